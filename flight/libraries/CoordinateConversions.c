@@ -60,49 +60,39 @@ void LLA2ECEF(int32_t LLAi[3], double ECEF[3])
     ECEF[2] = ((1.0d - e2) * N + LLA[2]) * sinLat;
 }
 
-// ****** convert ECEF to Lat,Lon,Alt (ITERATIVE!) *********
+// ****** convert ECEF to Lat,Lon,Alt (closed form) *********
 uint16_t ECEF2LLA(double ECEF[3], float LLA[3])
 {
     /**
-     * LLA parameter is used to prime the iteration.
-     * A position within 1 meter of the specified LLA
-     * will be calculated within at most 3 iterations.
-     * If unknown: Call with any valid LLA coordinate
-     * will compute within at most 5 iterations.
-     * Suggestion: [0,0,0]
+     * Bowring's formula, a single step from the parametric latitude.
+     * Below 1mm of error from the exact latitude and altitude
+     * for any altitude within some 1000km of the surface.
+     * The LLA parameter is not used anymore to prime an iteration.
      **/
 
-    const double a = 6378137.0f; // Equatorial Radius
-    const double e = 8.1819190842622e-2f; // Eccentricity
+    const double a   = 6378137.0d; // Equatorial Radius
+    const double e2  = 6.69437999014e-3d; // Eccentricity squared
+    const double b   = a * sqrt(1.0d - e2); // Polar Radius
+    const double ep2 = e2 / (1.0d - e2); // Second eccentricity squared
     double x = ECEF[0], y = ECEF[1], z = ECEF[2];
-    double Lat, N, NplusH, delta, esLat;
-    uint16_t iter;
+    double p = sqrt(x * x + y * y);
 
-#define MAX_ITER 10 // should not take more than 5 for valid coordinates
-#define ACCURACY 1.0e-11d // used to be e-14, but we don't need sub micrometer exact calculations
+    // parametric latitude
+    double theta    = atan2(z * a, p * b);
+    double sinTheta = sin(theta);
+    double cosTheta = cos(theta);
 
-    LLA[1] = (float)RAD2DEG_D(atan2(y, x));
-    Lat    = DEG2RAD_D((double)LLA[0]);
-    esLat  = e * sin(Lat);
-    N = a / sqrt(1 - esLat * esLat);
-    NplusH = N + (double)LLA[2];
-    delta  = 1;
-    iter   = 0;
-
-    while (((delta > ACCURACY) || (delta < -ACCURACY))
-           && (iter < MAX_ITER)) {
-        delta  = Lat - atan(z / (sqrt(x * x + y * y) * (1 - (N * e * e / NplusH))));
-        Lat    = Lat - delta;
-        esLat  = e * sin(Lat);
-        N      = a / sqrt(1 - esLat * esLat);
-        NplusH = sqrt(x * x + y * y) / cos(Lat);
-        iter  += 1;
-    }
+    double Lat    = atan2(z + ep2 * b * sinTheta * sinTheta * sinTheta,
+                          p - e2 * a * cosTheta * cosTheta * cosTheta);
+    double sinLat = sin(Lat);
+    double cosLat = cos(Lat);
 
-    LLA[0] = RAD2DEG_D(Lat);
-    LLA[2] = NplusH - N;
+    LLA[0] = (float)RAD2DEG_D(Lat);
+    LLA[1] = (float)RAD2DEG_D(atan2(y, x));
+    // well conditioned at the poles too, unlike p / cos(Lat) - N
+    LLA[2] = (float)(p * cosLat + z * sinLat - a * sqrt(1.0d - e2 * sinLat * sinLat));
 
-    return iter < MAX_ITER;
+    return 1;
 }
 
 // ****** find ECEF to NED rotation matrix ********
@@ -265,6 +255,54 @@ void LLA2Base(int32_t LLAi[3], double BaseECEF[3], float Rne[3][3], float NED[3]
     NED[2]  = Rne[2][0] * diff[0] + Rne[2][1] * diff[1] + Rne[2][2] * diff[2];
 }
 
+// ****** Compute the local NED Base Frame of a location ********
+uint8_t BaseFromLLA(int32_t LLAi[3], struct CoordinateBase *base)
+{
+    if (base->valid && base->LLAi[0] == LLAi[0] && base->LLAi[1] == LLAi[1] && base->LLAi[2] == LLAi[2]) {
+        // the base did not move, nothing to refresh
+        return 0;
+    }
+
+    const double a   = 6378137.0d; // Equatorial Radius
+    const double e2  = 6.69437999014e-3d; // Eccentricity squared
+    double lat    = DEG2RAD_D((double)LLAi[0] * 1e-7d);
+    double sinLat = sin(lat);
+    double w      = sqrt(1.0d - e2 * sinLat * sinLat);
+    double N      = a / w; // prime vertical radius of curvature
+    double M      = a * (1.0d - e2) / (w * w * w); // meridian radius of curvature
+    double h      = (double)LLAi[2] * 1e-4d;
+    float tanLat  = fabsf(tanf((float)lat));
+
+    base->LLAi[0] = LLAi[0];
+    base->LLAi[1] = LLAi[1];
+    base->LLAi[2] = LLAi[2];
+    LLA2ECEF(LLAi, base->ECEF);
+    RneFromLLA(LLAi, base->Rne);
+    base->NorthPerLat = (float)(DEG2RAD_D(1e-7d) * (M + h));
+    base->EastPerLon  = (float)(DEG2RAD_D(1e-7d) * (N + h) * cos(lat));
+    // the flat earth errors grow with the square of the distance, as d^2 / 2R
+    // down and below d^2 (1 + |tan(Lat)|) / 2R horizontally
+    base->FlatMaxDistance2 = 2.0f * (float)N * COORDINATE_FLAT_EARTH_MAX_ERROR / (1.0f + tanLat);
+    base->valid = 1;
+
+    return 1;
+}
+
+// ****** Express LLA in a local NED Base Frame, flat earth near the base ********
+void LLA2BaseFlat(int32_t LLAi[3], struct CoordinateBase *base, float NED[3])
+{
+    NED[0] = (float)(LLAi[0] - base->LLAi[0]) * base->NorthPerLat;
+    NED[1] = (float)(LLAi[1] - base->LLAi[1]) * base->EastPerLon;
+
+    if (NED[0] * NED[0] + NED[1] * NED[1] > base->FlatMaxDistance2) {
+        // too far for the error bound, do the exact conversion
+        LLA2Base(LLAi, base->ECEF, base->Rne, NED);
+        return;
+    }
+
+    NED[2] = -(float)(LLAi[2] - base->LLAi[2]) * 1e-4f;
+}
+
 // ****** Express ECEF in a local NED Base Frame ********
 void ECEF2Base(double ECEF[3], double BaseECEF[3], float Rne[3][3], float NED[3])
 {
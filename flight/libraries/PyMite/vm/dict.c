@@ -28,6 +28,175 @@
 #include "pm.h"
 
 
+/* Hash of a key, equal keys (see obj_compare()) have equal hashes */
+static uint16_t
+dict_hash(pPmObj_t pkey)
+{
+    uint32_t h;
+    uint16_t i;
+
+    switch (OBJ_GET_TYPE(pkey))
+    {
+        case OBJ_TYPE_NON:
+            return 0;
+
+        case OBJ_TYPE_INT:
+            h = (uint32_t)((pPmInt_t)pkey)->val;
+            break;
+
+#ifdef HAVE_FLOAT
+        case OBJ_TYPE_FLT:
+        {
+            union { float f; uint32_t u; } v;
+
+            /* 0.0 and -0.0 are equal */
+            if (((pPmFloat_t)pkey)->val == 0.0)
+            {
+                return 0;
+            }
+            v.f = ((pPmFloat_t)pkey)->val;
+            h = v.u;
+            break;
+        }
+#endif /* HAVE_FLOAT */
+
+        case OBJ_TYPE_STR:
+            /* FNV-1a */
+            h = 2166136261u;
+            for (i = 0; i < ((pPmString_t)pkey)->length; i++)
+            {
+                h = (h ^ ((pPmString_t)pkey)->val[i]) * 16777619u;
+            }
+            break;
+
+        case OBJ_TYPE_TUP:
+            /* Equal tuples have the same length */
+            h = ((pPmTuple_t)pkey)->length;
+            break;
+
+#ifdef HAVE_BYTEARRAY
+        case OBJ_TYPE_CLI:
+            /* Instances may compare by the object they contain */
+            return 0;
+#endif /* HAVE_BYTEARRAY */
+
+        default:
+            /* Other objects are equal only to themselves */
+            h = (uint32_t)((intptr_t)pkey >> 2);
+            break;
+    }
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+
+/* Adds the key at the given position to the index, there must be a free slot */
+static void
+dict_indexInsert(pPmDictIndex_t pindex, uint16_t hash, int16_t indx)
+{
+    uint16_t i;
+
+    for (i = hash & pindex->mask; pindex->slot[i] != 0;
+         i = (i + 1) & pindex->mask);
+    pindex->slot[i] = indx + 1;
+}
+
+
+/*
+ * Builds the hash index of the dict again, sized for its current length.
+ * Dicts too small or too large for an index, and dicts whose index
+ * cannot be allocated, are left without one and searched linearly.
+ */
+static PmReturn_t
+dict_reindex(pPmDict_t pdict)
+{
+    PmReturn_t retval;
+    pPmDictIndex_t pindex;
+    pSegment_t pseg;
+    uint16_t nslots;
+    int16_t i;
+    uint8_t *pchunk;
+
+    /* Drop the current index */
+    if (pdict->d_index != C_NULL)
+    {
+        retval = heap_freeChunk((pPmObj_t)pdict->d_index);
+        PM_RETURN_IF_ERROR(retval);
+        pdict->d_index = C_NULL;
+    }
+
+    /* Keep the index at most half full */
+    for (nslots = 2 * DICT_INDEX_MIN_LENGTH; nslots < 2 * pdict->length;
+         nslots <<= 1);
+    if ((pdict->length < DICT_INDEX_MIN_LENGTH)
+        || (nslots > DICT_INDEX_MAX_SLOTS))
+    {
+        return PM_RET_OK;
+    }
+
+    retval = heap_getChunk(sizeof(PmDictIndex_t)
+                           + (nslots - 1) * sizeof(int16_t), &pchunk);
+    if (retval == PM_RET_EX_MEM)
+    {
+        return PM_RET_OK;
+    }
+    PM_RETURN_IF_ERROR(retval);
+    pindex = (pPmDictIndex_t)pchunk;
+    OBJ_SET_TYPE(pindex, OBJ_TYPE_DHI);
+    pindex->mask = nslots - 1;
+    sli_memset((unsigned char *)pindex->slot, 0, nslots * sizeof(int16_t));
+
+    /* Add the keys, walking the segments once */
+    pseg = pdict->d_keys->sl_rootseg;
+    for (i = 0; i < pdict->length; i++)
+    {
+        if ((i > 0) && ((i % SEGLIST_OBJS_PER_SEG) == 0))
+        {
+            pseg = pseg->next;
+        }
+        dict_indexInsert(pindex,
+                         dict_hash(pseg->s_val[i % SEGLIST_OBJS_PER_SEG]), i);
+    }
+    pdict->d_index = pindex;
+
+    return PM_RET_OK;
+}
+
+
+/*
+ * Finds the position of the key in the keys seglist.
+ * Returns PM_RET_NO if the key is not in the dict.
+ */
+static PmReturn_t
+dict_findKey(pPmDict_t pdict, pPmObj_t pkey, int16_t *r_indx)
+{
+    PmReturn_t retval;
+    pPmDictIndex_t pindex = pdict->d_index;
+    pPmObj_t pobj;
+    uint16_t i;
+
+    /* Without index, scan the keys */
+    if (pindex == C_NULL)
+    {
+        *r_indx = 0;
+        return seglist_findEqual(pdict->d_keys, pkey, r_indx);
+    }
+
+    /* Probe the slots from the hash of the key up to an empty one */
+    for (i = dict_hash(pkey) & pindex->mask; pindex->slot[i] != 0;
+         i = (i + 1) & pindex->mask)
+    {
+        retval = seglist_getItem(pdict->d_keys, pindex->slot[i] - 1, &pobj);
+        PM_RETURN_IF_ERROR(retval);
+        if (obj_compare(pkey, pobj) == C_SAME)
+        {
+            *r_indx = pindex->slot[i] - 1;
+            return PM_RET_OK;
+        }
+    }
+    return PM_RET_NO;
+}
+
+
 PmReturn_t
 dict_new(pPmObj_t *r_pdict)
 {
@@ -45,6 +214,7 @@ dict_new(pPmObj_t *r_pdict)
     pdict->length = 0;
     pdict->d_keys = C_NULL;
     pdict->d_vals = C_NULL;
+    pdict->d_index = C_NULL;
 
     *r_pdict = (pPmObj_t)pchunk;
     return retval;
@@ -68,6 +238,14 @@ dict_clear(pPmObj_t pdict)
     /* clear length */
     ((pPmDict_t)pdict)->length = 0;
 
+    /* Free the hash index if needed */
+    if (((pPmDict_t)pdict)->d_index != C_NULL)
+    {
+        PM_RETURN_IF_ERROR(heap_freeChunk((pPmObj_t)
+                                          ((pPmDict_t)pdict)->d_index));
+        ((pPmDict_t)pdict)->d_index = C_NULL;
+    }
+
     /* Free the keys and values seglists if needed */
     if (((pPmDict_t)pdict)->d_keys != C_NULL)
     {
@@ -96,6 +274,7 @@ PmReturn_t
 dict_setItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t pval)
 {
     PmReturn_t retval = PM_RET_OK;
+    pPmDictIndex_t pindex;
     int16_t indx;
 
     C_ASSERT(pdict != C_NULL);
@@ -141,8 +320,7 @@ dict_setItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t pval)
     else
     {
         /* Check for matching key */
-        indx = 0;
-        retval = seglist_findEqual(((pPmDict_t)pdict)->d_keys, pkey, &indx);
+        retval = dict_findKey((pPmDict_t)pdict, pkey, &indx);
 
         /* If found a matching key, replace val obj */
         if (retval == PM_RET_OK)
@@ -150,14 +328,33 @@ dict_setItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t pval)
             retval = seglist_setItem(((pPmDict_t)pdict)->d_vals, pval, indx);
             return retval;
         }
+        if (retval != PM_RET_NO)
+        {
+            return retval;
+        }
     }
 
-    /* Otherwise, insert the key,val pair */
-    retval = seglist_insertItem(((pPmDict_t)pdict)->d_keys, pkey, 0);
+    /* Otherwise, insert the key,val pair, at the end once indexed */
+    pindex = ((pPmDict_t)pdict)->d_index;
+    indx = (pindex != C_NULL) ? ((pPmDict_t)pdict)->length : 0;
+    retval = seglist_insertItem(((pPmDict_t)pdict)->d_keys, pkey, indx);
+    PM_RETURN_IF_ERROR(retval);
+    retval = seglist_insertItem(((pPmDict_t)pdict)->d_vals, pval, indx);
     PM_RETURN_IF_ERROR(retval);
-    retval = seglist_insertItem(((pPmDict_t)pdict)->d_vals, pval, 0);
     ((pPmDict_t)pdict)->length++;
 
+    /* Index the key, the index is rebuilt when it gets too full */
+    pindex = ((pPmDict_t)pdict)->d_index;
+    if ((pindex != C_NULL)
+        && (2 * ((pPmDict_t)pdict)->length <= pindex->mask + 1))
+    {
+        dict_indexInsert(pindex, dict_hash(pkey), indx);
+    }
+    else if (((pPmDict_t)pdict)->length >= DICT_INDEX_MIN_LENGTH)
+    {
+        retval = dict_reindex((pPmDict_t)pdict);
+    }
+
     return retval;
 }
 
@@ -195,7 +392,7 @@ dict_getItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t *r_pobj)
     }
 
     /* check for matching key */
-    retval = seglist_findEqual(((pPmDict_t)pdict)->d_keys, pkey, &indx);
+    retval = dict_findKey((pPmDict_t)pdict, pkey, &indx);
     /* if key not found, raise KeyError */
     if (retval == PM_RET_NO)
     {
@@ -220,7 +417,7 @@ dict_delItem(pPmObj_t pdict, pPmObj_t pkey)
     C_ASSERT(pdict != C_NULL);
 
     /* Check for matching key */
-    retval = seglist_findEqual(((pPmDict_t)pdict)->d_keys, pkey, &indx);
+    retval = dict_findKey((pPmDict_t)pdict, pkey, &indx);
 
     /* Raise KeyError if key is not found */
     if (retval == PM_RET_NO)
@@ -236,9 +433,17 @@ dict_delItem(pPmObj_t pdict, pPmObj_t pkey)
     PM_RETURN_IF_ERROR(retval);
     retval = seglist_removeItem(((pPmDict_t)pdict)->d_vals, indx);
 
+    PM_RETURN_IF_ERROR(retval);
+
     /* Reduce the item count */
     ((pPmDict_t)pdict)->length--;
 
+    /* The following keys moved, index them again */
+    if (((pPmDict_t)pdict)->d_index != C_NULL)
+    {
+        retval = dict_reindex((pPmDict_t)pdict);
+    }
+
     return retval;
 }
 #endif /* HAVE_DEL */
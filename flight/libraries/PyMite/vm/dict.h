@@ -25,12 +25,44 @@
  */
 
 
+/**
+ * Dicts with at least this many items get a hash index of their keys
+ */
+#define DICT_INDEX_MIN_LENGTH 8
+
+/**
+ * Number of slots of the largest hash index, the index must fit in a chunk.
+ * Larger dicts are searched linearly.
+ */
+#define DICT_INDEX_MAX_SLOTS 512
+
+
+/**
+ * Dict hash index
+ *
+ * Open addressed table, with linear probing, of the positions
+ * of the keys in the keys seglist.
+ * The table is kept at most half full.
+ */
+typedef struct PmDictIndex_s
+{
+    /** object descriptor */
+    PmObjDesc_t od;
+    /** number of slots minus one, the number of slots is a power of 2 */
+    uint16_t mask;
+    /** key position plus one, zero for an empty slot */
+    int16_t slot[1];
+} PmDictIndex_t,
+ *pPmDictIndex_t;
+
+
 /**
  * Dict
  *
  * Contains ptr to two seglists,
  * one for keys, the other for values;
  * and a length, the number of key/value pairs.
+ * Dicts with DICT_INDEX_MIN_LENGTH items or more also have a hash index.
  */
 typedef struct PmDict_s
 {
@@ -42,6 +74,8 @@ typedef struct PmDict_s
     pSeglist_t d_keys;
     /** ptr to seglist containing values */
     pSeglist_t d_vals;
+    /** ptr to the hash index of the keys, C_NULL if the dict is searched linearly */
+    pPmDictIndex_t d_index;
 } PmDict_t,
  *pPmDict_t;
 
@@ -93,7 +127,8 @@ PmReturn_t dict_new(pPmObj_t *r_pdict);
  *
  * If the dict already contains a matching key, the value is
  * replaced; otherwise the new key,val pair is inserted
- * at the front of the dict (for fast lookup).
+ * at the front of the dict (for fast lookup), or appended
+ * to it once it has a hash index (so the indexed positions stay valid).
  * In the later case, the length of the dict is incremented.
  *
  * @param   pdict ptr to dict in which (key,val) will go
@@ -156,6 +156,25 @@ static WMMtype_Ellipsoid *Ellip = NULL;
 static WMMtype_MagneticModel *MagneticModel = NULL;
 static float decimal_date;
 
+// Field at the last fully evaluated point, reused while the position stays within
+// WMM_CACHE_DISTANCE, through the local linear model once it has been computed
+#define WMM_CACHE_DISTANCE 1000.0f // m along each of north, east, down
+#define WMM_LINEAR_STEP    5000.0f // m, finite difference step of the linear model
+#define WMM_M_PER_DEG_LAT  111320.0f
+static struct {
+    bool  valid;
+    bool  linear;
+    float Lat;
+    float Lon;
+    float Alt;
+    float decimal_date;
+    float B[3];
+    float dB[3][3];
+} Cache;
+
+static int WMM_Evaluate(float Lat, float Lon, float AltEllipsoid, float B[3]);
+static void WMM_CacheOffset(float Lat, float Lon, float AltEllipsoid, float dNED[3]);
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -165,6 +184,8 @@ static float decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	Repeated calls near the same point reuse the last evaluation, see WMM_GetLocalMagModel()
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -203,8 +224,6 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     // return '0' if all appears to be OK
     // return < 0 if error
 
-    int returned = 0; // default to OK
-
     // ***********
     // range check supplied params
 
@@ -220,15 +239,120 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     if (Lon > 180.0f) {
         return -4; // error
     }
+
+    if (WMM_DateToYear(Month, Day, Year) < 0) {
+        return -8; // error
+    }
+
     // ***********
-    // allocated required memory
+    // close enough to the last evaluated point, use the linear model or the cached field
+
+    if (Cache.valid && Cache.decimal_date == decimal_date) {
+        float dNED[3];
+        WMM_CacheOffset(Lat, Lon, AltEllipsoid, dNED);
+        if (fabsf(dNED[0]) < WMM_CACHE_DISTANCE && fabsf(dNED[1]) < WMM_CACHE_DISTANCE && fabsf(dNED[2]) < WMM_CACHE_DISTANCE) {
+            for (int i = 0; i < 3; i++) {
+                B[i] = Cache.B[i];
+                if (Cache.linear) {
+                    B[i] += Cache.dB[i][0] * dNED[0] + Cache.dB[i][1] * dNED[1] + Cache.dB[i][2] * dNED[2];
+                }
+            }
+            return 0; // OK
+        }
+    }
+
+    Cache.valid = false;
+    int returned = WMM_Evaluate(Lat, Lon, AltEllipsoid, B);
+    if (returned >= 0) {
+        Cache.Lat    = Lat;
+        Cache.Lon    = Lon;
+        Cache.Alt    = AltEllipsoid;
+        Cache.decimal_date = decimal_date;
+        Cache.B[0]   = B[0];
+        Cache.B[1]   = B[1];
+        Cache.B[2]   = B[2];
+        Cache.linear = false;
+        Cache.valid  = true;
+    }
+
+    return returned;
+}
+
+/**
+ * Local tangent linear model of the field around the point of the last full
+ * evaluation by WMM_GetMagVector(), B = B0 + dB * NED with NED the offset in m.
+ * The derivatives are computed by finite differences on the first call for a point.
+ * @param[out] B0 the magnetic vector at that point, same units as WMM_GetMagVector()
+ * @param[out] dB the derivatives of B along north, east and down, per m
+ * @returns 0 if OK, < 0 if no point has been evaluated yet or on error
+ */
+int WMM_GetLocalMagModel(float B0[3], float dB[3][3])
+{
+    if (!Cache.valid) {
+        return -1; // no point evaluated yet
+    }
+
+    if (!Cache.linear) {
+        // one step along each axis: north, east, down
+        const float step[3][3] = {
+            { WMM_LINEAR_STEP / WMM_M_PER_DEG_LAT,                                           0.0f, 0.0f             },
+            { 0.0f, WMM_LINEAR_STEP / (WMM_M_PER_DEG_LAT * cosf(DEG2RAD(Cache.Lat))), 0.0f             },
+            { 0.0f,                                                                          0.0f, -WMM_LINEAR_STEP }
+        };
+        const float saved_date = decimal_date;
+        decimal_date = Cache.decimal_date;
+        for (int j = 0; j < 3; j++) {
+            float Bj[3];
+            // near the poles the east step is meaningless, keep the field constant along it
+            if (!(fabsf(step[j][1]) < 180.0f) || WMM_Evaluate(Cache.Lat + step[j][0], Cache.Lon + step[j][1], Cache.Alt + step[j][2], Bj) < 0) {
+                Bj[0] = Cache.B[0];
+                Bj[1] = Cache.B[1];
+                Bj[2] = Cache.B[2];
+            }
+            for (int i = 0; i < 3; i++) {
+                Cache.dB[i][j] = (Bj[i] - Cache.B[i]) / WMM_LINEAR_STEP;
+            }
+        }
+        decimal_date = saved_date;
+        Cache.linear = true;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        B0[i] = Cache.B[i];
+        for (int j = 0; j < 3; j++) {
+            dB[i][j] = Cache.dB[i][j];
+        }
+    }
+
+    return 0; // OK
+}
 
-// Ellip = NULL;
-// MagneticModel = NULL;
+/**
+ * Offset in m along north, east and down from the cached point, flat earth approximation
+ */
+static void WMM_CacheOffset(float Lat, float Lon, float AltEllipsoid, float dNED[3])
+{
+    float dLon = Lon - Cache.Lon;
 
-// MagneticModel = NULL;
-// CoordGeodetic = NULL;
-// GeoMagneticElements = NULL;
+    if (dLon > 180.0f) {
+        dLon -= 360.0f;
+    } else if (dLon < -180.0f) {
+        dLon += 360.0f;
+    }
+    dNED[0] = (Lat - Cache.Lat) * WMM_M_PER_DEG_LAT;
+    dNED[1] = dLon * WMM_M_PER_DEG_LAT * cosf(DEG2RAD(Cache.Lat));
+    dNED[2] = Cache.Alt - AltEllipsoid;
+}
+
+/**
+ * Full evaluation of the spherical harmonic expansion at one point, at decimal_date
+ */
+static int WMM_Evaluate(float Lat, float Lon, float AltEllipsoid, float B[3])
+{
+    int returned = 0; // default to OK
+
+    // ***********
+    // allocated required memory
 
     Ellip = (WMMtype_Ellipsoid *)MALLOC(sizeof(WMMtype_Ellipsoid));
     MagneticModel = (WMMtype_MagneticModel *)MALLOC(sizeof(WMMtype_MagneticModel));
@@ -259,21 +383,14 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
         }
     }
 
-
-    if (returned >= 0) {
-        if (WMM_DateToYear(Month, Day, Year) < 0) {
-            returned = -8; // error
-        }
-    }
-
     if (returned >= 0) {
         // Compute the geoMagnetic field elements and their time change
         if (WMM_Geomag(CoordSpherical, CoordGeodetic, GeoMagneticElements) < 0) {
             returned = -9; // error
         } else { // set the returned values
-            B[0] = GeoMagneticElements->X;
-            B[1] = GeoMagneticElements->Y;
-            B[2] = GeoMagneticElements->Z;
+            B[0] = GeoMagneticElements->X * 1e-2f;
+            B[1] = GeoMagneticElements->Y * 1e-2f;
+            B[2] = GeoMagneticElements->Z * 1e-2f;
         }
     }
 
@@ -302,10 +419,6 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
         Ellip = NULL;
     }
 
-    B[0] = GeoMagneticElements->X * 1e-2f;
-    B[1] = GeoMagneticElements->Y * 1e-2f;
-    B[2] = GeoMagneticElements->Z * 1e-2f;
-
     return returned;
 }
 
@@ -40,10 +40,18 @@
 // Private types
 
 // Private variables
-static xSemaphoreHandle lock;
+// The alarms are kept here and set without locking, AlarmsPublish() writes the changed ones
+// to the SystemAlarms object once per system loop
+static volatile uint8_t severities[SYSTEMALARMS_ALARM_NUMELEM];
+static volatile uint8_t extendedStatus[SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM];
+static volatile uint8_t extendedSubStatus[SYSTEMALARMS_EXTENDEDALARMSUBSTATUS_NUMELEM];
+static volatile uint32_t dirty[(SYSTEMALARMS_ALARM_NUMELEM + 31) / 32];
+static volatile uint8_t severityCount[SYSTEMALARMS_ALARM_ERROR + 1]; // number of alarms at each severity
 static volatile uint16_t lastAlarmChange[SYSTEMALARMS_ALARM_NUMELEM] = { 0 }; // this deliberately overflows every 2^16 milliseconds to save memory
 
 // Private functions
+static bool changeSeverity(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity);
+static void setDirty(SystemAlarmsAlarmElem alarm);
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
 
 /**
@@ -51,12 +59,22 @@ static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
  */
 int32_t AlarmsInitialize(void)
 {
+    SystemAlarmsData alarms;
+
     SystemAlarmsInitialize();
 
-    lock = xSemaphoreCreateRecursiveMutex();
     // do not change the default states of the alarms, let the init code generated by the uavobjectgenerator handle that
     // AlarmsClearAll();
     // AlarmsDefaultAll();
+    SystemAlarmsGet(&alarms);
+    for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
+        severities[n] = SystemAlarmsAlarmToArray(alarms.Alarm)[n];
+        severityCount[severities[n]]++;
+    }
+    for (uint32_t n = 0; n < SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM; ++n) {
+        extendedStatus[n]    = SystemAlarmsExtendedAlarmStatusToArray(alarms.ExtendedAlarmStatus)[n];
+        extendedSubStatus[n] = SystemAlarmsExtendedAlarmSubStatusToArray(alarms.ExtendedAlarmSubStatus)[n];
+    }
     return 0;
 }
 
@@ -68,29 +86,14 @@ int32_t AlarmsInitialize(void)
  */
 int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity)
 {
-    SystemAlarmsAlarmData alarms;
-
     // Check that this is a valid alarm
-    if (alarm >= SYSTEMALARMS_ALARM_NUMELEM) {
+    if (alarm >= SYSTEMALARMS_ALARM_NUMELEM || severity > SYSTEMALARMS_ALARM_ERROR) {
         return -1;
     }
 
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsAlarmGet(&alarms);
-    uint16_t flightTime = (uint16_t)xTaskGetTickCount() * (uint16_t)portTICK_RATE_MS; // this deliberately overflows every 2^16 milliseconds to save memory
-    if (((uint16_t)(flightTime - lastAlarmChange[alarm]) > PIOS_ALARM_GRACETIME &&
-         SystemAlarmsAlarmToArray(alarms)[alarm] != severity)
-        || SystemAlarmsAlarmToArray(alarms)[alarm] < severity) {
-        SystemAlarmsAlarmToArray(alarms)[alarm] = severity;
-        lastAlarmChange[alarm] = flightTime;
-        SystemAlarmsAlarmSet(&alarms);
+    if (changeSeverity(alarm, severity)) {
+        setDirty(alarm);
     }
-
-    // Release lock
-    xSemaphoreGiveRecursive(lock);
     return 0;
 }
 
@@ -107,32 +110,78 @@ int32_t ExtendedAlarmsSet(SystemAlarmsAlarmElem alarm,
                           SystemAlarmsExtendedAlarmStatusOptions status,
                           uint8_t subStatus)
 {
-    SystemAlarmsData alarms;
-
     // Check that this is a valid alarm
-    if (alarm >= SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM) {
+    if (alarm >= SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM || severity > SYSTEMALARMS_ALARM_ERROR) {
         return -1;
     }
 
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    if (changeSeverity(alarm, severity)) {
+        extendedStatus[alarm]    = status;
+        extendedSubStatus[alarm] = subStatus;
+        setDirty(alarm);
+    }
+    return 0;
+}
 
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsGet(&alarms);
-    uint16_t flightTime = (uint16_t)xTaskGetTickCount() * (uint16_t)portTICK_RATE_MS; // this deliberately overflows every 2^16 milliseconds to save memory
-    if (((uint16_t)(flightTime - lastAlarmChange[alarm]) > PIOS_ALARM_GRACETIME &&
-         SystemAlarmsAlarmToArray(alarms.Alarm)[alarm] != severity)
-        || SystemAlarmsAlarmToArray(alarms.Alarm)[alarm] < severity) {
-        SystemAlarmsExtendedAlarmStatusToArray(alarms.ExtendedAlarmStatus)[alarm] = status;
-        SystemAlarmsExtendedAlarmSubStatusToArray(alarms.ExtendedAlarmSubStatus)[alarm] = subStatus;
-        SystemAlarmsAlarmToArray(alarms.Alarm)[alarm] = severity;
-        lastAlarmChange[alarm] = flightTime;
-        SystemAlarmsSet(&alarms);
+/**
+ * Publish the alarms changed since the last call to the SystemAlarms object.
+ * Called by the system task once per loop.
+ */
+void AlarmsPublish()
+{
+    uint32_t changed = 0;
+
+    for (uint32_t n = 0; n < NELEMENTS(dirty); ++n) {
+        changed |= __sync_fetch_and_and(&dirty[n], 0);
+    }
+    if (!changed) {
+        return;
     }
 
-    // Release lock
-    xSemaphoreGiveRecursive(lock);
-    return 0;
+    SystemAlarmsData alarms;
+    for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
+        SystemAlarmsAlarmToArray(alarms.Alarm)[n] = severities[n];
+    }
+    for (uint32_t n = 0; n < SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM; ++n) {
+        SystemAlarmsExtendedAlarmStatusToArray(alarms.ExtendedAlarmStatus)[n]       = extendedStatus[n];
+        SystemAlarmsExtendedAlarmSubStatusToArray(alarms.ExtendedAlarmSubStatus)[n] = extendedSubStatus[n];
+    }
+    // the alarm fields only, the fields that follow them are set elsewhere
+    UAVObjSetDataField(SystemAlarmsHandle(), &alarms.Alarm, offsetof(SystemAlarmsData, Alarm),
+                       offsetof(SystemAlarmsData, ExtendedAlarmSubStatus) + sizeof(alarms.ExtendedAlarmSubStatus) - offsetof(SystemAlarmsData, Alarm));
+}
+
+/**
+ * Update the severity of an alarm if it was changed
+ * @return true if the severity was changed
+ */
+static bool changeSeverity(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity)
+{
+    uint16_t flightTime = (uint16_t)xTaskGetTickCount() * (uint16_t)portTICK_RATE_MS; // this deliberately overflows every 2^16 milliseconds to save memory
+    uint8_t previous;
+
+    // a concurrent change of the same alarm makes the swap fail, check it again then
+    do {
+        previous = severities[alarm];
+        if (!(((uint16_t)(flightTime - lastAlarmChange[alarm]) > PIOS_ALARM_GRACETIME &&
+               previous != severity)
+              || previous < severity)) {
+            return false;
+        }
+    } while (!__sync_bool_compare_and_swap(&severities[alarm], previous, (uint8_t)severity));
+
+    lastAlarmChange[alarm] = flightTime;
+    __sync_fetch_and_sub(&severityCount[previous], 1);
+    __sync_fetch_and_add(&severityCount[severity], 1);
+    return true;
+}
+
+/**
+ * Mark an alarm for the next AlarmsPublish()
+ */
+static void setDirty(SystemAlarmsAlarmElem alarm)
+{
+    __sync_fetch_and_or(&dirty[alarm / 32], 1UL << (alarm % 32));
 }
 
 /**
@@ -142,16 +191,12 @@ int32_t ExtendedAlarmsSet(SystemAlarmsAlarmElem alarm,
  */
 SystemAlarmsAlarmOptions AlarmsGet(SystemAlarmsAlarmElem alarm)
 {
-    SystemAlarmsAlarmData alarms;
-
     // Check that this is a valid alarm
     if (alarm >= SYSTEMALARMS_ALARM_NUMELEM) {
         return 0;
     }
 
-    // Read alarm
-    SystemAlarmsAlarmGet(&alarms);
-    return SystemAlarmsAlarmToArray(alarms)[alarm];
+    return severities[alarm];
 }
 
 /**
@@ -233,24 +278,11 @@ int32_t AlarmsHasCritical()
  */
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
 {
-    SystemAlarmsAlarmData alarms;
-
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarms
-    SystemAlarmsAlarmGet(&alarms);
-
-    // Go through alarms and check if any are of the given severity or higher
-    for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
-        if (SystemAlarmsAlarmToArray(alarms)[n] >= severity) {
-            xSemaphoreGiveRecursive(lock);
+    for (uint32_t n = severity; n < NELEMENTS(severityCount); ++n) {
+        if (severityCount[n]) {
             return 1;
         }
     }
-
-    // If this point is reached then no alarms found
-    xSemaphoreGiveRecursive(lock);
     return 0;
 }
 /**
@@ -259,26 +291,18 @@ static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
  */
 SystemAlarmsAlarmOptions AlarmsGetHighestSeverity()
 {
-    SystemAlarmsAlarmData alarmsData;
-    SystemAlarmsAlarmOptions highest = SYSTEMALARMS_ALARM_UNINITIALISED;
-
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarms
-    SystemAlarmsAlarmGet(&alarmsData);
-
-    // Go through alarms and find the highest severity
-    uint32_t n = 0;
-    while (n < SYSTEMALARMS_ALARM_NUMELEM && highest != SYSTEMALARMS_ALARM_CRITICAL) {
-        if (SystemAlarmsAlarmToArray(alarmsData)[n] > highest) {
-            highest = SystemAlarmsAlarmToArray(alarmsData)[n];
+    // the options are in severity order, except for critical and error
+    static const SystemAlarmsAlarmOptions order[] = {
+        SYSTEMALARMS_ALARM_CRITICAL, SYSTEMALARMS_ALARM_ERROR, SYSTEMALARMS_ALARM_WARNING,
+        SYSTEMALARMS_ALARM_OK, SYSTEMALARMS_ALARM_UNINITIALISED
+    };
+
+    for (uint32_t n = 0; n < NELEMENTS(order); ++n) {
+        if (severityCount[order[n]]) {
+            return order[n];
         }
-        n++;
     }
-
-    xSemaphoreGiveRecursive(lock);
-    return highest;
+    return SYSTEMALARMS_ALARM_UNINITIALISED;
 }
 
 /**
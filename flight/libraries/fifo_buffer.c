@@ -210,6 +210,18 @@ uint16_t fifoBuf_getData(t_fifo_buffer *buf, void *data, uint16_t len)
     return i; // return number of bytes copied
 }
 
+uint16_t fifoBuf_getDataPtr(t_fifo_buffer *buf, uint8_t **data)
+{ // get the contiguous data at the read position, to be removed with fifoBuf_removeData once used
+    uint16_t rd = buf->rd;
+    uint16_t wr = buf->wr;
+
+    *data = buf->buf_ptr + rd;
+    if (wr >= rd) {
+        return wr - rd;
+    }
+    return buf->buf_size - rd; // up to the end of the buffer
+}
+
 uint16_t fifoBuf_putByte(t_fifo_buffer *buf, const uint8_t b)
 { // add a data byte to the buffer
     uint16_t wr        = buf->wr;
@@ -273,6 +285,37 @@ uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len)
     return i; // return number of bytes copied
 }
 
+uint16_t fifoBuf_getFreePtr(t_fifo_buffer *buf, uint8_t **data)
+{ // get the contiguous free space at the write position, to be filled then added with fifoBuf_addData
+    uint16_t wr        = buf->wr;
+    uint16_t num_bytes = fifoBuf_getFree(buf);
+    uint16_t block_len = buf->buf_size - wr;
+
+    *data = buf->buf_ptr + wr;
+    if (block_len > num_bytes) {
+        block_len = num_bytes;
+    }
+    return block_len;
+}
+
+void fifoBuf_addData(t_fifo_buffer *buf, uint16_t len)
+{ // add a number of bytes written in place, they may continue at the start of the buffer
+    uint16_t wr = buf->wr;
+    uint16_t buf_size  = buf->buf_size;
+
+    uint16_t num_bytes = fifoBuf_getFree(buf);
+
+    if (num_bytes > len) {
+        num_bytes = len;
+    }
+    wr += num_bytes;
+    if (wr >= buf_size) {
+        wr -= buf_size;
+    }
+
+    buf->wr = wr;
+}
+
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size)
 {
     buf->buf_ptr  = (uint8_t *)buffer;
@@ -33,7 +33,7 @@
 // ****** convert Lat,Lon,Alt to ECEF  ************
 void LLA2ECEF(int32_t LLAi[3], double ECEF[3]);
 
-// ****** convert ECEF to Lat,Lon,Alt (ITERATIVE!) *********
+// ****** convert ECEF to Lat,Lon,Alt (closed form) *********
 uint16_t ECEF2LLA(double ECEF[3], float LLA[3]);
 
 void RneFromLLA(int32_t LLAi[3], float Rne[3][3]);
@@ -68,6 +68,28 @@ void Quaternion2zB(const float q[4], float z[3]);
 // ****** Express LLA in a local NED Base Frame ********
 void LLA2Base(int32_t LLAi[3], double BaseECEF[3], float Rne[3][3], float NED[3]);
 
+// Largest error (m) of LLA2BaseFlat() against LLA2Base()
+#define COORDINATE_FLAT_EARTH_MAX_ERROR 0.1f
+
+// ****** A local NED Base Frame, cached by BaseFromLLA() ********
+struct CoordinateBase {
+    int32_t LLAi[3];
+    double  ECEF[3];
+    float   Rne[3][3];
+    float   NorthPerLat; // m per 1e-7 deg of latitude
+    float   EastPerLon; // m per 1e-7 deg of longitude
+    float   FlatMaxDistance2; // m^2, squared distance within which the flat earth conversion is used
+    uint8_t valid;
+};
+
+// ****** Compute the local NED Base Frame of a location ********
+// ****** only when it moved, returns 1 if base was refreshed ***
+uint8_t BaseFromLLA(int32_t LLAi[3], struct CoordinateBase *base);
+
+// ****** Express LLA in a local NED Base Frame, flat earth near the base ********
+// ****** within COORDINATE_FLAT_EARTH_MAX_ERROR of LLA2Base() ***
+void LLA2BaseFlat(int32_t LLAi[3], struct CoordinateBase *base, float NED[3]);
+
 // ****** Express ECEF in a local NED Base Frame ********
 void ECEF2Base(double ECEF[3], double BaseECEF[3], float Rne[3][3], float NED[3]);
 
@@ -30,5 +30,6 @@
 // Exposed Function Prototypes
 int WMM_Initialize();
 int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3]);
+int WMM_GetLocalMagModel(float B0[3], float dB[3][3]);
 
 #endif /* WORLDMAGMODEL_H_ */
@@ -13,4 +13,20 @@ void aes_encrypt_cbc_256(void *data, void *key, void *chain_block);
 void aes_decrypt_cbc_256(void *data, void *key, void *chain_block);
 void aes_decrypt_key_256_create(void *enc_key, void *dec_key);
 
+#define AES_128_ROUND_KEYS 44
+
+struct aes_ctr_128 {
+    uint32_t round_keys[AES_128_ROUND_KEYS];
+    uint8_t  keystream[N_BLOCK]; // word aligned, follows the round keys
+    uint8_t  counter[N_BLOCK];
+    uint8_t  used; // keystream bytes already consumed
+};
+
+void aes_key_128_expand(const void *key, uint32_t *round_keys);
+void aes_encrypt_block_128(const uint32_t *round_keys, const void *in, void *out);
+
+void aes_ctr_128_init(struct aes_ctr_128 *ctx, const void *key, const void *counter);
+void aes_ctr_128_set_counter(struct aes_ctr_128 *ctx, const void *counter);
+void aes_ctr_128_crypt(struct aes_ctr_128 *ctx, void *data, uint32_t len);
+
 #endif
@@ -42,6 +42,7 @@ int32_t AlarmsDefault(SystemAlarmsAlarmElem alarm);
 void AlarmsDefaultAll();
 int32_t AlarmsClear(SystemAlarmsAlarmElem alarm);
 void AlarmsClearAll();
+void AlarmsPublish();
 
 int32_t AlarmsHasWarnings();
 int32_t AlarmsHasErrors();
@@ -52,10 +52,13 @@ int16_t fifoBuf_getByte(t_fifo_buffer *buf);
 
 uint16_t fifoBuf_getDataPeek(t_fifo_buffer *buf, void *data, uint16_t len);
 uint16_t fifoBuf_getData(t_fifo_buffer *buf, void *data, uint16_t len);
+uint16_t fifoBuf_getDataPtr(t_fifo_buffer *buf, uint8_t **data);
 
 uint16_t fifoBuf_putByte(t_fifo_buffer *buf, const uint8_t b);
 
 uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len);
+uint16_t fifoBuf_getFreePtr(t_fifo_buffer *buf, uint8_t **data);
+void fifoBuf_addData(t_fifo_buffer *buf, uint16_t len);
 
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size);
 
@@ -34,6 +34,34 @@ struct path_status {
     float correction_vector[3];
 };
 
+enum path_segment_type {
+    PATH_SEGMENT_ENDPOINT,
+    PATH_SEGMENT_VECTOR,
+    PATH_SEGMENT_CIRCLE,
+};
+
+/**
+ * Geometry of a PathDesired precomputed by path_compile(), so that the progress
+ * along it can be evaluated every cycle without recomputing it
+ */
+struct path_segment {
+    enum path_segment_type type;
+    bool  mode3D; // altitude included in distance and progress
+    bool  clockwise;
+    float start[3];
+    float end[3];
+    float vector[3]; // end - start, horizontal only if not mode3D
+    float length; // length of vector, radius for circles
+    float unit[3]; // vector / length, zero if too short
+    float inv_length; // 1 / length, zero if too short
+    float curvature; // 1 / radius for circles, zero otherwise
+    float start_angle; // angle of start around the center (end) for circles, 0..2pi
+    float starting_velocity;
+    float ending_velocity;
+};
+
+void path_compile(const PathDesiredData *path, struct path_segment *segment);
+void path_segment_progress(const struct path_segment *segment, const float *cur_point, struct path_status *status);
 void path_progress(PathDesiredData *path, float *cur_point, struct path_status *status);
 
 #endif
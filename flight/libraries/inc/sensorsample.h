@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ *
+ * @file       sensorsample.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Direct handoff of the gyro and accel samples from the sensors
+ *             to the state estimation, bypassing the object manager.
+ *             --
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef SENSORSAMPLE_H_
+#define SENSORSAMPLE_H_
+#include <stdint.h>
+
+typedef struct {
+    float gyro[3]; // deg/s, same as GyroSensor
+    float accel[3]; // m/s^2, same as AccelSensor
+    uint32_t timestamp; // PIOS_DELAY_GetRaw() when the sample was published
+} sensorsample_t;
+
+/**
+ * @brief Publish a new sample, to be called by a single producer, never blocks
+ * @param[in] sample the calibrated and rotated sample, also set in GyroSensor and AccelSensor
+ */
+void sensorsample_publish(const sensorsample_t *sample);
+
+/**
+ * @brief Get the latest sample, may be called by any number of consumers
+ * @param[out] sample the latest sample, untouched if none has been published
+ * @return the sequence number of the sample, 0 if none has been published yet.
+ * A consumer knows it got a new sample when the number differs from its last one.
+ */
+uint32_t sensorsample_get(sensorsample_t *sample);
+
+#endif /* SENSORSAMPLE_H_ */
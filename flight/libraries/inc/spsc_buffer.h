@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spsc_buffer.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Lock free single producer single consumer byte ring buffer.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef _SPSC_BUFFER_H_
+#define _SPSC_BUFFER_H_
+
+#include "stdint.h"
+
+// *********************
+
+/*
+ * Alternative to t_fifo_buffer for the paths with exactly one writer and one reader,
+ * typically an ISR and a task: no critical section is needed around the calls.
+ * The size is a power of two and all of it is usable. The indexes run freely and are
+ * only masked when accessing the storage, the producer only writes wr and the
+ * consumer only writes rd.
+ */
+typedef struct {
+    uint8_t  *buf_ptr;
+    volatile uint32_t rd;
+    volatile uint32_t wr;
+    uint32_t mask;
+} t_spsc_buffer;
+
+/*
+ * Up to two contiguous regions of the storage, the second one being used when the
+ * region wraps around the end. Lets drivers DMA directly into or out of the buffer.
+ */
+typedef struct {
+    uint8_t  *ptr[2];
+    uint16_t len[2];
+} t_spsc_regions;
+
+// *********************
+
+int32_t spscBuf_init(t_spsc_buffer *buf, void *buffer, const uint16_t buffer_size);
+
+uint16_t spscBuf_getSize(t_spsc_buffer *buf);
+uint16_t spscBuf_getUsed(t_spsc_buffer *buf);
+uint16_t spscBuf_getFree(t_spsc_buffer *buf);
+
+// Producer side
+uint16_t spscBuf_putByte(t_spsc_buffer *buf, const uint8_t b);
+uint16_t spscBuf_putData(t_spsc_buffer *buf, const void *data, uint16_t len);
+uint16_t spscBuf_writePeek(t_spsc_buffer *buf, t_spsc_regions *regions);
+void spscBuf_writeCommit(t_spsc_buffer *buf, uint16_t len);
+
+// Consumer side
+int16_t spscBuf_getByte(t_spsc_buffer *buf);
+uint16_t spscBuf_getDataPeek(t_spsc_buffer *buf, void *data, uint16_t len);
+uint16_t spscBuf_getData(t_spsc_buffer *buf, void *data, uint16_t len);
+uint16_t spscBuf_readPeek(t_spsc_buffer *buf, t_spsc_regions *regions);
+void spscBuf_readCommit(t_spsc_buffer *buf, uint16_t len);
+void spscBuf_clearData(t_spsc_buffer *buf);
+
+// *********************
+
+#endif // ifndef _SPSC_BUFFER_H_
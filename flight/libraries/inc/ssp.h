@@ -20,6 +20,12 @@
 
 #define SPP_USES_CRC
 
+// Sliding window mode: up to SSP_MAX_WINDOW packets may be waiting for their ACK at once.
+// Each packet uses a slot of SSP_PACKET_SIZE(data length) bytes in the rx and tx buffers.
+#define SSP_MAX_WINDOW    8
+#define SSP_PACKET_SIZE(len)             ((len) + 4) // length, seq. no., data and CRC 16
+#define SSP_WINDOW_BUF_SIZE(len, window) (SSP_PACKET_SIZE(len) * (window))
+
 #define SSP_TX_IDLE       0   // not expecting a ACK packet (no current transmissions in progress)
 #define SSP_TX_WAITING    1   // waiting for a valid ACK to arrive
 #define SSP_TX_TIMEOUT    2   // failed to receive a valid ACK in the timeout period, after retrying.
@@ -57,6 +63,13 @@ typedef struct {
     uint8_t  seqNo;
 } Packet_t;
 
+typedef struct {
+    uint32_t timeout; // when this packet times out
+    uint8_t  seqNo; // sequence number of the packet in this slot
+    uint8_t  retryCount; // how many times the packet has been sent
+    uint8_t  acked; // the ACK of this packet was received
+} TxSlot_t;
+
 typedef struct {
     uint8_t  *rxBuf; // Buffer used to store rcv data
     uint16_t rxBufSize; // rcv buffer size.
@@ -68,6 +81,8 @@ typedef struct {
     int16_t (*pfSerialRead)(void); // function to call to read a byte from serial hardware
     void (*pfSerialWrite)(uint8_t); // function used to write a byte to serial hardware for transmission
     uint32_t (*pfGetTime)(void); // function returns time in number of seconds that has elapsed from a given reference point
+    void (*pfSerialWriteBuffer)(const uint8_t *, uint16_t); // optional, writes a block of bytes to the serial hardware
+    uint8_t  windowSize; // packets in flight, 0 or 1 = stop and wait. rx/tx buffers hold SSP_WINDOW_BUF_SIZE() bytes
 } PortConfig_t;
 
 typedef struct Port_tag {
@@ -75,6 +90,7 @@ typedef struct Port_tag {
     int16_t (*pfSerialRead)(void); // function to read a character from the serial input stream
     void (*pfSerialWrite)(uint8_t); // function to write a byte to be sent out the serial port
     uint32_t (*pfGetTime)(void); // function returns time in number of seconds that has elapsed from a given reference point
+    void (*pfSerialWriteBuffer)(const uint8_t *, uint16_t); // function to write a block of bytes, NULL to write them one at a time
     uint8_t  retryCount; // how many times have we tried to transmit the 'send' packet
     uint8_t  maxRetryCount; // max. times to try to transmit the 'send' packet
     int32_t  timeoutLen; // how long to wait for each retry to succeed
@@ -99,6 +115,11 @@ typedef struct Port_tag {
     uint32_t RxError;
     uint32_t TxError;
     uint16_t flags;
+    uint8_t  windowSize; // 0 = stop and wait, otherwise number of slots in the windows
+    uint8_t  txHead; // slot of the oldest packet waiting for its ACK
+    uint8_t  txCount; // number of packets in the send window
+    TxSlot_t txSlots[SSP_MAX_WINDOW];
+    uint8_t  rxSlotSeqNo[SSP_MAX_WINDOW]; // seq. no. of the packet received out of order in each rx slot, 0 = free
 } Port_t;
 
 /** Public Data **/
@@ -33,6 +33,7 @@
 #include <math.h>
 #include <stdint.h>
 #include <pios_math.h>
+#include <pios_helpers.h>
 
 // constants/macros/typdefs
 #define NUMX 13 // number of states, X is the state vector
@@ -50,8 +51,13 @@ void RungeKutta(float X[NUMX], float U[NUMU], float dT);
 void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
 void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
                  float G[NUMX][NUMW]);
-void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
-void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV],
+                   uint16_t SensorsUsed);
+void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX],
+                uint16_t SensorsUsed);
+uint16_t GateMeasurements(float Z[NUMV], float Y[NUMV], float R[NUMV],
+                          float P[NUMX][NUMX], uint16_t Group,
+                          float Gate);
 
 // Private variables
 
@@ -78,6 +84,10 @@ void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
 static const int8_t FrowMin[NUMX] = { 3, 4, 5, 6, 6, 6, 7, 6, 6, 6, 13, 13, 13 };
 static const int8_t FrowMax[NUMX] = { 3, 4, 5, 9, 9, 9, 12, 12, 12, 12, -1, -1, -1 };
 
+// first column of each row of Dummy used when forming the upper triangle of
+// Pnew in CovariancePrediction(): min(i, FrowMin[j]) for all j >= i with F row j not empty
+static const int8_t DrowMin[NUMX] = { 0, 1, 2, 3, 4, 5, 6, 6, 6, 6, 10, 11, 12 };
+
 static const int8_t GrowMin[NUMX] = { 9, 9, 9, 3, 3, 3, 0, 0, 0, 0, 6, 7, 8 };
 static const int8_t GrowMax[NUMX] = { -1, -1, -1, 5, 5, 5, 2, 2, 2, 2, 6, 7, 8 };
 
@@ -97,7 +107,10 @@ static struct EKFData {
     // input noise and measurement noise variances
     float Q[NUMW];
     float R[NUMV];
-} ekf;
+    // chi-square innovation gates of the GPS position and velocity, 0 if disabled
+    float PosGate;
+    float VelGate;
+} ekf PIOS_FAST_DATA;
 
 // Global variables
 struct NavStruct Nav;
@@ -160,6 +173,8 @@ void INSGPSInit() // pretty much just a place holder for now
     ekf.R[5]  = 100.0f;          // High freq GPS vertical velocity noise variance (m/s)^2
     ekf.R[6]  = ekf.R[7] = ekf.R[8] = 0.005f;    // magnetometer unit vector noise variance
     ekf.R[9]  = .25f;                    // High freq altimeter noise variance (m^2)
+
+    ekf.PosGate = ekf.VelGate = 0.0f;    // no innovation gating
 }
 
 void INSResetP(float PDiag[NUMX])
@@ -237,6 +252,12 @@ void INSSetPosVelVar(float PosVar[3], float VelVar[3])
     ekf.R[5] = VelVar[2];
 }
 
+void INSSetGpsGate(float PosGate, float VelGate)
+{
+    ekf.PosGate = PosGate;
+    ekf.VelGate = VelGate;
+}
+
 void INSSetGyroBias(float gyro_bias[3])
 {
     ekf.X[10] = gyro_bias[0];
@@ -370,11 +391,12 @@ void VelBaroCorrection(float Vel[3], float BaroAlt)
                   HORIZ_SENSORS | VERT_SENSORS | BARO_SENSOR);
 }
 
-void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
-                   float BaroAlt, uint16_t SensorsUsed)
+uint16_t INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
+                       float BaroAlt, uint16_t SensorsUsed)
 {
     float Z[10], Y[10];
     float Bmag, qmag;
+    uint16_t Rejected;
 
     // GPS Position in meters and in local NED frame
     Z[0] = Pos[0];
@@ -387,19 +409,27 @@ void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
     Z[5] = Vel[2];
 
     // magnetometer data in any units (use unit vector) and in body frame
-    Bmag =
-        sqrtf(mag_data[0] * mag_data[0] + mag_data[1] * mag_data[1] +
-              mag_data[2] * mag_data[2]);
-    Z[6] = mag_data[0] / Bmag;
-    Z[7] = mag_data[1] / Bmag;
-    Z[8] = mag_data[2] / Bmag;
+    if (SensorsUsed & MAG_SENSORS) {
+        Bmag =
+            sqrtf(mag_data[0] * mag_data[0] + mag_data[1] * mag_data[1] +
+                  mag_data[2] * mag_data[2]);
+        Z[6] = mag_data[0] / Bmag;
+        Z[7] = mag_data[1] / Bmag;
+        Z[8] = mag_data[2] / Bmag;
+    }
 
     // barometric altimeter in meters and in local NED frame
     Z[9] = BaroAlt;
 
-    // EKF correction step
-    LinearizeH(ekf.X, ekf.Be, ekf.H);
-    MeasurementEq(ekf.X, ekf.Be, Y);
+    // EKF correction step, only the rows of the sensors used are linearized
+    LinearizeH(ekf.X, ekf.Be, ekf.H, SensorsUsed);
+    MeasurementEq(ekf.X, ekf.Be, Y, SensorsUsed);
+
+    // drop GPS fixes whose innovation does not fit the covariance before they touch P
+    Rejected  = GateMeasurements(Z, Y, ekf.R, ekf.P, SensorsUsed & POS_SENSORS, ekf.PosGate);
+    Rejected |= GateMeasurements(Z, Y, ekf.R, ekf.P, SensorsUsed & (HORIZ_SENSORS | VERT_SENSORS), ekf.VelGate);
+    SensorsUsed &= ~Rejected;
+
     SerialUpdate(ekf.H, ekf.R, Z, Y, ekf.P, ekf.X, SensorsUsed);
     qmag       = sqrtf(ekf.X[6] * ekf.X[6] + ekf.X[7] * ekf.X[7] + ekf.X[8] * ekf.X[8] + ekf.X[9] * ekf.X[9]);
     ekf.X[6]  /= qmag;
@@ -421,6 +451,38 @@ void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
     Nav.gyro_bias[0] = ekf.X[10];
     Nav.gyro_bias[1] = ekf.X[11];
     Nav.gyro_bias[2] = ekf.X[12];
+
+    return Rejected;
+}
+
+// *************  GateMeasurements ***************
+// Chi-square test of the innovation of a group of measurements
+// that each observe one state directly (H row is a unit vector),
+// so that H*P*H' + R reduces to the diagonal P[k][k] + R[k].
+// Correlations within the group are ignored:
+// d^2 = sum((Z-Y)^2/(P[k][k]+R[k])) is compared to Gate
+// Returns the group if it is to be rejected, 0 otherwise
+// ************************************************
+
+uint16_t GateMeasurements(float Z[NUMV], float Y[NUMV], float R[NUMV],
+                          float P[NUMX][NUMX], uint16_t Group,
+                          float Gate)
+{
+    float d2 = 0.0f;
+    uint8_t m;
+
+    if (!Group || Gate <= 0.0f) {
+        return 0;
+    }
+
+    for (m = 0; m < NUMV; m++) {
+        if (Group & (0x01 << m)) {
+            float Error = Z[m] - Y[m];
+            d2 += Error * Error / (P[HrowMin[m]][HrowMin[m]] + R[m]);
+        }
+    }
+
+    return (d2 > Gate) ? Group : 0;
 }
 
 // *************  CovariancePrediction *************
@@ -432,6 +494,8 @@ void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
 // dimensions equal to the number of disturbance noise variables
 // The General Method is very inefficient,not taking advantage of the sparse F and G
 // The first Method is very specific to this implementation
+// Only the upper triangle of Pnew is formed, so only the columns of Dummy
+// it reads are computed (see DrowMin), the lower triangle is mirrored
 // ************************************************
 
 __attribute__((optimize("O3")))
@@ -453,7 +517,7 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
         int8_t Fistart = FrowMin[i];
         int8_t Fiend   = FrowMax[i];
         int8_t j;
-        for (j = 0; j < NUMX; j++) {
+        for (j = DrowMin[i]; j < NUMX; j++) { // columns left of DrowMin are never read
             Dirow[j] = Pirow[j] * dT1; // Dummy = P / T ...
             int8_t k;
             for (k = Fistart; k <= Fiend; k++) {
@@ -755,7 +819,8 @@ void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
     // G[13][9]=G[14][10]=G[15][11]=1;  // NO BIAS STATES ON ACCELS
 }
 
-void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
+void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV],
+                   uint16_t SensorsUsed)
 {
     float q0, q1, q2, q3;
 
@@ -772,6 +837,13 @@ void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
     Y[4] = X[4];
     Y[5] = X[5];
 
+    // Alt = -Pz
+    Y[9] = -1.0f * X[2];
+
+    if (!(SensorsUsed & MAG_SENSORS)) {
+        return;
+    }
+
     // Bb=Rbe*Be
     Y[6] =
         (q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3) * Be[0] +
@@ -785,12 +857,10 @@ void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
         2.0f * (q1 * q3 + q0 * q2) * Be[0] + 2.0f * (q2 * q3 -
                                                      q0 * q1) * Be[1] +
         (q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3) * Be[2];
-
-    // Alt = -Pz
-    Y[9] = -1.0f * X[2];
 }
 
-void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
+void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX],
+                uint16_t SensorsUsed)
 {
     float q0, q1, q2, q3;
 
@@ -804,6 +874,13 @@ void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
     // dV/dV=I;
     H[3][3] = H[4][4] = H[5][5] = 1.0f;
 
+    // dAlt/dPz = -1
+    H[9][2] = -1.0f;
+
+    if (!(SensorsUsed & MAG_SENSORS)) {
+        return;
+    }
+
     // dBb/dq
     H[6][6] = 2.0f * (q0 * Be[0] + q3 * Be[1] - q2 * Be[2]);
     H[6][7] = 2.0f * (q1 * Be[0] + q2 * Be[1] + q3 * Be[2]);
@@ -817,9 +894,6 @@ void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
     H[8][7] = 2.0f * (q3 * Be[0] - q0 * Be[1] - q1 * Be[2]);
     H[8][8] = 2.0f * (q0 * Be[0] + q3 * Be[1] - q2 * Be[2]);
     H[8][9] = 2.0f * (q1 * Be[0] + q2 * Be[1] + q3 * Be[2]);
-
-    // dAlt/dPz = -1
-    H[9][2] = -1.0f;
 }
 
 /**
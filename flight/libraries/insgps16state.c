@@ -293,8 +293,8 @@ void VelBaroCorrection(float Vel[3], float BaroAlt)
                   HORIZ_SENSORS | VERT_SENSORS | BARO_SENSOR);
 }
 
-void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
-                   float BaroAlt, uint16_t SensorsUsed)
+uint16_t INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
+                       float BaroAlt, uint16_t SensorsUsed)
 {
     float Z[10], Y[10];
     float Bmag, qmag;
@@ -347,6 +347,8 @@ void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
     Nav.accel_bias[0] = X[13];
     Nav.accel_bias[1] = X[14];
     Nav.accel_bias[2] = X[15];
+
+    return 0; // no innovation gating
 }
 
 // *************  CovariancePrediction *************
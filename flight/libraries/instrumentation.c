@@ -58,5 +58,23 @@ void counterCallback(const pios_perf_counter_t *counter, const int8_t index, __a
     data.Counter.Max   = counter->max;
     data.Counter.Min   = counter->min;
     data.Counter.Value = counter->value;
+
+    const pios_perf_stats_t *stats = counter->stats;
+    if (stats && stats->count) {
+        float mean = (float)stats->sum / stats->count;
+        data.Samples = stats->count;
+        data.Statistics.Mean     = mean;
+        data.Statistics.Variance = (float)stats->sumSquares / stats->count - mean * mean;
+        if (data.Statistics.Variance < 0.0f) {
+            // rounding
+            data.Statistics.Variance = 0.0f;
+        }
+        memcpy(data.Histogram, stats->histogram, sizeof(data.Histogram));
+    } else {
+        data.Samples = 0;
+        data.Statistics.Mean     = 0.0f;
+        data.Statistics.Variance = 0.0f;
+        memset(data.Histogram, 0, sizeof(data.Histogram));
+    }
     PerfCounterInstSet(index, &data);
 }
@@ -42,6 +42,11 @@
 #define RESET_STEP                   -1
 #define GET_CURRENT_MILLIS           (xTaskGetTickCount() * portTICK_RATE_MS)
 
+// Minimum time between two led frames, the steps due meanwhile are shown late
+#ifndef LED_MIN_FRAME_INTERVAL_MS
+#define LED_MIN_FRAME_INTERVAL_MS    10
+#endif
+
 // Private data types definition
 // this is the status for a single notification led set
 typedef struct {
@@ -61,6 +66,7 @@ typedef struct {
 } NotifierLedStatus_t;
 
 static bool led_status_initialized = false;
+static uint32_t last_frame_time;
 
 NotifierLedStatus_t led_status[MAX_HANDLED_LED];
 
@@ -223,7 +229,8 @@ static void run_led(NotifierLedStatus_t *status)
 {
     const uint32_t currentTime = GET_CURRENT_MILLIS;
 
-    if (!status->running || currentTime < status->next_run_time) {
+    if (!status->running || currentTime < status->next_run_time ||
+        currentTime - last_frame_time < LED_MIN_FRAME_INTERVAL_MS) {
         return;
     }
     status->next_run_time = currentTime;
@@ -235,7 +242,9 @@ static void run_led(NotifierLedStatus_t *status)
     for (uint8_t i = status->led_set_start; i <= status->led_set_end; i++) {
         PIOS_WS2811_setColorRGB(color, i, false);
     }
+    // only the leds whose color changed are written, no transfer when none did
     PIOS_WS2811_Update();
+    last_frame_time = currentTime;
     advance_sequence(status);
 }
 
@@ -256,4 +265,9 @@ void LedNotificationExtLedsRun()
     for (uint8_t i = 0; i < MAX_HANDLED_LED; i++) {
         run_led(&led_status[i]);
     }
+
+    // send the frame skipped while the previous one was still being transferred
+    if (PIOS_WS2811_UpdatePending()) {
+        PIOS_WS2811_Update();
+    }
 }
@@ -28,8 +28,8 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
-#include "openpilot.h"
-#include "math.h"
+#include <math.h>
+#include <pios_math.h>
 #include "butterworth.h"
 
 /**
@@ -98,3 +98,140 @@ float FilterButterWorthDF2(const float xn, const struct ButterWorthDF2Filter *fi
     *wn1Ptr = wn;
     return val;
 }
+
+
+/**
+ * Initialization of an empty filter bank, which passes samples through unchanged.
+ * @param[out] bank Pointer to the filter bank
+ * @returns Nothing
+ */
+void InitBiquadBank(struct BiquadFilterBank *bank)
+{
+    bank->numSections = 0;
+}
+
+
+/**
+ * Appends a section to the filter bank, with zeroed states.
+ * @returns 0 on success, -1 if the bank is full
+ */
+static int8_t BiquadBankAddSection(struct BiquadFilterBank *bank, const float b0, const float b1, const float b2, const float a1, const float a2)
+{
+    if (bank->numSections >= BIQUAD_BANK_MAX_SECTIONS) {
+        return -1;
+    }
+
+    const uint8_t s = bank->numSections;
+
+    bank->b0[s] = b0;
+    bank->b1[s] = b1;
+    bank->b2[s] = b2;
+    bank->a1[s] = a1;
+    bank->a2[s] = a2;
+    for (uint8_t axis = 0; axis < BIQUAD_BANK_AXES; axis++) {
+        bank->z1[s][axis] = 0.0f;
+        bank->z2[s][axis] = 0.0f;
+    }
+    bank->numSections++;
+    return 0;
+}
+
+
+/**
+ * Appends a second order Butterworth low pass section to the filter bank.
+ * @param[in]  ff Cut-off frequency ratio
+ * @param[out] bank Pointer to the filter bank
+ * @returns 0 on success, -1 if the bank is full
+ */
+int8_t BiquadBankAddLowPass(struct BiquadFilterBank *bank, const float ff)
+{
+    const float k    = tanf(M_PI_F * ff);
+    const float norm = 1.0f / (1.0f + M_SQRT2_F * k + k * k);
+    const float b0   = k * k * norm;
+
+    return BiquadBankAddSection(bank, b0, 2.0f * b0, b0, 2.0f * (k * k - 1.0f) * norm, (1.0f - M_SQRT2_F * k + k * k) * norm);
+}
+
+
+/**
+ * Appends a notch section to the filter bank, e.g. to reject motor noise.
+ * @param[in]  ff Notch frequency ratio
+ * @param[in]  q Quality factor, the notch is ff / q wide
+ * @param[out] bank Pointer to the filter bank
+ * @returns 0 on success, -1 if the bank is full
+ */
+int8_t BiquadBankAddNotch(struct BiquadFilterBank *bank, const float ff, const float q)
+{
+    const float w0    = 2.0f * M_PI_F * ff;
+    const float alpha = sinf(w0) / (2.0f * q);
+    const float norm  = 1.0f / (1.0f + alpha);
+    const float b1    = -2.0f * cosf(w0) * norm;
+
+    return BiquadBankAddSection(bank, norm, b1, norm, b1, (1.0f - alpha) * norm);
+}
+
+
+/**
+ * Sets the states of the filter bank to the steady state of a constant input.
+ * @param[in]  x0 Prescribed value of each axis
+ * @param[out] bank Pointer to the filter bank
+ * @returns Nothing
+ */
+void BiquadBankReset(struct BiquadFilterBank *bank, const float x0[BIQUAD_BANK_AXES])
+{
+    float x[BIQUAD_BANK_AXES];
+
+    for (uint8_t axis = 0; axis < BIQUAD_BANK_AXES; axis++) {
+        x[axis] = x0[axis];
+    }
+    for (uint8_t s = 0; s < bank->numSections; s++) {
+        const float gain = (bank->b0[s] + bank->b1[s] + bank->b2[s]) / (1.0f + bank->a1[s] + bank->a2[s]);
+        for (uint8_t axis = 0; axis < BIQUAD_BANK_AXES; axis++) {
+            const float y = gain * x[axis];
+            bank->z2[s][axis] = bank->b2[s] * x[axis] - bank->a2[s] * y;
+            bank->z1[s][axis] = y - bank->b0[s] * x[axis];
+            x[axis] = y;
+        }
+    }
+}
+
+
+/**
+ * Runs one sample of each axis through all the sections of the filter bank.
+ * The axes are processed together so that each coefficient is loaded once per section.
+ * @param[in,out] x Raw values in, filtered values out
+ * @param[in,out] bank Pointer to the filter bank
+ * @returns Nothing
+ */
+void FilterBiquadBank(struct BiquadFilterBank *bank, float x[BIQUAD_BANK_AXES])
+{
+    float x0 = x[0];
+    float x1 = x[1];
+    float x2 = x[2];
+
+    for (uint8_t s = 0; s < bank->numSections; s++) {
+        const float b0 = bank->b0[s];
+        const float b1 = bank->b1[s];
+        const float b2 = bank->b2[s];
+        const float a1 = bank->a1[s];
+        const float a2 = bank->a2[s];
+        float *z1 = bank->z1[s];
+        float *z2 = bank->z2[s];
+
+        const float y0 = b0 * x0 + z1[0];
+        const float y1 = b0 * x1 + z1[1];
+        const float y2 = b0 * x2 + z1[2];
+        z1[0] = b1 * x0 - a1 * y0 + z2[0];
+        z1[1] = b1 * x1 - a1 * y1 + z2[1];
+        z1[2] = b1 * x2 - a1 * y2 + z2[2];
+        z2[0] = b2 * x0 - a2 * y0;
+        z2[1] = b2 * x1 - a2 * y1;
+        z2[2] = b2 * x2 - a2 * y2;
+        x0    = y0;
+        x1    = y1;
+        x2    = y2;
+    }
+    x[0] = x0;
+    x[1] = x1;
+    x[2] = x2;
+}
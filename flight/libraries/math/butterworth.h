@@ -31,6 +31,8 @@
 #ifndef BUTTERWORTH_H
 #define BUTTERWORTH_H
 
+#include <stdint.h>
+
 // Coefficients of second order Butterworth biquadratic filter in direct from 2
 struct ButterWorthDF2Filter {
     float b0;
@@ -43,4 +45,27 @@ void InitButterWorthDF2Filter(const float ff, struct ButterWorthDF2Filter *filte
 void InitButterWorthDF2Values(const float x0, const struct ButterWorthDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr);
 float FilterButterWorthDF2(const float xn, const struct ButterWorthDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr);
 
+// Cascade of biquad sections applied to the three axes of a vector sample at once
+#define BIQUAD_BANK_AXES 3
+#define BIQUAD_BANK_MAX_SECTIONS 3
+
+// Sections in transposed direct form 2, H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2).
+// Coefficients and states are kept in separate arrays, the states of the axes next to each other.
+struct BiquadFilterBank {
+    uint8_t numSections;
+    float   b0[BIQUAD_BANK_MAX_SECTIONS];
+    float   b1[BIQUAD_BANK_MAX_SECTIONS];
+    float   b2[BIQUAD_BANK_MAX_SECTIONS];
+    float   a1[BIQUAD_BANK_MAX_SECTIONS];
+    float   a2[BIQUAD_BANK_MAX_SECTIONS];
+    float   z1[BIQUAD_BANK_MAX_SECTIONS][BIQUAD_BANK_AXES];
+    float   z2[BIQUAD_BANK_MAX_SECTIONS][BIQUAD_BANK_AXES];
+};
+
+void InitBiquadBank(struct BiquadFilterBank *bank);
+int8_t BiquadBankAddLowPass(struct BiquadFilterBank *bank, const float ff);
+int8_t BiquadBankAddNotch(struct BiquadFilterBank *bank, const float ff, const float q);
+void BiquadBankReset(struct BiquadFilterBank *bank, const float x0[BIQUAD_BANK_AXES]);
+void FilterBiquadBank(struct BiquadFilterBank *bank, float x[BIQUAD_BANK_AXES]);
+
 #endif
@@ -28,7 +28,6 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
-#include "openpilot.h"
 #include "pid.h"
 #include <mathmisc.h>
 #include <pios_math.h>
@@ -99,6 +98,52 @@ float pid_apply_setpoint(struct pid *pid, const pid_scaler *scaler, const float
     return (err * scaler->p * pid->p) + pid->iAccumulator / 1000.0f + dterm;
 }
 
+/**
+ * Update the roll, pitch and yaw PID computations with setpoint weighting together
+ * @param[in,out] pids The three PID structures
+ * @param[in] scalers The dynamic factors to scale each pid by
+ * @param[in] setpoint The three setpoints
+ * @param[in] measured The three measured values
+ * @param[in] dT  The time step
+ * @param[in] axes Bit n set updates pids[n] and output[n], the others are left untouched
+ * @param[out] output The computed controller values
+ *
+ * Same computation as pid_apply_setpoint(), with the dT dependent terms computed once
+ * for all axes and without branches on the gains: with a zero d gain the derivative
+ * filter state simply stays at zero, and with a zero dT the derivative term is held.
+ */
+void pid3_apply_setpoint(struct pid pids[3], const pid_scaler scalers[3], const float setpoint[3], const float measured[3], float dT, uint8_t axes, float output[3])
+{
+    const float iscale = dT * 1000.0f;
+    float alpha  = 0.0f;
+    float dscale = 0.0f;
+
+    if (dT > 0.0f) {
+        alpha  = dT / (dT + deriv_tau);
+        dscale = 1.0f / dT;
+    }
+
+    for (uint8_t t = 0; t < 3; t++) {
+        if (!(axes & (1 << t))) {
+            continue;
+        }
+        struct pid *pid = &pids[t];
+        const float err = setpoint[t] - measured[t];
+        const float lim = fabsf(pid->iLim) * 1000.0f;
+
+        // Scale up accumulator by 1000 while computing to avoid losing precision
+        pid->iAccumulator = fminf(fmaxf(pid->iAccumulator + err * (scalers[t].i * pid->i * iscale), -lim), lim);
+
+        // DT1 term on the weighted setpoint
+        const float derr  = deriv_gamma * setpoint[t] - measured[t];
+        const float dterm = pid->lastDer + alpha * ((scalers[t].d * (derr - pid->lastErr) * pid->d * dscale) - pid->lastDer);
+        pid->lastErr = derr;
+        pid->lastDer = dterm;
+
+        output[t]    = (err * scalers[t].p * pid->p) + pid->iAccumulator / 1000.0f + dterm;
+    }
+}
+
 /**
  * Reset a bit
  * @param[in] pid The pid to reset
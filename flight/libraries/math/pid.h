@@ -32,6 +32,7 @@
 #define PID_H
 
 #include "mathmisc.h"
+#include <stdint.h>
 
 // !
 struct pid {
@@ -53,6 +54,7 @@ typedef struct pid_scaler {
 // ! Methods to use the pid structures
 float pid_apply(struct pid *pid, const float err, float dT);
 float pid_apply_setpoint(struct pid *pid, const pid_scaler *scaler, const float setpoint, const float measured, float dT);
+void pid3_apply_setpoint(struct pid pids[3], const pid_scaler scalers[3], const float setpoint[3], const float measured[3], float dT, uint8_t axes, float output[3]);
 void pid_zero(struct pid *pid);
 void pid_configure(struct pid *pid, float p, float i, float d, float iLim);
 void pid_configure_derivative(float cutoff, float gamma);
@@ -7,7 +7,7 @@
  *
  * @file       sin_lookup.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      Sine lookup table from flash with 1 degree resolution
+ * @brief      Sine lookup table from flash with 0.5 degree resolution and linear interpolation
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -28,36 +28,40 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
-#include "openpilot.h"
-#include "math.h"
-#include "stdbool.h"
-#include "stdint.h"
+#include <stdint.h>
 #include <pios_math.h>
-
-#define FLASH_TABLE
-#ifdef FLASH_TABLE
-/** Version of the code which precomputes the lookup table in flash **/
-
-// This is a precomputed sin lookup table over 90 degrees that
-const float sin_table[] = {
-    0.000000f, 0.017452f, 0.034899f, 0.052336f, 0.069756f, 0.087156f, 0.104528f, 0.121869f, 0.139173f, 0.156434f,
-    0.173648f, 0.190809f, 0.207912f, 0.224951f, 0.241922f, 0.258819f, 0.275637f, 0.292372f, 0.309017f, 0.325568f,
-    0.342020f, 0.358368f, 0.374607f, 0.390731f, 0.406737f, 0.422618f, 0.438371f, 0.453990f, 0.469472f, 0.484810f,
-    0.500000f, 0.515038f, 0.529919f, 0.544639f, 0.559193f, 0.573576f, 0.587785f, 0.601815f, 0.615661f, 0.629320f,
-    0.642788f, 0.656059f, 0.669131f, 0.681998f, 0.694658f, 0.707107f, 0.719340f, 0.731354f, 0.743145f, 0.754710f,
-    0.766044f, 0.777146f, 0.788011f, 0.798636f, 0.809017f, 0.819152f, 0.829038f, 0.838671f, 0.848048f, 0.857167f,
-    0.866025f, 0.874620f, 0.882948f, 0.891007f, 0.898794f, 0.906308f, 0.913545f, 0.920505f, 0.927184f, 0.933580f,
-    0.939693f, 0.945519f, 0.951057f, 0.956305f, 0.961262f, 0.965926f, 0.970296f, 0.974370f, 0.978148f, 0.981627f,
-    0.984808f, 0.987688f, 0.990268f, 0.992546f, 0.994522f, 0.996195f, 0.997564f, 0.998630f, 0.999391f, 0.999848f,
-    1.000000f, 0.999848f, 0.999391f, 0.998630f, 0.997564f, 0.996195f, 0.994522f, 0.992546f, 0.990268f, 0.987688f,
-    0.984808f, 0.981627f, 0.978148f, 0.974370f, 0.970296f, 0.965926f, 0.961262f, 0.956305f, 0.951057f, 0.945519f,
-    0.939693f, 0.933580f, 0.927184f, 0.920505f, 0.913545f, 0.906308f, 0.898794f, 0.891007f, 0.882948f, 0.874620f,
-    0.866025f, 0.857167f, 0.848048f, 0.838671f, 0.829038f, 0.819152f, 0.809017f, 0.798636f, 0.788011f, 0.777146f,
-    0.766044f, 0.754710f, 0.743145f, 0.731354f, 0.719340f, 0.707107f, 0.694658f, 0.681998f, 0.669131f, 0.656059f,
-    0.642788f, 0.629320f, 0.615661f, 0.601815f, 0.587785f, 0.573576f, 0.559193f, 0.544639f, 0.529919f, 0.515038f,
-    0.500000f, 0.484810f, 0.469472f, 0.453990f, 0.438371f, 0.422618f, 0.406737f, 0.390731f, 0.374607f, 0.358368f,
-    0.342020f, 0.325568f, 0.309017f, 0.292372f, 0.275637f, 0.258819f, 0.241922f, 0.224951f, 0.207912f, 0.190809f,
-    0.173648f, 0.156434f, 0.139173f, 0.121869f, 0.104528f, 0.087156f, 0.069756f, 0.052336f, 0.034899f, 0.017452f
+#include "sin_lookup.h"
+
+// Table steps per degree, the table covers a quarter wave plus its end point
+#define SIN_STEPS_PER_DEG 2
+#define SIN_QUARTER_STEPS (90 * SIN_STEPS_PER_DEG)
+#define SIN_TURN_STEPS    (4 * SIN_QUARTER_STEPS)
+
+// This is a precomputed sin(i * 0.5 deg) lookup table over 90 degrees
+static const float sin_table[SIN_QUARTER_STEPS + 1] = {
+    0.00000000f, 0.00872654f, 0.01745241f, 0.02617695f, 0.03489950f, 0.04361939f, 0.05233596f, 0.06104854f,
+    0.06975647f, 0.07845910f, 0.08715574f, 0.09584575f, 0.10452846f, 0.11320321f, 0.12186934f, 0.13052619f,
+    0.13917310f, 0.14780941f, 0.15643447f, 0.16504761f, 0.17364818f, 0.18223553f, 0.19080900f, 0.19936793f,
+    0.20791169f, 0.21643961f, 0.22495105f, 0.23344536f, 0.24192190f, 0.25038000f, 0.25881905f, 0.26723838f,
+    0.27563736f, 0.28401534f, 0.29237170f, 0.30070580f, 0.30901699f, 0.31730466f, 0.32556815f, 0.33380686f,
+    0.34202014f, 0.35020738f, 0.35836795f, 0.36650123f, 0.37460659f, 0.38268343f, 0.39073113f, 0.39874907f,
+    0.40673664f, 0.41469324f, 0.42261826f, 0.43051110f, 0.43837115f, 0.44619781f, 0.45399050f, 0.46174861f,
+    0.46947156f, 0.47715876f, 0.48480962f, 0.49242356f, 0.50000000f, 0.50753836f, 0.51503807f, 0.52249856f,
+    0.52991926f, 0.53729961f, 0.54463904f, 0.55193699f, 0.55919290f, 0.56640624f, 0.57357644f, 0.58070296f,
+    0.58778525f, 0.59482279f, 0.60181502f, 0.60876143f, 0.61566148f, 0.62251464f, 0.62932039f, 0.63607822f,
+    0.64278761f, 0.64944805f, 0.65605903f, 0.66262005f, 0.66913061f, 0.67559021f, 0.68199836f, 0.68835458f,
+    0.69465837f, 0.70090926f, 0.70710678f, 0.71325045f, 0.71933980f, 0.72537437f, 0.73135370f, 0.73727734f,
+    0.74314483f, 0.74895572f, 0.75470958f, 0.76040597f, 0.76604444f, 0.77162458f, 0.77714596f, 0.78260816f,
+    0.78801075f, 0.79335334f, 0.79863551f, 0.80385686f, 0.80901699f, 0.81411552f, 0.81915204f, 0.82412619f,
+    0.82903757f, 0.83388582f, 0.83867057f, 0.84339145f, 0.84804810f, 0.85264016f, 0.85716730f, 0.86162916f,
+    0.86602540f, 0.87035570f, 0.87461971f, 0.87881711f, 0.88294759f, 0.88701083f, 0.89100652f, 0.89493436f,
+    0.89879405f, 0.90258528f, 0.90630779f, 0.90996127f, 0.91354546f, 0.91706007f, 0.92050485f, 0.92387953f,
+    0.92718385f, 0.93041757f, 0.93358043f, 0.93667219f, 0.93969262f, 0.94264149f, 0.94551858f, 0.94832366f,
+    0.95105652f, 0.95371695f, 0.95630476f, 0.95881973f, 0.96126170f, 0.96363045f, 0.96592583f, 0.96814764f,
+    0.97029573f, 0.97236992f, 0.97437006f, 0.97629601f, 0.97814760f, 0.97992470f, 0.98162718f, 0.98325491f,
+    0.98480775f, 0.98628560f, 0.98768834f, 0.98901586f, 0.99026807f, 0.99144486f, 0.99254615f, 0.99357186f,
+    0.99452190f, 0.99539620f, 0.99619470f, 0.99691733f, 0.99756405f, 0.99813480f, 0.99862953f, 0.99904822f,
+    0.99939083f, 0.99965732f, 0.99984770f, 0.99996192f, 1.00000000f
 };
 
 int sin_lookup_initalize()
@@ -65,61 +69,75 @@ int sin_lookup_initalize()
     return 0;
 }
 
-#else /* ifdef FLASH_TABLE */
-/** Version of the code which allocates the lookup table in heap **/
-
-const int SIN_RESOLUTION = 180;
-
-static float *sin_table;
-int sin_lookup_initalize()
+/**
+ * Computes sine and cosine together by linear interpolation in the quarter wave table,
+ * the interpolation error is below 1e-5
+ * @param[in] angle Angle in degrees
+ * @param[out] s sin(angle)
+ * @param[out] c cos(angle)
+ */
+void sincos_lookup_deg(float angle, float *s, float *c)
 {
-    // Previously initialized
-    if (sin_table) {
-        return 0;
-    }
+    float x   = angle * SIN_STEPS_PER_DEG;
+    int32_t i = (int32_t)x;
 
-    sin_table = (float *)pios_malloc(sizeof(float) * SIN_RESOLUTION);
-    if (sin_table == NULL) {
-        return -1;
+    if (x < (float)i) { // round towards -inf for negative angles
+        i--;
     }
+    float f = x - (float)i;
 
-    for (uint32_t i = 0; i < 180; i++) {
-        sin_table[i] = sinf(DEG2RAD((float)i));
+    i %= SIN_TURN_STEPS;
+    if (i < 0) {
+        i += SIN_TURN_STEPS;
+    }
+    int32_t k = i % SIN_QUARTER_STEPS;
+
+    // sine and cosine of the angle within its quarter
+    float qs  = sin_table[k] + f * (sin_table[k + 1] - sin_table[k]);
+    float qc  = sin_table[SIN_QUARTER_STEPS - k] + f * (sin_table[SIN_QUARTER_STEPS - k - 1] - sin_table[SIN_QUARTER_STEPS - k]);
+
+    switch (i / SIN_QUARTER_STEPS) {
+    case 0:
+        *s = qs;
+        *c = qc;
+        break;
+    case 1:
+        *s = qc;
+        *c = -qs;
+        break;
+    case 2:
+        *s = -qs;
+        *c = -qc;
+        break;
+    default:
+        *s = -qc;
+        *c = qs;
+        break;
     }
-
-    return 0;
 }
 
-#endif /* ifdef FLASH_TABLE */
+/**
+ * Computes sine and cosine together using the lookup table
+ * @param[in] angle Angle in radians
+ * @param[out] s sin(angle)
+ * @param[out] c cos(angle)
+ */
+void sincos_lookup_rad(float angle, float *s, float *c)
+{
+    sincos_lookup_deg(RAD2DEG(angle), s, c);
+}
 
 /**
- * Use the lookup table to return sine(angle) where angle is in radians
- * to save flash this cheats and uses trig functions to only save
- * 90 values
+ * Use the lookup table to return sine(angle)
  * @param[in] angle Angle in degrees
  * @returns sin(angle)
  */
 float sin_lookup_deg(float angle)
 {
-    if (sin_table == NULL) {
-        return 0;
-    }
-
-    // <bug, was> int i_ang = ((int32_t)angle) % 360;
-    // 1073741760 is a multiple of 360 that is close to 0x3fffffff
-    // so angle can be a very large number of positive or negative rotations
-    // this is the fastest fix (no tests, one integer addition)
-    // and has the largest range since float mantissas are 23-4 bit
-    // we could halve the lookup table size
-    // we could interpolate for greater accuracy
-    int i_ang = ((int32_t)(angle + 0.5f) + (int32_t)1073741760) % 360;
-    if (i_ang >= 180) { // for 180 to 360 deg
-        return -sin_table[i_ang - 180];
-    } else { // for 0 to 179 deg
-        return sin_table[i_ang];
-    }
+    float s, c;
 
-    return 0;
+    sincos_lookup_deg(angle, &s, &c);
+    return s;
 }
 
 /**
@@ -129,7 +147,10 @@ float sin_lookup_deg(float angle)
  */
 float cos_lookup_deg(float angle)
 {
-    return sin_lookup_deg(angle + 90);
+    float s, c;
+
+    sincos_lookup_deg(angle, &s, &c);
+    return c;
 }
 
 /**
@@ -139,19 +160,15 @@ float cos_lookup_deg(float angle)
  */
 float sin_lookup_rad(float angle)
 {
-    int degrees = RAD2DEG(angle);
-
-    return sin_lookup_deg(degrees);
+    return sin_lookup_deg(RAD2DEG(angle));
 }
 
 /**
- * Use the lookup table to return sine(angle) where angle is in radians
+ * Use the lookup table to return cosine(angle) where angle is in radians
  * @param[in] angle Angle in radians
  * @returns cos(angle)
  */
 float cos_lookup_rad(float angle)
 {
-    int degrees = RAD2DEG(angle);
-
-    return cos_lookup_deg(degrees);
+    return cos_lookup_deg(RAD2DEG(angle));
 }
@@ -36,5 +36,7 @@ float sin_lookup_deg(float angle);
 float cos_lookup_deg(float angle);
 float sin_lookup_rad(float angle);
 float cos_lookup_rad(float angle);
+void sincos_lookup_deg(float angle, float *s, float *c);
+void sincos_lookup_rad(float angle, float *s, float *c);
 
 #endif
@@ -44,17 +44,85 @@
 #define UPDATE_MAX      1.0f
 #define UPDATE_ALPHA    1.0e-2f
 
+// FlightModeSettings terms of the plans, refreshed only after the settings changed
+static struct {
+    float horizontalOffset;
+    float verticalOffset;
+    float verticalScale; // vertical / horizontal offset
+    float returnToBaseAltitudeOffset;
+    float landingVelocity;
+} planSettings;
+static volatile bool planSettingsUpdated = true;
+
+// PathDesired of the running plan, filled from the template by the setup functions and kept
+// up to date by the run functions so they don't need to read it back
+static const PathDesiredData endpointTemplate = {
+    .StartingVelocity = 0.0f,
+    .EndingVelocity   = 0.0f,
+    .Mode = PATHDESIRED_MODE_FLYENDPOINT,
+};
+static PathDesiredData planDesired;
+
+static void plan_settingsUpdatedCb(UAVObjEvent *ev);
+static void plan_update_settings();
+static void plan_set_endpoint(float north, float east, float down);
+
 /**
  * @brief initialize UAVOs and structs used by this library
  */
 void plan_initialize()
 {
+    static bool connected = false;
+
     TakeOffLocationInitialize();
     PositionStateInitialize();
     PathDesiredInitialize();
     FlightModeSettingsInitialize();
     AttitudeStateInitialize();
     ManualControlCommandInitialize();
+
+    if (!connected) {
+        connected = true;
+        FlightModeSettingsConnectFastCallback(plan_settingsUpdatedCb);
+    }
+}
+
+static void plan_settingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    planSettingsUpdated = true;
+}
+
+/**
+ * @brief reload the settings terms if the settings changed
+ */
+static void plan_update_settings()
+{
+    if (!planSettingsUpdated) {
+        return;
+    }
+    planSettingsUpdated = false;
+
+    FlightModeSettingsPositionHoldOffsetData offset;
+    FlightModeSettingsPositionHoldOffsetGet(&offset);
+    planSettings.horizontalOffset = offset.Horizontal;
+    planSettings.verticalOffset   = offset.Vertical;
+    planSettings.verticalScale    = offset.Vertical / offset.Horizontal;
+    FlightModeSettingsReturnToBaseAltitudeOffsetGet(&planSettings.returnToBaseAltitudeOffset);
+    FlightModeSettingsLandingVelocityGet(&planSettings.landingVelocity);
+}
+
+/**
+ * @brief set the end position of planDesired, the start position has the
+ * same offset as in position hold
+ */
+static void plan_set_endpoint(float north, float east, float down)
+{
+    planDesired.End.North   = north;
+    planDesired.End.East    = east;
+    planDesired.End.Down    = down;
+    planDesired.Start.North = north + planSettings.horizontalOffset; // in FlyEndPoint the direction of this vector does not matter
+    planDesired.Start.East  = east;
+    planDesired.Start.Down  = down;
 }
 
 /**
@@ -65,23 +133,12 @@ void plan_setup_positionHold()
     PositionStateData positionState;
 
     PositionStateGet(&positionState);
-    PathDesiredData pathDesired;
-    PathDesiredGet(&pathDesired);
+    plan_update_settings();
 
-    FlightModeSettingsPositionHoldOffsetData offset;
-    FlightModeSettingsPositionHoldOffsetGet(&offset);
+    planDesired = endpointTemplate;
+    plan_set_endpoint(positionState.North, positionState.East, positionState.Down);
 
-    pathDesired.End.North        = positionState.North;
-    pathDesired.End.East         = positionState.East;
-    pathDesired.End.Down         = positionState.Down;
-    pathDesired.Start.North      = positionState.North + offset.Horizontal; // in FlyEndPoint the direction of this vector does not matter
-    pathDesired.Start.East       = positionState.East;
-    pathDesired.Start.Down       = positionState.Down;
-    pathDesired.StartingVelocity = 0.0f;
-    pathDesired.EndingVelocity   = 0.0f;
-    pathDesired.Mode = PATHDESIRED_MODE_FLYENDPOINT;
-
-    PathDesiredSet(&pathDesired);
+    PathDesiredSet(&planDesired);
 }
 
 /**
@@ -94,49 +151,36 @@ void plan_setup_returnToBase()
 
     PositionStateDownGet(&positionStateDown);
 
-    PathDesiredData pathDesired;
-    PathDesiredGet(&pathDesired);
-
     TakeOffLocationData takeoffLocation;
     TakeOffLocationGet(&takeoffLocation);
+    plan_update_settings();
 
     // TODO: right now VTOLPF does fly straight to destination altitude.
     // For a safer RTB destination altitude will be the higher between takeofflocation and current position (corrected with safety margin)
 
-    float destDown;
-    FlightModeSettingsReturnToBaseAltitudeOffsetGet(&destDown);
-    destDown = MIN(positionStateDown, takeoffLocation.Down) - destDown;
-    FlightModeSettingsPositionHoldOffsetData offset;
-    FlightModeSettingsPositionHoldOffsetGet(&offset);
-
-    pathDesired.End.North        = takeoffLocation.North;
-    pathDesired.End.East         = takeoffLocation.East;
-    pathDesired.End.Down         = destDown;
-
-    pathDesired.Start.North      = takeoffLocation.North + offset.Horizontal; // in FlyEndPoint the direction of this vector does not matter
-    pathDesired.Start.East       = takeoffLocation.East;
-    pathDesired.Start.Down       = destDown;
+    float destDown = MIN(positionStateDown, takeoffLocation.Down) - planSettings.returnToBaseAltitudeOffset;
 
-    pathDesired.StartingVelocity = 0.0f;
-    pathDesired.EndingVelocity   = 0.0f;
-    pathDesired.Mode = PATHDESIRED_MODE_FLYENDPOINT;
+    planDesired = endpointTemplate;
+    plan_set_endpoint(takeoffLocation.North, takeoffLocation.East, destDown);
 
-    PathDesiredSet(&pathDesired);
+    PathDesiredSet(&planDesired);
 }
 
 static PiOSDeltatimeConfig landdT;
 void plan_setup_land()
 {
-    float descendspeed;
+    PositionStateData positionState;
 
-    plan_setup_positionHold();
+    PositionStateGet(&positionState);
+    plan_update_settings();
 
-    FlightModeSettingsLandingVelocityGet(&descendspeed);
-    PathDesiredData pathDesired;
-    PathDesiredGet(&pathDesired);
-    pathDesired.StartingVelocity = descendspeed;
-    pathDesired.EndingVelocity   = descendspeed;
-    PathDesiredSet(&pathDesired);
+    // position hold with the descend speed, written at once
+    planDesired = endpointTemplate;
+    plan_set_endpoint(positionState.North, positionState.East, positionState.Down);
+    planDesired.StartingVelocity = planSettings.landingVelocity;
+    planDesired.EndingVelocity   = planSettings.landingVelocity;
+
+    PathDesiredSet(&planDesired);
     PIOS_DELTATIME_Init(&landdT, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
 }
 
@@ -145,20 +189,17 @@ void plan_setup_land()
  */
 void plan_run_land()
 {
-    float downPos, descendspeed;
-    PathDesiredEndData pathDesiredEnd;
+    float downPos;
 
     PositionStateDownGet(&downPos); // current down position
-    PathDesiredEndGet(&pathDesiredEnd); // desired position
-    PathDesiredEndingVelocityGet(&descendspeed);
 
     // desired position is updated to match the desired descend speed but don't run ahead
     // too far if the current position can't keep up. This normaly means we have landed.
-    if (pathDesiredEnd.Down - downPos < 10) {
-        pathDesiredEnd.Down += descendspeed * PIOS_DELTATIME_GetAverageSeconds(&landdT);
+    if (planDesired.End.Down - downPos < 10) {
+        planDesired.End.Down += planDesired.EndingVelocity * PIOS_DELTATIME_GetAverageSeconds(&landdT);
     }
 
-    PathDesiredEndSet(&pathDesiredEnd);
+    PathDesiredEndSet(&planDesired.End);
 }
 
 
@@ -190,7 +231,8 @@ void plan_setup_PositionVarioNSEW()
 }
 
 
-#define DEADBAND 0.1f
+#define DEADBAND       0.1f
+#define DEADBAND_SCALE (1.0f / (1.0f - DEADBAND))
 static bool normalizeDeadband(float controlVector[4])
 {
     bool moving = false;
@@ -209,10 +251,10 @@ static bool normalizeDeadband(float controlVector[4])
             controlVector[t] -= DEADBAND;
         } else {
             controlVector[t] = 0.0f;
+            continue;
         }
         // deadband has been cut out, scale value back to [-1,+1]
-        controlVector[t] *= (1.0f / (1.0f - DEADBAND));
-        controlVector[t]  = boundf(controlVector[t], -1.0f, 1.0f);
+        controlVector[t] = boundf(controlVector[t] * DEADBAND_SCALE, -1.0f, 1.0f);
     }
 
     return moving;
@@ -222,12 +264,8 @@ typedef enum { FPV, LOS, NSEW } vario_type;
 
 static void getVector(float controlVector[4], vario_type type)
 {
-    FlightModeSettingsPositionHoldOffsetData offset;
-
-    FlightModeSettingsPositionHoldOffsetGet(&offset);
-
     // scale controlVector[3] (thrust) by vertical/horizontal to have vertical plane less sensitive
-    controlVector[3] *= offset.Vertical / offset.Horizontal;
+    controlVector[3] *= planSettings.verticalScale;
 
     float length = sqrtf(controlVector[0] * controlVector[0] + controlVector[1] * controlVector[1] + controlVector[3] * controlVector[3]);
 
@@ -235,29 +273,31 @@ static void getVector(float controlVector[4], vario_type type)
         length = 1.0f; // should never happen as getVector is not called if control within deadband
     }
     {
+        float invLength    = 1.0f / length;
         float direction[3] = {
-            controlVector[1] / length, // pitch is north
-            controlVector[0] / length, // roll is east
-            controlVector[3] / length // thrust is down
+            controlVector[1] * invLength, // pitch is north
+            controlVector[0] * invLength, // roll is east
+            controlVector[3] * invLength // thrust is down
         };
         controlVector[0] = direction[0];
         controlVector[1] = direction[1];
         controlVector[2] = direction[2];
     }
-    controlVector[3] = length * offset.Horizontal;
+    controlVector[3] = length * planSettings.horizontalOffset;
 
     // rotate north and east - rotation angle based on type
     float angle;
     switch (type) {
     case NSEW:
-        angle = 0.0f;
         // NSEW no rotation takes place
-        break;
+        return;
+
     case FPV:
         // local rotation, using current yaw
         AttitudeStateYawGet(&angle);
         break;
     case LOS:
+    default:
         // determine location based on vector from takeoff to current location
     {
         PositionStateData positionState;
@@ -270,9 +310,11 @@ static void getVector(float controlVector[4], vario_type type)
     }
     // rotate horizontally by angle
     {
+        float c = cos_lookup_deg(angle);
+        float s = sin_lookup_deg(angle);
         float rotated[2] = {
-            controlVector[0] * cos_lookup_deg(angle) - controlVector[1] * sin_lookup_deg(angle),
-            controlVector[0] * sin_lookup_deg(angle) + controlVector[1] * cos_lookup_deg(angle)
+            controlVector[0] * c - controlVector[1] * s,
+            controlVector[0] * s + controlVector[1] * c
         };
         controlVector[0] = rotated[0];
         controlVector[1] = rotated[1];
@@ -283,12 +325,8 @@ static void getVector(float controlVector[4], vario_type type)
 static void plan_run_PositionVario(vario_type type)
 {
     float controlVector[4];
-    PathDesiredData pathDesired;
-
-    PathDesiredGet(&pathDesired);
-    FlightModeSettingsPositionHoldOffsetData offset;
-    FlightModeSettingsPositionHoldOffsetGet(&offset);
 
+    plan_update_settings();
 
     ManualControlCommandRollGet(&controlVector[0]);
     ManualControlCommandPitchGet(&controlVector[1]);
@@ -302,14 +340,8 @@ static void plan_run_PositionVario(vario_type type)
             vario_hold = true;
 
             // new hold position is the position that was previously the start position
-            pathDesired.End.North   = hold_position[0];
-            pathDesired.End.East    = hold_position[1];
-            pathDesired.End.Down    = hold_position[2];
-            // while the new start position has the same offset as in position hold
-            pathDesired.Start.North = pathDesired.End.North + offset.Horizontal; // in FlyEndPoint the direction of this vector does not matter
-            pathDesired.Start.East  = pathDesired.End.East;
-            pathDesired.Start.Down  = pathDesired.End.Down;
-            PathDesiredSet(&pathDesired);
+            plan_set_endpoint(hold_position[0], hold_position[1], hold_position[2]);
+            PathDesiredSet(&planDesired);
         }
     } else {
         PositionStateData positionState;
@@ -323,9 +355,9 @@ static void plan_run_PositionVario(vario_type type)
         if (vario_hold) {
             // start position is the position that was previously the hold position
             vario_hold = false;
-            hold_position[0] = pathDesired.End.North;
-            hold_position[1] = pathDesired.End.East;
-            hold_position[2] = pathDesired.End.Down;
+            hold_position[0] = planDesired.End.North;
+            hold_position[1] = planDesired.End.East;
+            hold_position[2] = planDesired.End.Down;
         } else {
             // start position is advanced according to movement - in the direction of ControlVector only
             // projection using scalar product
@@ -339,14 +371,10 @@ static void plan_run_PositionVario(vario_type type)
             }
         }
         // new destination position is advanced based on controlVector
-        pathDesired.End.North   = hold_position[0] + controlVector[0] * controlVector[3];
-        pathDesired.End.East    = hold_position[1] + controlVector[1] * controlVector[3];
-        pathDesired.End.Down    = hold_position[2] - controlVector[2] * controlVector[3];
-        // the new start position has the same offset as in position hold
-        pathDesired.Start.North = pathDesired.End.North + offset.Horizontal; // in FlyEndPoint the direction of this vector does not matter
-        pathDesired.Start.East  = pathDesired.End.East;
-        pathDesired.Start.Down  = pathDesired.End.Down;
-        PathDesiredSet(&pathDesired);
+        plan_set_endpoint(hold_position[0] + controlVector[0] * controlVector[3],
+                          hold_position[1] + controlVector[1] * controlVector[3],
+                          hold_position[2] - controlVector[2] * controlVector[3]);
+        PathDesiredSet(&planDesired);
     }
 }
 void plan_run_PositionVarioFPV()
@@ -374,11 +402,7 @@ void plan_setup_AutoCruise()
     PositionStateData positionState;
 
     PositionStateGet(&positionState);
-    PathDesiredData pathDesired;
-    PathDesiredGet(&pathDesired);
-
-    FlightModeSettingsPositionHoldOffsetData offset;
-    FlightModeSettingsPositionHoldOffsetGet(&offset);
+    plan_update_settings();
 
     // initialization is flight in direction of the nose.
     // the velocity is not relevant, as it will be reset by the run function even during first call
@@ -388,21 +412,14 @@ void plan_setup_AutoCruise()
         cos_lookup_deg(angle),
         sin_lookup_deg(angle)
     };
-    hold_position[0]             = positionState.North;
-    hold_position[1]             = positionState.East;
-    hold_position[2]             = positionState.Down;
-    pathDesired.End.North        = hold_position[0] + vector[0];
-    pathDesired.End.East         = hold_position[1] + vector[1];
-    pathDesired.End.Down         = hold_position[2];
-    // start position has the same offset as in position hold
-    pathDesired.Start.North      = pathDesired.End.North + offset.Horizontal; // in FlyEndPoint the direction of this vector does not matter
-    pathDesired.Start.East       = pathDesired.End.East;
-    pathDesired.Start.Down       = pathDesired.End.Down;
-    pathDesired.StartingVelocity = 0.0f;
-    pathDesired.EndingVelocity   = 0.0f;
-    pathDesired.Mode             = PATHDESIRED_MODE_FLYENDPOINT;
-
-    PathDesiredSet(&pathDesired);
+    hold_position[0] = positionState.North;
+    hold_position[1] = positionState.East;
+    hold_position[2] = positionState.Down;
+
+    planDesired = endpointTemplate;
+    plan_set_endpoint(hold_position[0] + vector[0], hold_position[1] + vector[1], hold_position[2]);
+
+    PathDesiredSet(&planDesired);
 
     // re-iniztializing deltatime is valid and also good practice here since
     // getAverageSeconds() has not been called/updated in a long time if we were in a different flightmode.
@@ -417,10 +434,7 @@ void plan_run_AutoCruise()
     PositionStateData positionState;
 
     PositionStateGet(&positionState);
-    PathDesiredData pathDesired;
-    PathDesiredGet(&pathDesired);
-    FlightModeSettingsPositionHoldOffsetData offset;
-    FlightModeSettingsPositionHoldOffsetGet(&offset);
+    plan_update_settings();
 
     float controlVector[4];
     ManualControlCommandRollGet(&controlVector[0]);
@@ -432,9 +446,9 @@ void plan_run_AutoCruise()
     controlVector[3] = boundf(controlVector[3], 1e-6f, 1.0f); // bound to above zero, to prevent loss of vector direction
 
     // normalize old desired movement vector
-    float vector[3] = { pathDesired.End.North - hold_position[0],
-                        pathDesired.End.East - hold_position[1],
-                        pathDesired.End.Down - hold_position[2] };
+    float vector[3] = { planDesired.End.North - hold_position[0],
+                        planDesired.End.East - hold_position[1],
+                        planDesired.End.Down - hold_position[2] };
     float length    = sqrtf(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
     if (length < 1e-9f) {
         length = 1.0f; // should not happen since initialized properly in setup()
@@ -461,16 +475,10 @@ void plan_run_AutoCruise()
     angle    += 10.0f * controlVector[2] * dT; // TODO magic value could eventually end up in a to be created settings
 
     // resulting movement vector is scaled by velocity demand in controlvector[3] [0.0-1.0]
-    vector[0] = cosf(DEG2RAD(angle)) * offset.Horizontal * controlVector[3];
-    vector[1] = sinf(DEG2RAD(angle)) * offset.Horizontal * controlVector[3];
-    vector[2] = -controlVector[1] * offset.Vertical * controlVector[3];
-
-    pathDesired.End.North   = hold_position[0] + vector[0];
-    pathDesired.End.East    = hold_position[1] + vector[1];
-    pathDesired.End.Down    = hold_position[2] + vector[2];
-    // start position has the same offset as in position hold
-    pathDesired.Start.North = pathDesired.End.North + offset.Horizontal; // in FlyEndPoint the direction of this vector does not matter
-    pathDesired.Start.East  = pathDesired.End.East;
-    pathDesired.Start.Down  = pathDesired.End.Down;
-    PathDesiredSet(&pathDesired);
+    vector[0] = cosf(DEG2RAD(angle)) * planSettings.horizontalOffset * controlVector[3];
+    vector[1] = sinf(DEG2RAD(angle)) * planSettings.horizontalOffset * controlVector[3];
+    vector[2] = -controlVector[1] * planSettings.verticalOffset * controlVector[3];
+
+    plan_set_endpoint(hold_position[0] + vector[0], hold_position[1] + vector[1], hold_position[2] + vector[2]);
+    PathDesiredSet(&planDesired);
 }
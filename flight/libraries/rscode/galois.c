@@ -42,7 +42,7 @@
 #define PPOLY 0x1D 
 
 
-const int gexp[512] = {
+const uint8_t gexp[512] = {
 	  1,   2,   4,   8,  16,  32,  64, 128,  29,  58, 116, 232, 205, 135,  19,  38, 
 	 76, 152,  45,  90, 180, 117, 234, 201, 143,   3,   6,  12,  24,  48,  96, 192, 
 	157,  39,  78, 156,  37,  74, 148,  53, 106, 212, 181, 119, 238, 193, 159,  35, 
@@ -76,7 +76,7 @@ const int gexp[512] = {
 	 36,  72, 144,  61, 122, 244, 245, 247, 243, 251, 235, 203, 139,  11,  22,  44, 
 	 88, 176, 125, 250, 233, 207, 131,  27,  54, 108, 216, 173,  71, 142,   1,   0, 
 };
-const int glog[256] = {
+const uint8_t glog[256] = {
 	  0,   0,   1,  25,   2,  50,  26, 198,   3, 223,  51, 238,  27, 104, 199,  75, 
 	  4, 100, 224,  14,  52, 141, 239, 129,  28, 193, 105, 248, 200,   8,  76, 113, 
 	  5, 138, 101,  47, 225,  36,  15,  33,  53, 147, 142, 218, 240,  18, 130,  69, 
@@ -146,19 +146,4 @@ init_exp_table (void)
 }
 #endif
 
-/* multiplication using logarithms */
-int gmult(int a, int b)
-{
-  int i,j;
-  if (a==0 || b == 0) return (0);
-  i = glog[a];
-  j = glog[b];
-  return (gexp[i+j]);
-}
-		
-
-int ginv (int elt) 
-{ 
-  return (gexp[255-glog[elt]]);
-}
 
@@ -38,6 +38,10 @@ int synBytes[MAXDEG];
 /* generator polynomial */
 int genPoly[MAXDEG*2];
 
+/* logarithms of the generator polynomial coefficients, the encoder
+   multiplies by them with a single table lookup */
+static uint8_t genPolyLog[RS_ECC_NPARITY];
+
 //int DEBUG = FALSE;
 
 static void
@@ -47,11 +51,16 @@ compute_genpoly (int nbytes, int genpoly[]);
 void
 initialize_ecc ()
 {
+  int i;
+
   /* Initialize the galois field arithmetic tables */
     init_galois_tables();
 
     /* Compute the encoder generator polynomial */
     compute_genpoly(RS_ECC_NPARITY, genPoly);
+
+    /* the coefficients of a RS generator polynomial are never zero */
+    for (i = 0; i < RS_ECC_NPARITY; i++) genPolyLog[i] = glog[genPoly[i]];
 }
 
 void
@@ -111,12 +120,16 @@ void
 decode_data(unsigned char data[], int nbytes)
 {
   int i, j, sum;
-  for (j = 0; j < RS_ECC_NPARITY;  j++) {
-    sum	= 0;
-    for (i = 0; i < nbytes; i++) {
-      sum = data[i] ^ gmult(gexp[j+1], sum);
+
+  for (j = 0; j < RS_ECC_NPARITY; j++) synBytes[j] = 0;
+
+  /* all the syndromes in one pass over the data, sum * a^(j+1) is
+     a single lookup as the logarithm of a^(j+1) is j+1 */
+  for (i = 0; i < nbytes; i++) {
+    for (j = 0; j < RS_ECC_NPARITY; j++) {
+      sum = synBytes[j];
+      synBytes[j] = data[i] ^ (sum ? gexp[glog[sum] + j + 1] : 0);
     }
-    synBytes[j]  = sum;
   }
 }
 
@@ -187,16 +200,24 @@ compute_genpoly (int nbytes, int genpoly[])
 void
 encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
 {
-  int i, LFSR[RS_ECC_NPARITY+1],dbyte, j;
+  int i, LFSR[RS_ECC_NPARITY+1],dbyte, dlog, j;
 	
   for(i=0; i < RS_ECC_NPARITY+1; i++) LFSR[i]=0;
 
   for (i = 0; i < nbytes; i++) {
     dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
-    for (j = RS_ECC_NPARITY-1; j > 0; j--) {
-      LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
+    if (dbyte) {
+      dlog = glog[dbyte];
+      for (j = RS_ECC_NPARITY-1; j > 0; j--) {
+        LFSR[j] = LFSR[j-1] ^ gexp[genPolyLog[j] + dlog];
+      }
+      LFSR[0] = gexp[genPolyLog[0] + dlog];
+    } else {
+      for (j = RS_ECC_NPARITY-1; j > 0; j--) {
+        LFSR[j] = LFSR[j-1];
+      }
+      LFSR[0] = 0;
     }
-    LFSR[0] = gmult(genPoly[0], dbyte);
   }
 
   for (i = 0; i < RS_ECC_NPARITY; i++) 
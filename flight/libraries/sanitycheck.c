@@ -44,6 +44,35 @@
 // a number of useful macros
 #define ADDSEVERITY(check) severity = (severity != SYSTEMALARMS_ALARM_OK ? severity : ((check) ? SYSTEMALARMS_ALARM_OK : SYSTEMALARMS_ALARM_CRITICAL))
 
+// Inputs of the checks, a check is only run again when one of its inputs changed since its last run
+#define INPUT_FLIGHTMODESETTINGS (1 << 0) // the mode and stabilization settings of the switch positions, input of every check
+#define INPUT_SYSTEMSETTINGS     (1 << 1) // the airframe type
+#define INPUT_REVOSETTINGS       (1 << 2) // the fusion algorithm
+#define INPUT_RUNTIME            (1 << 3) // module and alarm states, there is no object to watch so those checks are always run
+#define INPUT_ALL                (INPUT_FLIGHTMODESETTINGS | INPUT_SYSTEMSETTINGS | INPUT_REVOSETTINGS | INPUT_RUNTIME)
+
+// Inputs of the check of each flight mode, besides INPUT_FLIGHTMODESETTINGS
+static const uint8_t modeInputs[] = {
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_MANUAL]       = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED1]  = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED2]  = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED3]  = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED4]  = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED5]  = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED6]  = INPUT_SYSTEMSETTINGS,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_AUTOTUNE]     = INPUT_RUNTIME,
+    // the nav modes are also available with hitl position states, which is a runtime state
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_PATHPLANNER]  = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONHOLD] = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIOFPV] = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIOLOS] = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIONSEW] = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_LAND]         = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POI]          = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_RETURNTOBASE] = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+    [FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_AUTOCRUISE]   = INPUT_REVOSETTINGS | INPUT_RUNTIME,
+};
+
 
 /****************************
 * Current checks:
@@ -53,10 +82,21 @@
 
 // ! Check a stabilization mode switch position for safety
 static bool check_stabilization_settings(int index, bool multirotor, bool coptercontrol);
+static bool check_flight_mode(uint8_t mode, bool multirotor, bool coptercontrol, bool navCapableFusion);
+static void inputChangedCb(UAVObjEvent *ev);
+
+// Private variables
+static xSemaphoreHandle lock;
+static volatile uint8_t changedInputs = INPUT_ALL;
+static uint8_t checkedPositions; // a bit per switch position that was checked
+static uint8_t failedPositions; // a bit per switch position that failed its last check
+static uint8_t publishedFailedPositions = 0xFF;
 
 /**
  * Run a preflight check over the hardware configuration
  * and currently active modules
+ * \note Only the checks of the switch positions whose inputs changed are run again,
+ * the first call has to be made before other tasks call it.
  */
 int32_t configuration_check()
 {
@@ -67,9 +107,22 @@ int32_t configuration_check()
     const struct pios_board_info *bdinfo = &pios_board_info_blob;
     bool coptercontrol     = bdinfo->board_type == 0x04;
 
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+        // the objects the checks depend on
+        FlightModeSettingsConnectFastCallback(inputChangedCb);
+        SystemSettingsConnectFastCallback(inputChangedCb);
+#ifdef REVOLUTION
+        RevoSettingsInitialize();
+        RevoSettingsConnectFastCallback(inputChangedCb);
+#endif
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    uint8_t changed = __sync_fetch_and_and(&changedInputs, 0) | INPUT_RUNTIME;
+
     // Classify navigation capability
 #ifdef REVOLUTION
-    RevoSettingsInitialize();
     uint8_t revoFusion;
     RevoSettingsFusionAlgorithmGet(&revoFusion);
     bool navCapableFusion;
@@ -103,58 +156,21 @@ int32_t configuration_check()
     uint8_t modes[FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_NUMELEM];
     ManualControlSettingsFlightModeNumberGet(&num_modes);
     FlightModeSettingsFlightModePositionGet(modes);
+    if (num_modes > FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_NUMELEM) {
+        num_modes = FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_NUMELEM;
+    }
 
     for (uint32_t i = 0; i < num_modes; i++) {
-        switch (modes[i]) {
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_MANUAL:
-            ADDSEVERITY(!multirotor);
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED1:
-            ADDSEVERITY(check_stabilization_settings(1, multirotor, coptercontrol));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED2:
-            ADDSEVERITY(check_stabilization_settings(2, multirotor, coptercontrol));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED3:
-            ADDSEVERITY(check_stabilization_settings(3, multirotor, coptercontrol));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED4:
-            ADDSEVERITY(check_stabilization_settings(4, multirotor, coptercontrol));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED5:
-            ADDSEVERITY(check_stabilization_settings(5, multirotor, coptercontrol));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED6:
-            ADDSEVERITY(check_stabilization_settings(6, multirotor, coptercontrol));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_AUTOTUNE:
-            ADDSEVERITY(PIOS_TASK_MONITOR_IsRunning(TASKINFO_RUNNING_AUTOTUNE));
-            break;
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_PATHPLANNER:
-        {
-            // Revo supports PathPlanner and that must be OK or we are not sane
-            // PathPlan alarm is uninitialized if not running
-            // PathPlan alarm is warning or error if the flightplan is invalid
-            SystemAlarmsAlarmData alarms;
-            SystemAlarmsAlarmGet(&alarms);
-            ADDSEVERITY(alarms.PathPlan == SYSTEMALARMS_ALARM_OK);
-        }
-        // intentionally no break as this also needs pathfollower
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONHOLD:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIOFPV:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIOLOS:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIONSEW:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_LAND:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POI:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_RETURNTOBASE:
-        case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_AUTOCRUISE:
-            ADDSEVERITY(!coptercontrol);
-            ADDSEVERITY(navCapableFusion);
-            break;
-        default:
-            // Uncovered modes are automatically an error
-            ADDSEVERITY(false);
+        uint8_t inputs = INPUT_FLIGHTMODESETTINGS | (modes[i] < NELEMENTS(modeInputs) ? modeInputs[modes[i]] : 0);
+        if ((changed & inputs) || !(checkedPositions & (1 << i))) {
+            checkedPositions |= (1 << i);
+            if (check_flight_mode(modes[i], multirotor, coptercontrol, navCapableFusion)) {
+                failedPositions &= ~(1 << i);
+            } else {
+                failedPositions |= (1 << i);
+            }
         }
+        ADDSEVERITY(!(failedPositions & (1 << i)));
         // mark the first encountered erroneous setting in status and substatus
         if ((severity != SYSTEMALARMS_ALARM_OK) && (alarmstatus == SYSTEMALARMS_EXTENDEDALARMSTATUS_NONE)) {
             alarmstatus    = SYSTEMALARMS_EXTENDEDALARMSTATUS_FLIGHTMODE;
@@ -162,6 +178,14 @@ int32_t configuration_check()
         }
     }
 
+    // the positions that can not be selected are not shown
+    uint8_t failed = failedPositions & ((1 << num_modes) - 1);
+    if (failed != publishedFailedPositions) {
+        publishedFailedPositions = failed;
+        SystemAlarmsSanityCheckFailedSet(&failed);
+    }
+    xSemaphoreGive(lock);
+
     uint8_t checks_disabled;
     FlightModeSettingsDisableSanityChecksGet(&checks_disabled);
     if (checks_disabled == FLIGHTMODESETTINGS_DISABLESANITYCHECKS_TRUE) {
@@ -177,6 +201,70 @@ int32_t configuration_check()
     return 0;
 }
 
+/**
+ * Marks the checks depending on the updated object to be run again
+ */
+static void inputChangedCb(UAVObjEvent *ev)
+{
+    uint8_t input = INPUT_FLIGHTMODESETTINGS;
+
+    if (ev->obj == SystemSettingsHandle()) {
+        input = INPUT_SYSTEMSETTINGS;
+    }
+#ifdef REVOLUTION
+    else if (ev->obj == RevoSettingsHandle()) {
+        input = INPUT_REVOSETTINGS;
+    }
+#endif
+    __sync_fetch_and_or(&changedInputs, input);
+}
+
+/**
+ * Checks a flight mode switch position
+ * @param[in] mode The flight mode of the position
+ * @returns true if the mode is available and safe
+ */
+static bool check_flight_mode(uint8_t mode, bool multirotor, bool coptercontrol, bool navCapableFusion)
+{
+    switch (mode) {
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_MANUAL:
+        return !multirotor;
+
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED1:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED2:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED3:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED4:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED5:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED6:
+        return check_stabilization_settings(mode - FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_STABILIZED1 + 1, multirotor, coptercontrol);
+
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_AUTOTUNE:
+        return PIOS_TASK_MONITOR_IsRunning(TASKINFO_RUNNING_AUTOTUNE);
+
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_PATHPLANNER:
+        // Revo supports PathPlanner and that must be OK or we are not sane
+        // PathPlan alarm is uninitialized if not running
+        // PathPlan alarm is warning or error if the flightplan is invalid
+        if (AlarmsGet(SYSTEMALARMS_ALARM_PATHPLAN) != SYSTEMALARMS_ALARM_OK) {
+            return false;
+        }
+    // intentionally no break as this also needs pathfollower
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONHOLD:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIOFPV:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIOLOS:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POSITIONVARIONSEW:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_LAND:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_POI:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_RETURNTOBASE:
+    case FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_AUTOCRUISE:
+        return !coptercontrol && navCapableFusion;
+
+    default:
+        // Uncovered modes are automatically an error
+        return false;
+    }
+}
+
 /**
  * Checks the stabiliation settings for a paritcular mode and makes
  * sure it is appropriate for the airframe
@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ *
+ * @file       sensorsample.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Direct handoff of the gyro and accel samples from the sensors
+ *             to the state estimation, bypassing the object manager.
+ *             --
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <pios_helpers.h>
+#include "inc/sensorsample.h"
+
+// Double buffer: the producer writes the slot not holding the latest sample,
+// then publishes it by incrementing seq, the latest sample is in slot seq & 1.
+// The producer only writes the slot a consumer copies after it published once,
+// a consumer that sees seq change during its copy retries.
+static volatile uint32_t seq;
+static sensorsample_t slots[2];
+
+void sensorsample_publish(const sensorsample_t *sample)
+{
+    uint32_t next = seq + 1;
+
+    memcpy(&slots[next & 1], sample, sizeof(sensorsample_t));
+    WRITE_MEMORY_BARRIER();
+    seq = next;
+}
+
+uint32_t sensorsample_get(sensorsample_t *sample)
+{
+    uint32_t start;
+
+    do {
+        start = seq;
+        READ_MEMORY_BARRIER();
+        if (!start) {
+            return 0;
+        }
+        memcpy(sample, &slots[start & 1], sizeof(sensorsample_t));
+        READ_MEMORY_BARRIER();
+    } while (seq != start);
+
+    return start;
+}
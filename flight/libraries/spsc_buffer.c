@@ -0,0 +1,186 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spsc_buffer.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Lock free single producer single consumer byte ring buffer.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+
+#include "spsc_buffer.h"
+
+// The index of the other side is read with acquire semantics, so that the data it covers
+// is read or overwritten only after it, and an index is published with release semantics,
+// once the data accesses before it are complete. This costs a dmb on Cortex-M and nothing
+// on x86, the volatile fields are not enough as the compiler may reorder the data accesses.
+#define SPSC_LOAD(index)   __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define SPSC_STORE(index, value) __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+// *****************************************************************************
+// internal helpers
+
+static void getRegions(t_spsc_buffer *buf, uint32_t index, uint32_t len, t_spsc_regions *regions)
+{ // split len bytes starting at index into the regions of the storage
+    uint32_t pos   = index & buf->mask;
+    uint32_t first = buf->mask + 1 - pos;
+
+    if (first > len) {
+        first = len;
+    }
+    regions->ptr[0] = buf->buf_ptr + pos;
+    regions->len[0] = first;
+    regions->ptr[1] = buf->buf_ptr;
+    regions->len[1] = len - first;
+}
+
+// *****************************************************************************
+// ring buffer functions
+
+int32_t spscBuf_init(t_spsc_buffer *buf, void *buffer, const uint16_t buffer_size)
+{ // the size must be a power of two
+    if (buffer_size == 0 || (buffer_size & (buffer_size - 1)) != 0) {
+        return -1;
+    }
+    buf->buf_ptr = (uint8_t *)buffer;
+    buf->rd   = 0;
+    buf->wr   = 0;
+    buf->mask = buffer_size - 1;
+    return 0;
+}
+
+uint16_t spscBuf_getSize(t_spsc_buffer *buf)
+{ // return the usable size of the buffer
+    return buf->buf_ptr ? buf->mask + 1 : 0;
+}
+
+uint16_t spscBuf_getUsed(t_spsc_buffer *buf)
+{ // return the number of bytes in the buffer
+    return SPSC_LOAD(buf->wr) - SPSC_LOAD(buf->rd);
+}
+
+uint16_t spscBuf_getFree(t_spsc_buffer *buf)
+{ // return the free space in the buffer
+    return buf->mask + 1 - spscBuf_getUsed(buf);
+}
+
+uint16_t spscBuf_writePeek(t_spsc_buffer *buf, t_spsc_regions *regions)
+{ // get the free regions, to be filled then committed
+    uint32_t wr  = buf->wr;
+    uint32_t rd  = SPSC_LOAD(buf->rd);
+    uint32_t len = buf->mask + 1 - (wr - rd);
+    getRegions(buf, wr, len, regions);
+    return len;
+}
+
+void spscBuf_writeCommit(t_spsc_buffer *buf, uint16_t len)
+{ // publish len bytes written into the regions
+    SPSC_STORE(buf->wr, buf->wr + len);
+}
+
+uint16_t spscBuf_readPeek(t_spsc_buffer *buf, t_spsc_regions *regions)
+{ // get the regions holding data, to be consumed then committed
+    uint32_t rd  = buf->rd;
+    uint32_t wr  = SPSC_LOAD(buf->wr);
+    uint32_t len = wr - rd;
+    getRegions(buf, rd, len, regions);
+    return len;
+}
+
+void spscBuf_readCommit(t_spsc_buffer *buf, uint16_t len)
+{ // release len bytes consumed from the regions
+    SPSC_STORE(buf->rd, buf->rd + len);
+}
+
+void spscBuf_clearData(t_spsc_buffer *buf)
+{ // remove all data from the buffer, consumer side
+    SPSC_STORE(buf->rd, SPSC_LOAD(buf->wr));
+}
+
+uint16_t spscBuf_putByte(t_spsc_buffer *buf, const uint8_t b)
+{ // add a data byte to the buffer
+    uint32_t wr = buf->wr;
+
+    if (wr - SPSC_LOAD(buf->rd) > buf->mask) {
+        return 0; // full
+    }
+    buf->buf_ptr[wr & buf->mask] = b;
+    spscBuf_writeCommit(buf, 1);
+    return 1;
+}
+
+uint16_t spscBuf_putData(t_spsc_buffer *buf, const void *data, uint16_t len)
+{ // add data to the buffer, as much as fits
+    t_spsc_regions regions;
+    uint16_t num_bytes = spscBuf_writePeek(buf, &regions);
+
+    if (num_bytes > len) {
+        num_bytes = len;
+    }
+    if (num_bytes < 1) {
+        return 0;
+    }
+    uint16_t first = regions.len[0] < num_bytes ? regions.len[0] : num_bytes;
+    memcpy(regions.ptr[0], data, first);
+    memcpy(regions.ptr[1], (const uint8_t *)data + first, num_bytes - first);
+    spscBuf_writeCommit(buf, num_bytes);
+    return num_bytes; // return number of bytes copied
+}
+
+int16_t spscBuf_getByte(t_spsc_buffer *buf)
+{ // get a data byte from the buffer
+    uint32_t rd = buf->rd;
+
+    if (SPSC_LOAD(buf->wr) == rd) {
+        return -1; // no byte returned
+    }
+    uint8_t b = buf->buf_ptr[rd & buf->mask];
+    spscBuf_readCommit(buf, 1);
+    return b;
+}
+
+uint16_t spscBuf_getDataPeek(t_spsc_buffer *buf, void *data, uint16_t len)
+{ // get data from the buffer without removing it
+    t_spsc_regions regions;
+    uint16_t num_bytes = spscBuf_readPeek(buf, &regions);
+
+    if (num_bytes > len) {
+        num_bytes = len;
+    }
+    if (num_bytes < 1) {
+        return 0;
+    }
+    uint16_t first = regions.len[0] < num_bytes ? regions.len[0] : num_bytes;
+    memcpy(data, regions.ptr[0], first);
+    memcpy((uint8_t *)data + first, regions.ptr[1], num_bytes - first);
+    return num_bytes; // return number of bytes copied
+}
+
+uint16_t spscBuf_getData(t_spsc_buffer *buf, void *data, uint16_t len)
+{ // get data from the buffer
+    uint16_t num_bytes = spscBuf_getDataPeek(buf, data, len);
+
+    if (num_bytes > 0) {
+        spscBuf_readCommit(buf, num_bytes);
+    }
+    return num_bytes; // return number of bytes copied
+}
+
+// *****************************************************************************
@@ -37,6 +37,13 @@
 * This protocol is best used in cases where one device is the master and the other is the slave, or a don't
 * speak unless spoken to type of approach.
 *
+* Window mode: with a windowSize of 2..SSP_MAX_WINDOW, up to windowSize packets are sent without waiting
+* for the ACK of the previous ones. Each packet is acked on its own, only the packets whose ACK did not
+* arrive before their timeout are sent again and the receiver keeps the packets that arrive ahead of a
+* lost one until the missing packet arrives, so the data is still handed over in order. The packet format
+* is unchanged but both ends must use the same window size, a stop and wait receiver would accept the packets
+* following a lost one. The rx and tx buffers hold windowSize packet slots of SSP_PACKET_SIZE() bytes.
+*
 * The following are items are required to initialize a port for communications:
 * 1. The number attempts for each packet
 * 2. time to wait for an ack.
@@ -53,6 +60,7 @@
 *       4. get time = function should return the current time. Note that time units are not specified it just
 *               needs to be some measure of time that increments as time passes by.  The timeout values for a given
 *               port should the units used/returned by the get time function.
+* 7. Optionally a write buffer function, the packets are then written in blocks instead of a byte at a time.
 *
 * All of the state information of a communication port is contained in a Port_t structure. This allows this
 * module to operature on multiple communication ports with a single code base.
@@ -108,18 +116,26 @@
 /** PRIVATE FUNCTIONS **/
 // static void          sf_SendSynchPacket( Port_t *thisport );
 static uint16_t sf_checksum(uint16_t crc, uint8_t data);
+static uint16_t sf_checksum_block(uint16_t crc, const uint8_t *data, uint16_t length);
 static void sf_write_byte(Port_t *thisport, uint8_t c);
 static void sf_SetSendTimeout(Port_t *thisport);
 static uint16_t sf_CheckTimeout(Port_t *thisport);
 static int16_t sf_DecodeState(Port_t *thisport, uint8_t c);
 static int16_t sf_ReceiveState(Port_t *thisport, uint8_t c);
 
-static void sf_SendPacket(Port_t *thisport);
+static void sf_SendPacket(Port_t *thisport, const uint8_t *packet);
 static void sf_SendAckPacket(Port_t *thisport, uint8_t seqNumber);
 static void sf_MakePacket(uint8_t *buf, const uint8_t *pdata, uint16_t length,
                           uint8_t seqNo);
 static int16_t sf_ReceivePacket(Port_t *thisport);
 
+static uint8_t *sf_TxSlotBuf(Port_t *thisport, uint8_t slot);
+static uint8_t *sf_RxSlotBuf(Port_t *thisport, uint8_t slot);
+static int16_t sf_WindowSend(Port_t *thisport, const uint8_t *data, uint16_t length, uint8_t seqNo);
+static int16_t sf_WindowSendProcess(Port_t *thisport);
+static void sf_WindowAck(Port_t *thisport, uint8_t seqNo);
+static int16_t sf_WindowReceive(Port_t *thisport);
+
 /* Flag bit masks...*/
 #define SENT_SYNCH       (0x01)
 #define ACK_RECEIVED     (0x02)
@@ -129,6 +145,9 @@ static int16_t sf_ReceivePacket(Port_t *thisport);
 #define SSP_ACKED        1
 #define SSP_IDLE         2
 
+// number of unescaped bytes written at once by sf_SendPacket when a write buffer function is set
+#define SSP_WRITE_CHUNK  32
+
 /** PRIVATE DATA **/
 static const uint16_t CRC_TABLE[] = { 0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301,
                                       0x03C0, 0x0280, 0xC241, 0xC601, 0x06C0,0x0780,  0xC741, 0x0500, 0xC5C1,
@@ -184,6 +203,7 @@ void ssp_Init(Port_t *thisport, const PortConfig_t *const info)
     thisport->pfSerialRead  = info->pfSerialRead;
     thisport->pfSerialWrite = info->pfSerialWrite;
     thisport->pfGetTime     = info->pfGetTime;
+    thisport->pfSerialWriteBuffer = info->pfSerialWriteBuffer;
 
     thisport->maxRetryCount = info->max_retry;
     thisport->timeoutLen    = info->timeoutLen;
@@ -196,6 +216,14 @@ void ssp_Init(Port_t *thisport, const PortConfig_t *const info)
     thisport->rxSeqNo = 255;
     thisport->txSeqNo = 255;
     thisport->SendState     = SSP_IDLE;
+
+    thisport->windowSize    = info->windowSize > SSP_MAX_WINDOW ? SSP_MAX_WINDOW : info->windowSize;
+    if (thisport->windowSize == 1) {
+        thisport->windowSize = 0; // a single slot window is stop and wait
+    }
+    thisport->txHead  = 0;
+    thisport->txCount = 0;
+    memset(thisport->rxSlotSeqNo, 0, sizeof(thisport->rxSlotSeqNo));
 }
 
 /*!
@@ -213,11 +241,16 @@ int16_t ssp_SendProcess(Port_t *thisport)
 {
     int16_t value = SSP_TX_WAITING;
 
+    if (thisport->windowSize) {
+        return sf_WindowSendProcess(thisport);
+    }
+
     if (thisport->SendState == SSP_AWAITING_ACK) {
         if (sf_CheckTimeout(thisport) == TRUE) {
             if (thisport->retryCount < thisport->maxRetryCount) {
                 // Try again
-                sf_SendPacket(thisport);
+                sf_SendPacket(thisport, thisport->txBuf);
+                thisport->retryCount++;
                 sf_SetSendTimeout(thisport);
                 value = SSP_TX_WAITING;
             } else {
@@ -317,7 +350,8 @@ uint16_t ssp_SendDataBlock(Port_t *thisport, uint8_t *data, uint16_t length)
  * \return	SSP_TX_BUSY = a packet has already been sent, but not yet acked
  *
  * \note
- *
+ * In window mode SSP_TX_BUSY means that the window is full, the data can be sent again once
+ * ssp_SendProcess has received the ACK of the oldest packet.
  */
 int16_t ssp_SendData(Port_t *thisport, const uint8_t *data,
                      const uint16_t length)
@@ -327,6 +361,17 @@ int16_t ssp_SendData(Port_t *thisport, const uint8_t *data,
     if ((length + 2) > thisport->txBufSize) {
         // TRYING to send too much data.
         value = SSP_TX_BUFOVERRUN;
+    } else if (thisport->windowSize) {
+        if (thisport->txCount < thisport->windowSize) {
+            CLEARBIT(thisport->txSeqNo, ACK_BIT);
+            thisport->txSeqNo++;
+            if (thisport->txSeqNo > 0x7F) {
+                thisport->txSeqNo = 1;
+            }
+            value = sf_WindowSend(thisport, data, length, thisport->txSeqNo);
+        } else {
+            value = SSP_TX_BUSY;
+        }
     } else if (thisport->SendState == SSP_IDLE) {
 #ifdef ACTIVE_SYNCH
         if (thisport->sendSynch == TRUE) {
@@ -363,9 +408,9 @@ int16_t ssp_SendData(Port_t *thisport, const uint8_t *data,
         CLEARBIT(thisport->flags, ACK_RECEIVED);
         thisport->SendState  = SSP_AWAITING_ACK;
         value = SSP_TX_WAITING;
-        thisport->retryCount = 0; // zero out the retry counter for this transmission
         sf_MakePacket(thisport->txBuf, data, length, thisport->txSeqNo);
-        sf_SendPacket(thisport); // punch out the packet to the serial port
+        sf_SendPacket(thisport, thisport->txBuf); // punch out the packet to the serial port
+        thisport->retryCount = 1;
         sf_SetSendTimeout(thisport); // do the timeout values
     } else {
         // error we are already sending a packet. Need to wait for the current packet to be acked or timeout.
@@ -395,12 +440,19 @@ uint16_t ssp_Synchronise(Port_t *thisport)
 #ifndef USE_SENDPACKET_DATA
     thisport->txSeqNo = 0; // make this zero to cause the other end to re-synch with us
     SETBIT(thisport->flags, SENT_SYNCH);
-    // TODO - should this be using ssp_SendPacketData()??
-    sf_MakePacket(thisport->txBuf, NULL, 0, thisport->txSeqNo); // construct the packet
-    sf_SendPacket(thisport);
-    sf_SetSendTimeout(thisport);
-    thisport->SendState = SSP_AWAITING_ACK;
-    packet_status = SSP_TX_WAITING;
+    if (thisport->windowSize) {
+        // drop the packets in flight, the synch packet is the only one in the window
+        thisport->txCount = 0;
+        packet_status     = sf_WindowSend(thisport, NULL, 0, thisport->txSeqNo);
+    } else {
+        // TODO - should this be using ssp_SendPacketData()??
+        sf_MakePacket(thisport->txBuf, NULL, 0, thisport->txSeqNo); // construct the packet
+        sf_SendPacket(thisport, thisport->txBuf);
+        thisport->retryCount = 1;
+        sf_SetSendTimeout(thisport);
+        thisport->SendState  = SSP_AWAITING_ACK;
+        packet_status = SSP_TX_WAITING;
+    }
 #else
     packet_status = ssp_SendData(thisport, NULL, 0);
 #endif
@@ -415,22 +467,50 @@ uint16_t ssp_Synchronise(Port_t *thisport)
 /*!
  * \brief   sends out a preformatted packet for a give port
  * \param   thisport = which port to use.
+ * \param	packet = the packet to send
  * \return  none.
  *
  * \note
  * Packet should be formed through the use of sf_MakePacket before calling this function.
+ * With a write buffer function the escaped packet is written in chunks, otherwise a byte at a time.
  */
-static void sf_SendPacket(Port_t *thisport)
+static void sf_SendPacket(Port_t *thisport, const uint8_t *packet)
 {
     // add 3 to packet data length for: 1 length + 2 CRC (packet overhead)
-    uint8_t packetLen = thisport->txBuf[LENGTH] + 3;
+    uint16_t packetLen = packet[LENGTH] + 3;
 
-    // use the raw serial write function so the SYNC byte does not get 'escaped'
-    thisport->pfSerialWrite(SYNC);
-    for (uint8_t x = 0; x < packetLen; x++) {
-        sf_write_byte(thisport, thisport->txBuf[x]);
+    if (thisport->pfSerialWriteBuffer == NULL) {
+        // use the raw serial write function so the SYNC byte does not get 'escaped'
+        thisport->pfSerialWrite(SYNC);
+        for (uint16_t x = 0; x < packetLen; x++) {
+            sf_write_byte(thisport, packet[x]);
+        }
+        return;
+    }
+
+    // every byte may be escaped to two bytes, plus the SYNC byte in the first chunk
+    uint8_t chunk[2 * SSP_WRITE_CHUNK + 1];
+    uint16_t len = 0;
+    chunk[len++] = SYNC;
+    for (uint16_t x = 0; x < packetLen; x++) {
+        uint8_t c = packet[x];
+        if (c == SYNC) {
+            chunk[len++] = ESC;
+            chunk[len++] = ESC_SYNC;
+        } else if (c == ESC) {
+            chunk[len++] = ESC;
+            chunk[len++] = ESC;
+        } else {
+            chunk[len++] = c;
+        }
+        if (len >= 2 * SSP_WRITE_CHUNK - 1) {
+            thisport->pfSerialWriteBuffer(chunk, len);
+            len = 0;
+        }
+    }
+    if (len) {
+        thisport->pfSerialWriteBuffer(chunk, len);
     }
-    thisport->retryCount++;
 }
 
 /*!
@@ -452,21 +532,18 @@ static void sf_SendPacket(Port_t *thisport)
 void sf_MakePacket(uint8_t *txBuf, const uint8_t *pdata, uint16_t length,
                    uint8_t seqNo)
 {
-    uint16_t crc    = 0xffff;
-    uint16_t bufPos = 0;
-    uint8_t b;
+    uint16_t crc;
+    uint16_t bufPos;
 
     // add 1 for the seq. number
     txBuf[LENGTH] = length + 1;
     txBuf[SEQNUM] = seqNo;
-    crc    = sf_checksum(crc, seqNo);
-
-    length = length + 2; // add two for the length and seqno bytes which are added before the loop.
-    for (bufPos = 2; bufPos < length; bufPos++) {
-        b   = *pdata++;
-        txBuf[bufPos] = b;
-        crc = sf_checksum(crc, b); // update CRC value
+    if (length) {
+        memcpy(&txBuf[DATA], pdata, length);
     }
+    // CRC of the seq. number and data bytes
+    crc    = sf_checksum_block(0xffff, &txBuf[SEQNUM], length + 1);
+    bufPos = length + 2; // add two for the length and seqno bytes
     txBuf[bufPos++] = LOWERBYTE(crc);
     txBuf[bufPos]   = UPPERBYTE(crc);
 }
@@ -484,10 +561,12 @@ void sf_MakePacket(uint8_t *txBuf, const uint8_t *pdata, uint16_t length,
 static void sf_SendAckPacket(Port_t *thisport, uint8_t seqNumber)
 {
     uint8_t AckSeqNumber = SETBIT(seqNumber, ACK_BIT);
+    uint8_t ackBuf[SSP_PACKET_SIZE(0)];
 
-    // create the packet, note we pass AckSequenceNumber directly
-    sf_MakePacket(thisport->txBuf, NULL, 0, AckSeqNumber);
-    sf_SendPacket(thisport);
+    // create the packet, note we pass AckSequenceNumber directly.  The ACK is formed in its
+    // own buffer as the tx buffer holds the packets that may have to be sent again.
+    sf_MakePacket(ackBuf, NULL, 0, AckSeqNumber);
+    sf_SendPacket(thisport, ackBuf);
     // we don't set the timeout for an ACK because we don't ACK our ACKs in this protocol
 }
 
@@ -549,6 +628,29 @@ static uint16_t sf_checksum(uint16_t crc, uint8_t data)
 #endif
 }
 
+/*!
+ * \brief   calculates the new CRC value for a block of bytes
+ * \param   crc = current CRC value
+ * \param	data = bytes to add to the CRC
+ * \param	length = number of bytes
+ * \return  updated CRC value
+ *
+ * \note
+ *
+ */
+
+static uint16_t sf_checksum_block(uint16_t crc, const uint8_t *data, uint16_t length)
+{
+    while (length--) {
+#ifdef SPP_USES_CRC
+        crc = (crc >> 8) ^ CRC_TABLE[(crc ^ *data++) & 0x00FF];
+#else
+        crc = sf_checksum(crc, *data++);
+#endif
+    }
+    return crc;
+}
+
 /*!
  * \brief   sets the timeout for the given packet
  * \param   thisport = which port to use
@@ -752,6 +854,14 @@ static int16_t sf_ReceivePacket(Port_t *thisport)
 {
     int16_t value = FALSE;
 
+    if (thisport->windowSize) {
+        if (ISBITSET(thisport->rxBuf[SEQNUM], ACK_BIT)) {
+            sf_WindowAck(thisport, thisport->rxBuf[SEQNUM] & 0x7F);
+            return FALSE;
+        }
+        return sf_WindowReceive(thisport);
+    }
+
     if (ISBITSET(thisport->rxBuf[SEQNUM], ACK_BIT)) {
         // Received an ACK packet, need to check if it matches the previous sent packet
         if ((thisport->rxBuf[SEQNUM] & 0x7F) == (thisport->txSeqNo & 0x7f)) {
@@ -793,3 +903,203 @@ static int16_t sf_ReceivePacket(Port_t *thisport)
     }
     return value;
 }
+
+/*!
+ * \brief   returns the packet buffer of a tx window slot
+ * \param   thisport = which port to use
+ * \param	slot = slot number
+ * \return  start of the slot in the tx buffer
+ */
+static uint8_t *sf_TxSlotBuf(Port_t *thisport, uint8_t slot)
+{
+    return &thisport->txBuf[slot * SSP_PACKET_SIZE(thisport->txBufSize)];
+}
+
+/*!
+ * \brief   returns the packet buffer of a rx window slot
+ * \param   thisport = which port to use
+ * \param	slot = slot number, slot 0 is the receive buffer of the decoder
+ * \return  start of the slot in the rx buffer
+ */
+static uint8_t *sf_RxSlotBuf(Port_t *thisport, uint8_t slot)
+{
+    return &thisport->rxBuf[slot * SSP_PACKET_SIZE(thisport->rxBufSize)];
+}
+
+/*!
+ * \brief   adds a packet to the send window and sends it
+ * \param   thisport = which port to use
+ * \param	data = pointer to data to send
+ * \param	length = number of bytes to send
+ * \param	seqNo = sequence number of the packet
+ * \return	SSP_TX_WAITING
+ *
+ * \note
+ * The caller checks that the window has a free slot.
+ */
+static int16_t sf_WindowSend(Port_t *thisport, const uint8_t *data, uint16_t length, uint8_t seqNo)
+{
+    uint8_t slot = (thisport->txHead + thisport->txCount) % thisport->windowSize;
+    TxSlot_t *s  = &thisport->txSlots[slot];
+    uint8_t *buf = sf_TxSlotBuf(thisport, slot);
+
+    sf_MakePacket(buf, data, length, seqNo);
+    s->seqNo      = seqNo;
+    s->acked      = FALSE;
+    s->retryCount = 1;
+    sf_SendPacket(thisport, buf);
+    s->timeout    = thisport->pfGetTime() + thisport->timeoutLen;
+    thisport->txCount++;
+
+    CLEARBIT(thisport->flags, ACK_RECEIVED);
+    thisport->SendState = SSP_AWAITING_ACK;
+    return SSP_TX_WAITING;
+}
+
+/*!
+ * \brief   window mode send process, sends again the packets whose ACK timed out
+ * \param   thisport = which port to use
+ * \return  SSP_TX_WAITING - packets in the window are waiting for their ACK
+ * \return  SSP_TX_TIMEOUT - a packet was not acked after retrying, the window is dropped.
+ * \return  SSP_TX_IDLE    - the window is empty
+ * \return  SSP_TX_ACKED   - all the packets in the window were acked since the last call
+ */
+static int16_t sf_WindowSendProcess(Port_t *thisport)
+{
+    if (thisport->txCount == 0) {
+        if (thisport->SendState == SSP_ACKED) {
+            SETBIT(thisport->flags, ACK_RECEIVED);
+            thisport->SendState = SSP_IDLE;
+            return SSP_TX_ACKED;
+        }
+        thisport->SendState = SSP_IDLE;
+        return SSP_TX_IDLE;
+    }
+
+    uint32_t now = thisport->pfGetTime();
+    for (uint8_t k = 0; k < thisport->txCount; k++) {
+        uint8_t slot = (thisport->txHead + k) % thisport->windowSize;
+        TxSlot_t *s  = &thisport->txSlots[slot];
+        if (s->acked || (int32_t)(now - s->timeout) <= 0) {
+            continue;
+        }
+        if (s->retryCount < thisport->maxRetryCount) {
+            // only this packet is sent again, the others are acked or still have time
+            sf_SendPacket(thisport, sf_TxSlotBuf(thisport, slot));
+            s->retryCount++;
+            s->timeout = now + thisport->timeoutLen;
+        } else {
+            // Give up, the receiver can not hand over anything past this packet
+            thisport->txCount = 0;
+            thisport->TxError++;
+            CLEARBIT(thisport->flags, ACK_RECEIVED);
+            thisport->SendState = SSP_IDLE;
+            return SSP_TX_TIMEOUT;
+        }
+    }
+    return SSP_TX_WAITING;
+}
+
+/*!
+ * \brief   window mode ACK, marks the packet as acked and slides the window past the acked packets
+ * \param   thisport = which port to use
+ * \param	seqNo = sequence number of the acked packet
+ * \return  none.
+ */
+static void sf_WindowAck(Port_t *thisport, uint8_t seqNo)
+{
+    for (uint8_t k = 0; k < thisport->txCount; k++) {
+        TxSlot_t *s = &thisport->txSlots[(thisport->txHead + k) % thisport->windowSize];
+        if (s->seqNo == seqNo) {
+            s->acked = TRUE;
+            break;
+        }
+    }
+    // else ignore the ACK packet, it is for a packet that already left the window
+
+    while (thisport->txCount && thisport->txSlots[thisport->txHead].acked) {
+        thisport->txHead = (thisport->txHead + 1) % thisport->windowSize;
+        thisport->txCount--;
+    }
+    if (thisport->txCount == 0) {
+        thisport->SendState = SSP_ACKED;
+    }
+}
+
+/*!
+ * \brief   window mode data packet. hands over the packets in sequence number order.
+ * \param   thisport = which port to use
+ * \return  true = new data was handed over to the application
+ * \return	false = otherwise
+ *
+ * \note
+ * A packet ahead of the expected one is kept in a rx slot until the missing packets arrive.
+ * Everything else within the window behind the expected packet is a retry whose ACK was lost.
+ */
+static int16_t sf_WindowReceive(Port_t *thisport)
+{
+    uint8_t seqNo = thisport->rxBuf[SEQNUM];
+    uint8_t expected;
+    uint8_t ahead;
+
+    if (seqNo == 0) {
+        // Synchronize sequence number with host
+#ifdef ACTIVE_SYNCH
+        thisport->sendSynch = TRUE;
+#endif
+        sf_SendAckPacket(thisport, seqNo);
+        thisport->rxSeqNo   = 0;
+        memset(thisport->rxSlotSeqNo, 0, sizeof(thisport->rxSlotSeqNo));
+        return FALSE;
+    }
+
+    // no synch yet, take the first packet as is like the stop and wait mode does
+    expected = thisport->rxSeqNo > 0x7F ? seqNo : thisport->rxSeqNo % 0x7F + 1;
+    ahead    = (seqNo + 0x7F - expected) % 0x7F;
+
+    if (ahead == 0) {
+        if (thisport->pfCallBack != NULL) {
+            thisport->pfCallBack(&(thisport->rxBuf[DATA]), thisport->rxBufLen);
+        }
+        thisport->rxSeqNo = seqNo;
+        sf_SendAckPacket(thisport, seqNo);
+
+        // hand over the packets kept while this one was missing
+        for (uint8_t slot = 1; slot < thisport->windowSize;) {
+            if (thisport->rxSlotSeqNo[slot] == thisport->rxSeqNo % 0x7F + 1) {
+                uint8_t *buf = sf_RxSlotBuf(thisport, slot);
+                thisport->rxSlotSeqNo[slot] = 0;
+                thisport->rxSeqNo = buf[SEQNUM];
+                if (thisport->pfCallBack != NULL) {
+                    thisport->pfCallBack(&buf[DATA], buf[LENGTH] - 1);
+                }
+                slot = 1;
+            } else {
+                slot++;
+            }
+        }
+        return TRUE;
+    }
+
+    if (ahead < thisport->windowSize) {
+        uint8_t free = 0;
+        for (uint8_t slot = 1; slot < thisport->windowSize; slot++) {
+            if (thisport->rxSlotSeqNo[slot] == seqNo) {
+                free = slot; // a retry of a packet we already kept
+                break;
+            } else if (free == 0 && thisport->rxSlotSeqNo[slot] == 0) {
+                free = slot;
+            }
+        }
+        if (free == 0) {
+            // can not happen with a sender using the same window size, don't ACK so it is sent again
+            thisport->RxError++;
+            return FALSE;
+        }
+        memcpy(sf_RxSlotBuf(thisport, free), thisport->rxBuf, thisport->rxBufLen + DATA);
+        thisport->rxSlotSeqNo[free] = seqNo;
+    }
+    // else already seen this packet, just ack it, don't act on the packet.
+    sf_SendAckPacket(thisport, seqNo);
+    return FALSE;
+}
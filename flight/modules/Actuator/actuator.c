@@ -48,9 +48,16 @@
 #undef PIOS_INCLUDE_INSTRUMENTATION
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
 #include <pios_instrumentation.h>
-static int8_t counter;
+static pios_counter_t counter;
 // Counter 0xAC700001 total Actuator body execution time(excluding queue waits etc).
+#ifdef REVOLUTION
+#include <sensorsample.h>
+static pios_counter_t latencyCounter;
+// Counter 0xAC700002 age in us of the newest gyro sample when the outputs are updated.
 #endif
+#endif
+#include <pios_instrumentation_helper.h>
+#include <float.h>
 
 // Private constants
 #define MAX_QUEUE_SIZE       2
@@ -69,6 +76,24 @@ static int8_t counter;
 
 // Private types
 
+// a throttle curve as one offset and one slope per segment
+typedef struct {
+    float base[MIXERSETTINGS_THROTTLECURVE1_NUMELEM];
+    float slope[MIXERSETTINGS_THROTTLECURVE1_NUMELEM];
+    bool  passthrough;
+} MixerCurve_t;
+
+// MixerSettings compiled for the mixing, rows of the disabled and non mixing channels are zero
+typedef struct {
+    float    matrix[MAX_MIX_ACTUATORS][MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+    uint8_t  type[MAX_MIX_ACTUATORS];
+    uint32_t mixed; // channels computed from the matrix
+    uint32_t motors; // channels of type Motor
+    uint8_t  nMixers;
+    bool     desaturate;
+    MixerCurve_t curve1;
+    MixerCurve_t curve2;
+} MixerMatrix_t;
 
 // Private variables
 static xQueueHandle queue;
@@ -80,19 +105,24 @@ static float filterAccumulator[MAX_MIX_ACTUATORS] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 static volatile bool actuator_settings_updated;
 // used to inform the actuator thread that mixer settings are changed
 static volatile bool mixer_settings_updated;
+// only accessed by the actuator task
+static MixerMatrix_t mixer;
+PERF_DEFINE_COUNTER(counterMixer);
 
 // Private functions
 static void actuatorTask(void *parameters);
 static int16_t scaleChannel(float value, int16_t max, int16_t min, int16_t neutral);
 static void setFailsafe(const ActuatorSettingsData *actuatorSettings, const MixerSettingsData *mixerSettings);
-static float MixerCurve(const float throttle, const float *curve, uint8_t elements);
+static void compileMixer(const MixerSettingsData *mixerSettings, MixerMatrix_t *m);
+static float MixerCurve(const float throttle, const MixerCurve_t *curve);
+static void mixMatrix(const MixerMatrix_t *m, const float input[MIXERSETTINGS_MIXER1VECTOR_NUMELEM],
+                      float thrust[MAX_MIX_ACTUATORS], float attitude[MAX_MIX_ACTUATORS]);
+static void desaturateMotors(const MixerMatrix_t *m, float thrust[MAX_MIX_ACTUATORS], float attitude[MAX_MIX_ACTUATORS]);
 static bool set_channel(uint8_t mixer_channel, uint16_t value, const ActuatorSettingsData *actuatorSettings);
 static void actuator_update_rate_if_changed(const ActuatorSettingsData *actuatorSettings, bool force_update);
 static void MixerSettingsUpdatedCb(UAVObjEvent *ev);
 static void ActuatorSettingsUpdatedCb(UAVObjEvent *ev);
-float ProcessMixer(const int index, const float curve1, const float curve2,
-                   const MixerSettingsData *mixerSettings, ActuatorDesiredData *desired,
-                   const float period);
+static float ProcessMotor(const int index, float result, const MixerSettingsData *mixerSettings, const float period);
 
 // this structure is equivalent to the UAVObjects for one mixer.
 typedef struct {
@@ -180,6 +210,9 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
     counter = PIOS_Instrumentation_CreateCounter(0xAC700001);
+#ifdef REVOLUTION
+    latencyCounter = PIOS_Instrumentation_CreateStatsCounter(0xAC700002);
+#endif
 #endif
     /* Read initial values of ActuatorSettings */
     ActuatorSettingsData actuatorSettings;
@@ -191,6 +224,8 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
     MixerSettingsData mixerSettings;
     mixer_settings_updated = false;
     MixerSettingsGet(&mixerSettings);
+    compileMixer(&mixerSettings, &mixer);
+    PERF_INIT_STATS_COUNTER(counterMixer, 0xAC700003);
 
     /* Force an initial configuration of the actuator update rates */
     actuator_update_rate_if_changed(&actuatorSettings, true);
@@ -219,6 +254,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         if (mixer_settings_updated) {
             mixer_settings_updated = false;
             MixerSettingsGet(&mixerSettings);
+            compileMixer(&mixerSettings, &mixer);
         }
 
         if (rc != pdTRUE) {
@@ -275,14 +311,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 #ifdef DIAG_MIXERSTATUS
         MixerStatusGet(&mixerStatus);
 #endif
-        int nMixers     = 0;
-        Mixer_t *mixers = (Mixer_t *)&mixerSettings.Mixer1Type;
-        for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-            if (mixers[ct].type != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
-                nMixers++;
-            }
-        }
-        if ((nMixers < 2) && !ActuatorCommandReadOnly()) { // Nothing can fly with less than two mixers.
+        if ((mixer.nMixers < 2) && !ActuatorCommandReadOnly()) { // Nothing can fly with less than two mixers.
             setFailsafe(&actuatorSettings, &mixerSettings); // So that channels like PWM buzzer keep working
             continue;
         }
@@ -293,28 +322,27 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         bool positiveThrottle = (throttleDesired > 0.00f);
         bool spinWhileArmed   = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
 
-        float curve1 = MixerCurve(throttleDesired, mixerSettings.ThrottleCurve1, MIXERSETTINGS_THROTTLECURVE1_NUMELEM);
+        PERF_TIMED_SECTION_START(counterMixer);
+        float curve1 = MixerCurve(throttleDesired, &mixer.curve1);
 
         // The source for the secondary curve is selectable
         float curve2 = 0;
         AccessoryDesiredData accessory;
         switch (mixerSettings.Curve2Source) {
         case MIXERSETTINGS_CURVE2SOURCE_THROTTLE:
-            curve2 = MixerCurve(throttleDesired, mixerSettings.ThrottleCurve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+            curve2 = MixerCurve(throttleDesired, &mixer.curve2);
             break;
         case MIXERSETTINGS_CURVE2SOURCE_ROLL:
-            curve2 = MixerCurve(desired.Roll, mixerSettings.ThrottleCurve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+            curve2 = MixerCurve(desired.Roll, &mixer.curve2);
             break;
         case MIXERSETTINGS_CURVE2SOURCE_PITCH:
-            curve2 = MixerCurve(desired.Pitch, mixerSettings.ThrottleCurve2,
-                                MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+            curve2 = MixerCurve(desired.Pitch, &mixer.curve2);
             break;
         case MIXERSETTINGS_CURVE2SOURCE_YAW:
-            curve2 = MixerCurve(desired.Yaw, mixerSettings.ThrottleCurve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+            curve2 = MixerCurve(desired.Yaw, &mixer.curve2);
             break;
         case MIXERSETTINGS_CURVE2SOURCE_COLLECTIVE:
-            curve2 = MixerCurve(collectiveDesired, mixerSettings.ThrottleCurve2,
-                                MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+            curve2 = MixerCurve(collectiveDesired, &mixer.curve2);
             break;
         case MIXERSETTINGS_CURVE2SOURCE_ACCESSORY0:
         case MIXERSETTINGS_CURVE2SOURCE_ACCESSORY1:
@@ -323,7 +351,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         case MIXERSETTINGS_CURVE2SOURCE_ACCESSORY4:
         case MIXERSETTINGS_CURVE2SOURCE_ACCESSORY5:
             if (AccessoryDesiredInstGet(mixerSettings.Curve2Source - MIXERSETTINGS_CURVE2SOURCE_ACCESSORY0, &accessory) == 0) {
-                curve2 = MixerCurve(accessory.AccessoryVal, mixerSettings.ThrottleCurve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+                curve2 = MixerCurve(accessory.AccessoryVal, &mixer.curve2);
             } else {
                 curve2 = 0;
             }
@@ -332,6 +360,20 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 
         float *status = (float *)&mixerStatus; // access status objects as an array of floats
 
+        // thrust and attitude contributions are kept apart for the desaturation
+        float input[MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+        input[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] = curve1;
+        input[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] = curve2;
+        input[MIXERSETTINGS_MIXER1VECTOR_ROLL]  = desired.Roll;
+        input[MIXERSETTINGS_MIXER1VECTOR_PITCH] = desired.Pitch;
+        input[MIXERSETTINGS_MIXER1VECTOR_YAW]   = desired.Yaw;
+        float thrust[MAX_MIX_ACTUATORS];
+        float attitude[MAX_MIX_ACTUATORS];
+        mixMatrix(&mixer, input, thrust, attitude);
+        if (mixer.desaturate && armed && positiveThrottle) {
+            desaturateMotors(&mixer, thrust, attitude);
+        }
+
         for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
             // During boot all camera actuators should be completely disabled (PWM pulse = 0).
             // command.Channel[i] is reused below as a channel PWM activity flag:
@@ -339,20 +381,22 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
             // Setting it to 1 by default means "Rescale this channel and enable PWM on its output".
             command.Channel[ct] = 1;
 
-            if (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_DISABLED) {
+            if (mixer.type[ct] == MIXERSETTINGS_MIXER1TYPE_DISABLED) {
                 // Set to minimum if disabled.  This is not the same as saying PWM pulse = 0 us
                 status[ct] = -1;
                 continue;
             }
 
-            if ((mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_MOTOR) || (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_REVERSABLEMOTOR) || (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_SERVO)) {
-                status[ct] = ProcessMixer(ct, curve1, curve2, &mixerSettings, &desired, dTSeconds);
+            if (mixer.mixed & (1 << ct)) {
+                status[ct] = thrust[ct] + attitude[ct];
             } else {
                 status[ct] = -1;
             }
 
             // Motors have additional protection for when to be on
-            if (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+            if (mixer.type[ct] == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+                status[ct] = ProcessMotor(ct, status[ct], &mixerSettings, dTSeconds);
+
                 // If not armed or motors aren't meant to spin all the time
                 if (!armed ||
                     (!spinWhileArmed && !positiveThrottle)) {
@@ -368,7 +412,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
             }
 
             // Reversable Motors are like Motors but go to neutral instead of minimum
-            if (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_REVERSABLEMOTOR) {
+            if (mixer.type[ct] == MIXERSETTINGS_MIXER1TYPE_REVERSABLEMOTOR) {
                 // If not armed or motor is inactive - no "spinwhilearmed" for this engine type
                 if (!armed || !activeThrottle) {
                     filterAccumulator[ct] = 0;
@@ -383,20 +427,20 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
             // these also will not be updated in failsafe mode.  I'm not sure what
             // the correct behavior is since it seems domain specific.  I don't love
             // this code
-            if ((mixers[ct].type >= MIXERSETTINGS_MIXER1TYPE_ACCESSORY0) &&
-                (mixers[ct].type <= MIXERSETTINGS_MIXER1TYPE_ACCESSORY5)) {
-                if (AccessoryDesiredInstGet(mixers[ct].type - MIXERSETTINGS_MIXER1TYPE_ACCESSORY0, &accessory) == 0) {
+            if ((mixer.type[ct] >= MIXERSETTINGS_MIXER1TYPE_ACCESSORY0) &&
+                (mixer.type[ct] <= MIXERSETTINGS_MIXER1TYPE_ACCESSORY5)) {
+                if (AccessoryDesiredInstGet(mixer.type[ct] - MIXERSETTINGS_MIXER1TYPE_ACCESSORY0, &accessory) == 0) {
                     status[ct] = accessory.AccessoryVal;
                 } else {
                     status[ct] = -1;
                 }
             }
 
-            if ((mixers[ct].type >= MIXERSETTINGS_MIXER1TYPE_CAMERAROLLORSERVO1) &&
-                (mixers[ct].type <= MIXERSETTINGS_MIXER1TYPE_CAMERAYAW)) {
+            if ((mixer.type[ct] >= MIXERSETTINGS_MIXER1TYPE_CAMERAROLLORSERVO1) &&
+                (mixer.type[ct] <= MIXERSETTINGS_MIXER1TYPE_CAMERAYAW)) {
                 CameraDesiredData cameraDesired;
                 if (CameraDesiredGet(&cameraDesired) == 0) {
-                    switch (mixers[ct].type) {
+                    switch (mixer.type[ct]) {
                     case MIXERSETTINGS_MIXER1TYPE_CAMERAROLLORSERVO1:
                         status[ct] = cameraDesired.RollOrServo1;
                         break;
@@ -419,6 +463,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
                 }
             }
         }
+        PERF_TIMED_SECTION_END(counterMixer);
 
         // Set real actuator output values scaling them from mixers. All channels
         // will be set except explicitly disabled (which will have PWM pulse = 0).
@@ -454,6 +499,9 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
             success &= set_channel(n, command.Channel[n], &actuatorSettings);
         }
 
+        // all single pulse outputs start together, right after the mixing
+        PIOS_Servo_Update();
+
         if (!success) {
             command.NumFailedUpdates++;
             ActuatorCommandSet(&command);
@@ -461,64 +509,164 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         }
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
         PIOS_Instrumentation_TimeEnd(counter);
+#ifdef REVOLUTION
+        sensorsample_t sample;
+        if (sensorsample_get(&sample)) {
+            PIOS_Instrumentation_updateCounter(latencyCounter, PIOS_DELAY_DiffuS(sample.timestamp));
+        }
+#endif
 #endif
     }
 }
 
 
 /**
- * Process mixing for one actuator
+ * Compile the mixer settings into the matrix and the curve segments used by the mixing
  */
-float ProcessMixer(const int index, const float curve1, const float curve2,
-                   const MixerSettingsData *mixerSettings, ActuatorDesiredData *desired, const float period)
+static void compileMixer(const MixerSettingsData *mixerSettings, MixerMatrix_t *m)
 {
-    static float lastFilteredResult[MAX_MIX_ACTUATORS];
     const Mixer_t *mixers = (Mixer_t *)&mixerSettings->Mixer1Type; // pointer to array of mixers in UAVObjects
-    const Mixer_t *mixer  = &mixers[index];
 
-    float result = (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] / 128.0f) * curve1) +
-                   (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] / 128.0f) * curve2) +
-                   (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_ROLL] / 128.0f) * desired->Roll) +
-                   (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_PITCH] / 128.0f) * desired->Pitch) +
-                   (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_YAW] / 128.0f) * desired->Yaw);
+    m->mixed   = 0;
+    m->motors  = 0;
+    m->nMixers = 0;
+    for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+        uint8_t type = mixers[ct].type;
+        bool mixes   = (type == MIXERSETTINGS_MIXER1TYPE_MOTOR) || (type == MIXERSETTINGS_MIXER1TYPE_REVERSABLEMOTOR) || (type == MIXERSETTINGS_MIXER1TYPE_SERVO);
 
-    // note: no feedforward for reversable motors yet for safety reasons
-    if (mixer->type == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
-        if (result < 0.0f) { // idle throttle
-            result = 0.0f;
-        }
-
-        // feed forward
-        float accumulator = filterAccumulator[index];
-        accumulator += (result - lastResult[index]) * mixerSettings->FeedForward;
-        lastResult[index] = result;
-        result += accumulator;
-        if (period > 0.0f) {
-            if (accumulator > 0.0f) {
-                float invFilter = period / mixerSettings->AccelTime;
-                if (invFilter > 1) {
-                    invFilter = 1;
-                }
-                accumulator -= accumulator * invFilter;
-            } else {
-                float invFilter = period / mixerSettings->DecelTime;
-                if (invFilter > 1) {
-                    invFilter = 1;
-                }
-                accumulator -= accumulator * invFilter;
-            }
+        m->type[ct] = type;
+        if (type != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
+            m->nMixers++;
+        }
+        if (mixes) {
+            m->mixed |= 1 << ct;
+        }
+        if (type == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+            m->motors |= 1 << ct;
+        }
+        for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++) {
+            m->matrix[ct][i] = mixes ? (float)mixers[ct].matrix[i] / 128.0f : 0.0f;
+        }
+    }
+
+    const float *curves[2]     = { mixerSettings->ThrottleCurve1, mixerSettings->ThrottleCurve2 };
+    MixerCurve_t *compiled[2]  = { &m->curve1, &m->curve2 };
+    for (int c = 0; c < 2; c++) {
+        const float *curve = curves[c];
+        compiled[c]->passthrough = curve[0] < -1;
+        for (int i = 0; i < MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1; i++) {
+            compiled[c]->base[i]  = curve[i];
+            compiled[c]->slope[i] = curve[i + 1] - curve[i];
+        }
+        // the last point is only reached by clamping
+        compiled[c]->base[MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1]  = curve[MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1];
+        compiled[c]->slope[MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1] = 0.0f;
+    }
+
+    m->desaturate = mixerSettings->MotorDesaturation == MIXERSETTINGS_MOTORDESATURATION_TRUE;
+}
+
+/**
+ * Mix all channels at once, one row of the matrix per channel
+ */
+static void mixMatrix(const MixerMatrix_t *m, const float input[MIXERSETTINGS_MIXER1VECTOR_NUMELEM],
+                      float thrust[MAX_MIX_ACTUATORS], float attitude[MAX_MIX_ACTUATORS])
+{
+    for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+        const float *row = m->matrix[ct];
+        thrust[ct]   = row[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] * input[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] +
+                       row[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] * input[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2];
+        attitude[ct] = row[MIXERSETTINGS_MIXER1VECTOR_ROLL] * input[MIXERSETTINGS_MIXER1VECTOR_ROLL] +
+                       row[MIXERSETTINGS_MIXER1VECTOR_PITCH] * input[MIXERSETTINGS_MIXER1VECTOR_PITCH] +
+                       row[MIXERSETTINGS_MIXER1VECTOR_YAW] * input[MIXERSETTINGS_MIXER1VECTOR_YAW];
+    }
+}
+
+/**
+ * Keep the motors within 0..1 without losing attitude authority: the attitude part is
+ * scaled down when its spread exceeds the range, then all motors are shifted together.
+ */
+static void desaturateMotors(const MixerMatrix_t *m, float thrust[MAX_MIX_ACTUATORS], float attitude[MAX_MIX_ACTUATORS])
+{
+    float attMin = FLT_MAX;
+    float attMax = -FLT_MAX;
+
+    for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+        if (m->motors & (1 << ct)) {
+            attMin = fminf(attMin, attitude[ct]);
+            attMax = fmaxf(attMax, attitude[ct]);
         }
-        filterAccumulator[index] = accumulator;
-        result += accumulator;
+    }
+    if (attMax < attMin) {
+        return; // no motors
+    }
+
+    float scale = attMax - attMin > 1.0f ? 1.0f / (attMax - attMin) : 1.0f;
+    float outMin = FLT_MAX;
+    float outMax = -FLT_MAX;
+    for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+        if (m->motors & (1 << ct)) {
+            attitude[ct] *= scale;
+            outMin = fminf(outMin, thrust[ct] + attitude[ct]);
+            outMax = fmaxf(outMax, thrust[ct] + attitude[ct]);
+        }
+    }
+
+    float shift = 0.0f;
+    if (outMin < 0.0f) {
+        shift = -outMin;
+    } else if (outMax > 1.0f) {
+        shift = 1.0f - outMax;
+    }
+    for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+        if (m->motors & (1 << ct)) {
+            thrust[ct] += shift;
+        }
+    }
+}
 
-        // acceleration limit
-        float dt    = result - lastFilteredResult[index];
-        float maxDt = mixerSettings->MaxAccel * period;
-        if (dt > maxDt) { // we are accelerating too hard
-            result = lastFilteredResult[index] + maxDt;
+/**
+ * Feed forward and acceleration limit of one motor
+ */
+static float ProcessMotor(const int index, float result, const MixerSettingsData *mixerSettings, const float period)
+{
+    static float lastFilteredResult[MAX_MIX_ACTUATORS];
+
+    // note: no feedforward for reversable motors yet for safety reasons
+    if (result < 0.0f) { // idle throttle
+        result = 0.0f;
+    }
+
+    // feed forward
+    float accumulator = filterAccumulator[index];
+    accumulator += (result - lastResult[index]) * mixerSettings->FeedForward;
+    lastResult[index] = result;
+    result += accumulator;
+    if (period > 0.0f) {
+        if (accumulator > 0.0f) {
+            float invFilter = period / mixerSettings->AccelTime;
+            if (invFilter > 1) {
+                invFilter = 1;
+            }
+            accumulator -= accumulator * invFilter;
+        } else {
+            float invFilter = period / mixerSettings->DecelTime;
+            if (invFilter > 1) {
+                invFilter = 1;
+            }
+            accumulator -= accumulator * invFilter;
         }
-        lastFilteredResult[index] = result;
     }
+    filterAccumulator[index] = accumulator;
+    result += accumulator;
+
+    // acceleration limit
+    float dt    = result - lastFilteredResult[index];
+    float maxDt = mixerSettings->MaxAccel * period;
+    if (dt > maxDt) { // we are accelerating too hard
+        result = lastFilteredResult[index] + maxDt;
+    }
+    lastFilteredResult[index] = result;
 
     return result;
 }
@@ -528,27 +676,22 @@ float ProcessMixer(const int index, const float curve1, const float curve2,
  * Interpolate a throttle curve. Throttle input should be in the range 0 to 1.
  * Output is in the range 0 to 1.
  */
-static float MixerCurve(const float throttle, const float *curve, uint8_t elements)
+static float MixerCurve(const float throttle, const MixerCurve_t *curve)
 {
-    float scale = throttle * (float)(elements - 1);
-    int idx1    = scale;
-
-    scale -= (float)idx1; // remainder
-    if (curve[0] < -1) {
+    if (curve->passthrough) {
         return throttle;
     }
-    if (idx1 < 0) {
-        idx1  = 0; // clamp to lowest entry in table
-        scale = 0;
+
+    float scale = throttle * (float)(MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1);
+    int idx     = scale;
+
+    if (idx < 0) {
+        return curve->base[0]; // clamp to lowest entry in table
     }
-    int idx2 = idx1 + 1;
-    if (idx2 >= elements) {
-        idx2 = elements - 1; // clamp to highest entry in table
-        if (idx1 >= elements) {
-            idx1 = elements - 1;
-        }
+    if (idx >= MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1) {
+        return curve->base[MIXERSETTINGS_THROTTLECURVE1_NUMELEM - 1]; // clamp to highest entry in table
     }
-    return curve[idx1] * (1.0f - scale) + curve[idx2] * scale;
+    return curve->base[idx] + curve->slope[idx] * (scale - (float)idx);
 }
 
 
@@ -615,6 +758,7 @@ static void setFailsafe(const ActuatorSettingsData *actuatorSettings, const Mixe
     for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; ++n) {
         set_channel(n, Channel[n], actuatorSettings);
     }
+    PIOS_Servo_Update();
 
     // Update output object's parts that we changed
     ActuatorCommandChannelSet(Channel);
@@ -755,16 +899,27 @@ static bool set_channel(uint8_t mixer_channel, uint16_t value, const ActuatorSet
 static void actuator_update_rate_if_changed(const ActuatorSettingsData *actuatorSettings, bool force_update)
 {
     static uint16_t prevChannelUpdateFreq[ACTUATORSETTINGS_CHANNELUPDATEFREQ_NUMELEM];
+    static uint8_t prevBankMode[ACTUATORSETTINGS_BANKMODE_NUMELEM];
 
-    // check if the any rate setting is changed
+    // check if the any rate or mode setting is changed
     if (force_update ||
         memcmp(prevChannelUpdateFreq,
                actuatorSettings->ChannelUpdateFreq,
-               sizeof(prevChannelUpdateFreq)) != 0) {
+               sizeof(prevChannelUpdateFreq)) != 0 ||
+        memcmp(prevBankMode,
+               actuatorSettings->BankMode,
+               sizeof(prevBankMode)) != 0) {
         /* Something has changed, apply the settings to HW */
         memcpy(prevChannelUpdateFreq,
                actuatorSettings->ChannelUpdateFreq,
                sizeof(prevChannelUpdateFreq));
+        memcpy(prevBankMode,
+               actuatorSettings->BankMode,
+               sizeof(prevBankMode));
+        for (uint8_t i = 0; i < ACTUATORSETTINGS_BANKMODE_NUMELEM; i++) {
+            // the options are in the order of pios_servo_bank_mode, a bank falls back to PWM if it can not run the mode
+            PIOS_Servo_SetBankMode(i, actuatorSettings->BankMode[i]);
+        }
         PIOS_Servo_SetHz(actuatorSettings->ChannelUpdateFreq, ACTUATORSETTINGS_CHANNELUPDATEFREQ_NUMELEM);
     }
 }
@@ -30,44 +30,31 @@
  */
 
 
+
 #include "openpilot.h"
 #include "velocitystate.h"
 #include "attitudestate.h"
 #include "airspeedsensor.h"
 #include "airspeedsettings.h"
+#include "windvelocitystate.h"
 #include "imu_airspeed.h"
-#include "CoordinateConversions.h"
-#include "butterworth.h"
 #include <pios_math.h>
 
 
 // Private constants
-#define EPS               1e-6f
-#define EPS_REORIENTATION 1e-10f
-#define EPS_VELOCITY      1.f
+#define EPS             1e-6f
+#define WIND_SIGMA      5.0f  // m/s, typical wind change over IMUBasedEstimationLowPassPeriod2
+#define AIRSPEED_SIGMA  5.0f  // m/s, typical airspeed change over IMUBasedEstimationLowPassPeriod1
+#define INITIAL_SIGMA   10.0f // m/s, uncertainty of the first guess
+#define VELOCITY_SIGMA2 1.0f  // (m/s)^2, velocity noise and model error (sideslip, vertical wind)
 
 // Private types
-// structure with smoothed fuselage orientation, ground speed, wind vector and their changes in time
+// Kalman filter of the state x = [wind north, wind east, airspeed] with its covariance P.
+// The velocity measured is v = wind + airspeed * xB, xB being the fuselage vector in NED.
 struct IMUGlobals {
-    // Butterworth filters
-    struct ButterWorthDF2Filter filter;
-    struct ButterWorthDF2Filter prefilter;
-    float ff, ffV;
-
-    // storage variables for Butterworth filter
-    float pn1, pn2;
-    float yn1, yn2;
-    float v1n1, v1n2;
-    float v2n1, v2n2;
-    float v3n1, v3n2;
-    float Vw1n1, Vw1n2;
-    float Vw2n1, Vw2n2;
-    float Vw3n1, Vw3n2;
-    float Vw1, Vw2, Vw3;
-
-    // storage variables for derivative calculation
-    float pOld, yOld;
-    float v1Old, v2Old, v3Old;
+    float x[3];
+    float P[3][3];
+    volatile bool velocityUpdated;
 };
 
 
@@ -81,69 +68,115 @@ static inline float Sq(float x)
     return x * x;
 }
 
-// ****** find pitch, yaw from quaternion ********
-static void Quaternion2PY(const float q0, const float q1, const float q2, const float q3, float *pPtr, float *yPtr, bool principalArg)
+// ****** fuselage vector in NED from quaternion, first column of the rotation matrix ********
+static void Quaternion2xB(const float q0, const float q1, const float q2, const float q3, float xB[3])
 {
-    float R13, R11, R12;
-    const float q0s = q0 * q0;
-    const float q1s = q1 * q1;
-    const float q2s = q2 * q2;
-    const float q3s = q3 * q3;
-
-    R13   = 2.0f * (q1 * q3 - q0 * q2);
-    R11   = q0s + q1s - q2s - q3s;
-    R12   = 2.0f * (q1 * q2 + q0 * q3);
-
-    *pPtr = asinf(-R13); // pitch always between -pi/2 to pi/2
-
-    const float y_ = atan2f(R12, R11);
-    // use old yaw contained in y to add multiples of 2pi to have a continuous yaw if user does not want the principal argument
-    // else simply copy atan2 result into result
-    if (principalArg) {
-        *yPtr = y_;
-    } else {
-        // calculate needed mutliples of 2pi to avoid jumps
-        // number of cycles accumulated in old yaw
-        const int32_t cycles = (int32_t)(*yPtr / M_2PI_F);
-        // look for a jump by substracting the modulus, i.e. there is maximally one jump.
-        // take slightly less than 2pi, because the jump will always be lower than 2pi
-        const int32_t mod    = (int32_t)((y_ - (*yPtr - cycles * M_2PI_F)) / (M_2PI_F * 0.8f));
-        *yPtr = y_ + M_2PI_F * (cycles - mod);
-    }
+    xB[0] = Sq(q0) + Sq(q1) - Sq(q2) - Sq(q3);
+    xB[1] = 2.0f * (q1 * q2 + q0 * q3);
+    xB[2] = 2.0f * (q1 * q3 - q0 * q2);
 }
 
-static void PY2xB(const float p, const float y, float x[3])
+static void velocityUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
-    const float cosp = cosf(p);
-
-    x[0] = cosp * cosf(y);
-    x[1] = cosp * sinf(y);
-    x[2] = -sinf(p);
+    imu->velocityUpdated = true;
 }
 
+// covariance of the state after dt, both wind and airspeed are random walks
+static void predict(const float dT, const AirspeedSettingsData *airspeedSettings)
+{
+    const float qWind     = Sq(WIND_SIGMA) * dT / MAX(airspeedSettings->IMUBasedEstimationLowPassPeriod2, EPS);
+    const float qAirspeed = Sq(AIRSPEED_SIGMA) * dT / MAX(airspeedSettings->IMUBasedEstimationLowPassPeriod1, EPS);
+
+    imu->P[0][0] += qWind;
+    imu->P[1][1] += qWind;
+    imu->P[2][2] += qAirspeed;
+}
 
-static void PY2DeltaxB(const float p, const float y, const float xB[3], float x[3])
+// Kalman update with the measured velocity v, H = [ 1 0 xB0 ; 0 1 xB1 ; 0 0 xB2 ]
+static void update(const float v[3], const float xB[3])
 {
-    const float cosp = cosf(p);
+    float (*P)[3] = imu->P;
+    float *x = imu->x;
+
+    // P H'
+    float PHt[3][3];
+
+    for (uint8_t i = 0; i < 3; i++) {
+        PHt[i][0] = P[i][0] + P[i][2] * xB[0];
+        PHt[i][1] = P[i][1] + P[i][2] * xB[1];
+        PHt[i][2] = P[i][2] * xB[2];
+    }
+
+    // S = H P H' + R, symmetric
+    float S[3][3];
+    for (uint8_t j = 0; j < 3; j++) {
+        S[0][j] = PHt[0][j] + xB[0] * PHt[2][j];
+        S[1][j] = PHt[1][j] + xB[1] * PHt[2][j];
+        S[2][j] = xB[2] * PHt[2][j];
+    }
+    S[0][0] += VELOCITY_SIGMA2;
+    S[1][1] += VELOCITY_SIGMA2;
+    S[2][2] += VELOCITY_SIGMA2;
+
+    // S^-1 from the cofactors
+    float Si[3][3];
+    Si[0][0] = S[1][1] * S[2][2] - S[1][2] * S[2][1];
+    Si[0][1] = S[0][2] * S[2][1] - S[0][1] * S[2][2];
+    Si[0][2] = S[0][1] * S[1][2] - S[0][2] * S[1][1];
+    const float det = S[0][0] * Si[0][0] + S[1][0] * Si[0][1] + S[2][0] * Si[0][2];
+    if (fabsf(det) < EPS) {
+        return;
+    }
+    Si[1][0] = S[1][2] * S[2][0] - S[1][0] * S[2][2];
+    Si[1][1] = S[0][0] * S[2][2] - S[0][2] * S[2][0];
+    Si[1][2] = S[0][2] * S[1][0] - S[0][0] * S[1][2];
+    Si[2][0] = S[1][0] * S[2][1] - S[1][1] * S[2][0];
+    Si[2][1] = S[0][1] * S[2][0] - S[0][0] * S[2][1];
+    Si[2][2] = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+
+    // K = P H' S^-1
+    const float invDet = 1.0f / det;
+    float K[3][3];
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            K[i][j] = (PHt[i][0] * Si[0][j] + PHt[i][1] * Si[1][j] + PHt[i][2] * Si[2][j]) * invDet;
+        }
+    }
+
+    // innovation
+    const float y[3] = {
+        v[0] - (x[0] + x[2] * xB[0]),
+        v[1] - (x[1] + x[2] * xB[1]),
+        v[2] - x[2] * xB[2]
+    };
+    for (uint8_t i = 0; i < 3; i++) {
+        x[i] += K[i][0] * y[0] + K[i][1] * y[1] + K[i][2] * y[2];
+    }
+    // flying backwards is not a solution
+    if (x[2] < 0.0f) {
+        x[2] = 0.0f;
+    }
 
-    x[0] = xB[0] - cosp * cosf(y);
-    x[1] = xB[1] - cosp * sinf(y);
-    x[2] = xB[2] - -sinf(p);
+    // P = P - K H P = P - K (P H')', kept symmetric
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = i; j < 3; j++) {
+            P[i][j] -= K[i][0] * PHt[j][0] + K[i][1] * PHt[j][1] + K[i][2] * PHt[j][2];
+            P[j][i]  = P[i][j];
+        }
+    }
 }
 
 
 /*
  * Initialize function loads first data sets, and allocates memory for structure.
  */
-void imu_airspeedInitialize(const AirspeedSettingsData *airspeedSettings)
+void imu_airspeedInitialize(__attribute__((unused)) const AirspeedSettingsData *airspeedSettings)
 {
-    // pre-filter frequency rate
-    const float ff  = (float)(airspeedSettings->SamplePeriod) / 1000.0f / airspeedSettings->IMUBasedEstimationLowPassPeriod1;
-    // filter frequency rate
-    const float ffV = (float)(airspeedSettings->SamplePeriod) / 1000.0f / airspeedSettings->IMUBasedEstimationLowPassPeriod2;
-
     // This method saves memory in case we don't use the module.
-    imu = (struct IMUGlobals *)pios_malloc(sizeof(struct IMUGlobals));
+    if (!imu) {
+        imu = (struct IMUGlobals *)pios_malloc(sizeof(struct IMUGlobals));
+        PIOS_Assert(imu);
+    }
 
     // airspeed calculation variables
     VelocityStateInitialize();
@@ -153,142 +186,65 @@ void imu_airspeedInitialize(const AirspeedSettingsData *airspeedSettings)
     AttitudeStateData attData;
     AttitudeStateGet(&attData);
 
-    // initialize filters for given ff and ffV
-    InitButterWorthDF2Filter(ffV, &(imu->filter));
-    InitButterWorthDF2Filter(ff, &(imu->prefilter));
-    imu->ffV = ffV;
-    imu->ff  = ff;
-
-    // get pitch and yaw from quarternion; principal argument for yaw
-    Quaternion2PY(attData.q1, attData.q2, attData.q3, attData.q4, &(imu->pOld), &(imu->yOld), true);
-    InitButterWorthDF2Values(imu->pOld, &(imu->prefilter), &(imu->pn1), &(imu->pn2));
-    InitButterWorthDF2Values(imu->yOld, &(imu->prefilter), &(imu->yn1), &(imu->yn2));
-
-    // use current NED speed as vOld vector and as initial value for filter
-    imu->v1Old = velData.North;
-    imu->v2Old = velData.East;
-    imu->v3Old = velData.Down;
-    InitButterWorthDF2Values(imu->v1Old, &(imu->prefilter), &(imu->v1n1), &(imu->v1n2));
-    InitButterWorthDF2Values(imu->v2Old, &(imu->prefilter), &(imu->v2n1), &(imu->v2n2));
-    InitButterWorthDF2Values(imu->v3Old, &(imu->prefilter), &(imu->v3n1), &(imu->v3n2));
-
-    // initial guess for windspeed is zero
-    imu->Vw3   = imu->Vw2 = imu->Vw1 = 0.0f;
-    InitButterWorthDF2Values(0.0f, &(imu->filter), &(imu->Vw1n1), &(imu->Vw1n2));
-    imu->Vw3n1 = imu->Vw2n1 = imu->Vw1n1;
-    imu->Vw3n2 = imu->Vw2n2 = imu->Vw1n2;
+    WindVelocityStateInitialize();
+
+    // initial guess for windspeed is zero, so airspeed is the groundspeed along the fuselage
+    float xB[3];
+    Quaternion2xB(attData.q1, attData.q2, attData.q3, attData.q4, xB);
+    imu->x[0] = 0.0f;
+    imu->x[1] = 0.0f;
+    imu->x[2] = MAX(velData.North * xB[0] + velData.East * xB[1] + velData.Down * xB[2], 0.0f);
+    memset(imu->P, 0, sizeof(imu->P));
+    imu->P[0][0] = imu->P[1][1] = imu->P[2][2] = Sq(INITIAL_SIGMA);
+
+    imu->velocityUpdated = false;
+    VelocityStateConnectCallback(&velocityUpdatedCb);
 }
 
 /*
  * Calculate airspeed as a function of groundspeed and vehicle attitude.
  *  Adapted from "IMU Wind Estimation (Theory)", by William Premerlani.
- *  The idea is that V_gps=V_air+V_wind. If we assume wind constant, =>
- *  V_gps_2-V_gps_1 = (V_air_2+V_wind_2) -(V_air_1+V_wind_1) = V_air_2 - V_air_1.
- *  If we assume airspeed constant, => V_gps_2-V_gps_1 = |V|*(f_2 - f1),
- *  where "f" is the fuselage vector in earth coordinates.
- *  We then solve for |V| = |V_gps_2-V_gps_1|/ |f_2 - f1|.
- *  Adapted to: |V| = (V_gps_2-V_gps_1) dot (f2_-f_1) / |f_2 - f1|^2.
+ *  The idea is that V_gps=V_air+V_wind, with V_air = |V| * f where "f" is the fuselage
+ *  vector in earth coordinates. A change of orientation with unchanged wind and
+ *  airspeed tells |V| and V_wind apart.
  *
- * See OP-1317 imu_wind_estimation.pdf for details on the adaptation
- * Need a low pass filter to filter out spikes in non coordinated maneuvers
- * A two step Butterworth second order filter is used. In the first step fuselage vector xB
- * and ground speed vector Vel are filtered. The fuselage vector is filtered through its pitch
- * and yaw to keep a unit length. After building the differenced dxB and dVel are produced and
- * the airspeed calculated. The calculated airspeed is filtered again with a Butterworth filter
+ * See OP-1317 imu_wind_estimation.pdf for the original adaptation.
+ * Here a Kalman filter of the horizontal wind and |V| does the separation, the
+ * covariance keeps track of what the past orientations made observable. Both are
+ * random walks, fast for |V| and slow for the wind, so steady flight attributes
+ * speed changes to the airspeed. The measurement update runs on each new VelocityState,
+ * whatever its rate, while the prediction and the airspeed output run every sample
+ * with the current attitude.
  */
 void imu_airspeedGet(AirspeedSensorData *airspeedData, const AirspeedSettingsData *airspeedSettings)
 {
-    // pre-filter frequency rate
-    const float ff  = (float)(airspeedSettings->SamplePeriod) / 1000.0f / airspeedSettings->IMUBasedEstimationLowPassPeriod1;
-    // filter frequency rate
-    const float ffV = (float)(airspeedSettings->SamplePeriod) / 1000.0f / airspeedSettings->IMUBasedEstimationLowPassPeriod2;
-
-    // check for a change in filter frequency rate. if yes, then actualize filter constants and intermediate values
-    if (fabsf(ffV - imu->ffV) > EPS) {
-        InitButterWorthDF2Filter(ffV, &(imu->filter));
-        InitButterWorthDF2Values(imu->Vw1, &(imu->filter), &(imu->Vw1n1), &(imu->Vw1n2));
-        InitButterWorthDF2Values(imu->Vw2, &(imu->filter), &(imu->Vw2n1), &(imu->Vw2n2));
-        InitButterWorthDF2Values(imu->Vw3, &(imu->filter), &(imu->Vw3n1), &(imu->Vw3n2));
-    }
-    if (fabsf(ff - imu->ff) > EPS) {
-        InitButterWorthDF2Filter(ff, &(imu->prefilter));
-        InitButterWorthDF2Values(imu->pOld, &(imu->prefilter), &(imu->pn1), &(imu->pn2));
-        InitButterWorthDF2Values(imu->yOld, &(imu->prefilter), &(imu->yn1), &(imu->yn2));
-        InitButterWorthDF2Values(imu->v1Old, &(imu->prefilter), &(imu->v1n1), &(imu->v1n2));
-        InitButterWorthDF2Values(imu->v2Old, &(imu->prefilter), &(imu->v2n1), &(imu->v2n2));
-        InitButterWorthDF2Values(imu->v3Old, &(imu->prefilter), &(imu->v3n1), &(imu->v3n2));
-    }
+    const float dT = (float)(airspeedSettings->SamplePeriod) / 1000.0f;
 
-    float normVel2;
-    float normDiffAttitude2;
-    float dvdtDotdfdt;
+    AttitudeStateData attData;
+    AttitudeStateGet(&attData);
+    VelocityStateData velData;
+    VelocityStateGet(&velData);
 
     float xB[3];
-    // get values and conduct smoothing of ground speed and orientation independently of the calculation of airspeed
-    { // Scoping to save memory
-        AttitudeStateData attData;
-        AttitudeStateGet(&attData);
-        VelocityStateData velData;
-        VelocityStateGet(&velData);
-        float p = imu->pOld, y = imu->yOld;
-        float dxB[3];
-
-        // get pitch and roll Euler angles from quaternion
-        // do not calculate the principlal argument of yaw, i.e. use old yaw to add multiples of 2pi to have a continuous yaw
-        Quaternion2PY(attData.q1, attData.q2, attData.q3, attData.q4, &p, &y, false);
-
-        // filter pitch and roll Euler angles instead of fuselage vector to guarantee a unit length at all times
-        p = FilterButterWorthDF2(p, &(imu->prefilter), &(imu->pn1), &(imu->pn2));
-        y = FilterButterWorthDF2(y, &(imu->prefilter), &(imu->yn1), &(imu->yn2));
-        // transform pitch and yaw into fuselage vector xB and xBold
-        PY2xB(p, y, xB);
-        // calculate change in fuselage vector by substraction of old value
-        PY2DeltaxB(imu->pOld, imu->yOld, xB, dxB);
-
-        // filter ground speed from VelocityState
-        const float fv1n = FilterButterWorthDF2(velData.North, &(imu->prefilter), &(imu->v1n1), &(imu->v1n2));
-        const float fv2n = FilterButterWorthDF2(velData.East, &(imu->prefilter), &(imu->v2n1), &(imu->v2n2));
-        const float fv3n = FilterButterWorthDF2(velData.Down, &(imu->prefilter), &(imu->v3n1), &(imu->v3n2));
-
-        // calculate norm of ground speed
-        normVel2 = Sq(fv1n) + Sq(fv2n) + Sq(fv3n);
-        // calculate norm of orientation change
-        normDiffAttitude2 = Sq(dxB[0]) + Sq(dxB[1]) + Sq(dxB[2]);
-        // cauclate scalar product between groundspeed change and orientation change
-        dvdtDotdfdt = (fv1n - imu->v1Old) * dxB[0] + (fv2n - imu->v2Old) * dxB[1] + (fv3n - imu->v3Old) * dxB[2];
-
-        // actualise old values
-        imu->pOld   = p;
-        imu->yOld   = y;
-        imu->v1Old  = fv1n;
-        imu->v2Old  = fv2n;
-        imu->v3Old  = fv3n;
-    }
+    Quaternion2xB(attData.q1, attData.q2, attData.q3, attData.q4, xB);
+
+    predict(dT, airspeedSettings);
+    if (imu->velocityUpdated) {
+        imu->velocityUpdated = false;
+        update(&velData.North, xB);
 
-    // Some reorientation needed to be able to calculate airspeed, calculate only for sufficient velocity
-    // a negative scalar product is a clear sign that we are not really able to calculate the airspeed
-    // NOTE: normVel2 check against EPS_VELOCITY might make problems during hovering maneuvers in fixed wings
-    if (normDiffAttitude2 > EPS_REORIENTATION && normVel2 > EPS_VELOCITY && dvdtDotdfdt > 0.f) {
-        // Airspeed modulus: |v| = dv/dt * dxB/dt / |dxB/dt|^2
-        // airspeed is always REAL because  normDiffAttitude2 > EPS_REORIENTATION > 0 and REAL dvdtDotdfdt
-        const float airspeed = dvdtDotdfdt / normDiffAttitude2;
-
-        // groundspeed = airspeed + wind ---> wind = groundspeed - airspeed
-        const float wind[3]  = { imu->v1Old - xB[0] * airspeed,
-                                 imu->v2Old - xB[1] * airspeed,
-                                 imu->v3Old - xB[2] * airspeed };
-        // filter raw wind
-        imu->Vw1 = FilterButterWorthDF2(wind[0], &(imu->filter), &(imu->Vw1n1), &(imu->Vw1n2));
-        imu->Vw2 = FilterButterWorthDF2(wind[1], &(imu->filter), &(imu->Vw2n1), &(imu->Vw2n2));
-        imu->Vw3 = FilterButterWorthDF2(wind[2], &(imu->filter), &(imu->Vw3n1), &(imu->Vw3n2));
-    } // else leave wind estimation unchanged
+        WindVelocityStateData windData;
+        windData.North = imu->x[0];
+        windData.East  = imu->x[1];
+        WindVelocityStateSet(&windData);
+    }
 
     { // Scoping to save memory
       // airspeed = groundspeed - wind
         const float Vair[3] = {
-            imu->v1Old - imu->Vw1,
-            imu->v2Old - imu->Vw2,
-            imu->v3Old - imu->Vw3
+            velData.North - imu->x[0],
+            velData.East - imu->x[1],
+            velData.Down
         };
 
         // project airspeed into fuselage vector
@@ -33,6 +33,10 @@
  * Output object: BaroSensor
  *
  * This module will periodically update the value of the BaroSensor object.
+ * The conversions of the sensor are chained by a callback, scheduled when
+ * the running conversion completes: a temperature conversion every
+ * BaroTemperatureDecimation pressure conversions. The I2C transfers are
+ * asynchronous requests where the driver supports them.
  *
  */
 
@@ -45,34 +49,49 @@
 #if defined(PIOS_INCLUDE_HCSR04)
 #include "sonaraltitude.h" // object that will be updated by the module
 #endif
-#include "taskinfo.h"
+#include "callbackinfo.h"
 
 // Private constants
 #define STACK_SIZE_BYTES    550
-#define TASK_PRIORITY       (tskIDLE_PRIORITY + 1)
+#define CALLBACK_PRIORITY   CALLBACK_PRIORITY_REGULAR
+#define CBTASK_PRIORITY     CALLBACK_TASK_AUXILIARY
+
+// Delay before retrying a conversion which failed to start or to be read
+#define RETRY_DELAY_MS      1
 
 // Interval in number of sample to recalculate temp bias
 #define TEMP_CALIB_INTERVAL 10
 
-// LPF
+// LPF, TEMP_DT is the period of the temperature samples without decimation
 #define TEMP_DT             (1.0f / 120.0f)
 #define TEMP_LPF_FC         5.0f
-static const float temp_alpha = TEMP_DT / (TEMP_DT + 1.0f / (2.0f * M_PI_F * TEMP_LPF_FC));
 
 // Private types
 
 // Private variables
-static xTaskHandle taskHandle;
+static DelayedCallbackInfo *altitudeCBInfo;
 static RevoSettingsBaroTempCorrectionPolynomialData baroCorrection;
 static RevoSettingsBaroTempCorrectionExtentData baroCorrectionExtent;
 static volatile bool tempCorrectionEnabled;
+static volatile uint8_t tempDecimation = 1;
+static volatile float temp_alpha;
 
 static float baro_temp_bias   = 0;
 static float baro_temperature = NAN;
 static uint8_t temp_calibration_count = 0;
 
+// Conversion requested, and pressure conversions until the next temperature one
+static ConversionTypeTypeDef conversion;
+static uint8_t pressureCount = 0;
+// Conversion request in progress
+static volatile bool requestPending = false;
+static volatile bool requestDone    = false;
+static volatile int32_t requestStatus;
+
 // Private functions
-static void altitudeTask(void *parameters);
+static void altitudeCb(void);
+static void requestCompleted(int32_t status, bool *woken);
+static void pressureUpdated(void);
 static void SettingsUpdatedCb(UAVObjEvent *ev);
 
 /**
@@ -81,9 +100,9 @@ static void SettingsUpdatedCb(UAVObjEvent *ev);
  */
 int32_t AltitudeStart()
 {
-    // Start main task
-    xTaskCreate(altitudeTask, "Altitude", STACK_SIZE_BYTES / 4, NULL, TASK_PRIORITY, &taskHandle);
-    PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_ALTITUDE, taskHandle);
+    // Start the conversions
+    altitudeCBInfo = PIOS_CALLBACKSCHEDULER_Create(&altitudeCb, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_ALTITUDE, STACK_SIZE_BYTES);
+    PIOS_CALLBACKSCHEDULER_Dispatch(altitudeCBInfo);
 
     return 0;
 }
@@ -104,107 +123,160 @@ int32_t AltitudeInitialize()
     return 0;
 }
 MODULE_INITCALL(AltitudeInitialize, AltitudeStart);
+
 /**
- * Module thread, should not return.
+ * Conversion callback, requests the read of the completed conversion and the
+ * start of the next one. It runs again at the end of the request, to handle
+ * the conversion read, then when the new conversion is completed. It never
+ * waits for the sensor nor the bus.
  */
-static void altitudeTask(__attribute__((unused)) void *parameters)
+static void altitudeCb(void)
 {
-    BaroSensorData data;
+    if (requestPending) {
+        if (!requestDone) {
+            return;
+        }
+        requestPending = false;
+        requestDone    = false;
 
-#if defined(PIOS_INCLUDE_HCSR04)
-    SonarAltitudeData sonardata;
-    int32_t value = 0, timeout = 10, sample_rate = 0;
-    float coeff   = 0.25, height_out = 0, height_in = 0;
-    PIOS_HCSR04_Trigger();
-#endif
+        ConversionTypeTypeDef read;
+        int32_t result = PIOS_MS5611_ReadRequestedADC(&read);
+        if (result == -1) {
+            // The pressure is not compensated without a valid temperature
+            if (read == TemperatureConv) {
+                pressureCount = 0;
+            }
+        } else if (result == 0) {
+            if (read == TemperatureConv) {
+                float temp = PIOS_MS5611_GetTemperature();
+                if (isnan(baro_temperature)) {
+                    baro_temperature = temp;
+                }
+                baro_temperature = temp_alpha * (temp - baro_temperature) + baro_temperature;
+            } else {
+                pressureUpdated();
+            }
+        }
+
+        if (requestStatus != 0) {
+            if (conversion == TemperatureConv) {
+                pressureCount = 0;
+            }
+            PIOS_CALLBACKSCHEDULER_Schedule(altitudeCBInfo, RETRY_DELAY_MS, CALLBACK_UPDATEMODE_OVERRIDE);
+        } else {
+            PIOS_CALLBACKSCHEDULER_Schedule(altitudeCBInfo, PIOS_MS5611_GetDelay(), CALLBACK_UPDATEMODE_OVERRIDE);
+        }
+        return;
+    }
 
-    // TODO: Check the pressure sensor and set a warning if it fails test
+    // Read the completed conversion and start the next one, a temperature one first
+    ConversionTypeTypeDef next = pressureCount ? PressureConv : TemperatureConv;
+    // The request can complete before it returns
+    requestPending = true;
+    if (PIOS_MS5611_RequestADC(next, &requestCompleted) != 0) {
+        // Scheduled a bit early, or the request failed
+        requestPending = false;
+        PIOS_CALLBACKSCHEDULER_Schedule(altitudeCBInfo, RETRY_DELAY_MS, CALLBACK_UPDATEMODE_OVERRIDE);
+        return;
+    }
+    if (next == TemperatureConv) {
+        pressureCount = tempDecimation;
+    } else {
+        pressureCount--;
+    }
+    conversion = next;
+}
 
-// Option to change the interleave between Temp and Pressure conversions
-// Undef for normal operation
-// #define PIOS_MS5611_SLOW_TEMP_RATE 20
+/**
+ * End of the conversion request, from the I2C interrupt
+ */
+static void requestCompleted(int32_t status, bool *woken)
+{
+    long higherPriorityTaskWoken = pdFALSE;
 
-    RevoSettingsBaroTempCorrectionPolynomialGet(&baroCorrection);
+    requestStatus = status;
+    requestDone   = true;
+    PIOS_CALLBACKSCHEDULER_DispatchFromISR(altitudeCBInfo, &higherPriorityTaskWoken);
+    if (woken) {
+        *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+    }
+}
 
-#ifdef PIOS_MS5611_SLOW_TEMP_RATE
-    uint8_t temp_press_interleave_count = 1;
-#endif
-    // Main task loop
-    while (1) {
 #if defined(PIOS_INCLUDE_HCSR04)
-        // Compute the current altitude
-        // depends on baro samplerate
-        if (!(sample_rate--)) {
-            if (PIOS_HCSR04_Completed()) {
-                value = PIOS_HCSR04_Get();
-                // from 3.4cm to 5.1m
-                if ((value > 100) && (value < 15000)) {
-                    height_in  = value * 0.00034f / 2.0f;
-                    height_out = (height_out * (1 - coeff)) + (height_in * coeff);
-                    sonardata.Altitude = height_out; // m/us
-                }
+/**
+ * Reads the sonar, depends on the baro samplerate
+ */
+static void sonarUpdate(void)
+{
+    static SonarAltitudeData sonardata;
+    static int32_t timeout = 10, sample_rate = 0;
+    static float height_out = 0;
+    static bool triggered   = false;
+    const float coeff = 0.25;
 
-                // Update the SonarAltitude UAVObject
-                SonarAltitudeSet(&sonardata);
-                timeout = 10;
-                PIOS_HCSR04_Trigger();
-            }
-            if (!(timeout--)) {
-                // retrigger
-                timeout = 10;
-                PIOS_HCSR04_Trigger();
+    if (!triggered) {
+        PIOS_HCSR04_Trigger();
+        triggered = true;
+    }
+
+    // Compute the current altitude
+    if (!(sample_rate--)) {
+        if (PIOS_HCSR04_Completed()) {
+            int32_t value = PIOS_HCSR04_Get();
+            // from 3.4cm to 5.1m
+            if ((value > 100) && (value < 15000)) {
+                float height_in = value * 0.00034f / 2.0f;
+                height_out = (height_out * (1 - coeff)) + (height_in * coeff);
+                sonardata.Altitude = height_out; // m/us
             }
-            sample_rate = 25;
-        }
-#endif /* if defined(PIOS_INCLUDE_HCSR04) */
-        float temp, press;
-#ifdef PIOS_MS5611_SLOW_TEMP_RATE
-        temp_press_interleave_count--;
-        if (temp_press_interleave_count == 0) {
-#endif
-        // Update the temperature data
-        PIOS_MS5611_StartADC(TemperatureConv);
-        vTaskDelay(PIOS_MS5611_GetDelay());
-        PIOS_MS5611_ReadADC();
 
-#ifdef PIOS_MS5611_SLOW_TEMP_RATE
-        temp_press_interleave_count = PIOS_MS5611_SLOW_TEMP_RATE;
+            // Update the SonarAltitude UAVObject
+            SonarAltitudeSet(&sonardata);
+            timeout = 10;
+            PIOS_HCSR04_Trigger();
+        }
+        if (!(timeout--)) {
+            // retrigger
+            timeout = 10;
+            PIOS_HCSR04_Trigger();
+        }
+        sample_rate = 25;
     }
-#endif
-
-        // Update the pressure data
-        PIOS_MS5611_StartADC(PressureConv);
-        vTaskDelay(PIOS_MS5611_GetDelay());
-        PIOS_MS5611_ReadADC();
+}
+#endif /* if defined(PIOS_INCLUDE_HCSR04) */
 
-        temp  = PIOS_MS5611_GetTemperature();
-        press = PIOS_MS5611_GetPressure();
+/**
+ * Updates the BaroSensor object from a new pressure sample
+ */
+static void pressureUpdated(void)
+{
+    BaroSensorData data;
 
-        if (isnan(baro_temperature)) {
-            baro_temperature = temp;
-        }
+#if defined(PIOS_INCLUDE_HCSR04)
+    sonarUpdate();
+#endif
 
-        baro_temperature = temp_alpha * (temp - baro_temperature) + baro_temperature;
+    float temp  = PIOS_MS5611_GetTemperature();
+    float press = PIOS_MS5611_GetPressure();
 
-        if (tempCorrectionEnabled && !temp_calibration_count) {
-            temp_calibration_count = TEMP_CALIB_INTERVAL;
-            // pressure bias = A + B*t + C*t^2 + D * t^3
-            // in case the temperature is outside of the calibrated range, uses the nearest extremes
-            float ctemp = boundf(baro_temperature, baroCorrectionExtent.max, baroCorrectionExtent.min);
-            baro_temp_bias = baroCorrection.a + ((baroCorrection.d * ctemp + baroCorrection.c) * ctemp + baroCorrection.b) * ctemp;
-        }
+    if (tempCorrectionEnabled && !temp_calibration_count) {
+        temp_calibration_count = TEMP_CALIB_INTERVAL;
+        // pressure bias = A + B*t + C*t^2 + D * t^3
+        // in case the temperature is outside of the calibrated range, uses the nearest extremes
+        float ctemp = boundf(baro_temperature, baroCorrectionExtent.max, baroCorrectionExtent.min);
+        baro_temp_bias = baroCorrection.a + ((baroCorrection.d * ctemp + baroCorrection.c) * ctemp + baroCorrection.b) * ctemp;
+    }
 
-        press -= baro_temp_bias;
+    press -= baro_temp_bias;
 
-        float altitude = 44330.0f * (1.0f - powf((press) / MS5611_P0, (1.0f / 5.255f)));
+    float altitude = 44330.0f * (1.0f - powf((press) / MS5611_P0, (1.0f / 5.255f)));
 
-        if (!isnan(altitude)) {
-            data.Altitude    = altitude;
-            data.Temperature = temp;
-            data.Pressure    = press;
-            // Update the BasoSensor UAVObject
-            BaroSensorSet(&data);
-        }
+    if (!isnan(altitude)) {
+        data.Altitude    = altitude;
+        data.Temperature = temp;
+        data.Pressure    = press;
+        // Update the BasoSensor UAVObject
+        BaroSensorSet(&data);
     }
 }
 
@@ -214,6 +286,13 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     RevoSettingsBaroTempCorrectionExtentGet(&baroCorrectionExtent);
     tempCorrectionEnabled = !(baroCorrectionExtent.max - baroCorrectionExtent.min < 0.1f ||
                               (baroCorrection.a < 1e-9f && baroCorrection.b < 1e-9f && baroCorrection.c < 1e-9f && baroCorrection.d < 1e-9f));
+
+    uint8_t decimation;
+    RevoSettingsBaroTemperatureDecimationGet(&decimation);
+    tempDecimation = decimation ? decimation : 1;
+    // The temperature is filtered at the rate of its samples
+    const float dt = TEMP_DT * tempDecimation;
+    temp_alpha = dt / (dt + 1.0f / (2.0f * M_PI_F * TEMP_LPF_FC));
 }
 /**
  * @}
@@ -99,6 +99,17 @@ static const float temp_alpha = TEMP_DT / (TEMP_DT + 1.0f / (2.0f * M_PI_F * TEM
 #define UPDATE_MAX          1.0f
 #define UPDATE_ALPHA        1.0e-2f
 
+// The accel correction is worked out every ACCEL_DECIMATION updates from the mean of
+// their accels, and held in between
+#ifdef PIOS_ATTITUDE_ACCEL_DECIMATION
+#define ACCEL_DECIMATION    PIOS_ATTITUDE_ACCEL_DECIMATION
+#else
+#define ACCEL_DECIMATION    1
+#endif
+
+// Largest drift of the squared quaternion norm left to the first order renormalization
+#define QMAG_APPROX_MAX     1.0e-2f
+
 // Private types
 
 // Private variables
@@ -122,6 +133,9 @@ static float accel_alpha = 0;
 static bool accel_filter_enabled = false;
 static float accels_filtered[3];
 static float grot_filtered[3];
+static float accels_sum[3];
+static uint8_t accels_summed = 0;
+static float accel_err[3];
 static float yawBiasRate = 0;
 static float rollPitchBiasRate = 0.0f;
 static AccelGyroSettingsaccel_biasData accel_bias;
@@ -455,33 +469,31 @@ static int32_t updateSensors(AccelStateData *accelState, GyroStateData *gyros)
  * @param[in] attitudeRaw Populate the UAVO instead of saving right here
  * @return 0 if successfull, -1 if not
  */
-static struct pios_mpu6000_data mpu6000_data;
 static int32_t updateSensorsCC3D(AccelStateData *accelStateData, GyroStateData *gyrosData)
 {
     float accels[3] = { 0 };
     float gyros[3]  = { 0 };
     float temp = 0;
-    uint8_t count   = 0;
+    uint16_t count  = 0;
 
 #if defined(PIOS_INCLUDE_MPU6000)
 
-    xQueueHandle queue = PIOS_MPU6000_GetQueue();
-    BaseType_t ret     = xQueueReceive(queue, (void *)&mpu6000_data, sensor_period_ms);
-    while (ret == pdTRUE) {
-        gyros[0]  += mpu6000_data.gyro_x;
-        gyros[1]  += mpu6000_data.gyro_y;
-        gyros[2]  += mpu6000_data.gyro_z;
+    // The driver sums the samples in the interrupt, the loop timing paces the reads
+    struct pios_mpu6000_sum mpu6000_sum;
+    if (PIOS_MPU6000_ReadSum(&mpu6000_sum) != 0) {
+        return -1;
+    }
+    gyros[0]  = mpu6000_sum.gyro_x;
+    gyros[1]  = mpu6000_sum.gyro_y;
+    gyros[2]  = mpu6000_sum.gyro_z;
 
-        accels[0] += mpu6000_data.accel_x;
-        accels[1] += mpu6000_data.accel_y;
-        accels[2] += mpu6000_data.accel_z;
+    accels[0] = mpu6000_sum.accel_x;
+    accels[1] = mpu6000_sum.accel_y;
+    accels[2] = mpu6000_sum.accel_z;
 
-        temp += mpu6000_data.temperature;
+    temp  = mpu6000_sum.temperature;
 
-        count++;
-        // check if further samples are already in queue
-        ret = xQueueReceive(queue, (void *)&mpu6000_data, 0);
-    }
+    count = mpu6000_sum.count;
     PERF_TRACK_VALUE(counterAccelSamples, count);
 
     if (!count) {
@@ -603,42 +615,55 @@ __attribute__((optimize("O3"))) static void updateAttitude(AccelStateData *accel
     float *accels = &accelStateData->x;
 
     float grot[3];
-    float accel_err[3];
 
-    // Apply smoothing to accel values, to reduce vibration noise before main calculations.
-    apply_accel_filter(accels, accels_filtered);
+    accels_sum[0] += accels[0];
+    accels_sum[1] += accels[1];
+    accels_sum[2] += accels[2];
 
-    // Rotate gravity unit vector to body frame, filter and cross with accels
-    grot[0] = -(2 * (q[1] * q[3] - q[0] * q[2]));
-    grot[1] = -(2 * (q[2] * q[3] + q[0] * q[1]));
-    grot[2] = -(q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]);
+    if (++accels_summed >= ACCEL_DECIMATION) {
+        float accels_mean[3] = { accels_sum[0], accels_sum[1], accels_sum[2] };
+        if (ACCEL_DECIMATION > 1) {
+            accels_mean[0] *= 1.0f / ACCEL_DECIMATION;
+            accels_mean[1] *= 1.0f / ACCEL_DECIMATION;
+            accels_mean[2] *= 1.0f / ACCEL_DECIMATION;
+        }
+        accels_sum[0] = accels_sum[1] = accels_sum[2] = 0;
+        accels_summed = 0;
 
-    apply_accel_filter(grot, grot_filtered);
+        // Apply smoothing to accel values, to reduce vibration noise before main calculations.
+        apply_accel_filter(accels_mean, accels_filtered);
 
-    CrossProduct((const float *)accels_filtered, (const float *)grot_filtered, accel_err);
+        // Rotate gravity unit vector to body frame, filter and cross with accels
+        grot[0] = -(2 * (q[1] * q[3] - q[0] * q[2]));
+        grot[1] = -(2 * (q[2] * q[3] + q[0] * q[1]));
+        grot[2] = -(q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]);
 
-    // Account for accel magnitude
-    float inv_accel_mag = fast_invsqrtf(accels_filtered[0] * accels_filtered[0] + accels_filtered[1] * accels_filtered[1] + accels_filtered[2] * accels_filtered[2]);
-    if (inv_accel_mag > 1e3f) {
-        return;
-    }
+        apply_accel_filter(grot, grot_filtered);
 
-    // Account for filtered gravity vector magnitude
-    float inv_grot_mag;
+        CrossProduct((const float *)accels_filtered, (const float *)grot_filtered, accel_err);
 
-    if (accel_filter_enabled) {
-        inv_grot_mag = fast_invsqrtf(grot_filtered[0] * grot_filtered[0] + grot_filtered[1] * grot_filtered[1] + grot_filtered[2] * grot_filtered[2]);
-    } else {
-        inv_grot_mag = 1.0f;
-    }
+        // Account for accel magnitude
+        float inv_accel_mag = fast_invsqrtf(accels_filtered[0] * accels_filtered[0] + accels_filtered[1] * accels_filtered[1] + accels_filtered[2] * accels_filtered[2]);
+
+        // Account for filtered gravity vector magnitude
+        float inv_grot_mag;
 
-    if (inv_grot_mag > 1e3f) {
-        return;
+        if (accel_filter_enabled) {
+            inv_grot_mag = fast_invsqrtf(grot_filtered[0] * grot_filtered[0] + grot_filtered[1] * grot_filtered[1] + grot_filtered[2] * grot_filtered[2]);
+        } else {
+            inv_grot_mag = 1.0f;
+        }
+
+        if (inv_accel_mag > 1e3f || inv_grot_mag > 1e3f) {
+            // No correction to hold until the next one
+            accel_err[0] = accel_err[1] = accel_err[2] = 0;
+            return;
+        }
+        const float invMag = (inv_accel_mag * inv_grot_mag);
+        accel_err[0] *= invMag;
+        accel_err[1] *= invMag;
+        accel_err[2] *= invMag;
     }
-    const float invMag = (inv_accel_mag * inv_grot_mag);
-    accel_err[0] *= invMag;
-    accel_err[1] *= invMag;
-    accel_err[2] *= invMag;
 
     // Accumulate integral of error.  Scale here so that units are (deg/s) but Ki has units of s
     gyro_correct_int[0] += accel_err[0] * accelKi;
@@ -646,8 +671,10 @@ __attribute__((optimize("O3"))) static void updateAttitude(AccelStateData *accel
 
     // gyro_correct_int[2] += accel_err[2] * accelKi;
 
-    // Correct rates based on error, integral component dealt with in updateSensors
-    const float kpInvdT = accelKp / dT;
+    // Correct rates based on error, integral component dealt with in updateSensors.
+    // The error is held for ACCEL_DECIMATION updates, the gain is bounded for these
+    // not to correct more than the whole error
+    const float kpInvdT = MIN(accelKp, 1.0f / ACCEL_DECIMATION) / dT;
     gyros[0] += accel_err[0] * kpInvdT;
     gyros[1] += accel_err[1] * kpInvdT;
     gyros[2] += accel_err[2] * kpInvdT;
@@ -675,8 +702,9 @@ __attribute__((optimize("O3"))) static void updateAttitude(AccelStateData *accel
         }
     }
 
-    // Renomalize
-    float inv_qmag = fast_invsqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    // Renomalize, the norm stays close to 1 so the first order of 1/sqrt() around 1 is enough
+    float qmag2    = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+    float inv_qmag = fabsf(qmag2 - 1.0f) < QMAG_APPROX_MAX ? 1.5f - 0.5f * qmag2 : fast_invsqrtf(qmag2);
 
     // If quaternion has become inappropriately short or is nan reinit.
     // THIS SHOULD NEVER ACTUALLY HAPPEN
@@ -716,7 +744,8 @@ static void settingsUpdatedCb(__attribute__((unused)) UAVObjEvent *objEv)
     yawBiasRate = attitudeSettings.YawBiasRate;
 
     // Calculate accel filter alpha, in the same way as for gyro data in stabilization module.
-    const float fakeDt = 0.0025f;
+    // It filters one mean of accels per correction step.
+    const float fakeDt = 0.0025f * ACCEL_DECIMATION;
     if (attitudeSettings.AccelTau < 0.0001f) {
         accel_alpha = 0; // not trusting this to resolve to 0
         accel_filter_enabled = false;
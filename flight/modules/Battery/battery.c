@@ -56,7 +56,15 @@
 // Configuration
 //
 #define SAMPLE_PERIOD_MS 500
+// time constants (s) of the low-pass filters on the oversampled readings
+#define VOLTAGE_FILTER_TAU 1.0f
+#define CURRENT_FILTER_TAU 2.0f
+
 // Private types
+struct adc_sum {
+    uint32_t sum;
+    uint32_t count;
+};
 
 // Private variables
 static bool batteryEnabled = false;
@@ -68,8 +76,19 @@ static bool batteryEnabled = false;
 static int8_t voltageADCPin = -1; // ADC pin for voltage
 static int8_t currentADCPin = -1; // ADC pin for current
 
+#ifdef PIOS_ADC_HAS_STREAM
+// sums of the raw samples taken by the ADC DMA since the last timer tick
+static struct adc_sum voltageSum;
+static struct adc_sum currentSum;
+static bool adcStreaming = false;
+#endif
+
 // Private functions
 static void onTimer(UAVObjEvent *ev);
+static bool readADC(int8_t pin, float *volt);
+#ifdef PIOS_ADC_HAS_STREAM
+static void adcStreamCb(const uint16_t *samples, uint16_t num_samples, uint8_t num_pins, void *context, bool *woken);
+#endif
 static int8_t GetNbCells(const FlightBatterySettingsData *batterySettings, FlightBatteryStateData *flightBatteryData);
 
 /**
@@ -117,6 +136,11 @@ int32_t BatteryInitialize(void)
 
         // FlightBatterySettingsConnectCallback(FlightBatterySettingsUpdatedCb);
 
+#ifdef PIOS_ADC_HAS_STREAM
+        // oversample from the DMA buffers, falling back to a single reading per tick
+        adcStreaming = (PIOS_ADC_AddStreamListener(adcStreamCb, NULL) == 0);
+#endif
+
         static UAVObjEvent ev;
 
         memset(&ev, 0, sizeof(UAVObjEvent));
@@ -127,20 +151,82 @@ int32_t BatteryInitialize(void)
 }
 
 MODULE_INITCALL(BatteryInitialize, 0);
+
+#ifdef PIOS_ADC_HAS_STREAM
+/**
+ * Sum the samples of the battery pins of each completed DMA buffer, called from the ADC interrupt
+ */
+static void adcStreamCb(const uint16_t *samples, uint16_t num_samples, uint8_t num_pins, __attribute__((unused)) void *context, __attribute__((unused)) bool *woken)
+{
+    int8_t pins[2] = { voltageADCPin, currentADCPin };
+    struct adc_sum *sums[2] = { &voltageSum, &currentSum };
+
+    for (uint8_t i = 0; i < 2; i++) {
+        if (pins[i] < 0 || pins[i] >= num_pins) {
+            continue;
+        }
+        uint32_t sum = 0;
+        for (uint16_t sample = 0; sample < num_samples; sample++) {
+            sum += samples[sample * num_pins + pins[i]];
+        }
+        sums[i]->sum   += sum;
+        sums[i]->count += num_samples;
+    }
+}
+#endif /* PIOS_ADC_HAS_STREAM */
+
+/**
+ * Read the mean voltage of an ADC pin since the last call
+ * \return true if the reading is the mean of all the samples of the period, false if it is a single reading
+ */
+static bool readADC(int8_t pin, float *volt)
+{
+#ifdef PIOS_ADC_HAS_STREAM
+    if (adcStreaming) {
+        struct adc_sum *adc = (pin == voltageADCPin) ? &voltageSum : &currentSum;
+
+        PIOS_IRQ_Disable();
+        struct adc_sum period = *adc;
+        adc->sum   = 0;
+        adc->count = 0;
+        PIOS_IRQ_Enable();
+
+        if (period.count > 0) {
+            *volt = ((float)period.sum / (float)period.count) * PIOS_ADC_VOLTAGE_SCALE;
+            return true;
+        }
+    }
+#endif
+    *volt = PIOS_ADC_PinGetVolt(pin);
+    return false;
+}
+
 static void onTimer(__attribute__((unused)) UAVObjEvent *ev)
 {
     static FlightBatterySettingsData batterySettings;
     static FlightBatteryStateData flightBatteryData;
+    static bool firstRun = true;
+    static float lastCurrent = 0.0f;
 
     FlightBatterySettingsGet(&batterySettings);
     FlightBatteryStateGet(&flightBatteryData);
 
     const float dT = SAMPLE_PERIOD_MS / 1000.0f;
+    const float voltageAlpha = dT / (dT + VOLTAGE_FILTER_TAU);
+    const float currentAlpha = dT / (dT + CURRENT_FILTER_TAU);
     float energyRemaining;
+    float volt;
 
     // calculate the battery parameters
     if (voltageADCPin >= 0) {
-        flightBatteryData.Voltage = (PIOS_ADC_PinGetVolt(voltageADCPin) - batterySettings.SensorCalibrations.VoltageZero) * batterySettings.SensorCalibrations.VoltageFactor; // in Volts
+        readADC(voltageADCPin, &volt);
+        float voltage = (volt - batterySettings.SensorCalibrations.VoltageZero) * batterySettings.SensorCalibrations.VoltageFactor; // in Volts
+        // filter out the sag of the throttle transients, but follow a battery plugged in at once
+        if (firstRun || flightBatteryData.Voltage <= 0.5f) {
+            flightBatteryData.Voltage = voltage;
+        } else {
+            flightBatteryData.Voltage += voltageAlpha * (voltage - flightBatteryData.Voltage);
+        }
     } else {
         flightBatteryData.Voltage = 0; // Dummy placeholder value. This is in case we get another source of battery current which is not from the ADC
     }
@@ -148,25 +234,39 @@ static void onTimer(__attribute__((unused)) UAVObjEvent *ev)
     // voltage available: get the number of cells if possible, desired and not armed
     GetNbCells(&batterySettings, &flightBatteryData);
 
+    // the integral of the current over the period: exact for the mean of all the samples, trapezoidal across the ticks for a single reading
+    float charge = 0.0f;
+
     // ad a plausibility check: zero voltage => zero current
     if (currentADCPin >= 0 && flightBatteryData.Voltage > 0.f) {
-        flightBatteryData.Current = (PIOS_ADC_PinGetVolt(currentADCPin) - batterySettings.SensorCalibrations.CurrentZero) * batterySettings.SensorCalibrations.CurrentFactor; // in Amps
+        bool oversampled = readADC(currentADCPin, &volt);
+        flightBatteryData.Current = (volt - batterySettings.SensorCalibrations.CurrentZero) * batterySettings.SensorCalibrations.CurrentFactor; // in Amps
         if (flightBatteryData.Current > flightBatteryData.PeakCurrent) {
             flightBatteryData.PeakCurrent = flightBatteryData.Current; // in Amps
         }
+        if (oversampled) {
+            charge = flightBatteryData.Current * dT;
+        } else {
+            charge = 0.5f * (lastCurrent + flightBatteryData.Current) * dT;
+        }
     } else { // If there's no current measurement, we still need to assign one. Make it negative, so it can never trigger an alarm
         flightBatteryData.Current = -0; // Dummy placeholder value. This is in case we get another source of battery current which is not from the ADC
     }
+    lastCurrent = flightBatteryData.Current;
 
     // For safety reasons consider only positive currents in energy comsumption, i.e. no charging up.
     // necesary when sensor are not perfectly calibrated
-    if (flightBatteryData.Current > 0) {
-        flightBatteryData.ConsumedEnergy += (flightBatteryData.Current * dT * 1000.0f / 3600.0f); // in mAh
+    if (charge > 0) {
+        flightBatteryData.ConsumedEnergy += (charge * 1000.0f / 3600.0f); // in mAh
     }
 
-    // Apply a 2 second rise time low-pass filter to average the current
-    float alpha = 1.0f - dT / (dT + 2.0f);
-    flightBatteryData.AvgCurrent = alpha * flightBatteryData.AvgCurrent + (1 - alpha) * flightBatteryData.Current; // in Amps
+    // Low-pass filter the current for the flight time estimation
+    if (firstRun) {
+        flightBatteryData.AvgCurrent = flightBatteryData.Current;
+    } else {
+        flightBatteryData.AvgCurrent += currentAlpha * (flightBatteryData.Current - flightBatteryData.AvgCurrent); // in Amps
+    }
+    firstRun = false;
 
     /*The motor could regenerate power. Or we could have solar cells.
        In short, is there any likelihood of measuring negative current? If it's a bad current reading we want to check, then
@@ -0,0 +1,306 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup BenchmarkModule Benchmark Module
+ * @{
+ *
+ * @file       benchmark.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      On board microbenchmarks of the core operations, triggered and
+ *             reported through @ref BenchmarkResults
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * Input object: BenchmarkResults (Status set to Start by the GCS)
+ * Output object: BenchmarkResults
+ *
+ * When BenchmarkResults.Status is set to Start while disarmed, every
+ * benchmarked operation is timed Samples times with the cycle counter
+ * (PIOS_DELAY_GetRaw(), the DWT counter on the STM32 targets). One sample
+ * is taken per callback run and the runs are spaced so that the events
+ * queued by the object updates are handled in between, the min, mean and
+ * max cycle counts are then sent back in BenchmarkResults.
+ *
+ * The module is enabled by HwSettings.OptionalModules.Benchmark.
+ */
+
+#include <openpilot.h>
+
+#include <callbackinfo.h>
+
+#include "benchmark.h"
+#include "benchmarkresults.h"
+#include "flightstatus.h"
+#include "hwsettings.h"
+
+// Private constants
+#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
+#define CBTASK_PRIORITY   CALLBACK_TASK_AUXILIARY
+
+#define STACK_SIZE_BYTES  512
+#define SAMPLE_PERIOD_MS  2
+#define SAMPLES           32
+// Every sample writes a flash slot, keep the wear low
+#define FLASH_SAMPLES     4
+
+#define NUM_TESTS         BENCHMARKRESULTS_MINCYCLES_NUMELEM
+
+// Private types
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t count;
+} TestStats;
+
+// Private variables
+extern uintptr_t pios_uavo_settings_fs_id;
+
+static bool benchmarkEnabled;
+static DelayedCallbackInfo *benchmarkCBInfo;
+static UAVTalkConnection nullConnection;
+static volatile bool startRequested;
+static bool running;
+static uint8_t currentTest;
+static TestStats stats[NUM_TESTS];
+static BenchmarkResultsData scratch;
+
+// Private functions
+static void benchmarkTask(void);
+static void BenchmarkResultsUpdatedCb(UAVObjEvent *ev);
+static bool runSample(uint8_t test, uint32_t *cycles);
+static uint16_t testSamples(uint8_t test);
+static void finish(void);
+static int32_t nullOutput(uint8_t *data, int32_t length);
+
+/**
+ * Initialise the module, called on startup
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t BenchmarkInitialize(void)
+{
+    HwSettingsInitialize();
+    uint8_t optionalModules[HWSETTINGS_OPTIONALMODULES_NUMELEM];
+    HwSettingsOptionalModulesArrayGet(optionalModules);
+
+    benchmarkEnabled = optionalModules[HWSETTINGS_OPTIONALMODULES_BENCHMARK] == HWSETTINGS_OPTIONALMODULES_ENABLED;
+    if (!benchmarkEnabled) {
+        return -1;
+    }
+
+    BenchmarkResultsInitialize();
+    FlightStatusInitialize();
+
+    // The packed objects are dropped, only the packing is timed
+    nullConnection = UAVTalkInitialize(&nullOutput);
+    if (!nullConnection) {
+        benchmarkEnabled = false;
+        return -1;
+    }
+
+    BenchmarkResultsConnectCallback(&BenchmarkResultsUpdatedCb);
+    return 0;
+}
+
+/**
+ * Create the callback, called after the initialisation of all modules
+ * \returns 0 on success or -1 if the module is disabled
+ */
+int32_t BenchmarkStart(void)
+{
+    if (!benchmarkEnabled) {
+        return -1;
+    }
+
+    benchmarkCBInfo = PIOS_CALLBACKSCHEDULER_Create(&benchmarkTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_BENCHMARK, STACK_SIZE_BYTES);
+    return 0;
+}
+MODULE_INITCALL(BenchmarkInitialize, BenchmarkStart);
+
+/**
+ * Start request from the GCS, the updates made by the module itself
+ * never carry the Start status
+ */
+static void BenchmarkResultsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    uint8_t status;
+
+    BenchmarkResultsStatusGet(&status);
+    if (status == BENCHMARKRESULTS_STATUS_START && !running && benchmarkCBInfo) {
+        startRequested = true;
+        PIOS_CALLBACKSCHEDULER_Dispatch(benchmarkCBInfo);
+    }
+}
+
+/**
+ * Take one sample of the current test, then schedule the next one
+ */
+static void benchmarkTask(void)
+{
+    if (startRequested) {
+        uint8_t armed;
+
+        startRequested = false;
+        FlightStatusArmedGet(&armed);
+        if (armed != FLIGHTSTATUS_ARMED_DISARMED) {
+            BenchmarkResultsData results;
+            BenchmarkResultsGet(&results);
+            results.Status = BENCHMARKRESULTS_STATUS_REFUSED;
+            BenchmarkResultsSet(&results);
+            BenchmarkResultsUpdated();
+            return;
+        }
+
+        memset(stats, 0, sizeof(stats));
+        for (uint8_t t = 0; t < NUM_TESTS; t++) {
+            stats[t].min = UINT32_MAX;
+        }
+        running     = true;
+        currentTest = 0;
+
+        BenchmarkResultsGet(&scratch);
+        scratch.Status = BENCHMARKRESULTS_STATUS_RUNNING;
+        BenchmarkResultsSet(&scratch);
+        BenchmarkResultsUpdated();
+    }
+
+    if (!running) {
+        return;
+    }
+
+    while (currentTest < NUM_TESTS && stats[currentTest].count >= testSamples(currentTest)) {
+        currentTest++;
+    }
+    if (currentTest >= NUM_TESTS) {
+        finish();
+        return;
+    }
+
+    TestStats *test = &stats[currentTest];
+    uint32_t cycles;
+    if (runSample(currentTest, &cycles)) {
+        test->min  = cycles < test->min ? cycles : test->min;
+        test->max  = cycles > test->max ? cycles : test->max;
+        test->sum += cycles;
+        test->count++;
+    } else {
+        // Not available on this board
+        currentTest++;
+    }
+
+    PIOS_CALLBACKSCHEDULER_Schedule(benchmarkCBInfo, SAMPLE_PERIOD_MS, CALLBACK_UPDATEMODE_OVERRIDE);
+}
+
+/**
+ * Time one run of the operation
+ * \returns false if the operation is not available
+ */
+static bool runSample(uint8_t test, uint32_t *cycles)
+{
+    uint32_t start = 0;
+
+    switch (test) {
+    case BENCHMARKRESULTS_MINCYCLES_OBJGETDATA:
+        start = PIOS_DELAY_GetRaw();
+        BenchmarkResultsGet(&scratch);
+        break;
+    case BENCHMARKRESULTS_MINCYCLES_OBJSETDATA:
+        // scratch holds the Running status, the update callback ignores it
+        start = PIOS_DELAY_GetRaw();
+        BenchmarkResultsSet(&scratch);
+        break;
+    case BENCHMARKRESULTS_MINCYCLES_UAVTALKPACK:
+        start = PIOS_DELAY_GetRaw();
+        UAVTalkSendObject(nullConnection, BenchmarkResultsHandle(), 0, 0, 0);
+        break;
+    case BENCHMARKRESULTS_MINCYCLES_FLASHOBJSAVE:
+#if defined(PIOS_INCLUDE_FLASH)
+        if (!pios_uavo_settings_fs_id) {
+            return false;
+        }
+        // BenchmarkResults is not a settings object, the slot is never loaded back
+        start = PIOS_DELAY_GetRaw();
+        PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id, BENCHMARKRESULTS_OBJID, 0, (uint8_t *)&scratch, sizeof(scratch));
+        break;
+#else
+        return false;
+#endif
+    case BENCHMARKRESULTS_MINCYCLES_SPITRANSFER:
+#if defined(PIOS_INCLUDE_MPU6000)
+        // Register read, a bus claim and a two bytes transfer
+        start = PIOS_DELAY_GetRaw();
+        PIOS_MPU6000_ReadID();
+        break;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+
+    *cycles = PIOS_DELAY_GetRaw() - start;
+    return true;
+}
+
+static uint16_t testSamples(uint8_t test)
+{
+    return test == BENCHMARKRESULTS_MINCYCLES_FLASHOBJSAVE ? FLASH_SAMPLES : SAMPLES;
+}
+
+/**
+ * Send the results
+ */
+static void finish(void)
+{
+    BenchmarkResultsData results;
+
+    running = false;
+#if defined(PIOS_INCLUDE_FLASH)
+    if (pios_uavo_settings_fs_id) {
+        PIOS_FLASHFS_ObjDelete(pios_uavo_settings_fs_id, BENCHMARKRESULTS_OBJID, 0);
+    }
+#endif
+
+    memset(&results, 0, sizeof(results));
+    results.Status   = BENCHMARKRESULTS_STATUS_COMPLETED;
+    results.SysClock = PIOS_SYSCLK / 1000000;
+    for (uint8_t t = 0; t < NUM_TESTS; t++) {
+        if (stats[t].count > 0) {
+            BenchmarkResultsMinCyclesToArray(results.MinCycles)[t]   = stats[t].min;
+            BenchmarkResultsMeanCyclesToArray(results.MeanCycles)[t] = stats[t].sum / stats[t].count;
+            BenchmarkResultsMaxCyclesToArray(results.MaxCycles)[t]   = stats[t].max;
+            BenchmarkResultsSamplesToArray(results.Samples)[t]       = stats[t].count;
+        }
+    }
+    BenchmarkResultsSet(&results);
+    BenchmarkResultsUpdated();
+}
+
+static int32_t nullOutput(__attribute__((unused)) uint8_t *data, int32_t length)
+{
+    return length;
+}
+
+/**
+ * @}
+ * @}
+ */
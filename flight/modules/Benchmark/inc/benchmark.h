@@ -1,12 +1,15 @@
 /**
  ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup BenchmarkModule Benchmark Module
+ * @{
+ *
+ * @file       benchmark.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      On board microbenchmarks, results in @ref BenchmarkResults
  *
- * @file       traillineitem.h
- * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a WayPoint
  * @see        The GNU Public License (GPL) Version 3
- * @defgroup   OPMapWidget
- * @{
  *
  *****************************************************************************/
 /*
@@ -24,32 +27,14 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
-#ifndef TAILLINEITEM_H
-#define TAILLINEITEM_H
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
 
-#include <QGraphicsItem>
-#include <QPainter>
-#include <QLabel>
-#include "../internals/pointlatlng.h"
-#include <QObject>
-#include "mapgraphicitem.h"
+int32_t BenchmarkInitialize(void);
 
-namespace mapcontrol {
-class TrailLineItem : public QObject, public QGraphicsLineItem {
-    Q_OBJECT Q_INTERFACES(QGraphicsItem)
-public:
-    enum { Type = UserType + 7 };
-    TrailLineItem(internals::PointLatLng const & coord1, internals::PointLatLng const & coord2, QBrush color, MapGraphicItem *map);
-    int type() const;
-    internals::PointLatLng coord1;
-    internals::PointLatLng coord2;
-private:
-    QBrush m_brush;
-    MapGraphicItem *m_map;
-public slots:
-    void setLineSlot();
-signals:
-};
-}
+#endif // BENCHMARK_H
 
-#endif // TAILLINEITEM_H
+/**
+ * @}
+ * @}
+ */
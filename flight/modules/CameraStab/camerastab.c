@@ -49,6 +49,7 @@
 
 #include "accessorydesired.h"
 #include "attitudestate.h"
+#include "gyrostate.h"
 #include "camerastabsettings.h"
 #include "cameradesired.h"
 #include "hwsettings.h"
@@ -57,12 +58,14 @@
 // Configuration
 //
 #define SAMPLE_PERIOD_MS 10
+#define MAX_DT_MS        100.0f
 
 // Private types
 
 // Private variables
 static struct CameraStab_data {
-    portTickType lastSysTime;
+    uint32_t lastSysTime;
+    CameraStabSettingsData settings;
     float inputs[CAMERASTABSETTINGS_INPUT_NUMELEM];
 
 #ifdef USE_GIMBAL_LPF
@@ -78,6 +81,9 @@ static struct CameraStab_data {
 
 // Private functions
 static void attitudeUpdated(UAVObjEvent *ev);
+static void gyroUpdated(UAVObjEvent *ev);
+static void settingsUpdated(UAVObjEvent *ev);
+static void eulerRates(const AttitudeStateData *attitude, float rates[CAMERASTABSETTINGS_INPUT_NUMELEM]);
 
 #ifdef USE_GIMBAL_FF
 static void applyFeedForward(uint8_t index, float dT, float *attitude, CameraStabSettingsData *cameraStab);
@@ -116,12 +122,19 @@ int32_t CameraStabInitialize(void)
 
         // initialize camera state variables
         memset(csd, 0, sizeof(struct CameraStab_data));
-        csd->lastSysTime = xTaskGetTickCount();
+        csd->lastSysTime = PIOS_DELAY_GetRaw();
 
         AttitudeStateInitialize();
+        GyroStateInitialize();
         CameraStabSettingsInitialize();
         CameraDesiredInitialize();
 
+        CameraStabSettingsConnectCallback(settingsUpdated);
+        settingsUpdated(NULL);
+
+        // dispatch from the context of the GyroState setter to follow the gyro rate when selected
+        GyroStateConnectFastCallback(gyroUpdated);
+
         UAVObjEvent ev = {
             .obj    = AttitudeStateHandle(),
             .instId = 0,
@@ -144,23 +157,66 @@ int32_t CameraStabStart(void)
 
 MODULE_INITCALL(CameraStabInitialize, CameraStabStart);
 
+static void settingsUpdated(__attribute__((unused)) UAVObjEvent *ev)
+{
+    CameraStabSettingsGet(&csd->settings);
+}
+
+static void gyroUpdated(UAVObjEvent *ev)
+{
+    if (csd->settings.UpdateSource == CAMERASTABSETTINGS_UPDATESOURCE_GYROSTATE) {
+        EventCallbackDispatch(ev, attitudeUpdated);
+    }
+}
+
+/**
+ * Convert the body rates of GyroState into the rates of the roll, pitch and yaw angles
+ */
+static void eulerRates(const AttitudeStateData *attitude, float rates[CAMERASTABSETTINGS_INPUT_NUMELEM])
+{
+    GyroStateData gyro;
+
+    GyroStateGet(&gyro);
+
+    float sinRoll  = sinf(DEG2RAD(attitude->Roll));
+    float cosRoll  = cosf(DEG2RAD(attitude->Roll));
+    // the yaw rate is undefined at +-90 degrees of pitch, keep it bounded near there
+    float cosPitch = boundf(cosf(DEG2RAD(attitude->Pitch)), 0.1f, 1.0f);
+    float tanPitch = sinf(DEG2RAD(attitude->Pitch)) / cosPitch;
+    float qr = gyro.y * sinRoll + gyro.z * cosRoll;
+
+    rates[CAMERASTABSETTINGS_INPUT_ROLL]  = gyro.x + qr * tanPitch;
+    rates[CAMERASTABSETTINGS_INPUT_PITCH] = gyro.y * cosRoll - gyro.z * sinRoll;
+    rates[CAMERASTABSETTINGS_INPUT_YAW]   = qr / cosPitch;
+}
+
 static void attitudeUpdated(UAVObjEvent *ev)
 {
-    if (ev->obj != AttitudeStateHandle()) {
+    // the periodic event carries AttitudeState, the gyro synchronous one GyroState
+    bool gyroSync = (csd->settings.UpdateSource == CAMERASTABSETTINGS_UPDATESOURCE_GYROSTATE);
+
+    if (ev->obj != (gyroSync ? GyroStateHandle() : AttitudeStateHandle())) {
         return;
     }
 
     AccessoryDesiredData accessory;
+    AttitudeStateData attitudeState;
+    CameraStabSettingsData cameraStab = csd->settings;
 
-    CameraStabSettingsData cameraStab;
-    CameraStabSettingsGet(&cameraStab);
+    AttitudeStateGet(&attitudeState);
 
     // check how long since last update, time delta between calls in ms
-    portTickType thisSysTime = xTaskGetTickCount();
-    float dT_millis = (thisSysTime > csd->lastSysTime) ?
-                      (float)((thisSysTime - csd->lastSysTime) * portTICK_RATE_MS) :
-                      (float)SAMPLE_PERIOD_MS;
-    csd->lastSysTime = thisSysTime;
+    float dT_millis = (float)PIOS_DELAY_DiffuS(csd->lastSysTime) * 0.001f;
+    csd->lastSysTime = PIOS_DELAY_GetRaw();
+    if (dT_millis <= 0.0f || dT_millis > MAX_DT_MS) {
+        dT_millis = (float)SAMPLE_PERIOD_MS;
+    }
+
+    bool brushless = (cameraStab.GimbalType == CAMERASTABSETTINGS_GIMBALTYPE_BRUSHLESS);
+    float rates[CAMERASTABSETTINGS_INPUT_NUMELEM] = { 0 };
+    if (!brushless) {
+        eulerRates(&attitudeState, rates);
+    }
 
     // storage for elevon roll component before the pitch component has been generated
     // we are guaranteed that the iteration order of i is roll pitch yaw
@@ -195,23 +251,45 @@ static void attitudeUpdated(UAVObjEvent *ev)
             }
         }
 
+        // the brushless gimbal controller stabilizes itself and only takes the camera commands
+        if (brushless) {
+            float output = boundf(csd->inputs[i] / CameraStabSettingsOutputRangeToArray(cameraStab.OutputRange)[i], -1.0f, 1.0f);
+            switch (i) {
+            case CAMERASTABSETTINGS_INPUT_ROLL:
+                CameraDesiredRollOrServo1Set(&output);
+                break;
+            case CAMERASTABSETTINGS_INPUT_PITCH:
+                CameraDesiredPitchOrServo2Set(&output);
+                break;
+            case CAMERASTABSETTINGS_INPUT_YAW:
+                CameraDesiredYawSet(&output);
+                break;
+            default:
+                PIOS_Assert(0);
+            }
+            continue;
+        }
+
         // calculate servo output
         float attitude;
 
         switch (i) {
         case CAMERASTABSETTINGS_INPUT_ROLL:
-            AttitudeStateRollGet(&attitude);
+            attitude = attitudeState.Roll;
             break;
         case CAMERASTABSETTINGS_INPUT_PITCH:
-            AttitudeStatePitchGet(&attitude);
+            attitude = attitudeState.Pitch;
             break;
         case CAMERASTABSETTINGS_INPUT_YAW:
-            AttitudeStateYawGet(&attitude);
+            attitude = attitudeState.Yaw;
             break;
         default:
             PIOS_Assert(0);
         }
 
+        // lead the servos by the attitude rate to compensate their lag
+        attitude += rates[i] * (float)CameraStabSettingsRateFeedForwardToArray(cameraStab.RateFeedForward)[i] * 0.001f;
+
 #ifdef USE_GIMBAL_LPF
         if (CameraStabSettingsResponseTimeToArray(cameraStab.ResponseTime)[i]) {
             float rt = (float)CameraStabSettingsResponseTimeToArray(cameraStab.ResponseTime)[i];
@@ -290,6 +368,7 @@ void applyFeedForward(uint8_t index, float dT_millis, float *attitude, CameraSta
     switch (cameraStab->GimbalType) {
     case CAMERASTABSETTINGS_GIMBALTYPE_GENERIC:
     case CAMERASTABSETTINGS_GIMBALTYPE_ROLLPITCHMIXED:
+    case CAMERASTABSETTINGS_GIMBALTYPE_BRUSHLESS:
         // no correction
         break;
     case CAMERASTABSETTINGS_GIMBALTYPE_YAWROLLPITCH:
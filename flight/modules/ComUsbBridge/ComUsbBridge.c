@@ -43,6 +43,8 @@
 static void com2UsbBridgeTask(void *parameters);
 static void usb2ComBridgeTask(void *parameters);
 static void updateSettings(UAVObjEvent *ev);
+static void bridge(uint32_t rx_port, uint32_t tx_port, volatile uint32_t *tx_errors);
+static void hostBaudRateChanged(uint32_t context, uint32_t baud);
 
 // ****************
 // Private constants
@@ -52,7 +54,14 @@ static void updateSettings(UAVObjEvent *ev);
 
 #define TASK_PRIORITY        (tskIDLE_PRIORITY + 1)
 
-#define BRIDGE_BUF_LEN       10
+// bytes moved at once, at most the tx buffer of the ports
+#ifdef PIOS_COMUSBBRIDGE_CHUNK_LEN
+#define BRIDGE_CHUNK_LEN     PIOS_COMUSBBRIDGE_CHUNK_LEN
+#else
+#define BRIDGE_CHUNK_LEN     10
+#endif
+
+#define BRIDGE_HOST_BAUD     57600 // until the host sets its line coding
 
 // ****************
 // Private variables
@@ -60,14 +69,15 @@ static void updateSettings(UAVObjEvent *ev);
 static xTaskHandle com2UsbBridgeTaskHandle;
 static xTaskHandle usb2ComBridgeTaskHandle;
 
-static uint8_t *com2usb_buf;
-static uint8_t *usb2com_buf;
-
 static uint32_t usart_port;
 static uint32_t vcp_port;
 
 static bool bridge_enabled = false;
 
+// follow the line coding of the host on the usart
+static volatile bool follow_host = false;
+static volatile uint32_t host_baud = BRIDGE_HOST_BAUD;
+
 /**
  * Initialise the module
  * \return -1 if initialisation failed
@@ -114,10 +124,8 @@ static int32_t comUsbBridgeInitialize(void)
 #endif
 
     if (bridge_enabled) {
-        com2usb_buf = pios_malloc(BRIDGE_BUF_LEN);
-        PIOS_Assert(com2usb_buf);
-        usb2com_buf = pios_malloc(BRIDGE_BUF_LEN);
-        PIOS_Assert(usb2com_buf);
+        // fails when the vcp does not report the line coding, the speed setting applies then
+        PIOS_COM_RegisterBaudRateCallback(vcp_port, hostBaudRateChanged, 0);
         HwSettingsConnectCallback(&updateSettings);
         updateSettings(0);
     }
@@ -126,6 +134,30 @@ static int32_t comUsbBridgeInitialize(void)
 }
 MODULE_INITCALL(comUsbBridgeInitialize, comUsbBridgeStart);
 
+/**
+ * Move the bytes received on rx_port to tx_port. They are received straight into the
+ * space reserved in the tx buffer, without going through an intermediate buffer.
+ */
+static void bridge(uint32_t rx_port, uint32_t tx_port, volatile uint32_t *tx_errors)
+{
+    struct pios_com_iovec regions[2];
+
+    if (PIOS_COM_TxReserve(tx_port, BRIDGE_CHUNK_LEN, regions) != 0) {
+        /* Error on transmit */
+        (*tx_errors)++;
+        vTaskDelay(1);
+        return;
+    }
+
+    uint16_t rx_bytes = PIOS_COM_ReceiveBuffer(rx_port, regions[0].data, regions[0].len, 500);
+    if (rx_bytes == regions[0].len && regions[1].len) {
+        /* The reserved space wraps around the end of the tx buffer */
+        rx_bytes += PIOS_COM_ReceiveBuffer(rx_port, regions[1].data, regions[1].len, 0);
+    }
+
+    PIOS_COM_TxCommit(tx_port, rx_bytes);
+}
+
 /**
  * Main task. It does not return.
  */
@@ -136,16 +168,7 @@ static void com2UsbBridgeTask(__attribute__((unused)) void *parameters)
     volatile uint32_t tx_errors = 0;
 
     while (1) {
-        uint32_t rx_bytes;
-
-        rx_bytes = PIOS_COM_ReceiveBuffer(usart_port, com2usb_buf, BRIDGE_BUF_LEN, 500);
-        if (rx_bytes > 0) {
-            /* Bytes available to transfer */
-            if (PIOS_COM_SendBuffer(vcp_port, com2usb_buf, rx_bytes) != (int32_t)rx_bytes) {
-                /* Error on transmit */
-                tx_errors++;
-            }
-        }
+        bridge(usart_port, vcp_port, &tx_errors);
     }
 }
 
@@ -155,19 +178,20 @@ static void usb2ComBridgeTask(__attribute__((unused)) void *parameters)
     volatile uint32_t tx_errors = 0;
 
     while (1) {
-        uint32_t rx_bytes;
-
-        rx_bytes = PIOS_COM_ReceiveBuffer(vcp_port, usb2com_buf, BRIDGE_BUF_LEN, 500);
-        if (rx_bytes > 0) {
-            /* Bytes available to transfer */
-            if (PIOS_COM_SendBuffer(usart_port, usb2com_buf, rx_bytes) != (int32_t)rx_bytes) {
-                /* Error on transmit */
-                tx_errors++;
-            }
-        }
+        bridge(vcp_port, usart_port, &tx_errors);
     }
 }
 
+/**
+ * Called by the vcp, possibly from the USB interrupt, when the host sets its line coding
+ */
+static void hostBaudRateChanged(__attribute__((unused)) uint32_t context, uint32_t baud)
+{
+    host_baud = baud;
+    if (follow_host && usart_port) {
+        PIOS_COM_ChangeBaud(usart_port, baud);
+    }
+}
 
 static void updateSettings(__attribute__((unused)) UAVObjEvent *ev)
 {
@@ -199,6 +223,19 @@ static void updateSettings(__attribute__((unused)) UAVObjEvent *ev)
         case HWSETTINGS_COMUSBBRIDGESPEED_115200:
             PIOS_COM_ChangeBaud(usart_port, 115200);
             break;
+        case HWSETTINGS_COMUSBBRIDGESPEED_230400:
+            PIOS_COM_ChangeBaud(usart_port, 230400);
+            break;
+        case HWSETTINGS_COMUSBBRIDGESPEED_460800:
+            PIOS_COM_ChangeBaud(usart_port, 460800);
+            break;
+        case HWSETTINGS_COMUSBBRIDGESPEED_921600:
+            PIOS_COM_ChangeBaud(usart_port, 921600);
+            break;
+        case HWSETTINGS_COMUSBBRIDGESPEED_HOST:
+            PIOS_COM_ChangeBaud(usart_port, host_baud);
+            break;
         }
+        follow_host = (speed == HWSETTINGS_COMUSBBRIDGESPEED_HOST);
     }
 }
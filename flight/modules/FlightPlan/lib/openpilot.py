@@ -29,6 +29,20 @@
 #include "openpilot.h"
 #include "flightplanstatus.h"
 #include "flightplancontrol.h"
+
+// Collect the garbage in the idle time of the delays once the heap is getting
+// full, so the collection rarely has to run when an allocation fails in the
+// middle of the script. The pause is bounded by the size of the script heap.
+#define GC_IDLE_THRESHOLD (PM_HEAP_SIZE / 4)
+
+static PmReturn_t collectWhileIdle(void)
+{
+#ifdef HAVE_GC
+	if (heap_getAvail() < GC_IDLE_THRESHOLD)
+		return heap_gcRun();
+#endif
+	return PM_RET_OK;
+}
 """
 
 # Delay (suspend VM thread) for timeToDelayMs ms
@@ -37,6 +51,7 @@ def delay(timeToDelayMs):
 	pPmObj_t pobj;
 	PmReturn_t retval;
 	portTickType timeToDelayTicks;
+	portTickType startTicks = xTaskGetTickCount();
 
 	// Check number of arguments
   if (NATIVE_GET_NUM_ARGS() != 1)
@@ -57,6 +72,12 @@ def delay(timeToDelayMs):
 		return retval;
 	}
 	 
+	// Collect, the time spent is taken from the delay
+	retval = collectWhileIdle();
+	PM_RETURN_IF_ERROR(retval);
+	startTicks = xTaskGetTickCount() - startTicks;
+	timeToDelayTicks = (startTicks < timeToDelayTicks) ? timeToDelayTicks - startTicks : 0;
+
 	// Delay
 	vTaskDelay(timeToDelayTicks);
  
@@ -110,6 +131,10 @@ def delayUntil(lastWakeTimeMs, timeToDelayMs):
 		return retval;
 	}
 	 
+	// Collect, vTaskDelayUntil() takes the time spent from the delay
+	retval = collectWhileIdle();
+	PM_RETURN_IF_ERROR(retval);
+
 	// Delay
 	vTaskDelayUntil(&lastWakeTimeTicks, timeToDelayTicks);
 
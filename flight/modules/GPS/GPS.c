@@ -52,6 +52,7 @@
 #include "inc/ubx_autoconfig.h"
 #endif
 
+#define PIOS_INSTRUMENT_MODULE
 #include <pios_instrumentation_helper.h>
 PERF_DEFINE_COUNTER(counterBytesIn);
 PERF_DEFINE_COUNTER(counterRate);
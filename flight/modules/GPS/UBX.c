@@ -33,6 +33,8 @@
 #include "pios_math.h"
 #include <pios_helpers.h>
 #include <pios_delay.h>
+#define PIOS_INSTRUMENT_MODULE
+#include <pios_instrumentation_helper.h>
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 #include "inc/UBX.h"
 #include "inc/GPS.h"
@@ -48,6 +50,8 @@ static GPSPositionSensorSensorTypeOptions sensorType = GPSPOSITIONSENSOR_SENSORT
 static bool usePvt = false;
 static uint32_t lastPvtTime = 0;
 
+PERF_DEFINE_COUNTER(counterUbxMessage);
+
 
 // parse table item
 typedef struct {
@@ -69,6 +73,7 @@ static void parse_ubx_nav_svinfo(struct UBXPacket *ubx, GPSPositionSensorData *G
 
 static void parse_ubx_op_sys(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
 static void parse_ubx_op_mag(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_op_pvt(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
 
 static void parse_ubx_ack_ack(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
 static void parse_ubx_ack_nak(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
@@ -77,12 +82,17 @@ static void parse_ubx_mon_ver(struct UBXPacket *ubx, GPSPositionSensorData *GpsP
 #endif
 
 const ubx_message_handler ubx_handler_table[] = {
+#ifndef PIOS_GPS_MINIMAL
+    // NAV-PVT alone makes up a complete epoch when the receiver sends it
+    { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_PVT,     .handler = &parse_ubx_nav_pvt     },
+    // so does the compact NAV-PVT the GPSV9 module parses
+    { .msgClass = UBX_CLASS_OP_CUST, .msgID = UBX_ID_OP_PVT,      .handler = &parse_ubx_op_pvt      },
+#endif
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_POSLLH,  .handler = &parse_ubx_nav_posllh  },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_VELNED,  .handler = &parse_ubx_nav_velned  },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_SOL,     .handler = &parse_ubx_nav_sol     },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_DOP,     .handler = &parse_ubx_nav_dop     },
 #ifndef PIOS_GPS_MINIMAL
-    { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_PVT,     .handler = &parse_ubx_nav_pvt     },
     { .msgClass = UBX_CLASS_OP_CUST, .msgID = UBX_ID_OP_MAG,      .handler = &parse_ubx_op_mag      },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_SVINFO,  .handler = &parse_ubx_nav_svinfo  },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_TIMEUTC, .handler = &parse_ubx_nav_timeutc },
@@ -120,12 +130,14 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
         UBX_PAYLOAD,
         UBX_CHK1,
         UBX_CHK2,
-        FINISHED
+        UBX_SKIP,
+        FINISHED,
+        SKIPPED
     };
     uint8_t c;
     static enum proto_states proto_state = START;
-    static uint8_t rx_count = 0;
-    struct UBXPacket *ubx   = (struct UBXPacket *)gps_rx_buffer;
+    static uint16_t rx_count = 0;
+    struct UBXPacket *ubx    = (struct UBXPacket *)gps_rx_buffer;
 
     for (int i = 0; i < len; i++) {
         c = rx[i];
@@ -133,6 +145,10 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
         case START: // detect protocol
             if (c == UBX_SYNC1) { // first UBX sync char found
                 proto_state = UBX_SY2;
+            } else {
+                // discard everything up to the next sync char at once
+                const uint8_t *sync = memchr(&rx[i + 1], UBX_SYNC1, len - i - 1);
+                i = sync ? (sync - rx) - 1 : len - 1;
             }
             break;
         case UBX_SY2:
@@ -156,25 +172,34 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
             break;
         case UBX_LEN2:
             ubx->header.len += (c << 8);
+            rx_count = 0;
             if (ubx->header.len > sizeof(UBXPayload)) {
                 gpsRxStats->gpsRxOverflow++;
                 proto_state = START;
+            } else if (usePvt && ubx->header.class == UBX_CLASS_NAV &&
+                       (ubx->header.id == UBX_ID_NAV_POSLLH || ubx->header.id == UBX_ID_NAV_VELNED ||
+                        ubx->header.id == UBX_ID_NAV_SOL || ubx->header.id == UBX_ID_NAV_TIMEUTC)) {
+                // NAV-PVT supersedes these, skip them without copy nor checksum
+                proto_state = UBX_SKIP;
             } else {
-                rx_count    = 0;
-                proto_state = UBX_PAYLOAD;
+                proto_state = ubx->header.len ? UBX_PAYLOAD : UBX_CHK1;
             }
             break;
         case UBX_PAYLOAD:
-            if (rx_count < ubx->header.len) {
-                ubx->payload.payload[rx_count] = c;
-                if (++rx_count == ubx->header.len) {
-                    proto_state = UBX_CHK1;
-                }
-            } else {
-                gpsRxStats->gpsRxOverflow++;
-                proto_state = START;
+        {
+            // copy as much of the payload as this chunk holds
+            uint16_t count = ubx->header.len - rx_count;
+            if (count > len - i) {
+                count = len - i;
             }
-            break;
+            memcpy(&ubx->payload.payload[rx_count], &rx[i], count);
+            rx_count += count;
+            i += count - 1;
+            if (rx_count == ubx->header.len) {
+                proto_state = UBX_CHK1;
+            }
+        }
+        break;
         case UBX_CHK1:
             ubx->header.ck_a = c;
             proto_state = UBX_CHK2;
@@ -189,6 +214,20 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
                 proto_state = START;
             }
             break;
+        case UBX_SKIP:
+        {
+            // payload and checksum
+            uint16_t count = ubx->header.len + 2 - rx_count;
+            if (count > len - i) {
+                count = len - i;
+            }
+            rx_count += count;
+            i += count - 1;
+            if (rx_count == ubx->header.len + 2) {
+                proto_state = SKIPPED;
+            }
+        }
+        break;
         default: break;
         }
 
@@ -198,6 +237,8 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
             gpsRxStats->gpsRxReceived++;
             proto_state = START;
             ret = PARSER_COMPLETE; // message complete & processed
+        } else if (proto_state == SKIPPED) {
+            proto_state = START;
         }
     }
     return ret;
@@ -481,6 +522,54 @@ static void parse_ubx_op_mag(struct UBXPacket *ubx, __attribute__((unused)) GPSP
     float mags[3] = { mag->x, mag->y, mag->z };
     auxmagsupport_publish_samples(mags, AUXMAGSENSOR_STATUS_OK);
 }
+
+static void parse_ubx_op_pvt(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+{
+    lastPvtTime = PIOS_DELAY_GetuS();
+
+    GPSVelocitySensorData GpsVelocity;
+    struct UBX_OP_PVT *pvt = &ubx->payload.op_pvt;
+    check_msgtracker(pvt->iTOW, (ALL_RECEIVED));
+
+    GpsVelocity.North = (float)pvt->velN * 0.01f;
+    GpsVelocity.East  = (float)pvt->velE * 0.01f;
+    GpsVelocity.Down  = (float)pvt->velD * 0.01f;
+    GPSVelocitySensorSet(&GpsVelocity);
+
+    GpsPosition->Groundspeed     = (float)pvt->gSpeed * 0.01f;
+    GpsPosition->Heading         = (float)pvt->heading * 0.01f;
+    GpsPosition->Altitude        = (float)pvt->hMSL * 0.001f;
+    GpsPosition->GeoidSeparation = (float)pvt->geoidSeparation * 0.01f;
+    GpsPosition->Latitude        = pvt->lat;
+    GpsPosition->Longitude       = pvt->lon;
+    GpsPosition->Satellites      = pvt->numSV;
+    GpsPosition->PDOP = pvt->pDOP * 0.01f;
+    if (pvt->flags & OP_PVT_FLAGS_GNSSFIX_OK) {
+        GpsPosition->Status = (pvt->flags & OP_PVT_FLAGS_FIXTYPE) == PVT_FIX_TYPE_3D ?
+                              GPSPOSITIONSENSOR_STATUS_FIX3D : GPSPOSITIONSENSOR_STATUS_FIX2D;
+    } else {
+        GpsPosition->Status = GPSPOSITIONSENSOR_STATUS_NOFIX;
+    }
+
+    if (pvt->flags & OP_PVT_FLAGS_VALIDTIME) {
+        GPSTimeData GpsTime;
+
+        GpsTime.Year   = pvt->year;
+        GpsTime.Month  = pvt->month;
+        GpsTime.Day    = pvt->day;
+        GpsTime.Hour   = pvt->hour;
+        GpsTime.Minute = pvt->min;
+        GpsTime.Second = pvt->sec;
+
+        GPSTimeSet(&GpsTime);
+    }
+
+    // the module sends the mag sample in this frame instead of a mag packet
+    if (useMag && (pvt->flags & OP_PVT_FLAGS_MAG)) {
+        float mags[3] = { pvt->magX, pvt->magY, pvt->magZ };
+        auxmagsupport_publish_samples(mags, AUXMAGSENSOR_STATUS_OK);
+    }
+}
 #endif /* if !defined(PIOS_GPS_MINIMAL) */
 
 
@@ -498,7 +587,9 @@ uint32_t parse_ubx_message(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosi
         GpsPosition->PDOP = 99.99f;
         GpsPosition->VDOP = 99.99f;
         ubxInitialized    = true;
+        PERF_INIT_COUNTER(counterUbxMessage, 0x97510004);
     }
+    PERF_TIMED_SECTION_START(counterUbxMessage);
     // is it using PVT?
     usePvt = (lastPvtTime) && (PIOS_DELAY_GetuSSince(lastPvtTime) < UBX_PVT_TIMEOUT * 1000);
     for (uint8_t i = 0; i < UBX_HANDLER_TABLE_SIZE; i++) {
@@ -524,6 +615,7 @@ uint32_t parse_ubx_message(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosi
             GPSPositionSensorStatusSet(&status);
         }
     }
+    PERF_TIMED_SECTION_END(counterUbxMessage);
     return id;
 }
 
@@ -82,6 +82,7 @@ typedef enum {
 typedef enum {
     UBX_ID_OP_SYS = 0x01,
     UBX_ID_OP_MAG = 0x02,
+    UBX_ID_OP_PVT = 0x03,
 } ubx_class_op_id;
 
 typedef enum {
@@ -361,6 +362,38 @@ struct UBX_OP_MAG {
     uint16_t Status;
 };
 
+// NAV-PVT parsed by the GPSV9 module, with the mag sample taken at the same time
+#define OP_PVT_FLAGS_FIXTYPE    0x07
+#define OP_PVT_FLAGS_GNSSFIX_OK 0x08
+#define OP_PVT_FLAGS_VALIDTIME  0x10
+#define OP_PVT_FLAGS_MAG        0x20
+
+struct UBX_OP_PVT {
+    uint32_t iTOW;
+    int32_t  lon;
+    int32_t  lat;
+    int32_t  hMSL; // mm
+    int16_t  geoidSeparation; // cm
+    int16_t  velN; // cm/s
+    int16_t  velE;
+    int16_t  velD;
+    uint16_t gSpeed; // cm/s
+    uint16_t heading; // deg * 100
+    uint16_t pDOP; // * 100
+    uint16_t year;
+    uint8_t  month;
+    uint8_t  day;
+    uint8_t  hour;
+    uint8_t  min;
+    uint8_t  sec;
+    uint8_t  numSV;
+    uint8_t  flags;
+    uint8_t  magAge; // ms
+    int16_t  magX;
+    int16_t  magY;
+    int16_t  magZ;
+} __attribute__((packed));
+
 typedef union {
     uint8_t payload[0];
     // Nav Class
@@ -380,6 +413,7 @@ typedef union {
     struct UBX_MON_VER     mon_ver;
     struct UBX_OP_SYSINFO  op_sysinfo;
     struct UBX_OP_MAG op_mag;
+    struct UBX_OP_PVT op_pvt;
 #endif
 } UBXPayload;
 
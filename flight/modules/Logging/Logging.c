@@ -36,6 +36,21 @@
 #include "debuglogstatus.h"
 #include "debuglogentry.h"
 #include "flightstatus.h"
+#include "taskinfo.h"
+
+// private defines
+#define RETRIEVE_WINDOW_MAX 8 // DebugLogEntry instances used to send a window of entries
+#if defined(PIOS_INCLUDE_TRACE)
+#define TRACE_RECORDS_PER_ENTRY (sizeof(((DebugLogEntryData *)0)->Data) / sizeof(struct pios_trace_record))
+#define TRACE_TICKS_PER_US      (PIOS_SYSCLK / 1000000)
+#define TRACE_DUMP_RETRY_MS     20
+#define TRACE_DUMP_STACK_SIZE   256
+#if defined(PIOS_INCLUDE_TASK_MONITOR)
+#define TRACE_TASK_COUNT        TASKINFO_RUNNINGTIME_NUMELEM
+#else
+#define TRACE_TASK_COUNT        0
+#endif
+#endif
 
 // private variables
 static DebugLogSettingsData settings;
@@ -43,12 +58,23 @@ static DebugLogControlData control;
 static DebugLogStatusData status;
 static FlightStatusData flightstatus;
 static DebugLogEntryData *entry; // would be better on stack but event dispatcher stack might be insufficient
+#if defined(PIOS_INCLUDE_TRACE)
+static DelayedCallbackInfo *traceDumpCallback;
+static bool traceDumping;
+static uint32_t traceDumpPosition; // task names first, then the trace records
+static struct pios_trace_record traceRecords[TRACE_RECORDS_PER_ENTRY];
+#endif
 
 // private functions
 static void SettingsUpdatedCb(UAVObjEvent *ev);
 static void ControlUpdatedCb(UAVObjEvent *ev);
 static void StatusUpdatedCb(UAVObjEvent *ev);
 static void FlightStatusUpdatedCb(UAVObjEvent *ev);
+static void RetrieveEntry(uint16_t flight, uint16_t entryNum);
+static void RetrieveWindow(uint16_t flight, uint16_t first, uint8_t count);
+#if defined(PIOS_INCLUDE_TRACE)
+static void DumpTrace(void);
+#endif
 
 int32_t LoggingInitialize(void)
 {
@@ -62,6 +88,12 @@ int32_t LoggingInitialize(void)
     if (!entry) {
         return -1;
     }
+#if defined(PIOS_INCLUDE_TRACE)
+    traceDumpCallback = PIOS_CALLBACKSCHEDULER_Create(&DumpTrace, CALLBACK_PRIORITY_LOW, CALLBACK_TASK_AUXILIARY, -1, TRACE_DUMP_STACK_SIZE);
+    if (!traceDumpCallback) {
+        return -1;
+    }
+#endif
 
     return 0;
 }
@@ -90,6 +122,7 @@ MODULE_INITCALL(LoggingInitialize, LoggingStart);
 static void StatusUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     PIOS_DEBUGLOG_Info(&status.Flight, &status.Entry, &status.FreeSlots, &status.UsedSlots);
+    status.DroppedEntries = PIOS_DEBUGLOG_DroppedEntries();
     DebugLogStatusSet(&status);
 }
 
@@ -119,30 +152,118 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     } else {
         FlightStatusUpdatedCb(NULL);
     }
+#if defined(PIOS_INCLUDE_TRACE)
+    if (!traceDumping) {
+        PIOS_TRACE_Enable(settings.Trace == DEBUGLOGSETTINGS_TRACE_ENABLED);
+    }
+#endif
 }
 
 static void ControlUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     DebugLogControlGet(&control);
     if (control.Operation == DEBUGLOGCONTROL_OPERATION_RETRIEVE) {
-        memset(entry, 0, sizeof(DebugLogEntryData));
-        if (PIOS_DEBUGLOG_Read(entry, control.Flight, control.Entry) != 0) {
-            // reading from log failed, mark as non existent in output
-            entry->Flight = control.Flight;
-            entry->Entry  = control.Entry;
-            entry->Type   = DEBUGLOGENTRY_TYPE_EMPTY;
-        }
+        RetrieveEntry(control.Flight, control.Entry);
         DebugLogEntrySet(entry);
+    } else if (control.Operation == DEBUGLOGCONTROL_OPERATION_RETRIEVEWINDOW) {
+        RetrieveWindow(control.Flight, control.Entry, control.Count);
     } else if (control.Operation == DEBUGLOGCONTROL_OPERATION_FORMATFLASH) {
         uint8_t armed;
         FlightStatusArmedGet(&armed);
         if (armed == FLIGHTSTATUS_ARMED_DISARMED) {
             PIOS_DEBUGLOG_Format();
         }
+#if defined(PIOS_INCLUDE_TRACE)
+    } else if (control.Operation == DEBUGLOGCONTROL_OPERATION_DUMPTRACE) {
+        if (!traceDumping) {
+            // freeze the ring until it has been written
+            traceDumping = true;
+            PIOS_TRACE_Enable(false);
+            traceDumpPosition = 0;
+            PIOS_CALLBACKSCHEDULER_Dispatch(traceDumpCallback);
+        }
+#endif
     }
     StatusUpdatedCb(ev);
 }
 
+static void RetrieveEntry(uint16_t flight, uint16_t entryNum)
+{
+    memset(entry, 0, sizeof(DebugLogEntryData));
+    if (PIOS_DEBUGLOG_Read(entry, flight, entryNum) != 0) {
+        // reading from log failed, mark as non existent in output
+        entry->Flight = flight;
+        entry->Entry  = entryNum;
+        entry->Type   = DEBUGLOGENTRY_TYPE_EMPTY;
+    }
+}
+
+static void RetrieveWindow(uint16_t flight, uint16_t first, uint8_t count)
+{
+    count = MIN(count, RETRIEVE_WINDOW_MAX);
+
+    // every entry gets its own instance so none is overwritten before telemetry has sent it
+    uint16_t instances = UAVObjGetNumInstances(DebugLogEntryHandle());
+    while (instances < count) {
+        DebugLogEntryCreateInstance();
+        if (UAVObjGetNumInstances(DebugLogEntryHandle()) == instances) {
+            // out of memory, use a smaller window
+            count = instances;
+            break;
+        }
+        instances++;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        RetrieveEntry(flight, first + i);
+        DebugLogEntryInstSet(i, entry);
+        UAVObjInstanceUpdated(DebugLogEntryHandle(), i);
+        if (entry->Type == DEBUGLOGENTRY_TYPE_EMPTY) {
+            // the rest of the window would be empty as well
+            break;
+        }
+    }
+}
+
+#if defined(PIOS_INCLUDE_TRACE)
+/**
+ * Write the frozen trace to the log, an entry per callback run until a
+ * buffer is not available, then retry once the log writer caught up.
+ */
+static void DumpTrace(void)
+{
+    while (true) {
+        uint32_t count    = 0;
+        uint32_t position = traceDumpPosition;
+
+#if defined(PIOS_INCLUDE_TASK_MONITOR)
+        // the task names come first, so the decoder knows them before the first task switch
+        for (; position < TRACE_TASK_COUNT && count < TRACE_RECORDS_PER_ENTRY; position++) {
+            xTaskHandle handle = PIOS_TASK_MONITOR_GetHandle(position);
+            if (handle) {
+                PIOS_TRACE_TaskInfo(&traceRecords[count++], position, handle);
+            }
+        }
+#endif
+        if (position >= TRACE_TASK_COUNT) {
+            uint32_t read = PIOS_TRACE_Read(position - TRACE_TASK_COUNT, &traceRecords[count], TRACE_RECORDS_PER_ENTRY - count);
+            count    += read;
+            position += read;
+        }
+        if (!count) {
+            break;
+        }
+        if (!PIOS_DEBUGLOG_Trace(traceRecords, count * sizeof(struct pios_trace_record), TRACE_TICKS_PER_US)) {
+            PIOS_CALLBACKSCHEDULER_Schedule(traceDumpCallback, TRACE_DUMP_RETRY_MS, CALLBACK_UPDATEMODE_SOONER);
+            return;
+        }
+        traceDumpPosition = position;
+    }
+
+    traceDumping = false;
+    PIOS_TRACE_Enable(settings.Trace == DEBUGLOGSETTINGS_TRACE_ENABLED);
+}
+#endif /* PIOS_INCLUDE_TRACE */
 
 /**
  * @}
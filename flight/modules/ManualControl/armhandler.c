@@ -260,14 +260,9 @@ static bool okToArm(void)
     // update checks
     configuration_check();
 
-    // read alarms
-    SystemAlarmsData alarms;
-
-    SystemAlarmsGet(&alarms);
-
-    // Check each alarm
+    // Check each alarm, read from the alarms library as SystemAlarms is only published once per system loop
     for (int i = 0; i < SYSTEMALARMS_ALARM_NUMELEM; i++) {
-        if (SystemAlarmsAlarmToArray(alarms.Alarm)[i] >= SYSTEMALARMS_ALARM_CRITICAL) { // found an alarm thats set
+        if (AlarmsGet(i) >= SYSTEMALARMS_ALARM_CRITICAL) { // found an alarm thats set
             if (i == SYSTEMALARMS_ALARM_GPS || i == SYSTEMALARMS_ALARM_TELEMETRY) {
                 continue;
             }
@@ -310,15 +305,10 @@ static bool okToArm(void)
  */
 static bool forcedDisArm(void)
 {
-    // read alarms
-    SystemAlarmsAlarmData alarms;
-
-    SystemAlarmsAlarmGet(&alarms);
-
-    if (alarms.Guidance == SYSTEMALARMS_ALARM_CRITICAL) {
+    if (AlarmsGet(SYSTEMALARMS_ALARM_GUIDANCE) == SYSTEMALARMS_ALARM_CRITICAL) {
         return true;
     }
-    if (alarms.Receiver == SYSTEMALARMS_ALARM_CRITICAL) {
+    if (AlarmsGet(SYSTEMALARMS_ALARM_RECEIVER) == SYSTEMALARMS_ALARM_CRITICAL) {
         return true;
     }
     return false;
@@ -33,11 +33,13 @@
 #include <openpilot.h>
 #include <flightstatus.h>
 
-typedef void (*handlerFunc)(bool newinit);
+typedef void (*handlerFunc)(void);
 
 typedef struct controlHandlerStruct {
     FlightStatusControlChainData controlChain;
-    handlerFunc handler;
+    handlerFunc init; // called when the flight mode is entered, before the first handler call (may be NULL)
+    handlerFunc handler; // called on every command update while in the flight mode (may be NULL)
+    handlerFunc exit; // called when another flight mode is entered (may be NULL)
 } controlHandler;
 
 /**
@@ -52,28 +54,31 @@ void armHandler(bool newinit);
  * @input: ManualControlCommand
  * @output: ActuatorDesired
  */
-void manualHandler(bool newinit);
+void manualHandlerInit();
+void manualHandler();
 
 /**
  * @brief Handler to control Stabilized flightmodes. FlightControl is governed by "Stabilization"
  * @input: ManualControlCommand
  * @output: StabilizationDesired
  */
-void stabilizedHandler(bool newinit);
+void stabilizedHandlerInit();
+void stabilizedHandler();
 
 /**
  * @brief Handler to control Guided flightmodes. FlightControl is governed by PathFollower, control via PathDesired
  * @input: NONE: fully automated mode -- TODO recursively call handler for advanced stick commands
  * @output: PathDesired
  */
-void pathFollowerHandler(bool newinit);
+void pathFollowerHandlerInit();
+void pathFollowerHandler();
 
 /**
  * @brief Handler to control Navigated flightmodes. FlightControl is governed by PathFollower, controlled indirectly via PathPlanner
  * @input: NONE: fully automated mode -- TODO recursively call handler for advanced stick commands to affect navigation
  * @output: NONE
  */
-void pathPlannerHandler(bool newinit);
+void pathPlannerHandler();
 
 /**
  * @brief Handler to setup takeofflocation on arming. it is set up during Arming
@@ -63,7 +63,9 @@ static const controlHandler handler_MANUAL = {
         .PathFollower  = false,
         .PathPlanner   = false,
     },
+    .init              = &manualHandlerInit,
     .handler           = &manualHandler,
+    .exit              = NULL,
 };
 static const controlHandler handler_STABILIZED = {
     .controlChain      = {
@@ -71,7 +73,9 @@ static const controlHandler handler_STABILIZED = {
         .PathFollower  = false,
         .PathPlanner   = false,
     },
+    .init              = &stabilizedHandlerInit,
     .handler           = &stabilizedHandler,
+    .exit              = NULL,
 };
 
 
@@ -81,7 +85,9 @@ static const controlHandler handler_AUTOTUNE = {
         .PathFollower  = false,
         .PathPlanner   = false,
     },
+    .init              = NULL,
     .handler           = NULL,
+    .exit              = NULL,
 };
 
 #ifndef PIOS_EXCLUDE_ADVANCED_FEATURES
@@ -91,7 +97,9 @@ static const controlHandler handler_PATHFOLLOWER = {
         .PathFollower  = true,
         .PathPlanner   = false,
     },
+    .init              = &pathFollowerHandlerInit,
     .handler           = &pathFollowerHandler,
+    .exit              = NULL,
 };
 
 static const controlHandler handler_PATHPLANNER = {
@@ -100,16 +108,45 @@ static const controlHandler handler_PATHPLANNER = {
         .PathFollower  = true,
         .PathPlanner   = true,
     },
+    .init              = NULL,
     .handler           = &pathPlannerHandler,
+    .exit              = NULL,
 };
 
 #endif /* ifndef PIOS_EXCLUDE_ADVANCED_FEATURES */
+
+// Handler of each flight mode, the ones left out fall back to handler_MANUAL
+static const controlHandler *const handlers[FLIGHTSTATUS_FLIGHTMODE_AUTOCRUISE + 1] = {
+    [FLIGHTSTATUS_FLIGHTMODE_MANUAL]            = &handler_MANUAL,
+    [FLIGHTSTATUS_FLIGHTMODE_STABILIZED1]       = &handler_STABILIZED,
+    [FLIGHTSTATUS_FLIGHTMODE_STABILIZED2]       = &handler_STABILIZED,
+    [FLIGHTSTATUS_FLIGHTMODE_STABILIZED3]       = &handler_STABILIZED,
+    [FLIGHTSTATUS_FLIGHTMODE_STABILIZED4]       = &handler_STABILIZED,
+    [FLIGHTSTATUS_FLIGHTMODE_STABILIZED5]       = &handler_STABILIZED,
+    [FLIGHTSTATUS_FLIGHTMODE_STABILIZED6]       = &handler_STABILIZED,
+#ifndef PIOS_EXCLUDE_ADVANCED_FEATURES
+    [FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD]      = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOFPV]  = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOLOS]  = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIONSEW] = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_RETURNTOBASE]      = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_LAND]              = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_POI]               = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_AUTOCRUISE]        = &handler_PATHFOLLOWER,
+    [FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER]       = &handler_PATHPLANNER,
+#endif
+    [FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE]          = &handler_AUTOTUNE,
+};
+
 // Private variables
 static DelayedCallbackInfo *callbackHandle;
+static uint8_t flightModePosition[FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_NUMELEM];
+static volatile bool modeSettingsUpdated = true;
 
 // Private functions
 static void configurationUpdatedCb(UAVObjEvent *ev);
 static void commandUpdatedCb(UAVObjEvent *ev);
+static void modeSettingsUpdatedCb(UAVObjEvent *ev);
 
 static void manualControlTask(void);
 
@@ -127,6 +164,7 @@ int32_t ManualControlStart()
     SystemSettingsConnectCallback(configurationUpdatedCb);
     ManualControlSettingsConnectCallback(configurationUpdatedCb);
     ManualControlCommandConnectCallback(commandUpdatedCb);
+    FlightModeSettingsConnectCallback(modeSettingsUpdatedCb);
 
     // clear alarms
     AlarmsClear(SYSTEMALARMS_ALARM_MANUALCONTROL);
@@ -180,64 +218,46 @@ static void manualControlTask(void)
     ManualControlCommandData cmd;
     ManualControlCommandGet(&cmd);
 
-    FlightModeSettingsData modeSettings;
-    FlightModeSettingsGet(&modeSettings);
+    // The switch positions are only read again when they change
+    if (modeSettingsUpdated) {
+        modeSettingsUpdated = false;
+        FlightModeSettingsFlightModePositionGet(flightModePosition);
+    }
 
     uint8_t position = cmd.FlightModeSwitchPosition;
     uint8_t newMode  = flightStatus.FlightMode;
     if (position < FLIGHTMODESETTINGS_FLIGHTMODEPOSITION_NUMELEM) {
-        newMode = modeSettings.FlightModePosition[position];
+        newMode = flightModePosition[position];
     }
 
     // Depending on the mode update the Stabilization or Actuator objects
-    const controlHandler *handler = &handler_MANUAL;
-    switch (newMode) {
-    case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
-        handler = &handler_MANUAL;
-        break;
-    case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
-    case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
-    case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
-    case FLIGHTSTATUS_FLIGHTMODE_STABILIZED4:
-    case FLIGHTSTATUS_FLIGHTMODE_STABILIZED5:
-    case FLIGHTSTATUS_FLIGHTMODE_STABILIZED6:
-        handler = &handler_STABILIZED;
-        break;
-#ifndef PIOS_EXCLUDE_ADVANCED_FEATURES
-    case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
-    case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOFPV:
-    case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOLOS:
-    case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIONSEW:
-    case FLIGHTSTATUS_FLIGHTMODE_RETURNTOBASE:
-    case FLIGHTSTATUS_FLIGHTMODE_LAND:
-    case FLIGHTSTATUS_FLIGHTMODE_POI:
-    case FLIGHTSTATUS_FLIGHTMODE_AUTOCRUISE:
-        handler = &handler_PATHFOLLOWER;
-        break;
-    case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
-        handler = &handler_PATHPLANNER;
-        break;
-#endif
-    case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
-        handler = &handler_AUTOTUNE;
-        break;
-        // There is no default, so if a flightmode is forgotten the compiler can throw a warning!
-    }
-
-    bool newinit = false;
+    static const controlHandler *handler = NULL;
 
     // FlightMode needs to be set correctly on first run (otherwise ControlChain is invalid)
-    static bool firstRun = true;
+    if (flightStatus.FlightMode != newMode || !handler) {
+        const controlHandler *newHandler = NULL;
+        if (newMode < NELEMENTS(handlers)) {
+            newHandler = handlers[newMode];
+        }
+        if (!newHandler) {
+            newHandler = &handler_MANUAL;
+        }
+
+        if (handler && handler->exit) {
+            handler->exit();
+        }
+        handler = newHandler;
 
-    if (flightStatus.FlightMode != newMode || firstRun) {
-        firstRun = false;
         flightStatus.ControlChain = handler->controlChain;
         flightStatus.FlightMode   = newMode;
         FlightStatusSet(&flightStatus);
-        newinit = true;
+
+        if (handler->init) {
+            handler->init();
+        }
     }
     if (handler->handler) {
-        handler->handler(newinit);
+        handler->handler();
     }
 }
 
@@ -249,6 +269,14 @@ static void configurationUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     configuration_check();
 }
 
+/**
+ * Called whenever the flight mode settings change
+ */
+static void modeSettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    modeSettingsUpdated = true;
+}
+
 /**
  * Called whenever a critical configuration component changes
  */
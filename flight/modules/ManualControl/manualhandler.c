@@ -39,17 +39,21 @@
 // Private functions
 
 
+/**
+ * @brief Called when entering the Manual flightmode
+ */
+void manualHandlerInit()
+{
+    ActuatorDesiredInitialize();
+}
+
 /**
  * @brief Handler to control Manual flightmode - input directly steers actuators
  * @input: ManualControlCommand
  * @output: ActuatorDesired
  */
-void manualHandler(bool newinit)
+void manualHandler()
 {
-    if (newinit) {
-        ActuatorDesiredInitialize();
-    }
-
     ManualControlCommandData cmd;
     ManualControlCommandGet(&cmd);
 
@@ -45,51 +45,56 @@
 // Private functions
 
 /**
- * @brief Handler to control Guided flightmodes. FlightControl is governed by PathFollower, control via PathDesired
- * @input: NONE: fully automated mode -- TODO recursively call handler for advanced stick commands
- * @output: PathDesired
+ * @brief Called when entering a Guided flightmode
  */
-void pathFollowerHandler(bool newinit)
+void pathFollowerHandlerInit()
 {
-    if (newinit) {
-        plan_initialize();
-    }
+    plan_initialize();
 
     uint8_t flightMode;
     FlightStatusFlightModeGet(&flightMode);
 
-    if (newinit) {
-        // After not being in this mode for a while init at current height
-        switch (flightMode) {
-        case FLIGHTSTATUS_FLIGHTMODE_RETURNTOBASE:
-            plan_setup_returnToBase();
-            break;
-
-        case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
-            plan_setup_positionHold();
-            break;
-        case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOFPV:
-            plan_setup_PositionVarioFPV();
-            break;
-        case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOLOS:
-            plan_setup_PositionVarioLOS();
-            break;
-        case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIONSEW:
-            plan_setup_PositionVarioNSEW();
-            break;
-
-        case FLIGHTSTATUS_FLIGHTMODE_LAND:
-            plan_setup_land();
-            break;
-        case FLIGHTSTATUS_FLIGHTMODE_AUTOCRUISE:
-            plan_setup_AutoCruise();
-            break;
-
-        default:
-            plan_setup_positionHold();
-            break;
-        }
+    // After not being in this mode for a while init at current height
+    switch (flightMode) {
+    case FLIGHTSTATUS_FLIGHTMODE_RETURNTOBASE:
+        plan_setup_returnToBase();
+        break;
+
+    case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
+        plan_setup_positionHold();
+        break;
+    case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOFPV:
+        plan_setup_PositionVarioFPV();
+        break;
+    case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOLOS:
+        plan_setup_PositionVarioLOS();
+        break;
+    case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIONSEW:
+        plan_setup_PositionVarioNSEW();
+        break;
+
+    case FLIGHTSTATUS_FLIGHTMODE_LAND:
+        plan_setup_land();
+        break;
+    case FLIGHTSTATUS_FLIGHTMODE_AUTOCRUISE:
+        plan_setup_AutoCruise();
+        break;
+
+    default:
+        plan_setup_positionHold();
+        break;
     }
+}
+
+/**
+ * @brief Handler to control Guided flightmodes. FlightControl is governed by PathFollower, control via PathDesired
+ * @input: NONE: fully automated mode -- TODO recursively call handler for advanced stick commands
+ * @output: PathDesired
+ */
+void pathFollowerHandler()
+{
+    uint8_t flightMode;
+    FlightStatusFlightModeGet(&flightMode);
 
     switch (flightMode) {
     case FLIGHTSTATUS_FLIGHTMODE_POSITIONVARIOFPV:
@@ -113,7 +118,9 @@ void pathFollowerHandler(bool newinit)
 }
 
 #else /* if defined(REVOLUTION) */
-void pathFollowerHandler(__attribute__((unused)) bool newinit)
+void pathFollowerHandlerInit() {}
+
+void pathFollowerHandler()
 {
     AlarmsSet(SYSTEMALARMS_ALARM_MANUALCONTROL, SYSTEMALARMS_ALARM_CRITICAL); // should not be called
 }
@@ -42,7 +42,7 @@
  * @input: NONE: fully automated mode -- TODO recursively call handler for advanced stick commands to affect navigation
  * @output: NONE
  */
-void pathPlannerHandler(__attribute__((unused)) bool newinit)
+void pathPlannerHandler()
 {
     /**
      *
@@ -36,14 +36,29 @@
 #include <stabilizationbank.h>
 
 // Private constants
+#define EXPO_CURVE_POINTS 33 // points of the expo curves from 0 to full stick
+#define EXPO_CURVE_SCALE  65535.0f
 
 // Private types
 
+// Private variables
+
+// Computed from the settings when entering the flight mode or when they change
+static volatile bool settingsUpdated = true;
+static bool modeValid;
+static uint8_t stabModes[STABILIZATIONDESIRED_STABILIZATIONMODE_NUMELEM];
+static float axisScale[3];
+static uint16_t expoCurves[3][EXPO_CURVE_POINTS];
+
 // Private functions
-static float applyExpo(float value, float expo);
+static void settingsUpdatedCb(UAVObjEvent *ev);
+static void updateSettings(void);
+static void computeExpoCurve(uint16_t *curve, float expo);
+static float applyExpo(float value, const uint16_t *curve);
+static float modeScale(uint8_t mode, float manualRate, float max);
 
 
-static float applyExpo(float value, float expo)
+static void computeExpoCurve(uint16_t *curve, float expo)
 {
     // note: fastPow makes a small error, therefore result needs to be bound
     float exp = boundf(fastPow(1.00695f, expo), 0.5f, 2.0f);
@@ -54,45 +69,75 @@ static float applyExpo(float value, float expo)
     // expo=0 yields value**1
     // expo=-100 yields value**(1/10)
     // (pow(2.0,1/100)~=1.00695)
-    if (value > 0.0f) {
-        return boundf(fastPow(value, exp), 0.0f, 1.0f);
-    } else if (value < -0.0f) {
-        return boundf(-fastPow(-value, exp), -1.0f, 0.0f);
-    } else {
-        return 0.0f;
+    curve[0] = 0;
+    for (uint8_t i = 1; i < EXPO_CURVE_POINTS; i++) {
+        float value = (float)i / (EXPO_CURVE_POINTS - 1);
+        curve[i] = (uint16_t)(boundf(fastPow(value, exp), 0.0f, 1.0f) * EXPO_CURVE_SCALE + 0.5f);
     }
 }
 
+static float applyExpo(float value, const uint16_t *curve)
+{
+    // Linear interpolation between the points of the precomputed curve
+    float pos   = boundf(fabsf(value), 0.0f, 1.0f) * (EXPO_CURVE_POINTS - 1);
+    uint8_t i   = (uint8_t)pos;
+    float result;
+
+    if (i >= EXPO_CURVE_POINTS - 1) {
+        result = curve[EXPO_CURVE_POINTS - 1];
+    } else {
+        result = curve[i] + (curve[i + 1] - curve[i]) * (pos - i);
+    }
+    result *= 1.0f / EXPO_CURVE_SCALE;
+
+    return (value < 0.0f) ? -result : result;
+}
 
 /**
- * @brief Handler to control Stabilized flightmodes. FlightControl is governed by "Stabilization"
- * @input: ManualControlCommand
- * @output: StabilizationDesired
+ * @brief Scale of the stick input of an axis in the given stabilization mode
  */
-void stabilizedHandler(bool newinit)
+static float modeScale(uint8_t mode, float manualRate, float max)
 {
-    if (newinit) {
-        StabilizationDesiredInitialize();
-        StabilizationBankInitialize();
+    switch (mode) {
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_MANUAL:
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR:
+        return 1.0f;
+
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_RATE:
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK:
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_ACRO:
+        return manualRate;
+
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING:
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE:
+    case STABILIZATIONDESIRED_STABILIZATIONMODE_RATTITUDE:
+        return max;
+
+    default:
+        return 0; // this is an invalid mode
     }
-    ManualControlCommandData cmd;
-    ManualControlCommandGet(&cmd);
+}
+
+static void settingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    settingsUpdated = true;
+}
 
+/**
+ * @brief Work out the stabilization modes, stick scales and expo curves of the current flight mode
+ */
+static void updateSettings(void)
+{
     FlightModeSettingsData settings;
     FlightModeSettingsGet(&settings);
 
-    StabilizationDesiredData stabilization;
-    StabilizationDesiredGet(&stabilization);
-
     StabilizationBankData stabSettings;
     StabilizationBankGet(&stabSettings);
 
-    cmd.Roll  = applyExpo(cmd.Roll, stabSettings.StickExpo.Roll);
-    cmd.Pitch = applyExpo(cmd.Pitch, stabSettings.StickExpo.Pitch);
-    cmd.Yaw   = applyExpo(cmd.Yaw, stabSettings.StickExpo.Yaw);
     uint8_t *stab_settings;
     FlightStatusData flightStatus;
     FlightStatusGet(&flightStatus);
+    modeValid = true;
     switch (flightStatus.FlightMode) {
     case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
         stab_settings = FlightModeSettingsStabilization1SettingsToArray(settings.Stabilization1Settings);
@@ -114,57 +159,78 @@ void stabilizedHandler(bool newinit)
         break;
     default:
         // Major error, this should not occur because only enter this block when one of these is true
-        AlarmsSet(SYSTEMALARMS_ALARM_MANUALCONTROL, SYSTEMALARMS_ALARM_CRITICAL);
-        stab_settings = FlightModeSettingsStabilization1SettingsToArray(settings.Stabilization1Settings);
+        modeValid = false;
         return;
     }
 
-    stabilization.Roll =
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_MANUAL) ? cmd.Roll :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? cmd.Roll * stabSettings.ManualRate.Roll :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? cmd.Roll * stabSettings.RollMax :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? cmd.Roll * stabSettings.RollMax :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? cmd.Roll * stabSettings.ManualRate.Roll :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR) ? cmd.Roll :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACRO) ? cmd.Roll * stabSettings.ManualRate.Roll :
-        (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATTITUDE) ? cmd.Roll * stabSettings.RollMax :
-        0; // this is an invalid mode
-
-    stabilization.Pitch =
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_MANUAL) ? cmd.Pitch :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? cmd.Pitch * stabSettings.ManualRate.Pitch :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? cmd.Pitch * stabSettings.PitchMax :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? cmd.Pitch * stabSettings.PitchMax :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? cmd.Pitch * stabSettings.ManualRate.Pitch :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR) ? cmd.Pitch :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACRO) ? cmd.Pitch * stabSettings.ManualRate.Pitch :
-        (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATTITUDE) ? cmd.Pitch * stabSettings.PitchMax :
-        0; // this is an invalid mode
-
     // TOOD: Add assumption about order of stabilization desired and manual control stabilization mode fields having same order
-    stabilization.StabilizationMode.Roll  = stab_settings[0];
-    stabilization.StabilizationMode.Pitch = stab_settings[1];
+    stabModes[0] = stab_settings[0];
+    stabModes[1] = stab_settings[1];
+    stabModes[2] = stab_settings[2];
+    stabModes[3] = stab_settings[3];
     // Other axes (yaw) cannot be Rattitude, so use Rate
     // Should really do this for Attitude mode as well?
-    if (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATTITUDE) {
-        stabilization.StabilizationMode.Yaw = STABILIZATIONDESIRED_STABILIZATIONMODE_RATE;
-        stabilization.Yaw = cmd.Yaw * stabSettings.ManualRate.Yaw;
-    } else {
-        stabilization.StabilizationMode.Yaw = stab_settings[2];
-        stabilization.Yaw =
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_MANUAL) ? cmd.Yaw :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? cmd.Yaw * stabSettings.ManualRate.Yaw :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? cmd.Yaw * stabSettings.YawMax :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? cmd.Yaw * stabSettings.YawMax :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? cmd.Yaw * stabSettings.ManualRate.Yaw :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR) ? cmd.Yaw :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACRO) ? cmd.Yaw * stabSettings.ManualRate.Yaw :
-            (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATTITUDE) ? cmd.Yaw * stabSettings.YawMax :
-            0; // this is an invalid mode
+    if (stabModes[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATTITUDE) {
+        stabModes[2] = STABILIZATIONDESIRED_STABILIZATIONMODE_RATE;
+    }
+
+    axisScale[0] = modeScale(stabModes[0], stabSettings.ManualRate.Roll, stabSettings.RollMax);
+    axisScale[1] = modeScale(stabModes[1], stabSettings.ManualRate.Pitch, stabSettings.PitchMax);
+    axisScale[2] = modeScale(stabModes[2], stabSettings.ManualRate.Yaw, stabSettings.YawMax);
+
+    computeExpoCurve(expoCurves[0], stabSettings.StickExpo.Roll);
+    computeExpoCurve(expoCurves[1], stabSettings.StickExpo.Pitch);
+    computeExpoCurve(expoCurves[2], stabSettings.StickExpo.Yaw);
+}
+
+
+/**
+ * @brief Called when entering a Stabilized flightmode
+ */
+void stabilizedHandlerInit()
+{
+    static bool connected = false;
+
+    if (!connected) {
+        StabilizationDesiredInitialize();
+        StabilizationBankInitialize();
+        StabilizationBankConnectCallback(&settingsUpdatedCb);
+        FlightModeSettingsConnectCallback(&settingsUpdatedCb);
+        connected = true;
     }
+    // The stabilization modes depend on the flight mode just entered
+    settingsUpdated = true;
+}
+
+/**
+ * @brief Handler to control Stabilized flightmodes. FlightControl is governed by "Stabilization"
+ * @input: ManualControlCommand
+ * @output: StabilizationDesired
+ */
+void stabilizedHandler()
+{
+    if (settingsUpdated) {
+        settingsUpdated = false;
+        updateSettings();
+    }
+    if (!modeValid) {
+        AlarmsSet(SYSTEMALARMS_ALARM_MANUALCONTROL, SYSTEMALARMS_ALARM_CRITICAL);
+        return;
+    }
+
+    ManualControlCommandData cmd;
+    ManualControlCommandGet(&cmd);
+
+    StabilizationDesiredData stabilization;
 
+    stabilization.Roll   = applyExpo(cmd.Roll, expoCurves[0]) * axisScale[0];
+    stabilization.Pitch  = applyExpo(cmd.Pitch, expoCurves[1]) * axisScale[1];
+    stabilization.Yaw    = applyExpo(cmd.Yaw, expoCurves[2]) * axisScale[2];
     stabilization.Thrust = cmd.Thrust;
-    stabilization.StabilizationMode.Thrust = stab_settings[3];
+    stabilization.StabilizationMode.Roll   = stabModes[0];
+    stabilization.StabilizationMode.Pitch  = stabModes[1];
+    stabilization.StabilizationMode.Yaw    = stabModes[2];
+    stabilization.StabilizationMode.Thrust = stabModes[3];
     StabilizationDesiredSet(&stabilization);
 }
 
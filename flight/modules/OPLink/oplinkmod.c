@@ -164,6 +164,7 @@ static void systemTask(__attribute__((unused)) void *parameters)
             oplinkStatus.Timeouts    = radio_stats.timeouts;
             oplinkStatus.RSSI        = radio_stats.rssi;
             oplinkStatus.LinkQuality = radio_stats.link_quality;
+            oplinkStatus.AirDataRate = radio_stats.air_datarate;
             if (first_time) {
                 first_time = false;
             } else {
@@ -47,17 +47,29 @@ int32_t osdgenInitialize(void);
 #define CALC_BUFF_ADDR(x, y) (((x) / 8) + ((y) * (GRAPHICS_WIDTH_REAL / 8)))
 #define CALC_BIT_IN_WORD(x)  ((x) & 7)
 #define DEBUG_DELAY
+
+// Extent of a widget in the buffers, in bytes and lines (inclusive), empty when x1 < x0
+struct osd_rect {
+    int16_t x0, y0, x1, y1;
+};
+
+// Records the buffer writes of the widget being drawn, see osd_widget()
+extern struct osd_rect *osd_track_rect;
+void osd_track_write(unsigned int addr);
+#define TRACK_WRITE(addr) { if (osd_track_rect) { osd_track_write(addr); } }
+
 // Macro for writing a word with a mode (NAND = clear, OR = set, XOR = toggle)
 // at a given position
 #define WRITE_WORD_MODE(buff, addr, mask, mode) \
+    TRACK_WRITE(addr); \
     switch (mode) { \
     case 0: buff[addr] &= ~mask; break; \
     case 1: buff[addr] |= mask; break; \
     case 2: buff[addr] ^= mask; break; }
 
-#define WRITE_WORD_NAND(buff, addr, mask) { buff[addr] &= ~mask; DEBUG_DELAY; }
-#define WRITE_WORD_OR(buff, addr, mask)   { buff[addr] |= mask; DEBUG_DELAY; }
-#define WRITE_WORD_XOR(buff, addr, mask)  { buff[addr] ^= mask; DEBUG_DELAY; }
+#define WRITE_WORD_NAND(buff, addr, mask) { TRACK_WRITE(addr); buff[addr] &= ~mask; DEBUG_DELAY; }
+#define WRITE_WORD_OR(buff, addr, mask)   { TRACK_WRITE(addr); buff[addr] |= mask; DEBUG_DELAY; }
+#define WRITE_WORD_XOR(buff, addr, mask)  { TRACK_WRITE(addr); buff[addr] ^= mask; DEBUG_DELAY; }
 
 // Horizontal line calculations.
 // Edge cases.
@@ -204,4 +216,9 @@ void write_string_formatted(char *str, unsigned int x, unsigned int y, unsigned
 
 void updateOnceEveryFrame();
 
+// Dirty rectangle rendering of the frames drawn by updateGraphics()
+typedef void (*osd_widget_draw)(const void *args);
+void osd_widget(osd_widget_draw draw, const void *args, uint8_t args_len);
+void osd_string(char *str, unsigned int x, unsigned int y, unsigned int xs, unsigned int ys, int va, int ha, int flags, int font);
+
 #endif /* OSDGEN_H_ */
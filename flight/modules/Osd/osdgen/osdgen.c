@@ -50,6 +50,8 @@
 #include "WMMInternal.h"
 
 #include "splash.h"
+
+#include <pios_instrumentation_helper.h>
 /*
    static uint16_t angleA=0;
    static int16_t angleB=90;
@@ -90,6 +92,17 @@ xSemaphoreHandle osdSemaphore = NULL;
 #define TASK_PRIORITY    (tskIDLE_PRIORITY + 4)
 #define UPDATE_PERIOD    100
 
+// The widgets of a frame, their arguments are compared with the ones of the last frame
+#define OSD_MAX_WIDGETS     32
+#define OSD_WIDGET_ARGS_LEN 44
+#define OSD_STRING_MAX_LEN  24
+
+// Performance counters
+// - 0x05D00001 rendering time of a frame (us)
+// - 0x05D00002 widgets drawn again in the frame
+PERF_DEFINE_COUNTER(counterRender);
+PERF_DEFINE_COUNTER(counterDrawn);
+
 // ****************
 // Private variables
 
@@ -132,6 +145,209 @@ void clearGraphics()
     memset((uint8_t *)draw_buffer_level, 0, GRAPHICS_WIDTH * GRAPHICS_HEIGHT);
 }
 
+/*
+ * Dirty rectangle rendering.
+ * updateGraphics() queues the widgets of the frame (a drawing function and its
+ * arguments) with osd_widget(). A widget queued with the same function and
+ * arguments as in the last frame is copied from the last frame (the display
+ * buffer) instead of being drawn again. The extent of a widget is recorded by
+ * the buffer writes while it is drawn. A widget overlapping the last extent of a
+ * changed one is drawn again, and the frame is drawn again entirely when a
+ * changed widget grows over an unchanged one.
+ */
+struct osd_widget {
+    osd_widget_draw draw;
+    struct osd_rect rect;
+    uint8_t args_len;
+    bool    dirty;
+    uint8_t args[OSD_WIDGET_ARGS_LEN] __attribute__((aligned(4)));
+};
+
+struct osd_frame {
+    struct osd_widget widgets[OSD_MAX_WIDGETS];
+    uint8_t num_widgets;
+};
+
+static struct osd_frame frames[2];
+static uint8_t current_frame;
+static bool redraw_all = true;
+struct osd_rect *osd_track_rect;
+
+void osd_track_write(unsigned int addr)
+{
+    int16_t x = addr % GRAPHICS_WIDTH;
+    int16_t y = addr / GRAPHICS_WIDTH;
+
+    if (osd_track_rect->x1 < osd_track_rect->x0) {
+        *osd_track_rect = (struct osd_rect) { x, y, x, y };
+        return;
+    }
+    osd_track_rect->x0 = MIN(osd_track_rect->x0, x);
+    osd_track_rect->x1 = MAX(osd_track_rect->x1, x);
+    osd_track_rect->y0 = MIN(osd_track_rect->y0, y);
+    osd_track_rect->y1 = MAX(osd_track_rect->y1, y);
+}
+
+static bool osd_rect_overlap(const struct osd_rect *a, const struct osd_rect *b)
+{
+    return a->x0 <= a->x1 && b->x0 <= b->x1 &&
+           a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+/**
+ * Queues a widget of the frame
+ * \param[in] draw the drawing function, called with a copy of the arguments
+ * \param[in] args the arguments, NULL for a widget drawn again in every frame
+ * \param[in] args_len size of the arguments, up to OSD_WIDGET_ARGS_LEN
+ */
+void osd_widget(osd_widget_draw draw, const void *args, uint8_t args_len)
+{
+    struct osd_frame *frame = &frames[current_frame];
+
+    if (frame->num_widgets >= OSD_MAX_WIDGETS || args_len > OSD_WIDGET_ARGS_LEN) {
+        // Not drawn, OSD_MAX_WIDGETS must cover the widgets of a screen
+        return;
+    }
+
+    struct osd_widget *widget = &frame->widgets[frame->num_widgets++];
+    widget->draw     = draw;
+    widget->args_len = args && args_len ? args_len : 0;
+    widget->dirty    = !args;
+    memcpy(widget->args, args, widget->args_len);
+}
+
+static void osd_draw_widget(struct osd_widget *widget)
+{
+    widget->rect   = (struct osd_rect) { 0, 0, -1, -1 };
+    osd_track_rect = &widget->rect;
+    widget->draw(widget->args);
+    osd_track_rect = NULL;
+}
+
+static void osd_copy_rect(const struct osd_rect *rect)
+{
+    for (int16_t y = rect->y0; y <= rect->y1; y++) {
+        int offset = y * GRAPHICS_WIDTH + rect->x0;
+        memcpy(&draw_buffer_level[offset], &disp_buffer_level[offset], rect->x1 - rect->x0 + 1);
+        memcpy(&draw_buffer_mask[offset], &disp_buffer_mask[offset], rect->x1 - rect->x0 + 1);
+    }
+}
+
+/**
+ * Draws the queued widgets in the draw buffer
+ * \return the number of widgets drawn, the others were copied
+ */
+static uint8_t osd_render(void)
+{
+    struct osd_frame *frame = &frames[current_frame];
+    struct osd_frame *last  = &frames[current_frame ^ 1];
+    uint8_t drawn = 0;
+
+    // The unchanged widgets keep their extent
+    for (uint8_t i = 0; i < frame->num_widgets; i++) {
+        struct osd_widget *widget = &frame->widgets[i];
+        if (redraw_all || i >= last->num_widgets || widget->dirty ||
+            widget->draw != last->widgets[i].draw || widget->args_len != last->widgets[i].args_len ||
+            memcmp(widget->args, last->widgets[i].args, widget->args_len)) {
+            widget->dirty = true;
+        } else {
+            widget->rect = last->widgets[i].rect;
+        }
+    }
+
+    // An unchanged widget is drawn again when the old pixels of a changed (or removed) one are in its extent
+    bool changed = !redraw_all;
+    while (changed) {
+        changed = false;
+        for (uint8_t i = 0; i < frame->num_widgets; i++) {
+            if (frame->widgets[i].dirty) {
+                continue;
+            }
+            for (uint8_t j = 0; j < last->num_widgets; j++) {
+                if ((j >= frame->num_widgets || frame->widgets[j].dirty) &&
+                    osd_rect_overlap(&frame->widgets[i].rect, &last->widgets[j].rect)) {
+                    frame->widgets[i].dirty = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    clearGraphics();
+    for (uint8_t i = 0; i < frame->num_widgets; i++) {
+        if (!frame->widgets[i].dirty) {
+            osd_copy_rect(&frame->widgets[i].rect);
+        }
+    }
+    for (uint8_t i = 0; i < frame->num_widgets; i++) {
+        if (frame->widgets[i].dirty) {
+            osd_draw_widget(&frame->widgets[i]);
+            drawn++;
+        }
+    }
+
+    // The drawing order matters where the widgets overlap, draw them all in order then
+    bool overlap = false;
+    for (uint8_t i = 0; i < frame->num_widgets && !overlap; i++) {
+        for (uint8_t j = 0; j < frame->num_widgets && !overlap; j++) {
+            overlap = frame->widgets[i].dirty && !frame->widgets[j].dirty &&
+                      osd_rect_overlap(&frame->widgets[i].rect, &frame->widgets[j].rect);
+        }
+    }
+    if (overlap) {
+        clearGraphics();
+        for (uint8_t i = 0; i < frame->num_widgets; i++) {
+            osd_draw_widget(&frame->widgets[i]);
+        }
+        drawn = frame->num_widgets;
+    }
+
+    redraw_all    = false;
+    current_frame ^= 1;
+    frames[current_frame].num_widgets = 0;
+    return drawn;
+}
+
+/*
+ * Widgets drawing functions, the arguments are packed in structures cleared
+ * before they are set, so that they compare equal when the values are equal.
+ */
+struct osd_string_args {
+    char     str[OSD_STRING_MAX_LEN];
+    uint16_t x, y, xs, ys;
+    int8_t   va, ha, flags, font;
+};
+
+static void osd_string_draw(const void *args)
+{
+    const struct osd_string_args *s = args;
+    char str[OSD_STRING_MAX_LEN];
+
+    memcpy(str, s->str, sizeof(str));
+    write_string(str, s->x, s->y, s->xs, s->ys, s->va, s->ha, s->flags, s->font);
+}
+
+/**
+ * Queues a write_string() widget, the string is truncated to OSD_STRING_MAX_LEN - 1 characters
+ */
+void osd_string(char *str, unsigned int x, unsigned int y, unsigned int xs, unsigned int ys, int va, int ha, int flags, int font)
+{
+    struct osd_string_args args;
+
+    memset(&args, 0, sizeof(args));
+    strncpy(args.str, str, sizeof(args.str) - 1);
+    args.x  = x;
+    args.y  = y;
+    args.xs = xs;
+    args.ys = ys;
+    args.va = va;
+    args.ha = ha;
+    args.flags = flags;
+    args.font  = font;
+    osd_widget(osd_string_draw, &args, sizeof(args));
+}
+
 void copyimage(uint16_t offsetx, uint16_t offsety, int image)
 {
     // check top/left position
@@ -144,6 +360,8 @@ void copyimage(uint16_t offsetx, uint16_t offsety, int image)
     for (uint16_t y = offsety; y < ((splash_info.height) + offsety); y++) {
         uint16_t x1 = offsetx;
         for (uint16_t x = offsetx; x < (((splash_info.width) / 16) + offsetx); x++) {
+            TRACK_WRITE(y * GRAPHICS_WIDTH + x1);
+            TRACK_WRITE(y * GRAPHICS_WIDTH + x1 + 1);
             draw_buffer_level[y * GRAPHICS_WIDTH + x1 + 1] = (uint8_t)(
                 mirror(splash_info.level[(y - offsety) * ((splash_info.width) / 16) + (x - offsetx)]) >> 8);
             draw_buffer_level[y * GRAPHICS_WIDTH + x1]     = (uint8_t)(
@@ -1588,7 +1806,7 @@ void printTime(uint16_t x, uint16_t y)
 
     sprintf(temp, "%02d:%02d:%02d", timex.hour, timex.min, timex.sec);
     // printTextFB(x,y,temp);
-    write_string(temp, x, y, 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
+    osd_string(temp, x, y, 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
 }
 
 /*
@@ -2098,16 +2316,16 @@ void calcHomeArrow(int16_t m_yaw)
     char temp[50] =
     { 0 };
     sprintf(temp, "hea:%d", (int)brng);
-    write_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+    osd_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
     sprintf(temp, "ele:%d", (int)elevation);
-    write_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+    osd_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
     sprintf(temp, "dis:%d", (int)d);
-    write_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30 + 10 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+    osd_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30 + 10 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
     sprintf(temp, "u2g:%d", (int)u2g);
-    write_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30 + 10 + 10 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+    osd_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - 30), APPLY_VDEADBAND(30 + 10 + 10 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
 
     sprintf(temp, "%c%c", (int)(u2g / 22.5f) * 2 + 0x90, (int)(u2g / 22.5f) * 2 + 0x91);
-    write_string(temp, APPLY_HDEADBAND(250), APPLY_VDEADBAND(40 + 10 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
+    osd_string(temp, APPLY_HDEADBAND(250), APPLY_VDEADBAND(40 + 10 + 10), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
 }
 
 int lama = 10;
@@ -2131,6 +2349,90 @@ void lamas(void)
     }
 }
 
+// Widgets of updateGraphics()
+struct osd_scale_args {
+    int16_t v, range, halign, x, y, height, mintick_step, majtick_step, mintick_len, majtick_len, boundtick_len, max_val, flags;
+};
+
+static void osd_scale_draw(const void *args)
+{
+    const struct osd_scale_args *a = args;
+
+    hud_draw_vertical_scale(a->v, a->range, a->halign, a->x, a->y, a->height, a->mintick_step, a->majtick_step,
+                            a->mintick_len, a->majtick_len, a->boundtick_len, a->max_val, a->flags);
+}
+
+static void osd_vertical_scale(int v, int range, int halign, int x, int y, int height, int mintick_step, int majtick_step, int mintick_len, int majtick_len,
+                               int boundtick_len, int max_val, int flags)
+{
+    struct osd_scale_args args = { v, range, halign, x, y, height, mintick_step, majtick_step, mintick_len, majtick_len, boundtick_len, max_val, flags };
+
+    osd_widget(osd_scale_draw, &args, sizeof(args));
+}
+
+struct osd_compass_args {
+    int16_t v, range, width, x, y, mintick_step, majtick_step, mintick_len, majtick_len, flags;
+};
+
+static void osd_compass_draw(const void *args)
+{
+    const struct osd_compass_args *a = args;
+
+    hud_draw_linear_compass(a->v, a->range, a->width, a->x, a->y, a->mintick_step, a->majtick_step, a->mintick_len, a->majtick_len, a->flags);
+}
+
+static void osd_linear_compass(int v, int range, int width, int x, int y, int mintick_step, int majtick_step, int mintick_len, int majtick_len, int flags)
+{
+    struct osd_compass_args args = { v, range, width, x, y, mintick_step, majtick_step, mintick_len, majtick_len, flags };
+
+    osd_widget(osd_compass_draw, &args, sizeof(args));
+}
+
+struct osd_attitude_args {
+    int16_t x, y, pitch, roll, size;
+};
+
+static void osd_attitude_draw(const void *args)
+{
+    const struct osd_attitude_args *a = args;
+
+    drawAttitude(a->x, a->y, a->pitch, a->roll, a->size);
+}
+
+struct osd_horizon_args {
+    float   angle, pitch;
+    int16_t x, y, size;
+};
+
+static void osd_horizon_draw(const void *args)
+{
+    const struct osd_horizon_args *a = args;
+
+    draw_artificial_horizon(a->angle, a->pitch, a->x, a->y, a->size);
+}
+
+struct osd_image_args {
+    int16_t x, y, image;
+};
+
+static void osd_image_draw(const void *args)
+{
+    const struct osd_image_args *a = args;
+
+    copyimage(a->x, a->y, a->image);
+}
+
+static void osd_lamas_draw(__attribute__((unused)) const void *args)
+{
+    lamas();
+}
+
+static void osd_crosshair_draw(__attribute__((unused)) const void *args)
+{
+    write_vline_lm(APPLY_HDEADBAND(GRAPHICS_RIGHT / 2), APPLY_VDEADBAND(0), APPLY_VDEADBAND(GRAPHICS_BOTTOM), 1, 1);
+    write_hline_lm(APPLY_HDEADBAND(0), APPLY_HDEADBAND(GRAPHICS_RIGHT), APPLY_VDEADBAND(GRAPHICS_BOTTOM / 2), 1, 1);
+}
+
 // main draw function
 void updateGraphics()
 {
@@ -2159,7 +2461,7 @@ void updateGraphics()
             { 0 };
             sprintf(temps, "HOME NOT SET");
             // printTextFB(x,y,temp);
-            write_string(temps, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2), (GRAPHICS_BOTTOM / 2), 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, 3);
+            osd_string(temps, APPLY_HDEADBAND(GRAPHICS_RIGHT / 2), (GRAPHICS_BOTTOM / 2), 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, 3);
         }
 
         char temp[50] =
@@ -2168,15 +2470,15 @@ void updateGraphics()
         // Note: cast to double required due to -Wdouble-promotion compiler option is
         // being used, and there is no way in C to pass a float to a variadic function like sprintf()
         sprintf(temp, "Lat:%11.7f", (double)(gpsData.Latitude / 10000000.0f));
-        write_string(temp, APPLY_HDEADBAND(20), APPLY_VDEADBAND(GRAPHICS_BOTTOM - 30), 0, 0, TEXT_VA_BOTTOM, TEXT_HA_LEFT, 0, 3);
+        osd_string(temp, APPLY_HDEADBAND(20), APPLY_VDEADBAND(GRAPHICS_BOTTOM - 30), 0, 0, TEXT_VA_BOTTOM, TEXT_HA_LEFT, 0, 3);
         sprintf(temp, "Lon:%11.7f", (double)(gpsData.Longitude / 10000000.0f));
-        write_string(temp, APPLY_HDEADBAND(20), APPLY_VDEADBAND(GRAPHICS_BOTTOM - 10), 0, 0, TEXT_VA_BOTTOM, TEXT_HA_LEFT, 0, 3);
+        osd_string(temp, APPLY_HDEADBAND(20), APPLY_VDEADBAND(GRAPHICS_BOTTOM - 10), 0, 0, TEXT_VA_BOTTOM, TEXT_HA_LEFT, 0, 3);
         sprintf(temp, "Sat:%d", (int)gpsData.Satellites);
-        write_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT - 40), APPLY_VDEADBAND(30), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND(GRAPHICS_RIGHT - 40), APPLY_VDEADBAND(30), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
 
         /* Print ADC voltage FLIGHT*/
         sprintf(temp, "V:%5.2fV", (double)(PIOS_ADC_PinGet(2) * 3 * 6.1f / 4096));
-        write_string(temp, APPLY_HDEADBAND(20), APPLY_VDEADBAND(20), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
+        osd_string(temp, APPLY_HDEADBAND(20), APPLY_VDEADBAND(20), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
 
         if (gpsData.Heading > 180) {
             calcHomeArrow((int16_t)(gpsData.Heading - 360));
@@ -2219,23 +2521,24 @@ void updateGraphics()
 
         /* Draw Attitude Indicator */
         if (OsdSettings.Attitude == OSDSETTINGS_ATTITUDE_ENABLED) {
-            drawAttitude(APPLY_HDEADBAND(OsdSettings.AttitudeSetup.X),
-                         APPLY_VDEADBAND(OsdSettings.AttitudeSetup.Y), attitude.Pitch, attitude.Roll, 96);
+            struct osd_attitude_args args = { APPLY_HDEADBAND(OsdSettings.AttitudeSetup.X),
+                                              APPLY_VDEADBAND(OsdSettings.AttitudeSetup.Y), attitude.Pitch, attitude.Roll, 96 };
+            osd_widget(osd_attitude_draw, &args, sizeof(args));
         }
-        // write_string("Hello OP-OSD", 60, 12, 1, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 0);
+        // osd_string("Hello OP-OSD", 60, 12, 1, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 0);
         // printText16( 60, 12,"Hello OP-OSD");
 
         char temp[50] =
         { 0 };
         memset(temp, ' ', 40);
         sprintf(temp, "Lat:%11.7f", (double)(gpsData.Latitude / 10000000.0f));
-        write_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(5), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(5), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
         sprintf(temp, "Lon:%11.7f", (double)(gpsData.Longitude / 10000000.0f));
-        write_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(15), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(15), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
         sprintf(temp, "Fix:%d", (int)gpsData.Status);
-        write_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(25), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(25), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
         sprintf(temp, "Sat:%d", (int)gpsData.Satellites);
-        write_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(35), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(35), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
 
         /* Print RTC time */
         if (OsdSettings.Time == OSDSETTINGS_TIME_ENABLED) {
@@ -2244,29 +2547,29 @@ void updateGraphics()
 
         /* Print Number of detected video Lines */
         sprintf(temp, "Lines:%4d", PIOS_Video_GetOSDLines());
-        write_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(5), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(5), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
 
         /* Print ADC voltage */
         // sprintf(temp,"Rssi:%4dV",(int)(PIOS_ADC_PinGet(4)*3000/4096));
-        // write_string(temp, (GRAPHICS_WIDTH_REAL - 2),15, 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        // osd_string(temp, (GRAPHICS_WIDTH_REAL - 2),15, 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
         sprintf(temp, "Rssi:%4.2fV", (double)(PIOS_ADC_PinGet(5) * 3.0f / 4096.0f));
-        write_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(15), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(15), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
 
         /* Print CPU temperature */
         sprintf(temp, "Temp:%4.2fC", (double)(PIOS_ADC_PinGet(3) * 0.29296875f - 264));
-        write_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(25), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(25), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
 
         /* Print ADC voltage FLIGHT*/
         sprintf(temp, "FltV:%4.2fV", (double)(PIOS_ADC_PinGet(2) * 3.0f * 6.1f / 4096.0f));
-        write_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(35), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(35), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
 
         /* Print ADC voltage VIDEO*/
         sprintf(temp, "VidV:%4.2fV", (double)(PIOS_ADC_PinGet(4) * 3.0f * 6.1f / 4096.0f));
-        write_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(45), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND((GRAPHICS_RIGHT - 8)), APPLY_VDEADBAND(45), 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
 
         /* Print ADC voltage RSSI */
         // sprintf(temp,"Curr:%4dA",(int)(PIOS_ADC_PinGet(0)*300*61/4096));
-        // write_string(temp, (GRAPHICS_WIDTH_REAL - 2),60, 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+        // osd_string(temp, (GRAPHICS_WIDTH_REAL - 2),60, 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
         /* Draw Battery Gauge */
         /*m_batt++;
            uint8_t dir=3;
@@ -2292,21 +2595,21 @@ void updateGraphics()
         // drawArrow(96,GRAPHICS_HEIGHT_REAL/2,angleB,32);
         // Draw airspeed (left side.)
         if (OsdSettings.Speed == OSDSETTINGS_SPEED_ENABLED) {
-            hud_draw_vertical_scale((int)gpsData.Groundspeed, 100, -1, APPLY_HDEADBAND(OsdSettings.SpeedSetup.X),
+            osd_vertical_scale((int)gpsData.Groundspeed, 100, -1, APPLY_HDEADBAND(OsdSettings.SpeedSetup.X),
                                     APPLY_VDEADBAND(OsdSettings.SpeedSetup.Y), 100, 10, 20, 7, 12, 15, 1000, HUD_VSCALE_FLAG_NO_NEGATIVE);
         }
         // Draw altimeter (right side.)
         if (OsdSettings.Altitude == OSDSETTINGS_ALTITUDE_ENABLED) {
-            hud_draw_vertical_scale((int)gpsData.Altitude, 200, +1, APPLY_HDEADBAND(OsdSettings.AltitudeSetup.X),
+            osd_vertical_scale((int)gpsData.Altitude, 200, +1, APPLY_HDEADBAND(OsdSettings.AltitudeSetup.X),
                                     APPLY_VDEADBAND(OsdSettings.AltitudeSetup.Y), 100, 20, 100, 7, 12, 15, 500, 0);
         }
         // Draw compass.
         if (OsdSettings.Heading == OSDSETTINGS_HEADING_ENABLED) {
             if (attitude.Yaw < 0) {
-                hud_draw_linear_compass(360 + attitude.Yaw, 150, 120, APPLY_HDEADBAND(OsdSettings.HeadingSetup.X),
+                osd_linear_compass(360 + attitude.Yaw, 150, 120, APPLY_HDEADBAND(OsdSettings.HeadingSetup.X),
                                         APPLY_VDEADBAND(OsdSettings.HeadingSetup.Y), 15, 30, 7, 12, 0);
             } else {
-                hud_draw_linear_compass(attitude.Yaw, 150, 120, APPLY_HDEADBAND(OsdSettings.HeadingSetup.X),
+                osd_linear_compass(attitude.Yaw, 150, 120, APPLY_HDEADBAND(OsdSettings.HeadingSetup.X),
                                         APPLY_VDEADBAND(OsdSettings.HeadingSetup.Y), 15, 30, 7, 12, 0);
             }
         }
@@ -2316,13 +2619,20 @@ void updateGraphics()
     {
         int size = 64;
         int x    = ((GRAPHICS_RIGHT / 2) - (size / 2)), y = (GRAPHICS_BOTTOM - size - 2);
-        draw_artificial_horizon(-attitude.Roll, attitude.Pitch, APPLY_HDEADBAND(x), APPLY_VDEADBAND(y), size);
-        hud_draw_vertical_scale((int)gpsData.Groundspeed, 20, +1, APPLY_HDEADBAND(GRAPHICS_RIGHT - (x - 1)), APPLY_VDEADBAND(y + (size / 2)), size, 5, 10, 4, 7,
+        struct osd_horizon_args horizon;
+        memset(&horizon, 0, sizeof(horizon));
+        horizon.angle = -attitude.Roll;
+        horizon.pitch = attitude.Pitch;
+        horizon.x     = APPLY_HDEADBAND(x);
+        horizon.y     = APPLY_VDEADBAND(y);
+        horizon.size  = size;
+        osd_widget(osd_horizon_draw, &horizon, sizeof(horizon));
+        osd_vertical_scale((int)gpsData.Groundspeed, 20, +1, APPLY_HDEADBAND(GRAPHICS_RIGHT - (x - 1)), APPLY_VDEADBAND(y + (size / 2)), size, 5, 10, 4, 7,
                                 10, 100, HUD_VSCALE_FLAG_NO_NEGATIVE);
         if (OsdSettings.AltitudeSource == OSDSETTINGS_ALTITUDESOURCE_BARO) {
-            hud_draw_vertical_scale((int)baro.Altitude, 50, -1, APPLY_HDEADBAND((x + size + 1)), APPLY_VDEADBAND(y + (size / 2)), size, 10, 20, 4, 7, 10, 500, 0);
+            osd_vertical_scale((int)baro.Altitude, 50, -1, APPLY_HDEADBAND((x + size + 1)), APPLY_VDEADBAND(y + (size / 2)), size, 10, 20, 4, 7, 10, 500, 0);
         } else {
-            hud_draw_vertical_scale((int)gpsData.Altitude, 50, -1, APPLY_HDEADBAND((x + size + 1)), APPLY_VDEADBAND(y + (size / 2)), size, 10, 20, 4, 7, 10, 500,
+            osd_vertical_scale((int)gpsData.Altitude, 50, -1, APPLY_HDEADBAND((x + size + 1)), APPLY_VDEADBAND(y + (size / 2)), size, 10, 20, 4, 7, 10, 500,
                                     0);
         }
 
@@ -2355,12 +2665,13 @@ void updateGraphics()
             sprintf(temp, "Mode: %d", status.FlightMode);
             break;
         }
-        write_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(5), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
+        osd_string(temp, APPLY_HDEADBAND(5), APPLY_VDEADBAND(5), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 2);
     }
     break;
     case 3:
     {
-        lamas();
+        // Moving every frame
+        osd_widget(osd_lamas_draw, NULL, 0);
     }
     break;
     case 4:
@@ -2371,26 +2682,31 @@ void updateGraphics()
         struct splashEntry splash_info;
         splash_info = splash[image];
 
-        copyimage(APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - (splash_info.width) / 2), APPLY_VDEADBAND(GRAPHICS_BOTTOM / 2 - (splash_info.height) / 2), image);
+        struct osd_image_args args = { APPLY_HDEADBAND(GRAPHICS_RIGHT / 2 - (splash_info.width) / 2), APPLY_VDEADBAND(GRAPHICS_BOTTOM / 2 - (splash_info.height) / 2), image };
+        osd_widget(osd_image_draw, &args, sizeof(args));
     }
     break;
     default:
-        write_vline_lm(APPLY_HDEADBAND(GRAPHICS_RIGHT / 2), APPLY_VDEADBAND(0), APPLY_VDEADBAND(GRAPHICS_BOTTOM), 1, 1);
-        write_hline_lm(APPLY_HDEADBAND(0), APPLY_HDEADBAND(GRAPHICS_RIGHT), APPLY_VDEADBAND(GRAPHICS_BOTTOM / 2), 1, 1);
+        // Static, without arguments
+        osd_widget(osd_crosshair_draw, &OsdSettings, 0);
         break;
     }
 
-    // Must mask out last half-word because SPI keeps clocking it out otherwise
-    for (uint32_t i = 0; i < 8; i++) {
-        write_vline(draw_buffer_level, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
-        write_vline(draw_buffer_mask, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
-    }
 }
 
 void updateOnceEveryFrame()
 {
-    clearGraphics();
+    PERF_TIMED_SECTION_START(counterRender);
     updateGraphics();
+    uint8_t drawn __attribute__((unused)) = osd_render();
+
+    // Must mask out last half-word because SPI keeps clocking it out otherwise
+    for (uint32_t i = 0; i < 8; i++) {
+        write_vline(draw_buffer_level, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
+        write_vline(draw_buffer_mask, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
+    }
+    PERF_TIMED_SECTION_END(counterRender);
+    PERF_TRACK_VALUE(counterDrawn, drawn);
 }
 
 // ****************
@@ -2406,6 +2722,8 @@ int32_t osdgenStart(void)
     vSemaphoreCreateBinary(osdSemaphore);
     xTaskCreate(osdgenTask, "OSDGEN", STACK_SIZE_BYTES / 4, NULL, TASK_PRIORITY, &osdgenTaskHandle);
     PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_OSDGEN, osdgenTaskHandle);
+    PERF_INIT_COUNTER(counterRender, 0x05D00001);
+    PERF_INIT_COUNTER(counterDrawn, 0x05D00002);
 #ifdef PIOS_INCLUDE_WDG
     PIOS_WDG_RegisterFlag(PIOS_WDG_OSDGEN);
 #endif
@@ -6,6 +6,8 @@
  * @brief Overo sync module
  * Starts a sync tasks  that watch event queues
  * and push to Overo spi port UAVobjects
+ * The objects are streamed on every update, or at the rate set for them in
+ * OveroSyncSettings, and the objects sent back by the companion are unpacked
  * @{
  *
  * @file       overosync.c
@@ -35,14 +37,21 @@
 #include "overosync.h"
 
 #include "hwsettings.h"
+#include "flightstatus.h"
+#include "overosyncsettings.h"
 #include "overosyncstats.h"
 #include "systemstats.h"
 #include "taskinfo.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE   200
-#define STACK_SIZE_BYTES 512
+#define STACK_SIZE_BYTES 768
 #define TASK_PRIORITY    (tskIDLE_PRIORITY + 0)
+#define RX_BUFFER_SIZE   64
+#define RX_POLL_MS       5    // Longest wait for an update before checking the receive buffer
+#define MAX_BURST_EVENTS 32   // Updates sent in a row before checking the receive buffer
+#define STATS_PERIOD_MS  1000
+#define PERIOD_NEVER     0xFFFF
 
 // Private types
 
@@ -51,11 +60,18 @@ static xQueueHandle queue;
 static UAVTalkConnection uavTalkCon;
 static xTaskHandle overoSyncTaskHandle;
 static bool overoEnabled;
+static volatile bool settingsUpdated;
+static OveroSyncSettingsData settings;
 
 // Private functions
 static void overoSyncTask(void *parameters);
 static int32_t packData(uint8_t *data, int32_t length);
+static int32_t reserveData(uint16_t length, UAVTalkOutputRegion regions[2]);
+static int32_t commitData(uint16_t length);
 static void registerObject(UAVObjHandle obj);
+static void settingsUpdatedCb(UAVObjEvent *ev);
+static bool streamEnabled(void);
+static void receiveData(void);
 
 // External variables
 extern uint32_t pios_com_overo_id;
@@ -65,7 +81,7 @@ struct overosync {
     uint32_t sent_bytes;
     uint32_t sent_objects;
     uint32_t failed_objects;
-    uint32_t received_objects;
+    uint32_t received_bytes;
 };
 
 struct overosync *overosync;
@@ -87,21 +103,22 @@ int32_t OveroSyncInitialize(void)
 
     if (optionalModules[HWSETTINGS_OPTIONALMODULES_OVERO] == HWSETTINGS_OPTIONALMODULES_ENABLED) {
         overoEnabled = true;
-
-        // Create object queues
-        queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
     } else {
         overoEnabled = false;
         return -1;
     }
 #endif
 
+    // Create object queues
+    queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 
+    OveroSyncSettingsInitialize();
     OveroSyncStatsInitialize();
 
 
-    // Initialise UAVTalk
+    // Initialise UAVTalk, the packets are written straight to the COM buffer when it can
     uavTalkCon = UAVTalkInitialize(&packData);
+    UAVTalkSetOutputBuffer(uavTalkCon, &reserveData, &commitData);
 
     return 0;
 }
@@ -126,7 +143,9 @@ int32_t OveroSyncStart(void)
     overosync->sent_bytes = 0;
 
     // Process all registered objects and connect queue for updates
+    OveroSyncSettingsGet(&settings);
     UAVObjIterate(&registerObject);
+    OveroSyncSettingsConnectCallback(&settingsUpdatedCb);
 
     // Start overosync tasks
     xTaskCreate(overoSyncTask, (signed char *)"OveroSync", STACK_SIZE_BYTES / 4, NULL, TASK_PRIORITY, &overoSyncTaskHandle);
@@ -140,63 +159,134 @@ MODULE_INITCALL(OveroSyncInitialize, OveroSyncStart);
 
 /**
  * Register a new object, adds object to local list and connects the queue depending on the object's
- * telemetry settings.
+ * stream period in the settings.  Connecting again only updates the mask and period.
  * \param[in] obj Object to connect
  */
 static void registerObject(UAVObjHandle obj)
 {
     int32_t eventMask;
+    uint16_t period = 0;
+    uint32_t objId  = UAVObjGetID(obj);
+
+    for (uint8_t i = 0; i < OVEROSYNCSETTINGS_STREAMOBJECTID_NUMELEM; i++) {
+        if (settings.StreamObjectID[i] == objId && objId != 0) {
+            period = settings.StreamPeriod[i];
+            break;
+        }
+    }
 
     eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
     if (UAVObjIsMetaobject(obj)) {
         eventMask |= EV_UNPACKED; // we also need to act on remote updates (unpack events)
     }
-    UAVObjConnectQueue(obj, queue, eventMask);
+    if (period == PERIOD_NEVER) {
+        // Disconnecting is not safe while the object is updated, let no event through instead
+        eventMask = 0;
+        period    = 0;
+    }
+    UAVObjConnectQueueThrottled(obj, queue, eventMask, period);
+}
+
+/**
+ * Called when the settings change, the queue is connected again by the task
+ */
+static void settingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    settingsUpdated = true;
+}
+
+/**
+ * Whether the updates are streamed now, as set by LogOn
+ */
+static bool streamEnabled(void)
+{
+    switch (settings.LogOn) {
+    case OVEROSYNCSETTINGS_LOGON_ALWAYS:
+        return true;
+
+    case OVEROSYNCSETTINGS_LOGON_ARMED:
+    {
+        uint8_t armed;
+        FlightStatusArmedGet(&armed);
+        return armed == FLIGHTSTATUS_ARMED_ARMED;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * Unpack all the objects the companion sent since the last call
+ */
+static void receiveData(void)
+{
+    uint8_t serial_data[RX_BUFFER_SIZE];
+    uint16_t bytes_to_process;
+
+    while ((bytes_to_process = PIOS_COM_ReceiveBuffer(pios_com_overo_id, serial_data, sizeof(serial_data), 0)) > 0) {
+        overosync->received_bytes += bytes_to_process;
+        UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
+    }
 }
 
 /**
  * Telemetry transmit task, regular priority
  *
- * Logic: We need to double buffer the DMA transfers.  Pack the buffer until either
- * 1) it is full (and then we should record the number of missed events then)
- * 2) the current transaction is done (we should immediately schedule since we are slave)
- * when done packing the buffer we should call PIOS_SPI_TransferBlock, change the active buffer
- * and then take the semaphrore
+ * Logic: The packets are written into the COM buffer, and the driver moves as much
+ * of it as fits in each SPI frame when the DMA swaps buffers.  All the queued updates
+ * are sent in a burst, so the frames fill up, and the receive buffer is checked in
+ * between the bursts or every RX_POLL_MS when idle.
  */
 static void overoSyncTask(__attribute__((unused)) void *parameters)
 {
     UAVObjEvent ev;
 
     // Kick off SPI transfers (once one is completed another will automatically transmit)
-    overosync->sent_objects     = 0;
-    overosync->failed_objects   = 0;
-    overosync->received_objects = 0;
+    overosync->sent_objects   = 0;
+    overosync->failed_objects = 0;
+    overosync->received_bytes = 0;
 
     portTickType lastUpdateTime = xTaskGetTickCount();
     portTickType updateTime;
 
     // Loop forever
     while (1) {
+        if (settingsUpdated) {
+            settingsUpdated = false;
+            OveroSyncSettingsGet(&settings);
+            UAVObjIterate(&registerObject);
+        }
+
         // Wait for queue message
-        if (xQueueReceive(queue, &ev, portMAX_DELAY) == pdTRUE) {
-            // Process event.  This calls transmitData
-            UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
-
-            updateTime = xTaskGetTickCount();
-            if (((portTickType)(updateTime - lastUpdateTime)) > 1000) {
-                // Update stats.  This will trigger a local send event too
-                OveroSyncStatsData syncStats;
-                syncStats.Send            = overosync->sent_bytes;
-                syncStats.Connected       = syncStats.Send > 500 ? OVEROSYNCSTATS_CONNECTED_TRUE : OVEROSYNCSTATS_CONNECTED_FALSE;
-                syncStats.DroppedUpdates  = overosync->failed_objects;
-                syncStats.Packets         = PIOS_OVERO_GetPacketCount(pios_overo_id);
-                OveroSyncStatsSet(&syncStats);
-                overosync->failed_objects = 0;
-                overosync->sent_bytes     = 0;
-                lastUpdateTime            = updateTime;
-            }
-
-            // TODO: Check the receive buffer
+        if (xQueueReceive(queue, &ev, RX_POLL_MS) == pdTRUE) {
+            bool stream = streamEnabled();
+            uint8_t burst = 0;
+            do {
+                // Process event.  This calls reserveData and commitData
+                if (stream) {
+                    UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
+                }
+            } while (++burst < MAX_BURST_EVENTS && xQueueReceive(queue, &ev, 0) == pdTRUE);
+        }
+
+        receiveData();
+
+        updateTime = xTaskGetTickCount();
+        if (((portTickType)(updateTime - lastUpdateTime)) > STATS_PERIOD_MS) {
+            // Update stats.  This will trigger a local send event too
+            OveroSyncStatsData syncStats;
+            OveroSyncStatsGet(&syncStats);
+            syncStats.Send            = overosync->sent_bytes;
+            syncStats.Received        = overosync->received_bytes;
+            syncStats.Connected       = syncStats.Send > 500 ? OVEROSYNCSTATS_CONNECTED_TRUE : OVEROSYNCSTATS_CONNECTED_FALSE;
+            syncStats.DroppedUpdates  = overosync->failed_objects;
+            syncStats.FramesyncErrors = PIOS_OVERO_GetFramingErrors(pios_overo_id);
+            syncStats.Packets         = PIOS_OVERO_GetPacketCount(pios_overo_id);
+            OveroSyncStatsSet(&syncStats);
+            overosync->failed_objects = 0;
+            overosync->sent_bytes     = 0;
+            overosync->received_bytes = 0;
+            lastUpdateTime            = updateTime;
         }
     }
 }
@@ -223,6 +313,44 @@ fail:
     return -1;
 }
 
+/**
+ * Reserve space for a packet in the COM buffer to the Overo.
+ * \param[in] length Length of the packet
+ * \param[out] regions Space to write the packet to
+ * \return 0 on success
+ * \return negative on failure, the update is counted as dropped
+ */
+static int32_t reserveData(uint16_t length, UAVTalkOutputRegion regions[2])
+{
+    struct pios_com_iovec iov[2];
+
+    if (PIOS_COM_TxReserve(pios_com_overo_id, length, iov) != 0) {
+        overosync->failed_objects++;
+        return -1;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        regions[i].data   = iov[i].data;
+        regions[i].length = iov[i].len;
+    }
+    return 0;
+}
+
+/**
+ * Send the packet written in the space reserved by reserveData().
+ * \param[in] length Length of the packet, 0 to cancel
+ * \return 0 on success
+ * \return -1 on failure
+ */
+static int32_t commitData(uint16_t length)
+{
+    if (PIOS_COM_TxCommit(pios_com_overo_id, length) != 0) {
+        return -1;
+    }
+    overosync->sent_bytes += length;
+    overosync->sent_objects++;
+    return 0;
+}
+
 /**
  * @}
  * @}
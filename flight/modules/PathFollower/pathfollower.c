@@ -54,6 +54,7 @@
 #include <sin_lookup.h>
 #include <pathdesired.h>
 #include <paths.h>
+#include <rategovernor.h>
 #include <sanitycheck.h>
 
 
@@ -107,6 +108,7 @@ static uint32_t updatePeriod = PF_IDLE_UPDATE_RATE_MS;
 static struct Globals global;
 static PathStatusData pathStatus;
 static PathDesiredData pathDesired;
+static struct path_segment pathSegment; // geometry of pathDesired, compiled when it changes
 static FixedWingPathFollowerSettingsData fixedWingPathFollowerSettings;
 static VtolPathFollowerSettingsData vtolPathFollowerSettings;
 
@@ -158,6 +160,7 @@ int32_t PathFollowerInitialize()
     FixedWingPathFollowerSettingsInitialize();
     FixedWingPathFollowerStatusInitialize();
     VtolPathFollowerSettingsInitialize();
+    RateGovernorInitialize();
     FlightStatusInitialize();
     PathStatusInitialize();
     PathDesiredInitialize();
@@ -259,6 +262,7 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     pid_configure(&global.PIDvel[2], vtolPathFollowerSettings.VerticalVelPID.Kp, vtolPathFollowerSettings.VerticalVelPID.Ki, vtolPathFollowerSettings.VerticalVelPID.Kd, vtolPathFollowerSettings.VerticalVelPID.ILimit);
 
     PathDesiredGet(&pathDesired);
+    path_compile(&pathDesired, &pathSegment);
 }
 
 
@@ -307,6 +311,14 @@ static void resetGlobals()
 
 static uint8_t updateAutoPilotByFrameType()
 {
+    // the period is stretched while the cpu is overloaded, the loops derive dT from it
+    uint8_t rateDivider;
+
+    RateGovernorDividerGet(&rateDivider);
+    if (rateDivider == 0) {
+        rateDivider = 1;
+    }
+
     FrameType_t frameType = GetCurrentFrameType();
 
     if (frameType == FRAME_TYPE_CUSTOM || frameType == FRAME_TYPE_GROUND) {
@@ -322,13 +334,13 @@ static uint8_t updateAutoPilotByFrameType()
     switch (frameType) {
     case FRAME_TYPE_MULTIROTOR:
     case FRAME_TYPE_HELI:
-        updatePeriod = vtolPathFollowerSettings.UpdatePeriod;
+        updatePeriod = vtolPathFollowerSettings.UpdatePeriod * rateDivider;
         return updateAutoPilotVtol();
 
         break;
     case FRAME_TYPE_FIXED_WING:
     default:
-        updatePeriod = fixedWingPathFollowerSettings.UpdatePeriod;
+        updatePeriod = fixedWingPathFollowerSettings.UpdatePeriod * rateDivider;
         return updateAutoPilotFixedWing();
 
         break;
@@ -478,7 +490,7 @@ static float updatePathBearing()
                      positionState.Down };
     struct path_status progress;
 
-    path_progress(&pathDesired, cur, &progress);
+    path_segment_progress(&pathSegment, cur, &progress);
 
     // atan2f always returns in between + and - 180 degrees
     return RAD2DEG(atan2f(progress.path_vector[1], progress.path_vector[0]));
@@ -591,6 +603,7 @@ static void processPOI()
             pathDesired.StartingVelocity = 1.0f;
             pathDesired.EndingVelocity   = 0.0f;
             pathDesired.Mode = PATHDESIRED_MODE_FLYENDPOINT;
+            path_compile(&pathDesired, &pathSegment);
             PathDesiredSet(&pathDesired);
         }
     }
@@ -626,7 +639,7 @@ static void updatePathVelocity(float kFF, bool limited)
                        positionState.Down + (velocityState.Down * kFF) };
     struct path_status progress;
 
-    path_progress(&pathDesired, cur, &progress);
+    path_segment_progress(&pathSegment, cur, &progress);
 
     // calculate velocity - can be zero if waypoints are too close
     VelocityDesiredData velocityDesired;
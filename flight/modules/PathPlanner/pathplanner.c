@@ -54,14 +54,36 @@
 
 // Private types
 
+// Waypoint of the compiled path plan
+typedef struct {
+    float   Position[3]; // North, East, Down
+    float   Velocity;
+    float   NextBearing; // direction of the leg to the next waypoint, atan2(North, East) in rad
+    uint8_t Action;
+} PlanWaypoint;
+
+// Path plan compiled from the Waypoint and PathAction instances, rebuilt when they change
+typedef struct {
+    PlanWaypoint   *waypoints;
+    PathActionData *actions;
+    uint16_t waypointCount;
+    uint16_t actionCount;
+    uint16_t waypointCapacity;
+    uint16_t actionCapacity;
+    bool     valid;
+} Plan;
+
 // Private functions
 static void pathPlannerTask();
 static void commandUpdated(UAVObjEvent *ev);
 static void statusUpdated(UAVObjEvent *ev);
+static void pathDesiredUpdated(UAVObjEvent *ev);
 static void updatePathDesired();
 static void setWaypoint(uint16_t num);
+static void planUpdated(UAVObjEvent *ev);
 
 static uint8_t checkPathPlan();
+static uint8_t compilePathPlan();
 static uint8_t pathConditionCheck();
 static uint8_t conditionNone();
 static uint8_t conditionTimeOut();
@@ -79,9 +101,13 @@ static uint8_t conditionImmediate();
 static DelayedCallbackInfo *pathPlannerHandle;
 static DelayedCallbackInfo *pathDesiredUpdaterHandle;
 static WaypointActiveData waypointActive;
-static WaypointData waypoint;
-static PathActionData pathAction;
+static const PlanWaypoint *waypoint;
+static const PathActionData *pathAction;
 static bool pathplanner_active = false;
+static Plan plan;
+static volatile bool planChanged = true;
+static struct path_segment pathSegment; // geometry of PathDesired for the condition checks
+static volatile bool pathDesiredChanged = true;
 
 
 /**
@@ -91,10 +117,12 @@ int32_t PathPlannerStart()
 {
     plan_initialize();
     // when the active waypoint changes, update pathDesired
-    WaypointConnectCallback(commandUpdated);
+    WaypointConnectCallback(planUpdated);
     WaypointActiveConnectCallback(commandUpdated);
-    PathActionConnectCallback(commandUpdated);
+    PathActionConnectCallback(planUpdated);
+    PathPlanConnectCallback(planUpdated);
     PathStatusConnectCallback(statusUpdated);
+    PathDesiredConnectFastCallback(pathDesiredUpdated);
 
     // Start main task callback
     PIOS_CALLBACKSCHEDULER_Dispatch(pathPlannerHandle);
@@ -157,6 +185,11 @@ static void pathPlannerTask()
 
     PathDesiredData pathDesired;
     PathDesiredGet(&pathDesired);
+    if (pathDesiredChanged) {
+        // clear first, a change during the compilation is picked up on the next run
+        pathDesiredChanged = false;
+        path_compile(&pathDesired, &pathSegment);
+    }
 
     static uint8_t failsafeRTHset = 0;
     if (!validPathPlan) {
@@ -191,8 +224,12 @@ static void pathPlannerTask()
         return;
     }
 
-    WaypointInstGet(waypointActive.Index, &waypoint);
-    PathActionInstGet(waypoint.Action, &pathAction);
+    if (waypointActive.Index >= plan.waypointCount) {
+        setWaypoint(waypointActive.Index);
+        return;
+    }
+    waypoint   = &plan.waypoints[waypointActive.Index];
+    pathAction = &plan.actions[waypoint->Action];
     PathStatusData pathStatus;
     PathStatusGet(&pathStatus);
 
@@ -202,15 +239,15 @@ static void pathPlannerTask()
     }
 
     // negative destinations DISABLE this feature
-    if (pathStatus.Status == PATHSTATUS_STATUS_CRITICAL && waypointActive.Index != pathAction.ErrorDestination && pathAction.ErrorDestination >= 0) {
-        setWaypoint(pathAction.ErrorDestination);
+    if (pathStatus.Status == PATHSTATUS_STATUS_CRITICAL && waypointActive.Index != pathAction->ErrorDestination && pathAction->ErrorDestination >= 0) {
+        setWaypoint(pathAction->ErrorDestination);
         return;
     }
 
     // check if condition has been met
     endCondition = pathConditionCheck();
     // decide what to do
-    switch (pathAction.Command) {
+    switch (pathAction->Command) {
     case PATHACTION_COMMAND_ONNOTCONDITIONNEXTWAYPOINT:
         endCondition = !endCondition;
     case PATHACTION_COMMAND_ONCONDITIONNEXTWAYPOINT:
@@ -222,21 +259,21 @@ static void pathPlannerTask()
         endCondition = !endCondition;
     case PATHACTION_COMMAND_ONCONDITIONJUMPWAYPOINT:
         if (endCondition) {
-            if (pathAction.JumpDestination < 0) {
+            if (pathAction->JumpDestination < 0) {
                 // waypoint ids <0 code relative jumps
-                setWaypoint(waypointActive.Index - pathAction.JumpDestination);
+                setWaypoint(waypointActive.Index - pathAction->JumpDestination);
             } else {
-                setWaypoint(pathAction.JumpDestination);
+                setWaypoint(pathAction->JumpDestination);
             }
         }
         break;
     case PATHACTION_COMMAND_IFCONDITIONJUMPWAYPOINTELSENEXTWAYPOINT:
         if (endCondition) {
-            if (pathAction.JumpDestination < 0) {
+            if (pathAction->JumpDestination < 0) {
                 // waypoint ids <0 code relative jumps
-                setWaypoint(waypointActive.Index - pathAction.JumpDestination);
+                setWaypoint(waypointActive.Index - pathAction->JumpDestination);
             } else {
-                setWaypoint(pathAction.JumpDestination);
+                setWaypoint(pathAction->JumpDestination);
             }
         } else {
             setWaypoint(waypointActive.Index + 1);
@@ -245,8 +282,18 @@ static void pathPlannerTask()
     }
 }
 
-// safety checks for path plan integrity
+// safety checks for path plan integrity, the plan is compiled again only after it changed
 static uint8_t checkPathPlan()
+{
+    if (planChanged) {
+        planChanged = false;
+        plan.valid  = compilePathPlan();
+    }
+    return plan.valid;
+}
+
+// copy the path plan into the compiled plan and check it
+static uint8_t compilePathPlan()
 {
     uint16_t i;
     uint16_t waypointCount;
@@ -254,8 +301,8 @@ static uint8_t checkPathPlan()
     uint8_t pathCrc;
     PathPlanData pathPlan;
 
-    // WaypointData waypoint; // using global instead (?)
-    // PathActionData action; // using global instead (?)
+    plan.waypointCount = 0;
+    plan.actionCount   = 0;
 
     PathPlanGet(&pathPlan);
 
@@ -290,39 +337,86 @@ static uint8_t checkPathPlan()
         return false;
     }
 
+    // make room, instances are never deleted so the plan does not shrink often
+    if (waypointCount > plan.waypointCapacity) {
+        if (plan.waypoints) {
+            pios_free(plan.waypoints);
+        }
+        plan.waypoints = (PlanWaypoint *)pios_malloc(waypointCount * sizeof(PlanWaypoint));
+        plan.waypointCapacity = plan.waypoints ? waypointCount : 0;
+    }
+    if (actionCount > plan.actionCapacity) {
+        if (plan.actions) {
+            pios_free(plan.actions);
+        }
+        plan.actions = (PathActionData *)pios_malloc(actionCount * sizeof(PathActionData));
+        plan.actionCapacity = plan.actions ? actionCount : 0;
+    }
+    if (waypointCount > plan.waypointCapacity || actionCount > plan.actionCapacity) {
+        // out of memory
+        return false;
+    }
+
     // waypoint consistency
     for (i = 0; i < waypointCount; i++) {
-        WaypointInstGet(i, &waypoint);
-        if (waypoint.Action >= actionCount) {
+        WaypointData waypointData;
+        WaypointInstGet(i, &waypointData);
+        if (waypointData.Action >= actionCount) {
             // path action id is out of range
             return false;
         }
+        plan.waypoints[i].Position[0] = waypointData.Position.North;
+        plan.waypoints[i].Position[1] = waypointData.Position.East;
+        plan.waypoints[i].Position[2] = waypointData.Position.Down;
+        plan.waypoints[i].Velocity    = waypointData.Velocity;
+        plan.waypoints[i].Action = waypointData.Action;
+    }
+    // the plan wraps around after the last waypoint
+    for (i = 0; i < waypointCount; i++) {
+        const PlanWaypoint *next = &plan.waypoints[(i + 1 < waypointCount) ? i + 1 : 0];
+        plan.waypoints[i].NextBearing = atan2f(next->Position[0] - plan.waypoints[i].Position[0],
+                                               next->Position[1] - plan.waypoints[i].Position[1]);
     }
 
     // path action consistency
     for (i = 0; i < actionCount; i++) {
-        PathActionInstGet(i, &pathAction);
-        if (pathAction.ErrorDestination >= waypointCount) {
+        PathActionInstGet(i, &plan.actions[i]);
+        if (plan.actions[i].ErrorDestination >= waypointCount) {
             // waypoint id is out of range
             return false;
         }
-        if (pathAction.JumpDestination >= waypointCount) {
+        if (plan.actions[i].JumpDestination >= waypointCount) {
             // waypoint id is out of range
             return false;
         }
     }
 
     // path plan passed checks
+    plan.waypointCount = waypointCount;
+    plan.actionCount   = actionCount;
 
     return true;
 }
 
+// callback function when the path plan changed in any way, recompile it and update pathDesired
+void planUpdated(__attribute__((unused)) UAVObjEvent *ev)
+{
+    planChanged = true;
+    PIOS_CALLBACKSCHEDULER_Dispatch(pathDesiredUpdaterHandle);
+}
+
 // callback function when status changed, issue execution of state machine
 void commandUpdated(__attribute__((unused)) UAVObjEvent *ev)
 {
     PIOS_CALLBACKSCHEDULER_Dispatch(pathDesiredUpdaterHandle);
 }
 
+// callback function when pathDesired changed, recompile its geometry on the next run
+void pathDesiredUpdated(__attribute__((unused)) UAVObjEvent *ev)
+{
+    pathDesiredChanged = true;
+}
+
 // callback function when waypoints changed in any way, update pathDesired
 void statusUpdated(__attribute__((unused)) UAVObjEvent *ev)
 {
@@ -343,18 +437,22 @@ void updatePathDesired()
     // find out current waypoint
     WaypointActiveGet(&waypointActive);
 
-    WaypointInstGet(waypointActive.Index, &waypoint);
-    PathActionInstGet(waypoint.Action, &pathAction);
-
-    pathDesired.End.North = waypoint.Position.North;
-    pathDesired.End.East  = waypoint.Position.East;
-    pathDesired.End.Down  = waypoint.Position.Down;
-    pathDesired.EndingVelocity    = waypoint.Velocity;
-    pathDesired.Mode = pathAction.Mode;
-    pathDesired.ModeParameters[0] = pathAction.ModeParameters[0];
-    pathDesired.ModeParameters[1] = pathAction.ModeParameters[1];
-    pathDesired.ModeParameters[2] = pathAction.ModeParameters[2];
-    pathDesired.ModeParameters[3] = pathAction.ModeParameters[3];
+    // the plan may have changed since the last pathPlannerTask run
+    if (!checkPathPlan() || waypointActive.Index >= plan.waypointCount) {
+        return;
+    }
+    waypoint   = &plan.waypoints[waypointActive.Index];
+    pathAction = &plan.actions[waypoint->Action];
+
+    pathDesired.End.North = waypoint->Position[0];
+    pathDesired.End.East  = waypoint->Position[1];
+    pathDesired.End.Down  = waypoint->Position[2];
+    pathDesired.EndingVelocity    = waypoint->Velocity;
+    pathDesired.Mode = pathAction->Mode;
+    pathDesired.ModeParameters[0] = pathAction->ModeParameters[0];
+    pathDesired.ModeParameters[1] = pathAction->ModeParameters[1];
+    pathDesired.ModeParameters[2] = pathAction->ModeParameters[2];
+    pathDesired.ModeParameters[3] = pathAction->ModeParameters[3];
     pathDesired.UID = waypointActive.Index;
 
     if (waypointActive.Index == 0) {
@@ -371,13 +469,12 @@ void updatePathDesired()
         pathDesired.StartingVelocity = pathDesired.EndingVelocity;
     } else {
         // Get previous waypoint as start point
-        WaypointData waypointPrev;
-        WaypointInstGet(waypointActive.Index - 1, &waypointPrev);
+        const PlanWaypoint *waypointPrev = &plan.waypoints[waypointActive.Index - 1];
 
-        pathDesired.Start.North = waypointPrev.Position.North;
-        pathDesired.Start.East  = waypointPrev.Position.East;
-        pathDesired.Start.Down  = waypointPrev.Position.Down;
-        pathDesired.StartingVelocity = waypointPrev.Velocity;
+        pathDesired.Start.North = waypointPrev->Position[0];
+        pathDesired.Start.East  = waypointPrev->Position[1];
+        pathDesired.Start.Down  = waypointPrev->Position[2];
+        pathDesired.StartingVelocity = waypointPrev->Velocity;
     }
     PathDesiredSet(&pathDesired);
 }
@@ -385,12 +482,8 @@ void updatePathDesired()
 // helper function to go to a specific waypoint
 static void setWaypoint(uint16_t num)
 {
-    PathPlanData pathPlan;
-
-    PathPlanGet(&pathPlan);
-
     // here it is assumed that the path plan has been validated (waypoint count is consistent)
-    if (num >= pathPlan.WaypointCount) {
+    if (num >= plan.waypointCount) {
         // path plans wrap around
         num = 0;
     }
@@ -403,7 +496,7 @@ static void setWaypoint(uint16_t num)
 static uint8_t pathConditionCheck()
 {
     // i thought about a lookup table, but a switch is safer considering there could be invalid EndCondition ID's
-    switch (pathAction.EndCondition) {
+    switch (pathAction->EndCondition) {
     case PATHACTION_ENDCONDITION_NONE:
         return conditionNone();
 
@@ -472,7 +565,7 @@ static uint8_t conditionTimeOut()
         toWaypoint  = waypointActive.Index;
         toStarttime = PIOS_DELAY_GetRaw();
     }
-    if (PIOS_DELAY_DiffuS(toStarttime) >= 1e6f * pathAction.ConditionParameters[0]) {
+    if (PIOS_DELAY_DiffuS(toStarttime) >= 1e6f * pathAction->ConditionParameters[0]) {
         // make sure we reinitialize even if the same waypoint comes twice
         toWaypoint = 0xFFFF;
         return true;
@@ -492,16 +585,16 @@ static uint8_t conditionDistanceToTarget()
     PositionStateData positionState;
 
     PositionStateGet(&positionState);
-    if (pathAction.ConditionParameters[1] > 0.5f) {
-        distance = sqrtf(powf(waypoint.Position.North - positionState.North, 2)
-                         + powf(waypoint.Position.East - positionState.East, 2)
-                         + powf(waypoint.Position.Down - positionState.Down, 2));
+    if (pathAction->ConditionParameters[1] > 0.5f) {
+        distance = sqrtf(powf(waypoint->Position[0] - positionState.North, 2)
+                         + powf(waypoint->Position[1] - positionState.East, 2)
+                         + powf(waypoint->Position[2] - positionState.Down, 2));
     } else {
-        distance = sqrtf(powf(waypoint.Position.North - positionState.North, 2)
-                         + powf(waypoint.Position.East - positionState.East, 2));
+        distance = sqrtf(powf(waypoint->Position[0] - positionState.North, 2)
+                         + powf(waypoint->Position[1] - positionState.East, 2));
     }
 
-    if (distance <= pathAction.ConditionParameters[0]) {
+    if (distance <= pathAction->ConditionParameters[0]) {
         return true;
     }
     return false;
@@ -515,18 +608,15 @@ static uint8_t conditionDistanceToTarget()
  */
 static uint8_t conditionLegRemaining()
 {
-    PathDesiredData pathDesired;
     PositionStateData positionState;
 
-    PathDesiredGet(&pathDesired);
     PositionStateGet(&positionState);
 
     float cur[3] = { positionState.North, positionState.East, positionState.Down };
     struct path_status progress;
 
-    path_progress(&pathDesired,
-                  cur, &progress);
-    if (progress.fractional_progress >= 1.0f - pathAction.ConditionParameters[0]) {
+    path_segment_progress(&pathSegment, cur, &progress);
+    if (progress.fractional_progress >= 1.0f - pathAction->ConditionParameters[0]) {
         return true;
     }
     return false;
@@ -539,18 +629,15 @@ static uint8_t conditionLegRemaining()
  */
 static uint8_t conditionBelowError()
 {
-    PathDesiredData pathDesired;
     PositionStateData positionState;
 
-    PathDesiredGet(&pathDesired);
     PositionStateGet(&positionState);
 
     float cur[3] = { positionState.North, positionState.East, positionState.Down };
     struct path_status progress;
 
-    path_progress(&pathDesired,
-                  cur, &progress);
-    if (progress.error <= pathAction.ConditionParameters[0]) {
+    path_segment_progress(&pathSegment, cur, &progress);
+    if (progress.error <= pathAction->ConditionParameters[0]) {
         return true;
     }
     return false;
@@ -568,7 +655,7 @@ static uint8_t conditionAboveAltitude()
 
     PositionStateGet(&positionState);
 
-    if (positionState.Down <= pathAction.ConditionParameters[0]) {
+    if (positionState.Down <= pathAction->ConditionParameters[0]) {
         return true;
     }
     return false;
@@ -588,13 +675,13 @@ static uint8_t conditionAboveSpeed()
     float velocity = sqrtf(velocityState.North * velocityState.North + velocityState.East * velocityState.East + velocityState.Down * velocityState.Down);
 
     // use airspeed if requested and available
-    if (pathAction.ConditionParameters[1] > 0.5f) {
+    if (pathAction->ConditionParameters[1] > 0.5f) {
         AirspeedStateData airspeed;
         AirspeedStateGet(&airspeed);
         velocity = airspeed.CalibratedAirspeed;
     }
 
-    if (velocity >= pathAction.ConditionParameters[0]) {
+    if (velocity >= pathAction->ConditionParameters[0]) {
         return true;
     }
     return false;
@@ -610,15 +697,7 @@ static uint8_t conditionAboveSpeed()
  */
 static uint8_t conditionPointingTowardsNext()
 {
-    uint16_t nextWaypointId = waypointActive.Index + 1;
-
-    if (nextWaypointId >= UAVObjGetNumInstances(WaypointHandle())) {
-        nextWaypointId = 0;
-    }
-    WaypointData nextWaypoint;
-    WaypointInstGet(nextWaypointId, &nextWaypoint);
-
-    float angle1 = atan2f((nextWaypoint.Position.North - waypoint.Position.North), (nextWaypoint.Position.East - waypoint.Position.East));
+    float angle1 = waypoint->NextBearing;
 
     VelocityStateData velocity;
     VelocityStateGet(&velocity);
@@ -630,7 +709,7 @@ static uint8_t conditionPointingTowardsNext()
         angle1 -= 360;
     }
 
-    if (angle1 <= pathAction.ConditionParameters[0]) {
+    if (angle1 <= pathAction->ConditionParameters[0]) {
         return true;
     }
     return false;
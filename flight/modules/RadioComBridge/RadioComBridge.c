@@ -57,12 +57,28 @@
 #define EVENT_QUEUE_SIZE  10
 #define MAX_PORT_DELAY    200
 #define SERIAL_RX_BUF_LEN 100
+#define UAVTALK_BUF_LEN   64
 #define PPM_INPUT_TIMEOUT 100
+#define RELAY_FILTERS     OPLINKSETTINGS_RELAYFILTEROBJID_NUMELEM
 
 
 // ****************
 // Private types
 
+// Relay direction, the filters keep the time of the last relayed update per direction
+typedef enum {
+    RELAY_TO_RADIO = 0,
+    RELAY_TO_TELEMETRY,
+    RELAY_DIRECTIONS
+} RelayDirection;
+
+// A relayed object whose updates are thinned or dropped
+typedef struct {
+    uint32_t     objId;
+    portTickType period; // 0 drops all updates
+    portTickType lastRelay[RELAY_DIRECTIONS];
+} RelayFilter;
+
 typedef struct {
     // The task handles.
     xTaskHandle telemetryTxTaskHandle;
@@ -82,6 +98,9 @@ typedef struct {
 
     // The raw serial Rx buffer
     uint8_t  serialRxBuf[SERIAL_RX_BUF_LEN];
+    // The UAVTalk Rx buffers of the radio and telemetry ports
+    uint8_t  radioRxBuf[UAVTALK_BUF_LEN];
+    uint8_t  telemRxBuf[UAVTALK_BUF_LEN];
 
     // Error statistics.
     uint32_t telemetryTxRetries;
@@ -95,6 +114,10 @@ typedef struct {
 
     // The current configured uart speed
     OPLinkSettingsComSpeedOptions comSpeed;
+
+    // The relay filters, sorted by object ID
+    RelayFilter  relayFilters[RELAY_FILTERS];
+    uint8_t      numRelayFilters;
 } RadioComBridgeData;
 
 // ****************
@@ -108,8 +131,10 @@ static void radioRxTask(void *parameters);
 static void PPMInputTask(void *parameters);
 static int32_t UAVTalkSendHandler(uint8_t *buf, int32_t length);
 static int32_t RadioSendHandler(uint8_t *buf, int32_t length);
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte);
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte);
+static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *rxbuffer, uint16_t length);
+static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *rxbuffer, uint16_t length);
+static void relayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *frame, uint16_t frameLength, RelayDirection direction);
+static void loadRelayFilters(const OPLinkSettingsData *oplinkSettings);
 static void objectPersistenceUpdatedCb(UAVObjEvent *objEv);
 static void registerObject(UAVObjHandle obj);
 
@@ -138,6 +163,8 @@ static int32_t RadioComBridgeStart(void)
                                (oplinkSettings.FlexiPort != OPLINKSETTINGS_FLEXIPORT_SERIAL) &&
                                (oplinkSettings.VCPPort != OPLINKSETTINGS_VCPPORT_SERIAL));
 
+        loadRelayFilters(&oplinkSettings);
+
         // Set the maximum radio RF power.
         switch (oplinkSettings.MaxRFPower) {
         case OPLINKSETTINGS_MAXRFPOWER_125:
@@ -403,14 +430,12 @@ static void radioRxTask(__attribute__((unused)) void *parameters)
         PIOS_WDG_UpdateFlag(PIOS_WDG_RADIORX);
 #endif
         if (PIOS_COM_RADIO) {
-            uint8_t serial_data[1];
-            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(PIOS_COM_RADIO, serial_data, sizeof(serial_data), MAX_PORT_DELAY);
+            uint8_t *serial_data = data->radioRxBuf;
+            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(PIOS_COM_RADIO, serial_data, sizeof(data->radioRxBuf), MAX_PORT_DELAY);
             if (bytes_to_process > 0) {
                 if (data->parseUAVTalk) {
                     // Pass the data through the UAVTalk parser.
-                    for (uint8_t i = 0; i < bytes_to_process; i++) {
-                        ProcessRadioStream(data->radioUAVTalkCon, data->telemUAVTalkCon, serial_data[i]);
-                    }
+                    ProcessRadioStream(data->radioUAVTalkCon, data->telemUAVTalkCon, serial_data, bytes_to_process);
                 } else if (PIOS_COM_TELEMETRY) {
                     // Send the data straight to the telemetry port.
                     // Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
@@ -448,12 +473,10 @@ static void telemetryRxTask(__attribute__((unused)) void *parameters)
         }
 #endif /* PIOS_INCLUDE_USB */
         if (inputPort) {
-            uint8_t serial_data[1];
-            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), MAX_PORT_DELAY);
+            uint8_t *serial_data = data->telemRxBuf;
+            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(data->telemRxBuf), MAX_PORT_DELAY);
             if (bytes_to_process > 0) {
-                for (uint8_t i = 0; i < bytes_to_process; i++) {
-                    ProcessTelemetryStream(data->telemUAVTalkCon, data->radioUAVTalkCon, serial_data[i]);
-                }
+                ProcessTelemetryStream(data->telemUAVTalkCon, data->radioUAVTalkCon, serial_data, bytes_to_process);
             }
         } else {
             vTaskDelay(5);
@@ -591,18 +614,33 @@ static int32_t RadioSendHandler(uint8_t *buf, int32_t length)
 }
 
 /**
- * @brief Process a byte of data received on the telemetry stream
+ * @brief Process a block of data received on the telemetry stream
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the telemetry port
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the radio port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] rxbuffer  The received bytes.
+ * @param[in] length  The number of received bytes.
  */
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte)
+static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *rxbuffer, uint16_t length)
 {
-    // Keep reading until we receive a completed packet.
-    UAVTalkRxState state = UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
+    // start of the packet being parsed, -1 when it started in a previous block
+    int32_t frameStart = -1;
+
+    for (uint16_t i = 0; i < length; i++) {
+        // Keep reading until we receive a completed packet.
+        UAVTalkRxState state = UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbuffer[i]);
+
+        if (state == UAVTALK_STATE_TYPE) {
+            // the sync byte of a new packet
+            frameStart = i;
+        }
+        if (state != UAVTALK_STATE_COMPLETE) {
+            continue;
+        }
+        const uint8_t *frame = frameStart < 0 ? NULL : &rxbuffer[frameStart];
+        uint16_t frameLength = i + 1 - frameStart;
+        frameStart = -1;
 
-    if (state == UAVTALK_STATE_COMPLETE) {
         // We only want to unpack certain telemetry objects
         uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
         switch (objId) {
@@ -627,29 +665,44 @@ static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalk
             // The OBJECTPERSISTENCE logic can be broken too if for example OPLM nacks and then REVO acks...
             UAVTalkReceiveObject(inConnectionHandle);
             // relay packet to remote modem
-            UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+            UAVTalkRelayFrame(inConnectionHandle, outConnectionHandle, frame, frameLength);
             break;
         default:
             // all other packets are relayed to the remote modem
-            UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+            relayPacket(inConnectionHandle, outConnectionHandle, frame, frameLength, RELAY_TO_RADIO);
             break;
         }
     }
 }
 
 /**
- * @brief Process a byte of data received on the radio data stream.
+ * @brief Process a block of data received on the radio data stream.
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the radio port.
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the telemetry port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] rxbuffer  The received bytes.
+ * @param[in] length  The number of received bytes.
  */
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte)
+static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *rxbuffer, uint16_t length)
 {
-    // Keep reading until we receive a completed packet.
-    UAVTalkRxState state = UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
+    // start of the packet being parsed, -1 when it started in a previous block
+    int32_t frameStart = -1;
+
+    for (uint16_t i = 0; i < length; i++) {
+        // Keep reading until we receive a completed packet.
+        UAVTalkRxState state = UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbuffer[i]);
+
+        if (state == UAVTALK_STATE_TYPE) {
+            // the sync byte of a new packet
+            frameStart = i;
+        }
+        if (state != UAVTALK_STATE_COMPLETE) {
+            continue;
+        }
+        const uint8_t *frame = frameStart < 0 ? NULL : &rxbuffer[frameStart];
+        uint16_t frameLength = i + 1 - frameStart;
+        frameStart = -1;
 
-    if (state == UAVTALK_STATE_COMPLETE) {
         // We only want to unpack certain objects from the remote modem
         // Similarly we only want to relay certain objects to the telemetry port
         uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
@@ -673,12 +726,91 @@ static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConn
             break;
         default:
             // all other packets are relayed to the telemetry port
-            UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+            relayPacket(inConnectionHandle, outConnectionHandle, frame, frameLength, RELAY_TO_TELEMETRY);
             break;
         }
     }
 }
 
+/**
+ * @brief Relay a packet unless the relay filters thin it out.
+ * Only object updates are filtered, requests, acks and multi object packets are always relayed.
+ *
+ * @param[in] inConnectionHandle  The UAVTalk connection handle the packet was received on.
+ * @param[in] outConnectionHandle  The UAVTalk connection handle to relay the packet on.
+ * @param[in] frame  The received bytes of the packet, NULL if they are not at hand.
+ * @param[in] frameLength  The number of bytes in frame.
+ * @param[in] direction  The relay direction.
+ */
+static void relayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *frame, uint16_t frameLength, RelayDirection direction)
+{
+    uint8_t type = UAVTalkGetPacketType(inConnectionHandle);
+
+    if (data->numRelayFilters > 0 && (type == UAVTALK_TYPE_OBJ || type == UAVTALK_TYPE_OBJ_TS)) {
+        uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
+        int32_t low    = 0;
+        int32_t high   = data->numRelayFilters - 1;
+        while (low <= high) {
+            int32_t mid = (low + high) / 2;
+            RelayFilter *filter = &data->relayFilters[mid];
+            if (filter->objId < objId) {
+                low = mid + 1;
+            } else if (filter->objId > objId) {
+                high = mid - 1;
+            } else {
+                portTickType now = xTaskGetTickCount();
+                if (filter->period == 0 || (now - filter->lastRelay[direction]) < filter->period) {
+                    return;
+                }
+                filter->lastRelay[direction] = now;
+                break;
+            }
+        }
+    }
+
+    UAVTalkRelayFrame(inConnectionHandle, outConnectionHandle, frame, frameLength);
+}
+
+/**
+ * @brief Load the relay filters from the settings, sorted by object ID for the lookup.
+ *
+ * @param[in] oplinkSettings  The OPLink settings.
+ */
+static void loadRelayFilters(const OPLinkSettingsData *oplinkSettings)
+{
+    portTickType now = xTaskGetTickCount();
+
+    data->numRelayFilters = 0;
+    for (uint8_t i = 0; i < RELAY_FILTERS; i++) {
+        uint32_t objId = oplinkSettings->RelayFilterObjID[i];
+        if (objId == 0) {
+            continue;
+        }
+        // an object listed twice keeps its first entry
+        bool listed = false;
+        for (uint8_t j = 0; j < data->numRelayFilters; j++) {
+            listed |= data->relayFilters[j].objId == objId;
+        }
+        if (listed) {
+            continue;
+        }
+        // insertion sort
+        uint8_t pos = data->numRelayFilters;
+        while (pos > 0 && data->relayFilters[pos - 1].objId > objId) {
+            data->relayFilters[pos] = data->relayFilters[pos - 1];
+            pos--;
+        }
+        RelayFilter *filter = &data->relayFilters[pos];
+        filter->objId  = objId;
+        filter->period = (oplinkSettings->RelayFilterPeriod[i] + portTICK_RATE_MS - 1) / portTICK_RATE_MS;
+        for (uint8_t d = 0; d < RELAY_DIRECTIONS; d++) {
+            // the first update is relayed right away
+            filter->lastRelay[d] = now - filter->period;
+        }
+        data->numRelayFilters++;
+    }
+}
+
 /**
  * @brief Callback that is called when the ObjectPersistence UAVObject is changed.
  * @param[in] objEv  The event that precipitated the callback.
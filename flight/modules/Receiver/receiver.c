@@ -47,6 +47,12 @@
 #include "pios_usb_rctx.h"
 #endif /* PIOS_INCLUDE_USB_RCTX */
 
+#define PIOS_INSTRUMENT_MODULE
+#include <pios_instrumentation_helper.h>
+
+PERF_DEFINE_COUNTER(counterFrameLatency);
+// Counter 0x52430001 time from the new frame wakeup to the ManualControlCommand update
+
 // Private constants
 #if defined(PIOS_RECEIVER_STACK_SIZE)
 #define STACK_SIZE_BYTES  PIOS_RECEIVER_STACK_SIZE
@@ -64,6 +70,7 @@
 // Private types
 
 // Private variables
+extern uint32_t pios_rcvr_group_map[];
 static xTaskHandle taskHandle;
 static portTickType lastSysTime;
 
@@ -160,15 +167,33 @@ static void receiverTask(__attribute__((unused)) void *parameters)
     portTickType lastActivityTime = xTaskGetTickCount();
     resetRcvrActivity(&activity_fsm);
 
+    PERF_INIT_STATS_COUNTER(counterFrameLatency, 0x52430001);
+
     // Main task loop
     lastSysTime = xTaskGetTickCount();
+    ManualControlSettingsGet(&settings);
 
     float scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM] = { 0 };
     SystemSettingsThrustControlOptions thrustType;
 
     while (1) {
-        // Wait until next update
-        vTaskDelayUntil(&lastSysTime, UPDATE_PERIOD_MS / portTICK_RATE_MS);
+        // Wait for the next frame of the receiver carrying the throttle when it signals them,
+        // at most one update period so that a lost receiver is still noticed, else poll
+        xSemaphoreHandle frameSemaphore = NULL;
+        bool newFrame = false;
+        if (settings.ChannelGroups.Throttle < MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+            frameSemaphore = PIOS_RCVR_GetSemaphore(pios_rcvr_group_map[settings.ChannelGroups.Throttle],
+                                                    settings.ChannelNumber.Throttle);
+        }
+        if (frameSemaphore) {
+            newFrame = (xSemaphoreTake(frameSemaphore, UPDATE_PERIOD_MS / portTICK_RATE_MS) == pdTRUE);
+            if (newFrame) {
+                PERF_TIMED_SECTION_START(counterFrameLatency);
+            }
+            lastSysTime = xTaskGetTickCount();
+        } else {
+            vTaskDelayUntil(&lastSysTime, UPDATE_PERIOD_MS / portTICK_RATE_MS);
+        }
 #ifdef PIOS_INCLUDE_WDG
         PIOS_WDG_UpdateFlag(PIOS_WDG_MANUAL);
 #endif
@@ -207,8 +232,6 @@ static void receiverTask(__attribute__((unused)) void *parameters)
 
         // Read channel values in us
         for (uint8_t n = 0; n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM; ++n) {
-            extern uint32_t pios_rcvr_group_map[];
-
             if (ManualControlSettingsChannelGroupsToArray(settings.ChannelGroups)[n] >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
                 cmd.Channel[n] = PIOS_RCVR_INVALID;
             } else {
@@ -440,6 +463,9 @@ static void receiverTask(__attribute__((unused)) void *parameters)
 
         // Update cmd object
         ManualControlCommandSet(&cmd);
+        if (newFrame) {
+            PERF_TIMED_SECTION_END(counterFrameLatency);
+        }
 #if defined(PIOS_INCLUDE_USB_RCTX)
         if (pios_usb_rctx_id) {
             PIOS_USB_RCTX_Update(pios_usb_rctx_id,
@@ -545,7 +571,6 @@ static bool updateRcvrActivity(struct rcvr_activity_fsm *fsm)
         resetRcvrActivity(fsm);
     }
 
-    extern uint32_t pios_rcvr_group_map[];
     if (!pios_rcvr_group_map[fsm->group]) {
         /* Unbound group, skip it */
         goto group_completed;
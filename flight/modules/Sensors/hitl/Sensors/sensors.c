@@ -0,0 +1,279 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup Sensors
+ * @brief Acquires sensor data
+ * Specifically updates the the @ref GyroSensor, @ref AccelSensor, and @ref MagSensor objects
+ * @{
+ *
+ * @file       sensors.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Reads the sensor frames that the GCS HITL plugin writes in shared memory.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ ******************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * Input objects: @ref HomeLocation
+ * Output objects: @ref GyroSensor @ref AccelSensor @ref MagSensor @ref BaroSensor
+ *                 @ref GPSPositionSensor @ref GPSVelocitySensor @ref AirspeedSensor
+ *
+ * The module executes in its own thread. It polls the shared memory ring of
+ * the GCS HITL plugin (see hitlsensorring.h) and publishes every frame it
+ * finds, so the sensor rate is the one of the simulator instead of the one
+ * of the telemetry link.
+ */
+
+#include <openpilot.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "accelsensor.h"
+#include "airspeedsensor.h"
+#include "barosensor.h"
+#include "gpspositionsensor.h"
+#include "gpsvelocitysensor.h"
+#include "gyrosensor.h"
+#include "homelocation.h"
+#include "magsensor.h"
+#include "taskinfo.h"
+
+#include "CoordinateConversions.h"
+#include "hitlsensorring.h"
+
+// Private constants
+#define STACK_SIZE_BYTES 1540
+#define TASK_PRIORITY    (tskIDLE_PRIORITY + 3)
+#define SENSOR_PERIOD    1
+#define SENSOR_TIMEOUT   100
+#define RING_RETRY       500
+
+// Private variables
+static xTaskHandle sensorsTaskHandle;
+static const struct hitl_sensor_ring *ring;
+static uint32_t tail;
+
+// Private functions
+static void SensorsTask(void *parameters);
+static bool openRing();
+static void publishFrame(const struct hitl_sensor_frame *frame);
+
+/**
+ * Initialise the module.  Called before the start function
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t SensorsInitialize(void)
+{
+    AccelSensorInitialize();
+    AirspeedSensorInitialize();
+    BaroSensorInitialize();
+    GyroSensorInitialize();
+    GPSPositionSensorInitialize();
+    GPSVelocitySensorInitialize();
+    MagSensorInitialize();
+
+    return 0;
+}
+
+/**
+ * Start the task.  Expects all objects to be initialized by this point.
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t SensorsStart(void)
+{
+    // Start main task
+    xTaskCreate(SensorsTask, "Sensors", STACK_SIZE_BYTES / 4, NULL, TASK_PRIORITY, &sensorsTaskHandle);
+    PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_SENSORS, sensorsTaskHandle);
+    PIOS_WDG_RegisterFlag(PIOS_WDG_SENSORS);
+
+    return 0;
+}
+
+MODULE_INITCALL(SensorsInitialize, SensorsStart);
+
+/**
+ * HITL sensor task.  Publish the frames written by the GCS since the last pass
+ */
+static void SensorsTask(__attribute__((unused)) void *parameters)
+{
+    portTickType lastFrameTime = xTaskGetTickCount();
+
+    AlarmsSet(SYSTEMALARMS_ALARM_SENSORS, SYSTEMALARMS_ALARM_CRITICAL);
+
+    // Main task loop
+    while (1) {
+        PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
+
+        if (!ring && !openRing()) {
+            // The GCS has not started the simulation yet
+            vTaskDelay(RING_RETRY / portTICK_RATE_MS);
+            continue;
+        }
+
+        uint32_t head = ring->head;
+        __sync_synchronize();
+
+        if ((int32_t)(head - tail) < 0) {
+            // The GCS has reset the ring
+            tail = head;
+        } else if (head - tail >= HITL_SENSOR_RING_LENGTH) {
+            // Too late for the oldest frames, the GCS may be writing over them
+            tail = head - HITL_SENSOR_RING_LENGTH + 1;
+        }
+
+        while (tail != head) {
+            struct hitl_sensor_frame frame = ring->frames[tail % HITL_SENSOR_RING_LENGTH];
+            __sync_synchronize();
+            // Only keep the copy if the GCS did not start to overwrite it meanwhile
+            if (ring->head - tail < HITL_SENSOR_RING_LENGTH) {
+                publishFrame(&frame);
+                lastFrameTime = xTaskGetTickCount();
+            }
+            tail++;
+        }
+
+        if ((xTaskGetTickCount() - lastFrameTime) * portTICK_RATE_MS > SENSOR_TIMEOUT) {
+            AlarmsSet(SYSTEMALARMS_ALARM_SENSORS, SYSTEMALARMS_ALARM_CRITICAL);
+        } else {
+            AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
+        }
+
+        vTaskDelay(SENSOR_PERIOD / portTICK_RATE_MS);
+    }
+}
+
+/**
+ * Map the ring created by the GCS
+ * \returns true once the ring is mapped and has the expected layout
+ */
+static bool openRing()
+{
+    int fd = shm_open(HITL_SENSOR_RING_NAME, O_RDONLY, 0);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    // The GCS may not have sized the object yet, reading past its end would fault
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct hitl_sensor_ring)) {
+        close(fd);
+        return false;
+    }
+
+    void *mem = mmap(NULL, sizeof(struct hitl_sensor_ring), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+
+    const struct hitl_sensor_ring *r = mem;
+    if (r->magic != HITL_SENSOR_RING_MAGIC || r->version != HITL_SENSOR_RING_VERSION) {
+        munmap(mem, sizeof(struct hitl_sensor_ring));
+        return false;
+    }
+
+    ring = r;
+    tail = r->head;
+    return true;
+}
+
+static void publishFrame(const struct hitl_sensor_frame *frame)
+{
+    AccelSensorData accelSensorData; // Skip get as we set all the fields
+
+    accelSensorData.x = frame->accel[0];
+    accelSensorData.y = frame->accel[1];
+    accelSensorData.z = frame->accel[2];
+    accelSensorData.temperature = frame->temperature;
+    AccelSensorSet(&accelSensorData);
+
+    GyroSensorData gyroSensorData; // Skip get as we set all the fields
+    gyroSensorData.x = frame->gyro[0];
+    gyroSensorData.y = frame->gyro[1];
+    gyroSensorData.z = frame->gyro[2];
+    gyroSensorData.temperature = frame->temperature;
+    GyroSensorSet(&gyroSensorData);
+
+    // The simulators have no magnetometer, rotate the home field by the simulator attitude
+    HomeLocationData homeLocation;
+    HomeLocationGet(&homeLocation);
+    if (homeLocation.Set == HOMELOCATION_SET_TRUE) {
+        float q[4];
+        float Rbe[3][3];
+        float mag[3];
+        RPY2Quaternion(frame->rpy, q);
+        Quaternion2R(q, Rbe);
+        rot_mult(Rbe, homeLocation.Be, mag);
+
+        MagSensorData magSensor;
+        magSensor.x = mag[0];
+        magSensor.y = mag[1];
+        magSensor.z = mag[2];
+        MagSensorSet(&magSensor);
+    }
+
+    if (frame->flags & HITL_SENSOR_BARO) {
+        BaroSensorData baroSensor;
+        baroSensor.Altitude    = frame->baroAltitude;
+        baroSensor.Temperature = frame->temperature;
+        baroSensor.Pressure    = frame->pressure;
+        BaroSensorSet(&baroSensor);
+    }
+
+    if (frame->flags & HITL_SENSOR_GPS) {
+        GPSPositionSensorData gpsPosition;
+        GPSPositionSensorGet(&gpsPosition);
+        gpsPosition.Latitude    = frame->latitude;
+        gpsPosition.Longitude   = frame->longitude;
+        gpsPosition.Altitude    = frame->altitude;
+        gpsPosition.Groundspeed = frame->groundspeed;
+        gpsPosition.Heading     = frame->heading;
+        gpsPosition.GeoidSeparation = 0.0f;
+        gpsPosition.PDOP       = 3.0f;
+        gpsPosition.VDOP       = gpsPosition.PDOP * 1.5f;
+        gpsPosition.Satellites = 10;
+        gpsPosition.Status     = GPSPOSITIONSENSOR_STATUS_FIX3D;
+        GPSPositionSensorSet(&gpsPosition);
+
+        GPSVelocitySensorData gpsVelocity;
+        gpsVelocity.North = frame->velNED[0];
+        gpsVelocity.East  = frame->velNED[1];
+        gpsVelocity.Down  = frame->velNED[2];
+        GPSVelocitySensorSet(&gpsVelocity);
+    }
+
+    if (frame->flags & HITL_SENSOR_AIRSPEED) {
+        AirspeedSensorData airspeedSensor;
+        AirspeedSensorGet(&airspeedSensor);
+        airspeedSensor.SensorConnected    = AIRSPEEDSENSOR_SENSORCONNECTED_TRUE;
+        airspeedSensor.CalibratedAirspeed = frame->calibratedAirspeed;
+        airspeedSensor.TrueAirspeed = frame->trueAirspeed;
+        AirspeedSensorSet(&airspeedSensor);
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -60,6 +60,8 @@
 #include <taskinfo.h>
 #include <pios_math.h>
 #include <CoordinateConversions.h>
+#include <sensorsample.h>
+#include <sensorcalibrationstats.h>
 
 #include <pios_board_info.h>
 
@@ -84,10 +86,12 @@ static const float temp_alpha = TEMP_DT / (TEMP_DT + 1.0f / (2.0f * M_PI_F * TEM
 
 PERF_DEFINE_COUNTER(counterGyroSamples);
 PERF_DEFINE_COUNTER(counterSensorPeriod);
+PERF_DEFINE_COUNTER(counterSensorTransform);
 
 // Counters:
 // - 0x53000001 Sensor fetch rate(period)
 // - 0x53000002 number of gyro samples read for each loop
+// - 0x53000003 time spent applying the accel and gyro calibration transforms
 
 // Private functions
 static void SensorsTask(void *parameters);
@@ -125,6 +129,40 @@ static float R[3][3] = {
 };
 static int8_t rotate = 0;
 
+// Calibration and board rotation fused into out = M * raw + offset,
+// rebuilt on settings changes, offset also on temperature bias changes
+typedef struct {
+    float M[3][3]; // board rotation times calibration scale
+    float rotation[3][3]; // board rotation alone, for the offset
+    float bias[3];
+    float offset[3]; // -rotation * (bias + temperature bias)
+} sensor_transform_t;
+
+static sensor_transform_t accel_transform;
+static sensor_transform_t gyro_transform;
+
+static void buildTransform(sensor_transform_t *transform, const float scale[3], const float bias[3], const float temp_bias[3]);
+static void updateTransformOffset(sensor_transform_t *transform, const float temp_bias[3]);
+static void applyTransform(const sensor_transform_t *transform, const int32_t accum[3], float k, float out[3]);
+
+// Running mean and sum of squared deviations (Welford) of the calibrated
+// samples, reported in SensorCalibrationStats while the calibration runs
+typedef struct {
+    uint32_t count;
+    float    mean[3];
+    float    m2[3];
+    float    temperature; // mean temperature
+} sensor_stats_t;
+
+static volatile uint16_t calibration_stats_period = 0;
+static sensor_stats_t accel_stats;
+static sensor_stats_t gyro_stats;
+static sensor_stats_t mag_stats;
+
+static void calibrationStatsUpdatedCb(UAVObjEvent *objEv);
+static void calibrationStatsAdd(sensor_stats_t *stats, const float sample[3], float temperature);
+static void calibrationStatsUpdate(portTickType now);
+
 /**
  * API for sensor fusion algorithms:
  * Configure(xQueueHandle gyro, xQueueHandle accel, xQueueHandle mag, xQueueHandle baro)
@@ -146,6 +184,7 @@ int32_t SensorsInitialize(void)
     RevoCalibrationInitialize();
     AttitudeSettingsInitialize();
     AccelGyroSettingsInitialize();
+    SensorCalibrationStatsInitialize();
 
     rotate = 0;
 
@@ -153,6 +192,7 @@ int32_t SensorsInitialize(void)
     AttitudeSettingsConnectCallback(&settingsUpdatedCb);
 
     AccelGyroSettingsConnectCallback(&settingsUpdatedCb);
+    SensorCalibrationStatsConnectCallback(&calibrationStatsUpdatedCb);
     return 0;
 }
 
@@ -243,8 +283,13 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
             vTaskDelay(10);
         }
     }
+#if defined(PIOS_INCLUDE_HMC5X83)
+    // Read the mag from its data ready interrupt when possible, so that the loop does not wait for its bus
+    PIOS_HMC5x83_EnableIRQRead(onboard_mag);
+#endif
     PERF_INIT_COUNTER(counterGyroSamples, 0x53000001);
-    PERF_INIT_COUNTER(counterSensorPeriod, 0x53000002);
+    PERF_INIT_STATS_COUNTER(counterSensorPeriod, 0x53000002);
+    PERF_INIT_STATS_COUNTER(counterSensorTransform, 0x53000003);
     // Main task loop
     lastSysTime = xTaskGetTickCount();
     bool error = false;
@@ -343,18 +388,41 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
             {
                 struct pios_mpu6000_data mpu6000_data;
                 xQueueHandle queue = PIOS_MPU6000_GetQueue();
-
-                while (xQueueReceive(queue, (void *)&mpu6000_data, gyro_samples == 0 ? 10 : 0) != errQUEUE_EMPTY) {
-                    gyro_accum[0]  += mpu6000_data.gyro_x;
-                    gyro_accum[1]  += mpu6000_data.gyro_y;
-                    gyro_accum[2]  += mpu6000_data.gyro_z;
-
-                    accel_accum[0] += mpu6000_data.accel_x;
-                    accel_accum[1] += mpu6000_data.accel_y;
-                    accel_accum[2] += mpu6000_data.accel_z;
-
-                    gyro_samples++;
-                    accel_samples++;
+                xQueueHandle block_queue = PIOS_MPU6000_GetBlockQueue();
+
+                if (block_queue) {
+                    // burst mode, the samples come in blocks read from the FIFO at once
+                    static struct pios_mpu6000_block mpu6000_block;
+
+                    while (xQueueReceive(block_queue, (void *)&mpu6000_block, gyro_samples == 0 ? 10 : 0) != errQUEUE_EMPTY) {
+                        for (uint8_t i = 0; i < mpu6000_block.count; i++) {
+                            gyro_accum[0]  += mpu6000_block.samples[i].gyro_x;
+                            gyro_accum[1]  += mpu6000_block.samples[i].gyro_y;
+                            gyro_accum[2]  += mpu6000_block.samples[i].gyro_z;
+
+                            accel_accum[0] += mpu6000_block.samples[i].accel_x;
+                            accel_accum[1] += mpu6000_block.samples[i].accel_y;
+                            accel_accum[2] += mpu6000_block.samples[i].accel_z;
+                        }
+                        gyro_samples  += mpu6000_block.count;
+                        accel_samples += mpu6000_block.count;
+                        if (mpu6000_block.count) {
+                            mpu6000_data.temperature = mpu6000_block.samples[mpu6000_block.count - 1].temperature;
+                        }
+                    }
+                } else {
+                    while (xQueueReceive(queue, (void *)&mpu6000_data, gyro_samples == 0 ? 10 : 0) != errQUEUE_EMPTY) {
+                        gyro_accum[0]  += mpu6000_data.gyro_x;
+                        gyro_accum[1]  += mpu6000_data.gyro_y;
+                        gyro_accum[2]  += mpu6000_data.gyro_z;
+
+                        accel_accum[0] += mpu6000_data.accel_x;
+                        accel_accum[1] += mpu6000_data.accel_y;
+                        accel_accum[2] += mpu6000_data.accel_z;
+
+                        gyro_samples++;
+                        accel_samples++;
+                    }
                 }
 
                 PERF_MEASURE_PERIOD(counterSensorPeriod);
@@ -402,53 +470,42 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
                 gyro_temp_bias[1] = (agcal.gyro_temp_coeff.Y + agcal.gyro_temp_coeff.Y2 * ctemp) * ctemp;
                 gyro_temp_bias[2] = (agcal.gyro_temp_coeff.Z + agcal.gyro_temp_coeff.Z2 * ctemp) * ctemp;
             }
+            updateTransformOffset(&accel_transform, accel_temp_bias);
+            updateTransformOffset(&gyro_transform, gyro_temp_bias);
         }
         temp_calibration_count--;
-        // Scale the accels
-        float accels[3] = { (float)accel_accum[0] / accel_samples,
-                            (float)accel_accum[1] / accel_samples,
-                            (float)accel_accum[2] / accel_samples };
-
-
-        float accels_out[3] = { accels[0] * accel_scaling * agcal.accel_scale.X - agcal.accel_bias.X - accel_temp_bias[0],
-                                accels[1] * accel_scaling * agcal.accel_scale.Y - agcal.accel_bias.Y - accel_temp_bias[1],
-                                accels[2] * accel_scaling * agcal.accel_scale.Z - agcal.accel_bias.Z - accel_temp_bias[2] };
 
+        PERF_TIMED_SECTION_START(counterSensorTransform);
+        // Average, scale, calibrate and rotate the accels
+        float accels[3];
+        applyTransform(&accel_transform, accel_accum, accel_scaling / accel_samples, accels);
+        accelSensorData.x = accels[0];
+        accelSensorData.y = accels[1];
+        accelSensorData.z = accels[2];
+
+        // and the gyros
+        float gyros[3];
+        applyTransform(&gyro_transform, gyro_accum, gyro_scaling / gyro_samples, gyros);
+        gyroSensorData.x = gyros[0];
+        gyroSensorData.y = gyros[1];
+        gyroSensorData.z = gyros[2];
+        PERF_TIMED_SECTION_END(counterSensorTransform);
 
-        if (rotate) {
-            rot_mult(R, accels_out, accels);
-            accelSensorData.x = accels[0];
-            accelSensorData.y = accels[1];
-            accelSensorData.z = accels[2];
-        } else {
-            accelSensorData.x = accels_out[0];
-            accelSensorData.y = accels_out[1];
-            accelSensorData.z = accels_out[2];
-        }
         AccelSensorSet(&accelSensorData);
 
-        // Scale the gyros
-        float gyros[3] = { (float)gyro_accum[0] / gyro_samples,
-                           (float)gyro_accum[1] / gyro_samples,
-                           (float)gyro_accum[2] / gyro_samples };
-
-        float gyros_out[3] = { gyros[0] * gyro_scaling * agcal.gyro_scale.X - agcal.gyro_bias.X - gyro_temp_bias[0],
-                               gyros[1] * gyro_scaling * agcal.gyro_scale.Y - agcal.gyro_bias.Y - gyro_temp_bias[1],
-                               gyros[2] * gyro_scaling * agcal.gyro_scale.Z - agcal.gyro_bias.Z - gyro_temp_bias[2] };
+        // the direct channel first, StateEstimation reads it on the GyroSensor update
+        sensorsample_publish(&(sensorsample_t) {
+            .gyro  = { gyroSensorData.x, gyroSensorData.y, gyroSensorData.z },
+            .accel = { accelSensorData.x, accelSensorData.y, accelSensorData.z },
+            .timestamp = PIOS_DELAY_GetRaw()
+        });
+        GyroSensorSet(&gyroSensorData);
 
-        if (rotate) {
-            rot_mult(R, gyros_out, gyros);
-            gyroSensorData.x = gyros[0];
-            gyroSensorData.y = gyros[1];
-            gyroSensorData.z = gyros[2];
-        } else {
-            gyroSensorData.x = gyros_out[0];
-            gyroSensorData.y = gyros_out[1];
-            gyroSensorData.z = gyros_out[2];
+        if (calibration_stats_period) {
+            calibrationStatsAdd(&accel_stats, accels, accelSensorData.temperature);
+            calibrationStatsAdd(&gyro_stats, gyros, gyroSensorData.temperature);
         }
 
-        GyroSensorSet(&gyroSensorData);
-
         // Because most crafts wont get enough information from gravity to zero yaw gyro, we try
         // and make it average zero (weakly)
 
@@ -456,23 +513,31 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
         MagSensorData mag;
         if (PIOS_HMC5x83_NewDataAvailable(onboard_mag) || PIOS_DELAY_DiffuS(mag_update_time) > 150000) {
             int16_t values[3];
-            PIOS_HMC5x83_ReadMag(onboard_mag, values);
-            float mags[3] = { (float)values[1] - mag_bias[0],
-                              (float)values[0] - mag_bias[1],
-                              -(float)values[2] - mag_bias[2] };
+            // In the interrupt mode this is the last sample read, no bus access
+            if (PIOS_HMC5x83_ReadMag(onboard_mag, values) == 0) {
+                float mags[3] = { (float)values[1] - mag_bias[0],
+                                  (float)values[0] - mag_bias[1],
+                                  -(float)values[2] - mag_bias[2] };
+
+                float mag_out[3];
+                rot_mult(mag_transform, mags, mag_out);
 
-            float mag_out[3];
-            rot_mult(mag_transform, mags, mag_out);
+                mag.x = mag_out[0];
+                mag.y = mag_out[1];
+                mag.z = mag_out[2];
 
-            mag.x = mag_out[0];
-            mag.y = mag_out[1];
-            mag.z = mag_out[2];
+                MagSensorSet(&mag);
 
-            MagSensorSet(&mag);
+                if (calibration_stats_period) {
+                    calibrationStatsAdd(&mag_stats, mag_out, 0.0f);
+                }
+            }
             mag_update_time = PIOS_DELAY_GetRaw();
         }
 #endif /* if defined(PIOS_INCLUDE_HMC5X83) */
 
+        calibrationStatsUpdate(xTaskGetTickCount());
+
 #ifdef PIOS_INCLUDE_WDG
         PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
 #endif
@@ -533,6 +598,118 @@ static void settingsUpdatedCb(__attribute__((unused)) UAVObjEvent *objEv)
         Quaternion2R(rotationQuat, R);
     }
     matrix_mult_3x3f((float(*)[3])RevoCalibrationmag_transformToArray(cal.mag_transform), R, mag_transform);
+
+    buildTransform(&accel_transform, AccelGyroSettingsaccel_scaleToArray(agcal.accel_scale),
+                   AccelGyroSettingsaccel_biasToArray(agcal.accel_bias), accel_temp_bias);
+    buildTransform(&gyro_transform, AccelGyroSettingsgyro_scaleToArray(agcal.gyro_scale),
+                   AccelGyroSettingsgyro_biasToArray(agcal.gyro_bias), gyro_temp_bias);
+}
+
+/**
+ * Fuse the calibration scale with the board rotation, identity when not rotating
+ */
+static void buildTransform(sensor_transform_t *transform, const float scale[3], const float bias[3], const float temp_bias[3])
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            transform->rotation[i][j] = rotate ? R[i][j] : (i == j ? 1.0f : 0.0f);
+            transform->M[i][j] = transform->rotation[i][j] * scale[j];
+        }
+        transform->bias[i] = bias[i];
+    }
+    updateTransformOffset(transform, temp_bias);
+}
+
+static void updateTransformOffset(sensor_transform_t *transform, const float temp_bias[3])
+{
+    const float b[3] = { transform->bias[0] + temp_bias[0],
+                         transform->bias[1] + temp_bias[1],
+                         transform->bias[2] + temp_bias[2] };
+
+    for (int i = 0; i < 3; i++) {
+        transform->offset[i] = -(transform->rotation[i][0] * b[0] + transform->rotation[i][1] * b[1] + transform->rotation[i][2] * b[2]);
+    }
+}
+
+/**
+ * out = M * (accum * k) + offset, k folds the averaging and the driver scale
+ */
+static void applyTransform(const sensor_transform_t *transform, const int32_t accum[3], float k, float out[3])
+{
+    const float v[3] = { (float)accum[0] * k, (float)accum[1] * k, (float)accum[2] * k };
+
+    for (int i = 0; i < 3; i++) {
+        out[i] = transform->M[i][0] * v[0] + transform->M[i][1] * v[1] + transform->M[i][2] * v[2] + transform->offset[i];
+    }
+}
+
+/**
+ * Cache the statistics period, the sensors task restarts the accumulation when it changes
+ */
+static void calibrationStatsUpdatedCb(__attribute__((unused)) UAVObjEvent *objEv)
+{
+    uint16_t period;
+
+    SensorCalibrationStatsPeriodGet(&period);
+    calibration_stats_period = period;
+}
+
+static void calibrationStatsAdd(sensor_stats_t *stats, const float sample[3], float temperature)
+{
+    stats->count++;
+    const float k = 1.0f / (float)stats->count;
+
+    for (int i = 0; i < 3; i++) {
+        const float delta = sample[i] - stats->mean[i];
+        stats->mean[i] += delta * k;
+        stats->m2[i]   += delta * (sample[i] - stats->mean[i]);
+    }
+    stats->temperature += (temperature - stats->temperature) * k;
+}
+
+static void calibrationStatsExport(const sensor_stats_t *stats, uint16_t *count, float mean[3], float variance[3])
+{
+    *count = (uint16_t)MIN(stats->count, UINT16_MAX);
+    for (int i = 0; i < 3; i++) {
+        mean[i]     = stats->mean[i];
+        variance[i] = (stats->count > 1) ? stats->m2[i] / (float)(stats->count - 1) : 0.0f;
+    }
+}
+
+/**
+ * Publish the statistics accumulated over the period and start a new period
+ */
+static void calibrationStatsUpdate(portTickType now)
+{
+    static uint16_t period = 0;
+    static portTickType start;
+
+    if (period != calibration_stats_period) {
+        period = calibration_stats_period;
+    } else if (!period || (now - start) < period / portTICK_RATE_MS) {
+        return;
+    } else {
+        SensorCalibrationStatsData data;
+        SensorCalibrationStatsGet(&data);
+
+        calibrationStatsExport(&accel_stats, &data.Count.Accel, SensorCalibrationStatsAccelMeanToArray(data.AccelMean),
+                               SensorCalibrationStatsAccelVarianceToArray(data.AccelVariance));
+        calibrationStatsExport(&gyro_stats, &data.Count.Gyro, SensorCalibrationStatsGyroMeanToArray(data.GyroMean),
+                               SensorCalibrationStatsGyroVarianceToArray(data.GyroVariance));
+        calibrationStatsExport(&mag_stats, &data.Count.Mag, SensorCalibrationStatsMagMeanToArray(data.MagMean),
+                               SensorCalibrationStatsMagVarianceToArray(data.MagVariance));
+        data.Temperature.Accel = accel_stats.temperature;
+        data.Temperature.Gyro  = gyro_stats.temperature;
+        // keep a period written by the GCS meanwhile
+        data.Period = calibration_stats_period;
+
+        SensorCalibrationStatsSet(&data);
+    }
+
+    memset(&accel_stats, 0, sizeof(accel_stats));
+    memset(&gyro_stats, 0, sizeof(gyro_stats));
+    memset(&mag_stats, 0, sizeof(mag_stats));
+    start = now;
 }
 /**
  * @}
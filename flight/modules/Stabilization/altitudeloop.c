@@ -37,6 +37,7 @@
 #include <altitudeholdstatus.h>
 #include <velocitystate.h>
 #include <positionstate.h>
+#include <rategovernor.h>
 // Private constants
 
 
@@ -62,12 +63,14 @@ static PiOSDeltatimeConfig timeval;
 static float thrustSetpoint = 0.0f;
 static float thrustDemand   = 0.0f;
 static float startThrust    = 0.5f;
+static uint8_t rateDivider  = 1;
 
 
 // Private functions
 static void altitudeHoldTask(void);
 static void SettingsUpdatedCb(UAVObjEvent *ev);
 static void VelocityStateUpdatedCb(UAVObjEvent *ev);
+static void RateGovernorUpdatedCb(UAVObjEvent *ev);
 
 /**
  * Setup mode and setpoint
@@ -131,6 +134,7 @@ void stabilizationAltitudeloopInit()
     AltitudeHoldStatusInitialize();
     PositionStateInitialize();
     VelocityStateInitialize();
+    RateGovernorInitialize();
 
     PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
     // Create object queue
@@ -138,6 +142,7 @@ void stabilizationAltitudeloopInit()
     altitudeHoldCBInfo = PIOS_CALLBACKSCHEDULER_Create(&altitudeHoldTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_ALTITUDEHOLD, STACK_SIZE_BYTES);
     AltitudeHoldSettingsConnectCallback(&SettingsUpdatedCb);
     VelocityStateConnectCallback(&VelocityStateUpdatedCb);
+    RateGovernorConnectCallback(&RateGovernorUpdatedCb);
 
     // Start main task
     SettingsUpdatedCb(NULL);
@@ -206,7 +211,21 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 
 static void VelocityStateUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
-    PIOS_CALLBACKSCHEDULER_Dispatch(altitudeHoldCBInfo);
+    static uint8_t updates = 0;
+
+    // run on every rateDivider-th velocity update, dT follows from the measured period
+    if (++updates >= rateDivider) {
+        updates = 0;
+        PIOS_CALLBACKSCHEDULER_Dispatch(altitudeHoldCBInfo);
+    }
+}
+
+static void RateGovernorUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    uint8_t divider;
+
+    RateGovernorDividerGet(&divider);
+    rateDivider = divider ? divider : 1;
 }
 
 
@@ -35,6 +35,7 @@
 
 #include <openpilot.h>
 #include <pid.h>
+#include <butterworth.h>
 #include <stabilizationsettings.h>
 #include <stabilizationbank.h>
 
@@ -45,6 +46,7 @@ typedef struct {
     StabilizationSettingsData settings;
     StabilizationBankData     stabBank;
     float gyro_alpha;
+    struct BiquadFilterBank gyroFilter;
     struct {
         float min_thrust;
         float max_thrust;
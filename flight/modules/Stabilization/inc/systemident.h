@@ -1,12 +1,15 @@
 /**
  ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup StabilizationModule Stabilization Module
+ * @{
+ *
+ * @file       systemident.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      High rate capture of the inner loop for system identification
  *
- * @file       trailitem.cpp
- * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a trail point
  * @see        The GNU Public License (GPL) Version 3
- * @defgroup   OPMapWidget
- * @{
  *
  *****************************************************************************/
 /*
@@ -24,25 +27,16 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
-#include "traillineitem.h"
 
-namespace mapcontrol {
-TrailLineItem::TrailLineItem(internals::PointLatLng const & coord1, internals::PointLatLng const & coord2, QBrush color, MapGraphicItem *map) : QGraphicsLineItem(map), coord1(coord1), coord2(coord2), m_brush(color), m_map(map)
-{
-    QPen pen;
+#ifndef SYSTEMIDENT_H
+#define SYSTEMIDENT_H
 
-    pen.setBrush(m_brush);
-    pen.setWidth(1);
-    this->setPen(pen);
-}
+void stabilizationSystemIdentInit();
+void stabilizationSystemIdentSample(const float gyro[3], const float actuator[3]);
 
-int TrailLineItem::type() const
-{
-    return Type;
-}
+#endif /* SYSTEMIDENT_H */
 
-void TrailLineItem::setLineSlot()
-{
-    setLine(m_map->FromLatLngToLocal(this->coord1).X(), m_map->FromLatLngToLocal(this->coord1).Y(), m_map->FromLatLngToLocal(this->coord2).X(), m_map->FromLatLngToLocal(this->coord2).Y());
-}
-}
+/**
+ * @}
+ * @}
+ */
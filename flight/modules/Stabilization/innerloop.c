@@ -49,6 +49,9 @@
 #include <stabilization.h>
 #include <virtualflybar.h>
 #include <cruisecontrol.h>
+#ifdef REVOLUTION
+#include <systemident.h>
+#endif
 
 // Private constants
 
@@ -62,6 +65,9 @@
 // Private variables
 static DelayedCallbackInfo *callbackHandle;
 static float gyro_filtered[3] = { 0, 0, 0 };
+#ifdef REVOLUTION
+static float gyro_raw[3]      = { 0, 0, 0 };
+#endif
 static float axis_lock_accum[3] = { 0, 0, 0 };
 static uint8_t previous_mode[AXES] = { 255, 255, 255, 255 };
 static PiOSDeltatimeConfig timeval;
@@ -91,7 +97,8 @@ void stabilizationInnerloopInit()
     PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
 
     callbackHandle = PIOS_CALLBACKSCHEDULER_Create(&stabilizationInnerloopTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_STABILIZATION1, STACK_SIZE_BYTES);
-    GyroStateConnectCallback(GyroStateUpdatedCb);
+    // filter and dispatch in the context of the GyroState setter, saves an event dispatcher hop
+    GyroStateConnectFastCallback(GyroStateUpdatedCb);
 
     // schedule dead calls every FAILSAFE_TIMEOUT_MS to have the watchdog cleared
     PIOS_CALLBACKSCHEDULER_Schedule(callbackHandle, FAILSAFE_TIMEOUT_MS, CALLBACK_UPDATEMODE_LATER);
@@ -135,7 +142,24 @@ static float pid_curve_value(const pid_curve_scaler *scaler)
     return 1.0f + (IS_REAL(y) ? y : 0.0f);
 }
 
-static pid_scaler create_pid_scaler(int axis)
+static float thrust_pid_curve_value()
+{
+    const pid_curve_scaler curve_scaler = {
+        .x      = get_pid_scale_source_value(),
+        .points = {
+            { 0.00f, stabSettings.stabBank.ThrustPIDScaleCurve[0] },
+            { 0.25f, stabSettings.stabBank.ThrustPIDScaleCurve[1] },
+            { 0.50f, stabSettings.stabBank.ThrustPIDScaleCurve[2] },
+            { 0.75f, stabSettings.stabBank.ThrustPIDScaleCurve[3] },
+            { 1.00f, stabSettings.stabBank.ThrustPIDScaleCurve[4] }
+        }
+    };
+
+    return pid_curve_value(&curve_scaler);
+}
+
+// curve_value is thrust_pid_curve_value(), evaluated once for all axes by the caller
+static pid_scaler create_pid_scaler(int axis, float curve_value)
 {
     pid_scaler scaler;
 
@@ -145,19 +169,6 @@ static pid_scaler create_pid_scaler(int axis)
     if (stabSettings.thrust_pid_scaling_enabled[axis][0]
         || stabSettings.thrust_pid_scaling_enabled[axis][1]
         || stabSettings.thrust_pid_scaling_enabled[axis][2]) {
-        const pid_curve_scaler curve_scaler = {
-            .x      = get_pid_scale_source_value(),
-            .points = {
-                { 0.00f, stabSettings.stabBank.ThrustPIDScaleCurve[0] },
-                { 0.25f, stabSettings.stabBank.ThrustPIDScaleCurve[1] },
-                { 0.50f, stabSettings.stabBank.ThrustPIDScaleCurve[2] },
-                { 0.75f, stabSettings.stabBank.ThrustPIDScaleCurve[3] },
-                { 1.00f, stabSettings.stabBank.ThrustPIDScaleCurve[4] }
-            }
-        };
-
-        float curve_value = pid_curve_value(&curve_scaler);
-
         if (stabSettings.thrust_pid_scaling_enabled[axis][0]) {
             scaler.p *= curve_value;
         }
@@ -241,6 +252,21 @@ static void stabilizationInnerloopTask()
     float dT;
     dT = PIOS_DELTATIME_GetAverageSeconds(&timeval);
 
+    // the rate PIDs of roll, pitch and yaw are run together after the mode switch
+    pid_scaler scalers[3];
+    float acroStick[3] = { 0 };
+    uint8_t pidAxes    = 0;
+    uint8_t acroAxes   = 0;
+    float curve_value  = 1.0f;
+    for (t = 0; t < STABILIZATIONSTATUS_INNERLOOP_THRUST; t++) {
+        if (stabSettings.thrust_pid_scaling_enabled[t][0]
+            || stabSettings.thrust_pid_scaling_enabled[t][1]
+            || stabSettings.thrust_pid_scaling_enabled[t][2]) {
+            curve_value = thrust_pid_curve_value();
+            break;
+        }
+    }
+
     for (t = 0; t < AXES; t++) {
         bool reinit = (StabilizationStatusInnerLoopToArray(enabled)[t] != previous_mode[t]);
         previous_mode[t] = StabilizationStatusInnerLoopToArray(enabled)[t];
@@ -271,8 +297,8 @@ static void stabilizationInnerloopTask()
                                  -StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t],
                                  StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t]
                                  );
-                pid_scaler scaler = create_pid_scaler(t);
-                actuatorDesiredAxis[t] = pid_apply_setpoint(&stabSettings.innerPids[t], &scaler, rate[t], gyro_filtered[t], dT);
+                scalers[t] = create_pid_scaler(t, curve_value);
+                pidAxes   |= 1 << t;
                 break;
             case STABILIZATIONSTATUS_INNERLOOP_ACRO:
             {
@@ -284,11 +310,11 @@ static void stabilizationInnerloopTask()
                                  -StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t],
                                  StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t]
                                  );
-                pid_scaler ascaler = create_pid_scaler(t);
-                ascaler.i *= boundf(1.0f - (1.5f * fabsf(stickinput[t])), 0.0f, 1.0f); // this prevents Integral from getting too high while controlled manually
-                float arate  = pid_apply_setpoint(&stabSettings.innerPids[t], &ascaler, rate[t], gyro_filtered[t], dT);
-                float factor = fabsf(stickinput[t]) * stabSettings.stabBank.AcroInsanityFactor;
-                actuatorDesiredAxis[t] = factor * stickinput[t] + (1.0f - factor) * arate;
+                scalers[t]    = create_pid_scaler(t, curve_value);
+                scalers[t].i *= boundf(1.0f - (1.5f * fabsf(stickinput[t])), 0.0f, 1.0f); // this prevents Integral from getting too high while controlled manually
+                acroStick[t]  = stickinput[t];
+                pidAxes  |= 1 << t;
+                acroAxes |= 1 << t;
             }
             break;
             case STABILIZATIONSTATUS_INNERLOOP_DIRECT:
@@ -311,10 +337,29 @@ static void stabilizationInnerloopTask()
         actuatorDesiredAxis[t] = boundf(actuatorDesiredAxis[t], -1.0f, 1.0f);
     }
 
+    if (pidAxes) {
+        float pidOutput[3];
+        pid3_apply_setpoint(stabSettings.innerPids, scalers, rate, gyro_filtered, dT, pidAxes, pidOutput);
+        for (t = 0; t < STABILIZATIONSTATUS_INNERLOOP_THRUST; t++) {
+            if (acroAxes & (1 << t)) {
+                float factor = fabsf(acroStick[t]) * stabSettings.stabBank.AcroInsanityFactor;
+                actuatorDesiredAxis[t] = factor * acroStick[t] + (1.0f - factor) * pidOutput[t];
+            } else if (pidAxes & (1 << t)) {
+                actuatorDesiredAxis[t] = pidOutput[t];
+            } else {
+                continue;
+            }
+            actuatorDesiredAxis[t] = boundf(actuatorDesiredAxis[t], -1.0f, 1.0f);
+        }
+    }
+
     actuator.UpdateTime = dT * 1000;
 
     if (cchain.Stabilization == FLIGHTSTATUS_CONTROLCHAIN_TRUE) {
         ActuatorDesiredSet(&actuator);
+#ifdef REVOLUTION
+        stabilizationSystemIdentSample(gyro_raw, actuatorDesiredAxis);
+#endif
     } else {
         // Force all axes to reinitialize when engaged
         for (t = 0; t < AXES; t++) {
@@ -325,8 +370,8 @@ static void stabilizationInnerloopTask()
     if (stabSettings.stabBank.EnablePiroComp == STABILIZATIONBANK_ENABLEPIROCOMP_TRUE && stabSettings.innerPids[0].iLim > 1e-3f && stabSettings.innerPids[1].iLim > 1e-3f) {
         // attempted piro compensation - rotate pitch and yaw integrals (experimental)
         float angleYaw = DEG2RAD(gyro_filtered[2] * dT);
-        float sinYaw   = sinf(angleYaw);
-        float cosYaw   = cosf(angleYaw);
+        float sinYaw, cosYaw;
+        sincos_lookup_rad(angleYaw, &sinYaw, &cosYaw);
         float rollAcc  = stabSettings.innerPids[0].iAccumulator / stabSettings.innerPids[0].iLim;
         float pitchAcc = stabSettings.innerPids[1].iAccumulator / stabSettings.innerPids[1].iLim;
         stabSettings.innerPids[0].iAccumulator = stabSettings.innerPids[0].iLim * (cosYaw * rollAcc + sinYaw * pitchAcc);
@@ -356,9 +401,18 @@ static void GyroStateUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 
     GyroStateGet(&gyroState);
 
-    gyro_filtered[0] = gyro_filtered[0] * stabSettings.gyro_alpha + gyroState.x * (1 - stabSettings.gyro_alpha);
-    gyro_filtered[1] = gyro_filtered[1] * stabSettings.gyro_alpha + gyroState.y * (1 - stabSettings.gyro_alpha);
-    gyro_filtered[2] = gyro_filtered[2] * stabSettings.gyro_alpha + gyroState.z * (1 - stabSettings.gyro_alpha);
+    float gyro[3] = { gyroState.x, gyroState.y, gyroState.z };
+#ifdef REVOLUTION
+    // the identification wants the plant response without the gyro filters
+    gyro_raw[0] = gyro[0];
+    gyro_raw[1] = gyro[1];
+    gyro_raw[2] = gyro[2];
+#endif
+    FilterBiquadBank(&stabSettings.gyroFilter, gyro);
+
+    gyro_filtered[0] = gyro_filtered[0] * stabSettings.gyro_alpha + gyro[0] * (1 - stabSettings.gyro_alpha);
+    gyro_filtered[1] = gyro_filtered[1] * stabSettings.gyro_alpha + gyro[1] * (1 - stabSettings.gyro_alpha);
+    gyro_filtered[2] = gyro_filtered[2] * stabSettings.gyro_alpha + gyro[2] * (1 - stabSettings.gyro_alpha);
 
     PIOS_CALLBACKSCHEDULER_Dispatch(callbackHandle);
     stabSettings.monitor.gyroupdates++;
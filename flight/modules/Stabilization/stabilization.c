@@ -49,10 +49,11 @@
 #include <innerloop.h>
 #include <outerloop.h>
 #include <altitudeloop.h>
+#include <systemident.h>
 
 
 // Public variables
-StabilizationData stabSettings;
+StabilizationData stabSettings PIOS_FAST_DATA;
 
 // Private variables
 static int cur_flight_mode = -1;
@@ -109,6 +110,7 @@ int32_t StabilizationInitialize()
     stabilizationInnerloopInit();
 #ifdef REVOLUTION
     stabilizationAltitudeloopInit();
+    stabilizationSystemIdentInit();
 #endif
     pid_zero(&stabSettings.outerPids[0]);
     pid_zero(&stabSettings.outerPids[1]);
@@ -361,6 +363,15 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
         stabSettings.gyro_alpha = expf(-fakeDt / stabSettings.settings.GyroTau);
     }
 
+    // Gyro notch, against motor noise, at the actual gyro update rate
+    struct BiquadFilterBank gyroFilter;
+    InitBiquadBank(&gyroFilter);
+    if (stabSettings.settings.GyroNotch.Frequency > 0.0f && stabSettings.settings.GyroNotch.Q > 0.0f
+        && stabSettings.settings.GyroNotch.Frequency < 0.5f * PIOS_SENSOR_RATE) {
+        BiquadBankAddNotch(&gyroFilter, stabSettings.settings.GyroNotch.Frequency / PIOS_SENSOR_RATE, stabSettings.settings.GyroNotch.Q);
+    }
+    stabSettings.gyroFilter = gyroFilter;
+
     // force flight mode update
     cur_flight_mode = -1;
 
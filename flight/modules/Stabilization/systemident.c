@@ -0,0 +1,234 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup StabilizationModule Stabilization Module
+ * @{
+ *
+ * @file       systemident.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      High rate capture of the inner loop for system identification.
+ *             While armed in Autotune flight mode every inner loop run records
+ *             the gyro and the actuator desired into a RAM ring, the ring is
+ *             streamed to the GCS through @ref SysIdCapture once disarmed.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <openpilot.h>
+
+#include <callbackinfo.h>
+
+#include <systemident.h>
+#include <flightstatus.h>
+#include <flighttelemetrystats.h>
+#include <sysidcapture.h>
+#include <sysidcapturesettings.h>
+
+// Private constants
+
+#ifdef REVOLUTION
+
+#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
+#define CBTASK_PRIORITY   CALLBACK_TASK_AUXILIARY
+
+#define STACK_SIZE_BYTES  512
+#define STREAM_PERIOD_MS  100
+#define BLOCK_SAMPLES     SYSIDCAPTURE_DELTATIME_NUMELEM
+#define GYRO_SCALE        10.0f
+#define ACTUATOR_SCALE    32767.0f
+
+// Private types
+typedef struct {
+    uint16_t deltaTime;
+    int16_t  gyro[3];
+    int16_t  actuator[3];
+} CaptureSample;
+
+// Private variables
+static DelayedCallbackInfo *streamCBInfo;
+static CaptureSample *ring;
+static uint16_t ringSize;
+static uint16_t ringHead; // next sample written
+static uint16_t ringCount; // samples held, the oldest ones are overwritten
+static uint32_t lastSampleTime;
+static volatile uint8_t captureState = SYSIDCAPTURE_STATE_IDLE;
+static bool streamPending;
+static bool gcsConnected;
+static uint16_t streamBlock;
+
+// Private functions
+static void streamTask(void);
+static void FlightStatusUpdatedCb(UAVObjEvent *ev);
+static void setState(uint8_t state);
+static int16_t scaleSample(float value, float scale);
+
+/**
+ * Allocate the capture ring, the capture stays disabled when
+ * SysIdCaptureSettings.Samples is 0 or the memory is not available
+ */
+void stabilizationSystemIdentInit()
+{
+    SysIdCaptureInitialize();
+    SysIdCaptureSettingsInitialize();
+    FlightStatusInitialize();
+    FlightTelemetryStatsInitialize();
+
+    SysIdCaptureSettingsSamplesGet(&ringSize);
+    if (ringSize == 0) {
+        return;
+    }
+    // the inner loop writes the ring on every gyro update, keep it in the fast heap
+    ring = (CaptureSample *)pios_fastheapmalloc(ringSize * sizeof(CaptureSample));
+    if (!ring) {
+        ringSize = 0;
+        return;
+    }
+
+    streamCBInfo = PIOS_CALLBACKSCHEDULER_Create(&streamTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_SYSIDCAPTURE, STACK_SIZE_BYTES);
+    FlightStatusConnectCallback(&FlightStatusUpdatedCb);
+    PIOS_CALLBACKSCHEDULER_Schedule(streamCBInfo, STREAM_PERIOD_MS, CALLBACK_UPDATEMODE_SOONER);
+}
+
+/**
+ * Record one sample, called by the inner loop after the actuator computation.
+ * Keep this cheap, it runs with critical flight control priority.
+ */
+void stabilizationSystemIdentSample(const float gyro[3], const float actuator[3])
+{
+    if (captureState != SYSIDCAPTURE_STATE_CAPTURING) {
+        return;
+    }
+
+    CaptureSample *sample = &ring[ringHead];
+    uint32_t dT = PIOS_DELAY_DiffuS(lastSampleTime);
+
+    lastSampleTime    = PIOS_DELAY_GetRaw();
+    sample->deltaTime = dT > UINT16_MAX ? UINT16_MAX : dT;
+    for (uint8_t t = 0; t < 3; t++) {
+        sample->gyro[t]     = scaleSample(gyro[t], GYRO_SCALE);
+        sample->actuator[t] = scaleSample(actuator[t], ACTUATOR_SCALE);
+    }
+
+    if (++ringHead >= ringSize) {
+        ringHead = 0;
+    }
+    if (ringCount < ringSize) {
+        ringCount++;
+    }
+}
+
+/**
+ * Capture while armed in Autotune, a new maneuver restarts the capture
+ */
+static void FlightStatusUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    FlightStatusData flightStatus;
+
+    FlightStatusGet(&flightStatus);
+    bool tuning = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED && flightStatus.FlightMode == FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE;
+
+    if (tuning && captureState != SYSIDCAPTURE_STATE_CAPTURING) {
+        // Abandon the previous capture
+        captureState   = SYSIDCAPTURE_STATE_IDLE;
+        streamPending  = false;
+        ringHead       = 0;
+        ringCount      = 0;
+        lastSampleTime = PIOS_DELAY_GetRaw();
+        setState(SYSIDCAPTURE_STATE_CAPTURING);
+    } else if (!tuning && captureState == SYSIDCAPTURE_STATE_CAPTURING) {
+        setState(SYSIDCAPTURE_STATE_IDLE);
+        streamPending = ringCount > 0;
+    }
+}
+
+/**
+ * Stream the ring one block per run once disarmed with the GCS connected,
+ * the capture is kept and streamed again on every new GCS connection
+ */
+static void streamTask(void)
+{
+    uint8_t telemetryStatus;
+    uint8_t armed;
+
+    FlightTelemetryStatsStatusGet(&telemetryStatus);
+    FlightStatusArmedGet(&armed);
+    bool connected = telemetryStatus == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED;
+
+    if (connected && !gcsConnected && ringCount > 0) {
+        streamPending = true;
+    }
+    gcsConnected = connected;
+
+    if (captureState == SYSIDCAPTURE_STATE_IDLE && streamPending && connected && armed == FLIGHTSTATUS_ARMED_DISARMED) {
+        streamPending = false;
+        streamBlock   = 0;
+        captureState  = SYSIDCAPTURE_STATE_STREAMING;
+    }
+
+    if (captureState == SYSIDCAPTURE_STATE_STREAMING) {
+        uint16_t blocks = (ringCount + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES;
+        if (!connected || streamBlock >= blocks) {
+            setState(SYSIDCAPTURE_STATE_IDLE);
+        } else {
+            SysIdCaptureData capture;
+            memset(&capture, 0, sizeof(capture));
+            capture.State  = SYSIDCAPTURE_STATE_STREAMING;
+            capture.Block  = streamBlock;
+            capture.Blocks = blocks;
+
+            uint16_t first = streamBlock * BLOCK_SAMPLES;
+            capture.Samples = (ringCount - first) < BLOCK_SAMPLES ? (ringCount - first) : BLOCK_SAMPLES;
+            // the oldest sample held is at ringHead once the ring is full
+            uint32_t index  = (uint32_t)ringHead + ringSize - ringCount + first;
+            for (uint8_t i = 0; i < capture.Samples; i++, index++) {
+                const CaptureSample *sample = &ring[index % ringSize];
+                capture.DeltaTime[i]     = sample->deltaTime;
+                capture.GyroX[i]         = sample->gyro[0];
+                capture.GyroY[i]         = sample->gyro[1];
+                capture.GyroZ[i]         = sample->gyro[2];
+                capture.ActuatorRoll[i]  = sample->actuator[0];
+                capture.ActuatorPitch[i] = sample->actuator[1];
+                capture.ActuatorYaw[i]   = sample->actuator[2];
+            }
+            SysIdCaptureSet(&capture);
+            streamBlock++;
+        }
+    }
+
+    PIOS_CALLBACKSCHEDULER_Schedule(streamCBInfo, STREAM_PERIOD_MS, CALLBACK_UPDATEMODE_SOONER);
+}
+
+static void setState(uint8_t state)
+{
+    captureState = state;
+    SysIdCaptureStateSet(&state);
+}
+
+static int16_t scaleSample(float value, float scale)
+{
+    return (int16_t)boundf(value * scale, -32767.0f, 32767.0f);
+}
+
+#endif /* ifdef REVOLUTION */
+
+/**
+ * @}
+ * @}
+ */
@@ -32,6 +32,7 @@
 
 #include "openpilot.h"
 #include <pios_math.h>
+#include <sin_lookup.h>
 #include "stabilization.h"
 #include "stabilizationsettings.h"
 
@@ -90,8 +91,9 @@ int stabilization_virtual_flybar(float gyro, float command, float *output, float
  */
 int stabilization_virtual_flybar_pirocomp(float z_gyro, float dT)
 {
-    float cy = cosf(DEG2RAD(z_gyro) * dT);
-    float sy = sinf(DEG2RAD(z_gyro) * dT);
+    float cy, sy;
+
+    sincos_lookup_deg(z_gyro * dT, &sy, &cy);
 
     float vbar_pitch = cy * vbar_integral[1] - sy * vbar_integral[0];
     float vbar_roll  = sy * vbar_integral[1] + cy * vbar_integral[0];
@@ -37,10 +37,14 @@
 #include <attitudestate.h>
 #include <systemalarms.h>
 #include <homelocation.h>
+#include <callbackinfo.h>
 
 #include <insgps.h>
 #include <CoordinateConversions.h>
 
+#define PIOS_INSTRUMENT_MODULE
+#include <pios_instrumentation_helper.h>
+
 // Private constants
 
 #define STACK_REQUIRED 2048
@@ -49,6 +53,15 @@
 #define DT_MAX         1.0f
 #define DT_INIT        (1.0f / PIOS_SENSOR_RATE) // initialize with board sensor rate
 
+// the correction callback must run in the task of StateEstimation, so that
+// it never preempts the prediction and the filter needs no locking
+#define CORRECTION_PRIORITY CALLBACK_PRIORITY_LOW
+#define CORRECTION_TASK     CALLBACK_TASK_FLIGHTCONTROL
+
+// sensors used by the correction step
+#define CORRECTION_SENSORS \
+    (SENSORUPDATES_mag | SENSORUPDATES_baro | SENSORUPDATES_pos | SENSORUPDATES_vel | SENSORUPDATES_airspeed)
+
 #define IMPORT_SENSOR_IF_UPDATED(shortname, num) \
     if (IS_SET(state->updated, SENSORUPDATES_##shortname)) { \
         uint8_t t; \
@@ -71,10 +84,19 @@ struct data {
     bool inited;
 
     PiOSDeltatimeConfig dtconfig;
+
+    // time accumulated by the state predictions since the last covariance prediction
+    float   covarianceDT;
+    uint8_t covarianceCount;
 };
 
 // Private variables
 static bool initialized = 0;
+static DelayedCallbackInfo *correctionCallback;
+static struct data *correctionData;
+
+// Time spent in the state and covariance predictions, the bulk of the filter
+PERF_DEFINE_COUNTER(counterPrediction);
 
 
 // Private functions
@@ -83,6 +105,9 @@ static int32_t init13i(stateFilter *self);
 static int32_t init13(stateFilter *self);
 static int32_t maininit(stateFilter *self);
 static filterResult filter(stateFilter *self, stateEstimation *state);
+static void covariancePrediction(struct data *this);
+static void correction(struct data *this);
+static void correctionCb(void);
 static inline bool invalid_var(float data);
 
 static void globalInit(void);
@@ -95,6 +120,7 @@ static void globalInit(void)
         EKFConfigurationInitialize();
         EKFStateVarianceInitialize();
         HomeLocationInitialize();
+        correctionCallback = PIOS_CALLBACKSCHEDULER_Create(&correctionCb, CORRECTION_PRIORITY, CORRECTION_TASK, CALLBACKINFO_RUNNING_EKFCORRECTION, STACK_REQUIRED);
     }
 }
 
@@ -158,7 +184,10 @@ static int32_t maininit(stateFilter *self)
     this->inited       = false;
     this->init_stage   = 0;
     this->work.updated = 0;
+    this->covarianceDT = 0.0f;
+    this->covarianceCount = 0;
     PIOS_DELTATIME_Init(&this->dtconfig, DT_INIT, DT_MIN, DT_MAX, DT_ALPHA);
+    PERF_INIT_STATS_COUNTER(counterPrediction, 0x45000001);
 
     EKFConfigurationGet(&this->ekfConfiguration);
     int t;
@@ -184,7 +213,12 @@ static int32_t maininit(stateFilter *self)
     if ((this->homeLocation.Be[0] * this->homeLocation.Be[0] + this->homeLocation.Be[1] * this->homeLocation.Be[1] + this->homeLocation.Be[2] * this->homeLocation.Be[2] < 1e-5f)) {
         return 2;
     }
+    if (this->ekfConfiguration.CovarianceDecimation < 1) {
+        this->ekfConfiguration.CovarianceDecimation = 1;
+    }
 
+    // the correction callback works on the filter initialised last
+    correctionData = this;
 
     return 0;
 }
@@ -200,15 +234,12 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
 
     // Perform the update
     float dT;
-    uint16_t sensors = 0;
 
     this->work.updated |= state->updated;
 
     // check magnetometer alarm, discard any magnetometer readings if not OK
     // during initialization phase (but let them through afterwards)
-    SystemAlarmsAlarmData alarms;
-    SystemAlarmsAlarmGet(&alarms);
-    if (alarms.Magnetometer != SYSTEMALARMS_ALARM_OK && !this->inited) {
+    if (AlarmsGet(SYSTEMALARMS_ALARM_MAGNETOMETER) != SYSTEMALARMS_ALARM_OK && !this->inited) {
         UNSET_MASK(state->updated, SENSORUPDATES_mag);
         UNSET_MASK(this->work.updated, SENSORUPDATES_mag);
     }
@@ -334,6 +365,7 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
     float gyros[3] = { DEG2RAD(this->work.gyro[0]), DEG2RAD(this->work.gyro[1]), DEG2RAD(this->work.gyro[2]) };
 
     // Advance the state estimate
+    PERF_TIMED_SECTION_START(counterPrediction);
     INSStatePrediction(gyros, this->work.accel, dT);
 
     // Copy the attitude into the state
@@ -353,8 +385,64 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
     state->vel[2]   = Nav.Vel[2];
     state->updated |= SENSORUPDATES_attitude | SENSORUPDATES_pos | SENSORUPDATES_vel;
 
-    // Advance the covariance estimate
-    INSCovariancePrediction(dT);
+    // Advance the covariance estimate, decimated
+    this->covarianceDT += dT;
+    if (++this->covarianceCount >= this->ekfConfiguration.CovarianceDecimation) {
+        covariancePrediction(this);
+    }
+    PERF_TIMED_SECTION_END(counterPrediction);
+
+    if (this->ekfConfiguration.CorrectionMode == EKFCONFIGURATION_CORRECTIONMODE_CALLBACK) {
+        // the prediction sensors have been used, the others are kept for the correction
+        UNSET_MASK(this->work.updated, ~CORRECTION_SENSORS);
+        if (this->work.updated) {
+            PIOS_CALLBACKSCHEDULER_Dispatch(correctionCallback);
+        }
+    } else {
+        correction(this);
+        // all sensor data has been used, reset!
+        this->work.updated = 0;
+    }
+
+    if (this->init_stage < 0) {
+        return FILTERRESULT_WARNING;
+    } else {
+        return FILTERRESULT_OK;
+    }
+}
+
+/**
+ * Covariance prediction over the time accumulated by the state predictions
+ */
+static void covariancePrediction(struct data *this)
+{
+    if (this->covarianceCount) {
+        INSCovariancePrediction(this->covarianceDT);
+        this->covarianceDT    = 0.0f;
+        this->covarianceCount = 0;
+    }
+}
+
+/**
+ * Correction callback, runs the corrections with the sensor data collected since the last one
+ */
+static void correctionCb(void)
+{
+    struct data *this = correctionData;
+
+    if (!this || !this->inited || !this->work.updated) {
+        return;
+    }
+    correction(this);
+    UNSET_MASK(this->work.updated, CORRECTION_SENSORS);
+}
+
+/**
+ * Correction step with the updated sensors in this->work
+ */
+static void correction(struct data *this)
+{
+    uint16_t sensors = 0;
 
     if (IS_SET(this->work.updated, SENSORUPDATES_mag)) {
         sensors |= MAG_SENSORS;
@@ -415,7 +503,13 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
      * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
      * although probably should occur within INS itself
      */
+    // only real GPS fixes are gated, the indoor and airspeed fakes have to be taken as they are
+    INSSetGpsGate(this->usePos ? this->ekfConfiguration.GPSGate.Position : 0.0f,
+                  (this->usePos && IS_SET(this->work.updated, SENSORUPDATES_vel)) ? this->ekfConfiguration.GPSGate.Velocity : 0.0f);
+
     if (sensors) {
+        // the covariance has to be up to date for the gain
+        covariancePrediction(this);
         INSCorrection(this->work.mag, this->work.pos, this->work.vel, this->work.baro[0], sensors);
     }
 
@@ -431,15 +525,6 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
             break;
         }
     }
-
-    // all sensor data has been used, reset!
-    this->work.updated = 0;
-
-    if (this->init_stage < 0) {
-        return FILTERRESULT_WARNING;
-    } else {
-        return FILTERRESULT_OK;
-    }
 }
 
 // check for invalid variance values
@@ -44,8 +44,7 @@
 struct data {
     GPSSettingsData  settings;
     HomeLocationData home;
-    double HomeECEF[3];
-    float HomeRne[3][3];
+    struct CoordinateBase base;
 };
 
 // Private variables
@@ -61,6 +60,9 @@ int32_t filterLLAInitialize(stateFilter *handle)
     handle->init      = &init;
     handle->filter    = &filter;
     handle->localdata = pios_malloc(sizeof(struct data));
+    if (handle->localdata) {
+        memset(handle->localdata, 0, sizeof(struct data));
+    }
     GPSSettingsInitialize();
     GPSPositionSensorInitialize();
     HomeLocationInitialize();
@@ -74,14 +76,13 @@ static int32_t init(__attribute__((unused)) stateFilter *self)
     GPSSettingsGet(&this->settings);
     HomeLocationGet(&this->home);
     if (this->home.Set == HOMELOCATION_SET_TRUE) {
-        // calculate home location coordinate reference
+        // calculate home location coordinate reference, only refreshed when it moved
         int32_t LLAi[3] = {
             this->home.Latitude,
             this->home.Longitude,
             (int32_t)(this->home.Altitude * 1e4f),
         };
-        LLA2ECEF(LLAi, this->HomeECEF);
-        RneFromLLA(LLAi, this->HomeRne);
+        BaseFromLLA(LLAi, &this->base);
     }
     return 0;
 }
@@ -111,7 +112,8 @@ static filterResult filter(__attribute__((unused)) stateFilter *self, stateEstim
                 gpsdata.Longitude,
                 (int32_t)((gpsdata.Altitude + gpsdata.GeoidSeparation) * 1e4f),
             };
-            LLA2Base(LLAi, this->HomeECEF, this->HomeRne, state->pos);
+            // flat earth near home, within COORDINATE_FLAT_EARTH_MAX_ERROR of the exact conversion
+            LLA2BaseFlat(LLAi, &this->base, state->pos);
             state->updated |= SENSORUPDATES_pos;
         }
     }
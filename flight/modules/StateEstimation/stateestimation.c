@@ -55,6 +55,7 @@
 #include "flightstatus.h"
 
 #include "CoordinateConversions.h"
+#include <sensorsample.h>
 
 // Private constants
 #define STACK_SIZE_BYTES        256
@@ -107,10 +108,10 @@
     }
 
 // local macros, ONLY to be used in the middle of StateEstimationCb in section RUNSTATE_SAVE before the check of alarms!
+// the state objects only hold what the estimator writes, so they are set without a Get first
 #define EXPORT_STATE_TO_UAVOBJECT_IF_UPDATED_3_DIMENSIONS(statename, shortname, a1, a2, a3) \
     if (IS_SET(states.updated, SENSORUPDATES_##shortname)) { \
         statename##Data s; \
-        statename##Get(&s); \
         s.a1 = states.shortname[0]; \
         s.a2 = states.shortname[1]; \
         s.a3 = states.shortname[2]; \
@@ -120,7 +121,6 @@
 #define EXPORT_STATE_TO_UAVOBJECT_IF_UPDATED_2_DIMENSIONS(statename, shortname, a1, a2) \
     if (IS_SET(states.updated, SENSORUPDATES_##shortname)) { \
         statename##Data s; \
-        statename##Get(&s); \
         s.a1 = states.shortname[0]; \
         s.a2 = states.shortname[1]; \
         statename##Set(&s); \
@@ -161,6 +161,10 @@ static stateFilter ekf13Filter;
 static float gyroRaw[3];
 static float gyroDelta[3];
 
+// sequence numbers of the last gyro and accel sample taken from the direct channel
+static uint32_t sensorSampleSeq;
+static uint32_t gyroShortcutSeq;
+
 // preconfigured filter chains selectable via revoSettings.FusionAlgorithm
 static const filterPipeline *cfQueue = &(filterPipeline) {
     .filter = &airFilter,
@@ -254,8 +258,10 @@ static const filterPipeline *ekf13Queue = &(filterPipeline) {
 
 static void settingsUpdatedCb(UAVObjEvent *objEv);
 static void sensorUpdatedCb(UAVObjEvent *objEv);
+static void gyroSensorUpdatedCb(UAVObjEvent *objEv);
 static void homeLocationUpdatedCb(UAVObjEvent *objEv);
 static void StateEstimationCb(void);
+static bool loadSensorSample(stateEstimation *states);
 
 static inline int32_t maxint32_t(int32_t a, int32_t b)
 {
@@ -294,7 +300,8 @@ int32_t StateEstimationInitialize(void)
 
     HomeLocationConnectCallback(&homeLocationUpdatedCb);
 
-    GyroSensorConnectCallback(&sensorUpdatedCb);
+    // GyroState is updated right away, in the context of the GyroSensor setter
+    GyroSensorConnectFastCallback(&gyroSensorUpdatedCb);
     AccelSensorConnectCallback(&sensorUpdatedCb);
     MagSensorConnectCallback(&sensorUpdatedCb);
     BaroSensorConnectCallback(&sensorUpdatedCb);
@@ -427,13 +434,16 @@ static void StateEstimationCb(void)
         updatedSensors = 0;
 
         // fetch sensors, check values, and load into state struct
-        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(GyroSensor, gyro, x, y, z);
+        // gyro and accel come from the direct channel when Sensors publishes there
+        if (!loadSensorSample(&states)) {
+            FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(GyroSensor, gyro, x, y, z);
+            FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(AccelSensor, accel, x, y, z);
+        }
         if (IS_SET(states.updated, SENSORUPDATES_gyro)) {
             gyroRaw[0] = states.gyro[0];
             gyroRaw[1] = states.gyro[1];
             gyroRaw[2] = states.gyro[2];
         }
-        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(AccelSensor, accel, x, y, z);
         FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(MagSensor, boardMag, x, y, z);
         FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(AuxMagSensor, auxMag, x, y, z);
         FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(GPSVelocitySensor, vel, North, East, Down);
@@ -482,7 +492,6 @@ static void StateEstimationCb(void)
         if (IS_SET(states.updated, SENSORUPDATES_mag)) {
             MagStateData s;
 
-            MagStateGet(&s);
             s.x = states.mag[0];
             s.y = states.mag[1];
             s.z = states.mag[2];
@@ -505,7 +514,6 @@ static void StateEstimationCb(void)
         // attitude nees manual conversion from quaternion to euler
         if (IS_SET(states.updated, SENSORUPDATES_attitude)) { \
             AttitudeStateData s;
-            AttitudeStateGet(&s);
             s.q1 = states.attitude[0];
             s.q2 = states.attitude[1];
             s.q3 = states.attitude[2];
@@ -552,6 +560,44 @@ static void StateEstimationCb(void)
 }
 
 
+/**
+ * Load gyro and accel from the direct sensor sample channel on a gyro update
+ * \return true if a new sample was loaded, false if the sensor UAVObjects have to be read
+ * (no Sensors module publishing there, or the objects were set by someone else)
+ */
+static bool loadSensorSample(stateEstimation *states)
+{
+    sensorsample_t sample;
+    uint32_t seq;
+
+    if (!IS_SET(states->updated, SENSORUPDATES_gyro)) {
+        return false;
+    }
+    seq = sensorsample_get(&sample);
+    if (!seq || seq == sensorSampleSeq) {
+        return false;
+    }
+    sensorSampleSeq = seq;
+
+    if (IS_REAL(sample.gyro[0]) && IS_REAL(sample.gyro[1]) && IS_REAL(sample.gyro[2])) {
+        states->gyro[0] = sample.gyro[0];
+        states->gyro[1] = sample.gyro[1];
+        states->gyro[2] = sample.gyro[2];
+    } else {
+        UNSET_MASK(states->updated, SENSORUPDATES_gyro);
+    }
+    // the accel of the sample goes with the gyro, even if its own update has not been seen yet
+    if (IS_REAL(sample.accel[0]) && IS_REAL(sample.accel[1]) && IS_REAL(sample.accel[2])) {
+        states->accel[0] = sample.accel[0];
+        states->accel[1] = sample.accel[1];
+        states->accel[2] = sample.accel[2];
+        states->updated |= SENSORUPDATES_accel;
+    } else {
+        UNSET_MASK(states->updated, SENSORUPDATES_accel);
+    }
+    return true;
+}
+
 /**
  * Callback for eventdispatcher when RevoSettings has been updated
  */
@@ -572,25 +618,42 @@ static void homeLocationUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 
 
 /**
- * Callback for eventdispatcher when any sensor UAVObject has been updated
- * updates the list of "recently updated UAVObjects" and dispatches the state estimator callback
+ * Fast callback invoked by the GyroSensor setter, updates GyroState right away so that the
+ * stabilization does not wait for the event dispatcher. Must remain short and never block.
  */
-static void sensorUpdatedCb(UAVObjEvent *ev)
+static void gyroSensorUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
-    if (!ev) {
-        return;
-    }
-
-    if (ev->obj == GyroSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_gyro;
-        // shortcut - update GyroState right away
+    updatedSensors |= SENSORUPDATES_gyro;
+    // shortcut - update GyroState right away
+    GyroStateData t;
+    sensorsample_t sample;
+    uint32_t seq = sensorsample_get(&sample);
+    // an update without a new sample has been set by someone else than Sensors
+    if (seq && seq != gyroShortcutSeq) {
+        gyroShortcutSeq = seq;
+        t.x = sample.gyro[0] + gyroDelta[0];
+        t.y = sample.gyro[1] + gyroDelta[1];
+        t.z = sample.gyro[2] + gyroDelta[2];
+    } else {
         GyroSensorData s;
-        GyroStateData t;
         GyroSensorGet(&s);
         t.x = s.x + gyroDelta[0];
         t.y = s.y + gyroDelta[1];
         t.z = s.z + gyroDelta[2];
-        GyroStateSet(&t);
+    }
+    GyroStateSet(&t);
+
+    PIOS_CALLBACKSCHEDULER_Dispatch(stateEstimationCallback);
+}
+
+/**
+ * Callback for eventdispatcher when any sensor UAVObject has been updated
+ * updates the list of "recently updated UAVObjects" and dispatches the state estimator callback
+ */
+static void sensorUpdatedCb(UAVObjEvent *ev)
+{
+    if (!ev) {
+        return;
     }
 
     if (ev->obj == AccelSensorHandle()) {
@@ -49,6 +49,8 @@
 
 // UAVOs
 #include <objectpersistence.h>
+#include <objectpersistencebatch.h>
+#include <objecthashes.h>
 #include <flightstatus.h>
 #include <systemstats.h>
 #include <systemsettings.h>
@@ -56,6 +58,8 @@
 #include <taskinfo.h>
 #include <watchdogstatus.h>
 #include <callbackinfo.h>
+#include <callbacktiming.h>
+#include <rategovernor.h>
 #include <hwsettings.h>
 #include <pios_flashfs.h>
 #include <pios_notify.h>
@@ -92,31 +96,130 @@
 
 #define TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
 
+// the alarms and the diagnostics are updated in slices taking turns, each update runs as many
+// slices as fit in SYSTEM_SLICE_BUDGET_US, at least one and at most all of them once
+#if defined(PIOS_SYSTEM_SLICE_BUDGET_US)
+#define SYSTEM_SLICE_BUDGET_US  PIOS_SYSTEM_SLICE_BUDGET_US
+#else
+#define SYSTEM_SLICE_BUDGET_US  1000
+#endif
+// tasks reported per slice of the task status walk, each needs a scan of the task stack
+#define SYSTEM_TASKS_PER_SLICE  4
+
+// flash filesystem garbage collection runs in small steps as a low priority callback
+#define FLASHFS_GC_PRIORITY     CALLBACK_PRIORITY_LOW
+#define FLASHFS_GC_TASK         CALLBACK_TASK_AUXILIARY
+#define FLASHFS_GC_STACK_SIZE   256
+#define FLASHFS_GC_PERIOD_MS    10
+
+// ObjectPersistence requests are captured on receipt and run by a callback, the single object
+// saves received within PERSISTENCE_BATCH_DELAY_MS of each other are written in one flash transaction
+// and acknowledged at once by the completion of the last one
+#define PERSISTENCE_PRIORITY       CALLBACK_PRIORITY_LOW
+#define PERSISTENCE_TASK           CALLBACK_TASK_AUXILIARY
+#define PERSISTENCE_STACK_SIZE     640
+#define PERSISTENCE_BATCH_DELAY_MS 20
+#define PERSISTENCE_MAX_PENDING    8
+// after a failure every request fails until none was received for PERSISTENCE_ERROR_HOLD_MS,
+// so that a failure is never hidden by the completion of a request sent before it was seen
+#define PERSISTENCE_ERROR_HOLD_MS  250
+
+// non critical loops are slowed down by up to RATEGOVERNOR_MAX_DIVIDER when the cpu load is above
+// CPULOAD_LIMIT_WARNING, one step per RATEGOVERNOR_LOWER_PERIODS updates, and sped up again one
+// step after RATEGOVERNOR_RAISE_PERIODS updates below CPULOAD_LIMIT_WARNING - RATEGOVERNOR_HYSTERESIS
+#define RATEGOVERNOR_MAX_DIVIDER    4
+#define RATEGOVERNOR_LOWER_PERIODS  4
+#define RATEGOVERNOR_RAISE_PERIODS  8
+#define RATEGOVERNOR_HYSTERESIS     15
+
 // Private types
+// an ObjectPersistence request waiting for the persistence callback
+struct persistenceRequest {
+    uint32_t ObjectID;
+    uint32_t InstanceID;
+    ObjectPersistenceOperationOptions Operation;
+    ObjectPersistenceSelectionOptions Selection;
+};
+// a slice returns true while it has work left, it is then run again before the next one
+typedef bool (*SystemSlice)(void);
 
 // Private variables
 static xTaskHandle systemTaskHandle;
 static xQueueHandle objectPersistenceQueue;
+static DelayedCallbackInfo *persistenceCallback;
+static xSemaphoreHandle persistenceLock;
+static struct persistenceRequest persistencePending[PERSISTENCE_MAX_PENDING];
+static uint8_t persistencePendingCount;
+static bool persistenceFailed;
+static uint32_t persistenceLastRequest;
+static ObjectPersistenceBatchData persistenceBatch;
+static bool persistenceBatchPending;
 static enum { STACKOVERFLOW_NONE = 0, STACKOVERFLOW_WARNING = 1, STACKOVERFLOW_CRITICAL = 3 } stackOverflow;
 static bool mallocFailed;
 static HwSettingsData bootHwSettings;
 static FrameType_t bootFrameType;
 static struct PIOS_FLASHFS_Stats fsStats;
+static DelayedCallbackInfo *flashFSGCCallback;
+static ObjectHashesData *hashesPage;
+static uint16_t hashesIndex;
 
 // Private functions
 static void objectUpdatedCb(UAVObjEvent *ev);
+static void objectPersistenceRequestCb(UAVObjEvent *ev);
+static void objectPersistenceBatchRequestCb(UAVObjEvent *ev);
+static void persistenceCb();
+static int32_t persistenceExecute(const struct persistenceRequest *request);
+static void persistenceReply(const struct persistenceRequest *request, int32_t retval);
+static void persistenceBatchExecute(ObjectPersistenceBatchData *batch, uint8_t armed);
+static void objectHashesUpdated();
+static void hashObject(UAVObjHandle obj);
 static void checkSettingsUpdatedCb(UAVObjEvent *ev);
 #ifdef DIAG_TASKS
 static void taskMonitorForEachCallback(uint16_t task_id, const struct pios_task_info *task_info, void *context);
 static void callbackSchedulerForEachCallback(int16_t callback_id, const struct pios_callback_info *callback_info, void *context);
+#ifdef DIAG_CALLBACK_TIMING
+static void updateCallbackTiming(int16_t callback_id, const struct pios_callback_info *callback_info);
+#endif
 #endif
 static void updateStats();
+static void updateRateGovernor();
+static void flashFSGCCb();
 static void updateSystemAlarms();
+static void runSystemSlices();
+static bool systemAlarmsSlice();
 static void systemTask(void *parameters);
 #ifdef DIAG_I2C_WDG_STATS
 static void updateI2Cstats();
 static void updateWDGstats();
+static bool diagStatsSlice();
+#endif
+#ifdef PIOS_INCLUDE_INSTRUMENTATION
+static bool instrumentationSlice();
+#endif
+#ifdef DIAG_TASKS
+static bool taskInfoSlice();
+static bool callbackInfoSlice();
+#endif
+#if defined(PIOS_INCLUDE_RFM22B)
+static bool oplinkStatusSlice();
+#endif
+
+static const SystemSlice systemSlices[] = {
+    systemAlarmsSlice,
+#ifdef DIAG_I2C_WDG_STATS
+    diagStatsSlice,
+#endif
+#ifdef PIOS_INCLUDE_INSTRUMENTATION
+    instrumentationSlice,
 #endif
+#ifdef DIAG_TASKS
+    taskInfoSlice,
+    callbackInfoSlice,
+#endif
+#if defined(PIOS_INCLUDE_RFM22B)
+    oplinkStatusSlice,
+#endif
+};
 
 extern uintptr_t pios_uavo_settings_fs_id;
 extern uintptr_t pios_user_fs_id;
@@ -147,11 +250,17 @@ int32_t SystemModInitialize(void)
     // Must registers objects here for system thread because ObjectManager started in OpenPilotInit
     SystemSettingsInitialize();
     SystemStatsInitialize();
+    RateGovernorInitialize();
     FlightStatusInitialize();
     ObjectPersistenceInitialize();
+    ObjectPersistenceBatchInitialize();
+    ObjectHashesInitialize();
 #ifdef DIAG_TASKS
     TaskInfoInitialize();
     CallbackInfoInitialize();
+#ifdef DIAG_CALLBACK_TIMING
+    CallbackTimingInitialize();
+#endif
 #endif
 #ifdef DIAG_I2C_WDG_STATS
     I2CStatsInitialize();
@@ -162,11 +271,23 @@ int32_t SystemModInitialize(void)
     InstrumentationInit();
 #endif
 
+    // one event for ObjectHashes
     objectPersistenceQueue = xQueueCreate(1, sizeof(UAVObjEvent));
     if (objectPersistenceQueue == NULL) {
         return -1;
     }
 
+    persistenceLock     = xSemaphoreCreateMutex();
+    persistenceCallback = PIOS_CALLBACKSCHEDULER_Create(&persistenceCb, PERSISTENCE_PRIORITY, PERSISTENCE_TASK, -1, PERSISTENCE_STACK_SIZE);
+    if (persistenceLock == NULL || persistenceCallback == NULL) {
+        return -1;
+    }
+
+    flashFSGCCallback = PIOS_CALLBACKSCHEDULER_Create(&flashFSGCCb, FLASHFS_GC_PRIORITY, FLASHFS_GC_TASK, -1, FLASHFS_GC_STACK_SIZE);
+    if (flashFSGCCallback == NULL) {
+        return -1;
+    }
+
     SystemModStart();
 
     return 0;
@@ -195,8 +316,10 @@ static void systemTask(__attribute__((unused)) void *parameters)
     /* Record a successful boot */
     PIOS_IAP_WriteBootCount(0);
 #endif
-    // Listen for SettingPersistance object updates, connect a callback function
-    ObjectPersistenceConnectQueue(objectPersistenceQueue);
+    // Listen for SettingPersistance object updates, the requests are captured as they are received
+    ObjectPersistenceConnectFastCallback(objectPersistenceRequestCb);
+    ObjectPersistenceBatchConnectFastCallback(objectPersistenceBatchRequestCb);
+    ObjectHashesConnectQueue(objectPersistenceQueue);
 
     // Load a copy of HwSetting active at boot time
     HwSettingsGet(&bootHwSettings);
@@ -205,99 +328,25 @@ static void systemTask(__attribute__((unused)) void *parameters)
     HwSettingsConnectCallback(checkSettingsUpdatedCb);
     SystemSettingsConnectCallback(checkSettingsUpdatedCb);
 
-#ifdef DIAG_TASKS
-    TaskInfoData taskInfoData;
-    CallbackInfoData callbackInfoData;
-#endif
     // Main system loop
     while (1) {
         NotificationUpdateStatus();
         // Update the system statistics
         updateStats();
-        // Update the system alarms
-        updateSystemAlarms();
-#ifdef DIAG_I2C_WDG_STATS
-        updateI2Cstats();
-        updateWDGstats();
-#endif
-
-#ifdef PIOS_INCLUDE_INSTRUMENTATION
-        InstrumentationPublishAllCounters();
-#endif
-
-#ifdef DIAG_TASKS
-        // Update the task status object
-        PIOS_TASK_MONITOR_ForEachTask(taskMonitorForEachCallback, &taskInfoData);
-        TaskInfoSet(&taskInfoData);
-        // Update the callback status object
-// if(FALSE){
-        PIOS_CALLBACKSCHEDULER_ForEachCallback(callbackSchedulerForEachCallback, &callbackInfoData);
-        CallbackInfoSet(&callbackInfoData);
-// }
-#endif
-// }
-
+        // Adapt the rate of the non critical loops to the cpu load
+        updateRateGovernor();
+        // Let the flash filesystems check whether they need garbage collection
+        PIOS_CALLBACKSCHEDULER_Dispatch(flashFSGCCallback);
+        // Update the system alarms and the diagnostics, as many slices as fit in the time budget
+        runSystemSlices();
+        // Write the alarms changed since the last loop to SystemAlarms
+        AlarmsPublish();
 
         UAVObjEvent ev;
         int delayTime = SYSTEM_UPDATE_PERIOD_MS;
 
-#if defined(PIOS_INCLUDE_RFM22B)
-
-        // Update the OPLinkStatus UAVO
-        OPLinkStatusData oplinkStatus;
-        OPLinkStatusGet(&oplinkStatus);
-
-        if (pios_rfm22b_id) {
-            // Get the other device stats.
-            PIOS_RFM2B_GetPairStats(pios_rfm22b_id, oplinkStatus.PairIDs, oplinkStatus.PairSignalStrengths, OPLINKSTATUS_PAIRIDS_NUMELEM);
-
-            // Get the stats from the radio device
-            struct rfm22b_stats radio_stats;
-            PIOS_RFM22B_GetStats(pios_rfm22b_id, &radio_stats);
-
-            // Update the OPLInk status
-            static bool first_time = true;
-            static uint16_t prev_tx_count = 0;
-            static uint16_t prev_rx_count = 0;
-            oplinkStatus.HeapRemaining = xPortGetFreeHeapSize();
-            oplinkStatus.DeviceID = PIOS_RFM22B_DeviceID(pios_rfm22b_id);
-            oplinkStatus.RxGood = radio_stats.rx_good;
-            oplinkStatus.RxCorrected   = radio_stats.rx_corrected;
-            oplinkStatus.RxErrors = radio_stats.rx_error;
-            oplinkStatus.RxMissed = radio_stats.rx_missed;
-            oplinkStatus.RxFailure     = radio_stats.rx_failure;
-            oplinkStatus.TxDropped     = radio_stats.tx_dropped;
-            oplinkStatus.TxResent = radio_stats.tx_resent;
-            oplinkStatus.TxFailure     = radio_stats.tx_failure;
-            oplinkStatus.Resets      = radio_stats.resets;
-            oplinkStatus.Timeouts    = radio_stats.timeouts;
-            oplinkStatus.RSSI        = radio_stats.rssi;
-            oplinkStatus.LinkQuality = radio_stats.link_quality;
-            if (first_time) {
-                first_time = false;
-            } else {
-                uint16_t tx_count = radio_stats.tx_byte_count;
-                uint16_t rx_count = radio_stats.rx_byte_count;
-                uint16_t tx_bytes = (tx_count < prev_tx_count) ? (0xffff - prev_tx_count + tx_count) : (tx_count - prev_tx_count);
-                uint16_t rx_bytes = (rx_count < prev_rx_count) ? (0xffff - prev_rx_count + rx_count) : (rx_count - prev_rx_count);
-                oplinkStatus.TXRate = (uint16_t)((float)(tx_bytes * 1000) / SYSTEM_UPDATE_PERIOD_MS);
-                oplinkStatus.RXRate = (uint16_t)((float)(rx_bytes * 1000) / SYSTEM_UPDATE_PERIOD_MS);
-                prev_tx_count = tx_count;
-                prev_rx_count = rx_count;
-            }
-            oplinkStatus.TXSeq     = radio_stats.tx_seq;
-            oplinkStatus.RXSeq     = radio_stats.rx_seq;
-
-            oplinkStatus.LinkState = radio_stats.link_state;
-        } else {
-            oplinkStatus.LinkState = OPLINKSTATUS_LINKSTATE_DISABLED;
-        }
-        OPLinkStatusSet(&oplinkStatus);
-
-#endif /* if defined(PIOS_INCLUDE_RFM22B) */
-
         if (xQueueReceive(objectPersistenceQueue, &ev, delayTime) == pdTRUE) {
-            // If object persistence is updated call the callback
+            // If object hashes are requested call the callback
             objectUpdatedCb(&ev);
         }
     }
@@ -307,97 +356,334 @@ static void systemTask(__attribute__((unused)) void *parameters)
  * Function called in response to object updates
  */
 static void objectUpdatedCb(UAVObjEvent *ev)
+{
+    if (ev->obj == ObjectHashesHandle()) {
+        objectHashesUpdated();
+    }
+}
+
+/**
+ * Called right away on ObjectPersistence updates, queues the request before the next
+ * one can overwrite it and schedules the persistence callback
+ */
+static void objectPersistenceRequestCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     ObjectPersistenceData objper;
-    UAVObjHandle obj;
 
-    // If the object updated was the ObjectPersistence execute requested action
-    if (ev->obj == ObjectPersistenceHandle()) {
-        // Get object data
-        ObjectPersistenceGet(&objper);
+    ObjectPersistenceGet(&objper);
+
+    // When this is called because of a reply don't do anything
+    if (objper.Operation == OBJECTPERSISTENCE_OPERATION_NOP ||
+        objper.Operation == OBJECTPERSISTENCE_OPERATION_ERROR ||
+        objper.Operation == OBJECTPERSISTENCE_OPERATION_COMPLETED) {
+        return;
+    }
+
+    struct persistenceRequest request = {
+        .ObjectID   = objper.ObjectID,
+        .InstanceID = objper.InstanceID,
+        .Operation  = objper.Operation,
+        .Selection  = objper.Selection,
+    };
+    bool bulk = (request.Operation == OBJECTPERSISTENCE_OPERATION_SAVE && request.Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT);
+    bool full = false;
+    uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
+
+    xSemaphoreTake(persistenceLock, portMAX_DELAY);
+    if (persistenceFailed && now - persistenceLastRequest > PERSISTENCE_ERROR_HOLD_MS) {
+        persistenceFailed = false;
+    }
+    persistenceLastRequest = now;
+
+    // a repeated save replaces the pending one, the last request received is acknowledged last
+    for (uint8_t i = 0; bulk && i < persistencePendingCount; i++) {
+        if (persistencePending[i].Operation == request.Operation && persistencePending[i].Selection == request.Selection &&
+            persistencePending[i].ObjectID == request.ObjectID && persistencePending[i].InstanceID == request.InstanceID) {
+            persistencePendingCount--;
+            memmove(&persistencePending[i], &persistencePending[i + 1], (persistencePendingCount - i) * sizeof(request));
+            break;
+        }
+    }
+    if (persistencePendingCount < PERSISTENCE_MAX_PENDING) {
+        persistencePending[persistencePendingCount++] = request;
+        full = (persistencePendingCount == PERSISTENCE_MAX_PENDING);
+    } else {
+        persistenceFailed = true;
+    }
+    xSemaphoreGive(persistenceLock);
+
+    if (full || !bulk) {
+        PIOS_CALLBACKSCHEDULER_Dispatch(persistenceCallback);
+    } else {
+        // wait for the following saves of a bulk write
+        PIOS_CALLBACKSCHEDULER_Schedule(persistenceCallback, PERSISTENCE_BATCH_DELAY_MS, CALLBACK_UPDATEMODE_LATER);
+    }
+}
+
+/**
+ * Called right away on ObjectPersistenceBatch updates, keeps the request until the
+ * persistence callback runs it
+ */
+static void objectPersistenceBatchRequestCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    uint8_t operation;
+
+    // When this is called because of a reply don't do anything
+    ObjectPersistenceBatchOperationGet(&operation);
+    if (operation != OBJECTPERSISTENCEBATCH_OPERATION_SAVE) {
+        return;
+    }
+
+    xSemaphoreTake(persistenceLock, portMAX_DELAY);
+    ObjectPersistenceBatchGet(&persistenceBatch);
+    persistenceBatchPending = true;
+    xSemaphoreGive(persistenceLock);
 
-        int retval = 1;
-        FlightStatusData flightStatus;
-        FlightStatusGet(&flightStatus);
+    PIOS_CALLBACKSCHEDULER_Dispatch(persistenceCallback);
+}
 
-        // When this is called because of this method don't do anything
-        if (objper.Operation == OBJECTPERSISTENCE_OPERATION_ERROR || objper.Operation == OBJECTPERSISTENCE_OPERATION_COMPLETED) {
-            return;
+/**
+ * Run the pending ObjectPersistence requests, in the order they were received.
+ * Consecutive single object saves are written in one flash transaction, then read back,
+ * the reply to the last one acknowledges them all.
+ */
+static void persistenceCb()
+{
+    struct persistenceRequest requests[PERSISTENCE_MAX_PENDING];
+    uint8_t count;
+
+    xSemaphoreTake(persistenceLock, portMAX_DELAY);
+    count = persistencePendingCount;
+    memcpy(requests, persistencePending, count * sizeof(requests[0]));
+    persistencePendingCount = 0;
+    xSemaphoreGive(persistenceLock);
+
+    uint8_t armed;
+    FlightStatusArmedGet(&armed);
+
+    for (uint8_t first = 0; first < count;) {
+        uint8_t last = first;
+        int32_t retval;
+
+        if (requests[first].Operation == OBJECTPERSISTENCE_OPERATION_SAVE &&
+            requests[first].Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
+            while (last + 1 < count && requests[last + 1].Operation == OBJECTPERSISTENCE_OPERATION_SAVE &&
+                   requests[last + 1].Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
+                last++;
+            }
         }
 
-        // Execute action if disarmed
-        if (flightStatus.Armed != FLIGHTSTATUS_ARMED_DISARMED) {
+        if (persistenceFailed || armed != FLIGHTSTATUS_ARMED_DISARMED) {
+            // Execute actions only if disarmed
             retval = -1;
-        } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_LOAD) {
-            if (objper.Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
-                // Get selected object
-                obj = UAVObjGetByID(objper.ObjectID);
-                if (obj == 0) {
-                    return;
-                }
-                // Load selected instance
-                retval = UAVObjLoad(obj, objper.InstanceID);
-            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
-                retval = UAVObjLoadSettings();
-            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
-                retval = UAVObjLoadMetaobjects();
+        } else if (last == first) {
+            retval = persistenceExecute(&requests[first]);
+        } else {
+            retval = UAVObjPersBegin();
+            for (uint8_t i = first; i <= last && retval == 0; i++) {
+                UAVObjHandle obj = UAVObjGetByID(requests[i].ObjectID);
+                retval = obj ? UAVObjSave(obj, requests[i].InstanceID) : -1;
+            }
+            if (UAVObjPersCommit() != 0) {
+                retval = -1;
+            }
+            // Verify saving worked
+            for (uint8_t i = first; i <= last && retval == 0; i++) {
+                retval = UAVObjLoad(UAVObjGetByID(requests[i].ObjectID), requests[i].InstanceID);
+            }
+        }
+
+        if (retval == -1) {
+            xSemaphoreTake(persistenceLock, portMAX_DELAY);
+            persistenceFailed = true;
+            xSemaphoreGive(persistenceLock);
+        }
+        persistenceReply(&requests[last], retval);
+        first = last + 1;
+    }
+
+    if (persistenceBatchPending) {
+        ObjectPersistenceBatchData batch;
+
+        xSemaphoreTake(persistenceLock, portMAX_DELAY);
+        batch = persistenceBatch;
+        persistenceBatchPending = false;
+        xSemaphoreGive(persistenceLock);
+
+        persistenceBatchExecute(&batch, armed);
+    }
+}
+
+/**
+ * Save the objects of an ObjectPersistenceBatch request in one flash transaction and
+ * reply with the objects that failed
+ */
+static void persistenceBatchExecute(ObjectPersistenceBatchData *batch, uint8_t armed)
+{
+    uint8_t count   = MIN(batch->Count, OBJECTPERSISTENCEBATCH_OBJECTID_NUMELEM);
+    uint16_t all    = (uint16_t)((1ul << count) - 1);
+    uint16_t failed = 0;
+
+    // Execute actions only if disarmed
+    if (armed != FLIGHTSTATUS_ARMED_DISARMED || UAVObjPersBegin() != 0) {
+        failed = all;
+    } else {
+        for (uint8_t i = 0; i < count; i++) {
+            UAVObjHandle obj = UAVObjGetByID(batch->ObjectID[i]);
+            if (obj == 0 || UAVObjSave(obj, batch->InstanceID[i]) != 0) {
+                failed |= 1 << i;
+            }
+        }
+        if (UAVObjPersCommit() != 0) {
+            failed = all;
+        }
+        // Verify saving worked
+        for (uint8_t i = 0; i < count; i++) {
+            if (!(failed & (1 << i)) && UAVObjLoad(UAVObjGetByID(batch->ObjectID[i]), batch->InstanceID[i]) != 0) {
+                failed |= 1 << i;
+            }
+        }
+    }
+
+    batch->Operation = OBJECTPERSISTENCEBATCH_OPERATION_COMPLETED;
+    batch->Failed    = failed;
+    ObjectPersistenceBatchSet(batch);
+}
+
+/**
+ * Execute a single ObjectPersistence request
+ * \return 0 on success, -1 on failure, 1 when there is no reply
+ */
+static int32_t persistenceExecute(const struct persistenceRequest *request)
+{
+    int32_t retval = 1;
+    UAVObjHandle obj;
+
+    if (request->Operation == OBJECTPERSISTENCE_OPERATION_LOAD) {
+        if (request->Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
+            // Get selected object
+            obj = UAVObjGetByID(request->ObjectID);
+            if (obj == 0) {
+                return -1;
             }
-        } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_SAVE) {
-            if (objper.Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
-                // Get selected object
-                obj = UAVObjGetByID(objper.ObjectID);
-                if (obj == 0) {
-                    return;
-                }
-                // Save selected instance
-                retval = UAVObjSave(obj, objper.InstanceID);
-
-                // Not sure why this is needed
-                vTaskDelay(10);
-
-                // Verify saving worked
-                if (retval == 0) {
-                    retval = UAVObjLoad(obj, objper.InstanceID);
-                }
-            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
-                retval = UAVObjSaveSettings();
-            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
-                retval = UAVObjSaveMetaobjects();
+            // Load selected instance
+            retval = UAVObjLoad(obj, request->InstanceID);
+        } else if (request->Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || request->Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
+            retval = UAVObjLoadSettings();
+        } else if (request->Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || request->Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
+            retval = UAVObjLoadMetaobjects();
+        }
+    } else if (request->Operation == OBJECTPERSISTENCE_OPERATION_SAVE) {
+        if (request->Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
+            // Get selected object
+            obj = UAVObjGetByID(request->ObjectID);
+            if (obj == 0) {
+                return -1;
+            }
+            // Save selected instance
+            retval = UAVObjSave(obj, request->InstanceID);
+
+            // Verify saving worked
+            if (retval == 0) {
+                retval = UAVObjLoad(obj, request->InstanceID);
             }
-        } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_DELETE) {
-            if (objper.Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
-                // Get selected object
-                obj = UAVObjGetByID(objper.ObjectID);
-                if (obj == 0) {
-                    return;
-                }
-                // Delete selected instance
-                retval = UAVObjDelete(obj, objper.InstanceID);
-            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
-                retval = UAVObjDeleteSettings();
-            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
-                retval = UAVObjDeleteMetaobjects();
+        } else if (request->Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || request->Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
+            retval = UAVObjSaveSettings();
+        } else if (request->Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || request->Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
+            retval = UAVObjSaveMetaobjects();
+        }
+    } else if (request->Operation == OBJECTPERSISTENCE_OPERATION_DELETE) {
+        if (request->Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
+            // Get selected object
+            obj = UAVObjGetByID(request->ObjectID);
+            if (obj == 0) {
+                return -1;
             }
-        } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_FULLERASE) {
+            // Delete selected instance
+            retval = UAVObjDelete(obj, request->InstanceID);
+        } else if (request->Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || request->Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
+            retval = UAVObjDeleteSettings();
+        } else if (request->Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || request->Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
+            retval = UAVObjDeleteMetaobjects();
+        }
+    } else if (request->Operation == OBJECTPERSISTENCE_OPERATION_FULLERASE) {
 #if defined(PIOS_INCLUDE_FLASH_LOGFS_SETTINGS)
-            retval = PIOS_FLASHFS_Format(0);
+        retval = PIOS_FLASHFS_Format(0);
 #else
-            retval = -1;
+        retval = -1;
 #endif
-        }
-        switch (retval) {
-        case 0:
-            objper.Operation = OBJECTPERSISTENCE_OPERATION_COMPLETED;
-            ObjectPersistenceSet(&objper);
-            break;
-        case -1:
-            objper.Operation = OBJECTPERSISTENCE_OPERATION_ERROR;
-            ObjectPersistenceSet(&objper);
-            break;
-        default:
-            break;
-        }
     }
+    return retval;
+}
+
+/**
+ * Report the result of a request, with its ObjectID and InstanceID
+ */
+static void persistenceReply(const struct persistenceRequest *request, int32_t retval)
+{
+    ObjectPersistenceData objper;
+
+    objper.ObjectID   = request->ObjectID;
+    objper.InstanceID = request->InstanceID;
+    objper.Selection  = request->Selection;
+
+    switch (retval) {
+    case 0:
+        objper.Operation = OBJECTPERSISTENCE_OPERATION_COMPLETED;
+        ObjectPersistenceSet(&objper);
+        break;
+    case -1:
+        objper.Operation = OBJECTPERSISTENCE_OPERATION_ERROR;
+        ObjectPersistenceSet(&objper);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Fill the page of ObjectHashes requested by the gcs
+ */
+static void objectHashesUpdated()
+{
+    ObjectHashesData *hashes = (ObjectHashesData *)pios_malloc(sizeof(ObjectHashesData));
+
+    if (hashes == NULL) {
+        return;
+    }
+    ObjectHashesGet(hashes);
+
+    // When this is called because of this method don't do anything
+    if (hashes->Operation == OBJECTHASHES_OPERATION_REQUEST) {
+        memset(hashes->ObjectID, 0, sizeof(hashes->ObjectID));
+        memset(hashes->Hash, 0, sizeof(hashes->Hash));
+        hashesPage  = hashes;
+        hashesIndex = 0;
+        UAVObjIterate(&hashObject);
+        hashesPage  = NULL;
+
+        hashes->Pages     = (hashesIndex + OBJECTHASHES_OBJECTID_NUMELEM - 1) / OBJECTHASHES_OBJECTID_NUMELEM;
+        hashes->Operation = OBJECTHASHES_OPERATION_COMPLETED;
+        ObjectHashesSet(hashes);
+    }
+    pios_free(hashes);
+}
+
+/**
+ * Called for every object and metaobject, all the settings objects and metaobjects
+ * are numbered in the list order and the ones in the requested page are hashed
+ */
+static void hashObject(UAVObjHandle obj)
+{
+    if (!UAVObjIsMetaobject(obj) && !UAVObjIsSettings(obj)) {
+        return;
+    }
+    int32_t entry = (int32_t)hashesIndex - (int32_t)hashesPage->Page * OBJECTHASHES_OBJECTID_NUMELEM;
+    if (entry >= 0 && entry < OBJECTHASHES_OBJECTID_NUMELEM) {
+        hashesPage->ObjectID[entry] = UAVObjGetID(obj);
+        hashesPage->Hash[entry]     = UAVObjUpdateCRC32(obj, 0);
+    }
+    hashesIndex++;
 }
 
 /**
@@ -427,6 +713,7 @@ static void taskMonitorForEachCallback(uint16_t task_id, const struct pios_task_
     TaskInfoRunningToArray(taskData->Running)[task_id] = task_info->is_running ? TASKINFO_RUNNING_TRUE : TASKINFO_RUNNING_FALSE;
     ((uint16_t *)&taskData->StackRemaining)[task_id]   = task_info->stack_remaining;
     ((uint8_t *)&taskData->RunningTime)[task_id] = task_info->running_time_percentage;
+    ((uint16_t *)&taskData->MaxBurst)[task_id]   = task_info->max_burst_us > UINT16_MAX ? UINT16_MAX : task_info->max_burst_us;
 }
 
 static void callbackSchedulerForEachCallback(int16_t callback_id, const struct pios_callback_info *callback_info, void *context)
@@ -446,7 +733,47 @@ static void callbackSchedulerForEachCallback(int16_t callback_id, const struct p
     ((uint8_t *)&callbackData->Running)[callback_id] = callback_info->is_running;
     ((uint32_t *)&callbackData->RunningTime)[callback_id]   = callback_info->running_time_count;
     ((int16_t *)&callbackData->StackRemaining)[callback_id] = callback_info->stack_remaining;
+
+#ifdef DIAG_CALLBACK_TIMING
+    if (callback_info->latency && callback_info->runtime) {
+        updateCallbackTiming(callback_id, callback_info);
+    }
+#endif
+}
+
+#ifdef DIAG_CALLBACK_TIMING
+/**
+ * Publish the timing of a callback in the CallbackTiming instance matching its id
+ */
+static void updateCallbackTiming(int16_t callback_id, const struct pios_callback_info *callback_info)
+{
+    PIOS_STATIC_ASSERT(CALLBACKTIMING_LATENCYHISTOGRAM_NUMELEM == PIOS_CALLBACKSCHEDULER_TIMING_BUCKETS);
+    PIOS_STATIC_ASSERT(CALLBACKTIMING_RUNTIMEHISTOGRAM_NUMELEM == PIOS_CALLBACKSCHEDULER_TIMING_BUCKETS);
+
+    // instances are created the first time a callback reports
+    while (UAVObjGetNumInstances(CallbackTimingHandle()) <= callback_id) {
+        uint16_t instances = UAVObjGetNumInstances(CallbackTimingHandle());
+        CallbackTimingCreateInstance();
+        if (UAVObjGetNumInstances(CallbackTimingHandle()) == instances) {
+            return; // out of memory
+        }
+    }
+
+    const struct pios_callback_timing *latency = callback_info->latency;
+    const struct pios_callback_timing *runtime = callback_info->runtime;
+    CallbackTimingData timing;
+    timing.Runs = callback_info->running_time_count;
+    timing.Latency.Min  = latency->min;
+    timing.Latency.Max  = latency->max;
+    timing.Latency.Mean = latency->count ? latency->sum / latency->count : 0;
+    timing.Runtime.Min  = runtime->min;
+    timing.Runtime.Max  = runtime->max;
+    timing.Runtime.Mean = runtime->count ? runtime->sum / runtime->count : 0;
+    memcpy(timing.LatencyHistogram, latency->histogram, sizeof(timing.LatencyHistogram));
+    memcpy(timing.RuntimeHistogram, runtime->histogram, sizeof(timing.RuntimeHistogram));
+    CallbackTimingInstSet(callback_id, &timing);
 }
+#endif /* DIAG_CALLBACK_TIMING */
 #endif /* ifdef DIAG_TASKS */
 
 /**
@@ -551,6 +878,15 @@ static void updateStats()
         stats.UsrSlotsFree   = fsStats.num_free_slots;
         stats.UsrSlotsActive = fsStats.num_active_slots;
     }
+#endif
+#ifdef PIOS_INCLUDE_MEM_POOL
+    for (uint8_t i = 0; i < PIOS_MEM_POOL_NUM_CLASSES && i < SYSTEMSTATS_MEMPOOLFREE_NUMELEM; i++) {
+        struct pios_mem_pool_stats poolStats;
+        pios_pool_get_stats(i, &poolStats);
+        SystemStatsMemPoolFreeToArray(stats.MemPoolFree)[i]           = poolStats.free;
+        SystemStatsMemPoolMinFreeToArray(stats.MemPoolMinFree)[i]     = poolStats.min_free;
+        SystemStatsMemPoolFallbacksToArray(stats.MemPoolFallbacks)[i] = poolStats.fallbacks;
+    }
 #endif
     stats.CPULoad = 100 - PIOS_TASK_MONITOR_GetIdlePercentage();
 
@@ -561,6 +897,76 @@ static void updateStats()
     SystemStatsSet(&stats);
 }
 
+/**
+ * Lower the rate of the non critical loops while the cpu is overloaded, raise it back once there is headroom.
+ * A load above CPULOAD_LIMIT_CRITICAL means the critical loops are overrunning,
+ * the non critical loops drop to their lowest rate at once.
+ */
+static void updateRateGovernor()
+{
+    static uint8_t overloadPeriods = 0;
+    static uint8_t headroomPeriods = 0;
+    RateGovernorData governor;
+
+    RateGovernorGet(&governor);
+    SystemStatsCPULoadGet(&governor.CPULoad);
+
+    RateGovernorDecisionOptions decision = RATEGOVERNOR_DECISION_HOLD;
+    if (governor.CPULoad > CPULOAD_LIMIT_CRITICAL) {
+        if (governor.Divider < RATEGOVERNOR_MAX_DIVIDER) {
+            governor.Divider = RATEGOVERNOR_MAX_DIVIDER;
+            decision = RATEGOVERNOR_DECISION_LOWER;
+        }
+        overloadPeriods = 0;
+        headroomPeriods = 0;
+    } else if (governor.CPULoad > CPULOAD_LIMIT_WARNING) {
+        headroomPeriods = 0;
+        if (++overloadPeriods >= RATEGOVERNOR_LOWER_PERIODS) {
+            overloadPeriods = 0;
+            if (governor.Divider < RATEGOVERNOR_MAX_DIVIDER) {
+                governor.Divider++;
+                decision = RATEGOVERNOR_DECISION_LOWER;
+            }
+        }
+    } else if (governor.CPULoad + RATEGOVERNOR_HYSTERESIS < CPULOAD_LIMIT_WARNING) {
+        overloadPeriods = 0;
+        if (++headroomPeriods >= RATEGOVERNOR_RAISE_PERIODS) {
+            headroomPeriods = 0;
+            if (governor.Divider > 1) {
+                governor.Divider--;
+                decision = RATEGOVERNOR_DECISION_RAISE;
+            }
+        }
+    } else {
+        overloadPeriods = 0;
+        headroomPeriods = 0;
+    }
+
+    if (decision != RATEGOVERNOR_DECISION_HOLD || governor.Decision != RATEGOVERNOR_DECISION_HOLD) {
+        // only publish decisions, the consumers rescale their periods on updates
+        governor.Decision = decision;
+        RateGovernorSet(&governor);
+    }
+}
+
+/**
+ * Run one garbage collection step on each flash filesystem, rescheduled until all are done
+ */
+static void flashFSGCCb()
+{
+    bool pending = false;
+
+    if (pios_uavo_settings_fs_id) {
+        pending |= PIOS_FLASHFS_GarbageCollectStep(pios_uavo_settings_fs_id) > 0;
+    }
+    if (pios_user_fs_id) {
+        pending |= PIOS_FLASHFS_GarbageCollectStep(pios_user_fs_id) > 0;
+    }
+    if (pending) {
+        PIOS_CALLBACKSCHEDULER_Schedule(flashFSGCCallback, FLASHFS_GC_PERIOD_MS, CALLBACK_UPDATEMODE_SOONER);
+    }
+}
+
 /**
  * Update system alarms
  */
@@ -621,6 +1027,10 @@ static void updateSystemAlarms()
         AlarmsClear(SYSTEMALARMS_ALARM_EVENTSYSTEM);
     }
 
+    // Periodic updates fired late since the last check
+    SystemStatsEventSystemLateUpdatesSet(&evStats.lateUpdates);
+    SystemStatsEventSystemMaxLatenessSet(&evStats.maxLatenessMs);
+
     if (objStats.lastCallbackErrorID || objStats.lastQueueErrorID || evStats.lastErrorID) {
         SystemStatsData sysStats;
         SystemStatsGet(&sysStats);
@@ -631,6 +1041,143 @@ static void updateSystemAlarms()
     }
 }
 
+/**
+ * Run the slices from the one whose turn it is, until the time budget is spent or
+ * all of them ran once
+ */
+static void runSystemSlices()
+{
+    static uint8_t current = 0;
+    uint32_t start = PIOS_DELAY_GetRaw();
+    uint8_t completed  = 0;
+
+    do {
+        if (!systemSlices[current]()) {
+            current = (current + 1) % NELEMENTS(systemSlices);
+            completed++;
+        }
+    } while (completed < NELEMENTS(systemSlices) && PIOS_DELAY_DiffuS(start) < SYSTEM_SLICE_BUDGET_US);
+}
+
+static bool systemAlarmsSlice()
+{
+    updateSystemAlarms();
+    return false;
+}
+
+#ifdef DIAG_I2C_WDG_STATS
+static bool diagStatsSlice()
+{
+    updateI2Cstats();
+    updateWDGstats();
+    return false;
+}
+#endif
+
+#ifdef PIOS_INCLUDE_INSTRUMENTATION
+static bool instrumentationSlice()
+{
+    InstrumentationPublishAllCounters();
+    return false;
+}
+#endif
+
+#ifdef DIAG_TASKS
+/**
+ * Update the task status object, SYSTEM_TASKS_PER_SLICE tasks at a time
+ */
+static bool taskInfoSlice()
+{
+    static TaskInfoData taskInfoData;
+    static uint16_t nextTask = 0;
+
+    nextTask = PIOS_TASK_MONITOR_ForEachTaskFrom(nextTask, SYSTEM_TASKS_PER_SLICE, taskMonitorForEachCallback, &taskInfoData);
+    if (nextTask) {
+        return true;
+    }
+    // publish once all the tasks are updated
+    TaskInfoSet(&taskInfoData);
+    return false;
+}
+
+/**
+ * Update the callback status object
+ */
+static bool callbackInfoSlice()
+{
+    static CallbackInfoData callbackInfoData;
+
+    PIOS_CALLBACKSCHEDULER_ForEachCallback(callbackSchedulerForEachCallback, &callbackInfoData);
+    CallbackInfoSet(&callbackInfoData);
+    return false;
+}
+#endif /* ifdef DIAG_TASKS */
+
+#if defined(PIOS_INCLUDE_RFM22B)
+/**
+ * Update the OPLinkStatus UAVO
+ */
+static bool oplinkStatusSlice()
+{
+    OPLinkStatusData oplinkStatus;
+    OPLinkStatusGet(&oplinkStatus);
+
+    if (pios_rfm22b_id) {
+        // Get the other device stats.
+        PIOS_RFM2B_GetPairStats(pios_rfm22b_id, oplinkStatus.PairIDs, oplinkStatus.PairSignalStrengths, OPLINKSTATUS_PAIRIDS_NUMELEM);
+
+        // Get the stats from the radio device
+        struct rfm22b_stats radio_stats;
+        PIOS_RFM22B_GetStats(pios_rfm22b_id, &radio_stats);
+
+        // Update the OPLInk status
+        static bool first_time = true;
+        static uint16_t prev_tx_count = 0;
+        static uint16_t prev_rx_count = 0;
+        static uint32_t prev_time     = 0;
+        // the slices do not run at a fixed period, the rates are measured over the time since the last update
+        uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
+        uint32_t elapsed = (now - prev_time) ? : 1;
+        prev_time = now;
+        oplinkStatus.HeapRemaining = xPortGetFreeHeapSize();
+        oplinkStatus.DeviceID = PIOS_RFM22B_DeviceID(pios_rfm22b_id);
+        oplinkStatus.RxGood = radio_stats.rx_good;
+        oplinkStatus.RxCorrected   = radio_stats.rx_corrected;
+        oplinkStatus.RxErrors = radio_stats.rx_error;
+        oplinkStatus.RxMissed = radio_stats.rx_missed;
+        oplinkStatus.RxFailure     = radio_stats.rx_failure;
+        oplinkStatus.TxDropped     = radio_stats.tx_dropped;
+        oplinkStatus.TxResent = radio_stats.tx_resent;
+        oplinkStatus.TxFailure     = radio_stats.tx_failure;
+        oplinkStatus.Resets      = radio_stats.resets;
+        oplinkStatus.Timeouts    = radio_stats.timeouts;
+        oplinkStatus.RSSI        = radio_stats.rssi;
+        oplinkStatus.LinkQuality = radio_stats.link_quality;
+        oplinkStatus.AirDataRate = radio_stats.air_datarate;
+        if (first_time) {
+            first_time = false;
+        } else {
+            uint16_t tx_count = radio_stats.tx_byte_count;
+            uint16_t rx_count = radio_stats.rx_byte_count;
+            uint16_t tx_bytes = (tx_count < prev_tx_count) ? (0xffff - prev_tx_count + tx_count) : (tx_count - prev_tx_count);
+            uint16_t rx_bytes = (rx_count < prev_rx_count) ? (0xffff - prev_rx_count + rx_count) : (rx_count - prev_rx_count);
+            oplinkStatus.TXRate = (uint16_t)((float)(tx_bytes * 1000) / elapsed);
+            oplinkStatus.RXRate = (uint16_t)((float)(rx_bytes * 1000) / elapsed);
+            prev_tx_count = tx_count;
+            prev_rx_count = rx_count;
+        }
+        oplinkStatus.TXSeq     = radio_stats.tx_seq;
+        oplinkStatus.RXSeq     = radio_stats.rx_seq;
+
+        oplinkStatus.LinkState = radio_stats.link_state;
+    } else {
+        oplinkStatus.LinkState = OPLINKSTATUS_LINKSTATE_DISABLED;
+    }
+    OPLinkStatusSet(&oplinkStatus);
+    return false;
+}
+#endif /* if defined(PIOS_INCLUDE_RFM22B) */
+
 /**
  * Called by the RTOS when the CPU is idle,
  */
@@ -34,10 +34,14 @@
 
 #include "telemetry.h"
 
+#include "attitudestate.h"
+#include "flightstatus.h"
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
 #include "hwsettings.h"
+#include "rategovernor.h"
 #include "taskinfo.h"
+#include "telemetryping.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE            TELEM_QUEUE_SIZE
@@ -63,11 +67,17 @@
 #define MAX_RETRIES               2
 #define STATS_UPDATE_PERIOD_MS    4000
 #define CONNECTION_TIMEOUT_MS     8000
+#define MAX_BATCH_OBJECTS         8
+#define RX_BUFFER_SIZE            64
+#define LINK_MAX_DIVIDER          8
+#define LINK_HEADROOM_PERCENT     70
+#define LINK_RAISE_PERIODS        2
 
 // Private types
 
 // Private variables
 static uint32_t telemetryPort;
+static uint32_t reservedPort; // port the pending in place packet is written to
 #ifdef PIOS_INCLUDE_RFM22B
 static uint32_t radioPort;
 #endif
@@ -75,6 +85,7 @@ static xQueueHandle queue;
 
 #if defined(PIOS_TELEM_PRIORITY_QUEUE)
 static xQueueHandle priorityQueue;
+static xQueueSetHandle queueSet; // one handle per event waiting in either queue
 #else
 #define priorityQueue queue
 #endif
@@ -91,6 +102,14 @@ static UAVTalkConnection uavTalkCon;
 #ifdef PIOS_INCLUDE_RFM22B
 static UAVTalkConnection radioUavTalkCon;
 #endif
+static UAVObjHandle batchObjs[MAX_BATCH_OBJECTS];
+static uint16_t batchInstIds[MAX_BATCH_OBJECTS];
+static uint8_t batchCount;
+static uint8_t rateDivider = 1;
+static uint8_t linkDivider = 1;
+static uint32_t linkCapacity; // bytes sent in the last stats period the link was saturated
+static uint8_t linkHeadroomPeriods;
+static uint32_t probeObjId; // object sent timestamped for the latency probe of the GCS
 
 // Private functions
 static void telemetryTxTask(void *parameters);
@@ -100,14 +119,22 @@ static void radioRxTask(void *parameters);
 static int32_t transmitRadioData(uint8_t *data, int32_t length);
 #endif
 static int32_t transmitData(uint8_t *data, int32_t length);
+static int32_t reserveData(uint16_t length, UAVTalkOutputRegion regions[2]);
+static int32_t commitData(uint16_t length);
 static void registerObject(UAVObjHandle obj);
-static void updateObject(UAVObjHandle obj, int32_t eventType);
+static void updateObject(UAVObjHandle obj);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static int32_t setLoggingPeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static void processObjEvent(UAVObjEvent *ev);
+static void flushObjBatch();
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
+static void telemetryPingReceived();
 static void updateSettings();
+static void updateRateDivider();
+static void updateLinkDivider(bool connected, uint32_t txBytes, uint32_t errors);
+static bool isCriticalObject(UAVObjHandle obj);
+static void updatePeriodicObject(UAVObjHandle obj);
 static uint32_t getComPort(bool input);
 
 /**
@@ -122,6 +149,7 @@ int32_t TelemetryStart(void)
 
     // Listen to objects of interest
     GCSTelemetryStatsConnectQueue(priorityQueue);
+    TelemetryPingConnectQueue(priorityQueue);
 
     // Start telemetry tasks
     xTaskCreate(telemetryTxTask, "TelTx", STACK_SIZE_TX_BYTES / 4, NULL, TASK_PRIORITY_TX, &telemetryTxTaskHandle);
@@ -146,6 +174,8 @@ int32_t TelemetryInitialize(void)
 {
     FlightTelemetryStatsInitialize();
     GCSTelemetryStatsInitialize();
+    TelemetryPingInitialize();
+    RateGovernorInitialize();
 
     // Initialize vars
     timeOfLastObjectUpdate = 0;
@@ -154,6 +184,9 @@ int32_t TelemetryInitialize(void)
     queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 #if defined(PIOS_TELEM_PRIORITY_QUEUE)
     priorityQueue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+    queueSet      = xQueueCreateSet(2 * MAX_QUEUE_SIZE);
+    xQueueAddToSet(queue, queueSet);
+    xQueueAddToSet(priorityQueue, queueSet);
 #endif
 
     // Update telemetry settings
@@ -166,6 +199,7 @@ int32_t TelemetryInitialize(void)
 
     // Initialise UAVTalk
     uavTalkCon = UAVTalkInitialize(&transmitData);
+    UAVTalkSetOutputBuffer(uavTalkCon, &reserveData, &commitData);
 #ifdef PIOS_INCLUDE_RFM22B
     radioUavTalkCon = UAVTalkInitialize(&transmitRadioData);
 #endif
@@ -195,19 +229,23 @@ static void registerObject(UAVObjHandle obj)
         UAVObjConnectQueue(obj, priorityQueue, EV_MASK_ALL_UPDATES);
     } else {
         // Setup object for periodic updates
-        updateObject(obj, EV_NONE);
+        updateObject(obj);
     }
 }
 
 /**
- * Update object's queue connections and timer, depending on object's settings
+ * Update object's queue connections and timer, depending on object's settings.
+ * EV_UPDATED is shared by telemetry and logging: throttled objects are rate limited by
+ * the object manager, to the shortest interval needed, unless one of them wants every change.
  * \param[in] obj Object to updates
  */
-static void updateObject(UAVObjHandle obj, int32_t eventType)
+static void updateObject(UAVObjHandle obj)
 {
     UAVObjMetadata metadata;
     UAVObjUpdateMode updateMode, loggingMode;
     int32_t eventMask;
+    uint16_t throttle = 0;
+    bool onChange     = false;
 
     if (UAVObjIsMetaobject(obj)) {
         // This function updates the periodic updates for the object.
@@ -235,19 +273,13 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
         setUpdatePeriod(obj, 0);
         // Connect queue
         eventMask |= EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
+        onChange   = true;
         break;
     case UPDATEMODE_THROTTLED:
-        if ((eventType == EV_UPDATED_PERIODIC) || (eventType == EV_NONE)) {
-            // If we received a periodic update, we can change back to update on change
-            eventMask |= EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
-            // Set update period on initialization and metadata change
-            if (eventType == EV_NONE) {
-                setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
-            }
-        } else {
-            // Otherwise, we just received an object update, so switch to periodic for the timeout period to prevent more updates
-            eventMask |= EV_UPDATED_PERIODIC | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
-        }
+        // Sent on change, at most once per update period
+        setUpdatePeriod(obj, 0);
+        eventMask |= EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
+        throttle   = metadata.telemetryUpdatePeriod;
         break;
     case UPDATEMODE_MANUAL:
         // Set update period
@@ -268,18 +300,14 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
         setLoggingPeriod(obj, 0);
         // Connect queue
         eventMask |= EV_UPDATED | EV_LOGGING_MANUAL;
+        onChange   = true;
         break;
     case UPDATEMODE_THROTTLED:
-        if ((eventType == EV_LOGGING_PERIODIC) || (eventType == EV_NONE)) {
-            // If we received a periodic update, we can change back to update on change
-            eventMask |= EV_UPDATED | EV_LOGGING_MANUAL;
-            // Set update period on initialization and metadata change
-            if (eventType == EV_NONE) {
-                setLoggingPeriod(obj, metadata.loggingUpdatePeriod);
-            }
-        } else {
-            // Otherwise, we just received an object update, so switch to periodic for the timeout period to prevent more updates
-            eventMask |= EV_LOGGING_PERIODIC | EV_LOGGING_MANUAL;
+        // Logged on change, at most once per logging period
+        setLoggingPeriod(obj, 0);
+        eventMask |= EV_UPDATED | EV_LOGGING_MANUAL;
+        if (throttle == 0 || metadata.loggingUpdatePeriod < throttle) {
+            throttle = metadata.loggingUpdatePeriod;
         }
         break;
     case UPDATEMODE_MANUAL:
@@ -289,11 +317,15 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
         eventMask |= EV_LOGGING_MANUAL;
         break;
     }
+    if (onChange) {
+        throttle = 0;
+    }
     // note that all setting objects have implicitly IsPriority=true
+    // updates still waiting in the queue are coalesced, the latest data is sent anyway
     if (UAVObjIsPriority(obj)) {
-        UAVObjConnectQueue(obj, priorityQueue, eventMask);
+        UAVObjConnectQueueThrottled(obj, priorityQueue, eventMask | EV_MASK_COALESCE, throttle);
     } else {
-        UAVObjConnectQueue(obj, queue, eventMask);
+        UAVObjConnectQueueThrottled(obj, queue, eventMask | EV_MASK_COALESCE, throttle);
     }
 }
 
@@ -309,8 +341,14 @@ static void processObjEvent(UAVObjEvent *ev)
 
     if (ev->obj == 0) {
         updateTelemetryStats();
+        updateRateDivider();
     } else if (ev->obj == GCSTelemetryStatsHandle()) {
         gcsTelemetryStatsUpdated();
+    } else if (ev->obj == TelemetryPingHandle()) {
+        // only the pings of the GCS are answered, not our own updates
+        if (ev->event == EV_UNPACKED) {
+            telemetryPingReceived();
+        }
     } else {
         // Get object metadata
         UAVObjGetMetadata(ev->obj, &metadata);
@@ -321,20 +359,37 @@ static void processObjEvent(UAVObjEvent *ev)
         success    = -1;
         if ((ev->event == EV_UPDATED && (updateMode == UPDATEMODE_ONCHANGE || updateMode == UPDATEMODE_THROTTLED))
             || ev->event == EV_UPDATED_MANUAL
-            || (ev->event == EV_UPDATED_PERIODIC && updateMode != UPDATEMODE_THROTTLED)) {
-            // Send update to GCS (with retries)
-            while (retries < MAX_RETRIES && success == -1) {
-                // call blocks until ack is received or timeout
-                success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);
+            || ev->event == EV_UPDATED_PERIODIC) {
+            // The probed object is sent on its own, the timestamp covers a whole packet
+            bool stamped = probeObjId != 0 && UAVObjGetID(ev->obj) == probeObjId;
+            if (ev->event == EV_UPDATED_PERIODIC && !UAVObjGetTelemetryAcked(&metadata) && !stamped) {
+                // Periodic updates due in the same tick are coalesced into a single packet
+                batchObjs[batchCount]    = ev->obj;
+                batchInstIds[batchCount] = ev->instId;
+                if (++batchCount == MAX_BATCH_OBJECTS) {
+                    flushObjBatch();
+                }
+            } else {
+                // Keep pending periodic updates ahead of this one
+                flushObjBatch();
+                // Send update to GCS (with retries)
+                while (retries < MAX_RETRIES && success == -1) {
+                    // call blocks until ack is received or timeout
+                    if (stamped) {
+                        success = UAVTalkSendObjectTimestamped(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);
+                    } else {
+                        success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);
+                    }
+                    if (success == -1) {
+                        ++retries;
+                    }
+                }
+                // Update stats
+                txRetries += retries;
                 if (success == -1) {
-                    ++retries;
+                    ++txErrors;
                 }
             }
-            // Update stats
-            txRetries += retries;
-            if (success == -1) {
-                ++txErrors;
-            }
         } else if (ev->event == EV_UPDATE_REQ) {
             // Request object update from GCS (with retries)
             while (retries < MAX_RETRIES && success == -1) {
@@ -353,12 +408,7 @@ static void processObjEvent(UAVObjEvent *ev)
         // If this is a metaobject then make necessary telemetry updates
         if (UAVObjIsMetaobject(ev->obj)) {
             // linked object will be the actual object the metadata are for
-            updateObject(UAVObjGetLinkedObj(ev->obj), EV_NONE);
-        } else {
-            if (updateMode == UPDATEMODE_THROTTLED) {
-                // If this is UPDATEMODE_THROTTLED, the event mask changes on every event.
-                updateObject(ev->obj, ev->event);
-            }
+            updateObject(UAVObjGetLinkedObj(ev->obj));
         }
     }
     // Log UAVObject if necessary
@@ -366,7 +416,7 @@ static void processObjEvent(UAVObjEvent *ev)
         updateMode = UAVObjGetLoggingUpdateMode(&metadata);
         if ((ev->event == EV_UPDATED && (updateMode == UPDATEMODE_ONCHANGE || updateMode == UPDATEMODE_THROTTLED))
             || ev->event == EV_LOGGING_MANUAL
-            || (ev->event == EV_LOGGING_PERIODIC && updateMode != UPDATEMODE_THROTTLED)) {
+            || ev->event == EV_LOGGING_PERIODIC) {
             if (ev->instId == UAVOBJ_ALL_INSTANCES) {
                 success = UAVObjGetNumInstances(ev->obj);
                 for (retries = 0; retries < success; retries++) {
@@ -376,10 +426,6 @@ static void processObjEvent(UAVObjEvent *ev)
                 UAVObjInstanceWriteToLog(ev->obj, ev->instId);
             }
         }
-        if (updateMode == UPDATEMODE_THROTTLED) {
-            // If this is UPDATEMODE_THROTTLED, the event mask changes on every event.
-            updateObject(ev->obj, ev->event);
-        }
     }
 }
 
@@ -396,23 +442,27 @@ static void telemetryTxTask(__attribute__((unused)) void *parameters)
          * Tries to empty the high priority queue before handling any standard priority item
          */
 #if defined(PIOS_TELEM_PRIORITY_QUEUE)
-        // empty priority queue, non-blocking
-        while (xQueueReceive(priorityQueue, &ev, 0) == pdTRUE) {
-            // Process event
-            processObjEvent(&ev);
-        }
-        // check regular queue and process update - non-blocking
-        if (xQueueReceive(queue, &ev, 0) == pdTRUE) {
-            // Process event
-            processObjEvent(&ev);
-            // if both queues are empty, wait on priority queue for updates (1 tick) then repeat cycle
-        } else if (xQueueReceive(priorityQueue, &ev, 1) == pdTRUE) {
+        xQueueHandle source = priorityQueue;
+        if (xQueueReceive(priorityQueue, &ev, 0) == pdTRUE || xQueueReceive(source = queue, &ev, 0) == pdTRUE) {
+            UAVObjQueueEventReceived(source, &ev);
+            // the set holds the handle of this event, drop it to keep the set in step with the queues
+            xQueueSelectFromSet(queueSet, 0);
             // Process event
             processObjEvent(&ev);
+        } else {
+            // both queues are empty, send the coalesced updates and sleep until an event is queued
+            xQueueSetMemberHandle member;
+            flushObjBatch();
+            xQueuePeek(queueSet, &member, portMAX_DELAY);
         }
 #else
-        // wait on queue for updates (1 tick) then repeat cycle
-        if (xQueueReceive(queue, &ev, 1) == pdTRUE) {
+        // send the coalesced updates once the queue is drained
+        if (uxQueueMessagesWaiting(queue) == 0) {
+            flushObjBatch();
+        }
+        // wait on queue for updates then repeat cycle
+        if (xQueueReceive(queue, &ev, portMAX_DELAY) == pdTRUE) {
+            UAVObjQueueEventReceived(queue, &ev);
             // Process event
             processObjEvent(&ev);
         }
@@ -420,6 +470,31 @@ static void telemetryTxTask(__attribute__((unused)) void *parameters)
     }
 }
 
+/**
+ * Send the periodic updates coalesced by processObjEvent() in as few packets as possible
+ */
+static void flushObjBatch()
+{
+    int32_t retries = 0;
+    int32_t success = -1;
+
+    if (batchCount == 0) {
+        return;
+    }
+    while (retries < MAX_RETRIES && success == -1) {
+        success = UAVTalkSendObjectBatch(uavTalkCon, batchObjs, batchInstIds, batchCount);
+        if (success == -1) {
+            ++retries;
+        }
+    }
+    // Update stats
+    txRetries += retries;
+    if (success == -1) {
+        ++txErrors;
+    }
+    batchCount = 0;
+}
+
 
 /**
  * Telemetry receive task. Processes queue events and periodic updates.
@@ -431,15 +506,13 @@ static void telemetryRxTask(__attribute__((unused)) void *parameters)
         uint32_t inputPort = getComPort(true);
 
         if (inputPort) {
-            // Block until data are available
-            uint8_t serial_data[1];
+            // Block until data are available, then take all of them (static, keeps the stack small)
+            static uint8_t serial_data[RX_BUFFER_SIZE];
             uint16_t bytes_to_process;
 
             bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
             if (bytes_to_process > 0) {
-                for (uint8_t i = 0; i < bytes_to_process; i++) {
-                    UAVTalkProcessInputStream(uavTalkCon, serial_data[i]);
-                }
+                UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
             }
         } else {
             vTaskDelay(5);
@@ -456,15 +529,13 @@ static void radioRxTask(__attribute__((unused)) void *parameters)
     // Task loop
     while (1) {
         if (radioPort) {
-            // Block until data are available
-            uint8_t serial_data[1];
+            // Block until data are available, then take all of them (static, keeps the stack small)
+            static uint8_t serial_data[RX_BUFFER_SIZE];
             uint16_t bytes_to_process;
 
             bytes_to_process = PIOS_COM_ReceiveBuffer(radioPort, serial_data, sizeof(serial_data), 500);
             if (bytes_to_process > 0) {
-                for (uint8_t i = 0; i < bytes_to_process; i++) {
-                    UAVTalkProcessInputStream(radioUavTalkCon, serial_data[i]);
-                }
+                UAVTalkProcessInputBuffer(radioUavTalkCon, serial_data, bytes_to_process);
             }
         } else {
             vTaskDelay(5);
@@ -506,6 +577,45 @@ static int32_t transmitData(uint8_t *data, int32_t length)
     return -1;
 }
 
+/**
+ * Reserve space for a packet in the tx buffer of the modem or USB port.
+ * \param[in] length Length of the packet
+ * \param[out] regions Space to write the packet to
+ * \return 0 on success
+ * \return negative on failure
+ */
+static int32_t reserveData(uint16_t length, UAVTalkOutputRegion regions[2])
+{
+    uint32_t outputPort = getComPort(false);
+
+    if (!outputPort) {
+        return -1;
+    }
+
+    struct pios_com_iovec iov[2];
+    int32_t rc = PIOS_COM_TxReserve(outputPort, length, iov);
+    if (rc == 0) {
+        // The port may change before commit, the packet goes where the space was reserved
+        reservedPort = outputPort;
+        for (uint8_t i = 0; i < 2; i++) {
+            regions[i].data   = iov[i].data;
+            regions[i].length = iov[i].len;
+        }
+    }
+    return rc;
+}
+
+/**
+ * Send the packet written in the space reserved by reserveData().
+ * \param[in] length Length of the packet, 0 to cancel
+ * \return 0 on success
+ * \return -1 on failure
+ */
+static int32_t commitData(uint16_t length)
+{
+    return PIOS_COM_TxCommit(reservedPort, length);
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -526,6 +636,13 @@ static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs)
 
     xQueueHandle targetQueue = UAVObjIsPriority(obj) ? priorityQueue : queue;
 
+    // periodic updates are stretched while the cpu is overloaded,
+    // those of the non critical objects also while the link is saturated
+    updatePeriodMs *= rateDivider;
+    if (!isCriticalObject(obj)) {
+        updatePeriodMs *= linkDivider;
+    }
+
     ret = EventPeriodicQueueUpdate(&ev, targetQueue, updatePeriodMs);
     if (ret == -1) {
         ret = EventPeriodicQueueCreate(&ev, targetQueue, updatePeriodMs);
@@ -533,6 +650,73 @@ static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs)
     return ret;
 }
 
+/**
+ * Follow the rate of the non critical loops chosen by the System module, rescaling all the update periods when it changes
+ */
+static void updateRateDivider()
+{
+    uint8_t divider;
+
+    RateGovernorDividerGet(&divider);
+    if (divider == 0) {
+        divider = 1;
+    }
+    if (divider != rateDivider) {
+        rateDivider = divider;
+        UAVObjIterate(&updatePeriodicObject);
+    }
+}
+
+static void updatePeriodicObject(UAVObjHandle obj)
+{
+    if (!UAVObjIsMetaobject(obj)) {
+        updateObject(obj);
+    }
+}
+
+/**
+ * Stretch the periodic updates of the non critical objects while the link is saturated.
+ * Send failures mean the tx fifo overflowed, what was sent in that period is what the link carries.
+ * The updates are sped up again once twice the current load fits the link with some headroom.
+ */
+static void updateLinkDivider(bool connected, uint32_t txBytes, uint32_t errors)
+{
+    uint8_t divider = linkDivider;
+
+    if (!connected) {
+        divider = 1;
+        linkHeadroomPeriods = 0;
+    } else if (errors > 0) {
+        linkCapacity = txBytes;
+        linkHeadroomPeriods = 0;
+        if (divider < LINK_MAX_DIVIDER) {
+            divider *= 2;
+        }
+    } else if (divider > 1 && txBytes * 2 * 100 < linkCapacity * LINK_HEADROOM_PERCENT) {
+        if (++linkHeadroomPeriods >= LINK_RAISE_PERIODS) {
+            linkHeadroomPeriods = 0;
+            divider /= 2;
+        }
+    } else {
+        linkHeadroomPeriods = 0;
+    }
+
+    if (divider != linkDivider) {
+        linkDivider = divider;
+        UAVObjIterate(&updatePeriodicObject);
+    }
+}
+
+/**
+ * Objects keeping their update rate whatever the link load
+ */
+static bool isCriticalObject(UAVObjHandle obj)
+{
+    uint32_t objId = UAVObjGetID(obj);
+
+    return UAVObjIsPriority(obj) || objId == ATTITUDESTATE_OBJID || objId == FLIGHTSTATUS_OBJID;
+}
+
 /**
  * Set logging update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -577,6 +761,26 @@ static void gcsTelemetryStatsUpdated()
     }
 }
 
+/**
+ * Called when the GCS sends a latency probe ping. The ping is sent back
+ * with the flight clock, for the GCS to relate it to its own clock, and the
+ * object it probes is then sent timestamped.
+ */
+static void telemetryPingReceived()
+{
+    TelemetryPingData ping;
+
+    TelemetryPingGet(&ping);
+    ping.FlightTime = xTaskGetTickCount() * portTICK_RATE_MS;
+    probeObjId = ping.ProbeObjectID;
+    TelemetryPingSet(&ping);
+
+    flushObjBatch();
+    if (UAVTalkSendObject(uavTalkCon, TelemetryPingHandle(), 0, 0, 0) == -1) {
+        ++txErrors;
+    }
+}
+
 /**
  * Update telemetry statistics and handle connection handshake
  */
@@ -622,7 +826,10 @@ static void updateTelemetryStats()
         flightStats.RxFailures   = 0;
         flightStats.RxSyncErrors = 0;
         flightStats.RxCrcErrors  = 0;
+        // the next GCS may not know timestamped packets
+        probeObjId = 0;
     }
+    updateLinkDivider(flightStats.Status == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED, utalkStats.txBytes, txErrors);
     txErrors  = 0;
     txRetries = 0;
 
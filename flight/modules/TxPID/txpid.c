@@ -65,7 +65,7 @@
 //
 // Configuration
 //
-#define SAMPLE_PERIOD_MS           200
+#define SAMPLE_PERIOD_MS           100 // minimum period between the updates of the tuned gains
 #define TELEMETRY_UPDATE_PERIOD_MS 0 // 0 = update on change (default)
 
 // Sanity checks
@@ -77,13 +77,113 @@
 
 // Private types
 
+// Type of a tuned field, the TxPID values are rounded for the integer ones
+typedef enum {
+    TXPID_FLOAT = 0,
+    TXPID_UINT8,
+    TXPID_INT8,
+} TxPIDFieldType;
+
+struct txpid_field {
+    uint16_t offset; // in StabilizationBankData, or StabilizationSettingsData if stab
+    uint8_t  type; // TxPIDFieldType
+    bool     stab;
+};
+
+// Fields tuned by each TxPIDSettings.PIDs option
+struct txpid_map {
+    uint8_t count;
+    struct txpid_field fields[2];
+};
+
+// A TxPID instance compiled from the settings
+struct txpid_slot {
+    const struct txpid_map *map;
+    uint8_t input;
+    float   min;
+    float   max;
+};
+
+// A changed field, pending to be written
+struct txpid_write {
+    const struct txpid_field *field;
+    union {
+        float   f;
+        uint8_t u8;
+        int8_t  i8;
+    } value;
+};
+
+#define BANK(name, t) { .offset = offsetof(StabilizationBankData, name), .type = t, .stab = false }
+#define STAB(name, t) { .offset = offsetof(StabilizationSettingsData, name), .type = t, .stab = true }
+#define MAP1(a)       { .count = 1, .fields = { a } }
+#define MAP2(a, b)    { .count = 2, .fields = { a, b } }
+
+static const struct txpid_map pidMaps[] = {
+    [TXPIDSETTINGS_PIDS_ROLLRATEKP]      = MAP1(BANK(RollRatePID.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLRATEKI]      = MAP1(BANK(RollRatePID.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLRATEKD]      = MAP1(BANK(RollRatePID.Kd, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLRATEILIMIT]  = MAP1(BANK(RollRatePID.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLRATERESP]    = MAP1(BANK(ManualRate.Roll, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLATTITUDEKP]  = MAP1(BANK(RollPI.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLATTITUDEKI]  = MAP1(BANK(RollPI.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLATTITUDEILIMIT] = MAP1(BANK(RollPI.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLATTITUDERESP]   = MAP1(BANK(RollMax, TXPID_UINT8)),
+    [TXPIDSETTINGS_PIDS_PITCHRATEKP]     = MAP1(BANK(PitchRatePID.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHRATEKI]     = MAP1(BANK(PitchRatePID.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHRATEKD]     = MAP1(BANK(PitchRatePID.Kd, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHRATEILIMIT] = MAP1(BANK(PitchRatePID.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHRATERESP]   = MAP1(BANK(ManualRate.Pitch, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHATTITUDEKP] = MAP1(BANK(PitchPI.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHATTITUDEKI] = MAP1(BANK(PitchPI.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHATTITUDEILIMIT] = MAP1(BANK(PitchPI.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_PITCHATTITUDERESP]   = MAP1(BANK(PitchMax, TXPID_UINT8)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHRATEKP]     = MAP2(BANK(RollRatePID.Kp, TXPID_FLOAT), BANK(PitchRatePID.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHRATEKI]     = MAP2(BANK(RollRatePID.Ki, TXPID_FLOAT), BANK(PitchRatePID.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHRATEKD]     = MAP2(BANK(RollRatePID.Kd, TXPID_FLOAT), BANK(PitchRatePID.Kd, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHRATEILIMIT] = MAP2(BANK(RollRatePID.ILimit, TXPID_FLOAT), BANK(PitchRatePID.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHRATERESP]   = MAP2(BANK(ManualRate.Roll, TXPID_FLOAT), BANK(ManualRate.Pitch, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDEKP] = MAP2(BANK(RollPI.Kp, TXPID_FLOAT), BANK(PitchPI.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDEKI] = MAP2(BANK(RollPI.Ki, TXPID_FLOAT), BANK(PitchPI.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDEILIMIT] = MAP2(BANK(RollPI.ILimit, TXPID_FLOAT), BANK(PitchPI.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDERESP]   = MAP2(BANK(RollMax, TXPID_UINT8), BANK(PitchMax, TXPID_UINT8)),
+    [TXPIDSETTINGS_PIDS_YAWRATEKP]       = MAP1(BANK(YawRatePID.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWRATEKI]       = MAP1(BANK(YawRatePID.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWRATEKD]       = MAP1(BANK(YawRatePID.Kd, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWRATEILIMIT]   = MAP1(BANK(YawRatePID.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWRATERESP]     = MAP1(BANK(ManualRate.Yaw, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWATTITUDEKP]   = MAP1(BANK(YawPI.Kp, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWATTITUDEKI]   = MAP1(BANK(YawPI.Ki, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWATTITUDEILIMIT] = MAP1(BANK(YawPI.ILimit, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_YAWATTITUDERESP] = MAP1(BANK(YawMax, TXPID_UINT8)),
+    [TXPIDSETTINGS_PIDS_ROLLEXPO]        = MAP1(BANK(StickExpo.Roll, TXPID_INT8)),
+    [TXPIDSETTINGS_PIDS_PITCHEXPO]       = MAP1(BANK(StickExpo.Pitch, TXPID_INT8)),
+    [TXPIDSETTINGS_PIDS_ROLLPITCHEXPO]   = MAP2(BANK(StickExpo.Roll, TXPID_INT8), BANK(StickExpo.Pitch, TXPID_INT8)),
+    [TXPIDSETTINGS_PIDS_YAWEXPO]         = MAP1(BANK(StickExpo.Yaw, TXPID_INT8)),
+    [TXPIDSETTINGS_PIDS_GYROTAU]         = MAP1(STAB(GyroTau, TXPID_FLOAT)),
+    [TXPIDSETTINGS_PIDS_ACROPLUSFACTOR]  = MAP1(BANK(AcroInsanityFactor, TXPID_FLOAT)),
+};
+
+static const uint8_t fieldSizes[] = {
+    [TXPID_FLOAT] = sizeof(float),
+    [TXPID_UINT8] = sizeof(uint8_t),
+    [TXPID_INT8]  = sizeof(int8_t),
+};
+
 // Private variables
+static struct txpid_slot slots[TXPIDSETTINGS_PIDS_NUMELEM];
+static uint8_t numSlots;
+static uint8_t updateMode;
+static UAVObjHandle bankHandle;
+static float throttleMin;
+static float throttleMax;
+static portTickType lastUpdate;
 
 // Private functions
 static void updatePIDs(UAVObjEvent *ev);
-static uint8_t update(float *var, float val);
-static uint8_t updateUint8(uint8_t *var, float val);
-static uint8_t updateInt8(int8_t *var, float val);
+static void settingsUpdated(UAVObjEvent *ev);
+static bool update(const struct txpid_field *field, UAVObjHandle obj, float val, struct txpid_write *write);
+static void writeFields(UAVObjHandle obj, void *data, const struct txpid_write *writes, uint8_t count);
 static float scale(float val, float inMin, float inMax, float outMin, float outMax);
 
 /**
@@ -108,13 +208,12 @@ int32_t TxPIDInitialize(void)
         TxPIDSettingsInitialize();
         AccessoryDesiredInitialize();
 
-        UAVObjEvent ev = {
-            .obj    = AccessoryDesiredHandle(),
-            .instId = 0,
-            .event  = 0,
-            .lowPriority = false,
-        };
-        EventPeriodicCallbackCreate(&ev, updatePIDs, SAMPLE_PERIOD_MS / portTICK_RATE_MS);
+        // compile the instances into the slot table on every settings change
+        TxPIDSettingsConnectCallback(settingsUpdated);
+        settingsUpdated(NULL);
+
+        // the receiver updates the accessory inputs every cycle
+        AccessoryDesiredConnectCallback(updatePIDs);
 
 #if (TELEMETRY_UPDATE_PERIOD_MS != 0)
         // Change StabilizationSettings update rate from OnChange to periodic
@@ -146,237 +245,131 @@ int32_t TxPIDStart(void)
 
 MODULE_INITCALL(TxPIDInitialize, TxPIDStart);
 
+/**
+ * Compile the enabled TxPID instances into the slot table
+ */
+static void settingsUpdated(__attribute__((unused)) UAVObjEvent *ev)
+{
+    TxPIDSettingsData inst;
+
+    TxPIDSettingsGet(&inst);
+
+    numSlots    = 0;
+    updateMode  = inst.UpdateMode;
+    throttleMin = inst.ThrottleRange.Min;
+    throttleMax = inst.ThrottleRange.Max;
+
+    switch (inst.BankNumber) {
+    case TXPIDSETTINGS_BANKNUMBER_BANK1:
+        bankHandle = StabilizationSettingsBank1Handle();
+        break;
+    case TXPIDSETTINGS_BANKNUMBER_BANK2:
+        bankHandle = StabilizationSettingsBank2Handle();
+        break;
+    case TXPIDSETTINGS_BANKNUMBER_BANK3:
+        bankHandle = StabilizationSettingsBank3Handle();
+        break;
+    default:
+        bankHandle = NULL;
+        return;
+    }
+
+    for (uint8_t i = 0; i < TXPIDSETTINGS_PIDS_NUMELEM; i++) {
+        uint8_t pid = TxPIDSettingsPIDsToArray(inst.PIDs)[i];
+        if (pid == TXPIDSETTINGS_PIDS_DISABLED || pid >= NELEMENTS(pidMaps) || pidMaps[pid].count == 0) {
+            continue;
+        }
+        slots[numSlots].map   = &pidMaps[pid];
+        slots[numSlots].input = TxPIDSettingsInputsToArray(inst.Inputs)[i];
+        slots[numSlots].min   = TxPIDSettingsMinPIDToArray(inst.MinPID)[i];
+        slots[numSlots].max   = TxPIDSettingsMaxPIDToArray(inst.MaxPID)[i];
+        numSlots++;
+    }
+}
+
 /**
  * Update PIDs callback function
  */
 static void updatePIDs(UAVObjEvent *ev)
 {
-    if (ev->obj != AccessoryDesiredHandle()) {
+    if (ev->obj != AccessoryDesiredHandle() || numSlots == 0 || !bankHandle) {
         return;
     }
 
-    TxPIDSettingsData inst;
-    TxPIDSettingsGet(&inst);
+    if (updateMode == TXPIDSETTINGS_UPDATEMODE_NEVER) {
+        return;
+    }
 
-    if (inst.UpdateMode == TXPIDSETTINGS_UPDATEMODE_NEVER) {
+    // every accessory instance triggers, throttle the updates
+    portTickType now = xTaskGetTickCount();
+    if ((now - lastUpdate) < SAMPLE_PERIOD_MS / portTICK_RATE_MS) {
         return;
     }
+    lastUpdate = now;
 
     uint8_t armed;
     FlightStatusArmedGet(&armed);
-    if ((inst.UpdateMode == TXPIDSETTINGS_UPDATEMODE_WHENARMED) &&
+    if ((updateMode == TXPIDSETTINGS_UPDATEMODE_WHENARMED) &&
         (armed == FLIGHTSTATUS_ARMED_DISARMED)) {
         return;
     }
 
-    StabilizationBankData bank;
-    switch (inst.BankNumber) {
-    case 0:
-        StabilizationSettingsBank1Get((StabilizationSettingsBank1Data *)&bank);
-        break;
-
-    case 1:
-        StabilizationSettingsBank2Get((StabilizationSettingsBank2Data *)&bank);
-        break;
-
-    case 2:
-        StabilizationSettingsBank3Get((StabilizationSettingsBank3Data *)&bank);
-        break;
-
-    default:
-        return;
-    }
-    StabilizationSettingsData stab;
-    StabilizationSettingsGet(&stab);
     AccessoryDesiredData accessory;
-
-    uint8_t needsUpdateBank = 0;
-    uint8_t needsUpdateStab = 0;
+    struct txpid_write bankWrites[TXPIDSETTINGS_PIDS_NUMELEM * 2];
+    struct txpid_write stabWrites[TXPIDSETTINGS_PIDS_NUMELEM * 2];
+    uint8_t numBankWrites = 0;
+    uint8_t numStabWrites = 0;
 
     // Loop through every enabled instance
-    for (uint8_t i = 0; i < TXPIDSETTINGS_PIDS_NUMELEM; i++) {
-        if (TxPIDSettingsPIDsToArray(inst.PIDs)[i] != TXPIDSETTINGS_PIDS_DISABLED) {
-            float value;
-            if (TxPIDSettingsInputsToArray(inst.Inputs)[i] == TXPIDSETTINGS_INPUTS_THROTTLE) {
-                ManualControlCommandThrottleGet(&value);
-                value = scale(value,
-                              inst.ThrottleRange.Min,
-                              inst.ThrottleRange.Max,
-                              TxPIDSettingsMinPIDToArray(inst.MinPID)[i],
-                              TxPIDSettingsMaxPIDToArray(inst.MaxPID)[i]);
-            } else if (AccessoryDesiredInstGet(
-                           TxPIDSettingsInputsToArray(inst.Inputs)[i] - TXPIDSETTINGS_INPUTS_ACCESSORY0,
-                           &accessory) == 0) {
-                value = scale(accessory.AccessoryVal, -1.0f, 1.0f,
-                              TxPIDSettingsMinPIDToArray(inst.MinPID)[i],
-                              TxPIDSettingsMaxPIDToArray(inst.MaxPID)[i]);
-            } else {
-                continue;
-            }
+    for (uint8_t i = 0; i < numSlots; i++) {
+        const struct txpid_slot *slot = &slots[i];
+        float value;
+        if (slot->input == TXPIDSETTINGS_INPUTS_THROTTLE) {
+            ManualControlCommandThrottleGet(&value);
+            value = scale(value, throttleMin, throttleMax, slot->min, slot->max);
+        } else if (AccessoryDesiredInstGet(slot->input - TXPIDSETTINGS_INPUTS_ACCESSORY0, &accessory) == 0) {
+            value = scale(accessory.AccessoryVal, -1.0f, 1.0f, slot->min, slot->max);
+        } else {
+            continue;
+        }
 
-            switch (TxPIDSettingsPIDsToArray(inst.PIDs)[i]) {
-            case TXPIDSETTINGS_PIDS_ROLLRATEKP:
-                needsUpdateBank |= update(&bank.RollRatePID.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLRATEKI:
-                needsUpdateBank |= update(&bank.RollRatePID.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLRATEKD:
-                needsUpdateBank |= update(&bank.RollRatePID.Kd, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLRATEILIMIT:
-                needsUpdateBank |= update(&bank.RollRatePID.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLRATERESP:
-                needsUpdateBank |= update(&bank.ManualRate.Roll, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLATTITUDEKP:
-                needsUpdateBank |= update(&bank.RollPI.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLATTITUDEKI:
-                needsUpdateBank |= update(&bank.RollPI.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLATTITUDEILIMIT:
-                needsUpdateBank |= update(&bank.RollPI.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLATTITUDERESP:
-                needsUpdateBank |= updateUint8(&bank.RollMax, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHRATEKP:
-                needsUpdateBank |= update(&bank.PitchRatePID.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHRATEKI:
-                needsUpdateBank |= update(&bank.PitchRatePID.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHRATEKD:
-                needsUpdateBank |= update(&bank.PitchRatePID.Kd, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHRATEILIMIT:
-                needsUpdateBank |= update(&bank.PitchRatePID.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHRATERESP:
-                needsUpdateBank |= update(&bank.ManualRate.Pitch, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHATTITUDEKP:
-                needsUpdateBank |= update(&bank.PitchPI.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHATTITUDEKI:
-                needsUpdateBank |= update(&bank.PitchPI.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHATTITUDEILIMIT:
-                needsUpdateBank |= update(&bank.PitchPI.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHATTITUDERESP:
-                needsUpdateBank |= updateUint8(&bank.PitchMax, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHRATEKP:
-                needsUpdateBank |= update(&bank.RollRatePID.Kp, value);
-                needsUpdateBank |= update(&bank.PitchRatePID.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHRATEKI:
-                needsUpdateBank |= update(&bank.RollRatePID.Ki, value);
-                needsUpdateBank |= update(&bank.PitchRatePID.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHRATEKD:
-                needsUpdateBank |= update(&bank.RollRatePID.Kd, value);
-                needsUpdateBank |= update(&bank.PitchRatePID.Kd, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHRATEILIMIT:
-                needsUpdateBank |= update(&bank.RollRatePID.ILimit, value);
-                needsUpdateBank |= update(&bank.PitchRatePID.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHRATERESP:
-                needsUpdateBank |= update(&bank.ManualRate.Roll, value);
-                needsUpdateBank |= update(&bank.ManualRate.Pitch, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDEKP:
-                needsUpdateBank |= update(&bank.RollPI.Kp, value);
-                needsUpdateBank |= update(&bank.PitchPI.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDEKI:
-                needsUpdateBank |= update(&bank.RollPI.Ki, value);
-                needsUpdateBank |= update(&bank.PitchPI.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDEILIMIT:
-                needsUpdateBank |= update(&bank.RollPI.ILimit, value);
-                needsUpdateBank |= update(&bank.PitchPI.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHATTITUDERESP:
-                needsUpdateBank |= updateUint8(&bank.RollMax, value);
-                needsUpdateBank |= updateUint8(&bank.PitchMax, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWRATEKP:
-                needsUpdateBank |= update(&bank.YawRatePID.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWRATEKI:
-                needsUpdateBank |= update(&bank.YawRatePID.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWRATEKD:
-                needsUpdateBank |= update(&bank.YawRatePID.Kd, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWRATEILIMIT:
-                needsUpdateBank |= update(&bank.YawRatePID.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWRATERESP:
-                needsUpdateBank |= update(&bank.ManualRate.Yaw, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWATTITUDEKP:
-                needsUpdateBank |= update(&bank.YawPI.Kp, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWATTITUDEKI:
-                needsUpdateBank |= update(&bank.YawPI.Ki, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWATTITUDEILIMIT:
-                needsUpdateBank |= update(&bank.YawPI.ILimit, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWATTITUDERESP:
-                needsUpdateBank |= updateUint8(&bank.YawMax, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLEXPO:
-                needsUpdateBank |= updateInt8(&bank.StickExpo.Roll, value);
-                break;
-            case TXPIDSETTINGS_PIDS_PITCHEXPO:
-                needsUpdateBank |= updateInt8(&bank.StickExpo.Pitch, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ROLLPITCHEXPO:
-                needsUpdateBank |= updateInt8(&bank.StickExpo.Roll, value);
-                needsUpdateBank |= updateInt8(&bank.StickExpo.Pitch, value);
-                break;
-            case TXPIDSETTINGS_PIDS_YAWEXPO:
-                needsUpdateBank |= updateInt8(&bank.StickExpo.Yaw, value);
-                break;
-            case TXPIDSETTINGS_PIDS_GYROTAU:
-                needsUpdateStab |= update(&stab.GyroTau, value);
-                break;
-            case TXPIDSETTINGS_PIDS_ACROPLUSFACTOR:
-                needsUpdateBank |= update(&bank.AcroInsanityFactor, value);
-                break;
-            default:
-                PIOS_Assert(0);
+        for (uint8_t j = 0; j < slot->map->count; j++) {
+            const struct txpid_field *field = &slot->map->fields[j];
+            if (field->stab) {
+                numStabWrites += update(field, StabilizationSettingsHandle(), value, &stabWrites[numStabWrites]);
+            } else {
+                numBankWrites += update(field, bankHandle, value, &bankWrites[numBankWrites]);
             }
         }
     }
-    if (needsUpdateStab) {
-        StabilizationSettingsSet(&stab);
+
+    if (numStabWrites) {
+        StabilizationSettingsData stab;
+        writeFields(StabilizationSettingsHandle(), &stab, stabWrites, numStabWrites);
     }
-    if (needsUpdateBank) {
-        switch (inst.BankNumber) {
-        case 0:
-            StabilizationSettingsBank1Set((StabilizationSettingsBank1Data *)&bank);
-            break;
-
-        case 1:
-            StabilizationSettingsBank2Set((StabilizationSettingsBank2Data *)&bank);
-            break;
-
-        case 2:
-            StabilizationSettingsBank3Set((StabilizationSettingsBank3Data *)&bank);
-            break;
-
-        default:
-            return;
-        }
+    if (numBankWrites) {
+        StabilizationBankData bank;
+        writeFields(bankHandle, &bank, bankWrites, numBankWrites);
+    }
+}
+
+/**
+ * Write the changed fields, a single field alone and several at once in the whole object
+ * so that an update is always a single object event.
+ * \param[in] data storage for the whole object
+ */
+static void writeFields(UAVObjHandle obj, void *data, const struct txpid_write *writes, uint8_t count)
+{
+    if (count == 1) {
+        UAVObjSetDataField(obj, &writes[0].value, writes[0].field->offset, fieldSizes[writes[0].field->type]);
+        return;
+    }
+
+    UAVObjGetData(obj, data);
+    for (uint8_t i = 0; i < count; i++) {
+        memcpy((uint8_t *)data + writes[i].field->offset, &writes[i].value, fieldSizes[writes[i].field->type]);
     }
+    UAVObjSetData(obj, data);
 }
 
 /**
@@ -415,51 +408,42 @@ static float scale(float val, float inMin, float inMax, float outMin, float outM
 }
 
 /**
- * Updates var using val if needed.
- * \returns 1 if updated, 0 otherwise
+ * Compares the field of obj with val, rounded for the integer fields.
+ * \param[out] write the field and its new value if it changed
+ * \returns 1 if the field needs an update, 0 otherwise
  */
-static uint8_t update(float *var, float val)
+static bool update(const struct txpid_field *field, UAVObjHandle obj, float val, struct txpid_write *write)
 {
-    /* FIXME: this is not an entirely correct way
-     * to check if the two floating point
-     * numbers are 'not equal'.
-     * Epsilon of 1e-9 is probably okay for the range
-     * of numbers we see here*/
-    if (fabsf(*var - val) > 1e-9f) {
-        *var = val;
-        return 1;
+    write->field = field;
+
+    switch (field->type) {
+    case TXPID_UINT8:
+    {
+        uint8_t var;
+        UAVObjGetDataField(obj, &var, field->offset, sizeof(var));
+        write->value.u8 = (uint8_t)roundf(val);
+        return var != write->value.u8;
     }
-    return 0;
-}
-
-/**
- * Updates var using val if needed.
- * \returns 1 if updated, 0 otherwise
- */
-static uint8_t updateUint8(uint8_t *var, float val)
-{
-    uint8_t roundedVal = (uint8_t)roundf(val);
-
-    if (*var != roundedVal) {
-        *var = roundedVal;
-        return 1;
+    case TXPID_INT8:
+    {
+        int8_t var;
+        UAVObjGetDataField(obj, &var, field->offset, sizeof(var));
+        write->value.i8 = (int8_t)roundf(val);
+        return var != write->value.i8;
+    }
+    default:
+    {
+        float var;
+        UAVObjGetDataField(obj, &var, field->offset, sizeof(var));
+        write->value.f = val;
+        /* FIXME: this is not an entirely correct way
+         * to check if the two floating point
+         * numbers are 'not equal'.
+         * Epsilon of 1e-9 is probably okay for the range
+         * of numbers we see here*/
+        return fabsf(var - val) > 1e-9f;
     }
-    return 0;
-}
-
-/**
- * Updates var using val if needed.
- * \returns 1 if updated, 0 otherwise
- */
-static uint8_t updateInt8(int8_t *var, float val)
-{
-    int8_t roundedVal = (int8_t)roundf(val);
-
-    if (*var != roundedVal) {
-        *var = roundedVal;
-        return 1;
     }
-    return 0;
 }
 
 /**
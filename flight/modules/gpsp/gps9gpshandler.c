@@ -31,39 +31,34 @@
 #include <pios_ubx_ddc.h>
 
 #include "gps9gpshandler.h"
+#include "gps9maghandler.h"
 #include "gps9protocol.h"
 
+#define UBX_OVERHEAD (UBX_HEADER_LEN + sizeof(UBXFooter_t))
+
 uint32_t lastUnsentData = 0;
 uint8_t buffer[BUFFER_SIZE];
 
+static uint16_t sendSentences(uint8_t *data, uint16_t length);
+static bool checksumOk(const UBXPacket_t *pkt);
+static void sendPvt(const NavPvtData *nav);
+
 void handleGPS()
 {
-    bool completeSentenceSent = false;
     int8_t maxCount = 2;
 
     do {
         int32_t datacounter = PIOS_UBX_DDC_GetAvailableBytes(PIOS_I2C_GPS);
         if (datacounter > 0) {
             uint8_t toRead = (uint32_t)datacounter > BUFFER_SIZE - lastUnsentData ? BUFFER_SIZE - lastUnsentData : (uint8_t)datacounter;
-            uint8_t toSend = toRead;
-            PIOS_UBX_DDC_ReadData(PIOS_I2C_GPS, buffer, toRead);
-
-            uint8_t *lastSentence;
-            uint16_t lastSentenceLength;
-            completeSentenceSent = ubx_getLastSentence(buffer, toRead, &lastSentence, &lastSentenceLength);
-            if (completeSentenceSent) {
-                toSend = (uint8_t)(lastSentence - buffer + lastSentenceLength);
-            } else {
-                lastUnsentData = 0;
-            }
+            PIOS_UBX_DDC_ReadData(PIOS_I2C_GPS, buffer + lastUnsentData, toRead);
 
-            PIOS_COM_SendBuffer(pios_com_main_id, buffer, toSend);
+            uint16_t count  = lastUnsentData + toRead;
+            uint16_t toSend = sendSentences(buffer, count);
 
-            if (toRead > toSend) {
-                // move unsent data at the beginning of buffer to be sent next time
-                lastUnsentData = toRead - toSend;
-                memcpy(buffer, (buffer + toSend), lastUnsentData);
-            }
+            // move unsent data at the beginning of buffer to be sent next time
+            lastUnsentData = count - toSend;
+            memmove(buffer, (buffer + toSend), lastUnsentData);
         }
 
         datacounter = PIOS_COM_ReceiveBuffer(pios_com_main_id, buffer, BUFFER_SIZE, 0);
@@ -78,6 +73,119 @@ void handleGPS()
     } while (maxCount--);
 }
 
+/**
+ * Sends the complete sentences in data, NAV-PVT is sent as a compact PVT frame and
+ * everything else as it is.
+ * \return the number of bytes sent, the remaining ones are the start of a sentence
+ */
+static uint16_t sendSentences(uint8_t *data, uint16_t length)
+{
+    uint16_t start = 0; // first byte not sent yet
+    uint16_t i     = 0;
+
+    while (i < length) {
+        if (data[i] != UBX_SYN1) {
+            i++;
+            continue;
+        }
+        if (length - i < UBX_HEADER_LEN) {
+            // wait for the rest of the header, unless it is not a sentence
+            if (length - i > 1 && data[i + 1] != UBX_SYN2) {
+                i++;
+                continue;
+            }
+            break;
+        }
+        UBXHeader_t *header = (UBXHeader_t *)&data[i];
+        uint16_t size = header->len + UBX_OVERHEAD;
+        if (header->syn2 != UBX_SYN2 || size > BUFFER_SIZE) {
+            i++;
+            continue;
+        }
+        if (length - i < size) {
+            // wait for the rest of the sentence
+            break;
+        }
+        if (header->class == UBX_NAV_CLASS && header->id == UBX_NAV_PVT && header->len == sizeof(NavPvtData)) {
+            UBXPacket_t *pkt = (UBXPacket_t *)&data[i];
+            if (checksumOk(pkt)) {
+                if (i > start) {
+                    PIOS_COM_SendBuffer(pios_com_main_id, &data[start], i - start);
+                }
+                sendPvt((const NavPvtData *)pkt->packet.payload);
+                i    += size;
+                start = i;
+                continue;
+            }
+        }
+        i += size;
+    }
+    if (i > start) {
+        PIOS_COM_SendBuffer(pios_com_main_id, &data[start], i - start);
+    }
+    return i;
+}
+
+/**
+ * Checks the checksum of a complete sentence
+ */
+static bool checksumOk(const UBXPacket_t *pkt)
+{
+    uint8_t chkA = 0;
+    uint8_t chkB = 0;
+    uint16_t len = pkt->packet.header.len;
+
+    // From class field to the end of payload
+    for (uint16_t i = 2; i < len + UBX_HEADER_LEN; i++) {
+        chkA += pkt->binarystream[i];
+        chkB += chkA;
+    }
+    return pkt->packet.payload[len] == chkA && pkt->packet.payload[len + 1] == chkB;
+}
+
+/**
+ * Sends the compact PVT frame of a NAV-PVT, with the last mag sample
+ */
+static void sendPvt(const NavPvtData *nav)
+{
+    PvtUbxPkt pvtPkt;
+    PvtData *pvt = &pvtPkt.fragments.data;
+    int16_t mag[3];
+
+    pvt->iTOW    = nav->iTOW;
+    pvt->lon     = nav->lon;
+    pvt->lat     = nav->lat;
+    pvt->hMSL    = nav->hMSL;
+    pvt->geoidSeparation = (nav->height - nav->hMSL) / 10;
+    pvt->velN    = nav->velN / 10;
+    pvt->velE    = nav->velE / 10;
+    pvt->velD    = nav->velD / 10;
+    pvt->gSpeed  = nav->gSpeed / 10;
+    pvt->heading = nav->heading / 1000;
+    pvt->pDOP    = nav->pDOP;
+    pvt->year    = nav->year;
+    pvt->month   = nav->month;
+    pvt->day     = nav->day;
+    pvt->hour    = nav->hour;
+    pvt->min     = nav->min;
+    pvt->sec     = nav->sec;
+    pvt->numSV   = nav->numSV;
+    pvt->flags   = (nav->fixType & PVT_DATA_FLAGS_FIXTYPE) |
+                   ((nav->flags & 0x01) ? PVT_DATA_FLAGS_GNSSFIX_OK : 0) |
+                   ((nav->valid & 0x02) ? PVT_DATA_FLAGS_VALIDTIME : 0);
+    if (takeMag(mag, &pvt->magAge)) {
+        pvt->flags |= PVT_DATA_FLAGS_MAG;
+        pvt->magX   = mag[0];
+        pvt->magY   = mag[1];
+        pvt->magZ   = mag[2];
+    } else {
+        pvt->magAge = 0;
+        pvt->magX   = pvt->magY = pvt->magZ = 0;
+    }
+    ubx_buildPacket(&pvtPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_PVT, sizeof(PvtData));
+    PIOS_COM_SendBuffer(pios_com_main_id, pvtPkt.packet.binarystream, sizeof(PvtUbxPkt));
+}
+
 typedef struct {
     uint8_t size;
     const uint8_t *sentence;
@@ -30,10 +30,28 @@
 #include <pios_hmc5x83.h>
 #include "inc/gps9protocol.h"
 #define MAG_RATE_HZ 30
+// a sample is kept that long for the next PVT frame before being sent on its own
+#define MAG_MERGE_WINDOW_US 5000
 extern pios_hmc5x83_dev_t onboard_mag;
 
+static int16_t lastMag[3];
+static uint32_t lastMagTime;
+static bool magPending;
+
 void handleMag()
 {
+    if (magPending && PIOS_DELAY_DiffuS(lastMagTime) > MAG_MERGE_WINDOW_US) {
+        // no PVT frame took it, send it on its own
+        MagUbxPkt magPkt;
+        magPkt.fragments.data.X = lastMag[0];
+        magPkt.fragments.data.Y = lastMag[1];
+        magPkt.fragments.data.Z = lastMag[2];
+        magPkt.fragments.data.status = 1;
+        ubx_buildPacket(&magPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_MAG, sizeof(MagData));
+        PIOS_COM_SendBuffer(pios_com_main_id, magPkt.packet.binarystream, sizeof(MagUbxPkt));
+        magPending = false;
+    }
+
 #ifdef PIOS_HMC5X83_HAS_GPIOS
     if (!PIOS_HMC5x83_NewDataAvailable(onboard_mag)) {
         return;
@@ -48,14 +66,25 @@ void handleMag()
     static int16_t mag[3];
 
     if (PIOS_HMC5x83_ReadMag(onboard_mag, mag) == 0) {
-        MagUbxPkt magPkt;
         // swap axis so that if side with connector is aligned to revo side with connectors, mags data are aligned
-        magPkt.fragments.data.X = -mag[1];
-        magPkt.fragments.data.Y = mag[0];
-        magPkt.fragments.data.Z = mag[2];
-        magPkt.fragments.data.status = 1;
-        ubx_buildPacket(&magPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_MAG, sizeof(MagData));
-        PIOS_COM_SendBuffer(pios_com_main_id, magPkt.packet.binarystream, sizeof(MagUbxPkt));
-        return;
+        lastMag[0]  = -mag[1];
+        lastMag[1]  = mag[0];
+        lastMag[2]  = mag[2];
+        lastMagTime = PIOS_DELAY_GetRaw();
+        magPending  = true;
+    }
+}
+
+bool takeMag(int16_t mag[3], uint8_t *age_ms)
+{
+    if (!magPending) {
+        return false;
     }
+    uint32_t age = PIOS_DELAY_DiffuS(lastMagTime) / 1000;
+    mag[0]     = lastMag[0];
+    mag[1]     = lastMag[1];
+    mag[2]     = lastMag[2];
+    *age_ms    = age > 0xFF ? 0xFF : age;
+    magPending = false;
+    return true;
 }
@@ -201,7 +201,7 @@ static void updateStats()
 
     // Get stats and update
     sysPkt.fragments.data.flightTime = xTaskGetTickCount() * portTICK_RATE_MS;
-    sysPkt.fragments.data.options    = SYS_DATA_OPTIONS_MAG | (flash_available() ? SYS_DATA_OPTIONS_FLASH : 0);
+    sysPkt.fragments.data.options    = SYS_DATA_OPTIONS_MAG | SYS_DATA_OPTIONS_PVT | (flash_available() ? SYS_DATA_OPTIONS_FLASH : 0);
     ubx_buildPacket(&sysPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_SYS, sizeof(SysData));
     PIOS_COM_SendBuffer(pios_com_main_id, sysPkt.packet.binarystream, sizeof(SysUbxPkt));
 }
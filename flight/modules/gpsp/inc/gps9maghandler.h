@@ -27,6 +27,8 @@
 #define GPS9MAGHANDLER_H
 
 void handleMag();
+// hands the last mag sample over to the PVT frame, returns false when it was already sent
+bool takeMag(int16_t mag[3], uint8_t *age_ms);
 
 
 #endif
@@ -36,10 +36,19 @@
 #define UBX_OP_CUST_CLASS             0x99
 #define UBX_OP_SYS                    0x01
 #define UBX_OP_MAG                    0x02
+#define UBX_OP_PVT                    0x03
+#define UBX_NAV_CLASS                 0x01
+#define UBX_NAV_PVT                   0x07
 
 
 #define SYS_DATA_OPTIONS_FLASH        0x01
 #define SYS_DATA_OPTIONS_MAG          0x02
+#define SYS_DATA_OPTIONS_PVT          0x04
+
+#define PVT_DATA_FLAGS_FIXTYPE        0x07 // NAV-PVT fixType
+#define PVT_DATA_FLAGS_GNSSFIX_OK     0x08
+#define PVT_DATA_FLAGS_VALIDTIME      0x10
+#define PVT_DATA_FLAGS_MAG            0x20 // the mag fields hold a sample not sent on its own
 
 #define CFG_PRT_DATA_PORTID_DDC       0x00
 #define CFG_PRT_DATA_TXREADI_DISABLED 0x00
@@ -67,6 +76,76 @@ typedef union {
     UBXPacket_t packet;
 } MagUbxPkt;
 
+// NAV-PVT as sent by the receiver, the fields used by PvtData
+typedef struct {
+    uint32_t iTOW;
+    uint16_t year;
+    uint8_t  month;
+    uint8_t  day;
+    uint8_t  hour;
+    uint8_t  min;
+    uint8_t  sec;
+    uint8_t  valid;
+    uint32_t tAcc;
+    int32_t  nano;
+    uint8_t  fixType;
+    uint8_t  flags;
+    uint8_t  reserved1;
+    uint8_t  numSV;
+    int32_t  lon;
+    int32_t  lat;
+    int32_t  height;
+    int32_t  hMSL;
+    uint32_t hAcc;
+    uint32_t vAcc;
+    int32_t  velN;
+    int32_t  velE;
+    int32_t  velD;
+    int32_t  gSpeed;
+    int32_t  heading;
+    uint32_t sAcc;
+    uint32_t headingAcc;
+    uint16_t pDOP;
+    uint16_t reserved2;
+    uint32_t reserved3;
+} __attribute__((packed)) NavPvtData;
+
+// NAV-PVT parsed on the module in a compact form, along with the last mag sample
+typedef struct {
+    uint32_t iTOW; // ms
+    int32_t  lon; // deg * 1e7
+    int32_t  lat; // deg * 1e7
+    int32_t  hMSL; // mm
+    int16_t  geoidSeparation; // cm
+    int16_t  velN; // cm/s
+    int16_t  velE; // cm/s
+    int16_t  velD; // cm/s
+    uint16_t gSpeed; // cm/s
+    uint16_t heading; // deg * 100
+    uint16_t pDOP; // * 100
+    uint16_t year;
+    uint8_t  month;
+    uint8_t  day;
+    uint8_t  hour;
+    uint8_t  min;
+    uint8_t  sec;
+    uint8_t  numSV;
+    uint8_t  flags;
+    uint8_t  magAge; // ms from the mag sample to the frame
+    int16_t  magX;
+    int16_t  magY;
+    int16_t  magZ;
+} __attribute__((packed)) PvtData;
+
+typedef union {
+    struct {
+        UBXHeader_t header;
+        PvtData     data;
+        UBXFooter_t footer;
+    } __attribute__((packed)) fragments;
+    UBXPacket_t packet;
+} PvtUbxPkt;
+
 typedef struct {
     uint32_t flightTime;
     uint16_t options;
@@ -1553,6 +1553,7 @@ void vTaskStepTick( const TickType_t xTicksToJump ) PRIVILEGED_FUNCTION;
 eSleepModeStatus eTaskConfirmSleepModeStatus( void ) PRIVILEGED_FUNCTION;
 
 UBaseType_t uxTaskGetRunTime( TaskHandle_t xTask );
+uint32_t ulTaskGetMaxBurst( TaskHandle_t xTask );
 #ifdef __cplusplus
 }
 #endif
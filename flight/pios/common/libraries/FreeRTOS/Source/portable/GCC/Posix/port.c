@@ -160,6 +160,16 @@ static volatile portBASE_TYPE xPendYield = pdFALSE;
 static volatile portLONG lIndexOfLastAddedTask = 0;
 /*-----------------------------------------------------------*/
 
+/*
+ * Virtual time, the supervisor runs the ticks ulTimeScale times faster than
+ * the wall clock and the time seen by the application follows the ticks
+ */
+static volatile unsigned portLONG ulTimeScale = 1;
+static unsigned long long ullVirtualTicks = 0;
+static struct timeval xLastTickTime;
+static pthread_mutex_t xVirtualTimeMutex = PTHREAD_MUTEX_INITIALIZER;
+/*-----------------------------------------------------------*/
+
 /*
  * Setup the timer to generate the tick interrupts.
  */
@@ -293,9 +303,11 @@ portBASE_TYPE xPortStartScheduler( void )
 
 	/**
 	 * Main scheduling loop. Call the tick handler every
-	 * portTICK_RATE_MICROSECONDS
+	 * portTICK_RATE_MICROSECONDS of virtual time
 	 */
-	portLONG sleepTimeUS = portTICK_RATE_MICROSECONDS;
+	portLONG tickPeriodUS = portTICK_RATE_MICROSECONDS / ulTimeScale;
+	if ( tickPeriodUS < 1 ) tickPeriodUS = 1;
+	portLONG sleepTimeUS = tickPeriodUS;
 	portLONG actualSleepTime;
 	struct timeval lastTime,currentTime;
 	gettimeofday( &lastTime, NULL );
@@ -322,7 +334,7 @@ portBASE_TYPE xPortStartScheduler( void )
 			actualSleepTime = 1000000 * ( currentTime.tv_sec - lastTime.tv_sec ) + ( currentTime.tv_usec - lastTime.tv_usec );
 
 			/* sleep until the next tick is due */
-			sleepTimeUS += portTICK_RATE_MICROSECONDS;
+			sleepTimeUS += tickPeriodUS;
 		}
 
 		/* reduce remaining sleep time by the slept time */
@@ -330,7 +342,7 @@ portBASE_TYPE xPortStartScheduler( void )
 		lastTime = currentTime;
 
 		/* safety checks */
-		if (sleepTimeUS <=0 || sleepTimeUS >= 3 * portTICK_RATE_MICROSECONDS) sleepTimeUS = portTICK_RATE_MICROSECONDS;
+		if (sleepTimeUS <=0 || sleepTimeUS >= 3 * tickPeriodUS) sleepTimeUS = tickPeriodUS;
 
 	}
 
@@ -648,6 +660,11 @@ void vPortSystemTickHandler()
 	 */
 	xTaskIncrementTick();
 
+	PORT_LOCK( xVirtualTimeMutex );
+	ullVirtualTicks++;
+	gettimeofday( &xLastTickTime, NULL );
+	PORT_UNLOCK( xVirtualTimeMutex );
+
 	
 #if ( configUSE_PREEMPTION == 1 )
 	/**
@@ -1087,3 +1104,41 @@ struct tms xTimes;
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * Set how many times faster than the wall clock the ticks run,
+ * must be called before the scheduler is started
+ */
+void vPortSetTimeScale( unsigned portLONG ulScale )
+{
+	ulTimeScale = ( ulScale > 0 ) ? ulScale : 1;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portLONG ulPortGetTimeScale( void )
+{
+	return ulTimeScale;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Virtual time in microseconds, the ticks handled so far plus the
+ * scaled wall clock time since the last one, bound to a tick period
+ * so that the time never gets ahead of the tick count
+ */
+unsigned long long ullPortGetVirtualTimeUS( void )
+{
+	struct timeval currentTime;
+	long long sinceTickUS;
+	unsigned long long ullTimeUS;
+
+	PORT_LOCK( xVirtualTimeMutex );
+	gettimeofday( &currentTime, NULL );
+	sinceTickUS = ( 1000000LL * ( currentTime.tv_sec - xLastTickTime.tv_sec ) + ( currentTime.tv_usec - xLastTickTime.tv_usec ) ) * ulTimeScale;
+	if ( sinceTickUS < 0 ) sinceTickUS = 0;
+	if ( sinceTickUS >= portTICK_RATE_MICROSECONDS ) sinceTickUS = portTICK_RATE_MICROSECONDS - 1;
+	ullTimeUS = ullVirtualTicks * portTICK_RATE_MICROSECONDS + sinceTickUS;
+	PORT_UNLOCK( xVirtualTimeMutex );
+
+	return ullTimeUS;
+}
+/*-----------------------------------------------------------*/
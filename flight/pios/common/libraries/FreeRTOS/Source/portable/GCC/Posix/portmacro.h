@@ -118,6 +118,11 @@ extern void vPortYield( void );
 
 #define portYIELD()					vPortYield()
 
+/* Virtual time, lets the simulation run faster than the wall clock. */
+extern void vPortSetTimeScale( unsigned portLONG ulScale );
+extern unsigned portLONG ulPortGetTimeScale( void );
+extern unsigned long long ullPortGetVirtualTimeUS( void );
+
 #define portEND_SWITCHING_ISR( xSwitchRequired ) if( xSwitchRequired ) vPortYieldFromISR()
 /*-----------------------------------------------------------*/
 
@@ -154,6 +154,7 @@ typedef struct tskTaskControlBlock
 
 	#if ( configGENERATE_RUN_TIME_STATS == 1 )
 		uint32_t		ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
+		uint32_t		ulMaxBurst;			/*< Stores the longest time the task has stayed in the Running state at once. */
 	#endif
 
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
@@ -1827,6 +1828,17 @@ UBaseType_t uxTaskGetNumberOfTasks( void )
         return runTime;
     }
 
+    uint32_t ulTaskGetMaxBurst( TaskHandle_t xTask )
+    {
+        uint32_t maxBurst;
+
+        tskTCB *pxTCB;
+        pxTCB = prvGetTCBFromHandle( xTask );
+        maxBurst = pxTCB->ulMaxBurst;
+        pxTCB->ulMaxBurst = 0;
+        return maxBurst;
+    }
+
 #endif
 
 #if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
@@ -2155,7 +2167,12 @@ void vTaskSwitchContext( void )
 				are provided by the application, not the kernel. */
 				if( ulTotalRunTime > ulTaskSwitchedInTime )
 				{
-					pxCurrentTCB->ulRunTimeCounter += ( ulTotalRunTime - ulTaskSwitchedInTime );
+					uint32_t ulBurst = ulTotalRunTime - ulTaskSwitchedInTime;
+					pxCurrentTCB->ulRunTimeCounter += ulBurst;
+					if( ulBurst > pxCurrentTCB->ulMaxBurst )
+					{
+						pxCurrentTCB->ulMaxBurst = ulBurst;
+					}
 				}
 				else
 				{
@@ -2781,6 +2798,7 @@ UBaseType_t x;
 	#if ( configGENERATE_RUN_TIME_STATS == 1 )
 	{
 		pxTCB->ulRunTimeCounter = 0UL;
+		pxTCB->ulMaxBurst = 0UL;
 	}
 	#endif /* configGENERATE_RUN_TIME_STATS */
 
@@ -45,6 +45,37 @@ void DFS_CachingEnabledSet(uint8_t enable)
 	last_sector = 0xffffffff;
 }
 
+/* Write-behind of the file data: the consecutive sectors written by DFS_WriteFile are */
+/* held back and written by a single multiple block write, once the run is broken or */
+/* full, or by DFS_Flush (called by DFS_Close). Set DFS_WRITE_BEHIND_SECTORS to 0 to */
+/* write them through. */
+#ifndef DFS_WRITE_BEHIND_SECTORS
+#define DFS_WRITE_BEHIND_SECTORS 8
+#endif
+
+#if DFS_WRITE_BEHIND_SECTORS > 0
+static uint8_t write_behind[DFS_WRITE_BEHIND_SECTORS * SECTOR_SIZE];
+static uint32_t write_behind_sector;
+static uint32_t write_behind_count;
+
+/* Returns the sector held back if it is in the run, NULL otherwise */
+static uint8_t *DFS_WriteBehindSector(uint32_t sector)
+{
+	if(write_behind_count && sector >= write_behind_sector &&
+	   sector < write_behind_sector + write_behind_count) {
+		return &write_behind[(sector - write_behind_sector) * SECTOR_SIZE];
+	}
+	return NULL;
+}
+
+/* Same for any sector of a range */
+static uint8_t DFS_WriteBehindOverlaps(uint32_t sector, uint32_t count)
+{
+	return write_behind_count && sector < write_behind_sector + write_behind_count &&
+	       write_behind_sector < sector + count;
+}
+#endif
+
 
 /**
 * Converts directory name to canonical name
@@ -87,11 +118,31 @@ uint32_t DFS_ReadSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_t
 		return 1;
 	}
 
-	/* According to README.txt, count is always 1 - check this! */
-	if(count != 1) {
+	if(count == 0) {
 		return 2;
 	}
 
+	/* Forward the multiple sector reads of DFS_ReadFile to PIOS */
+	if(count > 1) {
+#if DFS_WRITE_BEHIND_SECTORS > 0
+		if(DFS_WriteBehindOverlaps(sector, count) && DFS_Flush(unit)) {
+			return 3;
+		}
+#endif
+		last_sector = 0xffffffff;
+		return PIOS_SDCARD_SectorsRead(sector, buffer, count) ? 3 : 0;
+	}
+
+#if DFS_WRITE_BEHIND_SECTORS > 0
+	/* Sector not written yet */
+	uint8_t *held = DFS_WriteBehindSector(sector);
+	if(held) {
+		memcpy(buffer, held, SECTOR_SIZE);
+		last_sector = 0xffffffff;
+		return 0;
+	}
+#endif
+
 	/* Cache: */
 	if(caching_enabled && sector == last_sector) {
 		/* we assume that sector is already in *buffer */
@@ -124,17 +175,23 @@ uint32_t DFS_WriteSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_
 		return 1;
 	}
 
-	/* According to README.txt, count is always 1 - check this! */
-	if(count != 1) {
+	if(count == 0) {
 		return 2;
 	}
 
 	/* Invalidate cache */
 	last_sector = 0xffffffff;
 
+#if DFS_WRITE_BEHIND_SECTORS > 0
+	/* Keep the order of the writes of the same sectors */
+	if(DFS_WriteBehindOverlaps(sector, count) && DFS_Flush(unit)) {
+		return 3;
+	}
+#endif
+
 	/* Forward to PIOS */
 	int32_t status;
-	if((status = PIOS_SDCARD_SectorWrite(sector, buffer)) < 0) {
+	if((status = PIOS_SDCARD_SectorsWrite(sector, buffer, count)) < 0) {
 		/* Cannot access SD Card */
 		return 3;
 	}
@@ -143,3 +200,67 @@ uint32_t DFS_WriteSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_
 	return 0;
 }
 
+/**
+* Write file data sectors to SD Card, through the write-behind
+* Returns 0 OK, nonzero for any error
+*/
+uint32_t DFS_WriteDataSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_t count)
+{
+#if DFS_WRITE_BEHIND_SECTORS > 0
+	/* Only allow access to single unit */
+	if(unit != 0) {
+		return 1;
+	}
+
+	/* Invalidate cache */
+	last_sector = 0xffffffff;
+
+	for(; count; count--, sector++, buffer += SECTOR_SIZE) {
+		uint8_t *held = DFS_WriteBehindSector(sector);
+		if(!held) {
+			/* Extend the run, or start a new one */
+			if(!write_behind_count || sector != write_behind_sector + write_behind_count ||
+			   write_behind_count == DFS_WRITE_BEHIND_SECTORS) {
+				if(DFS_Flush(unit)) {
+					return 3;
+				}
+				/* Long runs are written through, without the copy */
+				if(count >= DFS_WRITE_BEHIND_SECTORS) {
+					return DFS_WriteSector(unit, buffer, sector, count);
+				}
+				write_behind_sector = sector;
+			}
+			held = &write_behind[write_behind_count++ * SECTOR_SIZE];
+		}
+		memcpy(held, buffer, SECTOR_SIZE);
+	}
+	return 0;
+#else
+	return DFS_WriteSector(unit, buffer, sector, count);
+#endif
+}
+
+/**
+* Write the file data held back by the write-behind
+* Returns 0 OK, nonzero for any error
+*/
+uint32_t DFS_Flush(uint8_t unit)
+{
+	/* Only allow access to single unit */
+	if(unit != 0) {
+		return 1;
+	}
+
+#if DFS_WRITE_BEHIND_SECTORS > 0
+	if(write_behind_count) {
+		uint32_t count = write_behind_count;
+		/* The data is dropped on error, as the write through would have */
+		write_behind_count = 0;
+		if(PIOS_SDCARD_SectorsWrite(write_behind_sector, write_behind, count) < 0) {
+			return 3;
+		}
+	}
+#endif
+	return 0;
+}
+
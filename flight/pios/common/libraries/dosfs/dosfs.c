@@ -920,6 +920,20 @@ uint32_t DFS_OpenFile(PVOLINFO volinfo, uint8_t *path, uint8_t mode, uint8_t *sc
         return DFS_NOTFOUND;
 }
 
+/*
+        Number of full sectors of len bytes from the (sector aligned) file pointer,
+        up to the end of the current cluster
+*/
+static uint32_t DFS_ClusterSectors(PFILEINFO fileinfo, uint32_t len)
+{
+        uint32_t clustersize = fileinfo->volinfo->secperclus * SECTOR_SIZE;
+        uint32_t left = clustersize - div(fileinfo->pointer, clustersize).rem;
+
+        if (len > left)
+                len = left;
+        return len / SECTOR_SIZE;
+}
+
 /*
         Read an open file
         You must supply a prepopulated FILEINFO as provided by DFS_OpenFile, and a
@@ -986,18 +1000,15 @@ uint32_t DFS_ReadFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, uin
                 // Case 2 - File pointer is on sector boundary
                 else {
                         // Case 2A - We have at least one more full sector to read and don't have
-                        // to go through the scratch buffer. You could insert optimizations here to
-                        // read multiple sectors at a time, if you were thus inclined (note that
-                        // the maximum multi-read you could perform is a single cluster, so it would
-                        // be advantageous to have code similar to case 1A above that would round the
-                        // pointer to a cluster boundary the first pass through, so all subsequent
-                        // [large] read requests would be able to go a cluster at a time).
+                        // to go through the scratch buffer. The full sectors up to the end of the
+                        // cluster (the maximum multi-read) are read at once.
                         if (remain >= SECTOR_SIZE) {
-                                result = DFS_ReadSector(fileinfo->volinfo->unit, buffer, sector, 1);
-                                remain -= SECTOR_SIZE;
-                                buffer += SECTOR_SIZE;
-                                fileinfo->pointer += SECTOR_SIZE;
-                                bytesread = SECTOR_SIZE;
+                                uint32_t count = DFS_ClusterSectors(fileinfo, remain);
+                                result = DFS_ReadSector(fileinfo->volinfo->unit, buffer, sector, count);
+                                remain -= count * SECTOR_SIZE;
+                                buffer += count * SECTOR_SIZE;
+                                fileinfo->pointer += count * SECTOR_SIZE;
+                                bytesread = count * SECTOR_SIZE;
                         }
                         // Case 2B - We are only reading a partial sector
                         else {
@@ -1197,7 +1208,7 @@ uint32_t DFS_WriteFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, ui
                         if (remain >= (uint32_t)SECTOR_SIZE - tempsize) {
                                 memcpy(scratch + tempsize, buffer, SECTOR_SIZE - tempsize);
                                 if (!result)
-                                        result = DFS_WriteSector(fileinfo->volinfo->unit, scratch, sector, 1);
+                                        result = DFS_WriteDataSector(fileinfo->volinfo->unit, scratch, sector, 1);
 
                                 byteswritten = SECTOR_SIZE - tempsize;
                                 buffer += SECTOR_SIZE - tempsize;
@@ -1211,7 +1222,7 @@ uint32_t DFS_WriteFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, ui
                         else {
                                 memcpy(scratch + tempsize, buffer, remain);
                                 if (!result)
-                                        result = DFS_WriteSector(fileinfo->volinfo->unit, scratch, sector, 1);
+                                        result = DFS_WriteDataSector(fileinfo->volinfo->unit, scratch, sector, 1);
 
                                 buffer += remain;
                                 fileinfo->pointer += remain;
@@ -1225,18 +1236,18 @@ uint32_t DFS_WriteFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, ui
                 // Case 2 - File pointer is on sector boundary
                 else {
                         // Case 2A - We have at least one more full sector to write and don't have
-                        // to go through the scratch buffer. You could insert optimizations here to
-                        // write multiple sectors at a time, if you were thus inclined. Refer to
-                        // similar notes in DFS_ReadFile.
+                        // to go through the scratch buffer. The full sectors up to the end of the
+                        // cluster are written at once.
                         if (remain >= SECTOR_SIZE) {
-                                result = DFS_WriteSector(fileinfo->volinfo->unit, buffer, sector, 1);
-                                remain -= SECTOR_SIZE;
-                                buffer += SECTOR_SIZE;
-                                fileinfo->pointer += SECTOR_SIZE;
+                                uint32_t count = DFS_ClusterSectors(fileinfo, remain);
+                                result = DFS_WriteDataSector(fileinfo->volinfo->unit, buffer, sector, count);
+                                remain -= count * SECTOR_SIZE;
+                                buffer += count * SECTOR_SIZE;
+                                fileinfo->pointer += count * SECTOR_SIZE;
                                 if (fileinfo->filelen < fileinfo->pointer) {
                                         fileinfo->filelen = fileinfo->pointer;
                                 }
-                                byteswritten = SECTOR_SIZE;
+                                byteswritten = count * SECTOR_SIZE;
                         }
                         // Case 2B - We are only writing a partial sector and potentially need to
                         // go through the scratch buffer.
@@ -1248,11 +1259,11 @@ uint32_t DFS_WriteFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, ui
                                         result = DFS_ReadSector(fileinfo->volinfo->unit, scratch, sector, 1);
                                         if (!result) {
                                                 memcpy(scratch, buffer, remain);
-                                                result = DFS_WriteSector(fileinfo->volinfo->unit, scratch, sector, 1);
+                                                result = DFS_WriteDataSector(fileinfo->volinfo->unit, scratch, sector, 1);
                                         }
                                 }
                                 else {
-                                        result = DFS_WriteSector(fileinfo->volinfo->unit, buffer, sector, 1);
+                                        result = DFS_WriteDataSector(fileinfo->volinfo->unit, buffer, sector, 1);
                                 }
 
                                 buffer += remain;
@@ -1328,10 +1339,10 @@ uint32_t DFS_WriteFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, ui
 // TK: added 2009-02-12
         Close a file
         No original function of DosFS driver
-        It has no effect if writing to SD Card, it's only used by the DosFS wrapper in emulation
+        On the SD Card it writes the file data held back by the write-behind
 */
-uint32_t DFS_Close(__attribute__((unused)) PFILEINFO fileinfo)
+uint32_t DFS_Close(PFILEINFO fileinfo)
 {
-  return DFS_OK;
+  return DFS_Flush(fileinfo->volinfo->unit) ? DFS_ERRMISC : DFS_OK;
 }
 
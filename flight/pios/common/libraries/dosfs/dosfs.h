@@ -13,6 +13,9 @@
 // User-supplied functions
 uint32_t DFS_ReadSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_t count);
 uint32_t DFS_WriteSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_t count);
+// File data sectors, can be held back until DFS_Flush
+uint32_t DFS_WriteDataSector(uint8_t unit, uint8_t *buffer, uint32_t sector, uint32_t count);
+uint32_t DFS_Flush(uint8_t unit);
 
 
 //===================================================================
@@ -381,7 +384,7 @@ uint32_t DFS_GetFAT(PVOLINFO volinfo, uint8_t *scratch, uint32_t *scratchcache,
 // TK: added 2009-02-12
         Close a file
         No original function of DosFS driver
-        It has no effect if writing to SD Card, it's only used by the DosFS wrapper in emulation
+        On the SD Card it writes the file data held back by the write-behind
 */
 uint32_t DFS_Close(PFILEINFO fileinfo);
 
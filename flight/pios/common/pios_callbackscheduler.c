@@ -43,7 +43,11 @@
  */
 struct DelayedCallbackTaskStruct {
     DelayedCallbackInfo *callbackQueue[CALLBACK_PRIORITY_LOW + 1];
-    DelayedCallbackInfo *queueCursor[CALLBACK_PRIORITY_LOW + 1];
+    DelayedCallbackInfo *volatile readyHead[CALLBACK_PRIORITY_LOW + 1];
+    DelayedCallbackInfo *volatile readyTail[CALLBACK_PRIORITY_LOW + 1];
+    uint16_t    numCallbacks[CALLBACK_PRIORITY_LOW + 1];
+    uint16_t    runsSinceLower[CALLBACK_PRIORITY_LOW + 1];
+    DelayedCallbackInfo *wakeups;
     xTaskHandle callbackSchedulerTaskHandle;
     char name[3];
     uint32_t    stackSize;
@@ -58,7 +62,9 @@ struct DelayedCallbackTaskStruct {
 struct DelayedCallbackInfoStruct {
     DelayedCallback   cb;
     int16_t callbackID;
-    bool volatile     waiting;
+    DelayedCallbackPriority priority;
+    bool volatile     ready;
+    bool scheduled;
     uint32_t volatile scheduletime;
     uint32_t stackSize;
     int32_t  stackFree;
@@ -68,6 +74,16 @@ struct DelayedCallbackInfoStruct {
     uint32_t runCount;
     struct DelayedCallbackTaskStruct *task;
     struct DelayedCallbackInfoStruct *next;
+    struct DelayedCallbackInfoStruct *volatile readyNext;
+    struct DelayedCallbackInfoStruct *heapChild;
+    struct DelayedCallbackInfoStruct *heapNext;
+    struct DelayedCallbackInfoStruct *heapPrev;
+#ifdef DIAG_CALLBACK_TIMING
+    uint32_t volatile dispatchTime;
+    uint32_t takenDispatchTime;
+    struct pios_callback_timing latency;
+    struct pios_callback_timing runtime;
+#endif
 };
 
 
@@ -78,7 +94,10 @@ static bool schedulerStarted;
 
 // Private functions
 static void CallbackSchedulerTask(void *task);
-static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority);
+static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task);
+static void setReady(DelayedCallbackInfo *cbinfo);
+static void heapInsert(struct DelayedCallbackTaskStruct *task, DelayedCallbackInfo *cbinfo);
+static void heapRemove(struct DelayedCallbackTaskStruct *task, DelayedCallbackInfo *cbinfo);
 
 /**
  * Initialize the scheduler
@@ -187,6 +206,10 @@ int32_t PIOS_CALLBACKSCHEDULER_Schedule(
             result = 2;
         }
         cbinfo->scheduletime = new;
+        if (cbinfo->scheduled) {
+            heapRemove(cbinfo->task, cbinfo);
+        }
+        heapInsert(cbinfo->task, cbinfo);
 
         // scheduler needs to be notified to adapt sleep times
         xSemaphoreGive(cbinfo->task->signal);
@@ -208,7 +231,7 @@ int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo)
     PIOS_Assert(cbinfo);
 
     // no semaphore needed for the callback
-    cbinfo->waiting = true;
+    setReady(cbinfo);
     // but the scheduler as a whole needs to be notified
     return xSemaphoreGive(cbinfo->task->signal);
 }
@@ -232,7 +255,7 @@ int32_t PIOS_CALLBACKSCHEDULER_DispatchFromISR(DelayedCallbackInfo *cbinfo, long
     PIOS_Assert(cbinfo);
 
     // no semaphore needed for the callback
-    cbinfo->waiting = true;
+    setReady(cbinfo);
     // but the scheduler as a whole needs to be notified
     return xSemaphoreGiveFromISR(cbinfo->task->signal, pxHigherPriorityTaskWoken);
 }
@@ -281,9 +304,13 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
 
         // initialize structure
         for (DelayedCallbackPriority p = 0; p <= CALLBACK_PRIORITY_LOW; p++) {
-            task->callbackQueue[p] = NULL;
-            task->queueCursor[p]   = NULL;
+            task->callbackQueue[p]  = NULL;
+            task->readyHead[p]      = NULL;
+            task->readyTail[p]      = NULL;
+            task->numCallbacks[p]   = 0;
+            task->runsSinceLower[p] = 0;
         }
+        task->wakeups      = NULL;
         task->name[0]      = 'C';
         task->name[1]      = 'a' + t;
         task->name[2]      = 0;
@@ -335,7 +362,13 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
         return NULL; // error - not enough memory
     }
     info->next               = NULL;
-    info->waiting            = false;
+    info->readyNext          = NULL;
+    info->heapChild          = NULL;
+    info->heapNext           = NULL;
+    info->heapPrev           = NULL;
+    info->priority           = priority;
+    info->ready              = false;
+    info->scheduled          = false;
     info->scheduletime       = 0;
     info->task               = task;
     info->cb = cb;
@@ -346,9 +379,14 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
     info->stackFree          = 0;
     info->stackSafetyCount   = STACK_SAFETYCOUNT;
     info->currentSafetyCount = 0;
+#ifdef DIAG_CALLBACK_TIMING
+    memset(&info->latency, 0, sizeof(info->latency));
+    memset(&info->runtime, 0, sizeof(info->runtime));
+#endif
 
     // add to scheduling queue
     LL_APPEND(task->callbackQueue[priority], info);
+    task->numCallbacks[priority]++;
 
     xSemaphoreGiveRecursive(mutex);
 
@@ -380,6 +418,13 @@ void PIOS_CALLBACKSCHEDULER_ForEachCallback(CallbackSchedulerCallbackInfoCallbac
                 info.is_running = true;
                 info.stack_remaining    = cbinfo->stackNotFree;
                 info.running_time_count = cbinfo->runCount;
+#ifdef DIAG_CALLBACK_TIMING
+                info.latency = &cbinfo->latency;
+                info.runtime = &cbinfo->runtime;
+#else
+                info.latency = NULL;
+                info.runtime = NULL;
+#endif
                 xSemaphoreGiveRecursive(mutex);
                 callback(cbinfo->callbackID, &info, context);
             }
@@ -458,75 +503,254 @@ static void checkStack(DelayedCallbackInfo *current)
 }
 
 /**
- * Scheduler subtask
- * \param[in] task The scheduler task in question
- * \param[in] priority The scheduling priority of the callback to search for
- * \return wait time until next scheduled callback is due - 0 if a callback has just been executed
+ * Mark a callback ready to run, once, in the ready queue of its priority.
+ * Safe to call from an ISR.
  */
-static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority)
+static void setReady(DelayedCallbackInfo *cbinfo)
 {
-    int32_t result = MAX_SLEEP;
-    int32_t diff   = 0;
+    struct DelayedCallbackTaskStruct *task = cbinfo->task;
+
+    PIOS_IRQ_Disable();
+    if (!cbinfo->ready) {
+#ifdef DIAG_CALLBACK_TIMING
+        cbinfo->dispatchTime = PIOS_DELAY_GetRaw();
+#endif
+        cbinfo->ready     = true;
+        cbinfo->readyNext = NULL;
+        if (task->readyTail[cbinfo->priority]) {
+            task->readyTail[cbinfo->priority]->readyNext = cbinfo;
+        } else {
+            task->readyHead[cbinfo->priority] = cbinfo;
+        }
+        task->readyTail[cbinfo->priority] = cbinfo;
+    }
+    PIOS_IRQ_Enable();
+}
 
+/**
+ * Take the next ready callback, highest priority first
+ * \param[in] task The scheduler task in question
+ * \param[in] priority The highest scheduling priority to search for
+ * \return the callback to run, NULL if none is ready
+ */
+static DelayedCallbackInfo *takeReady(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority)
+{
     // no such queue
     if (priority > CALLBACK_PRIORITY_LOW) {
-        return result;
+        return NULL;
     }
 
     // queue is empty, search a lower priority queue
-    if (task->callbackQueue[priority] == NULL) {
-        return runNextCallback(task, priority + 1);
-    }
-
-    DelayedCallbackInfo *current = task->queueCursor[priority];
-    DelayedCallbackInfo *next;
-    do {
-        if (current == NULL) {
-            next = task->callbackQueue[priority]; // loop around the end of the list
-            // also attempt to run a callback that has lower priority
-            // every time the queue is completely traversed
-            diff = runNextCallback(task, priority + 1);
-            if (!diff) {
-                task->queueCursor[priority] = next; // the recursive call has executed a callback
-                return 0;
-            }
-            if (diff < result) {
-                result = diff; // adjust sleep time
-            }
+    if (task->readyHead[priority] == NULL) {
+        return takeReady(task, priority + 1);
+    }
+
+    // also attempt to run a callback that has lower priority every time as many
+    // callbacks as this priority has have been run, so that they never starve
+    if (task->runsSinceLower[priority] >= task->numCallbacks[priority]) {
+        task->runsSinceLower[priority] = 0;
+        DelayedCallbackInfo *lower = takeReady(task, priority + 1);
+        if (lower) {
+            return lower;
+        }
+    }
+    task->runsSinceLower[priority]++;
+
+    PIOS_IRQ_Disable();
+    DelayedCallbackInfo *current = task->readyHead[priority];
+    task->readyHead[priority] = current->readyNext;
+    if (!task->readyHead[priority]) {
+        task->readyTail[priority] = NULL;
+    }
+    current->ready = false; // the flag is reset just before execution.
+#ifdef DIAG_CALLBACK_TIMING
+    current->takenDispatchTime = current->dispatchTime; // a new dispatch may come in before it runs
+#endif
+    PIOS_IRQ_Enable();
+
+    return current;
+}
+
+/**
+ * The scheduled callbacks of a task are kept in a pairing heap ordered by scheduletime,
+ * linked through the callbacks themselves. heapPrev points to the parent of a first child
+ * and to the left sibling of the other children.
+ * all heap functions must be called with the mutex held
+ */
+static bool scheduledBefore(DelayedCallbackInfo *a, DelayedCallbackInfo *b)
+{
+    return (int32_t)(a->scheduletime - b->scheduletime) < 0; // wraparound safe
+}
+
+static DelayedCallbackInfo *heapMeld(DelayedCallbackInfo *a, DelayedCallbackInfo *b)
+{
+    if (!a) {
+        return b;
+    }
+    if (!b) {
+        return a;
+    }
+    if (scheduledBefore(b, a)) {
+        DelayedCallbackInfo *t = a;
+        a = b;
+        b = t;
+    }
+    // b becomes the first child of a
+    b->heapPrev = a;
+    b->heapNext = a->heapChild;
+    if (a->heapChild) {
+        a->heapChild->heapPrev = b;
+    }
+    a->heapChild = b;
+    return a;
+}
+
+static DelayedCallbackInfo *heapMergePairs(DelayedCallbackInfo *first)
+{
+    DelayedCallbackInfo *pairs = NULL;
+
+    // meld the siblings by pairs from left to right, collecting the results in reverse order
+    while (first) {
+        DelayedCallbackInfo *a = first;
+        DelayedCallbackInfo *b = a->heapNext;
+        first = b ? b->heapNext : NULL;
+        a->heapNext = NULL;
+        a->heapPrev = NULL;
+        if (b) {
+            b->heapNext = NULL;
+            b->heapPrev = NULL;
+        }
+        a = heapMeld(a, b);
+        a->heapNext = pairs;
+        pairs = a;
+    }
+
+    // then meld the pairs from right to left
+    DelayedCallbackInfo *root = NULL;
+    while (pairs) {
+        DelayedCallbackInfo *next = pairs->heapNext;
+        pairs->heapNext = NULL;
+        root  = heapMeld(root, pairs);
+        pairs = next;
+    }
+    return root;
+}
+
+static void heapInsert(struct DelayedCallbackTaskStruct *task, DelayedCallbackInfo *cbinfo)
+{
+    cbinfo->heapChild = NULL;
+    cbinfo->heapNext  = NULL;
+    cbinfo->heapPrev  = NULL;
+    cbinfo->scheduled = true;
+    task->wakeups     = heapMeld(task->wakeups, cbinfo);
+}
+
+static void heapRemove(struct DelayedCallbackTaskStruct *task, DelayedCallbackInfo *cbinfo)
+{
+    if (cbinfo == task->wakeups) {
+        task->wakeups = heapMergePairs(cbinfo->heapChild);
+    } else {
+        // detach the subtree from its parent or left sibling
+        if (cbinfo->heapPrev->heapChild == cbinfo) {
+            cbinfo->heapPrev->heapChild = cbinfo->heapNext;
         } else {
-            next = current->next;
-            xSemaphoreTakeRecursive(mutex, portMAX_DELAY); // access to scheduletime should be mutex protected
-            if (current->scheduletime) {
-                diff = current->scheduletime - xTaskGetTickCount();
-                if (diff <= 0) {
-                    current->waiting = true;
-                } else if (diff < result) {
-                    result = diff; // adjust sleep time
-                }
-            }
-            if (current->waiting) {
-                task->queueCursor[priority] = next;
-                current->scheduletime = 0; // any schedules are reset
-                current->waiting = false; // the flag is reset just before execution.
-                xSemaphoreGiveRecursive(mutex);
+            cbinfo->heapPrev->heapNext = cbinfo->heapNext;
+        }
+        if (cbinfo->heapNext) {
+            cbinfo->heapNext->heapPrev = cbinfo->heapPrev;
+        }
+        task->wakeups = heapMeld(task->wakeups, heapMergePairs(cbinfo->heapChild));
+    }
+    cbinfo->heapChild = NULL;
+    cbinfo->heapNext  = NULL;
+    cbinfo->heapPrev  = NULL;
+    cbinfo->scheduled = false;
+}
 
-                /* callback gets invoked here - check stack sizes */
-                markStack(current);
+#ifdef DIAG_CALLBACK_TIMING
+/**
+ * Add a duration to a callback timing distribution
+ */
+static void addTiming(struct pios_callback_timing *timing, uint32_t us)
+{
+    uint8_t bucket = us ? 32 - __builtin_clz(us) : 0;
 
-                current->cb(); // call the callback
+    if (bucket >= PIOS_CALLBACKSCHEDULER_TIMING_BUCKETS) {
+        bucket = PIOS_CALLBACKSCHEDULER_TIMING_BUCKETS - 1;
+    }
+    timing->histogram[bucket]++;
+    if (!timing->count || us < timing->min) {
+        timing->min = us;
+    }
+    if (us > timing->max) {
+        timing->max = us;
+    }
+    timing->sum += us;
+    timing->count++;
+}
+#endif /* DIAG_CALLBACK_TIMING */
 
-                checkStack(current);
+/**
+ * Scheduler subtask
+ * \param[in] task The scheduler task in question
+ * \return wait time until next scheduled callback is due - 0 if a callback has just been executed
+ */
+static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task)
+{
+    int32_t result = MAX_SLEEP;
 
-                current->runCount++;
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY); // access to scheduletime should be mutex protected
 
-                return 0;
+    // callbacks whose schedule is due become ready, they keep their scheduletime until they run
+    while (task->wakeups) {
+        int32_t diff = task->wakeups->scheduletime - xTaskGetTickCount();
+        if (diff > 0) {
+            if (diff < result) {
+                result = diff; // adjust sleep time
             }
-            xSemaphoreGiveRecursive(mutex);
+            break;
         }
-        current = next;
-    } while (current != task->queueCursor[priority]);
-    // once the list has been traversed entirely without finding any to be executed task, abort (nothing to do)
-    return result;
+        DelayedCallbackInfo *due = task->wakeups;
+        heapRemove(task, due);
+        setReady(due);
+    }
+
+    DelayedCallbackInfo *current = takeReady(task, CALLBACK_PRIORITY_CRITICAL);
+    if (current) {
+        // any schedules are reset
+        if (current->scheduled) {
+            heapRemove(task, current);
+        }
+        current->scheduletime = 0;
+    }
+
+    xSemaphoreGiveRecursive(mutex);
+
+    if (!current) {
+        return result;
+    }
+
+    /* callback gets invoked here - check stack sizes */
+    markStack(current);
+
+#ifdef DIAG_CALLBACK_TIMING
+    addTiming(&current->latency, PIOS_DELAY_DiffuS(current->takenDispatchTime));
+    uint32_t start = PIOS_DELAY_GetRaw();
+#endif
+
+    PIOS_TRACE(PIOS_TRACE_CALLBACK_START, current->callbackID);
+    current->cb(); // call the callback
+    PIOS_TRACE(PIOS_TRACE_CALLBACK_END, current->callbackID);
+
+#ifdef DIAG_CALLBACK_TIMING
+    addTiming(&current->runtime, PIOS_DELAY_DiffuS(start));
+#endif
+
+    checkStack(current);
+
+    current->runCount++;
+
+    return 0;
 }
 
 /**
@@ -538,7 +762,7 @@ static void CallbackSchedulerTask(void *task)
     uint32_t delay = 0;
 
     while (1) {
-        delay = runNextCallback((struct DelayedCallbackTaskStruct *)task, CALLBACK_PRIORITY_CRITICAL);
+        delay = runNextCallback((struct DelayedCallbackTaskStruct *)task);
         if (delay) {
             // nothing to do but sleep
             xSemaphoreTake(((struct DelayedCallbackTaskStruct *)task)->signal, delay);
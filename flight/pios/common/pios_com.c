@@ -101,6 +101,7 @@ static struct pios_com_dev *PIOS_COM_alloc(void)
 #endif /* if defined(PIOS_INCLUDE_FREERTOS) */
 
 static uint16_t PIOS_COM_TxOutCallback(uint32_t context, uint8_t *buf, uint16_t buf_len, uint16_t *headroom, bool *need_yield);
+static uint16_t PIOS_COM_TxDmaCallback(uint32_t context, uint16_t consumed, uint8_t **buf, bool *need_yield);
 static uint16_t PIOS_COM_RxInCallback(uint32_t context, uint8_t *buf, uint16_t buf_len, uint16_t *headroom, bool *need_yield);
 static void PIOS_COM_UnblockRx(struct pios_com_dev *com_dev, bool *need_yield);
 static void PIOS_COM_UnblockTx(struct pios_com_dev *com_dev, bool *need_yield);
@@ -155,6 +156,10 @@ int32_t PIOS_COM_Init(uint32_t *com_id, const struct pios_com_driver *driver, ui
         vSemaphoreCreateBinary(com_dev->tx_sem);
 #endif /* PIOS_INCLUDE_FREERTOS */
         (com_dev->driver->bind_tx_cb)(lower_id, PIOS_COM_TxOutCallback, (uint32_t)com_dev);
+        if (com_dev->driver->bind_tx_dma_cb) {
+            /* The driver may also transmit straight from the fifo */
+            (com_dev->driver->bind_tx_dma_cb)(lower_id, PIOS_COM_TxDmaCallback, (uint32_t)com_dev);
+        }
     }
 #if defined(PIOS_INCLUDE_FREERTOS)
     com_dev->sendbuffer_sem = xSemaphoreCreateMutex();
@@ -259,6 +264,32 @@ static uint16_t PIOS_COM_TxOutCallback(uint32_t context, uint8_t *buf, uint16_t
     return bytes_from_fifo;
 }
 
+/**
+ * Hands out the tx fifo contents in place, for drivers transmitting by DMA.
+ * The segment stays in the fifo until the next call releases it.
+ * \param[in] consumed Number of bytes of the previous segment that have been sent
+ * \param[out] buf Start of the next contiguous segment
+ * \return length of the segment, 0 if the fifo is empty
+ */
+static uint16_t PIOS_COM_TxDmaCallback(uint32_t context, uint16_t consumed, uint8_t **buf, bool *need_yield)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)context;
+
+    bool valid = PIOS_COM_validate(com_dev);
+
+    PIOS_Assert(valid);
+    PIOS_Assert(buf);
+    PIOS_Assert(com_dev->has_tx);
+
+    if (consumed > 0) {
+        fifoBuf_removeData(&com_dev->tx, consumed);
+        /* More space has been made in the buffer */
+        PIOS_COM_UnblockTx(com_dev, need_yield);
+    }
+
+    return fifoBuf_getDataPtr(&com_dev->tx, buf);
+}
+
 /**
  * Change the port speed without re-initializing
  * \param[in] port COM port
@@ -283,6 +314,33 @@ int32_t PIOS_COM_ChangeBaud(uint32_t com_id, uint32_t baud)
     return 0;
 }
 
+/**
+ * Get notified of the baud rate the host sets on the port
+ * \param[in] port COM port
+ * \param[in] baud_rate_cb called with the new baud rate, possibly from an interrupt
+ * \param[in] context passed to the callback
+ * \return -1 if port not available
+ * \return -2 if the port does not report the baud rate of the host
+ * \return 0 on success
+ */
+int32_t PIOS_COM_RegisterBaudRateCallback(uint32_t com_id, pios_com_baud_rate_callback baud_rate_cb, uint32_t context)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+
+    if (!com_dev->driver->bind_baud_rate_cb) {
+        return -2;
+    }
+
+    com_dev->driver->bind_baud_rate_cb(com_dev->lower_id, baud_rate_cb, context);
+
+    return 0;
+}
+
 
 static int32_t PIOS_COM_SendBufferNonBlockingInternal(struct pios_com_dev *com_dev, const uint8_t *buffer, uint16_t len)
 {
@@ -351,32 +409,16 @@ int32_t PIOS_COM_SendBufferNonBlocking(uint32_t com_id, const uint8_t *buffer, u
 
 
 /**
- * Sends a package over given port
- * (blocking function)
- * \param[in] port COM port
- * \param[in] buffer character buffer
- * \param[in] len buffer length
+ * Sends a package, the caller holds the send mutex
  * \return -1 if port not available
- * \return -2 if mutex can't be taken;
  * \return -3 if data cannot be sent in the max allotted time of 5000msec
  * \return number of bytes transmitted on success
  */
-int32_t PIOS_COM_SendBuffer(uint32_t com_id, const uint8_t *buffer, uint16_t len)
+static int32_t PIOS_COM_SendBufferLocked(struct pios_com_dev *com_dev, const uint8_t *buffer, uint16_t len)
 {
-    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
-
-    if (!PIOS_COM_validate(com_dev)) {
-        /* Undefined COM port for this board (see pios_board.c) */
-        return -1;
-    }
-    PIOS_Assert(com_dev->has_tx);
-#if defined(PIOS_INCLUDE_FREERTOS)
-    if (xSemaphoreTake(com_dev->sendbuffer_sem, 5) != pdTRUE) {
-        return -2;
-    }
-#endif /* PIOS_INCLUDE_FREERTOS */
     uint32_t max_frag_len  = fifoBuf_getSize(&com_dev->tx);
     uint32_t bytes_to_send = len;
+
     while (bytes_to_send) {
         uint32_t frag_size;
 
@@ -392,9 +434,6 @@ int32_t PIOS_COM_SendBuffer(uint32_t com_id, const uint8_t *buffer, uint16_t len
         } else {
             switch (rc) {
             case -1:
-#if defined(PIOS_INCLUDE_FREERTOS)
-                xSemaphoreGive(com_dev->sendbuffer_sem);
-#endif /* PIOS_INCLUDE_FREERTOS */
                 /* Device is invalid, this will never work */
                 return -1;
 
@@ -407,24 +446,185 @@ int32_t PIOS_COM_SendBuffer(uint32_t com_id, const uint8_t *buffer, uint16_t len
                 }
 #if defined(PIOS_INCLUDE_FREERTOS)
                 if (xSemaphoreTake(com_dev->tx_sem, 5000) != pdTRUE) {
-                    xSemaphoreGive(com_dev->sendbuffer_sem);
                     return -3;
                 }
 #endif
                 continue;
             default:
                 /* Unhandled return code */
+                return rc;
+            }
+        }
+    }
+    return len;
+}
+
+/**
+ * Sends a package over given port
+ * (blocking function)
+ * \param[in] port COM port
+ * \param[in] buffer character buffer
+ * \param[in] len buffer length
+ * \return -1 if port not available
+ * \return -2 if mutex can't be taken;
+ * \return -3 if data cannot be sent in the max allotted time of 5000msec
+ * \return number of bytes transmitted on success
+ */
+int32_t PIOS_COM_SendBuffer(uint32_t com_id, const uint8_t *buffer, uint16_t len)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+    PIOS_Assert(com_dev->has_tx);
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (xSemaphoreTake(com_dev->sendbuffer_sem, 5) != pdTRUE) {
+        return -2;
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+    int32_t rc = PIOS_COM_SendBufferLocked(com_dev, buffer, len);
 #if defined(PIOS_INCLUDE_FREERTOS)
-                xSemaphoreGive(com_dev->sendbuffer_sem);
+    xSemaphoreGive(com_dev->sendbuffer_sem);
 #endif /* PIOS_INCLUDE_FREERTOS */
-                return rc;
+    return rc;
+}
+
+/**
+ * Sends several buffers over given port, one after the other and without other
+ * senders in between, saving the caller from assembling them
+ * (blocking function)
+ * \param[in] port COM port
+ * \param[in] iov buffers to send, they are not modified
+ * \param[in] count number of buffers
+ * \return -1 if port not available
+ * \return -2 if mutex can't be taken;
+ * \return -3 if data cannot be sent in the max allotted time of 5000msec
+ * \return number of bytes transmitted on success
+ */
+int32_t PIOS_COM_SendVector(uint32_t com_id, const struct pios_com_iovec *iov, uint8_t count)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+    PIOS_Assert(com_dev->has_tx);
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (xSemaphoreTake(com_dev->sendbuffer_sem, 5) != pdTRUE) {
+        return -2;
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+    int32_t total = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        int32_t rc = PIOS_COM_SendBufferLocked(com_dev, iov[i].data, iov[i].len);
+        if (rc < 0) {
+            total = rc;
+            break;
+        }
+        total += rc;
+    }
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreGive(com_dev->sendbuffer_sem);
+#endif /* PIOS_INCLUDE_FREERTOS */
+    return total;
+}
+
+/**
+ * Reserves space in the tx buffer for the caller to write a package in place, e.g. to pack
+ * an object without an intermediate copy. The space is made of up to two regions, the second
+ * one starting at the beginning of the buffer when the space wraps around its end.
+ * Other senders are held off until PIOS_COM_TxCommit(), which must follow a successful call.
+ * (blocking function)
+ * \param[in] port COM port
+ * \param[in] len number of bytes to reserve
+ * \param[out] regions the regions to write, the second one is empty when not needed
+ * \return -1 if port not available or len larger than the tx buffer
+ * \return -2 if mutex can't be taken;
+ * \return -3 if the space cannot be freed in the max allotted time of 5000msec
+ * \return 0 on success
+ */
+int32_t PIOS_COM_TxReserve(uint32_t com_id, uint16_t len, struct pios_com_iovec regions[2])
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+    PIOS_Assert(com_dev->has_tx);
+    if (len > fifoBuf_getSize(&com_dev->tx)) {
+        return -1;
+    }
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (xSemaphoreTake(com_dev->sendbuffer_sem, 5) != pdTRUE) {
+        return -2;
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+    if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+        /* Underlying device is down/unconnected, the package will be dropped on commit */
+        fifoBuf_clearData(&com_dev->tx);
+    }
+    while (fifoBuf_getFree(&com_dev->tx) < len) {
+        /* Wait for the underlying device to free some space */
+        if (com_dev->driver->tx_start) {
+            (com_dev->driver->tx_start)(com_dev->lower_id,
+                                        fifoBuf_getUsed(&com_dev->tx));
+        }
+#if defined(PIOS_INCLUDE_FREERTOS)
+        if (xSemaphoreTake(com_dev->tx_sem, 5000) != pdTRUE) {
+            xSemaphoreGive(com_dev->sendbuffer_sem);
+            return -3;
+        }
+#endif
+    }
+
+    regions[0].len = fifoBuf_getFreePtr(&com_dev->tx, &regions[0].data);
+    if (regions[0].len >= len) {
+        regions[0].len  = len;
+        regions[1].data = NULL;
+        regions[1].len  = 0;
+    } else {
+        regions[1].data = com_dev->tx.buf_ptr;
+        regions[1].len  = len - regions[0].len;
+    }
+    return 0;
+}
+
+/**
+ * Sends the package written in the space reserved by PIOS_COM_TxReserve()
+ * \param[in] port COM port
+ * \param[in] len number of bytes written, at most the reserved length, 0 to cancel
+ * \return -1 if port not available
+ * \return 0 on success
+ */
+int32_t PIOS_COM_TxCommit(uint32_t com_id, uint16_t len)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+    PIOS_Assert(com_dev->has_tx);
+    if (len > 0) {
+        if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+            /* Act like an infinite data sink, as PIOS_COM_SendBuffer() does */
+        } else {
+            fifoBuf_addData(&com_dev->tx, len);
+            /* More data has been put in the tx buffer, make sure the tx is started */
+            if (com_dev->driver->tx_start) {
+                com_dev->driver->tx_start(com_dev->lower_id,
+                                          fifoBuf_getUsed(&com_dev->tx));
             }
         }
     }
 #if defined(PIOS_INCLUDE_FREERTOS)
     xSemaphoreGive(com_dev->sendbuffer_sem);
 #endif /* PIOS_INCLUDE_FREERTOS */
-    return len;
+    return 0;
 }
 
 /**
@@ -34,7 +34,17 @@
 #include "debuglogentry.h"
 
 // global definitions
-
+#if defined(PIOS_INCLUDE_FREERTOS) && defined(PIOS_INCLUDE_CALLBACKSCHEDULER)
+// producers only fill RAM buffers, full buffers are written to flash by a low priority callback
+#define PIOS_DEBUGLOG_ASYNC
+#define LOG_BUFFER_COUNT       3
+#define LOG_WRITER_PRIORITY    CALLBACK_PRIORITY_LOW
+#define LOG_WRITER_TASK        CALLBACK_TASK_AUXILIARY
+#define LOG_WRITER_STACK_SIZE  512
+#define LOG_WRITER_RETRY_MS    100
+#else
+#define LOG_BUFFER_COUNT       1
+#endif
 
 // Global variables
 extern uintptr_t pios_user_fs_id; // flash filesystem for logging
@@ -48,16 +58,33 @@ static xSemaphoreHandle mutex = 0;
 #define mutexunlock()
 #endif
 
+#if defined(PIOS_DEBUGLOG_ASYNC)
+// serializes flash filesystem access between the writer callback and the other users
+static xSemaphoreHandle fs_mutex = 0;
+#define fslock()      xSemaphoreTakeRecursive(fs_mutex, portMAX_DELAY)
+#define fsunlock()    xSemaphoreGiveRecursive(fs_mutex)
+static DelayedCallbackInfo *writerCallback = 0;
+#else
+#define fslock()      mutexlock()
+#define fsunlock()    mutexunlock()
+#endif
+
 static bool logging_enabled = false;
 #define MAX_CONSECUTIVE_FAILS_COUNT 10
 static bool log_is_full     = false;
 static uint8_t fails_count  = 0;
 static uint16_t flightnum   = 0;
 static uint16_t lognum = 0;
-static DebugLogEntryData *buffer = 0;
+static uint16_t write_flight   = 0; // flight the last written buffer belonged to
+static uint32_t dropped_entries = 0;
+static DebugLogEntryData *buffers = 0;
 #if !defined(PIOS_INCLUDE_FREERTOS)
-static DebugLogEntryData staticbuffer;
+static DebugLogEntryData staticbuffer[LOG_BUFFER_COUNT];
 #endif
+static uint32_t buffer_used[LOG_BUFFER_COUNT];
+static volatile bool buffer_ready[LOG_BUFFER_COUNT];
+static uint8_t fill_idx  = 0; // buffer currently filled by producers
+static uint8_t write_idx = 0; // next buffer to be written to flash
 
 #define LOG_ENTRY_MAX_DATA_SIZE (sizeof(((DebugLogEntryData *)0)->Data))
 #define LOG_ENTRY_HEADER_SIZE   (sizeof(DebugLogEntryData) - LOG_ENTRY_MAX_DATA_SIZE)
@@ -66,9 +93,54 @@ static DebugLogEntryData staticbuffer;
 
 static uint32_t used_buffer_space = 0;
 
+/*
+ * Compressed entries (DEBUGLOGENTRY_TYPE_COMPRESSEDUAVOBJECTS) hold a stream of records in Data:
+ * record     := index [definition] delta payload
+ * index      := uint8 dictionary index, LOG_DICT_DEFINE defines the next free index, 0xff ends the block
+ * definition := objid (uint32, little endian) instid (varint) size (varint)
+ * delta      := varint, microseconds since the previous record in the block (since FlightTime for the first)
+ * payload    := for each group of up to 8 bytes XOR'ed with the previous sample of the same object
+ * (zero for a new definition) a bit mask followed by the bytes whose bit is set.
+ * The dictionary and the previous samples live for one flight, the decoder has to process
+ * all entries of a flight in order.
+ */
+#define LOG_DICT_SIZE         32
+#define LOG_DICT_SAMPLES_SIZE 1024
+#define LOG_DICT_DEFINE       0xfe
+#define LOG_DICT_END          0xff
+
+struct log_dict_entry {
+    uint32_t objid;
+    uint16_t instid;
+    uint16_t size;
+    uint16_t offset; // of the previous sample in dict_samples
+};
+
+static struct log_dict_entry *dict = 0;
+static uint8_t *dict_samples = 0;
+#if !defined(PIOS_INCLUDE_FREERTOS)
+static struct log_dict_entry staticdict[LOG_DICT_SIZE];
+static uint8_t staticdictsamples[LOG_DICT_SAMPLES_SIZE];
+#endif
+static uint8_t dict_count = 0;
+static uint16_t dict_samples_used = 0;
+static uint32_t block_time    = 0; // time of the last record in the current compressed block
+static uint8_t record[LOG_ENTRY_MAX_DATA_SIZE];
+
 /* Private Function Prototypes */
 static void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data);
-static bool write_current_buffer();
+static bool enqueue_compressed(uint32_t objid, uint16_t instid, size_t size, uint8_t *data);
+static uint32_t encode_record(uint8_t index, const struct log_dict_entry *def, uint32_t delta, size_t size, const uint8_t *data, const uint8_t *previous);
+static void reset_dictionary();
+static bool get_free_buffer();
+static void queue_current_buffer();
+static void kick_writer();
+static void write_pending_buffers();
+static void reset_buffers();
+#if defined(PIOS_DEBUGLOG_ASYNC)
+static void writerTask();
+#endif
+
 /**
  * @brief Initialize the log facility
  */
@@ -76,25 +148,38 @@ void PIOS_DEBUGLOG_Initialize()
 {
 #if defined(PIOS_INCLUDE_FREERTOS)
     if (!mutex) {
-        mutex  = xSemaphoreCreateRecursiveMutex();
-        buffer = pios_malloc(sizeof(DebugLogEntryData));
+        mutex   = xSemaphoreCreateRecursiveMutex();
+        buffers = pios_malloc(sizeof(DebugLogEntryData) * LOG_BUFFER_COUNT);
+        dict    = pios_malloc(sizeof(struct log_dict_entry) * LOG_DICT_SIZE);
+        dict_samples = pios_malloc(LOG_DICT_SAMPLES_SIZE);
+#if defined(PIOS_DEBUGLOG_ASYNC)
+        fs_mutex = xSemaphoreCreateRecursiveMutex();
+        writerCallback = PIOS_CALLBACKSCHEDULER_Create(&writerTask, LOG_WRITER_PRIORITY, LOG_WRITER_TASK, -1, LOG_WRITER_STACK_SIZE);
+        PIOS_Assert(writerCallback);
+#endif
     }
 #else
-    buffer = &staticbuffer;
+    buffers = staticbuffer;
+    dict    = staticdict;
+    dict_samples = staticdictsamples;
 #endif
-    if (!buffer) {
+    if (!buffers) {
         return;
     }
+    fslock();
     mutexlock();
     lognum      = 0;
     flightnum   = 0;
     fails_count = 0;
-    used_buffer_space = 0;
     log_is_full = false;
-    while (PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
+    reset_buffers();
+    reset_dictionary();
+    while (PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)&buffers[0], sizeof(DebugLogEntryData)) == 0) {
         flightnum++;
     }
+    write_flight = flightnum;
     mutexunlock();
+    fsunlock();
 }
 
 
@@ -106,8 +191,12 @@ void PIOS_DEBUGLOG_Enable(uint8_t enabled)
 {
     // increase the flight num as soon as logging is disabled
     if (logging_enabled && !enabled) {
+        mutexlock();
+        // pending data still belongs to the flight being closed
+        queue_current_buffer();
         flightnum++;
-        lognum = 0;
+        reset_dictionary();
+        mutexunlock();
     }
     logging_enabled = enabled;
 }
@@ -122,12 +211,14 @@ void PIOS_DEBUGLOG_Enable(uint8_t enabled)
  */
 void PIOS_DEBUGLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
 {
-    if (!logging_enabled || !buffer || log_is_full) {
+    if (!logging_enabled || !buffers || log_is_full) {
         return;
     }
     mutexlock();
 
-    enqueue_data(objid, instid, size, data);
+    if (!enqueue_compressed(objid, instid, size, data)) {
+        enqueue_data(objid, instid, size, data);
+    }
 
     mutexunlock();
 }
@@ -139,7 +230,7 @@ void PIOS_DEBUGLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, uint8
  */
 void PIOS_DEBUGLOG_Printf(char *format, ...)
 {
-    if (!logging_enabled || !buffer || log_is_full) {
+    if (!logging_enabled || !buffers || log_is_full) {
         return;
     }
 
@@ -147,9 +238,14 @@ void PIOS_DEBUGLOG_Printf(char *format, ...)
     va_start(args, format);
     mutexlock();
     // flush any pending buffer before writing debug text
-    if (used_buffer_space) {
-        write_current_buffer();
+    queue_current_buffer();
+    if (!get_free_buffer()) {
+        dropped_entries++;
+        mutexunlock();
+        va_end(args);
+        return;
     }
+    DebugLogEntryData *buffer = &buffers[fill_idx];
     memset(buffer->Data, 0xff, sizeof(buffer->Data));
     vsnprintf((char *)buffer->Data, sizeof(buffer->Data), (char *)format, args);
     buffer->Flight     = flightnum;
@@ -161,11 +257,49 @@ void PIOS_DEBUGLOG_Printf(char *format, ...)
     buffer->ObjectID   = 0;
     buffer->InstanceID = 0;
     buffer->Size       = strlen((const char *)buffer->Data);
+    used_buffer_space  = buffer->Size;
 
-    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
-        lognum++;
+    queue_current_buffer();
+    mutexunlock();
+    va_end(args);
+}
+
+/**
+ * @brief Write a debug log entry with scheduling trace records, written
+ * even when logging is disabled as the dump is requested explicitly
+ * @param[in] records buffer, up to the size of an entry
+ * @param[in] size of the records in bytes
+ * @param[in] ticks_per_us resolution of the record times
+ * @return true if the entry was queued, false if no buffer was available
+ */
+bool PIOS_DEBUGLOG_Trace(const void *records, size_t size, uint32_t ticks_per_us)
+{
+    if (!buffers || log_is_full) {
+        return false;
     }
+
+    mutexlock();
+    queue_current_buffer();
+    if (!get_free_buffer()) {
+        mutexunlock();
+        return false;
+    }
+    DebugLogEntryData *buffer = &buffers[fill_idx];
+    size = MIN(size, LOG_ENTRY_MAX_DATA_SIZE);
+    memset(buffer->Data, 0xff, sizeof(buffer->Data));
+    memcpy(buffer->Data, records, size);
+    buffer->Flight     = flightnum;
+    buffer->FlightTime = PIOS_DELAY_GetuS();
+    buffer->Entry      = lognum;
+    buffer->Type       = DEBUGLOGENTRY_TYPE_TRACE;
+    buffer->ObjectID   = ticks_per_us;
+    buffer->InstanceID = 0;
+    buffer->Size       = size;
+    used_buffer_space  = size;
+
+    queue_current_buffer();
     mutexunlock();
+    return true;
 }
 
 
@@ -184,7 +318,10 @@ void PIOS_DEBUGLOG_Printf(char *format, ...)
 int32_t PIOS_DEBUGLOG_Read(void *mybuffer, uint16_t flight, uint16_t inst)
 {
     PIOS_Assert(mybuffer);
-    return PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flight), inst, (uint8_t *)mybuffer, sizeof(DebugLogEntryData));
+    fslock();
+    int32_t ret = PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flight), inst, (uint8_t *)mybuffer, sizeof(DebugLogEntryData));
+    fsunlock();
+    return ret;
 }
 
 /**
@@ -203,7 +340,9 @@ void PIOS_DEBUGLOG_Info(uint16_t *flight, uint16_t *entry, uint16_t *free, uint1
         *entry = lognum;
     }
     struct PIOS_FLASHFS_Stats stats = { 0, 0 };
+    fslock();
     PIOS_FLASHFS_GetStats(pios_user_fs_id, &stats);
+    fsunlock();
     if (free) {
         *free = stats.num_free_slots;
     }
@@ -212,44 +351,60 @@ void PIOS_DEBUGLOG_Info(uint16_t *flight, uint16_t *entry, uint16_t *free, uint1
     }
 }
 
+/**
+ * @brief Retrieve the number of log entries dropped because no buffer was available
+ * @return dropped entries since system start
+ */
+uint32_t PIOS_DEBUGLOG_DroppedEntries(void)
+{
+    return dropped_entries;
+}
+
 /**
  * @brief Format entire flash memory!!!
  */
 void PIOS_DEBUGLOG_Format(void)
 {
+    fslock();
     mutexlock();
     PIOS_FLASHFS_Format(pios_user_fs_id);
-    lognum      = 0;
-    flightnum   = 0;
-    log_is_full = false;
-    fails_count = 0;
-    used_buffer_space = 0;
+    lognum       = 0;
+    flightnum    = 0;
+    write_flight = 0;
+    log_is_full  = false;
+    fails_count  = 0;
+    reset_buffers();
+    reset_dictionary();
     mutexunlock();
+    fsunlock();
 }
 
 void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
 {
     DebugLogEntryData *entry;
 
+    if (size > LOG_ENTRY_MAX_DATA_SIZE) {
+        size = LOG_ENTRY_MAX_DATA_SIZE;
+    }
+
+    // if an instance is being filled and there is not enough space, queue it and start a new one
+    if (used_buffer_space && (buffers[fill_idx].Type == DEBUGLOGENTRY_TYPE_COMPRESSEDUAVOBJECTS ||
+                              used_buffer_space + size + LOG_ENTRY_HEADER_SIZE > LOG_ENTRY_MAX_DATA_SIZE)) {
+        queue_current_buffer();
+    }
+
     // start a new block
     if (!used_buffer_space) {
-        entry = buffer;
-        memset(buffer->Data, 0xff, sizeof(buffer->Data));
+        if (!get_free_buffer()) {
+            dropped_entries++;
+            return;
+        }
+        entry = &buffers[fill_idx];
+        memset(entry->Data, 0xff, sizeof(entry->Data));
         used_buffer_space += size;
     } else {
-        // if an instance is being filled and there is enough space, does enqueues new data.
-        if (used_buffer_space + size + LOG_ENTRY_HEADER_SIZE > LOG_ENTRY_MAX_DATA_SIZE) {
-            buffer->Type = DEBUGLOGENTRY_TYPE_MULTIPLEUAVOBJECTS;
-            if (!write_current_buffer()) {
-                return;
-            }
-            entry = buffer;
-            memset(buffer->Data, 0xff, sizeof(buffer->Data));
-            used_buffer_space += size;
-        } else {
-            entry = (DebugLogEntryData *)&buffer->Data[used_buffer_space];
-            used_buffer_space += size + LOG_ENTRY_HEADER_SIZE;
-        }
+        entry = (DebugLogEntryData *)&buffers[fill_idx].Data[used_buffer_space];
+        used_buffer_space += size + LOG_ENTRY_HEADER_SIZE;
     }
 
     entry->Flight     = flightnum;
@@ -258,29 +413,269 @@ void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
     entry->Type = DEBUGLOGENTRY_TYPE_UAVOBJECT;
     entry->ObjectID   = objid;
     entry->InstanceID = instid;
-    if (size > sizeof(buffer->Data)) {
-        size = sizeof(buffer->Data);
-    }
     entry->Size = size;
 
     memcpy(entry->Data, data, size);
 }
 
-bool write_current_buffer()
+/**
+ * Append an object update to the current compressed block.
+ * Must be called with the mutex held.
+ * \return false if the object can not be compressed and has to be logged uncompressed
+ */
+bool enqueue_compressed(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
 {
-    // not enough space, write the block and start a new one
-    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
-        lognum++;
-        fails_count = 0;
-        used_buffer_space = 0;
+    if (!dict || !dict_samples) {
+        return false;
+    }
+
+    uint8_t index;
+    for (index = 0; index < dict_count; index++) {
+        if (dict[index].objid == objid && dict[index].instid == instid) {
+            break;
+        }
+    }
+
+    struct log_dict_entry def   = { .objid = objid, .instid = instid, .size = size, .offset = dict_samples_used };
+    const struct log_dict_entry *newdef = 0;
+    const uint8_t *previous     = 0;
+    if (index < dict_count) {
+        // the same object is always logged with the same size
+        if (dict[index].size != size) {
+            return false;
+        }
+        previous = &dict_samples[dict[index].offset];
     } else {
-        if (fails_count++ > MAX_CONSECUTIVE_FAILS_COUNT) {
-            log_is_full = true;
+        if (dict_count >= LOG_DICT_SIZE || dict_samples_used + size > LOG_DICT_SAMPLES_SIZE) {
+            return false;
         }
+        newdef = &def;
+    }
+
+    uint32_t now = PIOS_DELAY_GetuS();
+    DebugLogEntryData *block = &buffers[fill_idx];
+    bool in_block = used_buffer_space && block->Type == DEBUGLOGENTRY_TYPE_COMPRESSEDUAVOBJECTS;
+    if (used_buffer_space && !in_block) {
+        queue_current_buffer();
+    }
+
+    uint32_t len = encode_record(index, newdef, in_block ? now - block_time : 0, size, data, previous);
+    if (!len) {
         return false;
     }
+    if (in_block && used_buffer_space + len > LOG_ENTRY_MAX_DATA_SIZE) {
+        queue_current_buffer();
+        in_block = false;
+        len = encode_record(index, newdef, 0, size, data, previous);
+    }
+
+    if (!in_block) {
+        if (!get_free_buffer()) {
+            // the dictionary is left untouched so the decoder stays in sync
+            dropped_entries++;
+            return true;
+        }
+        block = &buffers[fill_idx];
+        memset(block->Data, 0xff, sizeof(block->Data));
+        block->Flight     = flightnum;
+        block->FlightTime = now;
+        block->Entry      = lognum;
+        block->Type       = DEBUGLOGENTRY_TYPE_COMPRESSEDUAVOBJECTS;
+        block->ObjectID   = 0;
+        block->InstanceID = 0;
+    }
+
+    memcpy(&block->Data[used_buffer_space], record, len);
+    used_buffer_space += len;
+    block->Size = used_buffer_space;
+    block_time  = now;
+
+    if (newdef) {
+        dict[dict_count++] = def;
+        dict_samples_used += size;
+    }
+    memcpy(&dict_samples[dict[index].offset], data, size);
     return true;
 }
+
+/**
+ * Encode one record of a compressed block into record[]
+ * \return the record length, 0 if it does not fit in a log entry
+ */
+uint32_t encode_record(uint8_t index, const struct log_dict_entry *def, uint32_t delta, size_t size, const uint8_t *data, const uint8_t *previous)
+{
+    // worst case: index, definition, delta, one mask per 8 bytes and the payload
+    if (1 + 4 + 3 + 3 + 5 + (size + 7) / 8 + size > sizeof(record)) {
+        return 0;
+    }
+
+    uint32_t len = 0;
+    if (def) {
+        record[len++] = LOG_DICT_DEFINE;
+        record[len++] = def->objid & 0xff;
+        record[len++] = (def->objid >> 8) & 0xff;
+        record[len++] = (def->objid >> 16) & 0xff;
+        record[len++] = (def->objid >> 24) & 0xff;
+        for (uint32_t v = def->instid; ; v >>= 7) {
+            record[len++] = (v & 0x7f) | (v > 0x7f ? 0x80 : 0);
+            if (v <= 0x7f) {
+                break;
+            }
+        }
+        for (uint32_t v = def->size; ; v >>= 7) {
+            record[len++] = (v & 0x7f) | (v > 0x7f ? 0x80 : 0);
+            if (v <= 0x7f) {
+                break;
+            }
+        }
+    } else {
+        record[len++] = index;
+    }
+    for (uint32_t v = delta; ; v >>= 7) {
+        record[len++] = (v & 0x7f) | (v > 0x7f ? 0x80 : 0);
+        if (v <= 0x7f) {
+            break;
+        }
+    }
+    for (size_t group = 0; group < size; group += 8) {
+        uint32_t mask = len++;
+        record[mask] = 0;
+        for (size_t t = group; t < group + 8 && t < size; t++) {
+            uint8_t value = previous ? data[t] ^ previous[t] : data[t];
+            if (value) {
+                record[mask]  |= 1 << (t - group);
+                record[len++]  = value;
+            }
+        }
+    }
+    return len;
+}
+
+/**
+ * Forget all objects seen so far, called whenever a new flight starts.
+ * Must be called with the mutex held.
+ */
+void reset_dictionary()
+{
+    dict_count = 0;
+    dict_samples_used = 0;
+    block_time = 0;
+}
+
+/**
+ * Check whether the fill buffer is available to producers, retrying
+ * a stalled write first. Must be called with the mutex held.
+ * \return true if buffers[fill_idx] can be filled
+ */
+bool get_free_buffer()
+{
+    if (buffer_ready[fill_idx]) {
+        kick_writer();
+    }
+    return !buffer_ready[fill_idx];
+}
+
+/**
+ * Hand the buffer being filled over to the writer and move on to the next
+ * one. Must be called with the mutex held.
+ */
+void queue_current_buffer()
+{
+    if (!used_buffer_space) {
+        return;
+    }
+    DebugLogEntryData *buffer = &buffers[fill_idx];
+    if (buffer->Type == DEBUGLOGENTRY_TYPE_UAVOBJECT && used_buffer_space > buffer->Size) {
+        buffer->Type = DEBUGLOGENTRY_TYPE_MULTIPLEUAVOBJECTS;
+    }
+    buffer_used[fill_idx]  = used_buffer_space;
+    buffer_ready[fill_idx] = true;
+    used_buffer_space = 0;
+    fill_idx = (fill_idx + 1) % LOG_BUFFER_COUNT;
+    kick_writer();
+}
+
+void kick_writer()
+{
+#if defined(PIOS_DEBUGLOG_ASYNC)
+    PIOS_CALLBACKSCHEDULER_Dispatch(writerCallback);
+#else
+    write_pending_buffers();
+#endif
+}
+
+/**
+ * Write all queued buffers to flash, oldest first.
+ * Entry numbers are assigned here so that they stay contiguous in flash.
+ */
+void write_pending_buffers()
+{
+    fslock();
+    while (buffer_ready[write_idx] && !log_is_full) {
+        DebugLogEntryData *buffer = &buffers[write_idx];
+
+        mutexlock();
+        if (buffer->Flight != write_flight) {
+            write_flight = buffer->Flight;
+            lognum = 0;
+        }
+        mutexunlock();
+        // the buffer is owned by the writer until buffer_ready is cleared, no need to hold the mutex while touching it
+        buffer->Entry = lognum;
+        if (buffer->Type == DEBUGLOGENTRY_TYPE_MULTIPLEUAVOBJECTS) {
+            uint32_t start = buffer->Size;
+            while (start + LOG_ENTRY_HEADER_SIZE <= buffer_used[write_idx]) {
+                DebugLogEntryData *entry = (DebugLogEntryData *)&buffer->Data[start];
+                entry->Entry = lognum;
+                start += LOG_ENTRY_HEADER_SIZE + entry->Size;
+            }
+        }
+
+        bool written = PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(write_flight), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0;
+
+        mutexlock();
+        if (written) {
+            lognum++;
+            fails_count = 0;
+            buffer_ready[write_idx] = false;
+            write_idx = (write_idx + 1) % LOG_BUFFER_COUNT;
+        } else if (fails_count++ > MAX_CONSECUTIVE_FAILS_COUNT) {
+            log_is_full = true;
+        }
+        mutexunlock();
+        if (!written) {
+#if defined(PIOS_DEBUGLOG_ASYNC)
+            if (!log_is_full) {
+                PIOS_CALLBACKSCHEDULER_Schedule(writerCallback, LOG_WRITER_RETRY_MS, CALLBACK_UPDATEMODE_SOONER);
+            }
+#endif
+            break;
+        }
+    }
+    fsunlock();
+}
+
+/**
+ * Discard all pending buffers. Must be called with the flash and buffer mutex held.
+ */
+void reset_buffers()
+{
+    for (uint8_t t = 0; t < LOG_BUFFER_COUNT; t++) {
+        buffer_ready[t] = false;
+        buffer_used[t]  = 0;
+    }
+    fill_idx  = 0;
+    write_idx = 0;
+    used_buffer_space = 0;
+}
+
+#if defined(PIOS_DEBUGLOG_ASYNC)
+static void writerTask()
+{
+    write_pending_buffers();
+}
+#endif
+
 /**
  * @}
  * @}
@@ -253,6 +253,36 @@ int32_t PIOS_FLASHFS_GetStats(__attribute__((unused)) uintptr_t fs_id, __attribu
     return 0;
 }
 
+/**
+ * @brief Runs one step of the incremental garbage collection
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0, files on the sd card never need garbage collection
+ */
+int32_t PIOS_FLASHFS_GarbageCollectStep(__attribute__((unused)) uintptr_t fs_id)
+{
+    return 0;
+}
+
+/**
+ * @brief Starts a transaction
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0, every object is its own file and saves take effect immediately
+ */
+int32_t PIOS_FLASHFS_BeginTransaction(__attribute__((unused)) uintptr_t fs_id)
+{
+    return 0;
+}
+
+/**
+ * @brief Commits a transaction
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0, nothing is held back by a transaction
+ */
+int32_t PIOS_FLASHFS_CommitTransaction(__attribute__((unused)) uintptr_t fs_id)
+{
+    return 0;
+}
+
 #endif /* PIOS_USE_SETTINGS_ON_SDCARD */
 
 /**
@@ -54,11 +54,36 @@
 #define JEDEC_STATUS_SEC          0x40
 #define JEDEC_STATUS_SRP0         0x80
 
+#define JEDEC_PAGE_SIZE           0x100
+// Read command, address and up to 4 fast read dummy bytes
+#define JEDEC_READ_CMD_MAX_LEN    8
+
+/*
+ * The small reads (slot headers) read ahead the following bytes of their page
+ * in a cache, the data of the slot is then read from it.
+ * The boards short of RAM can define PIOS_FLASH_JEDEC_CACHE_SIZE to 0.
+ */
+#ifndef PIOS_FLASH_JEDEC_CACHE_SIZE
+#define PIOS_FLASH_JEDEC_CACHE_SIZE 128
+#endif
+#define JEDEC_READ_AHEAD_MAX_LEN  32
+
+// Ranges read in one go by PIOS_Flash_Jedec_ReadRanges
+#define JEDEC_RANGE_BATCH         4
+
 enum pios_jedec_dev_magic {
     PIOS_JEDEC_DEV_MAGIC = 0xcb55aa55,
 };
 
 // ! Device handle structure
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+struct jedec_range_read {
+    struct pios_spi_transaction transaction;
+    struct pios_spi_segment     segments[2];
+    uint8_t cmd[JEDEC_READ_CMD_MAX_LEN];
+};
+#endif
+
 struct jedec_flash_dev {
     uint32_t spi_id;
     uint32_t slave_num;
@@ -71,6 +96,14 @@ struct jedec_flash_dev {
     const struct pios_flash_jedec_cfg *cfg;
 #if defined(FLASH_FREERTOS)
     xSemaphoreHandle transaction_lock;
+#endif
+#if PIOS_FLASH_JEDEC_CACHE_SIZE > 0
+    uint32_t cache_addr;
+    uint16_t cache_len; /* 0 when the cache is invalid */
+    uint8_t  cache[PIOS_FLASH_JEDEC_CACHE_SIZE];
+#endif
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    struct jedec_range_read ranges[JEDEC_RANGE_BATCH];
 #endif
     enum pios_jedec_dev_magic magic;
 };
@@ -88,6 +121,7 @@ static int32_t PIOS_Flash_Jedec_ClaimBus(struct jedec_flash_dev *flash_dev, bool
 static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_WriteEnable(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev);
+static void PIOS_Flash_Jedec_InvalidateCache(struct jedec_flash_dev *flash_dev);
 
 /**
  * @brief Allocate a new device
@@ -103,6 +137,12 @@ static struct jedec_flash_dev *PIOS_Flash_Jedec_alloc(void)
 
     flash_dev->claimed = false;
     flash_dev->magic   = PIOS_JEDEC_DEV_MAGIC;
+#if PIOS_FLASH_JEDEC_CACHE_SIZE > 0
+    flash_dev->cache_len = 0;
+#endif
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    memset(flash_dev->ranges, 0, sizeof(flash_dev->ranges));
+#endif
 #if defined(FLASH_FREERTOS)
     flash_dev->transaction_lock = xSemaphoreCreateMutex();
 #endif
@@ -192,6 +232,26 @@ static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev)
     return 0;
 }
 
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+/**
+ * @brief Runs the segments as one low priority SPI transaction, with CS asserted
+ * from the first to the last one. The bus is not held between the flash
+ * transactions, so the sensor transactions queued meanwhile run first.
+ * @return 0 for success, -1 for failure
+ */
+static int32_t PIOS_Flash_Jedec_Transfer(struct jedec_flash_dev *flash_dev, bool fast, const struct pios_spi_segment *segments, uint8_t count)
+{
+    struct pios_spi_transaction transaction = {
+        .slave_id      = flash_dev->slave_num,
+        .prescaler     = fast ? FLASH_FAST_PRESCALER : FLASH_PRESCALER,
+        .segments      = segments,
+        .segment_count = count,
+    };
+
+    return (PIOS_SPI_Transaction(flash_dev->spi_id, &transaction, PIOS_SPI_PRIORITY_LOW) < 0) ? -1 : 0;
+}
+#endif /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
+
 /**
  * @brief Returns if the flash chip is busy
  * @returns -1 for failure, 0 for not busy, 1 for busy
@@ -353,6 +413,7 @@ static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t flash_id, uint32_t addr)
     uint8_t ret;
     uint8_t out[] = { flash_dev->cfg->sector_erase, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
 
+    PIOS_Flash_Jedec_InvalidateCache(flash_dev);
     if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
         return ret;
     }
@@ -393,6 +454,7 @@ static int32_t PIOS_Flash_Jedec_EraseChip(uintptr_t flash_id)
     uint8_t ret;
     uint8_t out[] = { flash_dev->cfg->chip_erase };
 
+    PIOS_Flash_Jedec_InvalidateCache(flash_dev);
     if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
         return ret;
     }
@@ -458,10 +520,21 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t flash_id, uint32_t addr, uin
     if (((addr & 0xff) + len) > 0x100) {
         return -3;
     }
+    PIOS_Flash_Jedec_InvalidateCache(flash_dev);
     if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
         return ret;
     }
 
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    /* Write page command and address followed by the data */
+    const struct pios_spi_segment segments[] = {
+        { .send_buffer = out,  .len = sizeof(out) },
+        { .send_buffer = data, .len = len         },
+    };
+    if (PIOS_Flash_Jedec_Transfer(flash_dev, true, segments, len ? 2 : 1) != 0) {
+        return -1;
+    }
+#else
     /* Execute write page command and clock in address.  Keep CS asserted */
     if (PIOS_Flash_Jedec_ClaimBus(flash_dev, true) != 0) {
         return -1;
@@ -478,6 +551,7 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t flash_id, uint32_t addr, uin
     }
 
     PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+#endif /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
 
     // Keep polling when bus is busy too
 #if defined(FLASH_FREERTOS)
@@ -537,10 +611,25 @@ static int32_t PIOS_Flash_Jedec_WriteChunks(uintptr_t flash_id, uint32_t addr, s
     if (((addr & 0xff) + len) > 0x100) {
         return -3;
     }
+    PIOS_Flash_Jedec_InvalidateCache(flash_dev);
     if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
         return ret;
     }
 
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    /* Write page command and address followed by the chunks, the empty ones are skipped */
+    struct pios_spi_segment segments[1 + num];
+    uint8_t count = 0;
+    segments[count++] = (struct pios_spi_segment) { .send_buffer = out, .len = sizeof(out) };
+    for (uint32_t i = 0; i < num && count < UINT8_MAX; i++) {
+        if (chunks[i].len) {
+            segments[count++] = (struct pios_spi_segment) { .send_buffer = chunks[i].addr, .len = chunks[i].len };
+        }
+    }
+    if (PIOS_Flash_Jedec_Transfer(flash_dev, true, segments, count) != 0) {
+        return -1;
+    }
+#else
     /* Execute write page command and clock in address.  Keep CS asserted */
     if (PIOS_Flash_Jedec_ClaimBus(flash_dev, true) != 0) {
         return -1;
@@ -561,12 +650,86 @@ static int32_t PIOS_Flash_Jedec_WriteChunks(uintptr_t flash_id, uint32_t addr, s
         }
     }
     PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+#endif /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
 
     // Skip checking for busy with this to get OS running again fast
 
     return 0;
 }
 
+/**
+ * @brief Fills the read command, address and fast read dummy bytes
+ * @return the length of the command
+ */
+static uint8_t PIOS_Flash_Jedec_ReadCommand(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *out)
+{
+    bool fast_read = flash_dev->cfg->fast_read != 0;
+    uint8_t cmdlen = fast_read ? flash_dev->cfg->fast_read_dummy_bytes + 4 : 4;
+
+    memset(out, 0x0, cmdlen);
+    out[0] = fast_read ? flash_dev->cfg->fast_read : JEDEC_READ_DATA;
+    out[1] = (addr >> 16) & 0xff;
+    out[2] = (addr >> 8) & 0xff;
+    out[3] = addr & 0xff;
+    return cmdlen;
+}
+
+/**
+ * @brief Read data from the flash chip, without the cache
+ * @return Zero if success or error code
+ * @retval -1 Unable to claim SPI bus
+ */
+static int32_t PIOS_Flash_Jedec_ReadRaw(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    bool fast_read = flash_dev->cfg->fast_read != 0;
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    /* Read command and address, with the dummy bytes of the fast read, followed by the data */
+    uint8_t out[JEDEC_READ_CMD_MAX_LEN];
+    uint8_t cmdlen = PIOS_Flash_Jedec_ReadCommand(flash_dev, addr, out);
+    const struct pios_spi_segment segments[] = {
+        { .send_buffer    = out,  .len = cmdlen },
+        { .receive_buffer = data, .len = len    },
+    };
+    if (PIOS_Flash_Jedec_Transfer(flash_dev, fast_read, segments, len ? 2 : 1) != 0) {
+        return -3;
+    }
+    return 0;
+
+#else /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
+    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, fast_read) == -1) {
+        return -1;
+    }
+    /* Execute read command and clock in address.  Keep CS asserted */
+    uint8_t out[JEDEC_READ_CMD_MAX_LEN];
+    uint8_t cmdlen = PIOS_Flash_Jedec_ReadCommand(flash_dev, addr, out);
+    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, cmdlen, NULL) < 0) {
+        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+        return -2;
+    }
+
+    /* Copy the transfer data to the buffer */
+    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, NULL, data, len, NULL) < 0) {
+        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+        return -3;
+    }
+
+    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+
+    return 0;
+
+#endif /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
+}
+
+/**
+ * @brief Drops the read ahead data, before the flash content changes
+ */
+static void PIOS_Flash_Jedec_InvalidateCache(__attribute__((unused)) struct jedec_flash_dev *flash_dev)
+{
+#if PIOS_FLASH_JEDEC_CACHE_SIZE > 0
+    flash_dev->cache_len = 0;
+#endif
+}
+
 /**
  * @brief Read data from a location in flash memory
  * @param[in] addr Address in flash to write to
@@ -582,40 +745,131 @@ static int32_t PIOS_Flash_Jedec_ReadData(uintptr_t flash_id, uint32_t addr, uint
     if (PIOS_Flash_Jedec_Validate(flash_dev) != 0) {
         return -1;
     }
+
+#if PIOS_FLASH_JEDEC_CACHE_SIZE > 0
+    /* The cache is only used under the transaction lock, as all the other flash_dev state */
+    if (flash_dev->cache_len && addr >= flash_dev->cache_addr &&
+        addr + len <= flash_dev->cache_addr + flash_dev->cache_len) {
+        memcpy(data, &flash_dev->cache[addr - flash_dev->cache_addr], len);
+        return 0;
+    }
+
+    if (len && len <= JEDEC_READ_AHEAD_MAX_LEN) {
+        /* Small read, also read the rest of its page for the next reads */
+        uint16_t ahead = JEDEC_PAGE_SIZE - (addr & (JEDEC_PAGE_SIZE - 1));
+        if (ahead > PIOS_FLASH_JEDEC_CACHE_SIZE) {
+            ahead = PIOS_FLASH_JEDEC_CACHE_SIZE;
+        }
+        if (ahead > len) {
+            flash_dev->cache_len = 0;
+            int32_t ret = PIOS_Flash_Jedec_ReadRaw(flash_dev, addr, flash_dev->cache, ahead);
+            if (ret != 0) {
+                return ret;
+            }
+            flash_dev->cache_addr = addr;
+            flash_dev->cache_len  = ahead;
+            memcpy(data, flash_dev->cache, len);
+            return 0;
+        }
+    }
+#endif /* PIOS_FLASH_JEDEC_CACHE_SIZE > 0 */
+
+    return PIOS_Flash_Jedec_ReadRaw(flash_dev, addr, data, len);
+}
+
+/**
+ * @brief Read several locations of the flash memory, the empty ranges are skipped
+ * @param[in] ranges Address, buffer and length of each read
+ * @param[in] num_ranges Number of ranges
+ * @return Zero if success or error code of the first failed read
+ */
+static int32_t PIOS_Flash_Jedec_ReadRanges(uintptr_t flash_id, const struct pios_flash_range ranges[], uint32_t num_ranges)
+{
+    struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)flash_id;
+
+    if (PIOS_Flash_Jedec_Validate(flash_dev) != 0) {
+        return -1;
+    }
     bool fast_read = flash_dev->cfg->fast_read != 0;
+
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    /* Queue the reads by batches, the flash chip is deselected between them by the SPI driver */
+    uint32_t i = 0;
+    while (i < num_ranges) {
+        uint8_t count = 0;
+        for (; i < num_ranges && count < JEDEC_RANGE_BATCH; i++) {
+            if (!ranges[i].len) {
+                continue;
+            }
+            struct jedec_range_read *read = &flash_dev->ranges[count++];
+            uint8_t cmdlen = PIOS_Flash_Jedec_ReadCommand(flash_dev, ranges[i].addr, read->cmd);
+            read->segments[0] = (struct pios_spi_segment) { .send_buffer = read->cmd, .len = cmdlen };
+            read->segments[1] = (struct pios_spi_segment) { .receive_buffer = ranges[i].data, .len = ranges[i].len };
+            read->transaction = (struct pios_spi_transaction) {
+                .slave_id      = flash_dev->slave_num,
+                .prescaler     = fast_read ? FLASH_FAST_PRESCALER : FLASH_PRESCALER,
+                .segments      = read->segments,
+                .segment_count = 2,
+            };
+        }
+        if (!count) {
+            break;
+        }
+
+        int32_t ret = 0;
+        for (uint8_t n = 0; n + 1 < count; n++) {
+            bool woken = false;
+            if (PIOS_SPI_Submit(flash_dev->spi_id, &flash_dev->ranges[n].transaction, PIOS_SPI_PRIORITY_LOW, &woken) != 0) {
+                ret = -3;
+                count = n;
+                break;
+            }
+        }
+        /* The queue is ordered, the last read ends after the others */
+        if (!ret && PIOS_SPI_Transaction(flash_dev->spi_id, &flash_dev->ranges[count - 1].transaction, PIOS_SPI_PRIORITY_LOW) < 0) {
+            ret = -3;
+        }
+        for (uint8_t n = 0; n < count; n++) {
+            while (flash_dev->ranges[n].transaction.pending) {
+                vTaskDelay(0);
+            }
+            if (flash_dev->ranges[n].transaction.status < 0) {
+                ret = -3;
+            }
+        }
+        if (ret) {
+            return ret;
+        }
+    }
+    return 0;
+
+#else /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
+    /* Claim the bus once, the chip select is toggled between the reads */
     if (PIOS_Flash_Jedec_ClaimBus(flash_dev, fast_read) == -1) {
         return -1;
     }
-    /* Execute read command and clock in address.  Keep CS asserted */
-    if (!fast_read) {
-        uint8_t out[] = { JEDEC_READ_DATA, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
-        if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, sizeof(out), NULL) < 0) {
-            PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-            return -2;
+
+    int32_t ret = 0;
+    for (uint32_t i = 0; i < num_ranges && !ret; i++) {
+        if (!ranges[i].len) {
+            continue;
         }
-    } else {
-        uint8_t cmdlen = flash_dev->cfg->fast_read_dummy_bytes + 4;
-        uint8_t out[cmdlen];
-        memset(out, 0x0, cmdlen);
-        out[0] = flash_dev->cfg->fast_read;
-        out[1] = (addr >> 16) & 0xff;
-        out[2] = (addr >> 8) & 0xff;
-        out[3] = addr & 0xff;
+        uint8_t out[JEDEC_READ_CMD_MAX_LEN];
+        uint8_t cmdlen = PIOS_Flash_Jedec_ReadCommand(flash_dev, ranges[i].addr, out);
+        PIOS_SPI_RC_PinSet(flash_dev->spi_id, flash_dev->slave_num, 0);
         if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, cmdlen, NULL) < 0) {
-            PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-            return -2;
+            ret = -2;
+        } else if (PIOS_SPI_TransferBlock(flash_dev->spi_id, NULL, ranges[i].data, ranges[i].len, NULL) < 0) {
+            ret = -3;
         }
-    }
-
-    /* Copy the transfer data to the buffer */
-    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, NULL, data, len, NULL) < 0) {
-        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-        return -3;
+        PIOS_SPI_RC_PinSet(flash_dev->spi_id, flash_dev->slave_num, 1);
     }
 
     PIOS_Flash_Jedec_ReleaseBus(flash_dev);
 
-    return 0;
+    return ret;
+
+#endif /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
 }
 
 /* Provide a flash driver to external drivers */
@@ -627,6 +881,7 @@ const struct pios_flash_driver pios_jedec_flash_driver = {
     .write_chunks = PIOS_Flash_Jedec_WriteChunks,
     .write_data   = PIOS_Flash_Jedec_WriteData,
     .read_data    = PIOS_Flash_Jedec_ReadData,
+    .read_ranges  = PIOS_Flash_Jedec_ReadRanges,
 };
 
 #endif /* PIOS_INCLUDE_FLASH */
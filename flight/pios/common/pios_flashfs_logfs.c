@@ -30,6 +30,7 @@
 #ifdef PIOS_INCLUDE_FLASH
 
 #include <stdbool.h>
+#include <string.h>
 #include <openpilot.h>
 #include <pios_math.h>
 #include <pios_wdg.h>
@@ -39,6 +40,48 @@
  * Filesystem state data tracked in RAM
  */
 
+#ifndef PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP
+#define PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP 8 /* slots migrated by one incremental garbage collection step */
+#endif
+
+#ifndef PIOS_FLASHFS_LOGFS_INDEX_MAX_ENTRIES
+#define PIOS_FLASHFS_LOGFS_INDEX_MAX_ENTRIES 1024 /* 4 bytes per entry, power of two up to 32768 */
+#endif
+
+#ifndef PIOS_FLASHFS_LOGFS_BATCH_MAX_ENTRIES
+#define PIOS_FLASHFS_LOGFS_BATCH_MAX_ENTRIES 16 /* saves held back by a transaction before it is committed early */
+#endif
+
+#define LOGFS_MOUNT_BATCH 8 /* slot headers read at once while mounting an arena */
+
+/*
+ * Open addressing hash table mapping (obj_id, obj_inst_id) to the active slot holding it.
+ * The tag is taken from the upper hash bits, matches are always confirmed against the slot header.
+ */
+#define LOGFS_INDEX_SLOT_UNUSED  0x0000 /* slot 0 holds the arena header and is never indexed */
+#define LOGFS_INDEX_SLOT_DELETED 0xFFFF
+
+struct logfs_index_entry {
+    uint16_t slot_id;
+    uint16_t tag;
+};
+
+/*
+ * An object written to a reserved slot inside a transaction, activated on commit
+ */
+struct logfs_batch_entry {
+    uint32_t obj_id;
+    uint16_t obj_inst_id;
+    uint16_t obj_size;
+    uint16_t slot_id;
+};
+
+enum logfs_gc_state {
+    LOGFS_GC_IDLE = 0,
+    LOGFS_GC_ERASING, /* erasing the destination arena one sector per step */
+    LOGFS_GC_COPYING, /* copying active slots from the mounted arena to the destination arena */
+};
+
 enum pios_flashfs_logfs_dev_magic {
     PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
@@ -56,6 +99,24 @@ struct logfs_state {
     uint16_t num_free_slots; /* slots in free state */
     uint16_t num_active_slots; /* slots in active state */
 
+    /* slot index, NULL if not available */
+    struct logfs_index_entry *index;
+    uint16_t index_size; /* number of entries, power of two */
+    uint16_t index_used; /* entries not in unused state, including deleted ones */
+    bool     index_complete; /* all active slots are indexed, an index miss is authoritative */
+
+    /* incremental garbage collection, the mounted arena stays authoritative until it completes */
+    enum logfs_gc_state gc_state;
+    uint8_t  gc_arena_id; /* destination arena */
+    uint16_t gc_next; /* next sector to erase or next source slot to copy */
+    uint16_t gc_dst_slot_id; /* next free slot in the destination arena */
+    uint32_t gc_time; /* us spent in the running, or else the last, garbage collection */
+
+    /* saves deferred by PIOS_FLASHFS_BeginTransaction, old versions stay active until commit */
+    uint8_t  batch_depth; /* nesting level of open transactions */
+    uint8_t  batch_count;
+    struct logfs_batch_entry batch[PIOS_FLASHFS_LOGFS_BATCH_MAX_ENTRIES];
+
     /* Underlying flash driver glue */
     const struct pios_flash_driver *driver;
     uintptr_t flash_id;
@@ -111,23 +172,26 @@ struct arena_header {
 ****************************************/
 
 /**
- * @brief Erases all sectors within the given arena and sets arena to erased state.
+ * @brief Erases one sector within the given arena.
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_id)
+static int32_t logfs_erase_arena_sector(const struct logfs_state *logfs, uint8_t arena_id, uint16_t sector_id)
 {
     uintptr_t arena_addr = logfs_get_addr(logfs, arena_id, 0);
 
-    /* Erase all of the sectors in the arena */
-    for (uint8_t sector_id = 0;
-         sector_id < (logfs->cfg->arena_size / logfs->cfg->sector_size);
-         sector_id++) {
-        if (logfs->driver->erase_sector(logfs->flash_id,
-                                        arena_addr + (sector_id * logfs->cfg->sector_size))) {
-            return -1;
-        }
-    }
+    return logfs->driver->erase_sector(logfs->flash_id,
+                                       arena_addr + (sector_id * logfs->cfg->sector_size)) ? -1 : 0;
+}
+
+/**
+ * @brief Sets an arena whose sectors have all been erased to erased state.
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_mark_arena_erased(const struct logfs_state *logfs, uint8_t arena_id)
+{
+    uintptr_t arena_addr = logfs_get_addr(logfs, arena_id, 0);
 
     /* Mark this arena as fully erased */
     struct arena_header arena_hdr = {
@@ -146,6 +210,25 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
     return 0;
 }
 
+/**
+ * @brief Erases all sectors within the given arena and sets arena to erased state.
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_id)
+{
+    /* Erase all of the sectors in the arena */
+    for (uint8_t sector_id = 0;
+         sector_id < (logfs->cfg->arena_size / logfs->cfg->sector_size);
+         sector_id++) {
+        if (logfs_erase_arena_sector(logfs, arena_id, sector_id) != 0) {
+            return -1;
+        }
+    }
+
+    return logfs_mark_arena_erased(logfs, arena_id) != 0 ? -2 : 0;
+}
+
 /**
  * @brief Marks the given arena as reserved so it can be filled.
  * @return 0 if success, < 0 on failure
@@ -416,6 +499,127 @@ static bool logfs_log_is_full(const struct logfs_state *logfs)
     return logfs->num_free_slots == 0;
 }
 
+static uint32_t logfs_index_hash(uint32_t obj_id, uint16_t obj_inst_id)
+{
+    uint32_t hash = obj_id ^ ((uint32_t)obj_inst_id * 0x9E3779B1);
+
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+static void logfs_index_reset(struct logfs_state *logfs)
+{
+    if (!logfs->index) {
+        logfs->index_complete = false;
+        return;
+    }
+    memset(logfs->index, 0, logfs->index_size * sizeof(*logfs->index));
+    logfs->index_used     = 0;
+    logfs->index_complete = true;
+}
+
+/* NOTE: logfs keeps at most one active slot per object instance, the caller must have deleted any previous one */
+static void logfs_index_insert(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+    if (!logfs->index) {
+        return;
+    }
+
+    uint32_t hash = logfs_index_hash(obj_id, obj_inst_id);
+    uint16_t mask = logfs->index_size - 1;
+    struct logfs_index_entry *target = NULL;
+
+    for (uint16_t probe = 0; probe < logfs->index_size; probe++) {
+        struct logfs_index_entry *entry = &logfs->index[(hash + probe) & mask];
+        if (entry->slot_id == LOGFS_INDEX_SLOT_DELETED) {
+            /* Reuse the deleted entry, keeps the probe chains short when objects are rewritten */
+            target = entry;
+            break;
+        }
+        if (entry->slot_id == LOGFS_INDEX_SLOT_UNUSED) {
+            /* Keep the load factor below 3/4 so that misses terminate quickly */
+            if (logfs->index_used < logfs->index_size - logfs->index_size / 4) {
+                target = entry;
+                logfs->index_used++;
+            }
+            break;
+        }
+    }
+
+    if (!target) {
+        /* Index is full, lookups that miss will have to scan the arena */
+        logfs->index_complete = false;
+        return;
+    }
+    target->slot_id = slot_id;
+    target->tag     = hash >> 16;
+}
+
+static void logfs_index_remove(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+    if (!logfs->index) {
+        return;
+    }
+
+    uint32_t hash = logfs_index_hash(obj_id, obj_inst_id);
+    uint16_t mask = logfs->index_size - 1;
+
+    for (uint16_t probe = 0; probe < logfs->index_size; probe++) {
+        struct logfs_index_entry *entry = &logfs->index[(hash + probe) & mask];
+        if (entry->slot_id == LOGFS_INDEX_SLOT_UNUSED) {
+            break;
+        }
+        if (entry->slot_id == slot_id) {
+            entry->slot_id = LOGFS_INDEX_SLOT_DELETED;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Look up the active slot of an object in the index
+ * @return 0 if found, -1 if not in the index, -2 if reading a slot header failed
+ * @note Must be called while holding the flash transaction lock
+ */
+static int16_t logfs_index_find(const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    if (!logfs->index) {
+        return -1;
+    }
+
+    uint32_t hash = logfs_index_hash(obj_id, obj_inst_id);
+    uint16_t mask = logfs->index_size - 1;
+    uint16_t tag  = hash >> 16;
+
+    for (uint16_t probe = 0; probe < logfs->index_size; probe++) {
+        const struct logfs_index_entry *entry = &logfs->index[(hash + probe) & mask];
+        if (entry->slot_id == LOGFS_INDEX_SLOT_UNUSED) {
+            break;
+        }
+        if (entry->slot_id == LOGFS_INDEX_SLOT_DELETED || entry->tag != tag) {
+            continue;
+        }
+
+        uintptr_t slot_addr = logfs_get_addr(logfs, logfs->active_arena_id, entry->slot_id);
+        if (logfs->driver->read_data(logfs->flash_id,
+                                     slot_addr,
+                                     (uint8_t *)slot_hdr,
+                                     sizeof(*slot_hdr)) != 0) {
+            return -2;
+        }
+        if (slot_hdr->state == SLOT_STATE_ACTIVE &&
+            slot_hdr->obj_id == obj_id &&
+            slot_hdr->obj_inst_id == obj_inst_id) {
+            *slot_id = entry->slot_id;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
 static int32_t logfs_unmount_log(struct logfs_state *logfs)
 {
     PIOS_Assert(logfs->mounted);
@@ -427,6 +631,30 @@ static int32_t logfs_unmount_log(struct logfs_state *logfs)
     return 0;
 }
 
+/* Reads the headers of LOGFS_MOUNT_BATCH slots from first_slot_id, up to the end of the arena */
+static int32_t logfs_read_slot_headers(const struct logfs_state *logfs, uint16_t first_slot_id, uint16_t num_slots, struct slot_header *slot_hdrs)
+{
+    struct pios_flash_range ranges[LOGFS_MOUNT_BATCH];
+    uint8_t count = 0;
+
+    for (uint16_t slot_id = first_slot_id; slot_id < num_slots && count < LOGFS_MOUNT_BATCH; slot_id++) {
+        ranges[count].addr = logfs_get_addr(logfs, logfs->active_arena_id, slot_id);
+        ranges[count].data = (uint8_t *)&slot_hdrs[count];
+        ranges[count].len  = sizeof(slot_hdrs[count]);
+        count++;
+    }
+
+    if (logfs->driver->read_ranges) {
+        return logfs->driver->read_ranges(logfs->flash_id, ranges, count) != 0 ? -1 : 0;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (logfs->driver->read_data(logfs->flash_id, ranges[i].addr, ranges[i].data, ranges[i].len) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 {
     PIOS_Assert(!logfs->mounted);
@@ -434,19 +662,18 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
     logfs->num_active_slots = 0;
     logfs->num_free_slots   = 0;
     logfs->active_arena_id  = arena_id;
-
-    /* Scan the log to find out how full it is */
-    for (uint16_t slot_id = 1;
-         slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-         slot_id++) {
-        struct slot_header slot_hdr;
-        uintptr_t slot_addr = logfs_get_addr(logfs, logfs->active_arena_id, slot_id);
-        if (logfs->driver->read_data(logfs->flash_id,
-                                     slot_addr,
-                                     (uint8_t *)&slot_hdr,
-                                     sizeof(slot_hdr)) != 0) {
+    logfs_index_reset(logfs);
+
+    /* Scan the log to find out how full it is and index the active slots */
+    uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+    struct slot_header slot_hdrs[LOGFS_MOUNT_BATCH];
+    for (uint16_t slot_id = 1; slot_id < num_slots; slot_id++) {
+        /* The headers are read by batches, in one call when the driver reads ranges */
+        uint8_t batch_idx = (slot_id - 1) % LOGFS_MOUNT_BATCH;
+        if (batch_idx == 0 && logfs_read_slot_headers(logfs, slot_id, num_slots, slot_hdrs) != 0) {
             return -1;
         }
+        struct slot_header slot_hdr = slot_hdrs[batch_idx];
 
         /*
          * Empty slots must be in a continguous block at the
@@ -461,6 +688,7 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
             break;
         case SLOT_STATE_ACTIVE:
             logfs->num_active_slots++;
+            logfs_index_insert(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
             break;
         case SLOT_STATE_RESERVED:
         case SLOT_STATE_OBSOLETE:
@@ -497,8 +725,26 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
     /* Invalidate the magic */
     logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+    if (logfs->index) {
+        pios_free(logfs->index);
+        logfs->index = NULL;
+    }
     vPortFree(logfs);
 }
+
+static void PIOS_FLASHFS_Logfs_alloc_index(struct logfs_state *logfs)
+{
+    uint32_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+    uint32_t size = 4;
+
+    /* Twice the number of slots keeps the load factor at 1/2 when every slot is active */
+    while (size < 2 * num_slots && size < PIOS_FLASHFS_LOGFS_INDEX_MAX_ENTRIES) {
+        size <<= 1;
+    }
+
+    logfs->index_size = size;
+    logfs->index = (struct logfs_index_entry *)pios_malloc(size * sizeof(*logfs->index));
+}
 #else
 static struct logfs_state pios_flashfs_logfs_devs[PIOS_FLASHFS_LOGFS_MAX_DEVS];
 static uint8_t pios_flashfs_logfs_num_devs;
@@ -515,6 +761,12 @@ static struct logfs_state *PIOS_FLASHFS_Logfs_alloc(void)
 
     return logfs;
 }
+static void PIOS_FLASHFS_Logfs_alloc_index(struct logfs_state *logfs)
+{
+    /* No index without a heap, every lookup scans the arena */
+    logfs->index = NULL;
+    logfs->index_size = 0;
+}
 static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
     /* Invalidate the magic */
@@ -559,6 +811,11 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
     logfs->driver   = driver; /* lower-level flash driver */
     logfs->flash_id = flash_id; /* lower-level flash device id */
     logfs->mounted  = false;
+    logfs->gc_state    = LOGFS_GC_IDLE;
+    logfs->gc_time     = 0;
+    logfs->batch_depth = 0;
+    logfs->batch_count = 0;
+    PIOS_FLASHFS_Logfs_alloc_index(logfs);
 
     if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
         rc = -1;
@@ -628,79 +885,195 @@ out_exit:
     return rc;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect(struct logfs_state *logfs)
+/*
+ * Is it worth starting an incremental garbage collection?
+ * true = the log is running low on free slots and collecting would free a reasonable amount of them
+ */
+static bool logfs_gc_wanted(const struct logfs_state *logfs)
+{
+    uint16_t num_slots    = (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1;
+    uint16_t num_obsolete = num_slots - logfs->num_free_slots - logfs->num_active_slots;
+
+    return logfs->num_free_slots < num_slots / 8 && num_obsolete >= num_slots / 8;
+}
+
+/**
+ * @brief Run one step of the garbage collection, moving at most max_slots slots to the destination arena
+ * @param[in] start start a new collection even if it is not wanted yet
+ * @return 1 if more steps are needed, 0 if completed or nothing to do, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_step(struct logfs_state *logfs, uint16_t max_slots, bool start)
 {
     PIOS_Assert(logfs->mounted);
 
-    /* Source arena is the active arena */
-    uint8_t src_arena_id = logfs->active_arena_id;
+#ifdef PIOS_INCLUDE_DELAY
+    uint32_t step_start = PIOS_DELAY_GetRaw();
+#endif
+    int32_t rc = 1;
+
+    switch (logfs->gc_state) {
+    case LOGFS_GC_IDLE:
+        if (!start && !logfs_gc_wanted(logfs)) {
+            return 0;
+        }
+        /* Destination arena is the one following the active arena */
+        logfs->gc_arena_id = (logfs->active_arena_id + 1) % (logfs->cfg->total_fs_size / logfs->cfg->arena_size);
+        logfs->gc_next     = 0;
+        logfs->gc_time     = 0;
+        logfs->gc_state    = LOGFS_GC_ERASING;
+    /* fall through */
+    case LOGFS_GC_ERASING:
+        /* Sector erases are slow, only do one per step */
+        if (logfs_erase_arena_sector(logfs, logfs->gc_arena_id, logfs->gc_next) != 0) {
+            rc = -1;
+            break;
+        }
+        if (++logfs->gc_next < logfs->cfg->arena_size / logfs->cfg->sector_size) {
+            break;
+        }
+        if (logfs_mark_arena_erased(logfs, logfs->gc_arena_id) != 0) {
+            rc = -1;
+            break;
+        }
+        /* Reserve the destination arena so we can start filling it */
+        if (logfs_reserve_arena(logfs, logfs->gc_arena_id) != 0) {
+            /* Unable to reserve the arena */
+            rc = -2;
+            break;
+        }
+        logfs->gc_next = 1;
+        logfs->gc_dst_slot_id = 1;
+        logfs->gc_state = LOGFS_GC_COPYING;
+        break;
+    case LOGFS_GC_COPYING:
+    {
+        /* Copy active slots from active arena to destination arena, new objects keep getting appended to the active arena */
+        uint16_t used_slots = (logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+        for (uint16_t count = 0; count < max_slots && logfs->gc_next < used_slots; count++, logfs->gc_next++) {
+            struct slot_header slot_hdr;
+            uintptr_t src_addr = logfs_get_addr(logfs, logfs->active_arena_id, logfs->gc_next);
+            if (logfs->driver->read_data(logfs->flash_id,
+                                         src_addr,
+                                         (uint8_t *)&slot_hdr,
+                                         sizeof(slot_hdr)) != 0) {
+                rc = -3;
+                break;
+            }
 
-    /* Compute destination arena */
-    uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->cfg->total_fs_size / logfs->cfg->arena_size);
+            if (slot_hdr.state == SLOT_STATE_ACTIVE) {
+                uintptr_t dst_addr = logfs_get_addr(logfs, logfs->gc_arena_id, logfs->gc_dst_slot_id);
+                if (logfs_raw_copy_bytes(logfs,
+                                         src_addr,
+                                         sizeof(slot_hdr) + slot_hdr.obj_size,
+                                         dst_addr) != 0) {
+                    /* Failed to copy all bytes */
+                    rc = -4;
+                    break;
+                }
+                logfs->gc_dst_slot_id++;
+            }
+#ifdef PIOS_INCLUDE_WDG
+            PIOS_WDG_Clear();
+#endif
+        }
+        if (rc < 0 || logfs->gc_next < used_slots) {
+            break;
+        }
 
-    /* Erase destination arena */
-    if (logfs_erase_arena(logfs, dst_arena_id) != 0) {
-        return -1;
+        /* Everything has been copied, switch over to the destination arena */
+        uint8_t src_arena_id = logfs->active_arena_id;
+
+        /* Activate the destination arena */
+        if (logfs_activate_arena(logfs, logfs->gc_arena_id) != 0) {
+            rc = -5;
+            break;
+        }
+
+        /* Unmount the source arena */
+        if (logfs_unmount_log(logfs) != 0) {
+            rc = -6;
+            break;
+        }
+
+        /* Obsolete the source arena */
+        if (logfs_obsolete_arena(logfs, src_arena_id) != 0) {
+            rc = -7;
+            break;
+        }
+
+        /* Mount the new arena */
+        if (logfs_mount_log(logfs, logfs->gc_arena_id) != 0) {
+            rc = -8;
+            break;
+        }
+
+        logfs->gc_state = LOGFS_GC_IDLE;
+        rc = 0;
+        break;
+    }
     }
 
-    /* Reserve the destination arena so we can start filling it */
-    if (logfs_reserve_arena(logfs, dst_arena_id) != 0) {
-        /* Unable to reserve the arena */
-        return -2;
+    if (rc < 0 && logfs->mounted) {
+        /* Start over with the next collection, the active arena is unaffected */
+        logfs->gc_state = LOGFS_GC_IDLE;
     }
+#ifdef PIOS_INCLUDE_DELAY
+    logfs->gc_time += PIOS_DELAY_DiffuS(step_start);
+#endif
 
-    /* Copy active slots from active arena to destination arena */
-    uint16_t dst_slot_id = 1;
-    for (uint16_t src_slot_id = 1;
-         src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-         src_slot_id++) {
+    return rc;
+}
+
+/*
+ * An object has been obsoleted in the active arena while a garbage collection is copying slots.
+ * If its slot was copied already, the copy must be obsoleted as well.
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_obsolete_copy(struct logfs_state *logfs, uint16_t src_slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    if (logfs->gc_state != LOGFS_GC_COPYING || src_slot_id >= logfs->gc_next) {
+        /* Not copied (yet) */
+        return 0;
+    }
+
+    for (uint16_t slot_id = 1; slot_id < logfs->gc_dst_slot_id; slot_id++) {
         struct slot_header slot_hdr;
-        uintptr_t src_addr = logfs_get_addr(logfs, src_arena_id, src_slot_id);
+        uintptr_t slot_addr = logfs_get_addr(logfs, logfs->gc_arena_id, slot_id);
         if (logfs->driver->read_data(logfs->flash_id,
-                                     src_addr,
+                                     slot_addr,
                                      (uint8_t *)&slot_hdr,
                                      sizeof(slot_hdr)) != 0) {
-            return -3;
+            return -1;
         }
-
-        if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-            uintptr_t dst_addr = logfs_get_addr(logfs, dst_arena_id, dst_slot_id);
-            if (logfs_raw_copy_bytes(logfs,
-                                     src_addr,
-                                     sizeof(slot_hdr) + slot_hdr.obj_size,
-                                     dst_addr) != 0) {
-                /* Failed to copy all bytes */
-                return -4;
+        if (slot_hdr.state == SLOT_STATE_ACTIVE &&
+            slot_hdr.obj_id == obj_id &&
+            slot_hdr.obj_inst_id == obj_inst_id) {
+            slot_hdr.state = SLOT_STATE_OBSOLETE;
+            if (logfs->driver->write_data(logfs->flash_id,
+                                          slot_addr,
+                                          (uint8_t *)&slot_hdr,
+                                          sizeof(slot_hdr)) != 0) {
+                return -2;
             }
-            dst_slot_id++;
+            return 0;
         }
-#ifdef PIOS_INCLUDE_WDG
-        PIOS_WDG_Clear();
-#endif
-    }
-
-    /* Activate the destination arena */
-    if (logfs_activate_arena(logfs, dst_arena_id) != 0) {
-        return -5;
     }
 
-    /* Unmount the source arena */
-    if (logfs_unmount_log(logfs) != 0) {
-        return -6;
-    }
+    return 0;
+}
 
-    /* Obsolete the source arena */
-    if (logfs_obsolete_arena(logfs, src_arena_id) != 0) {
-        return -7;
-    }
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_garbage_collect(struct logfs_state *logfs)
+{
+    int32_t rc;
 
-    /* Mount the new arena */
-    if (logfs_mount_log(logfs, dst_arena_id) != 0) {
-        return -8;
+    /* Finish the running collection, or do a complete one, in one go */
+    while ((rc = logfs_gc_step(logfs, UINT16_MAX, true)) > 0) {
+        ;
     }
 
-    return 0;
+    return rc;
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
@@ -746,17 +1119,35 @@ static int16_t logfs_object_find_next(const struct logfs_state *logfs, struct sl
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
+static int16_t logfs_object_find(const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    int16_t rc = logfs_index_find(logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+
+    if (rc == -1 && !logfs->index_complete) {
+        /* Not every active slot is indexed, fall back to scanning the log */
+        *slot_id = 0;
+        rc = logfs_object_find_next(logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+    }
+
+    return rc;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
 static int8_t logfs_delete_object(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
     int8_t rc;
 
+    /* With a complete index only the indexed slot can hold an active version of the object */
     bool more = true;
+    bool use_index    = logfs->index_complete;
     uint16_t curr_slot_id = 0;
 
     do {
         struct slot_header slot_hdr;
-        switch (logfs_object_find_next(logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
+        int16_t found = use_index ?
+                        logfs_index_find(logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id) :
+                        logfs_object_find_next(logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id);
+        switch (found) {
         case 0:
             /* Found a matching slot.  Obsolete it. */
             slot_hdr.state = SLOT_STATE_OBSOLETE;
@@ -771,6 +1162,15 @@ static int8_t logfs_delete_object(struct logfs_state *logfs, uint32_t obj_id, ui
             }
             /* Object has been successfully obsoleted and is no longer active */
             logfs->num_active_slots--;
+            logfs_index_remove(logfs, obj_id, obj_inst_id, curr_slot_id);
+            if (logfs_gc_obsolete_copy(logfs, curr_slot_id, obj_id, obj_inst_id) != 0) {
+                rc = -2;
+                goto out_exit;
+            }
+            if (use_index) {
+                more = false;
+                rc   = 0;
+            }
             break;
         case -1:
             /* Search completed, object not found */
@@ -844,8 +1244,11 @@ static int8_t logfs_reserve_free_slot(struct logfs_state *logfs, uint16_t *slot_
     return 0;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int8_t logfs_append_to_log(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+/*
+ * Write an object into a new reserved slot, it is not visible until the slot is activated
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int8_t logfs_write_reserved(struct logfs_state *logfs, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
     /* Reserve a free slot for our new object */
     uint16_t free_slot_id;
@@ -879,21 +1282,120 @@ static int8_t logfs_append_to_log(struct logfs_state *logfs, uint32_t obj_id, ui
         obj_size    -= write_size;
     }
 
+    *slot_id = free_slot_id;
+    return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_activate_slot(struct logfs_state *logfs, uint16_t slot_id, uint32_t obj_id, uint16_t obj_inst_id, uint16_t obj_size)
+{
+    struct slot_header slot_hdr = {
+        .state       = SLOT_STATE_ACTIVE,
+        .obj_id      = obj_id,
+        .obj_inst_id = obj_inst_id,
+        .obj_size    = obj_size,
+    };
+
     /* Mark this slot active in one atomic step */
-    slot_hdr.state = SLOT_STATE_ACTIVE;
     if (logfs->driver->write_data(logfs->flash_id,
-                                  slot_addr,
+                                  logfs_get_addr(logfs, logfs->active_arena_id, slot_id),
                                   (uint8_t *)&slot_hdr,
                                   sizeof(slot_hdr)) != 0) {
         /* Failed to mark the slot active */
-        return -4;
+        return -1;
     }
 
     /* Object has been successfully written to the slot */
     logfs->num_active_slots++;
+    logfs_index_insert(logfs, obj_id, obj_inst_id, slot_id);
     return 0;
 }
 
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_append_to_log(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+    uint16_t slot_id;
+
+    if (logfs_write_reserved(logfs, &slot_id, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
+        return -1;
+    }
+
+    if (logfs_activate_slot(logfs, slot_id, obj_id, obj_inst_id, obj_size) != 0) {
+        return -4;
+    }
+
+    return 0;
+}
+
+/* Position of a pending save in the open transaction, -1 if there is none */
+static int16_t logfs_batch_find(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    for (uint8_t i = 0; i < logfs->batch_count; i++) {
+        if (logfs->batch[i].obj_id == obj_id && logfs->batch[i].obj_inst_id == obj_inst_id) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Discard a pending save, its reserved slot is obsoleted
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int8_t logfs_batch_drop(struct logfs_state *logfs, uint8_t pos)
+{
+    struct logfs_batch_entry *entry = &logfs->batch[pos];
+    struct slot_header slot_hdr     = {
+        .state       = SLOT_STATE_OBSOLETE,
+        .obj_id      = entry->obj_id,
+        .obj_inst_id = entry->obj_inst_id,
+        .obj_size    = entry->obj_size,
+    };
+
+    if (logfs->driver->write_data(logfs->flash_id,
+                                  logfs_get_addr(logfs, logfs->active_arena_id, entry->slot_id),
+                                  (uint8_t *)&slot_hdr,
+                                  sizeof(slot_hdr)) != 0) {
+        return -1;
+    }
+
+    logfs->batch_count--;
+    memmove(entry, entry + 1, (logfs->batch_count - pos) * sizeof(*entry));
+    return 0;
+}
+
+/*
+ * Make all pending saves visible, in the order they were made.
+ * Old versions of an object are only obsoleted once its new version is about to be activated,
+ * an interrupted commit leaves either version readable.
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int8_t logfs_batch_commit(struct logfs_state *logfs)
+{
+    uint8_t done;
+    int8_t rc = 0;
+
+    for (done = 0; done < logfs->batch_count; done++) {
+        struct logfs_batch_entry *entry = &logfs->batch[done];
+
+        if (logfs_delete_object(logfs, entry->obj_id, entry->obj_inst_id) != 0) {
+            rc = -1;
+            break;
+        }
+        if (logfs_activate_slot(logfs, entry->slot_id, entry->obj_id, entry->obj_inst_id, entry->obj_size) != 0) {
+            rc = -2;
+            break;
+        }
+    }
+
+    /* Keep whatever could not be committed for the next attempt */
+    logfs->batch_count -= done;
+    memmove(&logfs->batch[0], &logfs->batch[done], logfs->batch_count * sizeof(logfs->batch[0]));
+
+    return rc;
+}
+
 
 /**********************************
  *
@@ -917,6 +1419,7 @@ static int8_t logfs_append_to_log(struct logfs_state *logfs, uint32_t obj_id, ui
  * @retval -5 if garbage collection failed
  * @retval -6 if filesystem is full even after garbage collection should have freed space
  * @retval -7 if writing the new object to the filesystem failed
+ * @note Inside a transaction the new version only replaces the old one on commit
  */
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
@@ -936,7 +1439,25 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
         goto out_exit;
     }
 
-    if (logfs_delete_object(logfs, obj_id, obj_inst_id) != 0) {
+    if (logfs->batch_depth > 0) {
+        /* Only the latest pending save of an object is kept */
+        int16_t pos = logfs_batch_find(logfs, obj_id, obj_inst_id);
+        if (pos >= 0 && logfs_batch_drop(logfs, pos) != 0) {
+            rc = -3;
+            goto out_end_trans;
+        }
+        /* Commit early when the transaction is full or the log needs collecting, gc only moves active slots */
+        if ((logfs->batch_count == PIOS_FLASHFS_LOGFS_BATCH_MAX_ENTRIES || logfs_log_is_full(logfs)) &&
+            logfs_batch_commit(logfs) != 0) {
+            rc = -3;
+            goto out_end_trans;
+        }
+    }
+
+    /* Inside a transaction the old version stays active until commit, unless the log is full */
+    bool deferred = logfs->batch_depth > 0 && !logfs_log_is_full(logfs);
+
+    if (!deferred && logfs_delete_object(logfs, obj_id, obj_inst_id) != 0) {
         rc = -3;
         goto out_end_trans;
     }
@@ -974,7 +1495,18 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
     }
 
     /* We have room for our new object.  Append it to the log. */
-    if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
+    if (deferred) {
+        struct logfs_batch_entry *entry = &logfs->batch[logfs->batch_count];
+        if (logfs_write_reserved(logfs, &entry->slot_id, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
+            /* Error during append */
+            rc = -7;
+            goto out_end_trans;
+        }
+        entry->obj_id      = obj_id;
+        entry->obj_inst_id = obj_inst_id;
+        entry->obj_size    = obj_size;
+        logfs->batch_count++;
+    } else if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
         /* Error during append */
         rc = -7;
         goto out_end_trans;
@@ -1022,10 +1554,14 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
         goto out_exit;
     }
 
-    /* Find the object in the log */
+    /* Find the object in the log, a save pending in an open transaction hides older versions */
     uint16_t slot_id = 0;
     struct slot_header slot_hdr;
-    if (logfs_object_find_next(logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+    int16_t pos = logfs_batch_find(logfs, obj_id, obj_inst_id);
+    if (pos >= 0) {
+        slot_id = logfs->batch[pos].slot_id;
+        slot_hdr.obj_size = logfs->batch[pos].obj_size;
+    } else if (logfs_object_find(logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
         /* Object does not exist in fs */
         rc = -3;
         goto out_end_trans;
@@ -1087,6 +1623,13 @@ int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_in
         goto out_exit;
     }
 
+    /* A pending save must not resurrect the object on commit */
+    int16_t pos = logfs_batch_find(logfs, obj_id, obj_inst_id);
+    if (pos >= 0 && logfs_batch_drop(logfs, pos) != 0) {
+        rc = -3;
+        goto out_end_trans;
+    }
+
     if (logfs_delete_object(logfs, obj_id, obj_inst_id) != 0) {
         rc = -3;
         goto out_end_trans;
@@ -1126,6 +1669,8 @@ int32_t PIOS_FLASHFS_Format(uintptr_t fs_id)
     if (logfs->mounted) {
         logfs_unmount_log(logfs);
     }
+    logfs->gc_state    = LOGFS_GC_IDLE;
+    logfs->batch_count = 0;
 
     if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
         rc = -2;
@@ -1174,8 +1719,153 @@ int32_t PIOS_FLASHFS_GetStats(uintptr_t fs_id, struct PIOS_FLASHFS_Stats *stats)
     }
     stats->num_active_slots = logfs->num_active_slots;
     stats->num_free_slots   = logfs->num_free_slots;
+    stats->gc_running = logfs->gc_state != LOGFS_GC_IDLE;
+    stats->gc_time    = logfs->gc_time;
+
+    /* Erasing is accounted as the first half of the work, copying as the second one */
+    uint16_t num_sectors = logfs->cfg->arena_size / logfs->cfg->sector_size;
+    uint16_t used_slots  = (logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+    switch (logfs->gc_state) {
+    case LOGFS_GC_IDLE:
+        stats->gc_progress = 0;
+        break;
+    case LOGFS_GC_ERASING:
+        stats->gc_progress = (50 * logfs->gc_next) / num_sectors;
+        break;
+    case LOGFS_GC_COPYING:
+        stats->gc_progress = 50 + (50 * logfs->gc_next) / used_slots;
+        break;
+    }
     return 0;
 }
+
+/**
+ * @brief Runs one step of the incremental garbage collection
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 1 if more steps are needed, 0 if there is nothing to do, or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if the garbage collection step failed
+ * @note A collection is started when the log runs low on free slots, call this
+ *       periodically from a low priority context and repeat while it returns 1
+ */
+int32_t PIOS_FLASHFS_GarbageCollectStep(uintptr_t fs_id)
+{
+    int32_t rc;
+
+    struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+    if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+        rc = -1;
+        goto out_exit;
+    }
+
+    /* Avoid the transaction when there is nothing to do */
+    if (logfs->gc_state == LOGFS_GC_IDLE && !logfs_gc_wanted(logfs)) {
+        rc = 0;
+        goto out_exit;
+    }
+
+    if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
+        rc = -2;
+        goto out_exit;
+    }
+
+    if (logfs->batch_count > 0) {
+        /* Reserved slots of an open transaction would not be copied, retry after commit */
+        rc = 1;
+    } else {
+        rc = logfs_gc_step(logfs, PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP, false);
+        if (rc < 0) {
+            rc = -3;
+        }
+    }
+
+    logfs->driver->end_transaction(logfs->flash_id);
+
+out_exit:
+    return rc;
+}
+
+/**
+ * @brief Starts a transaction, saves are held back until the matching commit
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if too many transactions are nested
+ * @note Objects saved inside a transaction are written to reserved slots, the versions
+ *       they replace stay active until commit. A reset before commit keeps the old versions.
+ *       Transactions nest, the outermost commit makes the saves visible.
+ */
+int32_t PIOS_FLASHFS_BeginTransaction(uintptr_t fs_id)
+{
+    struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+    if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+        return -1;
+    }
+
+    if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
+        return -2;
+    }
+
+    int32_t rc = 0;
+    if (logfs->batch_depth == UINT8_MAX) {
+        rc = -3;
+    } else {
+        logfs->batch_depth++;
+    }
+
+    logfs->driver->end_transaction(logfs->flash_id);
+
+    return rc;
+}
+
+/**
+ * @brief Commits a transaction started by PIOS_FLASHFS_BeginTransaction
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if no transaction is open
+ * @retval -4 if activating the pending saves failed
+ */
+int32_t PIOS_FLASHFS_CommitTransaction(uintptr_t fs_id)
+{
+    int32_t rc;
+
+    struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+    if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+        rc = -1;
+        goto out_exit;
+    }
+
+    if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
+        rc = -2;
+        goto out_exit;
+    }
+
+    if (logfs->batch_depth == 0) {
+        rc = -3;
+        goto out_end_trans;
+    }
+
+    /* Pending saves become visible with the outermost commit only */
+    if (--logfs->batch_depth == 0 && logfs_batch_commit(logfs) != 0) {
+        rc = -4;
+        goto out_end_trans;
+    }
+
+    rc = 0;
+
+out_end_trans:
+    logfs->driver->end_transaction(logfs->flash_id);
+
+out_exit:
+    return rc;
+}
 #endif /* PIOS_INCLUDE_FLASH */
 
 /**
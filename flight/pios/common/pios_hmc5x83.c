@@ -35,6 +35,10 @@
 #ifdef PIOS_INCLUDE_HMC5X83
 
 #define PIOS_HMC5X83_MAGIC 0x4d783833
+
+#if (defined(PIOS_INCLUDE_I2C) && defined(PIOS_I2C_HAS_REQUESTS)) || (defined(PIOS_INCLUDE_SPI) && defined(PIOS_SPI_HAS_TRANSACTIONS))
+#define PIOS_HMC5X83_ASYNC_READ
+#endif
 /* Global Variables */
 
 /* Local Types */
@@ -46,9 +50,32 @@ typedef struct {
     uint8_t  slave_num;
     uint8_t  CTRLB;
     volatile bool data_ready;
+
+    /* Data ready interrupt mode, the samples are read from the interrupt */
+    bool     irq_read;
+    volatile bool read_pending;
+    volatile uint8_t sample; /* last complete sample */
+    bool     has_sample;
+    int16_t  samples[2][3];
+    uint8_t  read_buffer[6];
+#if defined(PIOS_INCLUDE_I2C) && defined(PIOS_I2C_HAS_REQUESTS)
+    uint8_t  read_addr;
+    uint8_t  mode_cmd[2];
+    struct pios_i2c_txn read_txns[3];
+    struct pios_i2c_request read_request;
+#endif
+#if defined(PIOS_INCLUDE_SPI) && defined(PIOS_SPI_HAS_TRANSACTIONS)
+    uint8_t  read_cmd;
+    uint8_t  mode_cmd_spi[2];
+    struct pios_spi_segment read_segments[2];
+    struct pios_spi_segment mode_segment;
+    struct pios_spi_transaction read_transaction;
+    struct pios_spi_transaction mode_transaction;
+#endif
 } pios_hmc5x83_dev_data_t;
 
 static int32_t PIOS_HMC5x83_Config(pios_hmc5x83_dev_data_t *dev);
+static void PIOS_HMC5x83_Convert(pios_hmc5x83_dev_data_t *dev, const uint8_t buffer[6], int16_t out[3]);
 
 /**
  * Allocate the device setting structure
@@ -201,15 +228,46 @@ int32_t PIOS_HMC5x83_ReadMag(pios_hmc5x83_dev_t handler, int16_t out[3])
 {
     pios_hmc5x83_dev_data_t *dev = dev_validate(handler);
 
+    if (dev->irq_read) {
+        if (!dev->data_ready && !dev->read_pending) {
+            /* No sample since the last call, a data ready edge may have been missed */
+            bool woken = false;
+            dev->read_pending = true;
+            if (dev->cfg->Driver->ReadMagAsync(handler, &woken) != 0) {
+                dev->read_pending = false;
+            }
+        }
+        dev->data_ready = false;
+        if (!dev->has_sample) {
+            return -1;
+        }
+        memcpy(out, dev->samples[dev->sample], sizeof(dev->samples[0]));
+        return 0;
+    }
+
     dev->data_ready = false;
     uint8_t buffer[6];
-    int32_t temp;
-    int32_t sensitivity;
 
     if (dev->cfg->Driver->Read(handler, PIOS_HMC5x83_DATAOUT_XMSB_REG, buffer, 6) != 0) {
         return -1;
     }
 
+    PIOS_HMC5x83_Convert(dev, buffer, out);
+
+    // This should not be necessary but for some reason it is coming out of continuous conversion mode
+    dev->cfg->Driver->Write(handler, PIOS_HMC5x83_MODE_REG, PIOS_HMC5x83_MODE_CONTINUOUS);
+
+    return 0;
+}
+
+/**
+ * @brief Scale the data registers, X, Z, Y (in that order), to X, Y, Z milligauss
+ */
+static void PIOS_HMC5x83_Convert(pios_hmc5x83_dev_data_t *dev, const uint8_t buffer[6], int16_t out[3])
+{
+    int32_t temp;
+    int32_t sensitivity;
+
     switch (dev->CTRLB & 0xE0) {
     case 0x00:
         sensitivity = PIOS_HMC5x83_Sensitivity_0_88Ga;
@@ -248,11 +306,6 @@ int32_t PIOS_HMC5x83_ReadMag(pios_hmc5x83_dev_t handler, int16_t out[3])
     temp   = out[2];
     out[2] = out[1];
     out[1] = temp;
-
-    // This should not be necessary but for some reason it is coming out of continuous conversion mode
-    dev->cfg->Driver->Write(handler, PIOS_HMC5x83_MODE_REG, PIOS_HMC5x83_MODE_CONTINUOUS);
-
-    return 0;
 }
 
 
@@ -376,24 +429,78 @@ int32_t PIOS_HMC5x83_Test(pios_hmc5x83_dev_t handler)
     return failed;
 }
 
+/**
+ * @brief Read the samples from the data ready interrupt, PIOS_HMC5x83_ReadMag()
+ * then returns the last sample read without accessing the bus.
+ * Call it after PIOS_HMC5x83_Test(), the bus driver must support asynchronous reads.
+ * \return 0 if enabled, -1 if the driver or the board do not support it
+ */
+int32_t PIOS_HMC5x83_EnableIRQRead(pios_hmc5x83_dev_t handler)
+{
+    pios_hmc5x83_dev_data_t *dev = dev_validate(handler);
+
+#ifdef PIOS_HMC5X83_HAS_GPIOS
+    if (dev->cfg->exti_cfg && dev->cfg->Driver->ReadMagAsync) {
+        dev->has_sample = false;
+        dev->irq_read   = true;
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+#ifdef PIOS_HMC5X83_ASYNC_READ
+/**
+ * @brief Called by the bus drivers once an asynchronous read is complete
+ */
+static void PIOS_HMC5x83_ReadMagDone(pios_hmc5x83_dev_data_t *dev, int32_t status)
+{
+    if (status == 0) {
+        uint8_t next = dev->sample ^ 1;
+        PIOS_HMC5x83_Convert(dev, dev->read_buffer, dev->samples[next]);
+        dev->sample     = next;
+        dev->has_sample = true;
+        dev->data_ready = true;
+    }
+    dev->read_pending = false;
+}
+#endif /* PIOS_HMC5X83_ASYNC_READ */
+
 /**
  * @brief IRQ Handler
  */
 bool PIOS_HMC5x83_IRQHandler(pios_hmc5x83_dev_t handler)
 {
     pios_hmc5x83_dev_data_t *dev = dev_validate(handler);
+    bool woken = false;
 
-    dev->data_ready = true;
-    return false;
+    if (!dev->irq_read) {
+        dev->data_ready = true;
+        return false;
+    }
+    if (!dev->read_pending) {
+        dev->read_pending = true;
+        if (dev->cfg->Driver->ReadMagAsync(handler, &woken) != 0) {
+            dev->read_pending = false;
+        }
+    }
+    return woken;
 }
 
 #ifdef PIOS_INCLUDE_SPI
 int32_t PIOS_HMC5x83_SPI_Read(pios_hmc5x83_dev_t handler, uint8_t address, uint8_t *buffer, uint8_t len);
 int32_t PIOS_HMC5x83_SPI_Write(pios_hmc5x83_dev_t handler, uint8_t address, uint8_t buffer);
 
+#ifdef PIOS_SPI_HAS_TRANSACTIONS
+static int32_t PIOS_HMC5x83_SPI_ReadMagAsync(pios_hmc5x83_dev_t handler, bool *woken);
+#endif
+
 const struct pios_hmc5x83_io_driver PIOS_HMC5x83_SPI_DRIVER = {
     .Read  = PIOS_HMC5x83_SPI_Read,
     .Write = PIOS_HMC5x83_SPI_Write,
+#ifdef PIOS_SPI_HAS_TRANSACTIONS
+    .ReadMagAsync = PIOS_HMC5x83_SPI_ReadMagAsync,
+#endif
 };
 
 static int32_t pios_hmc5x83_spi_claim_bus(pios_hmc5x83_dev_data_t *dev)
@@ -469,15 +576,66 @@ int32_t PIOS_HMC5x83_SPI_Write(pios_hmc5x83_dev_t handler, uint8_t address, uint
     pios_hmc5x83_spi_release_bus(dev);
     return 0;
 }
+
+#ifdef PIOS_SPI_HAS_TRANSACTIONS
+static void pios_hmc5x83_spi_read_done(struct pios_spi_transaction *transaction, int32_t status, __attribute__((unused)) bool *woken)
+{
+    PIOS_HMC5x83_ReadMagDone((pios_hmc5x83_dev_data_t *)transaction->context, status);
+}
+
+/**
+ * @brief Queues the read of the data registers then the mode register write of PIOS_HMC5x83_ReadMag()
+ * \return 0 if queued, -1 if the bus refused the transactions
+ */
+static int32_t PIOS_HMC5x83_SPI_ReadMagAsync(pios_hmc5x83_dev_t handler, bool *woken)
+{
+    pios_hmc5x83_dev_data_t *dev = dev_validate(handler);
+
+    dev->read_cmd        = PIOS_HMC5x83_DATAOUT_XMSB_REG | PIOS_HMC5x83_SPI_AUTOINCR_FLAG | PIOS_HMC5x83_SPI_READ_FLAG;
+    dev->read_segments[0] = (struct pios_spi_segment) { .send_buffer = &dev->read_cmd, .len = 1 };
+    dev->read_segments[1] = (struct pios_spi_segment) { .receive_buffer = dev->read_buffer, .len = sizeof(dev->read_buffer) };
+    dev->read_transaction.slave_id      = dev->slave_num;
+    dev->read_transaction.prescaler     = SPI_BaudRatePrescaler_16;
+    dev->read_transaction.segments      = dev->read_segments;
+    dev->read_transaction.segment_count = NELEMENTS(dev->read_segments);
+    dev->read_transaction.callback      = pios_hmc5x83_spi_read_done;
+    dev->read_transaction.context       = dev;
+
+    dev->mode_cmd_spi[0] = PIOS_HMC5x83_MODE_REG | PIOS_HMC5x83_SPI_AUTOINCR_FLAG;
+    dev->mode_cmd_spi[1] = PIOS_HMC5x83_MODE_CONTINUOUS;
+    dev->mode_segment    = (struct pios_spi_segment) { .send_buffer = dev->mode_cmd_spi, .len = sizeof(dev->mode_cmd_spi) };
+    dev->mode_transaction.slave_id      = dev->slave_num;
+    dev->mode_transaction.prescaler     = SPI_BaudRatePrescaler_16;
+    dev->mode_transaction.segments      = &dev->mode_segment;
+    dev->mode_transaction.segment_count = 1;
+    dev->mode_transaction.callback      = NULL;
+
+    if (PIOS_SPI_Submit(dev->port_id, &dev->read_transaction, PIOS_SPI_PRIORITY_HIGH, woken) != 0) {
+        return -1;
+    }
+    if (!dev->mode_transaction.pending) {
+        /* Still queued from the last read otherwise */
+        (void)PIOS_SPI_Submit(dev->port_id, &dev->mode_transaction, PIOS_SPI_PRIORITY_HIGH, woken);
+    }
+    return 0;
+}
+#endif /* PIOS_SPI_HAS_TRANSACTIONS */
 #endif /* PIOS_INCLUDE_SPI */
 #ifdef PIOS_INCLUDE_I2C
 
 int32_t PIOS_HMC5x83_I2C_Read(pios_hmc5x83_dev_t handler, uint8_t address, uint8_t *buffer, uint8_t len);
 int32_t PIOS_HMC5x83_I2C_Write(pios_hmc5x83_dev_t handler, uint8_t address, uint8_t buffer);
 
+#ifdef PIOS_I2C_HAS_REQUESTS
+static int32_t PIOS_HMC5x83_I2C_ReadMagAsync(pios_hmc5x83_dev_t handler, bool *woken);
+#endif
+
 const struct pios_hmc5x83_io_driver PIOS_HMC5x83_I2C_DRIVER = {
     .Read  = PIOS_HMC5x83_I2C_Read,
     .Write = PIOS_HMC5x83_I2C_Write,
+#ifdef PIOS_I2C_HAS_REQUESTS
+    .ReadMagAsync = PIOS_HMC5x83_I2C_ReadMagAsync,
+#endif
 };
 
 /**
@@ -547,6 +705,53 @@ int32_t PIOS_HMC5x83_I2C_Write(pios_hmc5x83_dev_t handler, uint8_t address, uint
     ;
     return PIOS_I2C_Transfer(dev->port_id, txn_list, NELEMENTS(txn_list));
 }
+
+#ifdef PIOS_I2C_HAS_REQUESTS
+static void pios_hmc5x83_i2c_read_done(struct pios_i2c_request *request, int32_t status, __attribute__((unused)) bool *woken)
+{
+    PIOS_HMC5x83_ReadMagDone((pios_hmc5x83_dev_data_t *)request->context, status);
+}
+
+/**
+ * @brief Queues the read of the data registers, followed by the mode register write of PIOS_HMC5x83_ReadMag()
+ * \return 0 if queued, -1 if the bus refused the request
+ */
+static int32_t PIOS_HMC5x83_I2C_ReadMagAsync(pios_hmc5x83_dev_t handler, bool *woken)
+{
+    pios_hmc5x83_dev_data_t *dev = dev_validate(handler);
+
+    dev->read_addr    = PIOS_HMC5x83_DATAOUT_XMSB_REG;
+    dev->mode_cmd[0]  = PIOS_HMC5x83_MODE_REG;
+    dev->mode_cmd[1]  = PIOS_HMC5x83_MODE_CONTINUOUS;
+    dev->read_txns[0] = (struct pios_i2c_txn) {
+        .info = __func__,
+        .addr = PIOS_HMC5x83_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_WRITE,
+        .len  = sizeof(dev->read_addr),
+        .buf  = &dev->read_addr,
+    };
+    dev->read_txns[1] = (struct pios_i2c_txn) {
+        .info = __func__,
+        .addr = PIOS_HMC5x83_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_READ,
+        .len  = sizeof(dev->read_buffer),
+        .buf  = dev->read_buffer,
+    };
+    dev->read_txns[2] = (struct pios_i2c_txn) {
+        .info = __func__,
+        .addr = PIOS_HMC5x83_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_WRITE,
+        .len  = sizeof(dev->mode_cmd),
+        .buf  = dev->mode_cmd,
+    };
+    dev->read_request.txn_list = dev->read_txns;
+    dev->read_request.num_txns = NELEMENTS(dev->read_txns);
+    dev->read_request.callback = pios_hmc5x83_i2c_read_done;
+    dev->read_request.context  = dev;
+
+    return PIOS_I2C_Submit(dev->port_id, &dev->read_request, woken) == 0 ? 0 : -1;
+}
+#endif /* PIOS_I2C_HAS_REQUESTS */
 #endif /* PIOS_INCLUDE_I2C */
 
 
@@ -26,6 +26,8 @@
 
 #include <pios_instrumentation.h>
 
+#define PIOS_INSTRUMENTATION_READ_RETRIES 4
+
 pios_perf_counter_t *pios_instrumentation_perf_counters = NULL;
 int8_t pios_instrumentation_max_counters = -1;
 int8_t pios_instrumentation_last_used_counter = -1;
@@ -59,6 +61,19 @@ pios_counter_t PIOS_Instrumentation_CreateCounter(uint32_t id)
     return counter_handle;
 }
 
+pios_counter_t PIOS_Instrumentation_CreateStatsCounter(uint32_t id)
+{
+    pios_perf_counter_t *counter = (pios_perf_counter_t *)PIOS_Instrumentation_CreateCounter(id);
+
+    if (!counter->stats) {
+        pios_perf_stats_t *stats = (pios_perf_stats_t *)pvPortMalloc(sizeof(pios_perf_stats_t));
+        PIOS_Assert(stats);
+        memset(stats, 0, sizeof(pios_perf_stats_t));
+        counter->stats = stats;
+    }
+    return (pios_counter_t)counter;
+}
+
 pios_counter_t PIOS_Instrumentation_SearchCounter(uint32_t id)
 {
     PIOS_Assert(pios_instrumentation_perf_counters);
@@ -77,6 +92,25 @@ void PIOS_Instrumentation_ForEachCounter(InstrumentationCounterCallback callback
     PIOS_Assert(pios_instrumentation_perf_counters);
     for (int8_t index = 0; index < pios_instrumentation_last_used_counter + 1; index++) {
         const pios_perf_counter_t *counter = &pios_instrumentation_perf_counters[index];
-        callback(counter, index, context);
+        pios_perf_counter_t copy;
+        pios_perf_stats_t stats;
+        bool consistent = false;
+
+        // The writer may preempt the copy, retry then. If it is itself preempted in the
+        // middle of an update it will not complete it while we retry, give up on the counter.
+        for (uint8_t retry = 0; retry < PIOS_INSTRUMENTATION_READ_RETRIES && !consistent; retry++) {
+            uint32_t seq = counter->seq;
+            PIOS_INSTRUMENTATION_BARRIER();
+            copy = *counter;
+            if (copy.stats) {
+                stats = *copy.stats;
+                copy.stats = &stats;
+            }
+            PIOS_INSTRUMENTATION_BARRIER();
+            consistent = !(seq & 1) && seq == counter->seq;
+        }
+        if (consistent) {
+            callback(&copy, index, context);
+        }
     }
 }
@@ -66,3 +66,145 @@ void pios_free(void *p)
 }
 
 #endif /* ifdef PIOS_TARGET_PROVIDES_FAST_HEAP */
+
+#ifdef PIOS_INCLUDE_MEM_POOL
+
+#ifndef PIOS_MEM_POOL_BLOCKS_32
+#define PIOS_MEM_POOL_BLOCKS_32  16
+#endif
+#ifndef PIOS_MEM_POOL_BLOCKS_64
+#define PIOS_MEM_POOL_BLOCKS_64  8
+#endif
+#ifndef PIOS_MEM_POOL_BLOCKS_128
+#define PIOS_MEM_POOL_BLOCKS_128 8
+#endif
+#ifndef PIOS_MEM_POOL_BLOCKS_256
+#define PIOS_MEM_POOL_BLOCKS_256 4
+#endif
+
+struct pios_mem_block {
+    struct pios_mem_block *next;
+};
+
+struct pios_mem_pool {
+    uint8_t  *start; // storage of the blocks, NULL until the pools are set up
+    uint8_t  *end;
+    struct pios_mem_block *free_list;
+    uint16_t block_size;
+    uint16_t blocks;
+    uint16_t free;
+    uint16_t min_free;
+    uint16_t fallbacks;
+};
+
+static struct pios_mem_pool pios_mem_pools[PIOS_MEM_POOL_NUM_CLASSES] = {
+    { .block_size = 32,  .blocks = PIOS_MEM_POOL_BLOCKS_32  },
+    { .block_size = 64,  .blocks = PIOS_MEM_POOL_BLOCKS_64  },
+    { .block_size = 128, .blocks = PIOS_MEM_POOL_BLOCKS_128 },
+    { .block_size = 256, .blocks = PIOS_MEM_POOL_BLOCKS_256 },
+};
+static bool pios_mem_pools_ready;
+
+/**
+ * Allocate the storage of all the pools and chain their blocks, once
+ */
+static void pios_pool_setup()
+{
+    size_t total = 0;
+
+    for (uint8_t i = 0; i < PIOS_MEM_POOL_NUM_CLASSES; i++) {
+        total += pios_mem_pools[i].block_size * pios_mem_pools[i].blocks;
+    }
+
+    uint8_t *storage = (uint8_t *)pios_malloc(total);
+    if (storage) {
+        for (uint8_t i = 0; i < PIOS_MEM_POOL_NUM_CLASSES; i++) {
+            struct pios_mem_pool *pool = &pios_mem_pools[i];
+            pool->start     = storage;
+            pool->end       = storage + pool->block_size * pool->blocks;
+            pool->free_list = NULL;
+            for (uint8_t *block = pool->end; block > pool->start;) {
+                block -= pool->block_size;
+                ((struct pios_mem_block *)block)->next = pool->free_list;
+                pool->free_list = (struct pios_mem_block *)block;
+            }
+            pool->free     = pool->blocks;
+            pool->min_free = pool->blocks;
+            storage = pool->end;
+        }
+    }
+    // Without storage the pools stay empty and everything falls back to pios_malloc()
+    pios_mem_pools_ready = true;
+}
+
+void *pios_pool_malloc(size_t size)
+{
+    uint8_t i = 0;
+
+    while (i < PIOS_MEM_POOL_NUM_CLASSES && size > pios_mem_pools[i].block_size) {
+        i++;
+    }
+    if (i == PIOS_MEM_POOL_NUM_CLASSES) {
+        return pios_malloc(size);
+    }
+
+    if (!pios_mem_pools_ready) {
+        vTaskSuspendAll();
+        if (!pios_mem_pools_ready) {
+            pios_pool_setup();
+        }
+        xTaskResumeAll();
+    }
+
+    struct pios_mem_pool *pool = &pios_mem_pools[i];
+    PIOS_IRQ_Disable();
+    struct pios_mem_block *block = pool->free_list;
+    if (block) {
+        pool->free_list = block->next;
+        if (--pool->free < pool->min_free) {
+            pool->min_free = pool->free;
+        }
+    } else {
+        pool->fallbacks++;
+    }
+    PIOS_IRQ_Enable();
+
+    return block ? (void *)block : pios_malloc(size);
+}
+
+void pios_pool_free(void *p)
+{
+    if (!p) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < PIOS_MEM_POOL_NUM_CLASSES; i++) {
+        struct pios_mem_pool *pool = &pios_mem_pools[i];
+        if ((uint8_t *)p >= pool->start && (uint8_t *)p < pool->end) {
+            struct pios_mem_block *block = (struct pios_mem_block *)p;
+            PIOS_IRQ_Disable();
+            block->next     = pool->free_list;
+            pool->free_list = block;
+            pool->free++;
+            PIOS_IRQ_Enable();
+            return;
+        }
+    }
+    pios_free(p);
+}
+
+void pios_pool_get_stats(uint8_t size_class, struct pios_mem_pool_stats *stats)
+{
+    PIOS_Assert(size_class < PIOS_MEM_POOL_NUM_CLASSES);
+    const struct pios_mem_pool *pool = &pios_mem_pools[size_class];
+
+    PIOS_IRQ_Disable();
+    stats->block_size = pool->block_size;
+    stats->blocks     = pool->start ? pool->blocks : 0;
+    stats->free       = pool->free;
+    stats->min_free   = pool->min_free;
+    stats->fallbacks  = pool->fallbacks;
+    PIOS_IRQ_Enable();
+}
+
+#endif /* PIOS_INCLUDE_MEM_POOL */
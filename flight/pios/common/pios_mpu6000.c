@@ -44,13 +44,22 @@ struct mpu6000_dev {
     uint32_t     spi_id;
     uint32_t     slave_num;
     xQueueHandle queue;
+    xQueueHandle block_queue;
     const struct pios_mpu6000_cfg *cfg;
     enum pios_mpu6000_range gyro_range;
     enum pios_mpu6000_accel_range accel_range;
     enum pios_mpu6000_filter filter;
+    uint16_t     sample_period_us;
+    uint8_t      burst_count;
+    bool         accumulate;
+    struct pios_mpu6000_sum sum;
     enum pios_mpu6000_dev_magic   magic;
 };
 
+#define PIOS_MPU6000_BURST_MODE(cfg) ((cfg)->burst_samples > 1 && ((cfg)->User_ctl & PIOS_MPU6000_USERCTL_FIFO_EN))
+// Number of blocks queued in burst mode
+#define PIOS_MPU6000_BLOCK_QUEUE_LEN 2
+
 #ifdef PIOS_MPU6000_ACCEL
 #define PIOS_MPU6000_SAMPLES_BYTES    14
 #define PIOS_MPU6000_SENSOR_FIRST_REG PIOS_MPU6000_ACCEL_X_OUT_MSB
@@ -89,6 +98,23 @@ static struct mpu6000_dev *dev;
 volatile bool mpu6000_configured = false;
 static mpu6000_data_t mpu6000_data;
 
+// burst mode transfer buffers, the FIFO records follow each other after the address byte
+static const uint8_t mpu6000_burst_send_buf[1 + PIOS_MPU6000_SAMPLES_BYTES * PIOS_MPU6000_BLOCK_SAMPLES] = { PIOS_MPU6000_FIFO_REG | 0x80 };
+static uint8_t mpu6000_burst_buf[1 + PIOS_MPU6000_SAMPLES_BYTES * PIOS_MPU6000_BLOCK_SAMPLES];
+static struct pios_mpu6000_block mpu6000_block;
+
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+// the sensor registers are read by a high priority SPI transaction, decoded from its callback
+static const uint8_t mpu6000_sensor_send_buf[1 + PIOS_MPU6000_SAMPLES_BYTES] = { PIOS_MPU6000_SENSOR_FIRST_REG | 0x80 };
+static const struct pios_spi_segment mpu6000_sensor_segment = {
+    .send_buffer    = mpu6000_sensor_send_buf,
+    .receive_buffer = &mpu6000_data.buffer[0],
+    .len = sizeof(mpu6000_data_t),
+};
+static struct pios_spi_transaction mpu6000_sensor_transaction;
+static void PIOS_MPU6000_SensorReadDone(struct pios_spi_transaction *transaction, int32_t status, bool *woken);
+#endif
+
 // ! Private functions
 static struct mpu6000_dev *PIOS_MPU6000_alloc(const struct pios_mpu6000_cfg *cfg);
 static int32_t PIOS_MPU6000_Validate(struct mpu6000_dev *dev);
@@ -97,8 +123,10 @@ static int32_t PIOS_MPU6000_SetReg(uint8_t address, uint8_t buffer);
 static int32_t PIOS_MPU6000_GetReg(uint8_t address);
 static void PIOS_MPU6000_SetSpeed(const bool fast);
 static bool PIOS_MPU6000_HandleData();
+static void PIOS_MPU6000_DecodeSample(const mpu6000_data_t *raw, struct pios_mpu6000_data *data);
 static bool PIOS_MPU6000_ReadFifo(bool *woken);
 static bool PIOS_MPU6000_ReadSensor(bool *woken);
+static bool PIOS_MPU6000_ReadBlock(bool *woken, uint32_t timestamp);
 /**
  * @brief Allocate a new device
  */
@@ -113,11 +141,26 @@ static struct mpu6000_dev *PIOS_MPU6000_alloc(const struct pios_mpu6000_cfg *cfg
 
     mpu6000_dev->magic = PIOS_MPU6000_DEV_MAGIC;
 
-    mpu6000_dev->queue = xQueueCreate(cfg->max_downsample + 1, sizeof(struct pios_mpu6000_data));
-    if (mpu6000_dev->queue == NULL) {
-        vPortFree(mpu6000_dev);
-        return NULL;
+    mpu6000_dev->queue       = NULL;
+    mpu6000_dev->block_queue = NULL;
+    mpu6000_dev->accumulate  = false;
+    memset(&mpu6000_dev->sum, 0, sizeof(mpu6000_dev->sum));
+    if (PIOS_MPU6000_BURST_MODE(cfg)) {
+        mpu6000_dev->block_queue = xQueueCreate(PIOS_MPU6000_BLOCK_QUEUE_LEN, sizeof(struct pios_mpu6000_block));
+        if (mpu6000_dev->block_queue == NULL) {
+            vPortFree(mpu6000_dev);
+            return NULL;
+        }
+    } else if (cfg->accumulate) {
+        mpu6000_dev->accumulate = true;
+    } else {
+        mpu6000_dev->queue = xQueueCreate(cfg->max_downsample + 1, sizeof(struct pios_mpu6000_data));
+        if (mpu6000_dev->queue == NULL) {
+            vPortFree(mpu6000_dev);
+            return NULL;
+        }
     }
+    mpu6000_dev->burst_count = 0;
 
     return mpu6000_dev;
 }
@@ -155,6 +198,14 @@ int32_t PIOS_MPU6000_Init(uint32_t spi_id, uint32_t slave_num, const struct pios
     dev->slave_num = slave_num;
     dev->cfg = cfg;
 
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+    mpu6000_sensor_transaction.slave_id      = slave_num;
+    mpu6000_sensor_transaction.prescaler     = cfg->fast_prescaler;
+    mpu6000_sensor_transaction.segments      = &mpu6000_sensor_segment;
+    mpu6000_sensor_transaction.segment_count = 1;
+    mpu6000_sensor_transaction.callback      = PIOS_MPU6000_SensorReadDone;
+#endif
+
     /* Configure the MPU6000 Sensor */
     PIOS_MPU6000_Config(cfg);
 
@@ -272,6 +323,9 @@ int32_t PIOS_MPU6000_ConfigureRanges(
     }
 
     dev->filter = filterSetting;
+    // gyro output rate is 8kHz without digital filtering, 1kHz with it
+    dev->sample_period_us = filterSetting == PIOS_MPU6000_LOWPASS_256_HZ ?
+                            125 * (1 + dev->cfg->Smpl_rate_div_no_dlp) : 1000 * (1 + dev->cfg->Smpl_rate_div_dlp);
 
     // Gyro range
     while (PIOS_MPU6000_SetReg(PIOS_MPU6000_GYRO_CFG_REG, gyroRange) != 0) {
@@ -457,7 +511,7 @@ int32_t PIOS_MPU6000_ReadID()
 
 /**
  * \brief Reads the queue handle
- * \return Handle to the queue or null if invalid device
+ * \return Handle to the queue or null if invalid device or in burst or accumulate mode
  */
 xQueueHandle PIOS_MPU6000_GetQueue()
 {
@@ -468,6 +522,39 @@ xQueueHandle PIOS_MPU6000_GetQueue()
     return dev->queue;
 }
 
+/**
+ * \brief Reads the block queue handle
+ * \return Handle to the queue of struct pios_mpu6000_block or null if invalid device or not in burst mode
+ */
+xQueueHandle PIOS_MPU6000_GetBlockQueue()
+{
+    if (PIOS_MPU6000_Validate(dev) != 0) {
+        return (xQueueHandle)NULL;
+    }
+
+    return dev->block_queue;
+}
+
+/**
+ * \brief Reads the sum of the samples since the previous call and starts a new one
+ * \param[out] sum The sum and number of samples
+ * \return 0 if successful, -1 if invalid device or not in accumulate mode
+ */
+int32_t PIOS_MPU6000_ReadSum(struct pios_mpu6000_sum *sum)
+{
+    if (PIOS_MPU6000_Validate(dev) != 0 || !dev->accumulate) {
+        return -1;
+    }
+
+    // The interrupt adds to the sum, swap it for an empty one at once
+    PIOS_IRQ_Disable();
+    *sum = dev->sum;
+    memset(&dev->sum, 0, sizeof(dev->sum));
+    PIOS_IRQ_Enable();
+
+    return 0;
+}
+
 
 float PIOS_MPU6000_GetScale()
 {
@@ -623,14 +710,19 @@ bool PIOS_MPU6000_IRQHandler(void)
     }
 
     bool read_ok = false;
-    if (dev->cfg->User_ctl & PIOS_MPU6000_USERCTL_FIFO_EN) {
-        read_ok = PIOS_MPU6000_ReadFifo(&woken);
-    } else {
-        read_ok = PIOS_MPU6000_ReadSensor(&woken);
-    }
-    if (read_ok) {
-        bool woken2 = PIOS_MPU6000_HandleData();
+    if (dev->block_queue) {
+        bool woken2 = PIOS_MPU6000_ReadBlock(&woken, timeval);
         woken |= woken2;
+    } else {
+        if (dev->cfg->User_ctl & PIOS_MPU6000_USERCTL_FIFO_EN) {
+            read_ok = PIOS_MPU6000_ReadFifo(&woken);
+        } else {
+            read_ok = PIOS_MPU6000_ReadSensor(&woken);
+        }
+        if (read_ok) {
+            bool woken2 = PIOS_MPU6000_HandleData();
+            woken |= woken2;
+        }
     }
 
     mpu6000_irq++;
@@ -640,61 +732,108 @@ bool PIOS_MPU6000_IRQHandler(void)
     return woken;
 }
 
-static bool PIOS_MPU6000_HandleData()
+static void PIOS_MPU6000_DecodeSample(const mpu6000_data_t *raw, struct pios_mpu6000_data *data)
 {
     // Rotate the sensor to OP convention.  The datasheet defines X as towards the right
     // and Y as forward.  OP convention transposes this.  Also the Z is defined negatively
     // to our convention
 
-    static struct pios_mpu6000_data data;
-
     // Currently we only support rotations on top so switch X/Y accordingly
     switch (dev->cfg->orientation) {
     case PIOS_MPU6000_TOP_0DEG:
 #ifdef PIOS_MPU6000_ACCEL
-        data.accel_y = GET_SENSOR_DATA(mpu6000_data, Accel_X); // chip X
-        data.accel_x = GET_SENSOR_DATA(mpu6000_data, Accel_Y); // chip Y
+        data->accel_y = GET_SENSOR_DATA((*raw), Accel_X); // chip X
+        data->accel_x = GET_SENSOR_DATA((*raw), Accel_Y); // chip Y
 #endif
-        data.gyro_y  = GET_SENSOR_DATA(mpu6000_data, Gyro_X); // chip X
-        data.gyro_x  = GET_SENSOR_DATA(mpu6000_data, Gyro_Y); // chip Y
+        data->gyro_y  = GET_SENSOR_DATA((*raw), Gyro_X); // chip X
+        data->gyro_x  = GET_SENSOR_DATA((*raw), Gyro_Y); // chip Y
         break;
     case PIOS_MPU6000_TOP_90DEG:
         // -1 to bring it back to -32768 +32767 range
 #ifdef PIOS_MPU6000_ACCEL
-        data.accel_y = -1 - (GET_SENSOR_DATA(mpu6000_data, Accel_Y)); // chip Y
-        data.accel_x = GET_SENSOR_DATA(mpu6000_data, Accel_X); // chip X
+        data->accel_y = -1 - (GET_SENSOR_DATA((*raw), Accel_Y)); // chip Y
+        data->accel_x = GET_SENSOR_DATA((*raw), Accel_X); // chip X
 #endif
-        data.gyro_y  = -1 - (GET_SENSOR_DATA(mpu6000_data, Gyro_Y)); // chip Y
-        data.gyro_x  = GET_SENSOR_DATA(mpu6000_data, Gyro_X); // chip X
+        data->gyro_y  = -1 - (GET_SENSOR_DATA((*raw), Gyro_Y)); // chip Y
+        data->gyro_x  = GET_SENSOR_DATA((*raw), Gyro_X); // chip X
         break;
     case PIOS_MPU6000_TOP_180DEG:
 #ifdef PIOS_MPU6000_ACCEL
-        data.accel_y = -1 - (GET_SENSOR_DATA(mpu6000_data, Accel_X)); // chip X
-        data.accel_x = -1 - (GET_SENSOR_DATA(mpu6000_data, Accel_Y)); // chip Y
+        data->accel_y = -1 - (GET_SENSOR_DATA((*raw), Accel_X)); // chip X
+        data->accel_x = -1 - (GET_SENSOR_DATA((*raw), Accel_Y)); // chip Y
 #endif
-        data.gyro_y  = -1 - (GET_SENSOR_DATA(mpu6000_data, Gyro_X)); // chip X
-        data.gyro_x  = -1 - (GET_SENSOR_DATA(mpu6000_data, Gyro_Y)); // chip Y
+        data->gyro_y  = -1 - (GET_SENSOR_DATA((*raw), Gyro_X)); // chip X
+        data->gyro_x  = -1 - (GET_SENSOR_DATA((*raw), Gyro_Y)); // chip Y
         break;
     case PIOS_MPU6000_TOP_270DEG:
 #ifdef PIOS_MPU6000_ACCEL
-        data.accel_y = GET_SENSOR_DATA(mpu6000_data, Accel_Y); // chip Y
-        data.accel_x = -1 - (GET_SENSOR_DATA(mpu6000_data, Accel_X)); // chip X
+        data->accel_y = GET_SENSOR_DATA((*raw), Accel_Y); // chip Y
+        data->accel_x = -1 - (GET_SENSOR_DATA((*raw), Accel_X)); // chip X
 #endif
-        data.gyro_y  = GET_SENSOR_DATA(mpu6000_data, Gyro_Y); // chip Y
-        data.gyro_x  = -1 - (GET_SENSOR_DATA(mpu6000_data, Gyro_X)); // chip X
+        data->gyro_y  = GET_SENSOR_DATA((*raw), Gyro_Y); // chip Y
+        data->gyro_x  = -1 - (GET_SENSOR_DATA((*raw), Gyro_X)); // chip X
         break;
     }
 #ifdef PIOS_MPU6000_ACCEL
-    data.accel_z     = -1 - (GET_SENSOR_DATA(mpu6000_data, Accel_Z));
+    data->accel_z     = -1 - (GET_SENSOR_DATA((*raw), Accel_Z));
 #endif
-    data.gyro_z      = -1 - (GET_SENSOR_DATA(mpu6000_data, Gyro_Z));
-    data.temperature = GET_SENSOR_DATA(mpu6000_data, Temperature);
+    data->gyro_z      = -1 - (GET_SENSOR_DATA((*raw), Gyro_Z));
+    data->temperature = GET_SENSOR_DATA((*raw), Temperature);
+}
+
+static bool PIOS_MPU6000_HandleData()
+{
+    static struct pios_mpu6000_data data;
+
+    PIOS_MPU6000_DecodeSample(&mpu6000_data, &data);
+
+    if (dev->accumulate) {
+        // Saturates after 65535 samples without a reader, well before the sums overflow
+        if (dev->sum.count < UINT16_MAX) {
+            dev->sum.gyro_x      += data.gyro_x;
+            dev->sum.gyro_y      += data.gyro_y;
+            dev->sum.gyro_z      += data.gyro_z;
+#ifdef PIOS_MPU6000_ACCEL
+            dev->sum.accel_x     += data.accel_x;
+            dev->sum.accel_y     += data.accel_y;
+            dev->sum.accel_z     += data.accel_z;
+#endif
+            dev->sum.temperature += data.temperature;
+            dev->sum.count++;
+        }
+        return false;
+    }
 
     BaseType_t higherPriorityTaskWoken;
     xQueueSendToBackFromISR(dev->queue, (void *)&data, &higherPriorityTaskWoken);
     return higherPriorityTaskWoken == pdTRUE;
 }
 
+#if defined(PIOS_SPI_HAS_TRANSACTIONS)
+/**
+ * @brief Queues the read of the sensor registers, the sample is handled by
+ * PIOS_MPU6000_SensorReadDone() at the end of the transaction
+ * @return false, no sample is available yet
+ */
+static bool PIOS_MPU6000_ReadSensor(bool *woken)
+{
+    if (PIOS_SPI_Submit(dev->spi_id, &mpu6000_sensor_transaction, PIOS_SPI_PRIORITY_HIGH, woken) != 0) {
+        // the previous read is still queued
+        mpu6000_fails++;
+    }
+    return false;
+}
+
+static void PIOS_MPU6000_SensorReadDone(__attribute__((unused)) struct pios_spi_transaction *transaction, int32_t status, bool *woken)
+{
+    if (status < 0) {
+        mpu6000_fails++;
+        return;
+    }
+    bool woken2 = PIOS_MPU6000_HandleData();
+    *woken |= woken2;
+}
+#else /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
 static bool PIOS_MPU6000_ReadSensor(bool *woken)
 {
     const uint8_t mpu6000_send_buf[1 + PIOS_MPU6000_SAMPLES_BYTES] = { PIOS_MPU6000_SENSOR_FIRST_REG | 0x80 };
@@ -710,6 +849,7 @@ static bool PIOS_MPU6000_ReadSensor(bool *woken)
     PIOS_MPU6000_ReleaseBusISR(woken);
     return true;
 }
+#endif /* if defined(PIOS_SPI_HAS_TRANSACTIONS) */
 
 static bool PIOS_MPU6000_ReadFifo(bool *woken)
 {
@@ -771,6 +911,66 @@ static bool PIOS_MPU6000_ReadFifo(bool *woken)
     }
     return true;
 }
+
+/**
+ * @brief Burst mode, reads all the samples in the FIFO in a single transfer every
+ * burst_samples interrupts and queues them as one block
+ * @param woken[in,out] set to true if a higher priority task is now eligible to run
+ * @param timestamp PIOS_DELAY raw time of this interrupt
+ * @return true if a higher priority task has been woken by the block
+ */
+static bool PIOS_MPU6000_ReadBlock(bool *woken, uint32_t timestamp)
+{
+    int32_t result;
+
+    // the interrupts in between only count the samples
+    if (++dev->burst_count < dev->cfg->burst_samples) {
+        return false;
+    }
+    dev->burst_count = 0;
+
+    if ((result = PIOS_MPU6000_GetInterruptStatusRegISR(woken)) < 0) {
+        return false;
+    }
+    if (result & PIOS_MPU6000_INT_STATUS_FIFO_OVERFLOW) {
+        // samples are lost anyway, restart from an empty FIFO
+        PIOS_MPU6000_ResetFifoISR(woken);
+        return false;
+    }
+
+    mpu6000_count = PIOS_MPU6000_FifoDepthISR(woken);
+    if (mpu6000_count < PIOS_MPU6000_SAMPLES_BYTES) {
+        return false;
+    }
+    uint8_t count = MIN(mpu6000_count / PIOS_MPU6000_SAMPLES_BYTES, PIOS_MPU6000_BLOCK_SAMPLES);
+    if (mpu6000_count >= PIOS_MPU6000_SAMPLES_BYTES * (PIOS_MPU6000_BLOCK_SAMPLES + 1)) {
+        // the rest is left in the FIFO for the next block
+        mpu6000_fifo_backup++;
+    }
+    mpu6000_transfer_size = 1 + count * PIOS_MPU6000_SAMPLES_BYTES;
+
+    if (PIOS_MPU6000_ClaimBusISR(woken, true) != 0) {
+        return false;
+    }
+    if (PIOS_SPI_TransferBlock(dev->spi_id, &mpu6000_burst_send_buf[0], &mpu6000_burst_buf[0], mpu6000_transfer_size, NULL) < 0) {
+        PIOS_MPU6000_ReleaseBusISR(woken);
+        mpu6000_fails++;
+        return false;
+    }
+    PIOS_MPU6000_ReleaseBusISR(woken);
+
+    // the last byte of a record takes the place of the dummy byte of the next one
+    for (uint8_t i = 0; i < count; i++) {
+        PIOS_MPU6000_DecodeSample((const mpu6000_data_t *)&mpu6000_burst_buf[i * PIOS_MPU6000_SAMPLES_BYTES], &mpu6000_block.samples[i]);
+    }
+    mpu6000_block.timestamp = timestamp;
+    mpu6000_block.sample_period_us = dev->sample_period_us;
+    mpu6000_block.count     = count;
+
+    BaseType_t higherPriorityTaskWoken;
+    xQueueSendToBackFromISR(dev->block_queue, (void *)&mpu6000_block, &higherPriorityTaskWoken);
+    return higherPriorityTaskWoken == pdTRUE;
+}
 #endif /* PIOS_INCLUDE_MPU6000 */
 
 /**
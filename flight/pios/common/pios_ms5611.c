@@ -52,9 +52,23 @@ static int64_t Temperature;
 static int32_t lastConversionStart;
 static int32_t PIOS_MS5611_Read(uint8_t address, uint8_t *buffer, uint8_t len);
 static int32_t PIOS_MS5611_WriteCommand(uint8_t command);
+static void PIOS_MS5611_Compensate(ConversionTypeTypeDef Type, const uint8_t *Data);
 
 // Second order temperature compensation. Temperature offset
 static int64_t compensation_t2;
+// Difference between actual and reference temperature
+static int64_t deltaTemp;
+
+// Conversion requests, the conversion started by a request is read by the next one
+static bool converting = false;
+static bool request_read;
+static ConversionTypeTypeDef request_read_type;
+static int32_t request_read_status;
+static ConversionTypeTypeDef request_start_type;
+static pios_ms5611_request_callback request_callback;
+static uint8_t request_read_command = MS5611_ADC_READ;
+static uint8_t request_data[3];
+static uint8_t request_start_command;
 
 // Move into proper driver structure with cfg stored
 static uint32_t oversampling;
@@ -91,22 +105,17 @@ void PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, int32_t i2c_device)
 /**
  * Start the ADC conversion
  * \param[in] PresOrTemp BMP085_PRES_ADDR or BMP085_TEMP_ADDR
- * \return 0 for success, -1 for failure (conversion completed and not read)
+ * \return 0 for success, -1 for failure (I2C error, the conversion was not started)
  */
 int32_t PIOS_MS5611_StartADC(ConversionTypeTypeDef Type)
 {
     /* Start the conversion */
-    if (Type == TemperatureConv) {
-        while (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + oversampling) != 0) {
-            continue;
-        }
-    } else if (Type == PressureConv) {
-        while (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + oversampling) != 0) {
-            continue;
-        }
+    if (PIOS_MS5611_WriteCommand((Type == TemperatureConv ? MS5611_TEMP_ADDR : MS5611_PRES_ADDR) + oversampling) != 0) {
+        return -1;
     }
     lastConversionStart = PIOS_DELAY_GetRaw();
     CurrentRead = Type;
+    converting  = true;
 
     return 0;
 }
@@ -167,7 +176,9 @@ uint32_t PIOS_MS5611_GetDelayUs()
 
 /**
  * Read the ADC conversion value (once ADC conversion has completed)
- * \return 0 if successfully read the ADC, -1 if failed
+ * Does not wait for the conversion, PIOS_MS5611_GetDelay() after the start
+ * of the conversion it is completed.
+ * \return 0 if successfully read the ADC, -1 if failed, -2 if the conversion is not completed yet
  */
 int32_t PIOS_MS5611_ReadADC(void)
 {
@@ -177,18 +188,28 @@ int32_t PIOS_MS5611_ReadADC(void)
     Data[1] = 0;
     Data[2] = 0;
 
-    while (PIOS_MS5611_GetDelayUs() > PIOS_DELAY_DiffuS(lastConversionStart)) {
-        vTaskDelay(0);
+    if (PIOS_MS5611_GetDelayUs() > PIOS_DELAY_DiffuS(lastConversionStart)) {
+        return -2;
     }
-    static int64_t deltaTemp;
 
-    /* Read and store the 16bit result */
-    if (CurrentRead == TemperatureConv) {
-        /* Read the temperature conversion */
-        if (PIOS_MS5611_Read(MS5611_ADC_READ, Data, 3) != 0) {
-            return -1;
-        }
+    /* Read the conversion */
+    if (PIOS_MS5611_Read(MS5611_ADC_READ, Data, 3) != 0) {
+        return -1;
+    }
+    converting = false;
 
+    PIOS_MS5611_Compensate(CurrentRead, Data);
+    return 0;
+}
+
+/**
+ * Computes the temperature or the compensated pressure from a conversion
+ * \param[in] Type type of the conversion
+ * \param[in] Data the 3 bytes of the conversion
+ */
+static void PIOS_MS5611_Compensate(ConversionTypeTypeDef Type, const uint8_t *Data)
+{
+    if (Type == TemperatureConv) {
         RawTemperature = (Data[0] << 16) | (Data[1] << 8) | Data[2];
         // Difference between actual and reference temperature
         // dT = D2 - TREF = D2 - C5 * 2^8
@@ -203,10 +224,6 @@ int32_t PIOS_MS5611_ReadADC(void)
         int64_t Offset2 = 0;
         int64_t Sens2   = 0;
 
-        /* Read the pressure conversion */
-        if (PIOS_MS5611_Read(MS5611_ADC_READ, Data, 3) != 0) {
-            return -1;
-        }
         // check if temperature is less than 20°C
         if (Temperature < 2000) {
             // Apply compensation
@@ -242,7 +259,6 @@ int32_t PIOS_MS5611_ReadADC(void)
         // P = D1 * SENS - OFF = (D1 * SENS / 2^21 - OFF) / 2^15
         Pressure = (((((int64_t)RawPressure) * Sens) / POW2(21)) - Offset) / POW2(15);
     }
-    return 0;
 }
 
 /**
@@ -262,6 +278,132 @@ float PIOS_MS5611_GetPressure(void)
     return ((float)Pressure) / 1000.0f;
 }
 
+/**
+ * End of a conversion request, the next conversion is started
+ * \param[in] status 0 if the conversion is started
+ * \param[in,out] woken passed to the request callback
+ */
+static void PIOS_MS5611_RequestStarted(int32_t status, bool *woken)
+{
+    if (status == 0) {
+        lastConversionStart = PIOS_DELAY_GetRaw();
+        CurrentRead = request_start_type;
+        converting  = true;
+    }
+    request_callback(request_read && request_read_status != 0 ? request_read_status : status, woken);
+}
+
+#if defined(PIOS_I2C_HAS_REQUESTS)
+static void PIOS_MS5611_ReadDone(__attribute__((unused)) struct pios_i2c_request *request, int32_t status, __attribute__((unused)) bool *woken)
+{
+    request_read_status = status;
+}
+
+static void PIOS_MS5611_StartDone(__attribute__((unused)) struct pios_i2c_request *request, int32_t status, bool *woken)
+{
+    PIOS_MS5611_RequestStarted(status, woken);
+}
+
+static const struct pios_i2c_txn request_read_txns[] = {
+    {
+        .info = "PIOS_MS5611_RequestADC",
+        .addr = MS5611_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_WRITE,
+        .len  = 1,
+        .buf  = &request_read_command,
+    },
+    {
+        .info = "PIOS_MS5611_RequestADC",
+        .addr = MS5611_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_READ,
+        .len  = sizeof(request_data),
+        .buf  = request_data,
+    },
+};
+
+static const struct pios_i2c_txn request_start_txns[] = {
+    {
+        .info = "PIOS_MS5611_RequestADC",
+        .addr = MS5611_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_WRITE,
+        .len  = 1,
+        .buf  = &request_start_command,
+    },
+};
+
+static struct pios_i2c_request request_read_request = {
+    .txn_list = request_read_txns,
+    .num_txns = NELEMENTS(request_read_txns),
+    .callback = PIOS_MS5611_ReadDone,
+};
+
+static struct pios_i2c_request request_start_request = {
+    .txn_list = request_start_txns,
+    .num_txns = NELEMENTS(request_start_txns),
+    .callback = PIOS_MS5611_StartDone,
+};
+#endif /* PIOS_I2C_HAS_REQUESTS */
+
+/**
+ * Reads the running conversion, if any, and starts the next one. With the
+ * asynchronous I2C requests the function returns at once and the transfers
+ * complete in the background, otherwise they are done before returning.
+ * \param[in] Type type of the next conversion
+ * \param[in] callback called once the next conversion is started, from the
+ * I2C interrupt with the asynchronous requests. Its status is 0 on success;
+ * -1 if the read or the start of the conversion failed. Its woken argument is
+ * NULL when the callback is not called from an interrupt.
+ * \return 0 if the request is queued, -1 if failed, -2 if the running conversion is not completed yet
+ */
+int32_t PIOS_MS5611_RequestADC(ConversionTypeTypeDef Type, pios_ms5611_request_callback callback)
+{
+    if (converting && PIOS_MS5611_GetDelayUs() > PIOS_DELAY_DiffuS(lastConversionStart)) {
+        return -2;
+    }
+
+    request_read = converting;
+    request_read_type   = CurrentRead;
+    request_read_status = 0;
+    request_start_type  = Type;
+    request_start_command = (Type == TemperatureConv ? MS5611_TEMP_ADDR : MS5611_PRES_ADDR) + oversampling;
+    request_callback    = callback;
+    converting = false;
+
+#if defined(PIOS_I2C_HAS_REQUESTS)
+    if (request_read && PIOS_I2C_Submit(i2c_id, &request_read_request, NULL) != 0) {
+        return -1;
+    }
+    if (PIOS_I2C_Submit(i2c_id, &request_start_request, NULL) != 0) {
+        return -1;
+    }
+#else
+    if (request_read) {
+        request_read_status = PIOS_MS5611_Read(request_read_command, request_data, sizeof(request_data));
+    }
+    PIOS_MS5611_RequestStarted(PIOS_MS5611_WriteCommand(request_start_command), NULL);
+#endif
+    return 0;
+}
+
+/**
+ * Computes the conversion read by the last request, once its callback is called
+ * \param[out] Type type of the conversion read
+ * \return 0 if the conversion is computed, -1 if it could not be read, -2 if the request did not read a conversion
+ */
+int32_t PIOS_MS5611_ReadRequestedADC(ConversionTypeTypeDef *Type)
+{
+    if (!request_read) {
+        return -2;
+    }
+    *Type = request_read_type;
+    if (request_read_status != 0) {
+        return -1;
+    }
+
+    PIOS_MS5611_Compensate(request_read_type, request_data);
+    return 0;
+}
+
 /**
  * Reads one or more bytes into a buffer
  * \param[in] the command indicating the address to read
@@ -327,7 +469,7 @@ int32_t PIOS_MS5611_Test()
 
     cur_value = Temperature;
     PIOS_MS5611_StartADC(TemperatureConv);
-    PIOS_DELAY_WaitmS(5);
+    PIOS_DELAY_WaituS(PIOS_MS5611_GetDelayUs());
     PIOS_MS5611_ReadADC();
     if (cur_value == Temperature) {
         return -1;
@@ -335,7 +477,7 @@ int32_t PIOS_MS5611_Test()
 
     cur_value = Pressure;
     PIOS_MS5611_StartADC(PressureConv);
-    PIOS_DELAY_WaitmS(26);
+    PIOS_DELAY_WaituS(PIOS_MS5611_GetDelayUs());
     PIOS_MS5611_ReadADC();
     if (cur_value == Pressure) {
         return -1;
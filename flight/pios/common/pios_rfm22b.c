@@ -76,6 +76,25 @@
 #define RFM22B_DEFAULT_CHANNEL_SET       24
 #define RFM22B_PPM_ONLY_DATARATE         RFM22_datarate_9600
 
+// Adaptive datarate: the link control header in front of the data packets
+#define RFM22B_LINK_CONTROL_LEN          3
+#define RFM22B_RATE_EVAL_PERIOD_MS       1000
+// Both modems fall back to the lowest datarate when the link is lost for that long
+#define RFM22B_RATE_LINK_LOST_MS         2000
+// Link quality (0 - 128) thresholds to step down / up
+#define RFM22B_RATE_DOWN_QUALITY         96
+#define RFM22B_RATE_UP_QUALITY           120
+// Minimum RSSI to step up, a faster datarate needs more signal
+#define RFM22B_RATE_UP_RSSI              -85 // dBm
+// Good evaluations before stepping up, doubled by each step down
+#define RFM22B_RATE_UP_PERIODS           5
+#define RFM22B_RATE_MAX_BACKOFF          3
+// Channel loss (0 - 255) thresholds to stop / resume sending data on a channel
+#define RFM22B_CHANNEL_LOSS_BAD          64
+#define RFM22B_CHANNEL_LOSS_GOOD         32
+// The sync channel and the first remote slot are always used, they carry the link control
+#define RFM22B_CONTROL_CHANNELS          0x0003
+
 // The maximum amount of time without activity before initiating a reset.
 #define PIOS_RFM22B_SUPERVISOR_TIMEOUT   150  // ms
 
@@ -96,6 +115,10 @@
 
 #define RX_FIFO_HI_WATERMARK             32 // 0-63
 
+// FIFO bursts at least this long are moved by DMA while the radio task sleeps
+#define SPI_DMA_MIN_LEN                  16
+#define SPI_DMA_TIMEOUT_MS               5
+
 // preamble byte (preceeds SYNC_BYTE's)
 #define PREAMBLE_BYTE                    0x55
 
@@ -203,6 +226,12 @@ static uint8_t rfm22_calcChannel(struct pios_rfm22b_dev *rfm22b_dev, uint8_t ind
 static uint8_t rfm22_calcChannelFromClock(struct pios_rfm22b_dev *rfm22b_dev);
 static bool rfm22_changeChannel(struct pios_rfm22b_dev *rfm22b_dev);
 static void rfm22_clearLEDs();
+static void rfm22_setPacketTiming(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_adaptDatarate(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_evaluateDatarate(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_switchDatarate(struct pios_rfm22b_dev *rfm22b_dev, uint8_t datarate);
+static void rfm22_receiveLinkControl(struct pios_rfm22b_dev *rfm22b_dev, const uint8_t *p);
+static void rfm22_updateChannelLoss(struct pios_rfm22b_dev *rfm22b_dev, bool error);
 
 // Utility functions.
 static uint32_t pios_rfm22_time_difference_ms(portTickType start_time, portTickType end_time);
@@ -216,6 +245,9 @@ static void rfm22_releaseBus(struct pios_rfm22b_dev *rfm22b_dev);
 static void rfm22_write_claim(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, uint8_t data);
 static void rfm22_write(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, uint8_t data);
 static uint8_t rfm22_read(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr);
+static int32_t rfm22_burstRead(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, uint8_t *data, uint16_t len);
+static int32_t rfm22_burstWrite(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, const uint8_t *data, uint16_t len);
+static void rfm22_burstDone(bool crc_ok, uint8_t crc_val);
 
 
 /* The state transition table */
@@ -397,6 +429,7 @@ int32_t PIOS_RFM22B_Init(uint32_t *rfm22b_id, uint32_t spi_id, uint32_t slave_nu
     rfm22b_dev->tx_power      = RFM22B_DEFAULT_TX_POWER;
     rfm22b_dev->coordinator   = false;
     rfm22b_dev->coordinatorID = 0;
+    rfm22b_dev->adaptive_datarate = false;
 
     // Initialize the com callbacks.
     rfm22b_dev->rx_in_cb      = NULL;
@@ -434,6 +467,10 @@ int32_t PIOS_RFM22B_Init(uint32_t *rfm22b_id, uint32_t spi_id, uint32_t slave_nu
     // Create a semaphore to know if an ISR needs responding to
     vSemaphoreCreateBinary(rfm22b_dev->isrPending);
 
+    // Create a semaphore signalled at the end of the DMA burst transfers, initially taken
+    vSemaphoreCreateBinary(rfm22b_dev->burstDone);
+    xSemaphoreTake(rfm22b_dev->burstDone, 0);
+
     // Create our (hopefully) unique 32 bit id from the processor serial number.
     uint8_t crcs[] = { 0, 0, 0, 0 };
     {
@@ -594,25 +631,70 @@ void PIOS_RFM22B_SetChannelConfig(uint32_t rfm22b_id, enum rfm22b_datarate datar
         rfm22b_dev->one_way_link = oneway;
         rfm22b_dev->datarate     = datarate;
     }
-    rfm22b_dev->packet_time = (ppm_mode ? packet_time_ppm[datarate] : packet_time[datarate]);
+    rfm22b_dev->adaptive_datarate = false;
+    rfm22_setPacketTiming(rfm22b_dev);
 
     // Find the first N channels that meet the min/max criteria out of the random channel list.
+    // The lower datarates hop on the first channels of the list, list enough of them for any datarate.
     uint8_t num_found = 0;
-    for (uint16_t i = 0; (i < RFM22B_NUM_CHANNELS) && (num_found < num_channels[datarate]); ++i) {
+    for (uint16_t i = 0; (i < RFM22B_NUM_CHANNELS) && (num_found < RFM22B_MAX_HOP_CHANNELS); ++i) {
         uint8_t idx  = (i + chan_set) % RFM22B_NUM_CHANNELS;
         uint8_t chan = channel_list[idx];
         if ((chan >= min_chan) && (chan <= max_chan)) {
             rfm22b_dev->channels[num_found++] = chan;
         }
     }
+}
 
-    // Calculate the maximum packet length from the datarate.
-    float bytes_per_period = (float)data_rate[datarate] * (float)(rfm22b_dev->packet_time - 2) / 9000;
+/**
+ * Let the modems step the datarate with the link quality, between the lowest datarate and
+ * the one set by PIOS_RFM22B_SetChannelConfig(), which must be called first.
+ * The coordinator proposes the datarate, the remote acknowledges it. Both modems must be
+ * configured alike, one way and PPM only links keep a fixed datarate.
+ *
+ * @param[in] rfm22b_id The RFM22B device index.
+ * @param[in] adaptive Adapt the datarate?
+ */
+void PIOS_RFM22B_SetAdaptiveDatarate(uint32_t rfm22b_id, bool adaptive)
+{
+    struct pios_rfm22b_dev *rfm22b_dev = (struct pios_rfm22b_dev *)rfm22b_id;
 
-    rfm22b_dev->max_packet_len = bytes_per_period - TX_PREAMBLE_NIBBLES / 2 - SYNC_BYTES - HEADER_BYTES - LENGTH_BYTES;
-    if (rfm22b_dev->max_packet_len > RFM22B_MAX_PACKET_LEN) {
-        rfm22b_dev->max_packet_len = RFM22B_MAX_PACKET_LEN;
+    if (!PIOS_RFM22B_Validate(rfm22b_dev) || rfm22b_dev->adaptive_datarate == adaptive) {
+        return;
     }
+    if (!adaptive) {
+        rfm22b_dev->adaptive_datarate = false;
+        rfm22b_dev->datarate = rfm22b_dev->max_datarate;
+        rfm22_setPacketTiming(rfm22b_dev);
+        return;
+    }
+    if (rfm22b_dev->one_way_link || rfm22b_dev->ppm_only_mode) {
+        return;
+    }
+
+    // PPM packets do not fit the lowest datarate
+    bool ppm_mode = rfm22b_dev->ppm_send_mode || rfm22b_dev->ppm_recv_mode;
+    rfm22b_dev->max_datarate = rfm22b_dev->datarate;
+    rfm22b_dev->min_datarate = ppm_mode ? RFM22_datarate_19200 : RFM22_datarate_9600;
+    if (rfm22b_dev->min_datarate > rfm22b_dev->max_datarate) {
+        rfm22b_dev->min_datarate = rfm22b_dev->max_datarate;
+    }
+
+    // Both modems start on the lowest datarate
+    rfm22b_dev->datarate          = rfm22b_dev->min_datarate;
+    rfm22b_dev->link_datarate     = rfm22b_dev->min_datarate;
+    rfm22b_dev->next_datarate     = rfm22b_dev->min_datarate;
+    rfm22b_dev->peer_quality      = 0;
+    rfm22b_dev->bad_channels      = 0;
+    rfm22b_dev->peer_bad_channels = 0;
+    memset(rfm22b_dev->channel_loss, 0, sizeof(rfm22b_dev->channel_loss));
+    rfm22b_dev->rate_good_periods    = 0;
+    rfm22b_dev->rate_pending_periods = 0;
+    rfm22b_dev->rate_backoff    = 0;
+    rfm22b_dev->rate_eval_ticks = xTaskGetTickCount();
+    rfm22b_dev->peer_ticks      = rfm22b_dev->rate_eval_ticks;
+    rfm22_setPacketTiming(rfm22b_dev);
+    rfm22b_dev->adaptive_datarate = true;
 }
 
 /**
@@ -662,6 +744,8 @@ void PIOS_RFM22B_GetStats(uint32_t rfm22b_id, struct rfm22b_stats *stats)
     // Calculate the current link quality
     rfm22_calculateLinkQuality(rfm22b_dev);
 
+    rfm22b_dev->stats.air_datarate = data_rate[rfm22b_dev->datarate];
+
     // Return the stats.
     *stats = rfm22b_dev->stats;
 }
@@ -808,10 +892,8 @@ bool PIOS_RFM22B_TransmitPacket(uint32_t rfm22b_id, uint8_t *p, uint8_t len)
 
     // Set the destination address in the transmit header.
     uint32_t id = rfm22_destinationID(rfm22b_dev);
-    rfm22_write(rfm22b_dev, RFM22_transmit_header0, id & 0xff);
-    rfm22_write(rfm22b_dev, RFM22_transmit_header1, (id >> 8) & 0xff);
-    rfm22_write(rfm22b_dev, RFM22_transmit_header2, (id >> 16) & 0xff);
-    rfm22_write(rfm22b_dev, RFM22_transmit_header3, (id >> 24) & 0xff);
+    uint8_t header[HEADER_BYTES] = { (id >> 24) & 0xff, (id >> 16) & 0xff, (id >> 8) & 0xff, id & 0xff };
+    rfm22_burstWrite(rfm22b_dev, RFM22_transmit_header3, header, sizeof(header));
 
     // FIFO mode, GFSK modulation
     uint8_t fd_bit = rfm22_read(rfm22b_dev, RFM22_modulation_mode_control2) & RFM22_mmc2_fd;
@@ -826,13 +908,10 @@ bool PIOS_RFM22B_TransmitPacket(uint32_t rfm22b_id, uint8_t *p, uint8_t len)
 
     // Add some data to the chips TX FIFO before enabling the transmitter
     uint8_t *tx_buffer = rfm22b_dev->tx_packet_handle;
-    rfm22_assertCs(rfm22b_dev);
-    PIOS_SPI_TransferByte(rfm22b_dev->spi_id, RFM22_fifo_access | 0x80);
     int bytes_to_write = (rfm22b_dev->tx_data_wr - rfm22b_dev->tx_data_rd);
     bytes_to_write = (bytes_to_write > FIFO_SIZE) ? FIFO_SIZE : bytes_to_write;
-    PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, &tx_buffer[rfm22b_dev->tx_data_rd], NULL, bytes_to_write, NULL);
+    rfm22_burstWrite(rfm22b_dev, RFM22_fifo_access, &tx_buffer[rfm22b_dev->tx_data_rd], bytes_to_write);
     rfm22b_dev->tx_data_rd += bytes_to_write;
-    rfm22_deassertCs(rfm22b_dev);
 
     // Enable TX interrupts.
     rfm22_write(rfm22b_dev, RFM22_interrupt_enable1, RFM22_ie1_enpksent | RFM22_ie1_entxffaem);
@@ -879,15 +958,12 @@ pios_rfm22b_int_result PIOS_RFM22B_ProcessTx(uint32_t rfm22b_id)
         // Add data to the TX FIFO buffer
         uint8_t *tx_buffer = rfm22b_dev->tx_packet_handle;
         uint16_t max_bytes = FIFO_SIZE - TX_FIFO_LO_WATERMARK - 1;
-        rfm22_claimBus(rfm22b_dev);
-        rfm22_assertCs(rfm22b_dev);
-        PIOS_SPI_TransferByte(rfm22b_dev->spi_id, RFM22_fifo_access | 0x80);
         int bytes_to_write = (rfm22b_dev->tx_data_wr - rfm22b_dev->tx_data_rd);
         bytes_to_write = (bytes_to_write > max_bytes) ? max_bytes : bytes_to_write;
-        PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, &tx_buffer[rfm22b_dev->tx_data_rd], NULL, bytes_to_write, NULL);
-        rfm22b_dev->tx_data_rd += bytes_to_write;
-        rfm22_deassertCs(rfm22b_dev);
+        rfm22_claimBus(rfm22b_dev);
+        rfm22_burstWrite(rfm22b_dev, RFM22_fifo_access, &tx_buffer[rfm22b_dev->tx_data_rd], bytes_to_write);
         rfm22_releaseBus(rfm22b_dev);
+        rfm22b_dev->tx_data_rd += bytes_to_write;
 
         return PIOS_RFM22B_INT_SUCCESS;
     } else if (rfm22b_dev->status_regs.int_status_1.packet_sent_interrupt) {
@@ -947,18 +1023,14 @@ pios_rfm22b_int_result PIOS_RFM22B_ProcessRx(uint32_t rfm22b_id)
         if (rfm22b_dev->rx_buffer_wr < len) {
             int32_t bytes_to_read = len - rfm22b_dev->rx_buffer_wr;
             // Fetch the data from the RX FIFO
-            rfm22_assertCs(rfm22b_dev);
-            PIOS_SPI_TransferByte(rfm22b_dev->spi_id, RFM22_fifo_access & 0x7F);
-            rfm22b_dev->rx_buffer_wr += (PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, OUT_FF, (uint8_t *)&rx_buffer[rfm22b_dev->rx_buffer_wr],
-                                                                bytes_to_read, NULL) == 0) ? bytes_to_read : 0;
-            rfm22_deassertCs(rfm22b_dev);
+            rfm22b_dev->rx_buffer_wr += (rfm22_burstRead(rfm22b_dev, RFM22_fifo_access, (uint8_t *)&rx_buffer[rfm22b_dev->rx_buffer_wr],
+                                                         bytes_to_read) == 0) ? bytes_to_read : 0;
         }
 
-        // Read the packet header (destination ID)
-        rfm22b_dev->rx_destination_id  = rfm22_read(rfm22b_dev, RFM22_received_header0);
-        rfm22b_dev->rx_destination_id |= (rfm22_read(rfm22b_dev, RFM22_received_header1) << 8);
-        rfm22b_dev->rx_destination_id |= (rfm22_read(rfm22b_dev, RFM22_received_header2) << 16);
-        rfm22b_dev->rx_destination_id |= (rfm22_read(rfm22b_dev, RFM22_received_header3) << 24);
+        // Read the packet header (destination ID), most significant byte first
+        uint8_t header[HEADER_BYTES];
+        rfm22_burstRead(rfm22b_dev, RFM22_received_header3, header, sizeof(header));
+        rfm22b_dev->rx_destination_id = ((uint32_t)header[0] << 24) | ((uint32_t)header[1] << 16) | ((uint32_t)header[2] << 8) | header[3];
 
         // Release the SPI bus.
         rfm22_releaseBus(rfm22b_dev);
@@ -1004,11 +1076,8 @@ pios_rfm22b_int_result PIOS_RFM22B_ProcessRx(uint32_t rfm22b_id)
         }
 
         // Fetch the data from the RX FIFO
-        rfm22_assertCs(rfm22b_dev);
-        PIOS_SPI_TransferByte(rfm22b_dev->spi_id, RFM22_fifo_access & 0x7F);
-        rfm22b_dev->rx_buffer_wr += (PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, OUT_FF, (uint8_t *)&rx_buffer[rfm22b_dev->rx_buffer_wr],
-                                                            RX_FIFO_HI_WATERMARK, NULL) == 0) ? RX_FIFO_HI_WATERMARK : 0;
-        rfm22_deassertCs(rfm22b_dev);
+        rfm22b_dev->rx_buffer_wr += (rfm22_burstRead(rfm22b_dev, RFM22_fifo_access, (uint8_t *)&rx_buffer[rfm22b_dev->rx_buffer_wr],
+                                                     RX_FIFO_HI_WATERMARK) == 0) ? RX_FIFO_HI_WATERMARK : 0;
 
         // Release the SPI bus.
         rfm22_releaseBus(rfm22b_dev);
@@ -1182,6 +1251,11 @@ static void pios_rfm22_task(void *parameters)
             }
         }
 
+        // Adapt the datarate to the link.
+        if (rfm22b_dev->adaptive_datarate) {
+            rfm22_adaptDatarate(rfm22b_dev);
+        }
+
         // Change channels if necessary.
         if (rfm22_changeChannel(rfm22b_dev)) {
             rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
@@ -1690,19 +1764,14 @@ static bool rfm22_setFreqHopChannel(struct pios_rfm22b_dev *rfm22b_dev, uint8_t
  */
 static bool pios_rfm22_readStatus(struct pios_rfm22b_dev *rfm22b_dev)
 {
-    // 1. Read the interrupt statuses with burst read
+    // 1. Read the device and interrupt statuses, they are consecutive registers
     rfm22_claimBus(rfm22b_dev); // Set RC and the semaphore
-    uint8_t write_buf[3] = { RFM22_interrupt_status1 &0x7f, 0xFF, 0xFF };
     uint8_t read_buf[3];
-    rfm22_assertCs(rfm22b_dev);
-    PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, write_buf, read_buf, sizeof(write_buf), NULL);
-    rfm22_deassertCs(rfm22b_dev);
+    rfm22_burstRead(rfm22b_dev, RFM22_device_status, read_buf, sizeof(read_buf));
+    rfm22b_dev->status_regs.device_status.raw = read_buf[0];
     rfm22b_dev->status_regs.int_status_1.raw  = read_buf[1];
     rfm22b_dev->status_regs.int_status_2.raw  = read_buf[2];
 
-    // Device status
-    rfm22b_dev->status_regs.device_status.raw = rfm22_read(rfm22b_dev, RFM22_device_status);
-
     // EzMAC status
     rfm22b_dev->status_regs.ezmac_status.raw  = rfm22_read(rfm22b_dev, RFM22_ezmac_status);
 
@@ -1758,9 +1827,21 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev *radio_dev)
         return RADIO_EVENT_RX_MODE;
     }
 
+    // The link control header: datarate and link quality, then the channels we receive badly.
+    uint8_t control_len = 0;
+    if (radio_dev->adaptive_datarate) {
+        uint8_t quality = radio_dev->stats.link_quality / 8;
+        p[0] = (radio_dev->link_datarate & 0x0F) | ((quality > 15 ? 15 : quality) << 4);
+        p[1] = radio_dev->bad_channels & 0xFF;
+        p[2] = radio_dev->bad_channels >> 8;
+        control_len = RFM22B_LINK_CONTROL_LEN;
+        len = control_len;
+    }
+
     // Should we append PPM data to the packet?
     if (radio_dev->ppm_send_mode) {
-        len = RFM22B_PPM_NUM_CHANNELS + (radio_dev->ppm_only_mode ? 2 : 1);
+        uint8_t *ppm = p + len;
+        len += RFM22B_PPM_NUM_CHANNELS + (radio_dev->ppm_only_mode ? 2 : 1);
 
         // Ensure we can fit the PPM data in the packet.
         if (max_data_len < len) {
@@ -1768,16 +1849,16 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev *radio_dev)
         }
 
         // The first byte is a bitmask of valid channels.
-        p[0] = 0;
+        ppm[0] = 0;
 
         // Read the PPM input.
         for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS; ++i) {
             int32_t val = radio_dev->ppm[i];
             if ((val == PIOS_RCVR_INVALID) || (val == PIOS_RCVR_TIMEOUT)) {
-                p[i + 1] = 0;
+                ppm[i + 1] = 0;
             } else {
-                p[0]    |= 1 << i;
-                p[i + 1] = (val < 1000) ? 0 : ((val >= 1900) ? 255 : (uint8_t)(256 * (val - 1000) / 900));
+                ppm[0]    |= 1 << i;
+                ppm[i + 1] = (val < 1000) ? 0 : ((val >= 1900) ? 255 : (uint8_t)(256 * (val - 1000) / 900));
             }
         }
 
@@ -1785,21 +1866,25 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev *radio_dev)
         if (radio_dev->ppm_only_mode) {
             uint8_t crc = 0;
             for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS + 1; ++i) {
-                crc = PIOS_CRC_updateByte(crc, p[i]);
+                crc = PIOS_CRC_updateByte(crc, ppm[i]);
             }
-            p[RFM22B_PPM_NUM_CHANNELS + 1] = crc;
+            ppm[RFM22B_PPM_NUM_CHANNELS + 1] = crc;
         }
     }
 
-    // Append data from the com interface if applicable.
-    if (!radio_dev->ppm_only_mode && radio_dev->tx_out_cb) {
+    // Append data from the com interface if applicable, the data waits for the next channel if the other modem receives this one badly.
+    bool bad_channel = radio_dev->adaptive_datarate && (radio_dev->peer_bad_channels & (1 << radio_dev->channel_index));
+    if (!radio_dev->ppm_only_mode && radio_dev->tx_out_cb && !bad_channel) {
         // Try to get some data to send
         bool need_yield = false;
         len += (radio_dev->tx_out_cb)(radio_dev->tx_out_context, p + len, max_data_len - len, NULL, &need_yield);
     }
 
     // Always send a packet on the sync channel if this modem is a coordinator.
-    if ((len == 0) && ((radio_dev->channel_index != 0) || !rfm22_isCoordinator(radio_dev))) {
+    // With an adaptive datarate the remote also always sends on its first channel to report the link.
+    bool control_slot = rfm22_isCoordinator(radio_dev) ? (radio_dev->channel_index == 0) :
+                        (radio_dev->adaptive_datarate && (radio_dev->channel_index == 1));
+    if ((len == control_len) && !control_slot) {
         return RADIO_EVENT_RX_MODE;
     }
 
@@ -1898,6 +1983,16 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev *radio_d
         }
     }
 
+    // Track the receive errors per channel, and pull the link control header off of the head of the packet.
+    if (radio_dev->adaptive_datarate) {
+        rfm22_updateChannelLoss(radio_dev, !good_packet && !corrected_packet);
+        if ((good_packet || corrected_packet) && (data_len >= RFM22B_LINK_CONTROL_LEN)) {
+            rfm22_receiveLinkControl(radio_dev, p);
+            p += RFM22B_LINK_CONTROL_LEN;
+            data_len -= RFM22B_LINK_CONTROL_LEN;
+        }
+    }
+
     // Should we pull PPM data off of the head of the packet?
     if ((good_packet || corrected_packet) && radio_dev->ppm_recv_mode) {
         uint8_t ppm_len = RFM22B_PPM_NUM_CHANNELS + (radio_dev->ppm_only_mode ? 2 : 1);
@@ -2145,6 +2240,204 @@ uint32_t rfm22_destinationID(struct pios_rfm22b_dev *rfm22b_dev)
 }
 
 
+/*****************************************************************************
+* Adaptive Datarate Functions
+*****************************************************************************/
+
+/**
+ * Set the packet time and the maximum packet length for the current datarate.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_setPacketTiming(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    bool ppm_mode = rfm22b_dev->ppm_send_mode || rfm22b_dev->ppm_recv_mode;
+    enum rfm22b_datarate datarate = rfm22b_dev->datarate;
+
+    rfm22b_dev->packet_time = (ppm_mode ? packet_time_ppm[datarate] : packet_time[datarate]);
+
+    // Calculate the maximum packet length from the datarate.
+    float bytes_per_period = (float)data_rate[datarate] * (float)(rfm22b_dev->packet_time - 2) / 9000;
+
+    rfm22b_dev->max_packet_len = bytes_per_period - TX_PREAMBLE_NIBBLES / 2 - SYNC_BYTES - HEADER_BYTES - LENGTH_BYTES;
+    if (rfm22b_dev->max_packet_len > RFM22B_MAX_PACKET_LEN) {
+        rfm22b_dev->max_packet_len = RFM22B_MAX_PACKET_LEN;
+    }
+}
+
+/**
+ * Evaluate the link periodically and switch the datarate between two packets once negotiated.
+ * The coordinator switches when the remote acknowledges its proposal, the remote switches
+ * when it loses the coordinator, which it then finds on the sync channel at the new datarate.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_adaptDatarate(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    if (pios_rfm22_time_difference_ms(rfm22b_dev->rate_eval_ticks, xTaskGetTickCount()) >= RFM22B_RATE_EVAL_PERIOD_MS) {
+        rfm22b_dev->rate_eval_ticks = xTaskGetTickCount();
+        rfm22_evaluateDatarate(rfm22b_dev);
+    }
+
+    if (!rfm22_isCoordinator(rfm22b_dev) && !rfm22_isConnected(rfm22b_dev)) {
+        rfm22b_dev->next_datarate = rfm22b_dev->link_datarate;
+    }
+    if ((rfm22b_dev->next_datarate != rfm22b_dev->datarate) && PIOS_RFM22B_InRxWait((uint32_t)rfm22b_dev)) {
+        rfm22_switchDatarate(rfm22b_dev, rfm22b_dev->next_datarate);
+        rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
+    }
+}
+
+/**
+ * Step the proposed datarate down when the link degrades, and up after it has been good
+ * with a signal margin for a while. Both modems fall back to the lowest datarate when
+ * the link is lost.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_evaluateDatarate(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    rfm22_calculateLinkQuality(rfm22b_dev);
+
+    // Bad channels get another chance after a while, no data is sent on them so their loss is not updated.
+    for (uint8_t i = 0; i < RFM22B_MAX_HOP_CHANNELS; ++i) {
+        if (rfm22b_dev->bad_channels & (1 << i)) {
+            rfm22b_dev->channel_loss[i] -= rfm22b_dev->channel_loss[i] >> 2;
+            if (rfm22b_dev->channel_loss[i] < RFM22B_CHANNEL_LOSS_GOOD) {
+                rfm22b_dev->bad_channels &= ~(1 << i);
+            }
+        }
+    }
+
+    bool link_lost = pios_rfm22_time_difference_ms(rfm22b_dev->peer_ticks, xTaskGetTickCount()) > RFM22B_RATE_LINK_LOST_MS;
+    if (link_lost) {
+        if (rfm22b_dev->datarate != rfm22b_dev->min_datarate) {
+            rfm22b_dev->link_datarate = rfm22b_dev->min_datarate;
+            rfm22b_dev->next_datarate = rfm22b_dev->min_datarate;
+        }
+        rfm22b_dev->rate_good_periods = 0;
+        return;
+    }
+    if (!rfm22_isCoordinator(rfm22b_dev)) {
+        return;
+    }
+
+    // Withdraw a proposal the remote does not acknowledge.
+    if (rfm22b_dev->link_datarate != rfm22b_dev->datarate) {
+        if (++rfm22b_dev->rate_pending_periods > RFM22B_RATE_UP_PERIODS) {
+            rfm22b_dev->link_datarate = rfm22b_dev->datarate;
+            rfm22b_dev->rate_pending_periods = 0;
+            if (rfm22b_dev->rate_backoff < RFM22B_RATE_MAX_BACKOFF) {
+                rfm22b_dev->rate_backoff++;
+            }
+        }
+        return;
+    }
+
+    // The link is as good as the worst direction.
+    uint8_t quality = rfm22b_dev->stats.link_quality;
+    if (rfm22b_dev->peer_quality < quality) {
+        quality = rfm22b_dev->peer_quality;
+    }
+
+    if ((quality < RFM22B_RATE_DOWN_QUALITY) && (rfm22b_dev->datarate > rfm22b_dev->min_datarate)) {
+        rfm22b_dev->link_datarate = rfm22b_dev->datarate - 1;
+        rfm22b_dev->rate_good_periods    = 0;
+        rfm22b_dev->rate_pending_periods = 0;
+        if (rfm22b_dev->rate_backoff < RFM22B_RATE_MAX_BACKOFF) {
+            rfm22b_dev->rate_backoff++;
+        }
+    } else if ((quality >= RFM22B_RATE_UP_QUALITY) && (rfm22b_dev->rssi_dBm >= RFM22B_RATE_UP_RSSI) &&
+               (rfm22b_dev->datarate < rfm22b_dev->max_datarate)) {
+        if (++rfm22b_dev->rate_good_periods >= (RFM22B_RATE_UP_PERIODS << rfm22b_dev->rate_backoff)) {
+            rfm22b_dev->link_datarate = rfm22b_dev->datarate + 1;
+            rfm22b_dev->rate_good_periods    = 0;
+            rfm22b_dev->rate_pending_periods = 0;
+        }
+    } else {
+        rfm22b_dev->rate_good_periods = 0;
+    }
+}
+
+/**
+ * Switch to a new datarate, the statistics of the previous datarate are dropped.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] datarate  The datarate to switch to.
+ */
+static void rfm22_switchDatarate(struct pios_rfm22b_dev *rfm22b_dev, uint8_t datarate)
+{
+    rfm22b_dev->datarate      = datarate;
+    rfm22b_dev->link_datarate = datarate;
+    rfm22b_dev->next_datarate = datarate;
+    rfm22_setPacketTiming(rfm22b_dev);
+    pios_rfm22_setDatarate(rfm22b_dev);
+
+    memset(rfm22b_dev->rx_packet_stats, 0, sizeof(rfm22b_dev->rx_packet_stats));
+    memset(rfm22b_dev->channel_loss, 0, sizeof(rfm22b_dev->channel_loss));
+    rfm22b_dev->bad_channels      = 0;
+    rfm22b_dev->peer_bad_channels = 0;
+    // until the other modem reports on the new datarate
+    rfm22b_dev->peer_quality      = 128;
+    rfm22b_dev->rate_good_periods = 0;
+    rfm22b_dev->rate_pending_periods = 0;
+    rfm22b_dev->peer_ticks = xTaskGetTickCount();
+}
+
+/**
+ * Process the link control header of a packet received from the other modem of the link.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] p  The link control header.
+ */
+static void rfm22_receiveLinkControl(struct pios_rfm22b_dev *rfm22b_dev, const uint8_t *p)
+{
+    if (rfm22b_dev->rx_destination_id != rfm22_destinationID(rfm22b_dev)) {
+        return;
+    }
+    uint8_t datarate = p[0] & 0x0F;
+    uint8_t quality  = p[0] >> 4;
+
+    rfm22b_dev->peer_ticks   = xTaskGetTickCount();
+    rfm22b_dev->peer_quality = (quality == 15) ? 128 : quality * 8;
+    rfm22b_dev->peer_bad_channels = (p[1] | (p[2] << 8)) & ~RFM22B_CONTROL_CHANNELS;
+
+    if (rfm22_isCoordinator(rfm22b_dev)) {
+        // The remote acknowledged our proposal
+        if ((datarate == rfm22b_dev->link_datarate) && (datarate != rfm22b_dev->datarate)) {
+            rfm22b_dev->next_datarate = datarate;
+        }
+    } else if ((datarate >= rfm22b_dev->min_datarate) && (datarate <= rfm22b_dev->max_datarate)) {
+        // Acknowledge the datarate proposed by the coordinator
+        rfm22b_dev->link_datarate = datarate;
+    }
+}
+
+/**
+ * Update the receive error rate of the current channel.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] error  Was the packet lost?
+ */
+static void rfm22_updateChannelLoss(struct pios_rfm22b_dev *rfm22b_dev, bool error)
+{
+    uint8_t idx = rfm22b_dev->channel_index;
+
+    if (idx >= RFM22B_MAX_HOP_CHANNELS) {
+        return;
+    }
+    // exponential average of the error rate over about 8 packets
+    uint16_t loss = rfm22b_dev->channel_loss[idx] - (rfm22b_dev->channel_loss[idx] >> 3) + (error ? 32 : 0);
+    rfm22b_dev->channel_loss[idx] = (loss > 255) ? 255 : loss;
+
+    if ((loss > RFM22B_CHANNEL_LOSS_BAD) && !(RFM22B_CONTROL_CHANNELS & (1 << idx))) {
+        rfm22b_dev->bad_channels |= 1 << idx;
+    } else if (loss < RFM22B_CHANNEL_LOSS_GOOD) {
+        rfm22b_dev->bad_channels &= ~(1 << idx);
+    }
+}
+
+
 /*****************************************************************************
 * Frequency Hopping Functions
 *****************************************************************************/
@@ -2553,6 +2846,79 @@ static uint8_t rfm22_read(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr)
     return in[1];
 }
 
+/**
+ * Transfer a burst of consecutive registers, or of FIFO bytes, under a single chip select
+ * without claiming the bus. The longer bursts go through DMA, the radio task sleeping
+ * until the transfer completes so that the CPU is free meanwhile.
+ *
+ * @param[in] rfm22b_dev  The RFM22B device structure pointer.
+ * @param[in] addr The address byte, with the write bit for writes
+ * @param[in] out The bytes to write, OUT_FF for reads
+ * @param[out] in The bytes read, NULL for writes
+ * @param[in] len The number of bytes to transfer
+ * @return 0 on success, negative on error
+ */
+static int32_t rfm22_burstTransfer(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, const uint8_t *out, uint8_t *in, uint16_t len)
+{
+    int32_t ret;
+
+    rfm22_assertCs(rfm22b_dev);
+    PIOS_SPI_TransferByte(rfm22b_dev->spi_id, addr);
+    if (len >= SPI_DMA_MIN_LEN) {
+        // Clear a completion left over by a transfer that timed out
+        xSemaphoreTake(rfm22b_dev->burstDone, 0);
+        ret = PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, out, in, len, (void *)rfm22_burstDone);
+        if ((ret >= 0) && (xSemaphoreTake(rfm22b_dev->burstDone, SPI_DMA_TIMEOUT_MS / portTICK_RATE_MS) != pdTRUE)) {
+            ret = -1;
+        }
+    } else {
+        ret = PIOS_SPI_TransferBlock(rfm22b_dev->spi_id, out, in, len, NULL);
+    }
+    rfm22_deassertCs(rfm22b_dev);
+    return (ret < 0) ? ret : 0;
+}
+
+/**
+ * Read consecutive registers, or the RX FIFO, without claiming the bus
+ *
+ * @param[in] rfm22b_dev  The RFM22B device structure pointer.
+ * @param[in] addr The address of the first register
+ * @param[out] data The bytes read
+ * @param[in] len The number of bytes to read, up to FIFO_SIZE
+ * @return 0 on success, negative on error
+ */
+static int32_t rfm22_burstRead(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, uint8_t *data, uint16_t len)
+{
+    return rfm22_burstTransfer(rfm22b_dev, addr & 0x7F, OUT_FF, data, len);
+}
+
+/**
+ * Write consecutive registers, or the TX FIFO, without claiming the bus
+ *
+ * @param[in] rfm22b_dev  The RFM22B device structure pointer.
+ * @param[in] addr The address of the first register
+ * @param[in] data The bytes to write
+ * @param[in] len The number of bytes to write
+ * @return 0 on success, negative on error
+ */
+static int32_t rfm22_burstWrite(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr, const uint8_t *data, uint16_t len)
+{
+    return rfm22_burstTransfer(rfm22b_dev, addr | 0x80, data, NULL, len);
+}
+
+/**
+ * The SPI DMA completion callback of the burst transfers, called from the DMA interrupt
+ */
+static void rfm22_burstDone(__attribute__((unused)) bool crc_ok, __attribute__((unused)) uint8_t crc_val)
+{
+    portBASE_TYPE pxHigherPriorityTaskWoken = pdFALSE;
+
+    if (PIOS_RFM22B_Validate(g_rfm22b_dev)) {
+        xSemaphoreGiveFromISR(g_rfm22b_dev->burstDone, &pxHigherPriorityTaskWoken);
+    }
+    portEND_SWITCHING_ISR(pxHigherPriorityTaskWoken == pdTRUE);
+}
+
 #endif /* PIOS_INCLUDE_RFM22B */
 
 /**
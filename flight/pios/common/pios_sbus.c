@@ -42,11 +42,17 @@ static uint16_t PIOS_SBus_RxInCallback(uint32_t context,
                                        uint16_t *headroom,
                                        bool *need_yield);
 static void PIOS_SBus_Supervisor(uint32_t sbus_id);
+#if defined(PIOS_INCLUDE_FREERTOS)
+static xSemaphoreHandle PIOS_SBus_Get_Semaphore(uint32_t rcvr_id, uint8_t channel);
+#endif
 
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_sbus_rcvr_driver = {
     .read = PIOS_SBus_Get,
+#if defined(PIOS_INCLUDE_FREERTOS)
+    .get_semaphore = PIOS_SBus_Get_Semaphore,
+#endif
 };
 
 enum pios_sbus_dev_magic {
@@ -66,6 +72,9 @@ struct pios_sbus_dev {
     enum pios_sbus_dev_magic   magic;
     const struct pios_sbus_cfg *cfg;
     struct pios_sbus_state     state;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreHandle new_frame_semaphore;
+#endif
 };
 
 /* Allocate S.Bus device descriptor */
@@ -142,6 +151,9 @@ int32_t PIOS_SBus_Init(uint32_t *sbus_id,
 
     /* Bind the configuration to the device instance */
     sbus_dev->cfg = cfg;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    sbus_dev->new_frame_semaphore = 0;
+#endif
 
     PIOS_SBus_ResetState(&(sbus_dev->state));
 
@@ -188,6 +200,25 @@ static int32_t PIOS_SBus_Get(uint32_t rcvr_id, uint8_t channel)
     return sbus_dev->state.channel_data[channel];
 }
 
+#if defined(PIOS_INCLUDE_FREERTOS)
+/**
+ * Get the semaphore given on every new frame, the same for all the channels
+ */
+static xSemaphoreHandle PIOS_SBus_Get_Semaphore(uint32_t rcvr_id, uint8_t channel)
+{
+    struct pios_sbus_dev *sbus_dev = (struct pios_sbus_dev *)rcvr_id;
+
+    if (!PIOS_SBus_Validate(sbus_dev) || channel >= PIOS_SBUS_NUM_INPUTS) {
+        return 0;
+    }
+
+    if (sbus_dev->new_frame_semaphore == 0) {
+        vSemaphoreCreateBinary(sbus_dev->new_frame_semaphore);
+    }
+    return sbus_dev->new_frame_semaphore;
+}
+#endif /* if defined(PIOS_INCLUDE_FREERTOS) */
+
 /**
  * Compute channel_data[] from received_data[].
  * For efficiency it unrolls first 8 channels without loops and does the
@@ -225,12 +256,17 @@ static void PIOS_SBus_UnrollChannels(struct pios_sbus_state *state)
     *d++ = (s[22] & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
 }
 
-/* Update decoder state processing input byte from the S.Bus stream */
-static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
+/**
+ * Update decoder state processing input byte from the S.Bus stream
+ * \return true when the byte completed a frame which updated the channels
+ */
+static bool PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 {
+    bool new_frame = false;
+
     /* should not process any data until new frame is found */
     if (!state->frame_found) {
-        return;
+        return false;
     }
 
     if (state->byte_count == 0) {
@@ -241,7 +277,7 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
             /* do not store the SOF byte */
             state->byte_count++;
         }
-        return;
+        return false;
     }
 
     /* do not store last frame byte as well */
@@ -258,10 +294,12 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
             } else if (flags & SBUS_FLAG_FS) {
                 /* failsafe flag active */
                 PIOS_SBus_ResetChannels(state);
+                new_frame = true;
             } else {
                 /* data looking good */
                 PIOS_SBus_UnrollChannels(state);
                 state->failsafe_timer = 0;
+                new_frame = true;
             }
         } else {
             /* discard whole frame */
@@ -270,6 +308,8 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
         /* prepare for the next frame */
         state->frame_found = 0;
     }
+
+    return new_frame;
 }
 
 /* Comm byte received callback */
@@ -287,9 +327,11 @@ static uint16_t PIOS_SBus_RxInCallback(uint32_t context,
 
     struct pios_sbus_state *state = &(sbus_dev->state);
 
+    bool new_frame = false;
+
     /* process byte(s) and clear receive timer */
     for (uint8_t i = 0; i < buf_len; i++) {
-        PIOS_SBus_UpdateState(state, buf[i]);
+        new_frame |= PIOS_SBus_UpdateState(state, buf[i]);
         state->receive_timer = 0;
     }
 
@@ -298,8 +340,15 @@ static uint16_t PIOS_SBus_RxInCallback(uint32_t context,
         *headroom = SBUS_FRAME_LENGTH;
     }
 
-    /* We never need a yield */
+    /* Wake up the task waiting for the frame */
     *need_yield = false;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (new_frame && sbus_dev->new_frame_semaphore) {
+        signed portBASE_TYPE pxHigherPriorityTaskWoken = pdFALSE;
+        xSemaphoreGiveFromISR(sbus_dev->new_frame_semaphore, &pxHigherPriorityTaskWoken);
+        *need_yield = (pxHigherPriorityTaskWoken == pdTRUE);
+    }
+#endif
 
     /* Always indicate that all bytes were consumed */
     return buf_len;
@@ -80,6 +80,22 @@ uint8_t PIOS_SDCARD_Sector[SECTOR_SIZE];
 #define SDCMD_WRITE_SINGLE_BLOCK     (0x40 + 24)
 #define SDCMD_WRITE_SINGLE_BLOCK_CRC 0xff
 
+#define SDCMD_STOP_TRANSMISSION      (0x40 + 12)
+#define SDCMD_STOP_TRANSMISSION_CRC  0xff
+
+#define SDCMD_READ_MULTIPLE_BLOCK    (0x40 + 18)
+#define SDCMD_READ_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_WRITE_MULTIPLE_BLOCK   (0x40 + 25)
+#define SDCMD_WRITE_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_SET_WR_BLK_ERASE_COUNT (0xC0 + 23)
+#define SDCMD_SET_WR_BLK_ERASE_COUNT_CRC 0xff
+
+/* Data tokens of the multiple block write */
+#define SDTOKEN_WRITE_MULTIPLE       0xfc
+#define SDTOKEN_STOP_TRAN            0xfd
+
 /* Card type flags (CardType) */
 #define CT_MMC                       0x01
 #define CT_SD1                       0x02
@@ -553,6 +569,191 @@ error:
     return status;
 }
 
+/**
+ * Waits for the end of the busy state of the card (DO held low)
+ * \return 0 once the card is ready
+ * \return -258 on timeout
+ */
+static int32_t PIOS_SDCARD_WaitReady(void)
+{
+    for (int i = 0; i < 32 * 65536; ++i) { /* TODO: check if sufficient */
+        if (PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff) != 0x00) {
+            return 0;
+        }
+    }
+    return -258;
+}
+
+/**
+ * Reads several consecutive 512 bytes sectors with one READ_MULTIPLE_BLOCK command
+ * \param[in] sector 32bit first sector
+ * \param[in] *buffer pointer to a buffer of count * 512 bytes
+ * \param[in] count number of sectors
+ * \return 0 if all the sectors have been successfully read
+ * \return -error as PIOS_SDCARD_SectorRead
+ */
+int32_t PIOS_SDCARD_SectorsRead(uint32_t sector, uint8_t *buffer, uint32_t count)
+{
+    int32_t status;
+    int i;
+
+    if (count <= 1) {
+        return count ? PIOS_SDCARD_SectorRead(sector, buffer) : 0;
+    }
+
+    if (!(CardType & CT_BLOCK)) {
+        sector *= 512;
+    }
+
+    SDCARD_MUTEX_TAKE;
+
+    /* Init SPI port for fast frequency access (ca. 18 MBit/s) */
+    /* this is required for the case that the SPI port is shared with other devices */
+    PIOS_SPI_SetClockSpeed(PIOS_SDCARD_SPI, PIOS_SPI_PRESCALER_4);
+
+    if ((status = PIOS_SDCARD_SendSDCCmd(SDCMD_READ_MULTIPLE_BLOCK, sector, SDCMD_READ_MULTIPLE_BLOCK_CRC))) {
+        status = (status < 0) ? -256 : status; /* return timeout indicator or error flags */
+        goto error;
+    }
+
+    for (uint32_t block = 0; block < count && !status; block++) {
+        /* Wait for start token of the data block */
+        for (i = 0; i < 65536; ++i) { // TODO: check if sufficient
+            uint8_t ret = PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+            if (ret != 0xff) {
+                break;
+            }
+        }
+
+        if (i == 65536) {
+            status = -257;
+            break;
+        }
+
+        /* Read 512 bytes via DMA */
+        PIOS_SPI_TransferBlock(PIOS_SDCARD_SPI, NULL, buffer + block * 512, 512, NULL);
+
+        /* Read (and ignore) CRC */
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+    }
+
+    /* Stop the transmission, the byte following the command is a stuff byte */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, (uint8_t)SDCMD_STOP_TRANSMISSION);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0x00);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0x00);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0x00);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0x00);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, SDCMD_STOP_TRANSMISSION_CRC);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+    /* Wait for the R1b response and the end of its busy state */
+    for (i = 0; i < 8; ++i) {
+        if (!(PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff) & 0x80)) {
+            break;
+        }
+    }
+    if (PIOS_SDCARD_WaitReady() != 0 && !status) {
+        status = -258;
+    }
+
+    /* Required for clocking (see spec) */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+error:
+    /* Deactivate chip select */
+    PIOS_SPI_RC_PinSet(PIOS_SDCARD_SPI, 0, 1); // spi, pin_value
+
+    /* Send dummy byte once deactivated to drop cards DO */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+    SDCARD_MUTEX_GIVE;
+    return status;
+}
+
+/**
+ * Writes several consecutive 512 bytes sectors with one WRITE_MULTIPLE_BLOCK command
+ * \param[in] sector 32bit first sector
+ * \param[in] *buffer pointer to a buffer of count * 512 bytes
+ * \param[in] count number of sectors
+ * \return 0 if all the sectors have been successfully written
+ * \return -error as PIOS_SDCARD_SectorWrite
+ */
+int32_t PIOS_SDCARD_SectorsWrite(uint32_t sector, uint8_t *buffer, uint32_t count)
+{
+    int32_t status;
+
+    if (count <= 1) {
+        return count ? PIOS_SDCARD_SectorWrite(sector, buffer) : 0;
+    }
+
+    SDCARD_MUTEX_TAKE;
+
+    if (!(CardType & CT_BLOCK)) {
+        sector *= 512;
+    }
+
+    /* Init SPI port for fast frequency access (ca. 18 MBit/s) */
+    /* This is required for the case that the SPI port is shared with other devices */
+    PIOS_SPI_SetClockSpeed(PIOS_SDCARD_SPI, PIOS_SPI_PRESCALER_4);
+
+    if (CardType & CT_SDC) {
+        /* Let the SD cards pre-erase the blocks, only a hint so the result does not matter */
+        if (PIOS_SDCARD_SendSDCCmd(SDCMD_SET_WR_BLK_ERASE_COUNT, count, SDCMD_SET_WR_BLK_ERASE_COUNT_CRC) >= 0) {
+            PIOS_SPI_RC_PinSet(PIOS_SDCARD_SPI, 0, 1); /* spi, pin_value */
+            PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+        }
+    }
+
+    if ((status = PIOS_SDCARD_SendSDCCmd(SDCMD_WRITE_MULTIPLE_BLOCK, sector, SDCMD_WRITE_MULTIPLE_BLOCK_CRC))) {
+        status = (status < 0) ? -256 : status; /* Return timeout indicator or error flags */
+        goto error;
+    }
+
+    for (uint32_t block = 0; block < count; block++) {
+        /* Send start token */
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, SDTOKEN_WRITE_MULTIPLE);
+
+        /* Send 512 bytes of data via DMA */
+        PIOS_SPI_TransferBlock(PIOS_SDCARD_SPI, buffer + block * 512, NULL, 512, NULL);
+
+        /* Send CRC */
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+        /* Read response */
+        uint8_t response = PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+        if ((response & 0x0f) != 0x5) {
+            status = -257;
+            break;
+        }
+
+        /* Wait for the programming of the block */
+        if ((status = PIOS_SDCARD_WaitReady()) != 0) {
+            goto error;
+        }
+    }
+
+    /* Stop the transmission, also after a rejected block */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, SDTOKEN_STOP_TRAN);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+    if (PIOS_SDCARD_WaitReady() != 0 && !status) {
+        status = -258;
+    }
+
+    /* Required for clocking (see spec) */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+error:
+    /* Deactivate chip select */
+    PIOS_SPI_RC_PinSet(PIOS_SDCARD_SPI, 0, 1); /* spi, pin_value */
+    /* Send dummy byte once deactivated to drop cards DO */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+    SDCARD_MUTEX_GIVE;
+
+    return status;
+}
+
 /**
  * Reads the CID informations from SD Card
  * \param[in] *cid pointer to buffer which holds the CID informations
@@ -29,10 +29,13 @@
 
 #ifdef PIOS_INCLUDE_TASK_MONITOR
 
+// The run time counter counts cpu cycles (DWT_CYCCNT, as PIOS_DELAY_GetRaw())
+#define RUN_TIME_COUNTS_PER_US (configCPU_CLOCK_HZ / 1000000)
+
 // Private variables
 static xSemaphoreHandle mLock;
 static xTaskHandle *mTaskHandles;
-static uint32_t mLastMonitorTime;
+static uint32_t *mLastMonitorTimes;
 static uint32_t mLastIdleMonitorTime;
 static uint16_t mMaxTasks;
 
@@ -52,12 +55,20 @@ int32_t PIOS_TASK_MONITOR_Initialize(uint16_t max_tasks)
     }
     memset(mTaskHandles, 0, max_tasks * sizeof(xTaskHandle));
 
+    // the tasks may be reported at different times, each keeps the time it was last reported
+    mLastMonitorTimes = (uint32_t *)pios_malloc(max_tasks * sizeof(uint32_t));
+    if (!mLastMonitorTimes) {
+        return -1;
+    }
+
     mMaxTasks = max_tasks;
 #if (configGENERATE_RUN_TIME_STATS == 1)
-    mLastMonitorTime     = portGET_RUN_TIME_COUNTER_VALUE();
+    for (uint16_t n = 0; n < max_tasks; ++n) {
+        mLastMonitorTimes[n] = portGET_RUN_TIME_COUNTER_VALUE();
+    }
     mLastIdleMonitorTime = portGET_RUN_TIME_COUNTER_VALUE();
 #else
-    mLastMonitorTime     = 0;
+    memset(mLastMonitorTimes, 0, max_tasks * sizeof(uint32_t));
     mLastIdleMonitorTime = 0;
 #endif
     return 0;
@@ -101,29 +112,51 @@ bool PIOS_TASK_MONITOR_IsRunning(uint16_t task_id)
     return mTaskHandles && task_id <= mMaxTasks && mTaskHandles[task_id];
 }
 
+/**
+ * Get the handle of a registered task
+ */
+xTaskHandle PIOS_TASK_MONITOR_GetHandle(uint16_t task_id)
+{
+    if (!mTaskHandles || task_id >= mMaxTasks) {
+        return 0;
+    }
+    return mTaskHandles[task_id];
+}
+
 /**
  * Tell the caller the status of all tasks via a task-by-task callback
  */
 void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *context)
 {
-    if (!mTaskHandles) {
-        return;
+    PIOS_TASK_MONITOR_ForEachTaskFrom(0, mMaxTasks, callback, context);
+}
+
+/**
+ * Tell the caller the status of count tasks from task_id first via a task-by-task callback
+ * \returns the task_id to start from on the next call, 0 once the last task was reported
+ */
+uint16_t PIOS_TASK_MONITOR_ForEachTaskFrom(uint16_t first, uint16_t count, TaskMonitorTaskInfoCallback callback, void *context)
+{
+    if (!mTaskHandles || first >= mMaxTasks) {
+        return 0;
     }
 
+    uint16_t last = (count < mMaxTasks - first) ? first + count : mMaxTasks;
+
     xSemaphoreTakeRecursive(mLock, portMAX_DELAY);
 
+    /* Update the task information */
+    for (uint16_t n = first; n < last; ++n) {
+        struct pios_task_info info;
 #if (configGENERATE_RUN_TIME_STATS == 1)
-    /* Calculate the amount of elapsed run time between the last time we
-     * measured and now. Scale so that we can convert task run times
-     * directly to percentages. */
-    uint32_t currentTime = portGET_RUN_TIME_COUNTER_VALUE();
-    /* avoid divide-by-zero if the interval is too small */
-    uint32_t deltaTime   = ((currentTime - mLastMonitorTime) / 100) ? : 1;
-    mLastMonitorTime = currentTime;
+        /* Calculate the amount of elapsed run time between the last time we
+         * measured this task and now. Scale so that we can convert task run
+         * times directly to percentages. */
+        uint32_t currentTime = portGET_RUN_TIME_COUNTER_VALUE();
+        /* avoid divide-by-zero if the interval is too small */
+        uint32_t deltaTime   = ((currentTime - mLastMonitorTimes[n]) / 100) ? : 1;
+        mLastMonitorTimes[n] = currentTime;
 #endif
-    /* Update all task information */
-    for (uint16_t n = 0; n < mMaxTasks; ++n) {
-        struct pios_task_info info;
         if (mTaskHandles[n]) {
             info.is_running = true;
 #if defined(ARCH_POSIX) || defined(ARCH_WIN32)
@@ -134,19 +167,28 @@ void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *c
 #if (configGENERATE_RUN_TIME_STATS == 1)
             /* Generate run time percentage stats */
             info.running_time_percentage = uxTaskGetRunTime(mTaskHandles[n]) / deltaTime;
+#if defined(ARCH_POSIX) || defined(ARCH_WIN32)
+            info.max_burst_us = 0;
+#else
+            info.max_burst_us = ulTaskGetMaxBurst(mTaskHandles[n]) / RUN_TIME_COUNTS_PER_US;
+#endif
 #else
             info.running_time_percentage = 0;
+            info.max_burst_us = 0;
 #endif
         } else {
             info.is_running = false;
             info.stack_remaining = 0;
             info.running_time_percentage = 0;
+            info.max_burst_us = 0;
         }
         /* Pass the information for this task back to the caller */
         callback(n, &info, context);
     }
 
     xSemaphoreGiveRecursive(mLock);
+
+    return (last < mMaxTasks) ? last : 0;
 }
 
 uint8_t PIOS_TASK_MONITOR_GetIdlePercentage()
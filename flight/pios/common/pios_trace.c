@@ -0,0 +1,96 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_trace.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      PiOS scheduling trace
+ *             Records task switches, callbacks, interrupts and event queue
+ *             overflows in a ring buffer for timeline analysis
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <pios.h>
+
+#ifdef PIOS_INCLUDE_TRACE
+
+#ifndef PIOS_TRACE_BUFFER_SIZE
+#define PIOS_TRACE_BUFFER_SIZE 512 // records, must be a power of two
+#endif
+#define PIOS_TRACE_BUFFER_MASK (PIOS_TRACE_BUFFER_SIZE - 1)
+
+static struct pios_trace_record trace_buffer[PIOS_TRACE_BUFFER_SIZE];
+static volatile uint32_t trace_head = 0; // total number of records written
+static volatile bool trace_enabled  = false;
+
+void PIOS_TRACE_Record(uint8_t event, uint32_t arg)
+{
+    if (!trace_enabled) {
+        return;
+    }
+    // claiming the slot is atomic, so interrupts preempting a writer get their own slot
+    uint32_t slot = __sync_fetch_and_add(&trace_head, 1) & PIOS_TRACE_BUFFER_MASK;
+
+    trace_buffer[slot].time = PIOS_DELAY_GetRaw();
+    trace_buffer[slot].data = ((uint32_t)event << 24) | (arg & 0x00ffffff);
+}
+
+void PIOS_TRACE_Enable(bool enable)
+{
+    if (enable && !trace_enabled) {
+        trace_head = 0;
+    }
+    trace_enabled = enable;
+}
+
+bool PIOS_TRACE_IsEnabled()
+{
+    return trace_enabled;
+}
+
+uint32_t PIOS_TRACE_Count()
+{
+    return trace_head < PIOS_TRACE_BUFFER_SIZE ? trace_head : PIOS_TRACE_BUFFER_SIZE;
+}
+
+uint32_t PIOS_TRACE_Read(uint32_t first, struct pios_trace_record *records, uint32_t count)
+{
+    if (trace_enabled) {
+        return 0;
+    }
+    uint32_t available = PIOS_TRACE_Count();
+    if (first >= available) {
+        return 0;
+    }
+    count = MIN(count, available - first);
+
+    // once the ring has wrapped the oldest record is the one at the head
+    uint32_t oldest = trace_head - available;
+    for (uint32_t i = 0; i < count; i++) {
+        records[i] = trace_buffer[(oldest + first + i) & PIOS_TRACE_BUFFER_MASK];
+    }
+    return count;
+}
+
+void PIOS_TRACE_TaskInfo(struct pios_trace_record *record, uint16_t task_id, void *handle)
+{
+    record->time = (uint32_t)handle;
+    record->data = ((uint32_t)PIOS_TRACE_TASK_INFO << 24) | task_id;
+}
+
+#endif /* PIOS_INCLUDE_TRACE */
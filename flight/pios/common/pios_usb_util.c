@@ -45,4 +45,35 @@ uint8_t *PIOS_USB_UTIL_AsciiToUtf8(uint8_t *dst, uint8_t *src, uint16_t srclen)
     return dst;
 }
 
+/**
+ * Count a transfer of an endpoint
+ * \param[in] throughput counters of the endpoint
+ * \param[in] len bytes transferred
+ */
+void PIOS_USB_UTIL_ThroughputAdd(struct pios_usb_util_throughput *throughput, uint16_t len)
+{
+    throughput->bytes += len;
+    throughput->transfers++;
+}
+
+/**
+ * Throughput of an endpoint since the last call, from a single reader
+ * \param[in] throughput counters of the endpoint
+ * \return bytes per second
+ */
+uint32_t PIOS_USB_UTIL_ThroughputRate(struct pios_usb_util_throughput *throughput)
+{
+    uint32_t bytes   = throughput->bytes;
+    uint32_t elapsed = PIOS_DELAY_GetuSSince(throughput->last_time);
+    uint32_t rate    = 0;
+
+    if (elapsed > 0) {
+        rate = (uint32_t)(((uint64_t)(bytes - throughput->last_bytes) * 1000000) / elapsed);
+    }
+    throughput->last_bytes = bytes;
+    throughput->last_time  = PIOS_DELAY_GetuS();
+
+    return rate;
+}
+
 #endif /* PIOS_INCLUDE_USB */
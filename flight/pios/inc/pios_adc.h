@@ -36,6 +36,19 @@
 
 typedef void (*ADCCallback)(float *data);
 
+#if defined(PIOS_ADC_HAS_STREAM)
+#ifndef PIOS_ADC_MAX_STREAM_LISTENERS
+#define PIOS_ADC_MAX_STREAM_LISTENERS 2
+#endif
+/*
+ * Called from the DMA interrupt with each completed half of the double buffer, the
+ * raw samples of a conversion follow each other: samples[sample * num_pins + pin].
+ * The buffer is refilled by the DMA after the next one, the listener reads it from
+ * the interrupt or copies what it needs.
+ */
+typedef void (*pios_adc_stream_callback)(const uint16_t *samples, uint16_t num_samples, uint8_t num_pins, void *context, bool *woken);
+#endif
+
 /* Public Functions */
 void PIOS_ADC_Config(uint32_t oversampling);
 int32_t PIOS_ADC_PinGet(uint32_t pin);
@@ -47,6 +60,9 @@ void PIOS_ADC_SetCallback(ADCCallback new_function);
 void PIOS_ADC_SetQueue(xQueueHandle data_queue);
 #endif
 extern void PIOS_ADC_DMA_Handler(void);
+#if defined(PIOS_ADC_HAS_STREAM)
+int32_t PIOS_ADC_AddStreamListener(pios_adc_stream_callback callback, void *context);
+#endif
 
 #endif /* PIOS_ADC_H */
 
@@ -186,6 +186,24 @@ int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo);
  */
 int32_t PIOS_CALLBACKSCHEDULER_DispatchFromISR(DelayedCallbackInfo *cbinfo, long *pxHigherPriorityTaskWoken);
 
+/**
+ * Number of buckets of the callback timing histograms. Bucket 0 counts durations
+ * below 1us, bucket n durations of 2^(n-1) to 2^n - 1 us and the last bucket
+ * all the longer durations.
+ */
+#define PIOS_CALLBACKSCHEDULER_TIMING_BUCKETS 16
+
+/**
+ * Distribution of a callback duration in microseconds, collected when built with DIAG_CALLBACK_TIMING.
+ */
+struct pios_callback_timing {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t histogram[PIOS_CALLBACKSCHEDULER_TIMING_BUCKETS];
+};
+
 /**
  * Information about a running callback that has been registered
  * via a call to PIOS_CALLBACKSCHEDULER_Create().
@@ -197,6 +215,10 @@ struct pios_callback_info {
     bool     is_running;
     /** Count of executions of the callback since system start */
     uint32_t running_time_count;
+    /** Time from dispatch to start of the callback, NULL unless built with DIAG_CALLBACK_TIMING */
+    const struct pios_callback_timing *latency;
+    /** Execution time of the callback, NULL unless built with DIAG_CALLBACK_TIMING */
+    const struct pios_callback_timing *runtime;
 };
 
 /**
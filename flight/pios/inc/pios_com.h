@@ -35,6 +35,16 @@
 #include <stdbool.h> /* bool */
 
 typedef uint16_t (*pios_com_callback)(uint32_t context, uint8_t *buf, uint16_t buf_len, uint16_t *headroom, bool *task_woken);
+/* Zero copy transmit: releases the consumed bytes of the previous segment and returns the next contiguous one */
+typedef uint16_t (*pios_com_dma_callback)(uint32_t context, uint16_t consumed, uint8_t **buf, bool *task_woken);
+/* Line settings of the host, e.g. the baud rate set on a USB virtual COM port */
+typedef void (*pios_com_baud_rate_callback)(uint32_t context, uint32_t baud);
+
+/* A buffer to send, or a region of the tx buffer to write in place */
+struct pios_com_iovec {
+    uint8_t  *data;
+    uint16_t len;
+};
 
 struct pios_com_driver {
     void (*init)(uint32_t id);
@@ -43,15 +53,21 @@ struct pios_com_driver {
     void (*rx_start)(uint32_t id, uint16_t rx_bytes_avail);
     void (*bind_rx_cb)(uint32_t id, pios_com_callback rx_in_cb, uint32_t context);
     void (*bind_tx_cb)(uint32_t id, pios_com_callback tx_out_cb, uint32_t context);
+    void (*bind_tx_dma_cb)(uint32_t id, pios_com_dma_callback tx_dma_cb, uint32_t context);
+    void (*bind_baud_rate_cb)(uint32_t id, pios_com_baud_rate_callback baud_rate_cb, uint32_t context);
     bool (*available)(uint32_t id);
 };
 
 /* Public Functions */
 extern int32_t PIOS_COM_ChangeBaud(uint32_t com_id, uint32_t baud);
+extern int32_t PIOS_COM_RegisterBaudRateCallback(uint32_t com_id, pios_com_baud_rate_callback baud_rate_cb, uint32_t context);
 extern int32_t PIOS_COM_SendCharNonBlocking(uint32_t com_id, char c);
 extern int32_t PIOS_COM_SendChar(uint32_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uint32_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBuffer(uint32_t com_id, const uint8_t *buffer, uint16_t len);
+extern int32_t PIOS_COM_SendVector(uint32_t com_id, const struct pios_com_iovec *iov, uint8_t count);
+extern int32_t PIOS_COM_TxReserve(uint32_t com_id, uint16_t len, struct pios_com_iovec regions[2]);
+extern int32_t PIOS_COM_TxCommit(uint32_t com_id, uint16_t len);
 extern int32_t PIOS_COM_SendStringNonBlocking(uint32_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uint32_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uint32_t com_id, const char *format, ...);
@@ -61,6 +61,16 @@ void PIOS_DEBUGLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, uint8
  */
 void PIOS_DEBUGLOG_Printf(char *format, ...);
 
+/**
+ * @brief Write a debug log entry with scheduling trace records, written
+ * even when logging is disabled as the dump is requested explicitly
+ * @param[in] records buffer, up to the size of an entry
+ * @param[in] size of the records in bytes
+ * @param[in] ticks_per_us resolution of the record times
+ * @return true if the entry was queued, false if no buffer was available
+ */
+bool PIOS_DEBUGLOG_Trace(const void *records, size_t size, uint32_t ticks_per_us);
+
 /**
  * @brief Load one object instance from the filesystem
  * @param[out] buffer where to store the uavobject
@@ -84,6 +94,12 @@ int32_t PIOS_DEBUGLOG_Read(void *buffer, uint16_t flight, uint16_t inst);
  */
 void PIOS_DEBUGLOG_Info(uint16_t *flight, uint16_t *entry, uint16_t *free, uint16_t *used);
 
+/**
+ * @brief Retrieve the number of log entries dropped because no buffer was available
+ * @return dropped entries since system start
+ */
+uint32_t PIOS_DEBUGLOG_DroppedEntries(void);
+
 /**
  * @brief Format entire flash memory!!!
  */
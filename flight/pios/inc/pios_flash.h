@@ -34,6 +34,12 @@ struct pios_flash_chunk {
     uint32_t len;
 };
 
+struct pios_flash_range {
+    uint32_t addr;
+    uint8_t  *data;
+    uint16_t len;
+};
+
 struct pios_flash_driver {
     int32_t (*start_transaction)(uintptr_t flash_id);
     int32_t (*end_transaction)(uintptr_t flash_id);
@@ -42,6 +48,8 @@ struct pios_flash_driver {
     int32_t (*write_data)(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len);
     int32_t (*write_chunks)(uintptr_t flash_id, uint32_t addr, struct pios_flash_chunk chunks[], uint32_t num_chunks);
     int32_t (*read_data)(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len);
+    /* Optional, reads several ranges at once */
+    int32_t (*read_ranges)(uintptr_t flash_id, const struct pios_flash_range ranges[], uint32_t num_ranges);
 };
 
 #endif /* PIOS_FLASH_H */
@@ -32,6 +32,9 @@
 struct PIOS_FLASHFS_Stats {
     uint16_t num_free_slots; /* slots in free state */
     uint16_t num_active_slots; /* slots in active state */
+    uint8_t  gc_running; /* incremental garbage collection in progress */
+    uint8_t  gc_progress; /* percent done of the running garbage collection */
+    uint32_t gc_time; /* us spent in the running, or else the last, garbage collection */
 };
 
 int32_t PIOS_FLASHFS_Format(uintptr_t fs_id);
@@ -39,4 +42,7 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size);
 int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id);
 int32_t PIOS_FLASHFS_GetStats(uintptr_t fs_id, struct PIOS_FLASHFS_Stats *stats);
+int32_t PIOS_FLASHFS_GarbageCollectStep(uintptr_t fs_id);
+int32_t PIOS_FLASHFS_BeginTransaction(uintptr_t fs_id);
+int32_t PIOS_FLASHFS_CommitTransaction(uintptr_t fs_id);
 #endif /* PIOS_FLASHFS_H */
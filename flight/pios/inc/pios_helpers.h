@@ -66,4 +66,17 @@
 // For future multicore ARM v7 or later:
 // The above three macros would be replaced with: asm volatile("dmb":::"memory")
 
+/**
+ * @brief Place a variable in the core coupled memory on the targets that have some (STM32F4),
+ * for hot flight control state that should not compete with DMA for the SRAM bus.
+ * The section is zeroed at startup and not loaded: the variable must not have an initialiser.
+ * CCM can not be reached by DMA, never use it for DMA buffers.
+ * Note that on these targets task stacks already come from the fast heap, in CCM as well.
+ */
+#if defined(STM32F4XX)
+#define PIOS_FAST_DATA __attribute__((section(".fast")))
+#else
+#define PIOS_FAST_DATA
+#endif
+
 #endif // PIOS_HELPERS_H
@@ -99,6 +99,8 @@ typedef uintptr_t pios_hmc5x83_dev_t;
 struct pios_hmc5x83_io_driver {
     int32_t (*Write)(pios_hmc5x83_dev_t handler, uint8_t address, uint8_t buffer);
     int32_t (*Read)(pios_hmc5x83_dev_t handler, uint8_t address, uint8_t *buffer, uint8_t len);
+    /* Optional, starts reading the data registers without waiting for the bus */
+    int32_t (*ReadMagAsync)(pios_hmc5x83_dev_t handler, bool *woken);
 };
 
 #ifdef PIOS_INCLUDE_SPI
@@ -128,6 +130,7 @@ extern int32_t PIOS_HMC5x83_ReadMag(pios_hmc5x83_dev_t handler, int16_t out[3]);
 extern uint8_t PIOS_HMC5x83_ReadID(pios_hmc5x83_dev_t handler, uint8_t out[4]);
 extern int32_t PIOS_HMC5x83_Test(pios_hmc5x83_dev_t handler);
 extern bool PIOS_HMC5x83_IRQHandler(pios_hmc5x83_dev_t handler);
+extern int32_t PIOS_HMC5x83_EnableIRQRead(pios_hmc5x83_dev_t handler);
 
 #endif /* PIOS_HMC5x83_H */
 
@@ -63,6 +63,39 @@ struct pios_i2c_fault_history {
     uint8_t  state[I2C_LOG_DEPTH];
 };
 
+/*
+ * Asynchronous requests, for the architectures defining PIOS_I2C_HAS_REQUESTS.
+ * A request runs its transaction list like PIOS_I2C_Transfer(), the queued
+ * requests of a bus are started from the interrupt which completes the
+ * previous one, so the callers do not wait for the bus.
+ */
+struct pios_i2c_request;
+/* Called from the I2C interrupt once the bus is stopped, status as returned by PIOS_I2C_Transfer() */
+typedef void (*pios_i2c_request_callback)(struct pios_i2c_request *request, int32_t status, bool *woken);
+
+struct pios_i2c_request {
+    const struct pios_i2c_txn *txn_list;
+    uint32_t num_txns;
+    pios_i2c_request_callback callback;
+    void     *context;
+
+    /* Private, used by the driver while the request is queued */
+    struct pios_i2c_request *next;
+    uint32_t start;
+    volatile bool pending;
+};
+
+/* Transfer statistics of a slave, by the address of the first transaction */
+#define PIOS_I2C_STATS_DEVICES 4
+struct pios_i2c_device_stats {
+    uint16_t addr;
+    uint32_t transfers;
+    uint32_t bus_errors;
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t max_time_us;
+};
+
 /* Public Functions */
 extern int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns);
 extern int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, void *callback);
@@ -70,6 +103,8 @@ extern void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_GetDiagnostics(struct pios_i2c_fault_history *data, uint8_t *error_counts);
+extern int32_t PIOS_I2C_Submit(uint32_t i2c_id, struct pios_i2c_request *request, bool *woken);
+extern uint8_t PIOS_I2C_GetDeviceStats(uint32_t i2c_id, struct pios_i2c_device_stats *stats, uint8_t max_devices);
 
 #endif /* PIOS_I2C_H */
 
@@ -72,6 +72,15 @@ struct pios_i2c_adapter {
 
     uint8_t *active_byte;
     uint8_t *last_byte;
+
+    /* Asynchronous requests, the active one owns the bus */
+    struct pios_i2c_request *queue_head;
+    struct pios_i2c_request *queue_tail;
+    struct pios_i2c_request *active;
+
+#if defined(PIOS_I2C_DIAGNOSTICS)
+    struct pios_i2c_device_stats stats[PIOS_I2C_STATS_DEVICES];
+#endif
 };
 
 int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg);
@@ -29,12 +29,36 @@
 #include <pios_debug.h>
 #include <pios_delay.h>
 #include <FreeRTOS.h>
+
+#define PIOS_INSTRUMENTATION_HISTOGRAM_BUCKETS 16
+
+/**
+ * Distribution of the values of a counter, only kept for the counters created
+ * with PIOS_Instrumentation_CreateStatsCounter().
+ * Histogram bucket 0 counts values below 1, bucket n values of 2^(n-1) to 2^n-1,
+ * the last bucket all larger ones.
+ */
+typedef struct {
+    uint32_t count;
+    int64_t  sum;
+    uint64_t sumSquares;
+    uint32_t histogram[PIOS_INSTRUMENTATION_HISTOGRAM_BUCKETS];
+} pios_perf_stats_t;
+
+/**
+ * Counters are single writer: each counter must only be updated from one task or
+ * interrupt handler. Updates do not need a critical section, they bump seq around
+ * them so that the reader, @see PIOS_Instrumentation_ForEachCounter, can tell it
+ * copied a consistent counter.
+ */
 typedef struct {
     uint32_t id;
     int32_t  max;
     int32_t  min;
     int32_t  value;
     uint32_t lastUpdateTS;
+    volatile uint32_t  seq; // odd while an update is in progress
+    pios_perf_stats_t *stats;
 } pios_perf_counter_t;
 
 typedef void *pios_counter_t;
@@ -42,81 +66,91 @@ typedef void *pios_counter_t;
 extern pios_perf_counter_t *pios_instrumentation_perf_counters;
 extern int8_t pios_instrumentation_last_used_counter;
 
+// Only keeps the compiler from moving the counter updates out of the seq brackets,
+// counters are written and read on the same core
+#define PIOS_INSTRUMENTATION_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+/**
+ * Store a new value and sample in a counter, the caller is the only writer of the counter
+ */
+static inline void PIOS_Instrumentation_storeSample(pios_perf_counter_t *counter, int32_t value, int32_t sample)
+{
+    counter->seq++;
+    PIOS_INSTRUMENTATION_BARRIER();
+
+    counter->value = value;
+    if (sample > counter->max) {
+        counter->max = sample;
+    }
+    if (sample < counter->min) {
+        counter->min = sample;
+    }
+    pios_perf_stats_t *stats = counter->stats;
+    if (stats) {
+        uint8_t bucket = sample > 0 ? 32 - __builtin_clz((uint32_t)sample) : 0;
+        if (bucket >= PIOS_INSTRUMENTATION_HISTOGRAM_BUCKETS) {
+            bucket = PIOS_INSTRUMENTATION_HISTOGRAM_BUCKETS - 1;
+        }
+        stats->histogram[bucket]++;
+        stats->count++;
+        stats->sum += sample;
+        stats->sumSquares += (uint64_t)((int64_t)sample * sample);
+    }
+
+    PIOS_INSTRUMENTATION_BARRIER();
+    counter->seq++;
+}
+
 /**
  * Update a counter with a new value
  * @param counter_handle handle of the counter to update @see PIOS_Instrumentation_SearchCounter @see PIOS_Instrumentation_CreateCounter
  * @param newValue the updated value.
  */
-inline void PIOS_Instrumentation_updateCounter(pios_counter_t counter_handle, int32_t newValue)
+static inline void PIOS_Instrumentation_updateCounter(pios_counter_t counter_handle, int32_t newValue)
 {
     PIOS_Assert(pios_instrumentation_perf_counters && counter_handle);
-    vPortEnterCritical();
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
-    counter->value = newValue;
-    if (counter->value > counter->max) {
-        counter->max = counter->value;
-    }
-    if (counter->value < counter->min) {
-        counter->min = counter->value;
-    }
+    PIOS_Instrumentation_storeSample(counter, newValue, newValue);
     counter->lastUpdateTS = PIOS_DELAY_GetRaw();
-    vPortExitCritical();
 }
 
 /**
  * Used to determine the time duration of a code block, mark the begin of the block. @see PIOS_Instrumentation_TimeEnd
  * @param counter_handle handle of the counter @see PIOS_Instrumentation_SearchCounter @see PIOS_Instrumentation_CreateCounter
  */
-inline void PIOS_Instrumentation_TimeStart(pios_counter_t counter_handle)
+static inline void PIOS_Instrumentation_TimeStart(pios_counter_t counter_handle)
 {
     PIOS_Assert(pios_instrumentation_perf_counters && counter_handle);
-    vPortEnterCritical();
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
 
     counter->lastUpdateTS = PIOS_DELAY_GetRaw();
-    vPortExitCritical();
 }
 
 /**
  * Used to determine the time duration of a code block, mark the end of the block. @see PIOS_Instrumentation_TimeStart
  * @param counter_handle handle of the counter @see PIOS_Instrumentation_SearchCounter @see PIOS_Instrumentation_CreateCounter
  */
-inline void PIOS_Instrumentation_TimeEnd(pios_counter_t counter_handle)
+static inline void PIOS_Instrumentation_TimeEnd(pios_counter_t counter_handle)
 {
     PIOS_Assert(pios_instrumentation_perf_counters && counter_handle);
-    vPortEnterCritical();
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
 
-    counter->value = PIOS_DELAY_DiffuS(counter->lastUpdateTS);
-    if (counter->value > counter->max) {
-        counter->max = counter->value;
-    }
-    if (counter->value < counter->min) {
-        counter->min = counter->value;
-    }
+    int32_t duration = PIOS_DELAY_DiffuS(counter->lastUpdateTS);
+    PIOS_Instrumentation_storeSample(counter, duration, duration);
     counter->lastUpdateTS = PIOS_DELAY_GetRaw();
-    vPortExitCritical();
 }
 
 /**
  * Used to determine the mean period between each call to the function
  * @param counter_handle handle of the counter @see PIOS_Instrumentation_SearchCounter @see PIOS_Instrumentation_CreateCounter
  */
-inline void PIOS_Instrumentation_TrackPeriod(pios_counter_t counter_handle)
+static inline void PIOS_Instrumentation_TrackPeriod(pios_counter_t counter_handle)
 {
     PIOS_Assert(pios_instrumentation_perf_counters && counter_handle);
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
     if (counter->lastUpdateTS != 0) {
-        vPortEnterCritical();
         uint32_t period = PIOS_DELAY_DiffuS(counter->lastUpdateTS);
-        counter->value = (counter->value * 15 + period) / 16;
-        if ((int32_t)period > counter->max) {
-            counter->max = period;
-        }
-        if ((int32_t)period < counter->min) {
-            counter->min = period;
-        }
-        vPortExitCritical();
+        PIOS_Instrumentation_storeSample(counter, (counter->value * 15 + period) / 16, period);
     }
     counter->lastUpdateTS = PIOS_DELAY_GetRaw();
 }
@@ -134,6 +168,13 @@ void PIOS_Instrumentation_Init(int8_t maxCounters);
  */
 pios_counter_t PIOS_Instrumentation_CreateCounter(uint32_t id);
 
+/**
+ * Create a new counter that also keeps the mean, variance and histogram of its samples.
+ * @param id the unique id to assign to the counter
+ * @return the counter handle to be used to manage its content
+ */
+pios_counter_t PIOS_Instrumentation_CreateStatsCounter(uint32_t id);
+
 /**
  * search a counter index by its unique Id
  * @param id the unique id to assign to the counter.
@@ -144,7 +185,8 @@ pios_counter_t PIOS_Instrumentation_SearchCounter(uint32_t id);
 
 typedef void (*InstrumentationCounterCallback)(const pios_perf_counter_t *counter, const int8_t index, void *context);
 /**
- * Retrieve and execute the passed callback for each counter
+ * Retrieve and execute the passed callback for each counter, with a consistent copy of it.
+ * A counter whose update keeps being in progress is skipped.
  * @param callback to be called for each counter
  * @param context a context variable pointer that can be passed to the callback
  */
@@ -55,6 +55,8 @@
  * PERF_INIT_COUNTER(counterAtt, 0xA7710002);
  * PERF_INIT_COUNTER(counterPeriod, 0xA7710003);
  * PERF_INIT_COUNTER(counterAccelSamples, 0xA7710004);</pre>
+ * PERF_INIT_STATS_COUNTER creates a counter that also keeps the mean, variance and
+ * histogram of all the samples, at the cost of some more ram and cycles per sample.
  *
  * At this point you can start using the counters as in the following samples
  *
@@ -72,6 +74,12 @@
  * <pre>PERF_TRACK_VALUE(counterAccelSamples, i);</pre>
  * the counter is then updated with the value of i.
  *
+ * Counters do not take any lock, a counter must only be updated from a single task or
+ * interrupt handler.
+ *
+ * All the instrumentation points of a build compile to nothing when it is made with
+ * NO_INSTRUMENTATION=YES, whatever the board configuration.
+ *
  * \par
  */
 
@@ -84,25 +92,27 @@
 /**
  * include the following macro together with modules variable declaration
  */
-#define PERF_DEFINE_COUNTER(x)      pios_counter_t x
+#define PERF_DEFINE_COUNTER(x)         pios_counter_t x
 
 /**
  * this mast be called at some module init code
  */
-#define PERF_INIT_COUNTER(x, id)    x = PIOS_Instrumentation_CreateCounter(id)
+#define PERF_INIT_COUNTER(x, id)       x = PIOS_Instrumentation_CreateCounter(id)
+#define PERF_INIT_STATS_COUNTER(x, id) x = PIOS_Instrumentation_CreateStatsCounter(id)
 
 /**
  * those are the monitoring macros
  */
-#define PERF_TIMED_SECTION_START(x) PIOS_Instrumentation_TimeStart(x)
-#define PERF_TIMED_SECTION_END(x)   PIOS_Instrumentation_TimeEnd(x)
-#define PERF_MEASURE_PERIOD(x)      PIOS_Instrumentation_TrackPeriod(x)
-#define PERF_TRACK_VALUE(x, y)      PIOS_Instrumentation_updateCounter(x, y)
+#define PERF_TIMED_SECTION_START(x)    PIOS_Instrumentation_TimeStart(x)
+#define PERF_TIMED_SECTION_END(x)      PIOS_Instrumentation_TimeEnd(x)
+#define PERF_MEASURE_PERIOD(x)         PIOS_Instrumentation_TrackPeriod(x)
+#define PERF_TRACK_VALUE(x, y)         PIOS_Instrumentation_updateCounter(x, y)
 
 #else
 
 #define PERF_DEFINE_COUNTER(x)
 #define PERF_INIT_COUNTER(x, id)
+#define PERF_INIT_STATS_COUNTER(x, id)
 #define PERF_TIMED_SECTION_START(x)
 #define PERF_TIMED_SECTION_END(x)
 #define PERF_MEASURE_PERIOD(x)
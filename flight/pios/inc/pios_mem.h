@@ -33,4 +33,33 @@ void *pios_malloc(size_t size);
 
 void pios_free(void *p);
 
+#ifdef PIOS_INCLUDE_MEM_POOL
+/*
+ * Fixed size block pools, for small allocations that are freed and reallocated
+ * at runtime. Blocks are taken in O(1) from the smallest size class that fits,
+ * requests that do not fit any pool or find it exhausted fall back to pios_malloc().
+ * The storage of the pools is allocated at once on first use, the number of blocks
+ * of each class can be set in pios_config.h.
+ */
+#define PIOS_MEM_POOL_NUM_CLASSES 4
+
+struct pios_mem_pool_stats {
+    uint16_t block_size;
+    uint16_t blocks;
+    uint16_t free;
+    uint16_t min_free;
+    uint16_t fallbacks; // requests of this class served by pios_malloc()
+};
+
+void *pios_pool_malloc(size_t size);
+
+void pios_pool_free(void *p);
+
+void pios_pool_get_stats(uint8_t size_class, struct pios_mem_pool_stats *stats);
+
+#else
+#define pios_pool_malloc(size) pios_malloc(size)
+#define pios_pool_free(p)      pios_free(p)
+#endif /* PIOS_INCLUDE_MEM_POOL */
+
 #endif /* PIOS_MEM_H */
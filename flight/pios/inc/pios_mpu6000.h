@@ -143,6 +143,32 @@ struct pios_mpu6000_data {
     int16_t temperature;
 };
 
+/* Largest number of samples delivered in one block in burst mode */
+#ifndef PIOS_MPU6000_BLOCK_SAMPLES
+#define PIOS_MPU6000_BLOCK_SAMPLES 16
+#endif
+
+struct pios_mpu6000_block {
+    uint32_t timestamp; /* PIOS_DELAY raw time of the interrupt of the newest sample */
+    uint16_t sample_period_us; /* time between two samples */
+    uint8_t  count; /* number of samples, the oldest first */
+    struct pios_mpu6000_data samples[PIOS_MPU6000_BLOCK_SAMPLES];
+};
+
+/* Sum of the samples since the last PIOS_MPU6000_ReadSum() in accumulate mode */
+struct pios_mpu6000_sum {
+    int32_t  gyro_x;
+    int32_t  gyro_y;
+    int32_t  gyro_z;
+#if defined(PIOS_MPU6000_ACCEL)
+    int32_t  accel_x;
+    int32_t  accel_y;
+    int32_t  accel_z;
+#endif /* PIOS_MPU6000_ACCEL */
+    int32_t  temperature;
+    uint16_t count; /* number of samples summed */
+};
+
 struct pios_mpu6000_cfg {
     const struct pios_exti_cfg *exti_cfg; /* Pointer to the EXTI configuration */
 
@@ -162,12 +188,21 @@ struct pios_mpu6000_cfg {
     SPIPrescalerTypeDef fast_prescaler;
     SPIPrescalerTypeDef std_prescaler;
     uint8_t max_downsample;
+    /* Burst mode if > 1, requires PIOS_MPU6000_USERCTL_FIFO_EN: the FIFO is read in a single transfer
+     * every burst_samples samples and delivered as a block (PIOS_MPU6000_GetBlockQueue()) instead of
+     * one sample at a time (PIOS_MPU6000_GetQueue()) */
+    uint8_t burst_samples;
+    /* Accumulate mode, for one reader at a fixed rate: the samples are summed in the interrupt and
+     * read with PIOS_MPU6000_ReadSum(), no queue is used.  Ignored in burst mode */
+    bool    accumulate;
 };
 
 /* Public Functions */
 extern int32_t PIOS_MPU6000_Init(uint32_t spi_id, uint32_t slave_num, const struct pios_mpu6000_cfg *new_cfg);
 extern int32_t PIOS_MPU6000_ConfigureRanges(enum pios_mpu6000_range gyroRange, enum pios_mpu6000_accel_range accelRange, enum pios_mpu6000_filter filterSetting);
 extern xQueueHandle PIOS_MPU6000_GetQueue();
+extern xQueueHandle PIOS_MPU6000_GetBlockQueue();
+extern int32_t PIOS_MPU6000_ReadSum(struct pios_mpu6000_sum *sum);
 extern int32_t PIOS_MPU6000_ReadGyros(struct pios_mpu6000_data *buffer);
 extern int32_t PIOS_MPU6000_ReadID();
 extern int32_t PIOS_MPU6000_Test();
@@ -64,6 +64,9 @@ enum pios_ms5611_osr {
     MS5611_OSR_4096 = 8,
 };
 
+/* Called once the conversion of a PIOS_MS5611_RequestADC() is started */
+typedef void (*pios_ms5611_request_callback)(int32_t status, bool *woken);
+
 /* Public Functions */
 extern void PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, int32_t i2c_device);
 extern int32_t PIOS_MS5611_StartADC(ConversionTypeTypeDef Type);
@@ -72,6 +75,9 @@ extern float PIOS_MS5611_GetTemperature(void);
 extern float PIOS_MS5611_GetPressure(void);
 extern int32_t PIOS_MS5611_Test();
 extern int32_t PIOS_MS5611_GetDelay();
+extern uint32_t PIOS_MS5611_GetDelayUs();
+extern int32_t PIOS_MS5611_RequestADC(ConversionTypeTypeDef Type, pios_ms5611_request_callback callback);
+extern int32_t PIOS_MS5611_ReadRequestedADC(ConversionTypeTypeDef *Type);
 
 #endif /* PIOS_MS5611_H */
 
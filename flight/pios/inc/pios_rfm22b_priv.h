@@ -41,6 +41,8 @@
 
 #define RFM22B_MAX_PACKET_LEN                     64
 #define RFM22B_NUM_CHANNELS                       250
+// The most frequency hopping channels used at any datarate
+#define RFM22B_MAX_HOP_CHANNELS                   16
 
 // ************************************
 
@@ -686,6 +688,9 @@ struct pios_rfm22b_dev {
     // ISR pending semaphore
     xSemaphoreHandle  isrPending;
 
+    // DMA burst transfer complete semaphore
+    xSemaphoreHandle  burstDone;
+
     // The COM callback functions.
     pios_com_callback rx_in_cb;
     uint32_t rx_in_context;
@@ -781,6 +786,28 @@ struct pios_rfm22b_dev {
     portTickType tx_complete_ticks;
     portTickType time_delta;
     bool         on_sync_channel;
+
+    // Step the datarate with the link quality, between min_datarate and max_datarate
+    bool         adaptive_datarate;
+    uint8_t      min_datarate;
+    uint8_t      max_datarate;
+    // coordinator: the datarate proposed to the remote, remote: the datarate acknowledged to the coordinator
+    uint8_t      link_datarate;
+    // The datarate to switch to between two packets
+    uint8_t      next_datarate;
+    // The link quality reported by the other modem
+    uint8_t      peer_quality;
+    // Channel indexes received badly here, and by the other modem
+    uint16_t     bad_channels;
+    uint16_t     peer_bad_channels;
+    // Receive error rate per channel index, 0 to 255
+    uint8_t      channel_loss[RFM22B_MAX_HOP_CHANNELS];
+    // Datarate evaluation state
+    uint8_t      rate_good_periods;
+    uint8_t      rate_pending_periods;
+    uint8_t      rate_backoff;
+    portTickType rate_eval_ticks;
+    portTickType peer_ticks;
 };
 
 
@@ -30,9 +30,25 @@
 #ifndef PIOS_SERVO_H
 #define PIOS_SERVO_H
 
+/* Maximum number of banks (channels sharing one timer) */
+#define PIOS_SERVO_MAX_BANKS 6
+
+/* Output mode of a bank, positions are given in PWM microseconds (1000-2000) in every mode */
+enum pios_servo_bank_mode {
+    PIOS_SERVO_BANK_MODE_PWM = 0, /* free running at the bank update rate */
+    PIOS_SERVO_BANK_MODE_ONESHOT125 = 1, /* one pulse of 125-250us per PIOS_Servo_Update() */
+    PIOS_SERVO_BANK_MODE_ONESHOT42  = 2, /* one pulse of 42-83us per PIOS_Servo_Update() */
+    PIOS_SERVO_BANK_MODE_MULTISHOT  = 3, /* one pulse of 5-25us per PIOS_Servo_Update() */
+    PIOS_SERVO_BANK_MODE_DSHOT150   = 4, /* one DShot frame per PIOS_Servo_Update(), needs an update DMA */
+    PIOS_SERVO_BANK_MODE_DSHOT300   = 5,
+    PIOS_SERVO_BANK_MODE_DSHOT600   = 6,
+};
+
 /* Public Functions */
 extern void PIOS_Servo_SetHz(const uint16_t *update_rates, uint8_t banks);
+extern void PIOS_Servo_SetBankMode(uint8_t bank, uint8_t mode);
 extern void PIOS_Servo_Set(uint8_t Servo, uint16_t Position);
+extern void PIOS_Servo_Update();
 
 #endif /* PIOS_SERVO_H */
 
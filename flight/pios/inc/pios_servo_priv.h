@@ -35,6 +35,13 @@
 #include <pios_stm32.h>
 #include <pios_tim_priv.h>
 
+/* Timer update DMA of a bank, used to burst the DShot frames into the compare registers */
+struct pios_servo_dma_cfg {
+    TIM_TypeDef *timer;
+    struct stm32_dma_chan dma; /* addresses and size are set by the driver */
+    uint32_t    flags; /* all flags of the stream, cleared before each frame */
+};
+
 struct pios_servo_cfg {
     TIM_TimeBaseInitTypeDef tim_base_init;
     TIM_OCInitTypeDef tim_oc_init;
@@ -42,6 +49,8 @@ struct pios_servo_cfg {
     uint32_t remap;
     const struct pios_tim_channel *channels;
     uint8_t  num_channels;
+    const struct pios_servo_dma_cfg *dma; /* optional, banks without one can not run DShot */
+    uint8_t  num_dma;
 };
 
 extern int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg);
@@ -42,6 +42,44 @@ typedef enum {
     PIOS_SPI_PRESCALER_256 = 7
 } SPIPrescalerTypeDef;
 
+/*
+ * Asynchronous transactions, for the architectures defining PIOS_SPI_HAS_TRANSACTIONS.
+ * A transaction selects its slave, runs its segments back to back by DMA and
+ * deselects the slave. The queued transactions of a bus are started from the
+ * DMA interrupt of the previous one, the high priority ones first, so a sensor
+ * read only waits for the end of the transaction in progress.
+ */
+enum pios_spi_priority {
+    PIOS_SPI_PRIORITY_HIGH = 0, /* sensor reads */
+    PIOS_SPI_PRIORITY_LOW,      /* bulk transfers */
+    PIOS_SPI_PRIORITY_COUNT
+};
+
+struct pios_spi_segment {
+    const uint8_t *send_buffer; /* NULL sends 0xFF */
+    uint8_t       *receive_buffer; /* NULL discards the received bytes */
+    uint16_t      len;
+};
+
+struct pios_spi_transaction;
+/* Called from the DMA interrupt once the slave is deselected, status is 0 or -4 on a CRC error */
+typedef void (*pios_spi_transaction_callback)(struct pios_spi_transaction *transaction, int32_t status, bool *woken);
+
+struct pios_spi_transaction {
+    uint32_t slave_id;
+    SPIPrescalerTypeDef prescaler;
+    const struct pios_spi_segment *segments;
+    uint8_t segment_count;
+    pios_spi_transaction_callback callback;
+    void    *context;
+
+    /* Private, used by the driver while the transaction is queued */
+    struct pios_spi_transaction *next;
+    uint8_t segment;
+    volatile bool pending;
+    int32_t status;
+};
+
 /* Public Functions */
 extern int32_t PIOS_SPI_SetClockSpeed(uint32_t spi_id, SPIPrescalerTypeDef spi_prescaler);
 extern int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, uint8_t pin_value);
@@ -54,6 +92,8 @@ extern int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id);
 extern int32_t PIOS_SPI_ReleaseBusISR(uint32_t spi_id, bool *woken);
 extern void    PIOS_SPI_IRQ_Handler(uint32_t spi_id);
 extern void    PIOS_SPI_SetPrescalar(uint32_t spi_id, uint32_t prescalar);
+extern int32_t PIOS_SPI_Submit(uint32_t spi_id, struct pios_spi_transaction *transaction, enum pios_spi_priority priority, bool *woken);
+extern int32_t PIOS_SPI_Transaction(uint32_t spi_id, struct pios_spi_transaction *transaction, enum pios_spi_priority priority);
 
 #endif /* PIOS_SPI_H */
 
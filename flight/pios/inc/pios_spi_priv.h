@@ -57,6 +57,10 @@ struct pios_spi_dev {
 #else
     uint8_t busy;
 #endif
+    /* Transaction queues, the bus is claimed while one of them runs */
+    struct pios_spi_transaction *queue_head[PIOS_SPI_PRIORITY_COUNT];
+    struct pios_spi_transaction *queue_tail[PIOS_SPI_PRIORITY_COUNT];
+    struct pios_spi_transaction *active;
 };
 
 extern int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg);
@@ -71,6 +71,14 @@ extern int32_t PIOS_TASK_MONITOR_UnregisterTask(uint16_t task_id);
  */
 extern bool PIOS_TASK_MONITOR_IsRunning(uint16_t task_id);
 
+/**
+ * Get the handle of a registered task.
+ *
+ * @param task_id The id of the task. Must be in the range [0, max_tasks-1].
+ * @return the task handle, 0 if the task is not registered.
+ */
+extern xTaskHandle PIOS_TASK_MONITOR_GetHandle(uint16_t task_id);
+
 /**
  * Information about a running task that has been registered
  * via a call to PIOS_TASK_MONITOR_Add().
@@ -80,10 +88,13 @@ struct pios_task_info {
     uint32_t stack_remaining;
     /** Flag indicating whether or not the task is running. */
     bool     is_running;
-    /** Percentage of cpu time used by the task since the last call
-     *  to PIOS_TASK_MONITOR_ForEachTask(). Low-load tasks may
+    /** Percentage of cpu time used by the task since it was last
+     *  reported by PIOS_TASK_MONITOR_ForEachTask(). Low-load tasks may
      *  report 0% load even though they have run during the interval. */
     uint8_t running_time_percentage;
+    /** Longest time in us the task ran without being switched out
+     *  since it was last reported by PIOS_TASK_MONITOR_ForEachTask(). */
+    uint32_t max_burst_us;
 };
 
 /**
@@ -104,6 +115,19 @@ typedef void (*TaskMonitorTaskInfoCallback)(uint16_t task_id, const struct pios_
  */
 extern void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *context);
 
+/**
+ * Iterate over count tasks starting from task_id first, to spread the
+ * iteration over several calls. The running time of each task is
+ * measured since it was last reported.
+ *
+ * @param first     The task_id to start from.
+ * @param count     The maximum number of tasks to report.
+ * @param callback  Called for each reported task.
+ * @param context   Context information passed to the callback.
+ * @return The task_id to start from on the next call, 0 once the last task was reported.
+ */
+extern uint16_t PIOS_TASK_MONITOR_ForEachTaskFrom(uint16_t first, uint16_t count, TaskMonitorTaskInfoCallback callback, void *context);
+
 /**
  * Return the idle task running time percentage.
  */
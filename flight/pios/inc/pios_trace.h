@@ -0,0 +1,121 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_trace.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      PiOS scheduling trace
+ *             Records task switches, callbacks, interrupts and event queue
+ *             overflows in a ring buffer for timeline analysis
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PIOS_TRACE_H
+#define PIOS_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Trace events, the argument of each event is:
+ * TASK_SWITCH     task handle switched in (low 24 bits)
+ * CALLBACK_START  callback id, as used for CallbackInfo (-1 for unmonitored callbacks)
+ * CALLBACK_END    callback id
+ * ISR_SPI         peripheral base address (low 24 bits)
+ * ISR_USART       peripheral base address (low 24 bits)
+ * ISR_TIMER       peripheral base address (low 24 bits)
+ * QUEUE_FULL      id of the object whose event was lost
+ * TASK_INFO       only produced by PIOS_TRACE_TaskInfo(), the time of the record
+ *                 holds the full task handle and the argument the TaskInfo index
+ */
+enum pios_trace_event {
+    PIOS_TRACE_TASK_SWITCH    = 1,
+    PIOS_TRACE_CALLBACK_START = 2,
+    PIOS_TRACE_CALLBACK_END   = 3,
+    PIOS_TRACE_ISR_SPI        = 4,
+    PIOS_TRACE_ISR_USART      = 5,
+    PIOS_TRACE_ISR_TIMER      = 6,
+    PIOS_TRACE_QUEUE_FULL     = 7,
+    PIOS_TRACE_TASK_INFO      = 8,
+};
+
+/**
+ * A trace record, time is PIOS_DELAY_GetRaw() when the event occurred,
+ * the event is in the most significant byte of data and its argument in
+ * the remaining 24 bits.
+ */
+struct pios_trace_record {
+    uint32_t time;
+    uint32_t data;
+};
+
+#define PIOS_TRACE_RECORD_EVENT(record) ((record)->data >> 24)
+#define PIOS_TRACE_RECORD_ARG(record)   ((record)->data & 0x00ffffff)
+
+#if defined(PIOS_INCLUDE_TRACE)
+
+#define PIOS_TRACE(event, arg) PIOS_TRACE_Record((event), (uint32_t)(arg))
+
+/**
+ * Append an event to the trace, may be called from any task or interrupt handler.
+ * Does nothing while the trace is disabled.
+ * @param[in] event the PIOS_TRACE_* event
+ * @param[in] arg argument of the event, only the low 24 bits are kept
+ */
+extern void PIOS_TRACE_Record(uint8_t event, uint32_t arg);
+
+/**
+ * Start or stop recording. The ring is kept when recording stops so that
+ * it can be read, starting again discards it.
+ * @param[in] enable true to record events
+ */
+extern void PIOS_TRACE_Enable(bool enable);
+
+/**
+ * @return true while events are recorded
+ */
+extern bool PIOS_TRACE_IsEnabled();
+
+/**
+ * @return number of records available to PIOS_TRACE_Read()
+ */
+extern uint32_t PIOS_TRACE_Count();
+
+/**
+ * Copy records of a stopped trace, oldest first
+ * @param[in] first index of the first record to copy
+ * @param[out] records destination
+ * @param[in] count maximum number of records to copy
+ * @return number of records copied, 0 while the trace is recording
+ */
+extern uint32_t PIOS_TRACE_Read(uint32_t first, struct pios_trace_record *records, uint32_t count);
+
+/**
+ * Build the record naming a task, to be stored along the trace
+ * @param[out] record filled with a PIOS_TRACE_TASK_INFO record
+ * @param[in] task_id TaskInfo index of the task
+ * @param[in] handle task handle
+ */
+extern void PIOS_TRACE_TaskInfo(struct pios_trace_record *record, uint16_t task_id, void *handle);
+
+#else /* if defined(PIOS_INCLUDE_TRACE) */
+
+#define PIOS_TRACE(event, arg)
+
+#endif /* if defined(PIOS_INCLUDE_TRACE) */
+
+#endif /* PIOS_TRACE_H */
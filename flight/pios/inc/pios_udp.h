@@ -31,5 +31,6 @@
 /* Global Types */
 
 /* Public Functions */
+extern void PIOS_UDP_SetPortOffset(uint16_t offset);
 
 #endif /* PIOS_UDP_H */
@@ -38,6 +38,20 @@
 
 extern const struct pios_com_driver pios_usart_com_driver;
 
+/*
+ * DMA transfers for a USART, STM32F4 only. The tx stream sends the tx fifo segments
+ * in place, the rx stream runs in circular mode into a buffer of rx_buffer_len bytes
+ * that is drained on its half and full transfer interrupts and on idle line.
+ * The stream interrupts must have the priority of the USART interrupt.
+ */
+struct pios_usart_dma_cfg {
+    struct stm32_dma_chan tx;
+    struct stm32_irq tx_irq; /* flags: transfer complete and error flags of the tx stream */
+    struct stm32_dma_chan rx;
+    struct stm32_irq rx_irq; /* flags: half, full transfer and error flags of the rx stream */
+    uint16_t rx_buffer_len;
+};
+
 struct pios_usart_cfg {
     USART_TypeDef     *regs;
     uint32_t remap; /* GPIO_Remap_* */
@@ -45,10 +59,13 @@ struct pios_usart_cfg {
     struct stm32_gpio rx;
     struct stm32_gpio tx;
     struct stm32_irq  irq;
+    const struct pios_usart_dma_cfg *dma; /* NULL for interrupt driven transfers */
 };
 
 extern int32_t PIOS_USART_Init(uint32_t *usart_id, const struct pios_usart_cfg *cfg);
 extern const struct pios_usart_cfg *PIOS_USART_GetConfig(uint32_t usart_id);
+extern void PIOS_USART_DMA_TxIrqHandler(uint32_t usart_id);
+extern void PIOS_USART_DMA_RxIrqHandler(uint32_t usart_id);
 
 #endif /* PIOS_USART_PRIV_H */
 
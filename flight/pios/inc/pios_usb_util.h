@@ -35,4 +35,27 @@
 
 uint8_t *PIOS_USB_UTIL_AsciiToUtf8(uint8_t *dst, uint8_t *src, uint16_t srclen);
 
+/* Data counters of an endpoint, updated from the USB interrupt */
+struct pios_usb_util_throughput {
+    volatile uint32_t bytes;
+    volatile uint32_t transfers;
+
+    /* Reference of the last PIOS_USB_UTIL_ThroughputRate() call */
+    uint32_t last_bytes;
+    uint32_t last_time;
+};
+
+struct pios_usb_util_stats {
+    uint32_t tx_bytes;
+    uint32_t tx_transfers;
+    uint32_t tx_rate; /* bytes per second since the last stats read */
+    uint32_t rx_bytes;
+    uint32_t rx_transfers;
+    uint32_t rx_rate;
+    uint32_t rx_dropped;
+};
+
+void PIOS_USB_UTIL_ThroughputAdd(struct pios_usb_util_throughput *throughput, uint16_t len);
+uint32_t PIOS_USB_UTIL_ThroughputRate(struct pios_usb_util_throughput *throughput);
+
 #endif /* PIOS_USB_UTIL_H */
@@ -31,9 +31,12 @@
 #include <stdint.h>
 #include <optypes.h>
 
+#ifndef PIOS_WS2811_NUMLEDS
 #define PIOS_WS2811_NUMLEDS 2
+#endif
 
 void PIOS_WS2811_setColorRGB(Color_t c, uint8_t led, bool update);
 void PIOS_WS2811_Update();
+bool PIOS_WS2811_UpdatePending();
 
 #endif /* PIOS_WS2811_H_ */
@@ -66,6 +66,11 @@
 /* PIOS board specific feature selection */
 #include "pios_config.h"
 
+/* Instrumentation can be left out of a build whatever the board configuration */
+#ifdef PIOS_EXCLUDE_INSTRUMENTATION
+#undef PIOS_INCLUDE_INSTRUMENTATION
+#endif
+
 /* PIOS board specific device configuration */
 #include "pios_board.h"
 
@@ -75,6 +80,7 @@
 /* #define PIOS_ENABLE_DEBUG_PINS */
 #include <pios_debug.h>
 #include <pios_debuglog.h>
+#include <pios_trace.h>
 
 /* PIOS common functions */
 #include <pios_crc.h>
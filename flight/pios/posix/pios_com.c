@@ -362,6 +362,116 @@ int32_t PIOS_COM_SendBuffer(uint32_t com_id, const uint8_t *buffer, uint16_t len
     return rc;
 }
 
+/**
+ * Sends several buffers over given port, one after the other
+ * (blocking function)
+ * \param[in] port COM port
+ * \param[in] iov buffers to send, they are not modified
+ * \param[in] count number of buffers
+ * \return -1 if port not available
+ * \return 0 on success
+ */
+int32_t PIOS_COM_SendVector(uint32_t com_id, const struct pios_com_iovec *iov, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        int32_t rc = PIOS_COM_SendBuffer(com_id, iov[i].data, iov[i].len);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Reserves space in the tx buffer for the caller to write a package in place,
+ * made of up to two regions when the space wraps around the end of the buffer
+ * (blocking function)
+ * \param[in] port COM port
+ * \param[in] len number of bytes to reserve
+ * \param[out] regions the regions to write, the second one is empty when not needed
+ * \return -1 if port not available or len larger than the tx buffer
+ * \return -3 if the space cannot be freed
+ * \return 0 on success
+ */
+int32_t PIOS_COM_TxReserve(uint32_t com_id, uint16_t len, struct pios_com_iovec regions[2])
+{
+    struct pios_com_dev *com_dev = PIOS_COM_find_dev(com_id);
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+
+    PIOS_Assert(com_dev->has_tx);
+
+    if (len > fifoBuf_getSize(&com_dev->tx)) {
+        return -1;
+    }
+
+    while (fifoBuf_getFree(&com_dev->tx) < len) {
+#if defined(PIOS_INCLUDE_FREERTOS)
+        /* Make sure the transmitter is running while we wait */
+        if (com_dev->driver->tx_start) {
+            (com_dev->driver->tx_start)(com_dev->lower_id,
+                                        fifoBuf_getUsed(&com_dev->tx));
+        }
+        if (xSemaphoreTake(com_dev->tx_sem, portMAX_DELAY) != pdTRUE) {
+            return -3;
+        }
+#else
+        return -3;
+#endif
+    }
+
+    PIOS_IRQ_Disable();
+    regions[0].len = fifoBuf_getFreePtr(&com_dev->tx, &regions[0].data);
+    PIOS_IRQ_Enable();
+    if (regions[0].len >= len) {
+        regions[0].len  = len;
+        regions[1].data = NULL;
+        regions[1].len  = 0;
+    } else {
+        regions[1].data = com_dev->tx.buf_ptr;
+        regions[1].len  = len - regions[0].len;
+    }
+
+    return 0;
+}
+
+/**
+ * Sends the package written in the space reserved by PIOS_COM_TxReserve()
+ * \param[in] port COM port
+ * \param[in] len number of bytes written, at most the reserved length, 0 to cancel
+ * \return -1 if port not available
+ * \return 0 on success
+ */
+int32_t PIOS_COM_TxCommit(uint32_t com_id, uint16_t len)
+{
+    struct pios_com_dev *com_dev = PIOS_COM_find_dev(com_id);
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        return -1;
+    }
+
+    PIOS_Assert(com_dev->has_tx);
+
+    if (len > 0) {
+        PIOS_IRQ_Disable();
+        fifoBuf_addData(&com_dev->tx, len);
+        PIOS_IRQ_Enable();
+
+        /* More data has been put in the tx buffer, make sure the tx is started */
+        if (com_dev->driver->tx_start) {
+            com_dev->driver->tx_start(com_dev->lower_id,
+                                      fifoBuf_getUsed(&com_dev->tx));
+        }
+    }
+
+    return 0;
+}
+
 /**
  * Sends a single character over given port
  * \param[in] port COM port
@@ -63,6 +63,8 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
     static struct timespec wait, rest;
 
+    // the simulation may run faster than the wall clock
+    uS /= ulPortGetTimeScale();
     wait.tv_sec  = 0;
     wait.tv_nsec = 1000 * uS;
     while (nanosleep(&wait, &rest) != 0) {
@@ -89,9 +91,10 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
     // for(int i = 0; i < mS; i++) {
     // PIOS_DELAY_WaituS(1000);
     static struct timespec wait, rest;
+    uint64_t uS = (uint64_t)mS * 1000 / ulPortGetTimeScale();
 
-    wait.tv_sec  = mS / 1000;
-    wait.tv_nsec = (mS % 1000) * 1000000;
+    wait.tv_sec  = uS / 1000000;
+    wait.tv_nsec = (uS % 1000000) * 1000;
     while (nanosleep(&wait, &rest) != 0) {
         wait = rest;
     }
@@ -109,6 +112,10 @@ uint32_t PIOS_DELAY_GetuS()
 {
     static struct timespec current;
 
+    // faster than real time, the time follows the scheduler ticks
+    if (ulPortGetTimeScale() > 1) {
+        return (uint32_t)ullPortGetVirtualTimeUS();
+    }
     clock_gettime(CLOCK_REALTIME, &current);
     return (current.tv_sec * 1000000) + (current.tv_nsec / 1000);
 }
@@ -52,6 +52,18 @@ void PIOS_Servo_Init(void)
 void PIOS_Servo_SetHz(const uint16_t *banks, uint8_t num_banks)
 {}
 
+/**
+ * Set the output mode of a bank
+ */
+void PIOS_Servo_SetBankMode(uint8_t bank, uint8_t mode)
+{}
+
+/**
+ * Start the pulses of the single pulse banks
+ */
+void PIOS_Servo_Update()
+{}
+
 /**
  * Set servo position
  * \param[in] Servo Servo number (0-7)
@@ -43,10 +43,16 @@ static uint16_t PIOS_DSM_RxInCallback(uint32_t context,
                                       uint16_t *headroom,
                                       bool *need_yield);
 static void PIOS_DSM_Supervisor(uint32_t dsm_id);
+#if defined(PIOS_INCLUDE_FREERTOS)
+static xSemaphoreHandle PIOS_DSM_Get_Semaphore(uint32_t rcvr_id, uint8_t channel);
+#endif
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_dsm_rcvr_driver = {
     .read = PIOS_DSM_Get,
+#if defined(PIOS_INCLUDE_FREERTOS)
+    .get_semaphore = PIOS_DSM_Get_Semaphore,
+#endif
 };
 
 enum pios_dsm_dev_magic {
@@ -70,6 +76,9 @@ struct pios_dsm_dev {
     enum pios_dsm_dev_magic   magic;
     const struct pios_dsm_cfg *cfg;
     struct pios_dsm_state     state;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreHandle new_frame_semaphore;
+#endif
 };
 
 /* Allocate DSM device descriptor */
@@ -239,9 +248,14 @@ stream_error:
     return -1;
 }
 
-/* Update decoder state processing input byte from the DSMx stream */
-static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
+/**
+ * Update decoder state processing input byte from the DSMx stream
+ * \return true when the byte completed a valid frame
+ */
+static bool PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 {
+    bool new_frame = false;
+
     struct pios_dsm_state *state = &(dsm_dev->state);
 
     if (state->frame_found) {
@@ -254,6 +268,7 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
                 if (!PIOS_DSM_UnrollChannels(dsm_dev)) {
                     /* data looking good */
                     state->failsafe_timer = 0;
+                    new_frame = true;
                 }
 
                 /* prepare for the next frame */
@@ -261,6 +276,8 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
             }
         }
     }
+
+    return new_frame;
 }
 
 /* Initialise DSM receiver interface */
@@ -283,6 +300,9 @@ int32_t PIOS_DSM_Init(uint32_t *dsm_id,
 
     /* Bind the configuration to the device instance */
     dsm_dev->cfg   = cfg;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    dsm_dev->new_frame_semaphore = 0;
+#endif
 
     /* Bind the receiver if requested */
     if (bind) {
@@ -316,9 +336,11 @@ static uint16_t PIOS_DSM_RxInCallback(uint32_t context,
 
     PIOS_Assert(valid);
 
+    bool new_frame = false;
+
     /* process byte(s) and clear receive timer */
     for (uint8_t i = 0; i < buf_len; i++) {
-        PIOS_DSM_UpdateState(dsm_dev, buf[i]);
+        new_frame |= PIOS_DSM_UpdateState(dsm_dev, buf[i]);
         dsm_dev->state.receive_timer = 0;
     }
 
@@ -327,8 +349,15 @@ static uint16_t PIOS_DSM_RxInCallback(uint32_t context,
         *headroom = DSM_FRAME_LENGTH;
     }
 
-    /* We never need a yield */
+    /* Wake up the task waiting for the frame */
     *need_yield = false;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (new_frame && dsm_dev->new_frame_semaphore) {
+        signed portBASE_TYPE pxHigherPriorityTaskWoken = pdFALSE;
+        xSemaphoreGiveFromISR(dsm_dev->new_frame_semaphore, &pxHigherPriorityTaskWoken);
+        *need_yield = (pxHigherPriorityTaskWoken == pdTRUE);
+    }
+#endif
 
     /* Always indicate that all bytes were consumed */
     return buf_len;
@@ -358,6 +387,25 @@ static int32_t PIOS_DSM_Get(uint32_t rcvr_id, uint8_t channel)
     return dsm_dev->state.channel_data[channel];
 }
 
+#if defined(PIOS_INCLUDE_FREERTOS)
+/**
+ * Get the semaphore given on every new valid frame, the same for all the channels
+ */
+static xSemaphoreHandle PIOS_DSM_Get_Semaphore(uint32_t rcvr_id, uint8_t channel)
+{
+    struct pios_dsm_dev *dsm_dev = (struct pios_dsm_dev *)rcvr_id;
+
+    if (!PIOS_DSM_Validate(dsm_dev) || channel >= PIOS_DSM_NUM_INPUTS) {
+        return 0;
+    }
+
+    if (dsm_dev->new_frame_semaphore == 0) {
+        vSemaphoreCreateBinary(dsm_dev->new_frame_semaphore);
+    }
+    return dsm_dev->new_frame_semaphore;
+}
+#endif /* if defined(PIOS_INCLUDE_FREERTOS) */
+
 /**
  * Input data supervisor is called periodically and provides
  * two functions: frame syncing and failsafe triggering.
@@ -35,10 +35,21 @@
 #include "pios_servo_priv.h"
 #include "pios_tim_priv.h"
 
+/* Timer clock of the banks in one of the single pulse modes, must divide the master clock */
+#define PIOS_SERVO_SINGLEPULSE_CLOCK 24000000
+#define PIOS_SERVO_SINGLEPULSE_MHZ   (PIOS_SERVO_SINGLEPULSE_CLOCK / 1000000)
+
 /* Private Function Prototypes */
+static uint8_t PIOS_Servo_Bank(TIM_TypeDef *timer);
+static uint32_t PIOS_Servo_PulseTicks(uint8_t mode, uint16_t position);
 
 static const struct pios_servo_cfg *servo_cfg;
 
+/* Banks in the order of the first channel using their timer */
+static TIM_TypeDef *bank_timer[PIOS_SERVO_MAX_BANKS];
+static uint8_t bank_mode[PIOS_SERVO_MAX_BANKS];
+static uint8_t num_banks;
+
 /**
  * Initialise Servos
  */
@@ -53,6 +64,15 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg)
     /* Store away the requested configuration */
     servo_cfg = cfg;
 
+    num_banks = 0;
+    for (uint8_t i = 0; i < cfg->num_channels; i++) {
+        if (PIOS_Servo_Bank(cfg->channels[i].timer) == num_banks && num_banks < PIOS_SERVO_MAX_BANKS) {
+            bank_timer[num_banks] = cfg->channels[i].timer;
+            bank_mode[num_banks]  = PIOS_SERVO_BANK_MODE_PWM;
+            num_banks++;
+        }
+    }
+
     /* Configure the channels to be in output compare mode */
     for (uint8_t i = 0; i < cfg->num_channels; i++) {
         const struct pios_tim_channel *chan = &cfg->channels[i];
@@ -87,6 +107,8 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg)
 
 /**
  * Set the servo update rate (Max 500Hz)
+ * Banks in a single pulse mode ignore their rate, they run a long period and
+ * are restarted by PIOS_Servo_Update().
  * \param[in] array of rates in Hz
  * \param[in] maximum number of banks
  */
@@ -99,27 +121,43 @@ void PIOS_Servo_SetHz(const uint16_t *speeds, uint8_t banks)
     TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure = servo_cfg->tim_base_init;
     TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
     TIM_TimeBaseStructure.TIM_CounterMode   = TIM_CounterMode_Up;
-    TIM_TimeBaseStructure.TIM_Prescaler     = (PIOS_MASTER_CLOCK / 1000000) - 1;
 
-    uint8_t set = 0;
-
-    for (uint8_t i = 0; (i < servo_cfg->num_channels) && (set < banks); i++) {
-        bool new = true;
-        const struct pios_tim_channel *chan = &servo_cfg->channels[i];
-
-        /* See if any previous channels use that same timer */
-        for (uint8_t j = 0; (j < i) && new; j++) {
-            new &= chan->timer != servo_cfg->channels[j].timer;
+    for (uint8_t set = 0; (set < num_banks) && (set < banks); set++) {
+        TIM_TypeDef *timer = bank_timer[set];
+        uint32_t clock     = 1000000;
+        if (bank_mode[set] != PIOS_SERVO_BANK_MODE_PWM) {
+            clock = PIOS_SERVO_SINGLEPULSE_CLOCK;
         }
 
-        if (new) {
+        TIM_TimeBaseStructure.TIM_Prescaler = (PIOS_MASTER_CLOCK / clock) - 1;
+
+        if (bank_mode[set] == PIOS_SERVO_BANK_MODE_PWM) {
             TIM_TimeBaseStructure.TIM_Period = ((1000000 / speeds[set]) - 1);
-            TIM_TimeBaseInit(chan->timer, &TIM_TimeBaseStructure);
-            set++;
+        } else {
+            // about 3ms, the pulse repeats on its own only if no update comes
+            TIM_TimeBaseStructure.TIM_Period = 0xFFFF;
         }
+        TIM_TimeBaseInit(timer, &TIM_TimeBaseStructure);
     }
 }
 
+/**
+ * Set the output mode of a bank, applied by the next PIOS_Servo_SetHz()
+ * \param[in] bank The bank number
+ * \param[in] mode One of pios_servo_bank_mode
+ */
+void PIOS_Servo_SetBankMode(uint8_t bank, uint8_t mode)
+{
+    if (bank >= num_banks) {
+        return;
+    }
+    // no DShot on this target
+    if (mode > PIOS_SERVO_BANK_MODE_MULTISHOT) {
+        mode = PIOS_SERVO_BANK_MODE_PWM;
+    }
+    bank_mode[bank] = mode;
+}
+
 /**
  * Set servo position
  * \param[in] Servo Servo number (0-7)
@@ -134,20 +172,76 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
 
     /* Update the position */
     const struct pios_tim_channel *chan = &servo_cfg->channels[servo];
+    uint8_t bank = PIOS_Servo_Bank(chan->timer);
+    uint32_t ticks = position;
+    if (bank < num_banks && bank_mode[bank] != PIOS_SERVO_BANK_MODE_PWM) {
+        ticks = PIOS_Servo_PulseTicks(bank_mode[bank], position);
+    }
     switch (chan->timer_chan) {
     case TIM_Channel_1:
-        TIM_SetCompare1(chan->timer, position);
+        TIM_SetCompare1(chan->timer, ticks);
         break;
     case TIM_Channel_2:
-        TIM_SetCompare2(chan->timer, position);
+        TIM_SetCompare2(chan->timer, ticks);
         break;
     case TIM_Channel_3:
-        TIM_SetCompare3(chan->timer, position);
+        TIM_SetCompare3(chan->timer, ticks);
         break;
     case TIM_Channel_4:
-        TIM_SetCompare4(chan->timer, position);
+        TIM_SetCompare4(chan->timer, ticks);
         break;
     }
 }
 
+/**
+ * Start the pulses of all single pulse banks at once with the positions set since the last update.
+ * Called after all channels have been set, a pulse still running is restarted.
+ */
+void PIOS_Servo_Update()
+{
+    for (uint8_t i = 0; i < num_banks; i++) {
+        if (bank_mode[i] != PIOS_SERVO_BANK_MODE_PWM) {
+            // resets the counter and loads the preloaded compare values
+            TIM_GenerateEvent(bank_timer[i], TIM_EventSource_Update);
+        }
+    }
+}
+
+/**
+ * \return the bank of a timer, num_banks if it does not drive any
+ */
+static uint8_t PIOS_Servo_Bank(TIM_TypeDef *timer)
+{
+    uint8_t bank = 0;
+
+    while (bank < num_banks && bank_timer[bank] != timer) {
+        bank++;
+    }
+    return bank;
+}
+
+/**
+ * Convert a position in PWM microseconds to the pulse in timer ticks of a single pulse mode
+ */
+static uint32_t PIOS_Servo_PulseTicks(uint8_t mode, uint16_t position)
+{
+    switch (mode) {
+    case PIOS_SERVO_BANK_MODE_ONESHOT125:
+        return (uint32_t)position * PIOS_SERVO_SINGLEPULSE_MHZ / 8;
+
+    case PIOS_SERVO_BANK_MODE_ONESHOT42:
+        return (uint32_t)position * PIOS_SERVO_SINGLEPULSE_MHZ / 24;
+
+    case PIOS_SERVO_BANK_MODE_MULTISHOT:
+        // 5us + 1us per 50us above 1000
+        if (position < 1000) {
+            position = 1000;
+        }
+        return 5 * PIOS_SERVO_SINGLEPULSE_MHZ + (uint32_t)(position - 1000) * PIOS_SERVO_SINGLEPULSE_MHZ / 50;
+
+    default:
+        return position;
+    }
+}
+
 #endif /* PIOS_INCLUDE_SERVO */
@@ -35,5 +35,14 @@
 #define PIOS_ADC_STM32_TEMP_AVG_SLOPE 2.5f /* mV/C */
 #define PIOS_CONVERT_VOLT_TO_CPU_TEMP(x) ((x - PIOS_ADC_STM32_TEMP_V25) * 1000.0f / PIOS_ADC_STM32_TEMP_AVG_SLOPE + 25.0f)
 
+// the SPI driver queues the asynchronous transactions (PIOS_SPI_Submit)
+#define PIOS_SPI_HAS_TRANSACTIONS
+
+// the I2C driver queues the asynchronous requests (PIOS_I2C_Submit)
+#define PIOS_I2C_HAS_REQUESTS
+
+// the ADC driver hands the completed DMA buffers to the stream listeners (PIOS_ADC_AddStreamListener)
+#define PIOS_ADC_HAS_STREAM
+
 
 #endif /* PIOS_ARCHITECTURE_H */
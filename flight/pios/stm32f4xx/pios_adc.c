@@ -33,6 +33,8 @@
  * voltage and current values.  Samples are averaged over the period between
  * fetches so that relatively accurate measurements can be obtained without
  * forcing higher-level logic to poll aggressively.
+ * The consumers needing every sample (current integration, filtering) register
+ * a stream listener instead, called with each completed DMA buffer.
  *
  * @todo This module needs more work to be more generally useful.  It should
  * almost certainly grow callback support so that e.g. voltage and current readings
@@ -118,6 +120,12 @@ static struct adc_accumulator accumulator[PIOS_ADC_NUM_PINS];
 
 // Two buffers here for double buffering
 static uint16_t adc_raw_buffer[2][PIOS_ADC_MAX_SAMPLES][PIOS_ADC_NUM_PINS];
+
+static struct {
+    pios_adc_stream_callback callback;
+    void *context;
+} stream_listeners[PIOS_ADC_MAX_STREAM_LISTENERS];
+static uint8_t num_stream_listeners;
 #endif
 
 #if defined(PIOS_INCLUDE_ADC)
@@ -339,6 +347,31 @@ void PIOS_ADC_SetCallback(ADCCallback new_function)
     pios_adc_dev->callback_function = new_function;
 }
 
+/**
+ * @brief Add a listener called with the raw samples of each completed DMA buffer
+ * @param[in] callback called from the DMA interrupt, see pios_adc_stream_callback
+ * @param[in] context passed to the callback
+ * @return 0 on success, -1 if all the listeners are used
+ */
+int32_t PIOS_ADC_AddStreamListener(pios_adc_stream_callback callback, void *context)
+{
+#if defined(PIOS_INCLUDE_ADC)
+    if (!callback || num_stream_listeners >= PIOS_ADC_MAX_STREAM_LISTENERS) {
+        return -1;
+    }
+
+    /* Set the listener before publishing it to the interrupt */
+    stream_listeners[num_stream_listeners].context  = context;
+    stream_listeners[num_stream_listeners].callback = callback;
+    num_stream_listeners++;
+    return 0;
+
+#else
+    return -1;
+
+#endif
+}
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 /**
  * @brief Register a queue to add data to when downsampled
@@ -448,8 +481,19 @@ void PIOS_ADC_DMA_Handler(void)
         DMA_ClearITPendingBit(pios_adc_dev->cfg->dma.rx.channel, pios_adc_dev->cfg->full_flag);
 
         /* accumulate results from the buffer that was just completed */
-        accumulate(&adc_raw_buffer[DMA_GetCurrentMemoryTarget(pios_adc_dev->cfg->dma.rx.channel) ? 0 : 1][0][0],
-                   PIOS_ADC_MAX_SAMPLES);
+        uint16_t *buffer = &adc_raw_buffer[DMA_GetCurrentMemoryTarget(pios_adc_dev->cfg->dma.rx.channel) ? 0 : 1][0][0];
+        accumulate(buffer, PIOS_ADC_MAX_SAMPLES);
+
+        /* and hand it as is to the stream listeners */
+        if (num_stream_listeners) {
+            bool woken = false;
+            for (uint8_t i = 0; i < num_stream_listeners; i++) {
+                stream_listeners[i].callback(buffer, PIOS_ADC_MAX_SAMPLES, PIOS_ADC_NUM_PINS, stream_listeners[i].context, &woken);
+            }
+#if defined(PIOS_INCLUDE_FREERTOS)
+            portEND_SWITCHING_ISR(woken ? pdTRUE : pdFALSE);
+#endif
+        }
     }
 #endif
 }
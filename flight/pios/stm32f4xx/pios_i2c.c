@@ -161,6 +161,12 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter);
 static void i2c_adapter_log_fault(enum pios_i2c_error_type type);
 static bool i2c_adapter_callback_handler(struct pios_i2c_adapter *i2c_adapter);
 
+static void i2c_adapter_record_stats(struct pios_i2c_adapter *i2c_adapter, uint16_t addr, int32_t status, uint32_t time_us);
+static void i2c_adapter_queue_start(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void i2c_adapter_queue_check_done(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void i2c_adapter_queue_check_stalled(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_queue_end_isr(struct pios_i2c_adapter *i2c_adapter);
+
 static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM_STATES] = {
     [I2C_STATE_FSM_FAULT] =             {
         .entry_fn   = go_fsm_fault,
@@ -992,11 +998,20 @@ int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg)
      * since the sem_ready mutex is used in the initial state.
      */
     vSemaphoreCreateBinary(i2c_adapter->sem_ready);
-    i2c_adapter->sem_busy = xSemaphoreCreateMutex();
+    /* Not a mutex, the request queue claims and releases the bus from the interrupts */
+    vSemaphoreCreateBinary(i2c_adapter->sem_busy);
 #else
     i2c_adapter->busy     = 0;
 #endif // USE_FREERTOS
 
+    /* No queued request */
+    i2c_adapter->queue_head = NULL;
+    i2c_adapter->queue_tail = NULL;
+    i2c_adapter->active     = NULL;
+#if defined(PIOS_I2C_DIAGNOSTICS)
+    memset(i2c_adapter->stats, 0, sizeof(i2c_adapter->stats));
+#endif
+
     /* Initialize the state machine */
     i2c_adapter_fsm_init(i2c_adapter);
 
@@ -1027,11 +1042,15 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
 
     bool semaphore_success = true;
 
+    /* A request which never completed would keep the bus */
+    i2c_adapter_queue_check_stalled(i2c_adapter);
+
 #ifdef USE_FREERTOS
     /* Lock the bus */
     portTickType timeout;
     timeout = i2c_adapter->cfg->transfer_timeout_ms / portTICK_RATE_MS;
     if (xSemaphoreTake(i2c_adapter->sem_busy, timeout) == pdFALSE) {
+        i2c_adapter_record_stats(i2c_adapter, txn_list[0].addr, -2, 0);
         return -2;
     }
 #else
@@ -1046,6 +1065,7 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
 
     PIOS_DEBUG_Assert(i2c_adapter->curr_state == I2C_STATE_STOPPED);
 
+    uint32_t start = PIOS_DELAY_GetRaw();
     i2c_adapter->first_txn  = &txn_list[0];
     i2c_adapter->last_txn   = &txn_list[num_txns - 1];
     i2c_adapter->active_txn = i2c_adapter->first_txn;
@@ -1105,10 +1125,16 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
     PIOS_IRQ_Enable();
 #endif /* USE_FREERTOS */
 
-    return !semaphore_success ? -2 :
-           i2c_adapter->bus_error ? -1 :
-           i2c_adapter->nack ? -3 :
-           0;
+    int32_t status = !semaphore_success ? -2 :
+                     i2c_adapter->bus_error ? -1 :
+                     i2c_adapter->nack ? -3 :
+                     0;
+    i2c_adapter_record_stats(i2c_adapter, txn_list[0].addr, status, PIOS_DELAY_DiffuS(start));
+
+    /* Start the requests queued during the transfer */
+    i2c_adapter_queue_start(i2c_adapter, NULL);
+
+    return status;
 }
 
 int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, void *callback)
@@ -1167,6 +1193,313 @@ int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn tx
     return !semaphore_success ? -2 : 0;
 }
 
+/**
+ * Records the result of a transfer in the statistics of its slave
+ * \param[in] i2c_adapter I2C adapter
+ * \param[in] addr address of the first transaction
+ * \param[in] status as returned by PIOS_I2C_Transfer()
+ * \param[in] time_us duration of the transfer
+ */
+static void i2c_adapter_record_stats(__attribute__((unused)) struct pios_i2c_adapter *i2c_adapter, __attribute__((unused)) uint16_t addr,
+                                     __attribute__((unused)) int32_t status, __attribute__((unused)) uint32_t time_us)
+{
+#if defined(PIOS_I2C_DIAGNOSTICS)
+    struct pios_i2c_device_stats *stats = NULL;
+
+    PIOS_IRQ_Disable();
+    /* The slots are used in order, a slave without transfer gets the first free one */
+    for (uint8_t i = 0; i < PIOS_I2C_STATS_DEVICES; i++) {
+        if (i2c_adapter->stats[i].transfers == 0) {
+            stats = &i2c_adapter->stats[i];
+            stats->addr = addr;
+            break;
+        }
+        if (i2c_adapter->stats[i].addr == addr) {
+            stats = &i2c_adapter->stats[i];
+            break;
+        }
+    }
+    if (stats) {
+        stats->transfers++;
+        switch (status) {
+        case -1:
+            stats->bus_errors++;
+            break;
+        case -2:
+            stats->timeouts++;
+            break;
+        case -3:
+            stats->nacks++;
+            break;
+        default:
+            break;
+        }
+        if (time_us > stats->max_time_us) {
+            stats->max_time_us = time_us;
+        }
+    }
+    PIOS_IRQ_Enable();
+#endif /* if defined(PIOS_I2C_DIAGNOSTICS) */
+}
+
+/**
+ * Claims the bus for the request queue, without waiting. Safe from the
+ * tasks and the interrupts.
+ * \param[in] i2c_adapter I2C adapter
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ * \return true if the bus has been claimed
+ */
+static bool i2c_adapter_queue_claim_bus(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+#ifdef USE_FREERTOS
+    signed portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+
+    if (xSemaphoreTakeFromISR(i2c_adapter->sem_busy, &higherPriorityTaskWoken) != pdTRUE) {
+        return false;
+    }
+    *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+#else
+    (void)woken;
+    if (i2c_adapter->busy) {
+        return false;
+    }
+    i2c_adapter->busy = 1;
+#endif /* USE_FREERTOS */
+    return true;
+}
+
+/**
+ * Releases the bus claimed by the request queue
+ * \param[in] i2c_adapter I2C adapter
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ */
+static void i2c_adapter_queue_release_bus(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+#ifdef USE_FREERTOS
+    signed portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+
+    xSemaphoreGiveFromISR(i2c_adapter->sem_busy, &higherPriorityTaskWoken);
+    *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+#else
+    (void)woken;
+    i2c_adapter->busy = 0;
+#endif /* USE_FREERTOS */
+}
+
+/**
+ * Removes the first queued request
+ * \param[in] i2c_adapter I2C adapter
+ * \return the request or NULL if the queue is empty
+ */
+static struct pios_i2c_request *i2c_adapter_queue_pop(struct pios_i2c_adapter *i2c_adapter)
+{
+    struct pios_i2c_request *request = i2c_adapter->queue_head;
+
+    if (request) {
+        i2c_adapter->queue_head = request->next;
+        if (!request->next) {
+            i2c_adapter->queue_tail = NULL;
+        }
+    }
+    return request;
+}
+
+/**
+ * Starts the transaction list of the active request, the bus is stopped
+ * \param[in] i2c_adapter I2C adapter
+ */
+static void i2c_adapter_queue_start_active(struct pios_i2c_adapter *i2c_adapter)
+{
+    struct pios_i2c_request *request = i2c_adapter->active;
+
+    PIOS_DEBUG_Assert(i2c_adapter->curr_state == I2C_STATE_STOPPED);
+
+    i2c_adapter->first_txn  = &request->txn_list[0];
+    i2c_adapter->last_txn   = &request->txn_list[request->num_txns - 1];
+    i2c_adapter->active_txn = i2c_adapter->first_txn;
+
+    request->start = PIOS_DELAY_GetRaw();
+    i2c_adapter->callback  = NULL;
+    i2c_adapter->bus_error = false;
+    i2c_adapter->nack = false;
+    i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START);
+}
+
+/**
+ * Starts the first queued request, if no request is active and the bus can be
+ * claimed. The request queue keeps the bus from one request to the next one,
+ * it is released once the queue is empty.
+ * \param[in] i2c_adapter I2C adapter
+ * \param[in,out] woken if non-NULL, set to true if a higher priority task is now eligible to run
+ */
+static void i2c_adapter_queue_start(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+    bool local_woken = false;
+
+    PIOS_IRQ_Disable();
+    if (!i2c_adapter->active && i2c_adapter->queue_head && i2c_adapter_queue_claim_bus(i2c_adapter, &local_woken)) {
+        i2c_adapter->active = i2c_adapter_queue_pop(i2c_adapter);
+        i2c_adapter_queue_start_active(i2c_adapter);
+    }
+    PIOS_IRQ_Enable();
+    if (woken) {
+        *woken = *woken || local_woken;
+    }
+}
+
+/**
+ * Completes the active request and starts the next queued one
+ * \param[in] i2c_adapter I2C adapter
+ * \param[in] status of the request, as returned by PIOS_I2C_Transfer()
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ */
+static void i2c_adapter_queue_complete(struct pios_i2c_adapter *i2c_adapter, int32_t status, bool *woken)
+{
+    struct pios_i2c_request *request = i2c_adapter->active;
+
+    i2c_adapter_record_stats(i2c_adapter, request->txn_list[0].addr, status, PIOS_DELAY_DiffuS(request->start));
+
+    PIOS_IRQ_Disable();
+    i2c_adapter->active = i2c_adapter_queue_pop(i2c_adapter);
+    if (i2c_adapter->active) {
+        i2c_adapter->active->start = PIOS_DELAY_GetRaw();
+    } else {
+        i2c_adapter_queue_release_bus(i2c_adapter, woken);
+    }
+    PIOS_IRQ_Enable();
+
+    /* The callback can submit the request again, it is queued after the next one */
+    request->pending = false;
+    if (request->callback) {
+        request->callback(request, status, woken);
+    }
+
+    if (i2c_adapter->active) {
+        i2c_adapter_queue_start_active(i2c_adapter);
+    }
+}
+
+/**
+ * Completes the active request once the FSM reached its end, from the interrupts
+ * \param[in] i2c_adapter I2C adapter
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ */
+static void i2c_adapter_queue_check_done(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+    if (!i2c_adapter->active || !i2c_adapter_fsm_terminated(i2c_adapter)) {
+        return;
+    }
+
+    /* The stop condition is sent within a bit time of the last event */
+    if (i2c_adapter_wait_for_stopped(i2c_adapter)) {
+        i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_STOPPED);
+    } else {
+        i2c_adapter_fsm_init(i2c_adapter);
+    }
+
+    i2c_adapter_queue_complete(i2c_adapter, i2c_adapter->bus_error ? -1 : i2c_adapter->nack ? -3 : 0, woken);
+}
+
+/**
+ * End of the I2C interrupts, completes the active request when it is done
+ * \param[in] i2c_adapter I2C adapter
+ */
+static void i2c_adapter_queue_end_isr(struct pios_i2c_adapter *i2c_adapter)
+{
+    bool woken = false;
+
+    i2c_adapter_queue_check_done(i2c_adapter, &woken);
+#ifdef USE_FREERTOS
+    portEND_SWITCHING_ISR(woken ? pdTRUE : pdFALSE);
+#endif
+}
+
+/**
+ * Aborts the active request if it did not complete within the transfer timeout,
+ * so that a lost interrupt or a slave holding the bus does not stop the queue.
+ * \param[in] i2c_adapter I2C adapter
+ */
+static void i2c_adapter_queue_check_stalled(struct pios_i2c_adapter *i2c_adapter)
+{
+    bool woken = false;
+
+    PIOS_IRQ_Disable();
+    if (i2c_adapter->active && PIOS_DELAY_DiffuS(i2c_adapter->active->start) > i2c_adapter->cfg->transfer_timeout_ms * 1000) {
+        i2c_adapter_fsm_init(i2c_adapter);
+        i2c_adapter_queue_complete(i2c_adapter, -2, &woken);
+    }
+    PIOS_IRQ_Enable();
+}
+
+/**
+ * Queues an asynchronous request, it is started at once if the bus is free.
+ * Safe from the tasks and the interrupts, the request, its transaction list and
+ * their buffers must stay valid until its callback.
+ * \param[in] i2c_id I2C adapter handle
+ * \param[in] request the request, with at least one transaction
+ * \param[in,out] woken if non-NULL, set to true if a higher priority task is now eligible to run
+ * \return 0 if the request is queued
+ * \return -1 if the request is invalid or already queued
+ */
+int32_t PIOS_I2C_Submit(uint32_t i2c_id, struct pios_i2c_request *request, bool *woken)
+{
+    struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+    if (!PIOS_I2C_validate(i2c_adapter) || !request || !request->txn_list || !request->num_txns) {
+        return -1;
+    }
+
+    i2c_adapter_queue_check_stalled(i2c_adapter);
+
+    PIOS_IRQ_Disable();
+    if (request->pending) {
+        PIOS_IRQ_Enable();
+        return -1;
+    }
+    request->pending = true;
+    request->next    = NULL;
+    if (i2c_adapter->queue_tail) {
+        i2c_adapter->queue_tail->next = request;
+    } else {
+        i2c_adapter->queue_head = request;
+    }
+    i2c_adapter->queue_tail = request;
+    i2c_adapter_queue_start(i2c_adapter, woken);
+    PIOS_IRQ_Enable();
+
+    return 0;
+}
+
+/**
+ * Copies the transfer statistics of the slaves of an adapter
+ * \param[in] i2c_id I2C adapter handle
+ * \param[out] stats array of max_devices statistics
+ * \param[in] max_devices size of the stats array
+ * \return the number of slaves copied
+ */
+uint8_t PIOS_I2C_GetDeviceStats(uint32_t i2c_id, struct pios_i2c_device_stats *stats, uint8_t max_devices)
+{
+    struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+    uint8_t count = 0;
+
+    if (!PIOS_I2C_validate(i2c_adapter)) {
+        return 0;
+    }
+
+#if defined(PIOS_I2C_DIAGNOSTICS)
+    PIOS_IRQ_Disable();
+    while (count < max_devices && count < PIOS_I2C_STATS_DEVICES && i2c_adapter->stats[count].transfers) {
+        stats[count] = i2c_adapter->stats[count];
+        count++;
+    }
+    PIOS_IRQ_Enable();
+#else
+    (void)stats;
+    (void)max_devices;
+#endif
+    return count;
+}
+
 void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 {
     struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
@@ -1296,7 +1629,7 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
     }
 
 skip_event:
-    ;
+    i2c_adapter_queue_end_isr(i2c_adapter);
 }
 
 
@@ -1327,6 +1660,8 @@ void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id)
         /* Fail hard on any errors for now */
         i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_BUS_ERROR);
     }
+
+    i2c_adapter_queue_end_isr(i2c_adapter);
 }
 
 #endif /* PIOS_INCLUDE_I2C */
@@ -38,13 +38,20 @@
  * data.  At the end of each transfer (NSS goes high) it makes sure to reset
  * the DMA counter to the beginning of each packet and swap to the next
  * buffer
+ *
+ * Each packet is a frame starting with the little endian length of the bytes
+ * that follow, in both directions.  The rest of the packet is not valid data,
+ * so it does not need clearing.  A length of 0xFFFF is an idle companion
+ * (nothing clocked out), any other length over the packet is a framing error.
  */
 
 #ifdef PIOS_INCLUDE_SPI
 
 #include <pios_overo_priv.h>
 
-#define PACKET_SIZE 1024
+#define PACKET_SIZE  1024
+#define FRAME_HEADER 2
+#define FRAME_IDLE   0xFFFF
 
 /* Provide a COM driver */
 static void PIOS_OVERO_RegisterRxCallback(uint32_t overo_id, pios_com_callback rx_in_cb, uint32_t context);
@@ -73,6 +80,7 @@ struct pios_overo_dev {
     uint32_t writing_offset;
 
     uint32_t packets;
+    uint32_t framing_errors;
 
     uint8_t  tx_buffer[2][PACKET_SIZE];
     uint8_t  rx_buffer[2][PACKET_SIZE];
@@ -86,6 +94,7 @@ struct pios_overo_dev {
 #if defined(PIOS_INCLUDE_FREERTOS)
 // ! Private methods
 static void PIOS_OVERO_WriteData(struct pios_overo_dev *overo_dev);
+static void PIOS_OVERO_ReadData(struct pios_overo_dev *overo_dev, uint8_t reading_buffer);
 static bool PIOS_OVERO_validate(struct pios_overo_dev *overo_dev);
 static struct pios_overo_dev *PIOS_OVERO_alloc(void);
 
@@ -108,18 +117,19 @@ static struct pios_overo_dev *PIOS_OVERO_alloc(void)
     overo_dev->tx_out_cb      = 0;
     overo_dev->tx_out_context = 0;
     overo_dev->packets = 0;
+    overo_dev->framing_errors = 0;
     overo_dev->magic   = PIOS_OVERO_DEV_MAGIC;
     return overo_dev;
 }
 
 /**
  * Take data from the PIOS_COM buffer and transfer it to the currently inactive DMA
- * circular buffer
+ * circular buffer, then write the frame length in front of it
  */
 static void PIOS_OVERO_WriteData(struct pios_overo_dev *overo_dev)
 {
-    // TODO: How do we protect against the DMA buffer swapping midway through adding data
-    // to this buffer.  If we were writing at the beginning it could cause a weird race.
+    // Only called from the DMA irq right after the swap, so the buffer
+    // is filled at once well before the DMA gets to it
     if (overo_dev->tx_out_cb) {
         int32_t max_bytes = PACKET_SIZE - overo_dev->writing_offset;
 
@@ -138,6 +148,39 @@ static void PIOS_OVERO_WriteData(struct pios_overo_dev *overo_dev)
             overo_dev->writing_offset += bytes_added;
         }
     }
+
+    uint8_t *frame = overo_dev->tx_buffer[overo_dev->writing_buffer];
+    uint16_t length = overo_dev->writing_offset - FRAME_HEADER;
+    frame[0] = length & 0xFF;
+    frame[1] = length >> 8;
+}
+
+/**
+ * Pass the frame received in the given DMA buffer to the PIOS_COM buffer
+ */
+static void PIOS_OVERO_ReadData(struct pios_overo_dev *overo_dev, uint8_t reading_buffer)
+{
+    uint8_t *frame  = overo_dev->rx_buffer[reading_buffer];
+    uint16_t length = frame[0] | (frame[1] << 8);
+
+    if (length == FRAME_IDLE || length == 0) {
+        return;
+    }
+    if (length > PACKET_SIZE - FRAME_HEADER) {
+        overo_dev->framing_errors++;
+        return;
+    }
+
+    if (overo_dev->rx_in_cb) {
+        bool rx_need_yield = false;
+        (void)(overo_dev->rx_in_cb)(overo_dev->rx_in_context, &frame[FRAME_HEADER], length, NULL, &rx_need_yield);
+
+#if defined(OVERO_USES_BLOCKING_WRITE)
+        if (rx_need_yield) {
+            vPortYieldFromISR();
+        }
+#endif
+    }
 }
 
 /**
@@ -155,23 +198,10 @@ void PIOS_OVERO_DMA_irq_handler(uint32_t overo_id)
     DMA_ClearFlag(overo_dev->cfg->dma.tx.channel, overo_dev->cfg->dma.irq.flags);
 
     overo_dev->writing_buffer = 1 - DMA_GetCurrentMemoryTarget(overo_dev->cfg->dma.tx.channel);
-    overo_dev->writing_offset = 0;
-
-/*	bool rx_need_yield;
-        // Get data from the Rx buffer and add to the fifo
-        (void) (overo_dev->rx_in_cb)(overo_dev->rx_in_context,
-                                                                 &overo_dev->rx_buffer[overo_dev->writing_buffer][0],
-                                                                PACKET_SIZE, NULL, &rx_need_yield);
-
-        if(rx_need_yield) {
-                vPortYieldFromISR();
-        }
+    overo_dev->writing_offset = FRAME_HEADER;
 
-        // Fill the buffer with known value to prevent rereading these bytes
-        memset(&overo_dev->rx_buffer[overo_dev->writing_buffer][0], 0xFF, PACKET_SIZE);
- */
-    // Fill the buffer with known value to prevent resending any bytes
-    memset(&overo_dev->tx_buffer[overo_dev->writing_buffer][0], 0xFF, PACKET_SIZE);
+    // Both channels swap together, the buffer just received is the one to write next
+    PIOS_OVERO_ReadData(overo_dev, overo_dev->writing_buffer);
 
     // Load any pending bytes from TX fifo
     PIOS_OVERO_WriteData(overo_dev);
@@ -200,7 +230,19 @@ int32_t PIOS_OVERO_GetWrittenBytes(uint32_t overo_id)
 
     PIOS_Assert(PIOS_OVERO_validate(overo_dev));
 
-    return overo_dev->writing_offset;
+    return overo_dev->writing_offset - FRAME_HEADER;
+}
+
+/**
+ * Number of frames received with an invalid length
+ */
+int32_t PIOS_OVERO_GetFramingErrors(uint32_t overo_id)
+{
+    struct pios_overo_dev *overo_dev = (struct pios_overo_dev *)overo_id;
+
+    PIOS_Assert(PIOS_OVERO_validate(overo_dev));
+
+    return overo_dev->framing_errors;
 }
 
 /**
@@ -221,10 +263,13 @@ int32_t PIOS_OVERO_Init(uint32_t *overo_id, const struct pios_overo_cfg *cfg)
     /* Bind the configuration to the device instance */
     overo_dev->cfg = cfg;
     overo_dev->writing_buffer = 1; // First writes to second buffer
+    overo_dev->writing_offset = FRAME_HEADER;
 
-    /* Put buffers to a known state */
+    /* Put buffers to a known state, empty frames until the first swap */
     memset(&overo_dev->tx_buffer[0][0], 0xFF, PACKET_SIZE);
     memset(&overo_dev->tx_buffer[1][0], 0xFF, PACKET_SIZE);
+    memset(&overo_dev->tx_buffer[0][0], 0, FRAME_HEADER);
+    memset(&overo_dev->tx_buffer[1][0], 0, FRAME_HEADER);
     memset(&overo_dev->rx_buffer[0][0], 0xFF, PACKET_SIZE);
     memset(&overo_dev->rx_buffer[1][0], 0xFF, PACKET_SIZE);
 
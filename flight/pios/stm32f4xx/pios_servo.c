@@ -35,10 +35,45 @@
 #include "pios_servo_priv.h"
 #include "pios_tim_priv.h"
 
+/* Timer clock of the banks in one of the single pulse modes, must divide both APB clocks */
+#define PIOS_SERVO_SINGLEPULSE_CLOCK 21000000
+#define PIOS_SERVO_SINGLEPULSE_MHZ   (PIOS_SERVO_SINGLEPULSE_CLOCK / 1000000)
+
+#define PIOS_SERVO_IS_DSHOT(mode)    ((mode) >= PIOS_SERVO_BANK_MODE_DSHOT150)
+
+/* 16 bits then two low bit times so the line idles low between the frames */
+#define DSHOT_FRAME_ROWS             18
+
 /* Private Function Prototypes */
+static uint8_t PIOS_Servo_Bank(TIM_TypeDef *timer);
+static uint32_t PIOS_Servo_PulseTicks(uint8_t mode, uint16_t position);
+#ifdef PIOS_INCLUDE_DSHOT
+static void PIOS_Servo_DShotSetup(uint8_t bank, uint32_t timer_clock);
+static void PIOS_Servo_DShotStop(uint8_t bank);
+static uint16_t PIOS_Servo_DShotPacket(uint16_t position);
+#endif
 
 static const struct pios_servo_cfg *servo_cfg;
 
+/* Banks in the order of the first channel using their timer */
+static TIM_TypeDef *bank_timer[PIOS_SERVO_MAX_BANKS];
+static uint8_t bank_mode[PIOS_SERVO_MAX_BANKS];
+static uint8_t num_banks;
+
+#ifdef PIOS_INCLUDE_DSHOT
+/* DShot state of a bank, the timer update DMA bursts one row of the frame into the compare registers per bit */
+struct dshot_bank {
+    const struct pios_servo_dma_cfg *dma;
+    uint32_t *frame; // DSHOT_FRAME_ROWS rows of one compare value per channel
+    uint16_t bit1; // high time of a 1 bit in timer ticks
+    uint16_t bit0; // high time of a 0 bit in timer ticks
+    uint8_t  first; // first timer channel (0 based) of the burst
+    uint8_t  count; // timer channels in the burst
+    uint16_t packet[4]; // next packet of each channel of the burst
+};
+static struct dshot_bank dshot_bank[PIOS_SERVO_MAX_BANKS];
+#endif
+
 /**
  * Initialise Servos
  */
@@ -53,6 +88,37 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg)
     /* Store away the requested configuration */
     servo_cfg = cfg;
 
+    num_banks = 0;
+    for (uint8_t i = 0; i < cfg->num_channels; i++) {
+        if (PIOS_Servo_Bank(cfg->channels[i].timer) == num_banks && num_banks < PIOS_SERVO_MAX_BANKS) {
+            bank_timer[num_banks] = cfg->channels[i].timer;
+            bank_mode[num_banks]  = PIOS_SERVO_BANK_MODE_PWM;
+            num_banks++;
+        }
+    }
+
+#ifdef PIOS_INCLUDE_DSHOT
+    for (uint8_t bank = 0; bank < num_banks; bank++) {
+        struct dshot_bank *dshot = &dshot_bank[bank];
+        uint8_t last = 0;
+        dshot->dma   = NULL;
+        dshot->first = 3;
+        for (uint8_t i = 0; i < cfg->num_dma; i++) {
+            if (cfg->dma[i].timer == bank_timer[bank]) {
+                dshot->dma = &cfg->dma[i];
+            }
+        }
+        for (uint8_t i = 0; i < cfg->num_channels; i++) {
+            if (cfg->channels[i].timer == bank_timer[bank]) {
+                uint8_t index = cfg->channels[i].timer_chan >> 2; // TIM_Channel_x is 4 * (x - 1)
+                dshot->first = MIN(dshot->first, index);
+                last = MAX(last, index);
+            }
+        }
+        dshot->count = last - dshot->first + 1;
+    }
+#endif
+
     /* Configure the channels to be in output compare mode */
     for (uint8_t i = 0; i < cfg->num_channels; i++) {
         const struct pios_tim_channel *chan = &cfg->channels[i];
@@ -87,6 +153,8 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg)
 
 /**
  * Set the servo update rate (Max 500Hz)
+ * Banks in a single pulse mode ignore their rate, they run a long period and
+ * are restarted by PIOS_Servo_Update().
  * \param[in] array of rates in Hz
  * \param[in] maximum number of banks
  */
@@ -101,32 +169,61 @@ void PIOS_Servo_SetHz(const uint16_t *speeds, uint8_t banks)
     TIM_TimeBaseStructure.TIM_CounterMode   = TIM_CounterMode_Up;
     //
 
-    uint8_t set = 0;
-
-    for (uint8_t i = 0; (i < servo_cfg->num_channels) && (set < banks); i++) {
-        bool new = true;
-        const struct pios_tim_channel *chan = &servo_cfg->channels[i];
+    for (uint8_t set = 0; (set < num_banks) && (set < banks); set++) {
+        TIM_TypeDef *timer   = bank_timer[set];
+        uint32_t timer_clock = PIOS_PERIPHERAL_APB1_CLOCK;
+        uint32_t clock = 1000000;
+        if (bank_mode[set] != PIOS_SERVO_BANK_MODE_PWM) {
+            clock = PIOS_SERVO_SINGLEPULSE_CLOCK;
+        }
 
-        /* See if any previous channels use that same timer */
-        for (uint8_t j = 0; (j < i) && new; j++) {
-            new &= chan->timer != servo_cfg->channels[j].timer;
+        // Choose the correct prescaler value for the APB the timer is attached
+        if (timer == TIM1 || timer == TIM8 || timer == TIM9 || timer == TIM10 || timer == TIM11) {
+            timer_clock = PIOS_PERIPHERAL_APB2_CLOCK;
         }
 
-        if (new) {
-            // Choose the correct prescaler value for the APB the timer is attached
-            if (chan->timer == TIM1 || chan->timer == TIM8 || chan->timer == TIM9 || chan->timer == TIM10 || chan->timer == TIM11) {
-                TIM_TimeBaseStructure.TIM_Prescaler = (PIOS_PERIPHERAL_APB2_CLOCK / 1000000) - 1;
-            } else {
-                TIM_TimeBaseStructure.TIM_Prescaler = (PIOS_PERIPHERAL_APB1_CLOCK / 1000000) - 1;
-            }
+#ifdef PIOS_INCLUDE_DSHOT
+        if (PIOS_SERVO_IS_DSHOT(bank_mode[set])) {
+            PIOS_Servo_DShotSetup(set, timer_clock);
+            continue;
+        }
+        PIOS_Servo_DShotStop(set);
+#endif
+        TIM_TimeBaseStructure.TIM_Prescaler = (timer_clock / clock) - 1;
 
+        if (bank_mode[set] == PIOS_SERVO_BANK_MODE_PWM) {
             TIM_TimeBaseStructure.TIM_Period = ((1000000 / speeds[set]) - 1);
-            TIM_TimeBaseInit(chan->timer, &TIM_TimeBaseStructure);
-            set++;
+        } else {
+            // about 3ms, the pulse repeats on its own only if no update comes
+            TIM_TimeBaseStructure.TIM_Period = 0xFFFF;
         }
+        TIM_TimeBaseInit(timer, &TIM_TimeBaseStructure);
     }
 }
 
+/**
+ * Set the output mode of a bank, applied by the next PIOS_Servo_SetHz()
+ * \param[in] bank The bank number
+ * \param[in] mode One of pios_servo_bank_mode
+ */
+void PIOS_Servo_SetBankMode(uint8_t bank, uint8_t mode)
+{
+    if (bank >= num_banks) {
+        return;
+    }
+    // DShot needs the update DMA of the bank timer
+    if (PIOS_SERVO_IS_DSHOT(mode)) {
+#ifdef PIOS_INCLUDE_DSHOT
+        if (!dshot_bank[bank].dma) {
+            mode = PIOS_SERVO_BANK_MODE_PWM;
+        }
+#else
+        mode = PIOS_SERVO_BANK_MODE_PWM;
+#endif
+    }
+    bank_mode[bank] = mode;
+}
+
 /**
  * Set servo position
  * \param[in] Servo Servo number (0-7)
@@ -141,20 +238,194 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
 
     /* Update the position */
     const struct pios_tim_channel *chan = &servo_cfg->channels[servo];
+    uint8_t bank = PIOS_Servo_Bank(chan->timer);
+    uint32_t ticks = position;
+#ifdef PIOS_INCLUDE_DSHOT
+    if (bank < num_banks && PIOS_SERVO_IS_DSHOT(bank_mode[bank])) {
+        // sent by the next PIOS_Servo_Update()
+        dshot_bank[bank].packet[(chan->timer_chan >> 2) - dshot_bank[bank].first] = PIOS_Servo_DShotPacket(position);
+        return;
+    }
+#endif
+    if (bank < num_banks && bank_mode[bank] != PIOS_SERVO_BANK_MODE_PWM) {
+        ticks = PIOS_Servo_PulseTicks(bank_mode[bank], position);
+    }
     switch (chan->timer_chan) {
     case TIM_Channel_1:
-        TIM_SetCompare1(chan->timer, position);
+        TIM_SetCompare1(chan->timer, ticks);
         break;
     case TIM_Channel_2:
-        TIM_SetCompare2(chan->timer, position);
+        TIM_SetCompare2(chan->timer, ticks);
         break;
     case TIM_Channel_3:
-        TIM_SetCompare3(chan->timer, position);
+        TIM_SetCompare3(chan->timer, ticks);
         break;
     case TIM_Channel_4:
-        TIM_SetCompare4(chan->timer, position);
+        TIM_SetCompare4(chan->timer, ticks);
         break;
     }
 }
 
+/**
+ * Start the pulses of all single pulse banks at once with the positions set since the last update.
+ * Called after all channels have been set, a pulse still running is restarted.
+ * DShot banks start a frame unless the previous one is still being sent.
+ */
+void PIOS_Servo_Update()
+{
+    for (uint8_t i = 0; i < num_banks; i++) {
+#ifdef PIOS_INCLUDE_DSHOT
+        if (PIOS_SERVO_IS_DSHOT(bank_mode[i])) {
+            struct dshot_bank *dshot   = &dshot_bank[i];
+            DMA_Stream_TypeDef *stream = dshot->dma->dma.channel;
+            if (stream->CR & DMA_SxCR_EN) {
+                continue;
+            }
+            for (uint8_t c = 0; c < dshot->count; c++) {
+                uint16_t packet = dshot->packet[c];
+                for (uint8_t bit = 0; bit < 16; bit++) {
+                    dshot->frame[bit * dshot->count + c] = (packet & (0x8000 >> bit)) ? dshot->bit1 : dshot->bit0;
+                }
+            }
+            DMA_ClearFlag(stream, dshot->dma->flags);
+            DMA_SetCurrDataCounter(stream, DSHOT_FRAME_ROWS * dshot->count);
+            // the first row is loaded by the next update event
+            DMA_Cmd(stream, ENABLE);
+            continue;
+        }
+#endif
+        if (bank_mode[i] != PIOS_SERVO_BANK_MODE_PWM) {
+            // resets the counter and loads the preloaded compare values
+            TIM_GenerateEvent(bank_timer[i], TIM_EventSource_Update);
+        }
+    }
+}
+
+/**
+ * \return the bank of a timer, num_banks if it does not drive any
+ */
+static uint8_t PIOS_Servo_Bank(TIM_TypeDef *timer)
+{
+    uint8_t bank = 0;
+
+    while (bank < num_banks && bank_timer[bank] != timer) {
+        bank++;
+    }
+    return bank;
+}
+
+/**
+ * Convert a position in PWM microseconds to the pulse in timer ticks of a single pulse mode
+ */
+static uint32_t PIOS_Servo_PulseTicks(uint8_t mode, uint16_t position)
+{
+    switch (mode) {
+    case PIOS_SERVO_BANK_MODE_ONESHOT125:
+        return (uint32_t)position * PIOS_SERVO_SINGLEPULSE_MHZ / 8;
+
+    case PIOS_SERVO_BANK_MODE_ONESHOT42:
+        return (uint32_t)position * PIOS_SERVO_SINGLEPULSE_MHZ / 24;
+
+    case PIOS_SERVO_BANK_MODE_MULTISHOT:
+        // 5us + 1us per 50us above 1000
+        if (position < 1000) {
+            position = 1000;
+        }
+        return 5 * PIOS_SERVO_SINGLEPULSE_MHZ + (uint32_t)(position - 1000) * PIOS_SERVO_SINGLEPULSE_MHZ / 50;
+
+    default:
+        return position;
+    }
+}
+
+#ifdef PIOS_INCLUDE_DSHOT
+/**
+ * Switch a bank to DShot: the timer period becomes one bit and its update DMA
+ * bursts one row of the frame into the compare registers per bit.
+ */
+static void PIOS_Servo_DShotSetup(uint8_t bank, uint32_t timer_clock)
+{
+    struct dshot_bank *dshot = &dshot_bank[bank];
+    TIM_TypeDef *timer = bank_timer[bank];
+    DMA_Stream_TypeDef *stream = dshot->dma->dma.channel;
+    uint32_t rate = 150000;
+
+    if (bank_mode[bank] == PIOS_SERVO_BANK_MODE_DSHOT300) {
+        rate = 300000;
+    } else if (bank_mode[bank] == PIOS_SERVO_BANK_MODE_DSHOT600) {
+        rate = 600000;
+    }
+
+    if (!dshot->frame) {
+        // the frame must not be in the CCM, the DMA can not reach it
+        dshot->frame = (uint32_t *)pios_malloc(DSHOT_FRAME_ROWS * dshot->count * sizeof(uint32_t));
+        if (!dshot->frame) {
+            bank_mode[bank] = PIOS_SERVO_BANK_MODE_PWM;
+            return;
+        }
+    }
+    memset(dshot->frame, 0, DSHOT_FRAME_ROWS * dshot->count * sizeof(uint32_t));
+    memset(dshot->packet, 0, sizeof(dshot->packet));
+
+    PIOS_Servo_DShotStop(bank);
+
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure = servo_cfg->tim_base_init;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode   = TIM_CounterMode_Up;
+    TIM_TimeBaseStructure.TIM_Prescaler     = 0;
+    TIM_TimeBaseStructure.TIM_Period = (timer_clock / rate) - 1;
+    TIM_TimeBaseInit(timer, &TIM_TimeBaseStructure);
+    dshot->bit1 = (timer_clock / rate) * 3 / 4;
+    dshot->bit0 = (timer_clock / rate) * 3 / 8;
+
+    // line low until the first frame
+    for (uint8_t c = 0; c < dshot->count; c++) {
+        (&timer->CCR1)[dshot->first + c] = 0; // CCR1 to CCR4 are consecutive
+    }
+
+    DMA_InitTypeDef init = dshot->dma->dma.init;
+    init.DMA_PeripheralBaseAddr = (uint32_t)&timer->DMAR;
+    init.DMA_Memory0BaseAddr    = (uint32_t)dshot->frame;
+    init.DMA_BufferSize         = DSHOT_FRAME_ROWS * dshot->count;
+    DMA_Init(stream, &init);
+
+    TIM_DMAConfig(timer, TIM_DMABase_CCR1 + dshot->first, (dshot->count - 1) << 8);
+    TIM_DMACmd(timer, TIM_DMA_Update, ENABLE);
+}
+
+/**
+ * Stop the DShot frames of a bank, if any
+ */
+static void PIOS_Servo_DShotStop(uint8_t bank)
+{
+    struct dshot_bank *dshot = &dshot_bank[bank];
+
+    if (!dshot->dma) {
+        return;
+    }
+    TIM_DMACmd(bank_timer[bank], TIM_DMA_Update, DISABLE);
+    DMA_Cmd(dshot->dma->dma.channel, DISABLE);
+    while (dshot->dma->dma.channel->CR & DMA_SxCR_EN) {
+        ;
+    }
+}
+
+/**
+ * Build the DShot packet of a position in PWM microseconds: 1000 and below stop the motor,
+ * above maps to the throttle range 48-2047. The telemetry bit is not used.
+ */
+static uint16_t PIOS_Servo_DShotPacket(uint16_t position)
+{
+    uint16_t throttle = 0;
+
+    if (position > 1000) {
+        throttle = MIN(48 + (uint32_t)(position - 1000) * (2047 - 48) / 1000, 2047);
+    }
+    uint16_t packet = throttle << 1;
+    uint16_t csum   = (packet ^ (packet >> 4) ^ (packet >> 8)) & 0xf;
+
+    return (packet << 4) | csum;
+}
+#endif /* PIOS_INCLUDE_DSHOT */
+
 #endif /* PIOS_INCLUDE_SERVO */
@@ -44,6 +44,8 @@
 
 #define SPI_MAX_BLOCK_PIO 128
 
+static void SPI_QueueStart(struct pios_spi_dev *spi_dev, bool *woken);
+
 static bool PIOS_SPI_validate(__attribute__((unused)) struct pios_spi_dev *com_dev)
 {
     /* Should check device magic here */
@@ -98,6 +100,13 @@ int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg)
     /* Disable callback function */
     spi_dev->callback = NULL;
 
+    /* No queued transaction */
+    for (uint8_t priority = 0; priority < PIOS_SPI_PRIORITY_COUNT; priority++) {
+        spi_dev->queue_head[priority] = NULL;
+        spi_dev->queue_tail[priority] = NULL;
+    }
+    spi_dev->active = NULL;
+
     /* Set rx/tx dummy bytes to a known value */
     spi_dev->rx_dummy_byte = 0xFF;
     spi_dev->tx_dummy_byte = 0xFF;
@@ -335,6 +344,8 @@ int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id)
     spi_dev->busy = 0;
     PIOS_IRQ_Enable();
 #endif
+    /* Start the transactions queued while the bus was claimed */
+    SPI_QueueStart(spi_dev, NULL);
     return 0;
 }
 
@@ -358,6 +369,8 @@ int32_t PIOS_SPI_ReleaseBusISR(uint32_t spi_id, bool *woken)
     if (woken) {
         *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
     }
+    /* Start the transactions queued while the bus was claimed */
+    SPI_QueueStart(spi_dev, woken);
     return 0;
 
 #else
@@ -444,36 +457,18 @@ int32_t PIOS_SPI_TransferByte(uint32_t spi_id, uint8_t b)
 }
 
 /**
- * Transfers a block of bytes via DMA.
- * \param[in] spi SPI number (0 or 1)
- * \param[in] send_buffer pointer to buffer which should be sent.<BR>
- * If NULL, 0xff (all-one) will be sent.
- * \param[in] receive_buffer pointer to buffer which should get the received values.<BR>
- * If NULL, received bytes will be discarded.
- * \param[in] len number of bytes which should be transfered
- * \param[in] callback pointer to callback function which will be executed
- * from DMA channel interrupt once the transfer is finished.
- * If NULL, no callback function will be used, and PIOS_SPI_TransferBlock() will
- * block until the transfer is finished.
- * \return >= 0 if no error during transfer
- * \return -1 if disabled SPI port selected
- * \return -3 if function has been called during an ongoing DMA transfer
+ * Configures the SPI block and the DMA channels for a block transfer and starts it.
+ * \param[in] spi_dev SPI device
+ * \param[in] init SPI configuration of the transfer
+ * \param[in] send_buffer buffer to send, NULL sends 0xff
+ * \param[in] receive_buffer buffer of the received bytes, NULL discards them
+ * \param[in] len number of bytes to transfer
+ * \param[in] interrupt enable the DMA transfer complete interrupt
  */
-static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, void *callback)
+static void SPI_DMA_Start(struct pios_spi_dev *spi_dev, const SPI_InitTypeDef *init, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, bool interrupt)
 {
-    struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
-
-    bool valid = PIOS_SPI_validate(spi_dev);
-
-    PIOS_Assert(valid)
-
     DMA_InitTypeDef dma_init;
 
-    /* Exit if ongoing transfer */
-    if (DMA_GetCurrDataCounter(spi_dev->cfg->dma.rx.channel)) {
-        return -3;
-    }
-
     /* Disable the DMA channels */
     DMA_Cmd(spi_dev->cfg->dma.rx.channel, DISABLE);
     DMA_Cmd(spi_dev->cfg->dma.tx.channel, DISABLE);
@@ -488,7 +483,7 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
     /* Disable the SPI peripheral */
     /* Initialize the SPI block */
     SPI_DeInit(spi_dev->cfg->regs);
-    SPI_Init(spi_dev->cfg->regs, (SPI_InitTypeDef *)&(spi_dev->cfg->init));
+    SPI_Init(spi_dev->cfg->regs, (SPI_InitTypeDef *)init);
     SPI_Cmd(spi_dev->cfg->regs, DISABLE);
     /* Configure CRC calculation */
     if (spi_dev->cfg->use_crc) {
@@ -500,9 +495,6 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
     /* Enable SPI interrupts to DMA */
     SPI_I2S_DMACmd(spi_dev->cfg->regs, SPI_I2S_DMAReq_Tx | SPI_I2S_DMAReq_Rx, ENABLE);
 
-    /* Set callback function */
-    spi_dev->callback = callback;
-
     /*
      * Configure Rx channel
      */
@@ -555,8 +547,8 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
 
     DMA_Init(spi_dev->cfg->dma.tx.channel, &(dma_init));
 
-    /* Enable DMA interrupt if callback function active */
-    DMA_ITConfig(spi_dev->cfg->dma.rx.channel, DMA_IT_TC, (callback != NULL) ? ENABLE : DISABLE);
+    /* Enable DMA interrupt if a callback or a transaction is waiting for the end of the transfer */
+    DMA_ITConfig(spi_dev->cfg->dma.rx.channel, DMA_IT_TC, interrupt ? ENABLE : DISABLE);
 
     /* Flush out the CRC registers */
     SPI_CalculateCRC(spi_dev->cfg->regs, DISABLE);
@@ -577,6 +569,41 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
 
     /* Reenable the SPI device */
     SPI_Cmd(spi_dev->cfg->regs, ENABLE);
+}
+
+/**
+ * Transfers a block of bytes via DMA.
+ * \param[in] spi SPI number (0 or 1)
+ * \param[in] send_buffer pointer to buffer which should be sent.<BR>
+ * If NULL, 0xff (all-one) will be sent.
+ * \param[in] receive_buffer pointer to buffer which should get the received values.<BR>
+ * If NULL, received bytes will be discarded.
+ * \param[in] len number of bytes which should be transfered
+ * \param[in] callback pointer to callback function which will be executed
+ * from DMA channel interrupt once the transfer is finished.
+ * If NULL, no callback function will be used, and PIOS_SPI_TransferBlock() will
+ * block until the transfer is finished.
+ * \return >= 0 if no error during transfer
+ * \return -1 if disabled SPI port selected
+ * \return -3 if function has been called during an ongoing DMA transfer
+ */
+static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, void *callback)
+{
+    struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
+
+    bool valid = PIOS_SPI_validate(spi_dev);
+
+    PIOS_Assert(valid)
+
+    /* Exit if ongoing transfer */
+    if (DMA_GetCurrDataCounter(spi_dev->cfg->dma.rx.channel)) {
+        return -3;
+    }
+
+    /* Set callback function */
+    spi_dev->callback = callback;
+
+    SPI_DMA_Start(spi_dev, &spi_dev->cfg->init, send_buffer, receive_buffer, len, callback != NULL);
 
     if (callback) {
         /* User has requested a callback, don't wait for the transfer to complete. */
@@ -728,6 +755,217 @@ int32_t PIOS_SPI_Busy(uint32_t spi_id)
     return 0;
 }
 
+/**
+ * Claims the bus for the transaction queue, without waiting. Safe from the
+ * tasks and the interrupts.
+ * \param[in] spi_dev SPI device
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ * \return true if the bus has been claimed
+ */
+static bool SPI_QueueClaimBus(struct pios_spi_dev *spi_dev, bool *woken)
+{
+#if defined(PIOS_INCLUDE_FREERTOS)
+    signed portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+
+    if (xSemaphoreTakeFromISR(spi_dev->busy, &higherPriorityTaskWoken) != pdTRUE) {
+        return false;
+    }
+    *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+#else
+    (void)woken;
+    if (spi_dev->busy) {
+        return false;
+    }
+    spi_dev->busy = 1;
+#endif
+    return true;
+}
+
+/**
+ * Releases the bus claimed by the transaction queue
+ * \param[in] spi_dev SPI device
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ */
+static void SPI_QueueReleaseBus(struct pios_spi_dev *spi_dev, bool *woken)
+{
+#if defined(PIOS_INCLUDE_FREERTOS)
+    signed portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+
+    xSemaphoreGiveFromISR(spi_dev->busy, &higherPriorityTaskWoken);
+    *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+#else
+    (void)woken;
+    spi_dev->busy = 0;
+#endif
+}
+
+/**
+ * Starts the DMA transfer of the current segment of the active transaction
+ * \param[in] spi_dev SPI device
+ */
+static void SPI_QueueStartSegment(struct pios_spi_dev *spi_dev)
+{
+    struct pios_spi_transaction *transaction = spi_dev->active;
+    const struct pios_spi_segment *segment   = &transaction->segments[transaction->segment];
+    SPI_InitTypeDef init = spi_dev->cfg->init;
+
+    init.SPI_BaudRatePrescaler = ((uint16_t)transaction->prescaler & 7) << 3;
+    spi_dev->callback = NULL;
+    SPI_DMA_Start(spi_dev, &init, segment->send_buffer, segment->receive_buffer, segment->len, true);
+}
+
+/**
+ * Removes the first transaction of the highest priority queue
+ * \param[in] spi_dev SPI device
+ * \return the transaction or NULL if the queues are empty
+ */
+static struct pios_spi_transaction *SPI_QueuePop(struct pios_spi_dev *spi_dev)
+{
+    for (uint8_t priority = 0; priority < PIOS_SPI_PRIORITY_COUNT; priority++) {
+        struct pios_spi_transaction *transaction = spi_dev->queue_head[priority];
+        if (transaction) {
+            spi_dev->queue_head[priority] = transaction->next;
+            if (!transaction->next) {
+                spi_dev->queue_tail[priority] = NULL;
+            }
+            return transaction;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Starts the next queued transaction, if no transaction is active and the bus
+ * can be claimed. The same transaction queue keeps the bus from one transaction
+ * to the next one, it is released once the queues are empty.
+ * \param[in] spi_dev SPI device
+ * \param[in,out] woken if non-NULL, set to true if a higher priority task is now eligible to run
+ */
+static void SPI_QueueStart(struct pios_spi_dev *spi_dev, bool *woken)
+{
+    bool local_woken = false;
+
+    PIOS_IRQ_Disable();
+    if (!spi_dev->active && (spi_dev->queue_head[PIOS_SPI_PRIORITY_HIGH] || spi_dev->queue_head[PIOS_SPI_PRIORITY_LOW])
+        && SPI_QueueClaimBus(spi_dev, &local_woken)) {
+        spi_dev->active = SPI_QueuePop(spi_dev);
+        PIOS_SPI_RC_PinSet((uint32_t)spi_dev, spi_dev->active->slave_id, 0);
+        SPI_QueueStartSegment(spi_dev);
+    }
+    PIOS_IRQ_Enable();
+    if (woken) {
+        *woken = *woken || local_woken;
+    }
+}
+
+/**
+ * Handles the end of a DMA transfer of the active transaction, from the DMA interrupt:
+ * starts its next segment, or completes it and starts the next queued transaction.
+ * \param[in] spi_dev SPI device
+ * \param[in,out] woken set to true if a higher priority task is now eligible to run
+ */
+static void SPI_QueueTransferDone(struct pios_spi_dev *spi_dev, bool *woken)
+{
+    struct pios_spi_transaction *transaction = spi_dev->active;
+
+    if (SPI_I2S_GetFlagStatus(spi_dev->cfg->regs, SPI_FLAG_CRCERR)) {
+        transaction->status = -4;
+        SPI_I2S_ClearFlag(spi_dev->cfg->regs, SPI_FLAG_CRCERR);
+    }
+
+    if (++transaction->segment < transaction->segment_count) {
+        SPI_QueueStartSegment(spi_dev);
+        return;
+    }
+
+    PIOS_SPI_RC_PinSet((uint32_t)spi_dev, transaction->slave_id, 1);
+    transaction->pending = false;
+    if (transaction->callback) {
+        transaction->callback(transaction, transaction->status, woken);
+    }
+
+    PIOS_IRQ_Disable();
+    spi_dev->active = SPI_QueuePop(spi_dev);
+    if (spi_dev->active) {
+        PIOS_SPI_RC_PinSet((uint32_t)spi_dev, spi_dev->active->slave_id, 0);
+        SPI_QueueStartSegment(spi_dev);
+    } else {
+        SPI_QueueReleaseBus(spi_dev, woken);
+    }
+    PIOS_IRQ_Enable();
+}
+
+/**
+ * Queues an asynchronous transaction, it is started at once if the bus is free.
+ * Safe from the tasks and the interrupts, the transaction and its buffers must
+ * stay valid until its callback.
+ * \param[in] spi_id SPI device handle
+ * \param[in] transaction the transaction, with at least one segment
+ * \param[in] priority the high priority transactions are run before the low priority ones
+ * \param[in,out] woken if non-NULL, set to true if a higher priority task is now eligible to run
+ * \return 0 if the transaction is queued
+ * \return -1 if the transaction is invalid or already queued
+ */
+int32_t PIOS_SPI_Submit(uint32_t spi_id, struct pios_spi_transaction *transaction, enum pios_spi_priority priority, bool *woken)
+{
+    struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
+
+    bool valid = PIOS_SPI_validate(spi_dev);
+
+    PIOS_Assert(valid)
+    PIOS_Assert(priority < PIOS_SPI_PRIORITY_COUNT)
+
+    if (!transaction || !transaction->segment_count || transaction->pending ||
+        transaction->slave_id >= spi_dev->cfg->slave_count) {
+        return -1;
+    }
+    for (uint8_t n = 0; n < transaction->segment_count; n++) {
+        if (!transaction->segments[n].len) {
+            return -1;
+        }
+    }
+
+    transaction->next    = NULL;
+    transaction->segment = 0;
+    transaction->status  = 0;
+    transaction->pending = true;
+
+    PIOS_IRQ_Disable();
+    if (spi_dev->queue_tail[priority]) {
+        spi_dev->queue_tail[priority]->next = transaction;
+    } else {
+        spi_dev->queue_head[priority] = transaction;
+    }
+    spi_dev->queue_tail[priority] = transaction;
+    PIOS_IRQ_Enable();
+
+    SPI_QueueStart(spi_dev, woken);
+    return 0;
+}
+
+/**
+ * Queues a transaction and waits for its end, from a task.
+ * \param[in] spi_id SPI device handle
+ * \param[in] transaction the transaction, its callback is still called
+ * \param[in] priority the high priority transactions are run before the low priority ones
+ * \return 0 if no error
+ * \return -1 if the transaction is invalid or already queued
+ * \return -4 if the CRC check failed
+ */
+int32_t PIOS_SPI_Transaction(uint32_t spi_id, struct pios_spi_transaction *transaction, enum pios_spi_priority priority)
+{
+    if (PIOS_SPI_Submit(spi_id, transaction, priority, NULL) != 0) {
+        return -1;
+    }
+    while (transaction->pending) {
+#if defined(PIOS_INCLUDE_FREERTOS)
+        vTaskDelay(0);
+#endif
+        ;
+    }
+    return transaction->status;
+}
+
 void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
 {
     struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
@@ -736,6 +974,8 @@ void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
 
     PIOS_Assert(valid)
 
+    PIOS_TRACE(PIOS_TRACE_ISR_SPI, spi_dev->cfg->regs);
+
     // FIXME XXX Only RX channel or better clear flags for both channels?
     DMA_ClearFlag(spi_dev->cfg->dma.rx.channel, spi_dev->cfg->dma.irq.flags);
 
@@ -751,7 +991,14 @@ void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
         }
     }
 
-    if (spi_dev->callback != NULL) {
+    if (spi_dev->active) {
+        bool woken = false;
+
+        SPI_QueueTransferDone(spi_dev, &woken);
+#if defined(PIOS_INCLUDE_FREERTOS)
+        portEND_SWITCHING_ISR(woken ? pdTRUE : pdFALSE);
+#endif
+    } else if (spi_dev->callback != NULL) {
         bool crc_ok = true;
         uint8_t crc_val;
 
@@ -187,6 +187,8 @@ out_fail:
 
 static void PIOS_TIM_generic_irq_handler(TIM_TypeDef *timer)
 {
+    PIOS_TRACE(PIOS_TRACE_ISR_TIMER, timer);
+
     /* Iterate over all registered clients of the TIM layer to find channels on this timer */
     for (uint8_t i = 0; i < pios_tim_num_devs; i++) {
         const struct pios_tim_dev *tim_dev = &pios_tim_devs[i];
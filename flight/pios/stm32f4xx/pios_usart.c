@@ -38,10 +38,14 @@
 
 #include <pios_usart_priv.h>
 
+#define PIOS_INSTRUMENT_MODULE
+#include <pios_instrumentation_helper.h>
+
 /* Provide a COM driver */
 static void PIOS_USART_ChangeBaud(uint32_t usart_id, uint32_t baud);
 static void PIOS_USART_RegisterRxCallback(uint32_t usart_id, pios_com_callback rx_in_cb, uint32_t context);
 static void PIOS_USART_RegisterTxCallback(uint32_t usart_id, pios_com_callback tx_out_cb, uint32_t context);
+static void PIOS_USART_RegisterTxDmaCallback(uint32_t usart_id, pios_com_dma_callback tx_dma_cb, uint32_t context);
 static void PIOS_USART_TxStart(uint32_t usart_id, uint16_t tx_bytes_avail);
 static void PIOS_USART_RxStart(uint32_t usart_id, uint16_t rx_bytes_avail);
 
@@ -49,8 +53,9 @@ const struct pios_com_driver pios_usart_com_driver = {
     .set_baud   = PIOS_USART_ChangeBaud,
     .tx_start   = PIOS_USART_TxStart,
     .rx_start   = PIOS_USART_RxStart,
-    .bind_tx_cb = PIOS_USART_RegisterTxCallback,
-    .bind_rx_cb = PIOS_USART_RegisterRxCallback,
+    .bind_tx_cb     = PIOS_USART_RegisterTxCallback,
+    .bind_rx_cb     = PIOS_USART_RegisterRxCallback,
+    .bind_tx_dma_cb = PIOS_USART_RegisterTxDmaCallback,
 };
 
 enum pios_usart_dev_magic {
@@ -65,6 +70,17 @@ struct pios_usart_dev {
     uint32_t rx_in_context;
     pios_com_callback tx_out_cb;
     uint32_t tx_out_context;
+    pios_com_dma_callback tx_dma_cb;
+    uint32_t tx_dma_context;
+
+    uint16_t tx_dma_len; /* length of the segment being sent by DMA, 0 when idle */
+    uint8_t  *rx_dma_buf;
+    uint16_t rx_dma_tail; /* position in rx_dma_buf up to which data were passed on */
+
+    uint32_t irq_count; /* USART and DMA interrupts serviced */
+#if defined(PIOS_INCLUDE_INSTRUMENTATION)
+    PERF_DEFINE_COUNTER(irq_counter);
+#endif
 };
 
 static bool PIOS_USART_validate(struct pios_usart_dev *usart_dev)
@@ -113,6 +129,9 @@ static struct pios_usart_dev *PIOS_USART_alloc(void)
  * each physical IRQ to a specific registered device instance.
  */
 static void PIOS_USART_generic_irq_handler(uint32_t usart_id);
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev *usart_dev);
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev *usart_dev, bool *need_yield);
+static void PIOS_USART_DMA_RxDrain(struct pios_usart_dev *usart_dev, bool *need_yield);
 
 static uint32_t PIOS_USART_1_id;
 void USART1_IRQHandler(void) __attribute__((alias("PIOS_USART_1_irq_handler")));
@@ -216,8 +235,18 @@ int32_t PIOS_USART_Init(uint32_t *usart_id, const struct pios_usart_cfg *cfg)
         break;
     }
     NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->irq.init));
-    USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
-    USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
+    if (usart_dev->cfg->dma) {
+        if (PIOS_USART_DMA_Init(usart_dev)) {
+            goto out_fail;
+        }
+        /* Interrupts are only counted on the DMA ports, instrumentation counters are scarce */
+        PERF_INIT_COUNTER(usart_dev->irq_counter, 0x55530000 | ((uint32_t)usart_dev->cfg->regs & 0xFFFF));
+        /* The rx stream is drained on idle line, tx is started by PIOS_USART_TxStart */
+        USART_ITConfig(usart_dev->cfg->regs, USART_IT_IDLE, ENABLE);
+    } else {
+        USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
+        USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
+    }
 
     // FIXME XXX Clear / reset uart here - sends NUL char else
 
@@ -230,6 +259,42 @@ out_fail:
     return -1;
 }
 
+/**
+ * Set up the DMA streams of a USART, the rx stream is started right away
+ * \return 0 on success, -1 if the rx buffer could not be allocated
+ */
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev *usart_dev)
+{
+    const struct pios_usart_dma_cfg *dma = usart_dev->cfg->dma;
+    DMA_InitTypeDef dma_init;
+
+    usart_dev->rx_dma_buf = (uint8_t *)pios_malloc(dma->rx_buffer_len);
+    if (!usart_dev->rx_dma_buf) {
+        return -1;
+    }
+
+    /* Tx, the memory address and length are set for each segment */
+    DMA_DeInit(dma->tx.channel);
+    DMA_Init(dma->tx.channel, (DMA_InitTypeDef *)&dma->tx.init);
+    DMA_ITConfig(dma->tx.channel, DMA_IT_TC, ENABLE);
+    NVIC_Init((NVIC_InitTypeDef *)&dma->tx_irq.init);
+
+    /* Rx, circular into the rx buffer */
+    dma_init = dma->rx.init;
+    dma_init.DMA_Memory0BaseAddr = (uint32_t)usart_dev->rx_dma_buf;
+    dma_init.DMA_BufferSize = dma->rx_buffer_len;
+    dma_init.DMA_Mode = DMA_Mode_Circular;
+    DMA_DeInit(dma->rx.channel);
+    DMA_Init(dma->rx.channel, &dma_init);
+    DMA_ITConfig(dma->rx.channel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+    NVIC_Init((NVIC_InitTypeDef *)&dma->rx_irq.init);
+    DMA_Cmd(dma->rx.channel, ENABLE);
+
+    USART_DMACmd(usart_dev->cfg->regs, USART_DMAReq_Tx | USART_DMAReq_Rx, ENABLE);
+
+    return 0;
+}
+
 static void PIOS_USART_RxStart(uint32_t usart_id, __attribute__((unused)) uint16_t rx_bytes_avail)
 {
     struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
@@ -238,6 +303,11 @@ static void PIOS_USART_RxStart(uint32_t usart_id, __attribute__((unused)) uint16
 
     PIOS_Assert(valid);
 
+    if (usart_dev->cfg->dma) {
+        /* The rx stream never stops */
+        PERF_TRACK_VALUE(usart_dev->irq_counter, usart_dev->irq_count);
+        return;
+    }
     USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
 }
 static void PIOS_USART_TxStart(uint32_t usart_id, __attribute__((unused)) uint16_t tx_bytes_avail)
@@ -248,6 +318,17 @@ static void PIOS_USART_TxStart(uint32_t usart_id, __attribute__((unused)) uint16
 
     PIOS_Assert(valid);
 
+    if (usart_dev->cfg->dma) {
+        PERF_TRACK_VALUE(usart_dev->irq_counter, usart_dev->irq_count);
+        /* Start a transfer unless one is running, the transfer complete interrupt chains the next ones */
+        bool need_yield = false;
+        PIOS_IRQ_Disable();
+        if (usart_dev->tx_dma_len == 0) {
+            PIOS_USART_DMA_TxNext(usart_dev, &need_yield);
+        }
+        PIOS_IRQ_Enable();
+        return;
+    }
     USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
 }
 
@@ -308,6 +389,127 @@ static void PIOS_USART_RegisterTxCallback(uint32_t usart_id, pios_com_callback t
     usart_dev->tx_out_cb = tx_out_cb;
 }
 
+static void PIOS_USART_RegisterTxDmaCallback(uint32_t usart_id, pios_com_dma_callback tx_dma_cb, uint32_t context)
+{
+    struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
+
+    bool valid = PIOS_USART_validate(usart_dev);
+
+    PIOS_Assert(valid);
+
+    /*
+     * Order is important in these assignments since ISR uses _cb
+     * field to determine if it's ok to dereference _cb and _context
+     */
+    usart_dev->tx_dma_context = context;
+    usart_dev->tx_dma_cb = tx_dma_cb;
+}
+
+/**
+ * Release the segment just sent and start sending the next one, if any.
+ * Called from the tx stream interrupt, or with interrupts disabled.
+ */
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+    DMA_Stream_TypeDef *stream = usart_dev->cfg->dma->tx.channel;
+    uint8_t *segment;
+    uint16_t len = 0;
+
+    if (usart_dev->tx_dma_cb) {
+        len = (usart_dev->tx_dma_cb)(usart_dev->tx_dma_context, usart_dev->tx_dma_len, &segment, need_yield);
+    }
+    usart_dev->tx_dma_len = len;
+
+    if (len > 0) {
+        DMA_ClearFlag(stream, usart_dev->cfg->dma->tx_irq.flags);
+        stream->M0AR = (uint32_t)segment;
+        stream->NDTR = len;
+        DMA_Cmd(stream, ENABLE);
+    }
+}
+
+/**
+ * Pass the data the rx stream has written since the last call to the COM layer,
+ * in two parts when they wrap around the end of the buffer.
+ * Data that do not fit in the rx fifo are dropped, as in interrupt mode.
+ */
+static void PIOS_USART_DMA_RxDrain(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+    uint16_t len  = usart_dev->cfg->dma->rx_buffer_len;
+    uint16_t head = len - DMA_GetCurrDataCounter(usart_dev->cfg->dma->rx.channel);
+    uint16_t tail = usart_dev->rx_dma_tail;
+    bool yield    = false;
+
+    if (head == len) {
+        head = 0;
+    }
+    if (head == tail) {
+        return;
+    }
+    if (usart_dev->rx_in_cb) {
+        if (head < tail) {
+            (void)(usart_dev->rx_in_cb)(usart_dev->rx_in_context, usart_dev->rx_dma_buf + tail, len - tail, NULL, &yield);
+            *need_yield |= yield;
+            tail = 0;
+        }
+        if (head > tail) {
+            (void)(usart_dev->rx_in_cb)(usart_dev->rx_in_context, usart_dev->rx_dma_buf + tail, head - tail, NULL, &yield);
+            *need_yield |= yield;
+        }
+    }
+    usart_dev->rx_dma_tail = head;
+}
+
+/**
+ * Transfer complete interrupt of the tx stream, to be mapped by the board
+ */
+void PIOS_USART_DMA_TxIrqHandler(uint32_t usart_id)
+{
+    struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
+
+    bool valid = PIOS_USART_validate(usart_dev);
+
+    PIOS_Assert(valid);
+    PIOS_Assert(usart_dev->cfg->dma);
+
+    usart_dev->irq_count++;
+    DMA_ClearFlag(usart_dev->cfg->dma->tx.channel, usart_dev->cfg->dma->tx_irq.flags);
+
+    bool need_yield = false;
+    PIOS_USART_DMA_TxNext(usart_dev, &need_yield);
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (need_yield) {
+        vPortYield();
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+}
+
+/**
+ * Half and full transfer interrupts of the rx stream, to be mapped by the board
+ */
+void PIOS_USART_DMA_RxIrqHandler(uint32_t usart_id)
+{
+    struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
+
+    bool valid = PIOS_USART_validate(usart_dev);
+
+    PIOS_Assert(valid);
+    PIOS_Assert(usart_dev->cfg->dma);
+
+    usart_dev->irq_count++;
+    DMA_ClearFlag(usart_dev->cfg->dma->rx.channel, usart_dev->cfg->dma->rx_irq.flags);
+
+    bool need_yield = false;
+    PIOS_USART_DMA_RxDrain(usart_dev, &need_yield);
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (need_yield) {
+        vPortYield();
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+}
+
 static void PIOS_USART_generic_irq_handler(uint32_t usart_id)
 {
     struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
@@ -316,6 +518,26 @@ static void PIOS_USART_generic_irq_handler(uint32_t usart_id)
 
     PIOS_Assert(valid);
 
+    PIOS_TRACE(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs);
+
+    usart_dev->irq_count++;
+
+    if (usart_dev->cfg->dma) {
+        /* Only the idle line interrupt is enabled, reading dr after sr clears it */
+        volatile uint16_t sr = usart_dev->cfg->regs->SR;
+        bool need_yield = false;
+        if (sr & USART_SR_IDLE) {
+            (void)usart_dev->cfg->regs->DR;
+            PIOS_USART_DMA_RxDrain(usart_dev, &need_yield);
+        }
+#if defined(PIOS_INCLUDE_FREERTOS)
+        if (need_yield) {
+            vPortYield();
+        }
+#endif /* PIOS_INCLUDE_FREERTOS */
+        return;
+    }
+
     /* Force read of dr after sr to make sure to clear error flags */
     volatile uint16_t sr = usart_dev->cfg->regs->SR;
     volatile uint8_t dr  = usart_dev->cfg->regs->DR;
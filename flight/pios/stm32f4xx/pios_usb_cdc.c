@@ -36,10 +36,22 @@
 #include "pios_usb_cdc_priv.h"
 #include "pios_usb_board_data.h" /* PIOS_BOARD_*_DATA_LENGTH */
 #include "pios_usbhook.h" /* PIOS_USBHOOK_* */
+#include "pios_usb_util.h" /* PIOS_USB_UTIL_Throughput* */
+
+/*
+ * Longest transfer sent straight from the COM tx fifo, the core splits it in
+ * full size packets and the endpoint fifo holds several of them, so that the
+ * host reads more than one packet per frame.
+ */
+#ifndef PIOS_USB_CDC_TX_SEGMENT_LEN
+#define PIOS_USB_CDC_TX_SEGMENT_LEN (8 * PIOS_USB_BOARD_CDC_DATA_LENGTH - 1)
+#endif
 
 /* Implement COM layer driver API */
 static void PIOS_USB_CDC_RegisterTxCallback(uint32_t usbcdc_id, pios_com_callback tx_out_cb, uint32_t context);
 static void PIOS_USB_CDC_RegisterRxCallback(uint32_t usbcdc_id, pios_com_callback rx_in_cb, uint32_t context);
+static void PIOS_USB_CDC_RegisterTxDmaCallback(uint32_t usbcdc_id, pios_com_dma_callback tx_dma_cb, uint32_t context);
+static void PIOS_USB_CDC_RegisterBaudRateCallback(uint32_t usbcdc_id, pios_com_baud_rate_callback baud_rate_cb, uint32_t context);
 static void PIOS_USB_CDC_TxStart(uint32_t usbcdc_id, uint16_t tx_bytes_avail);
 static void PIOS_USB_CDC_RxStart(uint32_t usbcdc_id, uint16_t rx_bytes_avail);
 static bool PIOS_USB_CDC_Available(uint32_t usbcdc_id);
@@ -49,6 +61,8 @@ const struct pios_com_driver pios_usb_cdc_com_driver = {
     .rx_start   = PIOS_USB_CDC_RxStart,
     .bind_tx_cb = PIOS_USB_CDC_RegisterTxCallback,
     .bind_rx_cb = PIOS_USB_CDC_RegisterRxCallback,
+    .bind_tx_dma_cb = PIOS_USB_CDC_RegisterTxDmaCallback,
+    .bind_baud_rate_cb = PIOS_USB_CDC_RegisterBaudRateCallback,
     .available  = PIOS_USB_CDC_Available,
 };
 
@@ -66,6 +80,12 @@ struct pios_usb_cdc_dev {
     uint32_t rx_in_context;
     pios_com_callback tx_out_cb;
     uint32_t tx_out_context;
+    pios_com_dma_callback tx_dma_cb;
+    uint32_t tx_dma_context;
+    pios_com_baud_rate_callback baud_rate_cb;
+    uint32_t baud_rate_context;
+    /* fifo segment being sent, released once sent */
+    uint16_t tx_dma_len;
 
     bool     usb_ctrl_if_enabled;
     bool     usb_data_if_enabled;
@@ -85,6 +105,8 @@ struct pios_usb_cdc_dev {
 
     uint32_t rx_dropped;
     uint32_t rx_oversize;
+    struct pios_usb_util_throughput tx_throughput;
+    struct pios_usb_util_throughput rx_throughput;
 
     /*
      * Used to hold the current state of the simulated UART.  Changes to this
@@ -205,23 +227,52 @@ out_fail:
     return -1;
 }
 
+/**
+ * Release the fifo segment just sent and get the next one, cut so that the transfer
+ * ends with a short packet and the host needs no zero length packet.
+ */
+static uint16_t PIOS_USB_CDC_NextSegment(struct pios_usb_cdc_dev *usb_cdc_dev, uint8_t **segment, bool *need_yield)
+{
+    uint16_t len = (usb_cdc_dev->tx_dma_cb)(usb_cdc_dev->tx_dma_context, usb_cdc_dev->tx_dma_len, segment, need_yield);
+
+    if (len > PIOS_USB_CDC_TX_SEGMENT_LEN) {
+        len = PIOS_USB_CDC_TX_SEGMENT_LEN;
+    }
+    if (len % PIOS_USB_BOARD_CDC_DATA_LENGTH == 0 && len > 0) {
+        len--;
+    }
+    usb_cdc_dev->tx_dma_len = len;
+
+    return len;
+}
+
 static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev *usb_cdc_dev)
 {
     uint16_t bytes_to_tx;
+    uint8_t *segment = usb_cdc_dev->tx_packet_buffer;
 
-    if (!usb_cdc_dev->tx_out_cb) {
+    bool need_yield = false;
+    if (usb_cdc_dev->tx_dma_cb) {
+        /* Send straight from the COM tx fifo */
+        bytes_to_tx = PIOS_USB_CDC_NextSegment(usb_cdc_dev, &segment, &need_yield);
+    } else if (usb_cdc_dev->tx_out_cb) {
+        bytes_to_tx = (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
+                                               usb_cdc_dev->tx_packet_buffer,
+                                               sizeof(usb_cdc_dev->tx_packet_buffer),
+                                               NULL,
+                                               &need_yield);
+    } else {
         return false;
     }
-
-    bool need_yield = false;
-    bytes_to_tx = (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
-                                           usb_cdc_dev->tx_packet_buffer,
-                                           sizeof(usb_cdc_dev->tx_packet_buffer),
-                                           NULL,
-                                           &need_yield);
     if (bytes_to_tx == 0) {
+#if defined(PIOS_INCLUDE_FREERTOS)
+        if (need_yield) {
+            vPortYield();
+        }
+#endif /* PIOS_INCLUDE_FREERTOS */
         return false;
     }
+    PIOS_USB_UTIL_ThroughputAdd(&usb_cdc_dev->tx_throughput, bytes_to_tx);
 
     /*
      * Mark this endpoint as being tx active _before_ actually transmitting
@@ -230,7 +281,7 @@ static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev *usb_cdc_dev)
     usb_cdc_dev->tx_active = true;
 
     PIOS_USBHOOK_EndpointTx(usb_cdc_dev->cfg->data_tx_ep,
-                            usb_cdc_dev->tx_packet_buffer,
+                            segment,
                             bytes_to_tx);
 
 #if defined(PIOS_INCLUDE_FREERTOS)
@@ -323,6 +374,63 @@ static void PIOS_USB_CDC_RegisterTxCallback(uint32_t usbcdc_id, pios_com_callbac
     usb_cdc_dev->tx_out_cb = tx_out_cb;
 }
 
+static void PIOS_USB_CDC_RegisterTxDmaCallback(uint32_t usbcdc_id, pios_com_dma_callback tx_dma_cb, uint32_t context)
+{
+    struct pios_usb_cdc_dev *usb_cdc_dev = (struct pios_usb_cdc_dev *)usbcdc_id;
+
+    bool valid = PIOS_USB_CDC_validate(usb_cdc_dev);
+
+    PIOS_Assert(valid);
+
+    /*
+     * Order is important in these assignments since ISR uses _cb
+     * field to determine if it's ok to dereference _cb and _context
+     */
+    usb_cdc_dev->tx_dma_context = context;
+    usb_cdc_dev->tx_dma_cb = tx_dma_cb;
+}
+
+static void PIOS_USB_CDC_RegisterBaudRateCallback(uint32_t usbcdc_id, pios_com_baud_rate_callback baud_rate_cb, uint32_t context)
+{
+    struct pios_usb_cdc_dev *usb_cdc_dev = (struct pios_usb_cdc_dev *)usbcdc_id;
+
+    bool valid = PIOS_USB_CDC_validate(usb_cdc_dev);
+
+    PIOS_Assert(valid);
+
+    /*
+     * Order is important in these assignments since ISR uses _cb
+     * field to determine if it's ok to dereference _cb and _context
+     */
+    usb_cdc_dev->baud_rate_context = context;
+    usb_cdc_dev->baud_rate_cb = baud_rate_cb;
+}
+
+/**
+ * Get the data counters of the interface
+ * \param[in] usbcdc_id USB CDC device
+ * \param[out] stats counters, the rates are the throughput since the last call
+ * \return 0 on success, -1 on invalid device
+ */
+int32_t PIOS_USB_CDC_GetStats(uint32_t usbcdc_id, struct pios_usb_util_stats *stats)
+{
+    struct pios_usb_cdc_dev *usb_cdc_dev = (struct pios_usb_cdc_dev *)usbcdc_id;
+
+    if (!PIOS_USB_CDC_validate(usb_cdc_dev)) {
+        return -1;
+    }
+
+    stats->tx_bytes     = usb_cdc_dev->tx_throughput.bytes;
+    stats->tx_transfers = usb_cdc_dev->tx_throughput.transfers;
+    stats->tx_rate      = PIOS_USB_UTIL_ThroughputRate(&usb_cdc_dev->tx_throughput);
+    stats->rx_bytes     = usb_cdc_dev->rx_throughput.bytes;
+    stats->rx_transfers = usb_cdc_dev->rx_throughput.transfers;
+    stats->rx_rate      = PIOS_USB_UTIL_ThroughputRate(&usb_cdc_dev->rx_throughput);
+    stats->rx_dropped   = usb_cdc_dev->rx_dropped;
+
+    return 0;
+}
+
 static bool PIOS_USB_CDC_CTRL_EP_IN_Callback(uint32_t usb_cdc_id, uint8_t epnum, uint16_t len);
 
 static void PIOS_USB_CDC_CTRL_IF_Init(uint32_t usb_cdc_id)
@@ -463,12 +571,13 @@ static void PIOS_USB_CDC_CTRL_IF_CtrlDataOut(uint32_t usb_cdc_id, const struct u
         switch (req->bRequest) {
         case USB_CDC_REQ_SET_LINE_CODING:
             /*
-             * If we cared to, this is where we would apply the new line coding
-             * that is now stored in the line_coding struct.  This could be used
-             * to notify the upper COM layer that the baud rate has changed.  This
-             * may be useful in the case of a COM USB bridge where we would
-             * auto-adjust the USART baud rate based on the line coding set here.
+             * The new line coding is now stored in the line_coding struct, notify
+             * the upper layer of the baud rate, e.g. for a COM USB bridge that
+             * follows it on its USART.
              */
+            if (usb_cdc_dev->baud_rate_cb) {
+                usb_cdc_dev->baud_rate_cb(usb_cdc_dev->baud_rate_context, htousbl(line_coding.dwDTERate));
+            }
             break;
         default:
             /* Unhandled class request */
@@ -552,8 +661,9 @@ static void PIOS_USB_CDC_DATA_IF_Init(uint32_t usb_cdc_id)
     }
 
     /* Register endpoint specific callbacks with the USBHOOK layer */
+    /* Full size packets, the transfers longer than a packet end with a short one */
     PIOS_USBHOOK_RegisterEpInCallback(usb_cdc_dev->cfg->data_tx_ep,
-                                      sizeof(usb_cdc_dev->tx_packet_buffer),
+                                      PIOS_USB_BOARD_CDC_DATA_LENGTH,
                                       PIOS_USB_CDC_DATA_EP_IN_Callback,
                                       (uint32_t)usb_cdc_dev);
     PIOS_USBHOOK_RegisterEpOutCallback(usb_cdc_dev->cfg->data_rx_ep,
@@ -653,6 +763,7 @@ static bool PIOS_USB_CDC_DATA_EP_OUT_Callback(
                                          &headroom,
                                          &need_yield);
 
+    PIOS_USB_UTIL_ThroughputAdd(&usb_cdc_dev->rx_throughput, len);
     if (bytes_rxed < len) {
         /* Lost bytes on rx */
         usb_cdc_dev->rx_dropped += (len - bytes_rxed);
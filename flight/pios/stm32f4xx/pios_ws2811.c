@@ -40,6 +40,12 @@
 static ledbuf_t *fb = 0;
 // bitmask with pin to be set/reset using dma
 static ledbuf_t dmaSource[4];
+// framebuffer values of the 4 bits of each nibble, msb first
+static ledbuf_t nibbleBits[16][4];
+// colors in the framebuffer, the led bits are only written again when they change
+static Color_t ledColors[PIOS_WS2811_NUMLEDS];
+// framebuffer changed since the last update
+static volatile bool fbChanged;
 
 static const struct pios_ws2811_cfg *pios_ws2811_cfg;
 static const struct pios_ws2811_pin_cfg *pios_ws2811_pin_cfg;
@@ -174,12 +180,19 @@ void PIOS_WS2811_Init(const struct pios_ws2811_cfg *ws2811_cfg, const struct pio
     for (uint8_t i = 0; i < 4; i++) {
         dmaSource[i] = (ledbuf_t)pios_ws2811_pin_cfg->gpioInit.GPIO_Pin;
     }
+    // a "0" bit resets the output early
+    for (uint8_t n = 0; n < 16; n++) {
+        for (uint8_t i = 0; i < 4; i++) {
+            nibbleBits[n][i] = ((n << i) & 0b1000) ? 0x0 : dmaSource[0];
+        }
+    }
 
     fb = (ledbuf_t *)pios_malloc(PIOS_WS2811_BUFFER_SIZE * sizeof(ledbuf_t));
     memset(fb, 0, PIOS_WS2811_BUFFER_SIZE * sizeof(ledbuf_t));
-    const Color_t ledoff = Color_Off;
     for (uint8_t i = 0; i < PIOS_WS2811_NUMLEDS; i++) {
-        PIOS_WS2811_setColorRGB(ledoff, i, false);
+        // the zeroed framebuffer is all "1" bits, write the led bits once
+        ledColors[i].R = ~Color_Off.R;
+        PIOS_WS2811_setColorRGB(Color_Off, i, false);
     }
     // Setup timers
     setupTimer();
@@ -287,13 +300,10 @@ void setupDMA()
     DMA_Cmd(pios_ws2811_cfg->streamUpdate, ENABLE);
 }
 
-void setColor(uint8_t color, ledbuf_t *buf)
+static void setColor(uint8_t color, ledbuf_t *buf)
 {
-    uint8_t i;
-
-    for (i = 0; i < 8; i++) {
-        buf[i] = ((color << i) & 0b10000000 ? 0x0 : dmaSource[0]);
-    }
+    memcpy(buf, nibbleBits[color >> 4], sizeof(nibbleBits[0]));
+    memcpy(buf + 4, nibbleBits[color & 0x0F], sizeof(nibbleBits[0]));
 }
 
 /**
@@ -304,12 +314,16 @@ void setColor(uint8_t color, ledbuf_t *buf)
  */
 void PIOS_WS2811_setColorRGB(Color_t c, uint8_t led, bool update)
 {
-    if (led >= PIOS_WS2811_NUMLEDS) {
+    if (led >= PIOS_WS2811_NUMLEDS || !fb) {
         return;
     }
-    setColor(c.G, fb + (led * 24));
-    setColor(c.R, fb + 8 + (led * 24));
-    setColor(c.B, fb + 16 + (led * 24));
+    if (c.R != ledColors[led].R || c.G != ledColors[led].G || c.B != ledColors[led].B) {
+        ledColors[led] = c;
+        setColor(c.G, fb + (led * 24));
+        setColor(c.R, fb + 8 + (led * 24));
+        setColor(c.B, fb + 16 + (led * 24));
+        fbChanged = true;
+    }
 
     if (update) {
         PIOS_WS2811_Update();
@@ -317,14 +331,15 @@ void PIOS_WS2811_setColorRGB(Color_t c, uint8_t led, bool update)
 }
 
 /**
- * trigger an update cycle if not already running
+ * trigger an update cycle if not already running and the framebuffer changed since the last one
  */
 void PIOS_WS2811_Update()
 {
     // does not start if framebuffer is not allocated (init has not been called yet) or a transfer is still on going
-    if (!fb || (pios_ws2811_cfg->timer->CR1 & TIM_CR1_CEN)) {
+    if (!fb || !fbChanged || (pios_ws2811_cfg->timer->CR1 & TIM_CR1_CEN)) {
         return;
     }
+    fbChanged = false;
 
     // reset counters for synchronization
     pios_ws2811_cfg->timer->CNT = PIOS_WS2811_TIM_PERIOD - 1;
@@ -336,6 +351,16 @@ void PIOS_WS2811_Update()
     TIM_Cmd(pios_ws2811_cfg->timer, ENABLE);
 }
 
+/**
+ * Check whether the framebuffer has changes not sent yet, the update was
+ * skipped because a transfer was still on going
+ * @return true if PIOS_WS2811_Update() must be called again
+ */
+bool PIOS_WS2811_UpdatePending()
+{
+    return fbChanged;
+}
+
 /**
  * Stop timer once the complete framebuffer has been sent
  */
@@ -93,6 +93,8 @@
 /* #define PIOS_INCLUDE_HCSR04 */
 
 #define PIOS_SENSOR_RATE 500.0f
+/* Attitude accel correction every 2 updates */
+#define PIOS_ATTITUDE_ACCEL_DECIMATION 2
 
 /* PIOS receiver drivers */
 #define PIOS_INCLUDE_PWM
@@ -120,6 +122,7 @@
 /* #define FLASH_FREERTOS */
 /* #define PIOS_INCLUDE_FLASH_EEPROM */
 /* #define PIOS_INCLUDE_FLASH_INTERNAL */
+#define PIOS_FLASH_JEDEC_CACHE_SIZE 0 /* no RAM for the read ahead, no transaction lock either */
 
 /* PIOS radio modules */
 /* #define PIOS_INCLUDE_RFM22B */
@@ -171,6 +174,8 @@
 #else
 #define PIOS_SYSTEM_STACK_SIZE          660
 #endif
+/* Time per System update spent on the alarms and diagnostics, the rest waits for the next one */
+#define PIOS_SYSTEM_SLICE_BUDGET_US     500
 #define PIOS_TELEM_RX_STACK_SIZE        410
 #define PIOS_TELEM_TX_STACK_SIZE        560
 #define PIOS_EVENTDISPATCHER_STACK_SIZE 95
@@ -133,7 +133,9 @@ static const struct pios_mpu6000_cfg pios_mpu6000_cfg = {
     .orientation    = PIOS_MPU6000_TOP_180DEG,
     .fast_prescaler = PIOS_SPI_PRESCALER_4,
     .std_prescaler  = PIOS_SPI_PRESCALER_64,
-    .max_downsample = 2
+    .max_downsample = 2,
+    // Attitude reads the sum of the samples each loop
+    .accumulate     = true,
 };
 #endif /* PIOS_INCLUDE_MPU6000 */
 
@@ -143,6 +143,8 @@
 #define PIOS_INCLUDE_COM_FLEXI
 /* #define PIOS_INCLUDE_COM_AUX */
 #define PIOS_TELEM_PRIORITY_QUEUE
+/* Bytes moved at once by the COM USB bridge, at most the bridge tx buffers */
+#define PIOS_COMUSBBRIDGE_CHUNK_LEN 128
 #define PIOS_INCLUDE_GPS
 /* #define PIOS_GPS_MINIMAL */
 #define PIOS_INCLUDE_GPS_NMEA_PARSER
@@ -440,6 +440,7 @@ void PIOS_Board_Init(void)
         // Set the radio configuration parameters.
         PIOS_RFM22B_SetChannelConfig(pios_rfm22b_id, datarate, oplinkSettings.MinChannel, oplinkSettings.MaxChannel, oplinkSettings.ChannelSet, is_coordinator, is_oneway, ppm_mode, ppm_only);
         PIOS_RFM22B_SetCoordinatorID(pios_rfm22b_id, oplinkSettings.CoordID);
+        PIOS_RFM22B_SetAdaptiveDatarate(pios_rfm22b_id, oplinkSettings.AdaptiveRate == OPLINKSETTINGS_ADAPTIVERATE_TRUE);
 
         /* Set the PPM callback if we should be receiving PPM. */
         if (ppm_mode) {
@@ -39,6 +39,7 @@
 #define configUSE_RECURSIVE_MUTEXES                  1
 #define configUSE_COUNTING_SEMAPHORES                0
 #define configUSE_ALTERNATIVE_API                    0
+#define configUSE_QUEUE_SETS                         1
 #define configCHECK_FOR_STACK_OVERFLOW               2
 #define configQUEUE_REGISTRY_SIZE                    10
 
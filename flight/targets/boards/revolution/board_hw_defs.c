@@ -726,6 +726,80 @@ static const struct flashfs_logfs_cfg flashfs_internal_cfg = {
 /*
  * MAIN USART
  */
+static uint32_t pios_usart_main_id;
+void PIOS_USART_main_dma_tx_irq_handler(void);
+void PIOS_USART_main_dma_rx_irq_handler(void);
+void DMA2_Stream7_IRQHandler(void) __attribute__((alias("PIOS_USART_main_dma_tx_irq_handler")));
+void DMA2_Stream2_IRQHandler(void) __attribute__((alias("PIOS_USART_main_dma_rx_irq_handler")));
+
+void PIOS_USART_main_dma_tx_irq_handler(void)
+{
+    PIOS_USART_DMA_TxIrqHandler(pios_usart_main_id);
+}
+
+void PIOS_USART_main_dma_rx_irq_handler(void)
+{
+    PIOS_USART_DMA_RxIrqHandler(pios_usart_main_id);
+}
+
+static const struct pios_usart_dma_cfg pios_usart_main_dma_cfg = {
+    .tx                                        = {
+        .channel = DMA2_Stream7,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART1->DR),
+            .DMA_DIR                = DMA_DIR_MemoryToPeripheral,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Normal,
+            .DMA_Priority           = DMA_Priority_Medium,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+    .tx_irq                                    = {
+        .flags = (DMA_FLAG_TCIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_FEIF7),
+        .init  = {
+            .NVIC_IRQChannel    = DMA2_Stream7_IRQn,
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .rx                                        = {
+        .channel = DMA2_Stream2,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART1->DR),
+            .DMA_DIR                = DMA_DIR_PeripheralToMemory,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Circular,
+            .DMA_Priority           = DMA_Priority_Medium,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+    .rx_irq                                    = {
+        .flags = (DMA_FLAG_HTIF2 | DMA_FLAG_TCIF2 | DMA_FLAG_TEIF2 | DMA_FLAG_FEIF2),
+        .init  = {
+            .NVIC_IRQChannel    = DMA2_Stream2_IRQn,
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .rx_buffer_len = 128,
+};
+
 static const struct pios_usart_cfg pios_usart_main_cfg = {
     .regs  = USART1,
     .remap = GPIO_AF_USART1,
@@ -765,6 +839,7 @@ static const struct pios_usart_cfg pios_usart_main_cfg = {
             .GPIO_PuPd  = GPIO_PuPd_UP
         },
     },
+    .dma                                       = &pios_usart_main_dma_cfg,
 };
 #endif /* PIOS_INCLUDE_COM_TELEM */
 
@@ -1701,6 +1776,53 @@ static const struct pios_tim_channel pios_tim_servoport_all_pins[] = {
 #define PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN_PPM 11
 #define PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN     12
 
+/*
+ * Timer update DMA requests for DShot, TIM9 has none
+ * TIM3_UP DMA1 Stream2 Ch5, TIM2_UP DMA1 Stream1 Ch3, TIM5_UP DMA1 Stream6 Ch6
+ */
+#define PIOS_SERVO_DMA_INIT(ch) \
+    { \
+        .DMA_Channel            = ch, \
+        .DMA_DIR                = DMA_DIR_MemoryToPeripheral, \
+        .DMA_PeripheralInc      = DMA_PeripheralInc_Disable, \
+        .DMA_MemoryInc          = DMA_MemoryInc_Enable, \
+        .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word, \
+        .DMA_MemoryDataSize     = DMA_MemoryDataSize_Word, \
+        .DMA_Mode               = DMA_Mode_Normal, \
+        .DMA_Priority           = DMA_Priority_High, \
+        .DMA_FIFOMode           = DMA_FIFOMode_Disable, \
+        .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full, \
+        .DMA_MemoryBurst        = DMA_MemoryBurst_Single, \
+        .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single, \
+    }
+
+static const struct pios_servo_dma_cfg pios_servo_dma_cfg[] = {
+    {
+        .timer = TIM3,
+        .dma   = {
+            .channel = DMA1_Stream2,
+            .init    = PIOS_SERVO_DMA_INIT(DMA_Channel_5),
+        },
+        .flags = DMA_FLAG_TCIF2 | DMA_FLAG_HTIF2 | DMA_FLAG_TEIF2 | DMA_FLAG_DMEIF2 | DMA_FLAG_FEIF2,
+    },
+    {
+        .timer = TIM2,
+        .dma   = {
+            .channel = DMA1_Stream1,
+            .init    = PIOS_SERVO_DMA_INIT(DMA_Channel_3),
+        },
+        .flags = DMA_FLAG_TCIF1 | DMA_FLAG_HTIF1 | DMA_FLAG_TEIF1 | DMA_FLAG_DMEIF1 | DMA_FLAG_FEIF1,
+    },
+    {
+        .timer = TIM5,
+        .dma   = {
+            .channel = DMA1_Stream6,
+            .init    = PIOS_SERVO_DMA_INIT(DMA_Channel_6),
+        },
+        .flags = DMA_FLAG_TCIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_FEIF6,
+    },
+};
+
 const struct pios_servo_cfg pios_servo_cfg_out = {
     .tim_oc_init          = {
         .TIM_OCMode       = TIM_OCMode_PWM1,
@@ -1714,6 +1836,8 @@ const struct pios_servo_cfg pios_servo_cfg_out = {
     },
     .channels     = pios_tim_servoport_all_pins,
     .num_channels = PIOS_SERVOPORT_ALL_PINS_PWMOUT,
+    .dma          = pios_servo_dma_cfg,
+    .num_dma      = NELEMENTS(pios_servo_dma_cfg),
 };
 // All servo outputs, servo input ch1 ppm, ch2-6 outputs
 const struct pios_servo_cfg pios_servo_cfg_out_in_ppm = {
@@ -1729,6 +1853,8 @@ const struct pios_servo_cfg pios_servo_cfg_out_in_ppm = {
     },
     .channels     = pios_tim_servoport_all_pins,
     .num_channels = PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN_PPM,
+    .dma          = pios_servo_dma_cfg,
+    .num_dma      = NELEMENTS(pios_servo_dma_cfg),
 };
 // All servo outputs, servo inputs ch1-6 Outputs
 const struct pios_servo_cfg pios_servo_cfg_out_in = {
@@ -1744,6 +1870,8 @@ const struct pios_servo_cfg pios_servo_cfg_out_in = {
     },
     .channels     = pios_tim_servoport_all_pins,
     .num_channels = PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN,
+    .dma          = pios_servo_dma_cfg,
+    .num_dma      = NELEMENTS(pios_servo_dma_cfg),
 };
 
 
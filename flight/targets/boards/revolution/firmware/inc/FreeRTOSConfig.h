@@ -39,6 +39,7 @@
 #define configUSE_RECURSIVE_MUTEXES                  1
 #define configUSE_COUNTING_SEMAPHORES                0
 #define configUSE_ALTERNATIVE_API                    0
+#define configUSE_QUEUE_SETS                         1
 #define configCHECK_FOR_STACK_OVERFLOW               2
 #define configQUEUE_REGISTRY_SIZE                    10
 
@@ -96,6 +97,14 @@
     while (0)
 #define portGET_RUN_TIME_COUNTER_VALUE() (*(unsigned long *)0xe0001004) /* DWT_CYCCNT */
 
+/* Record task switches in the PiOS scheduling trace, see pios_trace.h */
+#include "pios_config.h"
+#if defined(PIOS_INCLUDE_TRACE)
+#include <stdint.h>
+extern void PIOS_TRACE_Record(uint8_t event, uint32_t arg);
+#define traceTASK_SWITCHED_IN() PIOS_TRACE_Record(1 /* PIOS_TRACE_TASK_SWITCH */, (uint32_t)pxCurrentTCB)
+#endif
+
 
 /**
  * @}
@@ -55,9 +55,14 @@
 #define PIOS_INCLUDE_INITCALL
 #define PIOS_INCLUDE_SYS
 #define PIOS_INCLUDE_TASK_MONITOR
+#define PIOS_INCLUDE_MEM_POOL
+#define PIOS_MEM_POOL_UAVOBJECTS
 
 #define PIOS_INCLUDE_INSTRUMENTATION
-#define PIOS_INSTRUMENTATION_MAX_COUNTERS 10
+#define PIOS_INSTRUMENTATION_MAX_COUNTERS 12
+
+/* Scheduling trace, recording is started with DebugLogSettings.Trace */
+#define PIOS_INCLUDE_TRACE
 
 /* PIOS hardware peripherals */
 #define PIOS_INCLUDE_IRQ
@@ -113,6 +118,7 @@
 #define PIOS_INCLUDE_LED
 #define PIOS_INCLUDE_IAP
 #define PIOS_INCLUDE_SERVO
+#define PIOS_INCLUDE_DSHOT
 /* #define PIOS_INCLUDE_I2C_ESC */
 /* #define PIOS_INCLUDE_OVERO */
 /* #define PIOS_OVERO_SPI */
@@ -143,6 +149,8 @@
 #define PIOS_INCLUDE_COM_FLEXI
 /* #define PIOS_INCLUDE_COM_AUX */
 #define PIOS_TELEM_PRIORITY_QUEUE
+/* Bytes moved at once by the COM USB bridge, at most the bridge tx buffers */
+#define PIOS_COMUSBBRIDGE_CHUNK_LEN 128
 #define PIOS_INCLUDE_GPS
 /* #define PIOS_GPS_MINIMAL */
 #define PIOS_INCLUDE_GPS_NMEA_PARSER
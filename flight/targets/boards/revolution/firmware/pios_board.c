@@ -225,8 +225,8 @@ uint32_t pios_rcvr_group_map[MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE];
 #define PIOS_COM_TELEM_USB_RX_BUF_LEN    65
 #define PIOS_COM_TELEM_USB_TX_BUF_LEN    65
 
-#define PIOS_COM_BRIDGE_RX_BUF_LEN       65
-#define PIOS_COM_BRIDGE_TX_BUF_LEN       12
+#define PIOS_COM_BRIDGE_RX_BUF_LEN       256
+#define PIOS_COM_BRIDGE_TX_BUF_LEN       256
 
 #define PIOS_COM_RFM22B_RF_RX_BUF_LEN    512
 #define PIOS_COM_RFM22B_RF_TX_BUF_LEN    512
@@ -267,6 +267,12 @@ static void PIOS_Board_configure_com(const struct pios_usart_cfg *usart_port_cfg
     if (PIOS_USART_Init(&pios_usart_id, usart_port_cfg)) {
         PIOS_Assert(0);
     }
+#ifdef PIOS_INCLUDE_COM_TELEM
+    if (usart_port_cfg == &pios_usart_main_cfg) {
+        /* For the DMA stream interrupts */
+        pios_usart_main_id = pios_usart_id;
+    }
+#endif
 
     uint8_t *rx_buffer = (uint8_t *)pios_malloc(rx_buf_len);
     PIOS_Assert(rx_buffer);
@@ -775,6 +781,7 @@ void PIOS_Board_Init(void)
         /* Set the radio configuration parameters. */
         PIOS_RFM22B_SetChannelConfig(pios_rfm22b_id, datarate, oplinkSettings.MinChannel, oplinkSettings.MaxChannel, oplinkSettings.ChannelSet, is_coordinator, is_oneway, ppm_mode, ppm_only);
         PIOS_RFM22B_SetCoordinatorID(pios_rfm22b_id, oplinkSettings.CoordID);
+        PIOS_RFM22B_SetAdaptiveDatarate(pios_rfm22b_id, oplinkSettings.AdaptiveRate == OPLINKSETTINGS_ADAPTIVERATE_TRUE);
 
         /* Set the PPM callback if we should be receiving PPM. */
         if (ppm_mode) {
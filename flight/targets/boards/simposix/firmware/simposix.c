@@ -34,6 +34,7 @@
 #include "inc/openpilot.h"
 #include <systemmod.h>
 #include <uavobjectsinit.h>
+#include <unistd.h>
 
 /* Task Priorities */
 #define PRIORITY_TASK_HOOKS (tskIDLE_PRIORITY + 3)
@@ -84,10 +85,34 @@ extern void InitModules(void);
  * Start FreeRTOS Scheduler (vTaskStartScheduler)<BR>
  * If something goes wrong, blink LED1 and LED2 every 100ms
  *
+ * -s <factor> runs the simulation factor times faster than real time,
+ * the scheduler ticks, PIOS_DELAY and the simulated sensors all follow
+ * the virtual time.
+ * -p <offset> moves the UDP ports (telemetry 9000, GPS 9001, aux 9002)
+ * by offset to run several simulations side by side.
  */
-int main()
+int main(int argc, char *argv[])
 {
     int result;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:p:")) != -1) {
+        switch (opt) {
+        case 's':
+            if (atoi(optarg) < 1) {
+                fprintf(stderr, "Invalid speed factor %s\n", optarg);
+                return 1;
+            }
+            vPortSetTimeScale(atoi(optarg));
+            break;
+        case 'p':
+            PIOS_UDP_SetPortOffset(atoi(optarg));
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-s speed factor] [-p udp port offset]\n", argv[0]);
+            return 1;
+        }
+    }
 
     /* NOTE: Do NOT modify the following start-up sequence */
     /* Any new initialization functions should be added in OpenPilotInit() */
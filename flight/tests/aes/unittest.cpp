@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <string.h> /* memcpy */
+
+extern "C" {
+#include "aes.h"
+}
+
+// NIST SP 800-38A F.5.1 CTR-AES128.Encrypt
+static const uint8_t key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t counter[16] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+static const uint8_t plaintext[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+static const uint8_t ciphertext[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class AesTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        aes_ctr_128_init(&ctx, key, counter);
+    }
+
+    struct aes_ctr_128 ctx;
+};
+
+TEST_F(AesTest, EncryptBlockFips197) {
+    // FIPS-197 C.1
+    const uint8_t k[16]   = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const uint8_t in[16]  = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    const uint8_t out[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+    uint32_t round_keys[AES_128_ROUND_KEYS];
+    uint8_t block[16];
+
+    aes_key_128_expand(k, round_keys);
+    aes_encrypt_block_128(round_keys, in, block);
+    EXPECT_EQ(0, memcmp(out, block, sizeof(block)));
+
+    // the byte oriented implementation agrees
+    uint8_t cbc_key[16];
+    memcpy(cbc_key, k, sizeof(cbc_key));
+    memcpy(block, in, sizeof(block));
+    aes_encrypt_cbc_128(block, cbc_key, NULL);
+    EXPECT_EQ(0, memcmp(out, block, sizeof(block)));
+}
+
+TEST_F(AesTest, CtrWholeBuffer) {
+    uint32_t data[16];
+
+    memcpy(data, plaintext, sizeof(data));
+    aes_ctr_128_crypt(&ctx, data, sizeof(data));
+    EXPECT_EQ(0, memcmp(ciphertext, data, sizeof(data)));
+
+    aes_ctr_128_set_counter(&ctx, counter);
+    aes_ctr_128_crypt(&ctx, data, sizeof(data));
+    EXPECT_EQ(0, memcmp(plaintext, data, sizeof(data)));
+}
+
+TEST_F(AesTest, CtrStreamsInPieces) {
+    // odd sizes and an unaligned buffer must give the same stream
+    static const uint32_t sizes[] = { 1, 3, 16, 5, 17, 2, 20 };
+    uint8_t buffer[65];
+    uint8_t *data = buffer + 1;
+    uint32_t offset = 0;
+
+    memcpy(data, plaintext, sizeof(plaintext));
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        aes_ctr_128_crypt(&ctx, data + offset, sizes[i]);
+        offset += sizes[i];
+    }
+    ASSERT_EQ(sizeof(plaintext), offset);
+    EXPECT_EQ(0, memcmp(ciphertext, data, sizeof(plaintext)));
+}
+
+TEST_F(AesTest, CtrCounterWraps) {
+    // the whole 128 bit counter is incremented, all ones wraps to zero
+    const uint8_t ones[16] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    const uint8_t expected[40] = {
+        0x8a, 0xf2, 0x86, 0x01, 0x42, 0xf7, 0x86, 0xf4, 0x09, 0x30, 0x7c, 0x1a, 0x3f, 0x7e, 0xaa, 0xac,
+        0x7d, 0xf7, 0x6b, 0x0c, 0x1a, 0xb8, 0x99, 0xb3, 0x3e, 0x42, 0xf0, 0x47, 0xb9, 0x1b, 0x54, 0x6f,
+        0x57, 0x12, 0x7d, 0x40, 0x34, 0xb1, 0xbe, 0xbf
+    };
+    uint8_t data[40];
+
+    memset(data, 0, sizeof(data));
+    aes_ctr_128_set_counter(&ctx, ones);
+    aes_ctr_128_crypt(&ctx, data, sizeof(data));
+    EXPECT_EQ(0, memcmp(expected, data, sizeof(data)));
+}
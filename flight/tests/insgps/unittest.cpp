@@ -0,0 +1,264 @@
+#include "gtest/gtest.h"
+
+#include <math.h> /* fabs */
+#include <stdio.h> /* printf */
+#include <string.h> /* memcpy */
+#include <time.h> /* clock */
+
+#define NUMX 13
+#define NUMW 9
+
+extern "C" {
+#include "insgps.h"
+
+void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                          float Q[NUMW], float dT, float P[NUMX][NUMX]);
+}
+
+// Same sparsity as LinearizeFG()
+static const int8_t FrowMin[NUMX] = { 3, 4, 5, 6, 6, 6, 7, 6, 6, 6, 13, 13, 13 };
+static const int8_t FrowMax[NUMX] = { 3, 4, 5, 9, 9, 9, 12, 12, 12, 12, -1, -1, -1 };
+static const int8_t GrowMin[NUMX] = { 9, 9, 9, 3, 3, 3, 0, 0, 0, 0, 6, 7, 8 };
+static const int8_t GrowMax[NUMX] = { -1, -1, -1, 5, 5, 5, 2, 2, 2, 2, 6, 7, 8 };
+
+#define BENCH_RUNS 100000
+
+// The covariance prediction before only the used columns of Dummy were computed
+__attribute__((optimize("O3")))
+static void fullCovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                                     float Q[NUMW], float dT, float P[NUMX][NUMX])
+{
+    float dT1  = 1.0f / dT;
+    float dTsq = dT * dT;
+    float Dummy[NUMX][NUMX];
+
+    for (int8_t i = 0; i < NUMX; i++) {
+        for (int8_t j = 0; j < NUMX; j++) {
+            Dummy[i][j] = P[i][j] * dT1;
+            for (int8_t k = FrowMin[i]; k <= FrowMax[i]; k++) {
+                Dummy[i][j] += F[i][k] * P[k][j];
+            }
+        }
+    }
+    for (int8_t i = 0; i < NUMX; i++) {
+        for (int8_t j = i; j < NUMX; j++) {
+            float Ptmp = Dummy[i][j] * dT1;
+            for (int8_t k = FrowMin[j]; k <= FrowMax[j]; k++) {
+                Ptmp += Dummy[i][k] * F[j][k];
+            }
+            int8_t Gjstart = GrowMin[i] > GrowMin[j] ? GrowMin[i] : GrowMin[j];
+            int8_t Gjend   = GrowMax[i] < GrowMax[j] ? GrowMax[i] : GrowMax[j];
+            for (int8_t k = Gjstart; k <= Gjend; k++) {
+                Ptmp += Q[k] * G[i][k] * G[j][k];
+            }
+            P[j][i] = P[i][j] = Ptmp * dTsq;
+        }
+    }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class CovariancePredictionTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        unsigned int seed = 1;
+
+        memset(F, 0, sizeof(F));
+        memset(G, 0, sizeof(G));
+        for (int i = 0; i < NUMX; i++) {
+            for (int k = FrowMin[i]; k <= FrowMax[i]; k++) {
+                F[i][k] = (k == i) ? 0.0f : random(&seed);
+            }
+            for (int k = GrowMin[i]; k <= GrowMax[i]; k++) {
+                G[i][k] = random(&seed);
+            }
+        }
+        for (int k = 0; k < NUMW; k++) {
+            Q[k] = 1e-3f + fabsf(random(&seed)) * 1e-2f;
+        }
+
+        // P = A * A' + I is symmetric positive definite
+        float A[NUMX][NUMX];
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = 0; j < NUMX; j++) {
+                A[i][j] = random(&seed);
+            }
+        }
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = 0; j < NUMX; j++) {
+                double sum = (i == j) ? 1.0 : 0.0;
+                for (int k = 0; k < NUMX; k++) {
+                    sum += (double)A[i][k] * A[j][k];
+                }
+                P[i][j] = (float)sum;
+            }
+        }
+        dT = 0.002f;
+    }
+
+    // Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G' computed densely in double
+    void referencePrediction(double Pnew[NUMX][NUMX])
+    {
+        double Phi[NUMX][NUMX];
+        double PhiP[NUMX][NUMX];
+
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = 0; j < NUMX; j++) {
+                Phi[i][j] = (i == j ? 1.0 : 0.0) + (double)F[i][j] * dT;
+            }
+        }
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = 0; j < NUMX; j++) {
+                PhiP[i][j] = 0.0;
+                for (int k = 0; k < NUMX; k++) {
+                    PhiP[i][j] += Phi[i][k] * P[k][j];
+                }
+            }
+        }
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = 0; j < NUMX; j++) {
+                Pnew[i][j] = 0.0;
+                for (int k = 0; k < NUMX; k++) {
+                    Pnew[i][j] += PhiP[i][k] * Phi[j][k];
+                }
+                for (int k = 0; k < NUMW; k++) {
+                    Pnew[i][j] += (double)dT * dT * G[i][k] * Q[k] * G[j][k];
+                }
+            }
+        }
+    }
+
+    static float random(unsigned int *seed)
+    {
+        *seed = *seed * 1103515245u + 12345u;
+        return (float)((*seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+    }
+
+    float F[NUMX][NUMX];
+    float G[NUMX][NUMW];
+    float Q[NUMW];
+    float P[NUMX][NUMX];
+    float dT;
+};
+
+TEST_F(CovariancePredictionTest, MatchesDenseReference) {
+    double Pref[NUMX][NUMX];
+
+    referencePrediction(Pref);
+    CovariancePrediction(F, G, Q, dT, P);
+
+    for (int i = 0; i < NUMX; i++) {
+        for (int j = 0; j < NUMX; j++) {
+            EXPECT_NEAR(Pref[i][j], P[i][j], 1e-4 * (1.0 + fabs(Pref[i][j]))) << "P[" << i << "][" << j << "]";
+        }
+    }
+}
+
+TEST_F(CovariancePredictionTest, IsSymmetric) {
+    CovariancePrediction(F, G, Q, dT, P);
+
+    for (int i = 0; i < NUMX; i++) {
+        for (int j = i + 1; j < NUMX; j++) {
+            EXPECT_EQ(P[i][j], P[j][i]);
+        }
+    }
+}
+
+TEST_F(CovariancePredictionTest, MatchesFullPrediction) {
+    float Pfull[NUMX][NUMX];
+
+    memcpy(Pfull, P, sizeof(P));
+    fullCovariancePrediction(F, G, Q, dT, Pfull);
+    CovariancePrediction(F, G, Q, dT, P);
+
+    // same operations in the same order, only the unused ones are skipped
+    for (int i = 0; i < NUMX; i++) {
+        for (int j = 0; j < NUMX; j++) {
+            EXPECT_EQ(Pfull[i][j], P[i][j]) << "P[" << i << "][" << j << "]";
+        }
+    }
+}
+
+TEST_F(CovariancePredictionTest, Benchmark) {
+    float Pstart[NUMX][NUMX];
+
+    memcpy(Pstart, P, sizeof(P));
+
+    clock_t start = clock();
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        memcpy(P, Pstart, sizeof(P));
+        fullCovariancePrediction(F, G, Q, dT, P);
+    }
+    clock_t full = clock() - start;
+
+    start = clock();
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        memcpy(P, Pstart, sizeof(P));
+        CovariancePrediction(F, G, Q, dT, P);
+    }
+    clock_t sparse = clock() - start;
+
+    // informative only, timings on the build host say little about the fpu of the target
+    printf("CovariancePrediction: %.3f us per run, %.3f us for the full prediction\n",
+           1e6 * sparse / CLOCKS_PER_SEC / BENCH_RUNS, 1e6 * full / CLOCKS_PER_SEC / BENCH_RUNS);
+    EXPECT_FALSE(isnan(P[0][0]));
+}
+
+class InnovationGateTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        float PDiag[NUMX] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-9f, 1e-9f, 1e-9f };
+        float PosVar[3]   = { 1.0f, 1.0f, 1.0f };
+        float VelVar[3]   = { 1.0f, 1.0f, 1.0f };
+
+        INSGPSInit();
+        INSResetP(PDiag);
+        INSSetPosVelVar(PosVar, VelVar);
+    }
+
+    float zeros[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+TEST_F(InnovationGateTest, RejectsFarFix) {
+    float Pos[3] = { 50.0f, 0.0f, 0.0f };
+    float Pbefore[NUMX], Pafter[NUMX];
+
+    INSSetGpsGate(16.3f, 16.3f);
+    INSGetP(Pbefore);
+    // d^2 = 50^2 / (1 + 1)
+    EXPECT_EQ(POS_SENSORS, INSCorrection(zeros, Pos, zeros, 0.0f, POS_SENSORS | HORIZ_SENSORS | VERT_SENSORS));
+    INSGetP(Pafter);
+
+    EXPECT_EQ(0.0f, Nav.Pos[0]);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(Pbefore[i], Pafter[i]);
+    }
+    // the velocity fix agrees and is still used
+    EXPECT_LT(Pafter[3], Pbefore[3]);
+}
+
+TEST_F(InnovationGateTest, AcceptsNearFix) {
+    float Pos[3] = { 2.0f, 0.0f, 0.0f };
+
+    INSSetGpsGate(16.3f, 16.3f);
+    EXPECT_EQ(0, INSCorrection(zeros, Pos, zeros, 0.0f, POS_SENSORS));
+    EXPECT_NEAR(1.0f, Nav.Pos[0], 1e-4f);
+}
+
+TEST_F(InnovationGateTest, DisabledByDefault) {
+    float Pos[3] = { 50.0f, 0.0f, 0.0f };
+
+    EXPECT_EQ(0, INSCorrection(zeros, Pos, zeros, 0.0f, POS_SENSORS));
+    EXPECT_NEAR(25.0f, Nav.Pos[0], 1e-3f);
+}
+
+TEST_F(InnovationGateTest, BaroWithoutMag) {
+    // no magnetometer data, the mag rows are not used and must not spoil the state
+    INSCorrection(zeros, zeros, zeros, 1.0f, BARO_SENSOR);
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_FALSE(isnan(Nav.q[i]));
+    }
+    EXPECT_LT(Nav.Pos[2], 0.0f);
+}
@@ -12,6 +12,10 @@ extern "C" {
 
 void PIOS_WS2811_setColorRGB(__attribute__((unused)) Color_t c, __attribute__((unused)) uint8_t led, __attribute__((unused)) bool update) {}
 void PIOS_WS2811_Update() {}
+bool PIOS_WS2811_UpdatePending()
+{
+    return false;
+}
 }
 
 class LedNotificationTest : public testing::Test {};
@@ -3,6 +3,7 @@
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* abort */
 #include <string.h> /* memset */
+#include <sys/time.h> /* gettimeofday */
 
 extern "C" {
 #include "pios_flash.h" /* PIOS_FLASH_* API */
@@ -297,6 +298,233 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
     EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+static uint64_t elapsed_us(const struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) * 1000000ULL + now.tv_usec - start->tv_usec;
+}
+
+#define NUM_SETTINGS_OBJS 60
+
+TEST_F(LogfsTestCooked, IndexedMountAndLookup) {
+    /* Simulate a settings partition that has been saved a few times */
+    for (uint32_t pass = 0; pass < 3; pass++) {
+        for (uint32_t i = 0; i < NUM_SETTINGS_OBJS; i++) {
+            EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + 2 * i, 0, pass ? obj1_alt : obj1, sizeof(obj1)));
+        }
+    }
+
+    /* Remount, this is where the slot index gets built */
+    struct timeval start;
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    gettimeofday(&start, NULL);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_partition_a, &pios_ut_flash_driver, flash_id));
+    uint64_t mount_time = elapsed_us(&start);
+
+    /* Every lookup should only need to read the slot header and the data */
+    unsigned char obj1_check[OBJ1_SIZE];
+    uint32_t reads = PIOS_Flash_UT_GetReadCount(flash_id);
+    gettimeofday(&start, NULL);
+    for (uint32_t i = 0; i < NUM_SETTINGS_OBJS; i++) {
+        memset(obj1_check, 0, sizeof(obj1_check));
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + 2 * i, 0, obj1_check, sizeof(obj1_check)));
+        EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+    }
+    uint64_t lookup_time = elapsed_us(&start);
+    EXPECT_GE(2u * NUM_SETTINGS_OBJS, PIOS_Flash_UT_GetReadCount(flash_id) - reads);
+
+    /* Objects which are not in the filesystem are rejected without touching the flash */
+    reads = PIOS_Flash_UT_GetReadCount(flash_id);
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0u, PIOS_Flash_UT_GetReadCount(flash_id) - reads);
+
+    printf("[ BENCH    ] mount: %llu us, %d lookups: %llu us\n", (unsigned long long)mount_time, NUM_SETTINGS_OBJS, (unsigned long long)lookup_time);
+}
+
+TEST_F(LogfsTestCooked, IndexedSaveDoesNotScan) {
+    /* Fill most of the arena with distinct objects, like a debug log does */
+    uint32_t num_objs = (flashfs_config_partition_a.arena_size / flashfs_config_partition_a.slot_size) - 2;
+
+    for (uint32_t i = 0; i < num_objs; i++) {
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+    }
+
+    /* Appending one more object must not read every slot header of the arena */
+    struct timeval start;
+    uint32_t reads = PIOS_Flash_UT_GetReadCount(flash_id);
+    gettimeofday(&start, NULL);
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, num_objs, obj1, sizeof(obj1)));
+    uint64_t save_time = elapsed_us(&start);
+    EXPECT_GE(4u, PIOS_Flash_UT_GetReadCount(flash_id) - reads);
+
+    /* Rewriting an object must still obsolete the previous version */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    struct PIOS_FLASHFS_Stats stats;
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(num_objs + 1, stats.num_active_slots);
+
+    printf("[ BENCH    ] save into a %u slot arena: %llu us\n", num_objs + 1, (unsigned long long)save_time);
+}
+
+TEST_F(LogfsTestCooked, IncrementalGarbageCollect) {
+    uint32_t num_slots = (flashfs_config_partition_a.arena_size / flashfs_config_partition_a.slot_size) - 1;
+    struct PIOS_FLASHFS_Stats stats;
+
+    /* obj2 ends up in the first slot, followed by lots of obsolete versions of obj1 */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+    for (uint32_t i = 0; i < num_slots - 16; i++) {
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i % 10, obj1, sizeof(obj1)));
+    }
+
+    /* Running low on free slots, the first step erases and reserves the destination arena */
+    EXPECT_EQ(1, PIOS_FLASHFS_GarbageCollectStep(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(1, stats.gc_running);
+    EXPECT_EQ(50, stats.gc_progress);
+
+    /* The next step copies obj2, which is then rewritten while the collection is still running */
+    unsigned char obj2_alt[OBJ2_SIZE];
+    memset(obj2_alt, 0x5A, sizeof(obj2_alt));
+    EXPECT_EQ(1, PIOS_FLASHFS_GarbageCollectStep(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2_alt, sizeof(obj2_alt)));
+
+    /* Objects stay readable during the collection */
+    unsigned char obj2_check[OBJ2_SIZE];
+    memset(obj2_check, 0, sizeof(obj2_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+    EXPECT_EQ(0, memcmp(obj2_alt, obj2_check, sizeof(obj2_check)));
+
+    int32_t rc;
+    uint32_t steps = 0;
+    while ((rc = PIOS_FLASHFS_GarbageCollectStep(fs_id)) == 1) {
+        steps++;
+    }
+    EXPECT_EQ(0, rc);
+    EXPECT_LE(10u, steps);
+
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(0, stats.gc_running);
+    EXPECT_EQ(11, stats.num_active_slots);
+    /* the obsoleted copy of the old obj2 uses up one slot */
+    EXPECT_EQ(num_slots - 12, stats.num_free_slots);
+
+    /* Nothing left to collect */
+    EXPECT_EQ(0, PIOS_FLASHFS_GarbageCollectStep(fs_id));
+
+    /* The stale copy of obj2 must not come back after a remount */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_partition_a, &pios_ut_flash_driver, flash_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(11, stats.num_active_slots);
+
+    memset(obj2_check, 0, sizeof(obj2_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+    EXPECT_EQ(0, memcmp(obj2_alt, obj2_check, sizeof(obj2_check)));
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    for (uint16_t i = 0; i < 10; i++) {
+        memset(obj1_check, 0, sizeof(obj1_check));
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i, obj1_check, sizeof(obj1_check)));
+        EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+    }
+}
+
+TEST_F(LogfsTestCooked, TransactionCommit) {
+    struct PIOS_FLASHFS_Stats stats;
+    unsigned char obj1_check[OBJ1_SIZE];
+    unsigned char obj2_check[OBJ2_SIZE];
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+
+    EXPECT_EQ(-3, PIOS_FLASHFS_CommitTransaction(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_BeginTransaction(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+    /* Pending saves are readable, but the old version is still the active one */
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(1, stats.num_active_slots);
+
+    EXPECT_EQ(0, PIOS_FLASHFS_CommitTransaction(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(2, stats.num_active_slots);
+
+    /* Committed saves survive a remount */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_partition_a, &pios_ut_flash_driver, flash_id));
+
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_check)));
+    memset(obj2_check, 0, sizeof(obj2_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+    EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2_check)));
+}
+
+TEST_F(LogfsTestCooked, TransactionInterrupted) {
+    unsigned char obj1_check[OBJ1_SIZE];
+    unsigned char obj2_check[OBJ2_SIZE];
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+
+    EXPECT_EQ(0, PIOS_FLASHFS_BeginTransaction(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+    /* A deleted object must not come back on commit */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+
+    /* Remount without commit, as after a reset, the old version is kept */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_partition_a, &pios_ut_flash_driver, flash_id));
+
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+}
+
+TEST_F(LogfsTestCooked, TransactionFillsLog) {
+    uint32_t num_slots = (flashfs_config_partition_a.arena_size / flashfs_config_partition_a.slot_size) - 1;
+    struct PIOS_FLASHFS_Stats stats;
+    unsigned char obj1_check[OBJ1_SIZE];
+
+    /* More saves than a transaction holds, and enough to need a garbage collection */
+    EXPECT_EQ(0, PIOS_FLASHFS_BeginTransaction(fs_id));
+    for (uint32_t i = 0; i < 2 * num_slots; i++) {
+        obj1[0] = i;
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i % 10, obj1, sizeof(obj1)));
+    }
+
+    /* Collection waits for the commit */
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    if (stats.num_free_slots < num_slots / 8) {
+        EXPECT_EQ(1, PIOS_FLASHFS_GarbageCollectStep(fs_id));
+    }
+    EXPECT_EQ(0, PIOS_FLASHFS_CommitTransaction(fs_id));
+
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(10, stats.num_active_slots);
+
+    for (uint32_t i = 2 * num_slots - 10; i < 2 * num_slots; i++) {
+        obj1[0] = i;
+        memset(obj1_check, 0, sizeof(obj1_check));
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i % 10, obj1_check, sizeof(obj1_check)));
+        EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1_check)));
+    }
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
     virtual void SetUp()
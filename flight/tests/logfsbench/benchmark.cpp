@@ -0,0 +1,229 @@
+#include <benchmark/benchmark.h>
+
+#include <string.h> /* memset */
+
+extern "C" {
+#include "pios_flash.h" /* PIOS_FLASH_* API */
+#include "flashsim.h"
+
+extern const struct flashsim_cfg flashsim_m25p16_cfg;
+extern const struct flashsim_cfg flashsim_w25q16_cfg;
+extern const struct flashsim_cfg flashsim_stm32f4_cfg;
+
+#include "pios_flashfs_logfs_priv.h"
+
+extern const struct flashfs_logfs_cfg flashfs_external_system_cfg;
+extern const struct flashfs_logfs_cfg flashfs_external_user_cfg;
+extern const struct flashfs_logfs_cfg flashfs_internal_cfg;
+
+#include "pios_flashfs.h" /* PIOS_FLASHFS_* */
+}
+
+// The times reported are the simulated flash times, CPU is the host time of the logfs code.
+// The internal flash is memory mapped, its loads are not simulated.
+// Every benchmark runs a fixed number of operations on a fresh flash so that the arenas fill
+// and get collected the same way on each run.
+
+#define SETTINGS_OPS     5000
+#define DEBUGLOG_OPS     10000
+
+// Sizes of the settings objects and of a DebugLogEntry
+static const uint16_t settings_sizes[] = {
+    12, 16,  20,  24,  28,  32,  40,  44,  52,  60,  64, 76,
+    88, 100, 112, 123, 136, 148, 160, 180, 200, 216, 232, 244,
+};
+#define NUM_SETTINGS      (sizeof(settings_sizes) / sizeof(settings_sizes[0]))
+#define HOT_SETTINGS      4 // tuned over and over, e.g. StabilizationSettings
+#define SETTINGS_OBJ_ID   0x10000000
+#define DEBUGLOG_OBJ_ID   0x20000000
+#define DEBUGLOG_SIZE     217
+#define DEBUGLOG_FLIGHT   1000 // entries per flight
+#define DEBUGLOG_KEPT     2    // flights kept, the older ones are erased
+
+enum gc_mode {
+    GC_FOREGROUND  = 0, // collected by the save running out of slots
+    GC_INCREMENTAL = 1, // one PIOS_FLASHFS_GarbageCollectStep() between saves, as the System module
+};
+
+class LogfsBench {
+public:
+    LogfsBench(const struct flashsim_cfg *flash_cfg, const struct flashfs_logfs_cfg *fs_cfg)
+    {
+        memset(buffer, 0x5A, sizeof(buffer));
+        seed = 12345;
+        flash_ok = FlashSim_Init(&flash_id, flash_cfg) == 0;
+        fs_ok    = flash_ok && PIOS_FLASHFS_Logfs_Init(&fs_id, fs_cfg, &flashsim_driver, flash_id) == 0;
+        FlashSim_GetStats(flash_id, &start);
+    }
+
+    ~LogfsBench()
+    {
+        if (fs_ok) {
+            PIOS_FLASHFS_Logfs_Destroy(fs_id);
+        }
+        if (flash_ok) {
+            FlashSim_Destroy(flash_id);
+        }
+    }
+
+    uint64_t now()
+    {
+        struct flashsim_stats stats;
+
+        FlashSim_GetStats(flash_id, &stats);
+        return stats.time_ns;
+    }
+
+    // Deterministic choice of the next settings object, half of the saves go to the hot ones
+    uint32_t nextSetting()
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t r = (seed >> 16) & 0x7FFF;
+        return (r & 1) ? (r >> 1) % HOT_SETTINGS : (r >> 1) % NUM_SETTINGS;
+    }
+
+    void report(benchmark::State & state, uint64_t worst_ns, uint64_t gc_ns, uint32_t failures)
+    {
+        struct flashsim_stats stats;
+
+        FlashSim_GetStats(flash_id, &stats);
+        state.SetItemsProcessed(state.iterations());
+        state.counters["worst_ms"]     = worst_ns / 1e6;
+        state.counters["gc_ms"]        = gc_ns / 1e6;
+        state.counters["erases"]       = stats.erases - start.erases;
+        state.counters["max_wear"]     = stats.max_sector_erases;
+        state.counters["bytes_per_op"] = (double)(stats.bytes_programmed - start.bytes_programmed) / state.iterations();
+        state.counters["failures"]     = failures;
+        if (stats.program_errors) {
+            state.SkipWithError("logfs programmed erased bits back to 1");
+        }
+    }
+
+    uintptr_t flash_id;
+    uintptr_t fs_id;
+    bool flash_ok;
+    bool fs_ok;
+    uint32_t seed;
+    struct flashsim_stats start;
+    uint8_t buffer[256];
+};
+
+static void BM_SettingsSave(benchmark::State & state, const struct flashsim_cfg *flash_cfg, const struct flashfs_logfs_cfg *fs_cfg)
+{
+    LogfsBench bench(flash_cfg, fs_cfg);
+    uint64_t worst = 0, gc = 0;
+    uint32_t failures = 0;
+
+    if (!bench.fs_ok) {
+        state.SkipWithError("logfs init failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        uint32_t n = bench.nextSetting();
+        uint64_t t = bench.now();
+        if (PIOS_FLASHFS_ObjSave(bench.fs_id, SETTINGS_OBJ_ID + n, 0, bench.buffer, settings_sizes[n]) != 0) {
+            failures++;
+        }
+        uint64_t elapsed = bench.now() - t;
+        worst = elapsed > worst ? elapsed : worst;
+        state.SetIterationTime(elapsed / 1e9);
+
+        if (state.range(0) == GC_INCREMENTAL) {
+            t   = bench.now();
+            PIOS_FLASHFS_GarbageCollectStep(bench.fs_id);
+            gc += bench.now() - t;
+        }
+    }
+    bench.report(state, worst, gc, failures);
+}
+
+static void BM_SettingsLoad(benchmark::State & state, const struct flashsim_cfg *flash_cfg, const struct flashfs_logfs_cfg *fs_cfg)
+{
+    LogfsBench bench(flash_cfg, fs_cfg);
+    uint64_t worst = 0;
+    uint32_t failures = 0;
+
+    if (!bench.fs_ok) {
+        state.SkipWithError("logfs init failed");
+        return;
+    }
+    // A settled filesystem, every object saved a few times
+    for (uint32_t i = 0; i < 4 * NUM_SETTINGS; i++) {
+        PIOS_FLASHFS_ObjSave(bench.fs_id, SETTINGS_OBJ_ID + i % NUM_SETTINGS, 0, bench.buffer, settings_sizes[i % NUM_SETTINGS]);
+    }
+    FlashSim_GetStats(bench.flash_id, &bench.start);
+
+    for (auto _ : state) {
+        uint32_t n = bench.nextSetting();
+        uint64_t t = bench.now();
+        if (PIOS_FLASHFS_ObjLoad(bench.fs_id, SETTINGS_OBJ_ID + n, 0, bench.buffer, settings_sizes[n]) != 0) {
+            failures++;
+        }
+        uint64_t elapsed = bench.now() - t;
+        worst = elapsed > worst ? elapsed : worst;
+        state.SetIterationTime(elapsed / 1e9);
+    }
+    bench.report(state, worst, 0, failures);
+}
+
+// Log entries appended flight after flight, the oldest flight is erased when a new one starts
+static void BM_DebugLogAppend(benchmark::State & state, const struct flashsim_cfg *flash_cfg, const struct flashfs_logfs_cfg *fs_cfg)
+{
+    LogfsBench bench(flash_cfg, fs_cfg);
+    uint64_t worst = 0, gc = 0;
+    uint32_t failures = 0;
+    uint32_t entry = 0;
+
+    if (!bench.fs_ok) {
+        state.SkipWithError("logfs init failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        uint32_t flight = entry / DEBUGLOG_FLIGHT;
+        uint16_t inst   = entry % DEBUGLOG_FLIGHT;
+        if (inst == 0 && flight >= DEBUGLOG_KEPT) {
+            // Not timed, the erase of the old logs is a separate user action
+            for (uint16_t i = 0; i < DEBUGLOG_FLIGHT; i++) {
+                PIOS_FLASHFS_ObjDelete(bench.fs_id, DEBUGLOG_OBJ_ID + ((flight - DEBUGLOG_KEPT) & 0xFF), i);
+            }
+        }
+
+        uint64_t t = bench.now();
+        if (PIOS_FLASHFS_ObjSave(bench.fs_id, DEBUGLOG_OBJ_ID + (flight & 0xFF), inst, bench.buffer, DEBUGLOG_SIZE) != 0) {
+            failures++;
+        }
+        uint64_t elapsed = bench.now() - t;
+        worst = elapsed > worst ? elapsed : worst;
+        state.SetIterationTime(elapsed / 1e9);
+        entry++;
+
+        if (state.range(0) == GC_INCREMENTAL) {
+            t   = bench.now();
+            PIOS_FLASHFS_GarbageCollectStep(bench.fs_id);
+            gc += bench.now() - t;
+        }
+    }
+    bench.report(state, worst, gc, failures);
+}
+
+static void GcModes(benchmark::internal::Benchmark *b)
+{
+    b->ArgName("incremental_gc")->Arg(GC_FOREGROUND)->Arg(GC_INCREMENTAL);
+}
+
+BENCHMARK_CAPTURE(BM_SettingsSave, m25p16, &flashsim_m25p16_cfg, &flashfs_external_system_cfg)
+->Apply(GcModes)->Iterations(SETTINGS_OPS)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SettingsSave, w25q16, &flashsim_w25q16_cfg, &flashfs_external_system_cfg)
+->Apply(GcModes)->Iterations(SETTINGS_OPS)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SettingsSave, stm32f4, &flashsim_stm32f4_cfg, &flashfs_internal_cfg)
+->Apply(GcModes)->Iterations(SETTINGS_OPS)->UseManualTime();
+
+BENCHMARK_CAPTURE(BM_SettingsLoad, m25p16, &flashsim_m25p16_cfg, &flashfs_external_system_cfg)
+->Iterations(SETTINGS_OPS)->UseManualTime();
+
+BENCHMARK_CAPTURE(BM_DebugLogAppend, m25p16, &flashsim_m25p16_cfg, &flashfs_external_user_cfg)
+->Apply(GcModes)->Iterations(DEBUGLOG_OPS)->UseManualTime();
+
+BENCHMARK_MAIN();
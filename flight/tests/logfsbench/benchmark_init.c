@@ -0,0 +1,85 @@
+/*
+ * These need to be defined in a .c file so that we can use
+ * designated initializer syntax which c++ doesn't support (yet).
+ */
+
+#include "flashsim.h"
+
+/* Typical datasheet values, the parts are the ones of pios_flash_jedec_catalog.h */
+const struct flashsim_timing flashsim_m25p16 = {
+    .name = "m25p16",
+    .spi_byte_ns     = 800, /* 10MHz SPI */
+    .page_program_us = 640,
+    .program_byte_ns = 0,
+    .sector_erase_us = 600000, /* 64K sector */
+};
+
+const struct flashsim_timing flashsim_w25q16 = {
+    .name = "w25q16",
+    .spi_byte_ns     = 800,
+    .page_program_us = 700,
+    .program_byte_ns = 0,
+    .sector_erase_us = 150000, /* 64K block */
+};
+
+const struct flashsim_timing flashsim_stm32f4 = {
+    .name = "stm32f4",
+    .spi_byte_ns     = 0,
+    .page_program_us = 0,
+    .program_byte_ns = 4000, /* 16us per 32 bits word */
+    .sector_erase_us = 250000, /* 16K sector */
+};
+
+const struct flashsim_cfg flashsim_m25p16_cfg = {
+    .size_of_flash  = 0x00200000,
+    .size_of_sector = 0x00010000,
+    .timing = &flashsim_m25p16,
+};
+
+const struct flashsim_cfg flashsim_w25q16_cfg = {
+    .size_of_flash  = 0x00200000,
+    .size_of_sector = 0x00010000,
+    .timing = &flashsim_w25q16,
+};
+
+const struct flashsim_cfg flashsim_stm32f4_cfg = {
+    .size_of_flash  = 0x00008000,
+    .size_of_sector = 0x00004000,
+    .timing = &flashsim_stm32f4,
+};
+
+#include "pios_flashfs_logfs_priv.h"
+
+/* The partitions of the Revolution, see board_hw_defs.c */
+const struct flashfs_logfs_cfg flashfs_external_system_cfg = {
+    .fs_magic      = 0x99bbcdef,
+    .total_fs_size = 0x00040000, /* 256K bytes (4 sectors) */
+    .arena_size    = 0x00010000, /* 256 * slot size */
+    .slot_size     = 0x00000100, /* 256 bytes */
+
+    .start_offset  = 0,          /* start at the beginning of the chip */
+    .sector_size   = 0x00010000, /* 64K bytes */
+    .page_size     = 0x00000100, /* 256 bytes */
+};
+
+const struct flashfs_logfs_cfg flashfs_external_user_cfg = {
+    .fs_magic      = 0x99abceff,
+    .total_fs_size = 0x001C0000, /* rest of the chip */
+    .arena_size    = 0x000E0000, /* biggest possible arena size fssize/2 */
+    .slot_size     = 0x00000100, /* 256 bytes */
+
+    .start_offset  = 0x00040000, /* start after the system partition */
+    .sector_size   = 0x00010000, /* 64K bytes */
+    .page_size     = 0x00000100, /* 256 bytes */
+};
+
+const struct flashfs_logfs_cfg flashfs_internal_cfg = {
+    .fs_magic      = 0x99abcfef,
+    .total_fs_size = 0x00008000, /* 32K bytes (2x16KB sectors) */
+    .arena_size    = 0x00004000, /* 64 * slot size = 16K bytes = 1 sector */
+    .slot_size     = 0x00000100, /* 256 bytes */
+
+    .start_offset  = 0,
+    .sector_size   = 0x00004000, /* 16K bytes */
+    .page_size     = 0x00004000, /* 16K bytes */
+};
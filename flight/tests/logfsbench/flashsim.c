@@ -0,0 +1,170 @@
+/*
+ * In memory flash with the cost model of a NOR flash part, the operations
+ * return immediately and add their typical duration to a simulated clock.
+ */
+
+#include <stdlib.h> /* malloc */
+#include <string.h> /* memset */
+#include <assert.h> /* assert */
+#include <stdbool.h>
+#include "pios_flash.h"
+#include "flashsim.h"
+
+/* Command and three address bytes */
+#define SPI_HEADER_BYTES 4
+/* Fast read dummy byte */
+#define SPI_READ_DUMMY   1
+/* Write enable before every program and erase */
+#define SPI_WREN_BYTES   1
+
+struct flashsim_dev {
+    const struct flashsim_cfg *cfg;
+    bool     transaction_in_progress;
+    uint8_t  *data;
+    uint32_t *sector_erases;
+    struct flashsim_stats stats;
+};
+
+int32_t FlashSim_Init(uintptr_t *flash_id, const struct flashsim_cfg *cfg)
+{
+    assert(flash_id);
+    assert(cfg);
+    assert(cfg->timing);
+    assert(cfg->size_of_flash);
+    assert(cfg->size_of_sector);
+    assert((cfg->size_of_flash % cfg->size_of_sector) == 0);
+
+    struct flashsim_dev *dev = calloc(1, sizeof(struct flashsim_dev));
+    if (!dev) {
+        return -1;
+    }
+
+    dev->cfg  = cfg;
+    dev->data = malloc(cfg->size_of_flash);
+    dev->sector_erases = calloc(cfg->size_of_flash / cfg->size_of_sector, sizeof(uint32_t));
+    if (!dev->data || !dev->sector_erases) {
+        FlashSim_Destroy((uintptr_t)dev);
+        return -1;
+    }
+    /* A new chip comes erased */
+    memset(dev->data, 0xFF, cfg->size_of_flash);
+
+    *flash_id = (uintptr_t)dev;
+
+    return 0;
+}
+
+int32_t FlashSim_Destroy(uintptr_t flash_id)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+
+    assert(dev);
+
+    free(dev->data);
+    free(dev->sector_erases);
+    free(dev);
+
+    return 0;
+}
+
+void FlashSim_GetStats(uintptr_t flash_id, struct flashsim_stats *stats)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+
+    assert(dev);
+
+    *stats = dev->stats;
+}
+
+static void FlashSim_AddTime(struct flashsim_dev *dev, uint32_t spi_bytes, uint64_t busy_ns)
+{
+    dev->stats.time_ns += (uint64_t)spi_bytes * dev->cfg->timing->spi_byte_ns + busy_ns;
+}
+
+static int32_t FlashSim_StartTransaction(uintptr_t flash_id)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+
+    assert(!dev->transaction_in_progress);
+    dev->transaction_in_progress = true;
+
+    return 0;
+}
+
+static int32_t FlashSim_EndTransaction(uintptr_t flash_id)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+
+    assert(dev->transaction_in_progress);
+    dev->transaction_in_progress = false;
+
+    return 0;
+}
+
+static int32_t FlashSim_EraseSector(uintptr_t flash_id, uint32_t addr)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+    uint32_t sector = addr / dev->cfg->size_of_sector;
+
+    assert(dev->transaction_in_progress);
+    assert(addr < dev->cfg->size_of_flash);
+
+    memset(&dev->data[sector * dev->cfg->size_of_sector], 0xFF, dev->cfg->size_of_sector);
+
+    dev->stats.erases++;
+    if (++dev->sector_erases[sector] > dev->stats.max_sector_erases) {
+        dev->stats.max_sector_erases = dev->sector_erases[sector];
+    }
+    FlashSim_AddTime(dev, SPI_WREN_BYTES + SPI_HEADER_BYTES, (uint64_t)dev->cfg->timing->sector_erase_us * 1000);
+
+    return 0;
+}
+
+static int32_t FlashSim_WriteData(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+
+    assert(data);
+    assert(dev->transaction_in_progress);
+    assert(addr + len <= dev->cfg->size_of_flash);
+
+    /* Programming only clears bits */
+    for (uint16_t i = 0; i < len; i++) {
+        if ((dev->data[addr + i] & data[i]) != data[i]) {
+            dev->stats.program_errors++;
+        }
+        dev->data[addr + i] &= data[i];
+    }
+
+    dev->stats.programs++;
+    dev->stats.bytes_programmed += len;
+    FlashSim_AddTime(dev, SPI_WREN_BYTES + SPI_HEADER_BYTES + len,
+                     (uint64_t)dev->cfg->timing->page_program_us * 1000 + (uint64_t)len * dev->cfg->timing->program_byte_ns);
+
+    return 0;
+}
+
+static int32_t FlashSim_ReadData(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    struct flashsim_dev *dev = (struct flashsim_dev *)flash_id;
+
+    assert(data);
+    assert(dev->transaction_in_progress);
+    assert(addr + len <= dev->cfg->size_of_flash);
+
+    memcpy(data, &dev->data[addr], len);
+
+    dev->stats.reads++;
+    dev->stats.bytes_read += len;
+    FlashSim_AddTime(dev, SPI_HEADER_BYTES + SPI_READ_DUMMY + len, 0);
+
+    return 0;
+}
+
+const struct pios_flash_driver flashsim_driver = {
+    .start_transaction = FlashSim_StartTransaction,
+    .end_transaction   = FlashSim_EndTransaction,
+    .erase_sector = FlashSim_EraseSector,
+    .write_data   = FlashSim_WriteData,
+    .read_data    = FlashSim_ReadData,
+};
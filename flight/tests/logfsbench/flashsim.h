@@ -0,0 +1,38 @@
+#ifndef FLASHSIM_H
+#define FLASHSIM_H
+
+#include <stdint.h>
+
+/* Typical timings of a flash part, the SPI transfer of the command, address and data is added for SPI parts */
+struct flashsim_timing {
+    const char *name;
+    uint32_t   spi_byte_ns; /* 0 for the memory mapped internal flash */
+    uint32_t   page_program_us; /* fixed cost of a program operation */
+    uint32_t   program_byte_ns; /* programming cost per byte on top of it */
+    uint32_t   sector_erase_us;
+};
+
+struct flashsim_cfg {
+    uint32_t size_of_flash;
+    uint32_t size_of_sector;
+    const struct flashsim_timing *timing;
+};
+
+struct flashsim_stats {
+    uint64_t time_ns; /* simulated time spent in the flash operations */
+    uint32_t erases;
+    uint32_t max_sector_erases; /* erases of the most worn sector */
+    uint32_t programs;
+    uint64_t bytes_programmed;
+    uint32_t reads;
+    uint64_t bytes_read;
+    uint32_t program_errors; /* writes trying to set programmed bits back to 1 */
+};
+
+int32_t FlashSim_Init(uintptr_t *flash_id, const struct flashsim_cfg *cfg);
+int32_t FlashSim_Destroy(uintptr_t flash_id);
+void FlashSim_GetStats(uintptr_t flash_id, struct flashsim_stats *stats);
+
+extern const struct pios_flash_driver flashsim_driver;
+
+#endif /* FLASHSIM_H */
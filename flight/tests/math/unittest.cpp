@@ -3,9 +3,15 @@
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* abort */
 #include <string.h> /* memset */
+#include <math.h>
+#include <time.h>
 
 extern "C" {
 #include "mathmisc.h"
+#include "sin_lookup.h"
+#include "butterworth.h"
+#include "pid.h"
+#include "CoordinateConversions.h"
 }
 
 #define epsilon 0.00001f
@@ -108,3 +114,287 @@ TEST_F(MathTestRaw, y_on_curve1) {
     EXPECT_NEAR(-0.35f, y_on_curve(1.250f, points, length(points)), epsilon);
     EXPECT_NEAR(-0.50f, y_on_curve(2.000f, points, length(points)), epsilon);
 }
+
+class SinLookupTest : public testing::Test {};
+
+#define SIN_LOOKUP_EPSILON 1.5e-5f
+#define BENCH_RUNS         1000000
+
+TEST_F(SinLookupTest, MatchesLibm) {
+    for (float angle = -720.0f; angle <= 720.0f; angle += 0.0625f + 0.001f) {
+        float s, c;
+        sincos_lookup_deg(angle, &s, &c);
+        EXPECT_NEAR(sinf(angle * (float)M_PI / 180.0f), s, SIN_LOOKUP_EPSILON) << "angle " << angle;
+        EXPECT_NEAR(cosf(angle * (float)M_PI / 180.0f), c, SIN_LOOKUP_EPSILON) << "angle " << angle;
+        EXPECT_EQ(s, sin_lookup_deg(angle));
+        EXPECT_EQ(c, cos_lookup_deg(angle));
+    }
+}
+
+TEST_F(SinLookupTest, Radians) {
+    for (float angle = -7.0f; angle <= 7.0f; angle += 0.01f) {
+        float s, c;
+        sincos_lookup_rad(angle, &s, &c);
+        EXPECT_NEAR(sinf(angle), s, SIN_LOOKUP_EPSILON) << "angle " << angle;
+        EXPECT_NEAR(cosf(angle), c, SIN_LOOKUP_EPSILON) << "angle " << angle;
+        EXPECT_NEAR(sinf(angle), sin_lookup_rad(angle), SIN_LOOKUP_EPSILON);
+        EXPECT_NEAR(cosf(angle), cos_lookup_rad(angle), SIN_LOOKUP_EPSILON);
+    }
+}
+
+TEST_F(SinLookupTest, ExactValues) {
+    EXPECT_EQ(0.0f, sin_lookup_deg(0.0f));
+    EXPECT_EQ(1.0f, cos_lookup_deg(0.0f));
+    EXPECT_EQ(1.0f, sin_lookup_deg(90.0f));
+    EXPECT_EQ(-1.0f, sin_lookup_deg(-90.0f));
+    EXPECT_EQ(-1.0f, cos_lookup_deg(180.0f));
+    EXPECT_NEAR(0.5f, sin_lookup_deg(30.0f), 1e-7f);
+    EXPECT_NEAR(0.5f, sin_lookup_deg(30.0f + 3600.0f), 1e-7f);
+}
+
+TEST_F(SinLookupTest, Benchmark) {
+    volatile float sink = 0.0f;
+    float maxError = 0.0f;
+
+    for (int i = 0; i < 100000; i++) {
+        float angle = -360.0f + i * 0.0072f;
+        maxError = fmaxf(maxError, fabsf(sin_lookup_deg(angle) - sinf(angle * (float)M_PI / 180.0f)));
+    }
+
+    clock_t start = clock();
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        float s, c;
+        sincos_lookup_deg(i * 0.001f, &s, &c);
+        sink = sink + s + c;
+    }
+    clock_t lookup = clock() - start;
+
+    start = clock();
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        float a = i * 0.001f * (float)M_PI / 180.0f;
+        sink = sink + sinf(a) + cosf(a);
+    }
+    clock_t libm = clock() - start;
+
+    // informative only, timings on the build host say little about the fpu of the target
+    printf("sincos_lookup_deg: %.1f ns per call, sinf+cosf %.1f ns, max error %g\n",
+           1e9 * lookup / CLOCKS_PER_SEC / BENCH_RUNS, 1e9 * libm / CLOCKS_PER_SEC / BENCH_RUNS, maxError);
+    EXPECT_LT(maxError, SIN_LOOKUP_EPSILON);
+}
+
+class BiquadBankTest : public testing::Test {
+protected:
+    // largest output amplitude once settled, for a sine on all three axes with different phases
+    float steadyAmplitude(struct BiquadFilterBank *bank, float ff)
+    {
+        float amplitude = 0.0f;
+
+        for (int n = 0; n < 4000; n++) {
+            float x[3] = { sinf(2.0f * (float)M_PI * ff * n), sinf(2.0f * (float)M_PI * ff * n + 1.0f), sinf(2.0f * (float)M_PI * ff * n + 2.0f) };
+            FilterBiquadBank(bank, x);
+            if (n >= 3000) {
+                amplitude = fmaxf(amplitude, fmaxf(fabsf(x[0]), fmaxf(fabsf(x[1]), fabsf(x[2]))));
+            }
+        }
+        return amplitude;
+    }
+};
+
+TEST_F(BiquadBankTest, EmptyPassesThrough) {
+    struct BiquadFilterBank bank;
+
+    InitBiquadBank(&bank);
+    float x[3] = { 1.0f, -2.0f, 3.0f };
+    FilterBiquadBank(&bank, x);
+    EXPECT_EQ(1.0f, x[0]);
+    EXPECT_EQ(-2.0f, x[1]);
+    EXPECT_EQ(3.0f, x[2]);
+}
+
+TEST_F(BiquadBankTest, Full) {
+    struct BiquadFilterBank bank;
+
+    InitBiquadBank(&bank);
+    for (int i = 0; i < BIQUAD_BANK_MAX_SECTIONS; i++) {
+        EXPECT_EQ(0, BiquadBankAddLowPass(&bank, 0.1f));
+    }
+    EXPECT_EQ(-1, BiquadBankAddNotch(&bank, 0.1f, 2.0f));
+    EXPECT_EQ(BIQUAD_BANK_MAX_SECTIONS, bank.numSections);
+}
+
+TEST_F(BiquadBankTest, LowPassMatchesDF2) {
+    struct BiquadFilterBank bank;
+    struct ButterWorthDF2Filter df2;
+    float wn1 = 0.0f, wn2 = 0.0f;
+
+    InitBiquadBank(&bank);
+    BiquadBankAddLowPass(&bank, 0.05f);
+    InitButterWorthDF2Filter(0.05f, &df2);
+    for (int n = 0; n < 200; n++) {
+        float xn   = (n % 17) - 8.0f;
+        float x[3] = { xn, 2.0f * xn, -xn };
+        FilterBiquadBank(&bank, x);
+        float y    = FilterButterWorthDF2(xn, &df2, &wn1, &wn2);
+        EXPECT_NEAR(y, x[0], 1e-4f);
+        EXPECT_NEAR(2.0f * y, x[1], 2e-4f);
+        EXPECT_NEAR(-y, x[2], 1e-4f);
+    }
+}
+
+TEST_F(BiquadBankTest, Notch) {
+    struct BiquadFilterBank bank;
+
+    InitBiquadBank(&bank);
+    BiquadBankAddNotch(&bank, 0.2f, 2.0f);
+    EXPECT_LT(steadyAmplitude(&bank, 0.2f), 1e-3f);
+
+    InitBiquadBank(&bank);
+    BiquadBankAddNotch(&bank, 0.2f, 2.0f);
+    EXPECT_GT(steadyAmplitude(&bank, 0.01f), 0.99f);
+}
+
+TEST_F(BiquadBankTest, CascadeAttenuates) {
+    struct BiquadFilterBank bank;
+
+    InitBiquadBank(&bank);
+    BiquadBankAddLowPass(&bank, 0.02f);
+    BiquadBankAddNotch(&bank, 0.25f, 1.0f);
+    // Butterworth: -40dB per decade above the cut-off
+    EXPECT_LT(steadyAmplitude(&bank, 0.2f), 0.011f);
+}
+
+TEST_F(BiquadBankTest, ResetSteadyState) {
+    struct BiquadFilterBank bank;
+    const float x0[3] = { 10.0f, -5.0f, 0.5f };
+
+    InitBiquadBank(&bank);
+    BiquadBankAddLowPass(&bank, 0.05f);
+    BiquadBankAddNotch(&bank, 0.2f, 3.0f);
+    BiquadBankReset(&bank, x0);
+    for (int n = 0; n < 10; n++) {
+        float x[3] = { x0[0], x0[1], x0[2] };
+        FilterBiquadBank(&bank, x);
+        EXPECT_NEAR(x0[0], x[0], 1e-4f);
+        EXPECT_NEAR(x0[1], x[1], 1e-4f);
+        EXPECT_NEAR(x0[2], x[2], 1e-5f);
+    }
+}
+
+class Pid3Test : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        pid_configure_derivative(20.0f, 0.8f);
+        for (int t = 0; t < 3; t++) {
+            pid_configure(&pids[t], 0.003f * (t + 1), 0.006f, 0.00004f * t, 0.3f);
+            pid_zero(&pids[t]);
+            scalers[t].p = 1.0f;
+            scalers[t].i = 0.5f + t;
+            scalers[t].d = 1.5f;
+        }
+        memcpy(reference, pids, sizeof(pids));
+    }
+
+    struct pid pids[3];
+    struct pid reference[3];
+    pid_scaler scalers[3];
+};
+
+TEST_F(Pid3Test, MatchesSingleAxis) {
+    for (int n = 0; n < 2000; n++) {
+        const float dT = 0.002f + 0.0001f * (n % 3);
+        const float setpoint[3] = { 100.0f * sinf(n * 0.01f), -50.0f, 300.0f * (n % 200 < 100) };
+        const float measured[3] = { 90.0f * sinf(n * 0.01f - 0.1f), -40.0f + (n % 7), 0.0f };
+        float output[3];
+
+        pid3_apply_setpoint(pids, scalers, setpoint, measured, dT, 0x7, output);
+        for (int t = 0; t < 3; t++) {
+            float expected = pid_apply_setpoint(&reference[t], &scalers[t], setpoint[t], measured[t], dT);
+            ASSERT_NEAR(expected, output[t], 1e-5f + 1e-5f * fabsf(expected)) << "axis " << t << " step " << n;
+            ASSERT_NEAR(reference[t].iAccumulator, pids[t].iAccumulator, 1e-3f);
+            ASSERT_NEAR(reference[t].lastDer, pids[t].lastDer, 1e-5f + 1e-5f * fabsf(reference[t].lastDer));
+        }
+    }
+    // the integral of axis 2 hit its limit
+    EXPECT_FLOAT_EQ(300.0f, pids[2].iAccumulator);
+}
+
+TEST_F(Pid3Test, OnlySelectedAxes) {
+    const float setpoint[3] = { 10.0f, 20.0f, 30.0f };
+    const float measured[3] = { 0.0f, 0.0f, 0.0f };
+    float output[3] = { -1.0f, -2.0f, -3.0f };
+
+    pid3_apply_setpoint(pids, scalers, setpoint, measured, 0.002f, 0x2, output);
+    EXPECT_EQ(-1.0f, output[0]);
+    EXPECT_NE(-2.0f, output[1]);
+    EXPECT_EQ(-3.0f, output[2]);
+    EXPECT_EQ(0, memcmp(&pids[0], &reference[0], sizeof(struct pid)));
+    EXPECT_EQ(0, memcmp(&pids[2], &reference[2], sizeof(struct pid)));
+}
+
+class CoordinateConversionsTest : public testing::Test {};
+
+TEST_F(CoordinateConversionsTest, ECEF2LLARoundTrip) {
+    const int32_t locations[][3] = {
+        { 473820000,   85410000,   4500000   },
+        { -337000000,  1511900000, 0         },
+        { 0,           0,          100000000 },
+        { 895000000,   -1200000,   25000000  },
+        { -600000000,  -1790000000, 50000    },
+    };
+
+    for (uint8_t i = 0; i < length(locations); i++) {
+        int32_t LLAi[3] = { locations[i][0], locations[i][1], locations[i][2] };
+        double ECEF[3];
+        float LLA[3] = { 0.0f, 0.0f, 0.0f };
+
+        LLA2ECEF(LLAi, ECEF);
+        EXPECT_EQ(1, ECEF2LLA(ECEF, LLA));
+        // within the float resolution of the degrees
+        EXPECT_NEAR(LLAi[0] * 1e-7, LLA[0], 1e-5) << "location " << (int)i;
+        EXPECT_NEAR(LLAi[1] * 1e-7, LLA[1], 1e-5) << "location " << (int)i;
+        EXPECT_NEAR(LLAi[2] * 1e-4, LLA[2], 1e-2) << "location " << (int)i;
+    }
+}
+
+TEST_F(CoordinateConversionsTest, BaseFromLLACached) {
+    struct CoordinateBase base;
+    int32_t home[3] = { 473820000, 85410000, 4500000 };
+
+    memset(&base, 0, sizeof(base));
+    EXPECT_EQ(1, BaseFromLLA(home, &base));
+    EXPECT_EQ(0, BaseFromLLA(home, &base));
+    home[2] += 1;
+    EXPECT_EQ(1, BaseFromLLA(home, &base));
+}
+
+TEST_F(CoordinateConversionsTest, LLA2BaseFlatErrorBound) {
+    const int32_t latitudes[] = { 0, 473820000, 700000000 };
+
+    for (uint8_t i = 0; i < length(latitudes); i++) {
+        struct CoordinateBase base;
+        int32_t home[3] = { latitudes[i], 85410000, 4500000 };
+
+        memset(&base, 0, sizeof(base));
+        BaseFromLLA(home, &base);
+        // up to 10km away in all directions, beyond the flat earth distance
+        for (int32_t d = 1000; d <= 900000; d *= 3) {
+            for (int k = 0; k < 8; k++) {
+                int32_t LLAi[3] = {
+                    home[0] + (int32_t)(d * cosf(k * M_PI / 4)),
+                    home[1] + (int32_t)(d * sinf(k * M_PI / 4)),
+                    home[2] + 500000,
+                };
+                float exact[3], flat[3];
+
+                LLA2Base(LLAi, base.ECEF, base.Rne, exact);
+                LLA2BaseFlat(LLAi, &base, flat);
+                for (int j = 0; j < 3; j++) {
+                    // plus the float rounding of the exact conversion
+                    EXPECT_NEAR(exact[j], flat[j], COORDINATE_FLAT_EARTH_MAX_ERROR + 1e-5f * fabsf(exact[j]) + 2e-3f)
+                        << "latitude " << latitudes[i] << " distance " << d << " direction " << k << " axis " << j;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#include <benchmark/benchmark.h>
+
+extern "C" {
+#include "mathbench.h"
+}
+
+// Natively the cases run under Google Benchmark, on target mathbench_run()
+// times them with the cycle counter instead
+static void BM_MathCase(benchmark::State & state, const struct mathbench_case *bench)
+{
+    bench->setup();
+    for (auto _ : state) {
+        bench->run();
+    }
+}
+
+static int register_cases()
+{
+    for (uint32_t n = 0; n < mathbench_num_cases; n++) {
+        benchmark::RegisterBenchmark(mathbench_cases[n].name, BM_MathCase, &mathbench_cases[n]);
+    }
+    return 0;
+}
+
+static int registered = register_cases();
+
+BENCHMARK_MAIN();
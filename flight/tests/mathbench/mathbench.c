@@ -0,0 +1,259 @@
+/**
+ ******************************************************************************
+ *
+ * @file       mathbench.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Benchmark cases of the flight math libraries
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include "mathbench.h"
+#include "CoordinateConversions.h"
+#include "WorldMagModel.h"
+#include "insgps.h"
+#include "sin_lookup.h"
+#include "butterworth.h"
+#include "pid.h"
+
+// Results are stored here so that the compiler keeps the computations
+static volatile float sink;
+
+// Inputs vary between the runs so that nothing can be hoisted out of the loop
+static float step;
+
+static float next_input(void)
+{
+    step += 0.01f;
+    if (step > 1.0f) {
+        step = -1.0f;
+    }
+    return step;
+}
+
+static void setup_step(void)
+{
+    step = 0.0f;
+}
+
+static void run_quaternion2r(void)
+{
+    float q[4] = { 0.9f, next_input() * 0.3f, 0.1f, -0.2f };
+    float R[3][3];
+
+    Quaternion2R(q, R);
+    sink = R[0][0] + R[1][2] + R[2][1];
+}
+
+static void run_rpy2quaternion(void)
+{
+    float rpy[3] = { next_input() * 180.0f, 10.0f, -45.0f };
+    float q[4];
+
+    RPY2Quaternion(rpy, q);
+    sink = q[0] + q[3];
+}
+
+static int32_t lla_home[3] = { 473820000, 85410000, 45000 };
+static double lla_base[3];
+static float lla_rne[3][3];
+static struct CoordinateBase lla_flat_base;
+
+static void setup_lla2base(void)
+{
+    setup_step();
+    LLA2ECEF(lla_home, lla_base);
+    RneFromLLA(lla_home, lla_rne);
+}
+
+static void run_lla2base(void)
+{
+    int32_t lla[3] = { lla_home[0] + (int32_t)(next_input() * 10000.0f), lla_home[1] + 2500, lla_home[2] + 1000 };
+    float NED[3];
+
+    LLA2Base(lla, lla_base, lla_rne, NED);
+    sink = NED[0] + NED[1] + NED[2];
+}
+
+static void setup_lla2baseflat(void)
+{
+    setup_step();
+    lla_flat_base.valid = 0;
+    BaseFromLLA(lla_home, &lla_flat_base);
+}
+
+static void run_lla2baseflat(void)
+{
+    int32_t lla[3] = { lla_home[0] + (int32_t)(next_input() * 10000.0f), lla_home[1] + 2500, lla_home[2] + 1000 };
+    float NED[3];
+
+    LLA2BaseFlat(lla, &lla_flat_base, NED);
+    sink = NED[0] + NED[1] + NED[2];
+}
+
+static void run_ecef2lla(void)
+{
+    double ECEF[3] = { lla_base[0] + next_input() * 1000.0d, lla_base[1] + 250.0d, lla_base[2] + 100.0d };
+    float LLA[3];
+
+    ECEF2LLA(ECEF, LLA);
+    sink = LLA[0] + LLA[1] + LLA[2];
+}
+
+static void setup_sin_lookup(void)
+{
+    setup_step();
+    sin_lookup_initalize();
+}
+
+static void run_sin_lookup(void)
+{
+    float s, c;
+
+    sincos_lookup_deg(next_input() * 360.0f, &s, &c);
+    sink = s + c;
+}
+
+static struct pid pid;
+static const pid_scaler pid_scale = { 1.0f, 1.0f, 1.0f };
+
+static void setup_pid(void)
+{
+    setup_step();
+    pid_configure_derivative(25.0f, 0.95f);
+    pid_configure(&pid, 0.003f, 0.002f, 0.00003f, 0.3f);
+}
+
+static void run_pid(void)
+{
+    sink = pid_apply_setpoint(&pid, &pid_scale, 0.0f, next_input() * 100.0f, 0.002f);
+}
+
+static struct ButterWorthDF2Filter butterworth;
+static float butterworth_wn1, butterworth_wn2;
+
+static void setup_butterworth(void)
+{
+    setup_step();
+    InitButterWorthDF2Filter(0.05f, &butterworth);
+    InitButterWorthDF2Values(0.0f, &butterworth, &butterworth_wn1, &butterworth_wn2);
+}
+
+static void run_butterworth(void)
+{
+    sink = FilterButterWorthDF2(next_input(), &butterworth, &butterworth_wn1, &butterworth_wn2);
+}
+
+static struct BiquadFilterBank biquad_bank;
+
+static void setup_biquad_bank(void)
+{
+    const float x0[BIQUAD_BANK_AXES] = { 0.0f, 0.0f, 0.0f };
+
+    setup_step();
+    InitBiquadBank(&biquad_bank);
+    BiquadBankAddLowPass(&biquad_bank, 0.05f);
+    BiquadBankAddNotch(&biquad_bank, 0.2f, 5.0f);
+    BiquadBankReset(&biquad_bank, x0);
+}
+
+static void run_biquad_bank(void)
+{
+    float x[BIQUAD_BANK_AXES] = { next_input(), 0.5f, -0.5f };
+
+    FilterBiquadBank(&biquad_bank, x);
+    sink = x[0] + x[1] + x[2];
+}
+
+static void setup_insgps(void)
+{
+    float mag_north[3] = { 21500.0f, 1500.0f, 42000.0f };
+
+    setup_step();
+    INSGPSInit();
+    INSSetMagNorth(mag_north);
+}
+
+static void run_insgps_prediction(void)
+{
+    float gyro[3]  = { next_input() * 0.1f, 0.02f, -0.01f };
+    float accel[3] = { 0.1f, -0.1f, -9.81f };
+
+    INSStatePrediction(gyro, accel, 0.002f);
+    INSCovariancePrediction(0.002f);
+    sink = gyro[0];
+}
+
+static void run_insgps_correction(void)
+{
+    float mag[3] = { 21500.0f + next_input() * 100.0f, 1500.0f, 42000.0f };
+    float pos[3] = { 0.0f, 0.0f, 0.0f };
+    float vel[3] = { 0.0f, 0.0f, 0.0f };
+
+    sink = INSCorrection(mag, pos, vel, 0.0f, FULL_SENSORS);
+}
+
+static void setup_wmm(void)
+{
+    setup_step();
+    WMM_Initialize();
+}
+
+static void run_wmm(void)
+{
+    float B[3];
+
+    // Far enough apart to defeat the reuse of the last evaluation
+    WMM_GetMagVector(47.0f + next_input() * 40.0f, 8.5f, 0.5f, 10, 14, 2014, B);
+    sink = B[0] + B[1] + B[2];
+}
+
+const struct mathbench_case mathbench_cases[] = {
+    { "Quaternion2R",          setup_step,        run_quaternion2r      },
+    { "RPY2Quaternion",        setup_step,        run_rpy2quaternion    },
+    { "LLA2Base",              setup_lla2base,    run_lla2base          },
+    { "LLA2BaseFlat",          setup_lla2baseflat, run_lla2baseflat     },
+    { "ECEF2LLA",              setup_lla2base,    run_ecef2lla          },
+    { "sincos_lookup_deg",     setup_sin_lookup,  run_sin_lookup        },
+    { "pid_apply_setpoint",    setup_pid,         run_pid               },
+    { "FilterButterWorthDF2",  setup_butterworth, run_butterworth       },
+    { "FilterBiquadBank",      setup_biquad_bank, run_biquad_bank       },
+    { "INSPrediction",         setup_insgps,      run_insgps_prediction },
+    { "INSCorrection",         setup_insgps,      run_insgps_correction },
+    { "WMM_GetMagVector",      setup_wmm,         run_wmm               },
+};
+
+const uint32_t mathbench_num_cases = sizeof(mathbench_cases) / sizeof(mathbench_cases[0]);
+
+void mathbench_run(uint32_t (*cycles)(void), void (*report)(const char *name, uint32_t cycles), uint32_t iterations)
+{
+    for (uint32_t n = 0; n < mathbench_num_cases; n++) {
+        const struct mathbench_case *bench = &mathbench_cases[n];
+
+        bench->setup();
+        uint32_t start = cycles();
+        for (uint32_t i = 0; i < iterations; i++) {
+            bench->run();
+        }
+        // Unsigned arithmetic handles one wrap of the counter
+        uint32_t elapsed = cycles() - start;
+        report(bench->name, iterations ? elapsed / iterations : 0);
+    }
+}
@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ *
+ * @file       mathbench.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Benchmark cases of the flight math libraries
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef MATHBENCH_H
+#define MATHBENCH_H
+
+#include <stdint.h>
+
+// A benchmark case, setup() is called once before iterations of run()
+struct mathbench_case {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(void);
+};
+
+extern const struct mathbench_case mathbench_cases[];
+extern const uint32_t mathbench_num_cases;
+
+/**
+ * Runs all the cases with a cycle counter, e.g. PIOS_DELAY_GetRaw() which
+ * reads the DWT cycle counter on the STM32F4 targets.
+ * \param[in] cycles the cycle counter
+ * \param[in] report called with the mean number of cycles of each case
+ * \param[in] iterations number of runs of each case
+ */
+void mathbench_run(uint32_t (*cycles)(void), void (*report)(const char *name, uint32_t cycles), uint32_t iterations);
+
+#endif /* MATHBENCH_H */
@@ -0,0 +1,10 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define pios_malloc(size) malloc(size)
+#define vPortFree(ptr)    free(ptr)
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,10 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// as on the boards with a radio
+#define RS_ECC_NPARITY 4
+
+#endif /* OPENPILOT_H */
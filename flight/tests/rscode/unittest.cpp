@@ -0,0 +1,186 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* rand */
+#include <string.h> /* memcpy */
+#include <time.h>
+
+extern "C" {
+#include "ecc.h"
+
+extern int genPoly[MAXDEG * 2];
+}
+
+#define PACKET_LEN   60
+#define CODEWORD_LEN (PACKET_LEN + RS_ECC_NPARITY)
+#define BENCH_RUNS   20000
+
+// The generic codec the library used before, kept as the reference
+static int ref_gmult(int a, int b)
+{
+    // carry-less multiplication modulo x^8 + x^4 + x^3 + x^2 + 1, without the tables
+    int p = 0;
+
+    while (b) {
+        if (b & 1) {
+            p ^= a;
+        }
+        a <<= 1;
+        if (a & 0x100) {
+            a ^= 0x11d;
+        }
+        b >>= 1;
+    }
+    return p;
+}
+
+static int ref_gexp(int n)
+{
+    int p = 1;
+
+    while (n-- > 0) {
+        p = ref_gmult(p, 2);
+    }
+    return p;
+}
+
+static void ref_encode(const unsigned char msg[], int nbytes, unsigned char dst[])
+{
+    int i, j, dbyte, LFSR[RS_ECC_NPARITY + 1] = { 0 };
+
+    for (i = 0; i < nbytes; i++) {
+        dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY - 1];
+        for (j = RS_ECC_NPARITY - 1; j > 0; j--) {
+            LFSR[j] = LFSR[j - 1] ^ ref_gmult(genPoly[j], dbyte);
+        }
+        LFSR[0] = ref_gmult(genPoly[0], dbyte);
+    }
+    memcpy(dst, msg, nbytes);
+    for (i = 0; i < RS_ECC_NPARITY; i++) {
+        dst[i + nbytes] = LFSR[RS_ECC_NPARITY - 1 - i];
+    }
+}
+
+static void ref_syndromes(const unsigned char data[], int nbytes, int syn[])
+{
+    for (int j = 0; j < RS_ECC_NPARITY; j++) {
+        int sum = 0;
+        int alpha = ref_gexp(j + 1);
+        for (int i = 0; i < nbytes; i++) {
+            sum = data[i] ^ ref_gmult(alpha, sum);
+        }
+        syn[j] = sum;
+    }
+}
+
+static void random_packet(unsigned char *packet, int len)
+{
+    for (int i = 0; i < len; i++) {
+        packet[i] = rand() & 0xff;
+    }
+}
+
+class RSCodeTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        srand(1);
+        initialize_ecc();
+    }
+};
+
+TEST_F(RSCodeTest, Tables) {
+    for (int i = 0; i < 255; i++) {
+        EXPECT_EQ(ref_gexp(i), gexp[i]);
+        EXPECT_EQ(gexp[i], gexp[i + 255]);
+        EXPECT_EQ(i, glog[gexp[i]]);
+    }
+    for (int a = 0; a < 256; a += 7) {
+        for (int b = 0; b < 256; b++) {
+            ASSERT_EQ(ref_gmult(a, b), gmult(a, b));
+        }
+    }
+}
+
+TEST_F(RSCodeTest, EncodeMatchesReference) {
+    unsigned char packet[CODEWORD_LEN], codeword[CODEWORD_LEN], reference[CODEWORD_LEN];
+
+    for (int run = 0; run < 1000; run++) {
+        int len = 1 + run % PACKET_LEN;
+        random_packet(packet, len);
+        if (run % 10 == 0) {
+            // runs of zero bytes take the shift only path
+            memset(packet, 0, len / 2);
+        }
+        encode_data(packet, len, codeword);
+        ref_encode(packet, len, reference);
+        ASSERT_EQ(0, memcmp(codeword, reference, len + RS_ECC_NPARITY));
+    }
+}
+
+TEST_F(RSCodeTest, SyndromesMatchReference) {
+    unsigned char codeword[CODEWORD_LEN];
+    int reference[RS_ECC_NPARITY];
+
+    for (int run = 0; run < 1000; run++) {
+        random_packet(codeword, CODEWORD_LEN);
+        decode_data(codeword, CODEWORD_LEN);
+        ref_syndromes(codeword, CODEWORD_LEN, reference);
+        for (int j = 0; j < RS_ECC_NPARITY; j++) {
+            ASSERT_EQ(reference[j], synBytes[j]);
+        }
+    }
+}
+
+TEST_F(RSCodeTest, CorrectsErrors) {
+    unsigned char packet[PACKET_LEN], codeword[CODEWORD_LEN];
+
+    for (int run = 0; run < 200; run++) {
+        random_packet(packet, PACKET_LEN);
+        encode_data(packet, PACKET_LEN, codeword);
+
+        decode_data(codeword, CODEWORD_LEN);
+        EXPECT_EQ(0, check_syndrome());
+
+        // up to RS_ECC_NPARITY / 2 byte errors are corrected
+        for (int e = 0; e < RS_ECC_NPARITY / 2; e++) {
+            codeword[rand() % CODEWORD_LEN] ^= 1 + rand() % 255;
+        }
+        decode_data(codeword, CODEWORD_LEN);
+        if (check_syndrome() != 0) {
+            EXPECT_EQ(1, correct_errors_erasures(codeword, CODEWORD_LEN, 0, 0));
+        }
+        EXPECT_EQ(0, memcmp(packet, codeword, PACKET_LEN));
+    }
+}
+
+TEST_F(RSCodeTest, Benchmark) {
+    unsigned char packet[PACKET_LEN], codeword[CODEWORD_LEN];
+    int syn[RS_ECC_NPARITY];
+    volatile int sink = 0;
+
+    random_packet(packet, PACKET_LEN);
+
+    clock_t start = clock();
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        packet[0] = i;
+        encode_data(packet, PACKET_LEN, codeword);
+        decode_data(codeword, CODEWORD_LEN);
+        sink = sink + check_syndrome();
+    }
+    clock_t tables = clock() - start;
+
+    start = clock();
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        packet[0] = i;
+        ref_encode(packet, PACKET_LEN, codeword);
+        ref_syndromes(codeword, CODEWORD_LEN, syn);
+        sink = sink + syn[0];
+    }
+    clock_t generic = clock() - start;
+
+    // informative only, timings on the build host say little about the target
+    printf("rscode encode+syndromes of %d bytes: %.0f ns per packet, generic gf arithmetic %.0f ns\n",
+           PACKET_LEN, tables * 1e9 / CLOCKS_PER_SEC / BENCH_RUNS, generic * 1e9 / CLOCKS_PER_SEC / BENCH_RUNS);
+    EXPECT_EQ(0, sink);
+}
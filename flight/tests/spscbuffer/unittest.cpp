@@ -0,0 +1,221 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+extern "C" {
+#include "fifo_buffer.h"
+#include "spsc_buffer.h"
+}
+
+#define BUFFER_SIZE   256
+#define STRESS_BYTES  (4 * 1024 * 1024)
+#define BENCH_BYTES   (16 * 1024 * 1024)
+
+// To use a test fixture, derive a class from testing::Test.
+class SpscBufferTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(0, spscBuf_init(&buf, storage, BUFFER_SIZE));
+    }
+
+    t_spsc_buffer buf;
+    uint8_t storage[BUFFER_SIZE];
+};
+
+TEST_F(SpscBufferTest, InitRejectsNonPowerOfTwo) {
+    t_spsc_buffer other;
+
+    EXPECT_EQ(-1, spscBuf_init(&other, storage, 0));
+    EXPECT_EQ(-1, spscBuf_init(&other, storage, 100));
+    EXPECT_EQ(0, spscBuf_init(&other, storage, 128));
+    EXPECT_EQ(128, spscBuf_getSize(&other));
+}
+
+TEST_F(SpscBufferTest, WholeSizeIsUsable) {
+    uint8_t data[BUFFER_SIZE + 1];
+
+    memset(data, 0xA5, sizeof(data));
+    EXPECT_EQ(BUFFER_SIZE, spscBuf_getFree(&buf));
+    EXPECT_EQ(BUFFER_SIZE, spscBuf_putData(&buf, data, sizeof(data)));
+    EXPECT_EQ(0, spscBuf_getFree(&buf));
+    EXPECT_EQ(0, spscBuf_putByte(&buf, 1));
+    EXPECT_EQ(BUFFER_SIZE, spscBuf_getUsed(&buf));
+    spscBuf_clearData(&buf);
+    EXPECT_EQ(0, spscBuf_getUsed(&buf));
+    EXPECT_EQ(-1, spscBuf_getByte(&buf));
+}
+
+TEST_F(SpscBufferTest, DataWrapsAround) {
+    uint8_t in[100], out[100];
+
+    for (int round = 0; round < 20; round++) {
+        for (unsigned int i = 0; i < sizeof(in); i++) {
+            in[i] = round * 7 + i;
+        }
+        ASSERT_EQ(sizeof(in), spscBuf_putData(&buf, in, sizeof(in)));
+        EXPECT_EQ(in[0], spscBuf_getByte(&buf));
+        memset(out, 0, sizeof(out));
+        ASSERT_EQ(sizeof(in) - 1, spscBuf_getDataPeek(&buf, out, sizeof(out)));
+        EXPECT_EQ(0, memcmp(in + 1, out, sizeof(in) - 1));
+        ASSERT_EQ(sizeof(in) - 1, spscBuf_getData(&buf, out, sizeof(out)));
+        EXPECT_EQ(0, memcmp(in + 1, out, sizeof(in) - 1));
+        EXPECT_EQ(0, spscBuf_getUsed(&buf));
+    }
+}
+
+TEST_F(SpscBufferTest, RegionsSplitAtTheEnd) {
+    t_spsc_regions regions;
+    uint8_t data[BUFFER_SIZE];
+
+    memset(data, 0, sizeof(data));
+    // Move the indexes close to the end of the storage
+    spscBuf_putData(&buf, data, BUFFER_SIZE - 10);
+    spscBuf_getData(&buf, data, BUFFER_SIZE - 10);
+
+    EXPECT_EQ(BUFFER_SIZE, spscBuf_writePeek(&buf, &regions));
+    EXPECT_EQ(storage + BUFFER_SIZE - 10, regions.ptr[0]);
+    EXPECT_EQ(10, regions.len[0]);
+    EXPECT_EQ(storage, regions.ptr[1]);
+    EXPECT_EQ(BUFFER_SIZE - 10, regions.len[1]);
+
+    // Fill, as a DMA would, then commit
+    memset(regions.ptr[0], 1, regions.len[0]);
+    memset(regions.ptr[1], 2, 5);
+    spscBuf_writeCommit(&buf, 15);
+
+    EXPECT_EQ(15, spscBuf_readPeek(&buf, &regions));
+    EXPECT_EQ(10, regions.len[0]);
+    EXPECT_EQ(5, regions.len[1]);
+    EXPECT_EQ(1, regions.ptr[0][9]);
+    EXPECT_EQ(2, regions.ptr[1][4]);
+    spscBuf_readCommit(&buf, 12);
+    EXPECT_EQ(3, spscBuf_readPeek(&buf, &regions));
+    EXPECT_EQ(3, regions.len[0]);
+    EXPECT_EQ(0, regions.len[1]);
+}
+
+static void *producer(void *arg)
+{
+    t_spsc_buffer *buf = (t_spsc_buffer *)arg;
+    uint8_t chunk[37];
+    uint32_t sent = 0;
+
+    while (sent < STRESS_BYTES) {
+        uint16_t len = sizeof(chunk);
+        if (len > STRESS_BYTES - sent) {
+            len = STRESS_BYTES - sent;
+        }
+        for (uint16_t i = 0; i < len; i++) {
+            chunk[i] = (uint8_t)(sent + i);
+        }
+        // Retry the part that did not fit
+        uint16_t done = 0;
+        while (done < len) {
+            uint16_t put = spscBuf_putData(buf, chunk + done, len - done);
+            if (put == 0) {
+                sched_yield(); // full, let the consumer run
+            }
+            done += put;
+        }
+        sent += len;
+    }
+    return NULL;
+}
+
+TEST_F(SpscBufferTest, ProducerAndConsumerThreads) {
+    pthread_t thread;
+    uint8_t chunk[53];
+    uint32_t received = 0;
+    uint32_t errors   = 0;
+
+    ASSERT_EQ(0, pthread_create(&thread, NULL, producer, &buf));
+    while (received < STRESS_BYTES) {
+        uint16_t len = spscBuf_getData(&buf, chunk, sizeof(chunk));
+        if (len == 0) {
+            sched_yield(); // empty, let the producer run
+        }
+        for (uint16_t i = 0; i < len; i++) {
+            if (chunk[i] != (uint8_t)(received + i)) {
+                errors++;
+            }
+        }
+        received += len;
+    }
+    pthread_join(thread, NULL);
+    EXPECT_EQ(0u, errors);
+    EXPECT_EQ(0, spscBuf_getUsed(&buf));
+}
+
+// Microbenchmark against t_fifo_buffer, data is passed through in chunks of various sizes.
+// Only reports the throughput, the timings depend on the host.
+class SpscBufferBench : public testing::Test {};
+
+static double elapsed(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static void benchmark(uint16_t chunkSize)
+{
+    static uint8_t storage[BUFFER_SIZE];
+    uint8_t in[BUFFER_SIZE], out[BUFFER_SIZE];
+    struct timespec start;
+    uint32_t checksum[2] = { 0, 0 };
+    double seconds[2];
+
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        in[i] = i;
+    }
+
+    // fifo_buffer keeps one byte free, give it one more byte so that both hold the same
+    static uint8_t fifoStorage[BUFFER_SIZE + 1];
+    t_fifo_buffer fifo;
+    fifoBuf_init(&fifo, fifoStorage, sizeof(fifoStorage));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t total = 0; total < BENCH_BYTES; total += chunkSize) {
+        if (chunkSize == 1) {
+            fifoBuf_putByte(&fifo, in[total & 0xFF]);
+            checksum[0] += fifoBuf_getByte(&fifo);
+        } else {
+            fifoBuf_putData(&fifo, in, chunkSize);
+            fifoBuf_getData(&fifo, out, chunkSize);
+            checksum[0] += out[chunkSize - 1];
+        }
+    }
+    seconds[0] = elapsed(&start);
+
+    t_spsc_buffer spsc;
+    spscBuf_init(&spsc, storage, sizeof(storage));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t total = 0; total < BENCH_BYTES; total += chunkSize) {
+        if (chunkSize == 1) {
+            spscBuf_putByte(&spsc, in[total & 0xFF]);
+            checksum[1] += spscBuf_getByte(&spsc);
+        } else {
+            spscBuf_putData(&spsc, in, chunkSize);
+            spscBuf_getData(&spsc, out, chunkSize);
+            checksum[1] += out[chunkSize - 1];
+        }
+    }
+    seconds[1] = elapsed(&start);
+
+    EXPECT_EQ(checksum[0], checksum[1]);
+    printf("chunk %3d bytes: fifo_buffer %7.1f MB/s, spsc_buffer %7.1f MB/s\n", chunkSize,
+           BENCH_BYTES / seconds[0] / 1e6, BENCH_BYTES / seconds[1] / 1e6);
+}
+
+TEST_F(SpscBufferBench, Throughput) {
+    benchmark(1);
+    benchmark(7);
+    benchmark(64);
+    benchmark(200);
+}
@@ -44,6 +44,7 @@
 #define CALLBACK_PRIORITY    CALLBACK_PRIORITY_CRITICAL
 #define TASK_PRIORITY        CALLBACK_TASK_FLIGHTCONTROL
 #define MAX_UPDATE_PERIOD_MS 1000
+#define LATE_UPDATE_MS       5 // periodic updates fired later than this are counted as late
 
 // Private types
 
@@ -60,28 +61,37 @@ typedef struct {
 
 /**
  * List of object properties that are needed for the periodic updates.
+ * The entries with a period are also kept in a pairing heap ordered by their next update,
+ * so that each wakeup only touches the entries that are due.
  */
 struct PeriodicObjectListStruct {
     EventCallbackInfo evInfo; /** Event callback information */
     uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-    int32_t  timeToNextUpdateMs; /** Time delay to the next update */
+    uint32_t nextUpdateMs; /** System time of the next update */
+    bool     scheduled; /** Entry is in the heap */
+    struct PeriodicObjectListStruct *heapChild; /** First child in the heap */
+    struct PeriodicObjectListStruct *heapNext; /** Right sibling in the heap */
+    struct PeriodicObjectListStruct *heapPrev; /** Parent of a first child, left sibling of the other children */
     struct PeriodicObjectListStruct *next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private variables
 static PeriodicObjectList *mObjList;
+static PeriodicObjectList *mUpdates; /** Root of the heap of periodic updates */
 static xQueueHandle mQueue;
 static DelayedCallbackInfo *eventSchedulerCallback;
 static xSemaphoreHandle mMutex;
 static EventStats mStats;
 
 // Private functions
-static int32_t processPeriodicUpdates();
+static uint32_t processPeriodicUpdates();
 static void eventTask();
 static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
+static void scheduleUpdate(PeriodicObjectList *objEntry, uint32_t timeMs);
+static void unscheduleUpdate(PeriodicObjectList *objEntry);
 
 
 /**
@@ -92,6 +102,7 @@ int32_t EventDispatcherInitialize()
 {
     // Initialize variables
     mObjList = NULL;
+    mUpdates = NULL;
     memset(&mStats, 0, sizeof(EventStats));
 
     // Create mMutex
@@ -230,6 +241,7 @@ static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
     // Create handle
     objEntry = (PeriodicObjectList *)pios_malloc(sizeof(PeriodicObjectList));
     if (objEntry == NULL) {
+        xSemaphoreGiveRecursive(mMutex);
         return -1;
     }
     objEntry->evInfo.ev.obj      = ev->obj;
@@ -238,9 +250,12 @@ static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
     objEntry->evInfo.cb = cb;
     objEntry->evInfo.queue       = queue;
     objEntry->updatePeriodMs     = periodMs;
-    objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
-    // Add to list
-    LL_APPEND(mObjList, objEntry);
+    objEntry->scheduled = false;
+    if (periodMs > 0) {
+        scheduleUpdate(objEntry, xTaskGetTickCount() * portTICK_RATE_MS + randomizePeriod(periodMs)); // avoid bunching of updates
+    }
+    // Add to list, the order does not matter
+    LL_PREPEND(mObjList, objEntry);
     // Release lock
     xSemaphoreGiveRecursive(mMutex);
     return 0;
@@ -268,8 +283,13 @@ static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
             objEntry->evInfo.ev.instId == ev->instId &&
             objEntry->evInfo.ev.event == ev->event) {
             // Object found, update period
-            objEntry->updatePeriodMs     = periodMs;
-            objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+            if (objEntry->scheduled) {
+                unscheduleUpdate(objEntry);
+            }
+            objEntry->updatePeriodMs = periodMs;
+            if (periodMs > 0) {
+                scheduleUpdate(objEntry, xTaskGetTickCount() * portTICK_RATE_MS + randomizePeriod(periodMs)); // avoid bunching of updates
+            }
             // Release lock
             xSemaphoreGiveRecursive(mMutex);
             return 0;
@@ -303,7 +323,7 @@ static void eventTask()
     }
 
     // Process periodic updates
-    if ((xTaskGetTickCount() * portTICK_RATE_MS) >= timeToNextUpdateMs) {
+    if ((int32_t)(xTaskGetTickCount() * portTICK_RATE_MS - timeToNextUpdateMs) >= 0) {
         timeToNextUpdateMs = processPeriodicUpdates();
     }
 
@@ -311,55 +331,155 @@ static void eventTask()
 }
 
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Handle the periodic updates that are due.
+ * \return The system time of the next update (in ms)
  */
-static int32_t processPeriodicUpdates()
+static uint32_t processPeriodicUpdates()
 {
     PeriodicObjectList *objEntry;
-    int32_t timeNow;
-    int32_t timeToNextUpdate;
-    int32_t offset;
+    uint32_t timeNow;
+    uint32_t lateMs;
 
     // Get lock
     xSemaphoreTakeRecursive(mMutex, portMAX_DELAY);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = xTaskGetTickCount() * portTICK_RATE_MS + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(mObjList, objEntry) {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0) {
-            // Check if time for the next update
-            timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
-            if (objEntry->timeToNextUpdateMs <= timeNow) {
-                // Reset timer
-                offset = (timeNow - objEntry->timeToNextUpdateMs) % objEntry->updatePeriodMs;
-                objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-                // Invoke callback, if one
-                if (objEntry->evInfo.cb != 0) {
-                    objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-                }
-                // Push event to queue, if one
-                if (objEntry->evInfo.queue != 0) {
-                    if (xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE && !objEntry->evInfo.ev.lowPriority) { // do not block if queue is full
-                        if (objEntry->evInfo.ev.obj != NULL) {
-                            mStats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-                        }
-                        ++mStats.eventErrors;
-                    }
+    timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
+    while (mUpdates && (int32_t)(timeNow - mUpdates->nextUpdateMs) >= 0) {
+        objEntry = mUpdates;
+        lateMs   = timeNow - objEntry->nextUpdateMs;
+        if (lateMs > LATE_UPDATE_MS) {
+            ++mStats.lateUpdates;
+        }
+        if (lateMs > mStats.maxLatenessMs) {
+            mStats.maxLatenessMs = lateMs;
+        }
+        // Reschedule before invoking, the callback may update the period itself.
+        // Updates that were missed are skipped, keeping the phase
+        unscheduleUpdate(objEntry);
+        scheduleUpdate(objEntry, timeNow + objEntry->updatePeriodMs - lateMs % objEntry->updatePeriodMs);
+        // Invoke callback, if one
+        if (objEntry->evInfo.cb != 0) {
+            objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+        }
+        // Push event to queue, if one
+        if (objEntry->evInfo.queue != 0) {
+            if (xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE && !objEntry->evInfo.ev.lowPriority) { // do not block if queue is full
+                if (objEntry->evInfo.ev.obj != NULL) {
+                    mStats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
                 }
-            }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate) {
-                timeToNextUpdate = objEntry->timeToNextUpdateMs;
+                PIOS_TRACE(PIOS_TRACE_QUEUE_FULL, objEntry->evInfo.ev.obj != NULL ? mStats.lastErrorID : 0);
+                ++mStats.eventErrors;
             }
         }
     }
 
+    // Time of the next update, wake up every now and then anyway
+    timeNow += MAX_UPDATE_PERIOD_MS;
+    if (mUpdates && (int32_t)(mUpdates->nextUpdateMs - timeNow) < 0) {
+        timeNow = mUpdates->nextUpdateMs;
+    }
+
     // Done
     xSemaphoreGiveRecursive(mMutex);
-    return timeToNextUpdate;
+    return timeNow;
+}
+
+/**
+ * Pairing heap of the periodic updates, all functions must be called with the mutex held
+ */
+static PeriodicObjectList *heapMeld(PeriodicObjectList *a, PeriodicObjectList *b)
+{
+    if (!a) {
+        return b;
+    }
+    if (!b) {
+        return a;
+    }
+    if ((int32_t)(b->nextUpdateMs - a->nextUpdateMs) < 0) { // wraparound safe
+        PeriodicObjectList *t = a;
+        a = b;
+        b = t;
+    }
+    // b becomes the first child of a
+    b->heapPrev = a;
+    b->heapNext = a->heapChild;
+    if (a->heapChild) {
+        a->heapChild->heapPrev = b;
+    }
+    a->heapChild = b;
+    return a;
+}
+
+static PeriodicObjectList *heapMergePairs(PeriodicObjectList *first)
+{
+    PeriodicObjectList *pairs = NULL;
+
+    // meld the siblings by pairs from left to right, collecting the results in reverse order
+    while (first) {
+        PeriodicObjectList *a = first;
+        PeriodicObjectList *b = a->heapNext;
+        first = b ? b->heapNext : NULL;
+        a->heapNext = NULL;
+        a->heapPrev = NULL;
+        if (b) {
+            b->heapNext = NULL;
+            b->heapPrev = NULL;
+        }
+        a = heapMeld(a, b);
+        a->heapNext = pairs;
+        pairs = a;
+    }
+
+    // then meld the pairs from right to left
+    PeriodicObjectList *root = NULL;
+    while (pairs) {
+        PeriodicObjectList *next = pairs->heapNext;
+        pairs->heapNext = NULL;
+        root  = heapMeld(root, pairs);
+        pairs = next;
+    }
+    return root;
+}
+
+/**
+ * Add an entry to the heap
+ * \param[in] objEntry The entry, not in the heap
+ * \param[in] timeMs The system time of its next update
+ */
+static void scheduleUpdate(PeriodicObjectList *objEntry, uint32_t timeMs)
+{
+    objEntry->nextUpdateMs = timeMs;
+    objEntry->heapChild    = NULL;
+    objEntry->heapNext     = NULL;
+    objEntry->heapPrev     = NULL;
+    objEntry->scheduled    = true;
+    mUpdates = heapMeld(mUpdates, objEntry);
+}
+
+/**
+ * Remove an entry from the heap
+ * \param[in] objEntry The entry, in the heap
+ */
+static void unscheduleUpdate(PeriodicObjectList *objEntry)
+{
+    if (objEntry == mUpdates) {
+        mUpdates = heapMergePairs(objEntry->heapChild);
+    } else {
+        // detach the subtree from its parent or left sibling
+        if (objEntry->heapPrev->heapChild == objEntry) {
+            objEntry->heapPrev->heapChild = objEntry->heapNext;
+        } else {
+            objEntry->heapPrev->heapNext = objEntry->heapNext;
+        }
+        if (objEntry->heapNext) {
+            objEntry->heapNext->heapPrev = objEntry->heapPrev;
+        }
+        mUpdates = heapMeld(mUpdates, heapMergePairs(objEntry->heapChild));
+    }
+    objEntry->heapChild = NULL;
+    objEntry->heapNext  = NULL;
+    objEntry->heapPrev  = NULL;
+    objEntry->scheduled = false;
 }
 
 /**
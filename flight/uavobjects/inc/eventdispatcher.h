@@ -33,6 +33,8 @@
 typedef struct {
     uint32_t lastErrorID;
     uint32_t eventErrors;
+    uint32_t lateUpdates; /** Periodic updates fired late */
+    uint32_t maxLatenessMs; /** Largest delay of a periodic update */
 } EventStats;
 
 // Public functions
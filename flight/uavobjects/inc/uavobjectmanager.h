@@ -141,6 +141,7 @@ typedef enum {
  */
 #define EV_MASK_ALL         0
 #define EV_MASK_ALL_UPDATES (EV_UNPACKED | EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATED_PERIODIC | EV_LOGGING_MANUAL | EV_LOGGING_PERIODIC)
+#define EV_MASK_COALESCE    0x80 /** Queue flag, at most one pending event per instance and event type, @see UAVObjConnectQueue */
 
 /**
  * Access types
@@ -180,6 +181,8 @@ typedef struct {
     uint32_t eventCallbackErrors;
     uint32_t lastCallbackErrorID;
     uint32_t lastQueueErrorID;
+    uint32_t lockFreeRetries; /** Lock-free reads that raced with a writer and had to retry */
+    uint32_t lockFreeFallbacks; /** Lock-free reads that gave up and waited for the mutex */
 } UAVObjStats;
 
 int32_t UAVObjInitialize();
@@ -199,9 +202,12 @@ bool UAVObjIsPriority(UAVObjHandle obj);
 int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t *dataIn);
 int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t *dataOut);
 uint8_t UAVObjUpdateCRC(UAVObjHandle obj_handle, uint16_t instId, uint8_t crc);
+uint32_t UAVObjUpdateCRC32(UAVObjHandle obj_handle, uint32_t crc);
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjDelete(UAVObjHandle obj_handle, uint16_t instId);
+int32_t UAVObjPersBegin(void);
+int32_t UAVObjPersCommit(void);
 #if defined(PIOS_INCLUDE_SDCARD)
 int32_t UAVObjSaveToFile(UAVObjHandle obj_handle, uint16_t instId, FILEINFO *file);
 int32_t UAVObjLoadFromFile(UAVObjHandle obj_handle, FILEINFO *file);
@@ -216,6 +222,7 @@ int32_t UAVObjSetData(UAVObjHandle obj_handle, const void *dataIn);
 int32_t UAVObjSetDataField(UAVObjHandle obj_handle, const void *dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjGetData(UAVObjHandle obj_handle, void *dataOut);
 int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void *dataOut, uint32_t offset, uint32_t size);
+const void *UAVObjGetDataPtr(UAVObjHandle obj_handle);
 int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const void *dataIn);
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void *dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId, void *dataOut);
@@ -239,8 +246,11 @@ UAVObjUpdateMode UAVObjGetLoggingUpdateMode(const UAVObjMetadata *dataOut);
 void UAVObjSetLoggingUpdateMode(UAVObjMetadata *dataOut, UAVObjUpdateMode val);
 int8_t UAVObjReadOnly(UAVObjHandle obj);
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue, uint8_t eventMask);
+int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle, xQueueHandle queue, uint8_t eventMask, uint16_t interval);
 int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, xQueueHandle queue);
+void UAVObjQueueEventReceived(xQueueHandle queue, const UAVObjEvent *ev);
 int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask);
+int32_t UAVObjConnectFastCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask);
 int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb);
 void UAVObjRequestUpdate(UAVObjHandle obj);
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId);
@@ -73,18 +73,30 @@ struct ObjectEventEntry {
     xQueueHandle queue;
     UAVObjEventCallback     cb;
     uint8_t eventMask;
+    bool    fast;
+    bool    coalesce; // queue holds at most one pending event per instance and event type
+    volatile uint32_t pending; // EVENT_PENDING_KEY of the event waiting in a coalescing queue, 0 if none
+    uint16_t throttle; // minimum interval between two EV_UPDATED events queued, in ms, 0 if not throttled
+    uint32_t lastUpdated; // time the last EV_UPDATED event was queued, in ms
 };
 
+#define EVENT_PENDING_KEY(instId, event) (((uint32_t)(instId) << 8) | (event))
+
 /*
    MetaInstance   == [UAVOBase [UAVObjMetadata]]
    SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-   MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-   \-->[InstanceData1 [next]]
-                                                  _________...________/
-   \-->[InstanceDataN [next]]
+   MultiInstance  == [UAVOBase [UAVOData [NumInstances [MaxInstances [InstanceTable [InstanceData0]]]]]]
+                                                                      |
+                                    [&InstanceData0, &InstanceData1, ... &InstanceDataN]
+                                                     \___ chunk of UAVOBJ_INSTANCE_CHUNK instances ___/
  */
 
+/* Number of lock-free read attempts before a reader falls back to the mutex */
+#define UAVOBJ_SEQLOCK_RETRIES 3
+
+/* Number of instances allocated at once when a multi instance object grows */
+#define UAVOBJ_INSTANCE_CHUNK 4
+
 /*
  * UAVO Base Type
  *   - All Types of UAVObjects are of this base type
@@ -125,17 +137,13 @@ struct UAVOData {
 struct UAVOSingle {
     struct UAVOData uavo;
 
-    uint8_t instance0[];
     /*
-     * Additional space will be malloc'd here to hold the
-     * the data for this instance.
+     * Sequence counter guarding instance0 for lock-free readers.
+     * Odd while a write is in progress, writers hold the mutex.
      */
-} __attribute__((packed));
+    volatile uint32_t seq;
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-    struct UAVOMultiInst *next;
-    uint8_t instance[];
+    uint8_t instance0[];
     /*
      * Additional space will be malloc'd here to hold the
      * the data for this instance.
@@ -146,10 +154,17 @@ struct UAVOMultiInst {
 struct UAVOMulti {
     struct UAVOData uavo;
     uint16_t num_instances;
-    struct UAVOMultiInst instance0 __attribute__((aligned(4)));
+    uint16_t max_instances;
+    /*
+     * Table of pointers to the data of each allocated instance,
+     * NULL as long as only instance 0 exists.
+     */
+    uint8_t  **instance;
+    uint8_t  instance0[] __attribute__((aligned(4)));
     /*
      * Additional space will be malloc'd here to hold the
-     * the data for instance 0.
+     * the data for instance 0. Further instances are allocated
+     * contiguously in chunks of UAVOBJ_INSTANCE_CHUNK.
      */
 } __attribute__((packed));
 
@@ -162,9 +177,28 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void *)(&(((struct UAVOSingle *)obj)->instance0)))
-#define InstanceDataOffset(inst)         ((void *)&(((struct UAVOMultiInst *)inst)->instance))
 #define InstanceData(instance)           ((void *)instance)
 
+/**
+ * Mark the start/end of a write to the data of a single instance object.
+ * Must be called with the object manager mutex held.
+ */
+static inline void seqWriteBegin(struct UAVOData *obj)
+{
+    if (obj->base.flags.isSingle && !obj->base.flags.isMeta) {
+        ((struct UAVOSingle *)obj)->seq++;
+        __sync_synchronize();
+    }
+}
+
+static inline void seqWriteEnd(struct UAVOData *obj)
+{
+    if (obj->base.flags.isSingle && !obj->base.flags.isMeta) {
+        __sync_synchronize();
+        ((struct UAVOSingle *)obj)->seq++;
+    }
+}
+
 // Private functions
 int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType event);
 InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId);
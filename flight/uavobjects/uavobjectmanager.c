@@ -35,11 +35,24 @@
 #include "pios_struct_helper.h"
 #include "inc/uavobjectprivate.h"
 
+// Instances created at runtime can be taken from the block pools, see pios_mem.h
+#if defined(PIOS_INCLUDE_MEM_POOL) && defined(PIOS_MEM_POOL_UAVOBJECTS)
+#define instanceMalloc(size) pios_pool_malloc(size)
+#define instanceFree(p)      pios_pool_free(p)
+#else
+#define instanceMalloc(size) pios_malloc(size)
+#define instanceFree(p)      pios_free(p)
+#endif
+
 // Private functions
 static InstanceHandle createInstance(struct UAVOData *obj, uint16_t instId);
-static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue, UAVObjEventCallback cb, uint8_t eventMask);
+static int32_t growInstances(struct UAVOMulti *obj);
+static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue, UAVObjEventCallback cb, uint8_t eventMask, bool fast, uint16_t throttle);
 static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue, UAVObjEventCallback cb);
 static void instanceAutoUpdated(UAVObjHandle obj_handle, uint16_t instId);
+static struct UAVOData *indexLookup(uint32_t id);
+static void indexInsert(struct UAVOData *obj);
+static bool readSingleLockFree(struct UAVOData *obj, void *dataOut, uint32_t offset, uint32_t size);
 
 
 int32_t UAVObjPers_stub(__attribute__((unused)) UAVObjHandle obj_handle, __attribute__((unused))  uint16_t instId)
@@ -49,6 +62,12 @@ int32_t UAVObjPers_stub(__attribute__((unused)) UAVObjHandle obj_handle, __attri
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)  __attribute__((weak, alias("UAVObjPers_stub")));;
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId) __attribute__((weak, alias("UAVObjPers_stub")));
 int32_t UAVObjDelete(UAVObjHandle obj_handle, uint16_t instId) __attribute__((weak, alias("UAVObjPers_stub")));
+int32_t UAVObjPersTransaction_stub(void)
+{
+    return 0;
+}
+int32_t UAVObjPersBegin(void) __attribute__((weak, alias("UAVObjPersTransaction_stub")));
+int32_t UAVObjPersCommit(void) __attribute__((weak, alias("UAVObjPersTransaction_stub")));
 
 
 // Private variables
@@ -67,6 +86,16 @@ static const UAVObjMetadata defMetadata = {
 
 static UAVObjStats stats;
 
+/*
+ * Open addressed hash index of all registered objects, keyed by the data object ID.
+ * Object IDs always have their lowest bit cleared (the metaobject uses ID + 1), so
+ * both the data and the metaobject map to the same slot.
+ * Entries are only ever added and each one is a single pointer store done after the
+ * object is completely set up, so lookups can run without taking the mutex.
+ */
+static struct UAVOData **uavo_index;
+static uint16_t uavo_index_mask;
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -94,6 +123,19 @@ int32_t UAVObjInitialize()
         return -1;
     }
 
+    // Size the lookup index to keep the load factor at or below 3/4
+    uint32_t num_slots  = ((uintptr_t)__stop__uavo_handles - (uintptr_t)__start__uavo_handles) / sizeof(struct UAVOData *);
+    uint32_t index_size = 4;
+    while (index_size * 3 < num_slots * 4) {
+        index_size <<= 1;
+    }
+    uavo_index = (struct UAVOData **)pios_malloc(index_size * sizeof(struct UAVOData *));
+    if (uavo_index == NULL) {
+        return -1;
+    }
+    memset(uavo_index, 0, index_size * sizeof(struct UAVOData *));
+    uavo_index_mask = index_size - 1;
+
     // Done
     return 0;
 }
@@ -186,9 +228,11 @@ static struct UAVOData *UAVObjAllocMulti(uint32_t num_bytes)
 
     /* Set up the type-specific part of the UAVO */
     uavo_multi->num_instances = 1;
+    uavo_multi->max_instances = 1;
+    uavo_multi->instance = NULL;
 
     /* Clear the multi instance data carried in the UAVO */
-    memset(&(uavo_multi->instance0), 0, sizeof(struct UAVOMultiInst) + num_bytes);
+    memset(&(uavo_multi->instance0), 0, num_bytes);
 
     /* Give back the generic UAVO part */
     return &(uavo_multi->uavo);
@@ -246,6 +290,9 @@ UAVObjHandle UAVObjRegister(uint32_t id,
     /* Initialize the embedded meta UAVO */
     UAVObjInitMetaData(&uavo_data->metaObj);
 
+    /* Make the object visible to UAVObjGetByID() */
+    indexInsert(uavo_data);
+
     /* Initialize object fields and metadata to default values */
     if (initCb) {
         initCb((UAVObjHandle)uavo_data, 0);
@@ -275,26 +322,16 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-    UAVObjHandle *found_obj = (UAVObjHandle *)NULL;
-
-    // Get lock
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    // No locking needed, the index is only appended to
+    struct UAVOData *obj = indexLookup(id & ~1u);
 
-    // Look for object
-    UAVO_LIST_ITERATE(tmp_obj)
-    if (tmp_obj->id == id) {
-        found_obj = (UAVObjHandle *)tmp_obj;
-        goto unlock_exit;
+    if (obj == NULL) {
+        return (UAVObjHandle)NULL;
     }
-    if (MetaObjectId(tmp_obj->id) == id) {
-        found_obj = (UAVObjHandle *)&(tmp_obj->metaObj);
-        goto unlock_exit;
+    if (obj->id == id) {
+        return (UAVObjHandle)obj;
     }
-}
-
-unlock_exit:
-xSemaphoreGiveRecursive(mutex);
-return found_obj;
+    return (UAVObjHandle) & (obj->metaObj);
 }
 
 /**
@@ -508,8 +545,6 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t *da
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
-    int32_t rc = -1;
-
     if (UAVObjIsMetaobject(obj_handle)) {
         if (instId != 0) {
             goto unlock_exit;
@@ -533,16 +568,20 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t *da
             }
         }
         // Set the data
+        seqWriteBegin(obj);
         memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+        seqWriteEnd(obj);
     }
 
-    // Fire event
+    xSemaphoreGiveRecursive(mutex);
+
+    // Fire event, the listeners are notified once the lock is released
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UNPACKED);
-    rc = 0;
+    return 0;
 
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
-    return rc;
+    return -1;
 }
 
 /**
@@ -556,6 +595,10 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t *dataOut)
 {
     PIOS_Assert(obj_handle);
 
+    if (instId == 0 && readSingleLockFree((struct UAVOData *)obj_handle, dataOut, 0, UAVObjGetNumBytes(obj_handle))) {
+        return 0;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -629,6 +672,38 @@ unlock_exit:
     return crc;
 }
 
+/**
+ * Update a 32 bit CRC with the data of all the instances of an object,
+ * or with the metadata of a metaobject
+ * \param[in] obj The object handle
+ * \param[in] crc The crc to update
+ * \return the updated crc
+ */
+uint32_t UAVObjUpdateCRC32(UAVObjHandle obj_handle, uint32_t crc)
+{
+    PIOS_Assert(obj_handle);
+
+    // Lock
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    if (UAVObjIsMetaobject(obj_handle)) {
+        crc = PIOS_CRC32_updateCRC(crc, (uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
+    } else {
+        struct UAVOData *obj = (struct UAVOData *)obj_handle;
+        uint16_t numInstances = UAVObjGetNumInstances(obj_handle);
+
+        for (uint16_t instId = 0; instId < numInstances; instId++) {
+            InstanceHandle instEntry = getInstance(obj, instId);
+            if (instEntry != NULL) {
+                crc = PIOS_CRC32_updateCRC(crc, (uint8_t *)InstanceData(instEntry), (int32_t)obj->instance_size);
+            }
+        }
+    }
+
+    xSemaphoreGiveRecursive(mutex);
+    return crc;
+}
+
 /**
  * Actually write the object's data to the logfile
  * \param[in] obj The object handle
@@ -677,6 +752,11 @@ int32_t UAVObjSaveSettings()
 
     int32_t rc = -1;
 
+    // Batch the flash writes, stored objects are only replaced on commit
+    if (UAVObjPersBegin() != 0) {
+        goto unlock_exit;
+    }
+
     // Save all settings objects
     UAVO_LIST_ITERATE(obj)
     // Check if this is a settings object
@@ -684,13 +764,19 @@ int32_t UAVObjSaveSettings()
         // Save object
         if (UAVObjSave((UAVObjHandle)obj, 0) ==
             -1) {
-            goto unlock_exit;
+            goto commit_exit;
         }
     }
 }
 
 rc = 0;
 
+commit_exit:
+// Objects saved before a failure are still valid
+if (UAVObjPersCommit() != 0) {
+    rc = -1;
+}
+
 unlock_exit:
 xSemaphoreGiveRecursive(mutex);
 return rc;
@@ -767,17 +853,28 @@ int32_t UAVObjSaveMetaobjects()
 
     int32_t rc = -1;
 
+    // Batch the flash writes, stored objects are only replaced on commit
+    if (UAVObjPersBegin() != 0) {
+        goto unlock_exit;
+    }
+
     // Save all settings objects
     UAVO_LIST_ITERATE(obj)
     // Save object
     if (UAVObjSave((UAVObjHandle)MetaObjectPtr(obj), 0) ==
         -1) {
-        goto unlock_exit;
+        goto commit_exit;
     }
 }
 
 rc = 0;
 
+commit_exit:
+// Objects saved before a failure are still valid
+if (UAVObjPersCommit() != 0) {
+    rc = -1;
+}
+
 unlock_exit:
 xSemaphoreGiveRecursive(mutex);
 return rc;
@@ -896,8 +993,6 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
-    int32_t rc = -1;
-
     if (UAVObjIsMetaobject(obj_handle)) {
         if (instId != 0) {
             goto unlock_exit;
@@ -920,16 +1015,20 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
             goto unlock_exit;
         }
         // Set data
+        seqWriteBegin(obj);
         memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+        seqWriteEnd(obj);
     }
 
-    // Fire event
+    xSemaphoreGiveRecursive(mutex);
+
+    // Fire event, the listeners are notified once the lock is released
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
-    rc = 0;
+    return 0;
 
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
-    return rc;
+    return -1;
 }
 
 /**
@@ -946,8 +1045,6 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
-    int32_t rc = -1;
-
     if (UAVObjIsMetaobject(obj_handle)) {
         // Get instance information
         if (instId != 0) {
@@ -985,17 +1082,20 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
         }
 
         // Set data
+        seqWriteBegin(obj);
         memcpy(InstanceData(instEntry) + offset, dataIn, size);
+        seqWriteEnd(obj);
     }
 
+    xSemaphoreGiveRecursive(mutex);
 
-    // Fire event
+    // Fire event, the listeners are notified once the lock is released
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
-    rc = 0;
+    return 0;
 
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
-    return rc;
+    return -1;
 }
 
 /**
@@ -1010,6 +1110,10 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
     PIOS_Assert(obj_handle);
 
+    if (instId == 0 && readSingleLockFree((struct UAVOData *)obj_handle, dataOut, 0, UAVObjGetNumBytes(obj_handle))) {
+        return 0;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1056,6 +1160,11 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
     PIOS_Assert(obj_handle);
 
+    if (instId == 0 && (size + offset) <= UAVObjGetNumBytes(obj_handle)
+        && readSingleLockFree((struct UAVOData *)obj_handle, dataOut, offset, size)) {
+        return 0;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1103,6 +1212,27 @@ unlock_exit:
     return rc;
 }
 
+/**
+ * Get a pointer to the data of instance 0 of an object.
+ * The data of instance 0 is allocated with the object and never moves. It is
+ * meant for the generated field getters, which only read scalars from it:
+ * anything larger has to go through UAVObjGetData() to be consistent.
+ * \param[in] obj The object handle
+ * \return the instance data or NULL for a metaobject
+ */
+const void *UAVObjGetDataPtr(UAVObjHandle obj_handle)
+{
+    PIOS_Assert(obj_handle);
+
+    if (UAVObjIsMetaobject(obj_handle)) {
+        return NULL;
+    }
+    if (UAVObjIsSingleInstance(obj_handle)) {
+        return ((struct UAVOSingle *)obj_handle)->instance0;
+    }
+    return ((struct UAVOMulti *)obj_handle)->instance0;
+}
+
 /**
  * Set the object metadata
  * \param[in] obj The object handle
@@ -1333,7 +1463,9 @@ int8_t UAVObjReadOnly(UAVObjHandle obj_handle)
  * All events matching the event mask will be pushed to the event queue.
  * \param[in] obj The object handle
  * \param[in] queue The event queue
- * \param[in] eventMask The event mask, if EV_MASK_ALL then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \param[in] eventMask The event mask, if EV_MASK_ALL then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL).
+ * Adding EV_MASK_COALESCE keeps at most one pending event per instance and event type in the queue,
+ * the listener then has to call UAVObjQueueEventReceived() for each event it takes from the queue.
  * \return 0 if success or -1 if failure
  */
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue,
@@ -1343,11 +1475,55 @@ int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue,
     PIOS_Assert(queue);
     int32_t res;
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    res = connectObj(obj_handle, queue, 0, eventMask);
+    res = connectObj(obj_handle, queue, 0, eventMask, false, 0);
+    xSemaphoreGiveRecursive(mutex);
+    return res;
+}
+
+/**
+ * Connect an event queue to the object like UAVObjConnectQueue(), but only let through an
+ * EV_UPDATED event if the previous one queued is at least the given interval old. The
+ * updates in between are dropped by the sender, so they never take room in the queue.
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue
+ * \param[in] eventMask The event mask, see UAVObjConnectQueue()
+ * \param[in] interval The minimum interval between two EV_UPDATED events in ms, 0 to pass them all
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle, xQueueHandle queue,
+                                    uint8_t eventMask, uint16_t interval)
+{
+    PIOS_Assert(obj_handle);
+    PIOS_Assert(queue);
+    int32_t res;
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    res = connectObj(obj_handle, queue, 0, eventMask, false, interval);
     xSemaphoreGiveRecursive(mutex);
     return res;
 }
 
+/**
+ * Tell that an event was taken from a queue connected with EV_MASK_COALESCE,
+ * following updates of the same instance queue an event again.
+ * To be called before the object data is read.
+ * \param[in] queue The event queue
+ * \param[in] ev The event received
+ */
+void UAVObjQueueEventReceived(xQueueHandle queue, const UAVObjEvent *ev)
+{
+    struct ObjectEventEntry *event;
+
+    if (!ev->obj) {
+        return;
+    }
+    LL_FOREACH(((struct UAVOBase *)ev->obj)->next_event, event) {
+        if (event->queue == queue && event->coalesce) {
+            __sync_bool_compare_and_swap(&event->pending, EVENT_PENDING_KEY(ev->instId, ev->event), 0);
+            return;
+        }
+    }
+}
+
 /**
  * Disconnect an event queue from the object.
  * \param[in] obj The object handle
@@ -1379,7 +1555,28 @@ int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb,
     PIOS_Assert(obj_handle);
     int32_t res;
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    res = connectObj(obj_handle, 0, cb, eventMask);
+    res = connectObj(obj_handle, 0, cb, eventMask, false, 0);
+    xSemaphoreGiveRecursive(mutex);
+    return res;
+}
+
+/**
+ * Connect an event callback to the object that is invoked directly by whoever triggers the event,
+ * instead of from the event task. This removes the event task hop from latency critical chains.
+ * The callback runs in the context of the updating task, so it must be short and must never block,
+ * typically it only dispatches a callback.
+ * \param[in] obj The object handle
+ * \param[in] cb The event callback
+ * \param[in] eventMask The event mask, if EV_MASK_ALL then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectFastCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb,
+                                  uint8_t eventMask)
+{
+    PIOS_Assert(obj_handle);
+    int32_t res;
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    res = connectObj(obj_handle, 0, cb, eventMask, true, 0);
     xSemaphoreGiveRecursive(mutex);
     return res;
 }
@@ -1419,9 +1616,7 @@ void UAVObjRequestUpdate(UAVObjHandle obj_handle)
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATE_REQ);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /**
@@ -1441,9 +1636,7 @@ void UAVObjUpdated(UAVObjHandle obj_handle)
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED_MANUAL);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /**
@@ -1454,9 +1647,7 @@ void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 static void instanceAutoUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /*
@@ -1476,9 +1667,7 @@ void UAVObjLogging(UAVObjHandle obj_handle)
 void UAVObjInstanceLogging(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_LOGGING_MANUAL);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /**
@@ -1503,8 +1692,36 @@ void UAVObjIterate(void (*iterator)(UAVObjHandle obj))
 xSemaphoreGiveRecursive(mutex);
 }
 
+/**
+ * Push an event to a listener queue. Coalescing queues keep at most one pending
+ * event per instance and event type: the listener reads the latest data when it
+ * handles the event, so an equal event still waiting in the queue stands for
+ * later updates as well. The pending key is set before the event is queued and
+ * cleared by UAVObjQueueEventReceived(), races between senders only cost an
+ * extra event.
+ */
+static portBASE_TYPE queueEvent(struct ObjectEventEntry *event, UAVObjEvent *msg)
+{
+    if (!event->coalesce) {
+        return xQueueSend(event->queue, msg, 0);
+    }
+
+    uint32_t key = EVENT_PENDING_KEY(msg->instId, msg->event);
+    if (event->pending == key) {
+        return pdTRUE;
+    }
+    __sync_bool_compare_and_swap(&event->pending, 0, key);
+    if (xQueueSend(event->queue, msg, 0) != pdTRUE) {
+        __sync_bool_compare_and_swap(&event->pending, key, 0);
+        return pdFALSE;
+    }
+    return pdTRUE;
+}
+
 /**
  * Send a triggered event to all event queues registered on the object.
+ * Called without the mutex: entries are only appended once fully set up and
+ * never freed, so the list can be walked while it is being modified.
  */
 int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType triggered_event)
 {
@@ -1522,16 +1739,27 @@ int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType trigger
     LL_FOREACH(obj->next_event, event) {
         if (event->eventMask == 0 || (event->eventMask & triggered_event) != 0) {
             // Send to queue if a valid queue is registered
+            if (event->queue && triggered_event == EV_UPDATED && event->throttle) {
+                // Racing senders may both get through, which only costs an extra event
+                uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
+                if (now - event->lastUpdated < event->throttle) {
+                    continue;
+                }
+                event->lastUpdated = now;
+            }
             if (event->queue) {
                 // will not block
-                if (xQueueSend(event->queue, &msg, 0) != pdTRUE) {
+                if (queueEvent(event, &msg) != pdTRUE) {
                     ++stats.eventQueueErrors;
                     stats.lastQueueErrorID = UAVObjGetID(obj);
                 }
             }
 
             // Invoke callback (from event task) if a valid one is registered
-            if (event->cb) {
+            if (event->cb && event->fast) {
+                // fast callbacks are invoked right away
+                event->cb(&msg);
+            } else if (event->cb) {
                 // invoke callback from the event task, will not block
                 if (EventCallbackDispatch(&msg, event->cb) != pdTRUE) {
                     ++stats.eventCallbackErrors;
@@ -1544,12 +1772,92 @@ int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType trigger
     return 0;
 }
 
+/**
+ * Copy data out of a single instance data object without taking the mutex.
+ * Writers always hold the mutex and bump the sequence counter around the copy,
+ * so a reader only has to retry when it raced with one. Since a reader could
+ * have preempted the writer it gives up after a few attempts, the caller then
+ * takes the mutex which lets the writer finish through priority inheritance.
+ * \return true if the data was copied, false if the caller has to use the mutex
+ */
+static bool readSingleLockFree(struct UAVOData *obj, void *dataOut, uint32_t offset, uint32_t size)
+{
+    if (!obj->base.flags.isSingle || obj->base.flags.isMeta) {
+        return false;
+    }
+
+    struct UAVOSingle *uavo_single = (struct UAVOSingle *)obj;
+
+    for (uint8_t retry = 0; retry < UAVOBJ_SEQLOCK_RETRIES; ++retry) {
+        uint32_t seq = uavo_single->seq;
+        if ((seq & 1) == 0) {
+            __sync_synchronize();
+            memcpy(dataOut, uavo_single->instance0 + offset, size);
+            __sync_synchronize();
+            if (uavo_single->seq == seq) {
+                return true;
+            }
+        }
+        // Counters are only informational, a lost increment is harmless
+        ++stats.lockFreeRetries;
+    }
+    ++stats.lockFreeFallbacks;
+
+    return false;
+}
+
+/**
+ * Hash an object ID to its home slot in the lookup index.
+ * Object IDs are already well distributed hashes of the object definition,
+ * just fold the upper bits in.
+ */
+static inline uint16_t indexHash(uint32_t id)
+{
+    return (uint16_t)((id ^ (id >> 16)) >> 1) & uavo_index_mask;
+}
+
+/**
+ * Find a registered data object by its (data) ID, or NULL if not registered.
+ */
+static struct UAVOData *indexLookup(uint32_t id)
+{
+    if (uavo_index == NULL) {
+        return NULL;
+    }
+
+    for (uint16_t slot = indexHash(id);; slot = (slot + 1) & uavo_index_mask) {
+        struct UAVOData *obj = uavo_index[slot];
+        if (obj == NULL) {
+            return NULL;
+        }
+        if (obj->id == id) {
+            return obj;
+        }
+    }
+}
+
+/**
+ * Add an object to the lookup index, called with the mutex held.
+ */
+static void indexInsert(struct UAVOData *obj)
+{
+    PIOS_Assert(uavo_index);
+
+    uint16_t slot = indexHash(obj->id);
+
+    while (uavo_index[slot] != NULL) {
+        slot = (slot + 1) & uavo_index_mask;
+    }
+    // The index is sized for every handle slot, it can never run full
+    uavo_index[slot] = obj;
+}
+
 /**
  * Create a new object instance, return the instance info or NULL if failure.
  */
 static InstanceHandle createInstance(struct UAVOData *obj, uint16_t instId)
 {
-    struct UAVOMultiInst *instEntry;
+    uint8_t *instEntry;
 
     /* Don't allow more than one instance for single instance objects */
     if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1575,21 +1883,71 @@ static InstanceHandle createInstance(struct UAVOData *obj, uint16_t instId)
     }
 
     /* Create the actual instance */
-    uint32_t size = sizeof(struct UAVOMultiInst) + obj->instance_size;
-    instEntry = (struct UAVOMultiInst *)pios_malloc(size);
-    if (!instEntry) {
-        return NULL;
+    struct UAVOMulti *uavo_multi = (struct UAVOMulti *)obj;
+    if (instId >= uavo_multi->max_instances) {
+        if (growInstances(uavo_multi) < 0) {
+            return NULL;
+        }
     }
-    memset(instEntry, 0, size);
-    LL_APPEND(((struct UAVOMulti *)obj)->instance0.next, instEntry);
+    instEntry = uavo_multi->instance[instId];
+    memset(instEntry, 0, obj->instance_size);
 
-    ((struct UAVOMulti *)obj)->num_instances++;
+    uavo_multi->num_instances++;
 
     // Fire event
     instanceAutoUpdated((UAVObjHandle)obj, instId);
 
     // Done
-    return InstanceDataOffset(instEntry);
+    return instEntry;
+}
+
+/**
+ * Allocate storage for the next chunk of instances of a multi instance object
+ * and extend the instance table to cover them.
+ * \return 0 if success or -1 if failure
+ */
+static int32_t growInstances(struct UAVOMulti *obj)
+{
+    uint16_t old_max = obj->max_instances;
+    uint16_t new_max = old_max + UAVOBJ_INSTANCE_CHUNK;
+
+    if (new_max > UAVOBJ_MAX_INSTANCES) {
+        new_max = UAVOBJ_MAX_INSTANCES;
+    }
+
+    /* Keep every instance 4 byte aligned within the chunk */
+    uint32_t stride = (obj->uavo.instance_size + 3) & ~3;
+    uint8_t **table = (uint8_t **)instanceMalloc(new_max * sizeof(uint8_t *));
+    uint8_t *chunk  = (uint8_t *)instanceMalloc((new_max - old_max) * stride);
+
+    if (!table || !chunk) {
+        if (table) {
+            instanceFree(table);
+        }
+        if (chunk) {
+            instanceFree(chunk);
+        }
+        return -1;
+    }
+
+    if (obj->instance) {
+        memcpy(table, obj->instance, old_max * sizeof(uint8_t *));
+    } else {
+        table[0] = obj->instance0;
+    }
+    for (uint16_t n = old_max; n < new_max; ++n) {
+        table[n] = chunk + (n - old_max) * stride;
+    }
+
+    /* All accesses to the table are done with the mutex held */
+    uint8_t **old_table = obj->instance;
+    obj->instance      = table;
+    obj->max_instances = new_max;
+    if (old_table) {
+        instanceFree(old_table);
+    }
+
+    return 0;
 }
 
 /**
@@ -1625,17 +1983,10 @@ InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId)
             return NULL;
         }
 
-        // Look for specified instance ID
-        uint16_t instance = 0;
-        struct UAVOMultiInst *instEntry;
-        LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-            if (instance++ == instId) {
-                /* Found it */
-                return &(instEntry->instance);
-            }
+        if (instId == 0) {
+            return uavo_multi->instance0;
         }
-        /* Instance was not found */
-        return NULL;
+        return uavo_multi->instance[instId];
     }
 }
 
@@ -1645,10 +1996,12 @@ InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId)
  * \param[in] queue The event queue
  * \param[in] cb The event callback
  * \param[in] eventMask The event mask, if EV_MASK_ALL then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \param[in] fast Invoke the callback directly instead of from the event task
+ * \param[in] throttle Minimum interval between two EV_UPDATED events queued in ms, 0 to pass them all
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
-                          UAVObjEventCallback cb, uint8_t eventMask)
+                          UAVObjEventCallback cb, uint8_t eventMask, bool fast, uint16_t throttle)
 {
     struct ObjectEventEntry *event;
     struct UAVOBase *obj;
@@ -1658,7 +2011,11 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
     LL_FOREACH(obj->next_event, event) {
         if (event->queue == queue && event->cb == cb) {
             // Already connected, update event mask and return
-            event->eventMask = eventMask;
+            event->eventMask = eventMask & ~EV_MASK_COALESCE;
+            event->coalesce  = queue && (eventMask & EV_MASK_COALESCE);
+            event->pending   = 0;
+            event->fast = fast;
+            event->throttle  = throttle;
             return 0;
         }
     }
@@ -1670,7 +2027,14 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
     }
     event->queue     = queue;
     event->cb        = cb;
-    event->eventMask = eventMask;
+    event->eventMask = eventMask & ~EV_MASK_COALESCE;
+    event->coalesce  = queue && (eventMask & EV_MASK_COALESCE);
+    event->pending   = 0;
+    event->fast      = fast;
+    event->throttle  = throttle;
+    event->lastUpdated = 0;
+    // sendEvent() walks the list without the mutex, the entry has to be complete once linked
+    __sync_synchronize();
     LL_APPEND(obj->next_event, event);
 
     // Done
@@ -1695,8 +2059,9 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue,
     LL_FOREACH(obj->next_event, event) {
         if ((event->queue == queue
              && event->cb == cb)) {
+            // The entry is not freed, sendEvent() may still be walking it without the mutex.
+            // Next pointers are left untouched so such a walk continues along the list.
             LL_DELETE(obj->next_event, event);
-            vPortFree(event);
             return 0;
         }
     }
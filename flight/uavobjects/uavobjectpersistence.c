@@ -124,3 +124,21 @@ int32_t UAVObjDelete(UAVObjHandle obj_handle, uint16_t instId)
     PIOS_FLASHFS_ObjDelete(pios_uavo_settings_fs_id, UAVObjGetID(obj_handle), instId);
     return 0;
 }
+
+/**
+ * Start saving a set of objects, they replace the stored versions all at once on UAVObjPersCommit.
+ * @return 0 if success or -1 if failure
+ */
+int32_t UAVObjPersBegin(void)
+{
+    return PIOS_FLASHFS_BeginTransaction(pios_uavo_settings_fs_id) == 0 ? 0 : -1;
+}
+
+/**
+ * Make the objects saved since UAVObjPersBegin visible.
+ * @return 0 if success or -1 if failure
+ */
+int32_t UAVObjPersCommit(void)
+{
+    return PIOS_FLASHFS_CommitTransaction(pios_uavo_settings_fs_id) == 0 ? 0 : -1;
+}
@@ -32,6 +32,16 @@
 // Public types
 typedef int32_t (*UAVTalkOutputStream)(uint8_t *data, int32_t length);
 
+// Space reserved in the output buffer, a packet can be split in two regions
+typedef struct {
+    uint8_t  *data;
+    uint16_t length;
+} UAVTalkOutputRegion;
+// Reserve space for a packet of the given length in the output buffer, return 0 on success
+typedef int32_t (*UAVTalkOutputReserve)(uint16_t length, UAVTalkOutputRegion regions[2]);
+// Send the packet written in the reserved space, 0 to cancel, return 0 on success
+typedef int32_t (*UAVTalkOutputCommit)(uint16_t length);
+
 typedef struct {
     uint32_t txBytes;
     uint32_t txObjectBytes;
@@ -54,18 +64,23 @@ typedef enum { UAVTALK_STATE_ERROR = 0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE,
 UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream);
 int32_t UAVTalkSetOutputStream(UAVTalkConnection connection, UAVTalkOutputStream outputStream);
 UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
+int32_t UAVTalkSetOutputBuffer(UAVTalkConnection connection, UAVTalkOutputReserve outputReserve, UAVTalkOutputCommit outputCommit);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
+int32_t UAVTalkSendObjectBatch(UAVTalkConnection connectionHandle, const UAVObjHandle *objs, const uint16_t *instIds, uint8_t count);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
 UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
+UAVTalkRxState UAVTalkProcessInputBuffer(UAVTalkConnection connection, const uint8_t *rxbuffer, uint16_t length);
 int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle);
+int32_t UAVTalkRelayFrame(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *frame, uint16_t length);
 int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle);
 void UAVTalkGetStats(UAVTalkConnection connection, UAVTalkStats *stats, bool reset);
 void UAVTalkAddStats(UAVTalkConnection connection, UAVTalkStats *stats, bool reset);
 void UAVTalkResetStats(UAVTalkConnection connection);
 void UAVTalkGetLastTimestamp(UAVTalkConnection connection, uint16_t *timestamp);
 uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connection);
+uint8_t UAVTalkGetPacketType(UAVTalkConnection connection);
 
 #endif // UAVTALK_H
 /**
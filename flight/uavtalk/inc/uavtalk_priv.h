@@ -46,6 +46,12 @@
 #define UAVTALK_MIN_PACKET_LENGTH  UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH  UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
+// multi object record : object ID(4), instance ID(2), data (the first record uses the packet header IDs)
+#define UAVTALK_MULTI_RECORD_HEADER_LENGTH 6
+
+// multi object packets must also fit the 256 bytes GCS receive buffer
+#define UAVTALK_MAX_MULTI_PAYLOAD_LENGTH   (UAVOBJECTS_LARGEST < 255 ? UAVOBJECTS_LARGEST : 255)
+
 typedef struct {
     uint8_t  type;
     uint16_t packet_size;
@@ -58,11 +64,14 @@ typedef struct {
     uint32_t rxCount;
     UAVTalkRxState state;
     uint16_t rxPacketLength;
+    const uint8_t *rxData; // payload, in rxBuffer or in place in the block given to UAVTalkProcessInputBuffer()
 } UAVTalkInputProcessor;
 
 typedef struct {
     uint8_t canari;
     UAVTalkOutputStream outStream;
+    UAVTalkOutputReserve outReserve; // optional, objects are then packed directly in the output buffer
+    UAVTalkOutputCommit outCommit;
     xSemaphoreHandle    lock;
     xSemaphoreHandle    transLock;
     xSemaphoreHandle    respSema;
@@ -73,6 +82,8 @@ typedef struct {
     UAVTalkInputProcessor iproc;
     uint8_t      *rxBuffer;
     uint8_t      *txBuffer;
+    uint16_t     batchLength; // payload bytes of the multi object packet being built in txBuffer
+    uint8_t      batchCount; // number of records in the multi object packet being built
 } UAVTalkConnectionData;
 
 #define UAVTALK_CANARI          0xCA
@@ -86,6 +97,7 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK    (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK        (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK       (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_MULTI  (UAVTALK_TYPE_VER | 0x05)
 #define UAVTALK_TYPE_OBJ_TS     (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 #define UAVTALK_TYPE_OBJ_ACK_TS (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
 
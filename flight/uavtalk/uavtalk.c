@@ -51,7 +51,10 @@
 static int32_t objectTransaction(UAVTalkConnectionData *connection, uint8_t type, UAVObjHandle obj, uint16_t instId, int32_t timeout);
 static int32_t sendObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, UAVObjHandle obj);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, UAVObjHandle obj);
-static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t *data);
+static int32_t sendSingleObjectInPlace(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, int32_t headerLength, int32_t length);
+static int32_t appendBatchObject(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId, UAVObjHandle obj);
+static int32_t flushBatch(UAVTalkConnectionData *connection);
+static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, const uint8_t *data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId);
 
 /**
@@ -73,8 +76,12 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
     connection->iproc.rxPacketLength = 0;
     connection->iproc.state = UAVTALK_STATE_SYNC;
     connection->outStream   = outputStream;
+    connection->outReserve  = NULL;
+    connection->outCommit   = NULL;
     connection->lock = xSemaphoreCreateRecursiveMutex();
     connection->transLock   = xSemaphoreCreateRecursiveMutex();
+    connection->batchLength = 0;
+    connection->batchCount  = 0;
     // allocate buffers
     connection->rxBuffer    = pios_malloc(UAVTALK_MAX_PACKET_LENGTH);
     if (!connection->rxBuffer) {
@@ -115,6 +122,38 @@ int32_t UAVTalkSetOutputStream(UAVTalkConnection connectionHandle, UAVTalkOutput
     return 0;
 }
 
+/**
+ * Set the output buffer used to pack objects in place, avoiding the copy through the
+ * transmit buffer. The output stream is still used for the other packets and when
+ * no space can be reserved.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] outputReserve Function pointer that is called to reserve space for a packet, NULL to disable
+ * \param[in] outputCommit Function pointer that is called to send the packet written in the reserved space
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetOutputBuffer(UAVTalkConnection connectionHandle, UAVTalkOutputReserve outputReserve, UAVTalkOutputCommit outputCommit)
+{
+    UAVTalkConnectionData *connection;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    if ((outputReserve == NULL) != (outputCommit == NULL)) {
+        return -1;
+    }
+
+    // Lock
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+
+    connection->outReserve = outputReserve;
+    connection->outCommit  = outputCommit;
+
+    // Release lock
+    xSemaphoreGiveRecursive(connection->lock);
+
+    return 0;
+}
+
 /**
  * Get current output stream
  * \param[in] connection UAVTalkConnection to be used
@@ -289,6 +328,59 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
     }
 }
 
+/**
+ * Send several objects through the telemetry link, packed into as few packets as possible.
+ * Records that fit together are sent in a single UAVTALK_TYPE_OBJ_MULTI packet sharing one
+ * header and checksum, a lone record is sent as a plain UAVTALK_TYPE_OBJ packet.
+ * Batched objects are never acked.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] objs Objects to send
+ * \param[in] instIds The instance ID of each object or UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] count Number of entries in objs and instIds
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectBatch(UAVTalkConnection connectionHandle, const UAVObjHandle *objs, const uint16_t *instIds, uint8_t count)
+{
+    UAVTalkConnectionData *connection;
+    int32_t ret = 0;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+
+    connection->batchLength = 0;
+    connection->batchCount  = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        UAVObjHandle obj = objs[i];
+        uint16_t instId  = instIds[i];
+
+        // If all instances are requested and this is a single instance object, force instance ID to zero
+        if ((instId == UAVOBJ_ALL_INSTANCES) && UAVObjIsSingleInstance(obj)) {
+            instId = 0;
+        }
+
+        if (instId == UAVOBJ_ALL_INSTANCES) {
+            // Send all instances in reverse order, as sendObject() does
+            uint32_t numInst = UAVObjGetNumInstances(obj);
+            for (uint32_t n = 0; n < numInst; ++n) {
+                if (appendBatchObject(connection, UAVObjGetID(obj), numInst - n - 1, obj) == -1) {
+                    ret = -1;
+                }
+            }
+        } else if (appendBatchObject(connection, UAVObjGetID(obj), instId, obj) == -1) {
+            ret = -1;
+        }
+    }
+    if (flushBatch(connection) == -1) {
+        ret = -1;
+    }
+
+    xSemaphoreGiveRecursive(connection->lock);
+
+    return ret;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -386,6 +478,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
         iproc->rxPacketLength = 1;
         iproc->rxCount = 0;
+        iproc->rxData  = connection->rxBuffer;
 
         iproc->type    = 0;
         iproc->state   = UAVTALK_STATE_TYPE;
@@ -464,6 +557,10 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
         if (iproc->type == UAVTALK_TYPE_OBJ_REQ || iproc->type == UAVTALK_TYPE_ACK || iproc->type == UAVTALK_TYPE_NACK) {
             iproc->length = 0;
             iproc->timestampLength = 0;
+        } else if (iproc->type == UAVTALK_TYPE_OBJ_MULTI) {
+            // The payload holds several records, it is split by receiveObject()
+            iproc->length = iproc->packet_size - iproc->rxPacketLength;
+            iproc->timestampLength = 0;
         } else {
             iproc->timestampLength = (iproc->type & UAVTALK_TIMESTAMPED) ? 2 : 0;
             if (obj) {
@@ -589,6 +686,65 @@ UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uin
     return state;
 }
 
+/**
+ * Process a block of bytes from the telemetry stream, every object completed is received.
+ * The payloads are copied and checksummed in one go instead of byte by byte, a payload
+ * completely contained in the block is unpacked straight from it into the object.
+ * \param[in] connectionHandle UAVTalkConnection to be used
+ * \param[in] rxbuffer Received bytes
+ * \param[in] length Number of received bytes
+ * \return UAVTalkRxState after the last byte
+ */
+UAVTalkRxState UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, const uint8_t *rxbuffer, uint16_t length)
+{
+    UAVTalkConnectionData *connection;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    UAVTalkInputProcessor *iproc = &connection->iproc;
+    UAVTalkRxState state = iproc->state;
+    uint16_t position    = 0;
+
+    while (position < length) {
+        if (iproc->state == UAVTALK_STATE_DATA) {
+            // take as much of the payload as the block holds
+            uint32_t count = iproc->length - iproc->rxCount;
+            if (iproc->rxCount == 0 && count <= (uint32_t)(length - position)) {
+                // the whole payload is in the block, it is unpacked from there without a copy
+                iproc->rxData = &rxbuffer[position];
+            } else {
+                if (count > (uint32_t)(length - position)) {
+                    count = length - position;
+                }
+                memcpy(&connection->rxBuffer[iproc->rxCount], &rxbuffer[position], count);
+            }
+            iproc->cs = PIOS_CRC_updateCRC(iproc->cs, &rxbuffer[position], count);
+            iproc->rxCount        += count;
+            iproc->rxPacketLength += count;
+            connection->stats.rxBytes += count;
+            position += count;
+
+            if (iproc->rxCount == iproc->length) {
+                iproc->rxCount = 0;
+                iproc->state   = UAVTALK_STATE_CS;
+            }
+            state = iproc->state;
+        } else {
+            state = UAVTalkProcessInputStreamQuiet(connectionHandle, rxbuffer[position++]);
+            if (state == UAVTALK_STATE_COMPLETE) {
+                UAVTalkReceiveObject(connectionHandle);
+            }
+        }
+    }
+
+    // the block is not ours once we return, a payload left in it can not be relayed any more
+    if (iproc->rxData != connection->rxBuffer) {
+        iproc->rxData = NULL;
+    }
+
+    return state;
+}
+
 /**
  * Send a parsed packet received on one connection handle out on a different connection handle.
  * The packet must be in a complete state, meaning it is completed parsing.
@@ -606,8 +762,8 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
     CHECKCONHANDLE(inConnectionHandle, inConnection, return -1);
     UAVTalkInputProcessor *inIproc = &inConnection->iproc;
 
-    // The input packet must be completely parsed.
-    if (inIproc->state != UAVTALK_STATE_COMPLETE) {
+    // The input packet must be completely parsed, with its payload still available.
+    if (inIproc->state != UAVTALK_STATE_COMPLETE || !inIproc->rxData) {
         inConnection->stats.rxErrors++;
 
         return -1;
@@ -649,7 +805,7 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
 
     // Copy data (if any)
     if (inIproc->length > 0) {
-        memcpy(&outConnection->txBuffer[headerLength], inConnection->rxBuffer, inIproc->length);
+        memcpy(&outConnection->txBuffer[headerLength], inIproc->rxData, inIproc->length);
     }
 
     // Store the packet length
@@ -679,6 +835,61 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
     return ret;
 }
 
+/**
+ * Send a parsed packet received on one connection handle out on a different connection handle,
+ * forwarding the received bytes as they are instead of re-assembling the packet.
+ * Falls back to UAVTalkRelayPacket() when the frame given is not the complete packet,
+ * e.g. when the packet was received over several blocks.
+ * \param[in] inConnectionHandle UAVTalkConnection the packet was received on
+ * \param[in] outConnectionHandle UAVTalkConnection to send the packet on
+ * \param[in] frame The received bytes of the packet from the sync byte to the checksum, or NULL
+ * \param[in] length Number of bytes in frame
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkRelayFrame(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, const uint8_t *frame, uint16_t length)
+{
+    UAVTalkConnectionData *inConnection;
+
+    CHECKCONHANDLE(inConnectionHandle, inConnection, return -1);
+    UAVTalkInputProcessor *inIproc = &inConnection->iproc;
+
+    if (!frame || inIproc->state != UAVTALK_STATE_COMPLETE || length != inIproc->packet_size + UAVTALK_CHECKSUM_LENGTH) {
+        return UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+    }
+
+    UAVTalkConnectionData *outConnection;
+    CHECKCONHANDLE(outConnectionHandle, outConnection, return -1);
+
+    if (!outConnection->outStream) {
+        outConnection->stats.txErrors++;
+
+        return -1;
+    }
+
+    // Lock
+    xSemaphoreTakeRecursive(outConnection->lock, portMAX_DELAY);
+
+    // Send the frame, the output stream does not modify it
+    int32_t rc = (*outConnection->outStream)((uint8_t *)frame, length);
+
+    // Update stats
+    outConnection->stats.txBytes += (rc > 0) ? rc : 0;
+
+    // evaluate return value before releasing the lock
+    int32_t ret = 0;
+    if (rc != (int32_t)length) {
+        outConnection->stats.txErrors++;
+        ret = -1;
+    }
+
+    // Release lock
+    xSemaphoreGiveRecursive(outConnection->lock);
+
+    // Done
+    return ret;
+}
+
 /**
  * Complete receiving a UAVTalk packet.  This will cause the packet to be unpacked, acked, etc.
  * \param[in] connectionHandle UAVTalkConnection to be used
@@ -692,11 +903,11 @@ int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle)
     CHECKCONHANDLE(connectionHandle, connection, return -1);
 
     UAVTalkInputProcessor *iproc = &connection->iproc;
-    if (iproc->state != UAVTALK_STATE_COMPLETE) {
+    if (iproc->state != UAVTALK_STATE_COMPLETE || !iproc->rxData) {
         return -1;
     }
 
-    return receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer);
+    return receiveObject(connection, iproc->type, iproc->objId, iproc->instId, iproc->rxData, iproc->length);
 }
 
 /**
@@ -713,6 +924,20 @@ uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connectionHandle)
     return connection->iproc.objId;
 }
 
+/**
+ * Get the type of the current packet.
+ * \param[in] connectionHandle UAVTalkConnection to be used
+ * \return The packet type, or 0 on error.
+ */
+uint8_t UAVTalkGetPacketType(UAVTalkConnection connectionHandle)
+{
+    UAVTalkConnectionData *connection;
+
+    CHECKCONHANDLE(connectionHandle, connection, return 0);
+
+    return connection->iproc.type;
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  *
@@ -723,7 +948,7 @@ uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connectionHandle)
  * In that case we want to nack as there is no point in the sender retrying to send invalid objects.
  *
  * \param[in] connection UAVTalkConnection to be used
- * \param[in] type Type of received message (UAVTALK_TYPE_OBJ, UAVTALK_TYPE_OBJ_REQ, UAVTALK_TYPE_OBJ_ACK, UAVTALK_TYPE_ACK, UAVTALK_TYPE_NACK)
+ * \param[in] type Type of received message (UAVTALK_TYPE_OBJ, UAVTALK_TYPE_OBJ_REQ, UAVTALK_TYPE_OBJ_ACK, UAVTALK_TYPE_ACK, UAVTALK_TYPE_NACK, UAVTALK_TYPE_OBJ_MULTI)
  * \param[in] objId ID of the object to work on
  * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
  * \param[in] data Data buffer
@@ -731,7 +956,7 @@ uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connectionHandle)
  * \return 0 Success
  * \return -1 Failure
  */
-static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t *data)
+static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, const uint8_t *data, int32_t length)
 {
     UAVObjHandle obj;
     int32_t ret = 0;
@@ -766,6 +991,37 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
         }
         break;
 
+    case UAVTALK_TYPE_OBJ_MULTI:
+        // The first record uses the header IDs, the following ones carry their own
+        while (ret == 0 && length > 0) {
+            if (!obj || (instId == UAVOBJ_ALL_INSTANCES) || (int32_t)UAVObjGetNumBytes(obj) > length) {
+                ret = -1;
+                break;
+            }
+            // Unpack object, if the instance does not exist it will be created!
+            if (UAVObjUnpack(obj, instId, data) != 0) {
+                ret = -1;
+                break;
+            }
+            // Records act as OBJ messages and can ack a pending OBJ_REQ message
+            updateAck(connection, UAVTALK_TYPE_OBJ, objId, instId);
+            data   += UAVObjGetNumBytes(obj);
+            length -= UAVObjGetNumBytes(obj);
+            if (length == 0) {
+                break;
+            }
+            if (length < UAVTALK_MULTI_RECORD_HEADER_LENGTH) {
+                ret = -1;
+                break;
+            }
+            objId   = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+            instId  = data[4] | (data[5] << 8);
+            data   += UAVTALK_MULTI_RECORD_HEADER_LENGTH;
+            length -= UAVTALK_MULTI_RECORD_HEADER_LENGTH;
+            obj     = UAVObjGetByID(objId);
+        }
+        break;
+
     case UAVTALK_TYPE_OBJ_ACK:
     case UAVTALK_TYPE_OBJ_ACK_TS:
         UAVT_DEBUGLOG_CPRINTF(objId, "OBJ_ACK %X %d", objId, instId);
@@ -943,9 +1199,9 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type,
     connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
     int32_t headerLength = 10;
 
-    // Add timestamp when the transaction type is appropriate
+    // Add timestamp (ms) when the transaction type is appropriate
     if (type & UAVTALK_TIMESTAMPED) {
-        portTickType time = xTaskGetTickCount();
+        uint32_t time = xTaskGetTickCount() * portTICK_RATE_MS;
         connection->txBuffer[10] = (uint8_t)(time & 0xFF);
         connection->txBuffer[11] = (uint8_t)((time >> 8) & 0xFF);
         headerLength += 2;
@@ -965,24 +1221,37 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type,
         return -1;
     }
 
-    // Copy data (if any)
-    if (length > 0) {
-        if (UAVObjPack(obj, instId, &connection->txBuffer[headerLength]) == -1) {
+    // Store the packet length
+    connection->txBuffer[2] = (uint8_t)((headerLength + length) & 0xFF);
+    connection->txBuffer[3] = (uint8_t)(((headerLength + length) >> 8) & 0xFF);
+
+    uint16_t tx_msg_len = headerLength + length + UAVTALK_CHECKSUM_LENGTH;
+    int32_t rc = -2;
+
+    // Pack the data directly in the output buffer when possible
+    if (length > 0 && connection->outReserve) {
+        rc = sendSingleObjectInPlace(connection, obj, instId, headerLength, length);
+        if (rc == -1) {
             connection->stats.txErrors++;
             return -1;
         }
     }
 
-    // Store the packet length
-    connection->txBuffer[2] = (uint8_t)((headerLength + length) & 0xFF);
-    connection->txBuffer[3] = (uint8_t)(((headerLength + length) >> 8) & 0xFF);
+    if (rc == -2) {
+        // Copy data (if any)
+        if (length > 0) {
+            if (UAVObjPack(obj, instId, &connection->txBuffer[headerLength]) == -1) {
+                connection->stats.txErrors++;
+                return -1;
+            }
+        }
 
-    // Calculate and store checksum
-    connection->txBuffer[headerLength + length] = PIOS_CRC_updateCRC(0, connection->txBuffer, headerLength + length);
+        // Calculate and store checksum
+        connection->txBuffer[headerLength + length] = PIOS_CRC_updateCRC(0, connection->txBuffer, headerLength + length);
 
-    // Send object
-    uint16_t tx_msg_len = headerLength + length + UAVTALK_CHECKSUM_LENGTH;
-    int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+        // Send object
+        rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+    }
 
     // Update stats
     if (rc == tx_msg_len) {
@@ -1000,6 +1269,185 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type,
     return 0;
 }
 
+/**
+ * Copy bytes at the given offset of the reserved output regions.
+ */
+static void writeRegions(UAVTalkOutputRegion regions[2], uint16_t offset, const uint8_t *data, uint16_t length)
+{
+    for (uint8_t i = 0; i < 2 && length > 0; i++) {
+        if (offset >= regions[i].length) {
+            offset -= regions[i].length;
+            continue;
+        }
+        uint16_t chunk = regions[i].length - offset;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(regions[i].data + offset, data, chunk);
+        data   += chunk;
+        length -= chunk;
+        offset  = 0;
+    }
+}
+
+/**
+ * Send an object packing it directly in space reserved in the output buffer, the header
+ * must have been set up in the transmit buffer. The data are only packed in the transmit
+ * buffer first when they wrap around the end of the output buffer.
+ * \param[in] connection UAVTalkConnection to be used (lock must be held)
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID
+ * \param[in] headerLength Length of the header in the transmit buffer
+ * \param[in] length Length of the object data
+ * \return number of bytes sent on success
+ * \return -1 Failure to pack the object
+ * \return -2 No space could be reserved, the packet must be sent through the output stream
+ */
+static int32_t sendSingleObjectInPlace(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, int32_t headerLength, int32_t length)
+{
+    UAVTalkOutputRegion regions[2];
+    uint16_t tx_msg_len = headerLength + length + UAVTALK_CHECKSUM_LENGTH;
+
+    if ((*connection->outReserve)(tx_msg_len, regions) != 0) {
+        return -2;
+    }
+
+    writeRegions(regions, 0, connection->txBuffer, headerLength);
+    uint8_t cs = PIOS_CRC_updateCRC(0, connection->txBuffer, headerLength);
+
+    if (regions[0].length >= headerLength + length) {
+        uint8_t *data = regions[0].data + headerLength;
+        if (UAVObjPack(obj, instId, data) == -1) {
+            (*connection->outCommit)(0);
+            return -1;
+        }
+        cs = PIOS_CRC_updateCRC(cs, data, length);
+    } else {
+        uint8_t *data = &connection->txBuffer[headerLength];
+        if (UAVObjPack(obj, instId, data) == -1) {
+            (*connection->outCommit)(0);
+            return -1;
+        }
+        writeRegions(regions, headerLength, data, length);
+        cs = PIOS_CRC_updateCRC(cs, data, length);
+    }
+    writeRegions(regions, headerLength + length, &cs, UAVTALK_CHECKSUM_LENGTH);
+
+    if ((*connection->outCommit)(tx_msg_len) != 0) {
+        return 0;
+    }
+    return tx_msg_len;
+}
+
+/**
+ * Append an object instance to the multi object packet being built in the transmit buffer.
+ * The pending packet is sent first if the record does not fit in it.
+ * \param[in] connection UAVTalkConnection to be used (lock must be held)
+ * \param[in] objId The object ID
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \param[in] obj Object handle to send
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t appendBatchObject(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId, UAVObjHandle obj)
+{
+    int32_t ret    = 0;
+    int32_t length = UAVObjGetNumBytes(obj);
+
+    // Objects too large to share a packet are sent on their own
+    if (length + UAVTALK_MULTI_RECORD_HEADER_LENGTH > UAVTALK_MAX_MULTI_PAYLOAD_LENGTH) {
+        ret = flushBatch(connection);
+        if (sendSingleObject(connection, UAVTALK_TYPE_OBJ, objId, instId, obj) == -1) {
+            ret = -1;
+        }
+        return ret;
+    }
+
+    if (connection->batchCount > 0 && connection->batchLength + UAVTALK_MULTI_RECORD_HEADER_LENGTH + length > UAVTALK_MAX_MULTI_PAYLOAD_LENGTH) {
+        ret = flushBatch(connection);
+    }
+
+    uint8_t *record;
+    if (connection->batchCount == 0) {
+        // First record, IDs go in the packet header
+        record = &connection->txBuffer[4];
+    } else {
+        record = &connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH + connection->batchLength];
+        connection->batchLength += UAVTALK_MULTI_RECORD_HEADER_LENGTH;
+    }
+    record[0] = (uint8_t)(objId & 0xFF);
+    record[1] = (uint8_t)((objId >> 8) & 0xFF);
+    record[2] = (uint8_t)((objId >> 16) & 0xFF);
+    record[3] = (uint8_t)((objId >> 24) & 0xFF);
+    record[4] = (uint8_t)(instId & 0xFF);
+    record[5] = (uint8_t)((instId >> 8) & 0xFF);
+
+    if (UAVObjPack(obj, instId, &connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH + connection->batchLength]) == -1) {
+        // Drop the record
+        if (connection->batchCount > 0) {
+            connection->batchLength -= UAVTALK_MULTI_RECORD_HEADER_LENGTH;
+        }
+        connection->stats.txErrors++;
+        return -1;
+    }
+    connection->batchLength += length;
+    connection->batchCount++;
+
+    return ret;
+}
+
+/**
+ * Send the multi object packet built in the transmit buffer, if any.
+ * \param[in] connection UAVTalkConnection to be used (lock must be held)
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBatch(UAVTalkConnectionData *connection)
+{
+    uint8_t count   = connection->batchCount;
+    uint16_t length = connection->batchLength;
+
+    connection->batchCount  = 0;
+    connection->batchLength = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (!connection->outStream) {
+        connection->stats.txErrors++;
+        return -1;
+    }
+
+    // Setup sync byte
+    connection->txBuffer[0] = UAVTALK_SYNC_VAL;
+    // Setup type, a single record is a plain object packet
+    connection->txBuffer[1] = (count == 1) ? UAVTALK_TYPE_OBJ : UAVTALK_TYPE_OBJ_MULTI;
+    // Store the packet length
+    connection->txBuffer[2] = (uint8_t)((UAVTALK_MIN_HEADER_LENGTH + length) & 0xFF);
+    connection->txBuffer[3] = (uint8_t)(((UAVTALK_MIN_HEADER_LENGTH + length) >> 8) & 0xFF);
+
+    // Calculate and store checksum
+    connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH + length] = PIOS_CRC_updateCRC(0, connection->txBuffer, UAVTALK_MIN_HEADER_LENGTH + length);
+
+    // Send packet
+    uint16_t tx_msg_len = UAVTALK_MIN_HEADER_LENGTH + length + UAVTALK_CHECKSUM_LENGTH;
+    int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+
+    // Update stats
+    if (rc == tx_msg_len) {
+        connection->stats.txObjects     += count;
+        connection->stats.txObjectBytes += length - (count - 1) * UAVTALK_MULTI_RECORD_HEADER_LENGTH;
+        connection->stats.txBytes += tx_msg_len;
+    } else {
+        connection->stats.txErrors++;
+        connection->stats.txBytes += (rc > 0) ? rc : 0;
+        return -1;
+    }
+
+    return 0;
+}
+
 /**
  * @}
  * @}
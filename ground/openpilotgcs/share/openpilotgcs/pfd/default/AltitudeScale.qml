@@ -4,7 +4,7 @@ Item {
     id: sceneItem
     property variant sceneSize
 
-    property real altitude : -qmlWidget.altitudeFactor * PositionState.Down
+    property real altitude : -qmlWidget.altitudeFactor * pfdData.positionDown
 
     SvgElementImage {
         id: altitude_window
@@ -75,7 +75,7 @@ Item {
             anchors.left: parent.left
             anchors.verticalCenter: parent.verticalCenter
 
-            anchors.verticalCenterOffset: -altitude_scale.height/10 * (PositionState.Down - PathDesired.End_Down) * qmlWidget.altitudeFactor
+            anchors.verticalCenterOffset: -altitude_scale.height/10 * (pfdData.positionDown - PathDesired.End_Down) * qmlWidget.altitudeFactor
         }
     }
 
@@ -31,7 +31,7 @@ Item {
         x: Math.floor(scaledBounds.x * sceneItem.width)
         y: Math.floor(scaledBounds.y * sceneItem.height)
 
-        rotation: -AttitudeState.Yaw
+        rotation: -pfdData.yaw
         transformOrigin: Item.Center
 
         smooth: true
@@ -46,9 +46,9 @@ Item {
         x: Math.floor(scaledBounds.x * sceneItem.width)
         y: Math.floor(scaledBounds.y * sceneItem.height)
 
-        property real home_degrees: 180/3.1415 * Math.atan2(TakeOffLocation.East - PositionState.East, TakeOffLocation.North - PositionState.North)
+        property real home_degrees: 180/3.1415 * Math.atan2(TakeOffLocation.East - pfdData.positionEast, TakeOffLocation.North - pfdData.positionNorth)
 
-        rotation: -AttitudeState.Yaw + home_degrees
+        rotation: -pfdData.yaw + home_degrees
         transformOrigin: Item.Bottom
         visible: TakeOffLocation.Status == 0
 
@@ -62,9 +62,9 @@ Item {
         x: Math.floor(scaledBounds.x * sceneItem.width)
         y: Math.floor(scaledBounds.y * sceneItem.height)
 
-        property real course_degrees: 180/3.1415 * Math.atan2(PathDesired.End_East - PositionState.East, PathDesired.End_North - PositionState.North)
+        property real course_degrees: 180/3.1415 * Math.atan2(PathDesired.End_East - pfdData.positionEast, PathDesired.End_North - pfdData.positionNorth)
 
-        rotation: -AttitudeState.Yaw + course_degrees
+        rotation: -pfdData.yaw + course_degrees
         transformOrigin: Item.Center
 
         smooth: true
@@ -85,7 +85,7 @@ Item {
 
         Text {
             id: compass_text
-            text: Math.floor(AttitudeState.Yaw).toFixed()
+            text: Math.floor(pfdData.yaw).toFixed()
             color: "white"
             font {
                 family: "Arial"
@@ -18,19 +18,19 @@ Item {
    
     property bool init_dist: false
     
-    property real home_heading: 180/3.1415 * Math.atan2(TakeOffLocation.East - PositionState.East, 
-                                                        TakeOffLocation.North - PositionState.North)
+    property real home_heading: 180/3.1415 * Math.atan2(TakeOffLocation.East - pfdData.positionEast, 
+                                                        TakeOffLocation.North - pfdData.positionNorth)
 
-    property real home_distance: Math.sqrt(Math.pow((TakeOffLocation.East - PositionState.East),2) +
-                                           Math.pow((TakeOffLocation.North - PositionState.North),2))
+    property real home_distance: Math.sqrt(Math.pow((TakeOffLocation.East - pfdData.positionEast),2) +
+                                           Math.pow((TakeOffLocation.North - pfdData.positionNorth),2))
 
-    property real wp_heading: 180/3.1415 * Math.atan2(PathDesired.End_East - PositionState.East, 
-                                                      PathDesired.End_North - PositionState.North)
+    property real wp_heading: 180/3.1415 * Math.atan2(PathDesired.End_East - pfdData.positionEast, 
+                                                      PathDesired.End_North - pfdData.positionNorth)
 
-    property real wp_distance: Math.sqrt(Math.pow((PathDesired.End_East - PositionState.East),2) +
-                                           Math.pow(( PathDesired.End_North - PositionState.North),2))
+    property real wp_distance: Math.sqrt(Math.pow((PathDesired.End_East - pfdData.positionEast),2) +
+                                           Math.pow(( PathDesired.End_North - pfdData.positionNorth),2))
 
-    property real current_velocity: Math.sqrt(Math.pow(VelocityState.North,2)+Math.pow(VelocityState.East,2))
+    property real current_velocity: Math.sqrt(Math.pow(pfdData.velocityNorth,2)+Math.pow(pfdData.velocityEast,2))
 
     property real home_eta: (home_distance > 0 && current_velocity > 0 ? Math.round(home_distance/current_velocity) : 0)
     property real home_eta_h: (home_eta > 0 ? Math.floor(home_eta / 3600) : 0 )
@@ -190,7 +190,7 @@ Item {
 
         Timer {
             interval: 1000; running: true; repeat: true;
-            onTriggered: {if (GPSPositionSensor.Status == 3) compute_distance(PositionState.East,PositionState.North)}
+            onTriggered: {if (GPSPositionSensor.Status == 3) compute_distance(pfdData.positionEast,pfdData.positionNorth)}
         }
     }
 
@@ -413,7 +413,7 @@ Item {
 
         Timer {
             interval: 1000; running: true; repeat: true;
-            onTriggered: {if (GPSPositionSensor.Status == 3) compute_distance(PositionState.East,PositionState.North)}
+            onTriggered: {if (GPSPositionSensor.Status == 3) compute_distance(pfdData.positionEast,pfdData.positionNorth)}
         }
     }
 
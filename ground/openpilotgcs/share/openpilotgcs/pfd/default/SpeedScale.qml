@@ -3,8 +3,8 @@ import QtQuick 2.0
 Item {
     id: sceneItem
     property variant sceneSize
-    property real groundSpeed : qmlWidget.speedFactor * Math.sqrt(Math.pow(VelocityState.North,2)+
-                                                Math.pow(VelocityState.East,2))
+    property real groundSpeed : qmlWidget.speedFactor * Math.sqrt(Math.pow(pfdData.velocityNorth,2)+
+                                                Math.pow(pfdData.velocityEast,2))
 
     SvgElementImage {
         id: speed_window
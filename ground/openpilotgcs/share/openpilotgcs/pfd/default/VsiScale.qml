@@ -7,7 +7,7 @@ Item {
 
     Timer {
          interval: 100; running: true; repeat: true
-         onTriggered: vert_velocity = (0.9 * vert_velocity) + (0.1 * VelocityState.Down)
+         onTriggered: vert_velocity = (0.9 * vert_velocity) + (0.1 * pfdData.velocityDown)
      }
 
     SvgElementImage {
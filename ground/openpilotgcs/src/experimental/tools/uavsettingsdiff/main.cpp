@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Compares vehicle templates and settings exports to a reference
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavsettingssnapshot.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+// Exit codes
+#define RESULT_SAME        0
+#define RESULT_DIFFERENT   1
+#define RESULT_ERROR       2
+
+static void usage(QTextStream &err)
+{
+    err << "usage: uavsettingsdiff [-o <dir>] <reference> <file>...\n"
+        << "  Compares each file to the reference, the files are vehicle templates (.optmpl),\n"
+        << "  JSON or XML (.uav) settings exports.\n"
+        << "  -o <dir>  also write every file to <dir> as JSON, in the template layout\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    QStringList args = app.arguments().mid(1);
+    QString outputDir;
+
+    if (args.length() >= 2 && args.at(0) == "-o") {
+        outputDir = args.at(1);
+        args = args.mid(2);
+    }
+    if (args.length() < 2) {
+        usage(err);
+        return RESULT_ERROR;
+    }
+
+    // All the files are parsed in parallel, the results come in the order of the arguments
+    QList<UAVSettingsSnapshot> snapshots = UAVSettingsSnapshot::loadFiles(args).results();
+    int result = RESULT_SAME;
+
+    foreach(const UAVSettingsSnapshot &snapshot, snapshots) {
+        if (!snapshot.errorString().isEmpty()) {
+            err << snapshot.fileName() << ": " << snapshot.errorString() << "\n";
+            result = RESULT_ERROR;
+        }
+    }
+    if (result == RESULT_ERROR) {
+        return result;
+    }
+
+    const UAVSettingsSnapshot &reference = snapshots.first();
+    for (int i = 1; i < snapshots.length(); ++i) {
+        QList<UAVSettingsSnapshot::Difference> differences = reference.diff(snapshots.at(i));
+
+        out << "--- " << reference.fileName() << "\n+++ " << snapshots.at(i).fileName()
+            << " (" << differences.length() << " differences)\n";
+        foreach(const UAVSettingsSnapshot::Difference &difference, differences) {
+            out << difference.toString() << "\n";
+        }
+        if (!differences.isEmpty()) {
+            result = RESULT_DIFFERENT;
+        }
+    }
+
+    if (!outputDir.isEmpty()) {
+        foreach(const UAVSettingsSnapshot &snapshot, snapshots) {
+            QFile file(QDir(outputDir).filePath(QFileInfo(snapshot.fileName()).completeBaseName() + ".json"));
+            if (!file.open(QFile::WriteOnly) || !snapshot.writeJson(&file)) {
+                err << file.fileName() << ": " << file.errorString() << "\n";
+                return RESULT_ERROR;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,22 @@
+# Command line compare of vehicle templates and settings exports, e.g.
+#   uavsettingsdiff reference.optmpl vehicle1.uav vehicle2.uav ...
+# Only the snapshot and JSON sources of the UAVObjects plugin are built in,
+# there is no dependency on the GCS plugins or a GUI.
+
+TARGET = uavsettingsdiff
+TEMPLATE = app
+QT -= gui
+QT += concurrent
+CONFIG += console
+CONFIG -= app_bundle
+
+UAVOBJECTS_DIR = ../../../plugins/uavobjects
+INCLUDEPATH += $$UAVOBJECTS_DIR
+DEFINES += UAVOBJECTS_LIBRARY
+
+SOURCES += main.cpp \
+    $$UAVOBJECTS_DIR/uavsettingssnapshot.cpp \
+    $$UAVOBJECTS_DIR/uavobjectjson.cpp
+
+HEADERS += $$UAVOBJECTS_DIR/uavsettingssnapshot.h \
+    $$UAVOBJECTS_DIR/uavobjectjson.h
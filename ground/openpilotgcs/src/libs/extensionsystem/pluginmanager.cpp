@@ -37,6 +37,10 @@
 #include <QtCore/QDir>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMap>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
 #include <QtDebug>
 #ifdef WITH_TESTS
 #include <QTest>
@@ -46,6 +50,22 @@ typedef QList<ExtensionSystem::PluginSpec *> PluginSpecSet;
 
 enum { debugLeaks = 0 };
 
+namespace {
+// Opens the library of a plugin on a worker thread
+class LibraryOpener : public QRunnable {
+public:
+    LibraryOpener(ExtensionSystem::Internal::PluginSpecPrivate *spec) : m_spec(spec) {}
+
+    void run()
+    {
+        m_spec->openLibrary();
+    }
+
+private:
+    ExtensionSystem::Internal::PluginSpecPrivate *m_spec;
+};
+}
+
 /*!
     \namespace ExtensionSystem
     \brief The ExtensionSystem namespace provides classes that belong to the core plugin system.
@@ -581,24 +601,70 @@ void PluginManagerPrivate::removeObject(QObject *obj)
 void PluginManagerPrivate::loadPlugins()
 {
     QList<PluginSpec *> queue = loadQueue();
+    QElapsedTimer totalTimer;
+    QElapsedTimer timer;
+
+    totalTimer.start();
+
+    // Open the libraries in parallel, the dynamic linker loads the libraries
+    // they depend on. The plugin objects are then created and initialized on
+    // this thread in the queue order, dependencies first.
+    QThreadPool pool;
+    foreach(PluginSpec * spec, queue) {
+        if (!spec->hasError() && spec->state() == PluginSpec::Resolved) {
+            pool.start(new LibraryOpener(spec->d));
+        }
+    }
+    pool.waitForDone();
+
     foreach(PluginSpec * spec, queue) {
+        timer.start();
         loadPlugin(spec, PluginSpec::Loaded);
+        spec->d->loadTime = timer.elapsed();
     }
     foreach(PluginSpec * spec, queue) {
+        timer.start();
         loadPlugin(spec, PluginSpec::Initialized);
+        spec->d->initializeTime = timer.elapsed();
     }
     QListIterator<PluginSpec *> it(queue);
     it.toBack();
     while (it.hasPrevious()) {
         PluginSpec *plugin = it.previous();
         emit q->pluginAboutToBeLoaded(plugin);
+        timer.start();
         loadPlugin(plugin, PluginSpec::Running);
+        plugin->d->extensionsTime = timer.elapsed();
     }
+    reportStartupTimes(queue, totalTimer.elapsed());
     emit q->pluginsChanged();
     q->m_allPluginsLoaded = true;
     emit q->pluginsLoadEnded();
 }
 
+/*!
+    \fn void PluginManagerPrivate::reportStartupTimes(const QList<PluginSpec *> &queue, qint64 totalTime)
+    Prints the time spent on each plugin, slowest first. The libraries are
+    opened in parallel so their open times add up to more than the total.
+    \internal
+ */
+void PluginManagerPrivate::reportStartupTimes(const QList<PluginSpec *> &queue, qint64 totalTime)
+{
+    QMultiMap<qint64, PluginSpec *> byTime;
+
+    foreach(PluginSpec * spec, queue) {
+        byTime.insert(spec->d->loadTime + spec->d->initializeTime + spec->d->extensionsTime, spec);
+    }
+    qDebug() << "PluginManager - loading" << queue.size() << "plugins took" << totalTime << "ms";
+    QMapIterator<qint64, PluginSpec *> it(byTime);
+    it.toBack();
+    while (it.hasPrevious()) {
+        PluginSpec *spec = it.previous().value();
+        qDebug() << "PluginManager -" << spec->name() << ": open" << spec->d->openTime << "ms, load" << spec->d->loadTime
+                 << "ms, initialize" << spec->d->initializeTime << "ms, extensions" << spec->d->extensionsTime << "ms";
+    }
+}
+
 /*!
     \fn void PluginManagerPrivate::loadQueue()
     \internal
@@ -81,6 +81,7 @@ private:
                    QList<PluginSpec *> &queue,
                    QList<PluginSpec *> &circularityCheckQueue);
     void stopAll();
+    void reportStartupTimes(const QList<PluginSpec *> &queue, qint64 totalTime);
 };
 } // namespace Internal
 } // namespace ExtensionSystem
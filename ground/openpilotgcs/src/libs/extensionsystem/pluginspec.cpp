@@ -38,6 +38,7 @@
 #include <QtCore/QXmlStreamReader>
 #include <QtCore/QRegExp>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
 #include <QtDebug>
 
 #ifdef Q_OS_LINUX
@@ -384,6 +385,10 @@ PluginSpecPrivate::PluginSpecPrivate(PluginSpec *spec)
     : plugin(0),
     state(PluginSpec::Invalid),
     hasError(false),
+    openTime(0),
+    loadTime(0),
+    initializeTime(0),
+    extensionsTime(0),
     q(spec)
 {}
 
@@ -770,22 +775,11 @@ bool PluginSpecPrivate::resolveDependencies(const QList<PluginSpec *> &specs)
 }
 
 /*!
-    \fn bool PluginSpecPrivate::loadLibrary()
+    \fn QString PluginSpecPrivate::libraryPath() const
     \internal
  */
-bool PluginSpecPrivate::loadLibrary()
+QString PluginSpecPrivate::libraryPath() const
 {
-    if (hasError) {
-        return false;
-    }
-    if (state != PluginSpec::Resolved) {
-        if (state == PluginSpec::Loaded) {
-            return true;
-        }
-        errorString = QCoreApplication::translate("PluginSpec", "Loading the library failed because state != Resolved");
-        hasError    = true;
-        return false;
-    }
 #ifdef QT_NO_DEBUG
 
 #ifdef Q_OS_WIN
@@ -808,6 +802,45 @@ bool PluginSpecPrivate::loadLibrary()
 
 #endif
 
+    return libName;
+}
+
+/*!
+    \fn bool PluginSpecPrivate::openLibrary()
+    Only opens the library, loadLibrary() then finds it already loaded.
+    The plugin state is not changed so this can run on a worker thread.
+    \internal
+ */
+bool PluginSpecPrivate::openLibrary()
+{
+    QElapsedTimer timer;
+
+    timer.start();
+    PluginLoader loader(libraryPath());
+    bool opened = loader.load();
+    openTime = timer.elapsed();
+    return opened;
+}
+
+/*!
+    \fn bool PluginSpecPrivate::loadLibrary()
+    \internal
+ */
+bool PluginSpecPrivate::loadLibrary()
+{
+    if (hasError) {
+        return false;
+    }
+    if (state != PluginSpec::Resolved) {
+        if (state == PluginSpec::Loaded) {
+            return true;
+        }
+        errorString = QCoreApplication::translate("PluginSpec", "Loading the library failed because state != Resolved");
+        hasError    = true;
+        return false;
+    }
+
+    QString libName = libraryPath();
     PluginLoader loader(libName);
     if (!loader.load()) {
         hasError    = true;
@@ -49,6 +49,8 @@ public:
     bool read(const QString &fileName);
     bool provides(const QString &pluginName, const QString &version) const;
     bool resolveDependencies(const QList<PluginSpec *> &specs);
+    QString libraryPath() const;
+    bool openLibrary();
     bool loadLibrary();
     bool initializePlugin();
     bool initializeExtensions();
@@ -77,6 +79,12 @@ public:
     bool hasError;
     QString errorString;
 
+    // startup times in ms
+    qint64 openTime;
+    qint64 loadTime;
+    qint64 initializeTime;
+    qint64 extensionsTime;
+
     static bool isValidVersion(const QString &version);
     static int versionCompare(const QString &version1, const QString &version2);
 
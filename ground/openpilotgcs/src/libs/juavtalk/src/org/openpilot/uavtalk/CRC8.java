@@ -46,7 +46,20 @@ public class CRC8 {
 	* @return - the new CRC value
 	*/
 	public static byte  arrayUpdate(byte crc, byte[] data, int length) {
-		for (int i=0;i<length;i++)
+		return arrayUpdate(crc, data, 0, length);
+	}
+
+	/**
+	* update a CRC8 value with a part of a byte-array
+	* 
+	* @param crc - start CRC8 Value
+	* @param data - data byte-array to update the CRC8-Checksum with
+	* @param offset - where to start in the array
+	* @param length - the number of bytes
+	* @return - the new CRC value
+	*/
+	public static byte  arrayUpdate(byte crc, byte[] data, int offset, int length) {
+		for (int i=offset;i<offset+length;i++)
 	        crc = CRC8_TABLE[(crc ^ data[i])&0xFF];
 	    return crc;
 	}
@@ -63,7 +63,15 @@ public abstract class UAVObject {
     
     abstract public void setGeneratedMetaData();
 
+    private int myDataLength=-1;
+
+    /**
+     * the length of the serialized object, it is computed once
+     * as the layout of an object is fixed
+     */
     public int getDataLength() {
-    	return serialize().length;
+    	if (myDataLength<0)
+    		myDataLength=serialize().length;
+    	return myDataLength;
     }
 }
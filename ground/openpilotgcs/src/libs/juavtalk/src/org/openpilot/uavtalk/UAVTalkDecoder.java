@@ -0,0 +1,263 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+package org.openpilot.uavtalk;
+
+import java.util.Arrays;
+
+/**
+ ******************************************************************************
+ *
+ * @file       UAVTalkDecoder.java
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      decodes a UAVTalk byte stream into the UAVObjects
+ *
+ * The packets are collected in a single receive buffer and the payloads are
+ * deserialized in place by the objects, so nothing is allocated per packet.
+ * The objects are looked up in a table of IDs sorted once at construction.
+ *
+ ****************************************************************************
+*/
+public class UAVTalkDecoder {
+
+	/**
+	 * receives the objects updated by the decoder
+	 */
+	public interface Listener {
+		/**
+		 * called after an object was deserialized
+		 *
+		 * @param obj - the object
+		 * @param inst_id - the instance ID of the update
+		 * @param type - the package type
+		 */
+		public void objectReceived(UAVObject obj, int inst_id, byte type);
+
+		/**
+		 * called for the packages without object data (requests and acks)
+		 *
+		 * @param type - the package type
+		 * @param obj_id - the object ID
+		 * @param inst_id - the instance ID
+		 */
+		public void packageReceived(byte type, int obj_id, int inst_id);
+	}
+
+	private final static int STATE_SYNC=0;
+	private final static int STATE_HEADER=1;
+	private final static int STATE_DATA=2;
+	private final static int STATE_CRC=3;
+
+	private final int[] objIDs;
+	private final UAVObject[] objs;
+	private final Listener listener;
+
+	private final byte[] buffer=new byte[UAVTalkDefinitions.MAX_PACKET_LENGTH];
+	private int state=STATE_SYNC;
+	private int count;
+	private int headerLength;
+	private int packageLength;
+
+	private int rxPackages;
+	private int rxErrors;
+
+	/**
+	 * @param objects - the objects to decode
+	 * @param listener - receives the decoded objects
+	 */
+	public UAVTalkDecoder(UAVObjectsInterface objects, Listener listener) {
+		UAVObject[] all=objects.getUAVObjectArray();
+		long[] sorted=new long[all.length];
+
+		// sort the ID with the index in the low bits, the IDs are compared unsigned
+		for (int i=0;i<all.length;i++)
+			sorted[i]=((all[i].getObjID()&0xFFFFFFFFL)<<16) | i;
+		Arrays.sort(sorted);
+
+		objIDs=new int[all.length];
+		objs=new UAVObject[all.length];
+		for (int i=0;i<all.length;i++) {
+			objIDs[i]=(int)(sorted[i]>>>16);
+			objs[i]=all[(int)(sorted[i]&0xFFFF)];
+		}
+		this.listener=listener;
+	}
+
+	/**
+	 * find an object by its ID
+	 *
+	 * @param obj_id - the object ID
+	 * @return the object or null if unknown
+	 */
+	public UAVObject getObjectByID(int obj_id) {
+		long id=obj_id&0xFFFFFFFFL;
+		int low=0;
+		int high=objIDs.length-1;
+
+		while (low<=high) {
+			int mid=(low+high)>>>1;
+			long mid_id=objIDs[mid]&0xFFFFFFFFL;
+			if (mid_id<id)
+				low=mid+1;
+			else if (mid_id>id)
+				high=mid-1;
+			else
+				return objs[mid];
+		}
+		return null;
+	}
+
+	/**
+	 * decode a part of a byte-array
+	 *
+	 * @param data - the received bytes
+	 * @param offset - where to start in the array
+	 * @param length - the number of bytes
+	 */
+	public void decode(byte[] data, int offset, int length) {
+		for (int i=offset;i<offset+length;i++)
+			decode(data[i]);
+	}
+
+	/**
+	 * decode one received byte
+	 *
+	 * @param b - the received byte
+	 */
+	public void decode(byte b) {
+		switch (state) {
+		case STATE_SYNC:
+			if (b==UAVTalkDefinitions.SYNC_VAL) {
+				buffer[0]=b;
+				count=1;
+				headerLength=UAVTalkDefinitions.HEADER_LENGTH;
+				state=STATE_HEADER;
+			}
+			break;
+
+		case STATE_HEADER:
+			buffer[count++]=b;
+			if (count==2) {
+				if ((b&UAVTalkDefinitions.TYPE_MASK)!=UAVTalkDefinitions.TYPE_VER) {
+					error();
+					break;
+				}
+				if ((b&UAVTalkDefinitions.TIMESTAMPED)!=0)
+					headerLength+=UAVTalkDefinitions.TIMESTAMP_LENGTH;
+			} else if (count==4) {
+				packageLength=ValueParser.parse_ushort_from_arr_2(2,buffer);
+				if (packageLength<headerLength || packageLength+UAVTalkDefinitions.CHECKSUM_LENGTH>buffer.length) {
+					error();
+					break;
+				}
+			}
+			if (count==headerLength)
+				state=(count<packageLength) ? STATE_DATA : STATE_CRC;
+			break;
+
+		case STATE_DATA:
+			buffer[count++]=b;
+			if (count==packageLength)
+				state=STATE_CRC;
+			break;
+
+		case STATE_CRC:
+			state=STATE_SYNC;
+			if (CRC8.arrayUpdate((byte)0,buffer,0,packageLength)!=b) {
+				rxErrors++;
+				break;
+			}
+			rxPackages++;
+			process();
+			break;
+		}
+	}
+
+	private void error() {
+		rxErrors++;
+		state=STATE_SYNC;
+	}
+
+	/**
+	 * hand the received package to the objects
+	 */
+	private void process() {
+		byte type=(byte)(buffer[1]&~UAVTalkDefinitions.TIMESTAMPED);
+		int obj_id=ValueParser.parse_int_from_arr_4(4,buffer);
+		int inst_id=ValueParser.parse_ushort_from_arr_2(8,buffer);
+		int offset=headerLength;
+		int length=packageLength-headerLength;
+
+		switch (type) {
+		case UAVTalkDefinitions.TYPE_OBJ:
+		case UAVTalkDefinitions.TYPE_OBJ_ACK:
+			unpack(buffer[1],obj_id,inst_id,offset,length);
+			break;
+
+		case UAVTalkDefinitions.TYPE_OBJ_MULTI:
+			// the first record uses the header IDs, the following ones carry their own
+			while (length>0) {
+				int unpacked=unpack(type,obj_id,inst_id,offset,length);
+				if (unpacked<0 || length-unpacked<UAVTalkDefinitions.MULTI_RECORD_HEADER_LENGTH) {
+					if (unpacked!=length)
+						rxErrors++;
+					break;
+				}
+				offset+=unpacked;
+				length-=unpacked;
+				obj_id=ValueParser.parse_int_from_arr_4(offset,buffer);
+				inst_id=ValueParser.parse_ushort_from_arr_2(offset+4,buffer);
+				offset+=UAVTalkDefinitions.MULTI_RECORD_HEADER_LENGTH;
+				length-=UAVTalkDefinitions.MULTI_RECORD_HEADER_LENGTH;
+			}
+			break;
+
+		default:
+			if (listener!=null)
+				listener.packageReceived(type,obj_id,inst_id);
+			break;
+		}
+	}
+
+	/**
+	 * deserialize one object from the receive buffer
+	 *
+	 * @return the number of bytes used or -1 if the object is unknown or too long
+	 */
+	private int unpack(byte type, int obj_id, int inst_id, int offset, int length) {
+		UAVObject obj=getObjectByID(obj_id);
+		if (obj==null || obj.getDataLength()>length)
+			return -1;
+		obj.deserialize(buffer,offset);
+		if (listener!=null)
+			listener.objectReceived(obj,inst_id,type);
+		return obj.getDataLength();
+	}
+
+	/**
+	 * @return the number of packages with a valid checksum
+	 */
+	public int getRxPackages() {
+		return rxPackages;
+	}
+
+	/**
+	 * @return the number of dropped packages
+	 */
+	public int getRxErrors() {
+		return rxErrors;
+	}
+}
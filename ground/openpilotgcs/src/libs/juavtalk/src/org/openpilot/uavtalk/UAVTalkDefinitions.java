@@ -37,6 +37,18 @@ public class UAVTalkDefinitions {
 	public final static byte TYPE_OBJ_REQ = (TYPE_VER | 0x01);
 	public final static byte TYPE_OBJ_ACK = (TYPE_VER | 0x02);
 	public final static byte TYPE_ACK     = (TYPE_VER | 0x03);
+	public final static byte TYPE_NACK    = (TYPE_VER | 0x04);
+	public final static byte TYPE_OBJ_MULTI = (TYPE_VER | 0x05);
+
+	public final static byte TYPE_MASK    = 0x78;
+	public final static byte TIMESTAMPED  = (byte)0x80;
+
+	public final static int HEADER_LENGTH      = 10;
+	public final static int TIMESTAMP_LENGTH   = 2;
+	public final static int CHECKSUM_LENGTH    = 1;
+	public final static int MULTI_RECORD_HEADER_LENGTH = 6;
+	public final static int MAX_PAYLOAD_LENGTH = 256;
+	public final static int MAX_PACKET_LENGTH  = HEADER_LENGTH + TIMESTAMP_LENGTH + MAX_PAYLOAD_LENGTH + CHECKSUM_LENGTH;
 
 
 	public final static String getTypeString(byte type) {
@@ -49,6 +61,10 @@ public class UAVTalkDefinitions {
 				return "obj_ack";
 			case TYPE_OBJ_REQ:
 				return "obj_req";
+			case TYPE_NACK:
+				return "nack";
+			case TYPE_OBJ_MULTI:
+				return "obj_multi";
 		}			
 		return "unknown type";
 	}
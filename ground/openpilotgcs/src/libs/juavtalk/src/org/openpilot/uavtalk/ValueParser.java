@@ -31,4 +31,48 @@ public class ValueParser {
 				   arr[offset+0] 
 				);
 	}
+
+	/**
+	 * parse a uint32 value from 4 bytes of some array
+	 * 
+	 * @param offset - where to start in the array
+	 * @param arr - the array
+	 * @return - the calculated value
+	 */
+	public final static long parse_uint_from_arr_4(int offset,byte[] arr) {
+		return parse_int_from_arr_4(offset,arr)&0xFFFFFFFFL;
+	}
+
+	/**
+	 * parse a int16 value from 2 bytes of some array
+	 * 
+	 * @param offset - where to start in the array
+	 * @param arr - the array
+	 * @return - the calculated value
+	 */
+	public final static short parse_short_from_arr_2(int offset,byte[] arr) {
+		return (short)(((arr[offset+1]&0xFF)<<8) | arr[offset+0]&0xFF);
+	}
+
+	/**
+	 * parse a uint16 value from 2 bytes of some array
+	 * 
+	 * @param offset - where to start in the array
+	 * @param arr - the array
+	 * @return - the calculated value
+	 */
+	public final static int parse_ushort_from_arr_2(int offset,byte[] arr) {
+		return ((arr[offset+1]&0xFF)<<8) | arr[offset+0]&0xFF;
+	}
+
+	/**
+	 * parse a float32 value from 4 bytes of some array
+	 * 
+	 * @param offset - where to start in the array
+	 * @param arr - the array
+	 * @return - the calculated value
+	 */
+	public final static float parse_float_from_arr_4(int offset,byte[] arr) {
+		return Float.intBitsToFloat(parse_int_from_arr_4(offset,arr));
+	}
 }
@@ -29,7 +29,44 @@
 
 namespace core {
 MemoryCache::MemoryCache()
-{}
+{
+    setDecodedCacheCapacity(64);
+}
+
+/**
+ * Set the size of the decoded tiles cache in MB
+ */
+void MemoryCache::setDecodedCacheCapacity(const int &value)
+{
+    for (int i = 0; i < DECODED_CACHE_STRIPES; i++) {
+        QMutexLocker locker(&decodedTiles[i].mutex);
+        decodedTiles[i].images.setMaxCost(value * 1024 / DECODED_CACHE_STRIPES);
+    }
+}
+
+/**
+ * The decoded image of a tile, the encoded pic is decoded and cached on a miss.
+ * Safe to call from any thread.
+ */
+QImage MemoryCache::GetDecodedTile(const RawTile &tile, const QByteArray &pic)
+{
+    DecodedTiles &stripe = decodedTiles[qHash(tile) % DECODED_CACHE_STRIPES];
+    {
+        QMutexLocker locker(&stripe.mutex);
+        QImage *image = stripe.images.object(tile);
+        if (image) {
+            return *image;
+        }
+    }
+
+    // Decode out of the lock, premultiplied is the fastest format to draw
+    QImage image = QImage::fromData(pic).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    if (!image.isNull()) {
+        QMutexLocker locker(&stripe.mutex);
+        stripe.images.insert(tile, new QImage(image), qMax(1, image.byteCount() / 1024));
+    }
+    return image;
+}
 
 
 QByteArray MemoryCache::GetTileFromMemoryCache(const RawTile &tile)
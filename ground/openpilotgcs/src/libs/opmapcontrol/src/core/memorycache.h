@@ -31,6 +31,8 @@
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QQueue>
+#include <QCache>
+#include <QImage>
 #include "kibertilecache.h"
 #include <QDebug>
 #include "debugheader.h"
@@ -42,7 +44,19 @@ public:
     KiberTileCache TilesInMemory;
     QByteArray GetTileFromMemoryCache(const RawTile &tile);
     void AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic);
+    QImage GetDecodedTile(const RawTile &tile, const QByteArray &pic);
+    void setDecodedCacheCapacity(const int &value);
     QReadWriteLock kiberCacheLock;
+private:
+    // The decoded tiles are split in stripes by key, each with its own lock, so that
+    // the render thread and the loader threads seldom wait for each other
+    static const int DECODED_CACHE_STRIPES = 8;
+    struct DecodedTiles {
+        QMutex mutex;
+        // Least recently used tiles go first, the cost is the image size in KB
+        QCache<RawTile, QImage> images;
+    };
+    DecodedTiles decodedTiles[DECODED_CACHE_STRIPES];
 };
 }
 #endif // MEMORYCACHE_H
@@ -103,11 +103,14 @@ QByteArray OPMaps::GetImageFrom(const MapType::Types &type, const Point &pos, co
             QEventLoop q;
             QNetworkReply *reply;
             QNetworkRequest qheader;
-            QNetworkAccessManager network;
+            // Each loader thread keeps its network access manager, so that the
+            // connections to the tile servers are kept alive between tiles
+            if (!networkAccess.hasLocalData()) {
+                networkAccess.setLocalData(new QNetworkAccessManager());
+            }
+            QNetworkAccessManager &network = *networkAccess.localData();
             QTimer tT;
             tT.setSingleShot(true);
-            connect(&network, SIGNAL(finished(QNetworkReply *)),
-                    &q, SLOT(quit()));
             connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
             network.setProxy(Proxy);
 #ifdef DEBUG_GMAPS
@@ -194,6 +197,7 @@ QByteArray OPMaps::GetImageFrom(const MapType::Types &type, const Point &pos, co
                 break;
             }
             reply = network.get(qheader);
+            connect(reply, SIGNAL(finished()), &q, SLOT(quit()));
             tT.start(Timeout);
             q.exec();
 
@@ -201,6 +205,8 @@ QByteArray OPMaps::GetImageFrom(const MapType::Types &type, const Point &pos, co
                 errorvars.lock();
                 ++diag.timeouts;
                 errorvars.unlock();
+                reply->abort();
+                delete reply;
                 return ret;
             }
             tT.stop();
@@ -208,11 +214,11 @@ QByteArray OPMaps::GetImageFrom(const MapType::Types &type, const Point &pos, co
                 errorvars.lock();
                 ++diag.networkerrors;
                 errorvars.unlock();
-                reply->deleteLater();
+                delete reply;
                 return ret;
             }
             ret = reply->readAll();
-            reply->deleteLater(); // TODO can't this be global??
+            delete reply;
             if (ret.isEmpty()) {
 #ifdef DEBUG_GMAPS
                 qDebug() << "Invalid Tile";
@@ -255,7 +261,10 @@ bool OPMaps::ExportToGMDB(const QString &file)
 }
 bool OPMaps::ImportFromGMDB(const QString &file)
 {
-    return Cache::Instance()->ImageCache.ExportMapDataToDB(file, Cache::Instance()->ImageCache.GtileCache() + QDir::separator() + "Data.qmdb");
+    bool ret = Cache::Instance()->ImageCache.ExportMapDataToDB(file, Cache::Instance()->ImageCache.GtileCache() + QDir::separator() + "Data.qmdb");
+
+    Cache::Instance()->ImageCache.RefreshTileIndex();
+    return ret;
 }
 
 diagnostics OPMaps::GetDiagnostics()
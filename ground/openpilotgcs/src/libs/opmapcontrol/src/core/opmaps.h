@@ -99,6 +99,7 @@ private:
     static OPMaps *m_pInstance;
     diagnostics diag;
     QMutex errorvars;
+    QThreadStorage<QNetworkAccessManager *> networkAccess;
 protected:
     // MemoryCache TilesInMemory;
 };
@@ -27,13 +27,76 @@
 #include "pureimagecache.h"
 #include <QDateTime>
 #include <QSettings>
+#include <QAtomicInt>
 // #define DEBUG_PUREIMAGECACHE
 namespace core {
-qlonglong PureImageCache::ConnCounter = 0;
 
 PureImageCache::PureImageCache()
 {}
 
+PureImageCache::ThreadConnection::ThreadConnection(const QString &file) :
+    file(file)
+{
+    static QAtomicInt counter;
+
+    name = QString("TileCache%1").arg(counter.fetchAndAddRelaxed(1));
+    QSqlDatabase cn = QSqlDatabase::addDatabase("QSQLITE", name);
+    cn.setDatabaseName(file);
+    cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE;QSQLITE_BUSY_TIMEOUT=2000");
+    if (cn.open()) {
+        QSqlQuery query(cn);
+        // Readers don't block the writer in WAL mode, and the commits don't wait for a full sync
+        query.exec("PRAGMA journal_mode=WAL");
+        query.exec("PRAGMA synchronous=NORMAL");
+    }
+}
+
+PureImageCache::ThreadConnection::~ThreadConnection()
+{
+    {
+        QSqlDatabase cn = QSqlDatabase::database(name, false);
+        cn.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+/**
+ * The connection of the calling thread to the current cache database,
+ * must be called with lock held
+ */
+QSqlDatabase PureImageCache::Connection()
+{
+    QString db = gtilecache + "Data.qmdb";
+
+    if (!connections.hasLocalData() || connections.localData()->file != db) {
+        connections.setLocalData(new ThreadConnection(db));
+    }
+    return QSqlDatabase::database(connections.localData()->name, false);
+}
+
+/**
+ * Read the keys of all cached tiles, must be called with lock held
+ */
+void PureImageCache::LoadTileIndex()
+{
+    QSet<quint64> index;
+    QSqlDatabase cn = Connection();
+
+    if (cn.isOpen()) {
+        QSqlQuery query(cn);
+        // Older databases have no index on the tile coordinates
+        query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+        query.setForwardOnly(true);
+        query.exec("SELECT X, Y, Zoom, Type FROM Tiles");
+        while (query.next()) {
+            index.insert(TileKey((MapType::Types)query.value(3).toInt(), Point(query.value(0).toInt(), query.value(1).toInt()), query.value(2).toInt()));
+        }
+    }
+    indexLock.lockForWrite();
+    tileIndex = index;
+    indexLock.unlock();
+}
+
 void PureImageCache::setGtileCache(const QString &value)
 {
     lock.lockForWrite();
@@ -54,7 +117,13 @@ void PureImageCache::setGtileCache(const QString &value)
             CreateEmptyDB(db);
         }
     }
+    LoadTileIndex();
     lock.unlock();
+
+    // Packages dropped in the cache directory are used as well
+    foreach(QString package, QDir(value).entryList(QStringList("*.optiles"), QDir::Files)) {
+        AddTilePackage(value + package);
+    }
 }
 QString PureImageCache::GtileCache()
 {
@@ -105,6 +174,7 @@ bool PureImageCache::CreateEmptyDB(const QString &file)
         db.close();
         return false;
     }
+    query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
     query.exec("CREATE TABLE IF NOT EXISTS TilesData (id INTEGER NOT NULL PRIMARY KEY CONSTRAINT fk_Tiles_id REFERENCES Tiles(id) ON DELETE CASCADE, Tile BLOB NULL)");
     if (query.numRowsAffected() == -1) {
 #ifdef DEBUG_PUREIMAGECACHE
@@ -160,126 +230,197 @@ bool PureImageCache::CreateEmptyDB(const QString &file)
 }
 bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type, const Point &pos, const int &zoom)
 {
+    CacheItemQueue item(type, pos, tile, zoom);
+    QList<CacheItemQueue *> tiles;
+
+    tiles.append(&item);
+    return PutImagesToCache(tiles);
+}
+
+/**
+ * Write a batch of tiles in one transaction, the tiles already cached are skipped
+ */
+bool PureImageCache::PutImagesToCache(QList<CacheItemQueue *> tiles)
+{
+    lock.lockForRead();
     if (gtilecache.isEmpty() | gtilecache.isNull()) {
+        lock.unlock();
         return false;
     }
-    lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-    qDebug() << "PutImageToCache Start:"; // <<pos;
+    qDebug() << "PutImagesToCache Start:" << tiles.count();
 #endif // DEBUG_PUREIMAGECACHE
-    Mcounter.lock();
-    qlonglong id = ++ConnCounter;
-    Mcounter.unlock();
+    QSqlDatabase cn = Connection();
+    if (!cn.isOpen() || !cn.transaction()) {
+        lock.unlock();
+        return false;
+    }
+    QList<quint64> added;
     {
-        QSqlDatabase cn;
-        cn = QSqlDatabase::addDatabase("QSQLITE", QString::number(id));
-        QString db = gtilecache + "Data.qmdb";
-        cn.setDatabaseName(db);
-        cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-        if (cn.open()) {
-            {
-                QSqlQuery query(cn);
-                query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                query.addBindValue(pos.X());
-                query.addBindValue(pos.Y());
-                query.addBindValue(zoom);
-
-                query.addBindValue((int)type);
-                query.addBindValue(QDateTime::currentDateTime().toString());
-                query.exec();
+        QSqlQuery tileQuery(cn);
+        QSqlQuery dataQuery(cn);
+        tileQuery.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+        dataQuery.prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+        QString date = QDateTime::currentDateTime().toString();
+        foreach(CacheItemQueue * tile, tiles) {
+            quint64 key = TileKey(tile->GetMapType(), tile->GetPosition(), tile->GetZoom());
+            indexLock.lockForRead();
+            bool cached = tileIndex.contains(key);
+            indexLock.unlock();
+            if (cached || added.contains(key)) {
+                continue;
+            }
+            tileQuery.addBindValue(tile->GetPosition().X());
+            tileQuery.addBindValue(tile->GetPosition().Y());
+            tileQuery.addBindValue(tile->GetZoom());
+            tileQuery.addBindValue((int)tile->GetMapType());
+            tileQuery.addBindValue(date);
+            if (!tileQuery.exec()) {
+                continue;
             }
-            {
-                QSqlQuery query(cn);
-                query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                query.addBindValue(tile);
-                query.exec();
+            dataQuery.addBindValue(tileQuery.lastInsertId());
+            dataQuery.addBindValue(tile->GetImg());
+            if (dataQuery.exec()) {
+                added.append(key);
             }
-            cn.close();
         }
     }
-    QSqlDatabase::removeDatabase(QString::number(id));
+    bool ret = cn.commit();
+    if (ret) {
+        indexLock.lockForWrite();
+        foreach(quint64 key, added) {
+            tileIndex.insert(key);
+        }
+        indexLock.unlock();
+    } else {
+        cn.rollback();
+    }
     lock.unlock();
-    return true;
+    return ret;
 }
 QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
 {
-    lock.lockForRead();
     QByteArray ar;
+
+    packagesLock.lockForRead();
+    foreach(const TilePackage * package, packages) {
+        ar = package->GetTile(type, pos, zoom);
+        if (!ar.isEmpty()) {
+            break;
+        }
+    }
+    packagesLock.unlock();
+    if (!ar.isEmpty()) {
+        return ar;
+    }
+
+    indexLock.lockForRead();
+    bool cached = tileIndex.contains(TileKey(type, pos, zoom));
+    indexLock.unlock();
+    if (!cached) {
+        return ar;
+    }
+    lock.lockForRead();
     if (gtilecache.isEmpty() | gtilecache.isNull()) {
+        lock.unlock();
         return ar;
     }
-    QString dir  = gtilecache;
-    Mcounter.lock();
-    qlonglong id = ++ConnCounter;
-    Mcounter.unlock();
 #ifdef DEBUG_PUREIMAGECACHE
-    qDebug() << "Cache dir=" << dir << " Try to GET:" << pos.X() + "," + pos.Y();
+    qDebug() << "Cache dir=" << gtilecache << " Try to GET:" << pos.X() + "," + pos.Y();
 #endif // DEBUG_PUREIMAGECACHE
 
-    {
-        QString db = dir + "Data.qmdb";
-        {
-            QSqlDatabase cn;
-
-            cn = QSqlDatabase::addDatabase("QSQLITE", QString::number(id));
-
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if (cn.open()) {
-                {
-                    QSqlQuery query(cn);
-                    query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int)type));
-                    query.next();
-                    if (query.isValid()) {
-                        ar = query.value(0).toByteArray();
-                    }
-                }
-                cn.close();
-            }
+    QSqlDatabase cn = Connection();
+    if (cn.isOpen()) {
+        QSqlQuery query(cn);
+        query.setForwardOnly(true);
+        query.prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        query.addBindValue(pos.X());
+        query.addBindValue(pos.Y());
+        query.addBindValue(zoom);
+        query.addBindValue((int)type);
+        if (query.exec() && query.next()) {
+            ar = query.value(0).toByteArray();
         }
     }
-    QSqlDatabase::removeDatabase(QString::number(id));
     lock.unlock();
     return ar;
 }
 void PureImageCache::deleteOlderTiles(int const & days)
 {
+    lock.lockForRead();
     if (gtilecache.isEmpty() | gtilecache.isNull()) {
+        lock.unlock();
         return;
     }
     QList<long> add;
-    bool ret    = true;
-    QString dir = gtilecache;
-    {
-        QString db = dir + "Data.qmdb";
-        ret = QFileInfo(db).exists();
-        if (ret) {
-            QSqlDatabase cn;
-            Mcounter.lock();
-            qlonglong id = ++ConnCounter;
-            Mcounter.unlock();
-            cn = QSqlDatabase::addDatabase("QSQLITE", QString::number(id));
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if (cn.open()) {
-                {
-                    QSqlQuery query(cn);
-                    query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
-                    while (query.next()) {
-                        if (QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime()) > days) {
-                            add.append(query.value(0).toLongLong());
-                        }
-                    }
-                    foreach(long i, add) {
-                        query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
-                    }
-                }
-
-                cn.close();
+    QSqlDatabase cn = Connection();
+    if (cn.isOpen()) {
+        QSqlQuery query(cn);
+        query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
+        while (query.next()) {
+            if (QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime()) > days) {
+                add.append(query.value(0).toLongLong());
             }
-            QSqlDatabase::removeDatabase(QString::number(id));
         }
+        cn.transaction();
+        query.prepare("DELETE FROM Tiles WHERE id = ?");
+        foreach(long i, add) {
+            query.addBindValue((qlonglong)i);
+            query.exec();
+        }
+        cn.commit();
+    }
+    if (!add.isEmpty()) {
+        LoadTileIndex();
     }
+    lock.unlock();
+}
+/**
+ * Use the tiles of a package, opening the same file twice does nothing
+ */
+bool PureImageCache::AddTilePackage(const QString &file)
+{
+    QString path = QFileInfo(file).canonicalFilePath();
+    QWriteLocker locker(&packagesLock);
+
+    foreach(const TilePackage * package, packages) {
+        if (QFileInfo(package->FileName()).canonicalFilePath() == path) {
+            return true;
+        }
+    }
+    TilePackage *package = new TilePackage();
+    if (!package->Open(path)) {
+        delete package;
+        return false;
+    }
+    packages.append(package);
+#ifdef DEBUG_PUREIMAGECACHE
+    qDebug() << "Tile package" << path << "with" << package->Count() << "tiles";
+#endif // DEBUG_PUREIMAGECACHE
+    return true;
+}
+/**
+ * Copy a package into the cache directory and use it
+ */
+bool PureImageCache::ImportTilePackage(const QString &file)
+{
+    lock.lockForRead();
+    QString dest = gtilecache + QFileInfo(file).fileName();
+    lock.unlock();
+
+    if (QFileInfo(file).canonicalFilePath() != QFileInfo(dest).canonicalFilePath()) {
+        QFile::remove(dest);
+        if (!QFile::copy(file, dest)) {
+            return false;
+        }
+    }
+    return AddTilePackage(dest);
+}
+void PureImageCache::RefreshTileIndex()
+{
+    lock.lockForRead();
+    LoadTileIndex();
+    lock.unlock();
 }
 // PureImageCache::ExportMapDataToDB("C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data.qmdb","C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data2.qmdb");
 bool PureImageCache::ExportMapDataToDB(QString sourceFile, QString destFile)
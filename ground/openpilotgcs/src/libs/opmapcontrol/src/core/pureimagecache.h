@@ -42,22 +42,52 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QSet>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
+#include "tilepackage.h"
 namespace core {
 class PureImageCache {
 public:
     PureImageCache();
     static bool CreateEmptyDB(const QString &file);
     bool PutImageToCache(const QByteArray &tile, const MapType::Types &type, const core::Point &pos, const int &zoom);
+    bool PutImagesToCache(QList<CacheItemQueue *> tiles);
     QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
     QString GtileCache();
     void setGtileCache(const QString &value);
     static bool ExportMapDataToDB(QString sourceFile, QString destFile);
     void deleteOlderTiles(int const & days);
+    void RefreshTileIndex();
+    bool AddTilePackage(const QString &file);
+    bool ImportTilePackage(const QString &file);
 private:
+    // A connection stays open for the life of the thread using it
+    class ThreadConnection {
+public:
+        ThreadConnection(const QString &file);
+        ~ThreadConnection();
+        QString name;
+        QString file;
+    };
+    QSqlDatabase Connection();
+    void LoadTileIndex();
+    static quint64 TileKey(MapType::Types type, const core::Point &pos, int zoom)
+    {
+        return ((quint64)((quint32)pos.X() & 0x7FFFFF) << 41) | ((quint64)((quint32)pos.Y() & 0x7FFFFF) << 18)
+               | ((quint64)(zoom & 0x1F) << 13) | ((quint64)type & 0x1FFF);
+    }
+
     QString gtilecache;
-    QMutex Mcounter;
     QReadWriteLock lock;
-    static qlonglong ConnCounter;
+    QThreadStorage<ThreadConnection *> connections;
+    // Keys of the tiles in the database, misses are answered without a query
+    QSet<quint64> tileIndex;
+    QReadWriteLock indexLock;
+    // Opened packages are never closed, the tiles read from them point
+    // into their mapped file and may be held by the memory cache
+    QList<TilePackage *> packages;
+    QReadWriteLock packagesLock;
 };
 }
 #endif // PUREIMAGECACHE_H
@@ -71,20 +71,22 @@ void TileCacheQueue::run()
     qDebug() << "Cache Engine Start";
 #endif // DEBUG_TILECACHEQUEUE
     while (true) {
-        CacheItemQueue *task;
+        QList<CacheItemQueue *> tasks;
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug() << "Cache";
 #endif // DEBUG_TILECACHEQUEUE
-        if (tileCacheQueue.count() > 0) {
-            mutex.lock();
-            task = tileCacheQueue.dequeue();
-            mutex.unlock();
+        mutex.lock();
+        while (tileCacheQueue.count() > 0 && tasks.count() < MAX_BATCH_TILES) {
+            tasks.append(tileCacheQueue.dequeue());
+        }
+        mutex.unlock();
+        if (tasks.count() > 0) {
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug() << "Cache engine Put:" << task->GetPosition().X() << "," << task->GetPosition().Y();
+            qDebug() << "Cache engine Put:" << tasks.count() << "tiles";
 #endif // DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(), task->GetMapType(), task->GetPosition(), task->GetZoom());
-            usleep(44);
-            delete task;
+            // All the tiles waiting go in one transaction, through the connection of this thread
+            Cache::Instance()->ImageCache.PutImagesToCache(tasks);
+            qDeleteAll(tasks);
         } else {
             qDebug() << "Cache engine BEGIN WAIT";
             waitmutex.lock();
@@ -49,6 +49,8 @@ public:
 protected:
     QQueue<CacheItemQueue *> tileCacheQueue;
 private:
+    // Tiles written per transaction
+    static const int MAX_BATCH_TILES = 64;
     void run();
     QMutex mutex;
     QMutex waitmutex;
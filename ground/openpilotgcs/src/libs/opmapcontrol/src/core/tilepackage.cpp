@@ -0,0 +1,221 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tilepackage.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Single file tile packages for offline use
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "tilepackage.h"
+#include <QtEndian>
+#include <QDebug>
+
+// #define DEBUG_TILEPACKAGE
+namespace core {
+const char TilePackage::MAGIC[8] = { 'O', 'P', 'T', 'I', 'L', 'E', 'S', 0 };
+
+TilePackage::TilePackage() : data(0), size(0), index(0), count(0)
+{}
+
+TilePackage::~TilePackage()
+{
+    if (data) {
+        file.unmap((uchar *)data);
+    }
+    file.close();
+}
+
+bool TilePackage::Open(const QString &fileName)
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    size = file.size();
+    if (size < HEADER_SIZE) {
+        file.close();
+        return false;
+    }
+    data = file.map(0, size);
+    if (!data) {
+        file.close();
+        return false;
+    }
+
+    quint32 version     = qFromLittleEndian<quint32>(data + 8);
+    quint64 indexOffset = qFromLittleEndian<quint64>(data + 16);
+    count = qFromLittleEndian<quint32>(data + 12);
+    if (memcmp(data, MAGIC, sizeof(MAGIC)) || version != VERSION
+        || indexOffset < (quint64)HEADER_SIZE || indexOffset + (quint64)count * INDEX_ENTRY_SIZE > (quint64)size) {
+        qDebug() << "TilePackage - invalid package" << fileName;
+        file.unmap((uchar *)data);
+        file.close();
+        data  = 0;
+        count = 0;
+        return false;
+    }
+    index = data + indexOffset;
+#ifdef DEBUG_TILEPACKAGE
+    qDebug() << "TilePackage - opened" << fileName << count << "tiles";
+#endif // DEBUG_TILEPACKAGE
+    return true;
+}
+
+QByteArray TilePackage::GetTile(MapType::Types type, const core::Point &pos, int zoom) const
+{
+    quint64 key = TileKey(type, pos, zoom);
+    quint32 low = 0;
+    quint32 high = count;
+
+    // Binary search of the sorted index
+    while (low < high) {
+        quint32 middle = low + (high - low) / 2;
+        const uchar *entry = index + (qint64)middle * INDEX_ENTRY_SIZE;
+        quint64 entryKey   = qFromLittleEndian<quint64>(entry);
+        if (entryKey < key) {
+            low = middle + 1;
+        } else if (entryKey > key) {
+            high = middle;
+        } else {
+            quint64 offset = qFromLittleEndian<quint64>(entry + 8);
+            quint32 length = qFromLittleEndian<quint32>(entry + 16);
+            if (offset + length > (quint64)size) {
+                return QByteArray();
+            }
+            return QByteArray::fromRawData((const char *)data + offset, length);
+        }
+    }
+    return QByteArray();
+}
+
+/**
+ * Map type, zoom, then x and y interleaved
+ */
+quint64 TilePackage::TileKey(MapType::Types type, const core::Point &pos, int zoom)
+{
+    quint64 morton = 0;
+    quint32 x = (quint32)pos.X() & 0x7FFFFF;
+    quint32 y = (quint32)pos.Y() & 0x7FFFFF;
+
+    for (int bit = 0; bit < 23; bit++) {
+        morton |= (quint64)((x >> bit) & 1) << (2 * bit + 1);
+        morton |= (quint64)((y >> bit) & 1) << (2 * bit);
+    }
+    return ((quint64)type & 0x1FFF) << 51 | ((quint64)(zoom & 0x1F) << 46) | morton;
+}
+
+TilePackageWriter::TilePackageWriter()
+{}
+
+TilePackageWriter::~TilePackageWriter()
+{
+    Abort();
+}
+
+bool TilePackageWriter::Create(const QString &fileName)
+{
+    QMutexLocker locker(&mutex);
+
+    this->fileName = fileName;
+    entries.clear();
+    file.setFileName(fileName + ".part");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    // The header is written by Finish()
+    QByteArray header(TilePackage::HEADER_SIZE, 0);
+    return file.write(header) == header.size();
+}
+
+/**
+ * Append a tile, the tiles already in the package are skipped
+ */
+bool TilePackageWriter::AddTile(MapType::Types type, const core::Point &pos, int zoom, const QByteArray &tile)
+{
+    QMutexLocker locker(&mutex);
+
+    if (!file.isOpen() || tile.isEmpty()) {
+        return false;
+    }
+    quint64 key = TilePackage::TileKey(type, pos, zoom);
+    if (entries.contains(key)) {
+        return true;
+    }
+    Entry entry;
+    entry.offset = file.pos();
+    entry.size   = tile.size();
+    if (file.write(tile) != tile.size()) {
+        return false;
+    }
+    entries.insert(key, entry);
+    return true;
+}
+
+bool TilePackageWriter::Finish()
+{
+    QMutexLocker locker(&mutex);
+
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    // Index after the data, aligned on 8 bytes
+    qint64 indexOffset = (file.pos() + 7) & ~(qint64)7;
+    QByteArray buffer(indexOffset - file.pos() + entries.count() * TilePackage::INDEX_ENTRY_SIZE, 0);
+    uchar *entry = (uchar *)buffer.data() + (indexOffset - file.pos());
+    for (QMap<quint64, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        qToLittleEndian<quint64>(it.key(), entry);
+        qToLittleEndian<quint64>(it->offset, entry + 8);
+        qToLittleEndian<quint32>(it->size, entry + 16);
+        entry += TilePackage::INDEX_ENTRY_SIZE;
+    }
+
+    uchar header[TilePackage::HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, TilePackage::MAGIC, sizeof(TilePackage::MAGIC));
+    qToLittleEndian<quint32>(TilePackage::VERSION, header + 8);
+    qToLittleEndian<quint32>(entries.count(), header + 12);
+    qToLittleEndian<quint64>(indexOffset, header + 16);
+
+    bool ret = file.write(buffer) == buffer.size() && file.seek(0)
+               && file.write((const char *)header, sizeof(header)) == sizeof(header);
+    file.close();
+    if (ret) {
+        QFile::remove(fileName);
+        ret = file.rename(fileName);
+    } else {
+        file.remove();
+    }
+    entries.clear();
+    return ret;
+}
+
+void TilePackageWriter::Abort()
+{
+    QMutexLocker locker(&mutex);
+
+    if (file.isOpen()) {
+        file.close();
+        file.remove();
+    }
+    entries.clear();
+}
+}
@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tilepackage.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Single file tile packages for offline use
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TILEPACKAGE_H
+#define TILEPACKAGE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include "maptype.h"
+#include "point.h"
+
+namespace core {
+/**
+ * A tile package holds the tiles of an area in a single file read through memory mapping.
+ *
+ * Layout, all values little endian:
+ *   header: "OPTILES" magic and a 0 (8 bytes), version (4), tile count (4), index offset (8), reserved (8)
+ *   tile data, one image after the other
+ *   index at the index offset, 8 bytes aligned: per tile its key (8), data offset (8), size (4), reserved (4)
+ * The index is sorted by key; a key orders the tiles by map type, zoom and then along a Morton
+ * curve, so the tiles that are close on the map are close in the index.
+ */
+class TilePackage {
+public:
+    TilePackage();
+    ~TilePackage();
+    bool Open(const QString &fileName);
+    QString FileName() const
+    {
+        return file.fileName();
+    }
+    quint32 Count() const
+    {
+        return count;
+    }
+    /**
+     * The tile data points directly to the mapped file, it stays valid while the package is open
+     */
+    QByteArray GetTile(MapType::Types type, const core::Point &pos, int zoom) const;
+
+    static quint64 TileKey(MapType::Types type, const core::Point &pos, int zoom);
+
+    static const char MAGIC[8];
+    static const quint32 VERSION     = 1;
+    static const int HEADER_SIZE     = 32;
+    static const int INDEX_ENTRY_SIZE = 24;
+
+private:
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    const uchar *index;
+    quint32 count;
+};
+
+/**
+ * Builds a tile package, the tiles can be added from several threads.
+ * The package is written to a temporary file renamed when finished.
+ */
+class TilePackageWriter {
+public:
+    TilePackageWriter();
+    ~TilePackageWriter();
+    bool Create(const QString &fileName);
+    bool AddTile(MapType::Types type, const core::Point &pos, int zoom, const QByteArray &tile);
+    bool Finish();
+    void Abort();
+
+private:
+    struct Entry {
+        quint64 offset;
+        quint32 size;
+    };
+    QString fileName;
+    QFile file;
+    QMutex mutex;
+    QMap<quint64, Entry> entries;
+};
+}
+#endif // TILEPACKAGE_H
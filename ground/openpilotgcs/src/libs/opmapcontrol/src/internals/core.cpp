@@ -66,20 +66,55 @@ void Core::run()
     bool last = false;
 
     LoadTask task;
+    int discarded = 0;
 
+    MtileDrawingList.lock();
     MtileLoadQueue.lock();
     {
-        if (tileLoadQueue.count() > 0) {
-            task = tileLoadQueue.dequeue();
-            {
-                last = (tileLoadQueue.count() == 0);
-#ifdef DEBUG_CORE
-                qDebug() << "TileLoadQueue: " << tileLoadQueue.count() << " Point:" << task.Pos.ToString() << " ID=" << debug;;
-#endif // DEBUG_CORE
+        // Load the tile nearest to the view center first, the tasks of the tiles
+        // no longer in the drawing list are dropped without being loaded
+        int best = -1;
+        int bestDistance = 0;
+        for (int i = tileLoadQueue.count() - 1; i >= 0; i--) {
+            const LoadTask &t = tileLoadQueue.at(i);
+            if (t.Zoom != Zoom() || !tileDrawingList.contains(t.Pos)) {
+                tileLoadQueue.removeAt(i);
+                ++discarded;
+                if (best != -1) {
+                    --best;
+                }
+                continue;
+            }
+            int dx = t.Pos.X() - centerTileXYLocation.X();
+            int dy = t.Pos.Y() - centerTileXYLocation.Y();
+            int distance = dx * dx + dy * dy;
+            // on a tie the oldest task wins
+            if (best == -1 || distance <= bestDistance) {
+                best = i;
+                bestDistance = distance;
             }
         }
+        if (best != -1) {
+            task = tileLoadQueue.takeAt(best);
+        }
+        last = (tileLoadQueue.count() == 0);
+#ifdef DEBUG_CORE
+        qDebug() << "TileLoadQueue: " << tileLoadQueue.count() << " Point:" << task.Pos.ToString() << " discarded:" << discarded << " ID=" << debug;;
+#endif // DEBUG_CORE
     }
     MtileLoadQueue.unlock();
+    MtileDrawingList.unlock();
+
+    if (discarded > 0) {
+        MtileToload.lock();
+        tilesToload -= discarded;
+        MtileToload.unlock();
+        if (!task.HasValue() && last) {
+            // the dropped task was the last one
+            LoadComplete();
+            emit OnTilesStillToLoad(tilesToload < 0 ? 0 : tilesToload);
+        }
+    }
 
     if (task.HasValue()) {
         if (loaderLimit.tryAcquire(1, OPMaps::Instance()->Timeout)) {
@@ -128,11 +163,14 @@ void Core::run()
                                     Moverlays.lock();
                                     {
                                         t->Overlays.append(img);
+                                        t->OverlayTypes.append(tl);
 #ifdef DEBUG_CORE
                                         qDebug() << "Core::run append img:" << img.length() << " to tile:" << t->GetPos().ToString() << " now has " << t->Overlays.count() << " overlays" << " ID=" << debug;
 #endif // DEBUG_CORE
                                     }
                                     Moverlays.unlock();
+                                    // decode now on the loader thread, the render thread finds it cached
+                                    OPMaps::Instance()->GetDecodedTile(RawTile(tl, task.Pos, task.Zoom), img);
 
                                     break;
                                 } else if (OPMaps::Instance()->RetryLoadTile > 0) {
@@ -173,21 +211,7 @@ void Core::run()
                 {
                     // last buddy cleans stuff ;}
                     if (last) {
-                        OPMaps::Instance()->kiberCacheLock.lockForWrite();
-                        OPMaps::Instance()->TilesInMemory.RemoveMemoryOverload();
-                        OPMaps::Instance()->kiberCacheLock.unlock();
-
-                        MtileDrawingList.lock();
-                        {
-                            Matrix.ClearPointsNotIn(tileDrawingList);
-                        }
-                        MtileDrawingList.unlock();
-
-
-                        emit OnTileLoadComplete();
-
-
-                        emit OnNeedInvalidation();
+                        LoadComplete();
                     }
                 }
             }
@@ -202,6 +226,24 @@ void Core::run()
     --runningThreads;
     MrunningThreads.unlock();
 }
+void Core::LoadComplete()
+{
+    OPMaps::Instance()->kiberCacheLock.lockForWrite();
+    OPMaps::Instance()->TilesInMemory.RemoveMemoryOverload();
+    OPMaps::Instance()->kiberCacheLock.unlock();
+
+    MtileDrawingList.lock();
+    {
+        Matrix.ClearPointsNotIn(tileDrawingList);
+    }
+    MtileDrawingList.unlock();
+
+
+    emit OnTileLoadComplete();
+
+
+    emit OnNeedInvalidation();
+}
 diagnostics Core::GetDiagnostics()
 {
     MrunningThreads.lock();
@@ -557,6 +599,7 @@ void Core::UpdateBounds()
     MtileDrawingList.lock();
     {
         FindTilesAround(tileDrawingList);
+        AddPrefetchTiles(tileDrawingList);
 
 #ifdef DEBUG_CORE
         qDebug() << "OnTileLoadStart: " << tileDrawingList.count() << " tiles to load at zoom " << Zoom() << ", time: " << QDateTime::currentDateTime().date();
@@ -615,6 +658,39 @@ void Core::FindTilesAround(QList<Point> &list)
         }
     }
 }
+/**
+ * Add the ring of tiles just beyond the view on the sides the map is moving to,
+ * the map follows the UAV so this also prefetches in its direction of travel
+ */
+void Core::AddPrefetchTiles(QList<Point> &list)
+{
+    int dx = centerTileXYLocation.X() - prefetchCenter.X();
+    int dy = centerTileXYLocation.Y() - prefetchCenter.Y();
+
+    dx = (dx > 0) - (dx < 0);
+    dy = (dy > 0) - (dy < 0);
+    prefetchCenter = centerTileXYLocation;
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    int ringX = sizeOfMapArea.Width() + 1;
+    int ringY = sizeOfMapArea.Height() + 1;
+    for (int i = -ringX; i <= ringX; i++) {
+        for (int j = -ringY; j <= ringY; j++) {
+            bool onRing = (dx != 0 && i == dx * ringX) || (dy != 0 && j == dy * ringY);
+            if (!onRing) {
+                continue;
+            }
+            Point p(centerTileXYLocation.X() + i, centerTileXYLocation.Y() + j);
+            if (p.X() >= minOfTiles.Width() && p.Y() >= minOfTiles.Height() && p.X() <= maxOfTiles.Width() && p.Y() <= maxOfTiles.Height()) {
+                if (!list.contains(p)) {
+                    list.append(p);
+                }
+            }
+        }
+    }
+}
 void Core::UpdateGroundResolution()
 {
     double rez = Projection()->GetGroundResolution(Zoom(), CurrentPosition().Lat());
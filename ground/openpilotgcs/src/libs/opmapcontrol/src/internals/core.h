@@ -294,6 +294,8 @@ public:
 
     void FindTilesAround(QList<core::Point> &list);
 
+    void AddPrefetchTiles(QList<core::Point> &list);
+
     void UpdateGroundResolution();
 
     TileMatrix Matrix;
@@ -319,11 +321,14 @@ signals:
 private:
 
     void keepInBounds();
+    void LoadComplete();
     PointLatLng currentPosition;
     core::Point currentPositionPixel;
     core::Point renderOffset;
     core::Point centerTileXYLocation;
     core::Point centerTileXYLocationLast;
+    // view center at the last UpdateBounds(), gives the direction to prefetch
+    core::Point prefetchCenter;
     core::Point dragPoint;
     Rectangle tileRect;
     core::Point mouseDown;
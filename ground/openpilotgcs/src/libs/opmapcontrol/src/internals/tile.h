@@ -30,6 +30,7 @@
 #include "QList"
 #include <QImage>
 #include "../core/point.h"
+#include "../core/maptype.h"
 #include <QMutex>
 #include <QDebug>
 #include "debugheader.h"
@@ -67,6 +68,8 @@ public:
         return !(zoom == 0);
     }
     QList<QByteArray> Overlays;
+    // Map type of each overlay
+    QList<MapType::Types> OverlayTypes;
 protected:
 
     QMutex mutex;
@@ -173,6 +173,17 @@ public:
         core::Cache::Instance()->ImageCache.deleteOlderTiles(days);
     }
 
+    /**
+     * @brief  Copies a tile package (see core::TilePackage) to the cache location and reads tiles from it
+     *
+     * @param file the package
+     * @return true if the package could be used
+     */
+    bool ImportTilePackage(QString const & file)
+    {
+        return core::Cache::Instance()->ImageCache.ImportTilePackage(file);
+    }
+
     /**
      * @brief  Exports tiles from one DB to another. Only new tiles are added.
      *
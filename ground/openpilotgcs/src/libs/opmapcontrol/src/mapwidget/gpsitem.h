@@ -39,7 +39,6 @@
 #include <QtSvg/QSvgRenderer>
 #include "opmapwidget.h"
 #include "trailitem.h"
-#include "traillineitem.h"
 namespace mapcontrol {
 class WayPointItem;
 class OPMapWidget;
@@ -242,9 +241,7 @@ private:
     QPixmap pic;
     core::Point localposition;
     OPMapWidget *mapwidget;
-    QGraphicsItemGroup *trail;
-    QGraphicsItemGroup *trailLine;
-    internals::PointLatLng lasttrailline;
+    TrailItem *trail;
     QTime timer;
     bool showtrail;
     bool showtrailline;
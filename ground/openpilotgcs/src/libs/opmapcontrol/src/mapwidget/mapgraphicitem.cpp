@@ -317,13 +317,19 @@ void MapGraphicItem::DrawMap2D(QPainter *painter)
                         // render tile
                         // lock(t.Overlays)
                         if (t != 0) {
-                            foreach(QByteArray img, t->Overlays) {
+                            for (int k = 0; k < t->Overlays.count(); k++) {
+                                const QByteArray &img = t->Overlays.at(k);
                                 if (img.count() != 0) {
                                     if (!found) {
                                         found = true;
                                     }
                                     {
-                                        painter->drawPixmap(core->tileRect.X(), core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(), PureImageProxy::FromStream(img));
+                                        QRect target(core->tileRect.X(), core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height());
+                                        if (k < t->OverlayTypes.count()) {
+                                            painter->drawImage(target, OPMaps::Instance()->GetDecodedTile(RawTile(t->OverlayTypes.at(k), t->GetPos(), t->GetZoom()), img));
+                                        } else {
+                                            painter->drawPixmap(target, PureImageProxy::FromStream(img));
+                                        }
                                     }
                                 }
                             }
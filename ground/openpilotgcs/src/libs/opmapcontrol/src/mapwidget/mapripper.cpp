@@ -25,10 +25,39 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 #include "mapripper.h"
+#include <QThreadPool>
 namespace mapcontrol {
-MapRipper::MapRipper(internals::Core *core, const internals::RectLatLng & rect) : sleep(100), cancel(false), progressForm(0), core(core), yesToAll(false)
+/**
+ * Fetches tiles until there is none left, several of them run in parallel
+ */
+class MapRipper::Worker : public QRunnable {
+public:
+    Worker(MapRipper *ripper, QVector<core::MapType::Types> const & types) : ripper(ripper), types(types) {}
+    void run()
+    {
+        int index;
+
+        while (ripper->nextTile(index)) {
+            ripper->ripTile(ripper->points.at(index), types);
+        }
+    }
+private:
+    MapRipper *ripper;
+    QVector<core::MapType::Types> types;
+};
+
+MapRipper::MapRipper(internals::Core *core, const internals::RectLatLng & rect, QString const & packageFile) : sleep(100), cancel(false), progressForm(0), core(core), yesToAll(false),
+    nextPoint(0), done(0), nextRequest(0), package(0), packageFile(packageFile)
 {
     if (!rect.IsEmpty()) {
+        if (!packageFile.isEmpty()) {
+            package = new core::TilePackageWriter();
+            if (!package->Create(packageFile)) {
+                QMessageBox::warning(new QWidget(), tr("Tile package"), tr("Unable to create the tile package %1").arg(packageFile));
+                delete package;
+                package = 0;
+            }
+        }
         type    = core->GetMapType();
         progressForm = new MapRipForm;
         connect(progressForm, SIGNAL(cancelRequest()), this, SLOT(stopFetching()));
@@ -76,60 +105,108 @@ void MapRipper::finish()
             points   = core->Projection()->GetAreaTileList(area, zoom, 0);
             this->start();
         } else {
-            progressForm->close();
-            delete progressForm;
-            this->deleteLater();
+            close();
         }
     } else {
         yesToAll = false;
-        progressForm->close();
-        delete progressForm;
-        this->deleteLater();
+        close();
     }
 }
+MapRipper::~MapRipper()
+{
+    delete package;
+}
+void MapRipper::close()
+{
+    progressForm->close();
+    delete progressForm;
+    if (package) {
+        // Keep what was ripped even when cancelled, and use it right away
+        if (package->Finish()) {
+            core::Cache::Instance()->ImageCache.AddTilePackage(packageFile);
+        }
+    }
+    this->deleteLater();
+}
 
 
 void MapRipper::run()
 {
-    int countOk   = 0;
-    bool goodtile = false;
-
     // Stuff.Shuffle<Point>(ref list);
     QVector<core::MapType::Types> types = OPMaps::Instance()->GetAllLayersOfType(type);
-    int all = points.count();
-    for (int i = 0; i < all; i++) {
-        emit numberOfTilesChanged(all, i + 1);
-        if (cancel) {
-            break;
-        }
 
-        core::Point p = points[i];
-        {
-            // qDebug()<<"offline fetching:"<<p.ToString();
-            foreach(core::MapType::Types type, types) {
-                emit providerChanged(core::MapType::StrByType(type), zoom);
-                QByteArray img = OPMaps::Instance()->GetImageFrom(type, p, zoom);
+    nextPoint   = 0;
+    done        = 0;
+    nextRequest = 0;
+    clock.start();
+    emit providerChanged(core::MapType::StrByType(type), zoom);
 
-                if (img.length() != 0) {
-                    goodtile = true;
-                    img = NULL;
-                } else {
-                    goodtile = false;
-                }
-            }
-            if (goodtile) {
-                countOk++;
-            } else {
-                i--;
+    QThreadPool pool;
+    pool.setMaxThreadCount(CONNECTIONS);
+    for (int i = 0; i < CONNECTIONS; i++) {
+        pool.start(new Worker(this, types));
+    }
+    pool.waitForDone();
+}
+
+bool MapRipper::nextTile(int &index)
+{
+    QMutexLocker locker(&mutex);
+
+    if (cancel || nextPoint >= points.count()) {
+        return false;
+    }
+    index = nextPoint++;
+    return true;
+}
+
+/**
+ * Rate limit of the requests to the servers, shared by all connections
+ */
+void MapRipper::waitForTurn()
+{
+    qint64 wait;
+    {
+        QMutexLocker locker(&mutex);
+        qint64 now = clock.elapsed();
+        if (nextRequest < now) {
+            nextRequest = now;
+        }
+        wait = nextRequest - now;
+        nextRequest += sleep;
+    }
+    if (wait > 0) {
+        QThread::msleep(wait);
+    }
+}
+
+void MapRipper::ripTile(core::Point const & p, QVector<core::MapType::Types> const & types)
+{
+    // qDebug()<<"offline fetching:"<<p.ToString();
+    foreach(core::MapType::Types type, types) {
+        for (int retry = 0; retry < RETRIES && !cancel; retry++) {
+            if (retry > 0) {
                 QThread::msleep(1000);
-                continue;
+            }
+            waitForTurn();
+            QByteArray img = OPMaps::Instance()->GetImageFrom(type, p, zoom);
+            if (img.length() != 0) {
+                if (package) {
+                    package->AddTile(type, p, zoom, img);
+                }
+                break;
             }
         }
-        emit percentageChanged((int)((i + 1) * 100 / all)); // , i+1);
-        // worker.ReportProgress((int) ((i+1)*100/all), i+1);
+    }
 
-        QThread::msleep(sleep);
+    int all = points.count();
+    int count;
+    {
+        QMutexLocker locker(&mutex);
+        count = ++done;
     }
+    emit numberOfTilesChanged(all, count);
+    emit percentageChanged((int)(count * 100 / all));
 }
 
 void MapRipper::stopFetching()
@@ -32,13 +32,27 @@
 #include "mapripform.h"
 #include <QObject>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include "../core/tilepackage.h"
 namespace mapcontrol {
 class MapRipper : public QThread {
     Q_OBJECT
 public:
-    MapRipper(internals::Core *, internals::RectLatLng const &);
+    MapRipper(internals::Core *, internals::RectLatLng const &, QString const & packageFile = QString());
+    ~MapRipper();
     void run();
 private:
+    class Worker;
+    // Tiles fetched at the same time, each loader keeps its own server connection
+    static const int CONNECTIONS = 4;
+    // Attempts for a tile before it is skipped
+    static const int RETRIES     = 3;
+
+    bool nextTile(int &index);
+    void waitForTurn();
+    void ripTile(core::Point const & p, QVector<core::MapType::Types> const & types);
+    void close();
+
     QList<core::Point> points;
     int zoom;
     core::MapType::Types type;
@@ -50,6 +64,13 @@ private:
     internals::Core *core;
     bool yesToAll;
     QMutex mutex;
+    int nextPoint;
+    int done;
+    // Start time of the next request, the requests of all connections are spaced by sleep ms
+    QElapsedTimer clock;
+    qint64 nextRequest;
+    core::TilePackageWriter *package;
+    QString packageFile;
 
 signals:
     void percentageChanged(int const & perc);
@@ -14,7 +14,6 @@ SOURCES += mapgraphicitem.cpp \
     homeitem.cpp \
     mapripform.cpp \
     mapripper.cpp \
-    traillineitem.cpp \
     waypointline.cpp \
     waypointcircle.cpp
 
@@ -41,7 +40,6 @@ HEADERS += mapgraphicitem.h \
     homeitem.h \
     mapripform.h \
     mapripper.h \
-    traillineitem.h \
     waypointline.h \
     waypointcircle.h
 QT += opengl
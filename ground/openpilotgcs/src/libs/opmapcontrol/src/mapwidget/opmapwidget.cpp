@@ -517,9 +517,9 @@ void OPMapWidget::SetRotate(qreal const & value)
         compass->setRotation(value);
     }
 }
-void OPMapWidget::RipMap()
+void OPMapWidget::RipMap(QString const & packageFile)
 {
-    new MapRipper(core, map->SelectedArea());
+    new MapRipper(core, map->SelectedArea(), packageFile);
 }
 
 void OPMapWidget::setSelectedWP(QList<WayPointItem * >list)
@@ -654,8 +654,10 @@ signals:
 public slots:
     /**
      * @brief Ripps the current selection to the DB
+     *
+     * @param packageFile when given the tiles are also written to this tile package
      */
-    void RipMap();
+    void RipMap(QString const & packageFile = QString());
     void OnSelectionChanged();
 };
 }
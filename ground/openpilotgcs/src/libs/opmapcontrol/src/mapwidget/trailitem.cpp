@@ -26,13 +26,21 @@
  */
 #include "trailitem.h"
 #include <QDateTime>
+#include <QGraphicsSceneHoverEvent>
+#include <QStack>
+
+// Tolerance of the path simplification, in pixels
+#define SIMPLIFY_TOLERANCE 0.7
+// Distance to a point under which its tooltip is shown, in pixels
+#define HOVER_DISTANCE     4.0
+
 namespace mapcontrol {
-TrailItem::TrailItem(internals::PointLatLng const & coord, int const & altitude, QBrush color, MapGraphicItem *map) : QGraphicsItem(map), coord(coord), m_brush(color), m_map(map)
+TrailItem::TrailItem(MapGraphicItem *map, QColor pointColor, QColor lineColor) : QGraphicsItem(map), m_map(map), m_pointBrush(pointColor),
+    m_linePen(lineColor), m_showPoints(true), m_showLine(true), m_currentZoom(-1)
 {
-    QDateTime time    = QDateTime::currentDateTime();
-    QString coord_str = " " + QString::number(coord.Lat(), 'f', 6) + "   " + QString::number(coord.Lng(), 'f', 6);
-
-    setToolTip(QString(tr("Position:") + "%1\n" + tr("Altitude:") + "%2\n" + tr("Time:") + "%3").arg(coord_str).arg(QString::number(altitude)).arg(time.toString()));
+    m_linePen.setWidth(1);
+    setAcceptHoverEvents(true);
+    connect(map, SIGNAL(childRefreshPosition()), this, SLOT(setPosSLOT()));
 }
 
 void TrailItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
@@ -40,12 +48,29 @@ void TrailItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
     Q_UNUSED(option);
     Q_UNUSED(widget);
 
-    painter->setBrush(m_brush);
-    painter->drawEllipse(-2, -2, 4, 4);
+    const ZoomPaths *paths = current();
+    if (!paths) {
+        return;
+    }
+    if (m_showLine) {
+        painter->setPen(m_linePen);
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(paths->line);
+    }
+    if (m_showPoints) {
+        painter->setPen(Qt::black);
+        painter->setBrush(m_pointBrush);
+        painter->drawPath(paths->points);
+    }
 }
 QRectF TrailItem::boundingRect() const
 {
-    return QRectF(-2, -2, 4, 4);
+    const ZoomPaths *paths = current();
+
+    if (!paths) {
+        return QRectF();
+    }
+    return paths->line.controlPointRect().united(paths->points.controlPointRect()).adjusted(-3, -3, 3, 3);
 }
 
 
@@ -54,8 +79,207 @@ int TrailItem::type() const
     return Type;
 }
 
+void TrailItem::AddPoint(internals::PointLatLng const & coord, int const & altitude)
+{
+    TrailPoint point;
+
+    point.coord    = coord;
+    point.altitude = altitude;
+    point.time     = QDateTime::currentMSecsSinceEpoch();
+    m_points.append(point);
+
+    // Only the paths of the current zoom are extended, the others are rebuilt when used
+    prepareGeometryChange();
+    for (QHash<int, ZoomPaths>::iterator it = m_paths.begin(); it != m_paths.end();) {
+        if (it.key() != m_currentZoom) {
+            it = m_paths.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    ZoomPaths *paths = current();
+    if (paths && paths->local.count() == m_points.count() - 1) {
+        QPointF p = localPos(coord) - pos();
+        paths->local.append(p);
+        paths->line.lineTo(p);
+        paths->points.addEllipse(p, 2, 2);
+    }
+    setPosSLOT();
+    update();
+}
+
+void TrailItem::Clear()
+{
+    prepareGeometryChange();
+    m_points.clear();
+    m_paths.clear();
+    m_currentZoom = -1;
+    setToolTip(QString());
+}
+
+void TrailItem::SetShowPoints(bool const & value)
+{
+    m_showPoints = value;
+    setVisible(m_showPoints || m_showLine);
+    update();
+}
+
+void TrailItem::SetShowLine(bool const & value)
+{
+    m_showLine = value;
+    setVisible(m_showPoints || m_showLine);
+    update();
+}
+
+/**
+ * The tooltip of the point under the mouse is only built when hovered
+ */
+void TrailItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+{
+    const ZoomPaths *paths = current();
+
+    if (!paths) {
+        return;
+    }
+    int nearest  = -1;
+    qreal best   = HOVER_DISTANCE * HOVER_DISTANCE;
+    QPointF p    = event->pos();
+    for (int i = 0; i < paths->local.count(); i++) {
+        QPointF d = paths->local.at(i) - p;
+        qreal distance = d.x() * d.x() + d.y() * d.y();
+        if (distance <= best) {
+            best    = distance;
+            nearest = i;
+        }
+    }
+    if (nearest < 0 || nearest >= m_points.count()) {
+        setToolTip(QString());
+        return;
+    }
+    const TrailPoint &point = m_points.at(nearest);
+    QString coord_str = " " + QString::number(point.coord.Lat(), 'f', 6) + "   " + QString::number(point.coord.Lng(), 'f', 6);
+    setToolTip(QString(tr("Position:") + "%1\n" + tr("Altitude:") + "%2\n" + tr("Time:") + "%3").arg(coord_str).arg(QString::number(point.altitude))
+               .arg(QDateTime::fromMSecsSinceEpoch(point.time).toString()));
+}
+
+TrailItem::ZoomPaths *TrailItem::current()
+{
+    QHash<int, ZoomPaths>::iterator it = m_paths.find(m_currentZoom);
+
+    return it == m_paths.end() ? 0 : &it.value();
+}
+
+const TrailItem::ZoomPaths *TrailItem::current() const
+{
+    QHash<int, ZoomPaths>::const_iterator it = m_paths.constFind(m_currentZoom);
+
+    return it == m_paths.constEnd() ? 0 : &it.value();
+}
+
+int TrailItem::zoomKey() const
+{
+    return qRound(m_map->ZoomTotal() * 100);
+}
+
+QPointF TrailItem::localPos(internals::PointLatLng const & coord) const
+{
+    core::Point p = m_map->FromLatLngToLocal(coord);
+
+    return QPointF(p.X(), p.Y());
+}
+
+/**
+ * Build the paths of the current zoom, from the points simplified at the screen resolution
+ */
+void TrailItem::buildPaths(ZoomPaths &paths)
+{
+    paths.local.resize(m_points.count());
+    for (int i = 0; i < m_points.count(); i++) {
+        paths.local[i] = localPos(m_points.at(i).coord);
+    }
+    paths.origin = paths.local.first();
+
+    QVector<bool> keep;
+    simplify(paths.local, keep);
+    paths.line   = QPainterPath();
+    paths.points = QPainterPath();
+    bool first = true;
+    for (int i = 0; i < paths.local.count(); i++) {
+        if (!keep.at(i)) {
+            continue;
+        }
+        if (first) {
+            paths.line.moveTo(paths.local.at(i));
+            first = false;
+        } else {
+            paths.line.lineTo(paths.local.at(i));
+        }
+        paths.points.addEllipse(paths.local.at(i), 2, 2);
+    }
+}
+
+/**
+ * Douglas-Peucker simplification of the trail, iterative to bound the stack use
+ */
+void TrailItem::simplify(const QVector<QPointF> &local, QVector<bool> &keep) const
+{
+    int count = local.count();
+
+    keep.fill(false, count);
+    if (count == 0) {
+        return;
+    }
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    QStack<QPair<int, int> > ranges;
+    ranges.push(qMakePair(0, count - 1));
+    while (!ranges.isEmpty()) {
+        QPair<int, int> range = ranges.pop();
+        QPointF a = local.at(range.first);
+        QPointF d = local.at(range.second) - a;
+        qreal length2 = d.x() * d.x() + d.y() * d.y();
+        int farthest  = -1;
+        qreal best    = SIMPLIFY_TOLERANCE * SIMPLIFY_TOLERANCE;
+        for (int i = range.first + 1; i < range.second; i++) {
+            QPointF v = local.at(i) - a;
+            qreal distance2;
+            if (length2 > 0) {
+                qreal cross = v.x() * d.y() - v.y() * d.x();
+                distance2 = cross * cross / length2;
+            } else {
+                distance2 = v.x() * v.x() + v.y() * v.y();
+            }
+            if (distance2 > best) {
+                best     = distance2;
+                farthest = i;
+            }
+        }
+        if (farthest >= 0) {
+            keep[farthest] = true;
+            ranges.push(qMakePair(range.first, farthest));
+            ranges.push(qMakePair(farthest, range.second));
+        }
+    }
+}
+
+/**
+ * Follow the map: a pan only moves the item, a zoom switches to the paths of that zoom
+ */
 void TrailItem::setPosSLOT()
 {
-    setPos(m_map->FromLatLngToLocal(this->coord).X(), m_map->FromLatLngToLocal(this->coord).Y());
+    if (m_points.isEmpty()) {
+        return;
+    }
+    int key = zoomKey();
+    ZoomPaths &paths = m_paths[key];
+    if (paths.local.count() != m_points.count()) {
+        buildPaths(paths);
+    }
+    if (key != m_currentZoom) {
+        prepareGeometryChange();
+        m_currentZoom = key;
+    }
+    setPos(localPos(m_points.first().coord) - paths.origin);
 }
 }
@@ -3,7 +3,7 @@
  *
  * @file       trailitem.h
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a WayPoint
+ * @brief      A graphicsItem representing the trail of the UAV or of the GPS
  * @see        The GNU Public License (GPL) Version 3
  * @defgroup   OPMapWidget
  * @{
@@ -29,25 +29,70 @@
 
 #include <QGraphicsItem>
 #include <QPainter>
-#include <QLabel>
+#include <QPainterPath>
+#include <QHash>
+#include <QVector>
 #include "../internals/pointlatlng.h"
 #include <QObject>
 #include "mapgraphicitem.h"
 
 namespace mapcontrol {
+/**
+ * @brief The whole trail in one item: the trail points are kept in one buffer and drawn
+ * through a path built once per zoom level, simplified to the screen resolution.
+ *
+ * @class TrailItem trailitem.h "mapwidget/trailitem.h"
+ */
 class TrailItem : public QObject, public QGraphicsItem {
     Q_OBJECT Q_INTERFACES(QGraphicsItem)
 public:
     enum { Type = UserType + 3 };
-    TrailItem(internals::PointLatLng const & coord, int const & altitude, QBrush color, MapGraphicItem *map);
+    TrailItem(MapGraphicItem *map, QColor pointColor, QColor lineColor);
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                QWidget *widget);
     QRectF boundingRect() const;
     int type() const;
-    internals::PointLatLng coord;
+    /**
+     * @brief Adds a point at the end of the trail
+     */
+    void AddPoint(internals::PointLatLng const & coord, int const & altitude);
+    /**
+     * @brief Deletes all the trail points
+     */
+    void Clear();
+    void SetShowPoints(bool const & value);
+    void SetShowLine(bool const & value);
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
 private:
-    QBrush m_brush;
+    struct TrailPoint {
+        internals::PointLatLng coord;
+        int altitude;
+        qint64 time;
+    };
+    // Paths of one zoom level, in the local coordinates of the map at the time they were built
+    struct ZoomPaths {
+        QPainterPath points;
+        QPainterPath line;
+        QVector<QPointF> local;
+        QPointF origin; // local position of the first trail point when built
+    };
+
     MapGraphicItem *m_map;
+    QBrush m_pointBrush;
+    QPen m_linePen;
+    bool m_showPoints;
+    bool m_showLine;
+    QVector<TrailPoint> m_points;
+    QHash<int, ZoomPaths> m_paths;
+    int m_currentZoom;
+
+    ZoomPaths *current();
+    const ZoomPaths *current() const;
+    int zoomKey() const;
+    QPointF localPos(internals::PointLatLng const & coord) const;
+    void buildPaths(ZoomPaths &paths);
+    void simplify(const QVector<QPointF> &local, QVector<bool> &keep) const;
 public slots:
     void setPosSLOT();
 signals:
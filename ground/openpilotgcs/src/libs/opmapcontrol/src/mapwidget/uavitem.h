@@ -39,7 +39,6 @@
 #include <QtSvg/QSvgRenderer>
 #include "opmapwidget.h"
 #include "trailitem.h"
-#include "traillineitem.h"
 namespace mapcontrol {
 class WayPointItem;
 class OPMapWidget;
@@ -282,9 +281,7 @@ private:
     double ringTime;
     QPixmap pic;
     core::Point localposition;
-    QGraphicsItemGroup *trail;
-    QGraphicsItemGroup *trailLine;
-    internals::PointLatLng lasttrailline;
+    TrailItem *trail;
     QTime timer;
     bool showtrail;
     bool showtrailline;
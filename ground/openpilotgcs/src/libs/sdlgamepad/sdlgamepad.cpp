@@ -90,7 +90,11 @@ bool SDLGamepad::init()
 /**********************************************************************/
 void SDLGamepad::run()
 {
+    clock.start();
     while (loop) {
+        if (priv->gamepad) {
+            SDL_JoystickUpdate();
+        }
         updateAxes();
         updateButtons();
         msleep(tick);
@@ -142,7 +146,14 @@ void SDLGamepad::updateAxes()
 {
     if (priv->gamepad) {
         QListInt16 values;
-        SDL_JoystickUpdate();
+        quint32 changed = 0;
+        qint64 timestamp = clock.msecsSinceReference() + clock.elapsed();
+
+        if (axesStates.size() != axes) {
+            // a new gamepad, report every axis
+            axesStates.clear();
+            changed = ~0u;
+        }
 
         for (qint8 i = 0; i < axes; i++) {
             qint16 value = SDL_JoystickGetAxis(priv->gamepad, i);
@@ -150,11 +161,23 @@ void SDLGamepad::updateAxes()
             if (value > -NULL_RANGE && value < NULL_RANGE) {
                 value = 0;
             }
+            // entering or leaving the null range is always reported
+            if (changed != ~0u) {
+                qint16 last = axesStates.at(i);
+                if (qAbs(value - last) > CHANGE_RANGE || (value == 0) != (last == 0)) {
+                    // axes past the 32nd share the last bit
+                    changed |= 1u << qMin((int)i, 31);
+                }
+            }
 
             values.append(value);
         }
 
-        emit axesValues(values);
+        if (changed) {
+            axesStates = values;
+            emit axesValues(values);
+            emit axesChanged(values, changed, timestamp);
+        }
     }
 }
 
@@ -162,8 +185,6 @@ void SDLGamepad::updateAxes()
 void SDLGamepad::updateButtons()
 {
     if (priv->gamepad) {
-        SDL_JoystickUpdate();
-
         for (qint8 i = 0; i < buttons; i++) {
             qint16 state = SDL_JoystickGetButton(priv->gamepad, i);
 
@@ -26,6 +26,7 @@
 #include "sdlgamepad_global.h"
 
 #include <QThread>
+#include <QElapsedTimer>
 
 /**
  * The Axis range that is treated as null.
@@ -34,17 +35,28 @@
  * SDL axis values greater than -NULL_RANGE and smaller than +NULL_RANGE
  * will be treated as null.
  */
-#define NULL_RANGE 2800
+#define NULL_RANGE  2800
+
+/**
+ * The smallest change of an axis that is reported.
+ *
+ * Axis values are only emitted when at least one axis moved by more
+ * than CHANGE_RANGE since it was last reported, so that the noise of
+ * a sensor resting between two values does not produce signals.
+ */
+#define CHANGE_RANGE 64
 
 /**
  * The default tick rate of refreshing the SDL info.
  *
  * This is the default ms value in the thread method to sleep. If you
  * dont set a sleep rate you processor will have a much higher load!
+ * Since nothing is emitted while the gamepad is not moved a short
+ * tick only costs the reading of the device.
  *
  * @see SDLGamepad::setTickRate()
  */
-#define MIN_RATE   10
+#define MIN_RATE    4
 
 /**
  * Axis enumeration.
@@ -151,7 +163,7 @@ public:
      * The base of operation so to speak. Very abstract this method
      * does the following:
      * - refresh SDL information
-     * - emit signals
+     * - emit signals for what changed
      * - sleep tickrate
      */
     void run();
@@ -227,8 +239,8 @@ private:
      * Get new axes information from the SDL system.
      *
      * This class member is called from the run method to ask the SDL
-     * system for new axes values. Afterwords those values are emitted
-     * via the axesValues signal.
+     * system for new axes values. If changed, those values are emitted
+     * via the axesValues and axesChanged signals.
      *
      * @see run()
      * @see axesValues()
@@ -299,6 +311,18 @@ private:
      */
     QList<qint16> buttonStates;
 
+    /**
+     * A QList to store the last reported axes values.
+     *
+     * Empty until the first values were emitted.
+     */
+    QListInt16 axesStates;
+
+    /**
+     * Monotonic clock of the timestamps.
+     */
+    QElapsedTimer clock;
+
     /**
      * Variable that holds private members.
      */
@@ -339,14 +363,28 @@ signals:
      * A signal that emitts the current values of the gamepad axes.
      *
      * You can connect to this signal to receive the values of the
-     * gamepad axes. Unlike the button signal, this signal is thrown
-     * with every tick. You will get a QListInt16 containing the value
-     * of every present axis in a QList.
+     * gamepad axes. Like the button signal, this signal is only thrown
+     * when an axis changed by more than CHANGE_RANGE. You will get a
+     * QListInt16 containing the value of every present axis in a QList.
      *
      * @see QListInt16
      * @param values A QListInt16 Type containing all axes values.
      */
     void axesValues(QListInt16 values);
+
+    /**
+     * A signal that emitts the axes values along with what changed.
+     *
+     * Thrown right after axesValues. The timestamp is the time the
+     * values were read, in ms of the monotonic clock used by
+     * QElapsedTimer::msecsSinceReference().
+     *
+     * @param values A QListInt16 Type containing all axes values.
+     * @param changed Bit i is set if axis i changed, all bits are
+     *                set for the first values of a gamepad.
+     * @param timestamp The time the values were read.
+     */
+    void axesChanged(QListInt16 values, quint32 changed, qint64 timestamp);
 };
 
 #endif // SDLGAMEPAD_H
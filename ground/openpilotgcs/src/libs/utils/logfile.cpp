@@ -1,6 +1,10 @@
 #include "logfile.h"
 #include <QDebug>
 #include <QtGlobal>
+#include <QtEndian>
+#include <QDataStream>
+
+static const char indexMagic[8] = { 'O', 'P', 'L', 'I', 'D', 'X', 0, 0 };
 
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
@@ -8,8 +12,16 @@ LogFile::LogFile(QObject *parent) :
     m_lastPlayed(0),
     m_timeOffset(0),
     m_playbackSpeed(1.0),
+    m_writeOffset(0),
     m_nextTimeStamp(0),
-    m_useProvidedTimeStamp(false)
+    m_useProvidedTimeStamp(false),
+    m_replayData(NULL),
+    m_nextPacket(0),
+    m_readPacket(0),
+    m_readOffset(0),
+    m_releasedBytes(0),
+    m_asFastAsPossible(false),
+    m_lastReportedPosition(0)
 {
     connect(&m_timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -36,6 +48,12 @@ bool LogFile::open(OpenMode mode)
         return false;
     }
 
+    if (m_file.isWritable()) {
+        m_writeOffset = 0;
+        m_seekPoints.clear();
+        m_objectRanges.clear();
+    }
+
     // TODO: Write a header at the beginng describing objects so that in future
     // they can be read back if ID's change
 
@@ -54,6 +72,23 @@ void LogFile::close()
     if (m_timer.isActive()) {
         m_timer.stop();
     }
+
+    m_mutex.lock();
+    m_replayData    = NULL;
+    m_replayFallback.clear();
+    m_packets.clear();
+    m_releasedBytes = 0;
+    m_mutex.unlock();
+
+    bool written = m_file.isWritable() && m_writeOffset > 0;
+    flushPackets();
+    if (written) {
+        writeIndex();
+    }
+    m_seekPoints.clear();
+    m_objectRanges.clear();
+
+    // Also unmaps the file
     m_file.close();
     QIODevice::close();
 }
@@ -68,97 +103,291 @@ qint64 LogFile::writeData(const char *data, qint64 dataSize)
     // This is used when saving logs from on-board logging
     quint32 timeStamp = m_useProvidedTimeStamp ? m_nextTimeStamp : m_myTime.elapsed();
 
-    m_file.write((char *)&timeStamp, sizeof(timeStamp));
-    m_file.write((char *)&dataSize, sizeof(dataSize));
+    return writePacket(timeStamp, data, dataSize);
+}
+
+/**
+ * Adds a packet with the given timestamp to the log. Packets are buffered,
+ * they reach the file once enough of them are collected, on flushPackets() or on close().
+ */
+qint64 LogFile::writePacket(quint32 timeStamp, const char *data, qint64 dataSize)
+{
+    if (!m_file.isWritable()) {
+        return dataSize;
+    }
+
+    indexPacket(timeStamp, data, dataSize);
+    m_writeOffset += sizeof(timeStamp) + sizeof(dataSize) + dataSize;
+
+    m_writeBuffer.append((const char *)&timeStamp, sizeof(timeStamp));
+    m_writeBuffer.append((const char *)&dataSize, sizeof(dataSize));
+    m_writeBuffer.append(data, dataSize);
 
-    qint64 written = m_file.write(data, dataSize);
-    if (written != -1) {
-        emit bytesWritten(written);
+    if (m_writeBuffer.size() >= WRITE_BUFFER_SIZE) {
+        flushPackets();
     }
 
     return dataSize;
 }
 
+/**
+ * Writes the buffered packets to the file.
+ */
+bool LogFile::flushPackets()
+{
+    if (m_writeBuffer.isEmpty()) {
+        return true;
+    }
+
+    qint64 written = m_file.write(m_writeBuffer);
+    m_writeBuffer.clear();
+    if (written == -1) {
+        return false;
+    }
+
+    emit bytesWritten(written);
+    return m_file.flush();
+}
+
+/**
+ * Adds a written packet to the sidecar index: a seek point every INDEX_INTERVAL ms
+ * and, for UAVTalk frames, the time range of the object.
+ */
+void LogFile::indexPacket(quint32 timeStamp, const char *data, qint64 dataSize)
+{
+    if (m_seekPoints.isEmpty() || timeStamp >= m_seekPoints.last().timeStamp + INDEX_INTERVAL) {
+        SeekPoint point = { timeStamp, m_writeOffset };
+        m_seekPoints.append(point);
+    }
+
+    // UAVTalk frame: sync, type, length (2 bytes), object id (4 bytes)
+    if (dataSize < 8 || (quint8)data[0] != 0x3C) {
+        return;
+    }
+    quint32 objId = qFromLittleEndian<quint32>((const uchar *)data + 4);
+    QHash<quint32, ObjectRange>::iterator it = m_objectRanges.find(objId);
+    if (it == m_objectRanges.end()) {
+        ObjectRange range = { timeStamp, timeStamp, 1 };
+        m_objectRanges.insert(objId, range);
+    } else {
+        it->first = qMin(it->first, timeStamp);
+        it->last  = qMax(it->last, timeStamp);
+        it->count++;
+    }
+}
+
+/**
+ * Writes the sidecar index of the log, little endian:
+ * magic "OPLIDX\0\0", version, seek interval (ms), log size (8 bytes), number of seek points,
+ * number of objects, then the seek points (timestamp, file offset of the packet, 8 bytes)
+ * and the objects (object id, first and last timestamp, number of packets).
+ */
+bool LogFile::writeIndex()
+{
+    QFile file(indexFileName());
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Unable to write the log index" << file.fileName();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(indexMagic, sizeof(indexMagic));
+    out << INDEX_VERSION << INDEX_INTERVAL << (quint64)m_writeOffset
+        << (quint32)m_seekPoints.size() << (quint32)m_objectRanges.size();
+    foreach(const SeekPoint &point, m_seekPoints) {
+        out << point.timeStamp << (quint64)point.offset;
+    }
+    for (QHash<quint32, ObjectRange>::const_iterator it = m_objectRanges.constBegin(); it != m_objectRanges.constEnd(); ++it) {
+        out << it.key() << it->first << it->last << it->count;
+    }
+    file.close();
+
+    if (out.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+        qDebug() << "Unable to write the log index" << file.fileName();
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loads the object time ranges from the sidecar index, if there is one matching the log.
+ */
+bool LogFile::readIndex()
+{
+    m_objectRanges.clear();
+
+    QFile file(indexFileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[sizeof(indexMagic)];
+    quint32 version = 0;
+    quint32 interval;
+    quint64 logSize = 0;
+    quint32 numSeekPoints = 0;
+    quint32 numObjects    = 0;
+    if (in.readRawData(magic, sizeof(magic)) != (int)sizeof(magic) || memcmp(magic, indexMagic, sizeof(magic))) {
+        return false;
+    }
+    in >> version >> interval >> logSize >> numSeekPoints >> numObjects;
+    if (in.status() != QDataStream::Ok || version != INDEX_VERSION || logSize != (quint64)m_file.size()) {
+        qDebug() << "Ignoring stale log index" << file.fileName();
+        return false;
+    }
+
+    // Replay seeks use the packet index, the seek points are there for offline tools
+    in.skipRawData(numSeekPoints * (sizeof(quint32) + sizeof(quint64)));
+    for (quint32 i = 0; i < numObjects && in.status() == QDataStream::Ok; i++) {
+        quint32 objId;
+        ObjectRange range;
+        in >> objId >> range.first >> range.last >> range.count;
+        m_objectRanges.insert(objId, range);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Log index truncated" << file.fileName();
+        m_objectRanges.clear();
+        return false;
+    }
+    return true;
+}
+
 qint64 LogFile::readData(char *data, qint64 maxSize)
 {
     QMutexLocker locker(&m_mutex);
-    qint64 toRead = qMin(maxSize, (qint64)m_dataBuffer.size());
+    qint64 read = 0;
+
+    // Copy the released payloads straight from the mapped file
+    while (read < maxSize && m_releasedBytes > 0) {
+        const ReplayPacket &packet = m_packets.at(m_readPacket);
+        qint64 toRead = qMin(maxSize - read, packet.size - m_readOffset);
 
-    memcpy(data, m_dataBuffer.data(), toRead);
-    m_dataBuffer.remove(0, toRead);
-    return toRead;
+        memcpy(data + read, m_replayData + packet.offset + m_readOffset, toRead);
+        read            += toRead;
+        m_readOffset    += toRead;
+        m_releasedBytes -= toRead;
+        if (m_readOffset == packet.size) {
+            m_readPacket++;
+            m_readOffset = 0;
+        }
+    }
+    return read;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return m_dataBuffer.size();
+    return m_releasedBytes + QIODevice::bytesAvailable();
 }
 
 void LogFile::timerFired()
 {
-    qint64 dataSize;
+    int time = m_myTime.elapsed();
+    int first = m_nextPacket;
 
-    if (m_file.bytesAvailable() > 4) {
-        int time;
-        time = m_myTime.elapsed();
-
-        // TODO: going back in time will be a problem
-        while ((m_lastPlayed + ((time - m_timeOffset) * m_playbackSpeed) > m_lastTimeStamp)) {
-            m_lastPlayed += ((time - m_timeOffset) * m_playbackSpeed);
-            if (m_file.bytesAvailable() < (qint64)sizeof(dataSize)) {
-                stopReplay();
-                return;
-            }
+    m_mutex.lock();
+    if (m_asFastAsPossible) {
+        // Ignore the timestamps, but release a bounded amount per tick to keep the GUI responsive
+        qint64 burst = 0;
+        while (m_nextPacket < m_packets.size() && burst < REPLAY_BURST_SIZE) {
+            burst           += m_packets.at(m_nextPacket).size;
+            m_releasedBytes += m_packets.at(m_nextPacket).size;
+            m_lastPlayed     = m_packets.at(m_nextPacket++).timeStamp;
+        }
+    } else {
+        m_lastPlayed += ((time - m_timeOffset) * m_playbackSpeed);
+        while (m_nextPacket < m_packets.size() && (qint64)m_packets.at(m_nextPacket).timeStamp <= m_lastPlayed) {
+            m_releasedBytes += m_packets.at(m_nextPacket++).size;
+        }
+    }
+    m_timeOffset = time;
+    if (m_nextPacket < m_packets.size()) {
+        m_lastTimeStamp = m_packets.at(m_nextPacket).timeStamp;
+    }
+    m_mutex.unlock();
 
-            m_file.read((char *)&dataSize, sizeof(dataSize));
+    if (m_nextPacket != first) {
+        emit readyRead();
+    }
 
-            if (dataSize < 1 || dataSize > (1024 * 1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
+    if ((quint32)m_lastPlayed < m_lastReportedPosition || (quint32)m_lastPlayed - m_lastReportedPosition >= 100) {
+        m_lastReportedPosition = m_lastPlayed;
+        emit replayPositionChanged(m_lastReportedPosition);
+    }
 
-            if (m_file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+    if (m_nextPacket >= m_packets.size()) {
+        stopReplay();
+    }
+}
 
-            m_mutex.lock();
-            m_dataBuffer.append(m_file.read(dataSize));
-            m_mutex.unlock();
+/**
+ * Map the logfile and index its packets, stopping at the first corrupted one.
+ * Each packet is stored as timestamp (4 bytes), size (8 bytes) and data.
+ */
+bool LogFile::buildPacketIndex()
+{
+    qint64 fileSize = m_file.size();
 
-            emit readyRead();
+    m_replayData = m_file.map(0, fileSize);
+    if (m_replayData == NULL) {
+        // Mapping is not supported, keep the file in memory instead
+        m_file.seek(0);
+        m_replayFallback = m_file.readAll();
+        m_replayData     = (const uchar *)m_replayFallback.constData();
+        fileSize = m_replayFallback.size();
+    }
 
-            if (m_file.bytesAvailable() < (qint64)sizeof(m_lastTimeStamp)) {
-                stopReplay();
-                return;
-            }
+    m_packets.clear();
+    qint64 pos = 0;
+    while (pos + (qint64)(sizeof(quint32) + sizeof(qint64)) <= fileSize) {
+        ReplayPacket packet;
+        memcpy(&packet.timeStamp, m_replayData + pos, sizeof(packet.timeStamp));
+        memcpy(&packet.size, m_replayData + pos + sizeof(packet.timeStamp), sizeof(packet.size));
+        packet.offset = pos + sizeof(packet.timeStamp) + sizeof(packet.size);
 
-            int save = m_lastTimeStamp;
-            m_file.read((char *)&m_lastTimeStamp, sizeof(m_lastTimeStamp));
+        if (packet.size < 1 || packet.size > (1024 * 1024)) {
+            qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << packet.size << "\n";
+            break;
+        }
+        if (packet.offset + packet.size > fileSize) {
+            break;
+        }
+        if (!m_packets.isEmpty()) {
+            quint32 save = m_packets.last().timeStamp;
             // some validity checks
-            if (m_lastTimeStamp < save // logfile goes back in time
-                || (m_lastTimeStamp - save) > (60 * 60 * 1000)) { // gap of more than 60 minutes)
-                qDebug() << "Error: Logfile corrupted! Unlikely timestamp " << m_lastTimeStamp << " after " << save << "\n";
-                stopReplay();
-                return;
+            if (packet.timeStamp < save // logfile goes back in time
+                || (packet.timeStamp - save) > (60 * 60 * 1000)) { // gap of more than 60 minutes)
+                qDebug() << "Error: Logfile corrupted! Unlikely timestamp " << packet.timeStamp << " after " << save << "\n";
+                break;
             }
-
-            m_timeOffset = time;
-            time = m_myTime.elapsed();
         }
-    } else {
-        stopReplay();
+        m_packets.append(packet);
+        pos = packet.offset + packet.size;
     }
+    return !m_packets.isEmpty();
 }
 
 bool LogFile::startReplay()
 {
-    m_dataBuffer.clear();
+    m_mutex.lock();
+    bool hasPackets = buildPacketIndex();
+    readIndex();
+    m_nextPacket    = 0;
+    m_readPacket    = 0;
+    m_readOffset    = 0;
+    m_releasedBytes = 0;
+    m_mutex.unlock();
+
     m_myTime.restart();
-    m_timeOffset = 0;
-    m_lastPlayed = 0;
-    m_file.read((char *)&m_lastTimeStamp, sizeof(m_lastTimeStamp));
+    m_timeOffset    = 0;
+    m_lastPlayed    = 0;
+    m_lastReportedPosition = 0;
+    m_lastTimeStamp = hasPackets ? m_packets.first().timeStamp : 0;
     m_timer.setInterval(10);
     m_timer.start();
     emit replayStarted();
@@ -182,3 +411,69 @@ void LogFile::resumeReplay()
     m_timeOffset = m_myTime.elapsed();
     m_timer.start();
 }
+
+/**
+ * Moves the replay to the first packet at or after the given timestamp.
+ * A packet being read when seeking is cut short, the reader drops it and resynchronizes.
+ */
+bool LogFile::seekReplay(quint32 timeStamp)
+{
+    m_mutex.lock();
+    if (m_packets.isEmpty()) {
+        m_mutex.unlock();
+        return false;
+    }
+
+    // Packets are indexed in time order
+    int first = 0;
+    int count = m_packets.size();
+    while (count > 0) {
+        int step = count / 2;
+        if (m_packets.at(first + step).timeStamp < timeStamp) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    m_nextPacket    = first;
+    m_readPacket    = first;
+    m_readOffset    = 0;
+    m_releasedBytes = 0;
+    m_lastPlayed    = timeStamp;
+    m_timeOffset    = m_myTime.elapsed();
+    if (m_nextPacket < m_packets.size()) {
+        m_lastTimeStamp = m_packets.at(m_nextPacket).timeStamp;
+    }
+    m_lastReportedPosition = timeStamp;
+    m_mutex.unlock();
+
+    emit replayPositionChanged(timeStamp);
+    return true;
+}
+
+quint32 LogFile::replayStartTime() const
+{
+    return m_packets.isEmpty() ? 0 : m_packets.first().timeStamp;
+}
+
+quint32 LogFile::replayEndTime() const
+{
+    return m_packets.isEmpty() ? 0 : m_packets.last().timeStamp;
+}
+
+/**
+ * Time range of the given object in the replayed log, available when the log has a sidecar index.
+ */
+bool LogFile::objectTimeRange(quint32 objId, quint32 &first, quint32 &last) const
+{
+    QHash<quint32, ObjectRange>::const_iterator it = m_objectRanges.constFind(objId);
+
+    if (it == m_objectRanges.constEnd()) {
+        return false;
+    }
+    first = it->first;
+    last  = it->last;
+    return true;
+}
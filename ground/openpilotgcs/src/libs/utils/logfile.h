@@ -8,6 +8,8 @@
 #include <QDebug>
 #include <QBuffer>
 #include <QFile>
+#include <QVector>
+#include <QHash>
 #include "utils_global.h"
 
 class QTCREATOR_UTILS_EXPORT LogFile : public QIODevice {
@@ -17,7 +19,7 @@ public:
     qint64 bytesAvailable() const;
     qint64 bytesToWrite()
     {
-        return m_file.bytesToWrite();
+        return m_writeBuffer.size() + m_file.bytesToWrite();
     };
     bool open(OpenMode mode);
     void setFileName(QString name)
@@ -26,10 +28,20 @@ public:
     };
     void close();
     qint64 writeData(const char *data, qint64 dataSize);
+    qint64 writePacket(quint32 timeStamp, const char *data, qint64 dataSize);
+    bool flushPackets();
     qint64 readData(char *data, qint64 maxlen);
 
     bool startReplay();
     bool stopReplay();
+
+    quint32 replayStartTime() const;
+    quint32 replayEndTime() const;
+    quint32 replayPosition() const
+    {
+        return m_lastPlayed;
+    }
+    bool objectTimeRange(quint32 objId, quint32 &first, quint32 &last) const;
     void useProvidedTimeStamp(bool useProvidedTimeStamp)
     {
         m_useProvidedTimeStamp = useProvidedTimeStamp;
@@ -46,8 +58,13 @@ public slots:
         m_playbackSpeed = val;
         qDebug() << "Playback speed is now" << m_playbackSpeed;
     };
+    void setReplayAsFastAsPossible(bool enabled)
+    {
+        m_asFastAsPossible = enabled;
+    }
     void pauseReplay();
     void resumeReplay();
+    bool seekReplay(quint32 timeStamp);
 
 protected slots:
     void timerFired();
@@ -56,9 +73,9 @@ signals:
     void readReady();
     void replayStarted();
     void replayFinished();
+    void replayPositionChanged(quint32 timeStamp);
 
 protected:
-    QByteArray m_dataBuffer;
     QTimer m_timer;
     QTime m_myTime;
     QFile m_file;
@@ -71,8 +88,60 @@ protected:
     double m_playbackSpeed;
 
 private:
+    typedef struct {
+        qint64  offset;
+        qint64  size;
+        quint32 timeStamp;
+    } ReplayPacket;
+
+    typedef struct {
+        quint32 timeStamp;
+        qint64  offset;
+    } SeekPoint;
+
+    typedef struct {
+        quint32 first;
+        quint32 last;
+        quint32 count;
+    } ObjectRange;
+
+    // Bytes released to the reader per timer tick when replaying as fast as possible
+    static const qint64 REPLAY_BURST_SIZE = 256 * 1024;
+
+    // Written packets are collected and written to the file in large blocks
+    static const int WRITE_BUFFER_SIZE   = 256 * 1024;
+    QByteArray m_writeBuffer;
+
+    // Sidecar index (<logfile>.idx) written on close: a seek point every
+    // INDEX_INTERVAL ms and the time range of each logged object
+    static const quint32 INDEX_INTERVAL = 1000;
+    static const quint32 INDEX_VERSION  = 1;
+    qint64 m_writeOffset;
+    QVector<SeekPoint> m_seekPoints;
+    QHash<quint32, ObjectRange> m_objectRanges;
+
     quint32 m_nextTimeStamp;
     bool m_useProvidedTimeStamp;
+
+    // Replay state, the payloads are read in place from the mapped file
+    const uchar *m_replayData;
+    QByteArray m_replayFallback;
+    QVector<ReplayPacket> m_packets;
+    int m_nextPacket;
+    int m_readPacket;
+    qint64 m_readOffset;
+    qint64 m_releasedBytes;
+    bool m_asFastAsPossible;
+    quint32 m_lastReportedPosition;
+
+    bool buildPacketIndex();
+    void indexPacket(quint32 timeStamp, const char *data, qint64 dataSize);
+    bool writeIndex();
+    bool readIndex();
+    QString indexFileName() const
+    {
+        return m_file.fileName() + ".idx";
+    }
 };
 
 #endif // LOGFILE_H
@@ -0,0 +1,134 @@
+/**
+ ******************************************************************************
+ *
+ * @file       qmlobjectproxy.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @{
+ * @brief Shared, rate limited view of QObject properties for the QML gadgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "qmlobjectproxy.h"
+
+#include <QMetaProperty>
+#include <QQmlPropertyMap>
+
+// Default refresh rate of the maps, the fast values like the attitude are sampled per frame by the gadgets
+#define DEFAULT_UPDATE_RATE_HZ 20
+
+namespace Utils {
+QmlObjectProxy *QmlObjectProxy::instance()
+{
+    static QmlObjectProxy *proxy = 0;
+
+    if (!proxy) {
+        proxy = new QmlObjectProxy();
+    }
+    return proxy;
+}
+
+QmlObjectProxy::QmlObjectProxy()
+{
+    m_timer.setSingleShot(true);
+    setUpdateRate(DEFAULT_UPDATE_RATE_HZ);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(update()));
+}
+
+void QmlObjectProxy::setUpdateRate(int hz)
+{
+    m_timer.setInterval(1000 / qMax(hz, 1));
+}
+
+QQmlPropertyMap *QmlObjectProxy::map(QObject *object, const char *changedSignal)
+{
+    if (!object) {
+        return 0;
+    }
+
+    QQmlPropertyMap *map = m_maps.value(object);
+    if (!map) {
+        map = new QQmlPropertyMap(this);
+        m_maps.insert(object, map);
+        m_objects.insert(map, object);
+        refresh(object, map);
+
+        connect(object, changedSignal, this, SLOT(objectChanged()));
+        connect(object, SIGNAL(destroyed(QObject *)), this, SLOT(objectDestroyed(QObject *)));
+        connect(map, SIGNAL(valueChanged(QString, QVariant)), this, SLOT(mapValueChanged(QString, QVariant)));
+    }
+    return map;
+}
+
+void QmlObjectProxy::objectChanged()
+{
+    m_changed.insert(sender());
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void QmlObjectProxy::objectDestroyed(QObject *object)
+{
+    QQmlPropertyMap *map = m_maps.take(object);
+
+    m_changed.remove(object);
+    if (map) {
+        m_objects.remove(map);
+        map->deleteLater();
+    }
+}
+
+void QmlObjectProxy::mapValueChanged(const QString &key, const QVariant &value)
+{
+    // Written from QML, forward to the object
+    QObject *object = m_objects.value(qobject_cast<QQmlPropertyMap *>(sender()));
+
+    if (object) {
+        object->setProperty(key.toLatin1().constData(), value);
+    }
+}
+
+void QmlObjectProxy::update()
+{
+    QSet<QObject *> changed;
+
+    changed.swap(m_changed);
+    foreach(QObject * object, changed) {
+        QQmlPropertyMap *map = m_maps.value(object);
+
+        if (map) {
+            refresh(object, map);
+        }
+    }
+}
+
+void QmlObjectProxy::refresh(QObject *object, QQmlPropertyMap *map)
+{
+    const QMetaObject *metaObject = object->metaObject();
+
+    // Skip objectName, the map only notifies the values that differ
+    for (int i = QObject::staticMetaObject.propertyCount(); i < metaObject->propertyCount(); ++i) {
+        QMetaProperty property = metaObject->property(i);
+        QString name  = QString::fromLatin1(property.name());
+        QVariant value = property.read(object);
+
+        if (!map->contains(name) || map->value(name) != value) {
+            map->insert(name, value);
+        }
+    }
+}
+}
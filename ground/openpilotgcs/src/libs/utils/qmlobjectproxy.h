@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ *
+ * @file       qmlobjectproxy.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @{
+ * @brief Shared, rate limited view of QObject properties for the QML gadgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef QMLOBJECTPROXY_H
+#define QMLOBJECTPROXY_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+#include "utils_global.h"
+
+class QQmlPropertyMap;
+
+namespace Utils {
+// A property map per object, shared by all the QML views instead of the objects themselves.
+// The maps are refreshed by a single timer, only for the objects that changed since the last
+// tick and only the values that differ notify, so the bindings of every view are evaluated
+// at most once per tick whatever the update rate of the objects and the number of views.
+class QTCREATOR_UTILS_EXPORT QmlObjectProxy : public QObject {
+    Q_OBJECT
+public:
+    static QmlObjectProxy *instance();
+
+    // The map of object, created on the first call. changedSignal is the signal of
+    // the object telling that some of its properties changed, e.g. SIGNAL(objectUpdated(UAVObject *))
+    QQmlPropertyMap *map(QObject *object, const char *changedSignal);
+
+    void setUpdateRate(int hz);
+
+private slots:
+    void objectChanged();
+    void objectDestroyed(QObject *object);
+    void mapValueChanged(const QString &key, const QVariant &value);
+    void update();
+
+private:
+    QmlObjectProxy();
+    void refresh(QObject *object, QQmlPropertyMap *map);
+
+    QHash<QObject *, QQmlPropertyMap *> m_maps;
+    QHash<QQmlPropertyMap *, QObject *> m_objects;
+    QSet<QObject *> m_changed;
+    QTimer m_timer;
+};
+}
+
+#endif // QMLOBJECTPROXY_H
@@ -0,0 +1,57 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rastersvgitem.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @{
+ * @brief SVG item painted from the shared raster cache
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "rastersvgitem.h"
+#include "svgrastercache.h"
+
+#include <QPainter>
+#include <QSvgRenderer>
+#include <qmath.h>
+
+RasterSvgItem::RasterSvgItem(QGraphicsItem *parent) :
+    QGraphicsSvgItem(parent)
+{
+    setCacheMode(NoCache);
+}
+
+void RasterSvgItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    QRectF br = boundingRect();
+    // Scale of the item on the device, rotations do not change it
+    qreal scale = painter->worldTransform().map(QLineF(0, 0, 1, 0)).length();
+    QSize size(qCeil(br.width() * scale), qCeil(br.height() * scale));
+
+    QPixmap pixmap = Utils::SvgRasterCache::instance()->pixmap(renderer(), elementId(), size, painter->device()->devicePixelRatio());
+
+    if (pixmap.isNull()) {
+        // Fallback to direct painting
+        QGraphicsSvgItem::paint(painter, option, widget);
+        return;
+    }
+
+    bool smooth = painter->testRenderHint(QPainter::SmoothPixmapTransform);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawPixmap(br, pixmap, QRectF(pixmap.rect()));
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+}
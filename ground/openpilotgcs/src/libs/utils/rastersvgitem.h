@@ -0,0 +1,43 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rastersvgitem.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @{
+ * @brief SVG item painted from the shared raster cache
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef RASTERSVGITEM_H
+#define RASTERSVGITEM_H
+
+#include <QGraphicsSvgItem>
+
+#include "utils_global.h"
+
+// Svg item drawn from a pixmap of the Utils::SvgRasterCache.
+// The pixmap is rendered again only when the item is scaled, moving or
+// rotating the item, or a repaint of the scene, just composites it.
+class QTCREATOR_UTILS_EXPORT RasterSvgItem : public QGraphicsSvgItem {
+    Q_OBJECT
+public:
+    RasterSvgItem(QGraphicsItem *parent = 0);
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+};
+
+#endif // RASTERSVGITEM_H
@@ -0,0 +1,101 @@
+/**
+ ******************************************************************************
+ *
+ * @file       svgrastercache.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @{
+ * @brief Shared cache of rasterized SVG elements
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "svgrastercache.h"
+
+#include <QPainter>
+#include <QPixmapCache>
+#include <QSvgRenderer>
+
+// The dials are typically a few hundred pixels wide, leave room for several gadgets
+#define MIN_CACHE_LIMIT_KB (32 * 1024)
+
+namespace Utils {
+SvgRasterCache *SvgRasterCache::instance()
+{
+    static SvgRasterCache *cache = 0;
+
+    if (!cache) {
+        cache = new SvgRasterCache();
+    }
+    return cache;
+}
+
+SvgRasterCache::SvgRasterCache() : m_nextGeneration(0)
+{
+    if (QPixmapCache::cacheLimit() < MIN_CACHE_LIMIT_KB) {
+        QPixmapCache::setCacheLimit(MIN_CACHE_LIMIT_KB);
+    }
+}
+
+QPixmap SvgRasterCache::pixmap(QSvgRenderer *renderer, const QString &elementId, const QSize &size, int devicePixelRatio)
+{
+    QPixmap pixmap;
+
+    if (!renderer || size.isEmpty()) {
+        return pixmap;
+    }
+
+    QHash<QObject *, quint32>::const_iterator it = m_generations.constFind(renderer);
+    if (it == m_generations.constEnd()) {
+        it = m_generations.insert(renderer, m_nextGeneration++);
+        connect(renderer, SIGNAL(destroyed(QObject *)), this, SLOT(rendererDestroyed(QObject *)));
+    }
+
+    QString key = QString("svgraster:%1:%2:%3x%4@%5").arg(*it).arg(elementId)
+                  .arg(size.width()).arg(size.height()).arg(devicePixelRatio);
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+
+    QImage image(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    if (elementId.isEmpty()) {
+        renderer->render(&painter, QRectF(QPointF(0, 0), image.size()));
+    } else {
+        renderer->render(&painter, elementId, QRectF(QPointF(0, 0), image.size()));
+    }
+    painter.end();
+
+    pixmap = QPixmap::fromImage(image);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    QPixmapCache::insert(key, pixmap);
+    return pixmap;
+}
+
+void SvgRasterCache::invalidate(QSvgRenderer *renderer)
+{
+    // Stale pixmaps are never looked up again and age out of the cache
+    if (m_generations.contains(renderer)) {
+        m_generations[renderer] = m_nextGeneration++;
+    }
+}
+
+void SvgRasterCache::rendererDestroyed(QObject *renderer)
+{
+    m_generations.remove(renderer);
+}
+}
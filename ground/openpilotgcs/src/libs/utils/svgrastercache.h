@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ *
+ * @file       svgrastercache.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @{
+ * @brief Shared cache of rasterized SVG elements
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SVGRASTERCACHE_H
+#define SVGRASTERCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPixmap>
+
+#include "utils_global.h"
+
+class QSvgRenderer;
+
+namespace Utils {
+// Rasterized SVG elements, keyed by renderer, element id, pixel size and device pixel ratio.
+// The pixmaps are kept in the QPixmapCache, the least recently used ones are dropped first.
+class QTCREATOR_UTILS_EXPORT SvgRasterCache : public QObject {
+    Q_OBJECT
+public:
+    static SvgRasterCache *instance();
+
+    // The element rendered to size device independent pixels, an empty elementId renders the whole document
+    QPixmap pixmap(QSvgRenderer *renderer, const QString &elementId, const QSize &size, int devicePixelRatio);
+
+    // Forget the pixmaps of the renderer, to be called when it loads another file
+    void invalidate(QSvgRenderer *renderer);
+
+private slots:
+    void rendererDestroyed(QObject *renderer);
+
+private:
+    SvgRasterCache();
+
+    // Every renderer gets a new generation number, it is part of the keys
+    // so that the pixmaps of a previous file or of a deleted renderer are never hit
+    QHash<QObject *, quint32> m_generations;
+    quint32 m_nextGeneration;
+};
+}
+
+#endif // SVGRASTERCACHE_H
@@ -53,6 +53,9 @@ SOURCES += reloadpromptutils.cpp \
     mytabbedstackwidget.cpp \
     mytabwidget.cpp \
     cachedsvgitem.cpp \
+    svgrastercache.cpp \
+    qmlobjectproxy.cpp \
+    rastersvgitem.cpp \
     svgimageprovider.cpp \
     hostosinfo.cpp \
     logfile.cpp \
@@ -113,6 +116,9 @@ HEADERS += utils_global.h \
     mytabbedstackwidget.h \
     mytabwidget.h \
     cachedsvgitem.h \
+    svgrastercache.h \
+    qmlobjectproxy.h \
+    rastersvgitem.h \
     svgimageprovider.h \
     hostosinfo.h \
     logfile.h \
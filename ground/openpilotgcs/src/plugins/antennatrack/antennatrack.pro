@@ -13,6 +13,7 @@ HEADERS += antennatrackwidget.h
 HEADERS += antennatrackgadgetfactory.h
 HEADERS += antennatrackgadgetconfiguration.h
 HEADERS += antennatrackgadgetoptionspage.h
+HEADERS += trackingengine.h
 SOURCES += antennatrackplugin.cpp
 SOURCES += gpsparser.cpp
 SOURCES += telemetryparser.cpp
@@ -21,6 +22,7 @@ SOURCES += antennatrackgadgetfactory.cpp
 SOURCES += antennatrackwidget.cpp
 SOURCES += antennatrackgadgetconfiguration.cpp
 SOURCES += antennatrackgadgetoptionspage.cpp
+SOURCES += trackingengine.cpp
 OTHER_FILES += AntennaTrack.pluginspec
 FORMS += antennatrackgadgetoptionspage.ui
 FORMS += antennatrackwidget.ui
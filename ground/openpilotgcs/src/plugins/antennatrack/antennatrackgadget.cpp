@@ -37,10 +37,22 @@ AntennaTrackGadget::AntennaTrackGadget(QString classId, AntennaTrackWidget *widg
 {
     connect(m_widget->connectButton, SIGNAL(clicked(bool)), this, SLOT(onConnect()));
     connect(m_widget->disconnectButton, SIGNAL(clicked(bool)), this, SLOT(onDisconnect()));
+
+    m_engine = new TrackingEngine();
+    m_engine->moveToThread(&m_trackerThread);
+    connect(&m_trackerThread, SIGNAL(started()), m_engine, SLOT(start()));
+    connect(&m_trackerThread, SIGNAL(finished()), m_engine, SLOT(deleteLater()));
+    connect(m_engine, SIGNAL(portStatus(bool)), this, SLOT(onPortStatus(bool)));
+    connect(m_engine, SIGNAL(dataReceived(QByteArray)), this, SLOT(processNewSerialData(QByteArray)));
+    connect(m_engine, SIGNAL(antennaPosition(double, double)), m_widget, SLOT(setAntennaPosition(double, double)));
+    m_trackerThread.start(QThread::TimeCriticalPriority);
 }
 
 AntennaTrackGadget::~AntennaTrackGadget()
-{}
+{
+    m_trackerThread.quit();
+    m_trackerThread.wait();
+}
 
 /*
    This is called when a configuration is loaded, and updates the plugin's settings.
@@ -50,10 +62,8 @@ AntennaTrackGadget::~AntennaTrackGadget()
  */
 void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
 {
-    // Delete the (old)port, this also closes it.
-    if (port) {
-        delete port;
-    }
+    // Close the (old)port
+    QMetaObject::invokeMethod(m_engine, "closePort", Qt::QueuedConnection);
 
     // Delete the (old)parser, this also disconnects all signals.
     if (parser) {
@@ -78,14 +88,11 @@ void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
         if (nport.portName() == AntennaTrackConfig->port()) {
             qDebug() << "Using Serial port";
             // parser = new NMEAParser();
-            port = new QSerialPort(nport);
-            m_widget->setPort(port);
+            m_engine->setPort(nport.portName(), m_portsettings);
             m_widget->connectButton->setEnabled(true);
             m_widget->disconnectButton->setEnabled(false);
             m_widget->connectButton->setHidden(false);
             m_widget->disconnectButton->setHidden(false);
-
-            connect(port, SIGNAL(readyRead()), this, SLOT(onDataAvailable()));
         }
     }
     m_widget->dataStreamGroupBox->setHidden(false);
@@ -100,51 +107,21 @@ void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
 void AntennaTrackGadget::onConnect()
 {
     m_widget->textBrowser->append(QString("Connecting to Tracker ...\n"));
-    // TODO: Somehow mark that we're running, and disable connect button while so?
-
-    if (port) {
-        qDebug() << "Opening: " << port->portName() << ".";
-        bool isOpen = port->open(QIODevice::ReadWrite);
-        qDebug() << "Open: " << isOpen;
-        if (isOpen) {
-            if (port->setBaudRate(m_portsettings.BaudRate)
-                && port->setDataBits(m_portsettings.DataBits)
-                && port->setParity(m_portsettings.Parity)
-                && port->setStopBits(m_portsettings.StopBits)
-                && port->setFlowControl(m_portsettings.FlowControl)) {
-                m_widget->connectButton->setEnabled(false);
-                m_widget->disconnectButton->setEnabled(true);
-            }
-        }
-    } else {
-        qDebug() << "Port undefined or invalid.";
-    }
+    // The buttons follow the port status reported by the engine
+    m_widget->connectButton->setEnabled(false);
+    QMetaObject::invokeMethod(m_engine, "openPort", Qt::QueuedConnection);
 }
 
 void AntennaTrackGadget::onDisconnect()
 {
-    if (port) {
-        qDebug() << "Closing: " << port->portName() << ".";
-        port->close();
-        m_widget->connectButton->setEnabled(true);
-        m_widget->disconnectButton->setEnabled(false);
-    } else {
-        qDebug() << "Port undefined or invalid.";
-    }
+    QMetaObject::invokeMethod(m_engine, "closePort", Qt::QueuedConnection);
 }
 
-void AntennaTrackGadget::onDataAvailable()
+void AntennaTrackGadget::onPortStatus(bool open)
 {
-    int avail = port->bytesAvailable();
-
-    if (avail > 0) {
-        QByteArray serialData;
-        serialData.resize(avail);
-        int bytesRead = port->read(serialData.data(), serialData.size());
-        if (bytesRead > 0) {
-            processNewSerialData(serialData);
-        }
-    }
+    qDebug() << "Open: " << open;
+    m_widget->connectButton->setEnabled(!open);
+    m_widget->disconnectButton->setEnabled(open);
 }
 
 void AntennaTrackGadget::processNewSerialData(QByteArray serialData)
@@ -28,10 +28,11 @@
 #ifndef ANTENNATRACKGADGET_H_
 #define ANTENNATRACKGADGET_H_
 
-#include <QtSerialPort/QSerialPort>
+#include <QThread>
 #include <coreplugin/iuavgadget.h>
 #include "antennatrackwidget.h"
 #include "telemetryparser.h"
+#include "trackingengine.h"
 
 class IUAVGadget;
 class QWidget;
@@ -59,14 +60,16 @@ public slots:
     void onDisconnect();
 
 private slots:
-    void onDataAvailable();
+    void onPortStatus(bool open);
+    void processNewSerialData(QByteArray serialData);
 
 private:
     QPointer<AntennaTrackWidget> m_widget;
-    QPointer<QSerialPort> port;
     QPointer<GPSParser> parser;
+    // the tracker is driven from its own thread, away from the GUI load
+    QThread m_trackerThread;
+    TrackingEngine *m_engine;
     bool connected;
-    void processNewSerialData(QByteArray serialData);
     PortSettings m_portsettings;
 };
 
@@ -0,0 +1,248 @@
+/**
+ ******************************************************************************
+ *
+ * @file       trackingengine.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup AntennaTrackGadgetPlugin Antenna Track Gadget Plugin
+ * @{
+ * @brief A gadget that communicates with antenna tracker and enables basic configuration
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "trackingengine.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "positionstate.h"
+#include "velocitystate.h"
+#include "gpspositionsensor.h"
+#include "homelocation.h"
+
+#include <math.h>
+#include <QMutexLocker>
+#include <QDebug>
+
+const double TrackingEngine::MaxExtrapolation = 2.0;
+const double TrackingEngine::StateTimeout     = 1.0;
+
+// Earth radius used for the local projection (m)
+#define EARTH_RADIUS 6371000.0
+#define DEG2RAD      (M_PI / 180.0)
+#define RAD2DEG      (180.0 / M_PI)
+// antennaPosition() every DISPLAY_DIVIDER outputs
+#define DISPLAY_DIVIDER 4
+
+TrackingEngine::TrackingEngine() :
+    m_timer(NULL), m_homeLat(0), m_homeLon(0), m_homeAlt(0), m_homeValid(false),
+    m_stepper(0), m_servo(0), m_displayCount(0)
+{
+    Sample invalid = { 0, 0, 0, 0, false };
+
+    m_position    = invalid;
+    m_velocity    = invalid;
+    m_gpsPosition = invalid;
+    m_gpsVelocity = invalid;
+}
+
+TrackingEngine::~TrackingEngine()
+{
+    closePort();
+}
+
+void TrackingEngine::setPort(const QString &portName, const PortSettings &settings)
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_portName     = portName;
+    m_portSettings = settings;
+}
+
+/**
+ * Started in the engine thread, the object updates are queued to it
+ */
+void TrackingEngine::start()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    connect(PositionState::GetInstance(objManager), SIGNAL(objectUpdated(UAVObject *)), this, SLOT(positionUpdated(UAVObject *)));
+    connect(VelocityState::GetInstance(objManager), SIGNAL(objectUpdated(UAVObject *)), this, SLOT(velocityUpdated(UAVObject *)));
+    connect(GPSPositionSensor::GetInstance(objManager), SIGNAL(objectUpdated(UAVObject *)), this, SLOT(gpsUpdated(UAVObject *)));
+    HomeLocation *home = HomeLocation::GetInstance(objManager);
+    connect(home, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(homeUpdated(UAVObject *)));
+    homeUpdated(home);
+
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(output()));
+    m_timer->start(OutputPeriod);
+}
+
+void TrackingEngine::openPort()
+{
+    QMutexLocker lock(&m_mutex);
+
+    closePort();
+    m_port = new QSerialPort(m_portName, this);
+    qDebug() << "Opening: " << m_portName << ".";
+    bool isOpen = m_port->open(QIODevice::ReadWrite)
+                  && m_port->setBaudRate(m_portSettings.BaudRate)
+                  && m_port->setDataBits(m_portSettings.DataBits)
+                  && m_port->setParity(m_portSettings.Parity)
+                  && m_port->setStopBits(m_portSettings.StopBits)
+                  && m_port->setFlowControl(m_portSettings.FlowControl);
+    if (isOpen) {
+        connect(m_port, SIGNAL(readyRead()), this, SLOT(onDataAvailable()));
+    } else {
+        delete m_port;
+    }
+    emit portStatus(isOpen);
+}
+
+void TrackingEngine::closePort()
+{
+    if (m_port) {
+        qDebug() << "Closing: " << m_port->portName() << ".";
+        delete m_port;
+        emit portStatus(false);
+    }
+}
+
+void TrackingEngine::onDataAvailable()
+{
+    QByteArray data = m_port->readAll();
+
+    if (!data.isEmpty()) {
+        emit dataReceived(data);
+    }
+}
+
+void TrackingEngine::positionUpdated(UAVObject *obj)
+{
+    PositionState::DataFields data = static_cast<PositionState *>(obj)->getData();
+    Sample sample = { data.North, data.East, data.Down, obj->getUpdateTime(), true };
+
+    m_position = sample;
+}
+
+void TrackingEngine::velocityUpdated(UAVObject *obj)
+{
+    VelocityState::DataFields data = static_cast<VelocityState *>(obj)->getData();
+    Sample sample = { data.North, data.East, data.Down, obj->getUpdateTime(), true };
+
+    m_velocity = sample;
+}
+
+void TrackingEngine::gpsUpdated(UAVObject *obj)
+{
+    GPSPositionSensor::DataFields data = static_cast<GPSPositionSensor *>(obj)->getData();
+
+    if (!m_homeValid) {
+        return;
+    }
+    Sample position = { 0, 0, 0, obj->getUpdateTime(), true };
+    toLocal(data.Latitude * 1e-7, data.Longitude * 1e-7, data.Altitude, position.north, position.east, position.down);
+    m_gpsPosition = position;
+
+    // only the horizontal speed is known
+    Sample velocity = { data.Groundspeed * cos(data.Heading * DEG2RAD), data.Groundspeed * sin(data.Heading * DEG2RAD),
+                        0, position.time, true };
+    m_gpsVelocity = velocity;
+}
+
+void TrackingEngine::homeUpdated(UAVObject *obj)
+{
+    HomeLocation::DataFields data = static_cast<HomeLocation *>(obj)->getData();
+
+    m_homeLat   = data.Latitude * 1e-7;
+    m_homeLon   = data.Longitude * 1e-7;
+    m_homeAlt   = data.Altitude;
+    m_homeValid = true;
+}
+
+/**
+ * Equirectangular projection around home, good enough at the tracking ranges
+ */
+void TrackingEngine::toLocal(double lat, double lon, double alt, double &north, double &east, double &down) const
+{
+    north = (lat - m_homeLat) * DEG2RAD * EARTH_RADIUS;
+    east  = (lon - m_homeLon) * DEG2RAD * EARTH_RADIUS * cos(m_homeLat * DEG2RAD);
+    down  = m_homeAlt - alt;
+}
+
+void TrackingEngine::output()
+{
+    double now = UAVObject::currentTime();
+
+    const Sample *position = NULL;
+
+    if (m_position.valid && now - m_position.time < StateTimeout) {
+        position = &m_position;
+    } else if (m_gpsPosition.valid) {
+        position = &m_gpsPosition;
+    } else {
+        return;
+    }
+    const Sample *velocity = NULL;
+    if (m_velocity.valid && now - m_velocity.time < StateTimeout) {
+        velocity = &m_velocity;
+    } else if (m_gpsVelocity.valid && now - m_gpsVelocity.time < MaxExtrapolation) {
+        velocity = &m_gpsVelocity;
+    }
+
+    // extrapolate from the flight time of the sample, which includes the link latency
+    double dt    = qBound(0.0, now - position->time, MaxExtrapolation);
+    double north = position->north;
+    double east  = position->east;
+    double down  = position->down;
+    if (velocity) {
+        north += velocity->north * dt;
+        east  += velocity->east * dt;
+        down  += velocity->down * dt;
+    }
+
+    double azimuth = atan2(east, north) * RAD2DEG;
+    if (azimuth < 0) {
+        azimuth += 360;
+    }
+    double d = sqrt(north * north + east * east);
+    // Elevation  v depends servo direction
+    double elevation = (d != 0) ? 90 - (atan(-down / d) * RAD2DEG) : 0;
+
+    // servo value 2000-4000, the stepper moves are relative
+    int servo   = (int)(2000.0 / 180 * elevation + 2000);
+    int stepper = qRound(400.0 / 360 * azimuth);
+
+    if (m_port && m_port->isOpen() && (stepper != m_stepper || servo != m_servo)) {
+        QString cmd;
+        cmd.sprintf("move %d 2000 2000 2000 %d\r", stepper - m_stepper, servo);
+        m_port->write(cmd.toLatin1());
+        m_stepper = stepper;
+        m_servo   = servo;
+    }
+
+    if (++m_displayCount >= DISPLAY_DIVIDER) {
+        m_displayCount = 0;
+        emit antennaPosition(azimuth, elevation);
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
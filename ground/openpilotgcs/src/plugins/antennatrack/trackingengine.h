@@ -0,0 +1,110 @@
+/**
+ ******************************************************************************
+ *
+ * @file       trackingengine.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup AntennaTrackGadgetPlugin Antenna Track Gadget Plugin
+ * @{
+ * @brief A gadget that communicates with antenna tracker and enables basic configuration
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRACKINGENGINE_H
+#define TRACKINGENGINE_H
+
+#include "antennatrackgadgetconfiguration.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QTimer>
+#include <QPointer>
+#include <QtSerialPort/QSerialPort>
+
+class UAVObject;
+
+/**
+ * Drives the tracker from a worker thread. The aircraft position relative to
+ * home comes from PositionState, or from GPSPositionSensor when the estimate
+ * is not sent, and is extrapolated with VelocityState (or the GPS ground speed)
+ * from the flight time of the sample to the send time, so the tracker does not
+ * lag by the GPS period plus the link latency.
+ */
+class TrackingEngine : public QObject {
+    Q_OBJECT
+
+public:
+    static const int OutputPeriod = 50; // ms
+    // the samples older than this are not extrapolated further (s)
+    static const double MaxExtrapolation;
+    // PositionState/VelocityState older than this fall back to the GPS (s)
+    static const double StateTimeout;
+
+    TrackingEngine();
+    ~TrackingEngine();
+
+    // thread safe, the port is opened by openPort() in the engine thread
+    void setPort(const QString &portName, const PortSettings &settings);
+
+signals:
+    void portStatus(bool open);
+    void dataReceived(QByteArray data);
+    // current target, at a display rate
+    void antennaPosition(double azimuth, double elevation);
+
+public slots:
+    void start();
+    void openPort();
+    void closePort();
+
+private slots:
+    void positionUpdated(UAVObject *obj);
+    void velocityUpdated(UAVObject *obj);
+    void gpsUpdated(UAVObject *obj);
+    void homeUpdated(UAVObject *obj);
+    void output();
+    void onDataAvailable();
+
+private:
+    struct Sample {
+        double north, east, down;
+        double time; // s, UAVObject::currentTime() clock
+        bool valid;
+    };
+
+    void toLocal(double lat, double lon, double alt, double &north, double &east, double &down) const;
+
+    QMutex m_mutex;
+    QString m_portName;
+    PortSettings m_portSettings;
+    QPointer<QSerialPort> m_port;
+    QTimer *m_timer;
+
+    double m_homeLat, m_homeLon, m_homeAlt; // deg, deg, m
+    bool m_homeValid;
+    Sample m_position;
+    Sample m_velocity;
+    Sample m_gpsPosition;
+    Sample m_gpsVelocity;
+
+    int m_stepper; // commanded stepper position
+    int m_servo;
+    int m_displayCount;
+};
+
+#endif // TRACKINGENGINE_H
@@ -38,6 +38,34 @@ float CalibrationUtils::ComputeSigma(Eigen::VectorXf *samplesY)
     return (float)sqrt((tmpd - mean).square().mean());
 }
 
+/*
+ * Remove the samples whose residual to the polynomial is more than maxSigmas
+ * standard deviations of the residuals away from their mean.
+ * Returns the number of samples removed.
+ */
+int CalibrationUtils::RejectOutliers(Eigen::VectorXf *samplesX, Eigen::VectorXf *samplesY, Eigen::VectorXf *polynomial, float maxSigmas)
+{
+    Eigen::VectorXf residuals(samplesX->rows());
+
+    ComputePoly(samplesX, polynomial, &residuals);
+    residuals = *samplesY - residuals;
+    float mean  = residuals.mean();
+    float limit = maxSigmas * ComputeSigma(&residuals);
+
+    int kept    = 0;
+    for (int i = 0; i < residuals.rows(); i++) {
+        if (fabs(residuals[i] - mean) <= limit) {
+            (*samplesX)[kept] = (*samplesX)[i];
+            (*samplesY)[kept] = (*samplesY)[i];
+            kept++;
+        }
+    }
+    int removed = residuals.rows() - kept;
+    samplesX->conservativeResize(kept);
+    samplesY->conservativeResize(kept);
+    return removed;
+}
+
 /*
  * The following ellipsoid calibration code is based on RazorImu calibration samples that can be found here:
  * https://github.com/ptrbrtz/razor-9dof-ahrs/tree/master/Matlab/magnetometer_calibration
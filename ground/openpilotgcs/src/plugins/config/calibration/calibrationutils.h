@@ -34,6 +34,53 @@
 #include <Eigen/LU>
 #include <QList>
 namespace OpenPilot {
+/**
+ * Samples of a few channels appended as they arrive, each channel is
+ * contiguous so that it is handed to the solvers as an Eigen vector.
+ */
+class SampleBuffer {
+public:
+    SampleBuffer(int channels) : m_data(0, channels), m_count(0) {}
+
+    void clear()
+    {
+        m_count = 0;
+    }
+    int count() const
+    {
+        return m_count;
+    }
+    bool isEmpty() const
+    {
+        return m_count == 0;
+    }
+    void append(float a, float b = 0.0f, float c = 0.0f, float d = 0.0f)
+    {
+        const float values[] = { a, b, c, d };
+
+        if (m_count == m_data.rows()) {
+            m_data.conservativeResize(qMax(2 * m_count, 256), Eigen::NoChange);
+        }
+        for (int i = 0; i < m_data.cols() && i < 4; i++) {
+            m_data(m_count, i) = values[i];
+        }
+        m_count++;
+    }
+    Eigen::VectorXf channel(int i) const
+    {
+        return m_data.col(i).head(m_count);
+    }
+    float last(int i) const
+    {
+        return m_data(m_count - 1, i);
+    }
+
+private:
+    // A column per channel, the rows past m_count are spare capacity
+    Eigen::MatrixXf m_data;
+    int m_count;
+};
+
 class CalibrationUtils {
 public:
     struct EllipsoidCalibrationResult {
@@ -49,6 +96,7 @@ public:
 
     static void ComputePoly(Eigen::VectorXf *samplesX, Eigen::VectorXf *polynomial, Eigen::VectorXf *polyY);
     static float ComputeSigma(Eigen::VectorXf *samplesY);
+    static int RejectOutliers(Eigen::VectorXf *samplesX, Eigen::VectorXf *samplesY, Eigen::VectorXf *polynomial, float maxSigmas);
 
     static int SixPointInConstFieldCal(double ConstMag, double x[6], double y[6], double z[6], double S[3], double b[3]);
     static double listMean(QList<double> list);
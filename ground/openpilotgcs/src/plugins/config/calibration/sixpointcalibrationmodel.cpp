@@ -31,6 +31,7 @@
 
 #include <math.h>
 #include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
 #include "QDebug"
 
 #define POINT_SAMPLE_SIZE 50
@@ -52,7 +53,9 @@ SixPointCalibrationModel::SixPointCalibrationModel(QObject *parent) :
     currentSteps(0),
     position(-1),
     collectingData(false),
-    m_dirty(false)
+    m_dirty(false),
+    mag_fit(3),
+    aux_mag_fit(3)
 {
     calibrationStepsMag.clear();
     calibrationStepsMag
@@ -214,9 +217,7 @@ void SixPointCalibrationModel::start(bool calibrateAccel, bool calibrateMag)
     mag_accum_y.clear();
     mag_accum_z.clear();
 
-    mag_fit_x.clear();
-    mag_fit_y.clear();
-    mag_fit_z.clear();
+    mag_fit.clear();
 
     // Need to get as many accel updates as possible
     memento.accelStateMetadata = accelState->getMetadata();
@@ -324,9 +325,7 @@ void SixPointCalibrationModel::getSample(UAVObject *obj)
             mag_accum_y.append(magData.y);
             mag_accum_z.append(magData.z);
 #ifndef FITTING_USING_CONTINOUS_ACQUISITION
-            mag_fit_x.append(magData.x);
-            mag_fit_y.append(magData.y);
-            mag_fit_z.append(magData.z);
+            mag_fit.append(magData.x, magData.y, magData.z);
 #endif // FITTING_USING_CONTINOUS_ACQUISITION
         } else if (obj->getObjID() == AuxMagSensor::OBJID) {
             AuxMagSensor::DataFields auxMagData = auxMagSensor->getData();
@@ -336,9 +335,7 @@ void SixPointCalibrationModel::getSample(UAVObject *obj)
                 aux_mag_accum_z.append(auxMagData.z);
                 calibratingAuxMag = true;
 #ifndef FITTING_USING_CONTINOUS_ACQUISITION
-                aux_mag_fit_x.append(auxMagData.x);
-                aux_mag_fit_y.append(auxMagData.y);
-                aux_mag_fit_z.append(auxMagData.z);
+                aux_mag_fit.append(auxMagData.x, auxMagData.y, auxMagData.z);
 #endif // FITTING_USING_CONTINOUS_ACQUISITION
             }
         } else {
@@ -416,15 +413,11 @@ void SixPointCalibrationModel::continouslyGetMagSamples(UAVObject *obj)
 
     if (obj->getObjID() == MagSensor::OBJID) {
         MagSensor::DataFields magSensorData = magSensor->getData();
-        mag_fit_x.append(magSensorData.x);
-        mag_fit_y.append(magSensorData.y);
-        mag_fit_z.append(magSensorData.z);
+        mag_fit.append(magSensorData.x, magSensorData.y, magSensorData.z);
     } else if (obj->getObjID() == AuxMagSensor::OBJID) {
         AuxMagSensor::DataFields auxMagData = auxMagSensor->getData();
         if (auxMagData.Status == AuxMagSensor::STATUS_OK) {
-            aux_mag_fit_x.append(auxMagData.x);
-            aux_mag_fit_y.append(auxMagData.y);
-            aux_mag_fit_z.append(auxMagData.z);
+            aux_mag_fit.append(auxMagData.x, auxMagData.y, auxMagData.z);
             calibratingAuxMag = true;
         }
     }
@@ -461,13 +454,16 @@ void SixPointCalibrationModel::compute()
     if (calibratingMag) {
         Be_length = sqrt(pow(homeLocationData.Be[0], 2) + pow(homeLocationData.Be[1], 2) + pow(homeLocationData.Be[2], 2));
 
-        qDebug() << "-----------------------------------";
-        qDebug() << "Onboard Mag";
-        calcCalibration(mag_fit_x, mag_fit_y, mag_fit_z, Be_length, revoCalibrationData.mag_transform, revoCalibrationData.mag_bias);
+        // The aux mag is fitted on a worker thread meanwhile
+        QFuture<void> auxFit;
         if (calibratingAuxMag) {
-            qDebug() << "Aux Mag";
-            calcCalibration(aux_mag_fit_x, aux_mag_fit_y, aux_mag_fit_z, Be_length, auxCalibrationData.mag_transform, auxCalibrationData.mag_bias);
+            auxFit = QtConcurrent::run(&SixPointCalibrationModel::calcCalibration, aux_mag_fit, Be_length,
+                                       &auxCalibrationData.mag_transform[0], &auxCalibrationData.mag_bias[0]);
         }
+        qDebug() << "-----------------------------------";
+        qDebug() << "Onboard Mag";
+        calcCalibration(mag_fit, Be_length, revoCalibrationData.mag_transform, revoCalibrationData.mag_bias);
+        auxFit.waitForFinished();
     }
     // Restore the previous setting
     revoCalibrationData.MagBiasNullingRate = memento.revoCalibrationData.MagBiasNullingRate;;
@@ -537,18 +533,12 @@ void SixPointCalibrationModel::compute()
     position = -1;
 }
 
-void SixPointCalibrationModel::calcCalibration(QList<float> x, QList<float> y, QList<float> z, double Be_length, float calibrationMatrix[], float bias[])
+void SixPointCalibrationModel::calcCalibration(SampleBuffer samples, double Be_length, float calibrationMatrix[], float bias[])
 {
-    int vectSize = x.count();
-    Eigen::VectorXf samples_x(vectSize);
-    Eigen::VectorXf samples_y(vectSize);
-    Eigen::VectorXf samples_z(vectSize);
-
-    for (int i = 0; i < vectSize; i++) {
-        samples_x(i) = x[i];
-        samples_y(i) = y[i];
-        samples_z(i) = z[i];
-    }
+    Eigen::VectorXf samples_x = samples.channel(0);
+    Eigen::VectorXf samples_y = samples.channel(1);
+    Eigen::VectorXf samples_z = samples.channel(2);
+
     OpenPilot::CalibrationUtils::EllipsoidCalibrationResult result;
     OpenPilot::CalibrationUtils::EllipsoidCalibration(&samples_x, &samples_y, &samples_z, Be_length, &result, true);
 
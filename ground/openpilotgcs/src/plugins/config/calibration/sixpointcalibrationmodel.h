@@ -129,16 +129,12 @@ public:
     QList<double> mag_accum_x;
     QList<double> mag_accum_y;
     QList<double> mag_accum_z;
-    QList<float> mag_fit_x;
-    QList<float> mag_fit_y;
-    QList<float> mag_fit_z;
+    SampleBuffer mag_fit;
 
     QList<double> aux_mag_accum_x;
     QList<double> aux_mag_accum_y;
     QList<double> aux_mag_accum_z;
-    QList<float> aux_mag_fit_x;
-    QList<float> aux_mag_fit_y;
-    QList<float> aux_mag_fit_z;
+    SampleBuffer aux_mag_fit;
 
     // convenience pointers
     RevoCalibration *revoCalibration;
@@ -154,7 +150,7 @@ public:
     void compute();
     void showHelp(QString image);
     UAVObjectManager *getObjectManager();
-    void calcCalibration(QList<float> x, QList<float> y, QList<float> z, double Be_length, float calibrationMatrix[], float bias[]);
+    static void calcCalibration(SampleBuffer samples, double Be_length, float calibrationMatrix[], float bias[]);
 };
 }
 
@@ -27,6 +27,7 @@
  */
 #include "QDebug"
 #include "thermalcalibration.h"
+#include <QtConcurrent/QtConcurrentRun>
 using namespace OpenPilot;
 
 void ThermalCalibration::ComputeStats(Eigen::VectorXf *samplesX, Eigen::VectorXf *samplesY, Eigen::VectorXf *correctionPoly, float *initialSigma, float *rebiasedSigma)
@@ -49,80 +50,91 @@ bool ThermalCalibration::BarometerCalibration(Eigen::VectorXf pressure, Eigen::V
     pressure.array() -= refZero;
     qDebug() << "Rebiased zero is " << pressure[index20deg];
 
-    Eigen::VectorXf solution(BARO_PRESSURE_POLY_DEGREE + 1);
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &pressure, BARO_PRESSURE_POLY_DEGREE, solution, BARO_PRESSURE_MAX_REL_ERROR)) {
+    AxisResult axis = AxisCalibration(temperature, pressure, BARO_PRESSURE_POLY_DEGREE, BARO_PRESSURE_MAX_REL_ERROR);
+    if (!axis.calibrated) {
         return false;
     }
-    copyToArray(result, solution, BARO_PRESSURE_POLY_DEGREE + 1);
-    ComputeStats(&temperature, &pressure, &solution, inputSigma, calibratedSigma);
+    copyToArray(result, axis.solution, BARO_PRESSURE_POLY_DEGREE + 1);
+    *inputSigma      = axis.inputSigma;
+    *calibratedSigma = axis.calibratedSigma;
     return (*calibratedSigma) < (*inputSigma);
 }
 
 bool ThermalCalibration::AccelerometerCalibration(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature, float *result, float *inputSigma, float *calibratedSigma)
 {
-    Eigen::VectorXf solution(ACCEL_X_POLY_DEGREE + 1);
+    const int degrees[3] = { ACCEL_X_POLY_DEGREE, ACCEL_Y_POLY_DEGREE, ACCEL_Z_POLY_DEGREE };
+    const double maxRelativeErrors[3] = { ACCEL_X_MAX_REL_ERROR, ACCEL_Y_MAX_REL_ERROR, ACCEL_Z_MAX_REL_ERROR };
+    AxisResult axes[3];
 
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &samplesX, ACCEL_X_POLY_DEGREE, solution, ACCEL_X_MAX_REL_ERROR)) {
+    if (!AxesCalibration(samplesX, samplesY, samplesZ, temperature, degrees, maxRelativeErrors, axes)) {
         return false;
     }
-    result[0]   = solution[1];
-
-    solution[0] = 0;
-    ComputeStats(&temperature, &samplesX, &solution, &inputSigma[0], &calibratedSigma[0]);
-
-    solution.resize(ACCEL_Y_POLY_DEGREE + 1);
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &samplesY, ACCEL_Y_POLY_DEGREE, solution, ACCEL_Y_MAX_REL_ERROR)) {
-        return false;
-    }
-    result[1]   = solution[1];
-
-    solution[0] = 0;
-    ComputeStats(&temperature, &samplesY, &solution, &inputSigma[1], &calibratedSigma[1]);
-
-    solution.resize(ACCEL_Z_POLY_DEGREE + 1);
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &samplesZ, ACCEL_Z_POLY_DEGREE, solution, ACCEL_Z_MAX_REL_ERROR)) {
-        return false;
+    for (int i = 0; i < 3; i++) {
+        result[i] = axes[i].solution[1];
+        inputSigma[i]      = axes[i].inputSigma;
+        calibratedSigma[i] = axes[i].calibratedSigma;
     }
-    result[2]   = solution[1];
-
-    solution[0] = 0;
-    ComputeStats(&temperature, &samplesZ, &solution, &inputSigma[2], &calibratedSigma[2]);
     return (inputSigma[0] > calibratedSigma[0]) && (inputSigma[1] > calibratedSigma[1]) && (inputSigma[2] > calibratedSigma[2]);
 }
 
 
 bool ThermalCalibration::GyroscopeCalibration(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature, float *result, float *inputSigma, float *calibratedSigma)
 {
-    Eigen::VectorXf solution(GYRO_X_POLY_DEGREE + 1);
+    const int degrees[3] = { GYRO_X_POLY_DEGREE, GYRO_Y_POLY_DEGREE, GYRO_Z_POLY_DEGREE };
+    const double maxRelativeErrors[3] = { GYRO_X_MAX_REL_ERROR, GYRO_Y_MAX_REL_ERROR, GYRO_Z_MAX_REL_ERROR };
+    AxisResult axes[3];
 
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &samplesX, GYRO_X_POLY_DEGREE, solution, GYRO_X_MAX_REL_ERROR)) {
+    if (!AxesCalibration(samplesX, samplesY, samplesZ, temperature, degrees, maxRelativeErrors, axes)) {
         return false;
     }
+    for (int i = 0; i < 3; i++) {
+        result[2 * i]      = axes[i].solution[1];
+        result[2 * i + 1]  = axes[i].solution[2];
+        inputSigma[i]      = axes[i].inputSigma;
+        calibratedSigma[i] = axes[i].calibratedSigma;
+    }
+    return (inputSigma[0] > calibratedSigma[0]) && (inputSigma[1] > calibratedSigma[1]) && (inputSigma[2] > calibratedSigma[2]);
+}
 
-    result[0]   = solution[1];
-    result[1]   = solution[2];
-    solution[0] = 0;
-    ComputeStats(&temperature, &samplesX, &solution, &inputSigma[0], &calibratedSigma[0]);
-
-
-    solution.resize(GYRO_Y_POLY_DEGREE + 1);
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &samplesY, GYRO_Y_POLY_DEGREE, solution, GYRO_Y_MAX_REL_ERROR)) {
-        return false;
+/**
+ * Fit the polynomial of one axis, then fit it again without the outliers.
+ * The sigmas do not depend on the constant term, that is not sent to the board.
+ */
+ThermalCalibration::AxisResult ThermalCalibration::AxisCalibration(Eigen::VectorXf temperature, Eigen::VectorXf samples, int degree, double maxRelativeError)
+{
+    AxisResult axis;
+
+    axis.solution.resize(degree + 1);
+    axis.inputSigma      = 0;
+    axis.calibratedSigma = 0;
+    axis.calibrated = CalibrationUtils::PolynomialCalibration(&temperature, &samples, degree, axis.solution, maxRelativeError);
+    if (!axis.calibrated) {
+        return axis;
     }
-    result[2]   = solution[1];
-    result[3]   = solution[2];
-    solution[0] = 0;
-    ComputeStats(&temperature, &samplesY, &solution, &inputSigma[1], &calibratedSigma[1]);
 
-    solution.resize(GYRO_Z_POLY_DEGREE + 1);
-    if (!CalibrationUtils::PolynomialCalibration(&temperature, &samplesZ, GYRO_Z_POLY_DEGREE, solution, GYRO_Z_MAX_REL_ERROR)) {
-        return false;
+    int rejected = CalibrationUtils::RejectOutliers(&temperature, &samples, &axis.solution, OUTLIER_MAX_SIGMAS);
+    if (rejected > 0 && samples.rows() > degree) {
+        qDebug() << "Rejected" << rejected << "outliers";
+        axis.calibrated = CalibrationUtils::PolynomialCalibration(&temperature, &samples, degree, axis.solution, maxRelativeError);
     }
-    result[4]   = solution[1];
-    result[5]   = solution[2];
-    solution[0] = 0;
-    ComputeStats(&temperature, &samplesZ, &solution, &inputSigma[2], &calibratedSigma[2]);
-    return (inputSigma[0] > calibratedSigma[0]) && (inputSigma[1] > calibratedSigma[1]) && (inputSigma[2] > calibratedSigma[2]);
+    ComputeStats(&temperature, &samples, &axis.solution, &axis.inputSigma, &axis.calibratedSigma);
+    return axis;
+}
+
+/**
+ * Calibrate the three axes of a sensor, in parallel.
+ */
+bool ThermalCalibration::AxesCalibration(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature,
+                                         const int degrees[3], const double maxRelativeErrors[3], AxisResult results[3])
+{
+    QFuture<AxisResult> x = QtConcurrent::run(&ThermalCalibration::AxisCalibration, temperature, samplesX, degrees[0], maxRelativeErrors[0]);
+    QFuture<AxisResult> y = QtConcurrent::run(&ThermalCalibration::AxisCalibration, temperature, samplesY, degrees[1], maxRelativeErrors[1]);
+
+    // The calling thread takes the last axis
+    results[2] = AxisCalibration(temperature, samplesZ, degrees[2], maxRelativeErrors[2]);
+    results[0] = x.result();
+    results[1] = y.result();
+    return results[0].calibrated && results[1].calibrated && results[2].calibrated;
 }
 
 void ThermalCalibration::copyToArray(float *result, Eigen::VectorXf solution, int elements)
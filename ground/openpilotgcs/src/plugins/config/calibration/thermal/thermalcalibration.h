@@ -48,6 +48,15 @@ class ThermalCalibration {
     static const double GYRO_X_MAX_REL_ERROR   = 1E-6f;
     static const double GYRO_Y_MAX_REL_ERROR   = 1E-6f;
     static const double GYRO_Z_MAX_REL_ERROR   = 1E-6f;
+    // residuals further from their mean are dropped before the final fit
+    static const float OUTLIER_MAX_SIGMAS = 3.0f;
+
+    struct AxisResult {
+        bool calibrated;
+        Eigen::VectorXf solution;
+        float inputSigma;
+        float calibratedSigma;
+    };
 public:
 
     /**
@@ -98,6 +107,9 @@ public:
 
 
 private:
+    static AxisResult AxisCalibration(Eigen::VectorXf temperature, Eigen::VectorXf samples, int degree, double maxRelativeError);
+    static bool AxesCalibration(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature,
+                                const int degrees[3], const double maxRelativeErrors[3], AxisResult results[3]);
     static void copyToArray(float *result, Eigen::VectorXf solution, int elements);
     ThermalCalibration();
     static int searchReferenceValue(float value, Eigen::VectorXf values);
@@ -32,13 +32,14 @@
 #include "version_info/version_info.h"
 
 #include <math.h>
+#include <QtConcurrent/QtConcurrentRun>
 
 // uncomment to simulate board warming up (no need to put it in the fridge...)
 // #define SIMULATE
 
 namespace OpenPilot {
 ThermalCalibrationHelper::ThermalCalibrationHelper(QObject *parent) :
-    QObject(parent)
+    QObject(parent), m_accelSamples(4), m_gyroSamples(4), m_baroSamples(2), m_useCalibrationStats(false), m_pendingCalculations(0)
 {
     m_tempdir.reset(new QTemporaryDir());
 
@@ -57,12 +58,23 @@ ThermalCalibrationHelper::ThermalCalibrationHelper(QObject *parent) :
     gyroSensor        = GyroSensor::GetInstance(getObjectManager());
     baroSensor        = BaroSensor::GetInstance(getObjectManager());
     magSensor         = MagSensor::GetInstance(getObjectManager());
+    calibrationStats  = SensorCalibrationStats::GetInstance(getObjectManager());
     accelGyroSettings = AccelGyroSettings::GetInstance(getObjectManager());
     revoSettings      = RevoSettings::GetInstance(getObjectManager());
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
     connect(telMngr, SIGNAL(disconnected()), this, SLOT(cleanup()));
+
+    connect(&m_baroWatcher, SIGNAL(finished()), this, SLOT(baroCalculated()));
+    connect(&m_gyroWatcher, SIGNAL(finished()), this, SLOT(gyroCalculated()));
+}
+
+ThermalCalibrationHelper::~ThermalCalibrationHelper()
+{
+    // the workers write the results
+    m_baroWatcher.waitForFinished();
+    m_gyroWatcher.waitForFinished();
 }
 
 /**
@@ -74,6 +86,8 @@ bool ThermalCalibrationHelper::setupBoardForCalibration()
     setMetadataForCalibration(accelSensor);
     setMetadataForCalibration(gyroSensor);
     setMetadataForCalibration(baroSensor);
+    // boards aggregating the samples onboard report them instead of the raw stream
+    setCalibrationStatsPeriod(CalibrationStatsPeriod);
 
     // Clean up any gyro/accel correction before calibrating
     AccelGyroSettings::DataFields data = accelGyroSettings->getData();
@@ -138,6 +152,7 @@ bool ThermalCalibrationHelper::restoreInitialSettings()
     accelSensor->setMetadata(m_memento.accelSensorMeta);
     gyroSensor->setMetadata(m_memento.gyroSensorMeta);
     baroSensor->setMetadata(m_memento.baroensorMeta);
+    setCalibrationStatsPeriod(0);
     accelGyroSettings->setData(m_memento.accelGyroSettings);
     revoSettings->setData(m_memento.revoSettings);
 
@@ -183,7 +198,7 @@ void ThermalCalibrationHelper::initAcquisition()
     m_accelSamples.clear();
     m_gyroSamples.clear();
     m_baroSamples.clear();
-    m_magSamples.clear();
+    m_useCalibrationStats = false;
 
     m_results.accelCalibrated = false;
     m_results.gyroCalibrated  = false;
@@ -218,23 +233,64 @@ void ThermalCalibrationHelper::collectSample(UAVObject *sample)
     }
 
     switch (sample->getObjID()) {
+    case SensorCalibrationStats::OBJID:
+    {
+        if (!m_useCalibrationStats) {
+            // the board aggregates the samples, drop the raw ones and stop their stream
+            m_useCalibrationStats = true;
+            m_accelSamples.clear();
+            m_gyroSamples.clear();
+            accelSensor->setMetadata(m_memento.accelSensorMeta);
+            gyroSensor->setMetadata(m_memento.gyroSensorMeta);
+        }
+        SensorCalibrationStats::DataFields data = calibrationStats->getData();
+        if (data.Count[SensorCalibrationStats::COUNT_ACCEL] > 0) {
+            m_accelSamples.append(data.AccelMean[SensorCalibrationStats::ACCELMEAN_X], data.AccelMean[SensorCalibrationStats::ACCELMEAN_Y],
+                                  data.AccelMean[SensorCalibrationStats::ACCELMEAN_Z], data.Temperature[SensorCalibrationStats::TEMPERATURE_ACCEL]);
+        }
+        if (data.Count[SensorCalibrationStats::COUNT_GYRO] > 0) {
+            m_gyroSamples.append(data.GyroMean[SensorCalibrationStats::GYROMEAN_X], data.GyroMean[SensorCalibrationStats::GYROMEAN_Y],
+                                 data.GyroMean[SensorCalibrationStats::GYROMEAN_Z], data.Temperature[SensorCalibrationStats::TEMPERATURE_GYRO]);
+        }
+        m_debugStream << "STATS:: " << data.Temperature[SensorCalibrationStats::TEMPERATURE_GYRO]
+                      << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
+                      << "\t" << data.Count[SensorCalibrationStats::COUNT_ACCEL]
+                      << "\t" << data.Count[SensorCalibrationStats::COUNT_GYRO]
+                      << "\t" << data.GyroVariance[SensorCalibrationStats::GYROVARIANCE_X]
+                      << "\t" << data.GyroVariance[SensorCalibrationStats::GYROVARIANCE_Y]
+                      << "\t" << data.GyroVariance[SensorCalibrationStats::GYROVARIANCE_Z] << endl;
+        break;
+    }
+
     case AccelSensor::OBJID:
-        m_accelSamples.append(accelSensor->getData());
-        m_debugStream << "ACCEL:: " << m_accelSamples.last().temperature
+    {
+        if (m_useCalibrationStats) {
+            break;
+        }
+        AccelSensor::DataFields data = accelSensor->getData();
+        m_accelSamples.append(data.x, data.y, data.z, data.temperature);
+        m_debugStream << "ACCEL:: " << data.temperature
                       << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_accelSamples.last().x
-                      << "\t" << m_accelSamples.last().y
-                      << "\t" << m_accelSamples.last().z << endl;
+                      << "\t" << data.x
+                      << "\t" << data.y
+                      << "\t" << data.z << endl;
         break;
+    }
 
     case GyroSensor::OBJID:
-        m_gyroSamples.append(gyroSensor->getData());
-        m_debugStream << "GYRO:: " << m_gyroSamples.last().temperature
+    {
+        if (m_useCalibrationStats) {
+            break;
+        }
+        GyroSensor::DataFields data = gyroSensor->getData();
+        m_gyroSamples.append(data.x, data.y, data.z, data.temperature);
+        m_debugStream << "GYRO:: " << data.temperature
                       << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_gyroSamples.last().x
-                      << "\t" << m_gyroSamples.last().y
-                      << "\t" << m_gyroSamples.last().z << endl;
+                      << "\t" << data.x
+                      << "\t" << data.y
+                      << "\t" << data.z << endl;
         break;
+    }
 
     case BaroSensor::OBJID:
     {
@@ -244,23 +300,26 @@ void ThermalCalibrationHelper::collectSample(UAVObject *sample)
         data.Temperature = temp;
         data.Pressure   += 10.0f * temp;
 #endif
-        m_baroSamples.append(data);
-        m_debugStream << "BARO:: " << m_baroSamples.last().Temperature
+        m_baroSamples.append(data.Pressure, data.Temperature);
+        m_debugStream << "BARO:: " << data.Temperature
                       << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_baroSamples.last().Pressure
-                      << "\t" << m_baroSamples.last().Altitude << endl;
+                      << "\t" << data.Pressure
+                      << "\t" << data.Altitude << endl;
         // must be done last as this call might end acquisition and close the debug log file
         updateTemperature(temp);
         break;
     }
 
     case MagSensor::OBJID:
-        m_magSamples.append(magSensor->getData());
+    {
+        // only logged
+        MagSensor::DataFields data = magSensor->getData();
         m_debugStream << "MAG:: " << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_magSamples.last().x
-                      << "\t" << m_magSamples.last().y
-                      << "\t" << m_magSamples.last().z << endl;
+                      << "\t" << data.x
+                      << "\t" << data.y
+                      << "\t" << data.z << endl;
         break;
+    }
 
     default:
         qDebug() << "Unexpected object" << sample->getObjID();
@@ -289,6 +348,7 @@ float ThermalCalibrationHelper::getTemperature()
 void ThermalCalibrationHelper::endAcquisition()
 {
     disconnectUAVOs();
+    setCalibrationStatsPeriod(0);
 }
 
 void ThermalCalibrationHelper::cleanup()
@@ -300,72 +360,67 @@ void ThermalCalibrationHelper::cleanup()
 
 void ThermalCalibrationHelper::calculate()
 {
-    // baro
-    int count = m_baroSamples.count();
-    Eigen::VectorXf datax(count);
-    Eigen::VectorXf datay(1);
-    Eigen::VectorXf dataz(1);
-    Eigen::VectorXf datat(count);
-
-    for (int x = 0; x < count; x++) {
-        datax[x] = m_baroSamples[x].Pressure;
-        datat[x] = m_baroSamples[x].Temperature;
-    }
+    // The acquisition is over, the buffers are not touched until the next one
+    m_pendingCalculations = 2;
+    setProgressMax(m_pendingCalculations);
+    setProgress(0);
+    m_baroWatcher.setFuture(QtConcurrent::run(this, &ThermalCalibrationHelper::calculateBaro,
+                                              m_baroSamples.channel(0), m_baroSamples.channel(1)));
+    m_gyroWatcher.setFuture(QtConcurrent::run(this, &ThermalCalibrationHelper::calculateGyro,
+                                              m_gyroSamples.channel(0), m_gyroSamples.channel(1),
+                                              m_gyroSamples.channel(2), m_gyroSamples.channel(3)));
+}
 
-    m_results.baroCalibrated = ThermalCalibration::BarometerCalibration(datax, datat, m_results.baro,
+void ThermalCalibrationHelper::calculateBaro(Eigen::VectorXf pressure, Eigen::VectorXf temperature)
+{
+    m_results.baroCalibrated = ThermalCalibration::BarometerCalibration(pressure, temperature, m_results.baro,
                                                                         &m_results.baroInSigma, &m_results.baroOutSigma);
+    m_results.baroTempMin    = temperature.array().minCoeff();
+    m_results.baroTempMax    = temperature.array().maxCoeff();
+}
+
+void ThermalCalibrationHelper::calculateGyro(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature)
+{
+    m_results.gyroCalibrated   = ThermalCalibration::GyroscopeCalibration(samplesX, samplesY, samplesZ, temperature, m_results.gyro,
+                                                                          m_results.gyroInSigma, m_results.gyroOutSigma);
+    m_results.accelGyroTempMin = temperature.array().minCoeff();
+    m_results.accelGyroTempMax = temperature.array().maxCoeff();
+}
+
+void ThermalCalibrationHelper::baroCalculated()
+{
     if (m_results.baroCalibrated) {
         addInstructions(tr("Barometer is calibrated."));
     } else {
         qDebug() << "Failed to calibrate baro!";
         addInstructions(tr("Failed to calibrate barometer!"), WizardModel::Warn);
     }
+    calculationStepCompleted();
+}
 
-    m_results.baroTempMin = datat.array().minCoeff();
-    m_results.baroTempMax = datat.array().maxCoeff();
-
-    // gyro
-    count = m_gyroSamples.count();
-    datax.resize(count);
-    datay.resize(count);
-    dataz.resize(count);
-    datat.resize(count);
-
-    for (int x = 0; x < count; x++) {
-        datax[x] = m_gyroSamples[x].x;
-        datay[x] = m_gyroSamples[x].y;
-        dataz[x] = m_gyroSamples[x].z;
-        datat[x] = m_gyroSamples[x].temperature;
-    }
-
-    m_results.gyroCalibrated = ThermalCalibration::GyroscopeCalibration(datax, datay, dataz, datat, m_results.gyro,
-                                                                        m_results.gyroInSigma, m_results.gyroOutSigma);
+void ThermalCalibrationHelper::gyroCalculated()
+{
     if (m_results.gyroCalibrated) {
         addInstructions(tr("Gyro is calibrated."));
     } else {
         qDebug() << "Failed to calibrate gyro!";
         addInstructions(tr("Failed to calibrate gyro!"), WizardModel::Warn);
     }
+    calculationStepCompleted();
+}
+
+void ThermalCalibrationHelper::calculationStepCompleted()
+{
+    setProgress(m_progress + 1);
+    if (--m_pendingCalculations > 0) {
+        return;
+    }
 
     // accel
-    m_results.accelGyroTempMin = datat.array().minCoeff();
-    m_results.accelGyroTempMax = datat.array().maxCoeff();
     // TODO: sanity checks needs to be enforced before accel calibration can be enabled and usable.
     /*
-       count = m_accelSamples.count();
-       datax.resize(count);
-       datay.resize(count);
-       dataz.resize(count);
-       datat.resize(count);
-
-       for(int x = 0; x < count; x++){
-       datax[x] = m_accelSamples[x].x;
-       datay[x] = m_accelSamples[x].y;
-       dataz[x] = m_accelSamples[x].z;
-       datat[x] = m_accelSamples[x].temperature;
-       }
-
-       m_results.accelCalibrated = ThermalCalibration::AccelerometerCalibration(datax, datay, dataz, datat, m_results.accel);
+       m_results.accelCalibrated = ThermalCalibration::AccelerometerCalibration(m_accelSamples.channel(0), m_accelSamples.channel(1),
+                                                                                m_accelSamples.channel(2), m_accelSamples.channel(3), m_results.accel);
      */
     m_results.accelCalibrated  = false;
     QString str = QStringLiteral("INFO::Calibration results") + "\n";
@@ -461,6 +516,7 @@ void ThermalCalibrationHelper::connectUAVOs()
     connect(gyroSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
     connect(baroSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
     connect(magSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
+    connect(calibrationStats, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
 }
 
 void ThermalCalibrationHelper::disconnectUAVOs()
@@ -469,6 +525,20 @@ void ThermalCalibrationHelper::disconnectUAVOs()
     disconnect(gyroSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
     disconnect(baroSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
     disconnect(magSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
+    disconnect(calibrationStats, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
+}
+
+/**
+ * @brief Set the period of the onboard sample statistics, 0 stops them.
+ * Ignored by the boards without SensorCalibrationStats, they keep the raw stream
+ */
+void ThermalCalibrationHelper::setCalibrationStatsPeriod(quint16 period)
+{
+    SensorCalibrationStats::DataFields data = calibrationStats->getData();
+
+    data.Period = period;
+    calibrationStats->setData(data);
+    calibrationStats->updated();
 }
 
 void ThermalCalibrationHelper::createDebugLog()
@@ -33,6 +33,7 @@
 #include <QTime>
 #include <QTemporaryDir>
 #include <QTextStream>
+#include <QFutureWatcher>
 
 #include "uavobjectmanager.h"
 #include <uavobject.h>
@@ -45,6 +46,7 @@
 #include <gyrosensor.h>
 #include <barosensor.h>
 #include <magsensor.h>
+#include <sensorcalibrationstats.h>
 #include "accelgyrosettings.h"
 
 // Calibration data
@@ -53,6 +55,7 @@
 #include <revosettings.h>
 
 #include "../wizardmodel.h"
+#include "../calibrationutils.h"
 
 namespace OpenPilot {
 typedef struct {
@@ -96,6 +99,7 @@ public:
     const static float TargetTempDelta = 10.0f;
 
     explicit ThermalCalibrationHelper(QObject *parent = 0);
+    ~ThermalCalibrationHelper();
 
     float temperature()
     {
@@ -208,6 +212,10 @@ public slots:
 
     void cleanup();
 
+private slots:
+    void baroCalculated();
+    void gyroCalculated();
+
 private:
     float getTemperature();
     void updateTemperature(float temp);
@@ -223,10 +231,25 @@ private:
 
     QMutex sensorsUpdateLock;
 
-    QList<AccelSensor::DataFields> m_accelSamples;
-    QList<GyroSensor::DataFields> m_gyroSamples;
-    QList<BaroSensor::DataFields> m_baroSamples;
-    QList<MagSensor::DataFields> m_magSamples;
+    // x, y, z, temperature
+    SampleBuffer m_accelSamples;
+    SampleBuffer m_gyroSamples;
+    // pressure, temperature
+    SampleBuffer m_baroSamples;
+
+    // accel and gyro samples are the means aggregated onboard over this period (ms),
+    // once the board reports them, instead of the raw sensor stream
+    const static quint16 CalibrationStatsPeriod = 500;
+    bool m_useCalibrationStats;
+    void setCalibrationStatsPeriod(quint16 period);
+
+    // the fits run on worker threads
+    QFutureWatcher<void> m_baroWatcher;
+    QFutureWatcher<void> m_gyroWatcher;
+    int m_pendingCalculations;
+    void calculateBaro(Eigen::VectorXf pressure, Eigen::VectorXf temperature);
+    void calculateGyro(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature);
+    void calculationStepCompleted();
 
     // temperature checkpoints, used to calculate temp gradient
     const static int TimeBetweenCheckpoints = 10;
@@ -256,6 +279,7 @@ private:
     GyroSensor *gyroSensor;
     BaroSensor *baroSensor;
     MagSensor *magSensor;
+    SensorCalibrationStats *calibrationStats;
     AccelGyroSettings *accelGyroSettings;
     RevoSettings *revoSettings;
 
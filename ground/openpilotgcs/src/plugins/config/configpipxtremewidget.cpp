@@ -68,6 +68,7 @@ ConfigPipXtremeWidget::ConfigPipXtremeWidget(QWidget *parent) : ConfigTaskWidget
     addWidgetBinding("OPLinkSettings", "PPMOnly", m_oplink->PPMOnly);
     addWidgetBinding("OPLinkSettings", "PPM", m_oplink->PPM);
     addWidgetBinding("OPLinkSettings", "ComSpeed", m_oplink->ComSpeed);
+    addWidgetBinding("OPLinkSettings", "AdaptiveRate", m_oplink->AdaptiveRate);
 
     addWidgetBinding("OPLinkStatus", "DeviceID", m_oplink->DeviceID);
     addWidgetBinding("OPLinkStatus", "RxGood", m_oplink->Good);
@@ -316,6 +317,7 @@ void ConfigPipXtremeWidget::ppmOnlyChanged()
     m_oplink->PPM->setEnabled(!is_ppm_only);
     m_oplink->OneWayLink->setEnabled(!is_ppm_only);
     m_oplink->ComSpeed->setEnabled(!is_ppm_only);
+    m_oplink->AdaptiveRate->setEnabled(!is_ppm_only);
 }
 
 /**
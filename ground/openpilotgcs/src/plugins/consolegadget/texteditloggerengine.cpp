@@ -30,11 +30,20 @@
 #include <QTime>
 #include <QtGui/QTextEdit>
 #include <QtGui/QScrollBar>
+#include <QtGui/QTextDocument>
+#include <QStringList>
 #include <QObject>
 
 #define QXT_REQUIRED_LEVELS (QxtLogger::WarningLevel | QxtLogger::ErrorLevel | QxtLogger::CriticalLevel | QxtLogger::FatalLevel)
 
-TextEditLoggerEngine::TextEditLoggerEngine(QTextEdit *textEdit) : m_textEdit(textEdit)
+// Interval of the writes to the text edit
+#define FLUSH_INTERVAL_MS 100
+// Messages queued between two writes, older ones are dropped
+#define MAX_PENDING_MESSAGES 500
+// Lines kept by the text edit
+#define MAX_LINES 5000
+
+TextEditLoggerEngine::TextEditLoggerEngine(QTextEdit *textEdit) : m_textEdit(textEdit), m_dropped(0)
 {
 #ifndef QT_NO_DEBUG
     setLogLevelsEnabled(QXT_REQUIRED_LEVELS);
@@ -42,6 +51,11 @@ TextEditLoggerEngine::TextEditLoggerEngine(QTextEdit *textEdit) : m_textEdit(tex
     setLogLevelsEnabled(QXT_REQUIRED_LEVELS | QxtLogger::DebugLevel);
 #endif
     enableLogging();
+
+    m_textEdit->document()->setMaximumBlockCount(MAX_LINES);
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
 }
 
 TextEditLoggerEngine::~TextEditLoggerEngine()
@@ -73,47 +87,90 @@ void TextEditLoggerEngine::setLogLevelEnabled(QxtLogger::LogLevels level, bool e
 
 void TextEditLoggerEngine::writeFormatted(QxtLogger::LogLevel level, const QList<QVariant> &msgs)
 {
-    switch (level) {
+    // Filter before anything is formatted, the text is only built when flushed
+    if (msgs.isEmpty() || !isLogLevelEnabled(level)) {
+        return;
+    }
+
+    if (m_pending.size() >= MAX_PENDING_MESSAGES) {
+        m_pending.removeFirst();
+        m_dropped++;
+    }
+    Message message;
+    message.level = level;
+    message.time  = QTime::currentTime();
+    message.msgs  = msgs;
+    m_pending.append(message);
+
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void TextEditLoggerEngine::flush()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    Q_ASSERT(m_textEdit);
+
+    QStringList lines;
+    if (m_dropped > 0) {
+        lines << formatMessage(QTime::currentTime(), "Warning",
+                               QList<QVariant>() << QString("%1 messages dropped").arg(m_dropped), Qt::red);
+        m_dropped = 0;
+    }
+    foreach(const Message &message, m_pending) {
+        lines << formatMessage(message);
+    }
+    m_pending.clear();
+
+    // A single append for the whole batch
+    QScrollBar *sb = m_textEdit->verticalScrollBar();
+    bool scroll    = sb->value() == sb->maximum();
+    m_textEdit->append(lines.join("<br>"));
+    if (scroll) {
+        sb->setValue(sb->maximum());
+    }
+}
+
+QString TextEditLoggerEngine::formatMessage(const Message &message) const
+{
+    switch (message.level) {
     case QxtLogger::ErrorLevel:
-        writeToTextEdit("Error", msgs, Qt::red);
-        break;
+        return formatMessage(message.time, "Error", message.msgs, Qt::red);
+
     case QxtLogger::WarningLevel:
-        writeToTextEdit("Warning", msgs, Qt::red);
-        break;
+        return formatMessage(message.time, "Warning", message.msgs, Qt::red);
+
     case QxtLogger::CriticalLevel:
-        writeToTextEdit("Critical", msgs, Qt::red);
-        break;
+        return formatMessage(message.time, "Critical", message.msgs, Qt::red);
+
     case QxtLogger::FatalLevel:
-        writeToTextEdit("!!FATAL!!", msgs, Qt::red);
-        break;
+        return formatMessage(message.time, "!!FATAL!!", message.msgs, Qt::red);
+
     case QxtLogger::TraceLevel:
-        writeToTextEdit("Trace", msgs, Qt::blue);
-        break;
+        return formatMessage(message.time, "Trace", message.msgs, Qt::blue);
+
     case QxtLogger::DebugLevel:
-        writeToTextEdit("DEBUG", msgs, Qt::blue);
-        break;
+        return formatMessage(message.time, "DEBUG", message.msgs, Qt::blue);
+
     case QxtLogger::InfoLevel:
-        writeToTextEdit("INFO", msgs);
-        break;
+        return formatMessage(message.time, "INFO", message.msgs);
+
     default:
-        writeToTextEdit("", msgs);
-        break;
+        return formatMessage(message.time, "", message.msgs);
     }
 }
 
-void TextEditLoggerEngine::writeToTextEdit(const QString & level, const QList<QVariant> &msgs, QColor color)
+QString TextEditLoggerEngine::formatMessage(const QTime &time, const QString & level, const QList<QVariant> &msgs, QColor color) const
 {
     /* Message format...
         [time] [error level] First message.....
                     second message
                     third message
      */
-    if (msgs.isEmpty()) {
-        return;
-    }
-    QScrollBar *sb = m_textEdit->verticalScrollBar();
-    bool scroll    = sb->value() == sb->maximum();
-    QString header = '[' + QTime::currentTime().toString("hh:mm:ss.zzz") + "] [" + level + "] ";
+    QString header = '[' + time.toString("hh:mm:ss.zzz") + "] [" + level + "] ";
     QString padding;
     QString appendText;
     appendText.append(header);
@@ -130,10 +187,5 @@ void TextEditLoggerEngine::writeToTextEdit(const QString & level, const QList<QV
         }
         count++;
     }
-    Q_ASSERT(m_textEdit);
-    appendText = QString("<font color=%1>%2</font>").arg(color.name()).arg(appendText);
-    m_textEdit->append(appendText);
-    if (scroll) {
-        sb->setValue(sb->maximum());
-    }
+    return QString("<font color=%1>%2</font>").arg(color.name()).arg(appendText);
 }
@@ -33,9 +33,21 @@
 #include "qxtloggerengine.h"
 #include "qxtglobal.h"
 #include <QtGui/QColor>
+#include <QObject>
+#include <QTimer>
+#include <QTime>
 class QTextEdit;
 
-class TextEditLoggerEngine : public QxtLoggerEngine {
+/**
+ * Logger engine of the console gadget.
+ *
+ * The messages are queued and written to the text edit in batches by
+ * a timer, so that a burst of messages does not block the GUI. The
+ * queue is bounded, the oldest messages are dropped when it is full.
+ */
+class TextEditLoggerEngine : public QObject, public QxtLoggerEngine {
+    Q_OBJECT
+
 public:
     TextEditLoggerEngine(QTextEdit *textEdit);
     ~TextEditLoggerEngine();
@@ -47,9 +59,22 @@ public:
 
     bool isInitialized() const;
 
+private slots:
+    void flush();
+
 private:
-    virtual void writeToTextEdit(const QString & str_level, const QList<QVariant> &msgs, QColor color = QColor(0, 0, 0));
+    struct Message {
+        QxtLogger::LogLevel level;
+        QTime time;
+        QList<QVariant>     msgs;
+    };
+
+    virtual QString formatMessage(const Message &message) const;
+    virtual QString formatMessage(const QTime &time, const QString & str_level, const QList<QVariant> &msgs, QColor color = QColor(0, 0, 0)) const;
     QTextEdit *m_textEdit;
+    QList<Message> m_pending;
+    int m_dropped;
+    QTimer m_flushTimer;
 };
 
 #endif // TEXTEDITLOGGERENGINE_H
@@ -369,9 +369,12 @@ void ConnectionManager::resumePolling()
  * Synchronize the list of connections displayed with those physically
  * present
  * @param[in] connection Connection type that you want to forget about :)
+ * @returns true if devices were added or removed
  */
-void ConnectionManager::updateConnectionList(IConnection *connection)
+bool ConnectionManager::updateConnectionList(IConnection *connection)
 {
+    bool changed = false;
+
     // Get the updated list of devices
     QList <IConnection::device> availableDev = connection->availableDevices();
 
@@ -392,7 +395,8 @@ void ConnectionManager::updateConnectionList(IConnection *connection)
                 disconnectDevice();
             }
 
-            iter = m_devList.erase(iter);
+            iter    = m_devList.erase(iter);
+            changed = true;
         } else {
             ++iter;
         }
@@ -404,8 +408,10 @@ void ConnectionManager::updateConnectionList(IConnection *connection)
 
         if (!found) {
             registerDevice(connection, dev);
+            changed = true;
         }
     }
+    return changed;
 }
 
 /**
@@ -433,12 +439,15 @@ void ConnectionManager::devChanged(IConnection *connection)
         connect(ExtensionSystem::PluginManager::instance(), SIGNAL(pluginsLoadEnded()), this, SLOT(connectionsCallBack()), Qt::UniqueConnection);
         return;
     }
+    // remove registered devices of this IConnection from the list,
+    // the combobox is only rebuilt when the devices really changed
+    if (!updateConnectionList(connection)) {
+        return;
+    }
+
     // clear device list combobox
     m_availableDevList->clear();
 
-    // remove registered devices of this IConnection from the list
-    updateConnectionList(connection);
-
     updateConnectionDropdown();
 
     qDebug() << "# devices " << m_devList.count();
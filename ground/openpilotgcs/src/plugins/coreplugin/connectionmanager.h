@@ -107,7 +107,7 @@ public:
     void resumePolling();
 
 protected:
-    void updateConnectionList(IConnection *connection);
+    bool updateConnectionList(IConnection *connection);
     void registerDevice(IConnection *conn, IConnection::device device);
     void updateConnectionDropdown();
 
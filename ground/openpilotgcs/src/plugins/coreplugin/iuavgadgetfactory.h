@@ -52,7 +52,8 @@ public:
         m_classId(classId),
         m_name(name),
         m_icon(QIcon()),
-        m_singleConfigurationGadget(false) {}
+        m_singleConfigurationGadget(false),
+        m_createdOnStartup(false) {}
     virtual ~IUAVGadgetFactory() {}
 
     virtual IUAVGadget *createGadget(QWidget *parent) = 0;
@@ -84,6 +85,10 @@ public:
     {
         return m_singleConfigurationGadget;
     }
+    bool isCreatedOnStartup()
+    {
+        return m_createdOnStartup;
+    }
 protected:
     void setIcon(QIcon icon)
     {
@@ -93,11 +98,16 @@ protected:
     {
         m_singleConfigurationGadget = true;
     }
+    void setCreatedOnStartupTrue()
+    {
+        m_createdOnStartup = true;
+    }
 private:
     QString m_classId; // unique class id
     QString m_name; // display name, should also be unique
     QIcon m_icon;
     bool m_singleConfigurationGadget; // true if there is exactly one configuration for this gadget
+    bool m_createdOnStartup; // true if the gadget is used by others, its workspace is then not created lazily
 };
 } // namespace Core
 
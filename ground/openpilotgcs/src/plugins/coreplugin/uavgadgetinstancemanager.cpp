@@ -495,6 +495,13 @@ QIcon UAVGadgetInstanceManager::gadgetIcon(QString classId) const
     return m_classIdIconMap.value(classId);
 }
 
+bool UAVGadgetInstanceManager::isCreatedOnStartup(QString classId) const
+{
+    IUAVGadgetFactory *f = factory(classId);
+
+    return f && f->isCreatedOnStartup();
+}
+
 IUAVGadgetFactory *UAVGadgetInstanceManager::factory(QString classId) const
 {
     foreach(IUAVGadgetFactory * f, m_factories) {
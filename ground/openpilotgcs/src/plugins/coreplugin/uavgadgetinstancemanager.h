@@ -80,6 +80,7 @@ public:
     QStringList configurationNames(QString classId) const;
     QString gadgetName(QString classId) const;
     QIcon gadgetIcon(QString classId) const;
+    bool isCreatedOnStartup(QString classId) const;
 
 signals:
     void configurationChanged(IUAVGadgetConfiguration *config);
@@ -80,6 +80,7 @@ static inline ExtensionSystem::PluginManager *pluginManager()
 
 UAVGadgetManager::UAVGadgetManager(ICore *core, QString name, QIcon icon, int priority, QString uniqueName, QWidget *parent) :
     m_showToolbars(true),
+    m_pendingRestore(false),
     m_splitterOrView(0),
     m_currentGadget(0),
     m_core(core),
@@ -141,6 +142,7 @@ void UAVGadgetManager::modeChanged(Core::IMode *mode)
         return;
     }
 
+    restorePendingState();
     m_currentGadget->widget()->setFocus();
     showToolbars(toolbarsShown());
 }
@@ -339,6 +341,14 @@ bool UAVGadgetManager::restoreState(QSettings *qSettings)
 
 void UAVGadgetManager::saveSettings(QSettings *qs)
 {
+    if (m_pendingRestore) {
+        if (qs == m_core->settings()) {
+            // Never shown, the saved state is still there
+            return;
+        }
+        restorePendingState();
+    }
+
     qs->beginGroup("UAVGadgetManager");
     qs->beginGroup(this->uniqueModeName());
 
@@ -367,6 +377,43 @@ void UAVGadgetManager::readSettings(QSettings *qs)
     }
     qs->beginGroup(uniqueModeName());
 
+    // Hidden workspaces are restored from the core settings when first shown,
+    // the other settings may not be around by then
+    if (qs == m_core->settings() && m_core->modeManager()->currentMode() != this && !hasStartupGadget(qs)) {
+        m_pendingRestore = true;
+    } else {
+        m_pendingRestore = false;
+        restoreState(qs);
+        showToolbars(m_showToolbars);
+    }
+
+    qs->endGroup();
+    qs->endGroup();
+}
+
+bool UAVGadgetManager::hasStartupGadget(QSettings *qs) const
+{
+    UAVGadgetInstanceManager *im = ICore::instance()->uavGadgetInstanceManager();
+
+    foreach(QString key, qs->allKeys()) {
+        if (key.endsWith("classId") && im->isCreatedOnStartup(qs->value(key).toString())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UAVGadgetManager::restorePendingState()
+{
+    if (!m_pendingRestore) {
+        return;
+    }
+    m_pendingRestore = false;
+
+    QSettings *qs = m_core->settings();
+    qs->beginGroup("UAVGadgetManager");
+    qs->beginGroup(uniqueModeName());
+
     restoreState(qs);
 
     showToolbars(m_showToolbars);
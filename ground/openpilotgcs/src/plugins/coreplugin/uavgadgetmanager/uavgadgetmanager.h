@@ -132,8 +132,12 @@ private:
     void closeView(Core::Internal::UAVGadgetView *view);
     void emptyView(Core::Internal::UAVGadgetView *view);
     Core::Internal::SplitterOrView *currentSplitterOrView() const;
+    bool hasStartupGadget(QSettings *qs) const;
+    void restorePendingState();
 
     bool m_showToolbars;
+    // the gadgets are only created when the workspace is first shown
+    bool m_pendingRestore;
     Core::Internal::SplitterOrView *m_splitterOrView;
     Core::IUAVGadget *m_currentGadget;
     Core::ICore *m_core;
@@ -1,8 +1,24 @@
 #include "debugengine.h"
+#include <QCoreApplication>
+#include <QScrollBar>
+#include <QStringList>
+#include <QTextDocument>
+#include <QTimer>
 
-debugengine::debugengine()
+// Interval of the writes to the text browser
+#define FLUSH_INTERVAL_MS    100
+// Messages queued between two writes, older ones are dropped
+#define MAX_PENDING_MESSAGES 500
+// Lines kept by the text browser
+#define MAX_LINES            5000
+
+debugengine::debugengine() : _color(Qt::black), _dropped(0), _flushPending(false), _disabledTypes(0)
 {
     mut_lock = new QMutex(QMutex::Recursive);
+    // The flush timer has to run in the GUI thread
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
 }
 
 debugengine *debugengine::getInstance()
@@ -22,15 +38,33 @@ void debugengine::setTextEdit(QTextBrowser *textEdit)
 {
     QMutexLocker lock(mut_lock);
 
-    _textEdit = textEdit;
+    if (_textEdit != textEdit) {
+        _textEdit = textEdit;
+        if (_textEdit) {
+            _textEdit->document()->setMaximumBlockCount(MAX_LINES);
+        }
+    }
 }
 
 void debugengine::writeMessage(const QString &message)
 {
     QMutexLocker lock(mut_lock);
 
-    if (_textEdit) {
-        _textEdit->append(message);
+    if (!_textEdit) {
+        return;
+    }
+    if (_pending.size() >= MAX_PENDING_MESSAGES) {
+        _pending.removeFirst();
+        _dropped++;
+    }
+    Message msg;
+    msg.color = _color;
+    msg.text  = message;
+    _pending.append(msg);
+
+    if (!_flushPending) {
+        _flushPending = true;
+        QMetaObject::invokeMethod(this, "startFlush", Qt::QueuedConnection);
     }
 }
 
@@ -38,7 +72,61 @@ void debugengine::setColor(const QColor &c)
 {
     QMutexLocker lock(mut_lock);
 
-    if (_textEdit) {
-        _textEdit->setTextColor(c);
+    _color = c;
+}
+
+void debugengine::setMessageTypeEnabled(QtMsgType type, bool enable)
+{
+    QMutexLocker lock(mut_lock);
+
+    if (enable) {
+        _disabledTypes &= ~(1u << type);
+    } else {
+        _disabledTypes |= (1u << type);
+    }
+}
+
+bool debugengine::isMessageTypeEnabled(QtMsgType type) const
+{
+    return !(_disabledTypes & (1u << type));
+}
+
+void debugengine::startFlush()
+{
+    QTimer::singleShot(FLUSH_INTERVAL_MS, this, SLOT(flush()));
+}
+
+void debugengine::flush()
+{
+    QList<Message> pending;
+    int dropped;
+    QPointer<QTextBrowser> textEdit;
+    {
+        QMutexLocker lock(mut_lock);
+        pending.swap(_pending);
+        dropped       = _dropped;
+        _dropped      = 0;
+        _flushPending = false;
+        textEdit      = _textEdit;
+    }
+
+    if (!textEdit || pending.isEmpty()) {
+        return;
+    }
+
+    // A single append for the whole batch, the message text is escaped as it is not html
+    QStringList lines;
+    if (dropped > 0) {
+        lines << QString("<font color=%1>%2 messages dropped</font>").arg(QColor(Qt::red).name()).arg(dropped);
+    }
+    foreach(const Message &msg, pending) {
+        lines << QString("<font color=%1>%2</font>").arg(msg.color.name()).arg(msg.text.toHtmlEscaped());
+    }
+
+    QScrollBar *sb = textEdit->verticalScrollBar();
+    bool scroll    = sb->value() == sb->maximum();
+    textEdit->append(lines.join("<br>"));
+    if (scroll) {
+        sb->setValue(sb->maximum());
     }
 }
@@ -3,8 +3,13 @@
 #include <QTextBrowser>
 #include <QPointer>
 #include <QMutex>
+#include <QColor>
+#include <QList>
 
-class debugengine {
+// The messages are queued and written to the text browser in batches, so that the
+// message handler can be called from any thread and a burst does not block the GUI
+class debugengine : public QObject {
+    Q_OBJECT
 // Add all missing constructor etc... to have singleton
     debugengine();
     ~debugengine();
@@ -13,9 +18,24 @@ public:
     void setTextEdit(QTextBrowser *textEdit);
     void writeMessage(const QString &message);
     void setColor(const QColor &c);
+    void setMessageTypeEnabled(QtMsgType type, bool enable);
+    bool isMessageTypeEnabled(QtMsgType type) const;
     QMutex *mut_lock;
+private slots:
+    void startFlush();
+    void flush();
 private:
+    struct Message {
+        QColor  color;
+        QString text;
+    };
+
     QPointer<QTextBrowser> _textEdit;
+    QColor _color;
+    QList<Message> _pending;
+    int _dropped;
+    bool _flushPending;
+    quint32 _disabledTypes;
 };
 
 #endif // DEBUGENGINE_H
@@ -44,6 +44,10 @@ QPointer<QTextBrowser> m_textedit;
 void DebugGadgetWidget::customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
     Q_UNUSED(context);
+    // Filter before the message is formatted
+    if (type != QtFatalMsg && !debugengine::getInstance()->isMessageTypeEnabled(type)) {
+        return;
+    }
     QString txt;
     QColor color = Qt::black;
 
@@ -28,6 +28,8 @@
 
 #include "dialgadgetwidget.h"
 #include <utils/stylehelper.h>
+#include <utils/rastersvgitem.h>
+#include <utils/svgrastercache.h>
 #include <iostream>
 #include <QtOpenGL/QGLWidget>
 #include <QDebug>
@@ -249,16 +251,18 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
     n3enabled = false;
     QGraphicsScene *l_scene = scene();
     setBackgroundBrush(QBrush(Utils::StyleHelper::baseColor()));
+    // The pixmaps of the previous file are stale
+    Utils::SvgRasterCache::instance()->invalidate(m_renderer);
     if (QFile::exists(dfn) && m_renderer->load(dfn) && m_renderer->isValid()) {
         l_scene->clear(); // This also deletes all items contained in the scene.
-        m_background = new QGraphicsSvgItem();
+        m_background = new RasterSvgItem();
         // All other items will be clipped to the shape of the background
         m_background->setFlags(QGraphicsItem::ItemClipsChildrenToShape |
                                QGraphicsItem::ItemClipsToShape);
-        m_foreground = new QGraphicsSvgItem();
-        m_needle1    = new QGraphicsSvgItem();
-        m_needle2    = new QGraphicsSvgItem();
-        m_needle3    = new QGraphicsSvgItem();
+        m_foreground = new RasterSvgItem();
+        m_needle1    = new RasterSvgItem();
+        m_needle2    = new RasterSvgItem();
+        m_needle3    = new RasterSvgItem();
         m_needle1->setParentItem(m_background);
         m_needle2->setParentItem(m_background);
         m_needle3->setParentItem(m_background);
@@ -428,7 +432,7 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
         qDebug() << "no file: display default background.";
         m_renderer->load(QString(":/dial/images/empty.svg"));
         l_scene->clear(); // This also deletes all items contained in the scene.
-        m_background = new QGraphicsSvgItem();
+        m_background = new RasterSvgItem();
         m_background->setSharedRenderer(m_renderer);
         l_scene->addItem(m_background);
         m_text1   = NULL;
@@ -162,6 +162,13 @@ Rectangle {
                                 activeFocusOnPress: true
                                 onClicked: logManager.clearAllLogs()
                             }
+                            Button {
+                                id: traceButton
+                                enabled: !logManager.disableControls && logManager.boardConnected
+                                text: qsTr("Dump trace")
+                                activeFocusOnPress: true
+                                onClicked: logManager.dumpTrace()
+                            }
                             Button {
                                 id: exportButton
                                 enabled: !logManager.disableControls && !logManager.disableExport && logManager.boardConnected
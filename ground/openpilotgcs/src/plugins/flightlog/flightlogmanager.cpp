@@ -32,6 +32,12 @@
 #include <QFileDialog>
 #include <QXmlStreamReader>
 #include <QMessageBox>
+#include <QTimer>
+#include <QDataStream>
+#include <QtEndian>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QDebug>
 
 #include "debuglogcontrol.h"
@@ -44,7 +50,7 @@
 FlightLogManager::FlightLogManager(QObject *parent) :
     QObject(parent), m_disableControls(false),
     m_disableExport(true), m_cancelDownload(false),
-    m_adjustExportedTimestamps(true)
+    m_adjustExportedTimestamps(true), m_windowFlight(-1), m_windowFirst(0), m_windowCount(0)
 {
     ExtensionSystem::PluginManager *pluginManager = ExtensionSystem::PluginManager::instance();
 
@@ -68,6 +74,11 @@ FlightLogManager::FlightLogManager(QObject *parent) :
 
     m_flightLogEntry    = DebugLogEntry::GetInstance(m_objectManager);
     Q_ASSERT(m_flightLogEntry);
+    // Windowed retrieval sends entries as further instances, created as they arrive
+    foreach(UAVObject * obj, m_objectManager->getObjectInstances(DebugLogEntry::OBJID)) {
+        connectLogEntryInstance(obj);
+    }
+    connect(m_objectManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(connectLogEntryInstance(UAVObject *)));
 
     m_flightLogSettings = DebugLogSettings::GetInstance(m_objectManager);
     Q_ASSERT(m_flightLogSettings);
@@ -173,6 +184,21 @@ void FlightLogManager::clearAllLogs()
     setDisableControls(false);
 }
 
+void FlightLogManager::dumpTrace()
+{
+    setDisableControls(true);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    // The flight side writes the trace as Trace entries of the current flight
+    UAVObjectUpdaterHelper updateHelper;
+
+    m_flightLogControl->setOperation(DebugLogControl::OPERATION_DUMPTRACE);
+    updateHelper.doObjectAndWait(m_flightLogControl, UAVTALK_TIMEOUT);
+
+    QApplication::restoreOverrideCursor();
+    setDisableControls(false);
+}
+
 void FlightLogManager::clearLogList()
 {
     QList<ExtendedDebugLogEntry *> tmpList(m_logEntries);
@@ -200,12 +226,27 @@ void FlightLogManager::retrieveLogs(int flightToRetrieve)
     int startFlight = (flightToRetrieve == -1) ? 0 : flightToRetrieve;
     int endFlight   = (flightToRetrieve == -1) ? m_flightLogStatus->getFlight() : flightToRetrieve;
 
-    // Prepare to send request for event retrieval
-    m_flightLogControl->setOperation(DebugLogControl::OPERATION_RETRIEVE);
+    // Windowed retrieval streams several entries per request, entries it
+    // could not get are then requested one by one
+    bool windowed = true;
     for (int flight = startFlight; flight <= endFlight; flight++) {
+        m_compressedObjects.clear();
+        int slot = 0;
+        if (windowed) {
+            if (retrieveFlightWindowed(flight, slot)) {
+                continue;
+            }
+            if (m_cancelDownload) {
+                break;
+            }
+            // Nothing at all came back, the firmware does not support it
+            windowed = (slot > 0);
+        }
+
+        // Prepare to send request for event retrieval
+        m_flightLogControl->setOperation(DebugLogControl::OPERATION_RETRIEVE);
         m_flightLogControl->setFlight(flight);
         bool gotLast = false;
-        int slot     = 0;
         while (!gotLast) {
             // Send request for loading flight entry on flight side and wait for ack/nack
             m_flightLogControl->setEntry(slot);
@@ -213,36 +254,8 @@ void FlightLogManager::retrieveLogs(int flightToRetrieve)
             if (updateHelper.doObjectAndWait(m_flightLogControl, UAVTALK_TIMEOUT) == UAVObjectUpdaterHelper::SUCCESS &&
                 requestHelper.doObjectAndWait(m_flightLogEntry, UAVTALK_TIMEOUT) == UAVObjectUpdaterHelper::SUCCESS) {
                 if (m_flightLogEntry->getType() != DebugLogEntry::TYPE_EMPTY) {
-                    // Ok, we retrieved the entry, and it was the correct one. clone it and add it to the list
-                    ExtendedDebugLogEntry *logEntry = new ExtendedDebugLogEntry();
-
-                    logEntry->setData(m_flightLogEntry->getData(), m_objectManager);
-                    m_logEntries << logEntry;
-                    if (logEntry->getData().Type == DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
-                        const quint32 total_len  = sizeof(DebugLogEntry::DataFields);
-                        const quint32 data_len   = sizeof(((DebugLogEntry::DataFields *)0)->Data);
-                        const quint32 header_len = total_len - data_len;
-
-                        DebugLogEntry::DataFields fields;
-                        quint32 start = logEntry->getData().Size;
-
-                        // cycle until there is space for another object
-                        while (start + header_len + 1 < data_len) {
-                            memset(&fields, 0xFF, total_len);
-                            memcpy(&fields, &logEntry->getData().Data[start], header_len);
-                            // check wether a packed object is found
-                            // note that empty data blocks are set as 0xFF in flight side to minimize flash wearing
-                            // thus as soon as this read outside of used area, the test will fail as lenght would be 0xFFFF
-                            quint32 toread = header_len + fields.Size;
-                            if (!(toread + start > data_len)) {
-                                memcpy(&fields, &logEntry->getData().Data[start], toread);
-                                ExtendedDebugLogEntry *subEntry = new ExtendedDebugLogEntry();
-                                subEntry->setData(fields, m_objectManager);
-                                m_logEntries << subEntry;
-                            }
-                            start += toread;
-                        }
-                    }
+                    // Ok, we retrieved the entry, and it was the correct one.
+                    addLogEntry(m_flightLogEntry->getData());
 
                     // Increment to get next entry from flight side
                     slot++;
@@ -275,6 +288,137 @@ void FlightLogManager::retrieveLogs(int flightToRetrieve)
     setDisableControls(false);
 }
 
+void FlightLogManager::addLogEntry(const DebugLogEntry::DataFields &data)
+{
+    if (data.Type == DebugLogEntry::TYPE_COMPRESSEDUAVOBJECTS) {
+        decodeCompressedEntry(data);
+        return;
+    }
+
+    // clone it and add it to the list
+    ExtendedDebugLogEntry *logEntry = new ExtendedDebugLogEntry();
+
+    logEntry->setData(data, m_objectManager);
+    m_logEntries << logEntry;
+    if (logEntry->getData().Type == DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
+        const quint32 total_len  = sizeof(DebugLogEntry::DataFields);
+        const quint32 data_len   = sizeof(((DebugLogEntry::DataFields *)0)->Data);
+        const quint32 header_len = total_len - data_len;
+
+        DebugLogEntry::DataFields fields;
+        quint32 start = logEntry->getData().Size;
+
+        // cycle until there is space for another object
+        while (start + header_len + 1 < data_len) {
+            memset(&fields, 0xFF, total_len);
+            memcpy(&fields, &logEntry->getData().Data[start], header_len);
+            // check wether a packed object is found
+            // note that empty data blocks are set as 0xFF in flight side to minimize flash wearing
+            // thus as soon as this read outside of used area, the test will fail as lenght would be 0xFFFF
+            quint32 toread = header_len + fields.Size;
+            if (!(toread + start > data_len)) {
+                memcpy(&fields, &logEntry->getData().Data[start], toread);
+                ExtendedDebugLogEntry *subEntry = new ExtendedDebugLogEntry();
+                subEntry->setData(fields, m_objectManager);
+                m_logEntries << subEntry;
+            }
+            start += toread;
+        }
+    }
+}
+
+void FlightLogManager::connectLogEntryInstance(UAVObject *obj)
+{
+    if (obj->getObjID() == DebugLogEntry::OBJID) {
+        connect(obj, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(logEntryReceived(UAVObject *)), Qt::UniqueConnection);
+    }
+}
+
+void FlightLogManager::logEntryReceived(UAVObject *obj)
+{
+    DebugLogEntry *entry = qobject_cast<DebugLogEntry *>(obj);
+
+    if (!entry || m_windowFlight < 0) {
+        return;
+    }
+
+    DebugLogEntry::DataFields data = entry->getData();
+    if (data.Flight != m_windowFlight || data.Entry < m_windowFirst || data.Entry >= m_windowFirst + m_windowCount) {
+        // Late duplicate of an earlier window
+        return;
+    }
+    m_windowEntries.insert(data.Entry, data);
+    if (windowComplete()) {
+        m_windowLoop.quit();
+    }
+}
+
+// The window is complete when all of its entries arrived, or all up to the one marking the end of the flight
+bool FlightLogManager::windowComplete() const
+{
+    for (int entry = m_windowFirst; entry < m_windowFirst + m_windowCount; entry++) {
+        if (!m_windowEntries.contains(entry)) {
+            return false;
+        }
+        if (m_windowEntries[entry].Type == DebugLogEntry::TYPE_EMPTY) {
+            return true;
+        }
+    }
+    return true;
+}
+
+// Retrieves a flight a window of entries at a time, missing entries are requested again with the next window.
+// Returns false if the flight could not be retrieved completely, nextEntry is the first entry not retrieved.
+bool FlightLogManager::retrieveFlightWindowed(int flight, int &nextEntry)
+{
+    UAVObjectUpdaterHelper updateHelper;
+    int retries = 0;
+    bool gotLast = false;
+
+    while (!gotLast && !m_cancelDownload) {
+        m_windowEntries.clear();
+        m_windowFlight = flight;
+        m_windowFirst  = nextEntry;
+        m_windowCount  = LOG_WINDOW_SIZE;
+
+        m_flightLogControl->setOperation(DebugLogControl::OPERATION_RETRIEVEWINDOW);
+        m_flightLogControl->setFlight(flight);
+        m_flightLogControl->setEntry(nextEntry);
+        m_flightLogControl->setCount(LOG_WINDOW_SIZE);
+
+        bool acked = updateHelper.doObjectAndWait(m_flightLogControl, UAVTALK_TIMEOUT) == UAVObjectUpdaterHelper::SUCCESS;
+        if (acked && !windowComplete()) {
+            QTimer timeoutTimer;
+            timeoutTimer.setSingleShot(true);
+            connect(&timeoutTimer, SIGNAL(timeout()), &m_windowLoop, SLOT(quit()));
+            timeoutTimer.start(LOG_WINDOW_TIMEOUT);
+            m_windowLoop.exec();
+        }
+
+        // Use what arrived in order, a gap ends the window and is requested again
+        int first = nextEntry;
+        while (m_windowEntries.contains(nextEntry)) {
+            const DebugLogEntry::DataFields &data = m_windowEntries[nextEntry];
+            if (data.Type == DebugLogEntry::TYPE_EMPTY) {
+                gotLast = true;
+                break;
+            }
+            addLogEntry(data);
+            nextEntry++;
+        }
+
+        if (gotLast || nextEntry > first) {
+            retries = 0;
+        } else if (nextEntry == 0 || !acked || ++retries > LOG_WINDOW_RETRIES) {
+            break;
+        }
+    }
+
+    m_windowFlight = -1;
+    m_windowEntries.clear();
+    return gotLast;
+}
+
 void FlightLogManager::exportToOPL(QString fileName)
 {
     // Fix the file name
@@ -321,6 +465,103 @@ void FlightLogManager::exportToOPL(QString fileName)
     }
 }
 
+static bool readVarint(const quint8 *data, quint32 length, quint32 &pos, quint32 &value)
+{
+    value = 0;
+    for (int shift = 0; pos < length && shift < 32; shift += 7) {
+        quint8 byte = data[pos++];
+        value |= (quint32)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decodes one compressed block, see pios_debuglog.c for the record layout.
+// Blocks must be decoded in order as objects are delta encoded against their previous sample.
+void FlightLogManager::decodeCompressedEntry(const DebugLogEntry::DataFields &block)
+{
+    const quint8 DICT_DEFINE = 0xfe;
+    const quint8 DICT_END    = 0xff;
+    const quint32 data_len   = sizeof(block.Data);
+    const quint32 length     = qMin((quint32)block.Size, data_len);
+    quint32 time = block.FlightTime;
+    quint32 pos  = 0;
+
+    while (pos < length && block.Data[pos] != DICT_END) {
+        quint8 index = block.Data[pos++];
+        if (index == DICT_DEFINE) {
+            if (pos + 4 > length) {
+                break;
+            }
+            CompressedLogObject object;
+            object.objectId = block.Data[pos] | (block.Data[pos + 1] << 8) | (block.Data[pos + 2] << 16) | ((quint32)block.Data[pos + 3] << 24);
+            pos += 4;
+            quint32 instId, size;
+            if (!readVarint(block.Data, length, pos, instId) || !readVarint(block.Data, length, pos, size) || size > data_len) {
+                break;
+            }
+            object.instanceId = instId;
+            object.lastSample.fill(0, size);
+            index = m_compressedObjects.count();
+            m_compressedObjects << object;
+        } else if (index >= m_compressedObjects.count()) {
+            qDebug() << "FlightLogManager: unknown object index" << index << "in compressed log entry" << block.Entry;
+            break;
+        }
+
+        quint32 delta;
+        if (!readVarint(block.Data, length, pos, delta)) {
+            break;
+        }
+        time += delta;
+
+        CompressedLogObject &object = m_compressedObjects[index];
+        quint8 *sample = (quint8 *)object.lastSample.data();
+        const int size = object.lastSample.size();
+        bool valid     = true;
+        for (int group = 0; group < size && valid; group += 8) {
+            if (pos >= length) {
+                valid = false;
+                break;
+            }
+            quint8 mask = block.Data[pos++];
+            for (int t = group; t < group + 8 && t < size; t++) {
+                if (mask & (1 << (t - group))) {
+                    if (pos >= length) {
+                        valid = false;
+                        break;
+                    }
+                    sample[t] ^= block.Data[pos++];
+                }
+            }
+        }
+        if (!valid) {
+            break;
+        }
+
+        // skip objects unknown to this GCS, they still need to be decoded to keep the stream in sync
+        if (!m_objectManager->getObject(object.objectId, object.instanceId)) {
+            continue;
+        }
+        DebugLogEntry::DataFields fields;
+        memset(&fields, 0xFF, sizeof(fields));
+        fields.Flight     = block.Flight;
+        fields.FlightTime = time;
+        fields.Entry      = block.Entry;
+        fields.Type       = DebugLogEntry::TYPE_UAVOBJECT;
+        fields.ObjectID   = object.objectId;
+        fields.InstanceID = object.instanceId;
+        fields.Size       = size;
+        memcpy(fields.Data, sample, size);
+
+        ExtendedDebugLogEntry *logEntry = new ExtendedDebugLogEntry();
+        logEntry->setData(fields, m_objectManager);
+        m_logEntries << logEntry;
+    }
+}
+
 void FlightLogManager::exportToCSV(QString fileName)
 {
     QFile csvFile(fileName);
@@ -372,6 +613,345 @@ void FlightLogManager::exportToXML(QString fileName)
     }
 }
 
+// Writes a fixed size, NUL padded name as used in the columnar file headers
+static void writeColumnarName(QDataStream &stream, const QString &name)
+{
+    QByteArray bytes = name.toLatin1().left(63);
+
+    bytes.append(QByteArray(64 - bytes.size(), '\0'));
+    stream.writeRawData(bytes.constData(), bytes.size());
+}
+
+// Columnar binary export, one table per UAVObject with one typed column per field.
+// All integers are little endian and every column starts 8 byte aligned, so columns can be memory mapped.
+//   header:  char magic[8] "OPLCOL\0\0", uint32 version, uint32 table count, uint64 index offset
+//   columns: raw column data, rows x elements values of the column type
+//   index:   per table:  char name[64], uint32 object id, uint32 column count, uint64 row count
+//            per column: char name[64], uint32 type, uint32 elements, uint64 offset, uint64 size
+// Column types are UAVObjectField::FieldType values, enums and bitfields are stored as uint8.
+// Every table starts with the FlightTime (uint32, us), Flight (uint16) and Instance (uint16) columns.
+namespace {
+struct ColumnarColumn {
+    QString    name;
+    quint32    type;
+    quint32    elements;
+    quint32    dataOffset; // in the packed object
+    quint32    elementSize;
+    QByteArray data;
+    quint64    offset; // in the file
+    quint64    size;
+};
+struct ColumnarTable {
+    UAVDataObject *object;
+    QList<ExtendedDebugLogEntry *> rows;
+    QList<ColumnarColumn> columns;
+};
+}
+
+void FlightLogManager::exportToColumnar(QString fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return;
+    }
+
+    // Group the object entries by object, in order of their first appearance
+    QList<ColumnarTable> tables;
+    QHash<quint32, int> tableIndex;
+    QHash<quint32, quint32> baseTimes; // same time base as the other exports, the first entry of each flight
+    foreach(ExtendedDebugLogEntry * entry, m_logEntries) {
+        if (m_adjustExportedTimestamps && !baseTimes.contains(entry->getFlight())) {
+            baseTimes.insert(entry->getFlight(), entry->getFlightTime());
+        }
+        if (!entry->uavObject()) {
+            continue;
+        }
+        quint32 objId = entry->getObjectID();
+        if (!tableIndex.contains(objId)) {
+            tableIndex.insert(objId, tables.count());
+            ColumnarTable table;
+            table.object = entry->uavObject();
+            tables << table;
+        }
+        tables[tableIndex[objId]].rows << entry;
+    }
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // Header, the index offset is filled in once the columns are written
+    stream.writeRawData("OPLCOL\0\0", 8);
+    stream << (quint32)LOG_COLUMNAR_FILE_VERSION << (quint32)tables.count() << (quint64)0;
+
+    for (int t = 0; t < tables.count(); t++) {
+        ColumnarTable &table = tables[t];
+
+        // Build the columns straight from the packed object data of the log entries
+        ColumnarColumn column;
+        column.name        = "FlightTime";
+        column.type        = UAVObjectField::UINT32;
+        column.elements    = 1;
+        column.dataOffset  = 0;
+        column.elementSize = 0;
+        table.columns << column;
+        column.name = "Flight";
+        column.type = UAVObjectField::UINT16;
+        table.columns << column;
+        column.name = "Instance";
+        table.columns << column;
+        foreach(UAVObjectField * field, table.object->getFields()) {
+            if (field->getType() == UAVObjectField::STRING) {
+                continue;
+            }
+            column.name        = field->getName();
+            column.type        = (field->getType() == UAVObjectField::ENUM || field->getType() == UAVObjectField::BITFIELD) ?
+                                 UAVObjectField::UINT8 : field->getType();
+            column.elements    = field->getNumElements();
+            column.dataOffset  = field->getDataOffset();
+            column.elementSize = field->getNumBytes() / field->getNumElements();
+            table.columns << column;
+        }
+
+        foreach(ExtendedDebugLogEntry * entry, table.rows) {
+            quint32 flightTime = qToLittleEndian<quint32>(entry->getFlightTime() - baseTimes.value(entry->getFlight(), 0));
+            quint16 flight     = qToLittleEndian<quint16>(entry->getFlight() + 1);
+            quint16 instance   = qToLittleEndian<quint16>(entry->getInstanceID());
+            table.columns[0].data.append((const char *)&flightTime, sizeof(flightTime));
+            table.columns[1].data.append((const char *)&flight, sizeof(flight));
+            table.columns[2].data.append((const char *)&instance, sizeof(instance));
+
+            const DebugLogEntry::DataFields &data = entry->getData();
+            for (int c = 3; c < table.columns.count(); c++) {
+                ColumnarColumn &col = table.columns[c];
+                col.data.append((const char *)&data.Data[col.dataOffset], col.elements * col.elementSize);
+            }
+        }
+
+        // Write the columns 8 byte aligned and release their data
+        for (int c = 0; c < table.columns.count(); c++) {
+            ColumnarColumn &col = table.columns[c];
+            qint64 pos  = file.pos();
+            if (pos % 8) {
+                stream.writeRawData("\0\0\0\0\0\0\0", 8 - pos % 8);
+            }
+            col.offset = file.pos();
+            stream.writeRawData(col.data.constData(), col.data.size());
+            col.size = col.data.size();
+            col.data.clear();
+        }
+    }
+
+    // Index
+    qint64 pos = file.pos();
+    if (pos % 8) {
+        stream.writeRawData("\0\0\0\0\0\0\0", 8 - pos % 8);
+    }
+    quint64 indexOffset = file.pos();
+    foreach(const ColumnarTable &table, tables) {
+        writeColumnarName(stream, table.object->getName());
+        stream << (quint32)table.object->getObjID() << (quint32)table.columns.count() << (quint64)table.rows.count();
+        foreach(const ColumnarColumn &col, table.columns) {
+            writeColumnarName(stream, col.name);
+            stream << col.type << col.elements << col.offset << col.size;
+        }
+    }
+
+    file.seek(16);
+    stream << indexOffset;
+    file.close();
+}
+
+// Scheduling trace export in the Chrome Trace Event Format, for chrome://tracing.
+// Trace entries hold the records of flight/pios/inc/pios_trace.h: uint32 raw time,
+// uint32 event << 24 | argument, little endian, ObjectID is the raw ticks per us.
+// Every flight is a process, task switches are slices of the "Tasks" row, callbacks
+// slices of the row of the task running them, interrupts and lost events instants.
+namespace {
+enum TraceEvent {
+    TRACE_TASK_SWITCH    = 1,
+    TRACE_CALLBACK_START = 2,
+    TRACE_CALLBACK_END   = 3,
+    TRACE_ISR_SPI        = 4,
+    TRACE_ISR_USART      = 5,
+    TRACE_ISR_TIMER      = 6,
+    TRACE_QUEUE_FULL     = 7,
+    TRACE_TASK_INFO      = 8,
+};
+const int TRACE_TASKS_TID      = 0;
+const int TRACE_INTERRUPTS_TID = 1;
+const int TRACE_FIRST_TASK_TID = 2;
+
+QJsonObject traceEvent(const QString &name, const QString &phase, double ts, quint32 pid, int tid)
+{
+    QJsonObject event;
+
+    event["name"] = name;
+    event["ph"]   = phase;
+    event["ts"]   = ts;
+    event["pid"]  = (int)pid;
+    event["tid"]  = tid;
+    return event;
+}
+
+QJsonObject traceThreadName(quint32 pid, int tid, const QString &name)
+{
+    QJsonObject event = traceEvent("thread_name", "M", 0, pid, tid);
+    QJsonObject args;
+
+    args["name"]  = name;
+    event["args"] = args;
+    return event;
+}
+}
+
+void FlightLogManager::exportToChromeTrace(QString fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return;
+    }
+
+    QStringList taskNames;
+    QStringList callbackNames;
+    UAVObject *taskInfo     = m_objectManager->getObject("TaskInfo");
+    UAVObject *callbackInfo = m_objectManager->getObject("CallbackInfo");
+    if (taskInfo && taskInfo->getField("RunningTime")) {
+        taskNames = taskInfo->getField("RunningTime")->getElementNames();
+    }
+    if (callbackInfo && callbackInfo->getField("RunningTime")) {
+        callbackNames = callbackInfo->getField("RunningTime")->getElementNames();
+    }
+
+    QJsonArray events;
+    bool hasFlight = false;
+    quint32 flight = 0;
+    QHash<quint32, QString> tasks; // names by task handle, low 24 bits as in the task switches
+    QHash<quint32, int> taskTids;
+    bool started     = false;
+    quint32 lastRaw  = 0;
+    double now       = 0;
+    quint32 current  = 0;
+    double switchTime = 0;
+
+    foreach(ExtendedDebugLogEntry * entry, m_logEntries) {
+        if (entry->getType() != DebugLogEntry::TYPE_TRACE) {
+            continue;
+        }
+        if (!hasFlight || entry->getFlight() != flight) {
+            if (started && current) {
+                QJsonObject slice = traceEvent(tasks.value(current), "X", switchTime, flight + 1, TRACE_TASKS_TID);
+                slice["dur"] = now - switchTime;
+                events.append(slice);
+            }
+            hasFlight = true;
+            flight    = entry->getFlight();
+            tasks.clear();
+            taskTids.clear();
+            started   = false;
+            now       = 0;
+            current   = 0;
+
+            QJsonObject process = traceEvent("process_name", "M", 0, flight + 1, 0);
+            QJsonObject args;
+            args["name"]    = tr("Flight %1").arg(flight + 1);
+            process["args"] = args;
+            events.append(process);
+            events.append(traceThreadName(flight + 1, TRACE_TASKS_TID, tr("Tasks")));
+            events.append(traceThreadName(flight + 1, TRACE_INTERRUPTS_TID, tr("Interrupts")));
+        }
+
+        const DebugLogEntry::DataFields &data = entry->getData();
+        double ticksPerUs = data.ObjectID ? data.ObjectID : 1;
+        quint32 size = qMin<quint32>(data.Size, sizeof(data.Data));
+        for (quint32 pos = 0; pos + 8 <= size; pos += 8) {
+            quint32 raw   = qFromLittleEndian<quint32>(&data.Data[pos]);
+            quint32 word  = qFromLittleEndian<quint32>(&data.Data[pos + 4]);
+            quint8 event  = word >> 24;
+            quint32 arg   = word & 0xffffff;
+
+            if (event == TRACE_TASK_INFO) {
+                tasks.insert(raw & 0xffffff, taskNames.value(arg, tr("Task %1").arg(arg)));
+                continue;
+            }
+            // the raw time wraps around, the records are in order so only the differences count
+            if (started) {
+                now += (quint32)(raw - lastRaw) / ticksPerUs;
+            }
+            started = true;
+            lastRaw = raw;
+
+            // every task gets its own row for the callbacks it runs
+            if (current && !taskTids.contains(current)) {
+                if (!tasks.contains(current)) {
+                    tasks.insert(current, QString("Task 0x%1").arg(current, 6, 16, QChar('0')));
+                }
+                taskTids.insert(current, TRACE_FIRST_TASK_TID + taskTids.count());
+                events.append(traceThreadName(flight + 1, taskTids.value(current), tasks.value(current)));
+            }
+
+            switch (event) {
+            case TRACE_TASK_SWITCH:
+                if (current) {
+                    QJsonObject slice = traceEvent(tasks.value(current), "X", switchTime, flight + 1, TRACE_TASKS_TID);
+                    slice["dur"] = now - switchTime;
+                    events.append(slice);
+                }
+                current    = arg;
+                switchTime = now;
+                break;
+            case TRACE_CALLBACK_START:
+            case TRACE_CALLBACK_END:
+            {
+                // unmonitored callbacks have the id -1
+                QString name = callbackNames.value(arg, arg == 0xffffff ? tr("Callback") : tr("Callback %1").arg(arg));
+                events.append(traceEvent(name, event == TRACE_CALLBACK_START ? "B" : "E", now, flight + 1, taskTids.value(current, TRACE_TASKS_TID)));
+                break;
+            }
+            case TRACE_ISR_SPI:
+            case TRACE_ISR_USART:
+            case TRACE_ISR_TIMER:
+            {
+                QString kind = (event == TRACE_ISR_SPI) ? "SPI" : (event == TRACE_ISR_USART) ? "USART" : "TIM";
+                QJsonObject instant = traceEvent(QString("%1 0x%2").arg(kind).arg(arg, 6, 16, QChar('0')), "i", now, flight + 1, TRACE_INTERRUPTS_TID);
+                instant["s"] = QString("t");
+                events.append(instant);
+                break;
+            }
+            case TRACE_QUEUE_FULL:
+            {
+                // the object id is truncated to 24 bits
+                QString name = tr("Event queue full");
+                foreach(QList<UAVObject *> instances, m_objectManager->getObjects()) {
+                    if (!instances.isEmpty() && arg && (instances.first()->getObjID() & 0xffffff) == arg) {
+                        name += ": " + instances.first()->getName();
+                        break;
+                    }
+                }
+                QJsonObject instant = traceEvent(name, "i", now, flight + 1, taskTids.value(current, TRACE_TASKS_TID));
+                instant["s"] = QString("p");
+                events.append(instant);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+    if (started && current) {
+        QJsonObject slice = traceEvent(tasks.value(current), "X", switchTime, flight + 1, TRACE_TASKS_TID);
+        slice["dur"] = now - switchTime;
+        events.append(slice);
+    }
+
+    QJsonObject root;
+    root["traceEvents"]     = events;
+    root["displayTimeUnit"] = QString("ns");
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.close();
+}
+
 void FlightLogManager::exportLogs()
 {
     if (m_logEntries.isEmpty()) {
@@ -384,11 +964,13 @@ void FlightLogManager::exportLogs()
     QString oplFilter = tr("OpenPilot Log file %1").arg("(*.opl)");
     QString csvFilter = tr("Text file %1").arg("(*.csv)");
     QString xmlFilter = tr("XML file %1").arg("(*.xml)");
+    QString colFilter = tr("Columnar binary file %1").arg("(*.oplc)");
+    QString traceFilter = tr("Chrome trace file %1").arg("(*.json)");
 
     QString selectedFilter = csvFilter;
 
     QString fileName = QFileDialog::getSaveFileName(NULL, tr("Save Log Entries"), QDir::homePath(),
-                                                    QString("%1;;%2;;%3").arg(oplFilter, csvFilter, xmlFilter), &selectedFilter);
+                                                    QString("%1;;%2;;%3;;%4;;%5").arg(oplFilter, csvFilter, xmlFilter, colFilter, traceFilter), &selectedFilter);
     if (!fileName.isEmpty()) {
         if (selectedFilter == oplFilter) {
             if (!fileName.endsWith(".opl")) {
@@ -405,6 +987,16 @@ void FlightLogManager::exportLogs()
                 fileName.append(".xml");
             }
             exportToXML(fileName);
+        } else if (selectedFilter == colFilter) {
+            if (!fileName.endsWith(".oplc")) {
+                fileName.append(".oplc");
+            }
+            exportToColumnar(fileName);
+        } else if (selectedFilter == traceFilter) {
+            if (!fileName.endsWith(".json")) {
+                fileName.append(".json");
+            }
+            exportToChromeTrace(fileName);
         }
     }
 
@@ -643,6 +1235,8 @@ QString ExtendedDebugLogEntry::getLogString()
         return QString((const char *)getData().Data);
     } else if (getType() == DebugLogEntry::TYPE_UAVOBJECT || getType() == DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
         return m_object->toString().replace("\n", " ").replace("\t", " ");
+    } else if (getType() == DebugLogEntry::TYPE_TRACE) {
+        return tr("Scheduling trace, %1 records").arg(getSize() / 8);
     } else {
         return "";
     }
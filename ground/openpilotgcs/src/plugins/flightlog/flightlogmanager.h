@@ -31,6 +31,8 @@
 #include <QObject>
 #include <QList>
 #include <QHash>
+#include <QMap>
+#include <QEventLoop>
 #include <QQmlListProperty>
 #include <QSemaphore>
 #include <QXmlStreamWriter>
@@ -263,6 +265,7 @@ signals:
 
 public slots:
     void clearAllLogs();
+    void dumpTrace();
     void retrieveLogs(int flightToRetrieve = -1);
     void exportLogs();
     void cancelExportLogs();
@@ -319,6 +322,8 @@ private slots:
     void setupLogStatuses();
     void connectionStatusChanged();
     bool updateLogWrapper(QString name, int level, int period);
+    void connectLogEntryInstance(UAVObject *obj);
+    void logEntryReceived(UAVObject *obj);
 
 private:
     UAVObjectManager *m_objectManager;
@@ -338,12 +343,37 @@ private:
     QList<UAVOLogSettingsWrapper *> m_uavoEntries;
     QHash<QString, UAVOLogSettingsWrapper *> m_uavoEntriesHash;
 
+    // Per flight state for decoding TYPE_COMPRESSEDUAVOBJECTS entries
+    struct CompressedLogObject {
+        quint32    objectId;
+        quint16    instanceId;
+        QByteArray lastSample;
+    };
+    QList<CompressedLogObject> m_compressedObjects;
+
+    // Entries of the requested window, keyed by entry number, they may arrive in any order
+    QMap<quint16, DebugLogEntry::DataFields> m_windowEntries;
+    int m_windowFlight;
+    int m_windowFirst;
+    int m_windowCount;
+    QEventLoop m_windowLoop;
+
+    bool windowComplete() const;
+    bool retrieveFlightWindowed(int flight, int &nextEntry);
+    void addLogEntry(const DebugLogEntry::DataFields &data);
+    void decodeCompressedEntry(const DebugLogEntry::DataFields &block);
     void exportToOPL(QString fileName);
     void exportToCSV(QString fileName);
     void exportToXML(QString fileName);
+    void exportToColumnar(QString fileName);
+    void exportToChromeTrace(QString fileName);
 
     static const int UAVTALK_TIMEOUT = 4000;
+    static const int LOG_WINDOW_SIZE = 8; // matches RETRIEVE_WINDOW_MAX in Logging.c
+    static const int LOG_WINDOW_TIMEOUT = 1000;
+    static const int LOG_WINDOW_RETRIES = 5;
     static const int LOG_SETTINGS_FILE_VERSION = 1;
+    static const int LOG_COLUMNAR_FILE_VERSION = 1;
     bool m_disableControls;
     bool m_disableExport;
     bool m_cancelDownload;
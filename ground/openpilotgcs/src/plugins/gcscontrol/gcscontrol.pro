@@ -15,6 +15,7 @@ HEADERS += \
     gcscontrolgadgetwidget.h \
     gcscontrolgadgetfactory.h \
     gcscontrolplugin.h \
+    gcscontrolsender.h \
     joystickcontrol.h
 
 SOURCES += \
@@ -24,6 +25,7 @@ SOURCES += \
     gcscontrolgadgetwidget.cpp \
     gcscontrolgadgetfactory.cpp \
     gcscontrolplugin.cpp \
+    gcscontrolsender.cpp \
     joystickcontrol.cpp
 
 OTHER_FILES += GCSControl.pluginspec
@@ -32,8 +32,6 @@
 #include "uavobject.h"
 #include <QDebug>
 
-#define JOYSTICK_UPDATE_RATE 50
-
 GCSControlGadget::GCSControlGadget(QString classId, GCSControlGadgetWidget *widget, QWidget *parent, QObject *plugin) :
     IUAVGadget(classId, parent),
     m_widget(widget)
@@ -48,15 +46,26 @@ GCSControlGadget::GCSControlGadget(QString classId, GCSControlGadgetWidget *widg
 
     connect(control_sock, SIGNAL(readyRead()), this, SLOT(readUDPCommand()));
 
-    joystickTime.start();
+    m_sender = new GCSControlSender(getManualControlCommand());
+    m_sender->moveToThread(&m_controlThread);
+    connect(&m_controlThread, SIGNAL(started()), m_sender, SLOT(start()));
+    connect(&m_controlThread, SIGNAL(finished()), m_sender, SLOT(deleteLater()));
+    connect(m_sender, SIGNAL(latencyMeasured(double)), widget, SLOT(updateLatency(double)));
+    connect(widget, SIGNAL(controlChanged()), this, SLOT(controlChanged()));
+    m_controlThread.start(QThread::TimeCriticalPriority);
+
     GCSControlPlugin *pl = dynamic_cast<GCSControlPlugin *>(plugin);
     connect(pl->sdlGamepad, SIGNAL(gamepads(quint8)), this, SLOT(gamepads(quint8)));
     connect(pl->sdlGamepad, SIGNAL(buttonState(ButtonNumber, bool)), this, SLOT(buttonState(ButtonNumber, bool)));
-    connect(pl->sdlGamepad, SIGNAL(axesValues(QListInt16)), this, SLOT(axesValues(QListInt16)));
+    // queued from the gamepad thread to the control thread, not through the GUI thread
+    connect(pl->sdlGamepad, SIGNAL(axesValues(QListInt16)), m_sender, SLOT(axesValues(QListInt16)));
+    controlChanged();
 }
 
 GCSControlGadget::~GCSControlGadget()
 {
+    m_controlThread.quit();
+    m_controlThread.wait();
     delete m_widget;
 }
 
@@ -84,6 +93,26 @@ void GCSControlGadget::loadConfiguration(IUAVGadgetConfiguration *config)
         buttonSettings[i].Amount     = GCSControlConfig->getbuttonSettings(i).Amount;
         channelReverse[i] = GCSControlConfig->getChannelsReverse().at(i);
     }
+
+    bool buttonControl[4] = { false, false, false, false };
+    for (i = 0; i < 8; i++) {
+        if ((buttonSettings[i].FunctionID >= 1) && (buttonSettings[i].FunctionID <= 4) &&
+            ((buttonSettings[i].ActionID == 1) || (buttonSettings[i].ActionID == 2))) {
+            buttonControl[buttonSettings[i].FunctionID - 1] = true;
+        }
+    }
+    m_sender->setChannels(rollChannel, pitchChannel, yawChannel, throttleChannel, channelReverse);
+    m_sender->setButtonControlled(buttonControl[0], buttonControl[1], buttonControl[2], buttonControl[3]);
+}
+
+/**
+   The joystick commands are sent while in local GCS control
+ */
+void GCSControlGadget::controlChanged()
+{
+    GCSControlGadgetWidget *widget = (GCSControlGadgetWidget *)m_widget;
+
+    m_sender->setEnabled(widget->getGCSControl() && !widget->getUDPControl());
 }
 
 ManualControlCommand *GCSControlGadget::getManualControlCommand()
@@ -420,69 +449,6 @@ void GCSControlGadget::buttonState(ButtonNumber number, bool pressed)
     // buttonSettings[number].Amount
 }
 
-void GCSControlGadget::axesValues(QListInt16 values)
-{
-    int chMax = values.length();
-
-    if (rollChannel >= chMax || pitchChannel >= chMax ||
-        yawChannel >= chMax || throttleChannel >= chMax) {
-        qDebug() << "GCSControl: configuration is inconsistent with current joystick! Aborting update.";
-        return;
-    }
-
-    double rValue = (rollChannel > -1) ? values[rollChannel] : 0;
-    double pValue = (pitchChannel > -1) ? values[pitchChannel] : 0;
-    double yValue = (yawChannel > -1) ? values[yawChannel] : 0;
-    double tValue = (throttleChannel > -1) ? values[throttleChannel] : 0;
-    double max    = 32767;
-
-    if (rollChannel > -1) {
-        if (channelReverse[rollChannel] == true) {
-            rValue = -rValue;
-        }
-    }
-    if (pitchChannel > -1) {
-        if (channelReverse[pitchChannel] == true) {
-            pValue = -pValue;
-        }
-    }
-    if (yawChannel > -1) {
-        if (channelReverse[yawChannel] == true) {
-            yValue = -yValue;
-        }
-    }
-    if (throttleChannel > -1) {
-        if (channelReverse[throttleChannel] == true) {
-            tValue = -tValue;
-        }
-    }
-
-
-    if (joystickTime.elapsed() > JOYSTICK_UPDATE_RATE) {
-        joystickTime.restart();
-        // Remap RPYT to left X/Y and right X/Y depending on mode
-        // Mode 1: LeftX = Yaw, LeftY = Pitch, RightX = Roll, RightY = Throttle
-        // Mode 2: LeftX = Yaw, LeftY = THrottle, RightX = Roll, RightY = Pitch
-        // Mode 3: LeftX = Roll, LeftY = Pitch, RightX = Yaw, RightY = Throttle
-        // Mode 4: LeftX = Roll, LeftY = Throttle, RightX = Yaw, RightY = Pitch;
-        switch (controlsMode) {
-        case 1:
-            sticksChangedLocally(yValue / max, -pValue / max, rValue / max, -tValue / max);
-            break;
-        case 2:
-            sticksChangedLocally(yValue / max, -tValue / max, rValue / max, -pValue / max);
-            break;
-        case 3:
-            sticksChangedLocally(rValue / max, -pValue / max, yValue / max, -tValue / max);
-            break;
-        case 4:
-            sticksChangedLocally(rValue / max, -tValue / max, yValue / max, -pValue / max);
-            break;
-        }
-    }
-}
-
-
 double GCSControlGadget::bound(double input)
 {
     if (input > 1.0) {
@@ -32,7 +32,8 @@
 #include "manualcontrolcommand.h"
 #include "gcscontrolgadgetconfiguration.h"
 #include "sdlgamepad/sdlgamepad.h"
-#include <QTime>
+#include "gcscontrolsender.h"
+#include <QThread>
 #include "gcscontrolplugin.h"
 #include <QUdpSocket>
 #include <QHostAddress>
@@ -71,7 +72,6 @@ public:
 private:
     ManualControlCommand *getManualControlCommand();
     double constrain(double value);
-    QTime joystickTime;
     QWidget *m_widget;
     QList<int> m_context;
     UAVObject::Metadata mccInitialData;
@@ -86,6 +86,10 @@ private:
     bool channelReverse[8];
     QUdpSocket *control_sock;
 
+    // the joystick commands are sent from their own thread
+    QThread m_controlThread;
+    GCSControlSender *m_sender;
+
 
 signals:
     void sticksChangedRemotely(double leftX, double leftY, double rightX, double rightY);
@@ -94,11 +98,11 @@ protected slots:
     void manualControlCommandUpdated(UAVObject *);
     void sticksChangedLocally(double leftX, double leftY, double rightX, double rightY);
     void readUDPCommand();
+    void controlChanged();
 
     // signals from joystick
     void gamepads(quint8 count);
     void buttonState(ButtonNumber number, bool pressed);
-    void axesValues(QListInt16 values);
 };
 
 
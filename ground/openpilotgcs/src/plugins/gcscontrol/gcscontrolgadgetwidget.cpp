@@ -101,6 +101,11 @@ void GCSControlGadgetWidget::updateSticks(double nleftX, double nleftY, double n
     m_gcscontrol->widgetRightStick->changePosition(rightX, rightY);
 }
 
+void GCSControlGadgetWidget::updateLatency(double ms)
+{
+    m_gcscontrol->labelLatency->setText(tr("Latency: %1 ms").arg(ms, 0, 'f', 1));
+}
+
 void GCSControlGadgetWidget::leftStickClicked(double X, double Y)
 {
     leftX = X;
@@ -142,6 +147,7 @@ void GCSControlGadgetWidget::toggleControl(int state)
     }
     manualControlCommand->setMetadata(mdata);
     accessoryDesired->setMetadata(mdata);
+    emit controlChanged();
 }
 
 void GCSControlGadgetWidget::toggleArmed(int state)
@@ -170,6 +176,7 @@ void GCSControlGadgetWidget::toggleUDPControl(int state)
     } else {
         setUDPControl(false);
     }
+    emit controlChanged();
 }
 
 /*!
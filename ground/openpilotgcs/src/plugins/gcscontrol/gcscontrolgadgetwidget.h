@@ -50,10 +50,12 @@ public:
 
 signals:
     void sticksChanged(double leftX, double leftY, double rightX, double rightY);
+    void controlChanged();
 
 public slots:
     // signals from parent gadget indicating change from flight
     void updateSticks(double leftX, double leftY, double rightX, double rightY);
+    void updateLatency(double ms);
 
     // signals from children widgets indicating a local change
     void leftStickClicked(double X, double Y);
@@ -0,0 +1,169 @@
+/**
+ ******************************************************************************
+ *
+ * @file       gcscontrolsender.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GCSControlGadgetPlugin GCSControl Gadget Plugin
+ * @{
+ * @brief Sends the joystick commands from a dedicated thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "gcscontrolsender.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+
+GCSControlSender::GCSControlSender(ManualControlCommand *manualControlCommand) :
+    m_manualControlCommand(manualControlCommand), m_timer(NULL), m_enabled(false),
+    m_hasSample(false), m_newSample(false), m_roll(0), m_pitch(0), m_yaw(0), m_throttle(0),
+    m_sampleTime(0), m_latencySum(0), m_latencyCount(0), m_lastReport(0)
+{
+    for (int i = 0; i < 4; i++) {
+        m_channels[i] = -1;
+        m_buttonControlled[i] = false;
+    }
+    for (int i = 0; i < ChannelCount; i++) {
+        m_reverse[i] = false;
+    }
+    m_clock.start();
+}
+
+void GCSControlSender::setChannels(int roll, int pitch, int yaw, int throttle, const bool reverse[ChannelCount])
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_channels[0] = roll;
+    m_channels[1] = pitch;
+    m_channels[2] = yaw;
+    m_channels[3] = throttle;
+    for (int i = 0; i < ChannelCount; i++) {
+        m_reverse[i] = reverse[i];
+    }
+}
+
+void GCSControlSender::setButtonControlled(bool roll, bool pitch, bool yaw, bool throttle)
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_buttonControlled[0] = roll;
+    m_buttonControlled[1] = pitch;
+    m_buttonControlled[2] = yaw;
+    m_buttonControlled[3] = throttle;
+}
+
+void GCSControlSender::setEnabled(bool enabled)
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_enabled = enabled;
+}
+
+/**
+ * Started in the control thread, so that the send timer runs there
+ */
+void GCSControlSender::start()
+{
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(send()));
+    m_timer->start(SendPeriod);
+}
+
+void GCSControlSender::axesValues(QListInt16 values)
+{
+    QMutexLocker lock(&m_mutex);
+    int chMax = values.length();
+    double axis[4];
+
+    for (int i = 0; i < 4; i++) {
+        if (m_channels[i] >= chMax) {
+            qDebug() << "GCSControl: configuration is inconsistent with current joystick! Aborting update.";
+            return;
+        }
+        axis[i] = (m_channels[i] > -1) ? values[m_channels[i]] / 32767.0 : 0.0;
+        if (m_channels[i] > -1 && m_channels[i] < ChannelCount && m_reverse[m_channels[i]]) {
+            axis[i] = -axis[i];
+        }
+    }
+
+    // the stick modes only change the display, the axes map to the same commands
+    m_roll     = axis[0];
+    m_pitch    = axis[1];
+    m_yaw      = axis[2];
+    // convert the throttle stick range (-1..+1) to ManualControlCommand.Throttle range (0..1)
+    m_throttle = (1.0 - axis[3]) / 2.0;
+    // safety value to stop the motors from spinning at 0% throttle
+    if (m_throttle <= 0.01) {
+        m_throttle = -1;
+    }
+    if (!m_newSample) {
+        m_sampleTime = m_clock.nsecsElapsed();
+    }
+    m_hasSample = true;
+    m_newSample = true;
+}
+
+/**
+ * Sends the latest sample, also when unchanged so that the rate stays fixed
+ */
+void GCSControlSender::send()
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (!m_enabled || !m_hasSample) {
+        m_latencySum   = 0;
+        m_latencyCount = 0;
+        return;
+    }
+
+    // field by field, the GUI thread sets the flight mode and the button controlled axes
+    if (!m_buttonControlled[0]) {
+        m_manualControlCommand->setRoll(m_roll);
+    }
+    if (!m_buttonControlled[1]) {
+        m_manualControlCommand->setPitch(m_pitch);
+    }
+    if (!m_buttonControlled[2]) {
+        m_manualControlCommand->setYaw(m_yaw);
+    }
+    if (!m_buttonControlled[3]) {
+        m_manualControlCommand->setThrottle(m_throttle);
+        m_manualControlCommand->setThrust(m_throttle);
+    }
+    m_manualControlCommand->setConnected(ManualControlCommand::CONNECTED_TRUE);
+    m_manualControlCommand->updated();
+
+    qint64 now = m_clock.nsecsElapsed();
+    if (m_newSample) {
+        m_newSample     = false;
+        m_latencySum   += (now - m_sampleTime) / 1e6;
+        m_latencyCount += 1;
+    }
+    if (m_latencyCount > 0 && now / 1000000 - m_lastReport >= 1000) {
+        m_lastReport = now / 1000000;
+        emit latencyMeasured(m_latencySum / m_latencyCount);
+        m_latencySum   = 0;
+        m_latencyCount = 0;
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
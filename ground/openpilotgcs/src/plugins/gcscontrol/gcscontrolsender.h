@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ *
+ * @file       gcscontrolsender.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GCSControlGadgetPlugin GCSControl Gadget Plugin
+ * @{
+ * @brief Sends the joystick commands from a dedicated thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GCSCONTROLSENDER_H
+#define GCSCONTROLSENDER_H
+
+#include "manualcontrolcommand.h"
+#include "sdlgamepad/sdlgamepad.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * Lives in the control thread of the gadget: the gamepad samples are queued
+ * to it from the gamepad thread, and it sends the latest one in
+ * ManualControlCommand at a fixed rate. Neither path goes through the GUI
+ * thread, the manual updates are unacked and take the priority queue of the
+ * telemetry.
+ */
+class GCSControlSender : public QObject {
+    Q_OBJECT
+
+public:
+    static const int SendPeriod = 20; // ms
+    static const int ChannelCount = 8;
+
+    explicit GCSControlSender(ManualControlCommand *manualControlCommand);
+
+    // thread safe, called from the GUI thread
+    void setChannels(int roll, int pitch, int yaw, int throttle, const bool reverse[ChannelCount]);
+    void setButtonControlled(bool roll, bool pitch, bool yaw, bool throttle);
+    void setEnabled(bool enabled);
+
+signals:
+    // mean delay from the gamepad sample to its send, every second while sending
+    void latencyMeasured(double ms);
+
+public slots:
+    void start();
+    void axesValues(QListInt16 values);
+
+private slots:
+    void send();
+
+private:
+    ManualControlCommand *m_manualControlCommand;
+    QTimer *m_timer;
+
+    QMutex m_mutex;
+    bool m_enabled;
+    int m_channels[4]; // roll, pitch, yaw, throttle
+    bool m_reverse[ChannelCount];
+    bool m_buttonControlled[4];
+
+    // latest sample, in the control thread
+    bool m_hasSample;
+    bool m_newSample;
+    double m_roll, m_pitch, m_yaw, m_throttle;
+
+    QElapsedTimer m_clock;
+    qint64 m_sampleTime; // ns
+    double m_latencySum; // ms
+    int m_latencyCount;
+    qint64 m_lastReport; // ms
+};
+
+#endif // GCSCONTROLSENDER_H
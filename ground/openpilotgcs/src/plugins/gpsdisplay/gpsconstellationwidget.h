@@ -32,6 +32,8 @@
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
 
+#include "gpsparser.h"
+
 
 class GpsConstellationWidget : public QGraphicsView {
     Q_OBJECT
@@ -42,6 +44,7 @@ public:
 
 public slots:
     void updateSat(int index, int prn, int elevation, int azimuth, int snr);
+    void updateSats(const QList<GpsSatellite> &sats);
 
 
 private slots:
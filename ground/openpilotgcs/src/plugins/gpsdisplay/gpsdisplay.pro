@@ -11,7 +11,6 @@ HEADERS += gpsconstellationwidget.h
 HEADERS += gpsparser.h
 HEADERS += telemetryparser.h
 HEADERS += gpssnrwidget.h
-HEADERS += buffer.h
 HEADERS += nmeaparser.h
 HEADERS += gpsdisplaygadget.h
 HEADERS += gpsdisplaywidget.h
@@ -23,7 +22,6 @@ SOURCES += gpsconstellationwidget.cpp
 SOURCES += gpsparser.cpp
 SOURCES += telemetryparser.cpp
 SOURCES += gpssnrwidget.cpp
-SOURCES += buffer.cpp
 SOURCES += nmeaparser.cpp
 SOURCES += gpsdisplaygadget.cpp
 SOURCES += gpsdisplaygadgetfactory.cpp
@@ -35,9 +35,7 @@ GPSParser::GPSParser(QObject *parent) : QObject(parent)
 GPSParser::~GPSParser()
 {}
 
-void GPSParser::processInputStream(char c)
+void GPSParser::processInputStream(const QByteArray &data)
 {
-    {
-        Q_UNUSED(c)
-    }
+    Q_UNUSED(data)
 }
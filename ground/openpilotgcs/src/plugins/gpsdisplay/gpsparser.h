@@ -32,10 +32,18 @@
 #include <QtCore>
 #include <stdint.h>
 
+// One satellite of the constellation
+typedef struct {
+    int prn;
+    int elevation;
+    int azimuth;
+    int snr;
+} GpsSatellite;
+
 class GPSParser : public QObject {
     Q_OBJECT
 public: ~GPSParser();
-    virtual void processInputStream(char c);
+    virtual void processInputStream(const QByteArray &data);
 
 protected:
     GPSParser(QObject *parent = 0);
@@ -46,7 +54,7 @@ signals:
     void datetime(double, double); // Date then time
     void speedheading(double, double);
     void packet(QString); // Raw NMEA Packet (or just info)
-    void satellite(int, int, int, int, int); // Index, PRN, Elevation, Azimuth, SNR
+    void satellites(QList<GpsSatellite>); // Whole constellation, once per epoch
     void fixmode(QString); // Mode of fix: "Auto", "Manual".
     void fixtype(QString); // Type of fix: "NoGPS", "NoFix", "Fix2D", "Fix3D".
     void dop(double, double, double); // HDOP, VDOP, PDOP
@@ -52,6 +52,25 @@ void GpsSnrWidget::resizeEvent(QResizeEvent *event)
     }
 }
 
+/**
+ * Updates the whole constellation, the satellites missing from
+ * the list are cleared and the unchanged ones are not redrawn
+ */
+void GpsSnrWidget::updateSats(const QList<GpsSatellite> &sats)
+{
+    for (int index = 0; index < MAX_SATTELITES; index++) {
+        GpsSatellite sat = { 0, 0, 0, 0 };
+        if (index < sats.size()) {
+            sat = sats.at(index);
+        }
+        if (satellites[index][0] == sat.prn && satellites[index][1] == sat.elevation
+            && satellites[index][2] == sat.azimuth && satellites[index][3] == sat.snr) {
+            continue;
+        }
+        updateSat(index, sat.prn, sat.elevation, sat.azimuth, sat.snr);
+    }
+}
+
 void GpsSnrWidget::updateSat(int index, int prn, int elevation, int azimuth, int snr)
 {
     if (index >= MAX_SATTELITES) {
@@ -67,25 +67,55 @@
  */
 NMEAParser::NMEAParser(QObject *parent) : GPSParser(parent)
 {
-    bufferInit(&gpsRxBuffer, (unsigned char *)gpsRxData, 512);
-    gpsRxOverflow = 0;
+    gpsRxBuffer.reserve(NMEA_RXBUFFERSIZE);
+    gsvNextSentence = 1;
+    numUpdates      = 0;
+    numErrors       = 0;
+    gpsRxOverflow   = 0;
 }
 
 NMEAParser::~NMEAParser()
 {}
 
 /**
- * Called each time there are data in the input buffer
+ * Called each time there are data in the input buffer, all the complete
+ * sentences are processed and the partial one is kept for the next call
  */
-void NMEAParser::processInputStream(char c)
+void NMEAParser::processInputStream(const QByteArray &data)
 {
-    if (!bufferAddToEnd(&gpsRxBuffer, c)) {
-        // no space in buffer
-        // count overflow
+    gpsRxBuffer.append(data);
+
+    int pos = 0;
+    while (pos < gpsRxBuffer.size()) {
+        // look for a start of NMEA packet
+        int start = gpsRxBuffer.indexOf('$', pos);
+        if (start < 0) {
+            pos = gpsRxBuffer.size();
+            break;
+        }
+        // check for end of NMEA packet <CR><LF>
+        int end = gpsRxBuffer.indexOf("\r\n", start + 1);
+        if (end < 0) {
+            // keep the start until the full NMEA string is received
+            pos = start;
+            break;
+        }
+        // copy packet without the initial '$' to NmeaPacket,
+        // receive errors can generate erroneous long packets
+        int length = qMin(end - start - 1, NMEA_BUFFERSIZE - 1);
+        memcpy(NmeaPacket, gpsRxBuffer.constData() + start + 1, length);
+        NmeaPacket[length] = 0;
+        pos = end + 2;
+
+        nmeaProcess(NmeaPacket);
+    }
+    gpsRxBuffer.remove(0, pos);
+
+    if (gpsRxBuffer.size() >= NMEA_RXBUFFERSIZE) {
+        // we're logjammed, flush entire buffer
         gpsRxOverflow++;
-        return;
+        gpsRxBuffer.clear();
     }
-    nmeaProcess(&gpsRxBuffer);
 }
 
 
@@ -132,113 +162,51 @@ void NMEAParser::nmeaTerminateAtChecksum(char *gps_buffer)
 
 /**
  * Prosesses NMEA sentences
- * \param[in] cBuffer for prosessed nmea sentences
+ * \param[in] Buffer for the nmea sentence, without the initial '$'
  * \return Message code for found packet
- * \return 0xFF NO packet found
+ * \return 0xFF packet not known
  */
-uint8_t NMEAParser::nmeaProcess(cBuffer *rxBuffer)
+uint8_t NMEAParser::nmeaProcess(char *sentence)
 {
-    uint8_t foundpacket = NMEA_NODATA;
-    uint8_t startFlag   = false;
-    // u08 data;
-    uint16_t i, j;
-
-    // process the receive buffer
-    // go through buffer looking for packets
-    while (rxBuffer->datalength) {
-        // look for a start of NMEA packet
-        if (bufferGetAtIndex(rxBuffer, 0) == '$') {
-            // found start
-            startFlag = true;
-            // when start is found, we leave it intact in the receive buffer
-            // in case the full NMEA string is not completely received.  The
-            // start will be detected in the next nmeaProcess iteration.
-
-            // done looking for start
-            break;
-        } else {
-            bufferGetFromFront(rxBuffer);
-        }
-    }
+    uint8_t foundpacket = NMEA_UNKNOWN;
 
-    // if we detected a start, look for end of packet
-    if (startFlag) {
-        for (i = 1; i < (rxBuffer->datalength) - 1; i++) {
-            // check for end of NMEA packet <CR><LF>
-            if ((bufferGetAtIndex(rxBuffer, i) == '\r') && (bufferGetAtIndex(rxBuffer, i + 1) == '\n')) {
-                // have a packet end
-                // dump initial '$'
-                bufferGetFromFront(rxBuffer);
-                // copy packet to NmeaPacket
-                for (j = 0; j < (i - 1); j++) {
-                    // although NMEA strings should be 80 characters or less,
-                    // receive buffer errors can generate erroneous packets.
-                    // Protect against packet buffer overflow
-                    if (j < (NMEA_BUFFERSIZE - 1)) {
-                        NmeaPacket[j] = bufferGetFromFront(rxBuffer);
-                    } else {
-                        bufferGetFromFront(rxBuffer);
-                    }
-                }
-                // null terminate it
-                if (j < (NMEA_BUFFERSIZE - 1)) {
-                    NmeaPacket[j] = 0;
-                } else {
-                    NmeaPacket[NMEA_BUFFERSIZE - 1] = 0;
-                }
-                // dump <CR><LF> from rxBuffer
-                bufferGetFromFront(rxBuffer);
-                bufferGetFromFront(rxBuffer);
-                // DEBUG
+    // DEBUG
                                 #ifdef NMEA_DEBUG_PKT
-                qDebug() << NmeaPacket;
+    qDebug() << sentence;
                                 #endif
-                emit packet(QString(NmeaPacket));
-                // found a packet
-                // done with this processing session
-                foundpacket = NMEA_UNKNOWN;
-                break;
-            }
-        }
-    }
-
-    if (foundpacket) {
-        // check message type and process appropriately
-        if (!strncmp(NmeaPacket, "GPGGA", 5)) {
-            // process packet of this type
-            nmeaProcessGPGGA(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPGGA;
-        } else if (!strncmp(NmeaPacket, "GPVTG", 5)) {
-            // process packet of this type
-            nmeaProcessGPVTG(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPVTG;
-        } else if (!strncmp(NmeaPacket, "GPGSA", 5)) {
-            // process packet of this type
-            nmeaProcessGPGSA(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPGSA;
-        } else if (!strncmp(NmeaPacket, "GPRMC", 5)) {
-            // process packet of this type
-            nmeaProcessGPRMC(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPRMC;
-        } else if (!strncmp(NmeaPacket, "GPGSV", 5)) {
-            // Process packet of this type
-            nmeaProcessGPGSV(NmeaPacket);
-            // rerpot packet type
-            foundpacket = NMEA_GPGSV;
-        } else if (!strncmp(NmeaPacket, "GPZDA", 5)) {
-            // Process packet of this type
-            nmeaProcessGPZDA(NmeaPacket);
-            // rerpot packet type
-            foundpacket = NMEA_GPZDA;
-        }
-    } else if (rxBuffer->datalength >= rxBuffer->size) {
-        // if we found no packet, and the buffer is full
-        // we're logjammed, flush entire buffer
-        bufferFlush(rxBuffer);
+    emit packet(QString(sentence));
+
+    // check message type and process appropriately
+    if (!strncmp(sentence, "GPGGA", 5)) {
+        // process packet of this type
+        nmeaProcessGPGGA(sentence);
+        // report packet type
+        foundpacket = NMEA_GPGGA;
+    } else if (!strncmp(sentence, "GPVTG", 5)) {
+        // process packet of this type
+        nmeaProcessGPVTG(sentence);
+        // report packet type
+        foundpacket = NMEA_GPVTG;
+    } else if (!strncmp(sentence, "GPGSA", 5)) {
+        // process packet of this type
+        nmeaProcessGPGSA(sentence);
+        // report packet type
+        foundpacket = NMEA_GPGSA;
+    } else if (!strncmp(sentence, "GPRMC", 5)) {
+        // process packet of this type
+        nmeaProcessGPRMC(sentence);
+        // report packet type
+        foundpacket = NMEA_GPRMC;
+    } else if (!strncmp(sentence, "GPGSV", 5)) {
+        // Process packet of this type
+        nmeaProcessGPGSV(sentence);
+        // rerpot packet type
+        foundpacket = NMEA_GPGSV;
+    } else if (!strncmp(sentence, "GPZDA", 5)) {
+        // Process packet of this type
+        nmeaProcessGPZDA(sentence);
+        // rerpot packet type
+        foundpacket = NMEA_GPZDA;
     }
     return foundpacket;
 }
@@ -270,24 +238,31 @@ void NMEAParser::nmeaProcessGPGSV(char *packet)
     const int sentence_total = tokenslist.at(1).toInt(); // Number of sentences for full data
     const int sentence_index = tokenslist.at(2).toInt(); // sentence x of y
 
+    // The satellites are collected over the whole cycle and sent at once,
+    // a cycle with a missing sentence is dropped
+    if (sentence_index == 1) {
+        gsvSatellites.clear();
+    } else if (sentence_index != gsvNextSentence) {
+        gsvNextSentence = 1;
+        return;
+    }
+    gsvNextSentence = sentence_index + 1;
+
     int sats = (tokenslist.size() - 4) / 4;
     for (int sat = 0; sat < sats; sat++) {
-        int base          = 4 + sat * 4;
-        const int id      = tokenslist.at(base + 0).toInt(); // Satellite PRN number
-        const int elv     = tokenslist.at(base + 1).toInt(); // Elevation, degrees
-        const int azimuth = tokenslist.at(base + 2).toInt(); // Azimuth, degrees
-        const int sig     = tokenslist.at(base + 3).toInt(); // SNR - higher is better
-        const int index   = (sentence_index - 1) * 4 + sat;
-        emit satellite(index, id, elv, azimuth, sig);
+        int base = 4 + sat * 4;
+        GpsSatellite satellite;
+        satellite.prn       = tokenslist.at(base + 0).toInt(); // Satellite PRN number
+        satellite.elevation = tokenslist.at(base + 1).toInt(); // Elevation, degrees
+        satellite.azimuth   = tokenslist.at(base + 2).toInt(); // Azimuth, degrees
+        satellite.snr       = tokenslist.at(base + 3).toInt(); // SNR - higher is better
+        gsvSatellites.append(satellite);
     }
 
     if (sentence_index == sentence_total) {
-        // Last sentence
-        int total_sats = (sentence_index - 1) * 4 + sats;
-        for (int emptySatIndex = total_sats; emptySatIndex < 16; emptySatIndex++) {
-            // Wipe the rest.
-            emit satellite(emptySatIndex, 0, 0, 0, 0);
-        }
+        // Last sentence, the widgets wipe the rest
+        gsvNextSentence = 1;
+        emit satellites(gsvSatellites);
     }
 }
 
@@ -31,11 +31,11 @@
 #include <QObject>
 #include <QtCore>
 #include <stdint.h>
-#include "buffer.h"
 #include "gpsparser.h"
 
 // constants/macros/typdefs
-#define NMEA_BUFFERSIZE 128
+#define NMEA_BUFFERSIZE   128
+#define NMEA_RXBUFFERSIZE 512
 
 typedef struct struct_GpsData {
     double Latitude;
@@ -59,11 +59,11 @@ class NMEAParser : public GPSParser {
 public:
     NMEAParser(QObject *parent = 0);
     ~NMEAParser();
-    void processInputStream(char c);
+    void processInputStream(const QByteArray &data);
     char *nmeaGetPacketBuffer(void);
     char nmeaChecksum(char *gps_buffer);
     void nmeaTerminateAtChecksum(char *gps_buffer);
-    uint8_t nmeaProcess(cBuffer *rxBuffer);
+    uint8_t nmeaProcess(char *packet);
     void nmeaProcessGPGGA(char *packet);
     void nmeaProcessGPRMC(char *packet);
     void nmeaProcessGPVTG(char *packet);
@@ -71,8 +71,9 @@ public:
     void nmeaProcessGPGSV(char *packet);
     void nmeaProcessGPZDA(char *packet);
     GpsData_t GpsData;
-    cBuffer gpsRxBuffer;
-    char gpsRxData[512];
+    QByteArray gpsRxBuffer;
+    QList<GpsSatellite> gsvSatellites; // GSV cycle being received
+    int gsvNextSentence;
     char NmeaPacket[NMEA_BUFFERSIZE];
     uint32_t numUpdates;
     uint32_t numErrors;
@@ -106,9 +106,8 @@ void TelemetryParser::updateTime(UAVObject *object1)
 /**
    Updates the satellite constellation.
 
-   Not really optimized for now, we should only send updates for the stas
-   which have changed instead of updating everything... That said, Qt is supposed
-   to be able to optimize redraws anyway.
+   The object holds the whole constellation, it is sent as one batch and the
+   widgets only redraw the satellites which have changed.
  */
 void TelemetryParser::updateSats(UAVObject *object1)
 {
@@ -117,8 +116,14 @@ void TelemetryParser::updateSats(UAVObject *object1)
     UAVObjectField *azimuth   = object1->getField(QString("Azimuth"));
     UAVObjectField *snr       = object1->getField(QString("SNR"));
 
+    QList<GpsSatellite> sats;
     for (unsigned int i = 0; i < prn->getNumElements(); i++) {
-        emit satellite(i, prn->getValue(i).toInt(), elevation->getValue(i).toInt(),
-                       azimuth->getValue(i).toInt(), snr->getValue(i).toInt());
+        GpsSatellite sat;
+        sat.prn       = prn->getValue(i).toInt();
+        sat.elevation = elevation->getValue(i).toInt();
+        sat.azimuth   = azimuth->getValue(i).toInt();
+        sat.snr       = snr->getValue(i).toInt();
+        sats.append(sat);
     }
+    emit satellites(sats);
 }
@@ -43,6 +43,8 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings *qSettings, QObj
     settings.inPort = 0;
     settings.latitude             = "";
     settings.longitude            = "";
+    settings.sharedMemoryEnabled  = false;
+    settings.batchUpdates         = true;
 
     settings.attRawEnabled        = false;
     settings.attRawRate           = 20;
@@ -82,6 +84,8 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings *qSettings, QObj
         settings.longitude     = qSettings->value("longitude").toString();
         settings.startSim      = qSettings->value("startSim").toBool();
         settings.addNoise      = qSettings->value("noiseCheckBox").toBool();
+        settings.sharedMemoryEnabled = qSettings->value("sharedMemoryEnabled").toBool();
+        settings.batchUpdates  = qSettings->value("batchUpdates", true).toBool();
 
         settings.gcsReceiverEnabled   = qSettings->value("gcsReceiverEnabled").toBool();
         settings.manualControlEnabled = qSettings->value("manualControlEnabled").toBool();
@@ -138,6 +142,8 @@ void HITLConfiguration::saveConfig(QSettings *qSettings) const
     qSettings->setValue("longitude", settings.longitude);
     qSettings->setValue("addNoise", settings.addNoise);
     qSettings->setValue("startSim", settings.startSim);
+    qSettings->setValue("sharedMemoryEnabled", settings.sharedMemoryEnabled);
+    qSettings->setValue("batchUpdates", settings.batchUpdates);
 
     qSettings->setValue("gcsReceiverEnabled", settings.gcsReceiverEnabled);
     qSettings->setValue("manualControlEnabled", settings.manualControlEnabled);
@@ -82,6 +82,12 @@ QWidget *HITLOptionsPage::createPage(QWidget *parent)
 
     m_optionsPage->startSim->setChecked(config->Settings().startSim);
     m_optionsPage->noiseCheckBox->setChecked(config->Settings().addNoise);
+    m_optionsPage->sharedMemoryCheckBox->setChecked(config->Settings().sharedMemoryEnabled);
+    m_optionsPage->batchCheckBox->setChecked(config->Settings().batchUpdates);
+#ifndef Q_OS_UNIX
+    // simposix only runs on unix
+    m_optionsPage->sharedMemoryCheckBox->hide();
+#endif
 
     m_optionsPage->hostAddress->setText(config->Settings().hostAddress);
     m_optionsPage->remoteAddress->setText(config->Settings().remoteAddress);
@@ -126,6 +132,8 @@ void HITLOptionsPage::apply()
     settings.dataPath             = m_optionsPage->dataPath->path();
     settings.startSim             = m_optionsPage->startSim->isChecked();
     settings.addNoise             = m_optionsPage->noiseCheckBox->isChecked();
+    settings.sharedMemoryEnabled  = m_optionsPage->sharedMemoryCheckBox->isChecked();
+    settings.batchUpdates         = m_optionsPage->batchCheckBox->isChecked();
     settings.hostAddress          = m_optionsPage->hostAddress->text();
     settings.remoteAddress        = m_optionsPage->remoteAddress->text();
 
@@ -5,6 +5,9 @@ QT += network
 include(../../openpilotgcsplugin.pri)
 include(hitl_dependencies.pri)
 
+# sensor ring shared with the simposix firmware
+INCLUDEPATH += $$GCS_SOURCE_TREE/../../shared/hitl
+
 HEADERS += hitlplugin.h \
     hitlwidget.h \
     hitloptionspage.h \
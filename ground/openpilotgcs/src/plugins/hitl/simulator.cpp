@@ -34,6 +34,14 @@
 #include <coreplugin/threadmanager.h>
 #include <uavtalk/telemetrymanager.h>
 
+#include "hitlsensorring.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 volatile bool Simulator::isStarted = false;
 
 const float Simulator::GEE      = 9.81;
@@ -50,6 +58,8 @@ Simulator::Simulator(const SimulatorSettings & params) :
     time(NULL),
     inSocket(NULL),
     outSocket(NULL),
+    sensorRing(NULL),
+    telemetryManager(NULL),
     settings(params),
     updatePeriod(50),
     simTimeout(8000),
@@ -96,6 +106,8 @@ Simulator::~Simulator()
         outSocket = NULL;
     }
 
+    closeSensorRing();
+
     if (txTimer) {
         delete txTimer;
         txTimer = NULL;
@@ -163,9 +175,9 @@ void Simulator::onStart()
     groundTruth   = GroundTruth::GetInstance(objManager);
 
     // Listen to autopilot connection events
-    TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
-    connect(telMngr, SIGNAL(connected()), this, SLOT(onAutopilotConnect()));
-    connect(telMngr, SIGNAL(disconnected()), this, SLOT(onAutopilotDisconnect()));
+    telemetryManager = pm->getObject<TelemetryManager>();
+    connect(telemetryManager, SIGNAL(connected()), this, SLOT(onAutopilotConnect()));
+    connect(telemetryManager, SIGNAL(disconnected()), this, SLOT(onAutopilotDisconnect()));
     // connect(telStats, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(telStatsUpdated(UAVObject*)));
 
     // If already connect setup autopilot
@@ -195,6 +207,14 @@ void Simulator::onStart()
 // emit processOutput(QString("Can't connect to %1 on %2 port!").arg(settings.hostAddress).arg(settings.outPort));
 
 
+    if (settings.sharedMemoryEnabled) {
+        if (openSensorRing()) {
+            emit processOutput(QString("Sensors written to the shared memory %1\n").arg(HITL_SENSOR_RING_NAME));
+        } else {
+            emit processOutput(QString("Can't create the shared memory %1, sensors sent by telemetry\n").arg(HITL_SENSOR_RING_NAME));
+        }
+    }
+
     connect(inSocket, SIGNAL(readyRead()), this, SLOT(receiveUpdate()), Qt::DirectConnection);
 
     // Setup transmit timer
@@ -245,7 +265,7 @@ void Simulator::setupObjects()
 {
     if (settings.gcsReceiverEnabled) {
         setupInputObject(actCommand, settings.minOutputPeriod); // Input to the simulator
-        setupOutputObject(gcsReceiver, settings.minOutputPeriod);
+        setupOutputObject(gcsReceiver, settings.minOutputPeriod, settings.batchUpdates);
     } else if (settings.manualControlEnabled) {
         setupInputObject(actDesired, settings.minOutputPeriod); // Input to the simulator
     }
@@ -253,37 +273,37 @@ void Simulator::setupObjects()
     setupOutputObject(posHome, 10000); // Hardcoded? Bleh.
 
     if (settings.gpsPositionEnabled) {
-        setupOutputObject(gpsPos, settings.gpsPosRate);
-        setupOutputObject(gpsVel, settings.gpsPosRate);
+        setupOutputObject(gpsPos, settings.gpsPosRate, settings.batchUpdates);
+        setupOutputObject(gpsVel, settings.gpsPosRate, settings.batchUpdates);
     }
 
     if (settings.groundTruthEnabled) {
-        setupOutputObject(posState, settings.groundTruthRate);
-        setupOutputObject(velState, settings.groundTruthRate);
+        setupOutputObject(posState, settings.groundTruthRate, settings.batchUpdates);
+        setupOutputObject(velState, settings.groundTruthRate, settings.batchUpdates);
     }
 
     if (settings.attRawEnabled) {
-        setupOutputObject(accelState, settings.attRawRate);
-        setupOutputObject(gyroState, settings.attRawRate);
+        setupOutputObject(accelState, settings.attRawRate, settings.batchUpdates);
+        setupOutputObject(gyroState, settings.attRawRate, settings.batchUpdates);
     }
 
     if (settings.attStateEnabled && settings.attActHW) {
-        setupOutputObject(accelState, settings.attRawRate);
-        setupOutputObject(gyroState, settings.attRawRate);
+        setupOutputObject(accelState, settings.attRawRate, settings.batchUpdates);
+        setupOutputObject(gyroState, settings.attRawRate, settings.batchUpdates);
     }
 
     if (settings.attStateEnabled && !settings.attActHW) {
-        setupOutputObject(attState, 20); // Hardcoded? Bleh.
+        setupOutputObject(attState, 20, settings.batchUpdates); // Hardcoded? Bleh.
     } else {
         setupWatchedObject(attState, 100); // Hardcoded? Bleh.
     }
     if (settings.airspeedStateEnabled) {
-        setupOutputObject(airspeedState, settings.airspeedStateRate);
+        setupOutputObject(airspeedState, settings.airspeedStateRate, settings.batchUpdates);
     }
 
     if (settings.baroSensorEnabled) {
-        setupOutputObject(baroAlt, settings.baroAltRate);
-        setupOutputObject(flightBatt, settings.baroAltRate);
+        setupOutputObject(baroAlt, settings.baroAltRate, settings.batchUpdates);
+        setupOutputObject(flightBatt, settings.baroAltRate, settings.batchUpdates);
     }
 }
 
@@ -329,7 +349,7 @@ void Simulator::setupWatchedObject(UAVObject *obj, quint32 updatePeriod)
 }
 
 
-void Simulator::setupOutputObject(UAVObject *obj, quint32 updatePeriod)
+void Simulator::setupOutputObject(UAVObject *obj, quint32 updatePeriod, bool batched)
 {
     UAVObject::Metadata mdata;
 
@@ -337,7 +357,8 @@ void Simulator::setupOutputObject(UAVObject *obj, quint32 updatePeriod)
 
     UAVObject::SetGcsAccess(mdata, UAVObject::ACCESS_READWRITE);
     UAVObject::SetGcsTelemetryAcked(mdata, false);
-    UAVObject::SetGcsTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_PERIODIC);
+    // Batched objects are sent together by updateUAVOs(), at the same period
+    UAVObject::SetGcsTelemetryUpdateMode(mdata, batched ? UAVObject::UPDATEMODE_MANUAL : UAVObject::UPDATEMODE_PERIODIC);
     mdata.gcsTelemetryUpdatePeriod = updatePeriod;
 
     UAVObject::SetFlightAccess(mdata, UAVObject::ACCESS_READONLY);
@@ -390,6 +411,8 @@ void Simulator::resetInitialHomePosition()
 void Simulator::updateUAVOs(Output2Hardware out)
 {
     QTime currentTime = QTime::currentTime();
+    // Output objects updated during this tick
+    QList<UAVObject *> batch;
 
     Noise noise;
     HitlNoiseGeneration noiseSource;
@@ -458,12 +481,19 @@ void Simulator::updateUAVOs(Output2Hardware out)
     // Set UAVO
     groundTruth->setData(groundTruthData);
 
+    /*******************************/
+    // With the shared memory the sensors go straight to simposix, which
+    // estimates the state itself, the telemetry only carries the rest
+    if (sensorRing) {
+        writeSensorRing(out, noise, currentTime);
+    }
+
 /*******************************/
     // Update attState object
     AttitudeState::DataFields attStateData;
     attStateData = attState->getData();
 
-    if (settings.attActHW) {
+    if (settings.attActHW || sensorRing) {
         // do nothing
         /*****************************************/
     } else if (settings.attActSim) {
@@ -484,6 +514,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
         // Set UAVO
         attState->setData(attStateData);
+        batch.append(attState);
         /*****************************************/
     } else if (settings.attActCalc) {
         // calculate RPY with code from Attitude module
@@ -605,6 +636,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
         // Set UAVO
         attState->setData(attStateData);
+        batch.append(attState);
         /*****************************************/
     }
 
@@ -619,6 +651,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             }
 
             gcsReceiver->setData(gcsRcvrData);
+            batch.append(gcsReceiver);
 
             gcsRcvrTime = gcsRcvrTime.addMSecs(settings.minOutputPeriod);
         }
@@ -626,7 +659,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
 
     /*******************************/
-    if (settings.gpsPositionEnabled) {
+    if (settings.gpsPositionEnabled && !sensorRing) {
         if (gpsPosTime.msecsTo(currentTime) >= settings.gpsPosRate) {
             qDebug() << " GPS time:" << gpsPosTime << ", currentTime: " << currentTime << ", difference: " << gpsPosTime.msecsTo(currentTime);
             // Update GPS Position objects
@@ -644,6 +677,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             gpsPosData.Status = GPSPositionSensor::STATUS_FIX3D;
 
             gpsPos->setData(gpsPosData);
+            batch.append(gpsPos);
 
             // Update GPS Velocity.{North,East,Down}
             GPSVelocitySensor::DataFields gpsVelData;
@@ -653,6 +687,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             gpsVelData.Down  = out.velDown + noise.gpsVelData.Down;
 
             gpsVel->setData(gpsVelData);
+            batch.append(gpsVel);
 
             gpsPosTime = gpsPosTime.addMSecs(settings.gpsPosRate);
         }
@@ -660,7 +695,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update VelocityState.{North,East,Down}
-    if (settings.groundTruthEnabled) {
+    if (settings.groundTruthEnabled && !sensorRing) {
         if (groundTruthTime.msecsTo(currentTime) >= settings.groundTruthRate) {
             VelocityState::DataFields velocityStateData;
             memset(&velocityStateData, 0, sizeof(VelocityState::DataFields));
@@ -668,6 +703,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             velocityStateData.East  = out.velEast + noise.velocityStateData.East;
             velocityStateData.Down  = out.velDown + noise.velocityStateData.Down;
             velState->setData(velocityStateData);
+            batch.append(velState);
 
             // Update PositionState.{Nort,East,Down}
             PositionState::DataFields positionStateData;
@@ -676,6 +712,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             positionStateData.East  = (out.dstE - initE) + noise.positionStateData.East;
             positionStateData.Down  = (out.dstD /*-initD*/) + noise.positionStateData.Down;
             posState->setData(positionStateData);
+            batch.append(posState);
 
             groundTruthTime = groundTruthTime.addMSecs(settings.groundTruthRate);
         }
@@ -705,7 +742,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update BaroSensor object
-    if (settings.baroSensorEnabled) {
+    if (settings.baroSensorEnabled && !sensorRing) {
         if (baroAltTime.msecsTo(currentTime) >= settings.baroAltRate) {
             BaroSensor::DataFields baroAltData;
             memset(&baroAltData, 0, sizeof(BaroSensor::DataFields));
@@ -713,6 +750,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             baroAltData.Temperature = out.temperature + noise.baroAltData.Temperature;
             baroAltData.Pressure    = out.pressure + noise.baroAltData.Pressure;
             baroAlt->setData(baroAltData);
+            batch.append(baroAlt);
 
             baroAltTime = baroAltTime.addMSecs(settings.baroAltRate);
         }
@@ -728,6 +766,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             batteryData.Current = out.current;
             batteryData.ConsumedEnergy = out.consumption;
             flightBatt->setData(batteryData);
+            batch.append(flightBatt);
 
             battTime = battTime.addMSecs(settings.baroAltRate);
         }
@@ -735,7 +774,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update AirspeedState object
-    if (settings.airspeedStateEnabled) {
+    if (settings.airspeedStateEnabled && !sensorRing) {
         if (airspeedStateTime.msecsTo(currentTime) >= settings.airspeedStateRate) {
             AirspeedState::DataFields airspeedStateData;
             memset(&airspeedStateData, 0, sizeof(AirspeedState::DataFields));
@@ -744,6 +783,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             // airspeedStateData.alpha=out.angleOfAttack; // to be implemented
             // airspeedStateData.beta=out.angleOfSlip;
             airspeedState->setData(airspeedStateData);
+            batch.append(airspeedState);
 
             airspeedStateTime = airspeedStateTime.addMSecs(settings.airspeedStateRate);
         }
@@ -751,7 +791,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update raw attitude sensors
-    if (settings.attRawEnabled) {
+    if (settings.attRawEnabled && !sensorRing) {
         if (attRawTime.msecsTo(currentTime) >= settings.attRawRate) {
             // Update gyroscope sensor data
             GyroState::DataFields gyroStateData;
@@ -760,6 +800,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
             gyroStateData.y = out.pitchRate + noise.gyroStateData.y;
             gyroStateData.z = out.yawRate + noise.gyroStateData.z;
             gyroState->setData(gyroStateData);
+            batch.append(gyroState);
 
             // Update accelerometer sensor data
             AccelState::DataFields accelStateData;
@@ -768,10 +809,115 @@ void Simulator::updateUAVOs(Output2Hardware out)
             accelStateData.y = out.accY + noise.accelStateData.y;
             accelStateData.z = out.accZ + noise.accelStateData.z;
             accelState->setData(accelStateData);
+            batch.append(accelState);
 
             attRawTime = attRawTime.addMSecs(settings.attRawRate);
         }
     }
+
+    /*******************************/
+    // Send the objects of the tick in one go instead of a packet each
+    if (settings.batchUpdates && !batch.isEmpty()) {
+        telemetryManager->sendObjectBatch(batch);
+    }
+}
+
+/**
+ * Create or reuse the shared memory ring read by the simposix HITL Sensors module
+ */
+bool Simulator::openSensorRing()
+{
+#ifdef Q_OS_UNIX
+    int fd = shm_open(HITL_SENSOR_RING_NAME, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(hitl_sensor_ring)) < 0) {
+        close(fd);
+        return false;
+    }
+    void *mem = mmap(NULL, sizeof(hitl_sensor_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+
+    // Start over, a simposix still reading a previous session sees the head going backward
+    sensorRing = static_cast<hitl_sensor_ring *>(mem);
+    sensorRing->head    = 0;
+    sensorRing->version = HITL_SENSOR_RING_VERSION;
+    __sync_synchronize();
+    sensorRing->magic   = HITL_SENSOR_RING_MAGIC;
+    return true;
+
+#else
+    return false;
+
+#endif
+}
+
+void Simulator::closeSensorRing()
+{
+#ifdef Q_OS_UNIX
+    // The object is left in place for the simposix that has it mapped
+    if (sensorRing) {
+        munmap(sensorRing, sizeof(hitl_sensor_ring));
+        sensorRing = NULL;
+    }
+#endif
+}
+
+/**
+ * Write a frame in the ring. Accels and gyros are in every frame, the other
+ * sensors at the rates of their settings.
+ */
+void Simulator::writeSensorRing(const Output2Hardware & out, const Noise & noise, const QTime & currentTime)
+{
+    hitl_sensor_frame &frame = sensorRing->frames[sensorRing->head % HITL_SENSOR_RING_LENGTH];
+
+    memset(&frame, 0, sizeof(hitl_sensor_frame));
+    frame.delT     = out.delT;
+    frame.accel[0] = out.accX + noise.accelStateData.x;
+    frame.accel[1] = out.accY + noise.accelStateData.y;
+    frame.accel[2] = out.accZ + noise.accelStateData.z;
+    frame.gyro[0]  = out.rollRate + noise.gyroStateData.x;
+    frame.gyro[1]  = out.pitchRate + noise.gyroStateData.y;
+    frame.gyro[2]  = out.yawRate + noise.gyroStateData.z;
+    frame.rpy[0]   = out.roll;
+    frame.rpy[1]   = out.pitch;
+    frame.rpy[2]   = out.heading;
+    frame.temperature = out.temperature + noise.baroAltData.Temperature;
+
+    if (settings.gpsPositionEnabled && gpsPosTime.msecsTo(currentTime) >= settings.gpsPosRate) {
+        frame.flags      |= HITL_SENSOR_GPS;
+        frame.latitude    = out.latitude + noise.gpsPosData.Latitude; // Already in *10^7 integer format
+        frame.longitude   = out.longitude + noise.gpsPosData.Longitude;
+        frame.altitude    = out.altitude + noise.gpsPosData.Altitude;
+        frame.groundspeed = out.groundspeed + noise.gpsPosData.Groundspeed;
+        frame.heading     = out.heading + noise.gpsPosData.Heading;
+        frame.velNED[0]   = out.velNorth + noise.gpsVelData.North;
+        frame.velNED[1]   = out.velEast + noise.gpsVelData.East;
+        frame.velNED[2]   = out.velDown + noise.gpsVelData.Down;
+        gpsPosTime = gpsPosTime.addMSecs(settings.gpsPosRate);
+    }
+
+    if (settings.baroSensorEnabled && baroAltTime.msecsTo(currentTime) >= settings.baroAltRate) {
+        frame.flags       |= HITL_SENSOR_BARO;
+        frame.baroAltitude = out.altitude + noise.baroAltData.Altitude;
+        frame.pressure     = out.pressure + noise.baroAltData.Pressure;
+        baroAltTime = baroAltTime.addMSecs(settings.baroAltRate);
+    }
+
+    if (settings.airspeedStateEnabled && airspeedStateTime.msecsTo(currentTime) >= settings.airspeedStateRate) {
+        frame.flags |= HITL_SENSOR_AIRSPEED;
+        frame.calibratedAirspeed = out.calibratedAirspeed + noise.airspeedState.CalibratedAirspeed;
+        frame.trueAirspeed = out.trueAirspeed + noise.airspeedState.TrueAirspeed;
+        airspeedStateTime  = airspeedStateTime.addMSecs(settings.airspeedStateRate);
+    }
+
+    // Publish the frame only once it is complete
+    __sync_synchronize();
+    sensorRing->head = sensorRing->head + 1;
 }
 
 /**
@@ -61,6 +61,10 @@
 #include <QProcess>
 #include <qmath.h>
 
+struct hitl_sensor_ring;
+struct Noise;
+class TelemetryManager;
+
 /**
  * just imagine this was a class without methods and all public properties
  */
@@ -122,6 +126,8 @@ typedef struct _CONNECTION {
     int     inPort;
     bool    startSim;
     bool    addNoise;
+    bool    sharedMemoryEnabled;
+    bool    batchUpdates;
     QString latitude;
     QString longitude;
 
@@ -315,6 +321,7 @@ protected:
     QTime *time;
     QUdpSocket *inSocket; // (new QUdpSocket());
     QUdpSocket *outSocket;
+    hitl_sensor_ring *sensorRing;
 
     ActuatorCommand *actCommand;
     ActuatorDesired *actDesired;
@@ -335,6 +342,7 @@ protected:
     GCSTelemetryStats *telStats;
     GCSReceiver *gcsReceiver;
     GroundTruth *groundTruth;
+    TelemetryManager *telemetryManager;
 
     SimulatorSettings settings;
 
@@ -368,11 +376,15 @@ private:
     volatile static bool isStarted;
     static QStringList instances;
     // QList<QScopedPointer<UAVDataObject> > requiredUAVObjects;
-    void setupOutputObject(UAVObject *obj, quint32 updatePeriod);
+    void setupOutputObject(UAVObject *obj, quint32 updatePeriod, bool batched = false);
     void setupInputObject(UAVObject *obj, quint32 updatePeriod);
     void setupWatchedObject(UAVObject *obj, quint32 updatePeriod);
     void setupObjects();
 
+    bool openSensorRing();
+    void closeSensorRing();
+    void writeSensorRing(const Output2Hardware & out, const Noise & noise, const QTime & currentTime);
+
     AirParameters airParameters;
 };
 
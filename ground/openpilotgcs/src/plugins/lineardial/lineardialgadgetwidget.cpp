@@ -27,6 +27,8 @@
 
 #include "lineardialgadgetwidget.h"
 #include <utils/stylehelper.h>
+#include <utils/rastersvgitem.h>
+#include <utils/svgrastercache.h>
 #include <QFileDialog>
 #include <QtOpenGL/QGLWidget>
 #include <QDebug>
@@ -168,10 +170,12 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
     QGraphicsScene *l_scene = scene();
 
     setBackgroundBrush(QBrush(Utils::StyleHelper::baseColor()));
+    // The pixmaps of the previous file are stale
+    Utils::SvgRasterCache::instance()->invalidate(m_renderer);
     if (QFile::exists(dfn) && m_renderer->load(dfn) && m_renderer->isValid()) {
         l_scene->clear(); // Beware: clear also deletes all objects
                           // which are currently in the scene
-        background = new QGraphicsSvgItem();
+        background = new RasterSvgItem();
         background->setSharedRenderer(m_renderer);
         background->setElementId("background");
         background->setFlags(QGraphicsItem::ItemClipsChildrenToShape |
@@ -183,15 +187,15 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         if (m_renderer->elementExists("red")) {
             // Order is important: red, then yellow then green
             // overlayed on top of each other
-            red = new QGraphicsSvgItem();
+            red = new RasterSvgItem();
             red->setSharedRenderer(m_renderer);
             red->setElementId("red");
             red->setParentItem(background);
-            yellow = new QGraphicsSvgItem();
+            yellow = new RasterSvgItem();
             yellow->setSharedRenderer(m_renderer);
             yellow->setElementId("yellow");
             yellow->setParentItem(background);
-            green = new QGraphicsSvgItem();
+            green = new RasterSvgItem();
             green->setSharedRenderer(m_renderer);
             green->setElementId("green");
             green->setParentItem(background);
@@ -268,7 +272,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
             startY = nRect.y();
             QTransform matrix;
             matrix.translate(startX, startY);
-            index  = new QGraphicsSvgItem();
+            index  = new RasterSvgItem();
             index->setSharedRenderer(m_renderer);
             index->setElementId("needle");
             index->setTransform(matrix, false);
@@ -321,7 +325,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
             qreal startY = textMatrix.mapRect(m_renderer->boundsOnElement("symbol")).y();
             QTransform matrix;
             matrix.translate(startX, startY);
-            fieldSymbol = new QGraphicsSvgItem();
+            fieldSymbol = new RasterSvgItem();
             fieldSymbol->setElementId("symbol");
             fieldSymbol->setSharedRenderer(m_renderer);
             fieldSymbol->setTransform(matrix, false);
@@ -331,7 +335,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         }
 
         if (m_renderer->elementExists("foreground")) {
-            foreground = new QGraphicsSvgItem();
+            foreground = new RasterSvgItem();
             foreground->setSharedRenderer(m_renderer);
             foreground->setElementId("foreground");
             foreground->setParentItem(background);
@@ -351,7 +355,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         qDebug() << "no file ";
         m_renderer->load(QString(":/lineardial/images/empty.svg"));
         l_scene->clear(); // This also deletes all items contained in the scene.
-        background  = new QGraphicsSvgItem();
+        background  = new RasterSvgItem();
         background->setSharedRenderer(m_renderer);
         l_scene->addItem(background);
         fieldName   = NULL;
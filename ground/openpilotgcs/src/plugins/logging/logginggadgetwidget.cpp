@@ -33,6 +33,7 @@
 #include <QTextEdit>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QFileDialog>
 #include <loggingplugin.h>
 
 LoggingGadgetWidget::LoggingGadgetWidget(QWidget *parent) : QLabel(parent)
@@ -58,6 +59,13 @@ void LoggingGadgetWidget::setPlugin(LoggingPlugin *p)
     connect(m_logging->pauseButton, SIGNAL(clicked()), p->getLogfile(), SLOT(pauseReplay()));
     connect(m_logging->pauseButton, SIGNAL(clicked()), scpPlugin, SLOT(stopPlotting()));
     connect(m_logging->playbackSpeed, SIGNAL(valueChanged(double)), p->getLogfile(), SLOT(setReplaySpeed(double)));
+    connect(m_logging->fastReplay, SIGNAL(toggled(bool)), p->getLogfile(), SLOT(setReplayAsFastAsPossible(bool)));
+    connect(p->getLogfile(), SIGNAL(replayStarted()), this, SLOT(replayStarted()));
+    connect(p->getLogfile(), SIGNAL(replayFinished()), this, SLOT(replayFinished()));
+    connect(p->getLogfile(), SIGNAL(replayPositionChanged(quint32)), this, SLOT(replayPositionChanged(quint32)));
+    connect(m_logging->positionSlider, SIGNAL(sliderMoved(int)), this, SLOT(showPosition(int)));
+    connect(m_logging->positionSlider, SIGNAL(sliderReleased()), this, SLOT(seekReplay()));
+    connect(m_logging->plotLogButton, SIGNAL(clicked()), this, SLOT(plotLog()));
     void pauseReplay();
     void resumeReplay();
 }
@@ -68,6 +76,57 @@ void LoggingGadgetWidget::stateChanged(QString status)
     m_logging->statusLabel->setText(status);
 }
 
+void LoggingGadgetWidget::replayStarted()
+{
+    LogFile *logFile = loggingPlugin->getLogfile();
+
+    m_logging->positionSlider->setRange(logFile->replayStartTime(), logFile->replayEndTime());
+    m_logging->positionSlider->setValue(logFile->replayStartTime());
+    m_logging->positionSlider->setEnabled(true);
+    showPosition(logFile->replayStartTime());
+}
+
+void LoggingGadgetWidget::replayFinished()
+{
+    m_logging->positionSlider->setEnabled(false);
+}
+
+void LoggingGadgetWidget::replayPositionChanged(quint32 timeStamp)
+{
+    // Don't fight the user while the slider is dragged
+    if (!m_logging->positionSlider->isSliderDown()) {
+        m_logging->positionSlider->setValue(timeStamp);
+        showPosition(timeStamp);
+    }
+}
+
+void LoggingGadgetWidget::seekReplay()
+{
+    loggingPlugin->getLogfile()->seekReplay(m_logging->positionSlider->value());
+}
+
+void LoggingGadgetWidget::plotLog()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Plot log"), QString(""), tr("OpenPilot Log (*.opl)"));
+
+    if (!fileName.isEmpty()) {
+        scpPlugin->loadLog(fileName);
+    }
+}
+
+void LoggingGadgetWidget::showPosition(int timeStamp)
+{
+    m_logging->positionLabel->setText(QString("%1 / %2").arg(formatTime(timeStamp))
+                                      .arg(formatTime(m_logging->positionSlider->maximum())));
+}
+
+QString LoggingGadgetWidget::formatTime(int timeStamp)
+{
+    int seconds = timeStamp / 1000;
+
+    return QString("%1:%2").arg(seconds / 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
 /**
  * @}
  * @}
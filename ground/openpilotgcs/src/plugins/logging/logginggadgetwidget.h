@@ -47,12 +47,20 @@ public:
 
 protected slots:
     void stateChanged(QString status);
+    void replayStarted();
+    void replayFinished();
+    void replayPositionChanged(quint32 timeStamp);
+    void seekReplay();
+    void plotLog();
+    void showPosition(int timeStamp);
 
 signals:
     void pause();
     void play();
 
 private:
+    static QString formatTime(int timeStamp);
+
     Ui_Logging *m_logging;
     LoggingPlugin *loggingPlugin;
     ScopeGadgetFactory *scpPlugin;
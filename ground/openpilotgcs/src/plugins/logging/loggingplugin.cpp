@@ -38,6 +38,7 @@
 #include <QList>
 #include <QErrorMessage>
 #include <QWriteLocker>
+#include <QTimer>
 
 #include <extensionsystem/pluginmanager.h>
 #include <QKeySequence>
@@ -114,6 +115,69 @@ QString LoggingConnection::shortName()
 }
 
 
+LoggingQueue::LoggingQueue() : head(&stub), tail(&stub)
+{
+    stub.next.store(NULL);
+}
+
+LoggingQueue::~LoggingQueue()
+{
+    Packet *packet;
+
+    while ((packet = pop())) {
+        delete packet;
+    }
+}
+
+/**
+ * Adds a packet, the queue takes ownership. Safe to call from any thread.
+ */
+void LoggingQueue::push(Packet *packet)
+{
+    packet->next.store(NULL);
+    Packet *prev = head.fetchAndStoreOrdered(packet);
+    prev->next.storeRelease(packet);
+}
+
+/**
+ * Takes the oldest packet, the caller gets ownership. Must only be called from one thread.
+ * \return The packet or NULL if the queue is empty, or the next packet is still being pushed
+ */
+LoggingQueue::Packet *LoggingQueue::pop()
+{
+    Packet *first = tail;
+    Packet *next  = first->next.loadAcquire();
+
+    if (first == &stub) {
+        if (!next) {
+            return NULL;
+        }
+        tail  = next;
+        first = next;
+        next  = next->next.loadAcquire();
+    }
+    if (next) {
+        tail = next;
+        return first;
+    }
+    if (first != head.loadAcquire()) {
+        // A push is in progress
+        return NULL;
+    }
+    // Put the stub back so the last packet can be taken
+    push(&stub);
+    next = first->next.loadAcquire();
+    if (next) {
+        tail = next;
+        return first;
+    }
+    return NULL;
+}
+
+
+LoggingThread::LoggingThread() : telemetryManager(NULL), lastFlush(0)
+{}
+
 LoggingThread::~LoggingThread()
 {
     stopLogging();
@@ -129,33 +193,53 @@ bool LoggingThread::openFile(QString file, LoggingPlugin *parent)
 {
     logFile.setFileName(file);
     logFile.open(QIODevice::WriteOnly);
+    logTime.start();
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    telemetryManager = pm->getObject<TelemetryManager>();
 
-    uavTalk = new UAVTalk(&logFile, objManager);
     connect(parent, SIGNAL(stopLoggingSignal()), this, SLOT(stopLogging()));
 
     return true;
 };
 
 /**
- * Logs an object update to the file.  Data format is the
+ * Queues an object packet sent or received by the telemetry. Data format is the
  * timestamp as a 32 bit uint counting ms from start of
  * file writing (flight time will be embedded in stream),
- * then object packet size, then the packed UAVObject.
+ * then object packet size, then the UAVTalk packet.
+ * Called from the telemetry thread, the packet is written later by the logging thread.
  */
-void LoggingThread::objectUpdated(UAVObject *obj)
+void LoggingThread::recordPacket(const quint8 *packet, qint32 length)
+{
+    LoggingQueue::Packet *logPacket = new LoggingQueue::Packet;
+
+    logPacket->timeStamp = logTime.elapsed();
+    logPacket->data      = QByteArray((const char *)packet, length);
+    packets.push(logPacket);
+}
+
+/**
+ * Moves the queued packets to the log file, runs in the logging thread
+ */
+void LoggingThread::writePackets()
 {
     QWriteLocker locker(&lock);
+    LoggingQueue::Packet *packet;
 
-    if (!uavTalk->sendObject(obj, false, false)) {
-        qDebug() << "Error logging " << obj->getName();
+    while ((packet = packets.pop())) {
+        logFile.writePacket(packet->timeStamp, packet->data.constData(), packet->data.size());
+        delete packet;
     }
-};
+
+    if (logTime.elapsed() - lastFlush >= FLUSH_PERIOD) {
+        logFile.flushPackets();
+        lastFlush = logTime.elapsed();
+    }
+}
 
 /**
- * Connect signals from all the objects updates to the write routine then
+ * Start recording the telemetry packets then
  * run event loop
  */
 void LoggingThread::run()
@@ -163,19 +247,12 @@ void LoggingThread::run()
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
-    QList< QList<UAVObject *> > list;
-    list = objManager->getObjects();
-    QList< QList<UAVObject *> >::const_iterator i;
-    QList<UAVObject *>::const_iterator j;
-    int objects = 0;
-
-    for (i = list.constBegin(); i != list.constEnd(); ++i) {
-        for (j = (*i).constBegin(); j != (*i).constEnd(); ++j) {
-            connect(*j, SIGNAL(objectUpdated(UAVObject *)), (LoggingThread *)this, SLOT(objectUpdated(UAVObject *)));
-            objects++;
-            // qDebug() << "Detected " << j[0];
-        }
-    }
+    // The timer lives in this thread, so the writes happen here as well
+    QTimer writeTimer;
+    connect(&writeTimer, SIGNAL(timeout()), this, SLOT(writePackets()), Qt::DirectConnection);
+    writeTimer.start(WRITE_PERIOD);
+
+    telemetryManager->setRecorder(this);
 
     GCSTelemetryStats *gcsStatsObj = GCSTelemetryStats::GetInstance(objManager);
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
@@ -196,22 +273,14 @@ void LoggingThread::run()
  */
 void LoggingThread::stopLogging()
 {
-    QWriteLocker locker(&lock);
-
-    // Disconnect all objects we registered with:
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    // No packets are recorded anymore once this returns
+    if (telemetryManager) {
+        telemetryManager->setRecorder(NULL);
+    }
 
-    QList< QList<UAVObject *> > list;
-    list = objManager->getObjects();
-    QList< QList<UAVObject *> >::const_iterator i;
-    QList<UAVObject *>::const_iterator j;
+    writePackets();
 
-    for (i = list.constBegin(); i != list.constEnd(); ++i) {
-        for (j = (*i).constBegin(); j != (*i).constEnd(); ++j) {
-            disconnect(*j, SIGNAL(objectUpdated(UAVObject *)), (LoggingThread *)this, SLOT(objectUpdated(UAVObject *)));
-        }
-    }
+    QWriteLocker locker(&lock);
 
     logFile.close();
     qDebug() << "File closed";
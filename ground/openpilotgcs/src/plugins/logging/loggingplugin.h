@@ -35,11 +35,14 @@
 #include "uavobjectmanager.h"
 #include "gcstelemetrystats.h"
 #include <uavtalk/uavtalk.h>
+#include <uavtalk/telemetrymanager.h>
 #include <utils/logfile.h>
 
 #include <QThread>
 #include <QQueue>
 #include <QReadWriteLock>
+#include <QAtomicPointer>
+#include <QElapsedTimer>
 
 class LoggingPlugin;
 class LoggingGadgetFactory;
@@ -87,15 +90,41 @@ protected:
 };
 
 
-class LoggingThread : public QThread {
+/**
+ *   Lock-free queue of logged packets, any thread can push,
+ *   only the logging thread pops.
+ */
+class LoggingQueue {
+public:
+    struct Packet {
+        QAtomicPointer<Packet> next;
+        quint32    timeStamp;
+        QByteArray data;
+    };
+
+    LoggingQueue();
+    ~LoggingQueue();
+
+    void push(Packet *packet);
+    Packet *pop();
+
+private:
+    QAtomicPointer<Packet> head; // last pushed packet
+    Packet *tail; // next packet to pop, owned by the consumer
+    Packet stub;
+};
+
+class LoggingThread : public QThread, public UAVTalkRecorder {
     Q_OBJECT
 public:
+    LoggingThread();
     virtual ~LoggingThread();
 
     bool openFile(QString file, LoggingPlugin *parent);
+    void recordPacket(const quint8 *packet, qint32 length);
 
 private slots:
-    void objectUpdated(UAVObject *obj);
+    void writePackets();
     void transactionCompleted(UAVObject *obj, bool success);
 
 public slots:
@@ -105,7 +134,13 @@ protected:
     void run();
     QReadWriteLock lock;
     LogFile logFile;
-    UAVTalk *uavTalk;
+    LoggingQueue packets;
+    QElapsedTimer logTime;
+    TelemetryManager *telemetryManager;
+    qint64 lastFlush;
+
+    static const int WRITE_PERIOD = 50; // ms between writes of the queued packets
+    static const int FLUSH_PERIOD = 1000; // ms between flushes to the file
 
 private:
     QQueue<UAVDataObject *> queue;
@@ -36,9 +36,24 @@
 #include "viewport/glc_userinput.h"
 
 #include <iostream>
+#include <math.h>
+
+// Smallest attitude change, in degrees, worth a redraw
+#define ATTITUDE_THRESHOLD_DEG 0.2
+// Shortest time between two redraws triggered by attitude updates
+#define FRAME_PERIOD_MS        16
+
+// Swap on vertical sync, the redraws never run faster than the display
+static QGLFormat glFormat()
+{
+    QGLFormat format(QGL::SampleBuffers);
+
+    format.setSwapInterval(1);
+    return format;
+}
 
 ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
-    : QGLWidget(new GLC_Context(QGLFormat(QGL::SampleBuffers)), parent)
+    : QGLWidget(new GLC_Context(glFormat()), parent)
     , m_Light()
     , m_World()
     , m_GlView()
@@ -48,6 +63,7 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     , acFilename()
     , bgFilename()
     , vboEnable(false)
+    , attitudeValid(false)
 {
     connect(&m_GlView, SIGNAL(updateOpenGL()), this, SLOT(updateGL()));
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
@@ -69,7 +85,11 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
     attState = AttitudeState::GetInstance(objManager);
 
+    // The attitude is read when an update arrives, at most once per frame period
+    m_MotionTimer.setSingleShot(true);
     connect(&m_MotionTimer, SIGNAL(timeout()), this, SLOT(updateAttitude()));
+    connect(attState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(attitudeUpdated()));
+    lastFrame.start();
 }
 
 ModelViewGadgetWidget::~ModelViewGadgetWidget()
@@ -126,7 +146,8 @@ void ModelViewGadgetWidget::initializeGL()
     // Enable antialiasing
     glEnable(GL_MULTISAMPLE);
 
-    m_MotionTimer.start(100);
+    attitudeValid = false;
+    m_MotionTimer.start(0);
     setFocusPolicy(Qt::StrongFocus); // keyboard capture for camera switching
 }
 
@@ -201,6 +222,8 @@ void ModelViewGadgetWidget::CreateScene()
         if (QFile::exists(acFilename)) {
             QFile aircraft(acFilename);
             m_World = GLC_Factory::instance()->createWorldFromFile(aircraft);
+            // The meshes of the new world are kept in vertex buffer objects when enabled
+            m_World.collection()->setVboUsage(vboEnable);
             m_ModelBoundingBox = m_World.boundingBox();
             m_GlView.reframe(m_ModelBoundingBox); // center 3D model in the scene
         } else {
@@ -264,7 +287,8 @@ void ModelViewGadgetWidget::mouseReleaseEvent(QMouseEvent *)
         return;
     }
     m_MoverController.setNoMover();
-    m_MotionTimer.start();
+    attitudeValid = false;
+    m_MotionTimer.start(0);
     updateGL();
 }
 
@@ -320,9 +344,30 @@ void ModelViewGadgetWidget::keyPressEvent(QKeyEvent *e) // switch between camera
 //////////////////////////////////////////////////////////////////////
 // Private slots Functions
 //////////////////////////////////////////////////////////////////////
+void ModelViewGadgetWidget::attitudeUpdated()
+{
+    // No model updates while the camera is moved with the mouse
+    if (m_MotionTimer.isActive() || m_MoverController.hasActiveMover()) {
+        return;
+    }
+    m_MotionTimer.start(qMax(0, FRAME_PERIOD_MS - (int)lastFrame.elapsed()));
+}
+
 void ModelViewGadgetWidget::updateAttitude()
 {
     AttitudeState::DataFields data  = attState->getData(); // get attitude data
+
+    // Angle of the rotation between the shown attitude and the new one
+    double dot = fabs(data.q1 * lastAttitude[0] + data.q2 * lastAttitude[1] + data.q3 * lastAttitude[2] + data.q4 * lastAttitude[3]);
+    if (attitudeValid && 2.0 * acos(qMin(dot, 1.0)) < glc::toRadian(ATTITUDE_THRESHOLD_DEG)) {
+        return;
+    }
+    attitudeValid   = true;
+    lastAttitude[0] = data.q1;
+    lastAttitude[1] = data.q2;
+    lastAttitude[2] = data.q3;
+    lastAttitude[3] = data.q4;
+
     GLC_StructOccurence *rootObject = m_World.rootOccurence(); // get the full 3D model
     double x = data.q3;
     double y = data.q2;
@@ -349,4 +394,5 @@ void ModelViewGadgetWidget::updateAttitude()
     rootObject->structInstance()->setMatrix(rootObjectRotation);
     rootObject->updateChildrenAbsoluteMatrix();
     updateGL();
+    lastFrame.restart();
 }
@@ -30,6 +30,7 @@
 
 #include <QGLWidget>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include "glc_factory.h"
 #include "viewport/glc_viewport.h"
@@ -73,6 +74,7 @@ private:
 // Private slots Functions
 //////////////////////////////////////////////////////////////////////
 private slots:
+    void attitudeUpdated();
     void updateAttitude();
 
 private:
@@ -84,12 +86,16 @@ private:
     GLC_BoundingBox m_ModelBoundingBox;
     // ! The timer used for motion
     QTimer m_MotionTimer;
+    QElapsedTimer lastFrame;
 
     QString acFilename;
     QString bgFilename;
     bool vboEnable;
 
     AttitudeState *attState;
+    // The attitude quaternion shown
+    bool attitudeValid;
+    double lastAttitude[4];
 };
 
 #endif /* MODELVIEWGADGETWIDGET_H_ */
@@ -0,0 +1,139 @@
+/**
+ ******************************************************************************
+ *
+ * @file       notificationrule.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Notification conditions resolved once against their field, and
+ *             evaluated at a bounded rate for all the rules of an object
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   notifyplugin
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "notificationrule.h"
+#include "notificationitem.h"
+#include "notifypluginoptionspage.h"
+
+#include "uavdataobject.h"
+#include "uavobjectfield.h"
+
+const double NotificationRule::HysteresisRatio = 0.02;
+
+NotificationRule *NotificationRule::create(NotificationItem *notification, UAVDataObject *obj)
+{
+    UAVObjectField *field = obj->getField(notification->getObjectField());
+
+    if (field == NULL || field->getName().isEmpty()) {
+        return NULL;
+    }
+    return new NotificationRule(notification, field);
+}
+
+NotificationRule::NotificationRule(NotificationItem *notification, UAVObjectField *field) :
+    m_notification(notification), m_field(field), m_condition(notification->getCondition()),
+    m_isEnum(field->getType() == UAVObjectField::ENUM), m_min(0), m_max(0), m_hysteresis(0), m_active(false)
+{
+    if (m_isEnum) {
+        // match the option once, case insensitive as the configured value
+        QString value = notification->singleValue().toString();
+        foreach(const QString &option, field->getOptions()) {
+            if (!QString::compare(option, value, Qt::CaseInsensitive)) {
+                m_option = option;
+                break;
+            }
+        }
+    } else {
+        m_min = notification->singleValue().toDouble();
+        m_max = notification->valueRange2();
+        if (m_condition == NotifyPluginOptionsPage::inrange) {
+            m_hysteresis = qAbs(m_max - m_min) * HysteresisRatio;
+        } else if (m_condition != NotifyPluginOptionsPage::equal) {
+            m_hysteresis = qAbs(m_min) * HysteresisRatio;
+        }
+    }
+}
+
+bool NotificationRule::evaluate()
+{
+    if (m_isEnum) {
+        // only equality is meaningful for the enums
+        if (m_condition != NotifyPluginOptionsPage::equal) {
+            return true;
+        }
+        return !m_option.isEmpty() && m_field->getValue().toString() == m_option;
+    }
+
+    double value = m_field->getDouble();
+    // once active the bounds are relaxed by the hysteresis
+    double h     = m_active ? m_hysteresis : 0.0;
+
+    switch (m_condition) {
+    case NotifyPluginOptionsPage::equal:
+        m_active = (value == m_min);
+        break;
+
+    case NotifyPluginOptionsPage::bigger:
+        m_active = (value > m_min - h);
+        break;
+
+    case NotifyPluginOptionsPage::smaller:
+        m_active = (value < m_min + h);
+        break;
+
+    default:
+        m_active = (value > m_min - h) && (value < m_max + h);
+        break;
+    }
+    return m_active;
+}
+
+NotificationRuleSet::NotificationRuleSet(UAVDataObject *obj, QObject *parent) :
+    QObject(parent), m_object(obj)
+{
+    m_pending.setSingleShot(true);
+    connect(&m_pending, SIGNAL(timeout()), this, SLOT(evaluate()));
+    connect(m_object, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)), Qt::QueuedConnection);
+}
+
+NotificationRuleSet::~NotificationRuleSet()
+{
+    qDeleteAll(m_rules);
+}
+
+void NotificationRuleSet::objectUpdated(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    if (m_pending.isActive()) {
+        // the pending evaluation will see this update
+        return;
+    }
+    qint64 elapsed = m_lastEvaluation.isValid() ? m_lastEvaluation.elapsed() : EvaluationInterval;
+    if (elapsed >= EvaluationInterval) {
+        evaluate();
+    } else {
+        m_pending.start(EvaluationInterval - elapsed);
+    }
+}
+
+void NotificationRuleSet::evaluate()
+{
+    m_lastEvaluation.start();
+    emit evaluationDue(this);
+}
@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ *
+ * @file       notificationrule.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Notification conditions resolved once against their field, and
+ *             evaluated at a bounded rate for all the rules of an object
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   notifyplugin
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef NOTIFICATIONRULE_H
+#define NOTIFICATIONRULE_H
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class NotificationItem;
+class UAVObject;
+class UAVDataObject;
+class UAVObjectField;
+
+/**
+ * The condition of a notification, with its field and bounds looked up once.
+ * Numeric bounds have a hysteresis so that a noisy value does not toggle the
+ * condition around the threshold.
+ */
+class NotificationRule {
+public:
+    // ! hysteresis of the numeric bounds, relative to the threshold (or range width)
+    static const double HysteresisRatio;
+
+    // ! returns NULL if the field of the notification does not exist in obj
+    static NotificationRule *create(NotificationItem *notification, UAVDataObject *obj);
+
+    NotificationItem *notification() const
+    {
+        return m_notification;
+    }
+
+    // ! evaluates the condition on the current field value
+    bool evaluate();
+
+private:
+    NotificationRule(NotificationItem *notification, UAVObjectField *field);
+
+    NotificationItem *m_notification;
+    UAVObjectField *m_field;
+    int m_condition;
+    bool m_isEnum;
+    // ! option matched by enum rules, shares the data of the field options
+    QString m_option;
+    double m_min;
+    double m_max;
+    double m_hysteresis;
+    bool m_active;
+};
+
+/**
+ * The rules bound to one object. Object updates are coalesced so that the
+ * rules are evaluated at most once per EvaluationInterval, on the latest value.
+ */
+class NotificationRuleSet : public QObject {
+    Q_OBJECT
+
+public:
+    static const int EvaluationInterval = 250; // ms
+
+    NotificationRuleSet(UAVDataObject *obj, QObject *parent = 0);
+    ~NotificationRuleSet();
+
+    UAVDataObject *object() const
+    {
+        return m_object;
+    }
+    const QList<NotificationRule *> &rules() const
+    {
+        return m_rules;
+    }
+    void addRule(NotificationRule *rule)
+    {
+        m_rules.append(rule);
+    }
+
+signals:
+    void evaluationDue(NotificationRuleSet *ruleSet);
+
+private slots:
+    void objectUpdated(UAVObject *obj);
+    void evaluate();
+
+private:
+    UAVDataObject *m_object;
+    QList<NotificationRule *> m_rules;
+    QElapsedTimer m_lastEvaluation;
+    QTimer m_pending;
+};
+
+#endif // NOTIFICATIONRULE_H
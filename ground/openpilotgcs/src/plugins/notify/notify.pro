@@ -13,6 +13,7 @@ HEADERS += notifyplugin.h \
     notifyitemdelegate.h \
     notifytablemodel.h \
     notificationitem.h \
+    notificationrule.h \
     notifylogging.h
 
 SOURCES += notifyplugin.cpp \  
@@ -20,6 +21,7 @@ SOURCES += notifyplugin.cpp \
     notifyitemdelegate.cpp \
     notifytablemodel.cpp \
     notificationitem.cpp \
+    notificationrule.cpp \
     notifylogging.cpp
  
 OTHER_FILES += NotifyPlugin.pluginspec
@@ -176,11 +176,9 @@ void SoundNotifyPlugin::updateNotificationList(QList<NotificationItem *> list)
 
 void SoundNotifyPlugin::connectNotifications()
 {
-    foreach(UAVDataObject * obj, lstNotifiedUAVObjects) {
-        if (obj != NULL) {
-            disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(on_arrived_Notification(UAVObject *)));
-        }
-    }
+    qDeleteAll(_ruleSets);
+    _ruleSets.clear();
+    _rules.clear();
     if (phonon.mo != NULL) {
         delete phonon.mo;
         phonon.mo = NULL;
@@ -193,7 +191,7 @@ void SoundNotifyPlugin::connectNotifications()
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
-    lstNotifiedUAVObjects.clear();
+    QHash<UAVDataObject *, NotificationRuleSet *> ruleSets;
     _pendingNotifications.clear();
     _notificationList.append(_toRemoveNotifications);
     _toRemoveNotifications.clear();
@@ -213,17 +211,26 @@ void SoundNotifyPlugin::connectNotifications()
         }
 
         UAVDataObject *obj = dynamic_cast<UAVDataObject *>(objManager->getObject(notify->getDataObject()));
-        if (obj != NULL) {
-            if (!lstNotifiedUAVObjects.contains(obj)) {
-                lstNotifiedUAVObjects.append(obj);
-
-                connect(obj, SIGNAL(objectUpdated(UAVObject *)),
-                        this, SLOT(on_arrived_Notification(UAVObject *)),
-                        Qt::QueuedConnection);
-            }
-        } else {
+        if (obj == NULL) {
             qNotifyDebug() << "Error: Object is unknown (" << notify->getDataObject() << ").";
+            continue;
+        }
+        NotificationRule *rule = NotificationRule::create(notify, obj);
+        if (rule == NULL) {
+            qNotifyDebug() << "Error: Field is unknown (" << notify->getDataObject() << notify->getObjectField() << ").";
+            continue;
+        }
+        // the rules of the same object share its update rate limiting
+        NotificationRuleSet *ruleSet = ruleSets.value(obj);
+        if (ruleSet == NULL) {
+            ruleSet = new NotificationRuleSet(obj, this);
+            ruleSets.insert(obj, ruleSet);
+            _ruleSets.append(ruleSet);
+            connect(ruleSet, SIGNAL(evaluationDue(NotificationRuleSet *)),
+                    this, SLOT(on_evaluationDue_Notification(NotificationRuleSet *)));
         }
+        ruleSet->addRule(rule);
+        _rules.insert(notify, rule);
     }
 
     if (_notificationList.isEmpty()) {
@@ -236,14 +243,16 @@ void SoundNotifyPlugin::connectNotifications()
             this, SLOT(stateChanged(QMediaPlayer::State)));
 }
 
-void SoundNotifyPlugin::on_arrived_Notification(UAVObject *object)
+void SoundNotifyPlugin::on_evaluationDue_Notification(NotificationRuleSet *ruleSet)
 {
-    foreach(NotificationItem * ntf, _notificationList) {
-        if (object->getName() != ntf->getDataObject()) {
+    foreach(NotificationRule * rule, ruleSet->rules()) {
+        NotificationItem *ntf = rule->notification();
+
+        // the notifications played once are removed from the list
+        if (!_notificationList.contains(ntf)) {
             continue;
         }
 
-
         // skip duplicate notifications
         if (_nowPlayingNotification == ntf) {
             continue;
@@ -268,10 +277,8 @@ void SoundNotifyPlugin::on_arrived_Notification(UAVObject *object)
             .arg(ntf->singleValue().toString())
             .arg(ntf->valueRange2());
 
-        checkNotificationRule(ntf, object);
+        checkNotificationRule(rule);
     }
-    connect(object, SIGNAL(objectUpdated(UAVObject *)),
-            this, SLOT(on_arrived_Notification(UAVObject *)), Qt::UniqueConnection);
 }
 
 
@@ -295,11 +302,9 @@ void SoundNotifyPlugin::on_timerRepeated_Notification()
         .arg(notification->getObjectField())
         .arg(notification->toString());
 
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
-    UAVObject *object = objManager->getObject(notification->getDataObject());
-    if (object) {
-        checkNotificationRule(notification, object);
+    NotificationRule *rule = _rules.value(notification);
+    if (rule) {
+        checkNotificationRule(rule);
     }
 }
 
@@ -354,91 +359,16 @@ void SoundNotifyPlugin::stateChanged(QMediaPlayer::State newstate)
     }
 }
 
-bool checkRange(QString fieldValue, QString enumValue, QStringList /* values */, int direction)
-{
-    bool ret = false;
-
-    switch (direction) {
-    case NotifyPluginOptionsPage::equal:
-        ret = !QString::compare(enumValue, fieldValue, Qt::CaseInsensitive) ? true : false;
-        break;
-
-    default:
-        ret = true;
-        break;
-    }
-    ;
-    return ret;
-}
-
-bool checkRange(double fieldValue, double min, double max, int direction)
-{
-    bool ret = false;
-
-    // Q_ASSERT(min < max);
-    switch (direction) {
-    case NotifyPluginOptionsPage::equal:
-        ret = (fieldValue == min);
-        break;
-
-    case NotifyPluginOptionsPage::bigger:
-        ret = (fieldValue > min);
-        break;
-
-    case NotifyPluginOptionsPage::smaller:
-        ret = (fieldValue < min);
-        break;
-
-    default:
-        ret = (fieldValue > min) && (fieldValue < max);
-        break;
-    }
-    ;
-
-    return ret;
-}
-
-void SoundNotifyPlugin::checkNotificationRule(NotificationItem *notification, UAVObject *object)
+void SoundNotifyPlugin::checkNotificationRule(NotificationRule *rule)
 {
-    if (notification->getDataObject() != object->getName() || object->getField(notification->getObjectField()) == NULL) {
-        return;
-    }
-    bool condition = false;
+    NotificationItem *notification = rule->notification();
 
     if (notification->mute()) {
         return;
     }
 
-    int direction         = notification->getCondition();
-    QString fieldName     = notification->getObjectField();
-    UAVObjectField *field = object->getField(fieldName);
-
-    if (field->getName().isEmpty()) {
-        return;
-    }
-
-    QVariant value = field->getValue();
-    if (UAVObjectField::ENUM == field->getType()) {
-        qNotifyDebug() << "Check range ENUM" << value.toString() << "|" << notification->singleValue().toString() << "|" << field->getOptions() << "|" <<
-            direction << checkRange(value.toString(),
-                                    notification->singleValue().toString(),
-                                    field->getOptions(),
-                                    direction);;
-        condition = checkRange(value.toString(),
-                               notification->singleValue().toString(),
-                               field->getOptions(),
-                               direction);
-    } else {
-        qNotifyDebug() << "Check range VAL" << value.toString() << "|" << notification->singleValue().toString() << "|" << field->getOptions() << "|" <<
-            direction << checkRange(value.toDouble(),
-                                    notification->singleValue().toDouble(),
-                                    notification->valueRange2(),
-                                    direction);
-        condition = checkRange(value.toDouble(),
-                               notification->singleValue().toDouble(),
-                               notification->valueRange2(),
-                               direction);
-    }
+    bool condition = rule->evaluate();
+    qNotifyDebug() << "Check rule" << notification->getDataObject() << notification->getObjectField() << "|" << condition;
 
     notification->_isPlayed = condition;
     // if condition has been changed, and already in false state
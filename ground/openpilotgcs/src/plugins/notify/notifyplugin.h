@@ -32,8 +32,10 @@
 #include "uavobjectmanager.h"
 #include "uavobject.h"
 #include "notificationitem.h"
+#include "notificationrule.h"
 
 #include <QSettings>
+#include <QHash>
 #include <QMediaPlaylist>
 #include <QMediaPlayer>
 
@@ -83,7 +85,7 @@ private:
     Q_DISABLE_COPY(SoundNotifyPlugin)
 
     bool playNotification(NotificationItem *notification);
-    void checkNotificationRule(NotificationItem *notification, UAVObject *object);
+    void checkNotificationRule(NotificationRule *rule);
 
 private slots:
 
@@ -92,7 +94,7 @@ private slots:
     void connectNotifications();
     void updateNotificationList(QList<NotificationItem *> list);
     void resetNotification(void);
-    void on_arrived_Notification(UAVObject *object);
+    void on_evaluationDue_Notification(NotificationRuleSet *ruleSet);
     void on_timerRepeated_Notification(void);
     void on_expiredTimer_Notification(void);
     void stateChanged(QMediaPlayer::State newstate);
@@ -100,7 +102,9 @@ private slots:
 private:
     bool enableSound;
 
-    QList<UAVDataObject *> lstNotifiedUAVObjects;
+    // ! the rules of the notifications, grouped by object
+    QList<NotificationRuleSet *> _ruleSets;
+    QHash<NotificationItem *, NotificationRule *> _rules;
     QList<NotificationItem *> _notificationList;
     QList<NotificationItem *> _pendingNotifications;
     QList<NotificationItem *> _toRemoveNotifications;
@@ -34,6 +34,7 @@
 #include <QIODevice>
 #include <QMutex>
 #include <QByteArray>
+#include <QAtomicInt>
 #include "ophid_hidapi.h"
 #include "ophid_usbmon.h"
 
@@ -46,6 +47,9 @@ class RawHIDWriteThread;
  */
 class OPHID_EXPORT RawHID : public QIODevice {
     Q_OBJECT
+    // USB report counters, for the telemetry monitor
+    Q_PROPERTY(int reportsRead READ reportsRead)
+    Q_PROPERTY(int reportsWritten READ reportsWritten)
 
     friend class RawHIDReadThread;
     friend class RawHIDWriteThread;
@@ -59,6 +63,15 @@ public:
     virtual void close();
     virtual bool isSequential() const;
 
+    int reportsRead() const
+    {
+        return m_reportsRead.load();
+    }
+    int reportsWritten() const
+    {
+        return m_reportsWritten.load();
+    }
+
 signals:
     void closed();
 
@@ -88,6 +101,9 @@ protected:
 
     QMutex *m_mutex;
     QMutex *m_startedMutex;
+
+    QAtomicInt m_reportsRead;
+    QAtomicInt m_reportsWritten;
 };
 
 #endif // OPHID_H
@@ -33,6 +33,7 @@
 #include <QList>
 #include <QMutexLocker>
 #include <QWaitCondition>
+#include <QAtomicInt>
 
 class IConnection;
 
@@ -43,6 +44,71 @@ static const int READ_SIZE     = 64;
 static const int WRITE_TIMEOUT = 1000;
 static const int WRITE_SIZE    = 64;
 
+// ring sizes, must be powers of 2
+static const int READ_BUFFER_SIZE  = 65536;
+static const int WRITE_BUFFER_SIZE = 65536;
+
+
+// *********************************************************************************
+
+/**
+ *   Single producer single consumer byte ring. The producer only moves
+ *   the head and the consumer only moves the tail, so no lock is needed
+ *   between the USB thread and the thread using the device.
+ */
+class RawHIDRingBuffer {
+public:
+    RawHIDRingBuffer(int size) : m_buffer(size, 0), m_mask(size - 1), m_head(0), m_tail(0) {}
+
+    /** Return the bytes held */
+    int count() const
+    {
+        return (quint32)m_head.loadAcquire() - (quint32)m_tail.loadAcquire();
+    }
+
+    /** Return the bytes which can be written */
+    int space() const
+    {
+        return m_buffer.size() - count();
+    }
+
+    /** Producer side, append up to size bytes and return the number appended */
+    int write(const char *data, int size)
+    {
+        quint32 head = m_head.load();
+
+        size = qMin(size, m_buffer.size() - (int)(head - (quint32)m_tail.loadAcquire()));
+        int first = qMin(size, m_buffer.size() - (int)(head & m_mask));
+        memcpy(m_buffer.data() + (head & m_mask), data, first);
+        memcpy(m_buffer.data(), data + first, size - first);
+        m_head.storeRelease(head + size);
+        return size;
+    }
+
+    /** Consumer side, copy up to size bytes without removing them */
+    int peek(char *data, int size) const
+    {
+        quint32 tail = m_tail.load();
+
+        size = qMin(size, (int)((quint32)m_head.loadAcquire() - tail));
+        int first = qMin(size, m_buffer.size() - (int)(tail & m_mask));
+        memcpy(data, m_buffer.constData() + (tail & m_mask), first);
+        memcpy(data + first, m_buffer.constData(), size - first);
+        return size;
+    }
+
+    /** Consumer side, remove size bytes once they have been used */
+    void skip(int size)
+    {
+        m_tail.storeRelease(m_tail.load() + size);
+    }
+
+private:
+    QByteArray m_buffer;
+    quint32 m_mask;
+    QAtomicInt m_head;
+    QAtomicInt m_tail;
+};
 
 // *********************************************************************************
 
@@ -69,12 +135,8 @@ public slots:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-       a circular buffer but it's good enough and very simple */
-    QByteArray m_readBuffer;
-
-    /** A mutex to protect read buffer */
-    QMutex m_readBufMtx;
+    /** Filled by this thread, emptied by the device user */
+    RawHIDRingBuffer m_readBuffer;
 
     RawHID *m_hid;
 
@@ -110,16 +172,18 @@ public slots:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-       a circular buffer but it's good enough and very simple */
-    QByteArray m_writeBuffer;
+    /** Filled by the device user, emptied by this thread */
+    RawHIDRingBuffer m_writeBuffer;
 
-    /** A mutex to protect read buffer */
+    /** Only used to sleep while the ring is empty or full, the data is not protected */
     QMutex m_writeBufMtx;
 
     /** Synchronize task with data arival */
     QWaitCondition m_newDataToWrite;
 
+    /** Synchronize writer with room in the ring */
+    QWaitCondition m_spaceToWrite;
+
     RawHID *m_hid;
 
     opHID_hidapi *hiddev;
@@ -131,7 +195,8 @@ protected:
 // *********************************************************************************
 
 RawHIDReadThread::RawHIDReadThread(RawHID *hid)
-    : m_hid(hid),
+    : m_readBuffer(READ_BUFFER_SIZE),
+    m_hid(hid),
     hiddev(&hid->dev),
     hidno(hid->m_deviceNo),
     m_running(true)
@@ -157,8 +222,14 @@ void RawHIDReadThread::run()
     m_running = m_hid->openDevice();
 
     while (m_running) {
-        // here we use a temporary buffer so we don't need to lock
-        // the mutex while we are reading from the device
+        // the reports are left in the device when the user does not keep up
+        if (m_readBuffer.space() < READ_SIZE) {
+            msleep(1);
+            continue;
+        }
+
+        // here we use a temporary buffer so the ring is only
+        // touched once the report is complete
 
         // Want to read in regular chunks that match the packet size the device
         // is using.  In this case it is 64 bytes (the interrupt packet limit)
@@ -169,10 +240,10 @@ void RawHIDReadThread::run()
         int ret = hiddev->receive(hidno, buffer, READ_SIZE, READ_TIMEOUT);
 
         if (ret > 0) { // read some data
-            QMutexLocker lock(&m_readBufMtx);
             // Note: Preprocess the USB packets in this OS independent code
             // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append(&buffer[2], buffer[1]);
+            m_readBuffer.write(&buffer[2], qBound(0, (int)buffer[1], READ_SIZE - 2));
+            m_hid->m_reportsRead.ref();
 
             emit m_hid->readyRead();
         } else if (ret == 0) { // nothing read
@@ -188,27 +259,22 @@ void RawHIDReadThread::run()
 
 int RawHIDReadThread::getReadData(char *data, int size)
 {
-    QMutexLocker lock(&m_readBufMtx);
-
-    size = qMin(size, m_readBuffer.size());
-
-    memcpy(data, m_readBuffer.constData(), size);
-    m_readBuffer.remove(0, size);
+    size = m_readBuffer.peek(data, size);
+    m_readBuffer.skip(size);
 
     return size;
 }
 
 qint64 RawHIDReadThread::getBytesAvailable()
 {
-    QMutexLocker lock(&m_readBufMtx);
-
-    return m_readBuffer.size();
+    return m_readBuffer.count();
 }
 
 // *********************************************************************************
 
 RawHIDWriteThread::RawHIDWriteThread(RawHID *hid)
-    : m_hid(hid),
+    : m_writeBuffer(WRITE_BUFFER_SIZE),
+    m_hid(hid),
     hiddev(&hid->dev),
     hidno(hid->m_deviceNo),
     m_running(true)
@@ -226,47 +292,48 @@ RawHIDWriteThread::~RawHIDWriteThread()
 void RawHIDWriteThread::run()
 {
     while (m_running) {
-        char buffer[WRITE_SIZE] = { 0 };
-        int size;
-
         {
             QMutexLocker lock(&m_writeBufMtx);
-            size = qMin(WRITE_SIZE - 2, m_writeBuffer.size());
-            while (size <= 0) {
+            while (m_writeBuffer.count() == 0) {
                 // wait on new data to write condition, the timeout
                 // enable the thread to shutdown properly
                 m_newDataToWrite.wait(&m_writeBufMtx, 200);
                 if (!m_running) {
                     return;
                 }
-
-                size = m_writeBuffer.size();
             }
+        }
+
+        // send all the reports available before sleeping again
+        while (m_running && m_writeBuffer.count() > 0) {
+            char buffer[WRITE_SIZE] = { 0 };
 
             // NOTE: data size is limited to 2 bytes less than the
             // usb packet size (64 bytes for interrupt) to make room
             // for the reportID and valid data length
-            size = qMin(WRITE_SIZE - 2, m_writeBuffer.size());
-            memcpy(&buffer[2], m_writeBuffer.constData(), size);
+            int size = m_writeBuffer.peek(&buffer[2], WRITE_SIZE - 2);
             buffer[1] = size; // valid data length
             buffer[0] = 2; // reportID
-        }
 
-        // must hold lock through the send to know how much was sent
-        int ret = hiddev->send(hidno, buffer, WRITE_SIZE, WRITE_TIMEOUT);
+            int ret = hiddev->send(hidno, buffer, WRITE_SIZE, WRITE_TIMEOUT);
 
-        if (ret > 0) {
-            // only remove the size actually written to the device
-            QMutexLocker lock(&m_writeBufMtx);
-            m_writeBuffer.remove(0, size);
+            if (ret > 0) {
+                // only remove the size actually written to the device
+                m_writeBuffer.skip(size);
+                m_hid->m_reportsWritten.ref();
+                {
+                    QMutexLocker lock(&m_writeBufMtx);
+                    m_spaceToWrite.wakeOne();
+                }
 
-            emit m_hid->bytesWritten(ret - 2);
-        } else if (ret < 0) { // < 0 => error
-            // TODO! make proper error handling, this only quick hack for unplug freeze
-            m_running = false;
-            qDebug() << "Error writing to device (" << ret << ")";
-        } else {
-            qDebug() << "No data written to device ??";
+                emit m_hid->bytesWritten(ret - 2);
+            } else if (ret < 0) { // < 0 => error
+                // TODO! make proper error handling, this only quick hack for unplug freeze
+                m_running = false;
+                qDebug() << "Error writing to device (" << ret << ")";
+            } else {
+                qDebug() << "No data written to device ??";
+            }
         }
     }
 }
@@ -274,17 +341,24 @@ void RawHIDWriteThread::run()
 int RawHIDWriteThread::pushDataToWrite(const char *data, int size)
 {
     QMutexLocker lock(&m_writeBufMtx);
+    int written = 0;
 
-    m_writeBuffer.append(data, size);
-    m_newDataToWrite.wakeOne(); // signal that new data arrived
+    do {
+        written += m_writeBuffer.write(data + written, size - written);
+        m_newDataToWrite.wakeOne(); // signal that new data arrived
 
-    return size;
+        // the ring is full, wait for the device to take the rest
+        if (written < size && !m_spaceToWrite.wait(&m_writeBufMtx, WRITE_TIMEOUT)) {
+            break;
+        }
+    } while (written < size && m_running);
+
+    return written;
 }
 
 qint64 RawHIDWriteThread::getBytesToWrite()
 {
-    // QMutexLocker lock(&m_writeBufMtx);
-    return m_writeBuffer.size();
+    return m_writeBuffer.count();
 }
 
 // *********************************************************************************
@@ -295,7 +369,9 @@ RawHID::RawHID(const QString &deviceName)
     m_deviceNo(-1),
     m_readThread(NULL),
     m_writeThread(NULL),
-    m_mutex(NULL)
+    m_mutex(NULL),
+    m_reportsRead(0),
+    m_reportsWritten(0)
 {
     OPHID_TRACE("IN");
 
@@ -27,11 +27,16 @@
 #include "modeluavoproxy.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjecthelper.h"
+#include "telemetrymanager.h"
+#include "systemalarms.h"
 
 #include <QProgressDialog>
+#include <QEventLoop>
+#include <QTimer>
+#include <QHash>
 #include <math.h>
 
-ModelUavoProxy::ModelUavoProxy(QObject *parent, flightDataModel *model) : QObject(parent), myModel(model)
+ModelUavoProxy::ModelUavoProxy(QObject *parent, flightDataModel *model) : QObject(parent), myModel(model), m_progress(NULL), m_progressBase(0)
 {
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
 
@@ -43,7 +48,7 @@ ModelUavoProxy::ModelUavoProxy(QObject *parent, flightDataModel *model) : QObjec
 
 void ModelUavoProxy::sendPathPlan()
 {
-    modelToObjects();
+    bool prepared = modelToObjects();
 
     PathPlan *pathPlan      = PathPlan::GetInstance(objMngr);
 
@@ -55,35 +60,32 @@ void ModelUavoProxy::sendPathPlan()
     progress.setCancelButton(NULL);
     progress.show();
 
-    UAVObjectUpdaterHelper updateHelper;
-
-    // send PathPlan
-    bool success = (updateHelper.doObjectAndWait(pathPlan) == UAVObjectUpdaterHelper::SUCCESS);
-    progress.setValue(1);
-
-    if (success) {
-        // send Waypoint instances
-        qDebug() << "sending" << waypointCount << "waypoints";
-        for (int i = 0; i < waypointCount; ++i) {
-            Waypoint *waypoint = Waypoint::GetInstance(objMngr, i);
-            success = (updateHelper.doObjectAndWait(waypoint) == UAVObjectUpdaterHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
-        }
+    // highest instances first, the board creates the missing instances on the first one
+    QList<UAVObject *> objects;
+    for (int i = waypointCount - 1; i >= 0; --i) {
+        objects << Waypoint::GetInstance(objMngr, i);
+    }
+    for (int i = actionCount - 1; i >= 0; --i) {
+        objects << PathAction::GetInstance(objMngr, i);
     }
 
-    if (success) {
-        // send PathAction instances
-        qDebug() << "sending" << actionCount << "path actions";
-        for (int i = 0; i < actionCount; ++i) {
-            PathAction *action = PathAction::GetInstance(objMngr, i);
-            success = (updateHelper.doObjectAndWait(action) == UAVObjectUpdaterHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
+    bool success = false;
+    if (prepared) {
+        // send the whole plan in multi object packets, then check its CRC once
+        qDebug() << "sending" << waypointCount << "waypoints and" << actionCount << "path actions in bulk";
+        success = sendObjectsBulk(pathPlan, objects, progress);
+    }
+    if (prepared && !success) {
+        // resend everything with one acked transaction per object
+        qDebug() << "ModelUavoProxy::sendPathPlan - bulk transfer not verified, sending acked objects";
+        progress.setValue(0);
+        UAVObjectUpdaterHelper updateHelper;
+        success = (updateHelper.doObjectAndWait(pathPlan) == UAVObjectUpdaterHelper::SUCCESS);
+        progress.setValue(1);
+        if (success) {
+            // several transactions outstanding at a time
+            UAVObjectBulkUpdaterHelper bulkHelper;
+            success = transferObjects(bulkHelper, objects, progress);
         }
     }
 
@@ -114,42 +116,21 @@ void ModelUavoProxy::receivePathPlan()
     progress.setMaximum(1 + waypointCount + actionCount);
     progress.setValue(1);
 
-    if (success && (waypointCount > objMngr->getNumInstances(Waypoint::OBJID))) {
-        // allocate needed Waypoint instances
-        Waypoint *waypoint = new Waypoint;
-        waypoint->initialize(waypointCount - 1, waypoint->getMetaObject());
-        success = objMngr->registerObject(waypoint);
+    if (success) {
+        success = allocateInstances(waypointCount, actionCount);
     }
     if (success) {
-        // request Waypoint instances
-        qDebug() << "requesting" << waypointCount << "waypoints";
+        // request Waypoint and PathAction instances, several transactions outstanding at a time
+        qDebug() << "requesting" << waypointCount << "waypoints and" << actionCount << "path actions";
+        QList<UAVObject *> objects;
         for (int i = 0; i < waypointCount; ++i) {
-            Waypoint *waypoint = Waypoint::GetInstance(objMngr, i);
-            success = (requestHelper.doObjectAndWait(waypoint) == UAVObjectRequestHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
+            objects << Waypoint::GetInstance(objMngr, i);
         }
-    }
-
-    if (success && (actionCount > objMngr->getNumInstances(PathAction::OBJID))) {
-        // allocate needed PathAction instances
-        PathAction *action = new PathAction;
-        action->initialize(actionCount - 1, action->getMetaObject());
-        success = objMngr->registerObject(action);
-    }
-    if (success) {
-        // request PathAction isntances
-        qDebug() << "requesting" << actionCount << "path actions";
         for (int i = 0; i < actionCount; ++i) {
-            PathAction *action = PathAction::GetInstance(objMngr, i);
-            success = (requestHelper.doObjectAndWait(action) == UAVObjectRequestHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
+            objects << PathAction::GetInstance(objMngr, i);
         }
+        UAVObjectBulkRequestHelper bulkHelper;
+        success = transferObjects(bulkHelper, objects, progress);
     }
 
     qDebug() << "ModelUavoProxy::pathPlanReceived - completed" << success;
@@ -162,6 +143,76 @@ void ModelUavoProxy::receivePathPlan()
     progress.close();
 }
 
+// allocate the missing Waypoint and PathAction instances,
+// registering the last instance creates all the ones before it
+bool ModelUavoProxy::allocateInstances(int waypointCount, int actionCount)
+{
+    bool success = true;
+
+    if (waypointCount > objMngr->getNumInstances(Waypoint::OBJID)) {
+        Waypoint *waypoint = new Waypoint;
+        waypoint->initialize(waypointCount - 1, waypoint->getMetaObject());
+        success = objMngr->registerObject(waypoint);
+    }
+    if (success && (actionCount > objMngr->getNumInstances(PathAction::OBJID))) {
+        PathAction *action = new PathAction;
+        action->initialize(actionCount - 1, action->getMetaObject());
+        success = objMngr->registerObject(action);
+    }
+    return success;
+}
+
+// send the objects unacked in multi object packets, then the path plan with its CRC.
+// the board compiles the plan on its next path planner run and raises the PathPlan alarm
+// if anything was lost, so a single check of the alarm replaces the per object acks
+bool ModelUavoProxy::sendObjectsBulk(PathPlan *pathPlan, const QList<UAVObject *> &objects, QProgressDialog &progress)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    TelemetryManager *telemetryManager = pm->getObject<TelemetryManager>();
+
+    if (!telemetryManager || !telemetryManager->sendObjectBatch(objects)) {
+        return false;
+    }
+    progress.setValue(objects.size());
+
+    // the plan is acked after the objects sent before it were received
+    UAVObjectUpdaterHelper updateHelper;
+    if (updateHelper.doObjectAndWait(pathPlan) != UAVObjectUpdaterHelper::SUCCESS) {
+        return false;
+    }
+    progress.setValue(1 + objects.size());
+
+    QEventLoop loop;
+    QTimer::singleShot(PATHPLAN_CHECK_DELAY_MS, &loop, SLOT(quit()));
+    loop.exec();
+
+    SystemAlarms *systemAlarms = SystemAlarms::GetInstance(objMngr);
+    UAVObjectRequestHelper requestHelper;
+    if (requestHelper.doObjectAndWait(systemAlarms) != UAVObjectRequestHelper::SUCCESS) {
+        return false;
+    }
+    // also fails on boards without path planner, the alarm is then never set
+    return systemAlarms->getData().Alarm[SystemAlarms::ALARM_PATHPLAN] == SystemAlarms::ALARM_OK;
+}
+
+bool ModelUavoProxy::transferObjects(AbstractUAVObjectBulkHelper &bulkHelper, const QList<UAVObject *> &objects, QProgressDialog &progress)
+{
+    connect(&bulkHelper, SIGNAL(progress(int)), this, SLOT(objectsTransferred(int)));
+    m_progress     = &progress;
+    m_progressBase = progress.value();
+    bool success = (bulkHelper.doObjectsAndWait(objects) == AbstractUAVObjectHelper::SUCCESS);
+    m_progress     = NULL;
+    disconnect(&bulkHelper, SIGNAL(progress(int)), this, SLOT(objectsTransferred(int)));
+    return success;
+}
+
+void ModelUavoProxy::objectsTransferred(int count)
+{
+    if (m_progress) {
+        m_progress->setValue(m_progressBase + count);
+    }
+}
+
 // update waypoint and path actions UAV objects
 //
 // waypoints are unique and each waypoint has an entry in the UAV waypoint list
@@ -171,75 +222,55 @@ void ModelUavoProxy::receivePathPlan()
 // the compression of path actions happens here.
 // (compression consists in keeping only one instance of similar path actions)
 //
-// the UAV waypoint list and path action list are probably not empty, so we try to reuse existing instances
+// the UAV waypoint list and path action list are probably not empty, so existing instances are reused
 bool ModelUavoProxy::modelToObjects()
 {
     qDebug() << "ModelUAVProxy::modelToObjects";
 
-    // track number of path actions
-    int actionCount   = 0;
-
-    // iterate over waypoints
     int waypointCount = myModel->rowCount();
-    for (int i = 0; i < waypointCount; ++i) {
-        // Path Actions
-
-        // create action to use as a search criteria
-        // this object does not need to be deleted as it will either be added to the managed list or deleted later
-        PathAction *action = new PathAction;
 
-        // get model data
-        PathAction::DataFields actionData = action->getData();
+    // compress the path actions once, the packed data are compared so that no field is missed
+    QList<PathAction::DataFields> actions;
+    QHash<QByteArray, int> actionIndexes;
+    QVector<int> waypointActions(waypointCount);
+    for (int i = 0; i < waypointCount; ++i) {
+        PathAction::DataFields actionData;
+        memset(&actionData, 0, sizeof(actionData));
         modelToPathAction(i, actionData);
 
-        // see if that path action has already been added in this run
-        PathAction *foundAction = findPathAction(actionData, actionCount);
-        // TODO this test needs a consistency check as it is unsafe.
-        // if the find method is buggy and returns false positives then the flight plan sent to the uav is broken!
-        // the find method should do a "binary" compare instead of a field by field compare
-        // if a field is added everywhere and not in the compare method then you can start having false positives
-        if (!foundAction) {
-            // create or reuse an action instance
-            action = createPathAction(actionCount, action);
-            actionCount++;
-
-            // update UAVObject
-            action->setData(actionData);
+        QByteArray key((const char *)&actionData, sizeof(actionData));
+        QHash<QByteArray, int>::const_iterator found = actionIndexes.constFind(key);
+        if (found != actionIndexes.constEnd()) {
+            waypointActions[i] = found.value();
         } else {
-            action->deleteLater();
-            action = foundAction;
-            qDebug() << "ModelUAVProxy::modelToObjects - found action instance :" << action->getInstID();
+            waypointActions[i] = actions.size();
+            actionIndexes.insert(key, actions.size());
+            actions << actionData;
         }
+    }
+    int actionCount = actions.size();
 
-        // Waypoints
+    if (!allocateInstances(waypointCount, actionCount)) {
+        return false;
+    }
 
-        // create or reuse a waypoint instance
-        Waypoint *waypoint = createWaypoint(i, NULL);
+    for (int i = 0; i < actionCount; ++i) {
+        PathAction::GetInstance(objMngr, i)->setData(actions.at(i));
+    }
+    for (int i = 0; i < waypointCount; ++i) {
+        Waypoint *waypoint = Waypoint::GetInstance(objMngr, i);
         Q_ASSERT(waypoint);
 
-        // get model data
         Waypoint::DataFields waypointData = waypoint->getData();
         modelToWaypoint(i, waypointData);
 
         // connect waypoint to path action
-        waypointData.Action = action->getInstID();
+        waypointData.Action = waypointActions.at(i);
 
         // update UAVObject
         waypoint->setData(waypointData);
     }
 
-    // Put "safe" values in unused waypoint and path action objects
-    if (waypointCount < objMngr->getNumInstances(Waypoint::OBJID)) {
-        for (int i = waypointCount; i < objMngr->getNumInstances(Waypoint::OBJID); ++i) {
-            // TODO
-        }
-    }
-    if (actionCount < objMngr->getNumInstances(PathAction::OBJID)) {
-        for (int i = actionCount; i < objMngr->getNumInstances(PathAction::OBJID); ++i) {
-            // TODO
-        }
-    }
-
     // Update PathPlan
     PathPlan *pathPlan = PathPlan::GetInstance(objMngr);
     PathPlan::DataFields pathPlanData = pathPlan->getData();
@@ -253,86 +284,6 @@ bool ModelUavoProxy::modelToObjects()
     return true;
 }
 
-Waypoint *ModelUavoProxy::createWaypoint(int index, Waypoint *newWaypoint)
-{
-    Waypoint *waypoint = NULL;
-    int count = objMngr->getNumInstances(Waypoint::OBJID);
-
-    if (index < count) {
-        // reuse object
-        qDebug() << "ModelUAVProxy::createWaypoint - reused waypoint instance :" << index << "/" << count;
-        waypoint = Waypoint::GetInstance(objMngr, index);
-        if (newWaypoint) {
-            newWaypoint->deleteLater();
-        }
-    } else if (index < count + 1) {
-        // create "next" object
-        qDebug() << "ModelUAVProxy::createWaypoint - created waypoint instance :" << index;
-        // TODO is there a limit to the number of wp?
-        waypoint = newWaypoint ? newWaypoint : new Waypoint;
-        waypoint->initialize(index, waypoint->getMetaObject());
-        objMngr->registerObject(waypoint);
-    } else {
-        // we can only create the "next" object
-        // TODO fail in a clean way :(
-    }
-    return waypoint;
-}
-
-PathAction *ModelUavoProxy::createPathAction(int index, PathAction *newAction)
-{
-    PathAction *action = NULL;
-    int count = objMngr->getNumInstances(PathAction::OBJID);
-
-    if (index < count) {
-        // reuse object
-        qDebug() << "ModelUAVProxy::createPathAction - reused action instance :" << index << "/" << count;
-        action = PathAction::GetInstance(objMngr, index);
-        if (newAction) {
-            newAction->deleteLater();
-        }
-    } else if (index < count + 1) {
-        // create "next" object
-        qDebug() << "ModelUAVProxy::createPathAction - created action instance :" << index;
-        // TODO is there a limit to the number of path actions?
-        action = newAction ? newAction : new PathAction;
-        action->initialize(index, action->getMetaObject());
-        objMngr->registerObject(action);
-    } else {
-        // we can only create the "next" object
-        // TODO fail in a clean way :(
-    }
-    return action;
-}
-
-PathAction *ModelUavoProxy::findPathAction(const PathAction::DataFields &actionData, int actionCount)
-{
-    int instancesCount = objMngr->getNumInstances(PathAction::OBJID);
-    int count = actionCount <= instancesCount ? actionCount : instancesCount;
-
-    for (int i = 0; i < count; ++i) {
-        PathAction *action = PathAction::GetInstance(objMngr, i);
-        Q_ASSERT(action);
-        if (!action) {
-            continue;
-        }
-        PathAction::DataFields fields = action->getData();
-        if (fields.Command == actionData.Command
-            && fields.ConditionParameters[0] == actionData.ConditionParameters[0]
-            && fields.ConditionParameters[1] == actionData.ConditionParameters[1]
-            && fields.ConditionParameters[2] == actionData.ConditionParameters[2]
-            && fields.EndCondition == actionData.EndCondition
-            && fields.ErrorDestination == actionData.ErrorDestination
-            && fields.JumpDestination == actionData.JumpDestination && fields.Mode == actionData.Mode
-            && fields.ModeParameters[0] == actionData.ModeParameters[0]
-            && fields.ModeParameters[1] == actionData.ModeParameters[1]
-            && fields.ModeParameters[2] == actionData.ModeParameters[2]) {
-            return action;
-        }
-    }
-    return NULL;
-}
-
 bool ModelUavoProxy::objectsToModel()
 {
     // build model from uav objects
@@ -35,6 +35,9 @@
 
 #include <QObject>
 
+class QProgressDialog;
+class AbstractUAVObjectBulkHelper;
+
 class ModelUavoProxy : public QObject {
     Q_OBJECT
 
@@ -45,17 +48,24 @@ public slots:
     void sendPathPlan();
     void receivePathPlan();
 
+private slots:
+    void objectsTransferred(int count);
+
 private:
     UAVObjectManager *objMngr;
     flightDataModel *myModel;
+    QProgressDialog *m_progress;
+    int m_progressBase;
 
-    bool modelToObjects();
-    bool objectsToModel();
+    // time left to the board path planner to check the plan, it runs every 100ms
+    static const int PATHPLAN_CHECK_DELAY_MS = 300;
 
-    Waypoint *createWaypoint(int index, Waypoint *newWaypoint);
-    PathAction *createPathAction(int index, PathAction *newAction);
+    bool transferObjects(AbstractUAVObjectBulkHelper &bulkHelper, const QList<UAVObject *> &objects, QProgressDialog &progress);
+    bool sendObjectsBulk(PathPlan *pathPlan, const QList<UAVObject *> &objects, QProgressDialog &progress);
+    bool allocateInstances(int waypointCount, int actionCount);
 
-    PathAction *findPathAction(const PathAction::DataFields & actionFields, int actionCount);
+    bool modelToObjects();
+    bool objectsToModel();
 
     void modelToWaypoint(int i, Waypoint::DataFields &data);
     void modelToPathAction(int i, PathAction::DataFields &data);
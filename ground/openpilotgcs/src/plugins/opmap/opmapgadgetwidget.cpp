@@ -33,6 +33,8 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <QClipboard>
 #include <QMenu>
 #include <QStringList>
@@ -374,6 +376,8 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
     contextMenu.addAction(reloadAct);
     contextMenu.addSeparator();
     contextMenu.addAction(ripAct);
+    contextMenu.addAction(ripPackageAct);
+    contextMenu.addAction(importPackageAct);
     contextMenu.addSeparator();
 
     QMenu maxUpdateRateSubMenu(tr("&Max Update Rate ") + "(" + QString::number(m_maxUpdateRate) + " ms)", this);
@@ -1317,6 +1321,12 @@ void OPMapGadgetWidget::createActions()
     ripAct = new QAction(tr("&Rip map"), this);
     ripAct->setStatusTip(tr("Rip the map tiles"));
     connect(ripAct, SIGNAL(triggered()), this, SLOT(onRipAct_triggered()));
+    ripPackageAct = new QAction(tr("Rip map to tile &package..."), this);
+    ripPackageAct->setStatusTip(tr("Rip the map tiles into a tile package file for offline use"));
+    connect(ripPackageAct, SIGNAL(triggered()), this, SLOT(onRipPackageAct_triggered()));
+    importPackageAct = new QAction(tr("&Import tile package..."), this);
+    importPackageAct->setStatusTip(tr("Use the map tiles of a tile package file"));
+    connect(importPackageAct, SIGNAL(triggered()), this, SLOT(onImportPackageAct_triggered()));
 
     copyMouseLatLonToClipAct = new QAction(tr("Mouse latitude and longitude"), this);
     copyMouseLatLonToClipAct->setStatusTip(tr("Copy the mouse latitude and longitude to the clipboard"));
@@ -1605,6 +1615,33 @@ void OPMapGadgetWidget::onRipAct_triggered()
     m_map->RipMap();
 }
 
+void OPMapGadgetWidget::onRipPackageAct_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Tile Package"), QString(), tr("Tile packages (*.optiles)"));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!fileName.endsWith(".optiles")) {
+        fileName += ".optiles";
+    }
+    m_map->RipMap(fileName);
+}
+
+void OPMapGadgetWidget::onImportPackageAct_triggered()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Import Tile Package"), QString(), tr("Tile packages (*.optiles)"));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!m_map->configuration->ImportTilePackage(fileName)) {
+        QMessageBox::warning(this, tr("Tile package"), tr("Unable to import the tile package %1").arg(fileName));
+        return;
+    }
+    m_map->ReloadMap();
+}
+
 void OPMapGadgetWidget::onCopyMouseLatLonToClipAct_triggered()
 {
     QClipboard *clipboard = QApplication::clipboard();
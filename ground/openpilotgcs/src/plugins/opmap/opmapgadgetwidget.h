@@ -167,6 +167,8 @@ private slots:
      */
     void onReloadAct_triggered();
     void onRipAct_triggered();
+    void onRipPackageAct_triggered();
+    void onImportPackageAct_triggered();
     void onCopyMouseLatLonToClipAct_triggered();
     void onCopyMouseLatToClipAct_triggered();
     void onCopyMouseLonToClipAct_triggered();
@@ -238,6 +240,8 @@ private:
     bool m_telemetry_connected;
     QAction *reloadAct;
     QAction *ripAct;
+    QAction *ripPackageAct;
+    QAction *importPackageAct;
     QAction *copyMouseLatLonToClipAct;
     QAction *copyMouseLatToClipAct;
     QAction *copyMouseLonToClipAct;
@@ -53,6 +53,7 @@
 #include <osgViewer/ViewerEventHandlers>
 
 #include <osgEarth/MapNode>
+#include <osgEarth/Cache>
 #include <osgEarth/XmlUtils>
 #include <osgEarth/Viewpoint>
 
@@ -95,6 +96,7 @@ using namespace osgEarth::Annotation;
 #include "utils/homelocationutil.h"
 #include "utils/worldmagmodel.h"
 #include "utils/coordinateconversions.h"
+#include "utils/pathutils.h"
 #include "attitudestate.h"
 #include "gpspositionsensor.h"
 #include "homelocation.h"
@@ -103,6 +105,18 @@ using namespace osgEarth::Annotation;
 
 using namespace Utils;
 
+// Frames are drawn at most at the display rate
+#define FRAME_PERIOD_MS        16
+// Smallest attitude change, in degrees, and position change, in meters, worth a frame
+#define ATTITUDE_THRESHOLD_DEG 0.2
+#define POSITION_THRESHOLD_M   0.05
+// Bounds of the time the UAV takes to move to a new sample
+#define MIN_SAMPLE_PERIOD_MS   20
+#define MAX_SAMPLE_PERIOD_MS   500
+// Threads loading the terrain tiles, from the disk cache and from the network
+#define PAGER_THREADS          2
+#define PAGER_HTTP_THREADS     2
+
 OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
 {
     setThreadingModel(osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext);
@@ -113,6 +127,11 @@ OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
     mapNode = osgEarth::MapNode::findMapNode(earth);
     if (!mapNode) {
         qDebug() << "Uhoh";
+    } else if (!mapNode->getMap()->getCache()) {
+        // Keep the tiles on disk next to the map gadget cache, they are read back by the pager threads
+        FileSystemCacheOptions cacheOptions;
+        cacheOptions.rootPath() = QString(Utils::PathUtils().GetStoragePath() + "osgearthcache").toStdString();
+        mapNode->getMap()->setCache(osgEarth::CacheFactory::create(cacheOptions));
     }
 
     root->addChild(earth);
@@ -135,8 +154,23 @@ OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
     layout()->addWidget(viewWidget);
 
 
-    connect(&_timer, SIGNAL(timeout()), this, SLOT(update()));
-    _timer.start(10);
+    // Far away and no rotation at all, the first frame places the UAV
+    lastNED[0]   = lastNED[1] = lastNED[2] = 1.0e9;
+    lastAttitude = osg::Quat(0, 0, 0, 0);
+
+    // The UAV moves from the pose shown to the newest sample, during the time between the samples
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objMngr = pm->getObject<UAVObjectManager>();
+    sampleClock.start();
+    samplePeriod = MAX_SAMPLE_PERIOD_MS;
+    sampleTime   = -MAX_SAMPLE_PERIOD_MS;
+    readSample(toPose);
+    fromPose     = toPose;
+    connect(PositionState::GetInstance(objMngr), SIGNAL(objectUpdated(UAVObject *)), this, SLOT(sampleUpdated()));
+    connect(AttitudeState::GetInstance(objMngr), SIGNAL(objectUpdated(UAVObject *)), this, SLOT(sampleUpdated()));
+
+    connect(&_timer, SIGNAL(timeout()), this, SLOT(updateFrame()));
+    _timer.start(FRAME_PERIOD_MS);
 }
 
 OsgViewerWidget::~OsgViewerWidget()
@@ -153,6 +187,7 @@ QWidget *OsgViewerWidget::createViewWidget(osg::Camera *camera, osg::Node *scene
     view->setSceneData(scene);
     view->addEventHandler(new osgViewer::StatsHandler);
     view->getDatabasePager()->setDoPreCompile(true);
+    view->getDatabasePager()->setUpThreads(PAGER_THREADS, PAGER_HTTP_THREADS);
 
     manip = new EarthManipulator();
     view->setCameraManipulator(manip);
@@ -253,15 +288,90 @@ osg::Node *OsgViewerWidget::createAirplane()
 void OsgViewerWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
+    updateUAV();
+    frame();
+}
+
+/**
+ * Draws a frame only when the UAV moved, or when the viewer needs one for
+ * the camera manipulator, the input events or the tiles being loaded
+ */
+void OsgViewerWidget::updateFrame()
+{
+    bool moved = updateUAV();
+
+    if (moved || checkNeedToDoFrame()) {
+        frame();
+    }
+}
+
+/**
+ * Reads the current position and attitude
+ */
+void OsgViewerWidget::readSample(Pose &pose)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objMngr = pm->getObject<UAVObjectManager>();
+
+    PositionState::DataFields positionState = PositionState::GetInstance(objMngr)->getData();
+
+    pose.NED[0] = positionState.North;
+    pose.NED[1] = positionState.East;
+    pose.NED[2] = positionState.Down;
+
+    AttitudeState::DataFields attitudeState = AttitudeState::GetInstance(objMngr)->getData();
+    pose.attitude = osg::Quat(attitudeState.q2, attitudeState.q3, attitudeState.q4, attitudeState.q1);
+}
+
+/**
+ * The pose shown at time, between the previous pose and the newest sample
+ */
+void OsgViewerWidget::interpolate(qint64 time, Pose &pose)
+{
+    double t = qBound(0.0, (double)(time - sampleTime) / samplePeriod, 1.0);
+
+    for (int i = 0; i < 3; i++) {
+        pose.NED[i] = fromPose.NED[i] + t * (toPose.NED[i] - fromPose.NED[i]);
+    }
+    pose.attitude.slerp(t, fromPose.attitude, toPose.attitude);
+}
+
+/**
+ * A new position or attitude sample, the UAV starts moving to it from where it is shown
+ */
+void OsgViewerWidget::sampleUpdated()
+{
+    qint64 now = sampleClock.elapsed();
+
+    interpolate(now, fromPose);
+    readSample(toPose);
+    samplePeriod = qBound((qint64)MIN_SAMPLE_PERIOD_MS, now - sampleTime, (qint64)MAX_SAMPLE_PERIOD_MS);
+    sampleTime   = now;
+}
+
+/**
+ * Moves the UAV model to the current position and attitude, returns true if it moved
+ */
+bool OsgViewerWidget::updateUAV()
+{
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objMngr = pm->getObject<UAVObjectManager>();
 
-    PositionState *positionStateObj    = PositionState::GetInstance(objMngr);
-    PositionState::DataFields positionState = positionStateObj->getData();
-    double NED[3] = { positionState.North, positionState.East, positionState.Down };
+    Pose pose;
+    interpolate(sampleClock.elapsed(), pose);
+    double *NED = pose.NED;
+    bool moved  = false;
+
+    if (fabs(NED[0] - lastNED[0]) > POSITION_THRESHOLD_M || fabs(NED[1] - lastNED[1]) > POSITION_THRESHOLD_M
+        || fabs(NED[2] - lastNED[2]) > POSITION_THRESHOLD_M) {
+        lastNED[0] = NED[0];
+        lastNED[1] = NED[1];
+        lastNED[2] = NED[2];
+        moved = true;
+    }
 
     bool positionStateUpdate = true;
-    if (positionStateUpdate) {
+    if (moved && positionStateUpdate) {
         HomeLocation *homeLocationObj = HomeLocation::GetInstance(objMngr);
         HomeLocation::DataFields homeLocation = homeLocationObj->getData();
         double homeLLA[3] = { homeLocation.Latitude / 10.0e6, homeLocation.Longitude / 10.0e6, homeLocation.Altitude };
@@ -269,16 +379,21 @@ void OsgViewerWidget::paintEvent(QPaintEvent *event)
         double LLA[3];
         CoordinateConversions().NED2LLA_HomeLLA(homeLLA, NED, LLA);
         uavPos->getLocator()->setPosition(osg::Vec3d(LLA[1], LLA[0], LLA[2])); // Note this takes longtitude first
-    } else {
+    } else if (moved) {
         GPSPositionSensor *gpsPosObj = GPSPositionSensor::GetInstance(objMngr);
         GPSPositionSensor::DataFields gpsPos = gpsPosObj->getData();
         uavPos->getLocator()->setPosition(osg::Vec3d(gpsPos.Longitude / 10.0e6, gpsPos.Latitude / 10.0e6, gpsPos.Altitude));
     }
 
     // Set the attitude (reverse the attitude)
-    AttitudeState *attitudeStateObj = AttitudeState::GetInstance(objMngr);
-    AttitudeState::DataFields attitudeState = attitudeStateObj->getData();
-    osg::Quat quat(attitudeState.q2, attitudeState.q3, attitudeState.q4, attitudeState.q1);
+    osg::Quat quat = pose.attitude;
+
+    // Angle of the rotation between the shown attitude and the new one
+    double dot = fabs(quat.x() * lastAttitude.x() + quat.y() * lastAttitude.y() + quat.z() * lastAttitude.z() + quat.w() * lastAttitude.w());
+    if (2.0 * acos(qMin(dot, 1.0)) < osg::DegreesToRadians(ATTITUDE_THRESHOLD_DEG)) {
+        return moved;
+    }
+    lastAttitude = quat;
 
     // Have to rotate the axes from OP NED frame to OSG frame (X east, Y north, Z down)
     double angle;
@@ -289,5 +404,5 @@ void OsgViewerWidget::paintEvent(QPaintEvent *event)
 
     uavAttitudeAndScale->setMatrix(rot);
 
-    frame();
+    return true;
 }
@@ -34,6 +34,7 @@
 #include "uavobject.h"
 
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include <osg/Notify>
 #include <osg/PositionAttitudeTransform>
@@ -91,9 +92,22 @@ signals:
 
 public slots:
 
+private slots:
+    void updateFrame();
+    void sampleUpdated();
+
 protected:
+    struct Pose {
+        double    NED[3];
+        osg::Quat attitude;
+    };
+
     void paintEvent(QPaintEvent *event);
 
+    bool updateUAV();
+    void readSample(Pose &pose);
+    void interpolate(qint64 time, Pose &pose);
+
     /* Create a osgQt::GraphicsWindowQt to add to the widget */
     QWidget *createViewWidget(osg::Camera *camera, osg::Node *scene);
 
@@ -109,6 +123,15 @@ private: /* Private variables */
     osgEarth::Util::ObjectLocatorNode *uavPos;
     osg::MatrixTransform *uavAttitudeAndScale;
     osgEarth::MapNode *mapNode;
+    // The position and attitude shown
+    double lastNED[3];
+    osg::Quat lastAttitude;
+    // The UAV moves from fromPose to toPose, the newest sample, in samplePeriod ms from sampleTime
+    QElapsedTimer sampleClock;
+    Pose fromPose;
+    Pose toPose;
+    qint64 sampleTime;
+    qint64 samplePeriod;
 };
 
 
@@ -46,7 +46,8 @@ PathActionEditorGadgetWidget::PathActionEditorGadgetWidget(QWidget *parent) : QL
     m_pathactioneditor->pathactions->setModel(m_model);
     m_pathactioneditor->pathactions->setColumnWidth(0, 300);
     m_pathactioneditor->pathactions->setColumnWidth(1, 500);
-    m_pathactioneditor->pathactions->expandAll();
+    // Only the lists, the fields of an instance are created when it is expanded
+    m_pathactioneditor->pathactions->expandToDepth(0);
     BrowserItemDelegate *m_delegate = new BrowserItemDelegate();
     m_pathactioneditor->pathactions->setItemDelegate(m_delegate);
     m_pathactioneditor->pathactions->setEditTriggers(QAbstractItemView::AllEditTriggers);
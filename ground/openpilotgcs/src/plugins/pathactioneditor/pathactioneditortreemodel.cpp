@@ -44,6 +44,8 @@
 
 PathActionEditorTreeModel::PathActionEditorTreeModel(QObject *parent) :
     QAbstractItemModel(parent),
+    m_activeWaypoint(0),
+    m_activeAction(0),
     m_recentlyUpdatedColor(QColor(255, 230, 230)),
     m_manuallyChangedColor(QColor(230, 230, 255))
 {
@@ -118,18 +120,26 @@ void PathActionEditorTreeModel::updateActions()
 void PathActionEditorTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
     connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(highlightUpdatedObject(UAVObject *)));
-    TreeItem *item;
+    InstanceTreeItem *item;
     QString name = QString::number(obj->getInstID());
     item = new InstanceTreeItem(obj, name);
     connect(item, SIGNAL(updateHighlight(TreeItem *)), this, SLOT(updateHighlight(TreeItem *)));
     parent->appendChild(item);
-    foreach(UAVObjectField * field, obj->getFields()) {
+    m_instances.insert(obj, item);
+}
+
+void PathActionEditorTreeModel::addFields(InstanceTreeItem *item)
+{
+    foreach(UAVObjectField * field, item->object()->getFields()) {
         if (field->getNumElements() > 1) {
             addArrayField(field, item);
         } else {
             addSingleField(0, field, item);
         }
     }
+    item->setPopulated();
+    // the new fields take the active state of the instance
+    item->setActive(item->highlighted());
 }
 
 
@@ -223,17 +233,7 @@ QModelIndex PathActionEditorTreeModel::index(TreeItem *item)
         return QModelIndex();
     }
 
-    QModelIndex root = index(item->parent());
-
-    for (int i = 0; i < rowCount(root); ++i) {
-        QModelIndex childIndex = index(i, 0, root);
-        TreeItem *child = static_cast<TreeItem *>(childIndex.internalPointer());
-        if (child == item) {
-            return childIndex;
-        }
-    }
-    Q_ASSERT(false);
-    return QModelIndex();
+    return createIndex(item->row(), 0, item);
 }
 
 QModelIndex PathActionEditorTreeModel::parent(const QModelIndex &index) const
@@ -269,6 +269,40 @@ int PathActionEditorTreeModel::rowCount(const QModelIndex &parent) const
     return parentItem->childCount();
 }
 
+bool PathActionEditorTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (canFetchMore(parent)) {
+        return true;
+    }
+    return QAbstractItemModel::hasChildren(parent);
+}
+
+bool PathActionEditorTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!parent.isValid() || parent.column() > 0) {
+        return false;
+    }
+    InstanceTreeItem *item = dynamic_cast<InstanceTreeItem *>(static_cast<TreeItem *>(parent.internalPointer()));
+    return item && !item->populated();
+}
+
+void PathActionEditorTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    InstanceTreeItem *item = static_cast<InstanceTreeItem *>(parent.internalPointer());
+    int count = item->object()->getFields().count();
+
+    if (count > 0) {
+        beginInsertRows(parent, 0, count - 1);
+        addFields(item);
+        endInsertRows();
+    } else {
+        item->setPopulated();
+    }
+}
+
 int PathActionEditorTreeModel::columnCount(const QModelIndex &parent) const
 {
     if (parent.isValid()) {
@@ -399,53 +433,87 @@ void PathActionEditorTreeModel::updateHighlight(TreeItem *item)
 void PathActionEditorTreeModel::highlightUpdatedObject(UAVObject *obj)
 {
     Q_ASSERT(obj);
-    if (obj->getName().compare("Waypoint") == 0) {
-        m_waypointsTree->update();
-        // emit dataChanged(index(m_waypointsTree), index(m_waypointsTree));
-    } else if (obj->getName().compare("PathAction") == 0) {
-        m_pathactionsTree->update();
-        // emit dataChanged(index(m_pathactionsTree), index(m_pathactionsTree));
+    // Only the rows of the updated instance change
+    InstanceTreeItem *item = m_instances.value(obj);
+    if (item && item->populated()) {
+        item->update();
+        emitDataChanged(item);
+    }
+}
+
+void PathActionEditorTreeModel::emitDataChanged(TreeItem *item)
+{
+    QModelIndex itemIndex = index(item);
+
+    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
+    if (item->childCount() > 0) {
+        emit dataChanged(index(0, 0, itemIndex), index(item->childCount() - 1, TreeItem::dataColumn, itemIndex));
+        foreach(TreeItem * child, item->treeChildren()) {
+            if (child->childCount() > 0) {
+                emitDataChanged(child);
+            }
+        }
     }
 }
 
 void PathActionEditorTreeModel::newInstance(UAVObject *obj)
 {
+    TopTreeItem *parent;
+
     if (obj->getName().compare("Waypoint") == 0) {
-        addInstance(obj, m_waypointsTree);
-        m_waypointsTree->update();
+        parent = m_waypointsTree;
     } else if (obj->getName().compare("PathAction") == 0) {
-        addInstance(obj, m_pathactionsTree);
-        m_pathactionsTree->update();
+        parent = m_pathactionsTree;
+    } else {
+        return;
     }
+
+    int row = parent->childCount();
+    beginInsertRows(index(parent), row, row);
+    addInstance(obj, parent);
+    endInsertRows();
     updateActions();
-    emit layoutChanged();
 }
 
-void PathActionEditorTreeModel::objUpdated(UAVObject *obj)
+void PathActionEditorTreeModel::setActiveInstance(InstanceTreeItem * *active, InstanceTreeItem *item)
 {
-    Q_UNUSED(obj);
-    quint16 index  = m_objManager->getObject("WaypointActive")->getField("Index")->getValue().toInt();
-    quint16 action = 0;
-
-    foreach(TreeItem * child, m_waypointsTree->treeChildren()) {
-        ObjectTreeItem *objItem = dynamic_cast<ObjectTreeItem *>(child);
-
-        if (index == objItem->object()->getInstID()) {
-            child->setActive(true);
-            action = objItem->object()->getField("Action")->getValue().toInt();
-        } else {
-            child->setActive(false);
-        }
+    if (*active == item) {
+        return;
+    }
+    if (*active) {
+        (*active)->setActive(false);
+        emitDataChanged(*active);
+    }
+    *active = item;
+    if (item) {
+        item->setActive(true);
+        emitDataChanged(item);
     }
-    foreach(TreeItem * child, m_pathactionsTree->treeChildren()) {
-        ObjectTreeItem *objItem = dynamic_cast<ObjectTreeItem *>(child);
+}
 
-        if (action == objItem->object()->getInstID()) {
-            child->setActive(true);
-        } else {
-            child->setActive(false);
+void PathActionEditorTreeModel::objUpdated(UAVObject *obj)
+{
+    quint16 index = m_objManager->getObject("WaypointActive")->getField("Index")->getValue().toInt();
+    InstanceTreeItem *waypoint = m_instances.value(m_objManager->getObject("Waypoint", index));
+    InstanceTreeItem *action   = 0;
+
+    if (waypoint) {
+        quint16 actionIndex = waypoint->object()->getField("Action")->getValue().toInt();
+        action = m_instances.value(m_objManager->getObject("PathAction", actionIndex));
+    }
+    setActiveInstance(&m_activeWaypoint, waypoint);
+    setActiveInstance(&m_activeAction, action);
+
+    // The action titles are shown by the waypoints
+    if (obj->getName().compare("PathAction") == 0) {
+        QStringList actions = *m_actions;
+        updateActions();
+        if (actions != *m_actions) {
+            foreach(TreeItem * child, m_waypointsTree->treeChildren()) {
+                if (child->childCount() > 0) {
+                    emitDataChanged(child);
+                }
+            }
         }
     }
-    updateActions();
-    emit layoutChanged();
 }
@@ -31,10 +31,12 @@
 #include "treeitem.h"
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
+#include <QtCore/QHash>
 #include <QColor>
 
 class TopTreeItem;
 class ObjectTreeItem;
+class InstanceTreeItem;
 class DataObjectTreeItem;
 class UAVObject;
 class UAVDataObject;
@@ -60,6 +62,9 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
 
     void setRecentlyUpdatedColor(QColor color)
     {
@@ -86,6 +91,9 @@ private:
 
     void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    void addFields(InstanceTreeItem *item);
+    void emitDataChanged(TreeItem *item);
+    void setActiveInstance(InstanceTreeItem * *active, InstanceTreeItem *item);
     // QString updateMode(quint8 updateMode);
     void setupModelData();
     void updateActions();
@@ -96,6 +104,9 @@ private:
     TreeItem *m_rootItem;
     TopTreeItem *m_pathactionsTree;
     TopTreeItem *m_waypointsTree;
+    QHash<UAVObject *, InstanceTreeItem *> m_instances;
+    InstanceTreeItem *m_activeWaypoint;
+    InstanceTreeItem *m_activeAction;
     QColor m_recentlyUpdatedColor;
     QColor m_manuallyChangedColor;
 };
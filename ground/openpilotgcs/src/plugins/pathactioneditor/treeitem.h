@@ -221,15 +221,24 @@ class InstanceTreeItem : public DataObjectTreeItem {
     Q_OBJECT
 public:
     InstanceTreeItem(UAVObject *obj, const QList<QVariant> &data, TreeItem *parent = 0) :
-        DataObjectTreeItem(data, parent)
+        DataObjectTreeItem(data, parent), m_populated(false)
     {
         setObject(obj);
     }
     InstanceTreeItem(UAVObject *obj, const QVariant &data, TreeItem *parent = 0) :
-        DataObjectTreeItem(data, parent)
+        DataObjectTreeItem(data, parent), m_populated(false)
     {
         setObject(obj);
     }
+    // the field items are only created when the instance is first expanded
+    inline bool populated()
+    {
+        return m_populated;
+    }
+    inline void setPopulated()
+    {
+        m_populated = true;
+    }
     virtual void apply()
     {
         TreeItem::apply();
@@ -238,6 +247,8 @@ public:
     {
         TreeItem::update();
     }
+private:
+    bool m_populated;
 };
 
 class ArrayFieldTreeItem : public TreeItem {
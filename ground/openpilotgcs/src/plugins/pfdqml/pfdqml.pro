@@ -15,6 +15,7 @@ HEADERS += \
     pfdqmlplugin.h \
     pfdqmlgadget.h \
     pfdqmlgadgetwidget.h \
+    pfdqmldatamodel.h \
     pfdqmlgadgetfactory.h \
     pfdqmlgadgetconfiguration.h \
     pfdqmlgadgetoptionspage.h
@@ -24,6 +25,7 @@ SOURCES += \
     pfdqmlgadget.cpp \
     pfdqmlgadgetfactory.cpp \
     pfdqmlgadgetwidget.cpp \
+    pfdqmldatamodel.cpp \
     pfdqmlgadgetconfiguration.cpp \
     pfdqmlgadgetoptionspage.cpp
 
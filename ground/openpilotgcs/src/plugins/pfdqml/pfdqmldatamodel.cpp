@@ -0,0 +1,122 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pfdqmldatamodel.h"
+#include "uavobjectmanager.h"
+#include "attitudestate.h"
+#include "positionstate.h"
+#include "velocitystate.h"
+
+#include <QQuickWindow>
+#include <QTimer>
+
+// Shortest period between two samples, the values change at most this often
+// even when the window renders faster for other reasons
+#define MIN_SAMPLE_PERIOD_MS 15
+
+PfdQmlDataModel::PfdQmlDataModel(QQuickWindow *window, UAVObjectManager *objManager, QObject *parent) :
+    QObject(parent),
+    m_window(window),
+    m_dirty(0),
+    m_frameRequested(false)
+{
+    for (int i = 0; i < 3; i++) {
+        m_attitude[i] = 0.0f;
+        m_position[i] = 0.0f;
+        m_velocity[i] = 0.0f;
+    }
+
+    m_attitudeState = AttitudeState::GetInstance(objManager);
+    m_positionState = PositionState::GetInstance(objManager);
+    m_velocityState = VelocityState::GetInstance(objManager);
+
+    // Updates only mark the object, the fields are read once per frame
+    connect(m_attitudeState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
+    connect(m_positionState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
+    connect(m_velocityState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
+
+    // afterAnimating is emitted in the gui thread right before the frame is
+    // synchronized with the render thread, the values set here make it in that frame
+    connect(m_window, SIGNAL(afterAnimating()), this, SLOT(sample()));
+
+    m_lastSample.start();
+    m_dirty = ATTITUDE_DIRTY | POSITION_DIRTY | VELOCITY_DIRTY;
+}
+
+void PfdQmlDataModel::objectUpdated(UAVObject *object)
+{
+    if (object == m_attitudeState) {
+        m_dirty |= ATTITUDE_DIRTY;
+    } else if (object == m_positionState) {
+        m_dirty |= POSITION_DIRTY;
+    } else if (object == m_velocityState) {
+        m_dirty |= VELOCITY_DIRTY;
+    }
+
+    if (!m_frameRequested) {
+        m_frameRequested = true;
+        qint64 wait = MIN_SAMPLE_PERIOD_MS - m_lastSample.elapsed();
+        if (wait > 0) {
+            QTimer::singleShot((int)wait, m_window, SLOT(update()));
+        } else {
+            m_window->update();
+        }
+    }
+}
+
+void PfdQmlDataModel::sample()
+{
+    if (!m_dirty || m_lastSample.elapsed() < MIN_SAMPLE_PERIOD_MS) {
+        return;
+    }
+    int dirty = m_dirty;
+    m_dirty = 0;
+    m_frameRequested = false;
+    m_lastSample.restart();
+
+    if (dirty & ATTITUDE_DIRTY) {
+        AttitudeState::DataFields attitude = m_attitudeState->getData();
+        if (update(m_attitude, attitude.Roll, attitude.Pitch, attitude.Yaw)) {
+            emit attitudeChanged();
+        }
+    }
+    if (dirty & POSITION_DIRTY) {
+        PositionState::DataFields position = m_positionState->getData();
+        if (update(m_position, position.North, position.East, position.Down)) {
+            emit positionChanged();
+        }
+    }
+    if (dirty & VELOCITY_DIRTY) {
+        VelocityState::DataFields velocity = m_velocityState->getData();
+        if (update(m_velocity, velocity.North, velocity.East, velocity.Down)) {
+            emit velocityChanged();
+        }
+    }
+}
+
+/**
+ * Stores the values, returns true if any of them changed
+ */
+bool PfdQmlDataModel::update(float values[3], float first, float second, float third)
+{
+    if (values[0] == first && values[1] == second && values[2] == third) {
+        return false;
+    }
+    values[0] = first;
+    values[1] = second;
+    values[2] = third;
+    return true;
+}
@@ -0,0 +1,124 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PFDQMLDATAMODEL_H_
+#define PFDQMLDATAMODEL_H_
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class QQuickWindow;
+class UAVObject;
+class UAVObjectManager;
+class AttitudeState;
+class PositionState;
+class VelocityState;
+
+/**
+ * The fast changing values shown by the PFD.
+ *
+ * The objects are sampled once per frame when the window is about to render,
+ * so the QML bindings are evaluated at most at the frame rate and not at the
+ * telemetry rate. A frame is only requested when one of the objects changed.
+ */
+class PfdQmlDataModel : public QObject {
+    Q_OBJECT Q_PROPERTY(float roll READ roll NOTIFY attitudeChanged)
+    Q_PROPERTY(float pitch READ pitch NOTIFY attitudeChanged)
+    Q_PROPERTY(float yaw READ yaw NOTIFY attitudeChanged)
+
+    Q_PROPERTY(float positionNorth READ positionNorth NOTIFY positionChanged)
+    Q_PROPERTY(float positionEast READ positionEast NOTIFY positionChanged)
+    Q_PROPERTY(float positionDown READ positionDown NOTIFY positionChanged)
+
+    Q_PROPERTY(float velocityNorth READ velocityNorth NOTIFY velocityChanged)
+    Q_PROPERTY(float velocityEast READ velocityEast NOTIFY velocityChanged)
+    Q_PROPERTY(float velocityDown READ velocityDown NOTIFY velocityChanged)
+
+public:
+    PfdQmlDataModel(QQuickWindow *window, UAVObjectManager *objManager, QObject *parent = 0);
+
+    float roll() const
+    {
+        return m_attitude[0];
+    }
+    float pitch() const
+    {
+        return m_attitude[1];
+    }
+    float yaw() const
+    {
+        return m_attitude[2];
+    }
+
+    float positionNorth() const
+    {
+        return m_position[0];
+    }
+    float positionEast() const
+    {
+        return m_position[1];
+    }
+    float positionDown() const
+    {
+        return m_position[2];
+    }
+
+    float velocityNorth() const
+    {
+        return m_velocity[0];
+    }
+    float velocityEast() const
+    {
+        return m_velocity[1];
+    }
+    float velocityDown() const
+    {
+        return m_velocity[2];
+    }
+
+signals:
+    void attitudeChanged();
+    void positionChanged();
+    void velocityChanged();
+
+private slots:
+    void objectUpdated(UAVObject *object);
+    void sample();
+
+private:
+    enum {
+        ATTITUDE_DIRTY = 0x01,
+        POSITION_DIRTY = 0x02,
+        VELOCITY_DIRTY = 0x04
+    };
+
+    static bool update(float values[3], float first, float second, float third);
+
+    QQuickWindow *m_window;
+    AttitudeState *m_attitudeState;
+    PositionState *m_positionState;
+    VelocityState *m_velocityState;
+
+    int m_dirty;
+    bool m_frameRequested;
+    QElapsedTimer m_lastSample;
+
+    float m_attitude[3];
+    float m_position[3];
+    float m_velocity[3];
+};
+
+#endif /* PFDQMLDATAMODEL_H_ */
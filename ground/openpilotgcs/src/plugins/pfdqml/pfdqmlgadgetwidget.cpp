@@ -15,10 +15,12 @@
  */
 
 #include "pfdqmlgadgetwidget.h"
+#include "pfdqmldatamodel.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "uavobject.h"
 #include "utils/svgimageprovider.h"
+#include "utils/qmlobjectproxy.h"
 #ifdef USE_OSG
 #include "osgearth.h"
 #endif
@@ -86,12 +88,17 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent) :
         UAVObject *object = objManager->getObject(objectName);
 
         if (object) {
-            engine()->rootContext()->setContextProperty(objectName, object);
+            // the maps are shared by all the QML gadgets and refreshed at a limited rate
+            engine()->rootContext()->setContextProperty(objectName,
+                                                        Utils::QmlObjectProxy::instance()->map(object, SIGNAL(objectUpdated(UAVObject *))));
         } else {
             qWarning() << "Failed to load object" << objectName;
         }
     }
 
+    // the fast changing values, sampled once per frame
+    engine()->rootContext()->setContextProperty("pfdData", new PfdQmlDataModel(this, objManager, this));
+
     // to expose settings values
     engine()->rootContext()->setContextProperty("qmlWidget", this);
 #ifdef USE_OSG
@@ -31,6 +31,7 @@
 #include "uavobjectmanager.h"
 #include "uavobject.h"
 #include "utils/svgimageprovider.h"
+#include "utils/qmlobjectproxy.h"
 
 #include <QDebug>
 #include <QSvgRenderer>
@@ -61,7 +62,9 @@ QmlViewGadgetWidget::QmlViewGadgetWidget(QWindow *parent) :
         UAVObject *object = objManager->getObject(objectName);
 
         if (object) {
-            engine()->rootContext()->setContextProperty(objectName, object);
+            // the maps are shared by all the QML gadgets and refreshed at a limited rate
+            engine()->rootContext()->setContextProperty(objectName,
+                                                        Utils::QmlObjectProxy::instance()->map(object, SIGNAL(objectUpdated(UAVObject *))));
         } else {
             qWarning() << "Failed to load object" << objectName;
         }
@@ -29,13 +29,154 @@
 #include "plotdata.h"
 #include <math.h>
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
+
+PlotSampleBuffer::PlotSampleBuffer() :
+    m_head(0), m_count(0), m_isFixed(false), m_isDecimated(false)
+{}
+
+void PlotSampleBuffer::setFixedCapacity(int capacity)
+{
+    m_x.clear();
+    m_y.fill(0.0, qMax(capacity, 1));
+    m_head    = 0;
+    m_count   = 0;
+    m_isFixed = true;
+    m_isDecimated    = false;
+    d_boundingRect   = QRectF(0.0, 0.0, -1.0, -1.0);
+}
+
+void PlotSampleBuffer::grow()
+{
+    int capacity = qMax(2 * m_y.size(), 64);
+    QVector<double> newX(capacity);
+    QVector<double> newY(capacity);
+
+    for (int i = 0; i < m_count; ++i) {
+        newX[i] = x(i);
+        newY[i] = y(i);
+    }
+    m_x    = newX;
+    m_y    = newY;
+    m_head = 0;
+}
+
+/*!
+   Append a sample, x is ignored with a fixed capacity.
+ */
+void PlotSampleBuffer::append(double x, double y)
+{
+    if (m_isFixed) {
+        if (m_count == m_y.size()) {
+            // Overwrite the oldest sample
+            m_y[m_head] = y;
+            m_head = (m_head + 1) % m_y.size();
+        } else {
+            m_y[(m_head + m_count++) % m_y.size()] = y;
+        }
+    } else {
+        if (m_count == m_y.size()) {
+            grow();
+        }
+        int i = (m_head + m_count++) % m_y.size();
+        m_x[i] = x;
+        m_y[i] = y;
+    }
+    d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+}
+
+/*!
+   Replace all the samples, with a fixed capacity only the most recent ones are kept.
+ */
+void PlotSampleBuffer::assign(const QVector<double> &x, const QVector<double> &y)
+{
+    if (m_isFixed) {
+        int count = qMin(y.size(), m_y.size());
+        for (int i = 0; i < count; ++i) {
+            m_y[i] = y.at(y.size() - count + i);
+        }
+        m_count = count;
+    } else {
+        m_x     = x;
+        m_y     = y;
+        m_count = y.size();
+    }
+    m_head = 0;
+    m_isDecimated  = false;
+    d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+}
+
+void PlotSampleBuffer::removeFirst()
+{
+    if (m_count > 0) {
+        m_head = (m_head + 1) % m_y.size();
+        m_count--;
+        d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+    }
+}
+
+/*!
+   Keep the smallest and largest sample of each of the width buckets, in their original order,
+   so that spikes stay visible. Has no effect when there are fewer than two samples per bucket.
+ */
+void PlotSampleBuffer::decimate(int width)
+{
+    m_isDecimated  = width > 0 && m_count > 2 * width;
+    d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+    if (!m_isDecimated) {
+        m_decimated.clear();
+        return;
+    }
+
+    m_decimated.resize(0);
+    m_decimated.reserve(2 * width);
+    for (int bucket = 0; bucket < width; ++bucket) {
+        int from = (int)((qint64)bucket * m_count / width);
+        int to   = (int)((qint64)(bucket + 1) * m_count / width);
+        int iMin = from;
+        int iMax = from;
+        for (int i = from + 1; i < to; ++i) {
+            double value = y(i);
+            if (value < y(iMin)) {
+                iMin = i;
+            }
+            if (value > y(iMax)) {
+                iMax = i;
+            }
+        }
+        m_decimated.append(QPointF(x(qMin(iMin, iMax)), y(qMin(iMin, iMax))));
+        if (iMin != iMax) {
+            m_decimated.append(QPointF(x(qMax(iMin, iMax)), y(qMax(iMin, iMax))));
+        }
+    }
+}
+
+size_t PlotSampleBuffer::size() const
+{
+    return m_isDecimated ? m_decimated.size() : m_count;
+}
+
+QPointF PlotSampleBuffer::sample(size_t i) const
+{
+    return m_isDecimated ? m_decimated.at(i) : QPointF(x(i), y(i));
+}
+
+QRectF PlotSampleBuffer::boundingRect() const
+{
+    if (d_boundingRect.width() < 0.0) {
+        d_boundingRect = qwtBoundingRect(*this);
+    }
+    return d_boundingRect;
+}
 
 PlotData::PlotData(UAVObject *object, UAVObjectField *field, int element,
                    int scaleOrderFactor, int meanSamples, QString mathFunction,
                    double plotDataSize, QPen pen, bool antialiased) :
-    m_scalePower(scaleOrderFactor), m_meanSamples(meanSamples),
-    m_meanSum(0.0f), m_mathFunction(mathFunction), m_correctionSum(0.0f),
-    m_correctionCount(0), m_plotDataSize(plotDataSize),
+    m_scalePower(scaleOrderFactor), m_meanSamples(qMax(meanSamples, 1)),
+    m_mathFunction(mathFunction), m_mathFunctionId(mathFunctionFromName(mathFunction)),
+    m_plotDataSize(plotDataSize), m_samples(NULL),
+    m_windowHead(0), m_windowCount(0), m_sampleIndex(0), m_mean(0.0), m_m2(0.0),
+    m_sumSquares(0.0), m_resyncCount(0), m_lastValue(0.0), m_lastTime(0.0), m_hasLastValue(false),
     m_object(object), m_field(field), m_element(element),
     m_plotCurve(NULL), m_isVisible(true), m_pen(pen), m_isEnumPlot(false)
 {
@@ -62,8 +203,14 @@ PlotData::PlotData(UAVObject *object, UAVObjectField *field, int element,
     }
 
     m_plotCurve->setPen(m_pen);
-    m_plotCurve->setSamples(m_xDataEntries, m_yDataEntries);
+    m_samples = new PlotSampleBuffer();
+    m_plotCurve->setSamples(m_samples);
     m_isEnumPlot = m_field->getType() == UAVObjectField::ENUM;
+
+    m_window.resize(m_meanSamples);
+    if (m_mathFunctionId == MathFFTMagnitude) {
+        m_bins.resize(m_meanSamples / 2 + 1);
+    }
 }
 
 PlotData::~PlotData()
@@ -90,13 +237,34 @@ void PlotData::setVisible(bool visible)
 
 void PlotData::updatePlotData()
 {
-    m_plotCurve->setSamples(m_xDataEntries, m_yDataEntries);
+    // Never draw more points than the canvas has pixel columns
+    m_samples->decimate(m_plotCurve->plot() ? m_plotCurve->plot()->canvas()->width() : 0);
+    m_plotCurve->itemChanged();
+}
+
+/*!
+   Replace the curve samples with decoded ones, scaled like the live samples.
+   Scope math is not applied and enum curves are left unchanged.
+ */
+void PlotData::loadSamples(const QVector<double> &x, const QVector<double> &y)
+{
+    if (m_isEnumPlot) {
+        return;
+    }
+
+    QVector<double> scaled(y.size());
+    double scale = pow(10, m_scalePower);
+    for (int i = 0; i < y.size(); ++i) {
+        scaled[i] = y.at(i) * scale;
+    }
+    m_samples->assign(x, scaled);
+    updatePlotData();
 }
 
 bool PlotData::hasData() const
 {
     if (!m_isEnumPlot) {
-        return !m_xDataEntries.isEmpty();
+        return !m_samples->isEmpty();
     } else {
         return !m_enumMarkerList.isEmpty();
     }
@@ -105,7 +273,7 @@ bool PlotData::hasData() const
 QString PlotData::lastDataAsString()
 {
     if (!m_isEnumPlot) {
-        return QString().sprintf("%3.10g", m_yDataEntries.last());
+        return QString().sprintf("%3.10g", m_samples->lastY());
     } else {
         return m_enumMarkerList.last()->title().text();
     }
@@ -125,36 +293,204 @@ void PlotData::visibilityChanged(QwtPlotItem *item)
     }
 }
 
-void PlotData::calcMathFunction(double currentValue)
+/*!
+   The math function of its name in the configuration, MathNone if unknown.
+ */
+MathFunction PlotData::mathFunctionFromName(const QString &name)
 {
-    // Put the new value at the back
-    m_yDataHistory.append(currentValue);
+    static const char *const names[] = {
+        "None", "Boxcar average", "Standard deviation", "Minimum", "Maximum",
+        "RMS", "Derivative", "FFT magnitude"
+    };
+
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (name == names[i]) {
+            return (MathFunction)i;
+        }
+    }
+    return MathNone;
+}
+
+double PlotData::windowValue(int i) const
+{
+    return m_window.at((m_windowHead + i) % m_window.size());
+}
+
+/*!
+   Put the new value in the window, dropping the oldest one once it is full,
+   and update the running statistics in constant time.
+ */
+void PlotData::appendToWindow(double currentValue)
+{
+    bool full = m_windowCount == m_window.size();
+    double oldest = full ? m_window.at(m_windowHead) : 0.0;
 
-    // calculate average value
-    m_meanSum += currentValue;
-    if (m_yDataHistory.size() > m_meanSamples) {
-        m_meanSum -= m_yDataHistory.first();
-        m_yDataHistory.pop_front();
+    if (full) {
+        m_window[m_windowHead] = currentValue;
+        m_windowHead = (m_windowHead + 1) % m_window.size();
+    } else {
+        m_window[(m_windowHead + m_windowCount++) % m_window.size()] = currentValue;
     }
-    // make sure to correct the sum every meanSamples steps to prevent it
-    // from running away due to floating point rounding errors
-    m_correctionSum += currentValue;
-    if (++m_correctionCount >= m_meanSamples) {
-        m_meanSum = m_correctionSum;
-        m_correctionSum = 0.0f;
-        m_correctionCount = 0;
+
+    switch (m_mathFunctionId) {
+    case MathBoxcarAverage:
+    case MathStandardDeviation:
+    {
+        // Welford's update, with the removal of the oldest value for a full window
+        double previousMean = m_mean;
+        if (full) {
+            m_mean += (currentValue - oldest) / m_windowCount;
+            m_m2   += (currentValue - oldest) * (currentValue - m_mean + oldest - previousMean);
+        } else {
+            m_mean += (currentValue - previousMean) / m_windowCount;
+            m_m2   += (currentValue - previousMean) * (currentValue - m_mean);
+        }
+        break;
     }
+    case MathRMS:
+        m_sumSquares += currentValue * currentValue - oldest * oldest;
+        break;
+    case MathMinimum:
+        while (!m_minQueue.isEmpty() && m_minQueue.last().second >= currentValue) {
+            m_minQueue.removeLast();
+        }
+        m_minQueue.append(qMakePair(m_sampleIndex, currentValue));
+        if (m_minQueue.first().first <= m_sampleIndex - m_window.size()) {
+            m_minQueue.removeFirst();
+        }
+        break;
+    case MathMaximum:
+        while (!m_maxQueue.isEmpty() && m_maxQueue.last().second <= currentValue) {
+            m_maxQueue.removeLast();
+        }
+        m_maxQueue.append(qMakePair(m_sampleIndex, currentValue));
+        if (m_maxQueue.first().first <= m_sampleIndex - m_window.size()) {
+            m_maxQueue.removeFirst();
+        }
+        break;
+    case MathFFTMagnitude:
+    {
+        // Sliding DFT, the window is zero padded until it is full
+        const double step = 2.0 * M_PI / m_window.size();
+        for (int k = 0; k < m_bins.size(); k++) {
+            m_bins[k] = (m_bins.at(k) + currentValue - oldest) * std::polar(1.0, step * k);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    m_sampleIndex++;
 
-    double boxcarAvg = m_meanSum / m_yDataHistory.size();
-    if (m_mathFunction == "Standard deviation") {
-        // Calculate square of sample standard deviation, with Bessel's correction
-        double stdSum = 0;
-        for (int i = 0; i < m_yDataHistory.size(); i++) {
-            stdSum += pow(m_yDataHistory.at(i) - boxcarAvg, 2) / (m_meanSamples - 1);
+    // make sure to recompute the running values every meanSamples steps to prevent
+    // them from running away due to floating point rounding errors
+    if (++m_resyncCount >= m_window.size()) {
+        m_resyncCount = 0;
+        resyncWindow();
+    }
+}
+
+void PlotData::resyncWindow()
+{
+    switch (m_mathFunctionId) {
+    case MathBoxcarAverage:
+    case MathStandardDeviation:
+    {
+        double sum = 0.0;
+        for (int i = 0; i < m_windowCount; i++) {
+            sum += windowValue(i);
         }
-        m_yDataEntries.append(sqrt(stdSum));
-    } else {
-        m_yDataEntries.append(boxcarAvg);
+        m_mean = sum / m_windowCount;
+        m_m2   = 0.0;
+        for (int i = 0; i < m_windowCount; i++) {
+            m_m2 += (windowValue(i) - m_mean) * (windowValue(i) - m_mean);
+        }
+        break;
+    }
+    case MathRMS:
+        m_sumSquares = 0.0;
+        for (int i = 0; i < m_windowCount; i++) {
+            m_sumSquares += windowValue(i) * windowValue(i);
+        }
+        break;
+    case MathFFTMagnitude:
+        resyncBins();
+        break;
+    default:
+        break;
+    }
+}
+
+/*!
+   Recompute the bins as used by the sliding DFT, where the newest value is the
+   last of the window and the values missing before the window is full are zeros.
+ */
+void PlotData::resyncBins()
+{
+    const int size     = m_window.size();
+    const double step  = 2.0 * M_PI / size;
+    const int padding  = size - m_windowCount;
+
+    for (int k = 0; k < m_bins.size(); k++) {
+        std::complex<double> bin(0.0, 0.0);
+        for (int i = 0; i < m_windowCount; i++) {
+            // Value i is at window position padding + i, the newest at size - 1 was
+            // rotated once, the oldest at 0 size times
+            bin += windowValue(i) * std::polar(1.0, step * k * (size - padding - i));
+        }
+        m_bins[k] = bin;
+    }
+}
+
+/*!
+   Apply the math function to a new value, the time (in seconds) only matters to the derivative.
+ */
+double PlotData::calcMathFunction(double currentValue, double time)
+{
+    if (m_mathFunctionId == MathDerivative) {
+        double derivative = 0.0;
+        if (m_hasLastValue && time != m_lastTime) {
+            derivative = (currentValue - m_lastValue) / (time - m_lastTime);
+        }
+        m_lastValue    = currentValue;
+        m_lastTime     = time;
+        m_hasLastValue = true;
+        m_sampleIndex++;
+        return derivative;
+    }
+
+    appendToWindow(currentValue);
+
+    switch (m_mathFunctionId) {
+    case MathBoxcarAverage:
+        return m_mean;
+
+    case MathStandardDeviation:
+        // Sample standard deviation, with Bessel's correction
+        return m_windowCount > 1 ? sqrt(qMax(m_m2, 0.0) / (m_windowCount - 1)) : 0.0;
+
+    case MathMinimum:
+        return m_minQueue.first().second;
+
+    case MathMaximum:
+        return m_maxQueue.first().second;
+
+    case MathRMS:
+        return sqrt(qMax(m_sumSquares, 0.0) / m_windowCount);
+
+    case MathFFTMagnitude:
+    {
+        // Amplitude of the strongest component but the DC one
+        double peak = 0.0;
+        for (int k = 1; k < m_bins.size(); k++) {
+            double amplitude = std::abs(m_bins.at(k)) * ((2 * k == m_window.size()) ? 1.0 : 2.0) / m_window.size();
+            peak = qMax(peak, amplitude);
+        }
+        return peak;
+    }
+
+    default:
+        return currentValue;
     }
 }
 
@@ -186,22 +522,15 @@ bool SequentialPlotData::append(UAVObject *obj)
 {
     if (m_object == obj && m_field) {
         if (!m_isEnumPlot) {
-            double currentValue = m_field->getValue(m_element).toDouble() * pow(10, m_scalePower);
+            double currentValue = m_field->getDouble(m_element) * pow(10, m_scalePower);
 
             // Perform scope math, if necessary
-            if (m_mathFunction == "Boxcar average" || m_mathFunction == "Standard deviation") {
-                calcMathFunction(currentValue);
-            } else {
-                m_yDataEntries.append(currentValue);
+            if (m_mathFunctionId != MathNone) {
+                currentValue = calcMathFunction(currentValue, m_sampleIndex);
             }
 
-            if (m_yDataEntries.size() > m_plotDataSize) {
-                // If new data overflows the window, remove old data...
-                m_yDataEntries.pop_front();
-            } else {
-                // ...otherwise, add a new y point at position xData
-                m_xDataEntries.insert(m_xDataEntries.size(), m_xDataEntries.size());
-            }
+            // The buffer has a fixed size, new data overwrites the oldest
+            m_samples->append(0, currentValue);
             return true;
         } else {
             // Enum markers
@@ -225,22 +554,17 @@ bool SequentialPlotData::append(UAVObject *obj)
 bool ChronoPlotData::append(UAVObject *obj)
 {
     if (m_object == obj && m_field) {
-        // Get the field of interest
-        // THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-        QDateTime NOW = QDateTime::currentDateTime();
-
-        double xValue = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+        // The time of the sample, the autopilot one for the timestamped telemetry
+        double xValue = obj->getUpdateTime();
         if (!m_isEnumPlot) {
-            double currentValue = m_field->getValue(m_element).toDouble() * pow(10, m_scalePower);
+            double currentValue = m_field->getDouble(m_element) * pow(10, m_scalePower);
 
             // Perform scope math, if necessary
-            if (m_mathFunction == "Boxcar average" || m_mathFunction == "Standard deviation") {
-                calcMathFunction(currentValue);
-            } else {
-                m_yDataEntries.append(currentValue);
+            if (m_mathFunctionId != MathNone) {
+                currentValue = calcMathFunction(currentValue, xValue);
             }
 
-            m_xDataEntries.append(xValue);
+            m_samples->append(xValue, currentValue);
         } else {
             // Enum markers
             QString value = m_field->getValue(m_element).toString();
@@ -264,10 +588,9 @@ bool ChronoPlotData::append(UAVObject *obj)
 
 void ChronoPlotData::removeStaleData()
 {
-    while (!m_xDataEntries.isEmpty() &&
-           (m_xDataEntries.last() - m_xDataEntries.first()) > m_plotDataSize) {
-        m_yDataEntries.pop_front();
-        m_xDataEntries.pop_front();
+    while (!m_samples->isEmpty() &&
+           (m_samples->lastX() - m_samples->firstX()) > m_plotDataSize) {
+        m_samples->removeFirst();
     }
     while (!m_enumMarkerList.isEmpty() &&
            (m_enumMarkerList.last()->xValue() - m_enumMarkerList.first()->xValue()) > m_plotDataSize) {
@@ -276,3 +599,234 @@ void ChronoPlotData::removeStaleData()
         delete marker;
     }
 }
+
+/*!
+   In place radix-2 FFT, the size of data must be a power of two.
+ */
+static void fft(QVector<std::complex<double> > &data)
+{
+    int n = data.size();
+
+    // Bit reversal permutation
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (int length = 2; length <= n; length <<= 1) {
+        const std::complex<double> step = std::polar(1.0, -2.0 * M_PI / length);
+        for (int i = 0; i < n; i += length) {
+            std::complex<double> w(1.0, 0.0);
+            for (int k = 0; k < length / 2; ++k) {
+                std::complex<double> u = data[i + k];
+                std::complex<double> v = data[i + k + length / 2] * w;
+                data[i + k] = u + v;
+                data[i + k + length / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+SpectrumPlotData::SpectrumPlotData(UAVObject *object, UAVObjectField *field, int element,
+                                   int scaleFactor, int meanSamples, QString mathFunction,
+                                   double plotDataSize, QPen pen, bool antialiased) :
+    PlotData(object, field, element, scaleFactor, meanSamples,
+             mathFunction, plotDataSize, pen, antialiased),
+    m_head(0), m_count(0), m_hasNewData(false)
+{
+    int size = qMax((int)plotDataSize, 16);
+
+    m_values.resize(size);
+    m_times.resize(size);
+    m_lastUpdate.start();
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(spectrumReady()));
+}
+
+SpectrumPlotData::~SpectrumPlotData()
+{
+    // The worker has its own copy of the values, only its result is delivered here
+    m_watcher.waitForFinished();
+}
+
+void SpectrumPlotData::appendValue(double time, double value)
+{
+    int i = (m_head + m_count) % m_values.size();
+
+    m_values[i] = value;
+    m_times[i]  = time;
+    if (m_count < m_values.size()) {
+        ++m_count;
+    } else {
+        m_head = (m_head + 1) % m_values.size();
+    }
+    m_hasNewData = true;
+}
+
+bool SpectrumPlotData::append(UAVObject *obj)
+{
+    if (m_object != obj || !m_field || m_isEnumPlot) {
+        return false;
+    }
+
+    double time = obj->getUpdateTime();
+    double currentValue = m_field->getDouble(m_element) * pow(10, m_scalePower);
+
+    // Perform scope math, if necessary
+    if (m_mathFunctionId != MathNone) {
+        currentValue = calcMathFunction(currentValue, time);
+    }
+
+    appendValue(time, currentValue);
+    return true;
+}
+
+/*!
+   Copy the buffered values oldest first, the sample rate is the mean one of the buffer.
+   Returns false when there are too few samples for a spectrum.
+ */
+bool SpectrumPlotData::analysisWindow(QVector<double> &values, double &sampleRate) const
+{
+    if (m_count < 16) {
+        return false;
+    }
+
+    double span = m_times.at((m_head + m_count - 1) % m_times.size()) - m_times.at(m_head);
+    if (span <= 0.0) {
+        return false;
+    }
+
+    values.resize(m_count);
+    for (int i = 0; i < m_count; ++i) {
+        values[i] = m_values.at((m_head + i) % m_values.size());
+    }
+    sampleRate = (m_count - 1) / span;
+    return true;
+}
+
+void SpectrumPlotData::startSpectrum()
+{
+    QVector<double> values;
+    double sampleRate;
+
+    if (!analysisWindow(values, sampleRate)) {
+        return;
+    }
+    m_hasNewData = false;
+    m_lastUpdate.restart();
+    m_watcher.setFuture(QtConcurrent::run(&SpectrumPlotData::welch, values, sampleRate));
+}
+
+void SpectrumPlotData::spectrumReady()
+{
+    if (m_watcher.isCanceled()) {
+        return;
+    }
+
+    Spectrum spectrum = m_watcher.result();
+    m_samples->assign(spectrum.frequencies, spectrum.densities);
+    m_plotCurve->itemChanged();
+}
+
+/*!
+   Start a new estimate when there is new data, no more often than every s_updateInterval ms.
+   The curve is updated when the worker is done.
+ */
+void SpectrumPlotData::updatePlotData()
+{
+    if (m_hasNewData && !m_watcher.isRunning() && m_lastUpdate.elapsed() >= s_updateInterval) {
+        startSpectrum();
+    }
+}
+
+/*!
+   Show the spectrum of the last plotDataSize samples of a decoded log, x are the sample times (s).
+ */
+void SpectrumPlotData::loadSamples(const QVector<double> &x, const QVector<double> &y)
+{
+    if (m_isEnumPlot) {
+        return;
+    }
+
+    m_watcher.waitForFinished();
+    m_head  = 0;
+    m_count = 0;
+    double scale = pow(10, m_scalePower);
+    for (int i = qMax(y.size() - m_values.size(), 0); i < y.size(); ++i) {
+        appendValue(x.at(i), y.at(i) * scale);
+    }
+    m_hasNewData = false;
+
+    QVector<double> values;
+    double sampleRate;
+    Spectrum spectrum;
+    if (analysisWindow(values, sampleRate)) {
+        spectrum = welch(values, sampleRate);
+    }
+    m_samples->assign(spectrum.frequencies, spectrum.densities);
+    m_plotCurve->itemChanged();
+}
+
+/*!
+   Welch's estimate of the one sided power spectral density of values, in dB of units^2/Hz.
+
+   The values are cut in Hann windowed segments of a power of two of at most half of them,
+   overlapping by half, whose periodograms are averaged. The DC bin is left out, it has no
+   place on the log frequency axis.
+ */
+SpectrumPlotData::Spectrum SpectrumPlotData::welch(const QVector<double> &values, double sampleRate)
+{
+    Spectrum spectrum;
+    int length = 8;
+
+    while (4 * length <= values.size()) {
+        length *= 2;
+    }
+    if (values.size() < length) {
+        return spectrum;
+    }
+
+    QVector<double> hann(length);
+    double windowPower = 0.0;
+    for (int i = 0; i < length; ++i) {
+        hann[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / length));
+        windowPower += hann.at(i) * hann.at(i);
+    }
+
+    QVector<double> power(length / 2 + 1, 0.0);
+    QVector<std::complex<double> > segment(length);
+    int segments = 0;
+    // From the newest values, the oldest ones left over are ignored
+    for (int start = values.size() - length; start >= 0; start -= length / 2) {
+        double mean = 0.0;
+        for (int i = 0; i < length; ++i) {
+            mean += values.at(start + i);
+        }
+        mean /= length;
+        for (int i = 0; i < length; ++i) {
+            segment[i] = (values.at(start + i) - mean) * hann.at(i);
+        }
+        fft(segment);
+        for (int k = 0; k <= length / 2; ++k) {
+            power[k] += std::norm(segment.at(k));
+        }
+        ++segments;
+    }
+
+    double scale = 1.0 / (segments * sampleRate * windowPower);
+    spectrum.frequencies.resize(length / 2);
+    spectrum.densities.resize(length / 2);
+    for (int k = 1; k <= length / 2; ++k) {
+        // The bins below Nyquist also hold the power of the negative frequencies
+        double density = power.at(k) * scale * (k < length / 2 ? 2.0 : 1.0);
+        spectrum.frequencies[k - 1] = k * sampleRate / length;
+        spectrum.densities[k - 1]   = 10.0 * log10(qMax(density, 1e-20));
+    }
+    return spectrum;
+}
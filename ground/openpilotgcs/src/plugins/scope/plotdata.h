@@ -36,16 +36,86 @@
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 #include <qwt/src/qwt_plot_marker.h>
+#include <qwt/src/qwt_series_data.h>
 
 #include <QTimer>
 #include <QTime>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QVector>
+#include <QList>
+#include <QPair>
+#include <complex>
 #include <uavdataobject.h>
 
 /*!
    \brief Defines the different type of plots.
  */
-enum PlotType { SequentialPlot, ChronoPlot };
+enum PlotType { SequentialPlot, ChronoPlot, SpectrumPlot };
+
+/*!
+   \brief The scope math functions, all but the derivative over the last meanSamples values.
+ */
+enum MathFunction { MathNone, MathBoxcarAverage, MathStandardDeviation, MathMinimum, MathMaximum,
+                    MathRMS, MathDerivative, MathFFTMagnitude };
+
+/*!
+   \brief Circular sample buffer handed to the curve without copying.
+
+   With a fixed capacity the oldest sample is overwritten and the x value of a sample is
+   its position in the buffer, otherwise the buffer grows as needed.
+   decimate() reduces the samples shown to a min/max pair per pixel column.
+ */
+class PlotSampleBuffer : public QwtSeriesData<QPointF> {
+public:
+    PlotSampleBuffer();
+
+    void setFixedCapacity(int capacity);
+    void append(double x, double y);
+    void assign(const QVector<double> &x, const QVector<double> &y);
+    void removeFirst();
+    void decimate(int width);
+
+    bool isEmpty() const
+    {
+        return m_count == 0;
+    }
+    double firstX() const
+    {
+        return x(0);
+    }
+    double lastX() const
+    {
+        return x(m_count - 1);
+    }
+    double lastY() const
+    {
+        return y(m_count - 1);
+    }
+
+    size_t size() const;
+    QPointF sample(size_t i) const;
+    QRectF boundingRect() const;
+
+private:
+    QVector<double> m_x;
+    QVector<double> m_y;
+    int m_head;
+    int m_count;
+    bool m_isFixed;
+    QVector<QPointF> m_decimated;
+    bool m_isDecimated;
+
+    double x(int i) const
+    {
+        return m_isFixed ? i : m_x.at((m_head + i) % m_x.size());
+    }
+    double y(int i) const
+    {
+        return m_y.at((m_head + i) % m_y.size());
+    }
+    void grow();
+};
 
 /*!
    \brief Base class that keeps the data for each curve in the plot.
@@ -92,7 +162,8 @@ public:
     virtual PlotType plotType() const   = 0;
     virtual void removeStaleData() = 0;
 
-    void updatePlotData();
+    virtual void updatePlotData();
+    virtual void loadSamples(const QVector<double> &x, const QVector<double> &y);
 
     bool hasData() const;
     QString lastDataAsString();
@@ -106,15 +177,30 @@ protected:
     // This is the power to which each value must be raised
     int m_scalePower;
     int m_meanSamples;
-    double m_meanSum;
     QString m_mathFunction;
-    double m_correctionSum;
-    int m_correctionCount;
+    MathFunction m_mathFunctionId;
     double m_plotDataSize;
 
-    QVector<double> m_xDataEntries;
-    QVector<double> m_yDataEntries;
-    QVector<double> m_yDataHistory;
+    // owned by m_plotCurve
+    PlotSampleBuffer *m_samples;
+
+    // Window of the last m_meanSamples values, and its running statistics
+    QVector<double> m_window;
+    int m_windowHead;
+    int m_windowCount;
+    qint64 m_sampleIndex;
+    double m_mean;
+    double m_m2;
+    double m_sumSquares;
+    int m_resyncCount;
+    // Monotonic queues of (sample index, value), the window extremum first
+    QList<QPair<qint64, double> > m_minQueue;
+    QList<QPair<qint64, double> > m_maxQueue;
+    // Sliding DFT bins of the window, up to the Nyquist bin
+    QVector<std::complex<double> > m_bins;
+    double m_lastValue;
+    double m_lastTime;
+    bool m_hasLastValue;
 
     UAVObject *m_object;
     UAVObjectField *m_field;
@@ -126,7 +212,12 @@ protected:
     bool m_isVisible;
     QPen m_pen;
     bool m_isEnumPlot;
-    virtual void calcMathFunction(double currentValue);
+    static MathFunction mathFunctionFromName(const QString &name);
+    void appendToWindow(double currentValue);
+    void resyncWindow();
+    void resyncBins();
+    double windowValue(int i) const;
+    virtual double calcMathFunction(double currentValue, double time);
     QwtPlotMarker *createMarker(QString value);
 };
 
@@ -141,7 +232,10 @@ public:
                        int scaleFactor, int meanSamples, QString mathFunction,
                        double plotDataSize, QPen pen, bool antialiased)
         : PlotData(object, field, element, scaleFactor, meanSamples,
-                   mathFunction, plotDataSize, pen, antialiased) {}
+                   mathFunction, plotDataSize, pen, antialiased)
+    {
+        m_samples->setFixedCapacity((int)plotDataSize);
+    }
     ~SequentialPlotData() {}
 
     bool append(UAVObject *obj);
@@ -174,4 +268,53 @@ public:
     void removeStaleData();
 };
 
+/*!
+   \brief The spectrum plot shows the power spectral density of the last plotDataSize samples.
+
+   The density is estimated with Welch's method on a worker thread, at most every
+   s_updateInterval ms, the x values are the frequencies in Hz and the y values are in dB.
+ */
+class SpectrumPlotData : public PlotData {
+    Q_OBJECT
+public:
+    SpectrumPlotData(UAVObject *object, UAVObjectField *field, int element,
+                     int scaleFactor, int meanSamples, QString mathFunction,
+                     double plotDataSize, QPen pen, bool antialiased);
+    ~SpectrumPlotData();
+
+    bool append(UAVObject *obj);
+    PlotType plotType() const
+    {
+        return SpectrumPlot;
+    }
+    void removeStaleData() {}
+    void updatePlotData();
+    void loadSamples(const QVector<double> &x, const QVector<double> &y);
+
+    struct Spectrum {
+        QVector<double> frequencies;
+        QVector<double> densities;
+    };
+    static Spectrum welch(const QVector<double> &values, double sampleRate);
+
+private slots:
+    void spectrumReady();
+
+private:
+    static const int s_updateInterval = 100;
+
+    // Ring of the last plotDataSize values and their times (s)
+    QVector<double> m_values;
+    QVector<double> m_times;
+    int m_head;
+    int m_count;
+    bool m_hasNewData;
+    QElapsedTimer m_lastUpdate;
+    QFutureWatcher<Spectrum> m_watcher;
+
+    void appendValue(double time, double value);
+    bool analysisWindow(QVector<double> &values, double &sampleRate) const;
+    void startSpectrum();
+};
+
 #endif // PLOTDATA_H
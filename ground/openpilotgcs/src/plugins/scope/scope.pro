@@ -3,6 +3,8 @@ TARGET = ScopeGadget
 
 DEFINES += SCOPE_LIBRARY
 
+QT += concurrent
+
 include(../../openpilotgcsplugin.pri)
 include (scope_dependencies.pri)
 
@@ -54,6 +54,8 @@ void ScopeGadget::loadConfiguration(IUAVGadgetConfiguration *config)
         widget->setupSequentialPlot();
     } else if (sgConfig->plotType() == ChronoPlot) {
         widget->setupChronoPlot();
+    } else if (sgConfig->plotType() == SpectrumPlot) {
+        widget->setupSpectrumPlot();
     }
 
     foreach(PlotCurveConfiguration * plotCurveConfig, sgConfig->plotCurveConfigs()) {
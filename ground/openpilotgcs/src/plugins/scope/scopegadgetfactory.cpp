@@ -50,6 +50,11 @@ void ScopeGadgetFactory::startPlotting()
     emit onStartPlotting();
 }
 
+void ScopeGadgetFactory::loadLog(QString fileName)
+{
+    emit onLoadLog(fileName);
+}
+
 
 Core::IUAVGadget *ScopeGadgetFactory::createGadget(QWidget *parent)
 {
@@ -57,6 +62,7 @@ Core::IUAVGadget *ScopeGadgetFactory::createGadget(QWidget *parent)
 
     connect(this, SIGNAL(onStartPlotting()), gadgetWidget, SLOT(startPlotting()));
     connect(this, SIGNAL(onStopPlotting()), gadgetWidget, SLOT(stopPlotting()));
+    connect(this, SIGNAL(onLoadLog(QString)), gadgetWidget, SLOT(loadLog(QString)));
     return new ScopeGadget(QString("ScopeGadget"), gadgetWidget, parent);
 }
 
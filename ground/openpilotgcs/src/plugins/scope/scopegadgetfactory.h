@@ -51,10 +51,12 @@ public:
 public slots:
     void stopPlotting();
     void startPlotting();
+    void loadLog(QString fileName);
 
 signals:
     void onStopPlotting();
     void onStartPlotting();
+    void onLoadLog(QString fileName);
 };
 
 #endif // SCOPEGADGETFACTORY_H_
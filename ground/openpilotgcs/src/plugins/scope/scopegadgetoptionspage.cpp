@@ -55,6 +55,7 @@ QWidget *ScopeGadgetOptionsPage::createPage(QWidget *parent)
 
     options_page->cmbPlotType->addItem("Sequential Plot", "");
     options_page->cmbPlotType->addItem("Chronological Plot", "");
+    options_page->cmbPlotType->addItem("Spectrum Plot", "");
 
     // Fills the combo boxes for the UAVObjects
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -72,6 +73,11 @@ QWidget *ScopeGadgetOptionsPage::createPage(QWidget *parent)
     options_page->mathFunctionComboBox->addItem("None");
     options_page->mathFunctionComboBox->addItem("Boxcar average");
     options_page->mathFunctionComboBox->addItem("Standard deviation");
+    options_page->mathFunctionComboBox->addItem("Minimum");
+    options_page->mathFunctionComboBox->addItem("Maximum");
+    options_page->mathFunctionComboBox->addItem("RMS");
+    options_page->mathFunctionComboBox->addItem("Derivative");
+    options_page->mathFunctionComboBox->addItem("FFT magnitude");
 
     if (options_page->cmbUAVObjects->currentIndex() >= 0) {
         on_cmbUAVObjects_currentIndexChanged(options_page->cmbUAVObjects->currentText());
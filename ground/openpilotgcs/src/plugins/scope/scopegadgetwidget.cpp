@@ -33,14 +33,18 @@
 #include "uavobject.h"
 #include "coreplugin/icore.h"
 #include "coreplugin/connectionmanager.h"
+#include "uavtalk/uavtalklogdecoder.h"
 
 #include "qwt/src/qwt_plot_curve.h"
 #include "qwt/src/qwt_plot_grid.h"
+#include "qwt/src/qwt_scale_engine.h"
 
 #include <iostream>
 #include <math.h>
 #include <QDebug>
+#include <QApplication>
 #include <QDir>
+#include <QFileInfo>
 #include <QColor>
 #include <QStringList>
 #include <QWidget>
@@ -61,7 +65,8 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_csvLoggingNewFileOnConnect(false),
     m_csvLoggingStartTime(QDateTime::currentDateTime()),
     m_csvLoggingPath("./csvlogging/"),
-    m_plotLegend(NULL)
+    m_plotLegend(NULL),
+    m_showingLog(false)
 {
     setMouseTracking(true);
 
@@ -186,6 +191,7 @@ void ScopeGadgetWidget::showEvent(QShowEvent *e)
  */
 void ScopeGadgetWidget::startPlotting()
 {
+    m_showingLog = false;
     if (replotTimer && !replotTimer->isActive()) {
         replotTimer->start(m_refreshInterval);
     }
@@ -250,6 +256,7 @@ void ScopeGadgetWidget::preparePlot(PlotType plotType)
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
 
     setCanvasBackground(QColor(64, 64, 64));
+    setAxisScaleEngine(QwtPlot::xBottom, new QwtLinearScaleEngine());
 
     // Add grid lines
     QwtPlotGrid *grid = new QwtPlotGrid;
@@ -306,7 +313,7 @@ void ScopeGadgetWidget::setupChronoPlot()
     preparePlot(ChronoPlot);
 
     setAxisScaleDraw(QwtPlot::xBottom, new TimeScaleDraw());
-    uint NOW = QDateTime::currentDateTime().toTime_t();
+    double NOW = UAVObject::currentTime();
     setAxisScale(QwtPlot::xBottom, NOW - m_plotDataSize / 1000, NOW);
     setAxisLabelRotation(QwtPlot::xBottom, 0.0);
     setAxisLabelAlignment(QwtPlot::xBottom, Qt::AlignLeft | Qt::AlignBottom);
@@ -318,6 +325,24 @@ void ScopeGadgetWidget::setupChronoPlot()
     setAxisFont(QwtPlot::yLeft, fnt); // y-axis
 }
 
+void ScopeGadgetWidget::setupSpectrumPlot()
+{
+    preparePlot(SpectrumPlot);
+
+    // Frequencies in Hz, the range follows the sample rate of the curves
+    setAxisScaleDraw(QwtPlot::xBottom, new QwtScaleDraw());
+    setAxisScaleEngine(QwtPlot::xBottom, new QwtLogScaleEngine());
+    setAxisAutoScale(QwtPlot::xBottom);
+    setAxisLabelRotation(QwtPlot::xBottom, 0.0);
+    setAxisLabelAlignment(QwtPlot::xBottom, Qt::AlignLeft | Qt::AlignBottom);
+
+    // reduce the axis font size
+    QFont fnt(axisFont(QwtPlot::xBottom));
+    fnt.setPointSize(7);
+    setAxisFont(QwtPlot::xBottom, fnt); // x-axis
+    setAxisFont(QwtPlot::yLeft, fnt); // y-axis
+}
+
 void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubField, int scaleFactor,
                                      int meanSamples, QString mathFunction, QPen pen, bool antialiased)
 {
@@ -366,6 +391,10 @@ void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubFie
         plotData = new ChronoPlotData(object, field, element, scaleFactor,
                                       meanSamples, mathFunction, m_plotDataSize,
                                       pen, antialiased);
+    } else {
+        plotData = new SpectrumPlotData(object, field, element, scaleFactor,
+                                        meanSamples, mathFunction, m_plotDataSize,
+                                        pen, antialiased);
     }
     connect(this, SIGNAL(visibilityChanged(QwtPlotItem *)), plotData, SLOT(visibilityChanged(QwtPlotItem *)));
     plotData->attach(this);
@@ -390,6 +419,9 @@ void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubFie
 
 void ScopeGadgetWidget::uavObjectReceived(UAVObject *obj)
 {
+    if (m_showingLog) {
+        return;
+    }
     foreach(PlotData * plotData, m_curvesData.values()) {
         if (plotData->append(obj)) {
             m_csvLoggingDataUpdated = 1;
@@ -410,9 +442,8 @@ void ScopeGadgetWidget::replotNewData()
         plotData->updatePlotData();
     }
 
-    QDateTime NOW = QDateTime::currentDateTime();
-    double toTime = NOW.toTime_t();
-    toTime += NOW.time().msec() / 1000.0;
+    // On the clock of the sample times
+    double toTime = UAVObject::currentTime();
     if (m_plotType == ChronoPlot) {
         setAxisScale(QwtPlot::xBottom, toTime - m_plotDataSize, toTime);
     }
@@ -422,6 +453,51 @@ void ScopeGadgetWidget::replotNewData()
     replot();
 }
 
+/**
+ * Plots a whole telemetry log decoded offline in place of the live data,
+ * until plotting is restarted.
+ */
+void ScopeGadgetWidget::loadLog(QString fileName)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    UAVTalkLogDecoder decoder(objManager);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool decoded = decoder.decode(fileName);
+    QApplication::restoreOverrideCursor();
+    if (!decoded) {
+        qDebug() << "Unable to decode log" << fileName;
+        return;
+    }
+    stopPlotting();
+    m_showingLog = true;
+
+    // Logs have no wall clock time, assume the log ended when the file was last written
+    double startTime = QFileInfo(fileName).lastModified().toTime_t() - decoder.endTime() / 1000.0;
+
+    QMutexLocker locker(&m_mutex);
+    foreach(PlotData * plotData, m_curvesData.values()) {
+        const UAVObjectTimeSeries *series = decoder.series(plotData->object()->getObjID(), plotData->object()->getInstID());
+        const QVector<double> *values     = series ? series->values(plotData->field()->getName(), plotData->element()) : NULL;
+
+        if (values == NULL) {
+            plotData->loadSamples(QVector<double>(), QVector<double>());
+            continue;
+        }
+        QVector<double> x(series->timeStamps.size());
+        for (int i = 0; i < x.size(); ++i) {
+            x[i] = startTime + series->timeStamps.at(i) / 1000.0;
+        }
+        plotData->loadSamples(x, *values);
+    }
+
+    if (m_plotType == ChronoPlot) {
+        setAxisScale(QwtPlot::xBottom, startTime, startTime + decoder.endTime() / 1000.0);
+    }
+    replot();
+}
+
 void ScopeGadgetWidget::clearCurvePlots()
 {
     foreach(PlotData * plotData, m_curvesData.values()) {
@@ -71,6 +71,7 @@ public:
 
     void setupSequentialPlot();
     void setupChronoPlot();
+    void setupSpectrumPlot();
     void setupUAVObjectPlot();
     PlotType plotType()
     {
@@ -129,6 +130,9 @@ protected:
     void wheelEvent(QWheelEvent *e);
     void showEvent(QShowEvent *e);
 
+public slots:
+    void loadLog(QString fileName);
+
 private slots:
     void uavObjectReceived(UAVObject *);
     void replotNewData();
@@ -151,6 +155,8 @@ private:
     QMap<QString, PlotData *> m_curvesData;
 
     QTimer *replotTimer;
+    // A decoded log is shown, live updates are ignored until plotting restarts
+    bool m_showingLog;
 
     bool m_csvLoggingStarted;
     bool m_csvLoggingEnabled;
@@ -35,40 +35,80 @@
 
 #include <QDebug>
 
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#endif
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
 
 SerialEnumerationThread::SerialEnumerationThread(SerialConnection *serial)
-    : m_serial(serial), m_running(false)
+    : m_serial(serial), m_running(false), m_rescan(false)
 {}
 
 void SerialEnumerationThread::run()
 {
+    QMutexLocker locker(&m_mutex);
+
     m_running = true;
-    QList <Core::IConnection::device> devices = m_serial->availableDevices();
     while (m_running) {
         if (!m_serial->deviceOpened()) {
-            QList <Core::IConnection::device> newDev = m_serial->availableDevices();
-            if (devices != newDev) {
-                devices = newDev;
+            locker.unlock();
+            QList <Core::IConnection::device> newDev = m_serial->enumerateDevices();
+            locker.relock();
+            if (m_devices != newDev) {
+                m_devices = newDev;
                 emit enumerationChanged();
             }
         }
         // update available devices every two seconds (doesn't need more)
-        msleep(2000);
+        // unless a device event asks for it sooner
+        if (!m_rescan && m_running) {
+            m_wakeup.wait(&m_mutex, 2000);
+        }
+        m_rescan = false;
     }
 }
 
 void SerialEnumerationThread::stop()
 {
+    QMutexLocker locker(&m_mutex);
+
     if (!m_running) {
         return;
     }
     m_running = false;
+    m_wakeup.wakeAll();
+    locker.unlock();
     // wait for the thread to terminate
     if (wait(2100) == false) {
         qDebug() << "Cannot terminate SerialEnumerationThread";
     }
 }
 
+/**
+ * Returns the devices found by the last enumeration
+ */
+QList <Core::IConnection::device> SerialEnumerationThread::devices()
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_devices;
+}
+
+/**
+ * Enumerate again now, called on the device events
+ */
+void SerialEnumerationThread::rescan()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_rescan = true;
+    m_wakeup.wakeAll();
+}
+
 SerialConnection::SerialConnection() :
     serialHandle(NULL),
     enablePolling(true),
@@ -84,20 +124,15 @@ SerialConnection::SerialConnection() :
     // Experimental: enable polling on all OS'es since there
     // were reports that autodetect does not work on XP amongst
     // others.
-
-    // #ifdef Q_OS_WIN
-////I'm cheating a little bit here:
-////Knowing if the device enumeration really changed is a bit complicated
-////so I just signal it whenever we have a device event...
-// QMainWindow *mw = Core::ICore::instance()->mainWindow();
-// QObject::connect(mw, SIGNAL(deviceChange()),
-// this, SLOT(onEnumerationChanged()));
-// #else
-    // Other OSes do not send such signals:
     QObject::connect(&m_enumerateThread, SIGNAL(enumerationChanged()),
                      this, SLOT(onEnumerationChanged()));
+#ifdef Q_OS_WIN
+    // The device events only make the thread enumerate sooner, it still
+    // tells whether the enumeration really changed
+    QMainWindow *mw = Core::ICore::instance()->mainWindow();
+    QObject::connect(mw, SIGNAL(deviceChange()), &m_enumerateThread, SLOT(rescan()));
+#endif
     m_enumerateThread.start();
-// #endif
 }
 
 SerialConnection::~SerialConnection()
@@ -134,7 +169,19 @@ QList<QSerialPortInfo> SerialConnection::availablePorts()
 }
 
 
+/**
+ * Returns the serial ports found by the enumeration thread, without
+ * enumerating them again in the GUI thread
+ */
 QList <Core::IConnection::device> SerialConnection::availableDevices()
+{
+    if (!enablePolling) {
+        return QList <Core::IConnection::device>();
+    }
+    return m_enumerateThread.devices();
+}
+
+QList <Core::IConnection::device> SerialConnection::enumerateDevices()
 {
     QList <Core::IConnection::device> list;
 
@@ -174,15 +221,63 @@ QIODevice *SerialConnection::openDevice(const QString &deviceName)
                     && serialHandle->setStopBits(QSerialPort::OneStop)
                     && serialHandle->setFlowControl(QSerialPort::NoFlowControl)) {
                     qDebug() << "Serial telemetry running at " << m_config->speed();
+                    configureDriver(serialHandle);
                     m_deviceOpened = true;
                 }
             }
+            // the port lives in the telemetry thread, count in that thread
+            serialHandle->setProperty("rxOverruns", 0);
+            connect(serialHandle, SIGNAL(error(QSerialPort::SerialPortError)),
+                    this, SLOT(onPortError(QSerialPort::SerialPortError)), Qt::DirectConnection);
             return serialHandle;
         }
     }
     return NULL;
 }
 
+/**
+ * Applies the driver options of the configuration, a failure only
+ * leaves the driver defaults
+ */
+void SerialConnection::configureDriver(QSerialPort *port)
+{
+#ifdef Q_OS_LINUX
+    // ASYNC_LOW_LATENCY disables the receive batching of the tty layer,
+    // the ftdi_sio driver also drops its latency timer to 1ms with it
+    struct serial_struct serial;
+    if (ioctl(port->handle(), TIOCGSERIAL, &serial) == 0) {
+        if (m_config->lowLatency()) {
+            serial.flags |= ASYNC_LOW_LATENCY;
+        } else {
+            serial.flags &= ~ASYNC_LOW_LATENCY;
+        }
+        if (ioctl(port->handle(), TIOCSSERIAL, &serial) != 0) {
+            qDebug() << "SerialConnection: cannot set the low latency mode of" << port->portName();
+        }
+    }
+#endif
+#ifdef Q_OS_WIN
+    if (m_config->osBufferSize() > 0 &&
+        !SetupComm((HANDLE)port->handle(), m_config->osBufferSize(), m_config->osBufferSize())) {
+        qDebug() << "SerialConnection: cannot set the driver buffers of" << port->portName();
+    }
+#endif
+    Q_UNUSED(port);
+}
+
+/**
+ * Counts the receive overruns on the port, the telemetry monitor
+ * reports them with the other connection statistics
+ */
+void SerialConnection::onPortError(QSerialPort::SerialPortError error)
+{
+    QObject *port = sender();
+
+    if (port && error == QSerialPort::OverrunError) {
+        port->setProperty("rxOverruns", port->property("rxOverruns").toInt() + 1);
+    }
+}
+
 void SerialConnection::closeDevice(const QString &deviceName)
 {
     Q_UNUSED(deviceName);
@@ -218,6 +313,7 @@ void SerialConnection::suspendPolling()
 void SerialConnection::resumePolling()
 {
     enablePolling = true;
+    m_enumerateThread.rescan();
 }
 
 SerialPlugin::SerialPlugin() : m_connection(0)
@@ -36,6 +36,8 @@
 #include "serialpluginconfiguration.h"
 #include "serialpluginoptionspage.h"
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 
 class IConnection;
 class QSerialPortInfo;
@@ -44,7 +46,8 @@ class SerialConnection;
 /**
  *   Helper thread to check on new serial port connection/disconnection
  *   Some operating systems do not send device insertion events so
- *   for those we have to poll
+ *   for those we have to poll. The enumeration can take long, the
+ *   GUI only reads the list of the last one.
  */
 // class SERIAL_EXPORT SerialEnumerationThread : public QThread
 class SerialEnumerationThread : public QThread {
@@ -55,6 +58,10 @@ public:
     virtual void run();
 
     void stop();
+    QList <Core::IConnection::device> devices();
+
+public slots:
+    void rescan();
 
 signals:
     void enumerationChanged();
@@ -62,6 +69,10 @@ signals:
 protected:
     SerialConnection *m_serial;
     bool m_running;
+    bool m_rescan;
+    QMutex m_mutex;
+    QWaitCondition m_wakeup;
+    QList <Core::IConnection::device> m_devices;
 };
 
 
@@ -79,6 +90,7 @@ public:
     virtual ~SerialConnection();
 
     virtual QList <Core::IConnection::device> availableDevices();
+    QList <Core::IConnection::device> enumerateDevices();
     virtual QIODevice *openDevice(const QString &deviceName);
     virtual void closeDevice(const QString &deviceName);
 
@@ -108,9 +120,11 @@ private:
     SerialPluginOptionsPage *m_optionspage;
 
     QList<QSerialPortInfo> availablePorts();
+    void configureDriver(QSerialPort *port);
 
 protected slots:
     void onEnumerationChanged();
+    void onPortError(QSerialPort::SerialPortError error);
 
 protected:
     SerialEnumerationThread m_enumerateThread;
@@ -38,7 +38,9 @@
  */
 SerialPluginConfiguration::SerialPluginConfiguration(QString classId, QSettings *qSettings, QObject *parent) :
     IUAVGadgetConfiguration(classId, parent),
-    m_speed("57600")
+    m_speed("57600"),
+    m_lowLatency(true),
+    m_osBufferSize(65536)
 {
     Q_UNUSED(qSettings);
 
@@ -56,7 +58,9 @@ IUAVGadgetConfiguration *SerialPluginConfiguration::clone()
 {
     SerialPluginConfiguration *m = new SerialPluginConfiguration(this->classId());
 
-    m->m_speed = m_speed;
+    m->m_speed        = m_speed;
+    m->m_lowLatency   = m_lowLatency;
+    m->m_osBufferSize = m_osBufferSize;
     return m;
 }
 
@@ -67,6 +71,8 @@ IUAVGadgetConfiguration *SerialPluginConfiguration::clone()
 void SerialPluginConfiguration::saveConfig(QSettings *settings) const
 {
     settings->setValue("speed", m_speed);
+    settings->setValue("lowLatency", m_lowLatency);
+    settings->setValue("osBufferSize", m_osBufferSize);
 }
 
 void SerialPluginConfiguration::restoresettings()
@@ -79,6 +85,8 @@ void SerialPluginConfiguration::restoresettings()
     } else {
         m_speed = str;
     }
+    m_lowLatency   = settings->value(QLatin1String("lowLatency"), true).toBool();
+    m_osBufferSize = settings->value(QLatin1String("osBufferSize"), 65536).toInt();
     settings->endGroup();
 }
 
@@ -86,5 +94,7 @@ void SerialPluginConfiguration::savesettings() const
 {
     settings->beginGroup(QLatin1String("SerialConnection"));
     settings->setValue(QLatin1String("speed"), m_speed);
+    settings->setValue(QLatin1String("lowLatency"), m_lowLatency);
+    settings->setValue(QLatin1String("osBufferSize"), m_osBufferSize);
     settings->endGroup();
 }
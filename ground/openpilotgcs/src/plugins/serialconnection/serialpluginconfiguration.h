@@ -46,6 +46,14 @@ public:
     {
         return m_speed;
     }
+    bool lowLatency()
+    {
+        return m_lowLatency;
+    }
+    int osBufferSize()
+    {
+        return m_osBufferSize;
+    }
     void saveConfig(QSettings *settings) const;
     IUAVGadgetConfiguration *clone();
     void savesettings() const;
@@ -53,6 +61,8 @@ public:
 
 private:
     QString m_speed;
+    bool m_lowLatency;
+    int m_osBufferSize;
     QSettings *settings;
 
 public slots:
@@ -60,6 +70,14 @@ public slots:
     {
         m_speed = speed;
     }
+    void setLowLatency(bool lowLatency)
+    {
+        m_lowLatency = lowLatency;
+    }
+    void setOsBufferSize(int size)
+    {
+        m_osBufferSize = size;
+    }
 };
 
 #endif // SERIALPLUGINCONFIGURATION_H
@@ -78,6 +78,16 @@ QWidget *SerialPluginOptionsPage::createPage(QWidget *parent)
 
     options_page->cb_speed->addItems(allowedSpeeds);
     options_page->cb_speed->setCurrentIndex(options_page->cb_speed->findText(m_config->speed()));
+    options_page->cb_lowLatency->setChecked(m_config->lowLatency());
+    options_page->sb_bufferSize->setValue(m_config->osBufferSize());
+#ifndef Q_OS_LINUX
+    options_page->cb_lowLatency->setVisible(false);
+#endif
+#ifndef Q_OS_WIN
+    // only the Windows driver lets us choose its buffer sizes
+    options_page->label_bufferSize->setVisible(false);
+    options_page->sb_bufferSize->setVisible(false);
+#endif
     return optionsPageWidget;
 }
 
@@ -90,6 +100,8 @@ QWidget *SerialPluginOptionsPage::createPage(QWidget *parent)
 void SerialPluginOptionsPage::apply()
 {
     m_config->setSpeed(options_page->cb_speed->currentText());
+    m_config->setLowLatency(options_page->cb_lowLatency->isChecked());
+    m_config->setOsBufferSize(options_page->sb_bufferSize->value());
     m_config->savesettings();
 }
 
@@ -35,6 +35,13 @@
 #include "revocalibration.h"
 #include "accelgyrosettings.h"
 
+// a window of samples noisier than this (standard deviation) is taken as motion
+#define ACCEL_MOTION_STDDEV 0.3 // m/s^2
+#define GYRO_MOTION_STDDEV  1.0 // deg/s
+// the measurement of a sensor ends once the standard error of its mean is below this
+#define ACCEL_TARGET_ERROR  0.005 // m/s^2
+#define GYRO_TARGET_ERROR   0.01 // deg/s
+
 
 BiasCalibrationUtil::BiasCalibrationUtil(long measurementCount, long measurementRate) : QObject(),
     m_isMeasuring(false), m_accelMeasurementCount(measurementCount), m_gyroMeasurementCount(measurementCount),
@@ -70,7 +77,7 @@ void BiasCalibrationUtil::gyroMeasurementsUpdated(UAVObject *obj)
 {
     Q_UNUSED(obj);
 
-    if (m_receivedGyroUpdates < m_gyroMeasurementCount) {
+    if (m_isMeasuring && !m_gyro.converged && m_receivedGyroUpdates < m_gyroMeasurementCount) {
         ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
         UAVObjectManager *uavObjectManager = pm->getObject<UAVObjectManager>();
         Q_ASSERT(uavObjectManager);
@@ -78,23 +85,19 @@ void BiasCalibrationUtil::gyroMeasurementsUpdated(UAVObject *obj)
         GyroState *gyroState = GyroState::GetInstance(uavObjectManager);
         GyroState::DataFields gyroStateData = gyroState->getData();
 
-        m_gyroX += gyroStateData.x;
-        m_gyroY += gyroStateData.y;
-        m_gyroZ += gyroStateData.z;
+        addSample(m_gyro, gyroStateData.x, gyroStateData.y, gyroStateData.z);
 
         m_receivedGyroUpdates++;
         emit progress(m_receivedGyroUpdates + m_receivedAccelUpdates, m_gyroMeasurementCount + m_accelMeasurementCount);
-    } else if (m_receivedAccelUpdates >= m_accelMeasurementCount &&
-               m_receivedGyroUpdates >= m_gyroMeasurementCount && m_isMeasuring) {
-        stopMeasurement();
     }
+    checkDone();
 }
 
 void BiasCalibrationUtil::accelMeasurementsUpdated(UAVObject *obj)
 {
     Q_UNUSED(obj);
 
-    if (m_receivedAccelUpdates < m_accelMeasurementCount) {
+    if (m_isMeasuring && !m_accel.converged && m_receivedAccelUpdates < m_accelMeasurementCount) {
         ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
         UAVObjectManager *uavObjectManager = pm->getObject<UAVObjectManager>();
         Q_ASSERT(uavObjectManager);
@@ -102,15 +105,120 @@ void BiasCalibrationUtil::accelMeasurementsUpdated(UAVObject *obj)
         AccelState *accelState = AccelState::GetInstance(uavObjectManager);
         AccelState::DataFields AccelStateData = accelState->getData();
 
-        m_accelerometerX += AccelStateData.x;
-        m_accelerometerY += AccelStateData.y;
-        m_accelerometerZ += AccelStateData.z;
+        addSample(m_accel, AccelStateData.x, AccelStateData.y, AccelStateData.z);
 
         m_receivedAccelUpdates++;
         emit progress(m_receivedGyroUpdates + m_receivedAccelUpdates, m_gyroMeasurementCount + m_accelMeasurementCount);
-    } else if (m_receivedAccelUpdates >= m_accelMeasurementCount &&
-               m_receivedGyroUpdates >= m_gyroMeasurementCount && m_isMeasuring) {
-        stopMeasurement();
+    }
+    checkDone();
+}
+
+// Stop once both sensors converged or got all their samples, counting the skipped ones as received
+void BiasCalibrationUtil::checkDone()
+{
+    if (!m_isMeasuring ||
+        !(m_accel.converged || m_receivedAccelUpdates >= m_accelMeasurementCount) ||
+        !(m_gyro.converged || m_receivedGyroUpdates >= m_gyroMeasurementCount)) {
+        return;
+    }
+    emit progress(m_gyroMeasurementCount + m_accelMeasurementCount, m_gyroMeasurementCount + m_accelMeasurementCount);
+    stopMeasurement();
+
+    if (m_accel.accepted.count == 0 || m_gyro.accepted.count == 0) {
+        emit timeout(tr("Calibration failed, the vehicle did not stay still. Make sure it is not touched or moved during the calibration."));
+        return;
+    }
+
+    accelGyroBias bias;
+    bias.m_accelerometerXBias = m_accel.accepted.mean[0];
+    bias.m_accelerometerYBias = m_accel.accepted.mean[1];
+    bias.m_accelerometerZBias = m_accel.accepted.mean[2];
+
+    bias.m_gyroXBias = m_gyro.accepted.mean[0];
+    bias.m_gyroYBias = m_gyro.accepted.mean[1];
+    bias.m_gyroZBias = m_gyro.accepted.mean[2];
+
+    qDebug() << "Bias calculations finished";
+    emit done(bias);
+}
+
+void BiasCalibrationUtil::RunningStats::reset()
+{
+    count = 0;
+    for (int i = 0; i < 3; i++) {
+        mean[i] = 0;
+        m2[i]   = 0;
+    }
+}
+
+void BiasCalibrationUtil::RunningStats::add(const double sample[3])
+{
+    count++;
+    for (int i = 0; i < 3; i++) {
+        double delta = sample[i] - mean[i];
+        mean[i] += delta / count;
+        m2[i]   += delta * (sample[i] - mean[i]);
+    }
+}
+
+// Combine with the statistics of other samples (Chan et al.)
+void BiasCalibrationUtil::RunningStats::merge(const RunningStats &other)
+{
+    long total = count + other.count;
+
+    if (other.count == 0) {
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        double delta = other.mean[i] - mean[i];
+        mean[i] += delta * other.count / total;
+        m2[i]   += other.m2[i] + delta * delta * ((double)count * other.count / total);
+    }
+    count = total;
+}
+
+double BiasCalibrationUtil::RunningStats::variance(int axis) const
+{
+    return count > 1 ? m2[axis] / (count - 1) : 0;
+}
+
+void BiasCalibrationUtil::resetSensor(SensorStats &sensor, double motionStdDev, double targetError)
+{
+    sensor.window.reset();
+    sensor.accepted.reset();
+    sensor.motionStdDev    = motionStdDev;
+    sensor.targetError     = targetError;
+    sensor.rejectedWindows = 0;
+    sensor.converged = false;
+}
+
+void BiasCalibrationUtil::addSample(SensorStats &sensor, double x, double y, double z)
+{
+    const double sample[3] = { x, y, z };
+
+    sensor.window.add(sample);
+    if (sensor.window.count < WINDOW_SAMPLES) {
+        return;
+    }
+
+    bool moving = false;
+    for (int i = 0; i < 3; i++) {
+        moving |= sensor.window.variance(i) > sensor.motionStdDev * sensor.motionStdDev;
+    }
+    if (moving) {
+        sensor.rejectedWindows++;
+    } else {
+        sensor.accepted.merge(sensor.window);
+    }
+    sensor.window.reset();
+
+    if (sensor.accepted.count >= MIN_WINDOWS * WINDOW_SAMPLES) {
+        // standard error of the mean below the target on every axis
+        bool converged = true;
+        for (int i = 0; i < 3; i++) {
+            converged &= sensor.accepted.variance(i) < sensor.targetError * sensor.targetError * sensor.accepted.count;
+        }
+        sensor.converged = converged;
     }
 }
 
@@ -126,14 +234,10 @@ void BiasCalibrationUtil::startMeasurement()
 
     // Reset variables
     m_receivedAccelUpdates = 0;
-    m_accelerometerX = 0;
-    m_accelerometerY = 0;
-    m_accelerometerZ = 0;
+    resetSensor(m_accel, ACCEL_MOTION_STDDEV, ACCEL_TARGET_ERROR);
 
-    m_receivedGyroUpdates = 0;
-    m_gyroX = 0;
-    m_gyroY = 0;
-    m_gyroZ = 0;
+    m_receivedGyroUpdates  = 0;
+    resetSensor(m_gyro, GYRO_MOTION_STDDEV, GYRO_TARGET_ERROR);
 
     ExtensionSystem::PluginManager *pm     = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *uavObjectManager     = pm->getObject<UAVObjectManager>();
@@ -193,7 +297,8 @@ void BiasCalibrationUtil::startMeasurement()
 
 void BiasCalibrationUtil::stopMeasurement()
 {
-    qDebug() << "Sampling done, G =" << m_receivedGyroUpdates << "A =" << m_receivedAccelUpdates;
+    qDebug() << "Sampling done, G =" << m_receivedGyroUpdates << "(" << m_gyro.accepted.count << "used," << m_gyro.rejectedWindows << "windows rejected)"
+             << "A =" << m_receivedAccelUpdates << "(" << m_accel.accepted.count << "used," << m_accel.rejectedWindows << "windows rejected)";
 
     m_isMeasuring = false;
 
@@ -219,16 +324,4 @@ void BiasCalibrationUtil::stopMeasurement()
     AttitudeSettings::DataFields attitudeSettingsData = AttitudeSettings::GetInstance(uavObjectManager)->getData();
     attitudeSettingsData.BiasCorrectGyro = AttitudeSettings::BIASCORRECTGYRO_TRUE;
     AttitudeSettings::GetInstance(uavObjectManager)->setData(attitudeSettingsData);
-
-    accelGyroBias bias;
-    bias.m_accelerometerXBias = m_accelerometerX / (double)m_receivedAccelUpdates;
-    bias.m_accelerometerYBias = m_accelerometerY / (double)m_receivedAccelUpdates;
-    bias.m_accelerometerZBias = m_accelerometerZ / (double)m_receivedAccelUpdates;
-
-    bias.m_gyroXBias = m_gyroX / (double)m_receivedGyroUpdates;
-    bias.m_gyroYBias = m_gyroY / (double)m_receivedGyroUpdates;
-    bias.m_gyroZBias = m_gyroZ / (double)m_receivedGyroUpdates;
-
-    qDebug() << "Bias calculations finished";
-    emit done(bias);
 }
@@ -56,6 +56,32 @@ private slots:
     void timeout();
 
 private:
+    // Running mean and variance of 3 axis samples (Welford)
+    struct RunningStats {
+        long   count;
+        double mean[3];
+        double m2[3];
+
+        void reset();
+        void add(const double sample[3]);
+        void merge(const RunningStats &other);
+        double variance(int axis) const;
+    };
+
+    // Samples of a sensor are taken in windows of WINDOW_SAMPLES, a window noisier than
+    // motionStdDev is dropped, the others are merged in accepted until the standard error
+    // of the mean is below targetError
+    struct SensorStats {
+        RunningStats window;
+        RunningStats accepted;
+        double motionStdDev;
+        double targetError;
+        long   rejectedWindows;
+        bool   converged;
+    };
+    static const int WINDOW_SAMPLES = 25;
+    static const int MIN_WINDOWS    = 4;
+
     QTimer m_timeoutTimer;
 
     bool m_isMeasuring;
@@ -70,13 +96,12 @@ private:
     UAVObject::Metadata m_previousGyroMetaData;
     UAVObject::Metadata m_previousAccelMetaData;
 
-    double m_accelerometerX;
-    double m_accelerometerY;
-    double m_accelerometerZ;
-    double m_gyroX;
-    double m_gyroY;
-    double m_gyroZ;
+    SensorStats m_accel;
+    SensorStats m_gyro;
 
+    static void resetSensor(SensorStats &sensor, double motionStdDev, double targetError);
+    static void addSample(SensorStats &sensor, double x, double y, double z);
+    void checkDone();
     void stop();
     void startMeasurement();
     void stopMeasurement();
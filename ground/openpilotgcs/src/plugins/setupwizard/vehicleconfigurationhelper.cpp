@@ -47,8 +47,8 @@
 
 VehicleConfigurationHelper::VehicleConfigurationHelper(VehicleConfigurationSource *configSource)
     : m_configSource(configSource), m_uavoManager(0),
-    m_transactionOK(false), m_transactionTimeout(false), m_currentTransactionObjectID(-1),
-    m_progress(0)
+    m_transactionOK(false), m_transactionTimeout(false),
+    m_progress(0), m_saveToSD(false), m_savedCount(0)
 {
     Q_ASSERT(m_configSource);
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -760,109 +760,176 @@ void VehicleConfigurationHelper::applyTemplateSettings()
     }
 }
 
+/*
+   The modified objects are sent ahead of their acknowledgement, UPDATE_WINDOW at a time
+   so that the telemetry queue never overflows, and each one is queued for saving as soon
+   as the board acknowledged it. UAVObjectUtilManager keeps several save requests
+   outstanding that the board writes in one flash transaction.
+ */
 bool VehicleConfigurationHelper::saveChangesToController(bool save)
 {
     qDebug() << "Saving modified objects to controller. " << m_modifiedObjects.count() << " objects in found.";
-    const int OUTER_TIMEOUT = 3000 * 20; // 10 seconds timeout for saving all objects
-    const int INNER_TIMEOUT = 2000; // 1 second timeout on every save attempt
+    const int OUTER_TIMEOUT = 3000 * 20; // 60 seconds timeout for saving all objects
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     Q_ASSERT(pm);
     UAVObjectUtilManager *utilMngr     = pm->getObject<UAVObjectUtilManager>();
     Q_ASSERT(utilMngr);
 
+    m_saveToSD = save;
+    m_sendQueue.clear();
+    m_updatesPending.clear();
+    m_savesPending.clear();
+    m_attempts.clear();
+    m_descriptions.clear();
+    m_savedCount = 0;
+    m_transactionOK = true;
+    m_transactionTimeout = false;
+
+    // An object modified more than once is sent once
+    for (int i = 0; i < m_modifiedObjects.count(); i++) {
+        QPair<UAVDataObject *, QString> *objPair = m_modifiedObjects.at(i);
+        UAVDataObject *obj = objPair->first;
+        if (UAVObject::GetGcsAccess(obj->getMetadata()) == UAVObject::ACCESS_READONLY || !obj->isSettingsObject()) {
+            qDebug() << "Trying to save a UAVDataObject that is read only or is not a settings object.";
+            continue;
+        }
+        if (!m_descriptions.contains(obj)) {
+            m_sendQueue << obj;
+            connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(uAVOTransactionCompleted(UAVObject *, bool)));
+        }
+        m_descriptions.insert(obj, objPair->second);
+    }
+    QList<UAVDataObject *> objects = m_sendQueue;
+
     QTimer outerTimeoutTimer;
     outerTimeoutTimer.setSingleShot(true);
 
-    QTimer innerTimeoutTimer;
-    innerTimeoutTimer.setSingleShot(true);
-
     connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(uAVOTransactionCompleted(int, bool)));
-    connect(&innerTimeoutTimer, SIGNAL(timeout()), &m_eventLoop, SLOT(quit()));
     connect(&outerTimeoutTimer, SIGNAL(timeout()), this, SLOT(saveChangesTimeout()));
 
+    m_saveTime.start();
     outerTimeoutTimer.start(OUTER_TIMEOUT);
-    for (int i = 0; i < m_modifiedObjects.count(); i++) {
-        QPair<UAVDataObject *, QString> *objPair = m_modifiedObjects.at(i);
-        m_transactionOK = false;
-        UAVDataObject *obj     = objPair->first;
-        QString objDescription = objPair->second;
-        if (UAVObject::GetGcsAccess(obj->getMetadata()) != UAVObject::ACCESS_READONLY && obj->isSettingsObject()) {
-            emit saveProgress(m_modifiedObjects.count() + 1, ++m_progress, objDescription);
-
-            m_currentTransactionObjectID = obj->getObjID();
-
-            connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(uAVOTransactionCompleted(UAVObject *, bool)));
-            while (!m_transactionOK && !m_transactionTimeout) {
-                // Allow the transaction to take some time
-                innerTimeoutTimer.start(INNER_TIMEOUT);
-
-                // Set object updated
-                obj->updated();
-                if (!m_transactionOK) {
-                    m_eventLoop.exec();
-                }
-                innerTimeoutTimer.stop();
-            }
-            disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(uAVOTransactionCompleted(UAVObject *, bool)));
-            if (m_transactionOK) {
-                qDebug() << "Object " << obj->getName() << " was successfully updated.";
-                if (save) {
-                    m_transactionOK = false;
-                    m_currentTransactionObjectID = obj->getObjID();
-                    // Try to save until success or timeout
-                    while (!m_transactionOK && !m_transactionTimeout) {
-                        // Allow the transaction to take some time
-                        innerTimeoutTimer.start(INNER_TIMEOUT);
-
-                        // Persist object in controller
-                        utilMngr->saveObjectToSD(obj);
-                        if (!m_transactionOK) {
-                            m_eventLoop.exec();
-                        }
-                        innerTimeoutTimer.stop();
-                    }
-                    m_currentTransactionObjectID = -1;
-                }
-            }
-
-            if (!m_transactionOK) {
-                qDebug() << "Transaction timed out when trying to save: " << obj->getName();
-            } else {
-                qDebug() << "Object " << obj->getName() << " was successfully saved.";
-            }
-        } else {
-            qDebug() << "Trying to save a UAVDataObject that is read only or is not a settings object.";
-        }
-        if (m_transactionTimeout) {
-            qDebug() << "Transaction timed out when trying to save " << m_modifiedObjects.count() << " objects.";
-            break;
-        }
+    sendNextUpdates();
+    if (m_transactionOK && !(m_sendQueue.isEmpty() && m_updatesPending.isEmpty() && m_savesPending.isEmpty())) {
+        m_eventLoop.exec();
     }
 
     outerTimeoutTimer.stop();
+    foreach(UAVDataObject * obj, objects) {
+        disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(uAVOTransactionCompleted(UAVObject *, bool)));
+    }
     disconnect(&outerTimeoutTimer, SIGNAL(timeout()), this, SLOT(saveChangesTimeout()));
-    disconnect(&innerTimeoutTimer, SIGNAL(timeout()), &m_eventLoop, SLOT(quit()));
     disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(uAVOTransactionCompleted(int, bool)));
 
-    qDebug() << "Finished saving modified objects to controller. Success = " << m_transactionOK;
+    if (m_transactionTimeout) {
+        qDebug() << "Transaction timed out when trying to save " << m_modifiedObjects.count() << " objects.";
+    }
+    // Stop waiting for the completion of what is still outstanding
+    m_sendQueue.clear();
+    m_updatesPending.clear();
+    m_savesPending.clear();
+
+    qDebug() << "Finished saving modified objects to controller. Success = " << m_transactionOK
+             << ", " << m_savedCount << " objects in " << m_saveTime.elapsed() << "ms";
 
     return m_transactionOK;
 }
 
+void VehicleConfigurationHelper::sendNextUpdates()
+{
+    const int UPDATE_WINDOW = 8; // below the telemetry queue size
+
+    while (m_transactionOK && !m_sendQueue.isEmpty() && m_updatesPending.count() < UPDATE_WINDOW) {
+        UAVDataObject *obj = m_sendQueue.takeFirst();
+        m_updatesPending << obj;
+        m_attempts[obj]++;
+        // may complete at once, if it can't be queued
+        obj->updated();
+    }
+}
+
+void VehicleConfigurationHelper::objectSaved(UAVDataObject *object)
+{
+    qDebug() << "Object " << object->getName() << " was successfully saved.";
+    m_savedCount++;
+
+    // Report every modification of the object along with the achieved rate
+    float rate = m_savedCount * 1000.0f / qMax((qint64)1, m_saveTime.elapsed());
+    foreach(QString description, m_descriptions.values(object)) {
+        emit saveProgress(m_modifiedObjects.count() + 1, ++m_progress, tr("%1 (%2 objects/s)").arg(description).arg(rate, 0, 'f', 1));
+    }
+
+    if (m_sendQueue.isEmpty() && m_updatesPending.isEmpty() && m_savesPending.isEmpty()) {
+        m_eventLoop.quit();
+    }
+}
+
+// completion of the save request of an object
 void VehicleConfigurationHelper::uAVOTransactionCompleted(int oid, bool success)
 {
-    if (oid == m_currentTransactionObjectID) {
-        m_transactionOK = success;
+    const int SAVE_ATTEMPTS = 5;
+
+    UAVDataObject *obj = NULL;
+
+    // completions come in the order of the requests
+    foreach(UAVDataObject * pending, m_savesPending) {
+        if ((int)pending->getObjID() == oid) {
+            obj = pending;
+            break;
+        }
+    }
+    if (!obj || !m_transactionOK) {
+        return;
+    }
+
+    if (success) {
+        m_savesPending.removeOne(obj);
+        objectSaved(obj);
+    } else if (++m_attempts[obj] <= SAVE_ATTEMPTS) {
+        qDebug() << "Retrying to save " << obj->getName();
+        m_savesPending.removeOne(obj);
+        m_savesPending << obj;
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        pm->getObject<UAVObjectUtilManager>()->saveObjectToSD(obj);
+    } else {
+        qDebug() << "Transaction failed when trying to save: " << obj->getName();
+        m_transactionOK = false;
         m_eventLoop.quit();
     }
 }
 
+// completion of the update of an object
 void VehicleConfigurationHelper::uAVOTransactionCompleted(UAVObject *object, bool success)
 {
-    if (object) {
-        uAVOTransactionCompleted(object->getObjID(), success);
+    const int UPDATE_ATTEMPTS = 5;
+
+    UAVDataObject *obj = dynamic_cast<UAVDataObject *>(object);
+
+    if (!obj || !m_updatesPending.removeOne(obj) || !m_transactionOK) {
+        return;
+    }
+
+    if (success) {
+        qDebug() << "Object " << obj->getName() << " was successfully updated.";
+        if (m_saveToSD) {
+            m_attempts[obj] = 1;
+            m_savesPending << obj;
+            ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+            pm->getObject<UAVObjectUtilManager>()->saveObjectToSD(obj);
+        } else {
+            objectSaved(obj);
+        }
+    } else if (m_attempts[obj] < UPDATE_ATTEMPTS) {
+        // send it again after the others
+        m_sendQueue << obj;
+    } else {
+        qDebug() << "Transaction failed when trying to update: " << obj->getName();
+        m_transactionOK = false;
+        m_eventLoop.quit();
+        return;
     }
+    sendNextUpdates();
 }
 
 void VehicleConfigurationHelper::saveChangesTimeout()
@@ -30,6 +30,8 @@
 
 #include <QList>
 #include <QPair>
+#include <QHash>
+#include <QElapsedTimer>
 #include "vehicleconfigurationsource.h"
 #include "uavobjectmanager.h"
 #include "systemsettings.h"
@@ -97,12 +99,23 @@ private:
     void applyMultiGUISettings(SystemSettings::AirframeTypeOptions airframe, GUIConfigDataUnion guiConfig);
 
     bool saveChangesToController(bool save);
+    void sendNextUpdates();
+    void objectSaved(UAVDataObject *object);
     QEventLoop m_eventLoop;
     bool m_transactionOK;
     bool m_transactionTimeout;
-    int m_currentTransactionObjectID;
     int m_progress;
 
+    // objects of m_modifiedObjects being saved, by stage
+    bool m_saveToSD;
+    QList<UAVDataObject *> m_sendQueue;
+    QList<UAVDataObject *> m_updatesPending;
+    QList<UAVDataObject *> m_savesPending;
+    QHash<UAVDataObject *, int> m_attempts;
+    QMultiHash<UAVDataObject *, QString> m_descriptions;
+    QElapsedTimer m_saveTime;
+    int m_savedCount;
+
     void resetVehicleConfig();
     void resetGUIData();
 
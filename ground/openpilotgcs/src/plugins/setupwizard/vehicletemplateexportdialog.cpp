@@ -189,7 +189,6 @@ void VehicleTemplateExportDialog::accept()
     objectsToExport << StabilizationSettingsBank3::GetInstance(m_uavoManager);
     objectsToExport << MixerSettings::GetInstance(m_uavoManager);
     objectsToExport << EKFConfiguration::GetInstance(m_uavoManager);
-    m_uavoManager->toJson(exportObject, objectsToExport);
 
     exportObject["type"]       = m_type;
     exportObject["subtype"]    = m_subType;
@@ -217,8 +216,6 @@ void VehicleTemplateExportDialog::accept()
         exportObject["photo"] = QString::fromLatin1(bytes.toBase64().data());
     }
 
-    QJsonDocument saveDoc(exportObject);
-
     const char *fileType = ".optmpl";
 
     QString fileName     = QString("%1-%2-%3%4")
@@ -246,8 +243,8 @@ void VehicleTemplateExportDialog::accept()
             fullPath.append(fileType);
         }
         QFile saveFile(fullPath);
-        if (saveFile.open(QIODevice::WriteOnly)) {
-            saveFile.write(saveDoc.toJson());
+        // The objects are streamed after the template description
+        if (saveFile.open(QIODevice::WriteOnly) && m_uavoManager->toJson(&saveFile, objectsToExport, exportObject)) {
             saveFile.close();
         } else {
             QMessageBox::information(this, "Export", tr("Settings could not be exported to \n%1(%2).\nPlease try again.")
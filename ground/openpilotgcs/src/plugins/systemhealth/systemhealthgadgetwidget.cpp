@@ -29,11 +29,15 @@
 #include "systemhealthgadgetwidget.h"
 
 #include "utils/stylehelper.h"
+#include "utils/rastersvgitem.h"
+#include "utils/svgrastercache.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include <uavtalk/telemetrymanager.h>
 
 #include <QDebug>
+#include <QHeaderView>
+#include <QTableWidget>
 #include <QWhatsThis>
 
 /*
@@ -47,10 +51,11 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
 
 
     m_renderer = new QSvgRenderer();
-    background = new QGraphicsSvgItem();
-    foreground = new QGraphicsSvgItem();
-    nolink     = new QGraphicsSvgItem();
+    background = new RasterSvgItem();
+    foreground = new RasterSvgItem();
+    nolink     = new RasterSvgItem();
     missingElements = new QStringList();
+    taskTable  = NULL;
     paint();
 
     // Now connect the widget to the SystemAlarms UAVObject
@@ -60,12 +65,17 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
     SystemAlarms *obj = dynamic_cast<SystemAlarms *>(objManager->getObject(QString("SystemAlarms")));
     connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateAlarms(UAVObject *)));
 
+    UAVObject *taskInfo = objManager->getObject(QString("TaskInfo"));
+    if (taskInfo) {
+        connect(taskInfo, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateTasks(UAVObject *)));
+    }
+
     // Listen to autopilot connection events
     TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
     connect(telMngr, SIGNAL(connected()), this, SLOT(onAutopilotConnect()));
     connect(telMngr, SIGNAL(disconnected()), this, SLOT(onAutopilotDisconnect()));
 
-    setToolTip(tr("Displays flight system errors. Click on an alarm for more information."));
+    setToolTip(tr("Displays flight system errors. Click on an alarm for more information, right click for the task load."));
 }
 
 /**
@@ -86,17 +96,9 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
 
 void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
 {
-    // This code does not know anything about alarms beforehand, and
-    // I found no efficient way to locate items inside the scene by
-    // name, so it's just as simple to reset the scene:
-    // And add the one with the right name.
-    QGraphicsScene *m_scene = scene();
-
-    foreach(QGraphicsItem * item, background->childItems()) {
-        m_scene->removeItem(item);
-        delete item; // removeItem does _not_ delete the item.
-    }
-
+    // This code does not know anything about alarms beforehand, one
+    // indicator item is kept per alarm and switched to the element of
+    // its current value, so that an update only repaints what changed.
     QMatrix backgroundMatrix = (m_renderer->matrixForElement(background->elementId())).inverted();
 
     QString alarm = systemAlarm->getName();
@@ -107,6 +109,11 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
             if (!missingElements->contains(element)) {
                 if (m_renderer->elementExists(element)) {
                     QString element2 = element + "-" + value;
+                    QGraphicsSvgItem *ind = indicators.value(element);
+                    if (ind && ind->elementId() == element2) {
+                        // unchanged
+                        continue;
+                    }
                     if (!missingElements->contains(element2)) {
                         if (m_renderer->elementExists(element2)) {
                             // element2 is in global coordinates
@@ -115,19 +122,28 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
                             // use this composed projection to get the position in background coordinates
                             QRectF rectProjected  = blockMatrix.mapRect(m_renderer->boundsOnElement(element2));
 
-                            QGraphicsSvgItem *ind = new QGraphicsSvgItem();
-                            ind->setSharedRenderer(m_renderer);
+                            if (!ind) {
+                                ind = new RasterSvgItem();
+                                ind->setSharedRenderer(m_renderer);
+                                ind->setParentItem(background);
+                                indicators.insert(element, ind);
+                            }
                             ind->setElementId(element2);
-                            ind->setParentItem(background);
+                            ind->setVisible(true);
                             QTransform matrix;
                             matrix.translate(rectProjected.x(), rectProjected.y());
                             ind->setTransform(matrix, false);
                         } else {
+                            if (ind) {
+                                ind->setVisible(false);
+                            }
                             if (value.compare("Uninitialised") != 0) {
                                 missingElements->append(element2);
                                 qDebug() << "Warning: element " << element2 << " not found in SVG.";
                             }
                         }
+                    } else if (ind) {
+                        ind->setVisible(false);
                     }
                 } else {
                     missingElements->append(element);
@@ -148,6 +164,10 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
 {
     // Clear the list of elements not found on svg
     missingElements->clear();
+    // The indicators belong to the previous file
+    qDeleteAll(indicators);
+    indicators.clear();
+    Utils::SvgRasterCache::instance()->invalidate(m_renderer);
     setBackgroundBrush(QBrush(Utils::StyleHelper::baseColor()));
     if (QFile::exists(dfn)) {
         m_renderer->load(dfn);
@@ -217,6 +237,11 @@ void SystemHealthGadgetWidget::resizeEvent(QResizeEvent *event)
 
 void SystemHealthGadgetWidget::mousePressEvent(QMouseEvent *event)
 {
+    if (event->button() == Qt::RightButton) {
+        showTaskTable();
+        return;
+    }
+
     QGraphicsScene *graphicsScene = scene();
 
     if (graphicsScene) {
@@ -249,6 +274,81 @@ void SystemHealthGadgetWidget::mousePressEvent(QMouseEvent *event)
     }
 }
 
+/**
+ * Show the table of the running tasks, it can be sorted on any column
+ */
+void SystemHealthGadgetWidget::showTaskTable()
+{
+    if (!taskTable) {
+        taskTable = new QTableWidget(0, 4, this);
+        taskTable->setWindowFlags(Qt::Tool);
+        taskTable->setWindowTitle(tr("Task load"));
+        taskTable->setHorizontalHeaderLabels(QStringList() << tr("Task") << tr("Stack free (bytes)")
+                                                           << tr("CPU (%)") << tr("Max burst (us)"));
+        taskTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        taskTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        taskTable->verticalHeader()->setVisible(false);
+        taskTable->horizontalHeader()->setStretchLastSection(true);
+        taskTable->setSortingEnabled(true);
+        taskTable->sortByColumn(2, Qt::DescendingOrder);
+        taskTable->resize(480, 420);
+    }
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    UAVObject *taskInfo = objManager->getObject(QString("TaskInfo"));
+    if (taskInfo) {
+        taskInfo->requestUpdate();
+        updateTasks(taskInfo);
+    }
+    taskTable->show();
+    taskTable->raise();
+}
+
+/**
+ * Refresh the task table, one row per running task
+ */
+void SystemHealthGadgetWidget::updateTasks(UAVObject *taskInfo)
+{
+    if (!taskTable || !taskTable->isVisible()) {
+        return;
+    }
+
+    UAVObjectField *running  = taskInfo->getField("Running");
+    UAVObjectField *stack    = taskInfo->getField("StackRemaining");
+    UAVObjectField *load     = taskInfo->getField("RunningTime");
+    UAVObjectField *maxBurst = taskInfo->getField("MaxBurst");
+    if (!running || !stack || !load) {
+        return;
+    }
+
+    // Sorting while the rows are filled would move them around
+    taskTable->setSortingEnabled(false);
+    taskTable->setRowCount(0);
+    QStringList names = running->getElementNames();
+    for (int i = 0; i < names.size(); ++i) {
+        if (running->getValue(i).toString() != "True") {
+            continue;
+        }
+        int row = taskTable->rowCount();
+        taskTable->insertRow(row);
+        taskTable->setItem(row, 0, new QTableWidgetItem(names.at(i)));
+        QTableWidgetItem *item = new QTableWidgetItem();
+        item->setData(Qt::DisplayRole, (quint32)stack->getDouble(i));
+        taskTable->setItem(row, 1, item);
+        item = new QTableWidgetItem();
+        item->setData(Qt::DisplayRole, (quint32)load->getDouble(i));
+        taskTable->setItem(row, 2, item);
+        item = new QTableWidgetItem();
+        if (maxBurst) {
+            item->setData(Qt::DisplayRole, (quint32)maxBurst->getDouble(i));
+        }
+        taskTable->setItem(row, 3, item);
+    }
+    taskTable->setSortingEnabled(true);
+    taskTable->resizeColumnsToContents();
+}
+
 void SystemHealthGadgetWidget::showAlarmDescriptionForItemId(const QString itemId, const QPoint & location)
 {
     QFile alarmDescription(":/systemhealth/html/" + itemId + ".html");
@@ -259,6 +359,75 @@ void SystemHealthGadgetWidget::showAlarmDescriptionForItemId(const QString itemI
     }
 }
 
+/**
+ * Min / mean / max of a CallbackTiming duration, followed by its log2 histogram drawn with block characters
+ */
+static QString callbackDurationText(UAVObject *timing, const QString &name)
+{
+    UAVObjectField *stats     = timing->getField(name);
+    UAVObjectField *histogram = timing->getField(name + "Histogram");
+
+    if (!stats || !histogram) {
+        return QString();
+    }
+
+    double peak = 0;
+    for (uint i = 0; i < histogram->getNumElements(); ++i) {
+        peak = qMax(peak, histogram->getDouble(i));
+    }
+    QString graph;
+    for (uint i = 0; i < histogram->getNumElements(); ++i) {
+        double count = histogram->getDouble(i);
+        // U+2581 to U+2588, lower one eighth block to full block
+        graph.append(count > 0 ? QChar(0x2581 + qMin(7, (int)(8 * count / peak))) : QChar(' '));
+    }
+
+    return QString("%1 / %2 / %3 <tt>%4</tt>")
+           .arg((quint32)stats->getDouble(0)).arg((quint32)stats->getDouble(2)).arg((quint32)stats->getDouble(1))
+           .arg(graph.toHtmlEscaped());
+}
+
+/**
+ * Latency and run time of the callbacks, empty unless the firmware reports CallbackTiming
+ */
+QString SystemHealthGadgetWidget::callbackTimingDescription()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    // CallbackTiming instances follow the CallbackInfo elements
+    QStringList names;
+    UAVObject *callbackInfo = objManager->getObject(QString("CallbackInfo"));
+    if (callbackInfo && callbackInfo->getField("Running")) {
+        names = callbackInfo->getField("Running")->getElementNames();
+    }
+
+    QString rows;
+    foreach(UAVObject * timing, objManager->getObjectInstances(QString("CallbackTiming"))) {
+        UAVObjectField *runs = timing->getField("Runs");
+        if (!runs || runs->getDouble() == 0) {
+            continue;
+        }
+        int id = timing->getInstID();
+        rows.append(QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td></tr>")
+                    .arg(id < names.size() ? names.at(id) : QString::number(id))
+                    .arg((quint32)runs->getDouble())
+                    .arg(callbackDurationText(timing, "Latency"))
+                    .arg(callbackDurationText(timing, "Runtime")));
+    }
+    if (rows.isEmpty()) {
+        return QString();
+    }
+
+    return QString("<h3>%1</h3><table><tr><th>%2</th><th>%3</th><th>%4</th><th>%5</th></tr>%6</table>")
+           .arg(tr("Callback timing"))
+           .arg(tr("Callback"))
+           .arg(tr("Runs"))
+           .arg(tr("Latency us (min / mean / max)"))
+           .arg(tr("Run time us (min / mean / max)"))
+           .arg(rows);
+}
+
 void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint & location)
 {
     QGraphicsScene *graphicsScene = scene();
@@ -284,6 +453,8 @@ void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint & location)
             }
         }
 
+        alarmsText.append(callbackTimingDescription());
+
         // Show alarms text if we have any
         if (alarmsText.length() > 0) {
             QWhatsThis::showText(location, alarmsText);
@@ -39,6 +39,8 @@
 #include <QFile>
 #include <QTimer>
 
+class QTableWidget;
+
 class SystemHealthGadgetWidget : public QGraphicsView {
     Q_OBJECT
 
@@ -56,6 +58,7 @@ protected:
 
 private slots:
     void updateAlarms(UAVObject *systemAlarm); // Called by the systemalarms UAVObject
+    void updateTasks(UAVObject *taskInfo); // Called by the taskinfo UAVObject
     void onAutopilotConnect();
     void onAutopilotDisconnect();
 
@@ -65,10 +68,16 @@ private:
     QGraphicsSvgItem *foreground;
     QGraphicsSvgItem *nolink;
     QStringList *missingElements;
+    // The indicator item of each alarm, by alarm name
+    QHash<QString, QGraphicsSvgItem *> indicators;
+    // Per task stack and cpu load, shown on right click
+    QTableWidget *taskTable;
     // Simple flag to skip rendering if the
     bool fgenabled; // layer does not exist.
 
     void showAlarmDescriptionForItemId(const QString itemId, const QPoint & location);
     void showAllAlarmDescriptions(const QPoint &location);
+    QString callbackTimingDescription();
+    void showTaskTable();
 };
 #endif /* SYSTEMHEALTHGADGETWIDGET_H_ */
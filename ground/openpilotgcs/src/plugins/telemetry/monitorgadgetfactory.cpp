@@ -60,6 +60,8 @@ MonitorWidget *MonitorGadgetFactory::createMonitorWidget(QWidget *parent)
     connect(tm, SIGNAL(connected()), widget, SLOT(telemetryConnected()));
     connect(tm, SIGNAL(disconnected()), widget, SLOT(telemetryDisconnected()));
     connect(tm, SIGNAL(telemetryUpdated(double, double)), widget, SLOT(telemetryUpdated(double, double)));
+    connect(tm, SIGNAL(rxOverrunsUpdated(int)), widget, SLOT(rxOverrunsUpdated(int)));
+    connect(tm, SIGNAL(latencyUpdated(QString, QList<int>)), widget, SLOT(latencyUpdated(QString, QList<int>)));
 
     // and connect widget to connection manager (for retro compatibility)
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
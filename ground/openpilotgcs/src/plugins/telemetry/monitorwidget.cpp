@@ -1,6 +1,7 @@
 #include "monitorwidget.h"
 
 #include <utils/stylehelper.h>
+#include <uavtalk/telemetrymanager.h>
 
 #include <QObject>
 #include <QDebug>
@@ -174,7 +175,8 @@ MonitorWidget::MonitorWidget(QWidget *parent) :
         // scene->setSceneRect(graph->boundingRect());
     }
 
-    connected = false;
+    connected  = false;
+    rxOverruns = 0;
 
     setMin(0.0);
     setMax(1200.0);
@@ -216,6 +218,7 @@ void MonitorWidget::telemetryConnected()
     if (!connected) {
         // flash the lights
         setToolTip(tr("Connected"));
+        rxOverruns = 0;
         telemetryUpdated(maxValue, maxValue);
         connected = true;
     }
@@ -247,7 +250,12 @@ void MonitorWidget::telemetryUpdated(double txRate, double rxRate)
     double rxIndex = (rxRate - minValue) / (maxValue - minValue) * rxNodes.count();
 
     if (connected) {
-        this->setToolTip(QString("Tx: %0 bytes/s, Rx: %1 bytes/s").arg(txRate).arg(rxRate));
+        QString toolTip = QString("Tx: %0 bytes/s, Rx: %1 bytes/s").arg(txRate).arg(rxRate);
+        if (rxOverruns > 0) {
+            toolTip += QString(", Rx overruns: %0").arg(rxOverruns);
+        }
+        toolTip += latencyToolTip();
+        this->setToolTip(toolTip);
     }
 
     for (int i = 0; i < txNodes.count(); i++) {
@@ -287,6 +295,55 @@ void MonitorWidget::telemetryUpdated(double txRate, double rxRate)
     update();
 }
 
+/*!
+   \brief Called with the receive overruns counted by the connection
+
+   The count is shown in the tool tip on the next telemetry update.
+ */
+void MonitorWidget::rxOverrunsUpdated(int overruns)
+{
+    rxOverruns = overruns;
+}
+
+/*!
+   \brief Called with the latency histogram of the connected link
+
+   The histograms are shown in the tool tip on the next telemetry update.
+ */
+void MonitorWidget::latencyUpdated(const QString &link, const QList<int> &histogram)
+{
+    latencies[link] = histogram;
+}
+
+/*!
+   \brief Lines of the tool tip with the share of the packets in each latency bin
+ */
+QString MonitorWidget::latencyToolTip() const
+{
+    QString text;
+
+    foreach(const QString &link, latencies.keys()) {
+        const QList<int> &histogram = latencies[link];
+        int total = 0;
+        foreach(int count, histogram) {
+            total += count;
+        }
+        text += tr("\nLatency of %0, %1 packets").arg(link).arg(total);
+        if (total == 0) {
+            continue;
+        }
+        for (int i = 0; i < histogram.size(); i++) {
+            if (histogram[i] == 0) {
+                continue;
+            }
+            int limit = TelemetryManager::latencyBinLimit(i);
+            QString bin = limit < 0 ? tr(">= %0 ms").arg(TelemetryManager::latencyBinLimit(i - 1)) : tr("< %0 ms").arg(limit);
+            text += QString("\n    %0: %1%").arg(bin).arg(100.0 * histogram[i] / total, 0, 'f', 1);
+        }
+    }
+    return text;
+}
+
 void MonitorWidget::showEvent(QShowEvent *event)
 {
     Q_UNUSED(event);
@@ -7,6 +7,7 @@
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
 #include <QtCore/QPointer>
+#include <QtCore/QMap>
 
 class MonitorWidget : public QGraphicsView {
     Q_OBJECT
@@ -38,6 +39,8 @@ public slots:
     void telemetryConnected();
     void telemetryDisconnected();
     void telemetryUpdated(double txRate, double rxRate);
+    void rxOverrunsUpdated(int overruns);
+    void latencyUpdated(const QString &link, const QList<int> &histogram);
 
 protected:
     void showEvent(QShowEvent *event);
@@ -45,6 +48,9 @@ protected:
 
 private:
     bool connected;
+    int rxOverruns;
+    // latency histogram of each link, kept after it is disconnected
+    QMap<QString, QList<int> > latencies;
 
     double minValue;
     double maxValue;
@@ -58,6 +64,8 @@ private:
     QList<QGraphicsSvgItem *> rxNodes;
 
     Qt::AspectRatioMode aspectRatioMode;
+
+    QString latencyToolTip() const;
 };
 
 #endif // MONITORWIDGET_H
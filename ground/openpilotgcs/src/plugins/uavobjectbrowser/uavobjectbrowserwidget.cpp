@@ -36,6 +36,7 @@
 #include <QVBoxLayout>
 #include <QPushButton>
 #include <QComboBox>
+#include <QScrollBar>
 #include <QtCore/QDebug>
 #include <QItemEditorFactory>
 #include "extensionsystem/pluginmanager.h"
@@ -76,6 +77,15 @@ UAVObjectBrowserWidget::UAVObjectBrowserWidget(QWidget *parent) : QWidget(parent
     connect(m_viewoptions->cbCategorized, SIGNAL(toggled(bool)), this, SLOT(viewOptionsChangedSlot()));
     connect(m_viewoptions->cbDescription, SIGNAL(toggled(bool)), this, SLOT(viewOptionsChangedSlot()));
     connect(m_browser->splitter, SIGNAL(splitterMoved(int, int)), this, SLOT(splitterMoved()));
+
+    // Only the objects in view are refreshed on updates
+    m_visibleObjectsTimer.setSingleShot(true);
+    m_visibleObjectsTimer.setInterval(0);
+    connect(&m_visibleObjectsTimer, SIGNAL(timeout()), this, SLOT(updateVisibleObjects()));
+    connect(m_browser->treeView->verticalScrollBar(), SIGNAL(valueChanged(int)), &m_visibleObjectsTimer, SLOT(start()));
+    connect(m_browser->treeView->verticalScrollBar(), SIGNAL(rangeChanged(int, int)), &m_visibleObjectsTimer, SLOT(start()));
+    connect(m_browser->treeView, SIGNAL(expanded(QModelIndex)), &m_visibleObjectsTimer, SLOT(start()));
+    connect(m_browser->treeView, SIGNAL(collapsed(QModelIndex)), &m_visibleObjectsTimer, SLOT(start()));
     enableSendRequest(false);
 }
 
@@ -123,6 +133,7 @@ void UAVObjectBrowserWidget::categorize(bool categorize)
     m_browser->treeView->setModel(m_model);
     showMetaData(m_viewoptions->cbMetaData->isChecked());
     connect(m_browser->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex, QModelIndex)), this, SLOT(currentChanged(QModelIndex, QModelIndex)), Qt::UniqueConnection);
+    m_visibleObjectsTimer.start();
 
     delete tmpModel;
 }
@@ -139,6 +150,7 @@ void UAVObjectBrowserWidget::useScientificNotation(bool scientific)
     m_browser->treeView->setModel(m_model);
     showMetaData(m_viewoptions->cbMetaData->isChecked());
     connect(m_browser->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex, QModelIndex)), this, SLOT(currentChanged(QModelIndex, QModelIndex)), Qt::UniqueConnection);
+    m_visibleObjectsTimer.start();
 
     delete tmpModel;
 }
@@ -262,6 +274,26 @@ void UAVObjectBrowserWidget::currentChanged(const QModelIndex &current, const QM
     updateDescription();
 }
 
+/**
+ * Hands the object items having a row in view to the model
+ */
+void UAVObjectBrowserWidget::updateVisibleObjects()
+{
+    QTreeView *view = m_browser->treeView;
+    QSet<TreeItem *> visible;
+    int bottom = view->viewport()->height();
+
+    for (QModelIndex index = view->indexAt(QPoint(0, 0)); index.isValid() && view->visualRect(index).top() < bottom; index = view->indexBelow(index)) {
+        // The fields rows make their object, and the parent object of an instance, visible
+        for (TreeItem *item = static_cast<TreeItem *>(index.internalPointer()); item; item = item->parent()) {
+            if (dynamic_cast<ObjectTreeItem *>(item)) {
+                visible.insert(item);
+            }
+        }
+    }
+    m_model->setVisibleObjects(visible);
+}
+
 void UAVObjectBrowserWidget::viewSlot()
 {
     if (m_viewoptionsDialog->isVisible()) {
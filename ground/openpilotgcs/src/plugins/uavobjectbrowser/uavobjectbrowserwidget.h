@@ -30,6 +30,7 @@
 
 #include <QWidget>
 #include <QTreeView>
+#include <QTimer>
 #include "objectpersistence.h"
 #include "uavobjecttreemodel.h"
 
@@ -88,6 +89,7 @@ private slots:
     void viewSlot();
     void viewOptionsChangedSlot();
     void splitterMoved();
+    void updateVisibleObjects();
     QString createObjectDescription(UAVObject *object);
 signals:
     void viewOptionsChanged(bool categorized, bool scientific, bool metadata, bool description);
@@ -106,6 +108,8 @@ private:
     QColor m_manuallyChangedColor;
     bool m_onlyHilightChangedValues;
     QString m_mustacheTemplate;
+    // Coalesces the scrolls and expansions of the tree
+    QTimer m_visibleObjectsTimer;
 
     void updateObjectPersistance(ObjectPersistence::OperationOptions op, UAVObject *obj);
     void enableSendRequest(bool enable);
@@ -31,12 +31,16 @@
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
+#include "uavobjectupdatethrottle.h"
 #include "extensionsystem/pluginmanager.h"
 #include <QColor>
 #include <QtCore/QTimer>
 #include <QtCore/QSignalMapper>
 #include <QtCore/QDebug>
 
+// Repaints of the updated items are collected for this long
+#define DATA_CHANGED_INTERVAL_MS 100
+
 UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool useScientificNotation) :
     QAbstractItemModel(parent),
     m_useScientificFloatNotation(useScientificNotation),
@@ -44,7 +48,9 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool us
     m_recentlyUpdatedTimeout(500), // ms
     m_recentlyUpdatedColor(QColor(255, 230, 230)),
     m_manuallyChangedColor(QColor(230, 230, 255)),
-    m_unknownObjectColor(QColor(Qt::gray))
+    m_unknownObjectColor(QColor(Qt::gray)),
+    m_onlyHilightChangedValues(false),
+    m_visibleObjectsKnown(false)
 {
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -53,8 +59,14 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool us
 
     // Create highlight manager, let it run every 300 ms.
     m_highlightManager = new HighLightManager(300);
+    // Refreshing the tree more than 10 times per second is just wasted effort
+    m_updateThrottle   = new UAVObjectUpdateThrottle(10, this);
+    connect(m_updateThrottle, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(highlightUpdatedObject(UAVObject *)));
     connect(objManager, SIGNAL(newObject(UAVObject *)), this, SLOT(newObject(UAVObject *)));
     connect(objManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(newObject(UAVObject *)));
+    m_dataChangedTimer.setSingleShot(true);
+    m_dataChangedTimer.setInterval(DATA_CHANGED_INTERVAL_MS);
+    connect(&m_dataChangedTimer, SIGNAL(timeout()), this, SLOT(emitDataChanged()));
 
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
     setupModelData(objManager);
@@ -150,25 +162,20 @@ TreeItem *UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
 
 MetaObjectTreeItem *UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(highlightUpdatedObject(UAVObject *)));
+    m_updateThrottle->addObject(obj);
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
     connect(meta, SIGNAL(updateHighlight(TreeItem *)), this, SLOT(updateHighlight(TreeItem *)));
-    foreach(UAVObjectField * field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, meta);
-        } else {
-            addSingleField(0, field, meta);
-        }
-    }
+    m_pendingFields.insert(meta, obj);
+    m_unfetchedData.insert(obj, QByteArray());
     parent->appendChild(meta);
     return meta;
 }
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(highlightUpdatedObject(UAVObject *)));
+    m_updateThrottle->addObject(obj);
     connect(obj, SIGNAL(isKnownChanged(UAVObject *, bool)), this, SLOT(isKnownChanged(UAVObject *, bool)));
     TreeItem *item;
     if (obj->isSingleInstance()) {
@@ -183,13 +190,8 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
         connect(item, SIGNAL(updateIsKnown(TreeItem *)), this, SLOT(updateIsKnown(TreeItem *)));
         parent->appendChild(item);
     }
-    foreach(UAVObjectField * field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, item);
-        } else {
-            addSingleField(0, field, item);
-        }
-    }
+    m_pendingFields.insert(item, obj);
+    m_unfetchedData.insert(obj, QByteArray());
 }
 
 void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
@@ -199,9 +201,7 @@ void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
     item->setHighlightManager(m_highlightManager);
     connect(item, SIGNAL(updateHighlight(TreeItem *)), this, SLOT(updateHighlight(TreeItem *)));
     connect(item, SIGNAL(updateIsKnown(TreeItem *)), this, SLOT(updateIsKnown(TreeItem *)));
-    for (uint i = 0; i < field->getNumElements(); ++i) {
-        addSingleField(i, field, item);
-    }
+    m_pendingElements.insert(item, field);
     parent->appendChild(item);
 }
 
@@ -342,6 +342,70 @@ int UAVObjectTreeModel::columnCount(const QModelIndex &parent) const
     }
 }
 
+bool UAVObjectTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return false;
+    }
+    TreeItem *parentItem = parent.isValid() ? static_cast<TreeItem *>(parent.internalPointer()) : m_rootItem;
+
+    return parentItem->childCount() > 0 || pendingChildCount(parentItem) > 0;
+}
+
+bool UAVObjectTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return false;
+    }
+    return pendingChildCount(static_cast<TreeItem *>(parent.internalPointer())) > 0;
+}
+
+/**
+ * Creates the field items of an object or the element items of an array field,
+ * called by the view when the item is expanded for the first time.
+ */
+void UAVObjectTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!parent.isValid()) {
+        return;
+    }
+    TreeItem *item = static_cast<TreeItem *>(parent.internalPointer());
+    int count = pendingChildCount(item);
+    if (count == 0) {
+        return;
+    }
+
+    beginInsertRows(parent.sibling(parent.row(), 0), item->childCount(), item->childCount() + count - 1);
+    if (m_pendingFields.contains(item)) {
+        UAVObject *obj = m_pendingFields.take(item);
+        m_unfetchedData.remove(obj);
+        foreach(UAVObjectField * field, obj->getFields()) {
+            if (field->getNumElements() > 1) {
+                addArrayField(field, item);
+            } else {
+                addSingleField(0, field, item);
+            }
+        }
+    } else {
+        UAVObjectField *field = m_pendingElements.take(item);
+        for (uint i = 0; i < field->getNumElements(); ++i) {
+            addSingleField(i, field, item);
+        }
+    }
+    endInsertRows();
+}
+
+int UAVObjectTreeModel::pendingChildCount(TreeItem *item) const
+{
+    UAVObject *obj = m_pendingFields.value(item);
+
+    if (obj) {
+        return obj->getFields().count();
+    }
+    UAVObjectField *field = m_pendingElements.value(item);
+    return field ? field->getNumElements() : 0;
+}
+
 QList<QModelIndex> UAVObjectTreeModel::getMetaDataIndexes()
 {
     QList<QModelIndex> metaIndexes;
@@ -449,14 +513,85 @@ void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
     Q_ASSERT(obj);
     ObjectTreeItem *item = findObjectTreeItem(obj);
     Q_ASSERT(item);
-    if (!m_onlyHilightChangedValues) {
+    if (m_visibleObjectsKnown && !m_visibleObjects.contains(item)) {
+        // Nobody sees it, refresh it once it is scrolled into view
+        m_staleObjects.insert(item);
+        return;
+    }
+    refreshObject(item, obj);
+}
+
+void UAVObjectTreeModel::refreshObject(ObjectTreeItem *item, UAVObject *obj)
+{
+    bool highlight = !m_onlyHilightChangedValues;
+
+    if (!highlight && m_unfetchedData.contains(obj)) {
+        // Without field items only the object data tells whether a value changed
+        QByteArray data(obj->getNumBytes(), 0);
+        obj->pack((quint8 *)data.data());
+        QByteArray &last = m_unfetchedData[obj];
+        highlight = !last.isNull() && last != data;
+        last = data;
+    }
+    if (highlight) {
         item->setHighlight(true);
+        markDirty(item);
     }
     item->update();
-    if (!m_onlyHilightChangedValues) {
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+}
+
+void UAVObjectTreeModel::setVisibleObjects(const QSet<TreeItem *> &visible)
+{
+    m_visibleObjectsKnown = true;
+    m_visibleObjects = visible;
+
+    QMutableSetIterator<ObjectTreeItem *> iter(m_staleObjects);
+    while (iter.hasNext()) {
+        ObjectTreeItem *item = iter.next();
+        if (m_visibleObjects.contains(item)) {
+            item->update();
+            markDirty(item);
+            iter.remove();
+        }
+    }
+}
+
+void UAVObjectTreeModel::markDirty(TreeItem *item)
+{
+    m_dirtyItems.insert(item);
+    if (!m_dataChangedTimer.isActive()) {
+        m_dataChangedTimer.start();
+    }
+}
+
+/**
+ * Emits the changes collected since the last tick, one range of rows per parent
+ */
+void UAVObjectTreeModel::emitDataChanged()
+{
+    QHash<TreeItem *, QPair<int, int> > ranges;
+
+    foreach(TreeItem * item, m_dirtyItems) {
+        TreeItem *parent = item->parent();
+        if (!parent) {
+            continue;
+        }
+        int row = item->row();
+        QHash<TreeItem *, QPair<int, int> >::iterator range = ranges.find(parent);
+        if (range == ranges.end()) {
+            ranges.insert(parent, qMakePair(row, row));
+        } else {
+            range->first  = qMin(range->first, row);
+            range->second = qMax(range->second, row);
+        }
+    }
+    m_dirtyItems.clear();
+
+    int lastColumn = m_rootItem->columnCount() - 1;
+    for (QHash<TreeItem *, QPair<int, int> >::const_iterator range = ranges.constBegin(); range != ranges.constEnd(); ++range) {
+        TreeItem *parent = range.key();
+        emit dataChanged(createIndex(range->first, 0, parent->getChild(range->first)),
+                         createIndex(range->second, lastColumn, parent->getChild(range->second)));
     }
 }
 
@@ -492,18 +627,12 @@ MetaObjectTreeItem *UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::DATA_COLUMN));
+    markDirty(item);
 }
 
 void UAVObjectTreeModel::updateIsKnown(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::TITLE_COLUMN));
+    markDirty(item);
 }
 
 void UAVObjectTreeModel::isKnownChanged(UAVObject *object, bool isKnown)
@@ -32,6 +32,9 @@
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QHash>
+#include <QtCore/QTimer>
 #include <QColor>
 
 class TopTreeItem;
@@ -44,6 +47,7 @@ class UAVObjectField;
 class UAVObjectManager;
 class QSignalMapper;
 class QTimer;
+class UAVObjectUpdateThrottle;
 
 class UAVObjectTreeModel : public QAbstractItemModel {
     Q_OBJECT
@@ -61,6 +65,9 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
 
     void setUnknowObjectColor(QColor color)
     {
@@ -86,6 +93,9 @@ public:
 
     QList<QModelIndex> getMetaDataIndexes();
 
+    // The object items shown by the view, the others are refreshed once they are scrolled into view
+    void setVisibleObjects(const QSet<TreeItem *> &visible);
+
 signals:
 
 public slots:
@@ -96,6 +106,7 @@ private slots:
     void updateIsKnown(TreeItem *item);
     void highlightUpdatedObject(UAVObject *obj);
     void isKnownChanged(UAVObject *object, bool isKnown);
+    void emitDataChanged();
 
 private:
     void setupModelData(UAVObjectManager *objManager);
@@ -107,6 +118,9 @@ private:
     void addInstance(UAVObject *obj, TreeItem *parent);
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
+    int pendingChildCount(TreeItem *item) const;
+    void refreshObject(ObjectTreeItem *item, UAVObject *obj);
+    void markDirty(TreeItem *item);
 
     QString updateMode(quint8 updateMode);
     ObjectTreeItem *findObjectTreeItem(UAVObject *obj);
@@ -126,6 +140,25 @@ private:
 
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
+
+    // Rate limits object updates handed to the tree
+    UAVObjectUpdateThrottle *m_updateThrottle;
+
+    // Children are created when the view first expands their parent,
+    // the fields of an object item and the elements of an array field
+    QHash<TreeItem *, UAVObject *> m_pendingFields;
+    QHash<TreeItem *, UAVObjectField *> m_pendingElements;
+    // Last data of the objects without field items, to highlight changes only
+    QHash<UAVObject *, QByteArray> m_unfetchedData;
+
+    // Updates of objects out of view are deferred
+    bool m_visibleObjectsKnown;
+    QSet<TreeItem *> m_visibleObjects;
+    QSet<ObjectTreeItem *> m_staleObjects;
+
+    // Items to repaint, one dataChanged per parent and refresh tick
+    QSet<TreeItem *> m_dirtyItems;
+    QTimer m_dataChangedTimer;
 };
 
 #endif // UAVOBJECTTREEMODEL_H
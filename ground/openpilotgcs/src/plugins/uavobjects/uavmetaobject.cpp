@@ -94,6 +94,7 @@ void UAVMetaObject::setData(const Metadata & mdata)
     QMutexLocker locker(mutex);
 
     parentMetadata = mdata;
+    updateTime     = currentTime();
     emit objectUpdatedAuto(this); // trigger object updated event
     emit objectUpdated(this);
 }
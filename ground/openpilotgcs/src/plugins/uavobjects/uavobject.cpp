@@ -32,6 +32,8 @@
 #include <QtEndian>
 #include <QDebug>
 #include <QtWidgets>
+#include <QDateTime>
+#include <QElapsedTimer>
 
 using namespace Utils;
 
@@ -48,6 +50,17 @@ using namespace Utils;
 // Macros
 #define SET_BITS(var, shift, value, mask) var = (var & ~(mask << shift)) | (value << shift);
 
+// The wall clock at load time, then a monotonic timer
+static struct MonotonicClock {
+    qint64 epochMs;
+    QElapsedTimer timer;
+    MonotonicClock()
+    {
+        epochMs = QDateTime::currentMSecsSinceEpoch();
+        timer.start();
+    }
+} monotonicClock;
+
 /**
  * Constructor
  * @param objID The object ID
@@ -62,6 +75,7 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString & name)
     this->name         = name;
     this->data         = 0;
     this->numBytes     = 0;
+    this->updateTime   = currentTime();
     this->mutex        = new QMutex(QMutex::Recursive);
     m_isKnown = false;
 }
@@ -204,6 +218,9 @@ void UAVObject::requestUpdateAll()
  */
 void UAVObject::updated()
 {
+    mutex->lock();
+    updateTime = currentTime();
+    mutex->unlock();
     emit objectUpdatedManual(this);
     emit objectUpdated(this);
 }
@@ -273,6 +290,20 @@ QList<UAVObjectField *> UAVObject::getFields()
     return fields;
 }
 
+/**
+ * Check all the fields against their limits for a board
+ * @returns false as soon as an element is out of its limits
+ */
+bool UAVObject::isWithinLimits(int board)
+{
+    foreach(UAVObjectField * field, getFields()) {
+        if (!field->isWithinLimits(board)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Get a specific field
  * @returns The field or NULL if not found
@@ -300,12 +331,18 @@ UAVObjectField *UAVObject::getField(const QString & name)
 qint32 UAVObject::pack(quint8 *dataOut)
 {
     QMutexLocker locker(mutex);
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // The fields are stored in the packed layout, which is little endian
+    memcpy(dataOut, data, numBytes);
+#else
     qint32 offset = 0;
 
     for (int n = 0; n < fields.length(); ++n) {
         fields[n]->pack(&dataOut[offset]);
         offset += fields[n]->getNumBytes();
     }
+#endif
     return numBytes;
 }
 
@@ -314,14 +351,35 @@ qint32 UAVObject::pack(quint8 *dataOut)
  * @returns The number of bytes copied
  */
 qint32 UAVObject::unpack(const quint8 *dataIn)
+{
+    return unpack(dataIn, currentTime());
+}
+
+/**
+ * Unpack the object data from a byte array
+ * @param updateTime Time of the data, see currentTime()
+ * @returns The number of bytes copied
+ */
+qint32 UAVObject::unpack(const quint8 *dataIn, double updateTime)
 {
     QMutexLocker locker(mutex);
+
+    this->updateTime = updateTime;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // The fields are stored in the packed layout, which is little endian
+    memcpy(data, dataIn, numBytes);
+#else
     qint32 offset = 0;
 
     for (int n = 0; n < fields.length(); ++n) {
         fields[n]->unpack(&dataIn[offset]);
         offset += fields[n]->getNumBytes();
     }
+#endif
+    // Emit unlocked, the slots directly connected in the telemetry thread
+    // would otherwise keep the GUI readers of the object waiting
+    locker.unlock();
     emit objectUnpacked(this); // trigger object updated event
     emit objectUpdated(this);
 
@@ -572,6 +630,24 @@ void UAVObject::toJson(QJsonObject &jsonObject)
     jsonObject["fields"] = jSonFields;
 }
 
+/**
+ * Write the object to a JSON stream, same layout as toJson(QJsonObject &)
+ */
+void UAVObject::toJson(UAVObjectJsonWriter *jsonWriter)
+{
+    jsonWriter->writeStartObject();
+    jsonWriter->writeValue("name", getName());
+    jsonWriter->writeValue("setting", isSettingsObject());
+    jsonWriter->writeValue("id", QString("%1").arg(getObjID(), 1, 16).toUpper());
+    jsonWriter->writeValue("instance", (int)getInstID());
+    jsonWriter->writeStartArray("fields");
+    foreach(UAVObjectField * field, fields) {
+        field->toJson(jsonWriter);
+    }
+    jsonWriter->writeEndArray();
+    jsonWriter->writeEndObject();
+}
+
 void UAVObject::fromJson(const QJsonObject &jsonObject)
 {
     if (jsonObject["name"].toString() == getName() &&
@@ -604,6 +680,24 @@ void UAVObject::emitNewInstance(UAVObject *obj)
     emit newInstance(obj);
 }
 
+/**
+ * Time of the last update of the object data, in seconds since the epoch
+ */
+double UAVObject::getUpdateTime() const
+{
+    QMutexLocker locker(mutex);
+
+    return updateTime;
+}
+
+/**
+ * Seconds since the epoch, unlike the wall clock it never goes back
+ */
+double UAVObject::currentTime()
+{
+    return (monotonicClock.epochMs + monotonicClock.timer.nsecsElapsed() / 1000000.0) / 1000.0;
+}
+
 bool UAVObject::isKnown() const
 {
     QMutexLocker locker(mutex);
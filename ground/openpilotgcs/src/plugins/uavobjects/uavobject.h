@@ -40,6 +40,7 @@
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QJsonObject>
+#include "uavobjectjson.h"
 
 #include "uavobjectfield.h"
 
@@ -114,6 +115,8 @@ public:
     quint32 getNumBytes();
     qint32 pack(quint8 *dataOut);
     qint32 unpack(const quint8 *dataIn);
+    qint32 unpack(const quint8 *dataIn, double updateTime);
+    double getUpdateTime() const;
     quint8 updateCRC(quint8 crc = 0);
     bool save();
     bool save(QFile & file);
@@ -129,6 +132,7 @@ public:
     qint32 getNumFields();
     QList<UAVObjectField *> getFields();
     UAVObjectField *getField(const QString & name);
+    bool isWithinLimits(int board = 0);
     QString toString();
     QString toStringBrief();
     QString toStringData();
@@ -138,6 +142,7 @@ public:
 
     void toJson(QJsonObject &jsonObject);
     void fromJson(const QJsonObject &jsonObject);
+    void toJson(UAVObjectJsonWriter *jsonWriter);
 
     void emitTransactionCompleted(bool success);
     void emitNewInstance(UAVObject *);
@@ -145,6 +150,9 @@ public:
     bool isKnown() const;
     void setIsKnown(bool isKnown);
 
+    // Seconds since the epoch, from a monotonic clock
+    static double currentTime();
+
     virtual bool isSettingsObject();
     virtual bool isDataObject();
     virtual bool isMetaDataObject();
@@ -191,6 +199,8 @@ protected:
     QString description;
     QString category;
     quint32 numBytes;
+    // Time of the sample held, set by the telemetry for the received data
+    double updateTime;
     QMutex *mutex;
     quint8 *data;
     QList<UAVObjectField *> fields;
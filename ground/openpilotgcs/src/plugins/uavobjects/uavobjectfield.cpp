@@ -28,8 +28,55 @@
 #include "uavobjectfield.h"
 #include <QtEndian>
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <limits>
 #include <QtWidgets>
 
+namespace {
+template<typename T>
+double elementToDouble(const quint8 *fieldData, quint32 index)
+{
+    T value;
+
+    memcpy(&value, &fieldData[sizeof(T) * index], sizeof(T));
+    return value;
+}
+
+double bitfieldToDouble(const quint8 *fieldData, quint32 index)
+{
+    return (fieldData[index / 8] >> (index % 8)) & 1;
+}
+
+// Strings and limits of a generated field, built once for all its instances
+typedef struct {
+    QString name;
+    QString description;
+    QString units;
+    QStringList elementNames;
+    QStringList options;
+    QHash<QString, int> optionIndexes;
+    bool limitsParsed;
+    QMap<quint32, QList<UAVObjectField::LimitStruct> > limits;
+    QVector<QVector<UAVObjectField::CompiledLimit> > compiledLimits;
+} SharedFieldInfo;
+
+QHash<const UAVObjectField::FieldInfo *, SharedFieldInfo> sharedFieldInfos;
+QMutex sharedFieldInfosMutex;
+
+// Index of each option, the first one wins like QStringList::indexOf()
+QHash<QString, int> optionIndexesOf(const QStringList &options)
+{
+    QHash<QString, int> indexes;
+
+    indexes.reserve(options.length());
+    for (int n = options.length() - 1; n >= 0; --n) {
+        indexes.insert(options.at(n), n);
+    }
+    return indexes;
+}
+}
+
 UAVObjectField::UAVObjectField(const QString & name, const QString & description, const QString & units, FieldType type, quint32 numElements, const QStringList & options, const QString &limits)
 {
     QStringList elementNames;
@@ -40,11 +87,40 @@ UAVObjectField::UAVObjectField(const QString & name, const QString & description
     }
     // Initialize
     constructorInitialize(name, description, units, type, elementNames, options, limits);
+    optionIndexes = optionIndexesOf(this->options);
 }
 
 UAVObjectField::UAVObjectField(const QString & name, const QString & description, const QString & units, FieldType type, const QStringList & elementNames, const QStringList & options, const QString &limits)
 {
     constructorInitialize(name, description, units, type, elementNames, options, limits);
+    optionIndexes = optionIndexesOf(this->options);
+}
+
+UAVObjectField::UAVObjectField(const FieldInfo *info, const char *context)
+{
+    QMutexLocker locker(&sharedFieldInfosMutex);
+    QHash<const FieldInfo *, SharedFieldInfo>::iterator shared = sharedFieldInfos.find(info);
+
+    if (shared == sharedFieldInfos.end()) {
+        SharedFieldInfo strings;
+        strings.name  = QString::fromLatin1(info->name);
+        // Translated once, not for every instance and clone of the object
+        strings.description = QCoreApplication::translate(context, info->description);
+        strings.units = QString::fromLatin1(info->units);
+        for (quint32 n = 0; n < info->numElements; ++n) {
+            strings.elementNames.append(info->elementNames ? QString::fromLatin1(info->elementNames[n]) : QString::number(n));
+        }
+        for (quint32 n = 0; n < info->numOptions; ++n) {
+            strings.options.append(QString::fromLatin1(info->options[n]));
+        }
+        strings.optionIndexes = optionIndexesOf(strings.options);
+        strings.limitsParsed  = false;
+        shared = sharedFieldInfos.insert(info, strings);
+    }
+    // The string lists are implicitly shared, the limits are parsed on first use
+    constructorInitialize(shared->name, shared->description, shared->units, info->type, shared->elementNames, shared->options, QString());
+    this->optionIndexes = shared->optionIndexes;
+    this->info = info;
 }
 
 void UAVObjectField::constructorInitialize(const QString & name, const QString & description, const QString & units, FieldType type, const QStringList & elementNames, const QStringList & options, const QString &limits)
@@ -59,35 +135,47 @@ void UAVObjectField::constructorInitialize(const QString & name, const QString &
     this->offset       = 0;
     this->data         = NULL;
     this->obj = NULL;
+    this->toDouble     = NULL;
     this->elementNames = elementNames;
+    this->info         = NULL;
+    this->limitsString = limits;
+    this->limitsParsed = false;
     // Set field size
     switch (type) {
     case INT8:
         numBytesPerElement = sizeof(qint8);
+        toDouble = &elementToDouble<qint8>;
         break;
     case INT16:
         numBytesPerElement = sizeof(qint16);
+        toDouble = &elementToDouble<qint16>;
         break;
     case INT32:
         numBytesPerElement = sizeof(qint32);
+        toDouble = &elementToDouble<qint32>;
         break;
     case UINT8:
         numBytesPerElement = sizeof(quint8);
+        toDouble = &elementToDouble<quint8>;
         break;
     case UINT16:
         numBytesPerElement = sizeof(quint16);
+        toDouble = &elementToDouble<quint16>;
         break;
     case UINT32:
         numBytesPerElement = sizeof(quint32);
+        toDouble = &elementToDouble<quint32>;
         break;
     case FLOAT32:
         numBytesPerElement = sizeof(quint32);
+        toDouble = &elementToDouble<float>;
         break;
     case ENUM:
         numBytesPerElement = sizeof(quint8);
         break;
     case BITFIELD:
         numBytesPerElement = sizeof(quint8);
+        toDouble = &bitfieldToDouble;
         this->options = QStringList() << tr("0") << tr("1");
         break;
     case STRING:
@@ -96,7 +184,38 @@ void UAVObjectField::constructorInitialize(const QString & name, const QString &
     default:
         numBytesPerElement = 0;
     }
-    limitsInitialize(limits);
+}
+
+/**
+ * Returns the limits of the elements, parsed on first use. The limits of the
+ * generated fields are only parsed once for all the instances.
+ */
+const QMap<quint32, QList<UAVObjectField::LimitStruct> > &UAVObjectField::limits()
+{
+    if (limitsParsed) {
+        return elementLimits;
+    }
+    limitsParsed = true;
+
+    if (!info) {
+        limitsInitialize(limitsString);
+        limitsCompile();
+        return elementLimits;
+    }
+
+    QMutexLocker locker(&sharedFieldInfosMutex);
+    SharedFieldInfo &shared = sharedFieldInfos[info];
+    if (!shared.limitsParsed) {
+        limitsInitialize(QString::fromLatin1(info->limits));
+        limitsCompile();
+        shared.limits = elementLimits;
+        shared.compiledLimits = compiledLimits;
+        shared.limitsParsed = true;
+    } else {
+        elementLimits  = shared.limits;
+        compiledLimits = shared.compiledLimits;
+    }
+    return elementLimits;
 }
 
 void UAVObjectField::limitsInitialize(const QString &limits)
@@ -133,6 +252,7 @@ void UAVObjectField::limitsInitialize(const QString &limits)
             }
             QStringList valuesPerElement = _str.split(":");
             LimitStruct lstruc;
+            lstruc.type = UNDEFINED;
             bool startFlag    = valuesPerElement.at(0).startsWith("%");
             bool maxIndexFlag = (int)(index) < (int)numElements;
             bool elemNumberSizeFlag = valuesPerElement.at(0).size() == 3;
@@ -210,268 +330,237 @@ void UAVObjectField::limitsInitialize(const QString &limits)
     // }
     // }
 }
-bool UAVObjectField::isWithinLimits(QVariant var, quint32 index, int board)
+
+/**
+ * Compile the parsed limits into typed rules, so that a check only converts
+ * the value once and compares it to the intervals or the option set.
+ */
+void UAVObjectField::limitsCompile()
 {
-    if (!elementLimits.keys().contains(index)) {
-        return true;
-    }
+    compiledLimits.clear();
+    compiledLimits.resize(numElements);
 
-    foreach(LimitStruct struc, elementLimits.value(index)) {
-        if ((struc.board != board) && board != 0 && struc.board != 0) {
+    QMap<quint32, QList<LimitStruct> >::const_iterator element;
+    for (element = elementLimits.constBegin(); element != elementLimits.constEnd(); ++element) {
+        if (element.key() >= numElements) {
             continue;
         }
-        switch (struc.type) {
-        case EQUAL:
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toInt() == vars.toInt()) {
-                        return true;
+        foreach(const LimitStruct &limit, element.value()) {
+            CompiledLimit rule;
+            rule.type  = limit.type;
+            rule.board = limit.board;
+            rule.min   = -std::numeric_limits<double>::infinity();
+            rule.max   = std::numeric_limits<double>::infinity();
+
+            switch (limit.type) {
+            case EQUAL:
+            case NOT_EQUAL:
+                if (type == ENUM) {
+                    rule.optionSet.resize(options.length());
+                    foreach(const QVariant &value, limit.values) {
+                        int option = optionIndex(value.toString());
+                        if (option >= 0) {
+                            rule.optionSet.setBit(option);
+                        }
                     }
-                }
-                return false;
-
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toUInt() == vars.toUInt()) {
-                        return true;
+                } else if (type == STRING) {
+                    foreach(const QVariant &value, limit.values) {
+                        rule.strings.append(value.toString());
                     }
-                }
-                return false;
-
-                break;
-            case ENUM:
-            case STRING:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toString() == vars.toString()) {
-                        return true;
+                } else {
+                    foreach(const QVariant &value, limit.values) {
+                        rule.values.append(toLimitValue(value));
                     }
                 }
-                return false;
-
                 break;
-            case FLOAT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toFloat() == vars.toFloat()) {
-                        return true;
-                    }
+            case BETWEEN:
+                if (limit.values.length() < 2) {
+                    qDebug() << __FUNCTION__ << "between limit with less than 1 pair, aborting; field:" << name;
+                    rule.type = UNDEFINED;
+                    break;
                 }
-                return false;
-
-                break;
-            default:
-                return true;
-            }
-            break;
-        case NOT_EQUAL:
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toInt() == vars.toInt()) {
-                        return false;
-                    }
+                if (limit.values.length() > 2) {
+                    qDebug() << __FUNCTION__ << "between limit with more than 1 pair, using first; field" << name;
                 }
-                return true;
-
+                rule.min = toLimitValue(limit.values.at(0));
+                rule.max = toLimitValue(limit.values.at(1));
                 break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toUInt() == vars.toUInt()) {
-                        return false;
-                    }
+            case BIGGER:
+            case SMALLER:
+                if (limit.values.length() < 1) {
+                    qDebug() << __FUNCTION__ << "BIGGER or SMALLER limit with less than 1 value, aborting; field:" << name;
+                    rule.type = UNDEFINED;
+                    break;
                 }
-                return true;
-
-                break;
-            case ENUM:
-            case STRING:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toString() == vars.toString()) {
-                        return false;
-                    }
+                if (limit.values.length() > 1) {
+                    qDebug() << __FUNCTION__ << "BIGGER or SMALLER limit with more than 1 value, using first; field" << name;
                 }
-                return true;
-
-                break;
-            case FLOAT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toFloat() == vars.toFloat()) {
-                        return false;
-                    }
+                if (limit.type == BIGGER) {
+                    rule.min = toLimitValue(limit.values.at(0));
+                } else {
+                    rule.max = toLimitValue(limit.values.at(0));
                 }
-                return true;
-
                 break;
             default:
-                return true;
+                rule.type = UNDEFINED;
             }
-            break;
-        case BETWEEN:
-            if (struc.values.length() < 2) {
-                qDebug() << __FUNCTION__ << "between limit with less than 1 pair, aborting; field:" << name;
-                return true;
-            }
-            if (struc.values.length() > 2) {
-                qDebug() << __FUNCTION__ << "between limit with more than 1 pair, using first; field" << name;
+            // The strings have no order and the unknown types no limits
+            if ((type == STRING && rule.type != EQUAL && rule.type != NOT_EQUAL) || (!isNumeric() && type != ENUM && type != STRING)) {
+                rule.type = UNDEFINED;
             }
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                if (!(var.toInt() >= struc.values.at(0).toInt() && var.toInt() <= struc.values.at(1).toInt())) {
-                    return false;
-                }
-                return true;
-
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                if (!(var.toUInt() >= struc.values.at(0).toUInt() && var.toUInt() <= struc.values.at(1).toUInt())) {
-                    return false;
-                }
-                return true;
-
-                break;
-            case ENUM:
-                if (!(options.indexOf(var.toString()) >= options.indexOf(struc.values.at(0).toString()) && options.indexOf(var.toString()) <= options.indexOf(struc.values.at(1).toString()))) {
-                    return false;
-                }
-                return true;
+            compiledLimits[element.key()].append(rule);
+        }
+    }
+}
 
-                break;
-            case STRING:
-                return true;
+/**
+ * Convert a value to the domain of the compiled limits, the enum options are
+ * converted to their index, -1 when not found
+ */
+double UAVObjectField::toLimitValue(const QVariant &var)
+{
+    switch (type) {
+    case INT8:
+    case INT16:
+    case INT32:
+        return var.toInt();
 
-                break;
-            case FLOAT32:
-                if (!(var.toFloat() >= struc.values.at(0).toFloat() && var.toFloat() <= struc.values.at(1).toFloat())) {
-                    return false;
-                }
-                return true;
+    case UINT8:
+    case UINT16:
+    case UINT32:
+    case BITFIELD:
+        return var.toUInt();
 
-                break;
-            default:
-                return true;
-            }
-            break;
-        case BIGGER:
-            if (struc.values.length() < 1) {
-                qDebug() << __FUNCTION__ << "BIGGER limit with less than 1 value, aborting; field:" << name;
-                return true;
-            }
-            if (struc.values.length() > 1) {
-                qDebug() << __FUNCTION__ << "BIGGER limit with more than 1 value, using first; field" << name;
-            }
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                if (!(var.toInt() >= struc.values.at(0).toInt())) {
-                    return false;
-                }
-                return true;
+    case FLOAT32:
+        return var.toFloat();
 
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                if (!(var.toUInt() >= struc.values.at(0).toUInt())) {
-                    return false;
-                }
-                return true;
+    case ENUM:
+        return optionIndex(var.toString());
 
-                break;
-            case ENUM:
-                if (!(options.indexOf(var.toString()) >= options.indexOf(struc.values.at(0).toString()))) {
-                    return false;
-                }
-                return true;
+    default:
+        return 0.0;
+    }
+}
 
-                break;
-            case STRING:
-                return true;
+/**
+ * Index of an enum option, -1 when not found
+ */
+int UAVObjectField::optionIndex(const QString &option) const
+{
+    return optionIndexes.value(option, -1);
+}
 
-                break;
-            case FLOAT32:
-                if (!(var.toFloat() >= struc.values.at(0).toFloat())) {
-                    return false;
-                }
-                return true;
+/**
+ * Check a converted value against the compiled limits of an element,
+ * the first rule applying to the board decides
+ */
+bool UAVObjectField::isWithinCompiledLimits(quint32 index, double value, const QString &text, int board)
+{
+    if (index >= (quint32)compiledLimits.size()) {
+        return true;
+    }
 
-                break;
-            default:
-                return true;
+    const QVector<CompiledLimit> &rules = compiledLimits.at(index);
+    for (int n = 0; n < rules.size(); ++n) {
+        const CompiledLimit &rule = rules.at(n);
+        if ((rule.board != board) && board != 0 && rule.board != 0) {
+            continue;
+        }
+        switch (rule.type) {
+        case EQUAL:
+        case NOT_EQUAL:
+        {
+            bool found;
+            if (type == ENUM) {
+                found = value >= 0 && value < rule.optionSet.size() && rule.optionSet.testBit((int)value);
+            } else if (type == STRING) {
+                found = rule.strings.contains(text);
+            } else {
+                found = rule.values.contains(value);
             }
-            break;
+            return found == (rule.type == EQUAL);
+        }
+        case BETWEEN:
+        case BIGGER:
         case SMALLER:
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                if (!(var.toInt() <= struc.values.at(0).toInt())) {
-                    return false;
-                }
-                return true;
+            return value >= rule.min && value <= rule.max;
 
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                if (!(var.toUInt() <= struc.values.at(0).toUInt())) {
-                    return false;
-                }
-                return true;
+        default:
+            return true;
+        }
+    }
+    return true;
+}
 
-                break;
-            case ENUM:
-                if (!(options.indexOf(var.toString()) <= options.indexOf(struc.values.at(0).toString()))) {
-                    return false;
-                }
-                return true;
+bool UAVObjectField::isWithinLimits(QVariant var, quint32 index, int board)
+{
+    limits();
+    if (type == STRING) {
+        return isWithinCompiledLimits(index, 0.0, var.toString(), board);
+    }
+    return isWithinCompiledLimits(index, toLimitValue(var), QString(), board);
+}
 
-                break;
-            case STRING:
-                return true;
+/**
+ * Check all the elements of the field against their limits, the values
+ * are read from the object data without the conversion to QVariant
+ */
+bool UAVObjectField::isWithinLimits(int board)
+{
+    if (limits().isEmpty()) {
+        return true;
+    }
+    if (type == STRING) {
+        for (quint32 index = 0; index < numElements; ++index) {
+            if (!isWithinLimits(getValue(index), index, board)) {
+                return false;
+            }
+        }
+        return true;
+    }
 
-                break;
-            case FLOAT32:
-                if (!(var.toFloat() <= struc.values.at(0).toFloat())) {
-                    return false;
-                }
-                return true;
+    QMutexLocker locker(obj->getMutex());
 
-                break;
-            default:
-                return true;
-            }
-        default:
-            return true;
+    for (quint32 index = 0; index < numElements; ++index) {
+        double value;
+        if (type == ENUM) {
+            // Same fallback to the first option as getValue()
+            quint8 option = data[offset + index];
+            value = option < options.length() ? option : 0;
+        } else if (toDouble) {
+            value = toDouble(&data[offset], index);
+        } else {
+            continue;
+        }
+        if (!isWithinCompiledLimits(index, value, QString(), board)) {
+            return false;
         }
     }
     return true;
 }
 
+/**
+ * Returns the options of an element allowed by its limits
+ */
+QStringList UAVObjectField::getOptionsWithinLimits(quint32 index, int board)
+{
+    QStringList allowed;
+
+    limits();
+    for (int option = 0; option < options.length(); ++option) {
+        if (isWithinCompiledLimits(index, type == ENUM ? option : toLimitValue(options.at(option)), options.at(option), board)) {
+            allowed.append(options.at(option));
+        }
+    }
+    return allowed;
+}
+
 QString UAVObjectField::getLimitsAsString(quint32 index, int board)
 {
     QString limitString;
 
-    if (elementLimits.keys().contains(index)) {
-        foreach(LimitStruct struc, elementLimits.value(index)) {
+    if (limits().contains(index)) {
+        foreach(LimitStruct struc, limits().value(index)) {
             if ((struc.board != board) && board != 0 && struc.board != 0) {
                 continue;
             }
@@ -520,10 +609,10 @@ QString UAVObjectField::getLimitsAsString(quint32 index, int board)
 
 QVariant UAVObjectField::getMaxLimit(quint32 index, int board)
 {
-    if (!elementLimits.keys().contains(index)) {
+    if (!limits().contains(index)) {
         return QVariant();
     }
-    foreach(LimitStruct struc, elementLimits.value(index)) {
+    foreach(LimitStruct struc, limits().value(index)) {
         if ((struc.board != board) && board != 0 && struc.board != 0) {
             continue;
         }
@@ -547,10 +636,10 @@ QVariant UAVObjectField::getMaxLimit(quint32 index, int board)
 }
 QVariant UAVObjectField::getMinLimit(quint32 index, int board)
 {
-    if (!elementLimits.keys().contains(index)) {
+    if (!limits().contains(index)) {
         return QVariant();
     }
-    foreach(LimitStruct struc, elementLimits.value(index)) {
+    foreach(LimitStruct struc, limits().value(index)) {
         if ((struc.board != board) && board != 0 && struc.board != 0) {
             return QVariant();
         }
@@ -753,6 +842,36 @@ void UAVObjectField::toJson(QJsonObject &jsonObject)
     jsonObject["values"] = values;
 }
 
+/**
+ * Write the field to a JSON stream, the numeric elements are converted
+ * straight from the object data
+ */
+void UAVObjectField::toJson(UAVObjectJsonWriter *jsonWriter)
+{
+    jsonWriter->writeStartObject();
+    jsonWriter->writeValue("name", name);
+    jsonWriter->writeValue("type", getTypeAsString());
+    jsonWriter->writeValue("unit", units);
+    jsonWriter->writeStartArray("values");
+
+    QMutexLocker locker(obj->getMutex());
+    for (quint32 n = 0; n < numElements; ++n) {
+        jsonWriter->writeStartObject();
+        jsonWriter->writeValue("name", elementNames.at(n));
+        if (toDouble) {
+            jsonWriter->writeValue("value", toDouble(&data[offset], n));
+        } else if (type == ENUM) {
+            quint8 option = data[offset + n];
+            jsonWriter->writeValue("value", options.value(option < options.length() ? option : 0));
+        } else {
+            jsonWriter->writeValue("value", getValue(n).toString());
+        }
+        jsonWriter->writeEndObject();
+    }
+    jsonWriter->writeEndArray();
+    jsonWriter->writeEndObject();
+}
+
 void UAVObjectField::fromJson(const QJsonObject &jsonObject)
 {
     Q_ASSERT(jsonObject["name"].toString() == getName());
@@ -1076,7 +1195,7 @@ bool UAVObjectField::checkValue(const QVariant & value, quint32 index)
             break;
         case ENUM:
         {
-            qint8 tmpenum = options.indexOf(value.toString());
+            qint8 tmpenum = optionIndex(value.toString());
             return (tmpenum < 0) ? false : true;
 
             break;
@@ -1147,7 +1266,7 @@ void UAVObjectField::setValue(const QVariant & value, quint32 index)
         }
         case ENUM:
         {
-            qint8 tmpenum = options.indexOf(value.toString());
+            qint8 tmpenum = optionIndex(value.toString());
             // Default to 0 on invalid values.
             if (tmpenum < 0) {
                 tmpenum = 0;
@@ -1180,7 +1299,41 @@ void UAVObjectField::setValue(const QVariant & value, quint32 index)
 
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    if (toDouble == NULL) {
+        // Text fields go through their string representation
+        return getValue(index).toDouble();
+    }
+
+    QMutexLocker locker(obj->getMutex());
+
+    // Check that index is not out of bounds
+    if (index >= numElements) {
+        return 0.0;
+    }
+    return toDouble(&data[offset], index);
+}
+
+/**
+ * Copy the field elements as doubles, without going through QVariant for numeric fields.
+ * @returns The number of elements copied
+ */
+quint32 UAVObjectField::copyElements(double *dataOut, quint32 maxElements)
+{
+    quint32 count = qMin(numElements, maxElements);
+
+    if (toDouble == NULL) {
+        for (quint32 index = 0; index < count; ++index) {
+            dataOut[index] = getValue(index).toDouble();
+        }
+        return count;
+    }
+
+    QMutexLocker locker(obj->getMutex());
+
+    for (quint32 index = 0; index < count; ++index) {
+        dataOut[index] = toDouble(&data[offset], index);
+    }
+    return count;
 }
 
 void UAVObjectField::setDouble(double value, quint32 index)
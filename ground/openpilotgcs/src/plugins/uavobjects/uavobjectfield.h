@@ -34,9 +34,13 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QBitArray>
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QJsonObject>
+#include "uavobjectjson.h"
 
 class UAVObject;
 
@@ -52,8 +56,34 @@ public:
         int board;
     } LimitStruct;
 
+    // Limit rule compiled for the checks, the values are converted to double
+    // and the enum options to their index. The ranges are closed intervals.
+    typedef struct {
+        LimitType type; // UNDEFINED for the rules accepting all the values
+        int board;
+        double min;
+        double max;
+        QVector<double> values; // EQUAL and NOT_EQUAL on the numeric fields
+        QBitArray optionSet; // EQUAL and NOT_EQUAL on the enum fields
+        QStringList strings; // EQUAL and NOT_EQUAL on the string fields
+    } CompiledLimit;
+
+    // Field description generated in the object code, shared by all the instances
+    typedef struct {
+        const char *name;
+        const char *description; // untranslated
+        const char *units;
+        FieldType type;
+        quint32 numElements;
+        const char *const *elementNames; // NULL for the default names 0, 1...
+        quint32 numOptions;
+        const char *const *options;
+        const char *limits;
+    } FieldInfo;
+
     UAVObjectField(const QString & name, const QString & description, const QString & units, FieldType type, quint32 numElements, const QStringList & options, const QString & limits = QString());
     UAVObjectField(const QString & name, const QString & description, const QString & units, FieldType type, const QStringList & elementNames, const QStringList & options, const QString & limits = QString());
+    UAVObjectField(const FieldInfo *info, const char *context);
     void initialize(quint8 *data, quint32 dataOffset, UAVObject *obj);
     UAVObject *getObject();
     FieldType getType();
@@ -71,6 +101,11 @@ public:
     void setValue(const QVariant & data, quint32 index = 0);
     double getDouble(quint32 index = 0);
     void setDouble(double value, quint32 index = 0);
+    quint32 copyElements(double *dataOut, quint32 maxElements);
+    template<typename T> T getValueAs(quint32 index = 0)
+    {
+        return static_cast<T>(getDouble(index));
+    }
     quint32 getDataOffset();
     quint32 getNumBytes();
     bool isNumeric();
@@ -83,8 +118,11 @@ public:
 
     void toJson(QJsonObject &jsonObject);
     void fromJson(const QJsonObject &jsonObject);
+    void toJson(UAVObjectJsonWriter *jsonWriter);
 
     bool isWithinLimits(QVariant var, quint32 index, int board = 0);
+    bool isWithinLimits(int board = 0);
+    QStringList getOptionsWithinLimits(quint32 index, int board = 0);
     QString getLimitsAsString(quint32 index, int board = 0);
     QVariant getMaxLimit(quint32 index, int board = 0);
     QVariant getMinLimit(quint32 index, int board = 0);
@@ -92,21 +130,34 @@ signals:
     void fieldUpdated(UAVObjectField *field);
 
 protected:
+    typedef double (*ToDoubleFunc)(const quint8 *fieldData, quint32 index);
+
     QString name;
     QString description;
     QString units;
     FieldType type;
     QStringList elementNames;
     QStringList options;
+    QHash<QString, int> optionIndexes; // index of each option, shared by the instances of a generated field
     quint32 numElements;
     quint32 numBytesPerElement;
     quint32 offset;
     quint8 *data;
     UAVObject *obj;
+    ToDoubleFunc toDouble; // element converter of numeric fields, NULL for text fields
+    const FieldInfo *info; // NULL for the fields not generated
+    QString limitsString;
+    bool limitsParsed;
     QMap<quint32, QList<LimitStruct> > elementLimits;
+    QVector<QVector<CompiledLimit> > compiledLimits; // per element
     void clear();
     void constructorInitialize(const QString & name, const QString & description, const QString & units, FieldType type, const QStringList & elementNames, const QStringList & options, const QString &limits);
     void limitsInitialize(const QString &limits);
+    void limitsCompile();
+    const QMap<quint32, QList<LimitStruct> > &limits();
+    double toLimitValue(const QVariant &var);
+    int optionIndex(const QString &option) const;
+    bool isWithinCompiledLimits(quint32 index, double value, const QString &text, int board);
 };
 
 #endif // UAVOBJECTFIELD_H
@@ -0,0 +1,552 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectjson.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectjson.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <limits>
+
+#define JSON_BUFFER_SIZE 65536
+
+UAVObjectJsonWriter::UAVObjectJsonWriter(QIODevice *device) : device(device), error(false)
+{
+    buffer.reserve(JSON_BUFFER_SIZE + 1024);
+}
+
+UAVObjectJsonWriter::~UAVObjectJsonWriter()
+{
+    flush();
+}
+
+void UAVObjectJsonWriter::writeStartObject(const QString & name)
+{
+    writeSeparator(name);
+    buffer.append('{');
+    firstMember.append(true);
+}
+
+void UAVObjectJsonWriter::writeEndObject()
+{
+    buffer.append('}');
+    firstMember.removeLast();
+    writeBuffer(false);
+}
+
+void UAVObjectJsonWriter::writeStartArray(const QString & name)
+{
+    writeSeparator(name);
+    buffer.append('[');
+    firstMember.append(true);
+}
+
+void UAVObjectJsonWriter::writeEndArray()
+{
+    buffer.append(']');
+    firstMember.removeLast();
+    writeBuffer(false);
+}
+
+void UAVObjectJsonWriter::writeValue(const QString & name, const QString & value)
+{
+    writeSeparator(name);
+    writeString(value);
+}
+
+void UAVObjectJsonWriter::writeValue(const QString & name, double value)
+{
+    writeSeparator(name);
+    writeNumber(value);
+}
+
+void UAVObjectJsonWriter::writeValue(const QString & name, int value)
+{
+    writeSeparator(name);
+    buffer.append(QByteArray::number(value));
+}
+
+void UAVObjectJsonWriter::writeValue(const QString & name, bool value)
+{
+    writeSeparator(name);
+    buffer.append(value ? "true" : "false");
+}
+
+/**
+ * Write a value built with the Qt JSON classes, small objects and arrays
+ * are serialized by QJsonDocument
+ */
+void UAVObjectJsonWriter::writeValue(const QString & name, const QJsonValue & value)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        writeValue(name, value.toBool());
+        break;
+    case QJsonValue::Double:
+        writeValue(name, value.toDouble());
+        break;
+    case QJsonValue::String:
+        writeValue(name, value.toString());
+        break;
+    case QJsonValue::Array:
+        writeSeparator(name);
+        buffer.append(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+        break;
+    case QJsonValue::Object:
+        writeSeparator(name);
+        buffer.append(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+        break;
+    default:
+        writeSeparator(name);
+        buffer.append("null");
+    }
+}
+
+/**
+ * Write the pending output to the device
+ * @returns false if the device failed
+ */
+bool UAVObjectJsonWriter::flush()
+{
+    writeBuffer(true);
+    return !error;
+}
+
+bool UAVObjectJsonWriter::hasError() const
+{
+    return error;
+}
+
+void UAVObjectJsonWriter::writeSeparator(const QString & name)
+{
+    if (!firstMember.isEmpty()) {
+        if (!firstMember.last()) {
+            buffer.append(',');
+        }
+        firstMember.last() = false;
+    }
+    if (!name.isNull()) {
+        writeString(name);
+        buffer.append(':');
+    }
+}
+
+void UAVObjectJsonWriter::writeString(const QString & str)
+{
+    static const char hex[] = "0123456789abcdef";
+    QByteArray utf8 = str.toUtf8();
+
+    buffer.append('"');
+    for (int n = 0; n < utf8.size(); ++n) {
+        uchar c = utf8.at(n);
+        switch (c) {
+        case '"':
+            buffer.append("\\\"");
+            break;
+        case '\\':
+            buffer.append("\\\\");
+            break;
+        case '\b':
+            buffer.append("\\b");
+            break;
+        case '\f':
+            buffer.append("\\f");
+            break;
+        case '\n':
+            buffer.append("\\n");
+            break;
+        case '\r':
+            buffer.append("\\r");
+            break;
+        case '\t':
+            buffer.append("\\t");
+            break;
+        default:
+            if (c < 0x20) {
+                buffer.append("\\u00");
+                buffer.append(hex[c >> 4]);
+                buffer.append(hex[c & 0xf]);
+            } else {
+                buffer.append((char)c);
+            }
+        }
+    }
+    buffer.append('"');
+}
+
+void UAVObjectJsonWriter::writeNumber(double value)
+{
+    // Same format as QJsonDocument, so that the outputs can be compared
+    if (qIsFinite(value)) {
+        buffer.append(QByteArray::number(value, 'g', std::numeric_limits<double>::digits10 + 2));
+    } else {
+        buffer.append("null");
+    }
+}
+
+void UAVObjectJsonWriter::writeBuffer(bool force)
+{
+    if (buffer.isEmpty() || (!force && buffer.size() < JSON_BUFFER_SIZE)) {
+        return;
+    }
+    if (!error && device->write(buffer) != buffer.size()) {
+        error = true;
+    }
+    buffer.clear();
+}
+
+UAVObjectJsonReader::UAVObjectJsonReader(QIODevice *device) : device(device), pos(0), state(ExpectValue), token(Invalid), error(false)
+{}
+
+/**
+ * Read the next token
+ * @returns Invalid on a syntax or device error, EndDocument after the
+ * top level value
+ */
+UAVObjectJsonReader::TokenType UAVObjectJsonReader::readNext()
+{
+    if (error) {
+        return Invalid;
+    }
+    skipWhitespace();
+    switch (state) {
+    case ExpectNameOrEnd:
+        if (peekChar() == '}') {
+            getChar();
+            return endContainer('{');
+        }
+    // Fall through
+    case ExpectName:
+        if (getChar() != '"' || !readString(currentName)) {
+            return fail();
+        }
+        skipWhitespace();
+        if (getChar() != ':') {
+            return fail();
+        }
+        state = ExpectValue;
+        return token = Name;
+
+    case ExpectValueOrEnd:
+        if (peekChar() == ']') {
+            getChar();
+            return endContainer('[');
+        }
+    // Fall through
+    case ExpectValue:
+        return readScalarOrStart();
+
+    case ExpectSeparator:
+    {
+        int c = getChar();
+        if (c == ',') {
+            state = containers.last() == '{' ? ExpectName : ExpectValue;
+            return readNext();
+        }
+        if ((c == '}' || c == ']') && containers.last() == (c == '}' ? '{' : '[')) {
+            return endContainer(containers.last());
+        }
+        return fail();
+    }
+    case ExpectEnd:
+        return token = EndDocument;
+    }
+    return fail();
+}
+
+UAVObjectJsonReader::TokenType UAVObjectJsonReader::tokenType() const
+{
+    return token;
+}
+
+/**
+ * Returns the member name of the last Name token
+ */
+const QString &UAVObjectJsonReader::name() const
+{
+    return currentName;
+}
+
+/**
+ * Returns the value of the last String, Number or Bool token, numbers are doubles
+ */
+const QVariant &UAVObjectJsonReader::value() const
+{
+    return currentValue;
+}
+
+/**
+ * Read the next value, objects and arrays are skipped
+ * @returns the value or an invalid QVariant if it is not a string, number or bool
+ */
+QVariant UAVObjectJsonReader::readValue()
+{
+    switch (readNext()) {
+    case String:
+    case Number:
+    case Bool:
+        return currentValue;
+
+    case StartObject:
+    case StartArray:
+    {
+        int depth = 1;
+        while (depth > 0) {
+            switch (readNext()) {
+            case StartObject:
+            case StartArray:
+                depth++;
+                break;
+            case EndObject:
+            case EndArray:
+                depth--;
+                break;
+            case Invalid:
+            case EndDocument:
+                return QVariant();
+
+            default:
+                break;
+            }
+        }
+        return QVariant();
+    }
+    default:
+        return QVariant();
+    }
+}
+
+/**
+ * Skip the next value, typically after the Name token of an unknown member
+ */
+void UAVObjectJsonReader::skipValue()
+{
+    readValue();
+}
+
+bool UAVObjectJsonReader::hasError() const
+{
+    return error;
+}
+
+int UAVObjectJsonReader::peekChar()
+{
+    if (pos >= buffer.size()) {
+        buffer = device->read(JSON_BUFFER_SIZE);
+        pos    = 0;
+        if (buffer.isEmpty()) {
+            return -1;
+        }
+    }
+    return (uchar)buffer.at(pos);
+}
+
+int UAVObjectJsonReader::getChar()
+{
+    int c = peekChar();
+
+    if (c >= 0) {
+        pos++;
+    }
+    return c;
+}
+
+void UAVObjectJsonReader::skipWhitespace()
+{
+    int c = peekChar();
+
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        pos++;
+        c = peekChar();
+    }
+}
+
+/**
+ * Read a string after its opening quote
+ */
+bool UAVObjectJsonReader::readString(QString & str)
+{
+    QByteArray utf8;
+    ushort highSurrogate = 0;
+
+    for (;;) {
+        // Copy the runs without escape at once
+        int start = pos;
+        while (pos < buffer.size() && buffer.at(pos) != '"' && buffer.at(pos) != '\\') {
+            pos++;
+        }
+        utf8.append(buffer.constData() + start, pos - start);
+
+        int c = getChar();
+        if (c < 0) {
+            return false;
+        } else if (c == '"') {
+            str = QString::fromUtf8(utf8);
+            return true;
+        } else if (c != '\\') {
+            // The buffer ended inside the string
+            utf8.append((char)c);
+            continue;
+        }
+
+        c = getChar();
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            utf8.append((char)c);
+            break;
+        case 'b':
+            utf8.append('\b');
+            break;
+        case 'f':
+            utf8.append('\f');
+            break;
+        case 'n':
+            utf8.append('\n');
+            break;
+        case 'r':
+            utf8.append('\r');
+            break;
+        case 't':
+            utf8.append('\t');
+            break;
+        case 'u':
+        {
+            ushort code = 0;
+            for (int n = 0; n < 4; ++n) {
+                int digit = getChar();
+                code <<= 4;
+                if (digit >= '0' && digit <= '9') {
+                    code |= digit - '0';
+                } else if (digit >= 'a' && digit <= 'f') {
+                    code |= digit - 'a' + 10;
+                } else if (digit >= 'A' && digit <= 'F') {
+                    code |= digit - 'A' + 10;
+                } else {
+                    return false;
+                }
+            }
+            if (QChar::isHighSurrogate(code)) {
+                // Converted with the low surrogate of the next escape
+                highSurrogate = code;
+                continue;
+            }
+            QString utf16;
+            if (QChar::isLowSurrogate(code) && highSurrogate) {
+                utf16.append(QChar(highSurrogate));
+            }
+            utf16.append(QChar(code));
+            utf8.append(utf16.toUtf8());
+            break;
+        }
+        default:
+            return false;
+        }
+        highSurrogate = 0;
+    }
+}
+
+bool UAVObjectJsonReader::readLiteral(const char *literal)
+{
+    for (; *literal; ++literal) {
+        if (getChar() != *literal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+UAVObjectJsonReader::TokenType UAVObjectJsonReader::readScalarOrStart()
+{
+    int c = getChar();
+
+    switch (c) {
+    case '{':
+        containers.append('{');
+        state = ExpectNameOrEnd;
+        return token = StartObject;
+
+    case '[':
+        containers.append('[');
+        state = ExpectValueOrEnd;
+        return token = StartArray;
+
+    case '"':
+    {
+        QString str;
+        if (!readString(str)) {
+            return fail();
+        }
+        currentValue = str;
+        return valueRead(String);
+    }
+    case 't':
+        currentValue = true;
+        return readLiteral("rue") ? valueRead(Bool) : fail();
+
+    case 'f':
+        currentValue = false;
+        return readLiteral("alse") ? valueRead(Bool) : fail();
+
+    case 'n':
+        currentValue = QVariant();
+        return readLiteral("ull") ? valueRead(Null) : fail();
+
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            QByteArray number(1, (char)c);
+            c = peekChar();
+            while ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                number.append((char)getChar());
+                c = peekChar();
+            }
+            bool ok;
+            currentValue = number.toDouble(&ok);
+            return ok ? valueRead(Number) : fail();
+        }
+        return fail();
+    }
+}
+
+UAVObjectJsonReader::TokenType UAVObjectJsonReader::endContainer(char container)
+{
+    containers.removeLast();
+    valueRead(container == '{' ? EndObject : EndArray);
+    return token;
+}
+
+UAVObjectJsonReader::TokenType UAVObjectJsonReader::valueRead(TokenType type)
+{
+    state = containers.isEmpty() ? ExpectEnd : ExpectSeparator;
+    return token = type;
+}
+
+UAVObjectJsonReader::TokenType UAVObjectJsonReader::fail()
+{
+    error = true;
+    return token = Invalid;
+}
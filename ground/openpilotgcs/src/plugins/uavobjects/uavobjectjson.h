@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectjson.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTJSON_H
+#define UAVOBJECTJSON_H
+
+#include "uavobjects_global.h"
+#include <QIODevice>
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <QJsonValue>
+
+/**
+ * Incremental JSON writer, the document is written to the device as it is
+ * built without a QJsonDocument in memory. Inside an object the values are
+ * given with their member name, inside an array with a null name.
+ * The output is compact and uses the number format of QJsonDocument.
+ */
+class UAVOBJECTS_EXPORT UAVObjectJsonWriter {
+public:
+    UAVObjectJsonWriter(QIODevice *device);
+    ~UAVObjectJsonWriter();
+
+    void writeStartObject(const QString & name = QString());
+    void writeEndObject();
+    void writeStartArray(const QString & name = QString());
+    void writeEndArray();
+    void writeValue(const QString & name, const QString & value);
+    void writeValue(const QString & name, double value);
+    void writeValue(const QString & name, int value);
+    void writeValue(const QString & name, bool value);
+    void writeValue(const QString & name, const QJsonValue & value);
+    bool flush();
+    bool hasError() const;
+
+private:
+    QIODevice *device;
+    QByteArray buffer;
+    QVector<bool> firstMember; // per open object or array
+    bool error;
+
+    void writeSeparator(const QString & name);
+    void writeString(const QString & str);
+    void writeNumber(double value);
+    void writeBuffer(bool force);
+};
+
+/**
+ * Incremental JSON reader, the tokens are pulled from the device like with
+ * QXmlStreamReader. The member names are reported as Name tokens followed by
+ * their value.
+ */
+class UAVOBJECTS_EXPORT UAVObjectJsonReader {
+public:
+    typedef enum { Invalid, StartObject, EndObject, StartArray, EndArray, Name, String, Number, Bool, Null, EndDocument } TokenType;
+
+    UAVObjectJsonReader(QIODevice *device);
+
+    TokenType readNext();
+    TokenType tokenType() const;
+    const QString &name() const;
+    const QVariant &value() const;
+    QVariant readValue();
+    void skipValue();
+    bool hasError() const;
+
+private:
+    typedef enum { ExpectValue, ExpectValueOrEnd, ExpectName, ExpectNameOrEnd, ExpectSeparator, ExpectEnd } State;
+
+    QIODevice *device;
+    QByteArray buffer;
+    int pos;
+    QVector<char> containers; // '{' or '[' per open container
+    State state;
+    TokenType token;
+    QString currentName;
+    QVariant currentValue;
+    bool error;
+
+    int peekChar();
+    int getChar();
+    void skipWhitespace();
+    bool readString(QString & str);
+    bool readLiteral(const char *literal);
+    TokenType readScalarOrStart();
+    TokenType endContainer(char container);
+    TokenType valueRead(TokenType type);
+    TokenType fail();
+};
+
+#endif // UAVOBJECTJSON_H
@@ -53,54 +53,53 @@ bool UAVObjectManager::registerObject(UAVDataObject *obj)
     QMutexLocker locker(mutex);
 
     // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0 && objects[objidx][0]->getObjID() == obj->getObjID()) {
-            // Check if this is a single instance object, if yes we can not add a new instance
-            if (obj->isSingleInstance()) {
-                return false;
-            }
-            // The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
-            // There is a single metaobject for all object instances of this type, so no need to create a new one
-            // Get object type metaobject from existing instance
-            UAVDataObject *refObj = dynamic_cast<UAVDataObject *>(objects[objidx][0]);
-            if (refObj == NULL) {
-                return false;
-            }
-            UAVMetaObject *mobj = refObj->getMetaObject();
-            // If the instance ID is specified and not at the default value (0) then we need to make sure
-            // that there are no gaps in the instance list. If gaps are found then then additional instances
-            // will be created.
-            if ((obj->getInstID() > 0) && (obj->getInstID() < MAX_INSTANCES)) {
-                for (int instidx = 0; instidx < objects[objidx].length(); ++instidx) {
-                    if (objects[objidx][instidx]->getInstID() == obj->getInstID()) {
-                        // Instance conflict, do not add
-                        return false;
-                    }
-                }
-                // Check if there are any gaps between the requested instance ID and the ones in the list,
-                // if any then create the missing instances.
-                for (quint32 instidx = objects[objidx].length(); instidx < obj->getInstID(); ++instidx) {
-                    UAVDataObject *cobj = obj->clone(instidx);
-                    cobj->initialize(mobj);
-                    objects[objidx].append(cobj);
-                    getObject(cobj->getObjID())->emitNewInstance(cobj);
-                    emit newInstance(cobj);
+    int objidx = getObjectIndex(NULL, obj->getObjID());
+
+    if (objidx >= 0) {
+        // Check if this is a single instance object, if yes we can not add a new instance
+        if (obj->isSingleInstance()) {
+            return false;
+        }
+        // The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
+        // There is a single metaobject for all object instances of this type, so no need to create a new one
+        // Get object type metaobject from existing instance
+        UAVDataObject *refObj = dynamic_cast<UAVDataObject *>(objects[objidx][0]);
+        if (refObj == NULL) {
+            return false;
+        }
+        UAVMetaObject *mobj = refObj->getMetaObject();
+        // If the instance ID is specified and not at the default value (0) then we need to make sure
+        // that there are no gaps in the instance list. If gaps are found then then additional instances
+        // will be created.
+        if ((obj->getInstID() > 0) && (obj->getInstID() < MAX_INSTANCES)) {
+            for (int instidx = 0; instidx < objects[objidx].length(); ++instidx) {
+                if (objects[objidx][instidx]->getInstID() == obj->getInstID()) {
+                    // Instance conflict, do not add
+                    return false;
                 }
-                // Finally, initialize the actual object instance
-                obj->initialize(mobj);
-            } else if (obj->getInstID() == 0) {
-                // Assign the next available ID and initialize the object instance
-                obj->initialize(objects[objidx].length(), mobj);
-            } else {
-                return false;
             }
-            // Add the actual object instance in the list
-            objects[objidx].append(obj);
-            getObject(obj->getObjID())->emitNewInstance(obj);
-            emit newInstance(obj);
-            return true;
+            // Check if there are any gaps between the requested instance ID and the ones in the list,
+            // if any then create the missing instances.
+            for (quint32 instidx = objects[objidx].length(); instidx < obj->getInstID(); ++instidx) {
+                UAVDataObject *cobj = obj->clone(instidx);
+                cobj->initialize(mobj);
+                objects[objidx].append(cobj);
+                getObject(cobj->getObjID())->emitNewInstance(cobj);
+                emit newInstance(cobj);
+            }
+            // Finally, initialize the actual object instance
+            obj->initialize(mobj);
+        } else if (obj->getInstID() == 0) {
+            // Assign the next available ID and initialize the object instance
+            obj->initialize(objects[objidx].length(), mobj);
+        } else {
+            return false;
         }
+        // Add the actual object instance in the list
+        objects[objidx].append(obj);
+        getObject(obj->getObjID())->emitNewInstance(obj);
+        emit newInstance(obj);
+        return true;
     }
     // If this point is reached then this is the first time this object type (ID) is added in the list
     // create a new list of the instances, add in the object collection and create the object's metaobject
@@ -121,10 +120,25 @@ void UAVObjectManager::addObject(UAVObject *obj)
     // Add to list
     QList<UAVObject *> list;
     list.append(obj);
+    objIdIndex.insert(obj->getObjID(), objects.length());
+    nameIndex.insert(obj->getName(), objects.length());
     objects.append(list);
     emit newObject(obj);
 }
 
+/**
+ * Helper function returning the index of an object type in the object list, looked up by name
+ * if one is given or else by object ID.
+ * @returns The index or -1 if the object type is not registered
+ */
+int UAVObjectManager::getObjectIndex(const QString *name, quint32 objId) const
+{
+    if (name != NULL) {
+        return nameIndex.value(*name, -1);
+    }
+    return objIdIndex.value(objId, -1);
+}
+
 /**
  * Get all objects. A two dimentional QList is returned. Objects are grouped by
  * instances of the same object type.
@@ -227,17 +241,18 @@ UAVObject *UAVObjectManager::getObject(const QString *name, quint32 objId, quint
 {
     QMutexLocker locker(mutex);
 
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0) {
-            if ((name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId)) {
-                // Look for the requested instance ID
-                for (int instidx = 0; instidx < objects[objidx].length(); ++instidx) {
-                    if (objects[objidx][instidx]->getInstID() == instId) {
-                        return objects[objidx][instidx];
-                    }
-                }
+    int objidx = getObjectIndex(name, objId);
+
+    if (objidx >= 0) {
+        const QList<UAVObject *> &instances = objects.at(objidx);
+        // Instances are kept without gaps, so the instance ID is normally the list position
+        if (instId < (quint32)instances.length() && instances.at(instId)->getInstID() == instId) {
+            return instances.at(instId);
+        }
+        // Look for the requested instance ID
+        for (int instidx = 0; instidx < instances.length(); ++instidx) {
+            if (instances.at(instidx)->getInstID() == instId) {
+                return instances.at(instidx);
             }
         }
     }
@@ -269,14 +284,10 @@ QList<UAVObject *> UAVObjectManager::getObjectInstances(const QString *name, qui
 {
     QMutexLocker locker(mutex);
 
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0) {
-            if ((name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId)) {
-                return objects[objidx];
-            }
-        }
+    int objidx = getObjectIndex(name, objId);
+
+    if (objidx >= 0) {
+        return objects.at(objidx);
     }
     // If this point is reached then the requested object could not be found
     return QList<UAVObject *>();
@@ -356,6 +367,186 @@ void UAVObjectManager::fromJson(const QJsonObject &jsonObject, QList<UAVObject *
     }
 }
 
+/**
+ * Stream the objects to a device with the layout of toJson(QJsonObject &),
+ * the members of header are written before the objects
+ * @returns false if the device failed
+ */
+bool UAVObjectManager::toJson(QIODevice *device, const QList<UAVObject *> &objectsToExport, const QJsonObject &header)
+{
+    UAVObjectJsonWriter writer(device);
+
+    writer.writeStartObject();
+    for (QJsonObject::const_iterator member = header.constBegin(); member != header.constEnd(); ++member) {
+        writer.writeValue(member.key(), member.value());
+    }
+    writer.writeStartArray("objects");
+    foreach(UAVObject * object, objectsToExport) {
+        object->toJson(&writer);
+    }
+    writer.writeEndArray();
+    writer.writeEndObject();
+    return writer.flush();
+}
+
+namespace {
+typedef struct {
+    QString field;
+    QString element;
+    QVariant value;
+} JsonFieldValue;
+
+/**
+ * Read the "fields" array of an object, the values are kept until the
+ * object name and instance are known
+ */
+bool readJsonFields(UAVObjectJsonReader &reader, QList<JsonFieldValue> &values)
+{
+    if (reader.readNext() != UAVObjectJsonReader::StartArray) {
+        return false;
+    }
+    while (reader.readNext() == UAVObjectJsonReader::StartObject) {
+        QString fieldName;
+        int first = values.length();
+        while (reader.readNext() == UAVObjectJsonReader::Name) {
+            if (reader.name() == "name") {
+                fieldName = reader.readValue().toString();
+            } else if (reader.name() == "values") {
+                if (reader.readNext() != UAVObjectJsonReader::StartArray) {
+                    return false;
+                }
+                while (reader.readNext() == UAVObjectJsonReader::StartObject) {
+                    JsonFieldValue value;
+                    while (reader.readNext() == UAVObjectJsonReader::Name) {
+                        if (reader.name() == "name") {
+                            value.element = reader.readValue().toString();
+                        } else if (reader.name() == "value") {
+                            value.value = reader.readValue();
+                        } else {
+                            reader.skipValue();
+                        }
+                    }
+                    values.append(value);
+                }
+            } else {
+                reader.skipValue();
+            }
+        }
+        // The field name may follow its values
+        for (int n = first; n < values.length(); ++n) {
+            values[n].field = fieldName;
+        }
+    }
+    return !reader.hasError();
+}
+}
+
+/**
+ * Read the objects streamed from a device in the layout of toJson(QJsonObject &),
+ * the objects are updated one at a time as they are read
+ * @returns false on a syntax error, the objects read before stay updated
+ */
+bool UAVObjectManager::fromJson(QIODevice *device, QList<UAVObject *> *updatedObjects)
+{
+    UAVObjectJsonReader reader(device);
+
+    if (reader.readNext() != UAVObjectJsonReader::StartObject) {
+        return false;
+    }
+    while (reader.readNext() == UAVObjectJsonReader::Name) {
+        if (reader.name() != "objects") {
+            reader.skipValue();
+            continue;
+        }
+        if (reader.readNext() != UAVObjectJsonReader::StartArray) {
+            return false;
+        }
+        while (reader.readNext() == UAVObjectJsonReader::StartObject) {
+            QString name;
+            int instance = 0;
+            QList<JsonFieldValue> values;
+            while (reader.readNext() == UAVObjectJsonReader::Name) {
+                if (reader.name() == "name") {
+                    name = reader.readValue().toString();
+                } else if (reader.name() == "instance") {
+                    instance = reader.readValue().toInt();
+                } else if (reader.name() == "fields") {
+                    if (!readJsonFields(reader, values)) {
+                        return false;
+                    }
+                } else {
+                    reader.skipValue();
+                }
+            }
+            if (reader.hasError()) {
+                return false;
+            }
+
+            UAVObject *object = getObject(name, instance);
+            if (object != NULL) {
+                foreach(const JsonFieldValue &value, values) {
+                    UAVObjectField *field = object->getField(value.field);
+                    if (field != NULL) {
+                        int index = field->getElementNames().indexOf(value.element);
+                        if (index >= 0) {
+                            field->setValue(value.value, index);
+                        }
+                    }
+                }
+                object->updated();
+                if (updatedObjects != NULL) {
+                    updatedObjects->append(object);
+                }
+            }
+        }
+    }
+    return !reader.hasError() && reader.tokenType() == UAVObjectJsonReader::EndObject;
+}
+
+/**
+ * Copy the object values to a snapshot, only the data objects are copied.
+ * The copy is quick, the snapshot can then be written or compared on any thread.
+ */
+UAVSettingsSnapshot UAVObjectManager::toSettingsSnapshot(JSON_EXPORT_OPTION what)
+{
+    UAVSettingsSnapshot snapshot;
+    QList< QList<UAVDataObject *> > allObjects = getDataObjects();
+
+    foreach(QList<UAVDataObject *> instances, allObjects) {
+        foreach(UAVDataObject * object, instances) {
+            if ((what == JSON_EXPORT_SETTINGS && !object->isSettingsObject()) ||
+                (what == JSON_EXPORT_DATA && object->isSettingsObject()) ||
+                what == JSON_EXPORT_METADATA) {
+                continue;
+            }
+            UAVSettingsSnapshot::Object snapshotObject;
+            snapshotObject.name     = object->getName();
+            snapshotObject.id       = object->getObjID();
+            snapshotObject.instance = object->getInstID();
+            snapshotObject.setting  = object->isSettingsObject();
+            foreach(UAVObjectField * field, object->getFields()) {
+                UAVSettingsSnapshot::Field snapshotField;
+                snapshotField.name     = field->getName();
+                snapshotField.type     = field->getTypeAsString();
+                snapshotField.unit     = field->getUnits();
+                snapshotField.elements = field->getElementNames();
+                for (quint32 n = 0; n < field->getNumElements(); ++n) {
+                    QVariant value = field->getValue(n);
+                    // Same format as the files, see UAVSettingsSnapshot::readJson()
+                    if (value.type() == QMetaType::Float) {
+                        snapshotField.values << QString::number(value.toFloat(), 'g', 9);
+                    } else {
+                        snapshotField.values << value.toString();
+                    }
+                }
+                snapshotObject.fields << snapshotField;
+            }
+            snapshot.insert(snapshotObject);
+        }
+    }
+    return snapshot;
+}
+
 /**
  * Helper function for public getNumInstances
  */
@@ -363,14 +554,10 @@ qint32 UAVObjectManager::getNumInstances(const QString *name, quint32 objId)
 {
     QMutexLocker locker(mutex);
 
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0) {
-            if ((name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId)) {
-                return objects[objidx].length();
-            }
-        }
+    int objidx = getObjectIndex(name, objId);
+
+    if (objidx >= 0) {
+        return objects.at(objidx).length();
     }
     // If this point is reached then the requested object could not be found
     return -1;
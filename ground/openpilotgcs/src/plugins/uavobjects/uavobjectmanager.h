@@ -32,7 +32,9 @@
 #include "uavobject.h"
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
+#include "uavsettingssnapshot.h"
 #include <QList>
+#include <QHash>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QJsonObject>
@@ -60,6 +62,9 @@ public:
     void toJson(QJsonObject &jsonObject, const QList<QString> &objectsToExport);
     void toJson(QJsonObject &jsonObject, const QList<UAVObject *> &objectsToExport);
     void fromJson(const QJsonObject &jsonObject, QList<UAVObject *> *updatedObjects = NULL);
+    bool toJson(QIODevice *device, const QList<UAVObject *> &objectsToExport, const QJsonObject &header = QJsonObject());
+    bool fromJson(QIODevice *device, QList<UAVObject *> *updatedObjects = NULL);
+    UAVSettingsSnapshot toSettingsSnapshot(JSON_EXPORT_OPTION what = JSON_EXPORT_SETTINGS);
 
 signals:
     void newObject(UAVObject *obj);
@@ -69,9 +74,13 @@ private:
     static const quint32 MAX_INSTANCES = 1000;
 
     QList< QList<UAVObject *> > objects;
+    // index of each object type in objects, by object ID and by name
+    QHash<quint32, int> objIdIndex;
+    QHash<QString, int> nameIndex;
     QMutex *mutex;
 
     void addObject(UAVObject *obj);
+    int getObjectIndex(const QString *name, quint32 objId) const;
     UAVObject *getObject(const QString *name, quint32 objId, quint32 instId);
     QList<UAVObject *> getObjectInstances(const QString *name, quint32 objId);
     qint32 getNumInstances(const QString *name, quint32 objId);
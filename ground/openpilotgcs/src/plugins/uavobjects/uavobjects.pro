@@ -1,6 +1,8 @@
 TEMPLATE = lib
 TARGET = UAVObjects
 
+QT += concurrent
+
 DEFINES += UAVOBJECTS_LIBRARY
 
 include(../../openpilotgcsplugin.pri)
@@ -14,14 +16,20 @@ HEADERS += \
     uavdataobject.h \
     uavobjectfield.h \
     uavobjectsinit.h \
-    uavobjectsplugin.h
+    uavobjectsplugin.h \
+    uavobjectupdatethrottle.h \
+    uavobjectjson.h \
+    uavsettingssnapshot.h
 SOURCES += \
     uavobject.cpp \
     uavmetaobject.cpp \
     uavobjectmanager.cpp \
     uavdataobject.cpp \
     uavobjectfield.cpp \
-    uavobjectsplugin.cpp
+    uavobjectsplugin.cpp \
+    uavobjectupdatethrottle.cpp \
+    uavobjectjson.cpp \
+    uavsettingssnapshot.cpp
 
 OTHER_FILES += UAVObjects.pluginspec
 
@@ -33,6 +41,7 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/airspeedsensor.h \
     $$UAVOBJECT_SYNTHETICS/airspeedsettings.h \
     $$UAVOBJECT_SYNTHETICS/airspeedstate.h \
+    $$UAVOBJECT_SYNTHETICS/windvelocitystate.h \
     $$UAVOBJECT_SYNTHETICS/attitudestate.h \
     $$UAVOBJECT_SYNTHETICS/attitudesimulated.h \
     $$UAVOBJECT_SYNTHETICS/altitudeholdsettings.h \
@@ -55,9 +64,13 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/magstate.h \
     $$UAVOBJECT_SYNTHETICS/camerastabsettings.h \
     $$UAVOBJECT_SYNTHETICS/flighttelemetrystats.h \
+    $$UAVOBJECT_SYNTHETICS/telemetryping.h \
+    $$UAVOBJECT_SYNTHETICS/sensorcalibrationstats.h \
     $$UAVOBJECT_SYNTHETICS/systemstats.h \
     $$UAVOBJECT_SYNTHETICS/systemalarms.h \
     $$UAVOBJECT_SYNTHETICS/objectpersistence.h \
+    $$UAVOBJECT_SYNTHETICS/objectpersistencebatch.h \
+    $$UAVOBJECT_SYNTHETICS/objecthashes.h \
     $$UAVOBJECT_SYNTHETICS/overosyncstats.h \
     $$UAVOBJECT_SYNTHETICS/overosyncsettings.h \
     $$UAVOBJECT_SYNTHETICS/systemsettings.h \
@@ -100,6 +113,11 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/flightbatterysettings.h \
     $$UAVOBJECT_SYNTHETICS/taskinfo.h \
     $$UAVOBJECT_SYNTHETICS/callbackinfo.h \
+    $$UAVOBJECT_SYNTHETICS/callbacktiming.h \
+    $$UAVOBJECT_SYNTHETICS/rategovernor.h \
+    $$UAVOBJECT_SYNTHETICS/sysidcapture.h \
+    $$UAVOBJECT_SYNTHETICS/sysidcapturesettings.h \
+    $$UAVOBJECT_SYNTHETICS/benchmarkresults.h \
     $$UAVOBJECT_SYNTHETICS/flightplanstatus.h \
     $$UAVOBJECT_SYNTHETICS/flightplansettings.h \
     $$UAVOBJECT_SYNTHETICS/flightplancontrol.h \
@@ -137,6 +155,7 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/airspeedsensor.cpp \
     $$UAVOBJECT_SYNTHETICS/airspeedsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/airspeedstate.cpp \
+    $$UAVOBJECT_SYNTHETICS/windvelocitystate.cpp \
     $$UAVOBJECT_SYNTHETICS/attitudestate.cpp \
     $$UAVOBJECT_SYNTHETICS/attitudesimulated.cpp \
     $$UAVOBJECT_SYNTHETICS/altitudeholdsettings.cpp \
@@ -159,9 +178,13 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/magstate.cpp \
     $$UAVOBJECT_SYNTHETICS/camerastabsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/flighttelemetrystats.cpp \
+    $$UAVOBJECT_SYNTHETICS/telemetryping.cpp \
+    $$UAVOBJECT_SYNTHETICS/sensorcalibrationstats.cpp \
     $$UAVOBJECT_SYNTHETICS/systemstats.cpp \
     $$UAVOBJECT_SYNTHETICS/systemalarms.cpp \
     $$UAVOBJECT_SYNTHETICS/objectpersistence.cpp \
+    $$UAVOBJECT_SYNTHETICS/objectpersistencebatch.cpp \
+    $$UAVOBJECT_SYNTHETICS/objecthashes.cpp \
     $$UAVOBJECT_SYNTHETICS/overosyncstats.cpp \
     $$UAVOBJECT_SYNTHETICS/overosyncsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/systemsettings.cpp \
@@ -204,6 +227,11 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/flightbatterysettings.cpp \
     $$UAVOBJECT_SYNTHETICS/taskinfo.cpp \
     $$UAVOBJECT_SYNTHETICS/callbackinfo.cpp \
+    $$UAVOBJECT_SYNTHETICS/callbacktiming.cpp \
+    $$UAVOBJECT_SYNTHETICS/rategovernor.cpp \
+    $$UAVOBJECT_SYNTHETICS/sysidcapture.cpp \
+    $$UAVOBJECT_SYNTHETICS/sysidcapturesettings.cpp \
+    $$UAVOBJECT_SYNTHETICS/benchmarkresults.cpp \
     $$UAVOBJECT_SYNTHETICS/flightplanstatus.cpp \
     $$UAVOBJECT_SYNTHETICS/flightplansettings.cpp \
     $$UAVOBJECT_SYNTHETICS/flightplancontrol.cpp \
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectupdatethrottle.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectupdatethrottle.h"
+
+UAVObjectUpdateThrottle::UAVObjectUpdateThrottle(int maxRate, QObject *parent) : QObject(parent),
+    m_period(1000 / qMax(maxRate, 1)), m_flushScheduled(false)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+    m_sinceFlush.start();
+}
+
+/**
+ * Start forwarding the updates of an object
+ */
+void UAVObjectUpdateThrottle::addObject(UAVObject *obj)
+{
+    // Direct connection, updates unpacked in the telemetry thread are only queued once per period
+    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectChanged(UAVObject *)), Qt::DirectConnection);
+}
+
+/**
+ * Stop forwarding the updates of an object, a pending update is dropped
+ */
+void UAVObjectUpdateThrottle::removeObject(UAVObject *obj)
+{
+    disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectChanged(UAVObject *)));
+
+    QMutexLocker locker(&m_mutex);
+    if (m_pendingSet.remove(obj)) {
+        m_pending.removeOne(obj);
+    }
+}
+
+/**
+ * Called from the emitting thread on each object update
+ */
+void UAVObjectUpdateThrottle::objectChanged(UAVObject *obj)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_pendingSet.contains(obj)) {
+        m_pendingSet.insert(obj);
+        m_pending.append(obj);
+    }
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, "scheduleFlush", Qt::QueuedConnection);
+    }
+}
+
+/**
+ * Arm the flush timer so that flushes are at least one period apart
+ */
+void UAVObjectUpdateThrottle::scheduleFlush()
+{
+    m_timer.start(qMax(0, m_period - (int)m_sinceFlush.elapsed()));
+}
+
+/**
+ * Emit the objects updated since the last flush
+ */
+void UAVObjectUpdateThrottle::flush()
+{
+    QList<UAVObject *> pending;
+
+    m_mutex.lock();
+    pending.swap(m_pending);
+    m_pendingSet.clear();
+    m_flushScheduled = false;
+    m_mutex.unlock();
+
+    m_sinceFlush.restart();
+    foreach(UAVObject * obj, pending) {
+        emit objectUpdated(obj);
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectupdatethrottle.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTUPDATETHROTTLE_H
+#define UAVOBJECTUPDATETHROTTLE_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * Coalesces objectUpdated() signals of the added objects and re-emits them at most
+ * maxRate times per second, latest value wins. Each pending object is emitted once per
+ * period however many times it was updated meanwhile.
+ * Meant for display gadgets, consumers that need every sample (logging) must keep
+ * connecting to the objects directly.
+ */
+class UAVOBJECTS_EXPORT UAVObjectUpdateThrottle : public QObject {
+    Q_OBJECT
+
+public:
+    UAVObjectUpdateThrottle(int maxRate, QObject *parent = 0);
+
+    void addObject(UAVObject *obj);
+    void removeObject(UAVObject *obj);
+
+signals:
+    void objectUpdated(UAVObject *obj);
+
+private slots:
+    void objectChanged(UAVObject *obj);
+    void scheduleFlush();
+    void flush();
+
+private:
+    int m_period;
+    QTimer m_timer;
+    QElapsedTimer m_sinceFlush;
+    QMutex m_mutex;
+    QList<UAVObject *> m_pending;
+    QSet<UAVObject *> m_pendingSet;
+    bool m_flushScheduled;
+};
+
+#endif // UAVOBJECTUPDATETHROTTLE_H
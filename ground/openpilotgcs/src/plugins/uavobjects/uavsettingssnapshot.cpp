@@ -0,0 +1,488 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavsettingssnapshot.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavsettingssnapshot.h"
+#include "uavobjectjson.h"
+#include <QFile>
+#include <QXmlStreamReader>
+#include <QtConcurrentMap>
+#include <cmath>
+
+namespace {
+/**
+ * The JSON numbers as the GCS writes them, the floats keep their 9 significant digits
+ */
+QString valueToString(const QVariant &value)
+{
+    if (value.type() == QVariant::Double) {
+        double number = value.toDouble();
+        if (number == std::floor(number) && std::fabs(number) < 1e15) {
+            return QString::number((qint64)number);
+        }
+        return QString::number(number, 'g', 9);
+    }
+    return value.toString();
+}
+
+/**
+ * The file values are written per field type, compare the numbers at float precision
+ */
+bool valuesEqual(const QString &a, const QString &b)
+{
+    if (a == b) {
+        return true;
+    }
+    bool okA, okB;
+    float numberA = a.toFloat(&okA);
+    float numberB = b.toFloat(&okB);
+    return okA && okB && numberA == numberB;
+}
+
+bool isNumeric(const QString &type)
+{
+    return type != "enum" && type != "string";
+}
+
+bool readJsonFields(UAVObjectJsonReader &reader, UAVSettingsSnapshot::Object &object)
+{
+    if (reader.readNext() != UAVObjectJsonReader::StartArray) {
+        return false;
+    }
+    while (reader.readNext() == UAVObjectJsonReader::StartObject) {
+        UAVSettingsSnapshot::Field field;
+        while (reader.readNext() == UAVObjectJsonReader::Name) {
+            if (reader.name() == "name") {
+                field.name = reader.readValue().toString();
+            } else if (reader.name() == "type") {
+                field.type = reader.readValue().toString();
+            } else if (reader.name() == "unit") {
+                field.unit = reader.readValue().toString();
+            } else if (reader.name() == "values") {
+                if (reader.readNext() != UAVObjectJsonReader::StartArray) {
+                    return false;
+                }
+                while (reader.readNext() == UAVObjectJsonReader::StartObject) {
+                    QString element;
+                    QString value;
+                    while (reader.readNext() == UAVObjectJsonReader::Name) {
+                        if (reader.name() == "name") {
+                            element = reader.readValue().toString();
+                        } else if (reader.name() == "value") {
+                            value = valueToString(reader.readValue());
+                        } else {
+                            reader.skipValue();
+                        }
+                    }
+                    field.elements << element;
+                    field.values << value;
+                }
+            } else {
+                reader.skipValue();
+            }
+        }
+        object.fields << field;
+    }
+    return !reader.hasError();
+}
+}
+
+const UAVSettingsSnapshot::Field *UAVSettingsSnapshot::Object::field(const QString &name) const
+{
+    for (int i = 0; i < fields.length(); ++i) {
+        if (fields.at(i).name == name) {
+            return &fields.at(i);
+        }
+    }
+    return NULL;
+}
+
+QString UAVSettingsSnapshot::Difference::toString() const
+{
+    QString path = QString("%1[%2]").arg(object).arg(instance);
+
+    if (field.isEmpty()) {
+        return QString(kind == Added ? "+ %1" : "- %1").arg(path);
+    }
+    path += "." + field;
+    if (!element.isEmpty()) {
+        path += "[" + element + "]";
+    }
+    switch (kind) {
+    case Added:
+        return QString("+ %1 = %2").arg(path).arg(to);
+
+    case Removed:
+        return QString("- %1 = %2").arg(path).arg(from);
+
+    default:
+        return QString("~ %1: %2 -> %3").arg(path).arg(from).arg(to);
+    }
+}
+
+UAVSettingsSnapshot::UAVSettingsSnapshot()
+{}
+
+bool UAVSettingsSnapshot::setError(const QString &error)
+{
+    m_error = error;
+    return false;
+}
+
+/**
+ * Read a vehicle template or a JSON export, the layout of UAVObjectManager::toJson()
+ * @returns false on a syntax error
+ */
+bool UAVSettingsSnapshot::readJson(QIODevice *device)
+{
+    UAVObjectJsonReader reader(device);
+
+    if (reader.readNext() != UAVObjectJsonReader::StartObject) {
+        return setError("not a JSON object");
+    }
+    while (reader.readNext() == UAVObjectJsonReader::Name) {
+        if (reader.name() != "objects") {
+            reader.skipValue();
+            continue;
+        }
+        if (reader.readNext() != UAVObjectJsonReader::StartArray) {
+            return setError("\"objects\" is not an array");
+        }
+        while (reader.readNext() == UAVObjectJsonReader::StartObject) {
+            Object object;
+            while (reader.readNext() == UAVObjectJsonReader::Name) {
+                if (reader.name() == "name") {
+                    object.name = reader.readValue().toString();
+                } else if (reader.name() == "id") {
+                    object.id = reader.readValue().toString().toUInt(NULL, 16);
+                } else if (reader.name() == "instance") {
+                    object.instance = reader.readValue().toUInt();
+                } else if (reader.name() == "setting") {
+                    object.setting = reader.readValue().toBool();
+                } else if (reader.name() == "fields") {
+                    if (!readJsonFields(reader, object)) {
+                        return setError("invalid fields of " + object.name);
+                    }
+                } else {
+                    reader.skipValue();
+                }
+            }
+            if (reader.hasError()) {
+                break;
+            }
+            insert(object);
+        }
+    }
+    if (reader.hasError() || reader.tokenType() != UAVObjectJsonReader::EndObject) {
+        return setError("JSON syntax error");
+    }
+    return true;
+}
+
+/**
+ * Read an export of the settings import/export plugin, the values of a field are
+ * comma separated in the element order and the files have only instance 0
+ */
+bool UAVSettingsSnapshot::readXml(QIODevice *device)
+{
+    QXmlStreamReader reader(device);
+    bool setting = true;
+    Object object;
+    bool inObject = false;
+
+    while (!reader.atEnd()) {
+        switch (reader.readNext()) {
+        case QXmlStreamReader::StartElement:
+            if (reader.name() == "settings") {
+                setting = true;
+            } else if (reader.name() == "data") {
+                setting = false;
+            } else if (reader.name() == "object") {
+                object = Object();
+                object.name     = reader.attributes().value("name").toString();
+                object.id       = reader.attributes().value("id").toString().toUInt(NULL, 16);
+                object.setting  = setting;
+                inObject = true;
+            } else if (reader.name() == "field" && inObject) {
+                Field field;
+                field.name   = reader.attributes().value("name").toString();
+                field.type   = reader.attributes().value("type").toString();
+                field.unit   = reader.attributes().value("units").toString();
+                field.values = reader.attributes().value("values").toString().split(",");
+                object.fields << field;
+            }
+            break;
+
+        case QXmlStreamReader::EndElement:
+            if (reader.name() == "object" && inObject) {
+                insert(object);
+                inObject = false;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+    if (reader.hasError()) {
+        return setError(QString("line %1: %2").arg(reader.lineNumber()).arg(reader.errorString()));
+    }
+    return true;
+}
+
+/**
+ * Read a file in any of the formats, the JSON files start with an object
+ */
+bool UAVSettingsSnapshot::readFile(const QString &fileName)
+{
+    QFile file(fileName);
+
+    m_fileName = fileName;
+    if (!file.open(QFile::ReadOnly)) {
+        return setError(file.errorString());
+    }
+
+    char c = 0;
+    while (file.peek(&c, 1) == 1 && QChar(c).isSpace()) {
+        file.getChar(&c);
+    }
+    return c == '{' ? readJson(&file) : readXml(&file);
+}
+
+/**
+ * Write the snapshot with the layout of UAVObjectManager::toJson(), the members
+ * of header are written before the objects
+ * @returns false if the device failed
+ */
+bool UAVSettingsSnapshot::writeJson(QIODevice *device, const QJsonObject &header) const
+{
+    UAVObjectJsonWriter writer(device);
+
+    writer.writeStartObject();
+    for (QJsonObject::const_iterator member = header.constBegin(); member != header.constEnd(); ++member) {
+        writer.writeValue(member.key(), member.value());
+    }
+    writer.writeStartArray("objects");
+    foreach(const Object &object, m_objects) {
+        writer.writeStartObject();
+        writer.writeValue("name", object.name);
+        writer.writeValue("setting", object.setting);
+        writer.writeValue("id", QString("%1").arg(object.id, 1, 16).toUpper());
+        writer.writeValue("instance", (int)object.instance);
+        writer.writeStartArray("fields");
+        foreach(const Field &field, object.fields) {
+            writer.writeStartObject();
+            writer.writeValue("name", field.name);
+            writer.writeValue("type", field.type);
+            writer.writeValue("unit", field.unit);
+            writer.writeStartArray("values");
+            for (int n = 0; n < field.values.length(); ++n) {
+                bool ok = false;
+                double number = isNumeric(field.type) ? field.values.at(n).toDouble(&ok) : 0;
+                writer.writeStartObject();
+                writer.writeValue("name", field.elements.value(n, QString::number(n)));
+                if (ok) {
+                    writer.writeValue("value", number);
+                } else {
+                    writer.writeValue("value", field.values.at(n));
+                }
+                writer.writeEndObject();
+            }
+            writer.writeEndArray();
+            writer.writeEndObject();
+        }
+        writer.writeEndArray();
+        writer.writeEndObject();
+    }
+    writer.writeEndArray();
+    writer.writeEndObject();
+    return writer.flush();
+}
+
+void UAVSettingsSnapshot::insert(const Object &object)
+{
+    m_objects.insert(Key(object.name, object.instance), object);
+}
+
+const UAVSettingsSnapshot::Object *UAVSettingsSnapshot::object(const QString &name, quint32 instance) const
+{
+    QMap<Key, Object>::const_iterator it = m_objects.constFind(Key(name, instance));
+
+    return it != m_objects.constEnd() ? &it.value() : NULL;
+}
+
+QList<UAVSettingsSnapshot::Object> UAVSettingsSnapshot::objects() const
+{
+    return m_objects.values();
+}
+
+bool UAVSettingsSnapshot::isEmpty() const
+{
+    return m_objects.isEmpty();
+}
+
+QString UAVSettingsSnapshot::fileName() const
+{
+    return m_fileName;
+}
+
+QString UAVSettingsSnapshot::errorString() const
+{
+    return m_error;
+}
+
+namespace {
+void diffFields(const UAVSettingsSnapshot::Object &object, const UAVSettingsSnapshot::Field &from,
+                const UAVSettingsSnapshot::Field &to, QList<UAVSettingsSnapshot::Difference> &differences)
+{
+    UAVSettingsSnapshot::Difference difference;
+
+    difference.kind     = UAVSettingsSnapshot::Difference::Changed;
+    difference.object   = object.name;
+    difference.instance = object.instance;
+    difference.field    = from.name;
+
+    // Match the elements by name when both files have them, else by position
+    if (!from.elements.isEmpty() && !to.elements.isEmpty()) {
+        for (int n = 0; n < from.elements.length(); ++n) {
+            int index = to.elements.indexOf(from.elements.at(n));
+            difference.element = from.elements.at(n);
+            difference.from    = from.values.value(n);
+            difference.to      = to.values.value(index);
+            if (index < 0) {
+                difference.kind = UAVSettingsSnapshot::Difference::Removed;
+                differences << difference;
+            } else if (!valuesEqual(difference.from, difference.to)) {
+                difference.kind = UAVSettingsSnapshot::Difference::Changed;
+                differences << difference;
+            }
+        }
+        for (int n = 0; n < to.elements.length(); ++n) {
+            if (!from.elements.contains(to.elements.at(n))) {
+                difference.kind    = UAVSettingsSnapshot::Difference::Added;
+                difference.element = to.elements.at(n);
+                difference.from    = QString();
+                difference.to      = to.values.value(n);
+                differences << difference;
+            }
+        }
+        return;
+    }
+
+    const QStringList &names = from.elements.isEmpty() ? to.elements : from.elements;
+    int count = qMax(from.values.length(), to.values.length());
+    for (int n = 0; n < count; ++n) {
+        difference.element = names.value(n, count > 1 ? QString::number(n) : QString());
+        difference.from    = from.values.value(n);
+        difference.to      = to.values.value(n);
+        if (n >= to.values.length()) {
+            difference.kind = UAVSettingsSnapshot::Difference::Removed;
+        } else if (n >= from.values.length()) {
+            difference.kind = UAVSettingsSnapshot::Difference::Added;
+        } else if (!valuesEqual(difference.from, difference.to)) {
+            difference.kind = UAVSettingsSnapshot::Difference::Changed;
+        } else {
+            continue;
+        }
+        differences << difference;
+    }
+}
+}
+
+/**
+ * Compare the snapshots field by field, the objects and fields missing in one of
+ * them are reported as a whole. The differences are sorted by object name.
+ */
+QList<UAVSettingsSnapshot::Difference> UAVSettingsSnapshot::diff(const UAVSettingsSnapshot &other) const
+{
+    QList<Difference> differences;
+    QMap<Key, Object>::const_iterator from = m_objects.constBegin();
+    QMap<Key, Object>::const_iterator to   = other.m_objects.constBegin();
+
+    // Merge the two sorted maps
+    while (from != m_objects.constEnd() || to != other.m_objects.constEnd()) {
+        Difference difference;
+        if (to == other.m_objects.constEnd() || (from != m_objects.constEnd() && from.key() < to.key())) {
+            difference.kind     = Difference::Removed;
+            difference.object   = from.key().first;
+            difference.instance = from.key().second;
+            differences << difference;
+            ++from;
+            continue;
+        }
+        if (from == m_objects.constEnd() || to.key() < from.key()) {
+            difference.kind     = Difference::Added;
+            difference.object   = to.key().first;
+            difference.instance = to.key().second;
+            differences << difference;
+            ++to;
+            continue;
+        }
+
+        difference.object   = from.key().first;
+        difference.instance = from.key().second;
+        foreach(const Field &field, from.value().fields) {
+            const Field *otherField = to.value().field(field.name);
+            if (otherField) {
+                diffFields(from.value(), field, *otherField, differences);
+            } else {
+                difference.kind  = Difference::Removed;
+                difference.field = field.name;
+                difference.from  = field.values.join(",");
+                difference.to    = QString();
+                differences << difference;
+            }
+        }
+        foreach(const Field &field, to.value().fields) {
+            if (!from.value().field(field.name)) {
+                difference.kind  = Difference::Added;
+                difference.field = field.name;
+                difference.from  = QString();
+                difference.to    = field.values.join(",");
+                differences << difference;
+            }
+        }
+        ++from;
+        ++to;
+    }
+    return differences;
+}
+
+UAVSettingsSnapshot UAVSettingsSnapshot::loadFile(const QString &fileName)
+{
+    UAVSettingsSnapshot snapshot;
+
+    if (!snapshot.readFile(fileName)) {
+        // Keep the error, not a partial snapshot
+        snapshot.m_objects.clear();
+    }
+    return snapshot;
+}
+
+QFuture<UAVSettingsSnapshot> UAVSettingsSnapshot::loadFiles(const QStringList &fileNames)
+{
+    return QtConcurrent::mapped(fileNames, &UAVSettingsSnapshot::loadFile);
+}
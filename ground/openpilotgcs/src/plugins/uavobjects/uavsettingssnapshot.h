@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavsettingssnapshot.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVSETTINGSSNAPSHOT_H
+#define UAVSETTINGSSNAPSHOT_H
+
+#include "uavobjects_global.h"
+#include <QIODevice>
+#include <QFuture>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Plain copy of the object values, independent of the UAVObjectManager and of
+ * the GUI thread. A snapshot is read from a vehicle template or a settings
+ * export (JSON or the XML of the settings import/export plugin), or taken from
+ * the manager with UAVObjectManager::toSettingsSnapshot(), and compared field
+ * by field with diff(). The values are kept as strings, enums by their option.
+ */
+class UAVOBJECTS_EXPORT UAVSettingsSnapshot {
+public:
+    struct Field {
+        QString name;
+        QString type;
+        QString unit;
+        QStringList elements; // empty when the file only has the values
+        QStringList values;
+    };
+
+    struct Object {
+        Object() : id(0), instance(0), setting(true) {}
+        QString name;
+        quint32 id;
+        quint32 instance;
+        bool setting;
+        QList<Field> fields;
+
+        const Field *field(const QString & name) const;
+    };
+
+    struct Difference {
+        typedef enum { Changed, Added, Removed } Kind;
+        Kind kind;
+        QString object;
+        quint32 instance;
+        QString field; // empty when the whole object was added or removed
+        QString element;
+        QString from;
+        QString to;
+
+        QString toString() const;
+    };
+
+    UAVSettingsSnapshot();
+
+    bool readJson(QIODevice *device);
+    bool readXml(QIODevice *device);
+    bool readFile(const QString & fileName);
+    bool writeJson(QIODevice *device, const QJsonObject &header = QJsonObject()) const;
+
+    void insert(const Object &object);
+    const Object *object(const QString & name, quint32 instance = 0) const;
+    QList<Object> objects() const;
+    bool isEmpty() const;
+
+    QString fileName() const;
+    QString errorString() const;
+
+    // The differences to go from this snapshot to other
+    QList<Difference> diff(const UAVSettingsSnapshot &other) const;
+
+    // Read the files on worker threads, the results are in the order of the names.
+    // A file that failed is an empty snapshot with its errorString() set.
+    static UAVSettingsSnapshot loadFile(const QString & fileName);
+    static QFuture<UAVSettingsSnapshot> loadFiles(const QStringList &fileNames);
+
+private:
+    typedef QPair<QString, quint32> Key;
+
+    QMap<Key, Object> m_objects;
+    QString m_fileName;
+    QString m_error;
+
+    bool setError(const QString & error);
+};
+
+#endif // UAVSETTINGSSNAPSHOT_H
@@ -36,6 +36,7 @@
 #include <string.h>
 
 static guint global_op_uavtalk_port = 9000;
+static gboolean global_op_uavtalk_dissect_objects = TRUE;
 
 static int proto_op_uavtalk = -1;
 
@@ -121,7 +122,7 @@ static int dissect_op_uavtalk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tre
                                             payload_length);
 
         /* Check if we have an embedded objid to decode */
-        if ((packet_type == 0) || (packet_type == 2)) {
+        if (((packet_type == 0) || (packet_type == 2)) && global_op_uavtalk_dissect_objects) {
             /* Call any registered subdissector for this objid */
             if (!dissector_try_uint(uavtalk_subdissector_table, objid, next_tvb, pinfo, tree)) {
                 /* No subdissector registered, use the default data dissector */
@@ -187,6 +188,9 @@ void proto_register_op_uavtalk(void)
 
     prefs_register_uint_preference(op_uavtalk_module, "udp.port", "UAVTALK UDP port",
                                    "UAVTALK port (default 9000)", 10, &global_op_uavtalk_port);
+    prefs_register_bool_preference(op_uavtalk_module, "dissect_objects", "Dissect the UAVObjects",
+                                   "Decode the object fields, only the UAVTalk headers are dissected otherwise",
+                                   &global_op_uavtalk_dissect_objects);
 }
 
 void proto_reg_handoff_op_uavtalk(void)
@@ -107,3 +107,96 @@ void UAVObjectRequestHelper::doObjectAndWaitImpl()
 {
     m_object->requestUpdate();
 }
+
+AbstractUAVObjectBulkHelper::AbstractUAVObjectBulkHelper(QObject *parent) :
+    QObject(parent), m_window(DEFAULT_WINDOW), m_timeout(0), m_next(0), m_completed(0), m_failed(false)
+{
+    m_timeoutTimer.setSingleShot(true);
+    connect(&m_timeoutTimer, SIGNAL(timeout()), &m_eventLoop, SLOT(quit()));
+}
+
+AbstractUAVObjectBulkHelper::~AbstractUAVObjectBulkHelper()
+{}
+
+AbstractUAVObjectHelper::Result AbstractUAVObjectBulkHelper::doObjectsAndWait(const QList<UAVObject *> &objects, int window, int timeout)
+{
+    // Lock, we can't call this twice from different threads
+    QMutexLocker locker(&m_mutex);
+
+    m_objects   = objects;
+    m_window    = qMax(1, window);
+    m_timeout   = timeout;
+    m_next      = 0;
+    m_completed = 0;
+    m_failed    = false;
+
+    foreach(UAVObject * object, m_objects) {
+        connect(object, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+    }
+
+    // Start the first transactions, then wait for all of them
+    m_timeoutTimer.start(m_timeout);
+    fillWindow();
+    if (!m_failed && m_completed < m_objects.size()) {
+        m_eventLoop.exec();
+    }
+    m_timeoutTimer.stop();
+
+    foreach(UAVObject * object, m_objects) {
+        disconnect(object, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+    }
+
+    if (m_failed) {
+        return AbstractUAVObjectHelper::FAIL;
+    }
+    return (m_completed < m_objects.size()) ? AbstractUAVObjectHelper::TIMEOUT : AbstractUAVObjectHelper::SUCCESS;
+}
+
+void AbstractUAVObjectBulkHelper::fillWindow()
+{
+    while (!m_failed && m_next < m_objects.size() && (m_next - m_completed) < m_window) {
+        doObjectImpl(m_objects.at(m_next++));
+    }
+}
+
+void AbstractUAVObjectBulkHelper::transactionCompleted(UAVObject *object, bool success)
+{
+    Q_UNUSED(object)
+
+    if (!success) {
+        // Give up on the first failure, the outstanding transactions end on their own
+        m_failed = true;
+        m_eventLoop.quit();
+        return;
+    }
+
+    emit progress(++m_completed);
+    if (m_completed >= m_objects.size()) {
+        m_eventLoop.quit();
+        return;
+    }
+    m_timeoutTimer.start(m_timeout);
+    fillWindow();
+}
+
+UAVObjectBulkUpdaterHelper::UAVObjectBulkUpdaterHelper(QObject *parent) : AbstractUAVObjectBulkHelper(parent)
+{}
+
+UAVObjectBulkUpdaterHelper::~UAVObjectBulkUpdaterHelper()
+{}
+
+void UAVObjectBulkUpdaterHelper::doObjectImpl(UAVObject *object)
+{
+    object->updated();
+}
+
+UAVObjectBulkRequestHelper::UAVObjectBulkRequestHelper(QObject *parent) : AbstractUAVObjectBulkHelper(parent)
+{}
+
+UAVObjectBulkRequestHelper::~UAVObjectBulkRequestHelper()
+{}
+
+void UAVObjectBulkRequestHelper::doObjectImpl(UAVObject *object)
+{
+    object->requestUpdate();
+}
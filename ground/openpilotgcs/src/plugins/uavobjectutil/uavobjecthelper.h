@@ -30,8 +30,10 @@
 
 #include <QObject>
 #include <QEventLoop>
+#include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QTimer>
 
 #include "uavobjectutil_global.h"
 #include "uavobject.h"
@@ -82,4 +84,65 @@ protected:
     virtual void doObjectAndWaitImpl();
 };
 
+/**
+ * Runs the transactions of a list of distinct objects, keeping up to a window of them
+ * outstanding instead of waiting for each one before sending the next.
+ * Telemetry runs the transactions of different instances concurrently, so bulk transfers
+ * such as path plans are limited by the link throughput rather than by its round trip.
+ */
+class UAVOBJECTUTIL_EXPORT AbstractUAVObjectBulkHelper : public QObject {
+    Q_OBJECT
+public:
+    explicit AbstractUAVObjectBulkHelper(QObject *parent = 0);
+    virtual ~AbstractUAVObjectBulkHelper();
+
+    // the window stays well below the size of the telemetry event queue
+    static const int DEFAULT_WINDOW = 8;
+
+    // the timeout runs from the last completed transaction
+    AbstractUAVObjectHelper::Result doObjectsAndWait(const QList<UAVObject *> &objects, int window = DEFAULT_WINDOW, int timeout = 800);
+
+signals:
+    void progress(int completed);
+
+protected:
+    virtual void doObjectImpl(UAVObject *object) = 0;
+
+private slots:
+    void transactionCompleted(UAVObject *object, bool success);
+
+private:
+    QMutex m_mutex;
+    QEventLoop m_eventLoop;
+    QTimer m_timeoutTimer;
+    QList<UAVObject *> m_objects;
+    int m_window;
+    int m_timeout;
+    int m_next;
+    int m_completed;
+    bool m_failed;
+
+    void fillWindow();
+};
+
+class UAVOBJECTUTIL_EXPORT UAVObjectBulkUpdaterHelper : public AbstractUAVObjectBulkHelper {
+    Q_OBJECT
+public:
+    explicit UAVObjectBulkUpdaterHelper(QObject *parent = 0);
+    virtual ~UAVObjectBulkUpdaterHelper();
+
+protected:
+    virtual void doObjectImpl(UAVObject *object);
+};
+
+class UAVOBJECTUTIL_EXPORT UAVObjectBulkRequestHelper : public AbstractUAVObjectBulkHelper {
+    Q_OBJECT
+public:
+    explicit UAVObjectBulkRequestHelper(QObject *parent = 0);
+    virtual ~UAVObjectBulkRequestHelper();
+
+protected:
+    virtual void doObjectImpl(UAVObject *object);
+};
+
 #endif // UAVOBJECTHELPER_H
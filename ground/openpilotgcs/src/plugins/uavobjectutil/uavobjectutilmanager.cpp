@@ -35,22 +35,42 @@
 #include <QEventLoop>
 #include <QTimer>
 #include <objectpersistence.h>
+#include <objectpersistencebatch.h>
 
 #include "firmwareiapobj.h"
 #include "homelocation.h"
 #include "gpspositionsensor.h"
 
+// save requests sent ahead of their completion, as many as the board queues
+#define SAVE_WINDOW         8
+// no completion for this long fails the outstanding requests
+#define SAVE_TIMEOUT_MS     2000
+// after an unclear failure, time for the board to reply to the requests it still had
+#define SAVE_RETRY_DELAY_MS 500
+// no reply to an ObjectPersistenceBatch request for this long fails its objects
+#define BATCH_TIMEOUT_MS    5000
+
 // ******************************
 // constructor/destructor
 
 UAVObjectUtilManager::UAVObjectUtilManager()
 {
-    mutex     = new QMutex(QMutex::Recursive);
-    saveState = IDLE;
+    mutex      = new QMutex(QMutex::Recursive);
+    saveState  = IDLE;
+    ackPending = NULL;
+    serialSave = false;
     failureTimer.stop();
     failureTimer.setSingleShot(true);
-    failureTimer.setInterval(1000);
+    failureTimer.setInterval(SAVE_TIMEOUT_MS);
     connect(&failureTimer, SIGNAL(timeout()), this, SLOT(objectPersistenceOperationFailed()));
+    retryTimer.setSingleShot(true);
+    retryTimer.setInterval(SAVE_RETRY_DELAY_MS);
+    connect(&retryTimer, SIGNAL(timeout()), this, SLOT(saveNextObject()));
+    batchSequence    = 0;
+    batchUnsupported = false;
+    batchTimer.setSingleShot(true);
+    batchTimer.setInterval(BATCH_TIMEOUT_MS);
+    connect(&batchTimer, SIGNAL(timeout()), this, SLOT(objectPersistenceBatchFailed()));
 
     pm   = NULL;
     obm  = NULL;
@@ -97,44 +117,145 @@ void UAVObjectUtilManager::saveObjectToSD(UAVObject *obj)
     queue.enqueue(obj);
     qDebug() << "Enqueue object: " << obj->getName();
 
-
-    // If queue length is one, then start sending (call sendNextObject)
-    // Otherwise, do nothing, it's sending anyway
-    if (queue.length() == 1) {
-        saveNextObject();
-    }
+    // Send it now if the window allows, otherwise it goes once earlier saves complete
+    saveNextObject();
 }
 
+/*
+   Send the next save request. Several queued objects go in one ObjectPersistenceBatch
+   request, a round trip for up to ObjectPersistenceBatch::OBJECTID_NUMELEM objects.
+   Otherwise up to SAVE_WINDOW single object requests are sent ahead of their completion
+   so that the board can write them in one flash transaction.
+ */
 void UAVObjectUtilManager::saveNextObject()
 {
     if (queue.isEmpty()) {
+        if (sentQueue.isEmpty() && batchSent.isEmpty()) {
+            batchUnsupported = false;
+        }
+        return;
+    }
+    if (saveState == AWAITING_ACK || retryTimer.isActive() || !batchSent.isEmpty()) {
+        return;
+    }
+    if (queue.size() > 1 && sentQueue.isEmpty() && !serialSave && !batchUnsupported) {
+        saveNextBatch();
+        return;
+    }
+    if (sentQueue.size() >= (serialSave ? 1 : SAVE_WINDOW)) {
         return;
     }
 
-    Q_ASSERT(saveState == IDLE);
-
-    // Get next object from the queue
+    // The completions of two requests for the same object could not be told apart
     UAVObject *obj = queue.head();
+    if (sentQueue.contains(obj)) {
+        return;
+    }
+    queue.dequeue();
     qDebug() << "Send save object request to board " << obj->getName();
 
     ObjectPersistence *objper = dynamic_cast<ObjectPersistence *>(getObjectManager()->getObject(ObjectPersistence::NAME));
-    connect(objper, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(objectPersistenceTransactionCompleted(UAVObject *, bool)));
-    connect(objper, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectPersistenceUpdated(UAVObject *)));
-    saveState = AWAITING_ACK;
-    if (obj != NULL) {
-        ObjectPersistence::DataFields data;
-        data.Operation  = ObjectPersistence::OPERATION_SAVE;
-        data.Selection  = ObjectPersistence::SELECTION_SINGLEOBJECT;
-        data.ObjectID   = obj->getObjID();
-        data.InstanceID = obj->getInstID();
-        objper->setData(data);
-        objper->updated();
-    }
-    // Now: we are going to get two "objectUpdated" messages (one coming from GCS, one coming from Flight, which
-    // will confirm the object was properly received by both sides) and then one "transactionCompleted" indicating
-    // that the Flight side did not only receive the object but it did receive it without error. Last we will get
-    // a last "objectUpdated" message coming from flight side, where we'll get the results of the objectPersistence
-    // operation we asked for (saved, other).
+    connect(objper, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(objectPersistenceTransactionCompleted(UAVObject *, bool)), Qt::UniqueConnection);
+    connect(objper, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectPersistenceUpdated(UAVObject *)), Qt::UniqueConnection);
+    sentQueue.append(obj);
+    ackPending = obj;
+    saveState  = AWAITING_ACK;
+
+    ObjectPersistence::DataFields data;
+    data.Operation  = ObjectPersistence::OPERATION_SAVE;
+    data.Selection  = ObjectPersistence::SELECTION_SINGLEOBJECT;
+    data.ObjectID   = obj->getObjID();
+    data.InstanceID = obj->getInstID();
+    objper->setData(data);
+    objper->updated();
+    // Now: we are going to get one "transactionCompleted" indicating that the Flight side received the
+    // request without error, the next request can then be sent. Later we will get an "objectUpdated"
+    // message coming from flight side with the result of the last request of the batch it wrote, it also
+    // completes the requests sent before it.
+}
+
+/*
+   Send the queued objects in one ObjectPersistenceBatch request, the reply gives the
+   result of each
+ */
+void UAVObjectUtilManager::saveNextBatch()
+{
+    ObjectPersistenceBatch *batch = ObjectPersistenceBatch::GetInstance(getObjectManager());
+
+    Q_ASSERT(batch);
+    connect(batch, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(objectPersistenceBatchTransactionCompleted(UAVObject *, bool)), Qt::UniqueConnection);
+    connect(batch, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectPersistenceBatchUpdated(UAVObject *)), Qt::UniqueConnection);
+
+    ObjectPersistenceBatch::DataFields data;
+    memset(&data, 0, sizeof(data));
+    data.Operation = ObjectPersistenceBatch::OPERATION_SAVE;
+    data.Sequence  = ++batchSequence;
+
+    // A repeated save of an object goes in the next batch
+    while (!queue.isEmpty() && batchSent.size() < (int)ObjectPersistenceBatch::OBJECTID_NUMELEM && !batchSent.contains(queue.head())) {
+        UAVObject *obj = queue.dequeue();
+        data.ObjectID[batchSent.size()]   = obj->getObjID();
+        data.InstanceID[batchSent.size()] = obj->getInstID();
+        batchSent.append(obj);
+    }
+    data.Count = batchSent.size();
+    qDebug() << "Send save request of " << data.Count << " objects to board";
+
+    batch->setData(data);
+    batch->updated();
+    batchTimer.start();
+}
+
+/**
+ * @brief The ObjectPersistenceBatch request was sent, or not
+ *
+ * A failed transaction is usually a firmware without ObjectPersistenceBatch, its objects are
+ * then saved with single object requests until the queue is empty.
+ */
+void UAVObjectUtilManager::objectPersistenceBatchTransactionCompleted(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    if (success || batchSent.isEmpty()) {
+        return;
+    }
+    qDebug() << "ObjectPersistenceBatch request failed, saving the objects one by one";
+    batchTimer.stop();
+    while (!batchSent.isEmpty()) {
+        queue.prepend(batchSent.takeLast());
+    }
+    batchUnsupported = true;
+
+    saveNextObject();
+}
+
+/**
+ * @brief Process the reply to the ObjectPersistenceBatch request, with the result of each object
+ */
+void UAVObjectUtilManager::objectPersistenceBatchUpdated(UAVObject *obj)
+{
+    ObjectPersistenceBatch::DataFields data = static_cast<ObjectPersistenceBatch *>(obj)->getData();
+
+    if (data.Operation != ObjectPersistenceBatch::OPERATION_COMPLETED || data.Sequence != batchSequence || batchSent.isEmpty()) {
+        return;
+    }
+    batchTimer.stop();
+    for (int i = 0; !batchSent.isEmpty(); i++) {
+        emit saveCompleted(batchSent.takeFirst()->getObjID(), !(data.Failed & (1 << i)));
+    }
+
+    saveNextObject();
+}
+
+/**
+ * @brief No reply to the ObjectPersistenceBatch request
+ */
+void UAVObjectUtilManager::objectPersistenceBatchFailed()
+{
+    while (!batchSent.isEmpty()) {
+        emit saveCompleted(batchSent.takeFirst()->getObjID(), false);
+    }
+
+    saveNextObject();
 }
 
 /**
@@ -142,33 +263,35 @@ void UAVObjectUtilManager::saveNextObject()
  * @param[in] The object just transsacted.  Must be ObjectPersistance
  * @param[in] success Indicates that the transaction did not time out
  *
- * After a failed transaction (usually timeout) resends the save request.  After a succesful
- * transaction will then wait for a save completed update from the autopilot.
+ * After a failed transaction (usually timeout) the request is failed, the board never got it.
+ * After a succesful transaction the next request can be sent while waiting for the completion.
  */
 void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject *obj, bool success)
 {
+    Q_ASSERT(obj->getName().compare("ObjectPersistence") == 0);
+    Q_UNUSED(obj);
+    if (saveState != AWAITING_ACK) {
+        return;
+    }
+    saveState = AWAITING_COMPLETED;
+
     if (success) {
-        Q_ASSERT(obj->getName().compare("ObjectPersistence") == 0);
-        Q_ASSERT(saveState == AWAITING_ACK);
-        // Two things can happen:
-        // Either the Object Save Request did actually go through, and then we should get in
-        // "AWAITING_COMPLETED" mode, or the Object Save Request did _not_ go through, for example
-        // because the object does not exist and then we will never get a subsequent update.
-        // For this reason, we will arm a 1 second timer to make provision for this and not block
+        // The request may not be accepted by the board, for example because the object
+        // does not exist, and then we will never get a subsequent update.
+        // For this reason, we will arm a timer to make provision for this and not block
         // the queue:
-        saveState = AWAITING_COMPLETED;
-        disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(objectPersistenceTransactionCompleted(UAVObject *, bool)));
-        failureTimer.start(2000); // Create a timeout
-    } else {
+        failureTimer.start();
+    } else if (sentQueue.removeOne(ackPending)) {
         // Can be caused by timeout errors on sending.  Forget it and send next.
         qDebug() << "objectPersistenceTranscationCompleted (error)";
-        UAVObject *obj = getObjectManager()->getObject(ObjectPersistence::NAME);
-        obj->disconnect(this);
-        queue.dequeue(); // We can now remove the object, it failed anyway.
-        saveState = IDLE;
-        emit saveCompleted(obj->getField("ObjectID")->getValue().toInt(), false);
-        saveNextObject();
+        emit saveCompleted(ackPending->getObjID(), false);
+        if (sentQueue.isEmpty()) {
+            failureTimer.stop();
+        }
     }
+    ackPending = NULL;
+
+    saveNextObject();
 }
 
 /**
@@ -177,24 +300,17 @@ void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject *obj,
  */
 void UAVObjectUtilManager::objectPersistenceOperationFailed()
 {
-    if (saveState == AWAITING_COMPLETED) {
-        // TODO: some warning that this operation failed somehow
-        // We have to disconnect the object persistence 'updated' signal
-        // and ask to save the next object:
-
-        ObjectPersistence *objectPersistence = ObjectPersistence::GetInstance(getObjectManager());
-        Q_ASSERT(objectPersistence);
-
-        UAVObject *obj = queue.dequeue(); // We can now remove the object, it failed anyway.
-        Q_ASSERT(obj);
-
-        objectPersistence->disconnect(this);
-
-        saveState = IDLE;
-        emit saveCompleted(obj->getObjID(), false);
-
-        saveNextObject();
+    // TODO: some warning that this operation failed somehow
+    while (!sentQueue.isEmpty()) {
+        emit saveCompleted(sentQueue.takeFirst()->getObjID(), false);
+    }
+    saveState  = IDLE;
+    ackPending = NULL;
+    if (queue.isEmpty()) {
+        serialSave = false;
     }
+
+    saveNextObject();
 }
 
 
@@ -202,6 +318,10 @@ void UAVObjectUtilManager::objectPersistenceOperationFailed()
  * @brief Process the ObjectPersistence updated message to confirm the right object saved
  * then requests next object be saved.
  * @param[in] The object just received.  Must be ObjectPersistance
+ *
+ * A completion completes the requests sent up to the one it names. A failure while several
+ * requests are outstanding does not tell which ones were saved, they are all sent again one
+ * at a time once the board had the time to reply to the requests it still had.
  */
 void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject *obj)
 {
@@ -209,26 +329,48 @@ void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject *obj)
     Q_ASSERT(obj->getObjID() == ObjectPersistence::OBJID);
     ObjectPersistence::DataFields objectPersistence = ((ObjectPersistence *)obj)->getData();
 
-    if (saveState == AWAITING_COMPLETED && objectPersistence.Operation == ObjectPersistence::OPERATION_ERROR) {
-        failureTimer.stop();
-        objectPersistenceOperationFailed();
-    } else if (saveState == AWAITING_COMPLETED &&
-               objectPersistence.Operation == ObjectPersistence::OPERATION_COMPLETED) {
-        failureTimer.stop();
-        // Check right object saved
-        UAVObject *savingObj = queue.head();
-        if (objectPersistence.ObjectID != savingObj->getObjID()) {
-            objectPersistenceOperationFailed();
-            return;
-        }
+    if (objectPersistence.Operation != ObjectPersistence::OPERATION_COMPLETED &&
+        objectPersistence.Operation != ObjectPersistence::OPERATION_ERROR) {
+        return;
+    }
+
+    // Check right object saved, the last request for it
+    int last = sentQueue.size() - 1;
+    while (last >= 0 && (sentQueue[last]->getObjID() != objectPersistence.ObjectID ||
+                         sentQueue[last]->getInstID() != objectPersistence.InstanceID)) {
+        last--;
+    }
+    if (last < 0) {
+        return;
+    }
 
-        obj->disconnect(this);
-        queue.dequeue(); // We can now remove the object, it's done.
-        saveState = IDLE;
+    if (objectPersistence.Operation == ObjectPersistence::OPERATION_COMPLETED) {
+        for (int i = 0; i <= last; i++) {
+            emit saveCompleted(sentQueue.takeFirst()->getObjID(), true);
+        }
+    } else {
+        if (serialSave || sentQueue.size() == 1) {
+            emit saveCompleted(sentQueue.takeFirst()->getObjID(), false);
+        } else {
+            while (!sentQueue.isEmpty()) {
+                queue.prepend(sentQueue.takeLast());
+            }
+            serialSave = true;
+        }
+        // the board fails the requests it gets shortly after a failure
+        retryTimer.start();
+    }
 
-        emit saveCompleted(objectPersistence.ObjectID, true);
-        saveNextObject();
+    if (sentQueue.isEmpty()) {
+        failureTimer.stop();
+        if (queue.isEmpty()) {
+            serialSave = false;
+        }
+    } else {
+        failureTimer.start();
     }
+
+    saveNextObject();
 }
 
 /**
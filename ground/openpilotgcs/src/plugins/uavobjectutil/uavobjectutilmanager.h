@@ -76,9 +76,21 @@ signals:
 private:
     QMutex *mutex;
     QQueue<UAVObject *> queue;
+    // save requests sent and not completed yet, in the order they were sent
+    QList<UAVObject *> sentQueue;
+    // the request whose transaction is not acknowledged yet
+    UAVObject *ackPending;
     enum { IDLE, AWAITING_ACK, AWAITING_COMPLETED } saveState;
-    void saveNextObject();
+    // one request at a time after a failure, until the queue is empty
+    bool serialSave;
     QTimer failureTimer;
+    QTimer retryTimer;
+    // save requests of the ObjectPersistenceBatch request waiting for its reply
+    QList<UAVObject *> batchSent;
+    quint8 batchSequence;
+    // single object requests until the queue is empty, if the board does not know batches
+    bool batchUnsupported;
+    QTimer batchTimer;
 
     ExtensionSystem::PluginManager *pm;
     UAVObjectManager *obm;
@@ -86,6 +98,11 @@ private:
 
 private slots:
     // void transactionCompleted(UAVObject *obj, bool success);
+    void saveNextObject();
+    void saveNextBatch();
+    void objectPersistenceBatchTransactionCompleted(UAVObject *obj, bool success);
+    void objectPersistenceBatchUpdated(UAVObject *obj);
+    void objectPersistenceBatchFailed();
     void objectPersistenceTransactionCompleted(UAVObject *obj, bool success);
     void objectPersistenceUpdated(UAVObject *obj);
     void objectPersistenceOperationFailed();
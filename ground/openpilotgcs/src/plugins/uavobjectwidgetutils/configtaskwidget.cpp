@@ -297,7 +297,14 @@ void ConfigTaskWidget::refreshWidgetsValues(UAVObject *obj)
     foreach(WidgetBinding * binding, bindings) {
         if (binding->field() != NULL && binding->widget() != NULL) {
             if (binding->isEnabled()) {
-                setWidgetFromField(binding->widget(), binding->field(), binding);
+                // Object updates only refresh the widgets of the changed fields
+                QVariant value = binding->field()->getValue(binding->index());
+                if (obj != NULL && binding->isDisplayed(value)) {
+                    continue;
+                }
+                if (setWidgetFromField(binding->widget(), binding->field(), binding)) {
+                    binding->setDisplayedValue(value);
+                }
             } else {
                 binding->updateValueFromObjectField();
             }
@@ -406,6 +413,7 @@ void ConfigTaskWidget::widgetsContentsChanged()
 
     foreach(WidgetBinding * binding, m_widgetBindingsPerWidget.values(emitter)) {
         if (binding && binding->isEnabled()) {
+            binding->setDisplayedValue(QVariant());
             if (binding->widget() == emitter) {
                 value = getVariantFromWidget(emitter, binding);
                 checkWidgetsLimits(emitter, binding->field(), binding->index(), binding->isLimited(), value, binding->scale());
@@ -1012,11 +1020,7 @@ void ConfigTaskWidget::loadWidgetLimits(QWidget *widget, UAVObjectField *field,
             // valid or not. Ultimately this method will be called again when the connected
             // signal is handled.
             if (m_currentBoardId > -1) {
-                foreach(QString str, option) {
-                    if (field->isWithinLimits(str, index, m_currentBoardId)) {
-                        cb->addItem(str);
-                    }
-                }
+                cb->addItems(field->getOptionsWithinLimits(index, m_currentBoardId));
             }
         } else {
             cb->addItems(option);
@@ -1204,6 +1208,19 @@ void WidgetBinding::setValue(const QVariant &value)
      */
 }
 
+/**
+ * True when the widget still shows this field value
+ */
+bool WidgetBinding::isDisplayed(const QVariant &value) const
+{
+    return m_displayedValue.isValid() && m_displayedValue == value;
+}
+
+void WidgetBinding::setDisplayedValue(const QVariant &value)
+{
+    m_displayedValue = value;
+}
+
 void WidgetBinding::updateObjectFieldFromValue()
 {
     if (m_value.isValid()) {
@@ -85,6 +85,9 @@ public:
     QVariant value() const;
     void setValue(const QVariant &value);
 
+    bool isDisplayed(const QVariant &value) const;
+    void setDisplayedValue(const QVariant &value);
+
     void updateObjectFieldFromValue();
     void updateValueFromObjectField();
 
@@ -95,6 +98,8 @@ private:
     bool m_isEnabled;
     QList<ShadowWidgetBinding *> m_shadows;
     QVariant m_value;
+    // The field value last shown by the widget, invalid once the widget is edited
+    QVariant m_displayedValue;
 };
 
 class UAVOBJECTWIDGETUTILS_EXPORT ConfigTaskWidget : public QWidget {
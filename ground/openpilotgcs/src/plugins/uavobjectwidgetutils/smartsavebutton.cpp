@@ -26,6 +26,7 @@
  */
 #include "smartsavebutton.h"
 #include "configtaskwidget.h"
+#include "uavobjecthelper.h"
 
 SmartSaveButton::SmartSaveButton(ConfigTaskWidget *configTaskWidget) : configWidget(configTaskWidget)
 {}
@@ -75,18 +76,28 @@ void SmartSaveButton::processOperation(QPushButton *button, bool save)
     bool error = false;
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectUtilManager *utilMngr     = pm->getObject<UAVObjectUtilManager>();
+
+    // Should we really save these objects to the board?
+    QList<UAVDataObject *> toSave;
+    QList<UAVObject *> toUpload;
     foreach(UAVDataObject * obj, objects) {
         UAVObject::Metadata mdata = obj->getMetadata();
-
-        // Should we really save this object to the board?
         if (!configWidget->shouldObjectBeSaved(obj) || UAVObject::GetGcsAccess(mdata) == UAVObject::ACCESS_READONLY) {
             qDebug() << obj->getName() << "was skipped.";
             continue;
         }
+        toSave << obj;
+        toUpload << obj;
+    }
 
-        up_result = false;
+    // Upload them all with several transactions outstanding, the objects are
+    // then uploaded one by one only if that does not get through
+    UAVObjectBulkUpdaterHelper bulkHelper;
+    bool uploaded = (bulkHelper.doObjectsAndWait(toUpload, UAVObjectBulkUpdaterHelper::DEFAULT_WINDOW, 3000) == UAVObjectUpdaterHelper::SUCCESS);
+    foreach(UAVDataObject * obj, toSave) {
+        up_result = uploaded;
         current_object = obj;
-        for (int i = 0; i < 3; ++i) {
+        for (int i = 0; i < 3 && !up_result; ++i) {
             qDebug() << "Uploading" << obj->getName() << "to board.";
             connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transaction_finished(UAVObject *, bool)));
             connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
@@ -112,33 +123,38 @@ void SmartSaveButton::processOperation(QPushButton *button, bool save)
             continue;
         }
 
-        sv_result = false;
-        current_objectID = obj->getObjID();
         if (save && (obj->isSettingsObject())) {
-            for (int i = 0; i < 3; ++i) {
-                qDebug() << "Saving" << obj->getName() << "to board.";
-                connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
-                connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
-                utilMngr->saveObjectToSD(obj);
-
-                timer.start(3000);
-                loop.exec();
-                if (!timer.isActive()) {
-                    qDebug() << "Saving of" << obj->getName() << "timed out.";
-                }
-                timer.stop();
-
-                disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
-                disconnect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
-                if (sv_result) {
-                    qDebug() << "Saving of" << obj->getName() << "successful.";
-                    break;
-                }
-            }
-            if (sv_result == false) {
-                qDebug() << "Saving of" << obj->getName() << "failed after 3 tries.";
-                error = true;
+            pendingSaves << obj;
+        }
+    }
+
+    // Queue all the saves at once so that they are sent in batches, a failed save
+    // is queued again up to 3 times
+    if (!pendingSaves.isEmpty()) {
+        sv_result = true;
+        saveAttempts.clear();
+        connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
+        connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+        foreach(UAVDataObject * obj, pendingSaves) {
+            qDebug() << "Saving" << obj->getName() << "to board.";
+            saveAttempts[obj] = 1;
+            utilMngr->saveObjectToSD(obj);
+        }
+        while (!pendingSaves.isEmpty()) {
+            // the timeout runs from the last completion
+            timer.start(3000);
+            loop.exec();
+            if (!timer.isActive()) {
+                qDebug() << "Saving of" << pendingSaves.count() << "objects timed out.";
+                pendingSaves.clear();
+                sv_result = false;
             }
+            timer.stop();
+        }
+        disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
+        disconnect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+        if (sv_result == false) {
+            error = true;
         }
     }
     if (button) {
@@ -193,9 +209,24 @@ void SmartSaveButton::transaction_finished(UAVObject *obj, bool result)
 
 void SmartSaveButton::saving_finished(int id, bool result)
 {
-    if (id == (int)current_objectID) {
-        sv_result = result;
+    // saves complete in the order they were queued
+    foreach(UAVDataObject * obj, pendingSaves) {
+        if ((int)obj->getObjID() != id) {
+            continue;
+        }
+        if (result) {
+            qDebug() << "Saving of" << obj->getName() << "successful.";
+            pendingSaves.removeOne(obj);
+        } else if (saveAttempts[obj]++ < 3) {
+            ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+            pm->getObject<UAVObjectUtilManager>()->saveObjectToSD(obj);
+        } else {
+            qDebug() << "Saving of" << obj->getName() << "failed after 3 tries.";
+            pendingSaves.removeOne(obj);
+            sv_result = false;
+        }
         loop.quit();
+        return;
     }
 }
 
@@ -73,10 +73,12 @@ private slots:
     void saving_finished(int, bool);
 
 private:
-    quint32 current_objectID;
     UAVDataObject *current_object;
     bool up_result;
     bool sv_result;
+    // saves queued and not completed yet
+    QList<UAVDataObject *> pendingSaves;
+    QMap<UAVDataObject *, int> saveAttempts;
     QEventLoop loop;
     QList<UAVDataObject *> objects;
     QMap<QPushButton *, buttonTypeEnum> buttonList;
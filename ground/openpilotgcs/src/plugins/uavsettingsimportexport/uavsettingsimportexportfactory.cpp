@@ -42,15 +42,26 @@
 // for UAVObjects
 #include "uavdataobject.h"
 #include "uavobjectmanager.h"
+#include "uavobjectutil/uavobjecthelper.h"
 #include "extensionsystem/pluginmanager.h"
 
 // for XML object
 #include <QDomDocument>
 
+// for binary snapshots
+#include <QDataStream>
+
 // for file dialog and error messages
 #include <QFileDialog>
 #include <QMessageBox>
 
+// Binary snapshot, little endian:
+// header: magic, format version (quint16), GCS UAVO hash length (quint8) and bytes, record count (quint32)
+// record: object ID (quint32), instance ID (quint16), data size (quint16), data as packed by UAVObject::pack()
+// The object ID being a hash of the object definition, it also versions the packed data.
+#define SNAPSHOT_MAGIC   "UAVB"
+#define SNAPSHOT_VERSION 1
+
 UAVSettingsImportExportFactory::~UAVSettingsImportExportFactory()
 {
     // Do nothing
@@ -95,7 +106,7 @@ void UAVSettingsImportExportFactory::importUAVSettings()
 {
     // ask for file name
     QString fileName;
-    QString filters = tr("UAVObjects XML files (*.uav);; XML files (*.xml)");
+    QString filters = tr("UAVObjects XML files (*.uav);; XML files (*.xml);; UAVObjects binary snapshots (*.uavb)");
 
     fileName = QFileDialog::getOpenFileName(0, tr("Import UAV Settings"), "", filters);
     if (fileName.isEmpty()) {
@@ -104,6 +115,11 @@ void UAVSettingsImportExportFactory::importUAVSettings()
 
     // Now open the file
     QFile file(fileName);
+    if (fileName.endsWith(".uavb")) {
+        file.open(QFile::ReadOnly);
+        importBinarySnapshot(file.readAll());
+        return;
+    }
     QDomDocument doc("UAVObjects");
     file.open(QFile::ReadOnly | QFile::Text);
     if (!doc.setContent(file.readAll())) {
@@ -331,12 +347,122 @@ QString UAVSettingsImportExportFactory::createXMLDocument(const enum storedData
     return doc.toString(4);
 }
 
+// Create a binary snapshot of the packed objects, meant for provisioning boards
+// running the same firmware
+QByteArray UAVSettingsImportExportFactory::createBinarySnapshot(const enum storedData what)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    QList<UAVDataObject *> objects;
+    QList< QList<UAVDataObject *> > objList = objManager->getDataObjects();
+    foreach(QList<UAVDataObject *> list, objList) {
+        foreach(UAVDataObject * obj, list) {
+            if (((what == Settings) && obj->isSettingsObject()) ||
+                ((what == Data) && !obj->isSettingsObject()) ||
+                (what == Both)) {
+                objects << obj;
+            }
+        }
+    }
+
+    QByteArray snapshot;
+    QDataStream stream(&snapshot, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    QByteArray uavoHash = QByteArray::fromHex(VersionInfo::uavoHash().toLatin1());
+    stream.writeRawData(SNAPSHOT_MAGIC, 4);
+    stream << (quint16)SNAPSHOT_VERSION << (quint8)uavoHash.size();
+    stream.writeRawData(uavoHash.constData(), uavoHash.size());
+    stream << (quint32)objects.size();
+
+    QByteArray data;
+    foreach(UAVDataObject * obj, objects) {
+        data.resize(obj->getNumBytes());
+        obj->pack((quint8 *)data.data());
+        stream << (quint32)obj->getObjID() << (quint16)obj->getInstID() << (quint16)data.size();
+        stream.writeRawData(data.constData(), data.size());
+    }
+    return snapshot;
+}
+
+// Unpack the objects of a binary snapshot and send them all to the board at once
+void UAVSettingsImportExportFactory::importBinarySnapshot(const QByteArray &snapshot)
+{
+    QDataStream stream(snapshot);
+
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[4];
+    quint16 version = 0;
+    quint8 hashSize = 0;
+    quint32 count   = 0;
+    if (stream.readRawData(magic, 4) == 4 && !memcmp(magic, SNAPSHOT_MAGIC, 4)) {
+        stream >> version >> hashSize;
+        stream.skipRawData(hashSize);
+        stream >> count;
+    }
+    if (version != SNAPSHOT_VERSION || stream.status() != QDataStream::Ok) {
+        QMessageBox msgBox;
+        msgBox.setText(tr("Wrong file contents"));
+        msgBox.setInformativeText(tr("This file is not a correct UAVSettings snapshot"));
+        msgBox.setStandardButtons(QMessageBox::Ok);
+        msgBox.exec();
+        return;
+    }
+
+    emit importAboutToBegin();
+    qDebug() << "Import about to begin";
+
+    ImportSummaryDialog swui((QWidget *)Core::ICore::instance()->mainWindow());
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    swui.show();
+
+    QList<UAVObject *> objects;
+    QByteArray data;
+    for (quint32 n = 0; n < count; ++n) {
+        quint32 objId;
+        quint16 instId;
+        quint16 size;
+        stream >> objId >> instId >> size;
+        data.resize(size);
+        if (stream.readRawData(data.data(), size) != size) {
+            swui.addLine(tr("Snapshot"), "Error (File truncated)", false);
+            break;
+        }
+
+        UAVObject *obj = objManager->getObject(objId, instId);
+        if (obj == NULL) {
+            // Unknown to this GCS, or a definition changed with its ID
+            QString objName = QString("0x") + QString().setNum(objId, 16).toUpper();
+            qDebug() << "Object unknown:" << objName << instId;
+            swui.addLine(objName, "Error (Object unknown)", false);
+        } else if (size != obj->getNumBytes()) {
+            swui.addLine(obj->getName(), "Error (Object size mismatch)", false);
+        } else {
+            obj->unpack((const quint8 *)data.constData());
+            objects << obj;
+        }
+    }
+
+    // Keep a window of acknowledged updates outstanding rather than one round trip per object
+    UAVObjectBulkUpdaterHelper bulkHelper;
+    bool sent = (bulkHelper.doObjectsAndWait(objects, UAVObjectBulkUpdaterHelper::DEFAULT_WINDOW, 3000) == UAVObjectUpdaterHelper::SUCCESS);
+    foreach(UAVObject * obj, objects) {
+        swui.addLine(obj->getName(), sent ? "OK" : "Warning (Upload not acknowledged)", true);
+    }
+    qDebug() << "End import";
+    swui.exec();
+}
+
 // Slot called by the menu manager on user action
 void UAVSettingsImportExportFactory::exportUAVSettings()
 {
     // ask for file name
     QString fileName;
-    QString filters = tr("UAVObjects XML files (*.uav)");
+    QString filters = tr("UAVObjects XML files (*.uav);; UAVObjects binary snapshots (*.uavb)");
 
     fileName = QFileDialog::getSaveFileName(0, tr("Save UAVSettings File As"), "", filters);
     if (fileName.isEmpty()) {
@@ -345,19 +471,22 @@ void UAVSettingsImportExportFactory::exportUAVSettings()
 
     // If the filename ends with .xml, we will do a full export, otherwise, a simple export
     bool fullExport = false;
+    bool binary     = false;
     if (fileName.endsWith(".xml")) {
         fullExport = true;
+    } else if (fileName.endsWith(".uavb")) {
+        binary = true;
     } else if (!fileName.endsWith(".uav")) {
         fileName.append(".uav");
     }
 
-    // generate an XML first (used for all export formats as a formatted data source)
-    QString xml = createXMLDocument(Settings, fullExport);
+    // generate the XML document, or the binary snapshot
+    QByteArray content = binary ? createBinarySnapshot(Settings) : createXMLDocument(Settings, fullExport).toLatin1();
 
     // save file
     QFile file(fileName);
     if (file.open(QIODevice::WriteOnly) &&
-        (file.write(xml.toLatin1()) != -1)) {
+        (file.write(content) != -1)) {
         file.close();
     } else {
         QMessageBox::critical(0,
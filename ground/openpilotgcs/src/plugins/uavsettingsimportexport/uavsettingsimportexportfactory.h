@@ -39,6 +39,8 @@ public:
 private:
     enum storedData { Settings, Data, Both };
     QString createXMLDocument(const enum storedData, const bool fullExport);
+    QByteArray createBinarySnapshot(const enum storedData what);
+    void importBinarySnapshot(const QByteArray &snapshot);
 
 private slots:
     void importUAVSettings();
@@ -30,15 +30,19 @@
 #include "telemetrymonitor.h"
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/icore.h>
+#include <coreplugin/connectionmanager.h>
 #include <coreplugin/threadmanager.h>
 
-TelemetryManager::TelemetryManager() : m_isAutopilotConnected(false)
+TelemetryManager::TelemetryManager() : m_uavTalk(NULL), m_isAutopilotConnected(false), m_recorder(NULL)
 {
     moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
     // Get UAVObjectManager instance
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     m_uavobjectManager = pm->getObject<UAVObjectManager>();
 
+    // the latency histograms are queued to the GUI thread
+    qRegisterMetaType< QList<int> >("QList<int>");
+
     // connect to start stop signals
     connect(this, SIGNAL(myStart()), this, SLOT(onStart()), Qt::QueuedConnection);
     connect(this, SIGNAL(myStop()), this, SLOT(onStop()), Qt::QueuedConnection);
@@ -52,9 +56,46 @@ bool TelemetryManager::isConnected()
     return m_isAutopilotConnected;
 }
 
+/**
+ * Set the recorder getting a copy of all object packets of the current and
+ * later connections, NULL to stop recording.
+ */
+void TelemetryManager::setRecorder(UAVTalkRecorder *recorder)
+{
+    QMutexLocker locker(&m_recorderMutex);
+
+    m_recorder = recorder;
+    if (m_uavTalk) {
+        m_uavTalk->setRecorder(recorder);
+    }
+}
+
+/**
+ * Send the objects at once, packed in as few packets as possible. To be called
+ * from the telemetry thread, for objects whose GCS update mode is manual.
+ */
+bool TelemetryManager::sendObjectBatch(const QList<UAVObject *> & objs)
+{
+    QMutexLocker locker(&m_recorderMutex);
+
+    if (!m_uavTalk || !m_isAutopilotConnected) {
+        return false;
+    }
+    return m_uavTalk->sendObjectBatch(objs);
+}
+
+/**
+ * Upper limit in ms of a latency histogram bin, -1 for the last one.
+ */
+int TelemetryManager::latencyBinLimit(int bin)
+{
+    return TelemetryMonitor::latencyBinLimit(bin);
+}
+
 void TelemetryManager::start(QIODevice *dev)
 {
     m_telemetryDevice = dev;
+    m_linkName = Core::ICore::instance()->connectionManager()->getCurrentDevice().getConName();
     // OP-1383
     // take ownership of the device by moving it to the TelemetryManager thread (see TelemetryManager constructor)
     // this removes the following runtime Qt warning and incidentally fixes GCS crashes:
@@ -66,7 +107,10 @@ void TelemetryManager::start(QIODevice *dev)
 
 void TelemetryManager::onStart()
 {
+    m_recorderMutex.lock();
     m_uavTalk = new UAVTalk(m_telemetryDevice, m_uavobjectManager);
+    m_uavTalk->setRecorder(m_recorder);
+    m_recorderMutex.unlock();
     if (false) {
         // UAVTalk must be thread safe and for that:
         // 1- all public methods must lock a mutex
@@ -89,11 +133,14 @@ void TelemetryManager::onStart()
     }
 
     m_telemetry = new Telemetry(m_uavTalk, m_uavobjectManager);
-    m_telemetryMonitor = new TelemetryMonitor(m_uavobjectManager, m_telemetry);
+    m_telemetryMonitor = new TelemetryMonitor(m_uavobjectManager, m_telemetry, m_telemetryDevice);
 
     connect(m_telemetryMonitor, SIGNAL(connected()), this, SLOT(onConnect()));
     connect(m_telemetryMonitor, SIGNAL(disconnected()), this, SLOT(onDisconnect()));
     connect(m_telemetryMonitor, SIGNAL(telemetryUpdated(double, double)), this, SLOT(onTelemetryUpdate(double, double)));
+    connect(m_telemetryMonitor, SIGNAL(rxOverrunsUpdated(int)), this, SIGNAL(rxOverrunsUpdated(int)));
+    connect(m_telemetryMonitor, SIGNAL(latencyUpdated(QList<int>)), this, SLOT(onLatencyUpdate(QList<int>)));
+    connect(m_uavTalk, SIGNAL(timestampReceived(quint32, quint16, qint64)), m_telemetryMonitor, SLOT(timestampReceived(quint32, quint16, qint64)));
 }
 
 void TelemetryManager::stop()
@@ -111,7 +158,10 @@ void TelemetryManager::onStop()
     m_telemetryMonitor->disconnect(this);
     delete m_telemetryMonitor;
     delete m_telemetry;
+    m_recorderMutex.lock();
     delete m_uavTalk;
+    m_uavTalk = NULL;
+    m_recorderMutex.unlock();
     onDisconnect();
 }
 
@@ -132,6 +182,11 @@ void TelemetryManager::onTelemetryUpdate(double txRate, double rxRate)
     emit telemetryUpdated(txRate, rxRate);
 }
 
+void TelemetryManager::onLatencyUpdate(const QList<int> &histogram)
+{
+    emit latencyUpdated(m_linkName, histogram);
+}
+
 IODeviceReader::IODeviceReader(UAVTalk *uavTalk) : m_uavTalk(uavTalk)
 {}
 
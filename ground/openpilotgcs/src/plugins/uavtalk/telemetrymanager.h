@@ -47,11 +47,17 @@ public:
     void start(QIODevice *dev);
     void stop();
     bool isConnected();
+    void setRecorder(UAVTalkRecorder *recorder);
+    bool sendObjectBatch(const QList<UAVObject *> & objs);
+    static int latencyBinLimit(int bin);
 
 signals:
     void connected();
     void disconnected();
     void telemetryUpdated(double txRate, double rxRate);
+    void rxOverrunsUpdated(int overruns);
+    // latency histogram of the link since it is connected, see latencyBinLimit()
+    void latencyUpdated(const QString &link, const QList<int> &histogram);
     void myStart();
     void myStop();
 
@@ -59,6 +65,7 @@ private slots:
     void onConnect();
     void onDisconnect();
     void onTelemetryUpdate(double txRate, double rxRate);
+    void onLatencyUpdate(const QList<int> &histogram);
     void onStart();
     void onStop();
 
@@ -68,8 +75,11 @@ private:
     Telemetry *m_telemetry;
     TelemetryMonitor *m_telemetryMonitor;
     QIODevice *m_telemetryDevice;
+    QString m_linkName;
     bool m_isAutopilotConnected;
     QThread m_telemetryReaderThread;
+    UAVTalkRecorder *m_recorder;
+    QMutex m_recorderMutex;
 };
 
 
@@ -28,24 +28,52 @@
 #include "telemetrymonitor.h"
 #include "coreplugin/connectionmanager.h"
 #include "coreplugin/icore.h"
+#include "attitudestate.h"
+
+#include <QDateTime>
+
+// #define TELEMETRYMONITOR_DEBUG_REPORTS ///< define to log the USB report throughput
+
+// Object sent timestamped by the autopilot to measure the latency
+#define LATENCY_PROBE_OBJID AttitudeState::OBJID
+
+// Upper limits (ms) of the latency histogram bins, the last bin holds the longer latencies
+static const int latencyLimits[] = { 5, 10, 20, 50, 100, 200, 500 };
+#define LATENCY_BINS        ((int)(sizeof(latencyLimits) / sizeof(latencyLimits[0])) + 1)
 
 /**
  * Constructor
  */
-TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel) :
+TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel, QIODevice *device) :
     objMngr(objMngr),
     tel(tel),
     gcsStatsObj(GCSTelemetryStats::GetInstance(objMngr)),
     flightStatsObj(FlightTelemetryStats::GetInstance(objMngr)),
     firmwareIAPObj(FirmwareIAPObj::GetInstance(objMngr)),
+    objectHashesObj(ObjectHashes::GetInstance(objMngr)),
+    pingObj(TelemetryPing::GetInstance(objMngr)),
+    cache(objMngr),
+    hashesPage(0),
+    hashesTimer(new QTimer(this)),
     statsTimer(new QTimer(this)),
-    objPending(NULL),
     mutex(new QMutex(QMutex::Recursive)),
-    connectionTimer(new QTime())
+    connectionTimer(new QTime()),
+    device(device),
+    reportsRead(0),
+    reportsWritten(0),
+    clockOffset(0)
 {
+    for (int i = 0; i < LATENCY_BINS; i++) {
+        latencyHistogram.append(0);
+    }
+    connect(pingObj, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(pingUnpacked(UAVObject *)));
+
     // Listen for flight stats updates
     connect(flightStatsObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(flightStatsUpdated(UAVObject *)));
 
+    hashesTimer->setSingleShot(true);
+    connect(hashesTimer, SIGNAL(timeout()), this, SLOT(hashesTimeout()));
+
     // Start update timer
     connect(statsTimer, SIGNAL(timeout()), this, SLOT(processStatsUpdates()));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
@@ -67,7 +95,7 @@ TelemetryMonitor::~TelemetryMonitor()
 void TelemetryMonitor::startRetrievingObjects()
 {
     // Clear object queue
-    queue.clear();
+    stopRetrievingObjects();
     // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
     QList< QList<UAVObject *> > objs = objMngr->getObjects();
     for (int n = 0; n < objs.length(); ++n) {
@@ -90,7 +118,134 @@ void TelemetryMonitor::startRetrievingObjects()
     // Start retrieving
     qDebug() << tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects)")
         .arg(queue.length());
-    retrieveNextObject();
+
+    // Identify the board first to find the objects cached for it
+    connect(firmwareIAPObj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(boardIdentified(UAVObject *, bool)));
+    firmwareIAPObj->requestUpdate();
+}
+
+/**
+ * Called when the board identity is received, the hashes of the objects cached by a
+ * previous connection are requested, all objects are retrieved when there is no cache.
+ */
+void TelemetryMonitor::boardIdentified(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    disconnect(firmwareIAPObj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(boardIdentified(UAVObject *, bool)));
+
+    QByteArray cpuSerial;
+    FirmwareIAPObj::DataFields firmwareIapData = firmwareIAPObj->getData();
+    for (unsigned int i = 0; i < FirmwareIAPObj::CPUSERIAL_NUMELEM; i++) {
+        cpuSerial.append(firmwareIapData.CPUSerial[i]);
+    }
+
+    if (success && cpuSerial.count('\0') != cpuSerial.size() && cache.load(cpuSerial)) {
+        hashes.clear();
+        connect(objectHashesObj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(hashesTransactionCompleted(UAVObject *, bool)));
+        connect(objectHashesObj, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(hashesUnpacked(UAVObject *)));
+        requestHashesPage(0);
+    } else {
+        if (!success) {
+            // The cache is saved only for an identified board
+            cache.clear();
+        }
+        retrieveNextObjects();
+    }
+}
+
+/**
+ * Ask the autopilot for one page of object hashes
+ */
+void TelemetryMonitor::requestHashesPage(int page)
+{
+    ObjectHashes::DataFields hashesData = objectHashesObj->getData();
+
+    hashesPage = page;
+    hashesData.Operation = ObjectHashes::OPERATION_REQUEST;
+    hashesData.Page = page;
+    objectHashesObj->setData(hashesData);
+    objectHashesObj->updated();
+    hashesTimer->start(HASHES_TIMEOUT_MS);
+}
+
+/**
+ * Called when the hashes request is sent, a failure means that
+ * the autopilot does not know ObjectHashes
+ */
+void TelemetryMonitor::hashesTransactionCompleted(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    if (!success) {
+        qDebug("Object hashes not available, retrieving all objects");
+        stopRequestingHashes();
+        retrieveNextObjects();
+    }
+}
+
+/**
+ * Called when a page of hashes is received from the autopilot, once all pages
+ * are received the unchanged objects are restored from the cache
+ */
+void TelemetryMonitor::hashesUnpacked(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    ObjectHashes::DataFields hashesData = objectHashesObj->getData();
+    if (hashesData.Operation != ObjectHashes::OPERATION_COMPLETED || hashesData.Page != hashesPage) {
+        return;
+    }
+    for (unsigned int i = 0; i < ObjectHashes::OBJECTID_NUMELEM; i++) {
+        if (hashesData.ObjectID[i]) {
+            hashes.insert(hashesData.ObjectID[i], hashesData.Hash[i]);
+        }
+    }
+
+    if (hashesPage + 1 < hashesData.Pages) {
+        requestHashesPage(hashesPage + 1);
+    } else {
+        stopRequestingHashes();
+        restoreCachedObjects();
+        retrieveNextObjects();
+    }
+}
+
+void TelemetryMonitor::hashesTimeout()
+{
+    QMutexLocker locker(mutex);
+
+    qDebug("Object hashes request timed out, retrieving all objects");
+    stopRequestingHashes();
+    retrieveNextObjects();
+}
+
+void TelemetryMonitor::stopRequestingHashes()
+{
+    hashesTimer->stop();
+    disconnect(objectHashesObj, 0, this, 0);
+}
+
+/**
+ * Take out of the queue the objects restored from the cache
+ */
+void TelemetryMonitor::restoreCachedObjects()
+{
+    int restored = 0;
+
+    for (QQueue<UAVObject *>::iterator it = queue.begin(); it != queue.end();) {
+        QHash<quint32, quint32>::const_iterator hash = hashes.constFind((*it)->getObjID());
+        if (hash != hashes.constEnd() && cache.restore(*it, *hash)) {
+            it = queue.erase(it);
+            restored++;
+        } else {
+            ++it;
+        }
+    }
+    qDebug() << tr("%1 objects restored from the cache, %2 objects to retrieve").arg(restored).arg(queue.length());
 }
 
 /**
@@ -98,18 +253,28 @@ void TelemetryMonitor::startRetrievingObjects()
  */
 void TelemetryMonitor::stopRetrievingObjects()
 {
-    qDebug("Object retrieval has been cancelled");
+    if (!queue.isEmpty() || !objPending.isEmpty()) {
+        qDebug("Object retrieval has been cancelled");
+    }
     queue.clear();
+    foreach(UAVObject * obj, objPending) {
+        obj->disconnect(this);
+    }
+    objPending.clear();
+    disconnect(firmwareIAPObj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(boardIdentified(UAVObject *, bool)));
+    stopRequestingHashes();
 }
 
 /**
- * Retrieve the next object in the queue
+ * Retrieve the next objects in the queue, keeping up to RETRIEVE_WINDOW requests
+ * outstanding. Telemetry times out and retries each of them on its own.
  */
-void TelemetryMonitor::retrieveNextObject()
+void TelemetryMonitor::retrieveNextObjects()
 {
-    // If queue is empty return
-    if (queue.isEmpty()) {
+    // If all objects are retrieved return
+    if (queue.isEmpty() && objPending.isEmpty()) {
         qDebug("Object retrieval completed");
+        cache.save();
         if (firmwareIAPObj->getBoardType()) {
             emit connected();
         } else {
@@ -118,16 +283,18 @@ void TelemetryMonitor::retrieveNextObject()
         return;
     }
 
-    // Get next object from the queue
-    UAVObject *obj = queue.dequeue();
-    // qDebug( tr("Retrieving object: %1").arg(obj->getName()) );
+    while (!queue.isEmpty() && objPending.size() < RETRIEVE_WINDOW) {
+        // Get next object from the queue
+        UAVObject *obj = queue.dequeue();
+        // qDebug( tr("Retrieving object: %1").arg(obj->getName()) );
 
-    // Connect to object
-    connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+        // Connect to object
+        connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
 
-    // Request update
-    obj->requestUpdate();
-    objPending = obj;
+        // Request update, the transaction may complete right away
+        objPending.insert(obj);
+        obj->requestUpdate();
+    }
 }
 
 /**
@@ -138,15 +305,14 @@ void TelemetryMonitor::transactionCompleted(UAVObject *obj, bool success)
     Q_UNUSED(success);
     QMutexLocker locker(mutex);
 
-    if (obj == objPending) {
+    if (objPending.remove(obj)) {
         // Disconnect from sending object
         obj->disconnect(this);
-        objPending = NULL;
         // Process next object if telemetry is still available
         GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
 
         if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED) {
-            retrieveNextObject();
+            retrieveNextObjects();
         } else {
             stopRetrievingObjects();
         }
@@ -184,6 +350,108 @@ void TelemetryMonitor::firmwareIAPUpdated(UAVObject *obj)
     }
 }
 
+/**
+ * Logs the USB report throughput of the devices counting their reports (USB HID),
+ * the bytes per report show how well the reports are filled.
+ */
+void TelemetryMonitor::processReportStats(const Telemetry::TelemetryStats &telStats)
+{
+    if (!device || !device->property("reportsRead").isValid()) {
+        return;
+    }
+
+    int read    = device->property("reportsRead").toInt();
+    int written = device->property("reportsWritten").toInt();
+
+#ifdef TELEMETRYMONITOR_DEBUG_REPORTS
+    float seconds      = (float)statsTimer->interval() / 1000.0f;
+    float rxReportRate = (float)(read - reportsRead) / seconds;
+    float txReportRate = (float)(written - reportsWritten) / seconds;
+    qDebug() << "USB reports tx" << txReportRate << "/s" << (txReportRate > 0 ? telStats.txBytes / seconds / txReportRate : 0) << "bytes per report,"
+             << "rx" << rxReportRate << "/s" << (rxReportRate > 0 ? telStats.rxBytes / seconds / rxReportRate : 0) << "bytes per report";
+#else
+    Q_UNUSED(telStats);
+#endif
+
+    reportsRead    = read;
+    reportsWritten = written;
+}
+
+/**
+ * Upper limit in ms of a latency histogram bin, -1 for the last one.
+ */
+int TelemetryMonitor::latencyBinLimit(int bin)
+{
+    return bin < LATENCY_BINS - 1 ? latencyLimits[bin] : -1;
+}
+
+/**
+ * Send a ping to relate the autopilot clock to ours, it also asks the
+ * autopilot to timestamp the probe object.
+ */
+void TelemetryMonitor::sendPing()
+{
+    TelemetryPing::DataFields ping = pingObj->getData();
+
+    ping.GCSTime = (quint32)QDateTime::currentMSecsSinceEpoch();
+    ping.ProbeObjectID = LATENCY_PROBE_OBJID;
+    pingObj->setData(ping);
+    pingObj->updated();
+}
+
+/**
+ * Called when the autopilot answers a ping with its clock. Assuming the same delay
+ * both ways, the clock offset is best estimated by the ping with the shortest round trip.
+ */
+void TelemetryMonitor::pingUnpacked(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    TelemetryPing::DataFields ping = pingObj->getData();
+    ClockSample sample;
+    sample.roundTrip = (quint32)QDateTime::currentMSecsSinceEpoch() - ping.GCSTime;
+    if (sample.roundTrip > PING_TIMEOUT_MS) {
+        return;
+    }
+    sample.offset = ping.FlightTime - (ping.GCSTime + sample.roundTrip / 2);
+
+    clockSamples.enqueue(sample);
+    if (clockSamples.size() > PING_WINDOW) {
+        clockSamples.dequeue();
+    }
+    quint32 roundTrip = PING_TIMEOUT_MS;
+    foreach(const ClockSample &s, clockSamples) {
+        if (s.roundTrip <= roundTrip) {
+            roundTrip   = s.roundTrip;
+            clockOffset = s.offset;
+        }
+    }
+}
+
+/**
+ * Called for each timestamped packet, the latency is the receive time on the
+ * autopilot clock minus the timestamp (both in ms, modulo 16 bits).
+ */
+void TelemetryMonitor::timestampReceived(quint32 objId, quint16 timestamp, qint64 rxTime)
+{
+    QMutexLocker locker(mutex);
+
+    if (objId != LATENCY_PROBE_OBJID || clockSamples.isEmpty()) {
+        return;
+    }
+    qint16 latency = (qint16)((quint16)((quint32)rxTime + clockOffset) - timestamp);
+    // less than the clock estimate error
+    if (latency < 0) {
+        latency = 0;
+    }
+    int bin = 0;
+    while (bin < LATENCY_BINS - 1 && latency >= latencyLimits[bin]) {
+        bin++;
+    }
+    latencyHistogram[bin]++;
+}
+
 /**
  * Called periodically to update the statistics and connection status.
  */
@@ -210,6 +478,8 @@ void TelemetryMonitor::processStatsUpdates()
     gcsStats.RxSyncErrors += telStats.rxSyncErrors;
     gcsStats.RxCrcErrors  += telStats.rxCrcErrors;
 
+    processReportStats(telStats);
+
     // Check for a connection timeout
     bool connectionTimeout;
     if (telStats.rxObjects > 0) {
@@ -238,7 +508,14 @@ void TelemetryMonitor::processStatsUpdates()
         }
     }
 
+    // the serial connection counts the bytes lost by the driver
+    if (device && device->property("rxOverruns").isValid()) {
+        emit rxOverrunsUpdated(device->property("rxOverruns").toInt());
+    }
     emit telemetryUpdated((double)gcsStats.TxDataRate, (double)gcsStats.RxDataRate);
+    if (!clockSamples.isEmpty()) {
+        emit latencyUpdated(latencyHistogram);
+    }
 
     // Set data
     gcsStatsObj->setData(gcsStats);
@@ -249,6 +526,13 @@ void TelemetryMonitor::processStatsUpdates()
         gcsStatsObj->updated();
     }
 
+    if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED) {
+        sendPing();
+    } else {
+        // the autopilot may have rebooted
+        clockSamples.clear();
+    }
+
     // Act on new connections or disconnections
     if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED && gcsStats.Status != oldStatus) {
         statsTimer->setInterval(STATS_UPDATE_PERIOD_MS);
@@ -29,40 +29,71 @@
 #define TELEMETRYMONITOR_H
 
 #include <QObject>
+#include <QHash>
 #include <QQueue>
+#include <QSet>
 #include <QTimer>
 #include <QTime>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QPointer>
+#include <QIODevice>
 #include "uavobjectmanager.h"
 #include "gcstelemetrystats.h"
 #include "flighttelemetrystats.h"
 #include "firmwareiapobj.h"
+#include "objecthashes.h"
 #include "systemstats.h"
+#include "telemetryping.h"
 #include "telemetry.h"
+#include "uavobjectcache.h"
 
 class TelemetryMonitor : public QObject {
     Q_OBJECT
 
 public:
-    TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel);
+    TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel, QIODevice *device = 0);
     ~TelemetryMonitor();
 
+    static int latencyBinLimit(int bin);
+
 signals:
     void connected();
     void disconnected();
     void telemetryUpdated(double txRate, double rxRate);
+    void rxOverrunsUpdated(int overruns);
+    void latencyUpdated(const QList<int> &histogram);
 
 public slots:
     void transactionCompleted(UAVObject *obj, bool success);
     void processStatsUpdates();
     void flightStatsUpdated(UAVObject *obj);
     void firmwareIAPUpdated(UAVObject *obj);
+    void boardIdentified(UAVObject *obj, bool success);
+    void hashesTransactionCompleted(UAVObject *obj, bool success);
+    void hashesUnpacked(UAVObject *obj);
+    void hashesTimeout();
+    void pingUnpacked(UAVObject *obj);
+    void timestampReceived(quint32 objId, quint16 timestamp, qint64 rxTime);
 
 private:
     static const int STATS_UPDATE_PERIOD_MS  = 4000;
     static const int STATS_CONNECT_PERIOD_MS = 2000;
     static const int CONNECTION_TIMEOUT_MS   = 8000;
+    // Object requests kept outstanding while retrieving the objects on connection,
+    // small enough for the replies to fit in the flight side telemetry buffers
+    static const int RETRIEVE_WINDOW = 4;
+    // Time allowed to the autopilot to send a page of ObjectHashes
+    static const int HASHES_TIMEOUT_MS = 1000;
+    // Pings kept to estimate the autopilot clock, the one with the shortest round trip is used
+    static const int PING_WINDOW     = 8;
+    // Older ping answers are ignored
+    static const int PING_TIMEOUT_MS = 2000;
+
+    typedef struct {
+        quint32 roundTrip;
+        quint32 offset; // autopilot clock minus GCS clock, ms
+    } ClockSample;
 
     UAVObjectManager *objMngr;
     Telemetry *tel;
@@ -70,14 +101,31 @@ private:
     GCSTelemetryStats *gcsStatsObj;
     FlightTelemetryStats *flightStatsObj;
     FirmwareIAPObj *firmwareIAPObj;
+    ObjectHashes *objectHashesObj;
+    TelemetryPing *pingObj;
+    UAVObjectCache cache;
+    QHash<quint32, quint32> hashes;
+    int hashesPage;
+    QTimer *hashesTimer;
     QTimer *statsTimer;
-    UAVObject *objPending;
+    QSet<UAVObject *> objPending;
     QMutex *mutex;
     QTime *connectionTimer;
+    QPointer<QIODevice> device;
+    int reportsRead;
+    int reportsWritten;
+    QQueue<ClockSample> clockSamples;
+    quint32 clockOffset;
+    QList<int> latencyHistogram;
 
     void startRetrievingObjects();
-    void retrieveNextObject();
+    void requestHashesPage(int page);
+    void stopRequestingHashes();
+    void restoreCachedObjects();
+    void retrieveNextObjects();
     void stopRetrievingObjects();
+    void processReportStats(const Telemetry::TelemetryStats &telStats);
+    void sendPing();
 };
 
 #endif // TELEMETRYMONITOR_H
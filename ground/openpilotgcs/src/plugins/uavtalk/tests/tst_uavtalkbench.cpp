@@ -0,0 +1,337 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_uavtalkbench.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Throughput of the UAVTalk receive path, stage by stage
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+#include "uavtalk/uavtalk.h"
+#include "uavobjects/uavobjectsinit.h"
+#include "uavobjects/uavdataobject.h"
+
+#include <utils/crc.h>
+
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtEndian>
+
+#include <cstdlib>
+#include <new>
+
+// Every stage runs over the whole stream until this time has elapsed
+#define MIN_TIME_MS      1000
+// Rounds over all the objects in the generated stream
+#define GENERATED_ROUNDS 20
+
+// UAVTalk framing, see uavtalk.h
+#define SYNC_VAL           0x3C
+#define TYPE_MASK          0xF8
+#define TYPE_VER           0x20
+#define TYPE_OBJ           (TYPE_VER | 0x00)
+#define TYPE_OBJ_ACK       (TYPE_VER | 0x02)
+#define HEADER_LENGTH      10
+#define MAX_PAYLOAD_LENGTH 256
+#define CHECKSUM_LENGTH    1
+
+using namespace Utils;
+
+// C++ heap allocations of the whole program, operator new is replaced below
+static quint64 allocations = 0;
+
+#if __cplusplus >= 201103L
+void *operator new(size_t size)
+#else
+void *operator new(size_t size) throw(std::bad_alloc)
+#endif
+{
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+#if __cplusplus >= 201103L
+void *operator new[](size_t size)
+#else
+void *operator new[](size_t size) throw(std::bad_alloc)
+#endif
+{
+    return operator new(size);
+}
+
+void operator delete[](void *p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+/**
+ * Replays a stream of UAVTalk frames through the GCS receive path. Each stage
+ * reports packets per second (as the QtTest FramesPerSecond result), the time
+ * per packet and the C++ heap allocations per packet:
+ * - crc: checksum of the frames
+ * - getObject: UAVObjectManager lookup of the object of each frame
+ * - unpack: UAVObject::unpack of each frame into its object
+ * - processInputStream: the whole stack, framing to object updates
+ */
+class UAVTalkBench : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void crc();
+    void getObject();
+    void unpack();
+    void processInputStream();
+
+private:
+    typedef struct {
+        qint32  offset;
+        qint32  length; // packet size, without the checksum
+        quint8  type;
+        quint32 objId;
+        quint16 instId;
+    } Frame;
+
+    UAVObjectManager *objMngr;
+    QByteArray stream;
+    QVector<Frame> frames;
+
+    void generateStream();
+    bool loadLog(const QString &fileName);
+    void splitFrames();
+    void report(const char *stage, qint64 ns, int reps, quint64 allocs, int packets);
+};
+
+void UAVTalkBench::initTestCase()
+{
+    objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    QString log = QString::fromLocal8Bit(qgetenv("UAVTALK_BENCH_LOG"));
+    if (log.isEmpty()) {
+        generateStream();
+    } else {
+        QVERIFY2(loadLog(log), qPrintable("cannot read " + log));
+    }
+    splitFrames();
+    QVERIFY(!frames.isEmpty());
+    qDebug("%d bytes, %d frames", stream.size(), frames.size());
+}
+
+void UAVTalkBench::cleanupTestCase()
+{
+    delete objMngr;
+}
+
+/**
+ * Every instance of every object, sent GENERATED_ROUNDS times
+ */
+void UAVTalkBench::generateStream()
+{
+    QBuffer buffer(&stream);
+
+    buffer.open(QIODevice::WriteOnly);
+    UAVTalk talk(&buffer, objMngr);
+    for (int round = 0; round < GENERATED_ROUNDS; round++) {
+        foreach(const QList<UAVDataObject *> &instances, objMngr->getDataObjects()) {
+            foreach(UAVDataObject * obj, instances) {
+                talk.sendObject(obj, false, false);
+            }
+        }
+    }
+    buffer.close();
+}
+
+/**
+ * Joins the payloads of a telemetry log, each log packet is stored
+ * as timestamp (4 bytes), size (8 bytes) and data
+ */
+bool UAVTalkBench::loadLog(const QString &fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray log = file.readAll();
+    qint64 pos     = 0;
+    while (pos + (qint64)(sizeof(quint32) + sizeof(qint64)) <= log.size()) {
+        qint64 size;
+        memcpy(&size, log.constData() + pos + sizeof(quint32), sizeof(size));
+        pos += sizeof(quint32) + sizeof(size);
+        if (size < 1 || pos + size > log.size()) {
+            break;
+        }
+        stream.append(log.constData() + pos, size);
+        pos += size;
+    }
+    return !stream.isEmpty();
+}
+
+void UAVTalkBench::splitFrames()
+{
+    const quint8 *data = (const quint8 *)stream.constData();
+    qint32 pos = 0;
+
+    while (pos + HEADER_LENGTH + CHECKSUM_LENGTH <= stream.size()) {
+        const quint8 *frame = data + pos;
+        qint32 size = qFromLittleEndian<quint16>(frame + 2);
+        if (frame[0] != SYNC_VAL || (frame[1] & TYPE_MASK) != TYPE_VER
+            || size < HEADER_LENGTH || size > HEADER_LENGTH + MAX_PAYLOAD_LENGTH
+            || pos + size + CHECKSUM_LENGTH > stream.size()
+            || Crc::updateCRC(0, frame, size) != frame[size]) {
+            pos++;
+            continue;
+        }
+        Frame f;
+        f.offset = pos;
+        f.length = size;
+        f.type   = frame[1];
+        f.objId  = qFromLittleEndian<quint32>(frame + 4);
+        f.instId = qFromLittleEndian<quint16>(frame + 8);
+        frames.append(f);
+        pos += size + CHECKSUM_LENGTH;
+    }
+}
+
+void UAVTalkBench::report(const char *stage, qint64 ns, int reps, quint64 allocs, int packets)
+{
+    double total = (double)reps * packets;
+
+    qDebug("%-20s %12.0f packets/s %10.1f ns/packet %8.2f allocs/packet", stage, total * 1e9 / ns, ns / total, allocs / total);
+    QTest::setBenchmarkResult(total * 1e9 / ns, QTest::FramesPerSecond);
+}
+
+void UAVTalkBench::crc()
+{
+    const quint8 *data = (const quint8 *)stream.constData();
+    quint8 crc = 0;
+    int reps   = 0;
+    QElapsedTimer timer;
+
+    quint64 allocs = allocations;
+
+    timer.start();
+    do {
+        for (int i = 0; i < frames.size(); i++) {
+            crc ^= Crc::updateCRC(0, data + frames.at(i).offset, frames.at(i).length);
+        }
+        reps++;
+    } while (timer.elapsed() < MIN_TIME_MS);
+    report("crc", timer.nsecsElapsed(), reps, allocations - allocs, frames.size());
+    // keep the loop from being optimized out
+    volatile quint8 result = crc;
+    Q_UNUSED(result);
+}
+
+void UAVTalkBench::getObject()
+{
+    int found = 0;
+    int reps  = 0;
+    QElapsedTimer timer;
+
+    quint64 allocs = allocations;
+
+    timer.start();
+    do {
+        for (int i = 0; i < frames.size(); i++) {
+            if (objMngr->getObject(frames.at(i).objId, frames.at(i).instId)) {
+                found++;
+            }
+        }
+        reps++;
+    } while (timer.elapsed() < MIN_TIME_MS);
+    report("getObject", timer.nsecsElapsed(), reps, allocations - allocs, frames.size());
+    QVERIFY(found > 0);
+}
+
+void UAVTalkBench::unpack()
+{
+    const quint8 *data = (const quint8 *)stream.constData();
+    QVector<UAVObject *> objects;
+    QVector<qint32> offsets;
+    int reps = 0;
+    QElapsedTimer timer;
+
+    // Object frames of a known object and size
+    for (int i = 0; i < frames.size(); i++) {
+        const Frame &frame = frames.at(i);
+        UAVObject *obj     = objMngr->getObject(frame.objId, frame.instId);
+        if ((frame.type == TYPE_OBJ || frame.type == TYPE_OBJ_ACK) && obj
+            && (qint32)obj->getNumBytes() == frame.length - HEADER_LENGTH) {
+            objects.append(obj);
+            offsets.append(frame.offset + HEADER_LENGTH);
+        }
+    }
+    QVERIFY(!objects.isEmpty());
+
+    quint64 allocs = allocations;
+    timer.start();
+    do {
+        for (int i = 0; i < objects.size(); i++) {
+            objects.at(i)->unpack(data + offsets.at(i));
+        }
+        reps++;
+    } while (timer.elapsed() < MIN_TIME_MS);
+    report("unpack", timer.nsecsElapsed(), reps, allocations - allocs, objects.size());
+}
+
+void UAVTalkBench::processInputStream()
+{
+    QBuffer buffer(&stream);
+    int reps = 0;
+    QElapsedTimer timer;
+
+    buffer.open(QIODevice::ReadOnly);
+    UAVTalk talk(&buffer, objMngr);
+
+    // A first pass creates the instances met in the stream
+    QMetaObject::invokeMethod(&talk, "processInputStream", Qt::DirectConnection);
+    talk.resetStats();
+
+    quint64 allocs = allocations;
+    timer.start();
+    do {
+        buffer.seek(0);
+        QMetaObject::invokeMethod(&talk, "processInputStream", Qt::DirectConnection);
+        reps++;
+    } while (timer.elapsed() < MIN_TIME_MS);
+    report("processInputStream", timer.nsecsElapsed(), reps, allocations - allocs, frames.size());
+
+    UAVTalk::ComStats stats = talk.getStats();
+    qDebug("%u objects, %u errors, %u sync errors, %u crc errors", stats.rxObjects, stats.rxErrors, stats.rxSyncErrors, stats.rxCrcErrors);
+    QVERIFY(stats.rxObjects > 0);
+}
+
+QTEST_GUILESS_MAIN(UAVTalkBench)
+
+#include "tst_uavtalkbench.moc"
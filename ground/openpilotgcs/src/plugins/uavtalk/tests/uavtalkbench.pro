@@ -0,0 +1,20 @@
+# Benchmarks of the GCS UAVTalk receive path, not part of the GCS build:
+# run qmake on this file in the GCS build tree once the GCS is built.
+# UAVTALK_BENCH_LOG=<file.opl> replays a telemetry log instead of the
+# generated stream of all the objects.
+
+TEMPLATE = app
+TARGET   = uavtalkbench
+CONFIG  += console qtestlib
+CONFIG  -= app_bundle
+QT      += network widgets
+
+include(../../../../openpilotgcs.pri)
+include(../uavtalk.pri)
+include(../../../libs/extensionsystem/extensionsystem.pri)
+
+INCLUDEPATH += $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+QMAKE_RPATHDIR += $$GCS_LIBRARY_PATH $$GCS_PLUGIN_PATH/OpenPilot
+
+SOURCES += tst_uavtalkbench.cpp
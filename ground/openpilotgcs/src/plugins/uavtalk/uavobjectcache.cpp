@@ -0,0 +1,149 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectcache.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief The UAVTalk protocol plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavobjectcache.h"
+#include "uavdataobject.h"
+#include "uavmetaobject.h"
+
+#include <utils/crc.h>
+#include <utils/pathutils.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+using namespace Utils;
+
+UAVObjectCache::UAVObjectCache(UAVObjectManager *objMngr) :
+    m_objMngr(objMngr)
+{}
+
+/**
+ * Load the cache of a board, an empty cache is started when there is none yet.
+ * \return true when a cache was loaded
+ */
+bool UAVObjectCache::load(const QByteArray &boardSerial)
+{
+    clear();
+    m_fileName = PathUtils().GetStoragePath() + "uavobjectcache/" + QString(boardSerial.toHex()) + ".bin";
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        qDebug() << "UAVObjectCache - ignoring invalid cache" << m_fileName;
+        return false;
+    }
+    stream >> m_data;
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "UAVObjectCache - ignoring truncated cache" << m_fileName;
+        m_data.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Save the settings objects and metaobjects known from the board.
+ */
+bool UAVObjectCache::save()
+{
+    if (m_fileName.isEmpty()) {
+        return false;
+    }
+
+    m_data.clear();
+    foreach(const QList<UAVObject *> &instances, m_objMngr->getObjects()) {
+        UAVObject *obj = instances.first();
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
+        if (!obj->isKnown() || (dobj && !dobj->isSettingsObject()) || (!dobj && !dynamic_cast<UAVMetaObject *>(obj))) {
+            continue;
+        }
+        QByteArray data(instances.length() * obj->getNumBytes(), 0);
+        quint8 *ptr = (quint8 *)data.data();
+        foreach(UAVObject * instance, instances) {
+            ptr += instance->pack(ptr);
+        }
+        m_data.insert(obj->getObjID(), data);
+    }
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "UAVObjectCache - unable to write" << m_fileName;
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << CACHE_MAGIC << CACHE_VERSION << m_data;
+    return stream.status() == QDataStream::Ok;
+}
+
+void UAVObjectCache::clear()
+{
+    m_fileName.clear();
+    m_data.clear();
+}
+
+/**
+ * Restore all the instances of an object from the cache when the cached data
+ * has the hash sent by the board, the hash covers the instances in order.
+ * \return true when the object was restored
+ */
+bool UAVObjectCache::restore(UAVObject *obj, quint32 hash)
+{
+    QHash<quint32, QByteArray>::const_iterator it = m_data.constFind(obj->getObjID());
+
+    if (it == m_data.constEnd()) {
+        return false;
+    }
+    QList<UAVObject *> instances = m_objMngr->getObjectInstances(obj->getObjID());
+    if ((quint32)it->size() != instances.length() * obj->getNumBytes()) {
+        return false;
+    }
+    const quint8 *ptr = (const quint8 *)it->constData();
+    if (Crc::updateCRC32(0, ptr, it->size()) != hash) {
+        return false;
+    }
+    foreach(UAVObject * instance, instances) {
+        ptr += instance->unpack(ptr);
+        instance->setIsKnown(true);
+    }
+    return true;
+}
+
+/**
+ * @}
+ * @}
+ */
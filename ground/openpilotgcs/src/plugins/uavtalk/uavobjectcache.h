@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectcache.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief The UAVTalk protocol plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTCACHE_H
+#define UAVOBJECTCACHE_H
+
+#include "uavobjectmanager.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+/**
+ * Keeps on disk, per board, the settings objects and metaobjects last retrieved from it.
+ * On connection the board sends a CRC32 of each of them (see ObjectHashes), objects whose
+ * cached data has the same CRC are restored from the cache instead of being retrieved.
+ */
+class UAVObjectCache {
+public:
+    UAVObjectCache(UAVObjectManager *objMngr);
+
+    bool load(const QByteArray &boardSerial);
+    bool save();
+    void clear();
+
+    bool restore(UAVObject *obj, quint32 hash);
+
+private:
+    static const quint32 CACHE_MAGIC   = 0x4f504f43; // "OPOC"
+    static const quint32 CACHE_VERSION = 1;
+
+    UAVObjectManager *m_objMngr;
+    QString m_fileName;
+    // Packed data of all the instances of each object
+    QHash<quint32, QByteArray> m_data;
+};
+
+#endif // UAVOBJECTCACHE_H
@@ -49,16 +49,26 @@ using namespace Utils;
 /**
  * Constructor
  */
-UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr) : io(iodev), objMngr(objMngr), mutex(QMutex::Recursive)
+UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr) : io(iodev), objMngr(objMngr), mutex(QMutex::Recursive), recorder(NULL)
 {
     rxState = STATE_SYNC;
     rxPacketLength = 0;
+    rxTimestamped  = false;
+    rxTimestamp    = 0;
+    rxTime         = 0;
+    rxChunkTime    = 0.0;
+    rxSampleTime   = 0.0;
+    rxFlightTime   = 0;
+    rxLastTimestamp     = 0;
+    rxFlightClockOffset = 0.0;
+    rxHasFlightClock    = false;
 
     memset(&stats, 0, sizeof(ComStats));
 
+    // No plugin manager when used standalone, e.g. by the benchmarks
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings *settings = pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror = settings->useUDPMirror();
+    Core::Internal::GeneralSettings *settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings ? settings->useUDPMirror() : false;
     qDebug() << "USE UDP:::::::::::." << useUDPMirror;
     if (useUDPMirror) {
         udpSocketTx = new QUdpSocket(this);
@@ -137,6 +147,65 @@ bool UAVTalk::sendObject(UAVObject *obj, bool acked, bool allInstances)
     return success;
 }
 
+/**
+ * Send several objects through the telemetry link, packed into as few packets as possible.
+ * Records that fit together are sent in a single TYPE_OBJ_MULTI packet sharing one
+ * header and checksum, a lone record is sent as a plain TYPE_OBJ packet.
+ * Batched objects are never acked.
+ * \param[in] objs Objects to send, each with its own instance
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::sendObjectBatch(const QList<UAVObject *> & objs)
+{
+    QMutexLocker locker(&mutex);
+
+    bool success  = true;
+    qint32 length = 0;
+    qint32 count  = 0;
+
+    foreach(UAVObject * obj, objs) {
+        qint32 size = obj->getNumBytes();
+
+        // Objects too large to share a packet are sent on their own
+        if (size + MULTI_RECORD_HEADER_LENGTH > MAX_MULTI_PAYLOAD_LENGTH) {
+            success &= flushBatch(length, count);
+            success &= transmitSingleObject(TYPE_OBJ, obj->getObjID(), obj->getInstID(), obj);
+            continue;
+        }
+
+        if (count > 0 && length + MULTI_RECORD_HEADER_LENGTH + size > MAX_MULTI_PAYLOAD_LENGTH) {
+            success &= flushBatch(length, count);
+        }
+
+        quint8 *record;
+        if (count == 0) {
+            // First record, IDs go in the packet header
+            record = &txBuffer[4];
+        } else {
+            record  = &txBuffer[HEADER_LENGTH + length];
+            length += MULTI_RECORD_HEADER_LENGTH;
+        }
+        qToLittleEndian<quint32>(obj->getObjID(), &record[0]);
+        qToLittleEndian<quint16>(obj->getInstID(), &record[4]);
+
+        if (!obj->pack(&txBuffer[HEADER_LENGTH + length])) {
+            qWarning() << "UAVTalk - error transmitting : failed to pack object" << obj->toStringBrief();
+            ++stats.txErrors;
+            // Drop the record
+            if (count > 0) {
+                length -= MULTI_RECORD_HEADER_LENGTH;
+            }
+            success = false;
+            continue;
+        }
+        length += size;
+        ++count;
+    }
+    success &= flushBatch(length, count);
+
+    return success;
+}
+
 /**
  * Request an update for the specified object, on success the object data would have been
  * updated by the GCS.
@@ -144,6 +213,17 @@ bool UAVTalk::sendObject(UAVObject *obj, bool acked, bool allInstances)
  * \param[in] allInstances If set true then all instances will be updated
  * \return Success (true), Failure (false)
  */
+/**
+ * Set the recorder getting a copy of all object packets, NULL to stop recording.
+ * Once this returns the previous recorder is not called anymore.
+ */
+void UAVTalk::setRecorder(UAVTalkRecorder *recorder)
+{
+    QMutexLocker locker(&mutex);
+
+    this->recorder = recorder;
+}
+
 bool UAVTalk::sendObjectRequest(UAVObject *obj, bool allInstances)
 {
     QMutexLocker locker(&mutex);
@@ -208,34 +288,141 @@ bool UAVTalk::objectTransaction(quint8 type, quint32 objId, quint16 instId, UAVO
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
-        while (io->bytesAvailable() > 0) {
-            int ret = io->read((char *)&tmp, 1);
-            if (ret != -1) {
-                processInputByte(tmp);
-            } else {
+        qint64 available;
+        while ((available = io->bytesAvailable()) > 0) {
+            // Read everything available at once, the state machine keeps partial packets across reads
+            qint64 ret = io->read((char *)rxChunk, qMin(available, (qint64)RX_CHUNK_SIZE));
+            if (ret <= 0) {
                 // TODOD
+                break;
             }
-            if (rxState == STATE_COMPLETE) {
-                mutex.lock();
-                if (receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength)) {
-                    stats.rxObjectBytes += rxLength;
-                    stats.rxObjects++;
-                } else {
-                    // TODO...
+            // receive time of the timestamped packets
+            rxTime      = QDateTime::currentMSecsSinceEpoch();
+            rxChunkTime = UAVObject::currentTime();
+            const quint8 *data = rxChunk;
+            qint32 length = (qint32)ret;
+            while (length > 0) {
+                qint32 count = processInputBytes(data, length);
+                data   += count;
+                length -= count;
+                if (rxState == STATE_COMPLETE) {
+                    processReceivedPacket();
                 }
-                mutex.unlock();
+            }
+        }
+    }
+}
 
-                if (useUDPMirror) {
-                    // it is safe to do this outside of the above critical section as the rxDataArray is
-                    // accessed from this thread only
-                    udpSocketTx->writeDatagram(rxDataArray, QHostAddress::LocalHost, udpSocketRx->localPort());
-                }
+/**
+ * Dispatch the packet completed by the receive state machine
+ */
+void UAVTalk::processReceivedPacket()
+{
+    bool received;
+
+    updateSampleTime();
+    mutex.lock();
+    received = receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength);
+    if (received) {
+        stats.rxObjectBytes += rxLength;
+        stats.rxObjects++;
+        if (recorder && (rxType == TYPE_OBJ || rxType == TYPE_OBJ_ACK || rxType == TYPE_OBJ_MULTI)) {
+            // Only the payload is kept by the receive state machine, rebuild the packet
+            quint8 packet[MAX_PACKET_LENGTH];
+            packet[0] = SYNC_VAL;
+            packet[1] = rxType;
+            qToLittleEndian<quint16>(HEADER_LENGTH + rxLength, &packet[2]);
+            qToLittleEndian<quint32>(rxObjId, &packet[4]);
+            qToLittleEndian<quint16>(rxInstId, &packet[8]);
+            memcpy(&packet[HEADER_LENGTH], rxBuffer, rxLength);
+            packet[HEADER_LENGTH + rxLength] = rxCSPacket;
+            recorder->recordPacket(packet, HEADER_LENGTH + rxLength + CHECKSUM_LENGTH);
+        }
+    } else {
+        // TODO...
+    }
+    mutex.unlock();
+
+    if (received && rxTimestamped) {
+        emit timestampReceived(rxObjId, rxTimestamp, rxTime);
+    }
+
+    if (useUDPMirror) {
+        // it is safe to do this outside of the above critical section as the rxDataArray is
+        // accessed from this thread only
+        udpSocketTx->writeDatagram(rxDataArray, QHostAddress::LocalHost, udpSocketRx->localPort());
+    }
+}
+
+/**
+ * Set the time of the samples of the packet completed by the receive state machine.
+ * A timestamped packet is placed on the autopilot clock, so that the packets
+ * batched by the link keep their spacing, the others get the receive time.
+ */
+void UAVTalk::updateSampleTime()
+{
+    if (!rxTimestamped) {
+        rxSampleTime = rxChunkTime;
+        return;
+    }
+
+    // The timestamps of the objects interleave, each one is close to the previous one
+    rxFlightTime   += (qint16)(rxTimestamp - rxLastTimestamp);
+    rxLastTimestamp = rxTimestamp;
+
+    // The smallest offset is the one of the packets with the least latency, it creeps up
+    // to follow the clock drift, and a jump of a second is a restart of either side
+    double offset = rxChunkTime - rxFlightTime / 1000.0;
+    if (!rxHasFlightClock || offset < rxFlightClockOffset || offset - rxFlightClockOffset > 1.0) {
+        rxFlightClockOffset = offset;
+        rxHasFlightClock    = true;
+    } else {
+        rxFlightClockOffset += (offset - rxFlightClockOffset) * 0.001;
+    }
+    rxSampleTime = rxFlightTime / 1000.0 + rxFlightClockOffset;
+}
+
+/**
+ * Process a chunk of the telemetry stream, stopping after the first completed packet.
+ * Payload bytes are copied in one go, the other states go through processInputByte().
+ * \param[in] data Received bytes
+ * \param[in] length Number of received bytes
+ * \return Number of bytes consumed
+ */
+qint32 UAVTalk::processInputBytes(const quint8 *data, qint32 length)
+{
+    qint32 count = 0;
+
+    while (count < length) {
+        if (rxState == STATE_DATA) {
+            // Fast path, take as much of the payload as is available
+            qint32 n = qMin(length - count, (qint32)rxLength - rxCount);
+
+            memcpy(&rxBuffer[rxCount], &data[count], n);
+            rxCS = Crc::updateCRC(rxCS, &data[count], n);
+            if (useUDPMirror) {
+                rxDataArray.append((const char *)&data[count], n);
+            }
+
+            // Update stats
+            stats.rxBytes  += n;
+            rxPacketLength += n;
+
+            rxCount += n;
+            count   += n;
+            if (rxCount == rxLength) {
+                rxCount = 0;
+                rxState = STATE_CS;
+            }
+        } else {
+            processInputByte(data[count++]);
+            if (rxState == STATE_COMPLETE) {
+                break;
             }
         }
     }
+    return count;
 }
 
 /**
@@ -296,11 +483,12 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
             break;
         }
 
-        rxType     = rxbyte;
+        rxType        = rxbyte & ~TIMESTAMPED;
+        rxTimestamped = (rxbyte & TIMESTAMPED) != 0;
 
-        packetSize = 0;
+        packetSize    = 0;
 
-        rxState    = STATE_SIZE;
+        rxState       = STATE_SIZE;
         break;
 
     case STATE_SIZE:
@@ -317,7 +505,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
         rxCount     = 0;
 
 
-        if (packetSize < HEADER_LENGTH || packetSize > HEADER_LENGTH + MAX_PAYLOAD_LENGTH) {
+        if (packetSize < HEADER_LENGTH || packetSize > HEADER_LENGTH + (rxTimestamped ? TIMESTAMP_LENGTH : 0) + MAX_PAYLOAD_LENGTH) {
             // incorrect packet size
             qWarning() << "UAVTalk - error : incorrect packet size";
             stats.rxErrors++;
@@ -359,52 +547,27 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
 
         rxInstId = (qint16)qFromLittleEndian<quint16>(rxTmpBuffer);
 
-        // Search for object, if not found reset state machine
-        {
-            UAVObject *rxObj = objMngr->getObject(rxObjId);
-            if (rxObj == NULL && rxType != TYPE_OBJ_REQ) {
-                qWarning() << "UAVTalk - error : unknown object" << rxObjId;
-                stats.rxErrors++;
-                rxState = STATE_ERROR;
-                break;
-            }
+        if (rxTimestamped) {
+            rxState = STATE_TIMESTAMP;
+            break;
+        }
+        startPayload();
+        break;
 
-            // Determine data length
-            if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
-                rxLength = 0;
-            } else {
-                if (rxObj) {
-                    rxLength = rxObj->getNumBytes();
-                } else {
-                    rxLength = packetSize - rxPacketLength;
-                }
-            }
+    case STATE_TIMESTAMP:
 
-            // Check length and determine next state
-            if (rxLength >= MAX_PAYLOAD_LENGTH) {
-                // packet error - exceeded payload max length
-                qWarning() << "UAVTalk - error : exceeded payload max length" << rxObjId;
-                stats.rxErrors++;
-                rxState = STATE_ERROR;
-                break;
-            }
+        // Update CRC
+        rxCS = Crc::updateCRC(rxCS, rxbyte);
 
-            // Check the lengths match
-            if ((rxPacketLength + rxLength) != packetSize) {
-                // packet error - mismatched packet size
-                qWarning() << "UAVTalk - error : mismatched packet size" << rxObjId;
-                stats.rxErrors++;
-                rxState = STATE_ERROR;
-                break;
-            }
+        rxTmpBuffer[rxCount++] = rxbyte;
+        if (rxCount < TIMESTAMP_LENGTH) {
+            break;
         }
+        rxCount     = 0;
 
-        // If there is a payload get it, otherwise receive checksum
-        if (rxLength > 0) {
-            rxState = STATE_DATA;
-        } else {
-            rxState = STATE_CS;
-        }
+        rxTimestamp = qFromLittleEndian<quint16>(rxTmpBuffer);
+
+        startPayload();
         break;
 
     case STATE_DATA:
@@ -456,6 +619,61 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
     return true;
 }
 
+/**
+ * Called once the header (and timestamp) of a packet is received, looks up the
+ * object to determine the payload length and the next state.
+ */
+void UAVTalk::startPayload()
+{
+    // Search for object, if not found reset state machine
+    UAVObject *rxObj = objMngr->getObject(rxObjId);
+    if (rxObj == NULL && rxType != TYPE_OBJ_REQ) {
+        qWarning() << "UAVTalk - error : unknown object" << rxObjId;
+        stats.rxErrors++;
+        rxState = STATE_ERROR;
+        return;
+    }
+
+    // Determine data length
+    if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
+        rxLength = 0;
+    } else if (rxType == TYPE_OBJ_MULTI) {
+        // The payload holds several records, it is split by receiveObject()
+        rxLength = packetSize - rxPacketLength;
+    } else {
+        if (rxObj) {
+            rxLength = rxObj->getNumBytes();
+        } else {
+            rxLength = packetSize - rxPacketLength;
+        }
+    }
+
+    // Check length and determine next state
+    if (rxLength >= MAX_PAYLOAD_LENGTH) {
+        // packet error - exceeded payload max length
+        qWarning() << "UAVTalk - error : exceeded payload max length" << rxObjId;
+        stats.rxErrors++;
+        rxState = STATE_ERROR;
+        return;
+    }
+
+    // Check the lengths match
+    if ((rxPacketLength + rxLength) != packetSize) {
+        // packet error - mismatched packet size
+        qWarning() << "UAVTalk - error : mismatched packet size" << rxObjId;
+        stats.rxErrors++;
+        rxState = STATE_ERROR;
+        return;
+    }
+
+    // If there is a payload get it, otherwise receive checksum
+    if (rxLength > 0) {
+        rxState = STATE_DATA;
+    } else {
+        rxState = STATE_CS;
+    }
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  *
@@ -465,7 +683,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
  * Object handling errors are considered as application errors and are NACked.
  * In that case we want to nack as there is no point in the sender retrying to send invalid objects.
  *
- * \param[in] type Type of received message (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK)
+ * \param[in] type Type of received message (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_OBJ_MULTI)
  * \param[in] obj Handle of the received object
  * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
  * \param[in] data Data buffer
@@ -474,8 +692,6 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
  */
 bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length)
 {
-    Q_UNUSED(length);
-
     UAVObject *obj    = NULL;
     bool error        = false;
     bool allInstances = (instId == ALL_INSTANCES);
@@ -503,6 +719,41 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *
         }
         break;
 
+    case TYPE_OBJ_MULTI:
+        // The first record uses the header IDs, the following ones carry their own
+        while (!error && length > 0) {
+            UAVObject *typeObj = objMngr->getObject(objId);
+            if (typeObj == NULL || instId == ALL_INSTANCES || (qint32)typeObj->getNumBytes() > length) {
+                error = true;
+                break;
+            }
+            // Get object and update its data
+            obj = updateObject(objId, instId, data);
+#ifdef VERBOSE_UAVTALK
+            VERBOSE_FILTER(objId) qDebug() << "UAVTalk - received batched object" << objId << instId << (obj != NULL ? obj->toStringBrief() : "<null object>");
+#endif
+            if (obj == NULL) {
+                error = true;
+                break;
+            }
+            // Records act as OBJ messages and can ack a pending OBJ_REQ message
+            updateAck(TYPE_OBJ, objId, instId, obj);
+            data   += typeObj->getNumBytes();
+            length -= typeObj->getNumBytes();
+            if (length == 0) {
+                break;
+            }
+            if (length < MULTI_RECORD_HEADER_LENGTH) {
+                error = true;
+                break;
+            }
+            objId   = qFromLittleEndian<quint32>(data);
+            instId  = qFromLittleEndian<quint16>(data + 4);
+            data   += MULTI_RECORD_HEADER_LENGTH;
+            length -= MULTI_RECORD_HEADER_LENGTH;
+        }
+        break;
+
     case TYPE_OBJ_ACK:
         // All instances, not allowed for OBJ_ACK messages
         if (!allInstances) {
@@ -623,11 +874,11 @@ UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
             qWarning() << "UAVTalk - failed to register object " << instObj->toStringBrief();
             return NULL;
         }
-        instObj->unpack(data);
+        instObj->unpack(data, rxSampleTime);
         return instObj;
     } else {
         // Unpack data into object instance
-        obj->unpack(data);
+        obj->unpack(data, rxSampleTime);
         return obj;
     }
 }
@@ -779,6 +1030,53 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
         }
     }
 
+    if (!transmitPacket(length)) {
+        return false;
+    }
+
+    // Update stats
+    ++stats.txObjects;
+    stats.txObjectBytes += length;
+
+    // Done
+    return true;
+}
+
+/**
+ * Send the multi object packet built in the transmit buffer by sendObjectBatch(), if any.
+ * \param[in,out] length Payload length of the packet, reset once sent
+ * \param[in,out] count Number of records in the packet, reset once sent
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::flushBatch(qint32 & length, qint32 & count)
+{
+    bool ret = true;
+
+    if (count > 0) {
+        txBuffer[0] = SYNC_VAL;
+        // A lone record has the layout of a plain object packet
+        txBuffer[1] = (count == 1) ? TYPE_OBJ : TYPE_OBJ_MULTI;
+        ret = transmitPacket(length);
+        if (ret) {
+            stats.txObjects     += count;
+            stats.txObjectBytes += length - (count - 1) * MULTI_RECORD_HEADER_LENGTH;
+        }
+    }
+    length = 0;
+    count  = 0;
+
+    return ret;
+}
+
+/**
+ * Complete the packet in the transmit buffer with its length and checksum and send it.
+ * \param[in] length Payload length of the packet
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::transmitPacket(qint32 length)
+{
+    quint8 type = txBuffer[1];
+
     // Store the packet length
     qToLittleEndian<quint16>(HEADER_LENGTH + length, &txBuffer[2]);
 
@@ -789,6 +1087,9 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
     if (!io.isNull() && io->isWritable()) {
         if (io->bytesToWrite() < TX_BUFFER_SIZE) {
             io->write((const char *)txBuffer, HEADER_LENGTH + length + CHECKSUM_LENGTH);
+            if (recorder && (type == TYPE_OBJ || type == TYPE_OBJ_ACK || type == TYPE_OBJ_MULTI)) {
+                recorder->recordPacket(txBuffer, HEADER_LENGTH + length + CHECKSUM_LENGTH);
+            }
             if (useUDPMirror) {
                 udpSocketRx->writeDatagram((const char *)txBuffer, HEADER_LENGTH + length + CHECKSUM_LENGTH, QHostAddress::LocalHost, udpSocketTx->localPort());
             }
@@ -803,12 +1104,8 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
         return false;
     }
 
-    // Update stats
-    ++stats.txObjects;
-    stats.txObjectBytes += length;
     stats.txBytes += HEADER_LENGTH + length + CHECKSUM_LENGTH;
 
-    // Done
     return true;
 }
 
@@ -896,6 +1193,11 @@ const char *UAVTalk::typeToString(quint8 type)
     case TYPE_NACK:
         return "nack";
 
+        break;
+
+    case TYPE_OBJ_MULTI:
+        return "multiple objects";
+
         break;
     }
     return "<error>";
@@ -38,10 +38,21 @@
 #include <QThread>
 #include <QtNetwork/QUdpSocket>
 
+/**
+ * Gets a copy of every object packet sent or received by a UAVTalk instance,
+ * called from the thread running the telemetry with the UAVTalk lock held.
+ */
+class UAVTALK_EXPORT UAVTalkRecorder {
+public:
+    virtual ~UAVTalkRecorder() {}
+    virtual void recordPacket(const quint8 *packet, qint32 length) = 0;
+};
+
 class UAVTALK_EXPORT UAVTalk : public QObject {
     Q_OBJECT
 
     friend class IODeviceReader;
+    friend class UAVTalkLogDecoder;
 
 public:
     static const quint16 ALL_INSTANCES = 0xFFFF;
@@ -67,11 +78,15 @@ public:
     void resetStats();
 
     bool sendObject(UAVObject *obj, bool acked, bool allInstances);
+    bool sendObjectBatch(const QList<UAVObject *> & objs);
     bool sendObjectRequest(UAVObject *obj, bool allInstances);
     void cancelTransaction(UAVObject *obj);
+    void setRecorder(UAVTalkRecorder *recorder);
 
 signals:
     void transactionCompleted(UAVObject *obj, bool success);
+    // An object packet timestamped by the autopilot (ms, 16 bits) was read at rxTime (ms since the epoch)
+    void timestampReceived(quint32 objId, quint16 timestamp, qint64 rxTime);
 
 private slots:
     void processInputStream();
@@ -86,28 +101,41 @@ private:
     } Transaction;
 
     // Constants
-    static const int TYPE_MASK     = 0xF8;
+    static const int TYPE_MASK     = 0x78;
     static const int TYPE_VER      = 0x20;
+    static const int TIMESTAMPED   = 0x80;
     static const int TYPE_OBJ      = (TYPE_VER | 0x00);
     static const int TYPE_OBJ_REQ  = (TYPE_VER | 0x01);
     static const int TYPE_OBJ_ACK  = (TYPE_VER | 0x02);
     static const int TYPE_ACK      = (TYPE_VER | 0x03);
     static const int TYPE_NACK     = (TYPE_VER | 0x04);
+    static const int TYPE_OBJ_MULTI = (TYPE_VER | 0x05);
 
     // header : sync(1), type (1), size(2), object ID(4), instance ID(2)
     static const int HEADER_LENGTH = 10;
 
+    // multi object record : object ID(4), instance ID(2), data (the first record uses the packet header IDs)
+    static const int MULTI_RECORD_HEADER_LENGTH = 6;
+
+    // timestamp of the TIMESTAMPED packets, after the header
+    static const int TIMESTAMP_LENGTH = 2;
+
     static const int MAX_PAYLOAD_LENGTH = 256;
 
+    // same limit as the flight side, multi packets must fit its receive buffer
+    static const int MAX_MULTI_PAYLOAD_LENGTH = 255;
+
     static const int CHECKSUM_LENGTH    = 1;
 
     static const int MAX_PACKET_LENGTH  = (HEADER_LENGTH + MAX_PAYLOAD_LENGTH + CHECKSUM_LENGTH);
 
     static const int TX_BUFFER_SIZE     = 2 * 1024;
 
+    static const int RX_CHUNK_SIZE      = 2 * 1024;
+
     // Types
     typedef enum {
-        STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_DATA, STATE_CS, STATE_COMPLETE, STATE_ERROR
+        STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_TIMESTAMP, STATE_DATA, STATE_CS, STATE_COMPLETE, STATE_ERROR
     } RxStateType;
 
     // Variables
@@ -125,6 +153,8 @@ private:
 
     quint8 txBuffer[MAX_PACKET_LENGTH];
 
+    quint8 rxChunk[RX_CHUNK_SIZE];
+
     // Variables used by the receive state machine
     // state machine variables
     qint32 rxCount;
@@ -133,6 +163,17 @@ private:
     // data variables
     quint8 rxTmpBuffer[4];
     quint8 rxType;
+    bool rxTimestamped;
+    quint16 rxTimestamp;
+    qint64 rxTime;
+    // Sample times (s since the epoch) of the chunk and of the packet, see UAVObject::currentTime()
+    double rxChunkTime;
+    double rxSampleTime;
+    // Autopilot clock unwrapped from the packet timestamps (ms), and its offset to the GCS clock (s)
+    qint64 rxFlightTime;
+    quint16 rxLastTimestamp;
+    double rxFlightClockOffset;
+    bool rxHasFlightClock;
     quint32 rxObjId;
     quint16 rxInstId;
     quint16 rxLength;
@@ -145,15 +186,23 @@ private:
     QUdpSocket *udpSocketRx;
     QByteArray rxDataArray;
 
+    UAVTalkRecorder *recorder;
+
     // Methods
     bool objectTransaction(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
+    qint32 processInputBytes(const quint8 *data, qint32 length);
+    void updateSampleTime();
     bool processInputByte(quint8 rxbyte);
+    void startPayload();
+    void processReceivedPacket();
     bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length);
     UAVObject *updateObject(quint32 objId, quint16 instId, quint8 *data);
     void updateAck(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
     void updateNack(quint32 objId, quint16 instId, UAVObject *obj);
     bool transmitObject(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
     bool transmitSingleObject(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
+    bool flushBatch(qint32 & length, qint32 & count);
+    bool transmitPacket(qint32 length);
 
     Transaction *findTransaction(quint32 objId, quint16 instId);
     void openTransaction(quint8 type, quint32 objId, quint16 instId);
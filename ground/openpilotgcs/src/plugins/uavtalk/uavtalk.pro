@@ -17,13 +17,17 @@ HEADERS += \
     telemetrymonitor.h \
     telemetrymanager.h \
     uavtalk_global.h \
-    telemetry.h
+    telemetry.h \
+    uavtalklogdecoder.h \
+    uavobjectcache.h
 
 SOURCES += \
     uavtalk.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetry.cpp \
+    uavtalklogdecoder.cpp \
+    uavobjectcache.cpp
 
 OTHER_FILES += UAVTalk.pluginspec
@@ -0,0 +1,335 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavtalklogdecoder.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief The UAVTalk protocol plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavtalklogdecoder.h"
+#include "uavtalk.h"
+#include "uavdataobject.h"
+#include "uavobjectfield.h"
+
+#include <utils/crc.h>
+
+#include <QFile>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtEndian>
+#include <QDebug>
+
+#define SYNC_VAL 0x3C
+
+using namespace Utils;
+
+const QVector<double> *UAVObjectTimeSeries::values(const QString &fieldName, int element) const
+{
+    QHash<QString, int>::const_iterator it = fieldIndex.constFind(fieldName);
+
+    if (it == fieldIndex.constEnd() || *it + element >= elements.size()) {
+        return NULL;
+    }
+    return &elements.at(*it + element);
+}
+
+/**
+ * Decodes the frames starting in one chunk of the log stream, a frame started
+ * in the chunk is read to its end even when it runs into the next chunk.
+ */
+class UAVTalkLogDecoder::ChunkDecoder : public QRunnable {
+public:
+    ChunkDecoder(const QByteArray &stream, const QVector<qint64> &packetStart, const QVector<quint32> &packetTime,
+                 const QHash<quint32, UAVDataObject *> &layouts, int firstPacket, qint64 begin, qint64 end) :
+        frames(0), errors(0), m_stream((const quint8 *)stream.constData()), m_size(stream.size()),
+        m_packetStart(packetStart), m_packetTime(packetTime), m_layouts(layouts),
+        m_packet(firstPacket), m_begin(begin), m_end(end)
+    {
+        setAutoDelete(false);
+    }
+
+    void run();
+
+    QHash<quint64, UAVObjectTimeSeries> series;
+    quint32 frames;
+    quint32 errors;
+
+private:
+    typedef struct {
+        UAVDataObject *object;
+        QList<UAVObjectField *> fields;
+        int numElements;
+    } Clone;
+
+    const quint8 *m_stream;
+    qint64 m_size;
+    const QVector<qint64> &m_packetStart;
+    const QVector<quint32> &m_packetTime;
+    const QHash<quint32, UAVDataObject *> &m_layouts;
+    QHash<quint32, Clone> m_clones;
+    int m_packet;
+    qint64 m_begin;
+    qint64 m_end;
+
+    qint32 decodeFrame(qint64 pos, quint32 timeStamp);
+    bool addSample(quint32 objId, quint16 instId, const quint8 *data, qint32 length, quint32 timeStamp);
+};
+
+void UAVTalkLogDecoder::ChunkDecoder::run()
+{
+    qint64 pos = m_begin;
+
+    while (pos < m_end) {
+        if (m_stream[pos] != SYNC_VAL) {
+            pos++;
+            continue;
+        }
+        // Frames take the timestamp of the log packet holding their sync byte
+        while (m_packet + 1 < m_packetStart.size() && m_packetStart.at(m_packet + 1) <= pos) {
+            m_packet++;
+        }
+        qint32 length = decodeFrame(pos, m_packetTime.at(m_packet));
+        pos += length > 0 ? length : 1;
+    }
+
+    foreach(const Clone &clone, m_clones) {
+        delete clone.object;
+    }
+    m_clones.clear();
+}
+
+/**
+ * Decodes the frame at pos.
+ * \return the frame length, 0 when there is no valid frame at pos
+ */
+qint32 UAVTalkLogDecoder::ChunkDecoder::decodeFrame(qint64 pos, quint32 timeStamp)
+{
+    if (pos + UAVTalk::HEADER_LENGTH + UAVTalk::CHECKSUM_LENGTH > m_size) {
+        return 0;
+    }
+
+    const quint8 *frame = m_stream + pos;
+    quint8 type = frame[1];
+    qint32 packetSize = qFromLittleEndian<quint16>(frame + 2);
+    if ((type & UAVTalk::TYPE_MASK) != UAVTalk::TYPE_VER
+        || packetSize < UAVTalk::HEADER_LENGTH
+        || packetSize > UAVTalk::HEADER_LENGTH + UAVTalk::MAX_PAYLOAD_LENGTH
+        || pos + packetSize + UAVTalk::CHECKSUM_LENGTH > m_size
+        || Crc::updateCRC(0, frame, packetSize) != frame[packetSize]) {
+        return 0;
+    }
+
+    quint32 objId   = qFromLittleEndian<quint32>(frame + 4);
+    quint16 instId  = qFromLittleEndian<quint16>(frame + 8);
+    const quint8 *data = frame + UAVTalk::HEADER_LENGTH;
+    qint32 length   = packetSize - UAVTalk::HEADER_LENGTH;
+
+    if (type == UAVTalk::TYPE_OBJ || type == UAVTalk::TYPE_OBJ_ACK) {
+        addSample(objId, instId, data, length, timeStamp);
+    } else if (type == UAVTalk::TYPE_OBJ_MULTI) {
+        // The first record uses the header IDs, the following ones carry their own
+        while (length > 0) {
+            UAVDataObject *layout = m_layouts.value(objId);
+            if (layout == NULL || (qint32)layout->getNumBytes() > length
+                || !addSample(objId, instId, data, layout->getNumBytes(), timeStamp)) {
+                errors++;
+                break;
+            }
+            data   += layout->getNumBytes();
+            length -= layout->getNumBytes();
+            if (length < UAVTalk::MULTI_RECORD_HEADER_LENGTH) {
+                break;
+            }
+            objId   = qFromLittleEndian<quint32>(data);
+            instId  = qFromLittleEndian<quint16>(data + 4);
+            data   += UAVTalk::MULTI_RECORD_HEADER_LENGTH;
+            length -= UAVTalk::MULTI_RECORD_HEADER_LENGTH;
+        }
+    }
+    frames++;
+
+    return packetSize + UAVTalk::CHECKSUM_LENGTH;
+}
+
+/**
+ * Unpacks an object into the private clone of its type and appends its field values to the series.
+ */
+bool UAVTalkLogDecoder::ChunkDecoder::addSample(quint32 objId, quint16 instId, const quint8 *data, qint32 length, quint32 timeStamp)
+{
+    QHash<quint32, Clone>::iterator it = m_clones.find(objId);
+
+    if (it == m_clones.end()) {
+        UAVDataObject *layout = m_layouts.value(objId);
+        if (layout == NULL) {
+            errors++;
+            return false;
+        }
+        Clone clone;
+        clone.object = layout->clone(0);
+        // Nobody listens to the clone, skip the notifications
+        clone.object->blockSignals(true);
+        clone.fields = clone.object->getFields();
+        clone.numElements = 0;
+        foreach(UAVObjectField * field, clone.fields) {
+            clone.numElements += field->getNumElements();
+        }
+        it = m_clones.insert(objId, clone);
+    }
+    if (length != (qint32)it->object->getNumBytes()) {
+        errors++;
+        return false;
+    }
+    it->object->unpack(data);
+
+    UAVObjectTimeSeries &objSeries = series[seriesKey(objId, instId)];
+    if (objSeries.elements.isEmpty()) {
+        objSeries.objId  = objId;
+        objSeries.instId = instId;
+        objSeries.elements.resize(it->numElements);
+        int index = 0;
+        foreach(UAVObjectField * field, it->fields) {
+            objSeries.fieldIndex.insert(field->getName(), index);
+            index += field->getNumElements();
+        }
+    }
+
+    objSeries.timeStamps.append(timeStamp);
+    int index = 0;
+    foreach(UAVObjectField * field, it->fields) {
+        for (quint32 element = 0; element < field->getNumElements(); element++) {
+            objSeries.elements[index++].append(field->getDouble(element));
+        }
+    }
+    return true;
+}
+
+UAVTalkLogDecoder::UAVTalkLogDecoder(UAVObjectManager *objMngr) :
+    m_objMngr(objMngr), m_endTime(0), m_frames(0), m_errors(0)
+{}
+
+/**
+ * Decodes the whole log, blocks until done.
+ * Each log packet is stored as timestamp (4 bytes), size (8 bytes) and data.
+ */
+bool UAVTalkLogDecoder::decode(const QString &fileName)
+{
+    m_series.clear();
+    m_endTime = 0;
+    m_frames  = 0;
+    m_errors  = 0;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "UAVTalkLogDecoder - unable to open" << fileName;
+        return false;
+    }
+    QByteArray log = file.readAll();
+    file.close();
+
+    // Join the packet payloads into one stream, the frames are not
+    // necessarily aligned on the log packets in older logs
+    QByteArray stream;
+    QVector<qint64> packetStart;
+    QVector<quint32> packetTime;
+    stream.reserve(log.size());
+    qint64 pos = 0;
+    while (pos + (qint64)(sizeof(quint32) + sizeof(qint64)) <= log.size()) {
+        quint32 timeStamp;
+        qint64 size;
+        memcpy(&timeStamp, log.constData() + pos, sizeof(timeStamp));
+        memcpy(&size, log.constData() + pos + sizeof(timeStamp), sizeof(size));
+        pos += sizeof(timeStamp) + sizeof(size);
+        if (size < 1 || size > (1024 * 1024) || pos + size > log.size()) {
+            qDebug() << "UAVTalkLogDecoder - log truncated at" << pos;
+            break;
+        }
+        packetStart.append(stream.size());
+        packetTime.append(timeStamp);
+        stream.append(log.constData() + pos, size);
+        pos += size;
+    }
+    log.clear();
+    if (packetStart.isEmpty()) {
+        return false;
+    }
+    m_endTime = packetTime.last();
+
+    // The object types, the chunks unpack into private clones of them
+    QHash<quint32, UAVDataObject *> layouts;
+    foreach(const QList<UAVDataObject *> &instances, m_objMngr->getDataObjects()) {
+        if (!instances.isEmpty()) {
+            layouts.insert(instances.first()->getObjID(), instances.first());
+        }
+    }
+
+    // Split at packet boundaries into chunks of about the same size
+    QThreadPool pool;
+    int numChunks = qMax(1, pool.maxThreadCount() * CHUNKS_PER_THREAD);
+    qint64 chunkSize = stream.size() / numChunks + 1;
+    QList<ChunkDecoder *> chunks;
+    int first = 0;
+    while (first < packetStart.size()) {
+        int last = first + 1;
+        while (last < packetStart.size() && packetStart.at(last) - packetStart.at(first) < chunkSize) {
+            last++;
+        }
+        qint64 end = last < packetStart.size() ? packetStart.at(last) : stream.size();
+        chunks.append(new ChunkDecoder(stream, packetStart, packetTime, layouts, first, packetStart.at(first), end));
+        first = last;
+    }
+
+    foreach(ChunkDecoder * chunk, chunks) {
+        pool.start(chunk);
+    }
+    pool.waitForDone();
+
+    // Chunks are in time order, append their samples one after the other
+    foreach(ChunkDecoder * chunk, chunks) {
+        for (QHash<quint64, UAVObjectTimeSeries>::const_iterator it = chunk->series.constBegin(); it != chunk->series.constEnd(); ++it) {
+            UAVObjectTimeSeries &objSeries = m_series[it.key()];
+            if (objSeries.elements.isEmpty()) {
+                objSeries = *it;
+                continue;
+            }
+            objSeries.timeStamps += it->timeStamps;
+            for (int i = 0; i < objSeries.elements.size(); i++) {
+                objSeries.elements[i] += it->elements.at(i);
+            }
+        }
+        m_frames += chunk->frames;
+        m_errors += chunk->errors;
+        delete chunk;
+    }
+    return true;
+}
+
+const UAVObjectTimeSeries *UAVTalkLogDecoder::series(quint32 objId, quint16 instId) const
+{
+    QHash<quint64, UAVObjectTimeSeries>::const_iterator it = m_series.constFind(seriesKey(objId, instId));
+
+    return it == m_series.constEnd() ? NULL : &it.value();
+}
+
+/**
+ * @}
+ * @}
+ */
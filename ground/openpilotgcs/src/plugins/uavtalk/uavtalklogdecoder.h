@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavtalklogdecoder.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief The UAVTalk protocol plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVTALKLOGDECODER_H
+#define UAVTALKLOGDECODER_H
+
+#include "uavobjectmanager.h"
+#include "uavtalk_global.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * Samples of one object instance decoded from a log: a timestamp per sample (ms since
+ * the start of the log) and one contiguous array per field element.
+ */
+class UAVTALK_EXPORT UAVObjectTimeSeries {
+public:
+    UAVObjectTimeSeries() : objId(0), instId(0) {}
+
+    const QVector<double> *values(const QString &fieldName, int element = 0) const;
+
+    quint32 objId;
+    quint16 instId;
+    QVector<quint32> timeStamps;
+    // Field elements in the order of UAVObject::getFields()
+    QVector< QVector<double> > elements;
+    // Index in elements of the first element of each field
+    QHash<QString, int> fieldIndex;
+};
+
+/**
+ * Decodes a telemetry log (*.opl) into time series without going through the telemetry:
+ * the log is split into chunks at packet boundaries and the chunks are decoded in parallel
+ * on a thread pool, each frame being unpacked into a private clone of its object.
+ */
+class UAVTALK_EXPORT UAVTalkLogDecoder {
+public:
+    UAVTalkLogDecoder(UAVObjectManager *objMngr);
+
+    bool decode(const QString &fileName);
+
+    const UAVObjectTimeSeries *series(quint32 objId, quint16 instId = 0) const;
+    QList<UAVObjectTimeSeries> allSeries() const
+    {
+        return m_series.values();
+    }
+    quint32 endTime() const
+    {
+        return m_endTime;
+    }
+    quint32 frames() const
+    {
+        return m_frames;
+    }
+    quint32 errors() const
+    {
+        return m_errors;
+    }
+
+private:
+    class ChunkDecoder;
+
+    // Chunks per pool thread, a few to even out the load
+    static const int CHUNKS_PER_THREAD = 4;
+
+    UAVObjectManager *m_objMngr;
+    QHash<quint64, UAVObjectTimeSeries> m_series;
+    quint32 m_endTime;
+    quint32 m_frames;
+    quint32 m_errors;
+
+    static quint64 seriesKey(quint32 objId, quint16 instId)
+    {
+        return ((quint64)objId << 16) | instId;
+    }
+};
+
+#endif // UAVTALKLOGDECODER_H
@@ -816,11 +816,12 @@ OP_DFU::Status DFUObject::UploadFirmwareT(const QString &sfile, const bool &veri
     }
 
     if (verify) {
+        // The bootloader already checked the flash against the expected CRC
+        // to report Last_operation_Success, only ask it for the CRC of the
+        // flash again instead of downloading the whole firmware back
         emit operationProgress(QString("Verifying firmware"));
         cout << "Starting code verification\n";
-        QByteArray arr2;
-        StartDownloadT(&arr2, arr.length(), OP_DFU::FW);
-        if (arr != arr2) {
+        if (!findDevices() || device >= devices.length() || devices[device].FW_CRC != crc) {
             cout << "Verify:FAILED\n";
             return OP_DFU::abort;
         }
@@ -34,7 +34,10 @@
 
 UploaderGadgetFactory::UploaderGadgetFactory(QObject *parent) :
     IUAVGadgetFactory(QString("Uploader"), tr("Uploader"), parent), isautocapable(false)
-{}
+{
+    // The setup wizard auto update goes through the gadget
+    setCreatedOnStartupTrue();
+}
 
 UploaderGadgetFactory::~UploaderGadgetFactory()
 {}
@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+##
+##############################################################################
+#
+# @file       simbatch.py
+# @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+# @brief      Runs batches of simposix simulations in parallel for parameter
+#             sweeps and collects the metrics of each run in a CSV file.
+#
+# @see        The GNU Public License (GPL) Version 3
+#
+#############################################################################/
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+
+"""Runs a parameter sweep on simposix instances
+
+Every run starts a simposix instance in its own directory (so that it
+keeps its own settings files) and on its own UDP ports (-p option), at
+the -s speed factor. Once the telemetry is connected the run settings
+are sent through UAVTalk, then the flight plan steps are sent at their
+flight time. The time of a run is the SystemStats FlightTime of the
+simulation, so the plan does not depend on the speed factor.
+
+The sweep is a JSON file:
+
+  {
+    "duration": 120,                  flight time of each run, in seconds
+    "settings": { "Object.Field.Element": value, ... },
+    "sweep":    { "Object.Field.Element": [value, ...], ... },
+    "repeat":   1,
+    "plan":     [ { "time": 10, "set": { "Object.Field": value } }, ... ],
+    "error":    "PathStatus.error",   field giving the tracking error
+    "settle":   0.5                   error bound of the settling time
+  }
+
+The runs are all the combinations of the "sweep" values, on top of the
+common "settings". Enum values are given by their option name, a value
+given for a multi element field without an element sets all of them.
+
+The results file has a line per run with its sweep values, the mean and
+max tracking error, the settling time after the last plan step, the
+SystemStats CPU load and the running time of the tasks from TaskInfo.
+"""
+
+import csv
+import itertools
+import json
+import optparse
+import os
+import queue
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import uavtalk
+
+ROOT_DIR       = os.path.realpath(os.path.join(os.path.dirname(__file__), "..", ".."))
+XML_DIR        = os.path.join(ROOT_DIR, "shared", "uavobjectdefinition")
+FIRMWARE       = os.path.join(ROOT_DIR, "build", "firmware", "fw_simposix", "fw_simposix.elf")
+TELEMETRY_PORT = 9000
+# simposix uses 3 consecutive UDP ports (telemetry, GPS, aux)
+PORT_STRIDE    = 10
+
+def split_path(path):
+    """Splits Object.Field[.Element]"""
+    parts = path.split(".")
+    if len(parts) < 2 or len(parts) > 3:
+        raise ValueError("%s is not Object.Field[.Element]" % path)
+    return parts[0], parts[1], parts[2] if len(parts) == 3 else None
+
+def set_value(definition, values, path, value):
+    _, fieldname, element = split_path(path)
+    field = definition.field(fieldname)
+    if element is not None:
+        values[fieldname][field.elementnames.index(element)] = value
+    elif field.nelements > 1 and not isinstance(value, list):
+        values[fieldname] = [value] * field.nelements
+    else:
+        values[fieldname] = value
+
+def get_value(definition, values, path):
+    _, fieldname, element = split_path(path)
+    if element is not None:
+        return values[fieldname][definition.field(fieldname).elementnames.index(element)]
+    return values[fieldname]
+
+def apply_settings(conn, settings):
+    """Sends the Object.Field[.Element] values, starting from the current objects"""
+    objects = {}
+    for path in settings:
+        objects.setdefault(split_path(path)[0], []).append(path)
+    for name, paths in sorted(objects.items()):
+        values = conn.request(name)
+        if values is None:
+            return "no reply to the %s request" % name
+        for path in paths:
+            set_value(conn.defs[name], values, path, settings[path])
+        if not conn.send(name, values, acked = True):
+            return "%s not acknowledged" % name
+    return None
+
+class Metrics(object):
+    def __init__(self, definitions, error, settle):
+        self.defs      = definitions
+        self.error     = error
+        self.settle    = settle
+        self.now       = None
+        self.lastStep  = 0.0
+        self.errors    = []
+        self.cpuLoad   = []
+        self.taskLoad  = []
+        self.taskMax   = {}
+        self.taskNames = definitions["TaskInfo"].field("RunningTime").elementnames
+
+    def update(self, name, values):
+        if name == "SystemStats":
+            self.now = values["FlightTime"] / 1000.0
+            self.cpuLoad.append(values["CPULoad"])
+        if self.now is None:
+            return
+        if name == split_path(self.error)[0]:
+            self.errors.append((self.now, abs(get_value(self.defs[name], values, self.error))))
+        if name == "TaskInfo":
+            self.taskLoad.append(sum(values["RunningTime"]))
+            for task, load in zip(self.taskNames, values["RunningTime"]):
+                self.taskMax[task] = max(self.taskMax.get(task, 0), load)
+
+    def settlingTime(self):
+        """Time after the last plan step until the error stays within the bound"""
+        samples = [(t, e) for t, e in self.errors if t >= self.lastStep]
+        if not samples or samples[-1][1] > self.settle:
+            return None
+        settled = samples[0][0]
+        for (t, e), following in zip(samples, samples[1:]):
+            if e > self.settle:
+                settled = following[0]
+        return settled - self.lastStep
+
+    def results(self):
+        errors = [e for t, e in self.errors]
+        busiest = max(self.taskMax, key = self.taskMax.get) if self.taskMax else None
+        return {
+            "error_mean":    sum(errors) / len(errors) if errors else None,
+            "error_max":     max(errors) if errors else None,
+            "settling_time": self.settlingTime(),
+            "cpu_load_mean": sum(self.cpuLoad) / len(self.cpuLoad) if self.cpuLoad else None,
+            "cpu_load_max":  max(self.cpuLoad) if self.cpuLoad else None,
+            "task_load_mean": sum(self.taskLoad) / len(self.taskLoad) if self.taskLoad else None,
+            "busiest_task":  busiest,
+            "busiest_task_load": self.taskMax[busiest] if busiest else None,
+        }
+
+METRICS = ["error_mean", "error_max", "settling_time", "cpu_load_mean", "cpu_load_max",
+           "task_load_mean", "busiest_task", "busiest_task_load"]
+
+def simulate(run, slot, sweep, options, definitions):
+    """Runs one simulation on the ports of the slot, returns its results"""
+    rundir = os.path.join(options.workdir, run["name"])
+    os.makedirs(rundir, exist_ok = True)
+    offset = slot * PORT_STRIDE
+    duration = float(sweep.get("duration", 60))
+    result = {"name": run["name"], "status": "ok"}
+
+    log = open(os.path.join(rundir, "simposix.log"), "w")
+    proc = subprocess.Popen([options.firmware, "-s", str(options.speed), "-p", str(offset)],
+                            cwd = rundir, stdout = log, stderr = subprocess.STDOUT)
+    conn = uavtalk.UAVTalkConnection(definitions, "127.0.0.1", TELEMETRY_PORT + offset)
+    metrics = Metrics(definitions, sweep.get("error", "PathStatus.error"), float(sweep.get("settle", 0.5)))
+    try:
+        if not conn.connect(options.timeout):
+            result["status"] = "telemetry not connected"
+            return result
+        error = apply_settings(conn, run["settings"])
+        if error:
+            result["status"] = error
+            return result
+
+        conn.listeners.append(metrics.update)
+        plan = sorted(sweep.get("plan", []), key = lambda step: step["time"])
+        # the flight side drops the GCS after 8s of flight time without updates
+        keepalive = min(1.0, 2.0 / options.speed)
+        lastKeepalive = 0.0
+        start = None
+        deadline = time.time() + options.timeout + 4.0 * duration / options.speed
+        while proc.poll() is None:
+            conn.process(0.005)
+            if time.time() - lastKeepalive > keepalive:
+                conn.send_gcs_stats()
+                lastKeepalive = time.time()
+            if metrics.now is None:
+                continue
+            if start is None:
+                start = metrics.now
+            elapsed = metrics.now - start
+            while plan and plan[0]["time"] <= elapsed:
+                error = apply_settings(conn, plan.pop(0)["set"])
+                if error:
+                    result["status"] = error
+                    return result
+                metrics.lastStep = metrics.now
+            if elapsed >= duration:
+                break
+            if time.time() > deadline:
+                result["status"] = "timeout"
+                break
+        else:
+            result["status"] = "simulation exited (%d)" % proc.returncode
+    finally:
+        conn.close()
+        if proc.poll() is None:
+            proc.terminate()
+            try:
+                proc.wait(5)
+            except subprocess.TimeoutExpired:
+                proc.kill()
+                proc.wait()
+        log.close()
+        result.update(metrics.results())
+    return result
+
+def expand_runs(sweep):
+    """All the combinations of the sweep values, on top of the common settings"""
+    keys = list(sweep.get("sweep", {}).keys())
+    runs = []
+    for values in itertools.product(*[sweep["sweep"][k] for k in keys]):
+        for repeat in range(int(sweep.get("repeat", 1))):
+            settings = dict(sweep.get("settings", {}))
+            settings.update(zip(keys, values))
+            runs.append({"name": "run%04d" % len(runs), "params": dict(zip(keys, values)), "settings": settings})
+    return keys, runs
+
+def main():
+    parser = optparse.OptionParser(usage = "%prog [options] sweep.json", description = __doc__.split("\n")[0])
+    parser.add_option("-f", "--firmware", default = FIRMWARE, help = "simposix executable [%default]")
+    parser.add_option("-j", "--jobs", type = "int", default = os.cpu_count(), help = "simulations run in parallel [%default]")
+    parser.add_option("-s", "--speed", type = "int", default = 10, help = "speed factor of the simulations [%default]")
+    parser.add_option("-o", "--output", default = "simbatch.csv", help = "results file [%default]")
+    parser.add_option("-w", "--workdir", default = "simbatch", help = "directory of the runs [%default]")
+    parser.add_option("-t", "--timeout", type = "float", default = 30.0, help = "connection timeout in seconds [%default]")
+    options, args = parser.parse_args()
+    if len(args) != 1:
+        parser.error("one sweep file expected")
+
+    with open(args[0]) as f:
+        sweep = json.load(f)
+    definitions = uavtalk.UAVObjectDefinitions(XML_DIR)
+    keys, runs = expand_runs(sweep)
+
+    slots = queue.Queue()
+    for slot in range(options.jobs):
+        slots.put(slot)
+
+    def job(run):
+        slot = slots.get()
+        try:
+            result = simulate(run, slot, sweep, options, definitions)
+        finally:
+            slots.put(slot)
+        result.update(run["params"])
+        print("%s: %s" % (run["name"], result["status"]))
+        sys.stdout.flush()
+        return result
+
+    with ThreadPoolExecutor(max_workers = options.jobs) as executor:
+        results = list(executor.map(job, runs))
+
+    with open(options.output, "w") as f:
+        writer = csv.DictWriter(f, ["name", "status"] + keys + METRICS)
+        writer.writeheader()
+        for result in results:
+            writer.writerow(result)
+    failed = len([r for r in results if r["status"] != "ok"])
+    print("%d runs, %d failed, results in %s" % (len(results), failed, options.output))
+    return 1 if failed else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
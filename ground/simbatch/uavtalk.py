@@ -0,0 +1,328 @@
+##
+##############################################################################
+#
+# @file       uavtalk.py
+# @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+# @brief      Minimal UAVTalk client for the simulation harness, the object
+#             definitions are read from the UAVObject XML files.
+#
+# @see        The GNU Public License (GPL) Version 3
+#
+#############################################################################/
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+
+import glob
+import os
+import select
+import socket
+import struct
+import time
+import xml.etree.ElementTree as ElementTree
+
+# Field types, in the order of the UAVObjectGenerator
+FIELD_TYPES   = ["int8", "int16", "int32", "uint8", "uint16", "uint32", "float", "enum"]
+FIELD_STRUCTS = ["b", "h", "i", "B", "H", "I", "f", "B"]
+FIELD_SIZES   = [1, 2, 4, 1, 2, 4, 4, 1]
+FIELD_FLOAT   = 6
+FIELD_ENUM    = 7
+
+# Packet types, see flight/uavtalk/inc/uavtalk_priv.h
+SYNC_VAL        = 0x3C
+TYPE_MASK       = 0x78
+TYPE_VER        = 0x20
+TIMESTAMPED     = 0x80
+TYPE_OBJ        = TYPE_VER | 0x00
+TYPE_OBJ_REQ    = TYPE_VER | 0x01
+TYPE_OBJ_ACK    = TYPE_VER | 0x02
+TYPE_ACK        = TYPE_VER | 0x03
+TYPE_NACK       = TYPE_VER | 0x04
+TYPE_OBJ_MULTI  = TYPE_VER | 0x05
+HEADER_LENGTH   = 10
+MULTI_RECORD_HEADER_LENGTH = 6
+
+def _crc8(data, crc = 0):
+    """CRC-8 with the 0x07 polynomial, as PIOS_CRC_updateCRC"""
+    for b in data:
+        crc ^= b
+        for n in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+def _hash(value, h):
+    """Shift-Add-XOR hash of the UAVObjectParser"""
+    return (h ^ ((h << 5) + (h >> 2) + value)) & 0xFFFFFFFF
+
+def _hash_string(value, h):
+    for c in value.encode("latin-1"):
+        # the generator hashes signed chars
+        h = _hash(c - 256 if c > 127 else c, h)
+    return h
+
+class UAVObjectField(object):
+    def __init__(self, name, type, elementnames, options):
+        self.name         = name
+        self.type         = type
+        self.elementnames = elementnames
+        self.options      = options
+        self.nelements    = len(elementnames)
+
+    def struct(self):
+        return "%u%s" % (self.nelements, FIELD_STRUCTS[self.type])
+
+    def to_raw(self, value):
+        """Converts an enum option name or a number to the packed value"""
+        if self.type == FIELD_ENUM and not isinstance(value, int):
+            return self.options.index(value)
+        if self.type == FIELD_FLOAT:
+            return float(value)
+        return int(value)
+
+    def from_raw(self, value):
+        if self.type == FIELD_ENUM and value < len(self.options):
+            return self.options[value]
+        return value
+
+class UAVObjectDefinition(object):
+    def __init__(self, name, issettings, issingle, fields):
+        self.name       = name
+        self.issettings = issettings
+        self.issingle   = issingle
+        # the generator packs the fields sorted by size, largest first
+        self.fields     = sorted(fields, key = lambda f: -FIELD_SIZES[f.type])
+        self.struct     = struct.Struct("<" + "".join(f.struct() for f in self.fields))
+        self.size       = self.struct.size
+        self.objid      = self._calculate_id()
+
+    def _calculate_id(self):
+        h = _hash_string(self.name, 0)
+        h = _hash(1 if self.issettings else 0, h)
+        h = _hash(1 if self.issingle else 0, h)
+        for f in self.fields:
+            h = _hash_string(f.name, h)
+            h = _hash(f.nelements, h)
+            h = _hash(f.type, h)
+            if f.type == FIELD_ENUM:
+                for o in f.options:
+                    h = _hash_string(o, h)
+        return h & 0xFFFFFFFE
+
+    def field(self, name):
+        for f in self.fields:
+            if f.name == name:
+                return f
+        raise KeyError("%s has no field %s" % (self.name, name))
+
+    def unpack(self, data):
+        """Returns a dict of the field values, lists for the multi element fields"""
+        raw = self.struct.unpack(data[:self.size])
+        values = {}
+        n = 0
+        for f in self.fields:
+            v = [f.from_raw(x) for x in raw[n:n + f.nelements]]
+            values[f.name] = v if f.nelements > 1 else v[0]
+            n += f.nelements
+        return values
+
+    def pack(self, values):
+        raw = []
+        for f in self.fields:
+            v = values[f.name]
+            if f.nelements == 1:
+                v = [v]
+            raw.extend(f.to_raw(x) for x in v)
+        return self.struct.pack(*raw)
+
+def _element_texts(node, listname, itemname):
+    listnode = node.find(listname)
+    if listnode is None:
+        return []
+    return [e.text for e in listnode.findall(itemname) if e.text]
+
+def _split(value):
+    return [x.strip() for x in value.split(",") if x.strip()]
+
+class UAVObjectDefinitions(object):
+    """All the object definitions of a UAVObject XML directory"""
+    def __init__(self, xmldir):
+        self.byname = {}
+        self.byid   = {}
+        for filename in sorted(glob.glob(os.path.join(xmldir, "*.xml"))):
+            for obj in ElementTree.parse(filename).getroot().findall("object"):
+                d = self._parse(obj)
+                self.byname[d.name] = d
+                self.byid[d.objid]  = d
+
+    def _parse(self, obj):
+        fields = []
+        for f in obj.findall("field"):
+            if f.get("cloneof"):
+                parent = [p for p in fields if p.name == f.get("cloneof")][0]
+                fields.append(UAVObjectField(f.get("name"), parent.type, parent.elementnames, parent.options))
+                continue
+            ftype = FIELD_TYPES.index(f.get("type"))
+            if f.get("elementnames"):
+                names = _split(f.get("elementnames"))
+            else:
+                names = _element_texts(f, "elementnames", "elementname")
+            if not names:
+                names = [str(n) for n in range(int(f.get("elements")))]
+            options = []
+            if ftype == FIELD_ENUM:
+                if f.get("options"):
+                    options = _split(f.get("options"))
+                else:
+                    options = _element_texts(f, "options", "option")
+            fields.append(UAVObjectField(f.get("name"), ftype, names, options))
+        return UAVObjectDefinition(obj.get("name"), obj.get("settings") == "true",
+                                   obj.get("singleinstance") == "true", fields)
+
+    def __getitem__(self, name):
+        return self.byname[name]
+
+class UAVTalkConnection(object):
+    """UAVTalk over the UDP telemetry port of a simposix instance"""
+    def __init__(self, definitions, host, port):
+        self.defs    = definitions
+        self.sock    = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.connect((host, port))
+        self.rx      = bytearray()
+        self.objects = {}  # last received values, by object name
+        self.updated = {}  # time of the last update, by object name
+        self.acks    = set()
+        self.listeners = []
+
+    def close(self):
+        self.sock.close()
+
+    def _send_packet(self, type, objid, instid, data = b""):
+        packet = struct.pack("<BBHIH", SYNC_VAL, type, HEADER_LENGTH + len(data), objid, instid) + data
+        try:
+            self.sock.send(packet + struct.pack("B", _crc8(packet)))
+        except socket.error:
+            # nobody listening yet, the simulation is still starting
+            pass
+
+    def send(self, name, values, instid = 0, acked = False, timeout = 1.0, retries = 3):
+        d = self.defs[name]
+        if not acked:
+            self._send_packet(TYPE_OBJ, d.objid, instid, d.pack(values))
+            return True
+        for n in range(retries):
+            self.acks.discard((d.objid, instid))
+            self._send_packet(TYPE_OBJ_ACK, d.objid, instid, d.pack(values))
+            end = time.time() + timeout
+            while time.time() < end:
+                self.process(end - time.time())
+                if (d.objid, instid) in self.acks:
+                    return True
+        return False
+
+    def request(self, name, instid = 0, timeout = 1.0, retries = 3):
+        """Requests the object, returns its values or None"""
+        d = self.defs[name]
+        for n in range(retries):
+            self.updated.pop(name, None)
+            self._send_packet(TYPE_OBJ_REQ, d.objid, instid)
+            end = time.time() + timeout
+            while time.time() < end:
+                self.process(end - time.time())
+                if name in self.updated:
+                    return self.objects[name]
+        return None
+
+    def process(self, timeout = 0.0):
+        """Reads and handles the available packets, waits up to timeout for the first one"""
+        ready, _, _ = select.select([self.sock], [], [], max(timeout, 0.0))
+        while ready:
+            try:
+                self.rx.extend(self.sock.recv(4096))
+            except socket.error:
+                break
+            ready, _, _ = select.select([self.sock], [], [], 0.0)
+        self._parse()
+
+    def _parse(self):
+        while True:
+            start = self.rx.find(bytes([SYNC_VAL]))
+            if start < 0:
+                del self.rx[:]
+                return
+            del self.rx[:start]
+            if len(self.rx) < HEADER_LENGTH:
+                return
+            type, length, objid, instid = struct.unpack_from("<BHIH", self.rx, 1)
+            if (type & TYPE_MASK) != TYPE_VER or length < HEADER_LENGTH:
+                del self.rx[:1]
+                continue
+            if len(self.rx) < length + 1:
+                return
+            if _crc8(self.rx[:length]) != self.rx[length]:
+                del self.rx[:1]
+                continue
+            header = HEADER_LENGTH + (2 if type & TIMESTAMPED else 0)
+            data   = bytes(self.rx[header:length])
+            del self.rx[:length + 1]
+            self._handle(type & ~TIMESTAMPED, objid, instid, data)
+
+    def _handle(self, type, objid, instid, data):
+        if type == TYPE_ACK:
+            self.acks.add((objid, instid))
+        elif type in (TYPE_OBJ, TYPE_OBJ_ACK):
+            self._received(objid, data)
+            if type == TYPE_OBJ_ACK:
+                self._send_packet(TYPE_ACK, objid, instid)
+        elif type == TYPE_OBJ_MULTI:
+            # The first record uses the header IDs, the following ones carry their own
+            while data:
+                d = self.defs.byid.get(objid)
+                if d is None or d.size > len(data):
+                    return
+                self._received(objid, data[:d.size])
+                data = data[d.size:]
+                if len(data) < MULTI_RECORD_HEADER_LENGTH:
+                    return
+                objid, instid = struct.unpack_from("<IH", data)
+                data = data[MULTI_RECORD_HEADER_LENGTH:]
+
+    def _received(self, objid, data):
+        d = self.defs.byid.get(objid)
+        if d is None or len(data) < d.size:
+            return
+        self.objects[d.name] = d.unpack(data)
+        self.updated[d.name] = time.time()
+        for listener in self.listeners:
+            listener(d.name, self.objects[d.name])
+
+    def connect(self, timeout = 10.0):
+        """Runs the telemetry handshake, the flight side then sends its periodic objects"""
+        end = time.time() + timeout
+        status = "HandshakeReq"
+        while time.time() < end:
+            self.send_gcs_stats(status)
+            self.process(0.1)
+            flight = self.objects.get("FlightTelemetryStats")
+            if flight and flight["Status"] in ("HandshakeAck", "Connected"):
+                if status == "Connected" and flight["Status"] == "Connected":
+                    return True
+                status = "Connected"
+        return False
+
+    def send_gcs_stats(self, status = "Connected"):
+        d = self.defs["GCSTelemetryStats"]
+        values = d.unpack(bytes(d.size))
+        values["Status"] = status
+        self.send("GCSTelemetryStats", values)
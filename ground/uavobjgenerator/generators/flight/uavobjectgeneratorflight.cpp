@@ -50,10 +50,12 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
         return false;
     }
 
+    // The object files are generated in parallel, the loop below only collects their names
+    processObjects(this, parser);
+
     sizeCalc = 0;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
-        process_object(info);
         flightObjInit.append("#ifdef UAVOBJ_INIT_" + info->namelc + "\n");
         flightObjInit.append("    " + info->name + "Initialize();\n");
         flightObjInit.append("#endif\n");
@@ -98,6 +100,69 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
 }
 
 
+/**
+ * Generate the aligned in-memory layout of an object and its converters.
+ * Multi element fields come first, aligned for vector access, all fields keep their natural alignment.
+ **/
+QString UAVObjectGeneratorFlight::alignedData(ObjectInfo *info)
+{
+    QString fields;
+    QString toAligned;
+    QString fromAligned;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int n = 0; n < info->fields.length(); ++n) {
+            FieldInfo *field = info->fields[n];
+            if ((field->numElements > 1) != (pass == 0)) {
+                continue;
+            }
+            if (field->numElements > 1) {
+                fields.append(QString("    %1 %2[%3] __attribute__((aligned(%4)));\n")
+                              .arg(fieldTypeStrC[field->type])
+                              .arg(field->name)
+                              .arg(field->numElements)
+                              .arg(ALIGNED_FIELD_BYTES));
+                toAligned.append(QString("    memcpy(aligned->%1, &data->%1, sizeof(aligned->%1));\n").arg(field->name));
+                fromAligned.append(QString("    memcpy(&data->%1, aligned->%1, sizeof(aligned->%1));\n").arg(field->name));
+            } else {
+                fields.append(QString("    %1 %2;\n").arg(fieldTypeStrC[field->type]).arg(field->name));
+                toAligned.append(QString("    aligned->%1 = data->%1;\n").arg(field->name));
+                fromAligned.append(QString("    data->%1 = aligned->%1;\n").arg(field->name));
+            }
+        }
+    }
+
+    QString out;
+    out.append("/*\n");
+    out.append(" * Aligned in-memory layout, for processing the data with vector instructions.\n");
+    out.append(" * It is converted from and to the packed data, which stays the wire format.\n");
+    out.append(" */\n");
+    out.append(QString("typedef struct {\n%1} $(NAME)Aligned;\n\n").arg(fields));
+    out.append("static inline void $(NAME)ToAligned(const $(NAME)Data *data, $(NAME)Aligned *aligned)\n");
+    out.append(QString("{\n%1}\n").arg(toAligned));
+    out.append("static inline void $(NAME)FromAligned(const $(NAME)Aligned *aligned, $(NAME)Data *data)\n");
+    out.append(QString("{\n%1}\n").arg(fromAligned));
+    out.append("static inline int32_t $(NAME)InstGetAligned(uint16_t instId, $(NAME)Aligned *alignedOut)\n");
+    out.append("{\n");
+    out.append("    $(NAME)Data data;\n");
+    out.append("    if ($(NAME)InstGet(instId, &data) != 0) {\n");
+    out.append("        return -1;\n");
+    out.append("    }\n");
+    out.append("    $(NAME)ToAligned(&data, alignedOut);\n");
+    out.append("    return 0;\n");
+    out.append("}\n");
+    out.append("static inline int32_t $(NAME)InstSetAligned(uint16_t instId, const $(NAME)Aligned *alignedIn)\n");
+    out.append("{\n");
+    out.append("    $(NAME)Data data;\n");
+    out.append("    $(NAME)FromAligned(alignedIn, &data);\n");
+    out.append("    return $(NAME)InstSet(instId, &data);\n");
+    out.append("}\n");
+    out.append("static inline int32_t $(NAME)GetAligned($(NAME)Aligned *alignedOut) { return $(NAME)InstGetAligned(0, alignedOut); }\n");
+    out.append("static inline int32_t $(NAME)SetAligned(const $(NAME)Aligned *alignedIn) { return $(NAME)InstSetAligned(0, alignedIn); }\n\n");
+    out.replace(QString("$(NAME)"), info->name);
+    return out;
+}
+
 /**
  * Generate the Flight object files
  **/
@@ -204,6 +269,9 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
     }
     outInclude.replace(QString("$(DATAFIELDINFO)"), enums);
 
+    // Replace the $(ALIGNEDDATA) tag
+    outInclude.replace(QString("$(ALIGNEDDATA)"), info->isAligned ? alignedData(info) : QString());
+
     // Replace the $(INITFIELDS) tag
     QString initfields;
     for (int n = 0; n < info->fields.length(); ++n) {
@@ -256,142 +324,67 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
     // Replace the $(SETGETFIELDS) tag
     QString setgetfields;
     for (int n = 0; n < info->fields.length(); ++n) {
-        // if (!info->fields[n]->defaultValues.isEmpty() )
-        {
-            // For non-array fields
-            if (info->fields[n]->numElements == 1) {
-                /* Set */
-                setgetfields.append(QString("void %2%3Set(%1 *New%3)\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), sizeof(%3));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
-
-                /* GET */
-                setgetfields.append(QString("void %2%3Get(%1 *New%3)\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), sizeof(%3));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
-            } else {
-                // When no struct accessor is available for a field array accessor is the default.
-                QString suffix = QString("");
-
-                if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
-                    // struct based field accessor
-                    QString structTypeName = QString("%1%2Data").arg(info->name).arg(info->fields[n]->name);
-                    /* SET */
-                    setgetfields.append(QString("void %2%3Set( %1 *New%3 )\n")
-                                        .arg(structTypeName)
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name));
-                    setgetfields.append(QString("{\n"));
-                    setgetfields.append(QString("    UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name)
-                                        .arg(info->fields[n]->numElements)
-                                        .arg(fieldTypeStrC[info->fields[n]->type]));
-                    setgetfields.append(QString("}\n"));
-
-                    /* GET */
-                    setgetfields.append(QString("void %2%3Get( %1 *New%3 )\n")
-                                        .arg(structTypeName)
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name));
-                    setgetfields.append(QString("{\n"));
-                    setgetfields.append(QString("    UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name)
-                                        .arg(info->fields[n]->numElements)
-                                        .arg(fieldTypeStrC[info->fields[n]->type]));
-                    setgetfields.append(QString("}\n"));
-
-                    // Append array suffix to array accessors
-                    suffix = QString("Array");
-                }
+        QString fieldType = fieldTypeStrC[info->fields[n]->type];
+        QString fieldName = info->fields[n]->name;
+        // For non-array fields
+        if (info->fields[n]->numElements == 1) {
+            /* SET */
+            setgetfields.append(QString("static inline void %2%3Set(%1 *New%3) { UAVObjSetDataField(%2Handle(), (void *)New%3, offsetof(%2Data, %3), sizeof(%1)); }\n")
+                                .arg(fieldType)
+                                .arg(info->name)
+                                .arg(fieldName));
+
+            /* GET, the fields are sorted by size so scalars are naturally aligned */
+            setgetfields.append(QString("static inline void %2%3Get(%1 *New%3) { *New%3 = *(const volatile %1 *)((const uint8_t *)%2DataPtr + offsetof(%2Data, %3)); }\n")
+                                .arg(fieldType)
+                                .arg(info->name)
+                                .arg(fieldName));
+        } else {
+            // When no struct accessor is available for a field array accessor is the default.
+            QString suffix = QString("");
 
-                // array based field accessor
+            if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
+                // struct based field accessor
+                QString structTypeName = QString("%1%2Data").arg(info->name).arg(fieldName);
                 /* SET */
-                setgetfields.append(QString("void %2%3%4Set( %1 *New%3 )\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(suffix));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
+                setgetfields.append(QString("static inline void %2%3Set(%1 *New%3) { UAVObjSetDataField(%2Handle(), (void *)New%3, offsetof(%2Data, %3), %4 * sizeof(%5)); }\n")
+                                    .arg(structTypeName)
                                     .arg(info->name)
-                                    .arg(info->fields[n]->name)
+                                    .arg(fieldName)
                                     .arg(info->fields[n]->numElements)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
+                                    .arg(fieldType));
 
                 /* GET */
-                setgetfields.append(QString("void %2%3%4Get( %1 *New%3 )\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
+                setgetfields.append(QString("static inline void %2%3Get(%1 *New%3) { UAVObjGetDataField(%2Handle(), (void *)New%3, offsetof(%2Data, %3), %4 * sizeof(%5)); }\n")
+                                    .arg(structTypeName)
                                     .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(suffix));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
+                                    .arg(fieldName)
                                     .arg(info->fields[n]->numElements)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
-            }
-        }
-    }
-    outCode.replace(QString("$(SETGETFIELDS)"), setgetfields);
+                                    .arg(fieldType));
 
-    // Replace the $(SETGETFIELDSEXTERN) tag
-    QString setgetfieldsextern;
-    for (int n = 0; n < info->fields.length(); ++n) {
-        // if (!info->fields[n]->defaultValues.isEmpty() )
-        {
-            QString suffix = QString("");
-            if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
-                // struct based field accessor
-                QString structTypeName = QString("%1%2Data").arg(info->name).arg(info->fields[n]->name);
-
-                /* SET */
-                setgetfieldsextern.append(QString("extern void %2%3Set(%1 *New%3);\n")
-                                          .arg(structTypeName)
-                                          .arg(info->name)
-                                          .arg(info->fields[n]->name));
-
-                /* GET */
-                setgetfieldsextern.append(QString("extern void %2%3Get(%1 *New%3);\n")
-                                          .arg(structTypeName)
-                                          .arg(info->name)
-                                          .arg(info->fields[n]->name));
+                // Append array suffix to array accessors
                 suffix = QString("Array");
             }
+
+            // array based field accessor
             /* SET */
-            setgetfieldsextern.append(QString("extern void %2%3%4Set(%1 *New%3);\n")
-                                      .arg(fieldTypeStrC[info->fields[n]->type])
-                                      .arg(info->name)
-                                      .arg(info->fields[n]->name)
-                                      .arg(suffix));
+            setgetfields.append(QString("static inline void %2%3%4Set(%1 *New%3) { UAVObjSetDataField(%2Handle(), (void *)New%3, offsetof(%2Data, %3), %5 * sizeof(%1)); }\n")
+                                .arg(fieldType)
+                                .arg(info->name)
+                                .arg(fieldName)
+                                .arg(suffix)
+                                .arg(info->fields[n]->numElements));
 
             /* GET */
-            setgetfieldsextern.append(QString("extern void %2%3%4Get(%1 *New%3);\n")
-                                      .arg(fieldTypeStrC[info->fields[n]->type])
-                                      .arg(info->name)
-                                      .arg(info->fields[n]->name)
-                                      .arg(suffix));
+            setgetfields.append(QString("static inline void %2%3%4Get(%1 *New%3) { UAVObjGetDataField(%2Handle(), (void *)New%3, offsetof(%2Data, %3), %5 * sizeof(%1)); }\n")
+                                .arg(fieldType)
+                                .arg(info->name)
+                                .arg(fieldName)
+                                .arg(suffix)
+                                .arg(info->fields[n]->numElements));
         }
     }
-    outInclude.replace(QString("$(SETGETFIELDSEXTERN)"), setgetfieldsextern);
+    outInclude.replace(QString("$(SETGETFIELDS)"), setgetfields);
 
     // Write the flight code
     bool res = writeFileIfDiffrent(flightOutputPath.absolutePath() + "/" + info->namelc + ".c", outCode);
@@ -406,5 +399,11 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
         return false;
     }
 
+    QStringList inputs = QStringList() << info->filepath
+                                       << flightCodePath.absoluteFilePath("uavobject.c.template")
+                                       << flightCodePath.absoluteFilePath("inc/uavobject.h.template");
+    addDependencies(flightOutputPath.absolutePath() + "/" + info->namelc + ".c", inputs);
+    addDependencies(flightOutputPath.absolutePath() + "/" + info->namelc + ".h", inputs);
+
     return true;
 }
@@ -40,7 +40,9 @@ public:
     QDir flightOutputPath;
 
 private:
+    template<class Generator> friend class ObjectProcessor;
     bool process_object(ObjectInfo *info);
+    QString alignedData(ObjectInfo *info);
 };
 
 #endif
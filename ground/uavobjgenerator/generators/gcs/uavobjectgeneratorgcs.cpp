@@ -48,12 +48,14 @@ bool UAVObjectGeneratorGCS::generate(UAVObjectParser *parser, QString templatepa
         return false;
     }
 
+    // The object files are generated in parallel, the loop below only collects their names
+    processObjects(this, parser);
+
     QString objInc;
     QString gcsObjInit;
 
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
-        process_object(info);
 
         gcsObjInit.append("    objMngr->registerObject( new " + info->name + "() );\n");
         objInc.append("#include \"" + info->namelc + ".h\"\n");
@@ -71,6 +73,80 @@ bool UAVObjectGeneratorGCS::generate(UAVObjectParser *parser, QString templatepa
     return true; // if we come here everything should be fine
 }
 
+/**
+ * Generate the aligned in-memory layout of an object and its converters, only for the
+ * objects with the aligned attribute. Multi element fields come first, aligned for vector
+ * access, all fields keep their natural alignment.
+ **/
+void UAVObjectGeneratorGCS::alignedData(ObjectInfo *info, QString & outInclude, QString & outCode)
+{
+    if (!info->isAligned) {
+        outInclude.replace(QString("$(ALIGNEDDATA)"), QString());
+        outCode.replace(QString("$(ALIGNEDDATA_IMPL)"), QString());
+        return;
+    }
+
+    QString fields;
+    QString toAligned;
+    QString fromAligned;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int n = 0; n < info->fields.length(); ++n) {
+            FieldInfo *field = info->fields[n];
+            if ((field->numElements > 1) != (pass == 0)) {
+                continue;
+            }
+            if (field->numElements > 1) {
+                fields.append(QString("        %1 %2[%3] __attribute__((aligned(%4)));\n")
+                              .arg(fieldTypeStrCPP[field->type])
+                              .arg(field->name)
+                              .arg(field->numElements)
+                              .arg(ALIGNED_FIELD_BYTES));
+                toAligned.append(QString("    for (int n = 0; n < %1; ++n) {\n"
+                                         "        aligned.%2[n] = data.%2[n];\n"
+                                         "    }\n").arg(field->numElements).arg(field->name));
+                fromAligned.append(QString("    for (int n = 0; n < %1; ++n) {\n"
+                                           "        data.%2[n] = aligned.%2[n];\n"
+                                           "    }\n").arg(field->numElements).arg(field->name));
+            } else {
+                fields.append(QString("        %1 %2;\n").arg(fieldTypeStrCPP[field->type]).arg(field->name));
+                toAligned.append(QString("    aligned.%1 = data.%1;\n").arg(field->name));
+                fromAligned.append(QString("    data.%1 = aligned.%1;\n").arg(field->name));
+            }
+        }
+    }
+
+    QString decl;
+    decl.append("    // Aligned in-memory layout, for processing the data with vector instructions.\n");
+    decl.append("    // It is converted from and to DataFields, which stays the wire format.\n");
+    decl.append(QString("    typedef struct {\n%1    } AlignedFields;\n\n").arg(fields));
+    decl.append("    static void toAligned(const DataFields & data, AlignedFields & aligned);\n");
+    decl.append("    static void fromAligned(const AlignedFields & aligned, DataFields & data);\n");
+    decl.append("    AlignedFields getAlignedData();\n");
+    decl.append("    void setAlignedData(const AlignedFields & aligned);\n");
+    outInclude.replace(QString("$(ALIGNEDDATA)"), decl);
+
+    QString impl;
+    impl.append("/**\n * Convert the object data fields to the aligned layout\n */\n");
+    impl.append(QString("void %1::toAligned(const DataFields & data, AlignedFields & aligned)\n{\n%2}\n\n").arg(info->name).arg(toAligned));
+    impl.append("/**\n * Convert the aligned layout to the object data fields\n */\n");
+    impl.append(QString("void %1::fromAligned(const AlignedFields & aligned, DataFields & data)\n{\n%2}\n\n").arg(info->name).arg(fromAligned));
+    impl.append("/**\n * Get the object data fields in the aligned layout\n */\n");
+    impl.append(QString("%1::AlignedFields %1::getAlignedData()\n"
+                        "{\n"
+                        "    AlignedFields aligned;\n\n"
+                        "    toAligned(getData(), aligned);\n"
+                        "    return aligned;\n"
+                        "}\n\n").arg(info->name));
+    impl.append("/**\n * Set the object data fields from the aligned layout\n */\n");
+    impl.append(QString("void %1::setAlignedData(const AlignedFields & aligned)\n"
+                        "{\n"
+                        "    DataFields data;\n\n"
+                        "    fromAligned(aligned, data);\n"
+                        "    setData(data);\n"
+                        "}\n\n").arg(info->name));
+    outCode.replace(QString("$(ALIGNEDDATA_IMPL)"), impl);
+}
+
 /**
  * Generate the GCS object files
  */
@@ -236,49 +312,45 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
     outCode.replace(QString("$(PROPERTIES_IMPL)"), propertiesImpl);
     outCode.replace(QString("$(NOTIFY_PROPERTIES_CHANGED)"), propertyNotificationsImpl);
 
-    // Replace the $(FIELDSINIT) tag
-    QString finit;
+    // Replace the $(FIELDSINFO) tag
+    QString finfo;
+    QString ftable;
     for (int n = 0; n < info->fields.length(); ++n) {
-        // Setup element names
-        QString varElemName   = info->fields[n]->name + "ElemNames";
-        finit.append(QString("    QStringList %1;\n").arg(varElemName));
-        QStringList elemNames = info->fields[n]->elementNames;
-        for (int m = 0; m < elemNames.length(); ++m) {
-            finit.append(QString("    %1.append(\"%2\");\n")
+        FieldInfo *field = info->fields[n];
+        // Setup element names, the fields use the default names 0, 1... when there are none
+        QString varElemName("NULL");
+        if (!field->defaultElementNames) {
+            varElemName = field->name + "ElemNames";
+            finfo.append(QString("static const char *const %1[] = { \"%2\" };\n")
                          .arg(varElemName)
-                         .arg(elemNames[m]));
+                         .arg(field->elementNames.join("\", \"")));
         }
 
         // Only for enum types
-        if (info->fields[n]->type == FIELDTYPE_ENUM) {
-            QString varOptionName = info->fields[n]->name + "EnumOptions";
-            finit.append(QString("    QStringList %1;\n").arg(varOptionName));
-            QStringList options   = info->fields[n]->options;
-            for (int m = 0; m < options.length(); ++m) {
-                finit.append(QString("    %1.append(\"%2\");\n")
-                             .arg(varOptionName)
-                             .arg(options[m]));
-            }
-            finit.append(QString("    fields.append( new UAVObjectField(QString(\"%1\"), tr(\"%2\"), QString(\"%3\"), UAVObjectField::ENUM, %4, %5, QString(\"%6\")));\n")
-                         .arg(info->fields[n]->name)
-                         .arg(info->fields[n]->description)
-                         .arg(info->fields[n]->units)
-                         .arg(varElemName)
+        QString varOptionName("NULL");
+        int numOptions = 0;
+        if (field->type == FIELDTYPE_ENUM) {
+            varOptionName = field->name + "EnumOptions";
+            numOptions    = field->options.length();
+            finfo.append(QString("static const char *const %1[] = { \"%2\" };\n")
                          .arg(varOptionName)
-                         .arg(info->fields[n]->limitValues));
-        }
-        // For all other types
-        else {
-            finit.append(QString("    fields.append( new UAVObjectField(QString(\"%1\"), tr(\"%2\"), QString(\"%3\"), UAVObjectField::%4, %5, QStringList(), QString(\"%6\")));\n")
-                         .arg(info->fields[n]->name)
-                         .arg(info->fields[n]->description)
-                         .arg(info->fields[n]->units)
-                         .arg(fieldTypeStrCPPClass[info->fields[n]->type])
-                         .arg(varElemName)
-                         .arg(info->fields[n]->limitValues));
+                         .arg(field->options.join("\", \"")));
         }
+
+        ftable.append(QString("    { \"%1\", QT_TRANSLATE_NOOP(\"%2\", \"%3\"), \"%4\", UAVObjectField::%5, %6, %7, %8, %9, ")
+                      .arg(field->name)
+                      .arg(info->name)
+                      .arg(field->description)
+                      .arg(field->units)
+                      .arg(fieldTypeStrCPPClass[field->type])
+                      .arg(field->numElements)
+                      .arg(varElemName)
+                      .arg(numOptions)
+                      .arg(varOptionName));
+        ftable.append(QString("\"%1\" },\n").arg(field->limitValues));
     }
-    outCode.replace(QString("$(FIELDSINIT)"), finit);
+    finfo.append(QString("static const UAVObjectField::FieldInfo fieldInfo[] = {\n%1};\n").arg(ftable));
+    outCode.replace(QString("$(FIELDSINFO)"), finfo);
 
     // Replace the $(DATAFIELDINFO) tag
     QString name;
@@ -370,6 +442,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
 
     outCode.replace(QString("$(INITFIELDS)"), initfields);
 
+    // Replace the $(ALIGNEDDATA) and $(ALIGNEDDATA_IMPL) tags
+    alignedData(info, outInclude, outCode);
+
     // Write the GCS code
     bool res = writeFileIfDiffrent(gcsOutputPath.absolutePath() + "/" + info->namelc + ".cpp", outCode);
     if (!res) {
@@ -382,5 +457,11 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
         return false;
     }
 
+    QStringList inputs = QStringList() << info->filepath
+                                       << gcsCodePath.absoluteFilePath("uavobject.cpp.template")
+                                       << gcsCodePath.absoluteFilePath("uavobject.h.template");
+    addDependencies(gcsOutputPath.absolutePath() + "/" + info->namelc + ".cpp", inputs);
+    addDependencies(gcsOutputPath.absolutePath() + "/" + info->namelc + ".h", inputs);
+
     return true;
 }
@@ -36,7 +36,9 @@ public:
     bool generate(UAVObjectParser *gen, QString templatepath, QString outputpath);
 
 private:
+    template<class Generator> friend class ObjectProcessor;
     bool process_object(ObjectInfo *info);
+    void alignedData(ObjectInfo *info, QString & outInclude, QString & outCode);
 
     QString gcsCodeTemplate, gcsIncludeTemplate;
     QStringList fieldTypeStrCPP, fieldTypeStrCPPClass;
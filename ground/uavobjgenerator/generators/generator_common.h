@@ -30,9 +30,42 @@
 #include "../uavobjectparser.h"
 #include "generator_io.h"
 
+#include <QtConcurrent/QtConcurrentMap>
+
 // These special chars (regexp) will be removed from C/java identifiers
 #define ENUM_SPECIAL_CHARS "[\\.\\-\\s\\+/\\(\\)]"
 
+// Alignment of the multi element fields in the aligned layout of an object, in bytes
+#define ALIGNED_FIELD_BYTES 16
+
+/**
+ * Calls the process_object() of a generator, the generators make it a friend
+ */
+template<class Generator> class ObjectProcessor {
+public:
+    typedef bool result_type;
+    ObjectProcessor(Generator *generator) : generator(generator) {}
+    bool operator()(ObjectInfo *info) const
+    {
+        return generator->process_object(info);
+    }
+
+private:
+    Generator *generator;
+};
+
+/**
+ * Generate the files of every object in parallel on the global thread pool,
+ * process_object() must only read the state of the generator.
+ * \return true if all the objects were generated
+ */
+template<class Generator> bool processObjects(Generator *generator, UAVObjectParser *parser)
+{
+    QList<bool> results = QtConcurrent::blockingMapped<QList<bool> >(parser->getObjectInfo(), ObjectProcessor<Generator>(generator));
+
+    return !results.contains(false);
+}
+
 void replaceCommonTags(QString & out, ObjectInfo *info);
 void replaceCommonTags(QString & out);
 QString boolTo01String(bool value);
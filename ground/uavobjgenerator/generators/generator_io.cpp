@@ -26,8 +26,16 @@
 
 #include "generator_io.h"
 
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+
 using namespace std;
 
+// Inputs of each generated file, see addDependencies()
+static QMap<QString, QStringList> dependencies;
+static QMutex dependenciesMutex;
+
 /**
  * Read a file and return its contents as a string
  */
@@ -82,3 +90,29 @@ bool writeFileIfDiffrent(QString name, QString & str)
     }
     return writeFile(name, str);
 }
+
+/**
+ * Record the input files a generated file is made of, can be called from any thread
+ */
+void addDependencies(const QString & output, const QStringList & inputs)
+{
+    QMutexLocker locker(&dependenciesMutex);
+
+    dependencies[QDir::cleanPath(QDir::current().absoluteFilePath(output))] = inputs;
+}
+
+/**
+ * Write the dependencies recorded so far as make rules, one per generated file,
+ * and forget them
+ */
+bool writeDependencies(const QString & name)
+{
+    QMutexLocker locker(&dependenciesMutex);
+    QString rules;
+
+    for (QMap<QString, QStringList>::const_iterator it = dependencies.constBegin(); it != dependencies.constEnd(); ++it) {
+        rules.append(it.key() + ": " + it.value().join(" ") + "\n");
+    }
+    dependencies.clear();
+    return writeFileIfDiffrent(name, rules);
+}
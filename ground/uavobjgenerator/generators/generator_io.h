@@ -29,6 +29,7 @@
 #define GENERATORIO
 
 #include <QString>
+#include <QStringList>
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
@@ -38,5 +39,7 @@ QString readFile(QString name);
 QString readFile(QString name);
 bool writeFile(QString name, QString & str);
 bool writeFileIfDiffrent(QString name, QString & str);
+void addDependencies(const QString & output, const QStringList & inputs);
+bool writeDependencies(const QString & name);
 
 #endif
@@ -48,12 +48,14 @@ bool UAVObjectGeneratorJava::generate(UAVObjectParser *parser, QString templatep
         return false;
     }
 
+    // The object files are generated in parallel, the loop below only collects their names
+    processObjects(this, parser);
+
     QString objInc;
     QString javaObjInit;
 
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
-        process_object(info);
 
         javaObjInit.append("\t\t\tobjMngr.registerObject( new " + info->name + "() );\n");
         objInc.append("#include \"" + info->namelc + ".h\"\n");
@@ -244,5 +246,8 @@ bool UAVObjectGeneratorJava::process_object(ObjectInfo *info)
         return false;
     }
 
+    addDependencies(javaOutputPath.absolutePath() + "/" + info->name + ".java",
+                    QStringList() << info->filepath << javaCodePath.absoluteFilePath("uavobject.java.template"));
+
     return true;
 }
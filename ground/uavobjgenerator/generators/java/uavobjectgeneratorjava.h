@@ -37,6 +37,7 @@ public:
     bool generate(UAVObjectParser *gen, QString templatepath, QString outputpath);
 
 private:
+    template<class Generator> friend class ObjectProcessor;
     bool process_object(ObjectInfo *info);
 
     QString javaCodeTemplate, javaIncludeTemplate;
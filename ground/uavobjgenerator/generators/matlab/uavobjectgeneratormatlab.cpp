@@ -59,7 +59,7 @@ bool UAVObjectGeneratorMatlab::generate(UAVObjectParser *parser, QString templat
     matlabCodeTemplate.replace(QString("$(ALLOCATIONCODE)"), matlabAllocationCode);
     matlabCodeTemplate.replace(QString("$(EXPORTCSVCODE)"), matlabExportCsvCode);
 
-    bool res = writeFile(matlabOutputPath.absolutePath() + "/OPLogConvert.m", matlabCodeTemplate);
+    bool res = writeFileIfDiffrent(matlabOutputPath.absolutePath() + "/OPLogConvert.m", matlabCodeTemplate);
     if (!res) {
         cout << "Error: Could not write output files" << endl;
         return false;
@@ -138,19 +138,24 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo *info, int numBytes)
     // Generate function description comment
     matlabAllocationCode.append("% " + objectName + " typecasting\n");
     QString allocationFields;
+    QString payloadName(objectName + "Payload");
+
+    // Gather the payloads in a column per packet, each field is then typecast in one go
+    allocationFields.append("\t" + payloadName + " = reshape(buffer(bsxfun(@plus, " + objectName + "FidIdx(:)', "
+                            "(0:" + objectTableName.toUpper() + "_NUMBYTES - 1)')), " + objectTableName.toUpper() + "_NUMBYTES, []);\n");
 
     // Add timestamp
     allocationFields.append("\t" + objectName + ".timestamp = " +
-                            "double(typecast(buffer(mcolon(" + objectName + "FidIdx "
-                            "- headerLen - oplHeaderLen, " + objectName + "FidIdx + 3 - headerLen - oplHeaderLen)), 'uint32'))';\n");
+                            "double(typecast(reshape(buffer(bsxfun(@plus, " + objectName + "FidIdx(:)' "
+                            "- headerLen - oplHeaderLen, (0:3)')), 1, []), 'uint32'));\n");
 
     int currentIdx = 0;
 
     // Add Instance ID, if necessary
     if (!info->isSingleInst) {
         allocationFields.append("\t" + objectName + ".instanceID = " +
-                                "double(typecast(buffer(mcolon(" + objectName + "FidIdx - 2"
-                                ", " + objectName + "FidIdx - 2 + 1)), 'uint16'))';\n");
+                                "double(typecast(reshape(buffer(bsxfun(@plus, " + objectName + "FidIdx(:)' - 2"
+                                ", (0:1)')), 1, []), 'uint16'));\n");
     }
 
     for (int n = 0; n < info->fields.length(); ++n) {
@@ -159,18 +164,19 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo *info, int numBytes)
 
         // Determine variable type length
         QString size = fieldSizeStrMatlab[info->fields[n]->type];
+        QString rows = QString("%1:%2").arg(currentIdx + 1).arg(currentIdx + size.toInt() * info->fields[n]->numElements);
         // Append field
         if (info->fields[n]->numElements > 1) {
             allocationFields.append("\t" + objectName + "." + info->fields[n]->name + " = " +
-                                    "reshape(double(typecast(buffer(mcolon(" + objectName + "FidIdx + " + QString("%1").arg(currentIdx) +
-                                    ", " + objectName + "FidIdx + " + QString("%1").arg(currentIdx + size.toInt() * info->fields[n]->numElements - 1) + ")), '" + type + "')), " + QString::number(info->fields[n]->numElements, 10) + ", [] );\n");
+                                    "reshape(double(typecast(reshape(" + payloadName + "(" + rows + ", :), 1, []), '" + type + "')), " +
+                                    QString::number(info->fields[n]->numElements, 10) + ", []);\n");
         } else {
             allocationFields.append("\t" + objectName + "." + info->fields[n]->name + " = " +
-                                    "double(typecast(buffer(mcolon(" + objectName + "FidIdx + " + QString("%1").arg(currentIdx) +
-                                    ", " + objectName + "FidIdx + " + QString("%1").arg(currentIdx + size.toInt() - 1) + ")), '" + type + "'))';\n");
+                                    "double(typecast(reshape(" + payloadName + "(" + rows + ", :), 1, []), '" + type + "'));\n");
         }
         currentIdx += size.toInt() * info->fields[n]->numElements;
     }
+    allocationFields.append("\tclear " + payloadName + ";\n");
     matlabAllocationCode.append(allocationFields);
     matlabAllocationCode.append("\n");
 
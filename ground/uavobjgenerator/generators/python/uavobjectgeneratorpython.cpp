@@ -40,14 +40,59 @@ bool UAVObjectGeneratorPython::generate(UAVObjectParser *parser, QString templat
     }
 
     // Process each object
+    processObjects(this, parser);
+
+    // Generate the log reader, with the numpy dtype of each object
+    QDir logTemplatePath = QDir(templatepath + QString(PYTHON_LOG_TEMPLATE_DIR));
+    QString logTemplate  = readFile(logTemplatePath.absoluteFilePath("oplogconvert.py.template"));
+    if (logTemplate.isEmpty()) {
+        std::cerr << "Problem reading python log reader template" << endl;
+        return false;
+    }
+    QString dtypes;
+    QStringList inputs;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
-        process_object(info);
+        dtypes.append(objectDtype(info));
+        inputs << info->filepath;
+    }
+    logTemplate.replace(QString("$(OBJECTDTYPES)"), dtypes);
+    if (!writeFileIfDiffrent(pythonOutputPath.absolutePath() + "/oplogconvert.py", logTemplate)) {
+        cout << "Error: Could not write Python log reader" << endl;
+        return false;
     }
+    addDependencies(pythonOutputPath.absolutePath() + "/oplogconvert.py",
+                    inputs << logTemplatePath.absoluteFilePath("oplogconvert.py.template"));
 
     return true; // if we come here everything should be fine
 }
 
+/**
+ * Entry of the object in the OBJECTS table of the log reader, the dtype
+ * fields are in the packing order of the object data.
+ */
+QString UAVObjectGeneratorPython::objectDtype(ObjectInfo *info)
+{
+    static const char *const fieldTypeStrNumpy[] = {
+        "<i1", "<i2", "<i4", "<u1", "<u2", "<u4", "<f4", "<u1"
+    };
+    QStringList fields;
+
+    for (int n = 0; n < info->fields.length(); ++n) {
+        FieldInfo *field = info->fields[n];
+        if (field->numElements > 1) {
+            fields << QString("(\"%1\", \"%2\", (%3,))").arg(field->name).arg(fieldTypeStrNumpy[field->type]).arg(field->numElements);
+        } else {
+            fields << QString("(\"%1\", \"%2\")").arg(field->name).arg(fieldTypeStrNumpy[field->type]);
+        }
+    }
+    return QString("    0x%1: (\"%2\", %3, np.dtype([%4])),\n")
+           .arg(info->id, 8, 16, QChar('0'))
+           .arg(info->name)
+           .arg(info->isSingleInst ? "True" : "False")
+           .arg(fields.join(", "));
+}
+
 /**
  * Generate the python object files
  */
@@ -116,5 +161,8 @@ bool UAVObjectGeneratorPython::process_object(ObjectInfo *info)
         return false;
     }
 
+    addDependencies(pythonOutputPath.absolutePath() + "/" + info->namelc + ".py",
+                    QStringList() << info->filepath << pythonCodePath.absoluteFilePath("uavobject.pyt.template"));
+
     return true;
 }
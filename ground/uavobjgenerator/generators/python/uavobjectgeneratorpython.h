@@ -27,6 +27,8 @@
 #ifndef UAVOBJECTGENERATORPYTHON_H
 #define UAVOBJECTGENERATORPYTHON_H
 
+#define PYTHON_LOG_TEMPLATE_DIR "ground/openpilotgcs/src/plugins/uavobjects"
+
 #include "../generator_common.h"
 
 class UAVObjectGeneratorPython {
@@ -34,7 +36,9 @@ public:
     bool generate(UAVObjectParser *gen, QString templatepath, QString outputpath);
 
 private:
+    template<class Generator> friend class ObjectProcessor;
     bool process_object(ObjectInfo *info);
+    QString objectDtype(ObjectInfo *info);
 
     QString pythonCodeTemplate;
     QDir pythonCodePath;
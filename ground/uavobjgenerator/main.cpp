@@ -47,7 +47,7 @@ using namespace std;
  */
 void usage()
 {
-    cout << "Usage: uavobjectgenerator [-gcs] [-flight] [-java] [-python] [-matlab] [-wireshark] [-none] [-v] xml_path template_base [UAVObj1] ... [UAVObjN]" << endl;
+    cout << "Usage: uavobjectgenerator [-gcs] [-flight] [-java] [-python] [-matlab] [-wireshark] [-none] [-deps] [-v] xml_path template_base [UAVObj1] ... [UAVObjN]" << endl;
     cout << "Languages: " << endl;
     cout << "\t-gcs           build groundstation code" << endl;
     cout << "\t-flight        build flight code" << endl;
@@ -58,6 +58,7 @@ void usage()
     cout << "\tIf no language is specified ( and not -none ) -> all are built." << endl;
     cout << "Misc: " << endl;
     cout << "\t-none          build no language - just parse xml's" << endl;
+    cout << "\t-deps          write the make dependencies of the generated files to <language>.d" << endl;
     cout << "\t-h             this help" << endl;
     cout << "\t-v             verbose" << endl;
     cout << "\tinput_path     path to UAVObject definition (.xml) files." << endl;
@@ -110,6 +111,7 @@ int main(int argc, char *argv[])
     bool do_matlab     = (arguments_stringlist.removeAll("-matlab") > 0);
     bool do_wireshark  = (arguments_stringlist.removeAll("-wireshark") > 0);
     bool do_none       = (arguments_stringlist.removeAll("-none") > 0); //
+    bool do_deps       = (arguments_stringlist.removeAll("-deps") > 0);
 
     bool do_all        = ((do_gcs || do_flight || do_java || do_python || do_matlab) == false);
     bool do_allObjects = true;
@@ -162,6 +164,7 @@ int main(int argc, char *argv[])
         }
         QString filename = fileinfo.fileName();
         QString xmlstr   = readFile(fileinfo.absoluteFilePath());
+        int firstObject  = parser->getNumObjects();
 
         QString res = parser->parseXML(xmlstr, filename);
 
@@ -172,6 +175,9 @@ int main(int argc, char *argv[])
             cout << "Error parsing " << res.toStdString() << endl;
             return RETURN_ERR_XML;
         }
+        for (int objidx = firstObject; objidx < parser->getNumObjects(); ++objidx) {
+            parser->getObjectByIndex(objidx)->filepath = fileinfo.absoluteFilePath();
+        }
     }
 
     if (objects_stringlist.length() > 0) {
@@ -214,6 +220,9 @@ int main(int argc, char *argv[])
         cout << "generating flight code" << endl;
         UAVObjectGeneratorFlight flightgen;
         flightgen.generate(parser, templatepath, outputpath);
+        if (do_deps) {
+            writeDependencies(outputpath + "flight.d");
+        }
     }
 
     // generate gcs code if wanted
@@ -221,6 +230,9 @@ int main(int argc, char *argv[])
         cout << "generating gcs code" << endl;
         UAVObjectGeneratorGCS gcsgen;
         gcsgen.generate(parser, templatepath, outputpath);
+        if (do_deps) {
+            writeDependencies(outputpath + "gcs.d");
+        }
     }
 
     // generate java code if wanted
@@ -228,6 +240,9 @@ int main(int argc, char *argv[])
         cout << "generating java code" << endl;
         UAVObjectGeneratorJava javagen;
         javagen.generate(parser, templatepath, outputpath);
+        if (do_deps) {
+            writeDependencies(outputpath + "java.d");
+        }
     }
 
     // generate python code if wanted
@@ -235,6 +250,9 @@ int main(int argc, char *argv[])
         cout << "generating python code" << endl;
         UAVObjectGeneratorPython pygen;
         pygen.generate(parser, templatepath, outputpath);
+        if (do_deps) {
+            writeDependencies(outputpath + "python.d");
+        }
     }
 
     // generate matlab code if wanted
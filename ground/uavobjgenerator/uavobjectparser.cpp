@@ -652,6 +652,17 @@ QString UAVObjectParser::processObjectAttributes(QDomNode & node, ObjectInfo *in
         }
     }
 
+    // Get aligned attribute
+    attr = attributes.namedItem("aligned");
+    info->isAligned = false;
+    if (!attr.isNull()) {
+        if (attr.nodeValue().compare(QString("true")) == 0) {
+            info->isAligned = true;
+        } else if (attr.nodeValue().compare(QString("false")) != 0) {
+            return QString("Object:aligned attribute value is invalid (true|false)");
+        }
+    }
+
     // Settings objects can only have a single instance
     if (info->isSettings && !info->isSingleInst) {
         return QString("Object: Settings objects can not have multiple instances");
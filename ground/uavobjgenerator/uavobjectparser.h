@@ -82,10 +82,12 @@ typedef struct  {
     QString    name;
     QString    namelc; /** name in lowercase */
     QString    filename;
+    QString    filepath; /** absolute path of the XML file, for the dependencies */
     quint32    id;
     bool       isSingleInst;
     bool       isSettings;
     bool       isPriority;
+    bool       isAligned; /** Also generate the aligned in-memory layout, the wire format is not affected */
     AccessMode gcsAccess;
     AccessMode flightAccess;
     bool       flightTelemetryAcked;
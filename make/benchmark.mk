@@ -0,0 +1,69 @@
+###############################################################################
+# @file       benchmark.mk
+# @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+# @addtogroup 
+# @{
+# @addtogroup 
+# @{
+# @brief Makefile template for benchmarks
+###############################################################################
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+
+# Use native toolchain and disable THUMB mode for benchmarks
+override ARM_SDK_PREFIX :=
+override THUMB :=
+
+# Benchmark source files
+ALLSRC     := $(SRC) $(wildcard ./*.c)
+ALLCPPSRC  := $(wildcard ./*.cpp)
+ALLSRCBASE := $(notdir $(basename $(ALLSRC) $(ALLCPPSRC)))
+ALLOBJ     := $(addprefix $(OUTDIR)/, $(addsuffix .o, $(ALLSRCBASE)))
+
+$(foreach src,$(ALLSRC),$(eval $(call COMPILE_C_TEMPLATE,$(src))))
+$(foreach src,$(ALLCPPSRC),$(eval $(call COMPILE_CXX_TEMPLATE,$(src))))
+
+$(eval $(call LINK_CXX_TEMPLATE,$(OUTDIR)/$(TARGET).elf,$(ALLOBJ)))
+
+# Google Benchmark comes from the system unless BENCHMARK_DIR points to an install
+ifneq ($(BENCHMARK_DIR),)
+CPPFLAGS += -I$(BENCHMARK_DIR)/include
+LDFLAGS  += -L$(BENCHMARK_DIR)/lib
+endif
+
+# Flags passed to the C++ compiler
+CXXFLAGS += -Wall -Wextra
+
+# Flags passed to the C compiler
+CONLYFLAGS += -std=gnu99
+
+CFLAGS += -DUNIT_TEST
+CPPFLAGS += -DUNIT_TEST
+
+# Common compiler flags, optimized as the timings would be meaningless otherwise
+CFLAGS += -O2 -g
+CFLAGS += -Wall -Werror
+CFLAGS += $(patsubst %,-I%,$(EXTRAINCDIRS))
+
+LDFLAGS += -lbenchmark -lpthread
+
+.PHONY: elf
+elf: $(OUTDIR)/$(TARGET).elf
+
+.PHONY: run
+run: $(OUTDIR)/$(TARGET).elf
+	$(V0) @echo " BENCH RUN $(MSG_EXTRA)  $(call toprel, $<)"
+	$(V1) $< $(BENCHMARK_OPTIONS)
@@ -35,8 +35,12 @@ DIAG_MIXERSTATUS     ?= NO
 DIAG_RATEDESIRED     ?= NO
 DIAG_I2C_WDG_STATS   ?= NO
 DIAG_TASKS           ?= NO
+DIAG_CALLBACK_TIMING ?= NO
 DIAG_INSTRUMENTATION ?= NO
 
+# Set to YES to compile all instrumentation points to nothing, e.g. for release builds
+NO_INSTRUMENTATION   ?= NO
+
 # Or just turn on all the above diagnostics. WARNING: this consumes massive amounts of memory.
 DIAG_ALL             ?= NO
 
@@ -92,9 +96,17 @@ ifneq (,$(filter YES,$(DIAG_TASKS) $(DIAG_ALL)))
     CFLAGS += -DDIAG_TASKS
 endif
 
+ifneq (,$(filter YES,$(DIAG_CALLBACK_TIMING) $(DIAG_ALL)))
+    CFLAGS += -DDIAG_CALLBACK_TIMING
+endif
+
 ifneq (,$(filter YES,$(DIAG_INSTRUMENTATION) $(DIAG_ALL)))
     CFLAGS += -DPIOS_INCLUDE_INSTRUMENTATION
 endif
+
+ifeq ($(NO_INSTRUMENTATION), YES)
+    CFLAGS += -DPIOS_EXCLUDE_INSTRUMENTATION
+endif
 # Place project-specific -D and/or -U options for Assembler with preprocessor here.
 #ADEFS = -DUSE_IRQ_ASM_WRAPPER
 ADEFS = -D__ASSEMBLY__
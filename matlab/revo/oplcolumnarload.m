@@ -0,0 +1,63 @@
+function log = oplcolumnarload(oplcfile)
+% OPLCOLUMNARLOAD Load a columnar flight log exported by the GCS flight log plugin (*.oplc)
+%
+% log = oplcolumnarload(oplcfile) returns a struct with one member per UAVObject,
+% each holding one array per field, one row per logged sample. Columns are read
+% through memory mapping, without any parsing.
+% See FlightLogManager::exportToColumnar() for the file layout.
+
+if nargin==0
+	[FileName,PathName] = uigetfile('*.oplc');
+	oplcfile = strcat(PathName,FileName);
+end
+
+if ~exist(oplcfile, 'file')
+	error('Not a valid columnar log file')
+end
+
+fid = fopen(oplcfile, 'r', 'ieee-le');
+magic = fread(fid, 8, '*char')';
+if ~strcmp(magic(1:6), 'OPLCOL')
+	fclose(fid);
+	error('Not a valid columnar log file')
+end
+version = fread(fid, 1, 'uint32');
+if version ~= 1
+	fclose(fid);
+	error('Unsupported columnar log file version %d', version)
+end
+numTables = fread(fid, 1, 'uint32');
+indexOffset = fread(fid, 1, 'uint64');
+
+% UAVObjectField::FieldType to matlab types, enums and bitfields are stored as uint8
+types = {'int8', 'int16', 'int32', 'uint8', 'uint16', 'uint32', 'single', 'uint8', 'uint8'};
+
+fseek(fid, indexOffset, 'bof');
+log = struct();
+for t = 1:numTables
+	objName = readname(fid);
+	fread(fid, 1, 'uint32'); % object id
+	numColumns = fread(fid, 1, 'uint32');
+	numRows = fread(fid, 1, 'uint64');
+	obj = struct();
+	for c = 1:numColumns
+		colName = readname(fid);
+		type = fread(fid, 1, 'uint32');
+		elements = fread(fid, 1, 'uint32');
+		offset = fread(fid, 1, 'uint64');
+		fread(fid, 1, 'uint64'); % size
+
+		if numRows > 0
+			m = memmapfile(oplcfile, 'Offset', offset, 'Format', {types{type + 1}, [elements numRows], 'x'}, 'Repeat', 1);
+			obj.(colName) = m.Data.x';
+		else
+			obj.(colName) = zeros(0, elements, types{type + 1});
+		end
+	end
+	log.(objName) = obj;
+end
+fclose(fid);
+
+function name = readname(fid)
+name = fread(fid, 64, '*char')';
+name = name(1:find([name 0] == 0, 1) - 1);
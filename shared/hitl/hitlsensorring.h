@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ *
+ * @file       hitlsensorring.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      Layout of the shared memory ring through which the GCS HITL
+ *             plugin feeds the sensor frames of a simulator to a local
+ *             simposix firmware, without going through the telemetry.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef HITLSENSORRING_H
+#define HITLSENSORRING_H
+
+#include <stdint.h>
+
+/*
+ * The GCS creates the POSIX shared memory object and is the only writer of
+ * the frames, the simposix Sensors module is the only reader. The writer
+ * fills the frame at head % HITL_SENSOR_RING_LENGTH, then increments head.
+ * The reader keeps its own tail: a frame read while head - tail reached
+ * the ring length may have been overwritten and is dropped. The object is
+ * left in place when the GCS stops, a head going backward means that the
+ * ring has been reset and the reader starts over from the current head.
+ */
+#define HITL_SENSOR_RING_NAME    "/openpilot_hitl_sensors"
+#define HITL_SENSOR_RING_MAGIC   0x4F505352
+#define HITL_SENSOR_RING_VERSION 1
+#define HITL_SENSOR_RING_LENGTH  256
+
+/* Sensors present in a frame, accels and gyros always are */
+#define HITL_SENSOR_GPS          0x01
+#define HITL_SENSOR_BARO         0x02
+#define HITL_SENSOR_AIRSPEED     0x04
+
+struct hitl_sensor_frame {
+    uint32_t flags;
+    float    delT;         // [s] since the previous frame
+    float    accel[3];     // [m/s^2] body frame
+    float    gyro[3];      // [deg/s] body frame
+    float    rpy[3];       // [deg] attitude of the simulator, for the magnetometer
+    int32_t  latitude;     // [deg * 10^7]
+    int32_t  longitude;    // [deg * 10^7]
+    float    altitude;     // [m]
+    float    groundspeed;  // [m/s]
+    float    heading;      // [deg]
+    float    velNED[3];    // [m/s]
+    float    baroAltitude; // [m]
+    float    temperature;  // [C]
+    float    pressure;     // [kPa]
+    float    calibratedAirspeed; // [m/s]
+    float    trueAirspeed; // [m/s]
+};
+
+struct hitl_sensor_ring {
+    uint32_t magic;
+    uint32_t version;
+    volatile uint32_t head; // number of frames written
+    uint32_t reserved;
+    struct hitl_sensor_frame frames[HITL_SENSOR_RING_LENGTH];
+};
+
+#endif /* HITLSENSORRING_H */